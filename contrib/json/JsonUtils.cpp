@@ -168,6 +168,23 @@ void BinStrToJson(Json::Value &jsonObj, const std::string &binStr, const std::st
 	jsonObj[name] = binStrArray; // Add binary string array to supplied object.
 }
 
+void BinStrToJsonHex(Json::Value &jsonObj, const std::string &binStr, const std::string &name)
+{
+	assert(!name.empty()); // Can't do anything if no name supplied.
+
+	// A single string is far cheaper to write and parse than an array with an element per byte.
+	static const char hexDigits[] = "0123456789abcdef";
+	std::string hexStr;
+	hexStr.reserve(binStr.size() * 2);
+	for (unsigned int charIndex = 0; charIndex < binStr.size(); ++charIndex)
+	{
+		const unsigned char c = static_cast<unsigned char>(binStr[charIndex]);
+		hexStr += hexDigits[c >> 4];
+		hexStr += hexDigits[c & 0xf];
+	}
+	jsonObj[name] = hexStr; // Add hex string to supplied object.
+}
+
 void JsonToVector(vector3f *pVec, const Json::Value &jsonObj, const std::string &name)
 {
 	assert(!name.empty()); // Can't do anything if no name supplied.
@@ -362,3 +379,28 @@ std::string JsonToBinStr(const Json::Value &jsonObj, const std::string &name)
 		binStr += char(binStrArray[charIndex].asInt());
 	return binStr;
 }
+
+static int HexDigitValue(char c)
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	throw SavedGameCorruptException();
+}
+
+std::string JsonHexToBinStr(const Json::Value &jsonObj, const std::string &name)
+{
+	assert(!name.empty()); // Can't do anything if no name supplied.
+
+	if (!jsonObj.isMember(name.c_str())) throw SavedGameCorruptException();
+	Json::Value hexStrObj = jsonObj[name.c_str()];
+	if (!hexStrObj.isString()) throw SavedGameCorruptException();
+	const std::string hexStr = hexStrObj.asString();
+	if (hexStr.size() % 2 != 0) throw SavedGameCorruptException();
+
+	std::string binStr;
+	binStr.reserve(hexStr.size() / 2);
+	for (unsigned int charIndex = 0; charIndex < hexStr.size(); charIndex += 2)
+		binStr += char((HexDigitValue(hexStr[charIndex]) << 4) | HexDigitValue(hexStr[charIndex + 1]));
+	return binStr;
+}
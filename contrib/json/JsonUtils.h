@@ -23,6 +23,7 @@ void MatrixToJson(Json::Value &jsonObj, const matrix4x4d &mat, const std::string
 void ColorToJson(Json::Value &jsonObj, const Color3ub &col, const std::string &name);
 void ColorToJson(Json::Value &jsonObj, const Color4ub &col, const std::string &name);
 void BinStrToJson(Json::Value &jsonObj, const std::string &str, const std::string &name);
+void BinStrToJsonHex(Json::Value &jsonObj, const std::string &str, const std::string &name);
 
 // Parse JSON functions.
 void JsonToVector(vector3f *pVec, const Json::Value &jsonObj, const std::string &name);
@@ -36,5 +37,6 @@ void JsonToMatrix(matrix4x4d *pMat, const Json::Value &jsonObj, const std::strin
 void JsonToColor(Color3ub *pCol, const Json::Value &jsonObj, const std::string &name);
 void JsonToColor(Color4ub *pCol, const Json::Value &jsonObj, const std::string &name);
 std::string JsonToBinStr(const Json::Value &jsonObj, const std::string &name);
+std::string JsonHexToBinStr(const Json::Value &jsonObj, const std::string &name);
 
 #endif /* _JSON_UTILS_H */
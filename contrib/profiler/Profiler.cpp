@@ -18,6 +18,7 @@
 #include <cstring>
 #include <ctime>
 #include <cstdlib>
+#include <chrono>
 
 #include "Profiler.h"
 
@@ -858,6 +859,181 @@ namespace Profiler {
 	threadlocal Caller *root = NULL;
 	
 
+	/*
+	============
+	Trace - a timeline of every scope entered and left while recording, plus
+	flows (eg a job from being queued to being run and finished) and frame
+	markers, written out in the Chrome trace event format for chrome://tracing
+	or Perfetto
+	============
+	*/
+
+	struct TraceEvent {
+		u64 ticks;
+		const char *name;
+		u64 id;
+		char phase; // B/E scope, s/t/f flow, i frame
+	};
+
+	struct TraceThread {
+		TraceThread( const char *name_, u32 tid_ ) : name(name_), tid(tid_), dropped(0) { lock.mLock = 0; }
+		CASLock lock; // held by the thread while adding, and by whoever reads
+		Buffer<TraceEvent> events;
+		const char *name;
+		u32 tid, dropped;
+	};
+
+	// per thread, so a busy thread can't drown the rest out
+	const u32 traceMaxEvents = 1 << 18;
+
+	struct GlobalTraceList {
+		~GlobalTraceList() {
+			if ( list ) {
+				for ( u32 i = 0; i < list->Size(); i++ )
+					delete (*list)[i];
+			}
+			delete list;
+		}
+
+		void Acquire() {
+			lock.Acquire();
+			if ( !list )
+				list = new Buffer<TraceThread *>;
+		}
+
+		void Release() { lock.Release(); }
+
+		Buffer<TraceThread *> *list;
+		CASLock lock;
+	};
+
+	GlobalTraceList traceThreads = { NULL, {0} };
+	threadlocal TraceThread *traceThread = NULL;
+	volatile bool traceRecording = false;
+	u64 traceStartTicks = 0, traceStopTicks = 0;
+	time_t traceStartTime = 0;
+	std::chrono::steady_clock::time_point traceStartClock, traceStopClock;
+	u64 traceNextFrame = 0;
+
+	// threads are never forgotten, their events are wanted after they exit
+	void traceThreadEnter( const char *name ) {
+		traceThreads.Acquire();
+		traceThread = new TraceThread( name, traceThreads.list->Size() + 1 );
+		traceThreads.list->Push( traceThread );
+		traceThreads.Release();
+	}
+
+	inline void traceEvent( char phase, const char *name, u64 id ) {
+		TraceThread *t = traceThread;
+		if ( !t )
+			return;
+		t->lock.Acquire();
+		if ( t->events.Size() < traceMaxEvents ) {
+			TraceEvent e = { Timer::getticks(), name, id, phase };
+			t->events.Push( e );
+		} else {
+			t->dropped++;
+		}
+		t->lock.Release();
+	}
+
+	void traceStart() {
+		traceThreads.Acquire();
+		for ( u32 i = 0; i < traceThreads.list->Size(); i++ ) {
+			TraceThread *t = (*traceThreads.list)[i];
+			t->lock.Acquire();
+			t->events.Clear();
+			t->dropped = 0;
+			t->lock.Release();
+		}
+		time( &traceStartTime );
+		traceStartClock = std::chrono::steady_clock::now();
+		traceStartTicks = Timer::getticks();
+		traceRecording = true;
+		traceThreads.Release();
+	}
+
+	void traceStop() {
+		if ( !traceRecording )
+			return;
+		traceRecording = false;
+		traceStopTicks = Timer::getticks();
+		traceStopClock = std::chrono::steady_clock::now();
+	}
+
+	void writeTraceString( FILE *f, const char *s ) {
+		fputc( '"', f );
+		for ( ; *s; ++s ) {
+			if ( *s == '"' || *s == '\\' )
+				fputc( '\\', f );
+			if ( (unsigned char)*s >= 0x20 )
+				fputc( *s, f );
+		}
+		fputc( '"', f );
+	}
+
+	void dumpTrace( const char *dir ) {
+		traceStop();
+
+		// rdtsc ticks to microseconds, by the wall clock over the recording
+		const f64 micros = f64( std::chrono::duration_cast<std::chrono::microseconds>( traceStopClock - traceStartClock ).count() );
+		const f64 ticksPerMicro = ( micros > 0 && traceStopTicks > traceStartTicks ) ? f64( traceStopTicks - traceStartTicks ) / micros : 1.0;
+
+		char timeFormat[256], fileFormat[4096];
+		strftime( timeFormat, 255, "%Y%m%d_%H%M%S", localtime( &traceStartTime ) );
+		snprintf( fileFormat, 4096, "%s%s%s-trace-%s.json", dir ? dir : "", dir ? "/" : "", programName ? programName : "no-info-given", timeFormat );
+		FILE *f = fopen( fileFormat, "wb" );
+		if ( !f )
+			return;
+
+		fputs( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f );
+		bool first = true;
+
+		traceThreads.Acquire();
+		for ( u32 i = 0; i < traceThreads.list->Size(); i++ ) {
+			TraceThread *t = (*traceThreads.list)[i];
+			t->lock.Acquire();
+
+			fprintf( f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", t->tid );
+			char threadName[256];
+			snprintf( threadName, sizeof( threadName ), "%s %u%s", t->name, t->tid, t->dropped ? " (events dropped)" : "" );
+			writeTraceString( f, threadName );
+			fputs( "}}", f );
+			first = false;
+
+			for ( u32 e = 0; e < t->events.Size(); e++ ) {
+				const TraceEvent &ev = t->events[e];
+				if ( ev.ticks < traceStartTicks )
+					continue;
+				const f64 ts = f64( ev.ticks - traceStartTicks ) / ticksPerMicro;
+				fprintf( f, ",\n{\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f", ev.phase, t->tid, ts );
+				if ( ev.name ) {
+					fputs( ",\"name\":", f );
+					writeTraceString( f, ev.name );
+				}
+				switch ( ev.phase ) {
+					case 's': case 't':
+						fprintf( f, ",\"cat\":\"job\",\"id\":" PRINTFU64(), ev.id );
+						break;
+					case 'f':
+						// bind to the slice it's in, not the next one
+						fprintf( f, ",\"cat\":\"job\",\"bp\":\"e\",\"id\":" PRINTFU64(), ev.id );
+						break;
+					case 'i':
+						fprintf( f, ",\"s\":\"g\",\"args\":{\"frame\":" PRINTFU64() "}", ev.id );
+						break;
+				}
+				fputc( '}', f );
+			}
+
+			t->lock.Release();
+		}
+		traceThreads.Release();
+
+		fputs( "\n]}\n", f );
+		fclose( f );
+	}
+
 	/*
 		Thread Dumping
 	*/
@@ -1102,6 +1278,7 @@ namespace Profiler {
 
 	void enterThread( const char *name ) {
 		Caller *tmp = new Caller( name );
+		traceThreadEnter( name );
 
 		threads.AcquireGlobalLock();
 		threads.list->Push( Root( tmp, &Caller::thisThread ) );
@@ -1136,6 +1313,8 @@ namespace Profiler {
 		Caller *active = parent->FindOrCreate( name );
 		active->Start();
 		Caller::thisThread.activeCaller = active;
+		if ( traceRecording )
+			traceEvent( 'B', name, 0 );
 	}
 
 	inline void exitCaller() {
@@ -1145,6 +1324,8 @@ namespace Profiler {
 		
 		active->Stop();
 		Caller::thisThread.activeCaller = active->GetParent();
+		if ( traceRecording )
+			traceEvent( 'E', NULL, 0 );
 	}
 
 	inline void pauseCaller() {
@@ -1203,6 +1384,14 @@ namespace Profiler {
 	void threadenter( const char *name ) { enterThread( name ); }
 	void threadexit() { exitThread(); }
 	void reset() { resetThreads(); }
+	void tracestart() { traceStart(); }
+	void tracestop() { traceStop(); }
+	bool tracing() { return traceRecording; }
+	void dumptrace(const char *dir) { dumpTrace( dir ); }
+	void fastcall flowstart( const char *name, u64 id ) { if ( traceRecording ) traceEvent( 's', name, id ); }
+	void fastcall flowstep( const char *name, u64 id ) { if ( traceRecording ) traceEvent( 't', name, id ); }
+	void fastcall flowend( const char *name, u64 id ) { if ( traceRecording ) traceEvent( 'f', name, id ); }
+	void fastcall frame() { const u64 n = traceNextFrame++; if ( traceRecording ) traceEvent( 'i', "frame", n ); }
 #else
 	void detect( int argc, char **argv ) {}
 	//void detect( const char *commandLine ) {}
@@ -1215,6 +1404,14 @@ namespace Profiler {
 	void threadenter( const char *name ) {}
 	void threadexit() {}
 	void reset() {}
+	void tracestart() {}
+	void tracestop() {}
+	bool tracing() { return false; }
+	void dumptrace(const char *dir) {}
+	void fastcall flowstart( const char *name, u64 id ) {}
+	void fastcall flowstep( const char *name, u64 id ) {}
+	void fastcall flowend( const char *name, u64 id ) {}
+	void fastcall frame() {}
 #endif
 
 }; // namespace Profiler
@@ -61,6 +61,12 @@
 	#define PROFILE_SCOPED_DESC( desc ) PROFILE_SCOPED_RAW( PROFILE_CONCAT( PROFILE_FUNCTION(), desc ) )
 
 	#define PROFILE_STOP()              Profiler::exit();
+
+	// timeline
+	#define PROFILE_FLOW_START( name, id ) Profiler::flowstart( name, id );
+	#define PROFILE_FLOW_STEP( name, id )  Profiler::flowstep( name, id );
+	#define PROFILE_FLOW_END( name, id )   Profiler::flowend( name, id );
+	#define PROFILE_FRAME()                Profiler::frame();
 #else
 	#define PROFILE_THREAD_START_RAW( text )
 	#define PROFILE_THREAD_START()
@@ -85,6 +91,11 @@
 	#define PROFILE_SCOPED_DESC( desc )
 
 	#define PROFILE_STOP()
+
+	#define PROFILE_FLOW_START( name, id )
+	#define PROFILE_FLOW_STEP( name, id )
+	#define PROFILE_FLOW_END( name, id )
+	#define PROFILE_FRAME()
 #endif
 
 namespace Profiler {
@@ -187,6 +198,19 @@ namespace Profiler {
 	void threadexit();
 	void reset();
 
+	// timeline recording. while on, every scope entered and left is kept in
+	// order, per thread, with flows between threads (matched by id) and
+	// frame markers. dumptrace stops recording and writes it all out as a
+	// Chrome trace (json), for chrome://tracing or Perfetto
+	void tracestart();
+	void tracestop();
+	bool tracing();
+	void dumptrace(const char *dir = 0);
+	void fastcall flowstart( const char *name, u64 id );
+	void fastcall flowstep( const char *name, u64 id );
+	void fastcall flowend( const char *name, u64 id );
+	void fastcall frame();
+
 	struct Scoped {
 		Scoped( const char *name ) { PROFILE_START_RAW( name ) }
 		~Scoped() { PROFILE_STOP() }
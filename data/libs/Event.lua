@@ -24,170 +24,121 @@
 -- your module needs to know the difference.
 --
 
-local Engine = import("Engine")
-
-local pending = {}
-local callbacks = {}
-local do_callback = {}
-
-local do_callback_normal = function (cb, p)
-	cb(table.unpack(p.event))
-end
-local do_callback_timed = function (cb, p)
-	local d = debug.getinfo(cb)
-
-	local tstart = Engine.ticks
-	cb(table.unpack(p.event))
-	local tend = Engine.ticks
-
-	print(string.format("DEBUG: %s %dms %s:%d", p.name, tend-tstart, d.source, d.linedefined))
-end
-
-local Event
-Event = {
-	--
-	-- Function: Register
-	--
-	-- Register a function with a specific type of event. When an event with
-	-- the named type is processed, the function will be called.
-	--
-	-- > Event.Register(name, function)
-	--
-	-- Parameters:
-	--
-	--   name - the name (type) of the event
-	--
-	--   function - function to call when an event of the named type is processed.
-	--              The function will recieve a copy of the parameters attached to
-	--              the event.
-	--
-	--
-	-- Example:
-	--
-	-- > Event.Register("onEnterSystem", function (ship)
-	-- >     print("welcome to "..Game.system.name..", "..ship.label)
-	-- > end)
-	--
-	-- Availability:
-	--
-	--   alpha 26
-	--
-	-- Status:
-	--
-	--   stable
-	--
-	Register = function (name, cb)
-		if not callbacks[name] then callbacks[name] = {} end
-		callbacks[name][cb] = cb;
-        if not do_callback[name] then do_callback[name] = do_callback_normal end
-	end,
-
-	--
-	-- Function: Deregister
-	--
-	-- Deregisters a function from an event type. The funtion will no longer
-	-- receive events of the named type.
-	--
-	-- If the function is not registered this method does nothing.
-	--
-	-- > Event.Deregister(name, function)
-	--
-	-- Parameters:
-	--
-	--   name - the name (type) of the event
-	--
-	--   function - a function that was previously connected to this queue with
-	--              <Connect>
-	--
-	-- Availability:
-	--
-	--   alpha 26
-	--
-	-- Status:
-	--
-	--   stable
-	--
-	Deregister = function (name, cb)
-		if not callbacks[name] then return end
-		callbacks[name][cb] = nil
-	end,
-
-	--
-	-- Function: Queue
-	--
-	-- Add an event to the queue of pending events. The event will be
-	-- distributed to the handlers when the queue is processed.
-	--
-	-- > Event.Queue(name, ...)
-	--
-	-- Parameters:
-	--
-	--   name - the name (type) of the event
-	--
-	--   ... - zero or more arguments to be passed to the handlers
-	--
-	-- Example:
-	--
-	-- > Event.Queue("onEnterSystem", ship)
-	--
-	-- Availability:
-	--
-	--   alpha 26
-	--
-	-- Status:
-	--
-	--   stable
-	--
-	Queue = function (name, ...)
-		table.insert(pending, { name = name, event = {...} })
-	end,
-
-	--
-	-- Function: DebugTimer
-	--
-	-- Enables the function timer for this event type. When enabled the console
-	-- will display the amount of time that each handler for this event type
-	-- takes to run.
-	--
-	-- > Event.DebugTimer(name, enabled)
-	--
-	-- Parameters:
-	--
-	--   name - name (type) of the event
-	--
-	--   enabled - a true value to enable the timer, or a false value to
-	--             disable it.
-	--
-	-- Availability:
-	--
-	--   alpha 26
-	--
-	-- Status:
-	--
-	--   debug
-    --
-
-    DebugTimer = function (name, enabled)
-		do_callback[name] = enabled and do_callback_timed or do_callback_normal
-	end,
-
-	-- internal method, called from C++
-	_Clear = function ()
-		pending = {}
-	end,
-
-	-- internal method, called from C++
-	_Emit = function ()
-		while #pending > 0 do
-			local p = table.remove(pending, 1)
-			if callbacks[p.name] then
-				for cb,_ in pairs(callbacks[p.name]) do
-					do_callback[p.name](cb, p)
-				end
-			end
-		end
-	end
-}
+-- The queue and the handler lists are kept natively, so events that nothing
+-- is registered for never reach Lua at all.
+
+local Event = import_core("Event")
+
+--
+-- Function: Register
+--
+-- Register a function with a specific type of event. When an event with
+-- the named type is processed, the function will be called.
+--
+-- > Event.Register(name, function)
+--
+-- Parameters:
+--
+--   name - the name (type) of the event
+--
+--   function - function to call when an event of the named type is processed.
+--              The function will recieve a copy of the parameters attached to
+--              the event.
+--
+--
+-- Example:
+--
+-- > Event.Register("onEnterSystem", function (ship)
+-- >     print("welcome to "..Game.system.name..", "..ship.label)
+-- > end)
+--
+-- Availability:
+--
+--   alpha 26
+--
+-- Status:
+--
+--   stable
+--
+
+--
+-- Function: Deregister
+--
+-- Deregisters a function from an event type. The funtion will no longer
+-- receive events of the named type.
+--
+-- If the function is not registered this method does nothing.
+--
+-- > Event.Deregister(name, function)
+--
+-- Parameters:
+--
+--   name - the name (type) of the event
+--
+--   function - a function that was previously connected to this queue with
+--              <Connect>
+--
+-- Availability:
+--
+--   alpha 26
+--
+-- Status:
+--
+--   stable
+--
+
+--
+-- Function: Queue
+--
+-- Add an event to the queue of pending events. The event will be
+-- distributed to the handlers registered for it when the queue is
+-- processed.
+--
+-- > Event.Queue(name, ...)
+--
+-- Parameters:
+--
+--   name - the name (type) of the event
+--
+--   ... - zero or more arguments to be passed to the handlers
+--
+-- Example:
+--
+-- > Event.Queue("onEnterSystem", ship)
+--
+-- Availability:
+--
+--   alpha 26
+--
+-- Status:
+--
+--   stable
+--
+
+--
+-- Function: DebugTimer
+--
+-- Enables the function timer for this event type. When enabled the console
+-- will display the amount of time that each handler for this event type
+-- takes to run.
+--
+-- > Event.DebugTimer(name, enabled)
+--
+-- Parameters:
+--
+--   name - name (type) of the event
+--
+--   enabled - a true value to enable the timer, or a false value to
+--             disable it.
+--
+-- Availability:
+--
+--   alpha 26
+--
+-- Status:
+--
+--   debug
+--
 
 --
 -- Event: onGameStart
@@ -15,7 +15,19 @@ struct Light {
 	vec4 specular;
 	vec4 position;
 };
-uniform Light uLight[4];
+
+//scene uniform parameters
+struct Scene {
+	vec4 ambient;
+};
+
+// shared by every program and set once when they change, rather than
+// per program per draw. bound to SCENE_BLOCK_BINDING
+layout(std140) uniform SceneData {
+	Light uLight[4];
+	Scene scene;
+	float invLogZfarPlus1;
+};
 
 struct Material {
 	vec4 emission;
@@ -35,4 +47,19 @@ layout (location = 4) in mat4 a_transform;
 // shadows 5, 6, and 7
 // next available is layout (location = 8) 
 
+#ifdef USE_INSTANCING
+// instance transforms are affine, so their bottom row is free to carry
+// other per instance data (see PATTERN_ARRAY in multi.vert). this is the
+// transform without it
+mat4 instanceTransform()
+{
+	mat4 m = a_transform;
+	m[0].w = 0.0;
+	m[1].w = 0.0;
+	m[2].w = 0.0;
+	m[3].w = 1.0;
+	return m;
+}
+#endif
+
 #endif // VERTEX_SHADER
\ No newline at end of file
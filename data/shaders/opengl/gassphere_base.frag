@@ -7,6 +7,8 @@ uniform float geosphereAtmosTopRad;
 uniform vec3 geosphereCenter;
 uniform float geosphereAtmosFogDensity;
 uniform float geosphereAtmosInvScaleHeight;
+uniform sampler2D atmosOpticalDepth;
+uniform int atmosHasOpticalDepth;
 
 #ifdef ECLIPSE
 uniform int shadows;
@@ -20,7 +22,6 @@ uniform vec3 sdivlrad;
 #endif // ECLIPSE
 
 uniform Material material;
-uniform Scene scene;
 
 in vec3 varyingEyepos;
 in vec3 varyingNormal;
@@ -107,7 +108,10 @@ void main(void)
 		// a&b scaled so length of 1.0 means planet surface.
 		vec3 a = (atmosStart * eyenorm - geosphereCenter) / geosphereScaledRadius;
 		vec3 b = (eyepos - geosphereCenter) / geosphereScaledRadius;
-		ldprod = AtmosLengthDensityProduct(a, b, atmosColor.w*geosphereAtmosFogDensity, atmosDist, geosphereAtmosInvScaleHeight);
+		if (atmosHasOpticalDepth != 0)
+			ldprod = AtmosLengthDensityProductLUT(a, b, atmosColor.w*geosphereAtmosFogDensity, geosphereScale * geosphereScaledRadius, atmosOpticalDepth, geosphereAtmosTopRad);
+		else
+			ldprod = AtmosLengthDensityProduct(a, b, atmosColor.w*geosphereAtmosFogDensity, atmosDist, geosphereAtmosInvScaleHeight);
 		fogFactor = clamp( 1.5 / exp(ldprod),0.0,1.0); 
 	}
 
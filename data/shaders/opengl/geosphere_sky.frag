@@ -10,6 +10,8 @@ uniform float geosphereAtmosTopRad;
 uniform vec3 geosphereCenter;
 uniform float geosphereAtmosFogDensity;
 uniform float geosphereAtmosInvScaleHeight;
+uniform sampler2D atmosOpticalDepth;
+uniform int atmosHasOpticalDepth;
 
 #ifdef ECLIPSE
 uniform int shadows;
@@ -68,7 +70,10 @@ void main(void)
 	// a&b scaled so length of 1.0 means planet surface.
 	vec3 a = (skyNear * eyenorm - geosphereCenter) / geosphereScaledRadius;
 	vec3 b = (skyFar * eyenorm - geosphereCenter) / geosphereScaledRadius;
-	ldprod = AtmosLengthDensityProduct(a, b, atmosColor.a * geosphereAtmosFogDensity, atmosDist, geosphereAtmosInvScaleHeight);
+	if (atmosHasOpticalDepth != 0)
+		ldprod = AtmosLengthDensityProductLUT(a, b, atmosColor.a * geosphereAtmosFogDensity, geosphereScale * geosphereScaledRadius, atmosOpticalDepth, geosphereAtmosTopRad);
+	else
+		ldprod = AtmosLengthDensityProduct(a, b, atmosColor.a * geosphereAtmosFogDensity, atmosDist, geosphereAtmosInvScaleHeight);
 	
 	float fogFactor = 1.0 / exp(ldprod);
 	vec4 atmosDiffuse = vec4(0.0);
@@ -13,12 +13,29 @@ out vec4 varyingEmission;
 uniform Material material;
 #endif
 
+#ifdef COMPACT_VERTICES
+// normals arrive octahedron-encoded in xy, see GeoPatch::_UpdateVBOs
+vec3 decodeNormal(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0) {
+		vec2 s = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(n.yx)) * s;
+	}
+	return n;
+}
+#endif
+
 void main(void)
 {
 	gl_Position = logarithmicTransform();
 	vertexColor = a_color;
 	varyingEyepos = vec3(uViewMatrix * a_vertex);
+#ifdef COMPACT_VERTICES
+	varyingNormal = normalize(uNormalMatrix * decodeNormal(a_normal.xy));
+#else
 	varyingNormal = normalize(uNormalMatrix * a_normal);
+#endif
 
 #ifdef TERRAIN_WITH_LAVA
 	varyingEmission = material.emission;
@@ -2,11 +2,6 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #ifdef FRAGMENT_SHADER
-//scene uniform parameters
-struct Scene {
-	vec4 ambient;
-};
-
 //Currently used by: planet ring shader, geosphere shaders
 float findSphereEyeRayEntryDistance(in vec3 sphereCenter, in vec3 eyeTo, in float radius)
 {
@@ -47,4 +42,44 @@ float AtmosLengthDensityProduct(vec3 a, vec3 b, float surfaceDensity, float len,
 	ldprod *= len;
 	return ldprod;
 }
+
+// Used by: geosphere shaders
+// Optical depth from a point r planet radii from the centre out to the top of
+// the atmosphere, heading at mu, the cosine of the angle from straight up.
+// the table is built by AtmosphereLUT.cpp and only holds rays heading up
+float AtmosOpticalDepth(sampler2D table, float r, float mu, float topRad)
+{
+	vec2 size = vec2(textureSize(table, 0));
+	vec2 uv = vec2(sqrt(clamp((r - 1.0) / (topRad - 1.0), 0.0, 1.0)), sqrt(clamp(mu, 0.0, 1.0)));
+	return texture(table, (uv * (size - 1.0) + 0.5) / size).r;
+}
+
+// AtmosLengthDensityProduct from the optical depth table. the line is split
+// where it passes closest to the centre so each half is looked up heading up
+// a - start coord (normalized relative to planet radius)
+// b - end coord " "
+// radius - real planet radius in meters
+float AtmosLengthDensityProductLUT(vec3 a, vec3 b, float surfaceDensity, float radius, sampler2D table, float topRad)
+{
+	float len = length(b - a);
+	if (len <= 0.0)
+		return 0.0;
+	vec3 dir = (b - a) / len;
+	float ra = length(a);
+	float rb = length(b);
+	float closest = -dot(a, dir);
+	float depth;
+	if (closest <= 0.0) {
+		depth = AtmosOpticalDepth(table, ra, dot(a, dir) / ra, topRad) - AtmosOpticalDepth(table, rb, dot(b, dir) / rb, topRad);
+	} else if (closest >= len) {
+		depth = AtmosOpticalDepth(table, rb, -dot(b, dir) / rb, topRad) - AtmosOpticalDepth(table, ra, -dot(a, dir) / ra, topRad);
+	} else {
+		float rp = length(a + closest * dir);
+		depth = 2.0 * AtmosOpticalDepth(table, rp, 0.0, topRad)
+			- AtmosOpticalDepth(table, ra, -dot(a, dir) / ra, topRad)
+			- AtmosOpticalDepth(table, rb, dot(b, dir) / rb, topRad);
+	}
+	// the sampled version adds up six densities, so is six times the mean
+	return 6.0 * surfaceDensity * radius * max(depth, 0.0);
+}
 #endif
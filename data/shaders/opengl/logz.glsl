@@ -3,7 +3,6 @@
 
 // See http://www.gamedev.net/community/forums/mod/journal/journal.asp?jn=263350&reply_id=3513134
 #ifdef FRAGMENT_SHADER
-uniform float invLogZfarPlus1;
 in float varLogDepth;
 #else
 out float varLogDepth;
@@ -14,7 +13,7 @@ vec4 logarithmicTransform()
 {
 #ifdef USE_INSTANCING
 	//vec4 vertexPosClip = uProjectionMatrix * uViewMatrix * a_transform * a_vertex;
-	vec4 vertexPosClip = uViewProjectionMatrix * a_transform * a_vertex;
+	vec4 vertexPosClip = uViewProjectionMatrix * instanceTransform() * a_vertex;
 #else
 	vec4 vertexPosClip = uViewProjectionMatrix * a_vertex;
 #endif
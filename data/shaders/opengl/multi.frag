@@ -6,11 +6,42 @@ uniform sampler2D texture0; //diffuse
 uniform sampler2D texture1; //specular
 uniform sampler2D texture2; //glow
 uniform sampler2D texture3; //ambient
+#ifdef PATTERN_ARRAY
+uniform sampler2DArray texture4; //every pattern, a layer each
+#else
 uniform sampler2D texture4; //pattern
-uniform sampler2D texture5; //color
+#endif
 in vec2 texCoord0;
 #endif
 
+#ifdef MAP_COLOR
+#ifdef PATTERN_ARRAY
+flat in vec4 instancePatternColors[3];
+flat in vec2 instancePattern;
+#define PATTERN_COLORS instancePatternColors
+#define SMOOTH_PATTERN_COLORS (instancePattern.y > 0.5)
+#else
+uniform vec4 patternColors[3]; //primary, secondary, trim
+uniform bool smoothPatternColors;
+#define PATTERN_COLORS patternColors
+#define SMOOTH_PATTERN_COLORS smoothPatternColors
+#endif
+
+// the pattern's red channel picks from white and the three colours, a
+// quarter of the range each. sampled as if they were a 16 texel wide
+// ramp, which is what they used to be
+vec4 lookupPatternColor(float u)
+{
+	vec4 ramp[4] = vec4[4](vec4(1.0), vec4(PATTERN_COLORS[0].rgb, 1.0),
+		vec4(PATTERN_COLORS[1].rgb, 1.0), vec4(PATTERN_COLORS[2].rgb, 1.0));
+	if (!SMOOTH_PATTERN_COLORS)
+		return ramp[int(clamp(u * 16.0, 0.0, 15.0)) / 4];
+	float t = clamp(u * 16.0 - 0.5, 0.0, 15.0);
+	int texel = int(t);
+	return mix(ramp[texel / 4], ramp[min(texel + 1, 15) / 4], t - float(texel));
+}
+#endif
+
 #ifdef VERTEXCOLOR
 in vec4 vertexColor;
 #endif
@@ -24,7 +55,6 @@ in vec3 normal;
 	#endif // HEAT_COLOURING
 #endif // (NUM_LIGHTS > 0)
 
-uniform Scene scene;
 uniform Material material;
 
 out vec4 frag_color;
@@ -60,8 +90,12 @@ void main(void)
 #endif
 //patterns - simple lookup
 #ifdef MAP_COLOR
+#ifdef PATTERN_ARRAY
+	vec4 pat = texture(texture4, vec3(texCoord0, instancePattern.x));
+#else
 	vec4 pat = texture(texture4, texCoord0);
-	vec4 mapColor = texture(texture5, vec2(pat.r, 0.0));
+#endif
+	vec4 mapColor = lookupPatternColor(pat.r);
 	vec4 tint = mix(vec4(1.0),mapColor,pat.a);
 	color *= tint;
 #endif
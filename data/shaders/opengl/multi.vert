@@ -9,6 +9,21 @@ out vec2 texCoord0;
 #ifdef VERTEXCOLOR
 out vec4 vertexColor;
 #endif
+#ifdef PATTERN_ARRAY
+// each instance's pattern layer and colours, packed into the bottom row of
+// its transform by SceneGraph::Model::PackInstanceSkin. instances without
+// them (a bottom row of 0,0,0,1) use the material's colours and layer 0
+uniform vec4 patternColors[3];
+uniform bool smoothPatternColors;
+flat out vec4 instancePatternColors[3];
+flat out vec2 instancePattern; // layer, smooth colours
+
+vec4 unpackColor(float packed)
+{
+	int c = int(packed);
+	return vec4(float((c >> 16) & 255), float((c >> 8) & 255), float(c & 255), 255.0) / 255.0;
+}
+#endif
 #if (NUM_LIGHTS > 0)
 out vec3 eyePos;
 out vec3 normal;
@@ -28,10 +43,24 @@ void main(void)
 #ifdef TEXTURE0
 	texCoord0 = a_uv0.xy;
 #endif
+#ifdef PATTERN_ARRAY
+	float skin = a_transform[3].w;
+	if (skin >= 2.0) {
+		int s = int(skin) - 2;
+		for (int i = 0; i < 3; i++)
+			instancePatternColors[i] = unpackColor(a_transform[i].w);
+		instancePattern = vec2(float(s / 2), float(s & 1));
+	} else {
+		for (int i = 0; i < 3; i++)
+			instancePatternColors[i] = patternColors[i];
+		instancePattern = vec2(0.0, smoothPatternColors ? 1.0 : 0.0);
+	}
+#endif
 #if (NUM_LIGHTS > 0)
 #ifdef USE_INSTANCING
-	eyePos = vec3(uViewMatrix * (a_transform * a_vertex));
-	normal = normalize(uNormalMatrix * (mat3(a_transform) * a_normal));
+	mat4 transform = instanceTransform();
+	eyePos = vec3(uViewMatrix * (transform * a_vertex));
+	normal = normalize(uNormalMatrix * (mat3(transform) * a_normal));
 #else
 	eyePos = vec3(uViewMatrix * a_vertex);
 	normal = normalize(uNormalMatrix * a_normal);
@@ -0,0 +1,15 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+uniform Material material;
+
+in float alpha;
+
+out vec4 frag_color;
+
+void main(void)
+{
+	frag_color = vec4(material.diffuse.rgb, alpha);
+
+	SetFragDepth();
+}
@@ -0,0 +1,20 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+// how far the points have moved, the half line, and the half size of the box
+uniform vec3 lineOffset;
+uniform vec3 lineDir;
+uniform float lineBounds;
+
+out float alpha;
+
+void main(void)
+{
+	// points that leave the box come back in the other side
+	vec3 p = mod(a_vertex.xyz - lineOffset + lineBounds, 2.0 * lineBounds) - lineBounds;
+	// distance fade
+	alpha = clamp(1.0 - length(p) / lineBounds, 0.0, 1.0);
+
+	gl_Position = uViewProjectionMatrix * vec4(p + a_uv0.x * lineDir, 1.0);
+	varLogDepth = gl_Position.z;
+}
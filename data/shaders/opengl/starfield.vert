@@ -4,10 +4,12 @@
 out vec4 color;
 
 uniform Material material;
+// how far the stars have moved in hyperspace, zero outside it
+uniform vec3 hyperspaceOffset;
 
 void main(void)
 {
-	gl_Position = uViewProjectionMatrix * a_vertex;
+	gl_Position = uViewProjectionMatrix * vec4(a_vertex.xyz + hyperspaceOffset, 1.0);
 	gl_PointSize = 1.0 + pow(a_color.r,3.0);
 	color = a_color * material.emission;
 }
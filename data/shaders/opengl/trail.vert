@@ -0,0 +1,17 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+// sample number of the newest point, and how many points there are
+uniform float trailHead;
+uniform float trailCount;
+
+out float alpha;
+
+void main(void)
+{
+	gl_Position = logarithmicTransform();
+	// the newest point is nearly opaque, down to nothing at the oldest.
+	// sample numbers wrap at 65536, which a float holds exactly
+	float age = mod(trailHead - a_uv0.x, 65536.0);
+	alpha = clamp((trailCount - 1.0 - age) / trailCount, 0.0, 1.0);
+}
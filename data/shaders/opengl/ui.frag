@@ -6,14 +6,20 @@ in vec2 texCoord0;
 
 in vec4 vertexColor;
 
-uniform Scene scene;
 uniform Material material;
 
 out vec4 frag_color;
 
 void main(void)
 {
+#ifdef DISTANCE_FIELD
+	// 0.5 is the glyph edge. fwidth keeps it a pixel wide at any scale
+	float dist = texture(texture0, texCoord0).x;
+	float width = fwidth(dist);
+	frag_color = vertexColor * smoothstep(0.5 - width, 0.5 + width, dist);
+#else
 	frag_color = vertexColor * texture(texture0, texCoord0).x;
+#endif
 	
 	SetFragDepth();
 }
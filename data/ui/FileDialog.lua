@@ -17,6 +17,7 @@ ui.templates.FileDialog = function (args)
 	local cancelLabel = args.cancelLabel or l.CANCEL
 	local onSelect    = args.onSelect    or function (name) end
 	local onCancel    = args.onCancel    or function () end
+	local describe    = args.describe
 
 	local ok, files, _ = pcall(FileSystem.ReadDirectory, root, path)
 	if not ok then
@@ -31,7 +32,13 @@ ui.templates.FileDialog = function (args)
 
 	local list = ui:List()
 	for i = 1,#files do
-		list:AddOption(Format.Date(files[i].mtime.timestamp) .. ' - ' .. files[i].name)
+		local text = Format.Date(files[i].mtime.timestamp) .. ' - ' .. files[i].name
+		-- extra detail, if the caller can find any
+		local detail = describe and describe(files[i].name)
+		if detail then
+			text = text .. ' - ' .. detail
+		end
+		list:AddOption(text)
 	end
 
 	local selectButton = ui:Button(ui:Label(selectLabel):SetFont("HEADING_NORMAL"))
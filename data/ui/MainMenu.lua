@@ -9,6 +9,7 @@ local ShipDef = import("ShipDef")
 local Player = import("Player")
 local SystemPath = import("SystemPath")
 local ErrorScreen = import("ErrorScreen")
+local Format = import("Format")
 local equipment = import("Equipment")
 local cargo = equipment.cargo
 local misc = equipment.misc
@@ -60,6 +61,14 @@ local loadGame = function (path)
 	end
 end
 
+-- from the summary at the front of the save, so the file isn't loaded
+local describeSave = function (name)
+	local stats = Game.SaveGameStats(name)
+	if not stats then return nil end
+	local where = stats.location ~= '' and stats.location .. ', ' .. stats.system or stats.system
+	return string.format('%s - %s - %s (%s)', Format.Date(stats.time), where, Format.Money(stats.money), stats.ship_label)
+end
+
 local doLoadDialog = function ()
 	ui:NewLayer(
 		ui.templates.FileDialog({
@@ -68,6 +77,7 @@ local doLoadDialog = function ()
 			path        = "savefiles",
 			selectLabel = l.LOAD_GAME,
 			onSelect    = loadGame,
+			describe    = describeSave,
 			onCancel    = function () ui:DropLayer() end
 		})
 	)
@@ -66,6 +66,12 @@ static sigc::connection onChangeCamTypeConnection;
 void AmbientSounds::Init()
 {
 	onChangeCamTypeConnection = Pi::game->GetWorldView()->onChangeCamType.connect(sigc::ptr_fun(&AmbientSounds::UpdateForCamType));
+
+	// the ones that are bound to be wanted early on
+	Sound::Prefetch("Thruster_large");
+	Sound::Prefetch("Thruster_Small");
+	for (Uint32 i = 0; i < NUM_STATION_SOUNDS; i++)
+		Sound::Prefetch(s_stationNoiseSounds[i]);
 }
 
 void AmbientSounds::Uninit()
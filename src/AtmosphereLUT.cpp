@@ -0,0 +1,114 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "AtmosphereLUT.h"
+#include "JobQueue.h"
+#include "Pi.h"
+#include "graphics/Renderer.h"
+#include "graphics/Texture.h"
+#include <map>
+
+namespace AtmosphereLUT {
+
+static const int NUM_HEIGHTS = 64;
+static const int NUM_ANGLES = 128;
+// steps along each ray, bunched up near the start where the air is thickest
+static const int NUM_STEPS = 256;
+// a system has a handful of atmospheres, this covers a few systems' worth
+static const size_t MAX_TABLES = 32;
+
+// inverse scale height, atmosphere radius
+typedef std::pair<float,float> Key;
+
+struct Table {
+	RefCountedPtr<Graphics::Texture> texture;
+	Job::Handle job;
+	Uint32 lastUsed;
+};
+
+static std::map<Key,Table> s_tables;
+
+class BuildJob : public Job {
+public:
+	BuildJob(Graphics::Renderer *r, const Key &key) : m_renderer(r), m_key(key) {}
+
+	virtual void OnRun() override {
+		PROFILE_SCOPED()
+		const double invScaleHeight = m_key.first;
+		const double top = m_key.second;
+		m_depth.resize(NUM_HEIGHTS * NUM_ANGLES);
+		for (int j = 0; j < NUM_ANGLES; j++) {
+			const double v = double(j) / double(NUM_ANGLES - 1);
+			const double mu = v * v;
+			for (int i = 0; i < NUM_HEIGHTS; i++) {
+				const double u = double(i) / double(NUM_HEIGHTS - 1);
+				const double r = 1.0 + u * u * (top - 1.0);
+				// where the ray leaves the atmosphere
+				const double exit = -r * mu + sqrt(std::max(0.0, r * r * (mu * mu - 1.0) + top * top));
+
+				double depth = 0.0;
+				double prevT = 0.0;
+				double prevDensity = exp(-invScaleHeight * (r - 1.0));
+				for (int s = 1; s <= NUM_STEPS; s++) {
+					const double f = double(s) / double(NUM_STEPS);
+					const double t = exit * f * f;
+					const double h = sqrt(r * r + 2.0 * r * mu * t + t * t) - 1.0;
+					const double density = exp(-invScaleHeight * std::max(h, 0.0));
+					depth += 0.5 * (prevDensity + density) * (t - prevT);
+					prevT = t;
+					prevDensity = density;
+				}
+				m_depth[j * NUM_HEIGHTS + i] = float(depth);
+			}
+		}
+	}
+
+	virtual void OnFinish() override {
+		auto it = s_tables.find(m_key);
+		if (it == s_tables.end())
+			return;
+		const vector2f size(NUM_HEIGHTS, NUM_ANGLES);
+		const Graphics::TextureDescriptor desc(Graphics::TEXTURE_R_FLOAT, size, Graphics::LINEAR_CLAMP, false, false);
+		it->second.texture.Reset(m_renderer->CreateTexture(desc));
+		it->second.texture->Update(&m_depth[0], size, Graphics::TEXTURE_R_FLOAT);
+	}
+
+	virtual const char *GetName() const override { return "AtmosphereLUT"; }
+
+private:
+	Graphics::Renderer *m_renderer;
+	const Key m_key;
+	std::vector<float> m_depth;
+};
+
+// drop the table that has gone longest without being drawn
+static void Evict()
+{
+	auto oldest = s_tables.begin();
+	for (auto it = s_tables.begin(); it != s_tables.end(); ++it) {
+		if (Sint32(it->second.lastUsed - oldest->second.lastUsed) < 0)
+			oldest = it;
+	}
+	s_tables.erase(oldest);
+}
+
+Graphics::Texture *Get(Graphics::Renderer *r, const SystemBody::AtmosphereParameters &ap)
+{
+	const Key key(ap.atmosInvScaleHeight, ap.atmosRadius);
+	auto it = s_tables.find(key);
+	if (it == s_tables.end()) {
+		if (s_tables.size() >= MAX_TABLES)
+			Evict();
+		it = s_tables.insert(std::make_pair(key, Table())).first;
+		it->second.job = Pi::GetAsyncJobQueue()->Queue(new BuildJob(r, key));
+	}
+	it->second.lastUsed = SDL_GetTicks();
+	return it->second.texture.Get();
+}
+
+void Uninit()
+{
+	s_tables.clear();
+}
+
+}
@@ -0,0 +1,36 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _ATMOSPHERELUT_H
+#define _ATMOSPHERELUT_H
+
+#include "libs.h"
+#include "galaxy/StarSystem.h"
+
+namespace Graphics {
+	class Renderer;
+	class Texture;
+}
+
+/*
+ * Optical depth tables for the planet and gas giant atmospheres, so the
+ * shaders can look up how much atmosphere a ray passes through instead of
+ * sampling the density along it for every fragment.
+ *
+ * Each table is for one inverse scale height and atmosphere radius, and
+ * holds the depth from a point out to the top of the atmosphere against the
+ * point's height (x) and the cosine of the ray's angle from straight up (y),
+ * both square rooted to spend more of the table near the ground and the
+ * horizon. Depths are in planet radii, with a density of one at the surface.
+ *
+ * Tables are built on the job queue the first time a planet asks for one,
+ * until then the shaders sample the density as they did before.
+ */
+namespace AtmosphereLUT {
+	// the table for these parameters, or nullptr while it's being built
+	Graphics::Texture *Get(Graphics::Renderer *r, const SystemBody::AtmosphereParameters &ap);
+
+	void Uninit();
+}
+
+#endif
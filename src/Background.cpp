@@ -202,15 +202,6 @@ void Starfield::Init()
 	desc.vertexColors = true;
 	m_material.Reset(m_renderer->CreateMaterial(desc));
 	m_material->emissive = Color::WHITE;
-
-	Graphics::VertexBufferDesc vbd;
-	vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-	vbd.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-	vbd.attrib[1].semantic = Graphics::ATTRIB_DIFFUSE;
-	vbd.attrib[1].format = Graphics::ATTRIB_FORMAT_UBYTE4;
-	vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;
-	vbd.numVertices = BG_STAR_MAX*2;
-	m_animBuffer.reset(m_renderer->CreateVertexBuffer(vbd));
 }
 
 void Starfield::Fill(Random &rand)
@@ -227,39 +218,54 @@ void Starfield::Fill(Random &rand)
 	assert(sizeof(StarVert) == 16);
 	assert(m_vertexBuffer->GetDesc().stride == sizeof(StarVert));
 	auto vtxPtr = m_vertexBuffer->Map<StarVert>(Graphics::BUFFER_MAP_WRITE);
+	//kept for the hyperspace streaks below, only one buffer can be mapped at a time
+	std::unique_ptr<StarVert[]> stars(new StarVert[BG_STAR_MAX]);
 	//fill the array
 	for (int i=0; i<BG_STAR_MAX; i++) {
-		const Uint8 col = rand.Double(0.2,0.7)*255;
+		//three numbers per star, in the order they were once drawn one at a time
+		double rnd[3];
+		rand.FillDouble(&rnd[0], 1, 0.2, 0.7);
+		rand.FillDouble(&rnd[1], 1, 0.0, 2.0*M_PI);
+		rand.FillDouble(&rnd[2], 1, -1.0, 1.0);
+
+		const Uint8 col = rnd[0]*255;
 
 		// this is proper random distribution on a sphere's surface
-		const float theta = float(rand.Double(0.0, 2.0*M_PI));
-		const float u = float(rand.Double(-1.0, 1.0));
+		const float theta = float(rnd[1]);
+		const float u = float(rnd[2]);
 
 		vtxPtr->pos = vector3f(
 			1000.0f * sqrt(1.0f - u*u) * cos(theta),
 			1000.0f * u,
 			1000.0f * sqrt(1.0f - u*u) * sin(theta));
 		vtxPtr->col = Color(col, col, col,	255);
-
-		//need to keep data around for HS anim - this is stupid
-		m_hyperVtx[BG_STAR_MAX * 2 + i] = vtxPtr->pos;
-		m_hyperCol[BG_STAR_MAX * 2 + i] = vtxPtr->col;
+		stars[i] = *vtxPtr;
 
 		vtxPtr++;
 	}
 	m_vertexBuffer->Unmap();
+
+	//each streak runs from the star out to twice as far. the shader moves
+	//them along, so they don't change until the stars do
+	vbd.numVertices = BG_STAR_MAX*2;
+	m_animBuffer.reset(m_renderer->CreateVertexBuffer(vbd));
+	assert(m_animBuffer->GetDesc().stride == sizeof(StarVert));
+	auto animPtr = m_animBuffer->Map<StarVert>(Graphics::BUFFER_MAP_WRITE);
+	for (int i=0; i<BG_STAR_MAX; i++) {
+		animPtr[i*2].pos = stars[i].pos * 2.0f;
+		animPtr[i*2].col = stars[i].col;
+		animPtr[i*2+1] = stars[i];
+	}
+	m_animBuffer->Unmap();
 }
 
 void Starfield::Draw(Graphics::RenderState *rs)
 {
 	// XXX would be nice to get rid of the Pi:: stuff here
 	if (!Pi::game || Pi::player->GetFlightState() != Ship::HYPERSPACE) {
+		m_material->specialParameter0 = nullptr;
 		m_renderer->DrawBuffer(m_vertexBuffer.get(), rs, m_material.Get(), Graphics::POINTS);
 	} else {
-		assert(sizeof(StarVert) == 16);
-		assert(m_animBuffer->GetDesc().stride == sizeof(StarVert));
-		auto vtxPtr = m_animBuffer->Map<StarVert>(Graphics::BUFFER_MAP_WRITE);
-
 		// roughly, the multiplier gets smaller as the duration gets larger.
 		// the time-looking bits in this are completely arbitrary - I figured
 		// it out by tweaking the numbers until it looked sort of right
@@ -268,17 +274,8 @@ void Starfield::Draw(Graphics::RenderState *rs)
 		const double hyperspaceProgress = Pi::game->GetHyperspaceProgress();
 
 		const vector3d pz = Pi::player->GetOrient().VectorZ();	//back vector
-		for (int i=0; i<BG_STAR_MAX; i++) {
-			vector3f v = m_hyperVtx[BG_STAR_MAX * 2 + i] + vector3f(pz*hyperspaceProgress*mult);
-			const Color &c = m_hyperCol[BG_STAR_MAX * 2 + i];
-
-			vtxPtr[i*2].pos = m_hyperVtx[i*2] = m_hyperVtx[BG_STAR_MAX * 2 + i] + v;
-			vtxPtr[i*2].col = m_hyperCol[i*2] = c;
-
-			vtxPtr[i*2+1].pos = m_hyperVtx[i*2+1] = v;
-			vtxPtr[i*2+1].col = m_hyperCol[i*2+1] = c;
-		}
-		m_animBuffer->Unmap();
+		m_params.hyperspaceOffset = vector3f(pz*hyperspaceProgress*mult);
+		m_material->specialParameter0 = &m_params;
 		m_renderer->DrawBuffer(m_animBuffer.get(), rs, m_material.Get(), Graphics::LINE_SINGLE);
 	}
 }
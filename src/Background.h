@@ -21,6 +21,11 @@ namespace Graphics {
 
 namespace Background
 {
+	// passed to the starfield material in specialParameter0
+	struct StarfieldParameters {
+		vector3f hyperspaceOffset;
+	};
+
 	class BackgroundElement
 	{
 	public:
@@ -63,10 +68,9 @@ namespace Background
 		static const int BG_STAR_MAX = 100000;
 		std::unique_ptr<Graphics::VertexBuffer> m_vertexBuffer;
 
-		//hyperspace animation vertex data
-		vector3f m_hyperVtx[BG_STAR_MAX*3];
-		Color m_hyperCol[BG_STAR_MAX*3];
+		//hyperspace streaks, a line out from each star
 		std::unique_ptr<Graphics::VertexBuffer> m_animBuffer;
+		StarfieldParameters m_params;
 	};
 
 	class MilkyWay : public BackgroundElement
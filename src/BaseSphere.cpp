@@ -4,11 +4,15 @@
 #include "libs.h"
 #include "Pi.h"
 #include "BaseSphere.h"
+#include "AtmosphereLUT.h"
 #include "GeoSphere.h"
 #include "GasGiant.h"
 #include "graphics/Material.h"
 
-BaseSphere::BaseSphere(const SystemBody *body) : m_sbody(body), m_terrain(Terrain::InstanceTerrain(body)) {}
+BaseSphere::BaseSphere(const SystemBody *body) : m_sbody(body), m_terrain(Terrain::InstanceTerrain(body))
+{
+	m_materialParameters.opticalDepth = nullptr;
+}
 
 BaseSphere::~BaseSphere() {}
 
@@ -16,12 +20,14 @@ BaseSphere::~BaseSphere() {}
 void BaseSphere::Init()
 {
 	GeoSphere::Init();
+	GasGiant::Init();
 }
 
 //static 
 void BaseSphere::Uninit()
 {
 	GeoSphere::Uninit();
+	AtmosphereLUT::Uninit();
 }
 
 //static 
@@ -31,6 +37,12 @@ void BaseSphere::UpdateAllBaseSphereDerivatives()
 	GasGiant::UpdateAllGasGiants();
 }
 
+//static 
+void BaseSphere::BeginFrame()
+{
+	GeoSphere::BeginFrame();
+}
+
 //static 
 void BaseSphere::OnChangeDetailLevel()
 {
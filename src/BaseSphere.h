@@ -17,6 +17,7 @@ namespace Graphics {
 	class Renderer; 
 	class RenderState;
 	class Material;
+	class Texture;
 }
 class SystemBody;
 
@@ -33,6 +34,8 @@ public:
 	static void Init();
 	static void Uninit();
 	static void UpdateAllBaseSphereDerivatives();
+	// once per frame, before anything is drawn
+	static void BeginFrame();
 	static void OnChangeDetailLevel();
 	static void DrawAtmosphereSurface(Graphics::Renderer *renderer,
 		const matrix4x4d &modelView, const vector3d &campos, float rad,
@@ -44,6 +47,7 @@ public:
 	struct MaterialParameters {
 		SystemBody::AtmosphereParameters atmosphere;
 		std::vector<Camera::Shadow> shadows;
+		Graphics::Texture *opticalDepth; // from AtmosphereLUT, nullptr while it's built
 	};
 
 	virtual void Reset()=0;
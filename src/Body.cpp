@@ -10,7 +10,6 @@
 #include "SpaceStation.h"
 #include "Ship.h"
 #include "Player.h"
-#include "Projectile.h"
 #include "Missile.h"
 #include "HyperspaceCloud.h"
 #include "Pi.h"
@@ -35,6 +34,29 @@ Body::Body() : PropertiedObject(Lua::manager)
 
 Body::~Body()
 {
+	for (Body *w : m_watchers)
+		w->m_watching.erase(std::find(w->m_watching.begin(), w->m_watching.end(), this));
+	for (Body *b : m_watching)
+		b->m_watchers.erase(std::find(b->m_watchers.begin(), b->m_watchers.end(), this));
+}
+
+void Body::AddWatcher(Body *watcher)
+{
+	if (!watcher || watcher == this) return;
+	if (std::find(m_watchers.begin(), m_watchers.end(), watcher) != m_watchers.end()) return;
+	m_watchers.push_back(watcher);
+	watcher->m_watching.push_back(this);
+}
+
+void Body::NotifyWatchers()
+{
+	// a watcher may pick something else to watch as it lets go of this
+	std::vector<Body*> watchers;
+	watchers.swap(m_watchers);
+	for (Body *w : watchers) {
+		w->m_watching.erase(std::find(w->m_watching.begin(), w->m_watching.end(), this));
+		w->NotifyRemoved(this);
+	}
 }
 
 void Body::SaveToJson(Json::Value &jsonObj, Space *space)
@@ -57,7 +79,7 @@ void Body::SaveToJson(Json::Value &jsonObj, Space *space)
 void Body::LoadFromJson(const Json::Value &jsonObj, Space *space)
 {
 	if (!jsonObj.isMember("body")) throw SavedGameCorruptException();
-	Json::Value bodyObj = jsonObj["body"];
+	const Json::Value &bodyObj = jsonObj["body"];
 
 	if (!bodyObj.isMember("index_for_frame")) throw SavedGameCorruptException();
 	if (!bodyObj.isMember("label")) throw SavedGameCorruptException();
@@ -89,7 +111,6 @@ void Body::ToJson(Json::Value &jsonObj, Space *space)
 	case Object::PLAYER:
 	case Object::MISSILE:
 	case Object::CARGOBODY:
-	case Object::PROJECTILE:
 	case Object::HYPERSPACECLOUD:
 		SaveToJson(jsonObj, space);
 		break;
@@ -117,8 +138,6 @@ Body *Body::FromJson(const Json::Value &jsonObj, Space *space)
 		b = new Player(); break;
 	case Object::MISSILE:
 		b = new Missile(); break;
-	case Object::PROJECTILE:
-		b = new Projectile(); break;
 	case Object::CARGOBODY:
 		b = new CargoBody(); break;
 	case Object::HYPERSPACECLOUD:
@@ -132,16 +151,12 @@ Body *Body::FromJson(const Json::Value &jsonObj, Space *space)
 
 vector3d Body::GetPositionRelTo(const Frame *relTo) const
 {
-	vector3d fpos = m_frame->GetPositionRelTo(relTo);
-	matrix3x3d forient = m_frame->GetOrientRelTo(relTo);
-	return forient * GetPosition() + fpos;
+	return m_frame->GetPointRelTo(relTo, GetPosition());
 }
 
 vector3d Body::GetInterpPositionRelTo(const Frame *relTo) const
 {
-	vector3d fpos = m_frame->GetInterpPositionRelTo(relTo);
-	matrix3x3d forient = m_frame->GetInterpOrientRelTo(relTo);
-	return forient * GetInterpPosition() + fpos;
+	return m_frame->GetInterpPointRelTo(relTo, GetInterpPosition());
 }
 
 vector3d Body::GetPositionRelTo(const Body *relTo) const
@@ -168,10 +183,9 @@ matrix3x3d Body::GetInterpOrientRelTo(const Frame *relTo) const
 
 vector3d Body::GetVelocityRelTo(const Frame *relTo) const
 {
-	matrix3x3d forient = m_frame->GetOrientRelTo(relTo);
-	vector3d vel = GetVelocity();
-	if (m_frame != relTo) vel -= m_frame->GetStasisVelocity(GetPosition());
-	return forient * vel + m_frame->GetVelocityRelTo(relTo);
+	if (m_frame == relTo) return GetVelocity();
+	const vector3d vel = GetVelocity() - m_frame->GetStasisVelocity(GetPosition());
+	return m_frame->GetDirectionRelTo(relTo, vel) + m_frame->GetVelocityRelTo(relTo);
 }
 
 vector3d Body::GetVelocityRelTo(const Body *relTo) const
@@ -11,6 +11,7 @@
 #include "Serializer.h"
 #include "PropertiedObject.h"
 #include <string>
+#include <vector>
 
 class ObjMesh;
 class Space;
@@ -44,14 +45,29 @@ public:
 	virtual bool OnCollision(Object *o, Uint32 flags, double relVel) { return false; }
 	// Attacker may be null
 	virtual bool OnDamage(Object *attacker, float kgDamage, const CollisionContact& contactData) { return false; }
-	// Override to clear any pointers you hold to the body
+	// Override to clear any pointers you hold to the body. only called on
+	// bodies that asked for it with AddWatcher
 	virtual void NotifyRemoved(const Body* const removedBody) {}
+	// watcher holds a pointer to this body, and gets NotifyRemoved when it
+	// leaves the space. the link goes when either of them is destroyed
+	void AddWatcher(Body *watcher);
+	// for Space on removal. tells the watchers, then forgets them
+	void NotifyWatchers();
 
 	// before all bodies have had TimeStepUpdate (their moving step),
-	// StaticUpdate() is called. Good for special collision testing (Projectiles)
+	// StaticUpdate() is called. Good for special collision testing
 	// as you can't test for collisions if different objects are on different 'steps'
 	virtual void StaticUpdate(const float timeStep) {}
+	// optional step before StaticUpdate, used when the parallel body update
+	// is enabled. it runs on a worker thread alongside other bodies, so it may
+	// read other bodies but only change its own state. anything with effects
+	// on other bodies or on global state has to wait for StaticUpdate
+	virtual void ParallelUpdate(const float timeStep) {}
 	virtual void TimeStepUpdate(const float timeStep) {}
+	// with the simulation LOD on, the most physics ticks the three updates
+	// above may be apart for this body. the step they get is then the time
+	// since the last one. Space brings it back to every tick near the player
+	virtual Uint32 GetMaxSimulationInterval() const { return 1; }
 	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform) = 0;
 
 	virtual void SetFrame(Frame *f) { m_frame = f; }
@@ -117,6 +133,9 @@ private:
 	bool m_dead;				// Checked in destructor to make sure body has been marked dead.
 	double m_clipRadius;
 	double m_physRadius;
+
+	std::vector<Body*> m_watchers; // holding a pointer to this body
+	std::vector<Body*> m_watching; // this body holds a pointer to
 };
 
 #endif /* _BODY_H */
@@ -0,0 +1,84 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "BodyIntegrator.h"
+#include "DynamicBody.h"
+#include "JobQueue.h"
+
+// below this many bodies it isn't worth waking the runners
+static const Uint32 PARALLEL_MIN_BODIES = 1024;
+static const Uint32 PARALLEL_BATCH = 256;
+
+void BodyIntegrator::Begin()
+{
+	m_bodies.clear();
+	m_timeStep.clear();
+	for (int a = 0; a < 3; a++) {
+		m_pos[a].clear();
+		m_vel[a].clear();
+		m_angVel[a].clear();
+		m_force[a].clear();
+		m_torque[a].clear();
+	}
+	m_invMass.clear();
+	m_invAngInertia.clear();
+}
+
+void BodyIntegrator::Add(DynamicBody *body, double timeStep, const vector3d &pos, const vector3d &vel, const vector3d &angVel,
+	const vector3d &force, const vector3d &torque, double mass, double angInertia)
+{
+	m_bodies.push_back(body);
+	m_timeStep.push_back(timeStep);
+	for (int a = 0; a < 3; a++) {
+		m_pos[a].push_back(pos[a]);
+		m_vel[a].push_back(vel[a]);
+		m_angVel[a].push_back(angVel[a]);
+		m_force[a].push_back(force[a]);
+		m_torque[a].push_back(torque[a]);
+	}
+	m_invMass.push_back(1.0 / mass);
+	m_invAngInertia.push_back(1.0 / angInertia);
+}
+
+// the same steps as DynamicBody::TimeStepUpdate: velocities from forces,
+// then position from the new velocity
+void BodyIntegrator::IntegrateRange(Uint32 begin, Uint32 end)
+{
+	const double *dt = m_timeStep.data();
+	const double *invMass = m_invMass.data();
+	const double *invAngInertia = m_invAngInertia.data();
+
+	for (int a = 0; a < 3; a++) {
+		double *pos = m_pos[a].data();
+		double *vel = m_vel[a].data();
+		double *angVel = m_angVel[a].data();
+		const double *force = m_force[a].data();
+		const double *torque = m_torque[a].data();
+
+		for (Uint32 i = begin; i < end; i++)
+			vel[i] += dt[i] * force[i] * invMass[i];
+		for (Uint32 i = begin; i < end; i++)
+			angVel[i] += dt[i] * torque[i] * invAngInertia[i];
+		for (Uint32 i = begin; i < end; i++)
+			pos[i] += vel[i] * dt[i];
+	}
+}
+
+void BodyIntegrator::Integrate(JobQueue *jobs)
+{
+	PROFILE_SCOPED()
+
+	const Uint32 count = m_bodies.size();
+	if (jobs && count >= PARALLEL_MIN_BODIES)
+		jobs->ParallelFor(count, PARALLEL_BATCH, [this](Uint32 begin, Uint32 end) { IntegrateRange(begin, end); });
+	else
+		IntegrateRange(0, count);
+}
+
+void BodyIntegrator::Finish()
+{
+	PROFILE_SCOPED()
+
+	for (Uint32 i = 0; i < m_bodies.size(); i++)
+		m_bodies[i]->FinishIntegration(*this, i);
+}
@@ -0,0 +1,50 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _BODYINTEGRATOR_H
+#define _BODYINTEGRATOR_H
+
+#include "libs.h"
+#include "vector3.h"
+#include <vector>
+
+class DynamicBody;
+class JobQueue;
+
+/*
+ * Structure of arrays copy of the moving dynamic bodies for one physics
+ * step. DynamicBody::TimeStepUpdate adds the body along with the forces
+ * gathered for the step, Integrate steps them all in a few flat loops (the
+ * compiler vectorises those; big sets are also split over the job runners)
+ * and Finish hands each body its new state.
+ */
+class BodyIntegrator {
+public:
+	void Begin();
+	void Add(DynamicBody *body, double timeStep, const vector3d &pos, const vector3d &vel, const vector3d &angVel,
+		const vector3d &force, const vector3d &torque, double mass, double angInertia);
+	void Integrate(JobQueue *jobs);
+	// calls DynamicBody::FinishIntegration for every body added since Begin
+	void Finish();
+
+	double GetTimeStep(Uint32 i) const { return m_timeStep[i]; }
+	vector3d GetPosition(Uint32 i) const { return vector3d(m_pos[0][i], m_pos[1][i], m_pos[2][i]); }
+	vector3d GetVelocity(Uint32 i) const { return vector3d(m_vel[0][i], m_vel[1][i], m_vel[2][i]); }
+	vector3d GetAngVelocity(Uint32 i) const { return vector3d(m_angVel[0][i], m_angVel[1][i], m_angVel[2][i]); }
+
+private:
+	void IntegrateRange(Uint32 begin, Uint32 end);
+
+	std::vector<DynamicBody*> m_bodies;
+	std::vector<double> m_timeStep; // not the same for all, with the simulation LOD
+	// one array per axis
+	std::vector<double> m_pos[3];
+	std::vector<double> m_vel[3];
+	std::vector<double> m_angVel[3];
+	std::vector<double> m_force[3];
+	std::vector<double> m_torque[3];
+	std::vector<double> m_invMass;
+	std::vector<double> m_invAngInertia;
+};
+
+#endif
@@ -3,10 +3,12 @@
 
 #include "CRC32.h"
 
-const Uint32 CRC32::s_polynomial = 0x04c11db7;
+#if defined(__ARM_FEATURE_CRC32)
+#define CRC32_ARM 1
+#include <arm_acle.h>
+#endif
 
-bool CRC32::s_lookupTableGenerated;
-Uint32 CRC32::s_lookupTable[256];
+static const Uint32 s_polynomial = 0x04c11db7;
 
 static Uint32 crc32_reflect(Uint32 v, const int bits)
 {
@@ -19,23 +21,57 @@ static Uint32 crc32_reflect(Uint32 v, const int bits)
 	return r;
 }
 
-CRC32::CRC32() : m_checksum(0xffffffff)
-{
-	if (! s_lookupTableGenerated) {
+// slice-by-8: table[0] is the usual one byte table, table[k] is a byte
+// followed by k zero bytes, so eight bytes can be folded in at once.
+// built during static initialisation so there's no first-use race
+static struct LookupTables {
+	Uint32 table[8][256];
+
+	LookupTables() {
 		for (int i = 0; i <= 0xff; i++) {
-			s_lookupTable[i] = crc32_reflect(i,8) << 24;
+			Uint32 v = crc32_reflect(i,8) << 24;
 			for (int j = 0; j < 8; j++)
-				s_lookupTable[i] = (s_lookupTable[i] << 1) ^ (s_lookupTable[i] & (1 << 31) ? s_polynomial : 0);
-			s_lookupTable[i] = crc32_reflect(s_lookupTable[i], 32);
+				v = (v << 1) ^ (v & (1 << 31) ? s_polynomial : 0);
+			table[0][i] = crc32_reflect(v, 32);
 		}
-
-		s_lookupTableGenerated = true;
+		for (int i = 0; i <= 0xff; i++)
+			for (int k = 1; k < 8; k++)
+				table[k][i] = (table[k-1][i] >> 8) ^ table[0][table[k-1][i] & 0xff];
 	}
+} s_tables;
+
+static inline Uint32 ReadLE32(const unsigned char *p)
+{
+	return Uint32(p[0]) | (Uint32(p[1]) << 8) | (Uint32(p[2]) << 16) | (Uint32(p[3]) << 24);
+}
+
+CRC32::CRC32() : m_checksum(0xffffffff)
+{
 }
 
 void CRC32::AddData(const char *data, int length)
 {
 	const unsigned char *buf = reinterpret_cast<const unsigned char *>(data);
+	Uint32 crc = m_checksum;
+
+#ifdef CRC32_ARM
+	// the ARMv8 crc32 instructions use the same polynomial and bit order
+	for (; length >= 8; length -= 8, buf += 8) {
+		crc = __crc32d(crc, Uint64(ReadLE32(buf)) | (Uint64(ReadLE32(buf + 4)) << 32));
+	}
 	while (length--)
-		m_checksum = (m_checksum >> 8) ^ s_lookupTable[(m_checksum & 0xff) ^ *buf++];
+		crc = __crc32b(crc, *buf++);
+#else
+	const Uint32 (*t)[256] = s_tables.table;
+	for (; length >= 8; length -= 8, buf += 8) {
+		const Uint32 lo = ReadLE32(buf) ^ crc;
+		const Uint32 hi = ReadLE32(buf + 4);
+		crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+			t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+	}
+	while (length--)
+		crc = (crc >> 8) ^ t[0][(crc & 0xff) ^ *buf++];
+#endif
+
+	m_checksum = crc;
 }
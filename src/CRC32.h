@@ -16,10 +16,6 @@ public:
 
 private:
 	Uint32 m_checksum;
-
-	static const Uint32 s_polynomial;
-	static bool s_lookupTableGenerated;
-	static Uint32 s_lookupTable[256];
 };
 
 #endif
@@ -9,14 +9,18 @@
 #include "Pi.h"
 #include "Sfx.h"
 #include "Game.h"
+#include "ModelBatcher.h"
+#include "ProjectileSystem.h"
 #include "Planet.h"
 #include "graphics/Graphics.h"
 #include "graphics/Renderer.h"
+#include "graphics/SpriteBatch.h"
 #include "graphics/VertexArray.h"
 #include "graphics/Material.h"
 #include "graphics/TextureBuilder.h"
 
 #include <SDL_stdinc.h>
+#include <cstring>
 
 using namespace Graphics;
 
@@ -26,6 +30,15 @@ static const float OBJECT_HIDDEN_PIXEL_THRESHOLD = 2.0f;
 // if a terrain object would render smaller than this many pixels, draw a billboard instead
 static const float BILLBOARD_PIXEL_THRESHOLD = 8.0f;
 
+// bodies handed to each job runner at a time in Update and Draw. the
+// shadow pass checks every other planet and star per body, so it's finer
+static const Uint32 EVALUATE_BATCH = 32;
+static const Uint32 SHADOW_BATCH = 4;
+
+// the camera has to be well outside a body's box to test it, or the near
+// plane cuts into the box and it seems hidden. in clip radii
+static const double OCCLUSION_MIN_DIST = 2.0;
+
 CameraContext::CameraContext(float width, float height, float fovAng, float zNear, float zFar) :
 	m_width(width),
 	m_height(height),
@@ -82,13 +95,61 @@ void CameraContext::ApplyDrawTransforms(Graphics::Renderer *r)
 
 Camera::Camera(RefCountedPtr<CameraContext> context, Graphics::Renderer *renderer) :
 	m_context(context),
-	m_renderer(renderer)
+	m_renderer(renderer),
+	m_batching(false),
+	m_occlusionState(nullptr),
+	m_occlusionCulling(Pi::config->Int("BodyOcclusionCulling") != 0)
 {
 	Graphics::MaterialDescriptor desc;
 	desc.textures = 1;
+	desc.vertexColors = true;
 
 	m_billboardMaterial.reset(m_renderer->CreateMaterial(desc));
 	m_billboardMaterial->texture0 = Graphics::TextureBuilder::Billboard("textures/planet_billboard.png").GetOrCreateTexture(m_renderer, "billboard");
+	m_billboards.reset(new Graphics::VertexArray(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0));
+
+	if (Pi::config->Int("ModelBatching"))
+		m_modelBatcher.reset(new ModelBatcher(m_renderer));
+
+	if (m_occlusionCulling) {
+		// a cube around the clip sphere, drawn as black over what's there
+		// and leaving the depth alone
+		static const float c[8][3] = {
+			{ -1.f, -1.f, -1.f }, { 1.f, -1.f, -1.f }, { 1.f, 1.f, -1.f }, { -1.f, 1.f, -1.f },
+			{ -1.f, -1.f,  1.f }, { 1.f, -1.f,  1.f }, { 1.f, 1.f,  1.f }, { -1.f, 1.f,  1.f }
+		};
+		static const Uint8 tris[36] = {
+			0, 2, 1, 0, 3, 2,  4, 5, 6, 4, 6, 7,  0, 1, 5, 0, 5, 4,
+			3, 6, 2, 3, 7, 6,  0, 4, 7, 0, 7, 3,  1, 2, 6, 1, 6, 5
+		};
+		VertexArray box(ATTRIB_POSITION, 36);
+		for (Uint8 i : tris)
+			box.Add(vector3f(c[i][0], c[i][1], c[i][2]));
+
+		VertexBufferDesc vbd;
+		vbd.attrib[0].semantic = ATTRIB_POSITION;
+		vbd.attrib[0].format = ATTRIB_FORMAT_FLOAT3;
+		vbd.numVertices = box.GetNumVerts();
+		vbd.usage = BUFFER_USAGE_STATIC;
+		m_occlusionBox.reset(m_renderer->CreateVertexBuffer(vbd));
+		m_occlusionBox->Populate(box);
+
+		m_occlusionMaterial.reset(m_renderer->CreateMaterial(MaterialDescriptor()));
+		m_occlusionMaterial->diffuse = Color::BLACK;
+
+		RenderStateDesc rsd;
+		rsd.blendMode = BLEND_ADDITIVE;
+		rsd.cullMode = CULL_NONE;
+		rsd.depthWrite = false;
+		m_occlusionState = m_renderer->CreateRenderState(rsd);
+	}
+}
+
+Camera::~Camera()
+{
+	for (auto &it : m_occlusion)
+		if (it.second.query)
+			m_renderer->DeleteOcclusionQuery(it.second.query);
 }
 
 static void position_system_lights(Frame *camFrame, Frame *frame, std::vector<Camera::LightSource> &lights)
@@ -115,61 +176,144 @@ static void position_system_lights(Frame *camFrame, Frame *frame, std::vector<Ca
 	}
 }
 
-void Camera::Update()
+bool Camera::EvaluateBody(Body *b, const Frame *camFrame, BodyAttrs &attrs) const
 {
-	Frame *camFrame = m_context->GetCamFrame();
-
-	// evaluate each body and determine if/where/how to draw it
-	m_sortedBodies.clear();
-	for (Body* b : Pi::game->GetSpace()->GetBodies()) {
-		BodyAttrs attrs;
-		attrs.body = b;
+	attrs.body = b;
+
+	// determine position and transform for draw
+	Frame::GetFrameTransform(b->GetFrame(), camFrame, attrs.viewTransform);
+	attrs.viewCoords = attrs.viewTransform * b->GetInterpPosition();
+
+	// cull off-screen objects
+	double rad = b->GetClipRadius();
+	if (!m_context->GetFrustum().TestPointInfinite(attrs.viewCoords, rad))
+		return false;
+
+	attrs.camDist = attrs.viewCoords.Length();
+	attrs.bodyFlags = b->GetFlags();
+
+	// approximate pixel width (disc diameter) of body on screen
+	const float pixSize = Graphics::GetScreenHeight() * 2.0 * rad / (attrs.camDist * Graphics::GetFovFactor());
+	if (pixSize < OBJECT_HIDDEN_PIXEL_THRESHOLD)
+		return false;
+
+	// terrain objects are visible from distance but might not have any discernable features
+	attrs.billboard = false;
+	if (b->IsType(Object::TERRAINBODY)) {
+		if (pixSize < BILLBOARD_PIXEL_THRESHOLD) {
+			attrs.billboard = true;
+			vector3d pos;
+			double size = rad * 2.0 * m_context->GetFrustum().TranslatePoint(attrs.viewCoords, pos);
+			attrs.billboardPos = vector3f(pos);
+			attrs.billboardSize = float(size);
+			if (b->IsType(Object::STAR)) {
+				attrs.billboardColor = StarSystem::starRealColors[b->GetSystemBody()->GetType()];
+			}
+			else if (b->IsType(Object::PLANET)) {
+				// XXX this should incorporate some lighting effect
+				// (ie, colour of the illuminating star(s))
+				attrs.billboardColor = b->GetSystemBody()->GetAlbedo();
+				attrs.billboardColor.a = 255; // no alpha, these things are hard enough to see as it is
+			}
+			else
+				attrs.billboardColor = Color::WHITE;
+		}
+	}
 
-		// determine position and transform for draw
-		Frame::GetFrameTransform(b->GetFrame(), camFrame, attrs.viewTransform);
-		attrs.viewCoords = attrs.viewTransform * b->GetInterpPosition();
+	return true;
+}
 
-		// cull off-screen objects
-		double rad = b->GetClipRadius();
-		if (!m_context->GetFrustum().TestPointInfinite(attrs.viewCoords, rad))
+// stable LSD radix sort on the keys, a byte at a time. bytes that are the
+// same in every key, which for distances is most of the high ones, are skipped
+template <typename T>
+static void radix_sort(std::vector<T> &entries, std::vector<T> &scratch)
+{
+	if (entries.size() < 2)
+		return;
+	scratch.resize(entries.size());
+	for (int shift = 0; shift < 64; shift += 8) {
+		Uint32 counts[256] = {};
+		for (const T &e : entries)
+			counts[(e.key >> shift) & 0xff]++;
+		if (counts[(entries[0].key >> shift) & 0xff] == entries.size())
 			continue;
+		Uint32 offset = 0;
+		for (Uint32 &c : counts) {
+			const Uint32 n = c;
+			c = offset;
+			offset += n;
+		}
+		for (const T &e : entries)
+			scratch[counts[(e.key >> shift) & 0xff]++] = e;
+		entries.swap(scratch);
+	}
+}
 
-		attrs.camDist = attrs.viewCoords.Length();
-		attrs.bodyFlags = b->GetFlags();
+// the bits of a non-negative double sort as integers the same as the
+// values, so far to near is the largest subtracted from
+static Uint64 depth_sort_key(double camDist, bool drawLast)
+{
+	Uint64 bits;
+	memcpy(&bits, &camDist, sizeof(bits));
+	return (Uint64(drawLast) << 63) | (0x7fffffffffffffffULL - (bits & 0x7fffffffffffffffULL));
+}
 
-		// approximate pixel width (disc diameter) of body on screen
-		const float pixSize = Graphics::GetScreenHeight() * 2.0 * rad / (attrs.camDist * Graphics::GetFovFactor());
-		if (pixSize < OBJECT_HIDDEN_PIXEL_THRESHOLD)
-			continue;
+void Camera::Update()
+{
+	PROFILE_SCOPED()
+	Frame *camFrame = m_context->GetCamFrame();
 
-		// terrain objects are visible from distance but might not have any discernable features
-		attrs.billboard = false;
-		if (b->IsType(Object::TERRAINBODY)) {
-			if (pixSize < BILLBOARD_PIXEL_THRESHOLD) {
-				attrs.billboard = true;
-				vector3d pos;
-				double size = rad * 2.0 * m_context->GetFrustum().TranslatePoint(attrs.viewCoords, pos);
-				attrs.billboardPos = vector3f(pos);
-				attrs.billboardSize = float(size);
-				if (b->IsType(Object::STAR)) {
-					attrs.billboardColor = StarSystem::starRealColors[b->GetSystemBody()->GetType()];
-				}
-				else if (b->IsType(Object::PLANET)) {
-					// XXX this should incorporate some lighting effect
-					// (ie, colour of the illuminating star(s))
-					attrs.billboardColor = b->GetSystemBody()->GetAlbedo();
-					attrs.billboardColor.a = 255; // no alpha, these things are hard enough to see as it is
-				}
-				else
-					attrs.billboardColor = Color::WHITE;
-			}
+	// evaluate each body and determine if/where/how to draw it. each body
+	// only touches its own slot, so this is split over the job runners
+	m_bodies.clear();
+	for (Body* b : Pi::game->GetSpace()->GetBodies())
+		m_bodies.push_back(b);
+	m_bodyAttrs.resize(m_bodies.size());
+	m_bodyVisible.assign(m_bodies.size(), 0);
+	Pi::GetAsyncJobQueue()->ParallelFor(m_bodies.size(), EVALUATE_BATCH, [&](Uint32 begin, Uint32 end) {
+		for (Uint32 i = begin; i < end; i++) {
+			BodyAttrs &attrs = m_bodyAttrs[i];
+			m_bodyVisible[i] = EvaluateBody(m_bodies[i], camFrame, attrs);
+			if (m_bodyVisible[i])
+				attrs.sortKey = depth_sort_key(attrs.camDist, attrs.bodyFlags & Body::FLAG_DRAW_LAST);
 		}
+	});
 
-		m_sortedBodies.push_back(attrs);
+	m_sortedBodies.clear();
+	for (size_t i = 0; i < m_bodies.size(); i++) {
+		if (m_bodyVisible[i]) {
+			const SortEntry e = { m_bodyAttrs[i].sortKey, &m_bodyAttrs[i] };
+			m_sortedBodies.push_back(e);
+		}
 	}
 
 	// depth sort
-	m_sortedBodies.sort();
+	radix_sort(m_sortedBodies, m_sortScratch);
+}
+
+void Camera::CacheShadowedIntensities()
+{
+	PROFILE_SCOPED()
+	const Uint32 numLights = std::min<Uint32>(m_lightSources.size(), MAX_CACHED_LIGHTS);
+
+	// the slots are made up front so the runners only ever write to them
+	typedef std::pair<const Body*, ShadowedIntensities*> WorkItem;
+	std::vector<WorkItem, ArenaAllocator<WorkItem>> work(FrameArena::Allocator<WorkItem>());
+	work.reserve(m_sortedBodies.size());
+	for (const SortEntry &e : m_sortedBodies) {
+		if (e.attrs->billboard || !e.attrs->body->IsType(Object::MODELBODY))
+			continue;
+		work.push_back(std::make_pair(e.attrs->body, &m_shadowCache[e.attrs->body]));
+	}
+
+	Pi::GetAsyncJobQueue()->ParallelFor(work.size(), SHADOW_BATCH, [&](Uint32 begin, Uint32 end) {
+		// runners can't share the frame arena, so each batch brings its own
+		ScratchArena<1024> arena;
+		ShadowList scratch((ArenaAllocator<Shadow>(&arena)));
+		for (Uint32 i = begin; i < end; i++)
+			for (Uint32 l = 0; l < numLights; l++)
+				work[i].second->intensity[l] = CalcShadowedIntensity(l, work[i].first, scratch);
+	});
 }
 
 void Camera::Draw(const Body *excludeBody, ShipCockpit* cockpit)
@@ -187,6 +331,7 @@ void Camera::Draw(const Body *excludeBody, ShipCockpit* cockpit)
 	// Pick up to four suitable system light sources (stars)
 	m_lightSources.clear();
 	m_lightSources.reserve(4);
+	m_shadowCache.clear();
 	position_system_lights(camFrame, Pi::game->GetSpace()->GetRootFrame(), m_lightSources);
 
 	if (m_lightSources.empty()) {
@@ -194,6 +339,7 @@ void Camera::Draw(const Body *excludeBody, ShipCockpit* cockpit)
 		const Color col(255);
 		m_lightSources.push_back(LightSource(0, Graphics::Light(Graphics::Light::LIGHT_DIRECTIONAL, vector3f(0.f), col, col)));
 	}
+	GatherOccluders();
 
 	//fade space background based on atmosphere thickness and light angle
 	float bgIntensity = 1.f;
@@ -226,34 +372,51 @@ void Camera::Draw(const Body *excludeBody, ShipCockpit* cockpit)
 		}
 	}
 
-	Pi::game->GetSpace()->GetBackground()->SetIntensity(bgIntensity);
-	Pi::game->GetSpace()->GetBackground()->Draw(trans2bg);
+	{
+		Graphics::Renderer::GpuTimerTicket gt(m_renderer, Graphics::Stats::GPU_TIMER_BACKGROUND);
+		Pi::game->GetSpace()->GetBackground()->SetIntensity(bgIntensity);
+		Pi::game->GetSpace()->GetBackground()->Draw(trans2bg);
+	}
 
 	{
-		std::vector<Graphics::Light> rendererLights;
+		std::vector<Graphics::Light, ArenaAllocator<Graphics::Light>> rendererLights(FrameArena::Allocator<Graphics::Light>());
 		rendererLights.reserve(m_lightSources.size());
 		for (size_t i = 0; i < m_lightSources.size(); i++)
 			rendererLights.push_back(m_lightSources[i].GetLight());
 		m_renderer->SetLights(rendererLights.size(), &rendererLights[0]);
 	}
 
-	for (std::list<BodyAttrs>::iterator i = m_sortedBodies.begin(); i != m_sortedBodies.end(); ++i) {
-		BodyAttrs *attrs = &(*i);
+	CacheShadowedIntensities();
+
+	// thrusters and navlights of every body go in one draw per texture at
+	// the end. they're additive, so the order doesn't matter
+	Graphics::SpriteBatch &sprites = m_renderer->GetSpriteBatch();
+	sprites.Begin();
+	m_batching = true;
+	for (const SortEntry &e : m_sortedBodies) {
+		const BodyAttrs *attrs = e.attrs;
 
 		// explicitly exclude a single body if specified (eg player)
 		if (attrs->body == excludeBody)
 			continue;
 
 		// draw something!
-		if (attrs->billboard) {
-			Graphics::Renderer::MatrixTicket mt(m_renderer, Graphics::MatrixMode::MODELVIEW);
-			m_renderer->SetTransform(matrix4x4d::Identity());
-			m_billboardMaterial->diffuse = attrs->billboardColor;
-			m_renderer->DrawPointSprites(1, &attrs->billboardPos, Sfx::additiveAlphaState, m_billboardMaterial.get(), attrs->billboardSize);
-		}
-		else
+		if (attrs->billboard)
+			AddBillboard(attrs->billboardPos, attrs->billboardSize, attrs->billboardColor);
+		else if (!IsOccluded(*attrs)) {
+			FlushBillboards();
 			attrs->body->Render(m_renderer, this, attrs->viewCoords, attrs->viewTransform);
+		}
 	}
+	FlushBillboards();
+	m_batching = false;
+	if (m_modelBatcher)
+		m_modelBatcher->Flush();
+	sprites.End();
+
+	IssueOcclusionQueries(excludeBody);
+
+	Pi::game->GetSpace()->GetProjectiles()->Render(m_renderer, camFrame);
 
 	Sfx::RenderAll(m_renderer, Pi::game->GetSpace()->GetRootFrame(), camFrame);
 
@@ -263,34 +426,156 @@ void Camera::Draw(const Body *excludeBody, ShipCockpit* cockpit)
 	// Render cockpit
 	// XXX only here because it needs a frame for lighting calc
 	// should really be in WorldView, immediately after camera draw
-	if(cockpit)
+	if(cockpit) {
+		Graphics::Renderer::GpuTimerTicket gt(m_renderer, Graphics::Stats::GPU_TIMER_COCKPIT);
 		cockpit->RenderCockpit(m_renderer, this, camFrame);
+	}
 }
 
-void Camera::CalcShadows(const int lightNum, const Body *b, std::vector<Shadow> &shadowsOut) const {
+void Camera::AddBillboard(const vector3f &pos, float size, const Color &color)
+{
+	// in view space, so facing the camera is just lining up with the axes
+	const float sz = 0.5f * size;
+	const vector3f tl = pos + vector3f(-sz,  sz, 0.f);
+	const vector3f bl = pos + vector3f(-sz, -sz, 0.f);
+	const vector3f tr = pos + vector3f( sz,  sz, 0.f);
+	const vector3f br = pos + vector3f( sz, -sz, 0.f);
+	m_billboards->Add(tl, color, vector2f(0.f, 0.f));
+	m_billboards->Add(bl, color, vector2f(0.f, 1.f));
+	m_billboards->Add(tr, color, vector2f(1.f, 0.f));
+	m_billboards->Add(tr, color, vector2f(1.f, 0.f));
+	m_billboards->Add(bl, color, vector2f(0.f, 1.f));
+	m_billboards->Add(br, color, vector2f(1.f, 1.f));
+}
+
+void Camera::FlushBillboards()
+{
+	if (m_billboards->GetNumVerts() == 0)
+		return;
+	Graphics::Renderer::MatrixTicket mt(m_renderer, Graphics::MatrixMode::MODELVIEW);
+	m_renderer->SetTransform(matrix4x4d::Identity());
+	m_renderer->DrawTriangles(m_billboards.get(), Sfx::additiveAlphaState, m_billboardMaterial.get());
+	m_renderer->GetStats().AddToStatCount(Graphics::Stats::STAT_DRAWPOINTSPRITES, m_billboards->GetNumVerts() / 6);
+	m_billboards->Clear();
+}
+
+bool Camera::IsOcclusionCandidate(const BodyAttrs &attrs) const
+{
+	return !attrs.billboard && attrs.body->IsType(Object::MODELBODY) &&
+		attrs.camDist > attrs.body->GetClipRadius() * OCCLUSION_MIN_DIST;
+}
+
+bool Camera::IsOccluded(const BodyAttrs &attrs)
+{
+	if (!m_occlusionCulling || !IsOcclusionCandidate(attrs))
+		return false;
+	auto it = m_occlusion.find(attrs.body);
+	if (it == m_occlusion.end())
+		return false;
+	OcclusionState &state = it->second;
+	Uint32 samples;
+	if (state.pending && m_renderer->GetOcclusionQueryResult(state.query, samples)) {
+		state.pending = false;
+		state.hidden = (samples == 0);
+	}
+	return state.hidden;
+}
+
+void Camera::IssueOcclusionQueries(const Body *excludeBody)
+{
+	PROFILE_SCOPED()
+	if (!m_occlusionCulling)
+		return;
+
+	for (auto &it : m_occlusion)
+		it.second.inView = false;
+
+	for (const SortEntry &e : m_sortedBodies) {
+		const BodyAttrs &attrs = *e.attrs;
+		if (attrs.body == excludeBody || !IsOcclusionCandidate(attrs))
+			continue;
+		auto it = m_occlusion.find(attrs.body);
+		if (it == m_occlusion.end()) {
+			const OcclusionState state = { m_renderer->CreateOcclusionQuery(), false, false, false };
+			it = m_occlusion.insert(std::make_pair(attrs.body, state)).first;
+		}
+		OcclusionState &state = it->second;
+		state.inView = true;
+		// the renderer can't, or the last one hasn't come back yet
+		if (!state.query || state.pending)
+			continue;
+
+		const double rad = attrs.body->GetClipRadius();
+		m_renderer->SetTransform(matrix4x4d::Translation(attrs.viewCoords) * matrix4x4d::ScaleMatrix(rad));
+		m_renderer->BeginOcclusionQuery(state.query);
+		m_renderer->DrawBuffer(m_occlusionBox.get(), m_occlusionState, m_occlusionMaterial.get());
+		m_renderer->EndOcclusionQuery();
+		state.pending = true;
+	}
+
+	// bodies out of view, or gone, start again as visible
+	for (auto it = m_occlusion.begin(); it != m_occlusion.end();) {
+		if (it->second.inView) {
+			++it;
+			continue;
+		}
+		if (it->second.query)
+			m_renderer->DeleteOcclusionQuery(it->second.query);
+		it = m_occlusion.erase(it);
+	}
+}
+
+void Camera::GatherOccluders()
+{
+	PROFILE_SCOPED()
+	const Frame *root = Pi::game->GetSpace()->GetRootFrame();
+
+	m_lightPositions.clear();
+	for (const LightSource &light : m_lightSources)
+		m_lightPositions.push_back(light.GetBody() ? light.GetBody()->GetPositionRelTo(root) : vector3d(0.0));
+
+	m_occluders.clear();
+	for (const Body *b : Pi::game->GetSpace()->GetBodies()) {
+		if (!(b->IsType(Object::PLANET) || b->IsType(Object::STAR)))
+			continue;
+		const Occluder o = { b, b->GetPositionRelTo(root), b->GetSystemBody()->GetRadius() };
+		m_occluders.push_back(o);
+	}
+}
+
+void Camera::CalcShadows(const int lightNum, const Body *b, ShadowList &shadowsOut) const {
 	// Set up data for eclipses. All bodies are assumed to be spheres.
 	const Body *lightBody = m_lightSources[lightNum].GetBody();
 	if (!lightBody)
 		return;
 
+	// the occluders and lights are in root frame coordinates. only the
+	// shadow centres, which the terrain shader wants, need to be turned to
+	// the orientation of b's frame
+	const Frame *root = Pi::game->GetSpace()->GetRootFrame();
+	const vector3d bPos = b->GetPositionRelTo(root);
+
 	const double lightRadius = lightBody->GetPhysRadius();
-	const vector3d bLightPos = lightBody->GetPositionRelTo(b);
-	const vector3d lightDir = bLightPos.Normalized();
+	const vector3d bLightPos = m_lightPositions[lightNum] - bPos;
+	const double bLightDist = bLightPos.Length();
+	const vector3d lightDir = bLightPos / bLightDist;
 
 	double bRadius;
 	if (b->IsType(Object::TERRAINBODY)) bRadius = b->GetSystemBody()->GetRadius();
 	else bRadius = b->GetPhysRadius();
 
+	bool haveOrient = false;
+	matrix3x3d toB;
+
 	// Look for eclipsing third bodies:
-	for (const Body *b2 : Pi::game->GetSpace()->GetBodies()) {
-		if ( b2 == b || b2 == lightBody || !(b2->IsType(Object::PLANET) || b2->IsType(Object::STAR)))
+	for (const Occluder &o : m_occluders) {
+		if (o.body == b || o.body == lightBody)
 			continue;
 
-		double b2Radius = b2->GetSystemBody()->GetRadius();
-		vector3d b2pos = b2->GetPositionRelTo(b);
+		const vector3d b2pos = o.pos - bPos;
 		const double perpDist = lightDir.Dot(b2pos);
 
-		if ( perpDist <= 0 || perpDist > bLightPos.Length())
+		if ( perpDist <= 0 || perpDist > bLightDist)
 			// b2 isn't between b and lightBody; no eclipse
 			continue;
 
@@ -303,8 +588,8 @@ void Camera::CalcShadows(const int lightNum, const Body *b, std::vector<Shadow>
 		// normalised projected position p, the picture is of a disc of radius lrad being occulted by a
 		// disc of radius srad centred at projectedCentre-p. To determine the light intensity at p, we
 		// then just need to estimate the proportion of the light disc being occulted.
-		const double srad = b2Radius / bRadius;
-		const double lrad = (lightRadius/bLightPos.Length())*perpDist / bRadius;
+		const double srad = o.radius / bRadius;
+		const double lrad = (lightRadius/bLightDist)*perpDist / bRadius;
 		if (srad / lrad < 0.01) {
 			// any eclipse would have negligible effect - ignore
 			continue;
@@ -312,7 +597,11 @@ void Camera::CalcShadows(const int lightNum, const Body *b, std::vector<Shadow>
 		const vector3d projectedCentre = ( b2pos - perpDist*lightDir ) / bRadius;
 		if (projectedCentre.Length() < 1 + srad + lrad) {
 			// some part of b is (partially) eclipsed
-			Camera::Shadow shadow = { lightNum, projectedCentre, static_cast<float>(srad), static_cast<float>(lrad) };
+			if (!haveOrient) {
+				toB = root->GetOrientRelTo(b->GetFrame());
+				haveOrient = true;
+			}
+			Camera::Shadow shadow = { lightNum, toB * projectedCentre, static_cast<float>(srad), static_cast<float>(lrad) };
 			shadowsOut.push_back(shadow);
 		}
 	}
@@ -342,28 +631,35 @@ float discCovered(const float dist, const float rad) {
 	return Clamp((th + radsq*th2 - dist*d)/float(M_PI), 0.f, 1.f);
 }
 
-static std::vector<Camera::Shadow> shadows;
-
-float Camera::ShadowedIntensity(const int lightNum, const Body *b) const {
-	shadows.clear();
-	shadows.reserve(16);
-	CalcShadows(lightNum, b, shadows);
+float Camera::CalcShadowedIntensity(const int lightNum, const Body *b, ShadowList &scratch) const {
+	scratch.clear();
+	scratch.reserve(16);
+	CalcShadows(lightNum, b, scratch);
 	float product = 1.0;
-	for (std::vector<Camera::Shadow>::const_iterator it = shadows.begin(), itEnd = shadows.end(); it!=itEnd; ++it)
+	for (ShadowList::const_iterator it = scratch.begin(), itEnd = scratch.end(); it!=itEnd; ++it)
 		product *= 1.0 - discCovered(it->centre.Length() / it->lrad, it->srad / it->lrad);
 	return product;
 }
 
+float Camera::ShadowedIntensity(const int lightNum, const Body *b) const {
+	if (lightNum < MAX_CACHED_LIGHTS) {
+		auto it = m_shadowCache.find(b);
+		if (it != m_shadowCache.end())
+			return it->second.intensity[lightNum];
+	}
+	return CalcShadowedIntensity(lightNum, b, m_shadowScratch);
+}
+
 // PrincipalShadows(b,n): returns the n biggest shadows on b in order of size
 void Camera::PrincipalShadows(const Body *b, const int n, std::vector<Shadow> &shadowsOut) const {
+	ShadowList &shadows = m_shadowScratch;
 	shadows.clear();
-	shadows.reserve(16);
 	for (size_t i = 0; i < 4 && i < m_lightSources.size(); i++) {
 		CalcShadows(i, b, shadows);
 	}
 	shadowsOut.reserve(shadows.size());
 	std::sort(shadows.begin(), shadows.end());
-	std::vector<Shadow>::reverse_iterator it = shadows.rbegin(), itREnd = shadows.rend();
+	ShadowList::reverse_iterator it = shadows.rbegin(), itREnd = shadows.rend();
 	for (int i = 0; i < n; i++) {
 		if (it == itREnd) break;
 		shadowsOut.push_back(*(it++));
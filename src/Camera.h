@@ -11,10 +11,13 @@
 #include "matrix4x4.h"
 #include "Background.h"
 #include "Body.h"
+#include "LinearArena.h"
+#include <unordered_map>
 
 class Frame;
 class ShipCockpit;
-namespace Graphics { class Renderer; }
+class ModelBatcher;
+namespace Graphics { class Renderer; class RenderState; class VertexArray; class VertexBuffer; }
 
 class CameraContext : public RefCounted {
 public:
@@ -66,10 +69,10 @@ private:
 	Frame *m_camFrame;
 };
 
-
 class Camera {
 public:
 	Camera(RefCountedPtr<CameraContext> context, Graphics::Renderer *renderer);
+	~Camera();
 
 	const CameraContext *GetContext() const { return m_context.Get(); }
 
@@ -97,8 +100,10 @@ public:
 
 		bool operator< (const Shadow& other) const { return srad/lrad < other.srad/other.lrad; }
 	};
+	typedef std::vector<Shadow, ArenaAllocator<Shadow>> ShadowList;
 
-	void CalcShadows(const int lightNum, const Body *b, std::vector<Shadow> &shadowsOut) const;
+	void CalcShadows(const int lightNum, const Body *b, ShadowList &shadowsOut) const;
+	// uses the values worked out at the start of Draw() for bodies in view
 	float ShadowedIntensity(const int lightNum, const Body *b) const;
 	void PrincipalShadows(const Body *b, const int n, std::vector<Shadow> &shadowsOut) const;
 
@@ -106,11 +111,22 @@ public:
 	const std::vector<LightSource> &GetLightSources() const { return m_lightSources; }
 	const int GetNumLightSources() const { return m_lightSources.size(); }
 
+	// only while Draw() is drawing bodies, 0 otherwise
+	ModelBatcher *GetModelBatcher() const { return m_batching ? m_modelBatcher.get() : nullptr; }
+
 private:
 	RefCountedPtr<CameraContext> m_context;
 	Graphics::Renderer *m_renderer;
 
 	std::unique_ptr<Graphics::Material> m_billboardMaterial;
+	// billboards of distant bodies, drawn together before the next body
+	// that isn't one, so the back to front order holds
+	std::unique_ptr<Graphics::VertexArray> m_billboards;
+	void AddBillboard(const vector3f &pos, float size, const Color &color);
+	void FlushBillboards();
+
+	std::unique_ptr<ModelBatcher> m_modelBatcher;
+	bool m_batching;
 
 	// temp attrs for sorting and drawing
 	struct BodyAttrs {
@@ -132,27 +148,73 @@ private:
 		float billboardSize;
 		Color billboardColor;
 
-		// for sorting. "should a be drawn before b?"
-		friend bool operator<(const BodyAttrs &a, const BodyAttrs &b) {
-			// both drawing last; distance order
-			if (a.bodyFlags & Body::FLAG_DRAW_LAST && b.bodyFlags & Body::FLAG_DRAW_LAST)
-				return a.camDist > b.camDist;
-
-			// a drawing last; draw b first
-			if (a.bodyFlags & Body::FLAG_DRAW_LAST)
-				return false;
-
-			// b drawing last; draw a first
-			if (b.bodyFlags & Body::FLAG_DRAW_LAST)
-				return true;
-
-			// both in normal draw; distance order
-			return a.camDist > b.camDist;
-		}
+		// draw order: DRAW_LAST bodies after the rest, each far to near
+		Uint64 sortKey;
 	};
 
-	std::list<BodyAttrs> m_sortedBodies;
+	// fills in attrs for b. returns false if b shouldn't be drawn at all.
+	// safe to call for several bodies at once
+	bool EvaluateBody(Body *b, const Frame *camFrame, BodyAttrs &attrs) const;
+
+	// model bodies are skipped while their bounding box is hidden. the
+	// boxes are tested at the end of each Draw, against everything drawn,
+	// and the results are used once the GPU has them, usually next frame
+	struct OcclusionState {
+		Uint32 query;
+		bool pending; // issued, result not read yet
+		bool hidden;
+		bool inView;
+	};
+	std::unordered_map<const Body*, OcclusionState> m_occlusion;
+	std::unique_ptr<Graphics::VertexBuffer> m_occlusionBox;
+	std::unique_ptr<Graphics::Material> m_occlusionMaterial;
+	Graphics::RenderState *m_occlusionState;
+	bool m_occlusionCulling;
+	bool IsOcclusionCandidate(const BodyAttrs &attrs) const;
+	bool IsOccluded(const BodyAttrs &attrs);
+	void IssueOcclusionQueries(const Body *excludeBody);
+
+	// eclipse calculation for one light, with a caller-supplied scratch
+	// list so that it can be done from the job runners
+	float CalcShadowedIntensity(const int lightNum, const Body *b, ShadowList &scratch) const;
+
+	// shadowing for each lit model body in view, worked out across the job
+	// runners before any body is drawn
+	enum { MAX_CACHED_LIGHTS = 4 };
+	struct ShadowedIntensities {
+		float intensity[MAX_CACHED_LIGHTS];
+	};
+	void CacheShadowedIntensities();
+
+	// the bodies that can cast shadows, planets and stars, and the lights,
+	// in root frame coordinates. gathered once at the start of Draw() so
+	// CalcShadows doesn't go through every body in space for every one drawn
+	struct Occluder {
+		const Body *body;
+		vector3d pos;
+		double radius;
+	};
+	void GatherOccluders();
+	std::vector<Occluder> m_occluders;
+	std::vector<vector3d> m_lightPositions;
+	// for ShadowedIntensity and PrincipalShadows, on the main thread
+	mutable ShadowList m_shadowScratch;
+
+	// the bodies in space and what EvaluateBody made of them, kept from
+	// frame to frame so they aren't reallocated
+	std::vector<Body*> m_bodies;
+	std::vector<BodyAttrs> m_bodyAttrs;
+	std::vector<Uint8> m_bodyVisible;
+
+	// the visible ones in draw order, pointing into m_bodyAttrs
+	struct SortEntry {
+		Uint64 key;
+		BodyAttrs *attrs;
+	};
+	std::vector<SortEntry> m_sortedBodies;
+	std::vector<SortEntry> m_sortScratch;
 	std::vector<LightSource> m_lightSources;
+	std::unordered_map<const Body*, ShadowedIntensities> m_shadowCache;
 };
 
 #endif
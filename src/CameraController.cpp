@@ -187,7 +187,7 @@ void InternalCameraController::SaveToJson(Json::Value &jsonObj)
 void InternalCameraController::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("internal")) throw SavedGameCorruptException();
-	Json::Value internalCameraObj = jsonObj["internal"];
+	const Json::Value &internalCameraObj = jsonObj["internal"];
 	if (!internalCameraObj.isMember("mode")) throw SavedGameCorruptException();
 
 	SetMode(static_cast<Mode>(internalCameraObj["mode"].asInt()));
@@ -290,7 +290,7 @@ void ExternalCameraController::SaveToJson(Json::Value &jsonObj)
 void ExternalCameraController::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("external")) throw SavedGameCorruptException();
-	Json::Value externalCameraObj = jsonObj["external"];
+	const Json::Value &externalCameraObj = jsonObj["external"];
 	if (!externalCameraObj.isMember("rot_x")) throw SavedGameCorruptException();
 	if (!externalCameraObj.isMember("rot_y")) throw SavedGameCorruptException();
 	if (!externalCameraObj.isMember("dist")) throw SavedGameCorruptException();
@@ -400,7 +400,7 @@ void SiderealCameraController::SaveToJson(Json::Value &jsonObj)
 void SiderealCameraController::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("sidereal")) throw SavedGameCorruptException();
-	Json::Value siderealCameraObj = jsonObj["sidereal"];
+	const Json::Value &siderealCameraObj = jsonObj["sidereal"];
 	if (!siderealCameraObj.isMember("dist")) throw SavedGameCorruptException();
 
 	JsonToMatrix(&m_sidOrient, siderealCameraObj, "sid_orient");
@@ -33,7 +33,7 @@ void CargoBody::LoadFromJson(const Json::Value &jsonObj, Space *space)
 	DynamicBody::LoadFromJson(jsonObj, space);
 
 	if (!jsonObj.isMember("cargo_body")) throw SavedGameCorruptException();
-	Json::Value cargoBodyObj = jsonObj["cargo_body"];
+	const Json::Value &cargoBodyObj = jsonObj["cargo_body"];
 
 	if (!cargoBodyObj.isMember("hit_points")) throw SavedGameCorruptException();
 	if (!cargoBodyObj.isMember("self_destruct_timer")) throw SavedGameCorruptException();
@@ -16,33 +16,68 @@
 #include "scenegraph/Model.h"
 #include "scenegraph/SceneGraph.h"
 #include "scenegraph/ModelSkin.h"
+#include "terrain/Terrain.h"
 #include <set>
+#include <algorithm>
 
 static const unsigned int DEFAULT_NUM_BUILDINGS = 1000;
 static const double  START_SEG_SIZE = CITY_ON_PLANET_RADIUS;
 static const double  START_SEG_SIZE_NO_ATMO = CITY_ON_PLANET_RADIUS / 5.0f;
 static const double MIN_SEG_SIZE = 50.0;
+// edge length of the culling grid cells
+static const double CELL_SIZE = 500.0;
+// buildings that would cover less than this many pixels aren't drawn at all
+static const float MIN_PIXEL_RADIUS = 1.0f;
+// layouts kept for stations that have been visited. a few systems' worth
+static const size_t MAX_CACHED_LAYOUTS = 16;
 
 using SceneGraph::Model;
 
 bool CityOnPlanet::s_cityBuildingsInitted = false;
+int CityOnPlanet::s_detailReduction = 0;
 
 CityOnPlanet::citybuildinglist_t CityOnPlanet::s_buildingList = {
 	"city_building", 800, 2000, 0, 0,
 };
 
-CityOnPlanet::cityflavourdef_t CityOnPlanet::cityflavour[CITYFLAVOURS];
+std::map<SystemPath, CityOnPlanet::CachedLayout> CityOnPlanet::s_layouts;
+
+// everything the layout needs, copied from the station and planet so the
+// job doesn't touch them
+struct CityOnPlanet::LayoutParams {
+	RefCountedPtr<Terrain> terrain;
+	double planetRadius;
+	Uint32 seed;
+	double seg;
+	vector3d pos;
+	matrix4x4d orient;
+	Aabb aabb;
+};
+
+class CityOnPlanet::LayoutJob : public Job {
+public:
+	LayoutJob(CityOnPlanet *city, const LayoutParams &params) : m_city(city), m_params(params), m_layout(new Layout) {}
+
+	virtual void OnRun() override { GenerateLayout(m_params, *m_layout); }
+	virtual void OnFinish() override { m_city->SetLayout(m_layout); }
+	virtual const char *GetName() const override { return "CityLayout"; }
+
+private:
+	CityOnPlanet *m_city;
+	const LayoutParams m_params;
+	RefCountedPtr<Layout> m_layout;
+};
 
-void CityOnPlanet::PutCityBit(Random &rand, const matrix4x4d &rot, vector3d p1, vector3d p2, vector3d p3, vector3d p4)
+void CityOnPlanet::PutCityBit(const LayoutParams &params, const cityflavourdef_t *cityflavour, Random &rand, Layout &layout,
+	vector3d p1, vector3d p2, vector3d p3, vector3d p4)
 {
 	double rad = (p1-p2).Length()*0.5;
 	Uint32 instIndex(0);
 	double modelRadXZ(0.0);
-	const CollMesh *cmesh(0);
 	vector3d cent = (p1+p2+p3+p4)*0.25;
 
-	cityflavourdef_t *flavour(0);
-	citybuildinglist_t *buildings(0);
+	const cityflavourdef_t *flavour(0);
+	const citybuildinglist_t *buildings(0);
 
 	// pick a building flavour (city, windfarm, etc)
 	for (unsigned int flv = 0; flv < CITYFLAVOURS; flv++) {
@@ -54,7 +89,6 @@ void CityOnPlanet::PutCityBit(Random &rand, const matrix4x4d &rot, vector3d p1,
 			const citybuilding_t &bt = buildings->buildings[rand.Int32(buildings->numBuildings)];
 			instIndex = bt.instIndex;
 			modelRadXZ = bt.xzradius;
-			cmesh = bt.collMesh.Get();
 			if (modelRadXZ < rad) break;
 			if (tries == 0) return;
 		}
@@ -76,27 +110,140 @@ always_divide:
 		vector3d c = (p3+p4)*0.5;
 		vector3d d = (p4+p1)*0.5;
 		vector3d e = (p1+p2+p3+p4)*0.25;
-		PutCityBit(rand, rot, p1, a, e, d);
-		PutCityBit(rand, rot, a, p2, b, e);
-		PutCityBit(rand, rot, e, b, p3, c);
-		PutCityBit(rand, rot, d, e, c, p4);
+		PutCityBit(params, cityflavour, rand, layout, p1, a, e, d);
+		PutCityBit(params, cityflavour, rand, layout, a, p2, b, e);
+		PutCityBit(params, cityflavour, rand, layout, e, b, p3, c);
+		PutCityBit(params, cityflavour, rand, layout, d, e, c, p4);
 	} else {
 		cent = cent.Normalized();
-		double height = m_planet->GetTerrainHeight(cent);
+		// same as TerrainBody::GetTerrainHeight
+		const double height = params.planetRadius * (1.0 + (params.terrain ? params.terrain->GetHeight(cent) : 0.0));
 		/* don't position below sealevel! */
-		if (height - m_planet->GetSystemBody()->GetRadius() <= 0.0) return;
+		if (height - params.planetRadius <= 0.0) return;
 		cent = cent * height;
 
+		const BuildingInstance inst = { instIndex, int(rand.Int32(4)), cent };
+		layout.buildings.push_back(inst);
+	}
+}
+
+//static
+void CityOnPlanet::GenerateLayout(const LayoutParams &params, Layout &layout)
+{
+	PROFILE_SCOPED()
+	layout.buildings.clear();
+	layout.buildings.reserve(DEFAULT_NUM_BUILDINGS);
+	layout.orient = params.orient;
+
+	const Aabb &aabb = params.aabb;
+	const matrix4x4d &m = params.orient;
+
+	vector3d mx = m*vector3d(1,0,0);
+	vector3d mz = m*vector3d(0,0,1);
+
+	Random rand;
+	rand.seed(params.seed);
+
+	const double seg = params.seg;
+	const double sizex = seg*2.0;
+	const double sizez = seg*2.0;
+
+	const vector3d p = params.pos;
+
+	// always have random shipyard buildings around the space station
+	cityflavourdef_t cityflavour[CITYFLAVOURS];
+	cityflavour[0].center = p;
+	cityflavour[0].size = seg;
+
+	for (unsigned int i = 1; i < CITYFLAVOURS; i++) {
+		const citybuildinglist_t *blist = &s_buildingList;
+		const double a = rand.Int32(-1000,1000);
+		const double b = rand.Int32(-1000,1000);
+		cityflavour[i].center = p + a*mx + b*mz;
+		cityflavour[i].size = rand.Int32(int(blist->minRadius), int(blist->maxRadius));
+	}
+	
+	vector3d p1, p2, p3, p4;
+	for (int side=0; side<4; side++) {
+		/* put buildings on all sides of spaceport */
+		switch(side) {
+			case 3:
+				p1 = p + mx*(aabb.min.x) + mz*aabb.min.z;
+				p2 = p + mx*(aabb.min.x) + mz*(aabb.min.z-sizez);
+				p3 = p + mx*(aabb.min.x+sizex) + mz*(aabb.min.z-sizez);
+				p4 = p + mx*(aabb.min.x+sizex) + mz*(aabb.min.z);
+				break;
+			case 2:
+				p1 = p + mx*(aabb.min.x-sizex) + mz*aabb.max.z;
+				p2 = p + mx*(aabb.min.x-sizex) + mz*(aabb.max.z-sizez);
+				p3 = p + mx*(aabb.min.x) + mz*(aabb.max.z-sizez);
+				p4 = p + mx*(aabb.min.x) + mz*(aabb.max.z);
+				break;
+			case 1:
+				p1 = p + mx*(aabb.max.x-sizex) + mz*aabb.max.z;
+				p2 = p + mx*(aabb.max.x) + mz*aabb.max.z;
+				p3 = p + mx*(aabb.max.x) + mz*(aabb.max.z+sizez);
+				p4 = p + mx*(aabb.max.x-sizex) + mz*(aabb.max.z+sizez);
+				break;
+			default:
+			case 0:
+				p1 = p + mx*aabb.max.x + mz*aabb.min.z;
+				p2 = p + mx*(aabb.max.x+sizex) + mz*aabb.min.z;
+				p3 = p + mx*(aabb.max.x+sizex) + mz*(aabb.min.z+sizez);
+				p4 = p + mx*aabb.max.x + mz*(aabb.min.z+sizez);
+				break;
+		}
+
+		PutCityBit(params, cityflavour, rand, layout, p1, p2, p3, p4);
+	}
+	Aabb buildAABB;
+	for (const BuildingInstance &b : layout.buildings) {
+		buildAABB.Update(b.pos - p);
+	}
+	layout.realCentre = buildAABB.min + ((buildAABB.max - buildAABB.min)*0.5);
+	layout.clipRadius = buildAABB.GetRadius();
+}
+
+//static
+int CityOnPlanet::GetDetailLevel()
+{
+	return std::max(0, Pi::detail.cities - s_detailReduction);
+}
+
+void CityOnPlanet::SetLayout(RefCountedPtr<Layout> layout)
+{
+	PROFILE_SCOPED()
+	assert(!m_layout);
+	m_layout = layout;
+
+	// keep it for next time, dropping the one that's gone longest unused
+	if (s_layouts.find(m_path) == s_layouts.end() && s_layouts.size() >= MAX_CACHED_LAYOUTS) {
+		auto oldest = s_layouts.begin();
+		for (auto it = s_layouts.begin(); it != s_layouts.end(); ++it) {
+			if (Sint32(it->second.lastUsed - oldest->second.lastUsed) < 0)
+				oldest = it;
+		}
+		s_layouts.erase(oldest);
+	}
+	CachedLayout &cached = s_layouts[m_path];
+	cached.layout = layout;
+	cached.lastUsed = SDL_GetTicks();
+
+	m_buildings.clear();
+	m_buildings.reserve(layout->buildings.size());
+	for (const BuildingInstance &b : layout->buildings) {
+		const CollMesh *cmesh = s_buildingList.buildings[b.instIndex].collMesh.Get();
 		Geom *geom = new Geom(cmesh->GetGeomTree());
-		int rotTimes90 = rand.Int32(4);
-		matrix4x4d grot = rot * matrix4x4d::RotateYMatrix(M_PI*0.5*double(rotTimes90));
-		geom->MoveTo(grot, cent);
+		const matrix4x4d grot = layout->orient * matrix4x4d::RotateYMatrix(M_PI*0.5*double(b.rotation));
+		geom->MoveTo(grot, b.pos);
 		geom->SetUserData(this);
-//		f->AddStaticGeom(geom);
 
-		BuildingDef def = { instIndex, float(cmesh->GetRadius()), rotTimes90, cent, geom };
+		const BuildingDef def = { b.instIndex, float(cmesh->GetRadius()), b.rotation, b.pos, geom };
 		m_buildings.push_back(def);
 	}
+	m_realCentre = layout->realCentre;
+	m_clipRadius = layout->clipRadius;
+	AddStaticGeomsToCollisionSpace();
 }
 
 void CityOnPlanet::AddStaticGeomsToCollisionSpace()
@@ -110,7 +257,7 @@ void CityOnPlanet::AddStaticGeomsToCollisionSpace()
 
 	// Generate the new building list
 	int skipMask;
-	switch (Pi::detail.cities) {
+	switch (GetDetailLevel()) {
 		case 0: skipMask = 0xf; break;
 		case 1: skipMask = 0x7; break;
 		case 2: skipMask = 0x3; break;
@@ -137,13 +284,63 @@ void CityOnPlanet::AddStaticGeomsToCollisionSpace()
 		}
 	}
 
+	BuildCells();
+
 	// reset the reset flag
-	m_detailLevel = Pi::detail.cities;
+	m_detailLevel = GetDetailLevel();
+}
+
+void CityOnPlanet::BuildCells()
+{
+	struct CellKey {
+		Sint64 x, y, z;
+		bool operator<(const CellKey &o) const {
+			return x < o.x || (x == o.x && (y < o.y || (y == o.y && z < o.z)));
+		}
+		bool operator!=(const CellKey &o) const { return x != o.x || y != o.y || z != o.z; }
+	};
+	const auto keyOf = [](const vector3d &p) {
+		const CellKey k = { Sint64(floor(p.x / CELL_SIZE)), Sint64(floor(p.y / CELL_SIZE)), Sint64(floor(p.z / CELL_SIZE)) };
+		return k;
+	};
+
+	std::stable_sort(m_enabledBuildings.begin(), m_enabledBuildings.end(), [&keyOf](const BuildingDef &a, const BuildingDef &b) {
+		return keyOf(a.pos) < keyOf(b.pos);
+	});
+
+	m_cells.clear();
+	Uint32 first = 0;
+	while (first < m_enabledBuildings.size()) {
+		const CellKey key = keyOf(m_enabledBuildings[first].pos);
+		Uint32 end = first + 1;
+		while (end < m_enabledBuildings.size() && !(keyOf(m_enabledBuildings[end].pos) != key))
+			++end;
+
+		Aabb aabb;
+		aabb.min = aabb.max = m_enabledBuildings[first].pos;
+		for (Uint32 i = first; i < end; i++)
+			aabb.Update(m_enabledBuildings[i].pos);
+
+		BuildingCell cell;
+		cell.centre = (aabb.min + aabb.max) * 0.5;
+		cell.radius = 0.0;
+		cell.maxClipRadius = 0.0f;
+		cell.first = first;
+		cell.count = end - first;
+		for (Uint32 i = first; i < end; i++) {
+			const BuildingDef &b = m_enabledBuildings[i];
+			cell.radius = std::max(cell.radius, (b.pos - cell.centre).Length() + b.clipRadius);
+			cell.maxClipRadius = std::max(cell.maxClipRadius, b.clipRadius);
+		}
+		m_cells.push_back(cell);
+		first = end;
+	}
 }
 
 void CityOnPlanet::RemoveStaticGeomsFromCollisionSpace()
 {
 	m_enabledBuildings.clear();
+	m_cells.clear();
 	for (unsigned int i=0; i<m_buildings.size(); i++) {
 		m_frame->RemoveStaticGeom(m_buildings[i].geom);
 	}
@@ -213,6 +410,7 @@ void CityOnPlanet::Init()
 
 void CityOnPlanet::Uninit()
 {
+	s_layouts.clear();
 	delete[] s_buildingList.buildings;
 }
 
@@ -261,97 +459,49 @@ CityOnPlanet::~CityOnPlanet()
 	}
 }
 
-CityOnPlanet::CityOnPlanet(Planet *planet, SpaceStation *station, const Uint32 seed)
+CityOnPlanet::CityOnPlanet(Planet *planet, SpaceStation *station, const Uint32 seed) :
+	m_planet(planet),
+	m_frame(planet->GetFrame()),
+	m_path(station->GetSystemBody()->GetPath()),
+	m_detailLevel(GetDetailLevel()),
+	m_realCentre(0.0),
+	m_clipRadius(0.0f)
 {
-	m_buildings.clear();
-	m_buildings.reserve(DEFAULT_NUM_BUILDINGS);
-	m_planet = planet;
-	m_frame = planet->GetFrame();
-	m_detailLevel = Pi::detail.cities;
-
 	/* Resolve city model numbers since it is a bit expensive */
 	if (!s_cityBuildingsInitted) {
 		s_cityBuildingsInitted = true;
 		LookupBuildingListModels(&s_buildingList);
 	}
 
-	const Aabb &aabb = station->GetAabb();
-	const matrix4x4d &m = station->GetOrient();
-
-	vector3d mx = m*vector3d(1,0,0);
-	vector3d mz = m*vector3d(0,0,1);
+	auto cached = s_layouts.find(m_path);
+	if (cached != s_layouts.end()) {
+		SetLayout(cached->second.layout);
+		return;
+	}
 
-	Random rand;
-	rand.seed(seed);
+	LayoutParams params;
+	params.terrain.Reset(planet->GetTerrain());
+	params.planetRadius = planet->GetSystemBody()->GetRadius();
+	params.seed = seed;
+	params.pos = station->GetPosition();
+	params.orient = station->GetOrient();
+	params.aabb = station->GetAabb();
 
 	const float pop = planet->GetSystemBody()->GetPopulation();
-	double seg = START_SEG_SIZE;
 	if (planet->GetSystemBody()->HasAtmosphere())
-		seg=Clamp(pop*1000.0, 200.0, START_SEG_SIZE);
+		params.seg = Clamp(pop*1000.0, 200.0, START_SEG_SIZE);
 	else
-		seg=Clamp(pop*100.0, 250.0, START_SEG_SIZE_NO_ATMO);
-
-	const double sizex = seg*2.0;
-	const double sizez = seg*2.0;
-
-	const vector3d p = station->GetPosition();
-
-	// always have random shipyard buildings around the space station
-	cityflavour[0].center = p;
-	cityflavour[0].size = seg;
-
-	for (unsigned int i = 1; i < CITYFLAVOURS; i++) {
-		const citybuildinglist_t *blist = &s_buildingList;
-		const double a = rand.Int32(-1000,1000);
-		const double b = rand.Int32(-1000,1000);
-		cityflavour[i].center = p + a*mx + b*mz;
-		cityflavour[i].size = rand.Int32(int(blist->minRadius), int(blist->maxRadius));
-	}
-	
-	vector3d p1, p2, p3, p4;
-	for (int side=0; side<4; side++) {
-		/* put buildings on all sides of spaceport */
-		switch(side) {
-			case 3:
-				p1 = p + mx*(aabb.min.x) + mz*aabb.min.z;
-				p2 = p + mx*(aabb.min.x) + mz*(aabb.min.z-sizez);
-				p3 = p + mx*(aabb.min.x+sizex) + mz*(aabb.min.z-sizez);
-				p4 = p + mx*(aabb.min.x+sizex) + mz*(aabb.min.z);
-				break;
-			case 2:
-				p1 = p + mx*(aabb.min.x-sizex) + mz*aabb.max.z;
-				p2 = p + mx*(aabb.min.x-sizex) + mz*(aabb.max.z-sizez);
-				p3 = p + mx*(aabb.min.x) + mz*(aabb.max.z-sizez);
-				p4 = p + mx*(aabb.min.x) + mz*(aabb.max.z);
-				break;
-			case 1:
-				p1 = p + mx*(aabb.max.x-sizex) + mz*aabb.max.z;
-				p2 = p + mx*(aabb.max.x) + mz*aabb.max.z;
-				p3 = p + mx*(aabb.max.x) + mz*(aabb.max.z+sizez);
-				p4 = p + mx*(aabb.max.x-sizex) + mz*(aabb.max.z+sizez);
-				break;
-			default:
-			case 0:
-				p1 = p + mx*aabb.max.x + mz*aabb.min.z;
-				p2 = p + mx*(aabb.max.x+sizex) + mz*aabb.min.z;
-				p3 = p + mx*(aabb.max.x+sizex) + mz*(aabb.min.z+sizez);
-				p4 = p + mx*aabb.max.x + mz*(aabb.min.z+sizez);
-				break;
-		}
+		params.seg = Clamp(pop*100.0, 250.0, START_SEG_SIZE_NO_ATMO);
 
-		PutCityBit(rand, m, p1, p2, p3, p4);
-	}
-	Aabb buildAABB;
-	for (std::vector<BuildingDef>::const_iterator iter=m_buildings.begin(), itEND=m_buildings.end(); iter != itEND; ++iter) {
-		buildAABB.Update((*iter).pos - p);
-	}
-	m_realCentre = buildAABB.min + ((buildAABB.max - buildAABB.min)*0.5);
-	m_clipRadius = buildAABB.GetRadius();
-	AddStaticGeomsToCollisionSpace();
+	m_layoutJob = Pi::GetAsyncJobQueue()->Queue(new LayoutJob(this, params));
 }
 
 void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustum, const SpaceStation *station, const vector3d &viewCoords, const matrix4x4d &viewTransform)
 {
+	if (!m_layout)
+		return;
+	s_layouts[m_path].lastUsed = SDL_GetTicks();
+
 	// Early frustum test of whole city.
 	const vector3d stationPos = viewTransform * (station->GetPosition() + m_realCentre);
 	//modelview seems to be always identity
@@ -363,7 +513,7 @@ void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustu
 	rot[0] = station->GetOrient();
 
 	// change detail level if necessary
-	const bool bDetailChanged = m_detailLevel != Pi::detail.cities;
+	const bool bDetailChanged = m_detailLevel != GetDetailLevel();
 	if (bDetailChanged) {
 		RemoveStaticGeomsFromCollisionSpace();
 		AddStaticGeomsToCollisionSpace();
@@ -380,35 +530,48 @@ void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustu
 	}
 
 	Uint32 uCount = 0;
-	std::vector<Uint32> instCount;
-	std::vector< std::vector<matrix4x4f> > transform;
-	instCount.resize(s_buildingList.numBuildings);
-	transform.resize(s_buildingList.numBuildings);
-	memset(&instCount[0], 0, sizeof(Uint32) * s_buildingList.numBuildings);
+	m_instTransforms.resize(s_buildingList.numBuildings);
 	for(Uint32 i=0; i<s_buildingList.numBuildings; i++) {
-		transform[i].reserve(m_buildingCounts[i]);
+		m_instTransforms[i].clear();
+		m_instTransforms[i].reserve(m_buildingCounts[i]);
 	}
 
-	for (std::vector<BuildingDef>::const_iterator iter=m_enabledBuildings.begin(), itEND=m_enabledBuildings.end(); iter != itEND; ++iter)
+	// same estimate as SceneGraph::LOD uses to pick a detail level
+	const float pixelScale = Graphics::GetScreenHeight() / Graphics::GetFovFactor();
+
+	for (std::vector<BuildingCell>::const_iterator cell=m_cells.begin(), cellEnd=m_cells.end(); cell != cellEnd; ++cell)
 	{
-		const vector3d pos = viewTransform * (*iter).pos;
-		const vector3f posf(pos);
-		if (!frustum.TestPoint(pos, (*iter).clipRadius))
+		const vector3d cellPos = viewTransform * cell->centre;
+		if (!frustum.TestPoint(cellPos, cell->radius))
 			continue;
+		// too far away for even its largest building to show
+		const double cellDist = std::max(cellPos.Length() - cell->radius, 1.0);
+		if (pixelScale * cell->maxClipRadius / cellDist < MIN_PIXEL_RADIUS)
+			continue;
+
+		for (Uint32 b = cell->first, bEnd = cell->first + cell->count; b < bEnd; b++)
+		{
+			const BuildingDef &building = m_enabledBuildings[b];
+			const vector3d pos = viewTransform * building.pos;
+			if (!frustum.TestPoint(pos, building.clipRadius))
+				continue;
+			if (pixelScale * building.clipRadius / std::max(pos.Length(), 1.0) < MIN_PIXEL_RADIUS)
+				continue;
 
-		matrix4x4f _rot(rotf[(*iter).rotation]);
-		_rot.SetTranslate(posf);
+			matrix4x4f _rot(rotf[building.rotation]);
+			_rot.SetTranslate(vector3f(pos));
 
-		// increment the instance count and store the transform
-		instCount[(*iter).instIndex]++;
-		transform[(*iter).instIndex].push_back( _rot );
+			// store the transform for this building's model
+			m_instTransforms[building.instIndex].push_back( _rot );
 
-		++uCount;
+			++uCount;
+		}
 	}
 	
-	// render the building models using instancing
+	// render the building models using instancing, one batch per model
 	for(Uint32 i=0; i<s_buildingList.numBuildings; i++) {
-		s_buildingList.buildings[i].resolvedModel->Render(transform[i]);
+		if (!m_instTransforms[i].empty())
+			s_buildingList.buildings[i].resolvedModel->Render(m_instTransforms[i]);
 	}
 
 	r->GetStats().AddToStatCount(Graphics::Stats::STAT_BUILDINGS, uCount);
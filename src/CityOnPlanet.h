@@ -10,6 +10,7 @@
 #include "CollMesh.h"
 #include "collider/Geom.h"
 #include "galaxy/StarSystem.h"
+#include "JobQueue.h"
 
 class Planet;
 class SpaceStation;
@@ -26,14 +27,38 @@ public:
 	virtual ~CityOnPlanet();
 	void Render(Graphics::Renderer *r, const Graphics::Frustum &camera, const SpaceStation *station, const vector3d &viewCoords, const matrix4x4d &viewTransform);
 	inline Planet *GetPlanet() const { return m_planet; }
+	// the layout is made on a job. until it's done there's nothing to draw
+	// or hit
+	bool IsReady() const { return m_layout.Valid(); }
 
 	static void Init();
 	static void Uninit();
 	static void SetCityModelPatterns(const SystemPath &path);
+	// cities show this many detail levels fewer than the setting, for
+	// the quality governor
+	static void SetDetailReduction(int levels) { s_detailReduction = levels; }
+
 private:
-	void PutCityBit(Random &rand, const matrix4x4d &rot, vector3d p1, vector3d p2, vector3d p3, vector3d p4);
+	// where the buildings go. worked out once per station and kept across
+	// visits, it's the same every time
+	struct BuildingInstance {
+		Uint32 instIndex;
+		int rotation; // 0-3
+		vector3d pos;
+	};
+	struct Layout : public RefCounted {
+		std::vector<BuildingInstance> buildings;
+		matrix4x4d orient; // the station's
+		vector3d realCentre;
+		float clipRadius;
+	};
+	struct LayoutParams;
+	class LayoutJob;
+
+	void SetLayout(RefCountedPtr<Layout> layout);
 	void AddStaticGeomsToCollisionSpace();
 	void RemoveStaticGeomsFromCollisionSpace();
+	void BuildCells();
 
 	struct BuildingDef {
 		Uint32 instIndex;
@@ -45,9 +70,25 @@ private:
 
 	Planet *m_planet;
 	Frame *m_frame;
+	SystemPath m_path;
+	RefCountedPtr<Layout> m_layout;
+	Job::Handle m_layoutJob;
 	std::vector<BuildingDef> m_buildings;
 	std::vector<BuildingDef> m_enabledBuildings;
 	std::vector<Uint32> m_buildingCounts;
+
+	// the enabled buildings, sorted into a coarse grid so whole blocks can be
+	// culled at once. each cell covers a contiguous run of m_enabledBuildings
+	struct BuildingCell {
+		vector3d centre;
+		double radius;
+		float maxClipRadius;
+		Uint32 first, count;
+	};
+	std::vector<BuildingCell> m_cells;
+	// per model instance transforms, kept to save reallocating every frame
+	std::vector< std::vector<matrix4x4f> > m_instTransforms;
+
 	int m_detailLevel;
 	vector3d m_realCentre;
 	float m_clipRadius;
@@ -77,9 +118,20 @@ private:
 	};
 
 	static bool s_cityBuildingsInitted;
+	static int s_detailReduction;
+	static int GetDetailLevel();
 
 	static citybuildinglist_t s_buildingList;
-	static cityflavourdef_t cityflavour[CITYFLAVOURS];
+
+	static void GenerateLayout(const LayoutParams &params, Layout &layout);
+	static void PutCityBit(const LayoutParams &params, const cityflavourdef_t *flavours, Random &rand, Layout &layout,
+		vector3d p1, vector3d p2, vector3d p3, vector3d p4);
+
+	struct CachedLayout {
+		RefCountedPtr<Layout> layout;
+		Uint32 lastUsed;
+	};
+	static std::map<SystemPath, CachedLayout> s_layouts;
 
 	static void EnumerateNewBuildings(std::set<std::string> &filenames);
 	static void LookupBuildingListModels(citybuildinglist_t *list);
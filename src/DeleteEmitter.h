@@ -8,10 +8,8 @@
 // destroyed. the LuaObject tracking layer uses this to properly "forget"
 // about objects that are currently exposed to lua
 
-// including sigc++ directly so we don't get circular dependencies
-#include <sigc++/sigc++.h>
-
 #include "LuaWrappable.h"
+#include "Signal.h"
 
 class DeleteEmitter : public LuaWrappable {
 public:
@@ -22,12 +20,12 @@ public:
 
 	// onDelete is mutable since its not unusual to want to know when a const
 	// object is deleted, and attaching this signal does not conceptually
-	// affect the object's state
-	mutable sigc::signal<void> onDelete;
+	// affect the object's state. every object pushed to lua connects to it,
+	// so it's a Signal rather than a sigc::signal and connecting costs no
+	// allocation
+	mutable Signal<> onDelete;
 
 private:
-    // sigc++ signals cannot be copied, but long-standing design flaw means
-    // they don't have a private copy constructor. we protect them ourselves
 	DeleteEmitter(const DeleteEmitter &) {}
 };
 
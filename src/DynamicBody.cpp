@@ -8,11 +8,27 @@
 #include "Serializer.h"
 #include "Planet.h"
 #include "Pi.h"
+#include "Game.h"
+#include "Player.h"
+#include "BodyIntegrator.h"
 #include "json/JsonUtils.h"
 
 static const float KINETIC_ENERGY_MULT = 0.00001f;
 const double DynamicBody::DEFAULT_DRAG_COEFF = 0.1; // 'smooth sphere'
 
+// coasting bodies go on rails at and above this time accel
+static const Game::TimeAccel RAILS_MIN_TIME_ACCEL = Game::TIMEACCEL_1000X;
+// and no closer to the player than this (m)
+static const double RAILS_MIN_PLAYER_DIST = 1000.0e3;
+// how far the orbit may be from the body's state when it's made, relative
+// to the position and velocity
+static const double RAILS_POS_TOLERANCE = 1e-6;
+static const double RAILS_VEL_TOLERANCE = 1e-4;
+
+// the cached terrain height is reused for points closer than this to the
+// last one (m along the surface)
+static const double TERRAIN_HEIGHT_REUSE_DIST = 0.01;
+
 DynamicBody::DynamicBody(): ModelBody()
 {
 	m_dragCoeff = DEFAULT_DRAG_COEFF;
@@ -32,6 +48,10 @@ DynamicBody::DynamicBody(): ModelBody()
 	m_externalForce = vector3d(0.0);		// do external forces calc instead?
 	m_lastForce = vector3d(0.0);
 	m_lastTorque = vector3d(0.0);
+	m_onRails = false;
+	m_railsTime = 0.0;
+	m_terrainHeightBody = nullptr;
+	m_terrainHeight = 0.0;
 }
 
 void DynamicBody::SetForce(const vector3d &f)
@@ -82,7 +102,7 @@ void DynamicBody::LoadFromJson(const Json::Value &jsonObj, Space *space)
 	ModelBody::LoadFromJson(jsonObj, space);
 
 	if (!jsonObj.isMember("dynamic_body")) throw SavedGameCorruptException();
-	Json::Value dynamicBodyObj = jsonObj["dynamic_body"];
+	const Json::Value &dynamicBodyObj = jsonObj["dynamic_body"];
 
 	if (!dynamicBodyObj.isMember("force")) throw SavedGameCorruptException();
 	if (!dynamicBodyObj.isMember("torque")) throw SavedGameCorruptException();
@@ -127,6 +147,19 @@ void DynamicBody::SetFrame(Frame *f)
 	ModelBody::SetFrame(f);
 	// external forces will be wrong after frame transition
 	m_externalForce = m_gravityForce = m_atmosForce = vector3d(0.0);
+	m_onRails = false;
+	m_terrainHeightBody = nullptr;
+}
+
+double DynamicBody::GetTerrainHeightBelow(const TerrainBody *terrain, const vector3d &dir)
+{
+	const double reuse = TERRAIN_HEIGHT_REUSE_DIST / terrain->GetSystemBody()->GetRadius();
+	if (terrain != m_terrainHeightBody || (dir - m_terrainHeightDir).LengthSqr() > reuse*reuse) {
+		m_terrainHeight = terrain->GetTerrainHeight(dir);
+		m_terrainHeightDir = dir;
+		m_terrainHeightBody = terrain;
+	}
+	return m_terrainHeight;
 }
 
 double DynamicBody::CalcAtmosphericForce(double dragCoeff) const
@@ -184,35 +217,107 @@ void DynamicBody::CalcExternalForce()
 	}
 }
 
+// at high time accel a coasting body far from the player follows the orbit
+// it's on exactly, rather than integrating gravity in steps of minutes
+bool DynamicBody::CanUseRails() const
+{
+	if (!Pi::game || Pi::game->GetTimeAccel() < RAILS_MIN_TIME_ACCEL)
+		return false;
+	if (IsType(Object::PLAYER))
+		return false;
+	// under thrust
+	if (!is_zero_exact(m_force.LengthSqr()))
+		return false;
+
+	// rotating frames have drag and their own spin to think about
+	const Frame *frame = GetFrame();
+	if (!frame || frame->IsRotFrame())
+		return false;
+	const Body *body = frame->GetBody();
+	if (!body || body->IsType(Object::SPACESTATION))
+		return false;
+
+	const Body *player = Pi::game->GetPlayer();
+	if (player && player->GetFrame() && GetPositionRelTo(player).LengthSqr() < RAILS_MIN_PLAYER_DIST*RAILS_MIN_PLAYER_DIST)
+		return false;
+
+	return true;
+}
+
+bool DynamicBody::StartRails()
+{
+	const vector3d pos = GetPosition();
+	m_railsOrbit = Orbit::FromBodyState(pos, m_vel, GetFrame()->GetBody()->GetMass());
+	m_railsTime = 0.0;
+
+	// FromBodyState gives up on some states and rounds off others. only
+	// trust it if it puts the body where it is, going where it's going
+	const double posError = (m_railsOrbit.OrbitalPosAtTime(0.0) - pos).Length();
+	const double velError = (RailsVelocity(0.0) - m_vel).Length();
+	if (posError > RAILS_POS_TOLERANCE * pos.Length() + 1.0 || velError > RAILS_VEL_TOLERANCE * m_vel.Length() + 0.01)
+		return false;
+
+	m_railsPos = pos;
+	m_railsVel = m_vel;
+	return true;
+}
+
+// Orbit only does positions
+vector3d DynamicBody::RailsVelocity(double t) const
+{
+	const double h = 0.5;
+	return (m_railsOrbit.OrbitalPosAtTime(t + h) - m_railsOrbit.OrbitalPosAtTime(t - h)) / (2.0 * h);
+}
+
+void DynamicBody::MoveOnRails(double timeStep)
+{
+	m_railsTime += timeStep;
+	m_railsPos = m_railsOrbit.OrbitalPosAtTime(m_railsTime);
+	m_railsVel = RailsVelocity(m_railsTime);
+	SetPosition(m_railsPos);
+	m_vel = m_railsVel;
+}
+
 void DynamicBody::TimeStepUpdate(const float timeStep)
 {
 	m_oldPos = GetPosition();
 	if (m_isMoving) {
-		m_force += m_externalForce;
-
-		m_vel += double(timeStep) * m_force * (1.0 / m_mass);
+		// moved or pushed by something other than the last step
+		if (m_onRails && (!GetPosition().ExactlyEqual(m_railsPos) || !m_vel.ExactlyEqual(m_railsVel)))
+			m_onRails = false;
+		if (!CanUseRails())
+			m_onRails = false;
+		else if (!m_onRails)
+			m_onRails = StartRails();
+
+		if (!m_onRails) {
+			m_force += m_externalForce;
+
+			// Space integrates the lot together, and calls FinishIntegration
+			BodyIntegrator *integrator = Pi::game ? Pi::game->GetSpace()->GetIntegrator() : nullptr;
+			if (integrator) {
+				integrator->Add(this, timeStep, GetPosition(), m_vel, m_angVel, m_force, m_torque, m_mass, m_angInertia);
+				ModelBody::TimeStepUpdate(timeStep);
+				return;
+			}
+
+			m_vel += double(timeStep) * m_force * (1.0 / m_mass);
+		}
 		m_angVel += double(timeStep) * m_torque * (1.0 / m_angInertia);
 
-		double len = m_angVel.Length();
-		if (len > 1e-16) {
-			vector3d axis = m_angVel * (1.0 / len);
-			matrix3x3d r = matrix3x3d::Rotate(len * timeStep, axis);
-			SetOrient(r * GetOrient());
-		}
-		m_oldAngDisplacement = m_angVel * timeStep;
+		Rotate(timeStep);
 
-		SetPosition(GetPosition() + m_vel * double(timeStep));
+		if (m_onRails)
+			MoveOnRails(timeStep);
+		else
+			SetPosition(GetPosition() + m_vel * double(timeStep));
 
 //if (this->IsType(Object::PLAYER))
 //Output("pos = %.1f,%.1f,%.1f, vel = %.1f,%.1f,%.1f, force = %.1f,%.1f,%.1f, external = %.1f,%.1f,%.1f\n",
 //	pos.x, pos.y, pos.z, m_vel.x, m_vel.y, m_vel.z, m_force.x, m_force.y, m_force.z,
 //	m_externalForce.x, m_externalForce.y, m_externalForce.z);
 
-		m_lastForce = m_force;
-		m_lastTorque = m_torque;
-		m_force = vector3d(0.0);
-		m_torque = vector3d(0.0);
-		CalcExternalForce();			// regenerate for new pos/vel
+		EndStep();
 	} else {
 		m_oldAngDisplacement = vector3d(0.0);
 	}
@@ -220,6 +325,36 @@ void DynamicBody::TimeStepUpdate(const float timeStep)
 	ModelBody::TimeStepUpdate(timeStep);
 }
 
+void DynamicBody::FinishIntegration(const BodyIntegrator &integrator, Uint32 index)
+{
+	m_vel = integrator.GetVelocity(index);
+	m_angVel = integrator.GetAngVelocity(index);
+	Rotate(integrator.GetTimeStep(index));
+	SetPosition(integrator.GetPosition(index));
+	EndStep();
+}
+
+// by the (already updated) angular velocity
+void DynamicBody::Rotate(double timeStep)
+{
+	double len = m_angVel.Length();
+	if (len > 1e-16) {
+		vector3d axis = m_angVel * (1.0 / len);
+		matrix3x3d r = matrix3x3d::Rotate(len * timeStep, axis);
+		SetOrient(r * GetOrient());
+	}
+	m_oldAngDisplacement = m_angVel * timeStep;
+}
+
+void DynamicBody::EndStep()
+{
+	m_lastForce = m_force;
+	m_lastTorque = m_torque;
+	m_force = vector3d(0.0);
+	m_torque = vector3d(0.0);
+	CalcExternalForce();			// regenerate for new pos/vel
+}
+
 void DynamicBody::UpdateInterpTransform(double alpha)
 {
 	m_interpPos = alpha*GetPosition() + (1.0-alpha)*m_oldPos;
@@ -259,6 +394,7 @@ vector3d DynamicBody::GetVelocity() const
 void DynamicBody::SetVelocity(const vector3d &v)
 {
 	m_vel = v;
+	m_onRails = false;
 }
 
 vector3d DynamicBody::GetAngVelocity() const
@@ -10,6 +10,9 @@
 #include "matrix4x4.h"
 #include "Orbit.h"
 
+class BodyIntegrator;
+class TerrainBody;
+
 class DynamicBody: public ModelBody {
 public:
 	OBJDEF(DynamicBody, ModelBody, DYNAMICBODY);
@@ -51,6 +54,16 @@ public:
 	virtual void PostLoadFixup(Space *space);
 
 	Orbit ComputeOrbit() const;
+	// following an orbit analytically instead of being integrated. see
+	// TimeStepUpdate
+	bool IsOnRails() const { return m_onRails; }
+	// the rest of TimeStepUpdate, once integrator has stepped the body
+	void FinishIntegration(const BodyIntegrator &integrator, Uint32 index);
+
+	// terrain->GetTerrainHeight(dir), reusing the last answer while the body
+	// is still over the same spot (eg resting on the ground). terrain must
+	// be the body of the frame the body is in
+	double GetTerrainHeightBelow(const TerrainBody *terrain, const vector3d &dir);
 protected:
 	virtual void SaveToJson(Json::Value &jsonObj, Space *space);
 	virtual void LoadFromJson(const Json::Value &jsonObj, Space *space);
@@ -59,6 +72,14 @@ protected:
 	double m_dragCoeff;
 
 private:
+	void Rotate(double timeStep);
+	void EndStep();
+
+	bool CanUseRails() const;
+	bool StartRails();
+	void MoveOnRails(double timeStep);
+	vector3d RailsVelocity(double t) const;
+
 	vector3d m_oldPos;
 	vector3d m_oldAngDisplacement;
 
@@ -77,6 +98,16 @@ private:
 	// for time accel reduction fudge
 	vector3d m_lastForce;
 	vector3d m_lastTorque;
+
+	bool m_onRails;
+	Orbit m_railsOrbit;  // from where the body went on rails,
+	double m_railsTime;  // this long ago
+	vector3d m_railsPos; // what the last step set, so a change from
+	vector3d m_railsVel; // anywhere else takes the body off rails
+
+	const TerrainBody *m_terrainHeightBody; // null if there's no cached height
+	vector3d m_terrainHeightDir;
+	double m_terrainHeight;
 };
 
 #endif /* _DYNAMICBODY_H */
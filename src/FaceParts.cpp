@@ -104,6 +104,9 @@ namespace {
 	}
 
 	static PartDb *s_partdb;
+	// held while building a face, so Uninit can't pull the parts out from
+	// under a job. created once and kept, a job may still be waiting on it
+	static SDL_mutex *s_buildLock;
 } // anonymous namespace
 
 namespace fs = FileSystem;
@@ -215,6 +218,8 @@ const int FaceParts::FACE_HEIGHT = 285;
 
 void FaceParts::Init()
 {
+	if (!s_buildLock)
+		s_buildLock = SDL_CreateMutex();
 	s_partdb = new PartDb;
 	s_partdb->Scan();
 	Output("Face Generation source images loaded.\n");
@@ -222,8 +227,10 @@ void FaceParts::Init()
 
 void FaceParts::Uninit()
 {
+	SDL_LockMutex(s_buildLock);
 	delete s_partdb;
 	s_partdb = nullptr;
+	SDL_UnlockMutex(s_buildLock);
 }
 
 int FaceParts::NumSpecies() {
@@ -310,6 +317,12 @@ void FaceParts::PickFaceParts(FaceDescriptor &inout_face, const Uint32 seed) {
 }
 
 void FaceParts::BuildFaceImage(SDL_Surface *faceIm, const FaceDescriptor &face, bool armoured) {
+	SDL_LockMutex(s_buildLock);
+	if (!s_partdb) {
+		SDL_UnlockMutex(s_buildLock);
+		return;
+	}
+
 	const Uint32 selector = _make_selector(face.species, face.race, face.gender);
 
 	_blit_image(faceIm, s_partdb->background_general.Get(), 0, 0);
@@ -326,4 +339,5 @@ void FaceParts::BuildFaceImage(SDL_Surface *faceIm, const FaceDescriptor &face,
 	} else {
 		_blit_image(faceIm, _get_part(s_partdb->armour, selector, face.armour), 0, 0);
 	}
+	SDL_UnlockMutex(s_buildLock);
 }
@@ -54,6 +54,8 @@ namespace FaceParts {
 	int NumArmour(const int speciesIdx, const int raceIdx, const int genderIdx);
 
 	void PickFaceParts(FaceDescriptor &inout_face, const Uint32 seed);
+	// safe to call from worker threads. faces are built one at a time, as
+	// blitting a part changes its surface's blit map
 	void BuildFaceImage(SDL_Surface *faceIm, const FaceDescriptor &face, bool armoured);
 }
 
@@ -370,6 +370,7 @@ void FactionsDatabase::SetHomeSectors()
 	for (auto it = m_factions.begin(); it != m_factions.end(); ++it)
 		if ((*it)->hasHomeworld)
 			(*it)->m_homesector = m_galaxy->GetSector((*it)->homeworld);
+	m_spatial_index.Build(m_factions);
 	m_may_assign_factions = true;
 }
 
@@ -396,7 +397,6 @@ void FactionsDatabase::AddFaction(Faction* faction)
 		}
 		m_missingFactionsMap.erase(it);
 	}
-	m_spatial_index.Add(faction);
 
 	if (faction->hasHomeworld) m_homesystems.insert(faction->homeworld.SystemOnly());
 	faction->idx = m_factions.size()-1;
@@ -443,9 +443,18 @@ const Faction* FactionsDatabase::GetNearestFaction(const Sector::System* sys) co
 	// if it didn't, or it wasn't a custom StarStystem, then we go ahead and assign it a faction allegiance like normal below...
 	const Faction* result = &m_no_faction;
 	double closestFactionDist = HUGE_VAL;
-	ConstFactionList& candidates = m_spatial_index.CandidateFactions(sys);
 
-	for (ConstFactionIterator it = candidates.begin(); it != candidates.end(); ++it) {
+	// the spatial index only exists once the home sectors are set, so check everyone until then
+	if (!m_may_assign_factions) {
+		for (FactionList::const_iterator it = m_factions.begin(); it != m_factions.end(); ++it) {
+			if ((*it)->IsCloserAndContains(closestFactionDist, sys)) result = *it;
+		}
+		return result;
+	}
+
+	CandidateList candidates = m_spatial_index.CandidateFactions(sys);
+
+	for (ConstFactionIterator it = candidates->begin(); it != candidates->end(); ++it) {
 		if ((*it)->IsCloserAndContains(closestFactionDist, sys)) result = *it;
 	}
 	return result;
@@ -597,95 +606,151 @@ Faction::Faction(Galaxy* galaxy) :
 
 // ------ Factions Spatial Indexing ------
 
-void FactionsDatabase::Octsapling::Add(const Faction* faction)
+FactionsDatabase::SpatialIndex::SpatialIndex() :
+	m_root(NO_NODE)
 {
-	PROFILE_SCOPED()
-	/*  The general principle here is to put the faction in every octbox cell that a system
-	    that is a member of that faction could be in. This should let us cut the number
-		of factions that have to be checked by GetNearestFaction, by eliminating right off
-		all the those Factions that aren't in the same cell.
-
-		As I'm just going for the quick performance win, I'm being very sloppy and
-		treating a Faction as if it was a cube rather than a sphere. I'm also not even
-		attempting to work out real faction boundaries for this.
+	m_cacheLock = SDL_CreateMutex();
+}
 
-		Obviously this all could be improved even without this Octsapling growing into
-		a full Octree.
+FactionsDatabase::SpatialIndex::~SpatialIndex()
+{
+	SDL_DestroyMutex(m_cacheLock);
+}
 
-		This part happens at faction generation time so shouldn't be too performance
-		critical
+void FactionsDatabase::SpatialIndex::Build(const FactionList& factions)
+{
+	PROFILE_SCOPED()
+	/*  This happens once the home sectors are available, so custom homeworlds
+	    can be placed too. Factions whose homeworld still can't be found are
+	    candidates for every system, as they were with the old octbox.
 	*/
-	RefCountedPtr<const Sector> sec = faction->GetHomeSector();
+	Clear();
+	for (const Faction* faction : factions) {
+		if (!faction->hasHomeworld) {
+			m_unlocated.push_back(faction);
+			continue;
+		}
+		RefCountedPtr<const Sector> sec = faction->GetHomeSector();
+		if (faction->homeworld.systemIndex >= sec->m_systems.size()) {
+			m_unlocated.push_back(faction);
+			continue;
+		}
+		m_bySector[faction->homeworld.SectorOnly()].push_back(faction);
 
-	/* only factions with homeworlds that are available at faction generation time can
-	   be added to specific cells...
-	*/
-	if (faction->hasHomeworld && (faction->homeworld.systemIndex < sec->m_systems.size())) {
-		/* calculate potential indexes for the octbox cells the faction needs to go into
-		*/
-		Sector::System sys = sec->m_systems[faction->homeworld.systemIndex];
+		Node node;
+		node.faction = faction;
+		node.pos = sec->m_systems[faction->homeworld.systemIndex].GetFullPosition();
+		node.left = node.right = NO_NODE;
+		m_nodes.push_back(node);
+	}
+	m_root = BuildNodes(0, m_nodes.size(), 0);
+}
 
-		int xmin = BoxIndex(Sint32(sys.GetFullPosition().x - float((faction->Radius()))));
-		int xmax = BoxIndex(Sint32(sys.GetFullPosition().x + float((faction->Radius()))));
-		int ymin = BoxIndex(Sint32(sys.GetFullPosition().y - float((faction->Radius()))));
-		int ymax = BoxIndex(Sint32(sys.GetFullPosition().y + float((faction->Radius()))));
-		int zmin = BoxIndex(Sint32(sys.GetFullPosition().z - float((faction->Radius()))));
-		int zmax = BoxIndex(Sint32(sys.GetFullPosition().z + float((faction->Radius()))));
+Uint32 FactionsDatabase::SpatialIndex::BuildNodes(size_t first, size_t last, int depth)
+{
+	if (first >= last) return NO_NODE;
 
-		/* put the faction in all the octbox cells needed in a hideously inexact way that
-		   will generate duplicates in each cell in many cases
-		*/
-		octbox[xmin][ymin][zmin].push_back(faction);  // 0,0,0
-		octbox[xmax][ymin][zmin].push_back(faction);  // 1,0,0
-		octbox[xmax][ymax][zmin].push_back(faction);  // 1,1,0
-		octbox[xmax][ymax][zmax].push_back(faction);  // 1,1,1
+	const int axis = depth % 3;
+	const size_t mid = first + (last - first) / 2;
+	std::nth_element(m_nodes.begin() + first, m_nodes.begin() + mid, m_nodes.begin() + last,
+		[axis](const Node& a, const Node& b) { return a.pos[axis] < b.pos[axis]; });
 
-		octbox[xmin][ymax][zmin].push_back(faction);  // 0,1,0
-		octbox[xmin][ymax][zmax].push_back(faction);  // 0,1,1
-		octbox[xmin][ymin][zmax].push_back(faction);  // 0,0,1
-		octbox[xmax][ymin][zmax].push_back(faction);  // 1,0,1
+	Node& node = m_nodes[mid];
+	node.left = BuildNodes(first, mid, depth + 1);
+	node.right = BuildNodes(mid + 1, last, depth + 1);
 
-		/* prune any duplicates from the octbox cells making things slightly saner
-		*/
-		PruneDuplicates(0,0,0);
-		PruneDuplicates(1,0,0);
-		PruneDuplicates(1,1,0);
-		PruneDuplicates(1,1,1);
+	node.boundsMin = node.boundsMax = node.pos;
+	node.maxRadius = float(node.faction->Radius());
+	for (Uint32 child : { node.left, node.right }) {
+		if (child == NO_NODE) continue;
+		const Node& c = m_nodes[child];
+		for (int i = 0; i < 3; i++) {
+			node.boundsMin[i] = std::min(node.boundsMin[i], c.boundsMin[i]);
+			node.boundsMax[i] = std::max(node.boundsMax[i], c.boundsMax[i]);
+		}
+		node.maxRadius = std::max(node.maxRadius, c.maxRadius);
+	}
+	return Uint32(mid);
+}
 
-		PruneDuplicates(0,1,0);
-		PruneDuplicates(0,1,1);
-		PruneDuplicates(0,0,1);
-		PruneDuplicates(1,0,1);
+void FactionsDatabase::SpatialIndex::Clear()
+{
+	m_nodes.clear();
+	m_root = NO_NODE;
+	m_unlocated.clear();
+	m_bySector.clear();
+	ClearCache();
+}
 
-	} else {
-	/* ...other factions, such as ones with no homeworlds, and more annoyingly ones
-	   whose homeworlds don't exist yet because they're custom systems have to go in
-	   *every* octbox cell
-	*/
-		octbox[0][0][0].push_back(faction);
-		octbox[1][0][0].push_back(faction);
-		octbox[1][1][0].push_back(faction);
-		octbox[1][1][1].push_back(faction);
-
-		octbox[0][1][0].push_back(faction);
-		octbox[0][1][1].push_back(faction);
-		octbox[0][0][1].push_back(faction);
-		octbox[1][0][1].push_back(faction);
-	}
+void FactionsDatabase::SpatialIndex::ClearCache()
+{
+	SDL_LockMutex(m_cacheLock);
+	m_sectorCandidates.clear();
+	SDL_UnlockMutex(m_cacheLock);
 }
 
-void FactionsDatabase::Octsapling::PruneDuplicates(const int bx, const int by, const int bz)
+void FactionsDatabase::SpatialIndex::Query(Uint32 nodeIdx, const vector3f& centre, float radius, std::vector<const Faction*>& out) const
 {
-	PROFILE_SCOPED()
-	octbox[bx][by][bz].erase(std::unique( octbox[bx][by][bz].begin(), octbox[bx][by][bz].end() ), octbox[bx][by][bz].end() );
+	// a little slack so that rounding never drops a faction IsCloserAndContains would accept
+	static const float SLACK = 1.0f;
+
+	while (nodeIdx != NO_NODE) {
+		const Node& node = m_nodes[nodeIdx];
+		vector3f d(0.0f);
+		for (int i = 0; i < 3; i++) {
+			if (centre[i] < node.boundsMin[i]) d[i] = node.boundsMin[i] - centre[i];
+			else if (centre[i] > node.boundsMax[i]) d[i] = centre[i] - node.boundsMax[i];
+		}
+		if (d.Length() > radius + node.maxRadius + SLACK)
+			return;
+
+		if ((node.pos - centre).Length() < radius + float(node.faction->Radius()) + SLACK)
+			out.push_back(node.faction);
+
+		Query(node.left, centre, radius, out);
+		nodeIdx = node.right;
+	}
 }
 
-const std::vector<const Faction*>& FactionsDatabase::Octsapling::CandidateFactions(const Sector::System* sys) const
+FactionsDatabase::CandidateList FactionsDatabase::SpatialIndex::CandidateFactions(const Sector::System* sys) const
 {
 	PROFILE_SCOPED()
-	/* answer the factions that we've put in the same octobox cell as the one the
-	   system would go in. This part happens every time we do GetNearest faction
-	   so *is* performance criticale.e
+	/* answer the factions that could possibly claim a system anywhere in the
+	   system's sector. This part happens every time we do GetNearestFaction
+	   so *is* performance critical.
+	*/
+	const SystemPath sectorPath(sys->sx, sys->sy, sys->sz);
+
+	SDL_LockMutex(m_cacheLock);
+	auto it = m_sectorCandidates.find(sectorPath);
+	if (it != m_sectorCandidates.end()) {
+		CandidateList cached = it->second;
+		SDL_UnlockMutex(m_cacheLock);
+		return cached;
+	}
+	SDL_UnlockMutex(m_cacheLock);
+
+	std::vector<const Faction*> candidates(m_unlocated);
+	auto home = m_bySector.find(sectorPath);
+	if (home != m_bySector.end())
+		candidates.insert(candidates.end(), home->second.begin(), home->second.end());
+
+	const vector3f centre = Sector::SIZE * (vector3f(float(sys->sx), float(sys->sy), float(sys->sz)) + vector3f(0.5f));
+	const float halfDiagonal = Sector::SIZE * 0.8660254f;
+	Query(m_root, centre, halfDiagonal, candidates);
+
+	/* GetNearestFaction lets later factions win ties, so keep the candidates
+	   in the order the factions were added
 	*/
-	return octbox[BoxIndex(sys->sx)][BoxIndex(sys->sy)][BoxIndex(sys->sz)];
+	std::sort(candidates.begin(), candidates.end(),
+		[](const Faction* a, const Faction* b) { return a->idx < b->idx; });
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+	CandidateList result = std::make_shared<ConstFactionList>(std::move(candidates));
+
+	SDL_LockMutex(m_cacheLock);
+	if (m_sectorCandidates.size() >= MAX_CACHED_SECTORS)
+		m_sectorCandidates.clear();
+	m_sectorCandidates[sectorPath] = result;
+	SDL_UnlockMutex(m_cacheLock);
+	return result;
 }
@@ -11,7 +11,9 @@
 #include "vector3.h"
 #include "fixed.h"
 #include "DeleteEmitter.h"
+#include "SDL_mutex.h"
 #include <map>
+#include <memory>
 #include <vector>
 #include <utility>
 
@@ -73,11 +75,6 @@ private:
 	const bool IsCloserAndContains(double& closestFactionDist, const Sector::System* sys) const;
 };
 
-/* One day it might grow up to become a full tree, on the  other hand it might be
-   cut down before it's full growth to be replaced by
-   a proper spatial data structure.
-*/
-
 class FactionsDatabase {
 public:
 	FactionsDatabase(Galaxy* galaxy, const std::string& factionDir) : m_galaxy(galaxy), m_factionDirectory(factionDir), m_no_faction(galaxy), m_may_assign_factions(false), m_initialized(false) { }
@@ -85,7 +82,7 @@ public:
 
 	void Init();
 	void PostInit();
-	void ClearCache() { ClearHomeSectors(); }
+	void ClearCache() { ClearHomeSectors(); m_spatial_index.ClearCache(); }
 	bool IsInitialized() const;
 	Galaxy* GetGalaxy() const { return m_galaxy; }
 	void RegisterCustomSystem(CustomSystem *cs, const std::string& factionName);
@@ -101,21 +98,52 @@ public:
 	bool MayAssignFactions() const;
 
 private:
-	class Octsapling {
+	typedef std::vector<Faction*> FactionList;
+	typedef FactionList::iterator FactionIterator;
+	typedef const std::vector<const Faction*> ConstFactionList;
+	typedef ConstFactionList::const_iterator ConstFactionIterator;
+	typedef std::shared_ptr<ConstFactionList> CandidateList;
+
+	/* k-d tree over the faction homeworlds. Every node also carries the bounds
+	   of its subtree and the largest faction radius in it, so whole branches can
+	   be skipped when they can't reach a sector. The candidate list of each sector
+	   is kept, because every system in a sector asks the same question.
+	*/
+	class SpatialIndex {
 	public:
-		void Add(const Faction* faction);
-		const std::vector<const Faction*>& CandidateFactions(const Sector::System* sys) const;
+		SpatialIndex();
+		~SpatialIndex();
+
+		void Build(const FactionList& factions);
+		void Clear();
+		void ClearCache();
+		CandidateList CandidateFactions(const Sector::System* sys) const;
 
 	private:
-		std::vector<const Faction*> octbox[2][2][2];
-		static const int BoxIndex(Sint32 sectorIndex) { return sectorIndex < 0 ? 0: 1; };
-		void PruneDuplicates(const int bx, const int by, const int bz);
+		static const Uint32 NO_NODE = ~0u;
+		static const size_t MAX_CACHED_SECTORS = 4096;
+
+		struct Node {
+			const Faction* faction;
+			vector3f       pos;
+			vector3f       boundsMin;
+			vector3f       boundsMax;
+			float          maxRadius;
+			Uint32         left;
+			Uint32         right;
+		};
+
+		Uint32 BuildNodes(size_t first, size_t last, int depth);
+		void Query(Uint32 nodeIdx, const vector3f& centre, float radius, std::vector<const Faction*>& out) const;
+
+		std::vector<Node> m_nodes;
+		Uint32 m_root;
+		std::vector<const Faction*> m_unlocated;                          // no usable homeworld, so may claim any system
+		std::map<SystemPath, std::vector<const Faction*> > m_bySector;    // claim all of their home sector regardless of radius
+		mutable std::map<SystemPath, CandidateList> m_sectorCandidates;
+		SDL_mutex* m_cacheLock;
 	};
 
-	typedef std::vector<Faction*> FactionList;
-	typedef FactionList::iterator FactionIterator;
-	typedef const std::vector<const Faction*> ConstFactionList;
-	typedef ConstFactionList::const_iterator ConstFactionIterator;
 	typedef std::map<std::string, Faction*> FactionMap;
 	typedef std::set<SystemPath>  HomeSystemSet;
 	typedef std::map<std::string, std::list<CustomSystem*> > MissingFactionsMap;
@@ -129,7 +157,7 @@ private:
 	FactionList       m_factions;
 	FactionMap        m_factions_byName;
 	HomeSystemSet     m_homesystems;
-	Octsapling        m_spatial_index;
+	SpatialIndex      m_spatial_index;
 	bool              m_may_assign_factions;
 	bool              m_initialized = false;
 	MissingFactionsMap m_missingFactionsMap;
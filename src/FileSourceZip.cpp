@@ -13,7 +13,16 @@ extern "C" {
 
 namespace FileSystem {
 
-FileSourceZip::FileSourceZip(FileSourceFS &fs, const std::string &zipPath) : FileSource(zipPath), m_archive(0)
+// big files would push everything else out, so they're extracted each time
+static const size_t MAX_CACHED_FRACTION = 4;
+
+FileSourceZip::FileSourceZip(FileSourceFS &fs, const std::string &zipPath, size_t cacheBudget) :
+	FileSource(zipPath),
+	m_archive(0),
+	m_cacheBytes(0),
+	m_cacheBudget(cacheBudget),
+	m_readBuf(MZ_ZIP_MAX_IO_BUF_SIZE),
+	m_lock(SDL_CreateMutex())
 {
 	mz_zip_archive *zip = static_cast<mz_zip_archive*>(std::calloc(1, sizeof(mz_zip_archive)));
 	FILE *file = fs.OpenReadStream(zipPath);
@@ -45,6 +54,7 @@ FileSourceZip::FileSourceZip(FileSourceFS &fs, const std::string &zipPath) : Fil
 
 FileSourceZip::~FileSourceZip()
 {
+	SDL_DestroyMutex(m_lock);
 	if (!m_archive) return;
 	mz_zip_archive *zip = static_cast<mz_zip_archive*>(m_archive);
 	mz_zip_reader_end(zip);
@@ -110,7 +120,6 @@ FileInfo FileSourceZip::Lookup(const std::string &path)
 RefCountedPtr<FileData> FileSourceZip::ReadFile(const std::string &path)
 {
 	if (!m_archive) return RefCountedPtr<FileData>();
-	mz_zip_archive *zip = static_cast<mz_zip_archive*>(m_archive);
 
 	const Directory *dir;
 	std::string filename;
@@ -123,15 +132,63 @@ RefCountedPtr<FileData> FileSourceZip::ReadFile(const std::string &path)
 
 	const FileStat &st = (*i).second;
 
+	SDL_LockMutex(m_lock);
+
+	// FileData is never written to, so the cached one can be handed out
+	// as it is
+	std::map<Uint32,CacheEntry>::iterator cached = m_cache.find(st.index);
+	if (cached != m_cache.end()) {
+		m_lru.splice(m_lru.begin(), m_lru, (*cached).second.lru);
+		RefCountedPtr<FileData> data = (*cached).second.data;
+		SDL_UnlockMutex(m_lock);
+		return data;
+	}
+
+	RefCountedPtr<FileData> data = Extract(st, path);
+	if (data && st.size <= m_cacheBudget / MAX_CACHED_FRACTION)
+		CacheFile(st.index, data);
+
+	SDL_UnlockMutex(m_lock);
+	return data;
+}
+
+RefCountedPtr<FileData> FileSourceZip::Extract(const FileStat &st, const std::string &path)
+{
+	mz_zip_archive *zip = static_cast<mz_zip_archive*>(m_archive);
+
 	char *data = static_cast<char*>(std::malloc(st.size));
-	if (!mz_zip_reader_extract_to_mem(zip, st.index, data, st.size, 0)) {
+	if (!data && st.size) {
+		// XXX handling memory allocation failure gracefully is too hard right now
+		Output("FileSourceZip::ReadFile: failed when allocating buffer for '%s'\n", path.c_str());
+		abort();
+	}
+
+	// inflates straight into data, reading through m_readBuf
+	if (!mz_zip_reader_extract_to_mem_no_alloc(zip, st.index, data, st.size, 0, &m_readBuf[0], m_readBuf.size())) {
 		Output("FileSourceZip::ReadFile: couldn't extract '%s'\n", path.c_str());
+		std::free(data);
 		return RefCountedPtr<FileData>();
 	}
 
 	return RefCountedPtr<FileData>(new FileDataMalloc(st.info, st.size, data));
 }
 
+void FileSourceZip::CacheFile(Uint32 index, RefCountedPtr<FileData> data)
+{
+	while (!m_lru.empty() && m_cacheBytes + data->GetSize() > m_cacheBudget) {
+		std::map<Uint32,CacheEntry>::iterator oldest = m_cache.find(m_lru.back());
+		m_cacheBytes -= (*oldest).second.data->GetSize();
+		m_cache.erase(oldest);
+		m_lru.pop_back();
+	}
+
+	m_lru.push_front(index);
+	CacheEntry &entry = m_cache[index];
+	entry.data = data;
+	entry.lru = m_lru.begin();
+	m_cacheBytes += data->GetSize();
+}
+
 bool FileSourceZip::ReadDirectory(const std::string &path, std::vector<FileInfo> &output)
 {
 	const Directory *dir;
@@ -6,6 +6,8 @@
 
 #include "FileSystem.h"
 #include <SDL_stdinc.h>
+#include <SDL_mutex.h>
+#include <list>
 #include <map>
 #include <string>
 
@@ -14,8 +16,10 @@ namespace FileSystem {
 class FileSourceZip : public FileSource {
 public:
 	// for now this needs to be FileSourceFS rather than just FileSource,
-	// because we need a FILE* stream access to the .zip file
-	FileSourceZip(FileSourceFS &fs, const std::string &zipPath);
+	// because we need a FILE* stream access to the .zip file.
+	// up to cacheBudget bytes of extracted files are kept, so asking for
+	// the same file again doesn't inflate it again
+	FileSourceZip(FileSourceFS &fs, const std::string &zipPath, size_t cacheBudget = 32*1024*1024);
 	virtual ~FileSourceZip();
 
 	virtual FileInfo Lookup(const std::string &path);
@@ -41,6 +45,27 @@ private:
 
 	bool FindDirectoryAndFile(const std::string &path, const Directory* &dir, std::string &filename);
 	void AddFile(const std::string &path, const FileStat &fileStat);
+
+	RefCountedPtr<FileData> Extract(const FileStat &st, const std::string &path);
+	void CacheFile(Uint32 index, RefCountedPtr<FileData> data);
+
+	// extracted files by archive index, most recently used at the front
+	struct CacheEntry {
+		RefCountedPtr<FileData> data;
+		std::list<Uint32>::iterator lru;
+	};
+	std::map<Uint32,CacheEntry> m_cache;
+	std::list<Uint32> m_lru;
+	size_t m_cacheBytes;
+	const size_t m_cacheBudget;
+
+	// compressed data is read through this rather than a fresh buffer
+	// for each file
+	std::vector<char> m_readBuf;
+
+	// ReadFile gets called from jobs; the archive's FILE* and the cache
+	// are shared
+	SDL_mutex *m_lock;
 };
 
 }
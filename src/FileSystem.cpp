@@ -4,6 +4,7 @@
 #include "libs.h"
 #include "FileSystem.h"
 #include "StringRange.h"
+#include "utils.h"
 #include <cassert>
 #include <sstream>
 #include <algorithm>
@@ -121,12 +122,20 @@ namespace FileSystem {
 
 	void Init()
 	{
+		// nothing writes to these, and they're where the big assets are
+		dataFilesUser.SetMapFiles(true);
+		dataFilesApp.SetMapFiles(true);
+		dataFilesUser.EnableDirectoryIndex("dirindex-user.bin");
+		dataFilesApp.EnableDirectoryIndex("dirindex-app.bin");
+
 		gameDataFiles.AppendSource(&dataFilesUser);
 		gameDataFiles.AppendSource(&dataFilesApp);
 	}
 
 	void Uninit()
 	{
+		dataFilesUser.SaveDirectoryIndex();
+		dataFilesApp.SaveDirectoryIndex();
 	}
 
 	FileInfo::FileInfo(FileSource *source, const std::string &path, FileType type, Time::DateTime modTime):
@@ -155,6 +164,169 @@ namespace FileSystem {
 		return MakeFileInfo(path, fileType, Time::DateTime());
 	}
 
+	// directory index file: signature, then for each directory its path,
+	// modification time and entries (path, type, modification time).
+	// native byte order; it never leaves the machine it was written on
+	static const char DIR_INDEX_SIGNATURE[8] = { 'P', 'I', 'D', 'I', 'R', 'I', 'D', '1' };
+
+	static void put_u32(std::string &out, Uint32 v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+	static void put_time(std::string &out, const Time::DateTime &t)
+	{
+		const Sint64 us = (t - Time::DateTime()).GetTotalMicroseconds();
+		out.append(reinterpret_cast<const char*>(&us), sizeof(us));
+	}
+	static void put_string(std::string &out, const std::string &str)
+	{
+		put_u32(out, str.size());
+		out.append(str);
+	}
+
+	// reads from the index file, failing (for good) rather than running off the end
+	class DirIndexReader {
+	public:
+		DirIndexReader(const char *data, size_t size) : m_at(data), m_end(data + size), m_ok(true) {}
+		bool Ok() const { return m_ok; }
+		bool AtEnd() const { return m_at == m_end; }
+		Uint32 U32() { Uint32 v = 0; Bytes(&v, sizeof(v)); return v; }
+		Time::DateTime ModTime()
+		{
+			Sint64 us = 0;
+			Bytes(&us, sizeof(us));
+			return Time::DateTime() + Time::TimeDelta(us, Time::Microsecond);
+		}
+		std::string String()
+		{
+			const Uint32 size = U32();
+			if (!Need(size)) return std::string();
+			std::string str(m_at, size);
+			m_at += size;
+			return str;
+		}
+		void Bytes(void *out, size_t size)
+		{
+			if (!Need(size)) return;
+			memcpy(out, m_at, size);
+			m_at += size;
+		}
+		void Fail() { m_ok = false; }
+	private:
+		bool Need(size_t size)
+		{
+			if (m_ok && size_t(m_end - m_at) >= size) return true;
+			m_ok = false;
+			return false;
+		}
+		const char *m_at;
+		const char *m_end;
+		bool m_ok;
+	};
+
+	void FileSourceFS::EnableDirectoryIndex(const std::string &indexFile)
+	{
+		assert(!m_dirIndexLock);
+		m_dirIndexLock = SDL_CreateMutex();
+		m_dirIndexFile = indexFile;
+		if (!m_dirIndexFile.empty())
+			LoadDirectoryIndex();
+	}
+
+	bool FileSourceFS::FindIndexedDir(const std::string &path, const Time::DateTime &modTime, std::vector<FileInfo> &output)
+	{
+		SDL_LockMutex(m_dirIndexLock);
+		std::map<std::string,IndexedDir>::const_iterator it = m_dirIndex.find(path);
+		const bool found = (it != m_dirIndex.end() && (*it).second.modTime == modTime);
+		if (found)
+			output.insert(output.end(), (*it).second.entries.begin(), (*it).second.entries.end());
+		SDL_UnlockMutex(m_dirIndexLock);
+		return found;
+	}
+
+	void FileSourceFS::IndexDir(const std::string &path, const Time::DateTime &modTime, std::vector<FileInfo>::const_iterator begin, std::vector<FileInfo>::const_iterator end)
+	{
+		SDL_LockMutex(m_dirIndexLock);
+		IndexedDir &dir = m_dirIndex[path];
+		dir.modTime = modTime;
+		dir.entries.assign(begin, end);
+		m_dirIndexChanged = true;
+		SDL_UnlockMutex(m_dirIndexLock);
+	}
+
+	void FileSourceFS::LoadDirectoryIndex()
+	{
+		RefCountedPtr<FileData> data = userFiles.ReadFile(m_dirIndexFile);
+		if (!data) return;
+
+		DirIndexReader rd(data->GetData(), data->GetSize());
+		char signature[sizeof(DIR_INDEX_SIGNATURE)];
+		rd.Bytes(signature, sizeof(signature));
+		if (!rd.Ok() || memcmp(signature, DIR_INDEX_SIGNATURE, sizeof(signature)) != 0)
+			return;
+		// the same name could be used for a different data dir
+		if (rd.String() != GetRoot())
+			return;
+
+		std::map<std::string,IndexedDir> index;
+		const Uint32 numDirs = rd.U32();
+		for (Uint32 i = 0; i < numDirs && rd.Ok(); i++) {
+			IndexedDir &dir = index[rd.String()];
+			dir.modTime = rd.ModTime();
+			const Uint32 numEntries = rd.U32();
+			for (Uint32 j = 0; j < numEntries && rd.Ok(); j++) {
+				const std::string entryPath = rd.String();
+				const Uint32 type = rd.U32();
+				const Time::DateTime entryTime = rd.ModTime();
+				if (type > FileInfo::FT_SPECIAL) {
+					rd.Fail();
+					break;
+				}
+				dir.entries.push_back(MakeFileInfo(entryPath, FileInfo::FileType(type), entryTime));
+			}
+		}
+		if (!rd.Ok() || !rd.AtEnd()) {
+			Output("directory index '%s' is damaged, ignoring it\n", m_dirIndexFile.c_str());
+			return;
+		}
+
+		m_dirIndex.swap(index);
+	}
+
+	void FileSourceFS::SaveDirectoryIndex()
+	{
+		if (!m_dirIndexLock || m_dirIndexFile.empty()) return;
+
+		std::string out(DIR_INDEX_SIGNATURE, sizeof(DIR_INDEX_SIGNATURE));
+		SDL_LockMutex(m_dirIndexLock);
+		if (!m_dirIndexChanged) {
+			SDL_UnlockMutex(m_dirIndexLock);
+			return;
+		}
+		put_string(out, GetRoot());
+		put_u32(out, m_dirIndex.size());
+		for (std::map<std::string,IndexedDir>::const_iterator it = m_dirIndex.begin(); it != m_dirIndex.end(); ++it) {
+			put_string(out, (*it).first);
+			put_time(out, (*it).second.modTime);
+			put_u32(out, (*it).second.entries.size());
+			for (const FileInfo &info : (*it).second.entries) {
+				put_string(out, info.GetPath());
+				put_u32(out, info.GetType());
+				put_time(out, info.GetModificationTime());
+			}
+		}
+		m_dirIndexChanged = false;
+		SDL_UnlockMutex(m_dirIndexLock);
+
+		// write it aside and move it into place, so a reader never sees half of it
+		const std::string tmpPath = m_dirIndexFile + ".tmp";
+		FILE *f = userFiles.OpenWriteStream(tmpPath);
+		if (!f) {
+			Output("couldn't write directory index '%s'\n", m_dirIndexFile.c_str());
+			return;
+		}
+		const bool written = fwrite(out.data(), 1, out.size(), f) == out.size();
+		if (fclose(f) != 0 || !written || !userFiles.RenameFile(tmpPath, m_dirIndexFile))
+			Output("couldn't write directory index '%s'\n", m_dirIndexFile.c_str());
+	}
+
 	FileSourceUnion::FileSourceUnion(): FileSource(":union:") {}
 	FileSourceUnion::~FileSourceUnion() {}
 
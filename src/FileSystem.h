@@ -11,8 +11,11 @@
 #include <string>
 #include <vector>
 #include <deque>
+#include <map>
 #include <memory>
 
+struct SDL_mutex;
+
 /*
  * Functionality:
  *   - Overlay multiple file sources (directories and archives)
@@ -196,6 +199,49 @@ namespace FileSystem {
 		FILE* OpenReadStream(const std::string &path);
 		// similar to fopen(path, "wb")
 		FILE* OpenWriteStream(const std::string &path, int flags = 0);
+
+		// moves from over to, replacing to if it exists. readers see either
+		// the old file or the new one, never a partial write
+		bool RenameFile(const std::string &from, const std::string &to);
+
+		// large files are mapped rather than copied onto the heap. only for
+		// sources that nothing writes to while the game is running, since
+		// truncating a mapped file pulls it out from under the reader
+		void SetMapFiles(bool map) { m_mapFiles = map; }
+		bool GetMapFiles() const { return m_mapFiles; }
+
+		// keep directory listings, and reuse one for as long as the
+		// directory's modification time hasn't changed, so reading an
+		// unchanged directory costs one stat instead of one per entry.
+		// the modification times of the entries are as they were when the
+		// directory was read, so like SetMapFiles this is for sources whose
+		// files aren't edited in place. if indexFile is given (a path in
+		// userFiles) the index is loaded from it now and SaveDirectoryIndex
+		// writes it back, so the next run starts with it
+		void EnableDirectoryIndex(const std::string &indexFile = std::string());
+		void SaveDirectoryIndex();
+
+	private:
+		// below this, reading is as cheap as setting up the mapping
+		static const size_t MAP_MIN_SIZE = 64 * 1024;
+
+		bool m_mapFiles;
+
+		struct IndexedDir {
+			Time::DateTime modTime;
+			std::vector<FileInfo> entries;
+		};
+
+		// both called with the directory's current modification time.
+		// IndexDir is given the sorted listing
+		bool FindIndexedDir(const std::string &path, const Time::DateTime &modTime, std::vector<FileInfo> &output);
+		void IndexDir(const std::string &path, const Time::DateTime &modTime, std::vector<FileInfo>::const_iterator begin, std::vector<FileInfo>::const_iterator end);
+		void LoadDirectoryIndex();
+
+		std::map<std::string,IndexedDir> m_dirIndex;
+		std::string m_dirIndexFile;
+		bool m_dirIndexChanged;
+		SDL_mutex *m_dirIndexLock; // null unless the index is enabled
 	};
 
 	class FileSourceUnion : public FileSource {
@@ -0,0 +1,225 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _FLATHASHMAP_H
+#define _FLATHASHMAP_H
+
+#include <SDL_stdinc.h>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/*
+ * A hash map that keeps its entries in one array and probes linearly,
+ * instead of a node per entry like std::map and std::unordered_map. A
+ * lookup is usually one or two cache lines and inserting doesn't allocate
+ * until the table grows, so it suits maps that are read and written every
+ * frame.
+ *
+ * The interface is the part of std::unordered_map we use, with some
+ * differences:
+ *  - inserting may move every entry, so pointers and iterators into the
+ *    map go stale on insert. keep values that must stay put elsewhere
+ *  - erasing leaves a marker in the slot, so erase(it) is safe inside a loop
+ *    and only invalidates it, but markers are only cleared when the table
+ *    is rebuilt on a later insert
+ *  - erased and unused slots hold default constructed entries, so K and V
+ *    must be default constructible, and erasing assigns them back to that
+ *  - key and value are a std::pair<K,V>, don't change the key through it
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename Eq = std::equal_to<K>>
+class FlatHashMap {
+public:
+	typedef std::pair<K,V> value_type;
+
+private:
+	enum SlotState { EMPTY, FULL, ERASED };
+
+	struct Slot {
+		Slot() : state(EMPTY) {}
+		value_type kv;
+		Uint8 state;
+	};
+
+	template <typename SlotT, typename ValueT>
+	class Iterator : public std::iterator<std::forward_iterator_tag, ValueT> {
+	public:
+		Iterator() : m_slot(nullptr), m_end(nullptr) {}
+		Iterator(SlotT *slot, SlotT *end) : m_slot(slot), m_end(end) { Skip(); }
+		// iterator to const_iterator
+		template <typename S, typename T>
+		Iterator(const Iterator<S,T> &it) : m_slot(it.m_slot), m_end(it.m_end) {}
+
+		ValueT &operator*() const { return m_slot->kv; }
+		ValueT *operator->() const { return &m_slot->kv; }
+		Iterator &operator++() { ++m_slot; Skip(); return *this; }
+		Iterator operator++(int) { Iterator it(*this); ++*this; return it; }
+		bool operator==(const Iterator &b) const { return m_slot == b.m_slot; }
+		bool operator!=(const Iterator &b) const { return m_slot != b.m_slot; }
+
+	private:
+		friend class FlatHashMap;
+		template <typename S, typename T> friend class Iterator;
+
+		void Skip() { while (m_slot != m_end && m_slot->state != FULL) ++m_slot; }
+
+		SlotT *m_slot;
+		SlotT *m_end;
+	};
+
+public:
+	typedef Iterator<Slot, value_type> iterator;
+	typedef Iterator<const Slot, const value_type> const_iterator;
+
+	FlatHashMap() : m_size(0), m_used(0) {}
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	iterator begin() { return iterator(Slots(), Slots() + m_slots.size()); }
+	iterator end() { return iterator(Slots() + m_slots.size(), Slots() + m_slots.size()); }
+	const_iterator begin() const { return const_iterator(Slots(), Slots() + m_slots.size()); }
+	const_iterator end() const { return const_iterator(Slots() + m_slots.size(), Slots() + m_slots.size()); }
+
+	iterator find(const K &key) {
+		const size_t i = Find(key);
+		return i == NOT_FOUND ? end() : iterator(Slots() + i, Slots() + m_slots.size());
+	}
+	const_iterator find(const K &key) const {
+		const size_t i = Find(key);
+		return i == NOT_FOUND ? end() : const_iterator(Slots() + i, Slots() + m_slots.size());
+	}
+	size_t count(const K &key) const { return Find(key) != NOT_FOUND; }
+
+	V &operator[](const K &key) { return Insert(key).first->second; }
+
+	std::pair<iterator,bool> insert(const value_type &kv) {
+		std::pair<iterator,bool> r = Insert(kv.first);
+		if (r.second)
+			r.first->second = kv.second;
+		return r;
+	}
+
+	// returns the next entry, as std::unordered_map does
+	iterator erase(const_iterator it) {
+		Slot *slot = const_cast<Slot*>(it.m_slot);
+		assert(slot->state == FULL);
+		slot->state = ERASED;
+		slot->kv = value_type();
+		m_size--;
+		return iterator(slot, Slots() + m_slots.size());
+	}
+	size_t erase(const K &key) {
+		const size_t i = Find(key);
+		if (i == NOT_FOUND)
+			return 0;
+		erase(const_iterator(Slots() + i, Slots() + m_slots.size()));
+		return 1;
+	}
+
+	void clear() {
+		for (Slot &s : m_slots) {
+			if (s.state == FULL)
+				s.kv = value_type();
+			s.state = EMPTY;
+		}
+		m_size = m_used = 0;
+	}
+
+	// make room for this many entries without growing
+	void reserve(size_t n) {
+		size_t capacity = MIN_SLOTS;
+		while (capacity * MAX_LOAD_NUM < n * MAX_LOAD_DEN)
+			capacity *= 2;
+		if (capacity > m_slots.size())
+			Rebuild(capacity);
+	}
+
+private:
+	static const size_t NOT_FOUND = ~size_t(0);
+	static const size_t MIN_SLOTS = 16;
+	// full and erased slots together stay under three quarters
+	static const size_t MAX_LOAD_NUM = 3;
+	static const size_t MAX_LOAD_DEN = 4;
+
+	Slot *Slots() { return m_slots.empty() ? nullptr : &m_slots[0]; }
+	const Slot *Slots() const { return m_slots.empty() ? nullptr : &m_slots[0]; }
+
+	// std::hash of a pointer or an integer is often the value itself, whose
+	// low bits are all we look at, so stir the top bits down into them
+	size_t Bucket(const K &key) const {
+		size_t h = m_hash(key);
+		h ^= h >> 16;
+		h *= 0x45d9f3b;
+		h ^= h >> 16;
+		return h & (m_slots.size() - 1);
+	}
+
+	size_t Find(const K &key) const {
+		if (m_slots.empty())
+			return NOT_FOUND;
+		const size_t mask = m_slots.size() - 1;
+		for (size_t i = Bucket(key); ; i = (i + 1) & mask) {
+			const Slot &s = m_slots[i];
+			if (s.state == EMPTY)
+				return NOT_FOUND;
+			if (s.state == FULL && m_eq(s.kv.first, key))
+				return i;
+		}
+	}
+
+	std::pair<iterator,bool> Insert(const K &key) {
+		const size_t found = Find(key);
+		if (found != NOT_FOUND)
+			return std::make_pair(iterator(Slots() + found, Slots() + m_slots.size()), false);
+
+		if ((m_used + 1) * MAX_LOAD_DEN > m_slots.size() * MAX_LOAD_NUM) {
+			// mostly erased markers, rebuilding at the same size clears them
+			size_t capacity = m_slots.empty() ? size_t(MIN_SLOTS) : m_slots.size();
+			if ((m_size + 1) * MAX_LOAD_DEN * 2 > capacity * MAX_LOAD_NUM)
+				capacity *= 2;
+			Rebuild(capacity);
+		}
+
+		// the first erased slot along the way will do, since the key isn't there
+		const size_t mask = m_slots.size() - 1;
+		size_t i = Bucket(key);
+		while (m_slots[i].state == FULL)
+			i = (i + 1) & mask;
+		Slot &s = m_slots[i];
+		if (s.state == EMPTY)
+			m_used++;
+		s.state = FULL;
+		s.kv.first = key;
+		m_size++;
+		return std::make_pair(iterator(&s, Slots() + m_slots.size()), true);
+	}
+
+	void Rebuild(size_t capacity) {
+		assert((capacity & (capacity - 1)) == 0);
+		std::vector<Slot> old(capacity);
+		old.swap(m_slots);
+		m_used = m_size;
+		const size_t mask = capacity - 1;
+		for (Slot &o : old) {
+			if (o.state != FULL)
+				continue;
+			size_t i = Bucket(o.kv.first);
+			while (m_slots[i].state != EMPTY)
+				i = (i + 1) & mask;
+			m_slots[i].state = FULL;
+			m_slots[i].kv = std::move(o.kv);
+		}
+	}
+
+	std::vector<Slot> m_slots;
+	size_t m_size; // full slots
+	size_t m_used; // full and erased slots
+	Hash m_hash;
+	Eq m_eq;
+};
+
+#endif
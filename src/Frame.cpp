@@ -11,6 +11,7 @@
 #include "Game.h"
 #include "json/JsonUtils.h"
 #include <algorithm>
+#include <limits>
 
 Frame::Frame()
 {
@@ -60,7 +61,7 @@ Frame *Frame::FromJson(const Json::Value &jsonObj, Space *space, Frame *parent,
 	f->m_parent = parent;
 
 	if (!jsonObj.isMember("frame")) throw SavedGameCorruptException();
-	Json::Value frameObj = jsonObj["frame"];
+	const Json::Value &frameObj = jsonObj["frame"];
 
 	if (!frameObj.isMember("flags")) throw SavedGameCorruptException();
 	if (!frameObj.isMember("radius")) throw SavedGameCorruptException();
@@ -84,7 +85,7 @@ Frame *Frame::FromJson(const Json::Value &jsonObj, Space *space, Frame *parent,
 	f->m_vel = vector3d(0.0); // m_vel is set to zero.
 
 	if (!frameObj.isMember("child_frames")) throw SavedGameCorruptException();
-	Json::Value childFrameArray = frameObj["child_frames"];
+	const Json::Value &childFrameArray = frameObj["child_frames"];
 	if (!childFrameArray.isArray()) throw SavedGameCorruptException();
 	for (unsigned int i = 0; i < childFrameArray.size(); ++i) {
 		f->m_children.push_back(FromJson(childFrameArray[i], space, f, at_time));
@@ -114,6 +115,9 @@ void Frame::Init(Frame *parent, const char *label, unsigned int flags)
 	m_pos = vector3d(0.0);
 	m_vel = vector3d(0.0);
 	m_angSpeed = 0.0;
+	m_railsTime = std::numeric_limits<double>::quiet_NaN();
+	m_railsPos = vector3d(0.0);
+	m_railsAnomaly = std::numeric_limits<double>::quiet_NaN();
 	m_orient = matrix3x3d::Identity();
 	m_initialOrient = matrix3x3d::Identity();
 	ClearMovement();
@@ -202,6 +206,25 @@ matrix3x3d Frame::GetInterpOrientRelTo(const Frame *relTo) const
 */
 }
 
+vector3d Frame::GetPointRelTo(const Frame *relTo, const vector3d &pos) const
+{
+	if (this == relTo) return pos;
+	return GetDirectionRelTo(relTo, pos) + GetPositionRelTo(relTo);
+}
+
+vector3d Frame::GetDirectionRelTo(const Frame *relTo, const vector3d &dir) const
+{
+	if (this == relTo) return dir;
+	// out to root, then back in to relTo
+	return (m_rootOrient * dir) * relTo->m_rootOrient;
+}
+
+vector3d Frame::GetInterpPointRelTo(const Frame *relTo, const vector3d &pos) const
+{
+	if (this == relTo) return pos;
+	return (m_rootInterpOrient * pos) * relTo->m_rootInterpOrient + GetInterpPositionRelTo(relTo);
+}
+
 void Frame::UpdateInterpTransform(double alpha)
 {
 	PROFILE_SCOPED()
@@ -249,9 +272,14 @@ void Frame::UpdateOrbitRails(double time, double timestep)
 
 	// update frame position and velocity
 	if (m_parent && m_sbody && !IsRotFrame()) {
-		m_pos = m_sbody->GetOrbit().OrbitalPosAtTime(time);
-		vector3d pos2 = m_sbody->GetOrbit().OrbitalPosAtTime(time+timestep);
-		m_vel = (pos2 - m_pos) / timestep;
+		const Orbit &orbit = m_sbody->GetOrbit();
+		if (m_railsTime == time)
+			m_pos = m_railsPos;
+		else
+			m_pos = orbit.OrbitalPosAtTime(time, m_railsAnomaly);
+		m_railsTime = time+timestep;
+		m_railsPos = orbit.OrbitalPosAtTime(m_railsTime, m_railsAnomaly);
+		m_vel = (m_railsPos - m_pos) / timestep;
 	}
 	// temporary test thing
 	else m_pos = m_pos + m_vel * timestep;
@@ -90,6 +90,13 @@ public:
 	vector3d GetInterpPositionRelTo(const Frame *relTo) const;
 	matrix3x3d GetInterpOrientRelTo(const Frame *relTo) const;
 
+	// a point or direction given in this frame, in relTo. the same as going
+	// through GetOrientRelTo and GetPositionRelTo, but without building the
+	// combined orient for the sake of one vector
+	vector3d GetPointRelTo(const Frame *relTo, const vector3d &pos) const;
+	vector3d GetDirectionRelTo(const Frame *relTo, const vector3d &dir) const;
+	vector3d GetInterpPointRelTo(const Frame *relTo, const vector3d &pos) const;
+
 	static void GetFrameTransform(const Frame *fFrom, const Frame *fTo, matrix4x4d &m);
 
 	Sfx *m_sfx;			// the last survivor. actually m_children is pretty grim too.
@@ -112,6 +119,11 @@ private:
 	vector3d m_vel; // note we don't use this to move frame. rather,
 			// orbital rails determine velocity.
 	double m_angSpeed; // this however *is* directly applied (for rotating frames)
+	// the far end of the last orbit rails step, which is usually where the
+	// next one starts. m_railsTime is NaN before the first
+	double m_railsTime;
+	vector3d m_railsPos;
+	double m_railsAnomaly; // Orbit solver state, NaN if there isn't any
 	double m_oldAngDisplacement;
 	std::string m_label;
 	double m_radius;
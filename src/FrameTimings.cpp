@@ -0,0 +1,157 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "FrameTimings.h"
+#include "utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+static const char *s_phaseNames[FrameTimings::PHASE_MAX] = {
+	"physics", "lua", "render", "ui", "jobs", "swap", "other"
+};
+
+FrameTimings::FrameTimings(Uint32 numFrames, double hitchSeconds) :
+	m_frames(std::max(numFrames, 1U)),
+	m_next(0),
+	m_count(0),
+	m_frameIndex(0),
+	m_numHitches(0),
+	m_hitchSeconds(hitchSeconds),
+	m_frameStart(0),
+	m_lapStart(0)
+{
+	memset(&m_current, 0, sizeof(m_current));
+}
+
+//static
+const char *FrameTimings::GetPhaseName(Phase phase)
+{
+	assert(phase < PHASE_MAX);
+	return s_phaseNames[phase];
+}
+
+void FrameTimings::BeginFrame()
+{
+	memset(&m_current, 0, sizeof(m_current));
+	m_current.index = m_frameIndex++;
+	m_frameStart = m_lapStart = SDL_GetPerformanceCounter();
+}
+
+void FrameTimings::Lap(Phase phase)
+{
+	const Uint64 now = SDL_GetPerformanceCounter();
+	m_current.phases[phase] += float(double(now - m_lapStart) / double(SDL_GetPerformanceFrequency()));
+	m_lapStart = now;
+}
+
+void FrameTimings::Move(Phase from, Phase to, double seconds)
+{
+	if (seconds <= 0.0)
+		return;
+	const float t = std::min(float(seconds), m_current.phases[from]);
+	m_current.phases[from] -= t;
+	m_current.phases[to] += t;
+}
+
+bool FrameTimings::EndFrame()
+{
+	Lap(PHASE_OTHER);
+	m_current.total = float(double(m_lapStart - m_frameStart) / double(SDL_GetPerformanceFrequency()));
+
+	m_frames[m_next] = m_current;
+	m_next = (m_next + 1) % m_frames.size();
+	m_count = std::min<Uint32>(m_count + 1, m_frames.size());
+
+	// the first frames load everything they see, no point reporting them
+	if (m_hitchSeconds <= 0.0 || m_current.total < m_hitchSeconds || m_current.index < 2)
+		return false;
+	m_numHitches++;
+	LogHitch(m_current);
+	return true;
+}
+
+double FrameTimings::GetLastTotal() const
+{
+	return m_count ? m_frames[(m_next + m_frames.size() - 1) % m_frames.size()].total : 0.0;
+}
+
+double FrameTimings::GetLastPhase(Phase phase) const
+{
+	return m_count ? m_frames[(m_next + m_frames.size() - 1) % m_frames.size()].phases[phase] : 0.0;
+}
+
+void FrameTimings::LogHitch(const Frame &f) const
+{
+	char buf[256];
+	int len = snprintf(buf, sizeof(buf), "hitch: frame %u took %.1f ms (", f.index, f.total * 1e3);
+	for (int i = 0; i < PHASE_MAX && len < int(sizeof(buf)); i++)
+		len += snprintf(buf + len, sizeof(buf) - len, "%s%s %.1f", i ? ", " : "", s_phaseNames[i], f.phases[i] * 1e3);
+	Output("%s), %u phys ticks, %u/%u jobs deferred\n", buf, f.physTicks, f.asyncDeferred, f.syncDeferred);
+}
+
+static float Percentile(const std::vector<float> &sorted, double p)
+{
+	const size_t i = std::min(size_t(p * double(sorted.size())), sorted.size() - 1);
+	return sorted[i];
+}
+
+std::string FrameTimings::DumpPercentiles() const
+{
+	if (!m_count)
+		return "no frames timed\n";
+
+	std::string out;
+	char buf[128];
+	snprintf(buf, sizeof(buf), "%u frames timed; %u hitches (over %.0f ms) since startup\n", m_count, m_numHitches, m_hitchSeconds * 1e3);
+	out += buf;
+	snprintf(buf, sizeof(buf), "%-10s %8s %8s %8s %8s %8s\n", "ms", "mean", "p50", "p95", "p99", "max");
+	out += buf;
+
+	std::vector<float> times(m_count);
+	for (int phase = -1; phase < PHASE_MAX; phase++) {
+		double sum = 0.0;
+		for (Uint32 i = 0; i < m_count; i++) {
+			times[i] = phase < 0 ? m_frames[i].total : m_frames[i].phases[phase];
+			sum += times[i];
+		}
+		std::sort(times.begin(), times.end());
+		snprintf(buf, sizeof(buf), "%-10s %8.2f %8.2f %8.2f %8.2f %8.2f\n", phase < 0 ? "frame" : s_phaseNames[phase],
+			sum * 1e3 / double(m_count), Percentile(times, 0.5) * 1e3, Percentile(times, 0.95) * 1e3,
+			Percentile(times, 0.99) * 1e3, times.back() * 1e3);
+		out += buf;
+	}
+	return out;
+}
+
+bool FrameTimings::WriteCSV(const std::string &filename) const
+{
+	FILE *f = fopen(filename.c_str(), "w");
+	if (!f) {
+		Output("could not open \"%s\" for writing: %s\n", filename.c_str(), strerror(errno));
+		return false;
+	}
+
+	fputs("frame,total", f);
+	for (int i = 0; i < PHASE_MAX; i++)
+		fprintf(f, ",%s", s_phaseNames[i]);
+	fputs(",phys_ticks,async_deferred,sync_deferred\n", f);
+
+	// oldest first
+	const Uint32 first = m_count < m_frames.size() ? 0 : m_next;
+	for (Uint32 n = 0; n < m_count; n++) {
+		const Frame &fr = m_frames[(first + n) % m_frames.size()];
+		fprintf(f, "%u,%.3f", fr.index, fr.total * 1e3);
+		for (int i = 0; i < PHASE_MAX; i++)
+			fprintf(f, ",%.3f", fr.phases[i] * 1e3);
+		fprintf(f, ",%u,%u,%u\n", fr.physTicks, fr.asyncDeferred, fr.syncDeferred);
+	}
+	return fclose(f) == 0;
+}
+
+void FrameTimings::Clear()
+{
+	m_next = 0;
+	m_count = 0;
+}
@@ -0,0 +1,86 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _FRAMETIMINGS_H
+#define _FRAMETIMINGS_H
+
+#include "libs.h"
+#include <string>
+#include <vector>
+
+/*
+ * Wall clock time spent in each phase of the main loop, kept for the last
+ * few hundred frames. Cheap enough to leave on in release builds: a couple
+ * of performance counter reads per phase and no allocation once running.
+ *
+ * Frames slower than the hitch threshold are logged as they happen, with
+ * their phase breakdown, so a player's log says where the time went.
+ */
+class FrameTimings {
+public:
+	enum Phase {
+		PHASE_PHYSICS, // Space::TimeStep, less the Lua events and timers run from it
+		PHASE_LUA,     // events, timers, async callbacks and garbage collection
+		PHASE_RENDER,  // interpolation, view update and Draw3D
+		PHASE_UI,      // Gui and UI update and draw
+		PHASE_JOBS,    // finishing completed jobs
+		PHASE_SWAP,    // presenting the frame, usually waiting on the gpu
+		PHASE_OTHER,   // events, sound, everything else
+		PHASE_MAX
+	};
+
+	FrameTimings(Uint32 numFrames, double hitchSeconds);
+
+	void BeginFrame();
+	// time since the last lap (or BeginFrame) goes to phase
+	void Lap(Phase phase);
+	// move time already counted in one phase to another, eg the Lua run from
+	// inside the physics step
+	void Move(Phase from, Phase to, double seconds);
+	// counters for the hitch log, for the frame in progress
+	void SetPhysicsTicks(Uint32 ticks) { m_current.physTicks = ticks; }
+	void SetDeferredJobs(Uint32 async, Uint32 sync) { m_current.asyncDeferred = async; m_current.syncDeferred = sync; }
+	// records the frame. hitches are logged and return true, so the caller
+	// can add what else it knows
+	bool EndFrame();
+
+	void SetHitchThreshold(double seconds) { m_hitchSeconds = seconds; }
+	double GetHitchThreshold() const { return m_hitchSeconds; }
+	Uint32 GetNumFrames() const { return m_count; }
+	// of the frame EndFrame last recorded, 0 before there is one
+	double GetLastTotal() const;
+	double GetLastPhase(Phase phase) const;
+	Uint32 GetNumHitches() const { return m_numHitches; }
+
+	// p50/p95/p99 and max of the frame and each phase over the buffer
+	std::string DumpPercentiles() const;
+	// one line per buffered frame, oldest first, times in milliseconds
+	bool WriteCSV(const std::string &filename) const;
+	void Clear();
+
+	static const char *GetPhaseName(Phase phase);
+
+private:
+	struct Frame {
+		Uint32 index;
+		float total;
+		float phases[PHASE_MAX];
+		Uint32 physTicks;
+		Uint32 asyncDeferred;
+		Uint32 syncDeferred;
+	};
+
+	void LogHitch(const Frame &f) const;
+
+	std::vector<Frame> m_frames;
+	Uint32 m_next;
+	Uint32 m_count;
+	Uint32 m_frameIndex;
+	Uint32 m_numHitches;
+	double m_hitchSeconds;
+	Frame m_current;
+	Uint64 m_frameStart;
+	Uint64 m_lapStart;
+};
+
+#endif
@@ -23,14 +23,121 @@
 #include "LuaRef.h"
 #include "ObjectViewerView.h"
 #include "FileSystem.h"
+#include "JobQueue.h"
+#include "Lang.h"
+#include "SaveGameFile.h"
+#include "StringF.h"
+#include "ModelCache.h"
+#include "ShipType.h"
+#include "SpaceStationType.h"
 #include "graphics/Renderer.h"
 #include "ui/Context.h"
 #include "galaxy/GalaxyGenerator.h"
 
-static const int  s_saveVersion   = 81;
+static const int  s_saveVersion   = 84;
 static const char s_saveStart[]   = "PIONEER";
 static const char s_saveEnd[]     = "END";
 
+namespace {
+
+// formats and writes a snapshot taken on the main thread. saves run one after
+// another, so a later save of the same file always lands last
+class SaveGameJob : public Job {
+public:
+	enum Result { SAVE_OK, SAVE_COULD_NOT_OPEN, SAVE_COULD_NOT_WRITE };
+
+	enum Format { FORMAT_BINARY, FORMAT_COMPRESSED, FORMAT_JSON };
+
+	SaveGameJob(const std::string &filename, Json::Value &rootNode, Json::Value &summary, Format format) : m_filename(filename), m_format(format), m_result(SAVE_OK) {
+		SetLane(LANE_IO);
+		m_rootNode.swap(rootNode);
+		m_summary.swap(summary);
+	}
+
+	virtual void OnRun();
+	virtual void OnFinish();
+	virtual const char *GetName() const { return "SaveGameJob"; }
+
+private:
+	std::string m_filename;
+	Json::Value m_rootNode;
+	Json::Value m_summary;
+	Format m_format;
+	Result m_result;
+};
+
+std::unique_ptr<JobSet> s_saveJobs;
+SaveGameJob *s_lastSaveJob = nullptr; // still queued or running, or null
+std::atomic<Uint32> s_savesInFlight(0);
+// only touched by the save jobs, which never overlap
+SaveGameFile::ChunkCache s_saveChunks;
+
+void SaveGameJob::OnRun()
+{
+	std::string data;
+	if (m_format == FORMAT_JSON) {
+		Json::StyledWriter jsonWriter; // Create writer for writing the JSON data to string.
+		data = jsonWriter.write(m_rootNode); // Write the JSON data.
+	} else
+		data = SaveGameFile::Write(m_rootNode, m_summary, m_format == FORMAT_COMPRESSED, &s_saveChunks);
+	m_rootNode = Json::Value();
+
+	// write next to the old file and swap it in, so a crash or a full disk
+	// halfway through leaves the previous save intact
+	const std::string path = FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, m_filename);
+	const std::string tmpPath = path + ".tmp";
+
+	FILE *f = FileSystem::userFiles.OpenWriteStream(tmpPath);
+	if (!f)
+		m_result = SAVE_COULD_NOT_OPEN;
+	else {
+		const size_t nwritten = fwrite(data.data(), data.length(), 1, f);
+		const bool closed = fclose(f) == 0;
+		if (nwritten != 1 || !closed || !FileSystem::userFiles.RenameFile(tmpPath, path))
+			m_result = SAVE_COULD_NOT_WRITE;
+	}
+
+	--s_savesInFlight;
+}
+
+void SaveGameJob::OnFinish()
+{
+	if (s_lastSaveJob == this)
+		s_lastSaveJob = nullptr;
+
+	if (m_result == SAVE_OK)
+		return;
+
+	const std::string path = FileSystem::JoinPath(Pi::GetSaveDir(), m_filename);
+	const std::string message = (m_result == SAVE_COULD_NOT_OPEN) ?
+		stringf(Lang::COULD_NOT_OPEN_FILENAME, formatarg("path", path)) : std::string(Lang::GAME_SAVE_CANNOT_WRITE);
+	Output("%s\n", message.c_str());
+	if (Pi::game)
+		Pi::game->log->Add(message);
+}
+
+// what the load screen shows for a save
+void MakeSummary(Game *game, Json::Value &summary)
+{
+	Player *player = game->GetPlayer();
+
+	summary["time"] = game->GetTime();
+	summary["system"] = game->GetSpace()->GetStarSystem()->GetName();
+	if (player->GetDockedWith())
+		summary["location"] = player->GetDockedWith()->GetLabel();
+	else if (player->GetFrame())
+		summary["location"] = player->GetFrame()->GetLabel();
+
+	double money = 0.0;
+	player->Properties().Get("cash", money);
+	summary["money"] = money;
+
+	summary["ship_type"] = player->GetShipType()->name;
+	summary["ship_label"] = player->GetLabel();
+}
+
+}
+
 Game::Game(const SystemPath &path, double time) :
 	m_galaxy(GalaxyGenerator::Create()),
 	m_time(time),
@@ -80,6 +187,8 @@ Game::Game(const SystemPath &path, double time) :
 
 	CreateViews();
 
+	PreloadModels(path);
+
 	EmitPauseState(IsPaused());
 }
 
@@ -109,20 +218,20 @@ Game::~Game()
 	m_galaxy->FlushCaches();
 }
 
-Game::Game(const Json::Value &jsonObj) :
+Game::Game(Json::Value &jsonObj) :
 m_timeAccel(TIMEACCEL_PAUSED),
 m_requestedTimeAccel(TIMEACCEL_PAUSED),
 m_forceTimeAccel(false)
 {
 	// signature check
 	if (!jsonObj.isMember("signature")) throw SavedGameCorruptException();
-	Json::Value signature = jsonObj["signature"];
+	const Json::Value &signature = jsonObj["signature"];
 	if (signature.isString() && signature.asString().compare(s_saveStart) == 0) {}
 	else throw SavedGameCorruptException();
 
 	// version check
 	if (!jsonObj.isMember("version")) throw SavedGameCorruptException();
-	Json::Value version = jsonObj["version"];
+	const Json::Value &version = jsonObj["version"];
 	if (!version.isInt()) throw SavedGameCorruptException();
 	Output("savefile version: %d\n", version.asInt());
 	if (version.asInt() == s_saveVersion) {}
@@ -156,16 +265,18 @@ m_forceTimeAccel(false)
 	// space, all the bodies and things
 	if (!jsonObj.isMember("player")) throw SavedGameCorruptException();
 	m_space.reset(new Space(this, m_galaxy, jsonObj, m_time));
+	jsonObj.removeMember("space");
 	m_player.reset(static_cast<Player*>(m_space->GetBodyByIndex(jsonObj["player"].asUInt())));
 
 	assert(!m_player->IsDead()); // Pioneer does not support necromancy
 
 	// hyperspace clouds being brought over from the previous system
 	if (!jsonObj.isMember("hyperspace_clouds")) throw SavedGameCorruptException();
-	Json::Value hyperspaceCloudArray = jsonObj["hyperspace_clouds"];
+	const Json::Value &hyperspaceCloudArray = jsonObj["hyperspace_clouds"];
 	if (!hyperspaceCloudArray.isArray()) throw SavedGameCorruptException();
 	for (Uint32 i = 0; i < hyperspaceCloudArray.size(); i++)
 		m_hyperspaceClouds.push_back(static_cast<HyperspaceCloud*>(Body::FromJson(hyperspaceCloudArray[i], 0)));
+	jsonObj.removeMember("hyperspace_clouds");
 
 	// system political stuff
 	Polit::FromJson(jsonObj, m_galaxy);
@@ -175,12 +286,18 @@ m_forceTimeAccel(false)
 
 	// lua
 	Pi::luaSerializer->FromJson(jsonObj);
+	jsonObj.removeMember("lua_modules");
 
 	Pi::luaSerializer->UninitTableRefs();
 
+	if (IsHyperspace())
+		PrepareHyperspaceDest();
+	else
+		PreloadModels(m_space->GetStarSystem()->GetPath());
+
 	// signature check (don't really need this anymore)
 	if (!jsonObj.isMember("trailing_signature")) throw SavedGameCorruptException();
-	Json::Value trailingSignature = jsonObj["trailing_signature"];
+	const Json::Value &trailingSignature = jsonObj["trailing_signature"];
 	if (trailingSignature.isString() && trailingSignature.asString().compare(s_saveEnd) == 0) {}
 	else throw SavedGameCorruptException();
 
@@ -439,17 +556,63 @@ void Game::SwitchToHyperspace()
 	m_state = STATE_HYPERSPACE;
 	m_wantHyperspace = false;
 
+	PrepareHyperspaceDest();
+
 	Output("Started hyperspacing...\n");
 }
 
+void Game::PrepareHyperspaceDest()
+{
+	PROFILE_SCOPED()
+	// plenty of time to generate the system and load things while the jump
+	// animation plays. the cache runs star system jobs from the main loop a
+	// few at a time, so this spreads the work over the jump instead of
+	// doing it all in the frame we arrive
+	const SystemPath dest = m_hyperspaceDest.SystemOnly();
+	m_hyperspaceDestCache = m_galaxy->NewStarSystemSlaveCache();
+	m_hyperspaceDestCache->FillCache(StarSystemCache::PathVector(1, dest), [this, dest]() {
+		// might have arrived already, if the jump was short
+		if (m_state == STATE_HYPERSPACE)
+			PreloadModels(dest);
+	});
+}
+
+void Game::PreloadModels(const SystemPath &path)
+{
+	PROFILE_SCOPED()
+	if (!Pi::config->Int("ModelPreload"))
+		return;
+
+	std::vector<std::string> names;
+
+	// stations pick their type from their seed, so we know exactly which ones
+	RefCountedPtr<const StarSystem> sys = m_galaxy->GetStarSystem(path);
+	for (const SystemBody *sbody : sys->GetSpaceStations()) {
+		Random rand(sbody->GetSeed());
+		const bool ground = sbody->GetType() != SystemBody::TYPE_STARPORT_ORBITAL;
+		names.push_back(SpaceStationType::RandomStationType(rand, ground)->ModelName());
+	}
+
+	// ship spawning is up to the scripts, so any hull could turn up
+	for (const auto &it : ShipType::types) {
+		const ShipType &type = it.second;
+		if (type.tag == ShipType::TAG_SHIP || type.tag == ShipType::TAG_STATIC_SHIP)
+			names.push_back(type.modelName);
+	}
+
+	Pi::modelCache->Preload(names);
+}
+
 void Game::SwitchToNormalSpace()
 {
 	PROFILE_SCOPED()
 	// remove the player from hyperspace
 	m_space->RemoveBody(m_player.get());
 
-	// create a new space for the system
+	// create a new space for the system. the system itself should be
+	// waiting in the cache by now
 	m_space.reset(new Space(this, m_galaxy, m_hyperspaceDest, m_space.get()));
+	m_hyperspaceDestCache.Reset();
 
 	// put the player in it
 	m_player->SetFrame(m_space->GetRootFrame());
@@ -776,14 +939,25 @@ void Game::EmitPauseState(bool paused)
 Game *Game::LoadGame(const std::string &filename)
 {
 	Output("Game::LoadGame('%s')\n", filename.c_str());
+	WaitForSaves();
+	// nothing of the last game's saves is going to come up again
+	s_saveChunks.chunks.clear();
 	auto file = FileSystem::userFiles.ReadFile(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename));
 	if (!file) throw CouldNotOpenFileException();
 	Json::Value rootNode; // Create the root JSON value for receiving the game data.
-	Json::Reader jsonReader; // Create reader for parsing the JSON string.
-	jsonReader.parse(file->GetData(), rootNode); // Parse the JSON string.
+	const ByteRange data = file->AsByteRange();
+	if (SaveGameFile::IsBinary(data))
+		SaveGameFile::Read(data, rootNode);
+	else {
+		// parse straight from the file data rather than a std::string copy
+		// of it, and don't keep comments around
+		Json::Reader jsonReader;
+		jsonReader.parse(data.begin, data.end, rootNode, false);
+	}
+	// the tree is all that's needed from here on
+	file.Reset();
 	if (!rootNode.isObject()) throw SavedGameCorruptException();
 	return new Game(rootNode); // Decode the game data from JSON and create the game.
-	// file data is freed here
 }
 
 void Game::SaveGame(const std::string &filename, Game *game)
@@ -800,16 +974,47 @@ void Game::SaveGame(const std::string &filename, Game *game)
 		throw CouldNotOpenFileException();
 	}
 
+	// throws std::invalid_argument for names outside the save dir, before
+	// anything is queued
+	FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename);
+
 	Json::Value rootNode; // Create the root JSON value for receiving the game data.
 	game->ToJson(rootNode); // Encode the game data as JSON and give to the root value.
-	Json::StyledWriter jsonWriter; // Create writer for writing the JSON data to string.
-	const std::string jsonDataStr = jsonWriter.write(rootNode); // Write the JSON data.
 
-	FILE *f = FileSystem::userFiles.OpenWriteStream(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename));
-	if (!f) throw CouldNotOpenFileException();
+	Json::Value summary(Json::objectValue);
+	MakeSummary(game, summary);
+
+	if (!s_saveJobs)
+		s_saveJobs.reset(new JobSet(Pi::GetAsyncJobQueue()));
+
+	// plain json is for looking inside saves while debugging
+	SaveGameJob::Format format = SaveGameJob::FORMAT_COMPRESSED;
+	if (Pi::config->Int("JsonSaves"))
+		format = SaveGameJob::FORMAT_JSON;
+	else if (!Pi::config->Int("CompressSaves"))
+		format = SaveGameJob::FORMAT_BINARY;
 
-	size_t nwritten = fwrite(jsonDataStr.data(), jsonDataStr.length(), 1, f);
+	SaveGameJob *job = new SaveGameJob(filename, rootNode, summary, format);
+	++s_savesInFlight;
+	if (s_lastSaveJob)
+		s_saveJobs->OrderAfter(job, std::vector<Job*>(1, s_lastSaveJob));
+	else
+		s_saveJobs->Order(job);
+	s_lastSaveJob = job;
+}
+
+bool Game::ReadSaveSummary(const std::string &filename, Json::Value &summary)
+{
+	FILE *f = FileSystem::userFiles.OpenReadStream(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename));
+	if (!f)
+		return false;
+	const bool ok = SaveGameFile::ReadSummary(f, summary);
 	fclose(f);
+	return ok;
+}
 
-	if (nwritten != 1) throw CouldNotWriteToFileException();
+void Game::WaitForSaves()
+{
+	while (s_savesInFlight > 0)
+		SDL_Delay(1);
 }
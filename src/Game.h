@@ -45,13 +45,20 @@ public:
 	static Game *LoadGame(const std::string &filename);
 	// XXX game arg should be const, and this should probably be a member function
 	// (or LoadGame/SaveGame should be somewhere else entirely)
+	// SaveGame takes a snapshot of the game and returns, the file is written
+	// on a job runner. write errors are reported in the game log
 	static void SaveGame(const std::string &filename, Game *game);
+	// blocks until every save that has been started is on disk
+	static void WaitForSaves();
+	// the summary SaveGame put at the front of the file (game time, system,
+	// location, money, ship), without loading the rest. false if it has none
+	static bool ReadSaveSummary(const std::string &filename, Json::Value &summary);
 
 	// start docked in station referenced by path or nearby to body if it is no station
 	Game(const SystemPath &path, double time = 0.0);
 
-	// load game
-	Game(const Json::Value &jsonObj);
+	// load game. sections of the tree are released once they've been read
+	Game(Json::Value &jsonObj);
 
 	~Game();
 
@@ -158,6 +165,11 @@ private:
 	void SwitchToHyperspace();
 	void SwitchToNormalSpace();
 
+	// start loading the models likely to be needed in a system
+	void PreloadModels(const SystemPath &path);
+	// start generating the hyperspace destination, so it's ready on exit
+	void PrepareHyperspaceDest();
+
 	RefCountedPtr<Galaxy> m_galaxy;
 	std::unique_ptr<Views> m_gameViews;
 	std::unique_ptr<Space> m_space;
@@ -179,6 +191,9 @@ private:
 	double m_hyperspaceProgress;
 	double m_hyperspaceDuration;
 	double m_hyperspaceEndTime;
+	// keeps the destination system alive from when it's generated until
+	// the new space is built from it
+	RefCountedPtr<StarSystemCache::Slave> m_hyperspaceDestCache;
 
 	TimeAccel m_timeAccel;
 	TimeAccel m_requestedTimeAccel;
@@ -39,17 +39,64 @@ GameConfig::GameConfig(const std::map<std::string,std::string> &override_)
 	map["VSync"] = "0";
 	map["UseTextureCompression"] = "1";
 	map["WorkerThreads"] = "0";
+	map["TerrainWorkerThreads"] = "-1";
+	map["GalaxyWorkerThreads"] = "0";
+	map["IOWorkerThreads"] = "-1";
+	map["ParallelBodyUpdate"] = "0";
+	map["ParallelCollisions"] = "0";
+	map["BatchIntegration"] = "0";
+	map["SimulationLOD"] = "0";
+	map["GeoPatchCache"] = "0";
+	map["GasGiantCache"] = "1";
+	map["SectorStore"] = "1";
+	map["LuaBytecodeCache"] = "1";
+	map["SoundSampleCacheMB"] = "32";
+	map["SectorCacheBudgetMB"] = "64";
+	map["StarSystemCacheBudgetMB"] = "256";
+	map["TextureStreaming"] = "1";
+	map["TextureMaxSize"] = "0";
+	map["ModelTextureBudgetMB"] = "512";
+	map["DecalTextureBudgetMB"] = "32";
+	map["BillboardTextureBudgetMB"] = "32";
+	map["GeoPatchCompactVertices"] = "0";
+	map["GeoPatchPrefetch"] = "1";
+	map["GeoPatchUploadBudgetKB"] = "1024";
+	map["GeoSphereOcclusionCulling"] = "1";
+	map["GeoSphereKeepAliveBudgetMB"] = "128";
+	map["GeoSphereKeepAliveGpuBudgetMB"] = "64";
+	map["BodyOcclusionCulling"] = "1";
+	map["ModelBatching"] = "1";
+	map["ModelPreload"] = "1";
+	map["CompressSGM"] = "1";
+	map["AutoLodRatios"] = "0.3,0.1";
+	map["LuaGCBudgetMs"] = "1";
+	map["LuaApiCallCounts"] = "0";
+	map["FrameTimingFrames"] = "600";
+	map["FrameHitchMs"] = "50";
+	map["QualityGovernor"] = "0";
+	map["QualityGovernorFps"] = "60";
+	map["QualityGovernorMaxSteps"] = "4";
+	map["DynamicResolution"] = "0";
+	map["DynamicResolutionFps"] = "60";
+	map["DynamicResolutionMinScale"] = "0.5";
+	map["CompressSaves"] = "1";
+	map["JsonSaves"] = "0";
 	map["SpeedLines"] = "0";
 	map["EnableCockpit"] = "0";
 	map["HudTrails"] = "0";
 	map["EnableServerAgent"] = "0";
+	map["ServerAgentMaxRequests"] = "4";
+	map["ServerAgentTimeoutMs"] = "30000";
+	map["LazyCustomSystems"] = "1";
 
 #ifdef _WIN32
 	map["RedirectStdio"] = "1";
 #else
 	map["RedirectStdio"] = "0";
 #endif
+	map["ShaderCache"] = "1";
 	map["EnableGLDebug"] = "0";
+	map["FrameCaptureReplays"] = "100";
 
 	Load();
 
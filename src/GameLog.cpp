@@ -16,6 +16,7 @@ GameLog::GameLog(RefCountedPtr<Text::TextureFont> font, vector2f scrSize)
 : m_font(font)
 , m_screenSize(scrSize)
 , m_prevMessages(0)
+, m_prevAtlasGeneration(0)
 {
 	m_lineHeight = m_font->GetHeight();
 
@@ -77,7 +78,10 @@ void GameLog::DrawHudMessages(Graphics::Renderer *r)
 
 	// (re)build buffers
 	const size_t numMessages = m_messages.size();
-	const bool bRefresh = (numMessages != m_prevMessages);
+	// taken before populating, so that glyphs dropped in the middle of it
+	// get everything rebuilt next time
+	const Uint32 atlasGeneration = m_font->GetAtlasGeneration();
+	const bool bRefresh = (numMessages != m_prevMessages) || (m_prevAtlasGeneration != atlasGeneration);
 	// update message loop
 	float y = 0;
 	for (auto it = m_messages.rbegin(), itEnd = m_messages.rend(); it != itEnd; ++it) {
@@ -102,4 +106,5 @@ void GameLog::DrawHudMessages(Graphics::Renderer *r)
 		y -= m_lineHeight;
 	}
 	m_prevMessages = numMessages;
+	m_prevAtlasGeneration = atlasGeneration;
 }
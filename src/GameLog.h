@@ -32,6 +32,7 @@ private:
 	vector2f m_offset;
 	float m_lineHeight;
 	size_t m_prevMessages;
+	Uint32 m_prevAtlasGeneration;
 };
 
 #endif
@@ -3,6 +3,8 @@
 
 #include "libs.h"
 #include "GasGiant.h"
+#include "AtmosphereLUT.h"
+#include "GasGiantCache.h"
 #include "perlin.h"
 #include "Pi.h"
 #include "Game.h"
@@ -22,6 +24,7 @@ RefCountedPtr<GasPatchContext> GasGiant::s_patchContext;
 namespace
 {
 	static const float s_initialDelayTime = 60.0f; // (perhaps) 60 seconds seems like a reasonable default
+	static const Uint32 s_textureJobDeadline = 5000; // milliseconds before the full texture jobs stop yielding to terrain
 	static std::vector<GasGiant*> s_allGasGiants;
 
 	// generate root face patches of the cube/sphere
@@ -47,7 +50,13 @@ namespace
 		void OnRun()
 		{
 			assert( corners != nullptr );
+			if (GasGiantCache::Load(sysPath, pTerrain.Get(), face, UVDims(), colors))
+				return;
+
 			double fracStep = 1.0 / double(UVDims()-1);
+			// a row at a time, so the terrain can batch its noise
+			std::vector<vector3d> rowPoints(UVDims()), rowColors(UVDims());
+			const std::vector<double> rowHeights(UVDims(), 0.0);
 			for( Sint32 v=0; v<UVDims(); v++ ) {
 				for( Sint32 u=0; u<UVDims(); u++ ) {
 					// where in this row & colum are we now.
@@ -55,9 +64,13 @@ namespace
 					const double vstep = double(v) * fracStep;
 
 					// get point on the surface of the sphere
-					const vector3d p = GetSpherePoint(ustep, vstep);
-					// get colour using `p`
-					const vector3d colour = pTerrain->GetColor(p, 0.0, p);
+					rowPoints[u] = GetSpherePoint(ustep, vstep);
+				}
+				// get colour using the points, which are also the normals
+				pTerrain->GetColors(&rowPoints[0], &rowHeights[0], &rowPoints[0], &rowColors[0], UVDims());
+
+				for( Sint32 u=0; u<UVDims(); u++ ) {
+					const vector3d &colour = rowColors[u];
 
 					// convert to ubyte and store
 					Color* col = colors + (u + (v * UVDims()));
@@ -67,6 +80,7 @@ namespace
 					col[0].a = 255;
 				}
 			}
+			GasGiantCache::Save(sysPath, pTerrain.Get(), face, UVDims(), colors);
 		}
 
 		Sint32 Face() const { return face; }
@@ -132,7 +146,7 @@ namespace
 	class SingleTextureFaceJob : public Job
 	{
 	public:
-		SingleTextureFaceJob(STextureFaceRequest *data) : mData(data), mpResults(nullptr) { /* empty */ }
+		SingleTextureFaceJob(STextureFaceRequest *data) : mData(data), mpResults(nullptr) { SetLane(LANE_TERRAIN); }
 		virtual ~SingleTextureFaceJob()
 		{
 			if(mpResults) {
@@ -159,6 +173,7 @@ namespace
 			mpResults = nullptr;
 		}
 		virtual void OnCancel() {}
+		virtual const char *GetName() const { return "SingleTextureFaceJob"; }
 
 	private:
 		// deliberately prevent copy constructor access
@@ -377,6 +392,12 @@ GasGiant::~GasGiant()
 	s_allGasGiants.erase(std::find(s_allGasGiants.begin(), s_allGasGiants.end(), this));
 }
 
+//static
+void GasGiant::Init()
+{
+	GasGiantCache::Init();
+}
+
 //static
 bool GasGiant::OnAddTextureFaceResult(const SystemPath &path, STextureFaceResult *res)
 {
@@ -484,6 +505,9 @@ void GasGiant::GenerateTexture()
 
 		Graphics::TextureCubeData tcd;
 		std::unique_ptr<Color> bufs[NUM_PATCHES];
+		// a row at a time, so the terrain can batch its noise
+		vector3d rowPoints[UV_DIMS_SMALL], rowColors[UV_DIMS_SMALL];
+		double rowHeights[UV_DIMS_SMALL] = {};
 		for(int i=0; i<NUM_PATCHES; i++) {
 			Color *colors = new Color[ (UV_DIMS_SMALL*UV_DIMS_SMALL) ];
 			for( Uint32 v=0; v<UV_DIMS_SMALL; v++ ) {
@@ -493,9 +517,13 @@ void GasGiant::GenerateTexture()
 					const double vstep = double(v) * fracStep;
 
 					// get point on the surface of the sphere
-					const vector3d p = GetSpherePointFromCorners(ustep, vstep, &s_patchFaces[i][0]);
-					// get colour using `p`
-					const vector3d colour = pTerrain->GetColor(p, 0.0, p);
+					rowPoints[u] = GetSpherePointFromCorners(ustep, vstep, &s_patchFaces[i][0]);
+				}
+				// get colour using the points, which are also the normals
+				pTerrain->GetColors(rowPoints, rowHeights, rowPoints, rowColors, UV_DIMS_SMALL);
+
+				for( Uint32 u=0; u<UV_DIMS_SMALL; u++ ) {
+					const vector3d &colour = rowColors[u];
 
 					// convert to ubyte and store
 					Color* col = colors + (u + (v * UV_DIMS_SMALL));
@@ -524,7 +552,11 @@ void GasGiant::GenerateTexture()
 		assert(!m_job[i].HasJob());
 		m_hasJobRequest[i] = true;
 		STextureFaceRequest *ssrd = new STextureFaceRequest(&s_patchFaces[i][0], GetSystemBody()->GetPath(), i, UV_DIMS, GetTerrain());
-		m_job[i] = Pi::GetAsyncJobQueue()->Queue(new SingleTextureFaceJob(ssrd));
+		// the small texture covers us in the meantime, so this can wait a little
+		SingleTextureFaceJob *job = new SingleTextureFaceJob(ssrd);
+		job->SetPriority(Job::PRIORITY_LOW);
+		job->SetDeadline(s_textureJobDeadline);
+		m_job[i] = Pi::GetAsyncJobQueue()->Queue(job);
 	}
 }
 
@@ -587,6 +619,8 @@ void GasGiant::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView,
 		m_materialParameters.atmosphere.scale = scale;
 
 		m_materialParameters.shadows = shadows;
+		m_materialParameters.opticalDepth = m_materialParameters.atmosphere.atmosDensity > 0.0 ?
+			AtmosphereLUT::Get(renderer, m_materialParameters.atmosphere) : nullptr;
 
 		m_surfaceMaterial->specialParameter0 = &m_materialParameters;
 
@@ -596,6 +630,7 @@ void GasGiant::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView,
 			// make atmosphere sphere slightly bigger than required so
 			// that the edges of the pixel shader atmosphere jizz doesn't
 			// show ugly polygonal angles
+			Graphics::Renderer::GpuTimerTicket gt(renderer, Graphics::Stats::GPU_TIMER_ATMOSPHERES);
 			DrawAtmosphereSurface(renderer, trans, campos, m_materialParameters.atmosphere.atmosRadius*1.01, m_atmosRenderState, m_atmosphereMaterial.get());
 		}
 	}
@@ -620,8 +655,11 @@ void GasGiant::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView,
 
 	renderer->SetTransform(modelView);
 
-	for (int i=0; i<NUM_PATCHES; i++) {
-		m_patches[i]->Render(renderer, campos, modelView, frustum);
+	{
+		Graphics::Renderer::GpuTimerTicket gt(renderer, Graphics::Stats::GPU_TIMER_TERRAIN);
+		for (int i=0; i<NUM_PATCHES; i++) {
+			m_patches[i]->Render(renderer, campos, modelView, frustum);
+		}
 	}
 
 	m_surfaceMaterial->Unapply();
@@ -42,6 +42,7 @@ public:
 	virtual void Reset() {};
 
 	static bool OnAddTextureFaceResult(const SystemPath &path, STextureFaceResult *res);
+	static void Init();
 	static void UpdateAllGasGiants();
 
 private:
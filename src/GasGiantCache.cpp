@@ -0,0 +1,114 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "libs.h"
+#include "GasGiantCache.h"
+#include "FileSystem.h"
+#include "Pi.h"
+#include "terrain/Terrain.h"
+#include "miniz/miniz.h"
+
+namespace {
+
+const char CACHE_DIR[] = "gasgiantcache";
+
+// bump this whenever the texture generation changes in a way the terrain
+// signature wouldn't notice
+const Uint32 CACHE_VERSION = 2;
+
+struct Header {
+	char magic[4];
+	Uint32 version;
+	Uint64 signature;
+	Uint32 face;
+	Uint32 uvDims;
+	Uint32 compressedSize;
+	Uint32 pad;
+};
+
+bool s_enabled = false;
+
+std::string GetCacheFileName(const SystemPath &path, Uint64 signature, int face, int uvDims)
+{
+	char buf[128];
+	snprintf(buf, sizeof(buf), "%d_%d_%d_%u_%u_%08x%08x_%d_%d.face",
+		path.sectorX, path.sectorY, path.sectorZ, path.systemIndex, path.bodyIndex,
+		Uint32(signature >> 32), Uint32(signature), face, uvDims);
+	return FileSystem::JoinPath(CACHE_DIR, buf);
+}
+
+Header MakeHeader(Uint64 signature, int face, int uvDims, Uint32 compressedSize)
+{
+	Header h;
+	memcpy(h.magic, "GGC1", 4);
+	h.version = CACHE_VERSION;
+	h.signature = signature;
+	h.face = face;
+	h.uvDims = uvDims;
+	h.compressedSize = compressedSize;
+	h.pad = 0;
+	return h;
+}
+
+}
+
+namespace GasGiantCache {
+
+void Init()
+{
+	s_enabled = Pi::config->Int("GasGiantCache") != 0;
+	if (s_enabled && !FileSystem::userFiles.MakeDirectory(CACHE_DIR)) {
+		Output("GasGiantCache: couldn't create cache directory, disabling\n");
+		s_enabled = false;
+	}
+}
+
+bool IsEnabled()
+{
+	return s_enabled;
+}
+
+bool Load(const SystemPath &path, const Terrain *terrain, int face, int uvDims, Color *colors)
+{
+	PROFILE_SCOPED()
+	if (!s_enabled) return false;
+
+	const Uint64 signature = terrain->GetSignature();
+	RefCountedPtr<FileSystem::FileData> fd = FileSystem::userFiles.ReadFile(GetCacheFileName(path, signature, face, uvDims));
+	if (!fd || fd->GetSize() < sizeof(Header)) return false;
+
+	const char *data = fd->GetData();
+	Header header;
+	memcpy(&header, data, sizeof(Header));
+	// a short file is one that didn't finish being written
+	if (fd->GetSize() != sizeof(Header) + header.compressedSize) return false;
+	const Header expected = MakeHeader(signature, face, uvDims, header.compressedSize);
+	if (memcmp(&header, &expected, sizeof(Header)) != 0) return false;
+
+	const size_t numBytes = size_t(uvDims) * size_t(uvDims) * sizeof(Color);
+	const size_t outSize = tinfl_decompress_mem_to_mem(colors, numBytes, data + sizeof(Header), header.compressedSize, 0);
+	return outSize == numBytes;
+}
+
+void Save(const SystemPath &path, const Terrain *terrain, int face, int uvDims, const Color *colors)
+{
+	PROFILE_SCOPED()
+	if (!s_enabled) return;
+
+	const size_t numBytes = size_t(uvDims) * size_t(uvDims) * sizeof(Color);
+	size_t compressedSize = 0;
+	void *compressed = tdefl_compress_mem_to_heap(colors, numBytes, &compressedSize, 128);
+	if (!compressed) return;
+
+	const Uint64 signature = terrain->GetSignature();
+	FILE *f = FileSystem::userFiles.OpenWriteStream(GetCacheFileName(path, signature, face, uvDims));
+	if (f) {
+		const Header header = MakeHeader(signature, face, uvDims, Uint32(compressedSize));
+		fwrite(&header, sizeof(Header), 1, f);
+		fwrite(compressed, compressedSize, 1, f);
+		fclose(f);
+	}
+	mz_free(compressed);
+}
+
+}
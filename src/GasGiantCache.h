@@ -0,0 +1,31 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GASGIANTCACHE_H
+#define _GASGIANTCACHE_H
+
+#include <SDL_stdinc.h>
+
+#include "Color.h"
+#include "galaxy/SystemPath.h"
+
+class Terrain;
+
+// on-disk cache of generated gas giant cube map faces, in the user dir.
+// faces are stored deflated and identified like GeoPatchCache entries, by
+// body, terrain signature, face and size. Load and Save are safe to call
+// from the texture jobs
+namespace GasGiantCache {
+	// call from the main thread before any texture jobs are queued
+	void Init();
+
+	bool IsEnabled();
+
+	// fill colors (uvDims*uvDims) from the cache. returns false, leaving
+	// them alone, if the face isn't there
+	bool Load(const SystemPath &path, const Terrain *terrain, int face, int uvDims, Color *colors);
+
+	void Save(const SystemPath &path, const Terrain *terrain, int face, int uvDims, const Color *colors);
+}
+
+#endif
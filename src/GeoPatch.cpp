@@ -5,6 +5,7 @@
 #include "GeoPatchContext.h"
 #include "GeoPatch.h"
 #include "GeoPatchJobs.h"
+#include "GeoPatchHorizon.h"
 #include "GeoSphere.h"
 #include "perlin.h"
 #include "Pi.h"
@@ -71,8 +72,17 @@ void GeoPatch::_UpdateVBOs(Graphics::Renderer *renderer)
 {
 	if (m_needUpdateVBOs) {
 		assert(renderer);
+		const size_t bytes = ctx->NUMVERTICES() * (ctx->UseCompactVertices() ? sizeof(GeoPatchContext::VBOVertexCompact) : sizeof(GeoPatchContext::VBOVertex));
+		// the root patches have nothing to stand in for them
+		if (parent && !GeoSphere::TakeUploadBudget(bytes))
+			return;
 		m_needUpdateVBOs = false;
 
+		if (ctx->UseCompactVertices()) {
+			_UpdateCompactVBOs(renderer);
+			return;
+		}
+
 		//create buffer and upload data
 		Graphics::VertexBufferDesc vbd;
 		vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
@@ -125,9 +135,94 @@ void GeoPatch::_UpdateVBOs(Graphics::Renderer *renderer)
 	}
 }
 
+static inline Sint16 ToSnorm16(const double v)
+{
+	return Sint16(Clamp(v, -1.0, 1.0) * 32767.0 + (v < 0.0 ? -0.5 : 0.5));
+}
+
+// octahedral normal encoding, decoded again in geosphere_terrain.vert
+static inline void EncodeNormal(const vector3f &n, Sint16 *out)
+{
+	const double invL1 = 1.0 / (fabs(n.x) + fabs(n.y) + fabs(n.z));
+	double x = n.x * invL1;
+	double y = n.y * invL1;
+	if (n.z < 0.0f) {
+		const double ox = x;
+		x = (1.0 - fabs(y)) * (ox >= 0.0 ? 1.0 : -1.0);
+		y = (1.0 - fabs(ox)) * (y >= 0.0 ? 1.0 : -1.0);
+	}
+	out[0] = ToSnorm16(x);
+	out[1] = ToSnorm16(y);
+}
+
+void GeoPatch::_UpdateCompactVBOs(Graphics::Renderer *renderer)
+{
+	Graphics::VertexBufferDesc vbd;
+	vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+	vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_SHORT4N;
+	vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
+	vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_SHORT2N;
+	vbd.attrib[2].semantic = Graphics::ATTRIB_DIFFUSE;
+	vbd.attrib[2].format   = Graphics::ATTRIB_FORMAT_UBYTE4;
+	vbd.numVertices = ctx->NUMVERTICES();
+	vbd.usage = Graphics::BUFFER_USAGE_STATIC;
+	m_vertexBuffer.reset(renderer->CreateVertexBuffer(vbd));
+
+	const Sint32 edgeLen = ctx->GetEdgeLen();
+	const double frac = ctx->GetFrac();
+
+	// positions are stored relative to clipCentroid in units of clipRadius, so
+	// the final radius must be known before anything can be quantised
+	const double *pHts = heights.get();
+	for (Sint32 y=0; y<edgeLen; y++) {
+		for (Sint32 x=0; x<edgeLen; x++) {
+			const vector3d p((GetSpherePoint(double(x)*frac, double(y)*frac) * (*pHts + 1.0)) - clipCentroid);
+			clipRadius = std::max(clipRadius, p.Length());
+			++pHts;
+		}
+	}
+	const double invRadius = (clipRadius > 0.0) ? 1.0 / clipRadius : 0.0;
+
+	GeoPatchContext::VBOVertexCompact* vtxPtr = m_vertexBuffer->Map<GeoPatchContext::VBOVertexCompact>(Graphics::BUFFER_MAP_WRITE);
+	assert(m_vertexBuffer->GetDesc().stride == sizeof(GeoPatchContext::VBOVertexCompact));
+
+	pHts = heights.get();
+	const vector3f *pNorm = normals.get();
+	const Color3ub *pColr = colors.get();
+	for (Sint32 y=0; y<edgeLen; y++) {
+		for (Sint32 x=0; x<edgeLen; x++) {
+			const vector3d p(((GetSpherePoint(double(x)*frac, double(y)*frac) * (*pHts + 1.0)) - clipCentroid) * invRadius);
+			vtxPtr->pos[0] = ToSnorm16(p.x);
+			vtxPtr->pos[1] = ToSnorm16(p.y);
+			vtxPtr->pos[2] = ToSnorm16(p.z);
+			vtxPtr->pos[3] = 32767; // w = 1.0
+			++pHts;
+
+			EncodeNormal(pNorm->Normalized(), vtxPtr->norm);
+			++pNorm;
+
+			vtxPtr->col[0] = pColr->r;
+			vtxPtr->col[1] = pColr->g;
+			vtxPtr->col[2] = pColr->b;
+			vtxPtr->col[3] = 255;
+			++pColr;
+
+			++vtxPtr;
+		}
+	}
+	m_vertexBuffer->Unmap();
+
+#ifdef DEBUG_BOUNDING_SPHERES
+	RefCountedPtr<Graphics::Material> mat(Pi::renderer->CreateMaterial(Graphics::MaterialDescriptor()));
+	// drawn with the patch transform, which already includes the clipRadius scale
+	m_boundsphere.reset( new Graphics::Drawables::Sphere3D(Pi::renderer, mat, Pi::renderer->CreateRenderState(Graphics::RenderStateDesc()), 0, 1.0f) );
+#endif
+}
+
 // the default sphere we do the horizon culling against
 static const SSphere s_sph;
-void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, const matrix4x4d &modelView, const Graphics::Frustum &frustum)
+void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, const matrix4x4d &modelView, const Graphics::Frustum &frustum,
+	const GeoPatchHorizon *horizon)
 {
 	// must update the VBOs to calculate the clipRadius...
 	_UpdateVBOs(renderer);
@@ -151,14 +246,31 @@ void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, cons
 		}
 	}
 
+	// hidden behind nearby terrain
+	if (horizon && horizon->IsOccluded(clipCentroid, clipRadius))
+		return;
+
 	if (kids[0]) {
-		for (int i=0; i<NUM_KIDS; i++) kids[i]->Render(renderer, campos, modelView, frustum);
-	} else if (heights) {
+		// until all the kids are uploaded this patch is drawn in their place
+		bool kidsReady = true;
+		for (int i=0; i<NUM_KIDS; i++) {
+			kids[i]->_UpdateVBOs(renderer);
+			kidsReady &= kids[i]->HasVBO();
+		}
+		if (kidsReady) {
+			for (int i=0; i<NUM_KIDS; i++) kids[i]->Render(renderer, campos, modelView, frustum, horizon);
+			return;
+		}
+	}
+	if (heights && m_vertexBuffer) {
 		Graphics::Material *mat = geosphere->GetSurfaceMaterial();
 		Graphics::RenderState *rs = geosphere->GetSurfRenderState();
 
 		const vector3d relpos = clipCentroid - campos;
-		renderer->SetTransform(modelView * matrix4x4d::Translation(relpos));
+		if (ctx->UseCompactVertices())
+			renderer->SetTransform(modelView * matrix4x4d::Translation(relpos) * matrix4x4d::ScaleMatrix(clipRadius));
+		else
+			renderer->SetTransform(modelView * matrix4x4d::Translation(relpos));
 
 		Pi::statSceneTris += (ctx->GetNumTris());
 		++Pi::statNumPatches;
@@ -175,11 +287,64 @@ void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, cons
 	}
 }
 
-void GeoPatch::LODUpdate(const vector3d &campos) 
+static inline double DistanceToSegment(const vector3d &p, const vector3d &a, const vector3d &b)
 {
+	const vector3d ab(b - a);
+	const double lenSqr = ab.LengthSqr();
+	const double t = (lenSqr > 0.0) ? Clamp((p - a).Dot(ab) / lenSqr, 0.0, 1.0) : 0.0;
+	return (p - (a + ab * t)).Length();
+}
+
+void GeoPatch::GatherLeaves(std::vector<GeoPatch*> &leaves)
+{
+	if (kids[0]) {
+		for (int i=0; i<NUM_KIDS; i++) kids[i]->GatherLeaves(leaves);
+	} else if (heights) {
+		leaves.push_back(this);
+	}
+}
+
+void GeoPatch::AddToHorizon(GeoPatchHorizon &horizon) const
+{
+	assert(heights);
+	// the outermost rows and columns get restitched to match coarser
+	// neighbours, so only the inner ones are reliably joined by mesh edges
+	const Sint32 edgeLen = ctx->GetEdgeLen();
+	const double frac = ctx->GetFrac();
+	const Sint32 lines[3] = { 1, edgeLen / 2, edgeLen - 2 };
+	const Sint32 count = std::min(edgeLen - 2, 256);
+	vector3d points[256];
+	for (int l = 0; l < 3; l++) {
+		const Sint32 y = lines[l];
+		for (Sint32 x = 1; x <= count; x++)
+			points[x-1] = GetSpherePoint(double(x)*frac, double(y)*frac) * (heights[y*edgeLen + x] + 1.0);
+		horizon.AddOccluder(points, count);
+
+		for (Sint32 x = 1; x <= count; x++)
+			points[x-1] = GetSpherePoint(double(y)*frac, double(x)*frac) * (heights[x*edgeLen + y] + 1.0);
+		horizon.AddOccluder(points, count);
+	}
+}
+
+void GeoPatch::LODUpdate(const vector3d &campos, const vector3d &pathEnd)
+{
+	const double splitLength = m_roughLength * GeoSphere::GetSplitDistanceScale();
+	const bool nearCamera = (campos - centroid).Length() < splitLength;
+	const bool nearPath = nearCamera || (DistanceToSegment(centroid, campos, pathEnd) < splitLength);
+
 	// there should be no LOD update when we have active split requests
-	if(mHasJobRequest)
+	// but the camera may have moved closer since the split was queued
+	if(mHasJobRequest) {
+		if (parent && !nearPath && m_job.HasJob()) {
+			// the camera, or the path it was on, has moved away before the
+			// split was run so it's no longer wanted
+			m_job = Job::Handle();
+			mHasJobRequest = false;
+		} else {
+			m_job.SetPriority(nearCamera ? GetSplitPriority(campos) : Job::PRIORITY_LOW);
+		}
 		return;
+	}
 
 	bool canSplit = true;
 	bool canMerge = bool(kids[0]);
@@ -195,9 +360,7 @@ void GeoPatch::LODUpdate(const vector3d &campos)
 				break;
 			}
 		}
-		const float centroidDist = (campos - centroid).Length();
-		const bool errorSplit = (centroidDist < m_roughLength);
-		if( !(canSplit && (m_depth < std::min(GEOPATCH_MAX_DEPTH, geosphere->GetMaxDepth())) && errorSplit) ) {
+		if( !(canSplit && (m_depth < std::min(GEOPATCH_MAX_DEPTH, geosphere->GetMaxDepth())) && nearPath) ) {
 			canSplit = false;
 		}
 	}
@@ -211,10 +374,12 @@ void GeoPatch::LODUpdate(const vector3d &campos)
 			SQuadSplitRequest *ssrd = new SQuadSplitRequest(v0, v1, v2, v3, centroid.Normalized(), m_depth,
 						geosphere->GetSystemBody()->GetPath(), mPatchID, ctx->GetEdgeLen(),
 						ctx->GetFrac(), geosphere->GetTerrain());
-			m_job = Pi::GetAsyncJobQueue()->Queue(new QuadPatchJob(ssrd));
+			QuadPatchJob *job = new QuadPatchJob(ssrd);
+			job->SetPriority((nearCamera || !parent) ? GetSplitPriority(campos) : Job::PRIORITY_LOW);
+			m_job = Pi::GetAsyncJobQueue()->Queue(job);
 		} else {
 			for (int i=0; i<NUM_KIDS; i++) {
-				kids[i]->LODUpdate(campos);
+				kids[i]->LODUpdate(campos, pathEnd);
 			}
 		}
 	} else if (canMerge) {
@@ -237,7 +402,35 @@ void GeoPatch::RequestSinglePatch()
 		mHasJobRequest = true;
 		SSingleSplitRequest *ssrd = new SSingleSplitRequest(v0, v1, v2, v3, centroid.Normalized(), m_depth,
 					geosphere->GetSystemBody()->GetPath(), mPatchID, ctx->GetEdgeLen(), ctx->GetFrac(), geosphere->GetTerrain());
-		m_job = Pi::GetAsyncJobQueue()->Queue(new SinglePatchJob(ssrd));
+		// the root patches have to arrive before anything can be drawn
+		SinglePatchJob *job = new SinglePatchJob(ssrd);
+		job->SetPriority(Job::PRIORITY_HIGH);
+		m_job = Pi::GetAsyncJobQueue()->Queue(job);
+	}
+}
+
+void GeoPatch::CancelJobs()
+{
+	if (mHasJobRequest) {
+		m_job = Job::Handle();
+		mHasJobRequest = false;
+	}
+	for (int i=0; i<NUM_KIDS; i++) {
+		if (kids[i])
+			kids[i]->CancelJobs();
+	}
+}
+
+void GeoPatch::GetMemoryUsage(size_t &cpuBytes, size_t &gpuBytes) const
+{
+	const size_t numVerts = ctx->NUMVERTICES();
+	if (heights)
+		cpuBytes += numVerts * (sizeof(double) + sizeof(vector3f) + sizeof(Color3ub));
+	if (m_vertexBuffer)
+		gpuBytes += numVerts * m_vertexBuffer->GetDesc().stride;
+	for (int i=0; i<NUM_KIDS; i++) {
+		if (kids[i])
+			kids[i]->GetMemoryUsage(cpuBytes, gpuBytes);
 	}
 }
 
@@ -13,6 +13,7 @@
 #include "terrain/Terrain.h"
 #include "GeoPatchID.h"
 #include "JobQueue.h"
+#include "GeoPatchPool.h"
 
 #include <deque>
 
@@ -25,6 +26,7 @@ class GeoSphere;
 class BasePatchJob;
 class SQuadSplitResult;
 class SSingleSplitResult;
+class GeoPatchHorizon;
 
 class GeoPatch {
 private:
@@ -33,9 +35,9 @@ private:
 
 	RefCountedPtr<GeoPatchContext> ctx;
 	const vector3d v0, v1, v2, v3;
-	std::unique_ptr<double[]> heights;
-	std::unique_ptr<vector3f[]> normals;
-	std::unique_ptr<Color3ub[]> colors;
+	std::unique_ptr<double[], GeoPatchPool::Deleter> heights;
+	std::unique_ptr<vector3f[], GeoPatchPool::Deleter> normals;
+	std::unique_ptr<Color3ub[], GeoPatchPool::Deleter> colors;
 	std::unique_ptr<Graphics::VertexBuffer> m_vertexBuffer;
 	std::unique_ptr<GeoPatch> kids[NUM_KIDS];
 	GeoPatch *parent;
@@ -66,6 +68,7 @@ public:
 	}
 
 	void _UpdateVBOs(Graphics::Renderer *renderer);
+	void _UpdateCompactVBOs(Graphics::Renderer *renderer);
 
 	inline int GetEdgeIdxOf(const GeoPatch *e) const {
 		for (int i=0; i<NUM_KIDS; i++) {if (edgeFriend[i] == e) {return i;}}
@@ -124,7 +127,14 @@ public:
 			(edgeFriend[3] ? 8u : 0u);
 	}
 
-	void Render(Graphics::Renderer *r, const vector3d &campos, const matrix4x4d &modelView, const Graphics::Frustum &frustum);
+	// horizon may be null, otherwise patches it hides aren't drawn
+	void Render(Graphics::Renderer *r, const vector3d &campos, const matrix4x4d &modelView, const Graphics::Frustum &frustum,
+		const GeoPatchHorizon *horizon);
+
+	// leaf patches that have height data, for building the horizon
+	void GatherLeaves(std::vector<GeoPatch*> &leaves);
+	void AddToHorizon(GeoPatchHorizon &horizon) const;
+	inline double GetCentroidDistanceSqr(const vector3d &campos) const { return (campos - clipCentroid).LengthSqr(); }
 
 	inline bool canBeMerged() const {
 		bool merge = true;
@@ -137,14 +147,29 @@ public:
 		return merge;
 	}
 
-	void LODUpdate(const vector3d &campos);
+	// pathEnd is where the camera is predicted to be shortly, patches near
+	// the path from campos get low priority (prefetch) split requests
+	void LODUpdate(const vector3d &campos, const vector3d &pathEnd);
 
 	void RequestSinglePatch();
+	// drops any split still being worked on, for a sphere that's being put
+	// aside. the patch asks again the next time it wants to split
+	void CancelJobs();
+	// height, normal and colour arrays, and vertex buffers, of this patch
+	// and everything under it
+	void GetMemoryUsage(size_t &cpuBytes, size_t &gpuBytes) const;
 	void ReceiveHeightmaps(SQuadSplitResult *psr);
 	void ReceiveHeightmap(const SSingleSplitResult *psr);
 
 	inline void SetEdgeFriend(const int idx, GeoPatch *pPatch) { edgeFriend[idx] = pPatch; }
 	inline bool HasHeightData() const { return (heights.get()!=nullptr); }
+	inline bool HasVBO() const { return (m_vertexBuffer.get()!=nullptr); }
+
+private:
+	// patches right under the camera are the ones that visibly pop
+	inline Job::Priority GetSplitPriority(const vector3d &campos) const {
+		return ((campos - centroid).Length() < m_roughLength * 0.5) ? Job::PRIORITY_HIGH : Job::PRIORITY_NORMAL;
+	}
 };
 
 #endif /* _GEOPATCH_H */
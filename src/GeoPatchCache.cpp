@@ -0,0 +1,118 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "libs.h"
+#include "GeoPatchCache.h"
+#include "FileSystem.h"
+#include "Pi.h"
+#include "terrain/Terrain.h"
+
+namespace {
+
+const char CACHE_DIR[] = "patchcache";
+
+// bump this whenever the patch generation changes in a way the terrain
+// signature wouldn't notice (mesh layout, normal calculation etc.)
+const Uint32 CACHE_VERSION = 2;
+
+struct Header {
+	char magic[4];
+	Uint32 version;
+	Uint64 signature;
+	Uint64 patchID;
+	Uint32 depth;
+	Uint32 edgeLen;
+};
+
+bool s_enabled = false;
+
+std::string GetCacheFileName(const SystemPath &path, Uint64 signature, Uint64 patchID, int depth, int edgeLen)
+{
+	char buf[128];
+	snprintf(buf, sizeof(buf), "%d_%d_%d_%u_%u_%08x%08x_%08x%08x_%d_%d.patch",
+		path.sectorX, path.sectorY, path.sectorZ, path.systemIndex, path.bodyIndex,
+		Uint32(signature >> 32), Uint32(signature), Uint32(patchID >> 32), Uint32(patchID), depth, edgeLen);
+	return FileSystem::JoinPath(CACHE_DIR, buf);
+}
+
+Header MakeHeader(Uint64 signature, Uint64 patchID, int depth, int edgeLen)
+{
+	Header h;
+	memcpy(h.magic, "GPC1", 4);
+	h.version = CACHE_VERSION;
+	h.signature = signature;
+	h.patchID = patchID;
+	h.depth = depth;
+	h.edgeLen = edgeLen;
+	return h;
+}
+
+size_t GetDataSize(int edgeLen)
+{
+	const size_t numVerts = size_t(edgeLen) * size_t(edgeLen);
+	return sizeof(Header) + numVerts * (sizeof(double) + sizeof(vector3f) + sizeof(Color3ub));
+}
+
+}
+
+namespace GeoPatchCache {
+
+void Init()
+{
+	s_enabled = Pi::config->Int("GeoPatchCache") != 0;
+	if (s_enabled && !FileSystem::userFiles.MakeDirectory(CACHE_DIR)) {
+		Output("GeoPatchCache: couldn't create cache directory, disabling\n");
+		s_enabled = false;
+	}
+}
+
+bool IsEnabled()
+{
+	return s_enabled;
+}
+
+bool Load(const SystemPath &path, const Terrain *terrain, Uint64 patchID, int depth, int edgeLen,
+	double *heights, vector3f *normals, Color3ub *colors)
+{
+	PROFILE_SCOPED()
+	if (!s_enabled) return false;
+
+	const Uint64 signature = terrain->GetSignature();
+	RefCountedPtr<FileSystem::FileData> fd = FileSystem::userFiles.ReadFile(GetCacheFileName(path, signature, patchID, depth, edgeLen));
+	// a short file is one that didn't finish being written
+	if (!fd || fd->GetSize() != GetDataSize(edgeLen)) return false;
+
+	const char *data = fd->GetData();
+	const Header expected = MakeHeader(signature, patchID, depth, edgeLen);
+	if (memcmp(data, &expected, sizeof(Header)) != 0) return false;
+	data += sizeof(Header);
+
+	const size_t numVerts = size_t(edgeLen) * size_t(edgeLen);
+	memcpy(heights, data, numVerts * sizeof(double));
+	data += numVerts * sizeof(double);
+	memcpy(static_cast<void*>(normals), data, numVerts * sizeof(vector3f));
+	data += numVerts * sizeof(vector3f);
+	memcpy(colors, data, numVerts * sizeof(Color3ub));
+	return true;
+}
+
+void Save(const SystemPath &path, const Terrain *terrain, Uint64 patchID, int depth, int edgeLen,
+	const double *heights, const vector3f *normals, const Color3ub *colors)
+{
+	PROFILE_SCOPED()
+	if (!s_enabled) return;
+
+	const Uint64 signature = terrain->GetSignature();
+	FILE *f = FileSystem::userFiles.OpenWriteStream(GetCacheFileName(path, signature, patchID, depth, edgeLen));
+	if (!f) return;
+
+	const Header header = MakeHeader(signature, patchID, depth, edgeLen);
+	const size_t numVerts = size_t(edgeLen) * size_t(edgeLen);
+	fwrite(&header, sizeof(Header), 1, f);
+	fwrite(heights, sizeof(double), numVerts, f);
+	fwrite(normals, sizeof(vector3f), numVerts, f);
+	fwrite(colors, sizeof(Color3ub), numVerts, f);
+	fclose(f);
+}
+
+}
@@ -0,0 +1,35 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GEOPATCHCACHE_H
+#define _GEOPATCHCACHE_H
+
+#include <SDL_stdinc.h>
+
+#include "vector3.h"
+#include "Color.h"
+#include "galaxy/SystemPath.h"
+
+class Terrain;
+
+// on-disk cache of generated patch meshes, in the user dir. the terrain is
+// deterministic, so a patch is identified by its body, the terrain's
+// signature, the patch id and depth (the first child's id is the same as
+// its parent's) and the edge length. Load and Save are safe to
+// call from the patch jobs
+namespace GeoPatchCache {
+	// call from the main thread before any patch jobs are queued
+	void Init();
+
+	bool IsEnabled();
+
+	// fill heights, normals and colors (edgeLen*edgeLen each) from the
+	// cache. returns false, leaving them alone, if the patch isn't there
+	bool Load(const SystemPath &path, const Terrain *terrain, Uint64 patchID, int depth, int edgeLen,
+		double *heights, vector3f *normals, Color3ub *colors);
+
+	void Save(const SystemPath &path, const Terrain *terrain, Uint64 patchID, int depth, int edgeLen,
+		const double *heights, const vector3f *normals, const Color3ub *colors);
+}
+
+#endif
@@ -31,6 +31,7 @@ class GeoPatchContext : public RefCounted {
 private:
 	int edgeLen;
 	int numTris;
+	bool compactVertices;
 
 	double frac;
 
@@ -61,7 +62,16 @@ public:
 	};
 	#pragma pack(pop)
 
-	GeoPatchContext(int _edgeLen) : edgeLen(_edgeLen) {
+	// positions are patch-relative and scaled by the patch clipRadius,
+	// normals are octahedron-encoded (see GeoPatch::_UpdateVBOs)
+	struct VBOVertexCompact
+	{
+		Sint16 pos[4];
+		Sint16 norm[2];
+		Color4ub col;
+	};
+
+	GeoPatchContext(int _edgeLen, bool _compactVertices = false) : edgeLen(_edgeLen), compactVertices(_compactVertices) {
 		Init();
 	}
 
@@ -82,6 +92,7 @@ public:
 	inline int NUMVERTICES() const { return edgeLen*edgeLen; }
 
 	inline int GetEdgeLen() const { return edgeLen; }
+	inline bool UseCompactVertices() const { return compactVertices; }
 	inline int GetNumTris() const { return numTris; }
 	inline double GetFrac() const { return frac; }
 };
@@ -0,0 +1,130 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "libs.h"
+#include "GeoPatchHorizon.h"
+#include <algorithm>
+
+// polylines wider than this (in bins) are dropped rather than risk the
+// azimuth unwrapping going wrong for lines passing around the camera
+static const int MAX_OCCLUDER_BINS = GeoPatchHorizon::NUM_BINS / 4;
+// spheres wider than this are never tested
+static const int MAX_TEST_BINS = GeoPatchHorizon::NUM_BINS / 4;
+// slack for the float vertex data and the arcs between polyline points
+// dipping below their endpoints
+static const double HORIZON_EPSILON = 1e-4;
+
+static const double NO_HORIZON = -M_PI;
+
+GeoPatchHorizon::GeoPatchHorizon() : m_campos(0.0), m_up(0.0, 1.0, 0.0), m_east(1.0, 0.0, 0.0), m_north(0.0, 0.0, 1.0), m_hasOccluders(false)
+{
+	std::fill(m_horizon, m_horizon + NUM_BINS, NO_HORIZON);
+	std::fill(m_distance, m_distance + NUM_BINS, 0.0);
+}
+
+void GeoPatchHorizon::Reset(const vector3d &campos)
+{
+	PROFILE_SCOPED()
+	m_campos = campos;
+	m_up = campos.Normalized();
+	// any tangent basis will do
+	const vector3d axis = (fabs(m_up.y) < 0.9) ? vector3d(0.0, 1.0, 0.0) : vector3d(1.0, 0.0, 0.0);
+	m_east = axis.Cross(m_up).Normalized();
+	m_north = m_up.Cross(m_east);
+	std::fill(m_horizon, m_horizon + NUM_BINS, NO_HORIZON);
+	std::fill(m_distance, m_distance + NUM_BINS, 0.0);
+	m_hasOccluders = false;
+}
+
+void GeoPatchHorizon::Project(const vector3d &p, double &az, double &elev) const
+{
+	const vector3d d(p - m_campos);
+	const double len = d.Length();
+	elev = asin(Clamp(d.Dot(m_up) / len, -1.0, 1.0));
+	az = (atan2(d.Dot(m_north), d.Dot(m_east)) + M_PI) * (double(NUM_BINS) / (2.0 * M_PI));
+}
+
+void GeoPatchHorizon::AddOccluder(const vector3d *points, int count)
+{
+	if (count < 2)
+		return;
+
+	double az[256], elev[256];
+	count = std::min(count, 256);
+
+	// unwrap the azimuths so the polyline stays continuous
+	Project(points[0], az[0], elev[0]);
+	double azMin = az[0], azMax = az[0];
+	double maxDist = (points[0] - m_campos).Length();
+	for (int i = 1; i < count; i++) {
+		maxDist = std::max(maxDist, (points[i] - m_campos).Length());
+		Project(points[i], az[i], elev[i]);
+		double delta = az[i] - az[i-1];
+		if (delta > NUM_BINS / 2) delta -= NUM_BINS;
+		else if (delta < -NUM_BINS / 2) delta += NUM_BINS;
+		az[i] = az[i-1] + delta;
+		azMin = std::min(azMin, az[i]);
+		azMax = std::max(azMax, az[i]);
+	}
+
+	// only the bins every azimuth of which crosses the polyline
+	const int first = int(ceil(azMin));
+	const int last = int(floor(azMax));	// exclusive
+	if (last <= first || last - first > MAX_OCCLUDER_BINS)
+		return;
+
+	double lowest[MAX_OCCLUDER_BINS];
+	std::fill(lowest, lowest + (last - first), M_PI);
+	for (int i = 0; i < count - 1; i++) {
+		const double segElev = std::min(elev[i], elev[i+1]);
+		const int b0 = std::max(first, int(floor(std::min(az[i], az[i+1]))));
+		const int b1 = std::min(last - 1, int(floor(std::max(az[i], az[i+1]))));
+		for (int b = b0; b <= b1; b++)
+			lowest[b - first] = std::min(lowest[b - first], segElev);
+	}
+
+	// a bin only remembers its highest occluder, a lower but nearer one is lost
+	for (int b = first; b < last; b++) {
+		const int bin = ((b % NUM_BINS) + NUM_BINS) % NUM_BINS;
+		const double h = lowest[b - first] - HORIZON_EPSILON;
+		if (h > m_horizon[bin]) {
+			m_horizon[bin] = h;
+			m_distance[bin] = maxDist;
+		}
+	}
+	m_hasOccluders = true;
+}
+
+bool GeoPatchHorizon::IsOccluded(const vector3d &centre, double radius) const
+{
+	if (!m_hasOccluders)
+		return false;
+
+	const vector3d d(centre - m_campos);
+	const double dist = d.Length();
+	if (dist <= radius)
+		return false;
+
+	// the azimuth range is from the sphere's shadow on the horizontal plane
+	const double up = d.Dot(m_up);
+	const double horizDist = (d - m_up * up).Length();
+	if (horizDist <= radius)
+		return false;
+
+	const double topElev = asin(Clamp(up / dist, -1.0, 1.0)) + asin(radius / dist);
+	const double halfWidth = asin(radius / horizDist) * (double(NUM_BINS) / (2.0 * M_PI));
+	if (2.0 * halfWidth > MAX_TEST_BINS)
+		return false;
+
+	const double az = (atan2(d.Dot(m_north), d.Dot(m_east)) + M_PI) * (double(NUM_BINS) / (2.0 * M_PI));
+	const int first = int(floor(az - halfWidth));
+	const int last = int(floor(az + halfWidth));
+	// the sphere also has to be entirely behind the terrain hiding it
+	const double nearDist = dist - radius;
+	for (int b = first; b <= last; b++) {
+		const int bin = ((b % NUM_BINS) + NUM_BINS) % NUM_BINS;
+		if (m_horizon[bin] <= topElev || m_distance[bin] >= nearDist)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,46 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GEOPATCHHORIZON_H
+#define _GEOPATCHHORIZON_H
+
+#include <SDL_stdinc.h>
+
+#include "vector3.h"
+
+// Conservative horizon buffer for terrain occlusion close to the surface.
+// Polylines of terrain mesh vertices near the camera are rasterised into
+// azimuth bins. Each bin keeps an elevation below which every ray in the
+// bin passes under the terrain, along with how far away that terrain is,
+// so it can't see anything further away than that.
+// All positions are in the planet's frame, in planet radii.
+class GeoPatchHorizon {
+public:
+	static const int NUM_BINS = 512;
+
+	GeoPatchHorizon();
+
+	// clears the buffer and sets up the local frame at campos
+	void Reset(const vector3d &campos);
+
+	// points must be consecutive vertices joined by mesh edges, otherwise
+	// the line between them isn't terrain
+	void AddOccluder(const vector3d *points, int count);
+
+	// true if nothing inside the sphere can be seen from campos
+	bool IsOccluded(const vector3d &centre, double radius) const;
+
+	bool HasOccluders() const { return m_hasOccluders; }
+
+private:
+	// azimuth in bins (not wrapped) and elevation in radians
+	void Project(const vector3d &p, double &az, double &elev) const;
+
+	vector3d m_campos;
+	vector3d m_up, m_east, m_north;
+	double m_horizon[NUM_BINS];
+	double m_distance[NUM_BINS];
+	bool m_hasOccluders;
+};
+
+#endif /* _GEOPATCHHORIZON_H */
@@ -5,6 +5,7 @@
 #include "GeoPatchJobs.h"
 #include "GeoSphere.h"
 #include "GeoPatch.h"
+#include "GeoPatchCache.h"
 #include "perlin.h"
 #include "Pi.h"
 #include "RefCounted.h"
@@ -20,7 +21,7 @@ inline void setColour(Color3ub &r, const vector3d &v) {
 // ********************************************************************************
 
 // Generates full-detail vertices, and also non-edge normals and colors 
-void BasePatchJob::GenerateMesh(double *heights, vector3f *normals, Color3ub *colors, 
+bool BasePatchJob::GenerateMesh(double *heights, vector3f *normals, Color3ub *colors, 
 								double *borderHeights, vector3d *borderVertexs,
 								const vector3d &v0,
 								const vector3d &v1,
@@ -33,28 +34,36 @@ void BasePatchJob::GenerateMesh(double *heights, vector3f *normals, Color3ub *co
 	const int borderedEdgeLen = edgeLen+2;
 	const int numBorderedVerts = borderedEdgeLen*borderedEdgeLen;
 
-	// generate heights plus a 1 unit border
-	double *bhts = borderHeights;
+	// generate heights plus a 1 unit border. the sphere points go in the
+	// vertex array first so the terrain can do a whole row in one call
 	vector3d *vrts = borderVertexs;
 	for (int y=-1; y<borderedEdgeLen-1; y++) {
+		if (IsCancelled())
+			return false;
 		const double yfrac = double(y) * fracStep;
+		vector3d *row = vrts;
 		for (int x=-1; x<borderedEdgeLen-1; x++) {
 			const double xfrac = double(x) * fracStep;
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
-			const double height = pTerrain->GetHeight(p);
-			assert(height >= 0.0f && height <= 1.0f);
-			*(bhts++) = height;
-			*(vrts++) = p * (height + 1.0);
+			*(vrts++) = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
 		}
+		pTerrain->GetHeights(row, &borderHeights[row - borderVertexs], borderedEdgeLen);
+	}
+	assert(vrts==&borderVertexs[numBorderedVerts]);
+	for (int i=0; i<numBorderedVerts; i++) {
+		assert(borderHeights[i] >= 0.0f && borderHeights[i] <= 1.0f);
+		borderVertexs[i] *= (borderHeights[i] + 1.0);
 	}
-	assert(bhts==&borderHeights[numBorderedVerts]);
 
-	// Generate normals & colors for non-edge vertices since they never change
+	// Generate normals & colors for non-edge vertices since they never change.
+	// colours are done a row at a time, again so they can be batched
+	std::vector<vector3d> rowPoints(edgeLen), rowNorms(edgeLen), rowColors(edgeLen);
 	Color3ub *col = colors;
 	vector3f *nrm = normals;
 	double *hts = heights;
 	vrts = borderVertexs;
 	for (int y=1; y<borderedEdgeLen-1; y++) {
+		if (IsCancelled())
+			return false;
 		for (int x=1; x<borderedEdgeLen-1; x++) {
 			// height
 			const double height = borderHeights[x + y*borderedEdgeLen];
@@ -70,16 +79,21 @@ void BasePatchJob::GenerateMesh(double *heights, vector3f *normals, Color3ub *co
 			assert(nrm!=&normals[edgeLen*edgeLen]);
 			*(nrm++) = vector3f(n);
 
-			// color
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, (x-1)*fracStep, (y-1)*fracStep);
-			setColour(*col, pTerrain->GetColor(p, height, n));
+			rowPoints[x-1] = GetSpherePoint(v0, v1, v2, v3, (x-1)*fracStep, (y-1)*fracStep);
+			rowNorms[x-1] = n;
+		}
+
+		// color
+		pTerrain->GetColors(&rowPoints[0], hts - edgeLen, &rowNorms[0], &rowColors[0], edgeLen);
+		for (int x=0; x<edgeLen; x++) {
 			assert(col!=&colors[edgeLen*edgeLen]);
-			++col;
+			setColour(*(col++), rowColors[x]);
 		}
 	}
 	assert(hts==&heights[edgeLen*edgeLen]);
 	assert(nrm==&normals[edgeLen*edgeLen]);
 	assert(col==&colors[edgeLen*edgeLen]);
+	return true;
 }
 
 // ********************************************************************************
@@ -97,16 +111,26 @@ void SinglePatchJob::OnRun()    // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	BasePatchJob::OnRun();
 
 	const SSingleSplitRequest &srd = *mData;
+	const uint64_t patchID = srd.patchID.NextPatchID(srd.depth+1, 0);
 
 	// fill out the data
-	GenerateMesh(srd.heights, srd.normals, srd.colors, srd.borderHeights.get(), srd.borderVertexs.get(),
-		srd.v0, srd.v1, srd.v2, srd.v3, 
-		srd.edgeLen, srd.fracStep, srd.pTerrain.Get());
+	if (!GeoPatchCache::Load(srd.sysPath, srd.pTerrain.Get(), patchID, srd.depth+1, srd.edgeLen, srd.heights, srd.normals, srd.colors)) {
+		// nobody wants it any more, don't bother with a result
+		if (!GenerateMesh(srd.heights, srd.normals, srd.colors, srd.borderHeights.get(), srd.borderVertexs.get(),
+			srd.v0, srd.v1, srd.v2, srd.v3,
+			srd.edgeLen, srd.fracStep, srd.pTerrain.Get())) {
+			GeoPatchPool::Free(srd.heights);
+			GeoPatchPool::Free(srd.normals);
+			GeoPatchPool::Free(srd.colors);
+			return;
+		}
+		GeoPatchCache::Save(srd.sysPath, srd.pTerrain.Get(), patchID, srd.depth+1, srd.edgeLen, srd.heights, srd.normals, srd.colors);
+	}
 	// add this patches data
 	SSingleSplitResult *sr = new SSingleSplitResult(srd.patchID.GetPatchFaceIdx(), srd.depth);
 	sr->addResult(srd.heights, srd.normals, srd.colors, 
 		srd.v0, srd.v1, srd.v2, srd.v3, 
-		srd.patchID.NextPatchID(srd.depth+1, 0));
+		patchID);
 	// store the result
 	mpResults = sr;
 }
@@ -151,14 +175,29 @@ void QuadPatchJob::OnRun()    // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	SQuadSplitResult *sr = new SQuadSplitResult(srd.patchID.GetPatchFaceIdx(), srd.depth);
 	for (int i=0; i<4; i++)
 	{
+		const uint64_t patchID = srd.patchID.NextPatchID(srd.depth+1, i);
+
 		// fill out the data
-		GenerateMesh(srd.heights[i], srd.normals[i], srd.colors[i], srd.borderHeights[i].get(), srd.borderVertexs[i].get(),
-			vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3], 
-			srd.edgeLen, srd.fracStep, srd.pTerrain.Get());
+		if (!GeoPatchCache::Load(srd.sysPath, srd.pTerrain.Get(), patchID, srd.depth+1, srd.edgeLen, srd.heights[i], srd.normals[i], srd.colors[i])) {
+			// nobody wants it any more, don't bother with a result. the
+			// result only borrows the arrays so far, free them all here
+			if (!GenerateMesh(srd.heights[i], srd.normals[i], srd.colors[i], srd.borderHeights[i].get(), srd.borderVertexs[i].get(),
+				vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3],
+				srd.edgeLen, srd.fracStep, srd.pTerrain.Get())) {
+				delete sr;
+				for (int j=0; j<4; j++) {
+					GeoPatchPool::Free(srd.heights[j]);
+					GeoPatchPool::Free(srd.normals[j]);
+					GeoPatchPool::Free(srd.colors[j]);
+				}
+				return;
+			}
+			GeoPatchCache::Save(srd.sysPath, srd.pTerrain.Get(), patchID, srd.depth+1, srd.edgeLen, srd.heights[i], srd.normals[i], srd.colors[i]);
+		}
 		// add this patches data
 		sr->addResult(i, srd.heights[i], srd.normals[i], srd.colors[i], 
 			vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3], 
-			srd.patchID.NextPatchID(srd.depth+1, i));
+			patchID);
 	}
 	mpResults = sr;
 }
@@ -12,6 +12,7 @@
 #include "terrain/Terrain.h"
 #include "GeoPatchID.h"
 #include "JobQueue.h"
+#include "GeoPatchPool.h"
 
 class GeoSphere;
 
@@ -55,12 +56,12 @@ public:
 		const int numBorderedVerts = NUMVERTICES(edgeLen_+2);
 		for( int i=0 ; i<4 ; ++i )
 		{
-			heights[i] = new double[numVerts];
-			normals[i] = new vector3f[numVerts];
-			colors[i] = new Color3ub[numVerts];
+			heights[i] = GeoPatchPool::Alloc<double>(numVerts);
+			normals[i] = GeoPatchPool::Alloc<vector3f>(numVerts);
+			colors[i] = GeoPatchPool::Alloc<Color3ub>(numVerts);
 
-			borderHeights[i].reset(new double[numBorderedVerts]);
-			borderVertexs[i].reset(new vector3d[numBorderedVerts]);
+			borderHeights[i].reset(GeoPatchPool::Alloc<double>(numBorderedVerts));
+			borderVertexs[i].reset(GeoPatchPool::Alloc<vector3d>(numBorderedVerts));
 		}
 	}
 
@@ -70,8 +71,8 @@ public:
 	double *heights[4];
 
 	// these are created with the request but are destroyed when the request is finished
-	std::unique_ptr<double[]> borderHeights[4];
-	std::unique_ptr<vector3d[]> borderVertexs[4];
+	std::unique_ptr<double[], GeoPatchPool::Deleter> borderHeights[4];
+	std::unique_ptr<vector3d[], GeoPatchPool::Deleter> borderVertexs[4];
 
 protected:
 	// deliberately prevent copy constructor access
@@ -86,13 +87,13 @@ public:
 		: SBaseRequest(v0_, v1_, v2_, v3_, cn, depth_, sysPath_, patchID_, edgeLen_, fracStep_, pTerrain_)
 	{
 		const int numVerts = NUMVERTICES(edgeLen_);
-		heights = new double[numVerts];
-		normals = new vector3f[numVerts];
-		colors = new Color3ub[numVerts];
+		heights = GeoPatchPool::Alloc<double>(numVerts);
+		normals = GeoPatchPool::Alloc<vector3f>(numVerts);
+		colors = GeoPatchPool::Alloc<Color3ub>(numVerts);
 		
 		const int numBorderedVerts = NUMVERTICES(edgeLen_+2);
-		borderHeights.reset(new double[numBorderedVerts]);
-		borderVertexs.reset(new vector3d[numBorderedVerts]);
+		borderHeights.reset(GeoPatchPool::Alloc<double>(numBorderedVerts));
+		borderVertexs.reset(GeoPatchPool::Alloc<vector3d>(numBorderedVerts));
 	}
 
 	// these are created with the request and are given to the resulting patches
@@ -101,8 +102,8 @@ public:
 	double *heights;
 
 	// these are created with the request but are destroyed when the request is finished
-	std::unique_ptr<double> borderHeights;
-	std::unique_ptr<vector3d> borderVertexs;
+	std::unique_ptr<double[], GeoPatchPool::Deleter> borderHeights;
+	std::unique_ptr<vector3d[], GeoPatchPool::Deleter> borderVertexs;
 
 protected:
 	// deliberately prevent copy constructor access
@@ -117,7 +118,7 @@ public:
 			heights(heights_), normals(n_), colors(c_), v0(v0_), v1(v1_), v2(v2_), v3(v3_), patchID(patchID_)
 		{}
 		SSplitResultData(const SSplitResultData &r) : 
-			normals(r.normals), colors(r.colors), v0(r.v0), v1(r.v1), v2(r.v2), v3(r.v3), patchID(r.patchID)
+			heights(r.heights), normals(r.normals), colors(r.colors), v0(r.v0), v1(r.v1), v2(r.v2), v3(r.v3), patchID(r.patchID)
 		{}
 
 		double *heights;
@@ -161,9 +162,9 @@ public:
 	virtual void OnCancel()
 	{
 		for( int i=0; i<NUM_RESULT_DATA; ++i ) {
-			if( mData[i].heights ) {delete [] mData[i].heights;		mData[i].heights = NULL;}
-			if( mData[i].normals ) {delete [] mData[i].normals;		mData[i].normals = NULL;}
-			if( mData[i].colors ) {delete [] mData[i].colors;		mData[i].colors = NULL;}
+			if( mData[i].heights ) {GeoPatchPool::Free(mData[i].heights);		mData[i].heights = NULL;}
+			if( mData[i].normals ) {GeoPatchPool::Free(mData[i].normals);		mData[i].normals = NULL;}
+			if( mData[i].colors ) {GeoPatchPool::Free(mData[i].colors);		mData[i].colors = NULL;}
 		}
 	}
 
@@ -190,9 +191,9 @@ public:
 	virtual void OnCancel()
 	{
 		{
-			if( mData.heights ) {delete [] mData.heights;	mData.heights = NULL;}
-			if( mData.normals ) {delete [] mData.normals;	mData.normals = NULL;}
-			if( mData.colors ) {delete [] mData.colors;		mData.colors = NULL;}
+			if( mData.heights ) {GeoPatchPool::Free(mData.heights);	mData.heights = NULL;}
+			if( mData.normals ) {GeoPatchPool::Free(mData.normals);	mData.normals = NULL;}
+			if( mData.colors ) {GeoPatchPool::Free(mData.colors);		mData.colors = NULL;}
 		}
 	}
 
@@ -211,21 +212,29 @@ class GeoPatch;
 class BasePatchJob : public Job
 {
 public:
-	BasePatchJob() {}
+	BasePatchJob() : m_cancelled(false) { SetLane(LANE_TERRAIN); }
 	virtual void OnRun() {}    // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	virtual void OnFinish() {}
-	virtual void OnCancel() {}
+	// the patch has stopped wanting it, eg. the camera has flown past. the
+	// mesh generation checks for this between rows and gives up
+	virtual void OnCancel() { m_cancelled = true; }
 
 protected:
+	bool IsCancelled() const { return m_cancelled; }
+
 	// in patch surface coords, [0,1]
 	inline vector3d GetSpherePoint(const vector3d &v0, const vector3d &v1, const vector3d &v2, const vector3d &v3, const double x, const double y) const {
 		return (v0 + x*(1.0-y)*(v1-v0) + x*y*(v2-v0) + (1.0-x)*y*(v3-v0)).Normalized();
 	}
 
-	// Generates full-detail vertices, and also non-edge normals and colors 
-	void GenerateMesh(double *heights, vector3f *normals, Color3ub *colors, double *borderHeights, vector3d *borderVertexs,
+	// Generates full-detail vertices, and also non-edge normals and colors.
+	// false if the job was cancelled part way, the arrays are junk then
+	bool GenerateMesh(double *heights, vector3f *normals, Color3ub *colors, double *borderHeights, vector3d *borderVertexs,
 		const vector3d &v0, const vector3d &v1, const vector3d &v2, const vector3d &v3,
 		const int edgeLen, const double fracStep, const Terrain *pTerrain) const;
+
+private:
+	std::atomic<bool> m_cancelled;
 };
 
 // ********************************************************************************
@@ -239,6 +248,7 @@ public:
 
 	virtual void OnRun();      // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	virtual void OnFinish();   // runs in primary thread of the context
+	virtual const char *GetName() const { return "SinglePatchJob"; }
 
 private:
 	std::unique_ptr<SSingleSplitRequest> mData;
@@ -256,6 +266,7 @@ public:
 
 	virtual void OnRun();      // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	virtual void OnFinish();   // runs in primary thread of the context
+	virtual const char *GetName() const { return "QuadPatchJob"; }
 
 private:
 	std::unique_ptr<SQuadSplitRequest> mData;
@@ -0,0 +1,119 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "libs.h"
+#include "GeoPatchPool.h"
+#include "SDL_thread.h"
+#include <cstdlib>
+
+namespace {
+
+// each slab starts with a header saying which pool it came from. it's padded
+// out so the data that follows is suitably aligned for anything
+union SlabHeader {
+	Uint32 pool;
+	double alignDouble;
+	Uint64 alignInt;
+	void *alignPtr;
+};
+
+struct Pool {
+	size_t slabBytes;
+	Uint32 inUse;
+	std::vector<SlabHeader*> free;
+};
+
+// there's generally one size per kind of array, so five or so per detail level
+std::vector<Pool> s_pools;
+SDL_mutex *s_lock = nullptr;
+
+// only called on first use, which is from the main thread when the first
+// split request is made
+SDL_mutex *GetLock()
+{
+	if (!s_lock)
+		s_lock = SDL_CreateMutex();
+	return s_lock;
+}
+
+}
+
+namespace GeoPatchPool {
+
+void *Alloc(size_t bytes)
+{
+	SDL_mutex *lock = GetLock();
+	SDL_LockMutex(lock);
+
+	Uint32 poolIdx = 0;
+	while (poolIdx < s_pools.size() && s_pools[poolIdx].slabBytes != bytes)
+		poolIdx++;
+	if (poolIdx == s_pools.size()) {
+		Pool pool;
+		pool.slabBytes = bytes;
+		pool.inUse = 0;
+		s_pools.push_back(pool);
+	}
+
+	Pool &pool = s_pools[poolIdx];
+	SlabHeader *slab;
+	if (!pool.free.empty()) {
+		slab = pool.free.back();
+		pool.free.pop_back();
+	} else {
+		slab = static_cast<SlabHeader*>(std::malloc(sizeof(SlabHeader) + bytes));
+		if (!slab) {
+			SDL_UnlockMutex(lock);
+			throw std::bad_alloc();
+		}
+		slab->pool = poolIdx;
+	}
+	pool.inUse++;
+
+	SDL_UnlockMutex(lock);
+	return slab + 1;
+}
+
+void Free(void *p)
+{
+	if (!p) return;
+	SlabHeader *slab = static_cast<SlabHeader*>(p) - 1;
+
+	SDL_mutex *lock = GetLock();
+	SDL_LockMutex(lock);
+	assert(slab->pool < s_pools.size());
+	Pool &pool = s_pools[slab->pool];
+	assert(pool.inUse > 0);
+	pool.inUse--;
+	pool.free.push_back(slab);
+	SDL_UnlockMutex(lock);
+}
+
+Stats GetStats()
+{
+	Stats stats = { 0, 0, 0, 0 };
+	SDL_mutex *lock = GetLock();
+	SDL_LockMutex(lock);
+	for (const Pool &pool : s_pools) {
+		stats.slabsInUse += pool.inUse;
+		stats.slabsFree += pool.free.size();
+		stats.bytesInUse += pool.inUse * pool.slabBytes;
+		stats.bytesFree += pool.free.size() * pool.slabBytes;
+	}
+	SDL_UnlockMutex(lock);
+	return stats;
+}
+
+void Trim()
+{
+	SDL_mutex *lock = GetLock();
+	SDL_LockMutex(lock);
+	for (Pool &pool : s_pools) {
+		for (SlabHeader *slab : pool.free)
+			std::free(slab);
+		pool.free.clear();
+	}
+	SDL_UnlockMutex(lock);
+}
+
+}
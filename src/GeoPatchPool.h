@@ -0,0 +1,50 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GEOPATCHPOOL_H
+#define _GEOPATCHPOOL_H
+
+#include <SDL_stdinc.h>
+#include <cstddef>
+#include <new>
+
+// slab pools for the per patch vertex arrays (heights, normals, colours and
+// the border scratch arrays). every patch at a given detail level has the
+// same edge length, so each kind of array is always the same size and can
+// be recycled instead of going back to the heap. one pool is kept for each
+// slab size that's asked for. safe to use from any thread
+namespace GeoPatchPool {
+	void *Alloc(size_t bytes);
+	void Free(void *p);
+
+	// elements are default constructed and never destructed, so only use
+	// this for plain data
+	template <typename T>
+	T *Alloc(size_t count) {
+		T *p = static_cast<T*>(Alloc(count * sizeof(T)));
+		for (size_t i = 0; i < count; i++)
+			new (&p[i]) T;
+		return p;
+	}
+
+	// for unique_ptr
+	struct Deleter {
+		template <typename T>
+		void operator()(T *p) const { Free(p); }
+	};
+
+	// totals over all the pools
+	struct Stats {
+		Uint32 slabsInUse;
+		Uint32 slabsFree;
+		size_t bytesInUse;
+		size_t bytesFree;
+	};
+	Stats GetStats();
+
+	// release the free slabs back to the heap, eg. after the detail level
+	// (and so the edge length) has changed
+	void Trim();
+}
+
+#endif
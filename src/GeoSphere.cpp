@@ -3,9 +3,13 @@
 
 #include "libs.h"
 #include "GeoSphere.h"
+#include "AtmosphereLUT.h"
 #include "GeoPatchContext.h"
 #include "GeoPatch.h"
 #include "GeoPatchJobs.h"
+#include "GeoPatchCache.h"
+#include "GeoPatchPool.h"
+#include "GeoPatchHorizon.h"
 #include "perlin.h"
 #include "Pi.h"
 #include "RefCounted.h"
@@ -19,6 +23,7 @@
 #include <algorithm>
 
 RefCountedPtr<GeoPatchContext> GeoSphere::s_patchContext;
+double GeoSphere::s_splitDistanceScale = 1.0;
 
 // must be odd numbers
 static const int detail_edgeLen[5] = {
@@ -40,16 +45,59 @@ static const int geo_sphere_edge_friends[NUM_PATCHES][4] = {
 
 static std::vector<GeoSphere*> s_allGeospheres;
 
+// spheres put aside by KeepAlive, most recently used first, and what they
+// may hold between them. a budget of 0 keeps nothing
+static std::deque<GeoSphere*> s_keptGeospheres;
+static size_t s_keepAliveCpuBudget = 0;
+static size_t s_keepAliveGpuBudget = 0;
+
+static bool s_prefetchSplits = false;
+// how far ahead (in seconds) the camera path is projected
+static const double PREFETCH_LOOKAHEAD = 3.0;
+// anything projecting further than this (in planet radii) is a jump, not a path
+static const double PREFETCH_MAX_DIST = 1.0;
+// smoothing of the camera velocity estimate, per frame
+static const double PREFETCH_VELOCITY_BLEND = 0.25;
+
+// bytes of patch vertices uploaded each frame, 0 for no limit. patches past
+// it wait for a later frame, drawn as their parent meanwhile
+static Sint64 s_uploadBudget = 0;
+static Sint64 s_uploadRemaining = 0;
+
+static bool s_occlusionCulling = false;
+// terrain only hides much when the camera is down among it, this is in
+// multiples of the terrain's maximum feature height
+static const double OCCLUSION_MAX_ALTITUDE = 4.0;
+// how many of the nearest patches are rasterised into the horizon
+static const size_t OCCLUSION_NUM_OCCLUDERS = 24;
+
+static GeoPatchContext *CreatePatchContext()
+{
+	const int edgeLen = detail_edgeLen[Pi::detail.planets > 4 ? 4 : Pi::detail.planets];
+	return new GeoPatchContext(edgeLen, Pi::config->Int("GeoPatchCompactVertices") != 0);
+}
+
 void GeoSphere::Init()
 {
-	s_patchContext.Reset(new GeoPatchContext(detail_edgeLen[Pi::detail.planets > 4 ? 4 : Pi::detail.planets]));
+	s_patchContext.Reset(CreatePatchContext());
 	assert(s_patchContext->GetEdgeLen() <= detail_edgeLen[4]);
+	GeoPatchCache::Init();
+	s_prefetchSplits = (Pi::config->Int("GeoPatchPrefetch") != 0);
+	s_occlusionCulling = (Pi::config->Int("GeoSphereOcclusionCulling") != 0);
+	s_uploadBudget = Sint64(std::max(0, Pi::config->Int("GeoPatchUploadBudgetKB"))) * 1024;
+	s_uploadRemaining = s_uploadBudget;
+	s_keepAliveCpuBudget = size_t(std::max(0, Pi::config->Int("GeoSphereKeepAliveBudgetMB"))) * 1024 * 1024;
+	s_keepAliveGpuBudget = size_t(std::max(0, Pi::config->Int("GeoSphereKeepAliveGpuBudgetMB"))) * 1024 * 1024;
 }
 
 void GeoSphere::Uninit()
 {
+	// kept patches hold on to the context too
+	ClearKeptAlive();
 	assert (s_patchContext.Unique());
 	s_patchContext.Reset();
+	// the next context may well have a different edge length
+	GeoPatchPool::Trim();
 }
 
 static void print_info(const SystemBody *sbody, const Terrain *terrain)
@@ -72,10 +120,31 @@ void GeoSphere::UpdateAllGeoSpheres()
 	}
 }
 
+// static
+void GeoSphere::BeginFrame()
+{
+	s_uploadRemaining = s_uploadBudget;
+}
+
+// static
+bool GeoSphere::TakeUploadBudget(const size_t bytes)
+{
+	if (!s_uploadBudget)
+		return true;
+	if (s_uploadRemaining <= 0)
+		return false;
+	// the last upload of the frame may run over, else a budget smaller
+	// than one patch would never upload anything
+	s_uploadRemaining -= Sint64(bytes);
+	return true;
+}
+
 // static
 void GeoSphere::OnChangeDetailLevel()
 {
-	s_patchContext.Reset(new GeoPatchContext(detail_edgeLen[Pi::detail.planets > 4 ? 4 : Pi::detail.planets]));
+	// they were built with the old context's edge length
+	ClearKeptAlive();
+	s_patchContext.Reset(CreatePatchContext());
 	assert(s_patchContext->GetEdgeLen() <= detail_edgeLen[4]);
 
 	// reinit the geosphere terrain data
@@ -90,6 +159,85 @@ void GeoSphere::OnChangeDetailLevel()
 	}
 }
 
+// static
+void GeoSphere::KeepAlive(GeoSphere *sphere)
+{
+	PROFILE_SCOPED()
+	assert(sphere);
+	// half built spheres aren't worth the trouble of picking up again
+	if (sphere->m_initStage != eDefaultUpdateState) {
+		delete sphere;
+		return;
+	}
+
+	// it won't be updated while it's kept, so nothing can be waiting on it
+	sphere->ClearSplitResults();
+	for (int p=0; p<NUM_PATCHES; p++)
+		sphere->m_patches[p]->CancelJobs();
+	s_allGeospheres.erase(std::find(s_allGeospheres.begin(), s_allGeospheres.end(), sphere));
+
+	sphere->m_keptPath = sphere->GetSystemBody()->GetPath();
+	sphere->m_keptSeed = sphere->GetSystemBody()->GetSeed();
+	sphere->m_keptCpuBytes = sphere->m_keptGpuBytes = 0;
+	sphere->GetMemoryUsage(sphere->m_keptCpuBytes, sphere->m_keptGpuBytes);
+	sphere->m_sbody = nullptr;
+	s_keptGeospheres.push_front(sphere);
+
+	// drop the least recently used until everything fits
+	size_t cpuBytes = 0, gpuBytes = 0;
+	for (const GeoSphere *gs : s_keptGeospheres) {
+		cpuBytes += gs->m_keptCpuBytes;
+		gpuBytes += gs->m_keptGpuBytes;
+	}
+	while (!s_keptGeospheres.empty() && (cpuBytes > s_keepAliveCpuBudget || gpuBytes > s_keepAliveGpuBudget)) {
+		GeoSphere *gs = s_keptGeospheres.back();
+		s_keptGeospheres.pop_back();
+		cpuBytes -= gs->m_keptCpuBytes;
+		gpuBytes -= gs->m_keptGpuBytes;
+		delete gs;
+	}
+}
+
+// static
+GeoSphere *GeoSphere::Adopt(const SystemBody *body)
+{
+	const SystemPath path = body->GetPath();
+	for (auto it = s_keptGeospheres.begin(); it != s_keptGeospheres.end(); ++it) {
+		GeoSphere *gs = *it;
+		if (gs->m_keptPath != path)
+			continue;
+		s_keptGeospheres.erase(it);
+		// the same path in a different galaxy, eg. after loading another
+		// game, may well be a different body
+		if (gs->m_keptSeed != body->GetSeed()) {
+			delete gs;
+			return nullptr;
+		}
+		gs->m_sbody = body;
+		gs->m_hasTempCampos = false;
+		gs->m_hasPrevCampos = false;
+		s_allGeospheres.push_back(gs);
+		return gs;
+	}
+	return nullptr;
+}
+
+// static
+void GeoSphere::ClearKeptAlive()
+{
+	for (GeoSphere *gs : s_keptGeospheres)
+		delete gs;
+	s_keptGeospheres.clear();
+}
+
+void GeoSphere::GetMemoryUsage(size_t &cpuBytes, size_t &gpuBytes) const
+{
+	for (int p=0; p<NUM_PATCHES; p++) {
+		if (m_patches[p])
+			m_patches[p]->GetMemoryUsage(cpuBytes, gpuBytes);
+	}
+}
+
 //static
 bool GeoSphere::OnAddQuadSplitResult(const SystemPath &path, SQuadSplitResult *res)
 {
@@ -126,7 +274,7 @@ bool GeoSphere::OnAddSingleSplitResult(const SystemPath &path, SSingleSplitResul
 	return false;
 }
 
-void GeoSphere::Reset()
+void GeoSphere::ClearSplitResults()
 {
 	{
 		std::deque<SSingleSplitResult*>::iterator iter = mSingleSplitResults.begin();
@@ -165,6 +313,11 @@ void GeoSphere::Reset()
 		}
 		mQuadSplitResults.clear();
 	}
+}
+
+void GeoSphere::Reset()
+{
+	ClearSplitResults();
 
 	for (int p=0; p<NUM_PATCHES; p++) {
 		// delete patches
@@ -181,7 +334,10 @@ void GeoSphere::Reset()
 #define GEOSPHERE_TYPE	(GetSystemBody()->type)
 
 GeoSphere::GeoSphere(const SystemBody *body) : BaseSphere(body),
-	m_hasTempCampos(false), m_tempCampos(0.0), m_initStage(eBuildFirstPatches), m_maxDepth(0)
+	m_hasTempCampos(false), m_tempCampos(0.0),
+	m_hasPrevCampos(false), m_prevCampos(0.0), m_camVelocity(0.0), m_prefetchPos(0.0),
+	m_initStage(eBuildFirstPatches), m_maxDepth(0),
+	m_keptSeed(0), m_keptCpuBytes(0), m_keptGpuBytes(0)
 {
 	print_info(body, m_terrain.Get());
 
@@ -195,8 +351,11 @@ GeoSphere::GeoSphere(const SystemBody *body) : BaseSphere(body),
 GeoSphere::~GeoSphere()
 {
 	// update thread should not be able to access us now, so we can safely continue to delete
-	assert(std::count(s_allGeospheres.begin(), s_allGeospheres.end(), this) == 1);
-	s_allGeospheres.erase(std::find(s_allGeospheres.begin(), s_allGeospheres.end(), this));
+	// kept alive spheres have already been taken out
+	assert(std::count(s_allGeospheres.begin(), s_allGeospheres.end(), this) <= 1);
+	auto it = std::find(s_allGeospheres.begin(), s_allGeospheres.end(), this);
+	if (it != s_allGeospheres.end())
+		s_allGeospheres.erase(it);
 }
 
 bool GeoSphere::AddQuadSplitResult(SQuadSplitResult *res)
@@ -353,14 +512,37 @@ void GeoSphere::Update()
 	case eDefaultUpdateState:
 		if(m_hasTempCampos) {
 			ProcessSplitResults();
+			UpdatePrefetchPath();
 			for (int i=0; i<NUM_PATCHES; i++) {
-				m_patches[i]->LODUpdate(m_tempCampos);
+				m_patches[i]->LODUpdate(m_tempCampos, m_prefetchPos);
 			}
 		}
 		break;
 	}
 }
 
+void GeoSphere::UpdatePrefetchPath()
+{
+	m_prefetchPos = m_tempCampos;
+	if (!s_prefetchSplits)
+		return;
+
+	// campos is in the planet's frame, so differencing it gives the velocity
+	// the patches actually see, frame rotation included
+	const double frameTime = Pi::GetFrameTime();
+	if (m_hasPrevCampos && frameTime > 0.0) {
+		const vector3d vel((m_tempCampos - m_prevCampos) / frameTime);
+		if (vel.Length() * PREFETCH_LOOKAHEAD < PREFETCH_MAX_DIST) {
+			m_camVelocity = m_camVelocity * (1.0 - PREFETCH_VELOCITY_BLEND) + vel * PREFETCH_VELOCITY_BLEND;
+			m_prefetchPos = m_tempCampos + m_camVelocity * PREFETCH_LOOKAHEAD;
+		} else {
+			m_camVelocity = vector3d(0.0);
+		}
+	}
+	m_prevCampos = m_tempCampos;
+	m_hasPrevCampos = true;
+}
+
 void GeoSphere::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView, vector3d campos, const float radius, const float scale, const std::vector<Camera::Shadow> &shadows)
 {
 	// store this for later usage in the update method.
@@ -395,6 +577,8 @@ void GeoSphere::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView
 		m_materialParameters.atmosphere.scale = scale;
 
 		m_materialParameters.shadows = shadows;
+		m_materialParameters.opticalDepth = m_materialParameters.atmosphere.atmosDensity > 0.0 ?
+			AtmosphereLUT::Get(renderer, m_materialParameters.atmosphere) : nullptr;
 
 		m_surfaceMaterial->specialParameter0 = &m_materialParameters;
 
@@ -404,6 +588,7 @@ void GeoSphere::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView
 			// make atmosphere sphere slightly bigger than required so
 			// that the edges of the pixel shader atmosphere jizz doesn't
 			// show ugly polygonal angles
+			Graphics::Renderer::GpuTimerTicket gt(renderer, Graphics::Stats::GPU_TIMER_ATMOSPHERES);
 			DrawAtmosphereSurface(renderer, trans, campos,
 				m_materialParameters.atmosphere.atmosRadius*1.01,
 				m_atmosRenderState, m_atmosphereMaterial.get());
@@ -439,8 +624,12 @@ void GeoSphere::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView
 
 	renderer->SetTransform(modelView);
 
-	for (int i=0; i<NUM_PATCHES; i++) {
-		m_patches[i]->Render(renderer, campos, modelView, frustum);
+	const GeoPatchHorizon *horizon = BuildHorizon(campos);
+	{
+		Graphics::Renderer::GpuTimerTicket gt(renderer, Graphics::Stats::GPU_TIMER_TERRAIN);
+		for (int i=0; i<NUM_PATCHES; i++) {
+			m_patches[i]->Render(renderer, campos, modelView, frustum, horizon);
+		}
 	}
 
 	renderer->SetAmbientColor(oldAmbient);
@@ -448,6 +637,36 @@ void GeoSphere::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView
 	renderer->GetStats().AddToStatCount(Graphics::Stats::STAT_PLANETS, 1);
 }
 
+const GeoPatchHorizon *GeoSphere::BuildHorizon(const vector3d &campos)
+{
+	PROFILE_SCOPED()
+	if (!s_occlusionCulling)
+		return nullptr;
+	const double altitude = campos.Length() - 1.0;
+	if (altitude > OCCLUSION_MAX_ALTITUDE * GetMaxFeatureHeight())
+		return nullptr;
+
+	m_horizonLeaves.clear();
+	for (int i=0; i<NUM_PATCHES; i++) {
+		m_patches[i]->GatherLeaves(m_horizonLeaves);
+	}
+
+	// the nearest patches hide the most
+	const size_t numOccluders = std::min(OCCLUSION_NUM_OCCLUDERS, m_horizonLeaves.size());
+	std::partial_sort(m_horizonLeaves.begin(), m_horizonLeaves.begin() + numOccluders, m_horizonLeaves.end(),
+		[&campos](const GeoPatch *a, const GeoPatch *b) {
+			return a->GetCentroidDistanceSqr(campos) < b->GetCentroidDistanceSqr(campos);
+		});
+
+	if (!m_horizon)
+		m_horizon.reset(new GeoPatchHorizon());
+	m_horizon->Reset(campos);
+	for (size_t i = 0; i < numOccluders; i++) {
+		m_horizonLeaves[i]->AddToHorizon(*m_horizon);
+	}
+	return m_horizon->HasOccluders() ? m_horizon.get() : nullptr;
+}
+
 void GeoSphere::SetUpMaterials()
 {
 	//solid
@@ -495,6 +714,9 @@ void GeoSphere::SetUpMaterials()
 	if (bEnableEclipse) {
 		surfDesc.quality |= Graphics::HAS_ECLIPSES;
 	}
+	if (s_patchContext->UseCompactVertices()) {
+		surfDesc.quality |= Graphics::HAS_COMPACT_VERTICES;
+	}
 	m_surfaceMaterial.reset(Pi::renderer->CreateMaterial(surfDesc));
 
 	{
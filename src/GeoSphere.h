@@ -22,6 +22,7 @@ namespace Graphics { class Renderer; }
 class SystemBody;
 class GeoPatch;
 class GeoPatchContext;
+class GeoPatchHorizon;
 class SQuadSplitRequest;
 class SQuadSplitResult;
 class SSingleSplitResult;
@@ -54,7 +55,24 @@ public:
 	static void Init();
 	static void Uninit();
 	static void UpdateAllGeoSpheres();
+	// resets the per frame patch upload budget
+	static void BeginFrame();
+	// false once this frame's uploads are used up
+	static bool TakeUploadBudget(const size_t bytes);
 	static void OnChangeDetailLevel();
+	// patches split when the camera is nearer than their split distance
+	// times this. below 1 gives coarser terrain without rebuilding anything
+	static void SetSplitDistanceScale(double scale) { s_splitDistanceScale = scale; }
+	static double GetSplitDistanceScale() { return s_splitDistanceScale; }
+	// a sphere for a body that's going away, eg. with its Space on
+	// hyperspace. it's kept, up to the keep-alive budget, for Adopt to hand
+	// back if the same body turns up again, otherwise it's deleted
+	static void KeepAlive(GeoSphere *sphere);
+	// a kept sphere of the same body, with its patches as they were left,
+	// or null if there isn't one
+	static GeoSphere *Adopt(const SystemBody *body);
+	// deletes all kept spheres
+	static void ClearKeptAlive();
 	static bool OnAddQuadSplitResult(const SystemPath &path, SQuadSplitResult *res);
 	static bool OnAddSingleSplitResult(const SystemPath &path, SSingleSplitResult *res);
 	// in sbody radii
@@ -70,7 +88,12 @@ public:
 
 private:
 	void BuildFirstPatches();
+	void ClearSplitResults();
+	void GetMemoryUsage(size_t &cpuBytes, size_t &gpuBytes) const;
 	void CalculateMaxPatchDepth();
+	void UpdatePrefetchPath();
+	// returns null when there's nothing worth occlusion testing against
+	const GeoPatchHorizon *BuildHorizon(const vector3d &campos);
 	inline vector3d GetColor(const vector3d &p, double height, const vector3d &norm) const {
 		return m_terrain->GetColor(p, height, norm);
 	}
@@ -84,7 +107,18 @@ private:
 	bool m_hasTempCampos;
 	vector3d m_tempCampos;
 
+	// where the camera is expected to be a few seconds from now, patches
+	// along the way get low priority split requests ahead of time
+	bool m_hasPrevCampos;
+	vector3d m_prevCampos;
+	vector3d m_camVelocity;
+	vector3d m_prefetchPos;
+
+	std::unique_ptr<GeoPatchHorizon> m_horizon;
+	std::vector<GeoPatch*> m_horizonLeaves;
+
 	static RefCountedPtr<GeoPatchContext> s_patchContext;
+	static double s_splitDistanceScale;
 
 	virtual void SetUpMaterials();
 
@@ -97,6 +131,13 @@ private:
 	EGSInitialisationStage m_initStage;
 
 	Sint32 m_maxDepth;
+
+	// while kept alive, which body it was made for. m_sbody is left
+	// dangling meanwhile, its system may well be gone
+	SystemPath m_keptPath;
+	Uint32 m_keptSeed;
+	size_t m_keptCpuBytes;
+	size_t m_keptGpuBytes;
 };
 
 #endif /* _GEOSPHERE_H */
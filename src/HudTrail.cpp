@@ -7,11 +7,28 @@
 
 const float UPDATE_INTERVAL = 0.1f;
 const Uint16 MAX_POINTS = 100;
+// points further than this from the anchor get a new one, to keep them
+// precise enough as floats
+const double REANCHOR_DIST = 100000.0;
+// sample numbers go to the shader as floats, and wrap before they'd lose precision
+const Uint32 SAMPLE_WRAP = 65536;
+
+// the segment from each point back to the one before it is two vertices,
+// tagged with their sample numbers for the fade. segments go round a ring of
+// MAX_POINTS slots, so adding a point only sends those two vertices
+static inline void SetSegment(Graphics::VertexArray &va, Uint32 idx, const vector3f &from, const vector3f &to, Uint32 sample)
+{
+	va.Set(idx,   from, vector2f(float((sample - 1) % SAMPLE_WRAP), 0.f));
+	va.Set(idx+1, to,   vector2f(float(sample % SAMPLE_WRAP), 0.f));
+}
 
 HudTrail::HudTrail(Body *b, const Color& c)
 : m_body(b)
 , m_updateTime(0.f)
 , m_color(c)
+, m_trailPoints(MAX_POINTS + 1)
+, m_numPoints(0)
+, m_segment(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0, 2)
 {
 	m_currentFrame = b->GetFrame();
 
@@ -19,6 +36,23 @@ HudTrail::HudTrail(Body *b, const Color& c)
 	rsd.blendMode = Graphics::BLEND_ALPHA_ONE;
 	rsd.depthWrite = false;
 	m_renderState = Pi::renderer->CreateRenderState(rsd);
+
+	Graphics::MaterialDescriptor desc;
+	desc.effect = Graphics::EFFECT_TRAIL;
+	m_material.Reset(Pi::renderer->CreateMaterial(desc));
+	m_material->specialParameter0 = &m_params;
+
+	Graphics::VertexBufferDesc vbd;
+	vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+	vbd.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
+	vbd.attrib[1].semantic = Graphics::ATTRIB_UV0;
+	vbd.attrib[1].format = Graphics::ATTRIB_FORMAT_FLOAT2;
+	vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;
+	vbd.numVertices = MAX_POINTS * 2;
+	m_vbuffer.reset(Pi::renderer->CreateVertexBuffer(vbd));
+
+	m_segment.Add(vector3f(0.f), vector2f(0.f));
+	m_segment.Add(vector3f(0.f), vector2f(0.f));
 }
 
 void HudTrail::Update(float time)
@@ -32,55 +66,75 @@ void HudTrail::Update(float time)
 		
 		if( !m_currentFrame ) {
 			m_currentFrame = bodyFrame;
-			m_trailPoints.clear();
+			m_numPoints = 0;
 		}
 		
 		if( bodyFrame==m_currentFrame )
-			m_trailPoints.push_back(m_body->GetInterpPosition());
+			AddPoint(m_body->GetInterpPosition());
+	}
+}
+
+void HudTrail::AddPoint(const vector3d &pos)
+{
+	const Uint32 sample = m_numPoints++;
+	m_trailPoints[sample % m_trailPoints.size()] = pos;
+	if (sample == 0) {
+		m_anchor = pos;
+		return;
 	}
 
-	while (m_trailPoints.size() > MAX_POINTS)
-		m_trailPoints.pop_front();
+	if ((pos - m_anchor).LengthSqr() > REANCHOR_DIST * REANCHOR_DIST) {
+		m_anchor = pos;
+		Rebuild();
+		return;
+	}
+
+	const vector3d &prev = m_trailPoints[(sample - 1) % m_trailPoints.size()];
+	SetSegment(m_segment, 0, vector3f(prev - m_anchor), vector3f(pos - m_anchor), sample);
+	m_vbuffer->PopulateRange(m_segment, ((sample - 1) % MAX_POINTS) * 2);
+}
+
+// every segment again, after the anchor has moved
+void HudTrail::Rebuild()
+{
+	PROFILE_SCOPED();
+	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0, MAX_POINTS * 2);
+	for (Uint32 i = 0; i < MAX_POINTS * 2; i++)
+		va.Add(vector3f(0.f), vector2f(0.f));
+
+	const Uint32 first = m_numPoints > MAX_POINTS ? m_numPoints - MAX_POINTS : 1;
+	for (Uint32 sample = first; sample < m_numPoints; sample++) {
+		const vector3d &from = m_trailPoints[(sample - 1) % m_trailPoints.size()];
+		const vector3d &to = m_trailPoints[sample % m_trailPoints.size()];
+		SetSegment(va, ((sample - 1) % MAX_POINTS) * 2, vector3f(from - m_anchor), vector3f(to - m_anchor), sample);
+	}
+	m_vbuffer->Populate(va);
 }
 
 void HudTrail::Render(Graphics::Renderer *r)
 {
 	PROFILE_SCOPED();
 	//render trail
-	if (m_trailPoints.size() > 1) {
-		const vector3d vpos = m_transform * m_body->GetInterpPosition();
+	if (m_numPoints > 1) {
+		const vector3d vpos = m_transform * m_anchor;
 		m_transform[12] = vpos.x;
 		m_transform[13] = vpos.y;
 		m_transform[14] = vpos.z;
 		m_transform[15] = 1.0;
 
-		static std::vector<vector3f> tvts;
-		static std::vector<Color> colors;
-		tvts.clear();
-		colors.clear();
-		const vector3d curpos = m_body->GetInterpPosition();
-		tvts.reserve(MAX_POINTS);
-		colors.reserve(MAX_POINTS);
-		tvts.push_back(vector3f(0.f));
-		colors.push_back(Color(0.f));
-		float alpha = 1.f;
-		const float decrement = 1.f / m_trailPoints.size();
-		const Color tcolor = m_color;
-		for (Uint16 i = m_trailPoints.size()-1; i > 0; i--) {
-			tvts.push_back(-vector3f(curpos - m_trailPoints[i]));
-			alpha -= decrement;
-			colors.push_back(tcolor);
-			colors.back().a = Uint8(alpha * 255);
-		}
+		// the fade is done in the shader, from each point's age
+		m_params.head = float((m_numPoints - 1) % SAMPLE_WRAP);
+		m_params.count = float(std::min(m_numPoints, Uint32(MAX_POINTS)));
+		m_material->diffuse = m_color;
+		m_vbuffer->SetVertexCount(std::min(m_numPoints - 1, Uint32(MAX_POINTS)) * 2);
 
 		r->SetTransform(m_transform);
-		m_lines.SetData(tvts.size(), &tvts[0], &colors[0]);
-		m_lines.Draw(r, m_renderState, Graphics::LINE_STRIP);
+		r->DrawBuffer(m_vbuffer.get(), m_renderState, m_material.Get(), Graphics::LINE_SINGLE);
 	}
 }
 
 void HudTrail::Reset(const Frame *newFrame)
 {
 	m_currentFrame = newFrame;
-	m_trailPoints.clear();
+	m_numPoints = 0;
 }
@@ -9,11 +9,19 @@
 #include "libs.h"
 #include "Body.h"
 #include "graphics/Renderer.h"
-#include "graphics/Drawables.h"
+#include "graphics/Material.h"
+#include "graphics/VertexArray.h"
+#include "graphics/VertexBuffer.h"
 
 class HudTrail
 {
 public:
+	// what the trail material needs to fade the points
+	struct TrailParameters {
+		float head;
+		float count;
+	};
+
 	HudTrail(Body *b, const Color&);
 	void Update(float time);
 	void Render(Graphics::Renderer *r);
@@ -23,14 +31,24 @@ public:
 	void SetTransform(const matrix4x4d &t) { m_transform = t; }
 
 private:
+	void AddPoint(const vector3d &pos);
+	void Rebuild();
+
 	Body *m_body;
 	const Frame *m_currentFrame;
 	float m_updateTime;
 	Color m_color;
 	matrix4x4d m_transform;
-	std::deque<vector3d> m_trailPoints;
+	// ring of the last few points, and how many have been added since the
+	// trail was reset. they go on the GPU relative to the anchor
+	std::vector<vector3d> m_trailPoints;
+	Uint32 m_numPoints;
+	vector3d m_anchor;
+	TrailParameters m_params;
 	Graphics::RenderState *m_renderState;
-	Graphics::Drawables::Lines m_lines;
+	RefCountedPtr<Graphics::Material> m_material;
+	std::unique_ptr<Graphics::VertexBuffer> m_vbuffer;
+	Graphics::VertexArray m_segment;
 };
 
 #endif
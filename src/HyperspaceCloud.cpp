@@ -95,7 +95,7 @@ void HyperspaceCloud::LoadFromJson(const Json::Value &jsonObj, Space *space)
 	Body::LoadFromJson(jsonObj, space);
 
 	if (!jsonObj.isMember("hyperspace_cloud")) throw SavedGameCorruptException();
-	Json::Value hyperspaceCloudObj = jsonObj["hyperspace_cloud"];
+	const Json::Value &hyperspaceCloudObj = jsonObj["hyperspace_cloud"];
 
 	if (!hyperspaceCloudObj.isMember("vel")) throw SavedGameCorruptException();
 	if (!hyperspaceCloudObj.isMember("birth_date")) throw SavedGameCorruptException();
@@ -109,7 +109,7 @@ void HyperspaceCloud::LoadFromJson(const Json::Value &jsonObj, Space *space)
 
 	if (hyperspaceCloudObj.isMember("ship"))
 	{
-		Json::Value shipObj = hyperspaceCloudObj["ship"];
+		const Json::Value &shipObj = hyperspaceCloudObj["ship"];
 		m_ship = static_cast<Ship*>(Body::FromJson(shipObj, space));
 	}
 }
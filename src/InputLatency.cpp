@@ -0,0 +1,156 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "InputLatency.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const char *s_stageNames[InputLatency::STAGE_MAX] = {
+	"queued", "tick", "swap", "total"
+};
+
+// upper edges in milliseconds, the last bucket takes the rest. around the
+// frame times at 240, 120, 60, 30... fps
+static const double s_bucketEdges[] = { 4.0, 8.0, 12.0, 16.7, 25.0, 33.3, 50.0, 66.7, 100.0, 150.0, 250.0 };
+
+// inputs the controls haven't read by then are dropped
+static const double STALE_SECONDS = 1.0;
+
+static double Seconds(Uint64 ticks)
+{
+	return double(ticks) / double(SDL_GetPerformanceFrequency());
+}
+
+InputLatency::InputLatency()
+{
+	Clear();
+}
+
+//static
+const char *InputLatency::GetStageName(Stage stage)
+{
+	assert(stage < STAGE_MAX);
+	return s_stageNames[stage];
+}
+
+void InputLatency::OnEvent(const SDL_Event &event)
+{
+	switch (event.type) {
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+		case SDL_MOUSEMOTION:
+		case SDL_JOYAXISMOTION:
+		case SDL_JOYHATMOTION:
+		case SDL_JOYBUTTONDOWN:
+		case SDL_JOYBUTTONUP:
+			break;
+		default:
+			return;
+	}
+	if (m_pending.valid)
+		return;
+	m_pending.valid = true;
+	// the event timestamp is only to the millisecond, and from another clock
+	m_pending.queued = std::max(0.0, 0.001 * double(Sint32(SDL_GetTicks() - event.common.timestamp)));
+	m_pending.polled = SDL_GetPerformanceCounter();
+}
+
+void InputLatency::OnControlsPolled()
+{
+	// a second tick before the swap can't make the frame any sooner
+	if (!m_pending.valid || m_consumed.valid)
+		return;
+	m_consumed = m_pending;
+	m_consumed.ticked = SDL_GetPerformanceCounter();
+	m_pending.valid = false;
+}
+
+void InputLatency::OnSwap()
+{
+	const Uint64 now = SDL_GetPerformanceCounter();
+	if (m_consumed.valid) {
+		const double tick = Seconds(m_consumed.ticked - m_consumed.polled);
+		const double swap = Seconds(now - m_consumed.ticked);
+		Add(STAGE_QUEUED, m_consumed.queued);
+		Add(STAGE_TICK, tick);
+		Add(STAGE_SWAP, swap);
+		Add(STAGE_TOTAL, m_consumed.queued + tick + swap);
+		m_consumed.valid = false;
+		m_samples++;
+	}
+	if (m_pending.valid && Seconds(now - m_pending.polled) > STALE_SECONDS) {
+		m_pending.valid = false;
+		m_dropped++;
+	}
+}
+
+void InputLatency::Add(Stage stage, double seconds)
+{
+	const double ms = seconds * 1e3;
+	int bucket = 0;
+	while (bucket < NUM_BUCKETS - 1 && ms >= s_bucketEdges[bucket])
+		bucket++;
+	m_counts[stage][bucket]++;
+	m_sum[stage] += ms;
+	m_max[stage] = std::max(m_max[stage], ms);
+}
+
+std::string InputLatency::DumpHistograms() const
+{
+	if (!m_samples)
+		return "no input followed\n";
+
+	std::string out;
+	char buf[128];
+	snprintf(buf, sizeof(buf), "%u inputs followed to the screen, %u never read\n", m_samples, m_dropped);
+	out += buf;
+	snprintf(buf, sizeof(buf), "%-12s", "ms");
+	out += buf;
+	for (int s = 0; s < STAGE_MAX; s++) {
+		snprintf(buf, sizeof(buf), " %8s", s_stageNames[s]);
+		out += buf;
+	}
+	out += "\n";
+
+	for (int b = 0; b < NUM_BUCKETS; b++) {
+		if (b < NUM_BUCKETS - 1)
+			snprintf(buf, sizeof(buf), "< %-10.1f", s_bucketEdges[b]);
+		else
+			snprintf(buf, sizeof(buf), ">= %-9.1f", s_bucketEdges[b-1]);
+		out += buf;
+		for (int s = 0; s < STAGE_MAX; s++) {
+			snprintf(buf, sizeof(buf), " %8u", m_counts[s][b]);
+			out += buf;
+		}
+		out += "\n";
+	}
+
+	snprintf(buf, sizeof(buf), "%-12s", "mean");
+	out += buf;
+	for (int s = 0; s < STAGE_MAX; s++) {
+		snprintf(buf, sizeof(buf), " %8.2f", m_sum[s] / double(m_samples));
+		out += buf;
+	}
+	snprintf(buf, sizeof(buf), "\n%-12s", "max");
+	out += buf;
+	for (int s = 0; s < STAGE_MAX; s++) {
+		snprintf(buf, sizeof(buf), " %8.2f", m_max[s]);
+		out += buf;
+	}
+	out += "\n";
+	return out;
+}
+
+void InputLatency::Clear()
+{
+	m_pending.valid = false;
+	m_consumed.valid = false;
+	m_samples = 0;
+	m_dropped = 0;
+	memset(m_counts, 0, sizeof(m_counts));
+	memset(m_sum, 0, sizeof(m_sum));
+	memset(m_max, 0, sizeof(m_max));
+}
@@ -0,0 +1,68 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _INPUTLATENCY_H
+#define _INPUTLATENCY_H
+
+#include "libs.h"
+#include <string>
+
+/*
+ * How long player input takes to show on screen, in three parts: from SDL
+ * seeing the event to HandleEvents taking it off the queue, from there to
+ * the physics tick where the player's ship controller reads the controls,
+ * and from that tick to the swap of the frame that draws it. The swap
+ * returning is as close to the photons as we can see; the driver may still
+ * be holding the frame.
+ *
+ * Only the first input after each tick is followed, the others in the same
+ * gap see the same tick and swap, just with less of a wait.
+ */
+class InputLatency {
+public:
+	enum Stage {
+		STAGE_QUEUED, // in SDL's queue
+		STAGE_TICK,   // waiting for a physics tick
+		STAGE_SWAP,   // from the tick to the end of the swap
+		STAGE_TOTAL,
+		STAGE_MAX
+	};
+
+	InputLatency();
+
+	// in HandleEvents, for every event. only control input is followed
+	void OnEvent(const SDL_Event &event);
+	// the player's controls were read
+	void OnControlsPolled();
+	// the frame is swapped
+	void OnSwap();
+
+	Uint32 GetNumSamples() const { return m_samples; }
+	// a millisecond histogram of each stage
+	std::string DumpHistograms() const;
+	void Clear();
+
+	static const char *GetStageName(Stage stage);
+
+private:
+	static const int NUM_BUCKETS = 12;
+
+	void Add(Stage stage, double seconds);
+
+	struct Input {
+		bool valid;
+		double queued;
+		Uint64 polled;
+		Uint64 ticked;
+	};
+	Input m_pending;  // waiting for a tick
+	Input m_consumed; // waiting for the swap
+
+	Uint32 m_samples;
+	Uint32 m_dropped; // never read by a tick, eg while docked or paused
+	Uint32 m_counts[STAGE_MAX][NUM_BUCKETS];
+	double m_sum[STAGE_MAX];
+	double m_max[STAGE_MAX];
+};
+
+#endif
@@ -3,6 +3,157 @@
 
 #include "JobQueue.h"
 #include "StringF.h"
+#include "SDL_timer.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+#ifdef PIONEER_PROFILER
+static double TicksToSeconds(Uint64 ticks)
+{
+	return double(ticks) / double(SDL_GetPerformanceFrequency());
+}
+
+void JobStats::Histogram::Add(double t)
+{
+	count++;
+	total += t;
+	max = std::max(max, t);
+	const double micros = t * 1e6;
+	int bucket = 0;
+	while (bucket < NUM_BUCKETS-1 && micros >= double(1 << bucket))
+		bucket++;
+	buckets[bucket]++;
+}
+
+double JobStats::Histogram::Percentile(double fraction) const
+{
+	const Uint64 target = Uint64(fraction * double(count));
+	Uint64 seen = 0;
+	for (int i = 0; i < NUM_BUCKETS-1; i++) {
+		seen += buckets[i];
+		if (seen > target)
+			return double(1 << i) * 1e-6;
+	}
+	return max;
+}
+
+JobStats::JobStats()
+{
+	m_lock = SDL_CreateMutex();
+	Reset();
+}
+
+JobStats::~JobStats()
+{
+	SDL_DestroyMutex(m_lock);
+}
+
+void JobStats::AddWait(const char *name, double t)
+{
+	SDL_LockMutex(m_lock);
+	m_entries[name].wait.Add(t);
+	SDL_UnlockMutex(m_lock);
+}
+
+void JobStats::AddRun(const char *name, double t, Uint32 threadIdx)
+{
+	SDL_LockMutex(m_lock);
+	m_entries[name].run.Add(t);
+	m_busy[threadIdx] += t;
+	SDL_UnlockMutex(m_lock);
+}
+
+void JobStats::AddFinish(const char *name, double t)
+{
+	SDL_LockMutex(m_lock);
+	m_entries[name].finish.Add(t);
+	SDL_UnlockMutex(m_lock);
+}
+
+void JobStats::AddCancel(const char *name)
+{
+	SDL_LockMutex(m_lock);
+	m_entries[name].cancelled++;
+	SDL_UnlockMutex(m_lock);
+}
+
+void JobStats::Reset()
+{
+	SDL_LockMutex(m_lock);
+	m_entries.clear();
+	for (Uint32 i = 0; i < MAX_THREADS; i++)
+		m_busy[i] = 0.0;
+	m_resetTime = SDL_GetPerformanceCounter();
+	SDL_UnlockMutex(m_lock);
+}
+
+std::string JobStats::Dump(Uint32 numThreads) const
+{
+	static const char *names[] = { "wait", "run", "finish" };
+	char buf[256];
+	std::string out;
+
+	SDL_LockMutex(m_lock);
+	const double elapsed = TicksToSeconds(SDL_GetPerformanceCounter() - m_resetTime);
+
+	snprintf(buf, sizeof(buf), "%-24s %-6s %8s %10s %10s %10s %10s %10s\n", "job", "stage", "count", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms");
+	out += buf;
+	for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+		const Histogram *h[] = { &it->second.wait, &it->second.run, &it->second.finish };
+		for (int i = 0; i < 3; i++) {
+			const double mean = h[i]->count ? h[i]->total / double(h[i]->count) : 0.0;
+			snprintf(buf, sizeof(buf), "%-24s %-6s %8llu %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+				i == 0 ? it->first : "", names[i], static_cast<unsigned long long>(h[i]->count),
+				mean * 1e3, h[i]->Percentile(0.5) * 1e3, h[i]->Percentile(0.9) * 1e3, h[i]->Percentile(0.99) * 1e3, h[i]->max * 1e3);
+			out += buf;
+		}
+		snprintf(buf, sizeof(buf), "%-24s %-6s %8llu\n", "", "cancel", static_cast<unsigned long long>(it->second.cancelled));
+		out += buf;
+	}
+
+	snprintf(buf, sizeof(buf), "occupancy over %.1fs:", elapsed);
+	out += buf;
+	for (Uint32 i = 0; i < numThreads; i++) {
+		snprintf(buf, sizeof(buf), " %.0f%%", elapsed > 0.0 ? 100.0 * m_busy[i] / elapsed : 0.0);
+		out += buf;
+	}
+	out += "\n";
+	SDL_UnlockMutex(m_lock);
+
+	return out;
+}
+
+static std::atomic<Uint64> s_nextTraceId(0);
+
+void JobQueue::MarkQueued(Job *job)
+{
+	PROFILE_SCOPED()
+	job->m_queuedAt = SDL_GetPerformanceCounter();
+	job->m_traceId = ++s_nextTraceId;
+	PROFILE_FLOW_START(job->GetName(), job->m_traceId)
+}
+
+void JobQueue::RunJob(Job *job, Uint32 threadIdx)
+{
+	PROFILE_SCOPED_RAW(job->GetName())
+	PROFILE_FLOW_STEP(job->GetName(), job->m_traceId)
+	const Uint64 start = SDL_GetPerformanceCounter();
+	m_stats.AddWait(job->GetName(), TicksToSeconds(start - job->m_queuedAt));
+	job->OnRun();
+	job->m_ranAt = SDL_GetPerformanceCounter();
+	m_stats.AddRun(job->GetName(), TicksToSeconds(job->m_ranAt - start), threadIdx);
+}
+
+void JobQueue::FinishJob(Job *job)
+{
+	PROFILE_SCOPED_RAW(job->GetName())
+	PROFILE_FLOW_END(job->GetName(), job->m_traceId)
+	const Uint64 start = SDL_GetPerformanceCounter();
+	job->OnFinish();
+	m_stats.AddFinish(job->GetName(), TicksToSeconds(SDL_GetPerformanceCounter() - start));
+}
+#endif
 
 void Job::UnlinkHandle()
 {
@@ -16,6 +167,15 @@ Job::~Job()
 	UnlinkHandle();
 }
 
+void Job::SetDeadline(Uint32 milliseconds)
+{
+	assert(!m_handle);
+	m_deadline = SDL_GetTicks() + milliseconds;
+	// zero means no deadline
+	if (!m_deadline)
+		m_deadline = 1;
+}
+
 //static
 unsigned long long Job::Handle::s_nextId(0);
 
@@ -70,6 +230,12 @@ Job::Handle& Job::Handle::operator=(Handle&& other)
 	return *this;
 }
 
+void Job::Handle::SetPriority(Priority priority)
+{
+	if (m_job && m_queue && m_job->GetPriority() != priority)
+		m_queue->Reprioritise(m_job, priority);
+}
+
 Job::Handle::~Handle()
 {
 	if (m_job && m_queue) {
@@ -82,31 +248,247 @@ Job::Handle::~Handle()
 }
 
 
-AsyncJobQueue::AsyncJobQueue(Uint32 numRunners) :
+JobQueue::JobQueue()
+{
+	m_dependencyLock = SDL_CreateMutex();
+}
+
+//virtual
+JobQueue::~JobQueue()
+{
+	// anything still parked is waiting on a job that was deleted without
+	// running, so it never will
+	for (Job *job : m_waiting)
+		delete job;
+	SDL_DestroyMutex(m_dependencyLock);
+}
+
+std::string JobQueue::DumpStats(bool reset)
+{
+#ifdef PIONEER_PROFILER
+	const std::string out = m_stats.Dump(GetNumThreads());
+	if (reset)
+		m_stats.Reset();
+	return out;
+#else
+	return "job statistics are only collected in profiler builds\n";
+#endif
+}
+
+namespace {
+
+// shared between ParallelFor and its helper jobs. helpers that only get to
+// run after the loop is over find nothing left to claim
+struct ParallelForState {
+	ParallelForState(Uint32 count_, Uint32 batchSize_, const std::function<void(Uint32,Uint32)> &fn_) :
+		count(count_), batchSize(batchSize_), numBatches((count_ + batchSize_ - 1) / batchSize_), fn(fn_),
+		next(0), done(0)
+	{
+		lock = SDL_CreateMutex();
+		doneCond = SDL_CreateCond();
+	}
+	~ParallelForState() {
+		SDL_DestroyCond(doneCond);
+		SDL_DestroyMutex(lock);
+	}
+
+	// claim and run batches until there are none left
+	void Work() {
+		for (;;) {
+			const Uint32 batch = next++;
+			if (batch >= numBatches)
+				return;
+			const Uint32 begin = batch * batchSize;
+			fn(begin, std::min(begin + batchSize, count));
+			if (++done == numBatches) {
+				SDL_LockMutex(lock);
+				SDL_CondBroadcast(doneCond);
+				SDL_UnlockMutex(lock);
+			}
+		}
+	}
+
+	const Uint32 count, batchSize, numBatches;
+	// only called for claimed batches, which all finish before ParallelFor
+	// returns, so the caller's function can be referenced rather than copied
+	const std::function<void(Uint32,Uint32)> &fn;
+	std::atomic<Uint32> next;
+	std::atomic<Uint32> done;
+	SDL_mutex *lock;
+	SDL_cond *doneCond;
+};
+
+class ParallelForJob : public Job {
+public:
+	ParallelForJob(const std::shared_ptr<ParallelForState> &state) : m_state(state) {}
+	virtual void OnRun() { m_state->Work(); }
+	virtual void OnFinish() {}
+	virtual const char *GetName() const { return "ParallelFor"; }
+private:
+	std::shared_ptr<ParallelForState> m_state;
+};
+
+}
+
+void JobQueue::ParallelFor(Uint32 count, Uint32 batchSize, const std::function<void(Uint32,Uint32)> &fn)
+{
+	PROFILE_SCOPED()
+	if (!count)
+		return;
+	assert(batchSize > 0);
+
+	std::shared_ptr<ParallelForState> state(new ParallelForState(count, batchSize, fn));
+
+	// one helper per runner at most; the main thread takes a share as well
+	const Uint32 helpers = std::min(GetNumThreads(), state->numBatches - 1);
+	std::vector<Job::Handle> handles;
+	handles.reserve(helpers);
+	for (Uint32 i = 0; i < helpers; i++) {
+		Job *job = new ParallelForJob(state);
+		job->SetPriority(Job::PRIORITY_HIGH);
+		handles.push_back(Queue(job));
+	}
+
+	state->Work();
+
+	SDL_LockMutex(state->lock);
+	while (state->done < state->numBatches)
+		SDL_CondWait(state->doneCond, state->lock);
+	SDL_UnlockMutex(state->lock);
+
+	// helpers that haven't started yet have nothing to do, so dropping the
+	// handles cancels them
+}
+
+bool JobQueue::AddDependencies(Job *job, const std::vector<Job*> &after)
+{
+	SDL_LockMutex(m_dependencyLock);
+	for (Job *before : after) {
+		if (before && !before->m_ran) {
+			before->m_dependents.push_back(job);
+			job->m_waitingOn++;
+		}
+	}
+	const bool waiting = job->m_waitingOn > 0;
+	if (waiting)
+		m_waiting.insert(job);
+	SDL_UnlockMutex(m_dependencyLock);
+	return waiting;
+}
+
+void JobQueue::ReleaseDependents(Job *job, std::vector<Job*> &ready)
+{
+	SDL_LockMutex(m_dependencyLock);
+	job->m_ran = true;
+	for (Job *dep : job->m_dependents) {
+		assert(dep->m_waitingOn > 0);
+		if (--dep->m_waitingOn == 0) {
+			m_waiting.erase(dep);
+			ready.push_back(dep);
+		}
+	}
+	job->m_dependents.clear();
+	SDL_UnlockMutex(m_dependencyLock);
+}
+
+bool JobQueue::CancelWaiting(Job *job)
+{
+	SDL_LockMutex(m_dependencyLock);
+	const bool waiting = m_waiting.count(job) > 0;
+	if (waiting) {
+		job->cancelled = true;
+		job->UnlinkHandle();
+	}
+	SDL_UnlockMutex(m_dependencyLock);
+	return waiting;
+}
+
+//static
+Uint32 JobQueue::PromoteOverdueJobs(std::deque<Job*> queues[Job::PRIORITY_COUNT], Uint32 now)
+{
+	Uint32 promoted = 0;
+	for (int p = 0; p < Job::PRIORITY_HIGH; p++) {
+		std::deque<Job*> &q = queues[p];
+		for (std::deque<Job*>::iterator i = q.begin(); i != q.end(); ) {
+			Job *job = *i;
+			if (job->IsOverdue(now)) {
+				i = q.erase(i);
+				job->m_priority = Job::PRIORITY_HIGH;
+				job->m_deadline = 0;
+				queues[Job::PRIORITY_HIGH].push_back(job);
+				promoted++;
+			} else
+				++i;
+		}
+	}
+	return promoted;
+}
+
+//static
+bool JobQueue::MoveJob(std::deque<Job*> queues[Job::PRIORITY_COUNT], Job *job, Job::Priority priority)
+{
+	std::deque<Job*> &q = queues[job->m_priority];
+	for (std::deque<Job*>::iterator i = q.begin(); i != q.end(); ++i) {
+		if (*i == job) {
+			q.erase(i);
+			job->m_priority = priority;
+			queues[priority].push_back(job);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+AsyncJobQueue::AsyncJobQueue(Uint32 numRunners, const Uint32 *reserved) :
+	m_pending(0),
+	m_deadlines(0),
 	m_shutdown(false)
 {
 	// Want to limit this for now to the maximum number of threads defined in the class
-	numRunners = std::min( numRunners, MAX_THREADS );
+	numRunners = std::max( std::min( numRunners, MAX_THREADS ), 1U );
 
-	m_queueLock = SDL_CreateMutex();
-	m_queueWaitCond = SDL_CreateCond();
+	m_waitLock = SDL_CreateMutex();
+	for (int lane = 0; lane < Job::LANE_COUNT; lane++) {
+		m_queueWaitCond[lane] = SDL_CreateCond();
+		m_lanePending[lane] = 0;
+		m_nextQueue[lane] = 0;
+	}
+
+	// the reserved runners come first, the rest are general
+	Uint32 runner = 0;
+	for (int lane = Job::LANE_GENERAL + 1; reserved && lane < Job::LANE_COUNT; lane++) {
+		for (Uint32 n = 0; n < reserved[lane] && runner + 1 < numRunners; n++) {
+			m_runnerLane[runner] = Job::Lane(lane);
+			m_laneRunners[lane].push_back(runner++);
+		}
+	}
+	for (; runner < numRunners; runner++) {
+		m_runnerLane[runner] = Job::LANE_GENERAL;
+		m_laneRunners[Job::LANE_GENERAL].push_back(runner);
+	}
 
+	// all the locks have to exist before the first runner starts looking for work
 	for (Uint32 i = 0; i < numRunners; i++) {
+		m_queueLock[i] = SDL_CreateMutex();
 		m_finishedLock[i] = SDL_CreateMutex();
-		m_runners.push_back(new JobRunner(this, i));
 	}
+	m_runners.reserve(numRunners);
+	for (Uint32 i = 0; i < numRunners; i++)
+		m_runners.push_back(new JobRunner(this, i));
 }
 
 AsyncJobQueue::~AsyncJobQueue()
 {
-	// flag shutdown. protected by the queue lock for convenience in GetJob
-	SDL_LockMutex(m_queueLock);
+	// flag shutdown. protected by the wait lock for convenience in GetJob
+	SDL_LockMutex(m_waitLock);
 	m_shutdown = true;
-	SDL_UnlockMutex(m_queueLock);
+	SDL_UnlockMutex(m_waitLock);
 
 	// broadcast to any waiting runners that they should try (and fail) to get
 	// a new job right now
-	SDL_CondBroadcast(m_queueWaitCond);
+	for (int lane = 0; lane < Job::LANE_COUNT; lane++)
+		SDL_CondBroadcast(m_queueWaitCond[lane]);
 
 	// Flag each job runner that we're being destroyed (with lock so no one
 	// else is running one of our functions). Both the flag and the mutex
@@ -124,75 +506,200 @@ AsyncJobQueue::~AsyncJobQueue()
 		delete (*i);
 
 	// delete any remaining jobs
-	for (std::deque<Job*>::iterator i = m_queue.begin(); i != m_queue.end(); ++i)
-		delete (*i);
 	for (uint32_t threadIdx=0; threadIdx<numThreads; threadIdx++) {
-		for (std::deque<Job*>::iterator i = m_finished[threadIdx].begin(); i != m_finished[threadIdx].end(); ++i) {
-			delete (*i);
+		for (int p = 0; p < Job::PRIORITY_COUNT; p++) {
+			for (std::deque<Job*>::iterator i = m_queue[threadIdx][p].begin(); i != m_queue[threadIdx][p].end(); ++i)
+				delete (*i);
 		}
+		for (std::deque<Job*>::iterator i = m_finished[threadIdx].begin(); i != m_finished[threadIdx].end(); ++i)
+			delete (*i);
 	}
 
 	// only us left now, we can clean up and get out of here
 	for (uint32_t threadIdx=0; threadIdx<numThreads; threadIdx++) {
 		SDL_DestroyMutex(m_finishedLock[threadIdx]);
+		SDL_DestroyMutex(m_queueLock[threadIdx]);
 	}
-	SDL_DestroyCond(m_queueWaitCond);
-	SDL_DestroyMutex(m_queueLock);
+	for (int lane = 0; lane < Job::LANE_COUNT; lane++)
+		SDL_DestroyCond(m_queueWaitCond[lane]);
+	SDL_DestroyMutex(m_waitLock);
 }
 
 Job::Handle AsyncJobQueue::Queue(Job *job, JobClient *client)
 {
 	Job::Handle handle(job, this, client);
 
-	// push the job onto the queue
-	SDL_LockMutex(m_queueLock);
-	m_queue.push_back(job);
-	SDL_UnlockMutex(m_queueLock);
+	// deal the job out to the next runner's queue. anyone idle will steal it
+	// if that runner is busy
+	Enqueue(job, NextQueue(job));
+	return handle;
+}
+
+Job::Handle AsyncJobQueue::QueueAfter(Job *job, const std::vector<Job*> &after, JobClient *client)
+{
+	Job::Handle handle(job, this, client);
 
-	// and tell a waiting runner that there's one available
-	SDL_CondSignal(m_queueWaitCond);
+	if (!AddDependencies(job, after))
+		Enqueue(job, NextQueue(job));
 	return handle;
 }
 
-// called by the runner to get a new job
-Job *AsyncJobQueue::GetJob()
+Uint32 AsyncJobQueue::NextQueue(const Job *job)
 {
-	SDL_LockMutex(m_queueLock);
+	const Job::Lane lane = GetQueueLane(job);
+	const std::vector<Uint32> &runners = m_laneRunners[lane];
+	const Uint32 queueIdx = runners[m_nextQueue[lane]];
+	m_nextQueue[lane] = (m_nextQueue[lane] + 1) % runners.size();
+	return queueIdx;
+}
+
+// put a runnable job on one of the runner queues
+void AsyncJobQueue::Enqueue(Job *job, const Uint32 queueIdx)
+{
+	if (job->HasDeadline())
+		++m_deadlines;
+	MarkQueued(job);
+
+	SDL_LockMutex(m_queueLock[queueIdx]);
+	m_queue[queueIdx][job->GetPriority()].push_back(job);
+	SDL_UnlockMutex(m_queueLock[queueIdx]);
+
+	// and tell a waiting runner that there's one available. general runners
+	// can help out with any lane
+	const Job::Lane lane = m_runnerLane[queueIdx];
+	SDL_LockMutex(m_waitLock);
+	++m_pending;
+	++m_lanePending[lane];
+	SDL_CondSignal(m_queueWaitCond[lane]);
+	if (lane != Job::LANE_GENERAL)
+		SDL_CondSignal(m_queueWaitCond[Job::LANE_GENERAL]);
+	SDL_UnlockMutex(m_waitLock);
+}
+
+// queue up jobs whose dependencies have been released. the ones that were
+// cancelled while waiting never run, they go straight to the finished list
+// (and release anything waiting on them in turn)
+void AsyncJobQueue::Dispatch(std::vector<Job*> &ready, const uint8_t threadIdx)
+{
+	while (!ready.empty()) {
+		Job *job = ready.back();
+		ready.pop_back();
+		if (job->cancelled) {
+			ReleaseDependents(job, ready);
+			SDL_LockMutex(m_finishedLock[threadIdx]);
+			m_finished[threadIdx].push_back(job);
+			SDL_UnlockMutex(m_finishedLock[threadIdx]);
+		} else {
+			// our own queue if we can run it, otherwise one that can
+			const Job::Lane lane = GetQueueLane(job);
+			const std::vector<Uint32> &runners = m_laneRunners[lane];
+			Enqueue(job, m_runnerLane[threadIdx] == lane ? threadIdx : runners[threadIdx % runners.size()]);
+		}
+	}
+}
+
+// look for a job without blocking. highest priority first, and for each
+// priority our own queue first, then everyone else's. runners reserved for
+// a lane only look at their lane's queues
+Job *AsyncJobQueue::TryGetJob(const uint8_t threadIdx)
+{
+	const Job::Lane lane = m_runnerLane[threadIdx];
+	if ((lane == Job::LANE_GENERAL ? m_pending : m_lanePending[lane]) == 0)
+		return 0;
+
+	const uint32_t numRunners = m_runners.size();
+	for (int p = Job::PRIORITY_COUNT - 1; p >= 0; p--) {
+		for (uint32_t n = 0; n < numRunners; ++n) {
+			const uint32_t i = (threadIdx + n) % numRunners;
+			if (lane != Job::LANE_GENERAL && m_runnerLane[i] != lane)
+				continue;
+			std::deque<Job*> &q = m_queue[i][p];
+
+			SDL_LockMutex(m_queueLock[i]);
+			Job *job = 0;
+			if (!q.empty()) {
+				if (i == threadIdx) {
+					// our own queue, take the oldest
+					job = q.front();
+					q.pop_front();
+				} else {
+					// stealing, take from the other end to keep out of the owner's way
+					job = q.back();
+					q.pop_back();
+				}
+				--m_pending;
+				--m_lanePending[m_runnerLane[i]];
+				if (job->HasDeadline())
+					--m_deadlines;
+			}
+			SDL_UnlockMutex(m_queueLock[i]);
+
+			if (job)
+				return job;
+		}
+	}
 
+	return 0;
+}
+
+// called by the runner to get a new job
+Job *AsyncJobQueue::GetJob(const uint8_t threadIdx)
+{
 	// loop until a new job is available
 	Job *job = 0;
 	while (!job) {
+		job = TryGetJob(threadIdx);
+		if (job)
+			break;
+
+		SDL_LockMutex(m_waitLock);
+
 		// we're shutting down, so just get out of here
 		if (m_shutdown) {
-			SDL_UnlockMutex(m_queueLock);
+			SDL_UnlockMutex(m_waitLock);
 			return 0;
 		}
 
-		if (!m_queue.size())
-			// no jobs, go to sleep until one arrives
-			SDL_CondWait(m_queueWaitCond, m_queueLock);
-
-		else {
-			// got one, pop it and return it
-			job = m_queue.front();
-			m_queue.pop_front();
-		}
+		// no jobs, go to sleep until one arrives
+		const Job::Lane lane = m_runnerLane[threadIdx];
+		if ((lane == Job::LANE_GENERAL ? m_pending : m_lanePending[lane]) == 0)
+			SDL_CondWait(m_queueWaitCond[lane], m_waitLock);
 
+		SDL_UnlockMutex(m_waitLock);
 	}
 
-	SDL_UnlockMutex(m_queueLock);
-
 	return job;
 }
 
 // called by the runner when a job completes
 void AsyncJobQueue::Finish(Job *job, const uint8_t threadIdx)
 {
+	// start anything that was waiting on this job. has to happen before it
+	// goes on the finished list, the main thread may delete it after that
+	std::vector<Job*> ready;
+	ReleaseDependents(job, ready);
+	Dispatch(ready, threadIdx);
+
 	SDL_LockMutex(m_finishedLock[threadIdx]);
 	m_finished[threadIdx].push_back(job);
 	SDL_UnlockMutex(m_finishedLock[threadIdx]);
 }
 
+// bump anything that has waited past its deadline
+void AsyncJobQueue::PromoteOverdueJobs()
+{
+	if (m_deadlines == 0)
+		return;
+
+	const Uint32 now = SDL_GetTicks();
+	const uint32_t numRunners = m_runners.size();
+	for (uint32_t i = 0; i < numRunners; ++i) {
+		SDL_LockMutex(m_queueLock[i]);
+		m_deadlines -= JobQueue::PromoteOverdueJobs(m_queue[i], now);
+		SDL_UnlockMutex(m_queueLock[i]);
+	}
+}
+
 // call OnFinish methods for completed jobs, and clean up
 Uint32 AsyncJobQueue::FinishJobs()
 {
@@ -200,6 +707,9 @@ Uint32 AsyncJobQueue::FinishJobs()
 	Uint32 finished = 0;
 
 	const uint32_t numRunners = m_runners.size();
+
+	PromoteOverdueJobs();
+
 	for( uint32_t i=0; i<numRunners ; ++i) {
 		SDL_LockMutex(m_finishedLock[i]);
 		if( m_finished[i].empty() ) {
@@ -215,7 +725,7 @@ Uint32 AsyncJobQueue::FinishJobs()
 		// if its already been cancelled then its taken care of, so we just forget about it
 		if(!job->cancelled) {
 			job->UnlinkHandle();
-			job->OnFinish();
+			FinishJob(job);
 			finished++;
 		}
 
@@ -225,20 +735,95 @@ Uint32 AsyncJobQueue::FinishJobs()
 	return finished;
 }
 
+// as FinishJobs, but keep going round the runners until everything is
+// finished or we run out of time
+Uint32 AsyncJobQueue::FinishJobs(double timeBudget, Uint32 &deferred)
+{
+	PROFILE_SCOPED()
+	Uint32 finished = 0;
+
+	const Uint64 start = SDL_GetPerformanceCounter();
+	const Uint64 budget = Uint64(timeBudget * double(SDL_GetPerformanceFrequency()));
+
+	const uint32_t numRunners = m_runners.size();
+
+	PromoteOverdueJobs();
+
+	bool outOfTime = false;
+	bool found = true;
+	while (found && !outOfTime) {
+		found = false;
+		for( uint32_t i=0; i<numRunners ; ++i) {
+			if (finished > 0 && SDL_GetPerformanceCounter() - start >= budget) {
+				outOfTime = true;
+				break;
+			}
+
+			SDL_LockMutex(m_finishedLock[i]);
+			if( m_finished[i].empty() ) {
+				SDL_UnlockMutex(m_finishedLock[i]);
+				continue;
+			}
+			Job *job = m_finished[i].front();
+			m_finished[i].pop_front();
+			SDL_UnlockMutex(m_finishedLock[i]);
+
+			assert(job);
+			found = true;
+
+			// if its already been cancelled then its taken care of, so we just forget about it
+			if(!job->cancelled) {
+				job->UnlinkHandle();
+				FinishJob(job);
+				finished++;
+			}
+
+			delete job;
+		}
+	}
+
+	deferred = 0;
+	for( uint32_t i=0; i<numRunners ; ++i) {
+		SDL_LockMutex(m_finishedLock[i]);
+		deferred += m_finished[i].size();
+		SDL_UnlockMutex(m_finishedLock[i]);
+	}
+
+	return finished;
+}
+
 void AsyncJobQueue::Cancel(Job *job) {
-	// lock both queues, so we know that all jobs will stay put
-	SDL_LockMutex(m_queueLock);
+	MarkCancelled(job);
+
+	// still waiting on other jobs. it can't be deleted until they let go of it
+	if (CancelWaiting(job))
+		return;
+
+	// anything waiting on a job we drop from the queue gets released once
+	// all the locks are let go
+	std::vector<Job*> ready;
+
+	// lock all the queues, so we know that all jobs will stay put
 	const uint32_t numRunners = m_runners.size();
 	for( uint32_t i=0; i<numRunners ; ++i) {
+		SDL_LockMutex(m_queueLock[i]);
 		SDL_LockMutex(m_finishedLock[i]);
 	}
 
-	// check the waiting list. if its there then it hasn't run yet. just forget about it
-	for (std::deque<Job*>::iterator i = m_queue.begin(); i != m_queue.end(); ++i) {
-		if (*i == job) {
-			i = m_queue.erase(i);
-			delete job;
-			goto unlock;
+	// check the waiting lists. if its there then it hasn't run yet. just forget about it
+	for( uint32_t iRunner=0; iRunner<numRunners ; ++iRunner) {
+		std::deque<Job*> &q = m_queue[iRunner][job->GetPriority()];
+		for (std::deque<Job*>::iterator i = q.begin(); i != q.end(); ++i) {
+			if (*i == job) {
+				i = q.erase(i);
+				--m_pending;
+				--m_lanePending[m_runnerLane[iRunner]];
+				if (job->HasDeadline())
+					--m_deadlines;
+				ReleaseDependents(job, ready);
+				delete job;
+				goto unlock;
+			}
 		}
 	}
 
@@ -262,8 +847,22 @@ void AsyncJobQueue::Cancel(Job *job) {
 unlock:
 	for( uint32_t i=0; i<numRunners ; ++i) {
 		SDL_UnlockMutex(m_finishedLock[i]);
+		SDL_UnlockMutex(m_queueLock[i]);
+	}
+
+	Dispatch(ready, 0);
+}
+
+void AsyncJobQueue::Reprioritise(Job *job, Job::Priority priority)
+{
+	const uint32_t numRunners = m_runners.size();
+	for (uint32_t i = 0; i < numRunners; ++i) {
+		SDL_LockMutex(m_queueLock[i]);
+		const bool moved = MoveJob(m_queue[i], job, priority);
+		SDL_UnlockMutex(m_queueLock[i]);
+		if (moved)
+			return;
 	}
-	SDL_UnlockMutex(m_queueLock);
 }
 
 AsyncJobQueue::JobRunner::JobRunner(AsyncJobQueue *jq, const uint8_t idx) :
@@ -305,6 +904,9 @@ int AsyncJobQueue::JobRunner::Trampoline(void *data)
 
 void AsyncJobQueue::JobRunner::Main()
 {
+	// one name for all the runners, so the profiler gathers them together
+	PROFILE_THREAD_SCOPED_RAW("JobRunner")
+
 	Job *job;
 
 	// Lock to prevent destruction of the queue while calling GetJob.
@@ -313,7 +915,7 @@ void AsyncJobQueue::JobRunner::Main()
 		SDL_UnlockMutex(m_queueDestroyingLock);
 		return;
 	}
-	job = m_jobQueue->GetJob();
+	job = m_jobQueue->GetJob(m_threadIdx);
 	SDL_UnlockMutex(m_queueDestroyingLock);
 
 	while (job) {
@@ -323,7 +925,7 @@ void AsyncJobQueue::JobRunner::Main()
 		SDL_UnlockMutex(m_jobLock);
 
 		// run the thing
-		job->OnRun();
+		m_jobQueue->RunJob(job, m_threadIdx);
 
 		// Lock to prevent destruction of the queue while calling Finish
 		SDL_LockMutex(m_queueDestroyingLock);
@@ -346,7 +948,7 @@ void AsyncJobQueue::JobRunner::Main()
 			SDL_UnlockMutex(m_queueDestroyingLock);
 			return;
 		}
-		job = m_jobQueue->GetJob();
+		job = m_jobQueue->GetJob(m_threadIdx);
 		SDL_UnlockMutex(m_queueDestroyingLock);
 	}
 }
@@ -365,8 +967,10 @@ void AsyncJobQueue::JobRunner::SetQueueDestroyed()
 SyncJobQueue::~SyncJobQueue()
 {
 	// delete any remaining jobs
-	for (Job* j : m_queue)
-		delete j;
+	for (int p = 0; p < Job::PRIORITY_COUNT; p++) {
+		for (Job* j : m_queue[p])
+			delete j;
+	}
 	for (Job* j : m_finished)
 		delete j;
 }
@@ -374,10 +978,36 @@ SyncJobQueue::~SyncJobQueue()
 Job::Handle SyncJobQueue::Queue(Job *job, JobClient *client)
 {
 	Job::Handle handle(job, this, client);
-	m_queue.push_back(job);
+	MarkQueued(job);
+	m_queue[job->GetPriority()].push_back(job);
+	return handle;
+}
+
+Job::Handle SyncJobQueue::QueueAfter(Job *job, const std::vector<Job*> &after, JobClient *client)
+{
+	Job::Handle handle(job, this, client);
+	if (!AddDependencies(job, after)) {
+		MarkQueued(job);
+		m_queue[job->GetPriority()].push_back(job);
+	}
 	return handle;
 }
 
+void SyncJobQueue::Dispatch(std::vector<Job*> &ready)
+{
+	while (!ready.empty()) {
+		Job *job = ready.back();
+		ready.pop_back();
+		if (job->cancelled) {
+			ReleaseDependents(job, ready);
+			m_finished.push_back(job);
+		} else {
+			MarkQueued(job);
+			m_queue[job->GetPriority()].push_back(job);
+		}
+	}
+}
+
 // call OnFinish methods for completed jobs, and clean up
 Uint32 SyncJobQueue::FinishJobs()
 {
@@ -391,21 +1021,60 @@ Uint32 SyncJobQueue::FinishJobs()
 		// if its already been cancelled then its taken care of, so we just forget about it
 		if(!job->cancelled) {
 			job->UnlinkHandle();
-			job->OnFinish();
+			FinishJob(job);
+			finished++;
+		}
+
+		delete job;
+	}
+	return finished;
+}
+
+Uint32 SyncJobQueue::FinishJobs(double timeBudget, Uint32 &deferred)
+{
+	PROFILE_SCOPED()
+	Uint32 finished = 0;
+
+	const Uint64 start = SDL_GetPerformanceCounter();
+	const Uint64 budget = Uint64(timeBudget * double(SDL_GetPerformanceFrequency()));
+
+	while (!m_finished.empty()) {
+		if (finished > 0 && SDL_GetPerformanceCounter() - start >= budget)
+			break;
+
+		Job *job = m_finished.front();
+		m_finished.pop_front();
+
+		// if its already been cancelled then its taken care of, so we just forget about it
+		if(!job->cancelled) {
+			job->UnlinkHandle();
+			FinishJob(job);
 			finished++;
 		}
 
 		delete job;
 	}
+
+	deferred = m_finished.size();
 	return finished;
 }
 
 void SyncJobQueue::Cancel(Job *job) {
+	MarkCancelled(job);
+
+	// still waiting on other jobs. it can't be deleted until they let go of it
+	if (CancelWaiting(job))
+		return;
+
 	// check the waiting list. if its there then it hasn't run yet. just forget about it
-	for (std::deque<Job*>::iterator i = m_queue.begin(); i != m_queue.end(); ++i) {
+	std::deque<Job*> &q = m_queue[job->GetPriority()];
+	for (std::deque<Job*>::iterator i = q.begin(); i != q.end(); ++i) {
 		if (*i == job) {
-			i = m_queue.erase(i);
+			i = q.erase(i);
+			std::vector<Job*> ready;
+			ReleaseDependents(job, ready);
 			delete job;
+			Dispatch(ready);
 			return;
 		}
 	}
@@ -426,18 +1095,32 @@ void SyncJobQueue::Cancel(Job *job) {
 	job->OnCancel();
 }
 
+void SyncJobQueue::Reprioritise(Job *job, Job::Priority priority)
+{
+	MoveJob(m_queue, job, priority);
+}
+
 Uint32 SyncJobQueue::RunJobs(Uint32 count)
 {
 	Uint32 executed = 0;
 	assert(count >= 1);
+	PromoteOverdueJobs(m_queue, SDL_GetTicks());
 	for (Uint32 i = 0; i < count; ++i) {
-		if (m_queue.empty())
+		int p = Job::PRIORITY_COUNT - 1;
+		while (p >= 0 && m_queue[p].empty())
+			p--;
+		if (p < 0)
 			break;
 
-		Job* job = m_queue.front();
-		m_queue.pop_front();
-		job->OnRun();
+		Job* job = m_queue[p].front();
+		m_queue[p].pop_front();
+		RunJob(job, 0);
 		executed++;
+
+		std::vector<Job*> ready;
+		ReleaseDependents(job, ready);
+		Dispatch(ready);
+
 		m_finished.push_back(job);
 	}
 	return executed;
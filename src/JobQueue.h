@@ -4,8 +4,12 @@
 #ifndef JOBQUEUE_H
 #define JOBQUEUE_H
 
+#include <atomic>
 #include <cassert>
+#include <cstring>
 #include <deque>
+#include <functional>
+#include <map>
 #include <vector>
 #include <set>
 #include <string>
@@ -16,6 +20,61 @@ static const Uint32 MAX_THREADS = 64;
 class JobClient;
 class JobQueue;
 
+#ifdef PIONEER_PROFILER
+// timing for each kind of job (see Job::GetName), collected in profiler
+// builds only. everything is thread safe. times are in seconds
+class JobStats {
+public:
+	static const int NUM_BUCKETS = 24;
+
+	// log2 histogram. bucket n counts times below 2^n microseconds, the last
+	// bucket takes everything else
+	struct Histogram {
+		Histogram() : count(0), total(0.0), max(0.0) { memset(buckets, 0, sizeof(buckets)); }
+		void Add(double t);
+		// upper edge of the bucket holding the given fraction of samples
+		double Percentile(double fraction) const;
+
+		Uint64 count;
+		double total;
+		double max;
+		Uint32 buckets[NUM_BUCKETS];
+	};
+
+	struct Entry {
+		Entry() : cancelled(0) {}
+		Histogram wait;   // queued until started
+		Histogram run;    // OnRun
+		Histogram finish; // OnFinish
+		Uint64 cancelled;
+	};
+
+	JobStats();
+	~JobStats();
+
+	void AddWait(const char *name, double t);
+	void AddRun(const char *name, double t, Uint32 threadIdx);
+	void AddFinish(const char *name, double t);
+	void AddCancel(const char *name);
+
+	std::string Dump(Uint32 numThreads) const;
+	void Reset();
+
+private:
+	JobStats(const JobStats&) = delete;
+	JobStats& operator=(const JobStats&) = delete;
+
+	struct NameLess {
+		bool operator()(const char *a, const char *b) const { return strcmp(a, b) < 0; }
+	};
+
+	SDL_mutex *m_lock;
+	std::map<const char*,Entry,NameLess> m_entries;
+	double m_busy[MAX_THREADS];
+	Uint64 m_resetTime;
+};
+#endif
+
 // represents a single unit of work that you want done
 // subclass and implement:
 //
@@ -28,8 +87,38 @@ class JobQueue;
 // OnCancel: optional. called from the main thread to tell the job that its
 //           results are not wanted. it should arrange for OnRun to return
 //           as quickly as possible. OnFinish will not be called for the job
+//
+// jobs are run in priority order, and in submission order within the same
+// priority. a job can also be given a deadline, once that passes the job is
+// treated as PRIORITY_HIGH so that low priority work can't starve forever
+//
+// a job can be queued to run after other jobs with JobQueue::QueueAfter. it
+// stays parked until every one of those has run (or been cancelled) and is
+// then picked up by a worker straight away, without a round trip through the
+// main thread. queue several jobs after the same one to fan out, or one job
+// after several to fan in. OnFinish is still called for each job on its own
+//
+// a job can also be put in a lane, for the subsystem it works for. an
+// AsyncJobQueue can reserve runners for a lane, which only run that lane's
+// jobs, so a flood of work from one subsystem can't hold up another. the
+// other runners take jobs from any lane
 class Job {
 public:
+	enum Priority {
+		PRIORITY_LOW,     // background work, prefetching
+		PRIORITY_NORMAL,
+		PRIORITY_HIGH,    // results that are visibly missing right now
+		PRIORITY_COUNT
+	};
+
+	enum Lane {
+		LANE_GENERAL,
+		LANE_TERRAIN,     // terrain patches and gas giant textures
+		LANE_GALAXY,      // sectors and star systems
+		LANE_IO,          // loading and saving files
+		LANE_COUNT
+	};
+
 	// This is the RAII handle for a queued Job. A job is cancelled when the
 	// Job::Handle is destroyed. There is at most one Job::Handle for each Job
 	// (non-queued Jobs have no handle). Job::Handle is not copyable only
@@ -47,10 +136,15 @@ public:
 		bool HasJob() const { return m_job != nullptr; }
 		Job* GetJob() const { return m_job; }
 
+		// move a job that is still waiting in the queue to a different
+		// priority. does nothing once the job has started running
+		void SetPriority(Priority priority);
+
 		bool operator<(const Handle& other) const { return m_id < other.m_id; }
 
 	private:
 		friend class Job;
+		friend class JobQueue;
 		friend class AsyncJobQueue;
 		friend class SyncJobQueue;
 
@@ -66,7 +160,11 @@ public:
 	};
 
 public:
-	Job() : cancelled(false), m_handle(nullptr) {}
+	Job() : cancelled(false), m_priority(PRIORITY_NORMAL), m_lane(LANE_GENERAL), m_deadline(0), m_ran(false), m_waitingOn(0),
+#ifdef PIONEER_PROFILER
+		m_queuedAt(0), m_ranAt(0), m_traceId(0),
+#endif
+		m_handle(nullptr) {}
 	virtual ~Job();
 
 	Job(const Job&) = delete;
@@ -76,7 +174,22 @@ public:
 	virtual void OnFinish() = 0;
 	virtual void OnCancel() {}
 
+	// identifies the kind of job in the queue statistics
+	virtual const char *GetName() const { return "Job"; }
+
+	// set these before queueing the job. use Job::Handle::SetPriority to
+	// change the priority of a job that is already queued
+	void SetPriority(Priority priority) { assert(!m_handle); m_priority = priority; }
+	void SetDeadline(Uint32 milliseconds);
+	void SetLane(Lane lane) { assert(!m_handle); m_lane = lane; }
+
+	Priority GetPriority() const { return m_priority; }
+	Lane GetLane() const { return m_lane; }
+	bool HasDeadline() const { return m_deadline != 0; }
+	bool IsOverdue(Uint32 now) const { return m_deadline && Sint32(now - m_deadline) >= 0; }
+
 private:
+	friend class JobQueue;
 	friend class AsyncJobQueue;
 	friend class SyncJobQueue;
 	friend class JobRunner;
@@ -87,6 +200,21 @@ private:
 	void ClearHandle() { m_handle = nullptr; }
 
 	bool cancelled;
+	Priority m_priority;
+	Lane m_lane;
+	Uint32 m_deadline; // SDL_GetTicks() time, 0 if none
+
+	// dependency tracking, guarded by the queue's dependency lock
+	bool m_ran;
+	Uint32 m_waitingOn;
+	std::vector<Job*> m_dependents;
+
+#ifdef PIONEER_PROFILER
+	Uint64 m_queuedAt; // performance counter when the job became runnable
+	Uint64 m_ranAt;    // and when OnRun returned
+	Uint64 m_traceId;  // links queueing, running and finishing in a trace
+#endif
+
 	Handle* m_handle;
 };
 
@@ -95,18 +223,25 @@ private:
 // jobs do it. it will take care of the rest
 class JobQueue {
 public:
-	JobQueue() = default;
+	JobQueue();
 	JobQueue(const JobQueue&) = delete;
 	JobQueue& operator=(const JobQueue&) = delete;
 
-	// numRunners is the number of jobs to run in parallel. right now its the
-	// same as the number of threads, but there's no reason that it has to be
-	virtual ~JobQueue() { }
+	virtual ~JobQueue();
 
 	// call from the main thread to add a job to the queue. the job should be
 	// allocated with new. the queue will delete it once its its completed
 	virtual Job::Handle Queue(Job *job, JobClient *client = nullptr) = 0;
 
+	// as Queue, but the job won't be started until all the jobs in after have
+	// run or been cancelled. jobs in after must belong to this queue; ones
+	// that have already run are ignored (so a null or finished handle's job
+	// is fine)
+	virtual Job::Handle QueueAfter(Job *job, const std::vector<Job*> &after, JobClient *client = nullptr) = 0;
+	Job::Handle QueueAfter(Job *job, Job *after, JobClient *client = nullptr) {
+		return QueueAfter(job, std::vector<Job*>(1, after), client);
+	}
+
 	// call from the main thread to cancel a job. one of three things will happen
 	//
 	// - the job hasn't run yet. it will never be run, and neither OnFinished nor
@@ -119,10 +254,70 @@ public:
 	// - the job is running. OnCancel will be called
 	virtual void Cancel(Job *job) = 0;
 
+	// call from the main thread to move a job that hasn't started yet to a
+	// different priority. jobs that are running or finished are left alone
+	virtual void Reprioritise(Job *job, Job::Priority priority) = 0;
+
 	// call from the main loop. this will call OnFinish for any finished jobs,
 	// and then delete all finished and cancelled jobs. returns the number of
 	// finished jobs (not cancelled)
 	virtual Uint32 FinishJobs() = 0;
+
+	// as above, but stops once timeBudget seconds have been spent, leaving
+	// the rest for the next call. at least one job is always finished so the
+	// backlog keeps moving. deferred is set to the number of completed jobs
+	// still waiting for OnFinish
+	virtual Uint32 FinishJobs(double timeBudget, Uint32 &deferred) = 0;
+
+	// a printable table of per job type timings and worker occupancy since
+	// the last reset. only has anything in it in profiler builds
+	std::string DumpStats(bool reset = true);
+
+	// call from the main thread to run fn over [0,count) in batches of up to
+	// batchSize, spread over the runners. the main thread works through
+	// batches too, and this doesn't return until every batch is done. fn is
+	// called with a [begin,end) range and must be safe to run concurrently
+	// with itself
+	void ParallelFor(Uint32 count, Uint32 batchSize, const std::function<void(Uint32,Uint32)> &fn);
+
+	// how many jobs can run at once, for sizing batches of work
+	Uint32 GetNumRunners() const { return GetNumThreads(); }
+
+protected:
+	// move any overdue jobs in the lower priority queues to the back of the
+	// high priority queue. returns the number of jobs moved
+	static Uint32 PromoteOverdueJobs(std::deque<Job*> queues[Job::PRIORITY_COUNT], Uint32 now);
+	static bool MoveJob(std::deque<Job*> queues[Job::PRIORITY_COUNT], Job *job, Job::Priority priority);
+
+	// make job wait on each unfinished job in after. returns true if it has
+	// to wait, in which case it's parked until ReleaseDependents frees it
+	bool AddDependencies(Job *job, const std::vector<Job*> &after);
+	// called once job has run, or been dropped without running. appends the
+	// jobs that were waiting only on it to ready
+	void ReleaseDependents(Job *job, std::vector<Job*> &ready);
+	// if job is parked waiting on others, flag it as cancelled and return
+	// true. it is thrown away when it's released
+	bool CancelWaiting(Job *job);
+
+	virtual Uint32 GetNumThreads() const = 0;
+
+#ifdef PIONEER_PROFILER
+	// record timings. RunJob can be called from any thread
+	void MarkQueued(Job *job);
+	void MarkCancelled(Job *job) { m_stats.AddCancel(job->GetName()); }
+	void RunJob(Job *job, Uint32 threadIdx);
+	void FinishJob(Job *job);
+	JobStats m_stats;
+#else
+	void MarkQueued(Job *job) {}
+	void MarkCancelled(Job *job) {}
+	void RunJob(Job *job, Uint32 threadIdx) { job->OnRun(); }
+	void FinishJob(Job *job) { job->OnFinish(); }
+#endif
+
+private:
+	SDL_mutex *m_dependencyLock;
+	std::set<Job*> m_waiting;
 };
 
 // the queue management class. create one from the main thread, and feed your
@@ -130,13 +325,18 @@ public:
 class AsyncJobQueue : public JobQueue {
 public:
 	// numRunners is the number of jobs to run in parallel. right now its the
-	// same as the number of threads, but there's no reason that it has to be
-	AsyncJobQueue(Uint32 numRunners);
+	// same as the number of threads, but there's no reason that it has to be.
+	// reserved, if given, is how many of them to keep for each lane's jobs
+	// (indexed by Job::Lane, the count for LANE_GENERAL is ignored). at
+	// least one runner is always left for everything else
+	AsyncJobQueue(Uint32 numRunners, const Uint32 *reserved = nullptr);
 	virtual ~AsyncJobQueue();
 
 	// call from the main thread to add a job to the queue. the job should be
 	// allocated with new. the queue will delete it once its its completed
 	virtual Job::Handle Queue(Job *job, JobClient *client = nullptr) override;
+	virtual Job::Handle QueueAfter(Job *job, const std::vector<Job*> &after, JobClient *client = nullptr) override;
+	using JobQueue::QueueAfter;
 
 	// call from the main thread to cancel a job. one of three things will happen
 	//
@@ -150,10 +350,13 @@ public:
 	// - the job is running. OnCancel will be called
 	virtual void Cancel(Job *job) override;
 
+	virtual void Reprioritise(Job *job, Job::Priority priority) override;
+
 	// call from the main loop. this will call OnFinish for any finished jobs,
 	// and then delete all finished and cancelled jobs. returns the number of
 	// finished jobs (not cancelled)
 	virtual Uint32 FinishJobs() override;
+	virtual Uint32 FinishJobs(double timeBudget, Uint32 &deferred) override;
 
 private:
 	// a runner wraps a single thread, and calls into the queue when its ready for
@@ -182,12 +385,40 @@ private:
 		bool m_queueDestroyed;
 	};
 
-	Job *GetJob();
+	void PromoteOverdueJobs();
+	// the lane whose runners take job: its own if it has reserved runners,
+	// otherwise the general one
+	Job::Lane GetQueueLane(const Job *job) const {
+		return m_laneRunners[job->GetLane()].empty() ? Job::LANE_GENERAL : job->GetLane();
+	}
+	// from the main thread, the next queue in turn for job
+	Uint32 NextQueue(const Job *job);
+	Job *GetJob(const uint8_t threadIdx);
+	Job *TryGetJob(const uint8_t threadIdx);
+	void Enqueue(Job *job, const Uint32 queueIdx);
+	void Dispatch(std::vector<Job*> &ready, const uint8_t threadIdx);
 	void Finish(Job *job, const uint8_t threadIdx);
-
-	std::deque<Job*> m_queue;
-	SDL_mutex *m_queueLock;
-	SDL_cond *m_queueWaitCond;
+	virtual Uint32 GetNumThreads() const override { return m_runners.size(); }
+
+	// each runner owns a queue per priority. new jobs are dealt out
+	// round-robin among the runners of their lane, a runner takes from the
+	// front of its own queue and, when that runs dry, steals from the back
+	// of the others. runners reserved for a lane only steal from each other
+	std::deque<Job*> m_queue[MAX_THREADS][Job::PRIORITY_COUNT];
+	SDL_mutex *m_queueLock[MAX_THREADS];
+	Job::Lane m_runnerLane[MAX_THREADS];
+	std::vector<Uint32> m_laneRunners[Job::LANE_COUNT];
+	Uint32 m_nextQueue[Job::LANE_COUNT];
+
+	// idle runners sleep on their lane's condition. m_pending counts the
+	// jobs sitting in any of the runner queues, m_lanePending those in each
+	// lane's runners' queues; they're only incremented with m_waitLock held
+	// so that a runner about to sleep can't miss a wakeup
+	SDL_mutex *m_waitLock;
+	SDL_cond *m_queueWaitCond[Job::LANE_COUNT];
+	std::atomic<Uint32> m_pending;
+	std::atomic<Uint32> m_lanePending[Job::LANE_COUNT];
+	std::atomic<Uint32> m_deadlines; // queued jobs that have a deadline
 
 	std::deque<Job*> m_finished[MAX_THREADS];
 	SDL_mutex *m_finishedLock[MAX_THREADS];
@@ -205,6 +436,8 @@ public:
 	// call from the main thread to add a job to the queue. the job should be
 	// allocated with new. the queue will delete it once its its completed
 	virtual Job::Handle Queue(Job *job, JobClient *client = nullptr) override;
+	virtual Job::Handle QueueAfter(Job *job, const std::vector<Job*> &after, JobClient *client = nullptr) override;
+	using JobQueue::QueueAfter;
 
 	// call from the main thread to cancel a job. one of three things will happen
 	//
@@ -218,15 +451,21 @@ public:
 	// - the job is running. OnCancel will be called
 	virtual void Cancel(Job *job) override;
 
+	virtual void Reprioritise(Job *job, Job::Priority priority) override;
+
 	// call from the main loop. this will call OnFinish for any finished jobs,
 	// and then delete all finished and cancelled jobs. returns the number of
 	// finished jobs (not cancelled)
 	virtual Uint32 FinishJobs() override;
+	virtual Uint32 FinishJobs(double timeBudget, Uint32 &deferred) override;
 
 	Uint32 RunJobs(Uint32 count = 1);
 
 private:
-	std::deque<Job*> m_queue;
+	void Dispatch(std::vector<Job*> &ready);
+	virtual Uint32 GetNumThreads() const override { return 1; }
+
+	std::deque<Job*> m_queue[Job::PRIORITY_COUNT];
 	std::deque<Job*> m_finished;
 };
 
@@ -250,9 +489,15 @@ public:
 		auto x = m_jobs.insert(std::move(m_queue->Queue(job, this)));
 		assert(x.second);
 	}
+	// queue a job to run once the jobs in after have run
+	void OrderAfter(Job* job, const std::vector<Job*> &after) {
+		auto x = m_jobs.insert(std::move(m_queue->QueueAfter(job, after, this)));
+		assert(x.second);
+	}
 	virtual void RemoveJob(Job::Handle* handle) { m_jobs.erase(*handle); }
 
 	bool IsEmpty() const { return m_jobs.empty(); }
+	JobQueue* GetQueue() const { return m_queue; }
 
 private:
 	JobQueue* m_queue;
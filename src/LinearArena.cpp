@@ -0,0 +1,118 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "LinearArena.h"
+#include <algorithm>
+#include <cassert>
+
+LinearArena::LinearArena(size_t blockSize) :
+	m_block(0),
+	m_offset(0),
+	m_used(0),
+	m_blockSize(blockSize)
+{
+}
+
+LinearArena::LinearArena(void *buffer, size_t bytes) :
+	m_block(0),
+	m_offset(0),
+	m_used(0),
+	m_blockSize(bytes)
+{
+	const Block b = { static_cast<Uint8*>(buffer), bytes, false };
+	m_blocks.push_back(b);
+}
+
+LinearArena::~LinearArena()
+{
+	for (const Block &b : m_blocks)
+		if (b.owned)
+			delete[] b.data;
+}
+
+void LinearArena::NewBlock(size_t minBytes)
+{
+	// the next block along may already be big enough, from an earlier round
+	while (++m_block < m_blocks.size()) {
+		if (m_blocks[m_block].size >= minBytes) {
+			m_offset = 0;
+			return;
+		}
+	}
+	const size_t size = std::max(m_blockSize, minBytes);
+	const Block b = { new Uint8[size], size, true };
+	m_blocks.push_back(b);
+	m_block = m_blocks.size() - 1;
+	m_offset = 0;
+}
+
+void *LinearArena::Alloc(size_t bytes, size_t align)
+{
+	assert(align && (align & (align - 1)) == 0);
+	if (!bytes)
+		bytes = 1;
+
+	for (;;) {
+		if (m_block < m_blocks.size()) {
+			Block &b = m_blocks[m_block];
+			const uintptr_t start = reinterpret_cast<uintptr_t>(b.data) + m_offset;
+			const size_t pad = (align - (start & (align - 1))) & (align - 1);
+			if (m_offset + pad + bytes <= b.size) {
+				m_offset += pad + bytes;
+				m_used += pad + bytes;
+				return reinterpret_cast<void*>(start + pad);
+			}
+		}
+		// new blocks come from new[], aligned for anything
+		NewBlock(bytes + align);
+	}
+}
+
+void LinearArena::Reset()
+{
+	// if this round didn't fit in the first block, swap all the owned ones
+	// for a single one that would have held it, with some room to grow
+	if (m_block > 0) {
+		size_t total = m_used + m_used / 4;
+		std::vector<Block> kept;
+		for (const Block &b : m_blocks) {
+			if (b.owned) {
+				total = std::max(total, b.size);
+				delete[] b.data;
+			} else
+				kept.push_back(b);
+		}
+		if (kept.empty() || kept[0].size < total) {
+			const Block b = { new Uint8[total], total, true };
+			kept.insert(kept.begin(), b);
+		}
+		m_blocks.swap(kept);
+	}
+	m_block = 0;
+	m_offset = 0;
+	m_used = 0;
+}
+
+size_t LinearArena::GetBytesReserved() const
+{
+	size_t bytes = 0;
+	for (const Block &b : m_blocks)
+		bytes += b.size;
+	return bytes;
+}
+
+namespace FrameArena {
+
+static LinearArena s_arena;
+
+LinearArena &Get()
+{
+	return s_arena;
+}
+
+void EndFrame()
+{
+	s_arena.Reset();
+}
+
+}
@@ -0,0 +1,135 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _LINEARARENA_H
+#define _LINEARARENA_H
+
+#include <SDL_stdinc.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Bump allocation for short-lived containers. Allocating from an arena
+ * moves a pointer along, freeing does nothing, and everything goes at once
+ * when the arena is reset. Blocks are kept across resets, and if the last
+ * round spilled into more than one they're merged into one big enough for
+ * all of it, so an arena that's reset regularly settles on a single block
+ * and stops touching the heap at all.
+ */
+class LinearArena {
+public:
+	explicit LinearArena(size_t blockSize = 64 * 1024);
+	virtual ~LinearArena();
+
+	void *Alloc(size_t bytes, size_t align);
+	// everything allocated so far is gone
+	void Reset();
+
+	size_t GetBytesUsed() const { return m_used; }
+	size_t GetBytesReserved() const;
+
+protected:
+	// for ScratchArena, which starts out in a buffer of its own
+	LinearArena(void *buffer, size_t bytes);
+
+private:
+	LinearArena(const LinearArena &);
+	LinearArena &operator=(const LinearArena &);
+
+	struct Block {
+		Uint8 *data;
+		size_t size;
+		bool owned;
+	};
+
+	void NewBlock(size_t minBytes);
+
+	std::vector<Block> m_blocks;
+	size_t m_block;  // the one being allocated from
+	size_t m_offset; // into it
+	size_t m_used;   // since the last reset, padding included
+	size_t m_blockSize;
+};
+
+/*
+ * An arena that starts in N bytes of its own, for a job runner's or a
+ * function's scratch space on the stack. It only goes to the heap if that
+ * runs out.
+ */
+template <size_t N>
+class ScratchArena : public LinearArena {
+public:
+	ScratchArena() : LinearArena(&m_buffer, N) {}
+private:
+	typename std::aligned_storage<N>::type m_buffer;
+};
+
+/*
+ * An STL allocator on an arena, eg
+ *   std::vector<Foo, ArenaAllocator<Foo>> v((ArenaAllocator<Foo>(arena)));
+ * without an arena it uses the heap like std::allocator, so a container
+ * type can take an arena where it's worth it and not need one elsewhere.
+ * containers using an arena must be gone before it's reset.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+	typedef T *pointer;
+	typedef const T *const_pointer;
+	typedef T &reference;
+	typedef const T &const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	template <typename U> struct rebind { typedef ArenaAllocator<U> other; };
+
+	ArenaAllocator() : m_arena(nullptr) {}
+	explicit ArenaAllocator(LinearArena *arena) : m_arena(arena) {}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U> &a) : m_arena(a.GetArena()) {}
+
+	T *allocate(size_t n) {
+		if (m_arena)
+			return static_cast<T*>(m_arena->Alloc(n * sizeof(T), std::alignment_of<T>::value));
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+	void deallocate(T *p, size_t) {
+		if (!m_arena)
+			::operator delete(p);
+	}
+
+	template <typename U, typename... Args>
+	void construct(U *p, Args&&... args) { ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+	template <typename U>
+	void destroy(U *p) { p->~U(); }
+	size_t max_size() const { return size_t(-1) / sizeof(T); }
+
+	LinearArena *GetArena() const { return m_arena; }
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U> &b) const { return m_arena == b.GetArena(); }
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U> &b) const { return m_arena != b.GetArena(); }
+
+private:
+	LinearArena *m_arena;
+};
+
+/*
+ * The main thread's arena for anything that only lasts the frame. It's
+ * reset after the swap, so nothing allocated from it may be kept past
+ * that, and it mustn't be used from the job runners (give them a
+ * ScratchArena instead).
+ */
+namespace FrameArena {
+	LinearArena &Get();
+	void EndFrame();
+
+	template <typename T>
+	ArenaAllocator<T> Allocator() { return ArenaAllocator<T>(&Get()); }
+}
+
+#endif
@@ -0,0 +1,164 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "LuaArrayView.h"
+#include "LuaObject.h"
+#include "LuaManager.h"
+#include "LuaUtils.h"
+#include "Body.h"
+#include "Space.h"
+#include <new>
+
+namespace {
+
+template <typename T> struct ViewTraits;
+
+template <> struct ViewTraits<Body*> {
+	static const char *TypeName() { return "BodyView"; }
+	static Uint32 Serial() { return Space::GetRemovalSerial(); }
+	static void Push(Body *b) { LuaObject<Body>::PushToLua(b); }
+};
+
+template <> struct ViewTraits<SystemPath> {
+	static const char *TypeName() { return "SystemPathView"; }
+	// paths are values, they never go stale
+	static Uint32 Serial() { return 0; }
+	static void Push(const SystemPath &p) { LuaObject<SystemPath>::PushToLua(p); }
+};
+
+template <typename T>
+struct View {
+	std::vector<T> items;
+	Uint32 serial;
+};
+
+template <typename T>
+static View<T> *check_view(lua_State *l, int idx)
+{
+	typedef ViewTraits<T> Traits;
+	View<T> *v = static_cast<View<T>*>(luaL_checkudata(l, idx, Traits::TypeName()));
+	if (v->serial != Traits::Serial())
+		luaL_error(l, "%s is no longer valid (bodies have been removed since it was made)", Traits::TypeName());
+	return v;
+}
+
+template <typename T>
+static int l_view_index(lua_State *l)
+{
+	View<T> *v = check_view<T>(l, 1);
+	if (lua_type(l, 2) != LUA_TNUMBER) {
+		lua_pushnil(l);
+		return 1;
+	}
+	const lua_Integer i = lua_tointeger(l, 2);
+	if (i < 1 || size_t(i) > v->items.size())
+		lua_pushnil(l);
+	else
+		ViewTraits<T>::Push(v->items[i-1]);
+	return 1;
+}
+
+template <typename T>
+static int l_view_len(lua_State *l)
+{
+	View<T> *v = check_view<T>(l, 1);
+	lua_pushinteger(l, v->items.size());
+	return 1;
+}
+
+template <typename T>
+static int l_view_next(lua_State *l)
+{
+	View<T> *v = check_view<T>(l, 1);
+	const lua_Integer i = luaL_checkinteger(l, 2) + 1;
+	if (size_t(i) > v->items.size())
+		return 0;
+	lua_pushinteger(l, i);
+	ViewTraits<T>::Push(v->items[i-1]);
+	return 2;
+}
+
+template <typename T>
+static int l_view_ipairs(lua_State *l)
+{
+	check_view<T>(l, 1);
+	lua_pushcfunction(l, &l_view_next<T>);
+	lua_pushvalue(l, 1);
+	lua_pushinteger(l, 0);
+	return 3;
+}
+
+template <typename T>
+static int l_view_tostring(lua_State *l)
+{
+	View<T> *v = static_cast<View<T>*>(luaL_checkudata(l, 1, ViewTraits<T>::TypeName()));
+	lua_pushfstring(l, "%s(%d)", ViewTraits<T>::TypeName(), int(v->items.size()));
+	return 1;
+}
+
+template <typename T>
+static int l_view_gc(lua_State *l)
+{
+	View<T> *v = static_cast<View<T>*>(luaL_checkudata(l, 1, ViewTraits<T>::TypeName()));
+	v->~View<T>();
+	return 0;
+}
+
+template <typename T>
+static void register_view(lua_State *l)
+{
+	LUA_DEBUG_START(l);
+
+	static const luaL_Reg l_meta[] = {
+		{ "__index",    &l_view_index<T>    },
+		{ "__len",      &l_view_len<T>      },
+		{ "__ipairs",   &l_view_ipairs<T>   },
+		{ "__tostring", &l_view_tostring<T> },
+		{ "__gc",       &l_view_gc<T>       },
+		{ 0, 0 }
+	};
+
+	luaL_newmetatable(l, ViewTraits<T>::TypeName());
+	luaL_setfuncs(l, l_meta, 0);
+	lua_pushboolean(l, 0);
+	lua_setfield(l, -2, "__metatable");
+	lua_pop(l, 1);
+
+	LUA_DEBUG_END(l, 0);
+}
+
+template <typename T>
+static void push_view(lua_State *l, std::vector<T> &items)
+{
+	LUA_DEBUG_START(l);
+	View<T> *v = new (lua_newuserdata(l, sizeof(View<T>))) View<T>();
+	v->items.swap(items);
+	v->serial = ViewTraits<T>::Serial();
+	luaL_setmetatable(l, ViewTraits<T>::TypeName());
+	LUA_DEBUG_END(l, 1);
+}
+
+} // anonymous namespace
+
+void LuaArrayView::Register()
+{
+	lua_State *l = Lua::manager->GetLuaState();
+	register_view<Body*>(l);
+	register_view<SystemPath>(l);
+}
+
+void LuaArrayView::PushBodies(lua_State *l, std::vector<Body*> &items)
+{
+	push_view(l, items);
+}
+
+void LuaArrayView::PushPaths(lua_State *l, std::vector<SystemPath> &items)
+{
+	push_view(l, items);
+}
+
+const std::vector<SystemPath> *LuaArrayView::GetPaths(lua_State *l, int idx)
+{
+	View<SystemPath> *v = static_cast<View<SystemPath>*>(luaL_testudata(l, idx, ViewTraits<SystemPath>::TypeName()));
+	return v ? &v->items : 0;
+}
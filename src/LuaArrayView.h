@@ -0,0 +1,32 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _LUAARRAYVIEW_H
+#define _LUAARRAYVIEW_H
+
+#include "galaxy/SystemPath.h"
+#include <vector>
+
+struct lua_State;
+class Body;
+
+// Read-only array userdata for handing bulk results to Lua. The vector is
+// moved into the userdata, and elements are only turned into Lua objects
+// when a script actually reads them. Views support view[i], #view and
+// ipairs(view).
+//
+// Body views hold raw pointers, so they go stale as soon as any body is
+// removed from space. Touching a stale view is a Lua error.
+namespace LuaArrayView {
+	void Register();
+
+	// take ownership of the contents of items (it is left empty) and
+	// push a view over it
+	void PushBodies(lua_State *l, std::vector<Body*> &items);
+	void PushPaths(lua_State *l, std::vector<SystemPath> &items);
+
+	// the contents of the path view at idx, or 0 if it isn't one
+	const std::vector<SystemPath> *GetPaths(lua_State *l, int idx);
+}
+
+#endif
@@ -0,0 +1,246 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "libs.h"
+#include "LuaAsync.h"
+#include "LuaArrayView.h"
+#include "LuaManager.h"
+#include "LuaObject.h"
+#include "LuaUtils.h"
+#include "Game.h"
+#include "Pi.h"
+#include "galaxy/Galaxy.h"
+#include "galaxy/GalaxyCache.h"
+#include "galaxy/StarSystem.h"
+#include <map>
+
+/*
+ * Interface: Async
+ *
+ * Native work that is too slow to do in one go. Each function queues the
+ * work and comes back to the script when it's done, which is some frames
+ * later, so the main loop keeps running while it's done.
+ *
+ * Called from a coroutine, a function suspends it and returns the results
+ * directly once the coroutine is resumed. The coroutine must not yield to
+ * anything else while it waits. Called from anywhere else, the last
+ * argument must be a callback function, which is called with the results.
+ *
+ * > local Async = import("Async")
+ * >
+ * > coroutine.wrap(function ()
+ * >     local systems = Async.GetStarSystems(Game.system:GetNearbySystemPathView(30))
+ * >     -- the main loop kept running while those were generated
+ * > end)()
+ *
+ * Outstanding requests are dropped when the game ends.
+ */
+
+namespace {
+
+struct Request {
+	RefCountedPtr<StarSystemCache::Slave> cache;
+	std::vector<SystemPath> paths;
+	int coroutine; // registry refs, one of them LUA_NOREF
+	int callback;
+	bool done;
+};
+
+typedef std::map<int, Request> RequestMap;
+RequestMap s_requests;
+int s_nextId = 0;
+
+void Release(lua_State *l, Request &r)
+{
+	luaL_unref(l, LUA_REGISTRYINDEX, r.coroutine);
+	luaL_unref(l, LUA_REGISTRYINDEX, r.callback);
+}
+
+// store the coroutine or the callback in the request, or raise an error.
+// returns true for a coroutine
+bool take_continuation(lua_State *l, int callbackIdx, Request &r)
+{
+	r.coroutine = r.callback = LUA_NOREF;
+	if (lua_isfunction(l, callbackIdx)) {
+		lua_pushvalue(l, callbackIdx);
+		r.callback = luaL_ref(l, LUA_REGISTRYINDEX);
+		return false;
+	}
+	if (lua_pushthread(l)) {
+		lua_pop(l, 1);
+		luaL_error(l, "must be called from a coroutine, or with a callback");
+	}
+	r.coroutine = luaL_ref(l, LUA_REGISTRYINDEX);
+	return true;
+}
+
+void pull_paths(lua_State *l, int idx, std::vector<SystemPath> &paths)
+{
+	if (const std::vector<SystemPath> *view = LuaArrayView::GetPaths(l, idx)) {
+		paths = *view;
+		return;
+	}
+	luaL_checktype(l, idx, LUA_TTABLE);
+	const int n = lua_rawlen(l, idx);
+	paths.reserve(n);
+	for (int i = 1; i <= n; i++) {
+		lua_rawgeti(l, idx, i);
+		paths.push_back(*LuaObject<SystemPath>::CheckFromLua(-1));
+		lua_pop(l, 1);
+	}
+}
+
+// push the results for a finished request onto the main thread
+void push_results(lua_State *l, Request &r)
+{
+	lua_createtable(l, r.paths.size(), 0);
+	int i = 1;
+	for (const SystemPath &path : r.paths) {
+		RefCountedPtr<StarSystem> s = r.cache->GetCached(path);
+		LuaObject<StarSystem>::PushToLua(s.Get());
+		lua_rawseti(l, -2, i++);
+	}
+}
+
+void deliver(Request &r)
+{
+	lua_State *l = Lua::manager->GetMainThread();
+	LUA_DEBUG_START(l);
+
+	if (r.callback != LUA_NOREF) {
+		lua_rawgeti(l, LUA_REGISTRYINDEX, r.callback);
+		push_results(l, r);
+		pi_lua_protected_call(l, 1, 0);
+	} else {
+		lua_rawgeti(l, LUA_REGISTRYINDEX, r.coroutine);
+		lua_State *co = lua_tothread(l, -1);
+		lua_pop(l, 1);
+		push_results(l, r);
+		lua_xmove(l, co, 1);
+		const int ret = Lua::manager->Resume(co, 1);
+		if (ret == LUA_OK || ret == LUA_YIELD) {
+			// finished, or waiting on another request, which holds its
+			// own ref. whatever it returned or yielded goes nowhere
+			lua_settop(co, 0);
+		} else {
+			luaL_traceback(l, co, lua_tostring(co, -1), 0);
+			const std::string msg = lua_tostring(l, -1);
+			lua_pop(l, 1);
+			Error("Error in Async coroutine: %s", msg.c_str());
+		}
+	}
+
+	Release(l, r);
+	LUA_DEBUG_END(l, 0);
+}
+
+}
+
+/*
+ * Function: GetStarSystems
+ *
+ * Get the <StarSystems> for some paths, generating the ones that aren't
+ * already cached. Star systems are generated on the main thread, a few
+ * jobs a frame from the sync job queue, and each one is generated fully
+ * (bodies and population) before it's handed back
+ *
+ * > systems = Async.GetStarSystems(paths, callback)
+ *
+ * Parameters:
+ *
+ *   paths - an array of <SystemPaths>, or a path view such as the one
+ *           returned by <StarSystem.GetNearbySystemPathView>
+ *
+ *   callback - required unless running in a coroutine. called with the
+ *              array of systems once they are all ready
+ *
+ * Return:
+ *
+ *   systems - an array of <StarSystems>, in the same order as the paths.
+ *             nothing is returned if a callback was given
+ *
+ * Availability:
+ *
+ *   October 2015
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_async_get_star_systems(lua_State *l)
+{
+	PROFILE_SCOPED()
+	if (!Pi::game)
+		return luaL_error(l, "Game is not started");
+
+	std::vector<SystemPath> paths;
+	pull_paths(l, 1, paths);
+	for (SystemPath &path : paths)
+		path = path.SystemOnly();
+
+	// take_continuation can raise an error, so the request is only
+	// registered once it has its continuation
+	Request req;
+	req.done = false;
+	const bool suspend = take_continuation(l, 2, req);
+
+	const int id = ++s_nextId;
+	Request &r = s_requests[id];
+	r = req;
+	r.paths.swap(paths);
+	r.cache = Pi::game->GetGalaxy()->NewStarSystemSlaveCache();
+	// the fill callback may come straight away if everything is cached
+	r.cache->FillCache(r.paths, [id]() {
+		RequestMap::iterator it = s_requests.find(id);
+		if (it != s_requests.end())
+			it->second.done = true;
+	});
+
+	if (suspend)
+		return lua_yield(l, 0);
+	return 0;
+}
+
+void LuaAsync::Register()
+{
+	lua_State *l = Lua::manager->GetLuaState();
+
+	LUA_DEBUG_START(l);
+
+	static const luaL_Reg methods[]= {
+		{ "GetStarSystems", l_async_get_star_systems },
+		{ 0, 0 }
+	};
+
+	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
+	luaL_newlib(l, methods);
+	lua_setfield(l, -2, "Async");
+	lua_pop(l, 1);
+
+	LUA_DEBUG_END(l, 0);
+}
+
+void LuaAsync::Update()
+{
+	PROFILE_SCOPED()
+	// requests made while delivering wait for the next frame, which also
+	// keeps a coroutine from running twice in one frame
+	std::vector<Request> ready;
+	for (RequestMap::iterator it = s_requests.begin(); it != s_requests.end(); ) {
+		if (it->second.done) {
+			ready.push_back(it->second);
+			s_requests.erase(it++);
+		} else
+			++it;
+	}
+	for (Request &r : ready)
+		deliver(r);
+}
+
+void LuaAsync::Clear()
+{
+	lua_State *l = Lua::manager->GetMainThread();
+	for (RequestMap::iterator it = s_requests.begin(); it != s_requests.end(); ++it)
+		Release(l, it->second);
+	s_requests.clear();
+}
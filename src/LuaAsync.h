@@ -0,0 +1,22 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _LUAASYNC_H
+#define _LUAASYNC_H
+
+// native work started from Lua that finishes on the job runners. a script
+// either runs the request from a coroutine, which is suspended until the
+// results are in, or passes a callback
+namespace LuaAsync {
+	// sets up the Async core import
+	void Register();
+
+	// hand finished requests back to their scripts. call once a frame from
+	// the main loop, after the job queues have been finished
+	void Update();
+
+	// drop all outstanding requests without calling back
+	void Clear();
+}
+
+#endif
@@ -0,0 +1,119 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "libs.h"
+#include "LuaBytecodeCache.h"
+#include "FileSystem.h"
+#include "Pi.h"
+#include "jenkins/lookup3.h"
+#include <lua.hpp>
+
+namespace {
+
+const char CACHE_DIR[] = "luacache";
+
+// bump this if the way chunks are loaded changes in a way that makes
+// existing bytecode wrong (eg. a different chunk name layout)
+const Uint32 CACHE_VERSION = 1;
+
+struct Header {
+	char magic[4];
+	Uint32 version;
+	Uint32 luaVersion;
+	Uint32 sourceSize;
+	Uint32 sourceHash[2];
+	Uint32 nameHash[2];
+};
+
+bool s_enabled = false;
+
+void Hash(const char *data, size_t size, Uint32 out[2])
+{
+	out[0] = out[1] = 0;
+	lookup3_hashlittle2(data, size, &out[0], &out[1]);
+}
+
+Header MakeHeader(const std::string &chunkName, const StringRange &source)
+{
+	Header h;
+	memcpy(h.magic, "PLB1", 4);
+	h.version = CACHE_VERSION;
+	h.luaVersion = LUA_VERSION_NUM;
+	h.sourceSize = Uint32(source.Size());
+	Hash(source.begin, source.Size(), h.sourceHash);
+	Hash(chunkName.c_str(), chunkName.size(), h.nameHash);
+	return h;
+}
+
+std::string GetCacheFileName(const Header &h)
+{
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%08x%08x.luac", h.nameHash[0], h.nameHash[1]);
+	return FileSystem::JoinPath(CACHE_DIR, buf);
+}
+
+int DumpWriter(lua_State *, const void *p, size_t size, void *ud)
+{
+	static_cast<std::string*>(ud)->append(static_cast<const char*>(p), size);
+	return 0;
+}
+
+}
+
+namespace LuaBytecodeCache {
+
+void Init()
+{
+	s_enabled = Pi::config->Int("LuaBytecodeCache") != 0;
+	if (s_enabled && !FileSystem::userFiles.MakeDirectory(CACHE_DIR)) {
+		Output("LuaBytecodeCache: couldn't create cache directory, disabling\n");
+		s_enabled = false;
+	}
+}
+
+bool IsEnabled()
+{
+	return s_enabled;
+}
+
+bool Load(lua_State *l, const std::string &chunkName, const StringRange &source)
+{
+	PROFILE_SCOPED()
+	if (!s_enabled) return false;
+
+	const Header expected = MakeHeader(chunkName, source);
+	RefCountedPtr<FileSystem::FileData> fd = FileSystem::userFiles.ReadFile(GetCacheFileName(expected));
+	if (!fd || fd->GetSize() <= sizeof(Header)) return false;
+
+	// a different source under the same name, or a hash collision
+	// between names; either way it gets recompiled and overwritten
+	const char *data = fd->GetData();
+	if (memcmp(data, &expected, sizeof(Header)) != 0) return false;
+
+	// binary only, so a damaged entry can't be taken for source. the lua
+	// loader checks the bytecode header for a build mismatch itself
+	if (luaL_loadbufferx(l, data + sizeof(Header), fd->GetSize() - sizeof(Header), chunkName.c_str(), "b") != LUA_OK) {
+		lua_pop(l, 1);
+		return false;
+	}
+	return true;
+}
+
+void Save(lua_State *l, const std::string &chunkName, const StringRange &source)
+{
+	PROFILE_SCOPED()
+	if (!s_enabled) return;
+
+	std::string bytecode;
+	if (lua_dump(l, &DumpWriter, &bytecode) != 0 || bytecode.empty()) return;
+
+	const Header header = MakeHeader(chunkName, source);
+	FILE *f = FileSystem::userFiles.OpenWriteStream(GetCacheFileName(header));
+	if (!f) return;
+
+	fwrite(&header, sizeof(Header), 1, f);
+	fwrite(bytecode.data(), 1, bytecode.size(), f);
+	fclose(f);
+}
+
+}
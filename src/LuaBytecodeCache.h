@@ -0,0 +1,29 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _LUABYTECODECACHE_H
+#define _LUABYTECODECACHE_H
+
+#include "StringRange.h"
+#include <string>
+
+struct lua_State;
+
+// on-disk cache of compiled Lua chunks, in the user dir. a chunk is found
+// by its chunk name and only used if the source it was compiled from has the
+// same size and hash, and the Lua version matches. anything that doesn't
+// line up is quietly recompiled from the source and the entry rewritten
+namespace LuaBytecodeCache {
+	void Init();
+
+	bool IsEnabled();
+
+	// push the cached function for this source and return true, or leave
+	// the stack alone and return false
+	bool Load(lua_State *l, const std::string &chunkName, const StringRange &source);
+
+	// write out the function on the top of the stack (which is left there)
+	void Save(lua_State *l, const std::string &chunkName, const StringRange &source);
+}
+
+#endif
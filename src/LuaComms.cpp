@@ -109,7 +109,7 @@ void LuaComms::Register()
 	};
 
 	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
-	LuaObjectBase::CreateObject(l_methods, 0, 0);
+	LuaObjectBase::CreateObject("Comms", l_methods, 0, 0);
 	lua_setfield(l, -2, "Comms");
 	lua_pop(l, 1);
 
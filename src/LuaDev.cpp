@@ -2,6 +2,9 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "LuaDev.h"
+#include "FileSystem.h"
+#include "FrameTimings.h"
+#include "MemoryReport.h"
 #include "LuaObject.h"
 #include "Pi.h"
 #include "WorldView.h"
@@ -30,6 +33,110 @@ static int l_dev_set_camera_offset(lua_State *l)
 	return 0;
 }
 
+/*
+ * Print timing statistics for each kind of job run by the job queues, and
+ * reset them. Only collected in profiler builds.
+ *
+ * Dev.DumpJobStats()
+ */
+static int l_dev_dump_job_stats(lua_State *l)
+{
+	Output("async job queue:\n%s", Pi::GetAsyncJobQueue()->DumpStats().c_str());
+	Output("sync job queue:\n%s", Pi::GetSyncJobQueue()->DumpStats().c_str());
+	return 0;
+}
+
+/*
+ * Start timing every Lua call, attributing time and allocations to each
+ * function and source file. In profiler builds the results are also written
+ * out next to each profiler dump.
+ *
+ * Dev.StartLuaProfiler()
+ */
+static int l_dev_start_lua_profiler(lua_State *l)
+{
+	Lua::manager->StartProfiler();
+	return 0;
+}
+
+/*
+ * Stop the Lua profiler and print what it collected.
+ *
+ * Dev.StopLuaProfiler()
+ */
+static int l_dev_stop_lua_profiler(lua_State *l)
+{
+	if (!Lua::manager->IsProfiling())
+		return 0;
+	Lua::manager->StopProfiler();
+	Output("%s", Lua::manager->DumpProfile().c_str());
+	return 0;
+}
+
+/*
+ * Print the mean, median, 95th and 99th percentile and worst time spent in
+ * each phase of the main loop over the last few hundred frames. With a file
+ * name, also write every frame's timings there as CSV, in the user
+ * directory.
+ *
+ * Dev.DumpFrameTimings(filename)
+ */
+static int l_dev_dump_frame_timings(lua_State *l)
+{
+	const FrameTimings *timings = Pi::GetFrameTimings();
+	Output("frame timings:\n%s", timings->DumpPercentiles().c_str());
+	if (lua_gettop(l) >= 1) {
+		std::string path;
+		try {
+			path = FileSystem::JoinPathBelow(FileSystem::GetUserDir(), luaL_checkstring(l, 1));
+		} catch (std::invalid_argument &) {
+			return luaL_error(l, "frame timings file name must be in the user directory");
+		}
+		if (timings->WriteCSV(path))
+			Output("frame timings written to %s\n", path.c_str());
+	}
+	return 0;
+}
+
+/*
+ * Log frames slower than this many milliseconds as hitches, 0 to stop.
+ *
+ * Dev.SetFrameHitchThreshold(ms)
+ */
+static int l_dev_set_frame_hitch_threshold(lua_State *l)
+{
+	Pi::GetFrameTimings()->SetHitchThreshold(luaL_checknumber(l, 1) * 0.001);
+	return 0;
+}
+
+/*
+ * Print how much memory Lua, the model, texture and galaxy caches, GeoPatch
+ * data and sound samples are holding, and how much each has changed since
+ * the last time.
+ *
+ * Dev.DumpMemory()
+ */
+static int l_dev_dump_memory(lua_State *l)
+{
+	Output("memory:\n%s", MemoryReport::Dump().c_str());
+	return 0;
+}
+
+/*
+ * Print how many times each engine function was called from Lua and the
+ * time spent in it, since startup or the last reset. Needs LuaApiCallCounts=1
+ * in the config.
+ *
+ * Dev.DumpLuaApiCalls(reset)
+ */
+static int l_dev_dump_lua_api_calls(lua_State *l)
+{
+	Output("%s", LuaObjectBase::DumpCallCounts().c_str());
+	if (lua_toboolean(l, 1))
+		LuaObjectBase::ResetCallCounts();
+	return 0;
+}
+
 void LuaDev::Register()
 {
 	lua_State *l = Lua::manager->GetLuaState();
@@ -38,6 +145,13 @@ void LuaDev::Register()
 
 	static const luaL_Reg methods[]= {
 		{ "SetCameraOffset", l_dev_set_camera_offset },
+		{ "DumpJobStats", l_dev_dump_job_stats },
+		{ "StartLuaProfiler", l_dev_start_lua_profiler },
+		{ "StopLuaProfiler", l_dev_stop_lua_profiler },
+		{ "DumpFrameTimings", l_dev_dump_frame_timings },
+		{ "SetFrameHitchThreshold", l_dev_set_frame_hitch_threshold },
+		{ "DumpMemory", l_dev_dump_memory },
+		{ "DumpLuaApiCalls", l_dev_dump_lua_api_calls },
 		{ 0, 0 }
 	};
 
@@ -834,7 +834,7 @@ void LuaEngine::Register()
 	};
 
 	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
-	LuaObjectBase::CreateObject(l_methods, l_attrs, 0);
+	LuaObjectBase::CreateObject("Engine", l_methods, l_attrs, 0);
 	lua_setfield(l, -2, "Engine");
 	lua_pop(l, 1);
 
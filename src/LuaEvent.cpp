@@ -6,63 +6,252 @@
 #include "LuaManager.h"
 #include "LuaObject.h"
 #include "LuaUtils.h"
+#include <algorithm>
+#include <map>
 
 namespace LuaEvent {
 
-static bool _get_method_onto_stack(lua_State *l, const char *method) {
+struct HandlerList {
+	HandlerList() : live(0), timed(false) {}
+
+	// registry refs. deregistered handlers become LUA_NOREF until the list
+	// is compacted, so a dispatch in progress isn't disturbed
+	std::vector<int> callbacks;
+	int live;
+	bool timed;
+};
+
+typedef std::map<std::string, HandlerList> HandlerMap;
+
+// the arguments for every pending event live end to end in one registry
+// table (PiEventArgs), so queueing doesn't allocate a table per event
+struct PendingEvent {
+	HandlerMap::value_type *handlers;
+	int firstArg;
+	int numArgs;
+};
+
+static HandlerMap s_handlers;
+static std::vector<PendingEvent> s_pending;
+static size_t s_nextPending;
+static int s_numArgs;
+static int s_emitDepth;
+
+static void _compact(HandlerList &h)
+{
+	h.callbacks.erase(std::remove(h.callbacks.begin(), h.callbacks.end(), LUA_NOREF), h.callbacks.end());
+}
+
+static void _reset_pending(lua_State *l)
+{
+	s_pending.clear();
+	s_nextPending = 0;
+	s_numArgs = 0;
+
+	lua_newtable(l);
+	lua_setfield(l, LUA_REGISTRYINDEX, "PiEventArgs");
+}
+
+// copies count stack values starting at first into the argument table and
+// queues the event. the values are left on the stack
+static void _push_pending(lua_State *l, HandlerMap::value_type *handlers, int first, int count)
+{
 	LUA_DEBUG_START(l);
 
-	int top = lua_gettop(l);
+	lua_getfield(l, LUA_REGISTRYINDEX, "PiEventArgs");
+	for (int i = 0; i < count; i++) {
+		lua_pushvalue(l, first + i);
+		lua_rawseti(l, -2, s_numArgs + i + 1);
+	}
+	lua_pop(l, 1);
+
+	const PendingEvent e = { handlers, s_numArgs, count };
+	s_pending.push_back(e);
+	s_numArgs += count;
+
+	LUA_DEBUG_END(l, 0);
+}
 
-	if (!pi_lua_import(l, "Event"))
-		return false;
+static void _dispatch(lua_State *l, const PendingEvent &e)
+{
+	LUA_DEBUG_START(l);
 
-	lua_getfield(l, -1, method);
-	if (!lua_isfunction(l, -1)) {
-		lua_pop(l, 2);
+	HandlerList &h = e.handlers->second;
+	if (!h.live) {
 		LUA_DEBUG_END(l, 0);
-		return false;
+		return;
 	}
 
-	lua_insert(l, top+1);
-	lua_settop(l, top+1);
+	lua_getfield(l, LUA_REGISTRYINDEX, "PiEventArgs");
+	const int args = lua_gettop(l);
+
+	// handlers may register more handlers for this event while we're here
+	for (size_t i = 0; i < h.callbacks.size(); i++) {
+		const int ref = h.callbacks[i];
+		if (ref == LUA_NOREF) continue;
+
+		lua_rawgeti(l, LUA_REGISTRYINDEX, ref);
+		for (int a = 1; a <= e.numArgs; a++)
+			lua_rawgeti(l, args, e.firstArg + a);
+
+		if (!h.timed) {
+			pi_lua_protected_call(l, e.numArgs, 0);
+			continue;
+		}
+
+		lua_Debug ar;
+		lua_pushvalue(l, args + 1);
+		lua_getinfo(l, ">S", &ar);
+
+		const Uint32 start = SDL_GetTicks();
+		pi_lua_protected_call(l, e.numArgs, 0);
+		const Uint32 end = SDL_GetTicks();
+
+		// the registry still holds the function, so ar.source is valid
+		Output("DEBUG: %s %dms %s:%d\n", e.handlers->first.c_str(), int(end - start), ar.source, ar.linedefined);
+	}
 
-	LUA_DEBUG_END(l, 1);
+	lua_pop(l, 1);
 
-	return true;
+	LUA_DEBUG_END(l, 0);
 }
 
 void Clear()
 {
+	assert(s_emitDepth == 0);
+	_reset_pending(Lua::manager->GetLuaState());
+}
+
+void Emit()
+{
+	PROFILE_SCOPED()
+	if (s_nextPending >= s_pending.size())
+		return;
+
 	lua_State *l = Lua::manager->GetLuaState();
 
-	LUA_DEBUG_START(l);
-	if (!_get_method_onto_stack(l, "_Clear")) return;
-	pi_lua_protected_call(l, 0, 0);
-	LUA_DEBUG_END(l, 0);
+	// events queued by the handlers are delivered in this same pass. a
+	// handler may also cause a nested Emit, which carries on from here
+	++s_emitDepth;
+	while (s_nextPending < s_pending.size()) {
+		const PendingEvent e = s_pending[s_nextPending++];
+		_dispatch(l, e);
+	}
+	--s_emitDepth;
+
+	if (s_emitDepth == 0) {
+		_reset_pending(l);
+		for (HandlerMap::iterator it = s_handlers.begin(); it != s_handlers.end(); ++it)
+			_compact(it->second);
+	}
 }
 
-void Emit()
+// events are kept even if nothing is listening yet, as a handler registered
+// before the next Emit still gets them. the handlers are looked at then
+void Queue(const char *event, const ArgsBase &args)
 {
+	HandlerMap::iterator it = s_handlers.insert(std::make_pair(std::string(event), HandlerList())).first;
+
 	lua_State *l = Lua::manager->GetLuaState();
 
 	LUA_DEBUG_START(l);
-	if (!_get_method_onto_stack(l, "_Emit")) return;
-	pi_lua_protected_call(l, 0, 0);
+
+	const int top = lua_gettop(l);
+	args.PrepareStack();
+	_push_pending(l, &*it, top + 1, lua_gettop(l) - top);
+	lua_settop(l, top);
+
 	LUA_DEBUG_END(l, 0);
 }
 
-void Queue(const char *event, const ArgsBase &args)
+// returns the index of cb in h, or -1
+static int _find_callback(lua_State *l, const HandlerList &h, int cb)
+{
+	for (size_t i = 0; i < h.callbacks.size(); i++) {
+		if (h.callbacks[i] == LUA_NOREF) continue;
+		lua_rawgeti(l, LUA_REGISTRYINDEX, h.callbacks[i]);
+		const bool same = lua_rawequal(l, -1, cb);
+		lua_pop(l, 1);
+		if (same) return i;
+	}
+	return -1;
+}
+
+static int l_event_register(lua_State *l)
+{
+	const std::string name(luaL_checkstring(l, 1));
+	luaL_checktype(l, 2, LUA_TFUNCTION);
+
+	HandlerList &h = s_handlers[name];
+	if (_find_callback(l, h, 2) >= 0)
+		return 0;
+
+	lua_pushvalue(l, 2);
+	h.callbacks.push_back(luaL_ref(l, LUA_REGISTRYINDEX));
+	h.live++;
+
+	return 0;
+}
+
+static int l_event_deregister(lua_State *l)
+{
+	const std::string name(luaL_checkstring(l, 1));
+
+	HandlerMap::iterator it = s_handlers.find(name);
+	if (it == s_handlers.end())
+		return 0;
+
+	HandlerList &h = it->second;
+	const int i = _find_callback(l, h, 2);
+	if (i < 0)
+		return 0;
+
+	luaL_unref(l, LUA_REGISTRYINDEX, h.callbacks[i]);
+	h.callbacks[i] = LUA_NOREF;
+	h.live--;
+	if (s_emitDepth == 0)
+		_compact(h);
+
+	return 0;
+}
+
+static int l_event_queue(lua_State *l)
+{
+	HandlerMap::iterator it = s_handlers.insert(std::make_pair(std::string(luaL_checkstring(l, 1)), HandlerList())).first;
+	_push_pending(l, &*it, 2, lua_gettop(l) - 1);
+
+	return 0;
+}
+
+static int l_event_debug_timer(lua_State *l)
+{
+	s_handlers[luaL_checkstring(l, 1)].timed = lua_toboolean(l, 2);
+	return 0;
+}
+
+void Register()
 {
 	lua_State *l = Lua::manager->GetLuaState();
 
 	LUA_DEBUG_START(l);
-	if (!_get_method_onto_stack(l, "Queue")) return;
 
-	int top = lua_gettop(l);
-    lua_pushstring(l, event);
-	args.PrepareStack();
-	pi_lua_protected_call(l, lua_gettop(l) - top, 0);
+	// anything left over belongs to a previous Lua state
+	s_handlers.clear();
+	s_emitDepth = 0;
+	_reset_pending(l);
+
+	static const luaL_Reg methods[]= {
+		{ "Register",   l_event_register    },
+		{ "Deregister", l_event_deregister  },
+		{ "Queue",      l_event_queue       },
+		{ "DebugTimer", l_event_debug_timer },
+		{ 0, 0 }
+	};
+
+	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
+	luaL_newlib(l, methods);
+	lua_setfield(l, -2, "Event");
+	lua_pop(l, 1);
 
 	LUA_DEBUG_END(l, 0);
 }
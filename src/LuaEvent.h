@@ -70,6 +70,10 @@ namespace LuaEvent {
 		inline void PrepareStack() const {}
 	};
 
+	// sets up the Event core import. handlers and the queue live natively;
+	// queued events go to the handlers registered when Emit runs
+	void Register();
+
 	void Clear();
 	void Emit();
 
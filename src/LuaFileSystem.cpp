@@ -165,7 +165,7 @@ void LuaFileSystem::Register()
 	};
 
 	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
-	LuaObjectBase::CreateObject(l_methods, 0, 0, true); // protected interface
+	LuaObjectBase::CreateObject("FileSystem", l_methods, 0, 0, true); // protected interface
 	lua_setfield(l, -2, "FileSystem");
 	lua_pop(l, 1);
 
@@ -154,7 +154,7 @@ void LuaFormat::Register()
 	};
 
 	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
-	LuaObjectBase::CreateObject(l_methods, 0, 0);
+	LuaObjectBase::CreateObject("Format", l_methods, 0, 0);
 	lua_setfield(l, -2, "Format");
 	lua_pop(l, 1);
 
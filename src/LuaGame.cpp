@@ -109,6 +109,55 @@ static int l_game_load_game(lua_State *l)
 	return 0;
 }
 
+/*
+ * Function: SaveGameStats
+ *
+ * Get the summary of a saved game, without loading it.
+ *
+ * > stats = Game.SaveGameStats(filename)
+ *
+ * Parameters:
+ *
+ *   filename - Filename of the save, in the 'savefiles' directory in the
+ *              user's game directory.
+ *
+ * Return:
+ *
+ *   stats - a table with the fields time, system, location, money,
+ *           ship_type and ship_label, or nil if the save has no summary
+ *           (older saves and plain json saves don't)
+ *
+ * Availability:
+ *
+ *   2015
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_game_save_game_stats(lua_State *l)
+{
+	const std::string filename(luaL_checkstring(l, 1));
+
+	Json::Value summary;
+	try {
+		if (!Game::ReadSaveSummary(filename, summary))
+			return 0;
+	}
+	catch (std::invalid_argument &) {
+		return luaL_error(l, "invalid save file name '%s'", filename.c_str());
+	}
+
+	lua_newtable(l);
+	pi_lua_settable(l, "time", summary.get("time", 0.0).asDouble());
+	pi_lua_settable(l, "system", summary.get("system", "").asString().c_str());
+	pi_lua_settable(l, "location", summary.get("location", "").asString().c_str());
+	pi_lua_settable(l, "money", summary.get("money", 0.0).asDouble());
+	pi_lua_settable(l, "ship_type", summary.get("ship_type", "").asString().c_str());
+	pi_lua_settable(l, "ship_label", summary.get("ship_label", "").asString().c_str());
+	return 1;
+}
+
 /*
  * Function: SaveGame
  *
@@ -116,6 +165,9 @@ static int l_game_load_game(lua_State *l)
  *
  * > path = Game.SaveGame(filename)
  *
+ * The game is captured straight away and written to disk in the background.
+ * If the write fails, that's reported in the game log.
+ *
  * Parameters:
  *
  *   filename - Filename to save to. The file will be placed the 'savefiles'
@@ -299,6 +351,7 @@ void LuaGame::Register()
 		{ "StartGame", l_game_start_game },
 		{ "LoadGame",  l_game_load_game  },
 		{ "SaveGame",  l_game_save_game  },
+		{ "SaveGameStats", l_game_save_game_stats },
 		{ "EndGame",   l_game_end_game   },
 
 		{ "SwitchView", l_game_switch_view },
@@ -315,7 +368,7 @@ void LuaGame::Register()
 	};
 
 	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
-	LuaObjectBase::CreateObject(l_methods, l_attrs, 0);
+	LuaObjectBase::CreateObject("Game", l_methods, l_attrs, 0);
 	lua_setfield(l, -2, "Game");
 	lua_pop(l, 1);
 
@@ -135,7 +135,7 @@ void LuaLang::Register()
 	};
 
 	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
-	LuaObjectBase::CreateObject(l_methods, l_attrs, 0);
+	LuaObjectBase::CreateObject("Lang", l_methods, l_attrs, 0);
 	lua_setfield(l, -2, "Lang");
 	lua_pop(l, 1);
 
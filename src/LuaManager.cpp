@@ -3,17 +3,81 @@
 
 #include "LuaManager.h"
 #include "FileSystem.h"
+#include "StringF.h"
+#include <SDL_timer.h>
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 
 bool instantiated = false;
 
-LuaManager::LuaManager() : m_lua(0) {
+// work to do per incremental step, roughly in KB. small enough that a step
+// doesn't overshoot the budget by much
+static const int GC_STEP_SIZE = 8;
+// start a new cycle once memory use has grown this much since the last one
+// ended (Lua's own default pause)
+static const int GC_PAUSE_PERCENT = 200;
+// if it grows to this much, the budget isn't keeping up with the rate of
+// allocation so the cycle is finished regardless
+static const int GC_BEHIND_PERCENT = 400;
+
+LuaManager::SmallBlockPool::SmallBlockPool() : m_chunkPos(0), m_chunkLeft(0) {
+	for (int i = 0; i < NUM_CLASSES; i++)
+		m_freeLists[i] = 0;
+}
+
+LuaManager::SmallBlockPool::~SmallBlockPool() {
+	for (void *chunk : m_chunks)
+		free(chunk);
+}
+
+void *LuaManager::SmallBlockPool::Alloc(size_t size) {
+	const size_t c = ClassOf(size);
+
+	// free blocks hold the link to the next one
+	if (m_freeLists[c]) {
+		void *p = m_freeLists[c];
+		m_freeLists[c] = *static_cast<void**>(p);
+		return p;
+	}
+
+	const size_t blockSize = (c + 1) * GRANULARITY;
+	if (m_chunkLeft < blockSize) {
+		// whatever was left of the old chunk is too small for this class,
+		// but it can go to a smaller one
+		if (m_chunkLeft >= GRANULARITY)
+			Free(m_chunkPos, m_chunkLeft - (m_chunkLeft % GRANULARITY));
+
+		m_chunkPos = static_cast<char*>(malloc(CHUNK_SIZE));
+		if (!m_chunkPos) {
+			m_chunkLeft = 0;
+			return 0;
+		}
+		m_chunks.push_back(m_chunkPos);
+		m_chunkLeft = CHUNK_SIZE;
+	}
+
+	void *p = m_chunkPos;
+	m_chunkPos += blockSize;
+	m_chunkLeft -= blockSize;
+	return p;
+}
+
+void LuaManager::SmallBlockPool::Free(void *p, size_t size) {
+	const size_t c = ClassOf(size);
+	*static_cast<void**>(p) = m_freeLists[c];
+	m_freeLists[c] = p;
+}
+
+LuaManager::LuaManager() : m_lua(0), m_running(0), m_gcBudget(0.0), m_gcTime(0.0), m_gcCycles(0), m_gcCycleEndUsage(0), m_gcCycleActive(false),
+	m_bytesAllocated(0), m_profiling(false), m_profileStart(0), m_profileStop(0) {
 	if (instantiated) {
 		Output("Can't instantiate more than one LuaManager");
 		abort();
 	}
 
-	m_lua = luaL_newstate();
+	m_lua = lua_newstate(&LuaManager::Allocate, this);
+	m_running = m_lua;
 	pi_lua_open_standard_base(m_lua);
 	lua_atpanic(m_lua, pi_lua_panic);
 
@@ -26,6 +90,59 @@ LuaManager::~LuaManager() {
 	instantiated = false;
 }
 
+int LuaManager::Resume(lua_State *thread, int nargs) {
+	lua_State *prev = m_running;
+	m_running = thread;
+	const int ret = lua_resume(thread, prev, nargs);
+	m_running = prev;
+	return ret;
+}
+
+// small blocks go to the pool, anything else to the system. blocks are
+// counted for the profiler as they're handed out
+void *LuaManager::Allocate(void *ud, void *ptr, size_t osize, size_t nsize) {
+	LuaManager *m = static_cast<LuaManager*>(ud);
+	SmallBlockPool &pool = m->m_pool;
+
+	// without a block, osize is the type of object being made, not a size
+	if (!ptr)
+		osize = 0;
+
+	if (nsize == 0) {
+		if (ptr) {
+			if (SmallBlockPool::Handles(osize))
+				pool.Free(ptr, osize);
+			else
+				free(ptr);
+		}
+		return 0;
+	}
+
+	if (nsize > osize)
+		m->m_bytesAllocated += nsize - osize;
+
+	if (!ptr)
+		return SmallBlockPool::Handles(nsize) ? pool.Alloc(nsize) : malloc(nsize);
+
+	const bool wasPooled = SmallBlockPool::Handles(osize);
+	const bool pooled = SmallBlockPool::Handles(nsize);
+	if (!wasPooled && !pooled)
+		return realloc(ptr, nsize);
+	if (wasPooled && pooled && SmallBlockPool::ClassOf(osize) == SmallBlockPool::ClassOf(nsize))
+		return ptr;
+
+	// moving between the pool and the system, or between size classes
+	void *p = pooled ? pool.Alloc(nsize) : malloc(nsize);
+	if (!p)
+		return 0;
+	memcpy(p, ptr, std::min(osize, nsize));
+	if (wasPooled)
+		pool.Free(ptr, osize);
+	else
+		free(ptr);
+	return p;
+}
+
 size_t LuaManager::GetMemoryUsage() const {
 	int kb = lua_gc(m_lua, LUA_GCCOUNT, 0);
 	int b = lua_gc(m_lua, LUA_GCCOUNTB, 0);
@@ -34,4 +151,199 @@ size_t LuaManager::GetMemoryUsage() const {
 
 void LuaManager::CollectGarbage() {
 	lua_gc(m_lua, LUA_GCCOLLECT, 0);
+	m_gcCycleEndUsage = GetMemoryUsage();
+	m_gcCycleActive = false;
+}
+
+void LuaManager::SetGarbageBudget(double seconds) {
+	m_gcBudget = seconds;
+	if (m_gcBudget > 0.0) {
+		lua_gc(m_lua, LUA_GCSTOP, 0);
+		// lua may be part way through a cycle; carry on with it
+		m_gcCycleActive = true;
+	} else
+		lua_gc(m_lua, LUA_GCRESTART, 0);
+}
+
+void LuaManager::StepGarbage() {
+	PROFILE_SCOPED()
+	m_gcTime = 0.0;
+	if (m_gcBudget <= 0.0)
+		return;
+
+	const size_t usage = GetMemoryUsage();
+	if (!m_gcCycleActive) {
+		if (usage < m_gcCycleEndUsage / 100 * GC_PAUSE_PERCENT)
+			return;
+		m_gcCycleActive = true;
+	}
+
+	const bool behind = usage > m_gcCycleEndUsage / 100 * GC_BEHIND_PERCENT;
+
+	const Uint64 start = SDL_GetPerformanceCounter();
+	const Uint64 budget = Uint64(m_gcBudget * double(SDL_GetPerformanceFrequency()));
+	do {
+		if (lua_gc(m_lua, LUA_GCSTEP, GC_STEP_SIZE)) {
+			m_gcCycleEndUsage = GetMemoryUsage();
+			m_gcCycleActive = false;
+			m_gcCycles++;
+			break;
+		}
+	} while (behind || SDL_GetPerformanceCounter() - start < budget);
+
+	m_gcTime = double(SDL_GetPerformanceCounter() - start) / double(SDL_GetPerformanceFrequency());
+}
+
+void LuaManager::StartProfiler() {
+	if (m_profiling) return;
+
+	m_profile.clear();
+	m_profileStacks.clear();
+	m_profileStart = SDL_GetPerformanceCounter();
+	m_profiling = true;
+
+	// coroutines made from here on pick the hook up from their parent
+	lua_sethook(m_lua, &LuaManager::ProfilerHook, LUA_MASKCALL | LUA_MASKRET, 0);
+}
+
+void LuaManager::StopProfiler() {
+	if (!m_profiling) return;
+
+	lua_sethook(m_lua, 0, 0, 0);
+	m_profileStacks.clear();
+	m_profileStop = SDL_GetPerformanceCounter();
+	m_profiling = false;
+}
+
+void LuaManager::ProfilerHook(lua_State *l, lua_Debug *ar) {
+	void *ud;
+	lua_getallocf(l, &ud);
+	LuaManager *m = static_cast<LuaManager*>(ud);
+
+	// coroutines keep the hook after the profiler is stopped
+	if (!m->m_profiling) {
+		lua_sethook(l, 0, 0, 0);
+		return;
+	}
+
+	if (ar->event == LUA_HOOKRET)
+		m->ProfileReturn(l);
+	else
+		m->ProfileCall(l, ar, ar->event == LUA_HOOKTAILCALL);
+}
+
+void LuaManager::ProfileCall(lua_State *l, lua_Debug *ar, bool tail) {
+	lua_getinfo(l, "Sf", ar);
+	ProfileKey key;
+	if (lua_iscfunction(l, -1)) {
+		key.id = reinterpret_cast<const void*>(lua_tocfunction(l, -1));
+		key.line = -1;
+	} else {
+		key.id = ar->source;
+		key.line = ar->linedefined;
+	}
+	lua_pop(l, 1);
+
+	ProfileEntry &e = m_profile[key];
+	if (e.calls == 0) {
+		lua_getinfo(l, "n", ar);
+		e.source = ar->short_src;
+		if (ar->name)
+			e.name = ar->name;
+		else if (key.line > 0)
+			e.name = "<anonymous>";
+		else
+			e.name = "?";
+	}
+	e.calls++;
+
+	ProfileFrame f;
+	f.entry = &e;
+	f.childTicks = 0;
+	f.startBytes = m_bytesAllocated;
+	f.childBytes = 0;
+	f.tail = tail;
+	f.start = SDL_GetPerformanceCounter();
+	m_profileStacks[l].push_back(f);
+}
+
+void LuaManager::ProfileReturn(lua_State *l) {
+	const Uint64 now = SDL_GetPerformanceCounter();
+	std::vector<ProfileFrame> &stack = m_profileStacks[l];
+
+	// a tail call replaced its caller's frame, so finishing it finishes the
+	// caller too. returns from frames entered before the profiler started
+	// have nothing to match and are dropped
+	bool more = true;
+	while (more && !stack.empty()) {
+		const ProfileFrame f = stack.back();
+		stack.pop_back();
+		more = f.tail;
+
+		const Uint64 ticks = now - f.start;
+		const Uint64 bytes = m_bytesAllocated - f.startBytes;
+		f.entry->totalTicks += ticks;
+		f.entry->selfTicks += ticks - std::min(ticks, f.childTicks);
+		f.entry->selfBytes += bytes - std::min(bytes, f.childBytes);
+
+		if (!stack.empty()) {
+			stack.back().childTicks += ticks;
+			stack.back().childBytes += bytes;
+		}
+	}
+}
+
+std::string LuaManager::DumpProfile() const {
+	const double freq = double(SDL_GetPerformanceFrequency());
+	char buf[512];
+	std::string out;
+
+	struct Total {
+		Total() : calls(0), selfTicks(0), totalTicks(0), selfBytes(0) {}
+		Uint64 calls, selfTicks, totalTicks, selfBytes;
+		void Add(const ProfileEntry &e) {
+			calls += e.calls;
+			selfTicks += e.selfTicks;
+			totalTicks += e.totalTicks;
+			selfBytes += e.selfBytes;
+		}
+	};
+
+	// closures made from the same function all count as one, as do the C
+	// functions bound under the same name
+	std::map<std::string, Total> functions;
+	std::map<std::string, Total> files;
+	for (auto it = m_profile.begin(); it != m_profile.end(); ++it) {
+		const ProfileEntry &e = it->second;
+		const std::string where = it->first.line >= 0 ? stringf("%0:%1", e.source, it->first.line) : e.source;
+		functions[e.name + " (" + where + ")"].Add(e);
+		files[e.source].Add(e);
+	}
+
+	const double elapsed = double((m_profiling ? SDL_GetPerformanceCounter() : m_profileStop) - m_profileStart) / freq;
+	snprintf(buf, sizeof(buf), "lua profile over %.1fs\n", elapsed);
+	out += buf;
+
+	// total time means little for a file, since its functions call each other
+	const std::map<std::string, Total> *tables[] = { &files, &functions };
+	const char *titles[] = { "file", "function" };
+	for (int t = 0; t < 2; t++) {
+		std::vector<std::pair<Uint64, const std::string*> > sorted;
+		for (auto it = tables[t]->begin(); it != tables[t]->end(); ++it)
+			sorted.push_back(std::make_pair(it->second.selfTicks, &it->first));
+		std::sort(sorted.rbegin(), sorted.rend());
+
+		snprintf(buf, sizeof(buf), "\n%-60s %10s %10s %10s %10s\n", titles[t], "calls", "self ms", "total ms", "self KB");
+		out += buf;
+		for (auto it = sorted.begin(); it != sorted.end(); ++it) {
+			const Total &total = tables[t]->find(*it->second)->second;
+			const std::string inclusive = t == 0 ? "-" : stringf("%0{f.2}", double(total.totalTicks) / freq * 1e3);
+			snprintf(buf, sizeof(buf), "%-60s %10llu %10.2f %10s %10.1f\n", it->second->c_str(),
+				static_cast<unsigned long long>(total.calls), double(total.selfTicks) / freq * 1e3,
+				inclusive.c_str(), double(total.selfBytes) / 1024.0);
+			out += buf;
+		}
+	}
+
+	return out;
 }
@@ -5,21 +5,133 @@
 #define _LUAMANAGER_H
 
 #include "LuaUtils.h"
+#include <SDL_stdinc.h>
+#include <map>
+#include <vector>
 
 class LuaManager {
 public:
 	LuaManager();
 	~LuaManager();
 
-	lua_State *GetLuaState() { return m_lua; }
+	// the thread C functions should work on: the main thread, except while
+	// a coroutine is being run through Resume
+	lua_State *GetLuaState() { return m_running; }
+	lua_State *GetMainThread() { return m_lua; }
+
+	// lua_resume, with the coroutine made the current Lua state for as long
+	// as it runs. LuaObject and friends find their stack through
+	// GetLuaState, so without this they'd be looking at the wrong one
+	int Resume(lua_State *thread, int nargs);
+
 	size_t GetMemoryUsage() const;
 	void CollectGarbage();
 
+	// with a budget (in seconds), the collector no longer runs whenever the
+	// allocator decides, only in StepGarbage, which does no more than the
+	// budget's worth of incremental steps. zero hands control back to Lua
+	void SetGarbageBudget(double seconds);
+	void StepGarbage();
+	// seconds spent in the last StepGarbage, and full cycles since startup
+	double GetGarbageTime() const { return m_gcTime; }
+	Uint32 GetGarbageCycles() const { return m_gcCycles; }
+
+	// hook based script profiler. while running, every call and return is
+	// timed and allocations are charged to the function that made them.
+	// times are self times, excluding anything the function called
+	void StartProfiler();
+	void StopProfiler();
+	bool IsProfiling() const { return m_profiling; }
+	// per-function and per-file totals since the profiler was started
+	std::string DumpProfile() const;
+
 private:
 	LuaManager(const LuaManager &);
 	LuaManager &operator=(const LuaManager &);
 
+	static void *Allocate(void *ud, void *ptr, size_t osize, size_t nsize);
+
+	// most of what Lua allocates (strings, tables, closures, upvalues) is
+	// tiny. those blocks come from per-size free lists carved out of larger
+	// chunks instead of going to the system allocator one by one. chunks
+	// are only given back when the manager goes away
+	class SmallBlockPool {
+	public:
+		enum {
+			GRANULARITY = 16,
+			MAX_SIZE = 256,
+			NUM_CLASSES = MAX_SIZE / GRANULARITY,
+			CHUNK_SIZE = 64 * 1024
+		};
+
+		SmallBlockPool();
+		~SmallBlockPool();
+
+		static bool Handles(size_t size) { return size <= MAX_SIZE; }
+		static size_t ClassOf(size_t size) { return (size - 1) / GRANULARITY; }
+
+		void *Alloc(size_t size);
+		void Free(void *p, size_t size);
+
+	private:
+		SmallBlockPool(const SmallBlockPool &);
+		SmallBlockPool &operator=(const SmallBlockPool &);
+
+		void *m_freeLists[NUM_CLASSES];
+		char *m_chunkPos;
+		size_t m_chunkLeft;
+		std::vector<void*> m_chunks;
+	};
+	static void ProfilerHook(lua_State *l, lua_Debug *ar);
+
+	// Lua functions are told apart by source and line (their source strings
+	// are interned, so the pointer will do), C functions by address
+	struct ProfileKey {
+		const void *id;
+		int line;
+		bool operator<(const ProfileKey &o) const { return id != o.id ? id < o.id : line < o.line; }
+	};
+	struct ProfileEntry {
+		ProfileEntry() : calls(0), selfTicks(0), totalTicks(0), selfBytes(0) {}
+		std::string name;
+		std::string source;
+		Uint64 calls;
+		Uint64 selfTicks;
+		Uint64 totalTicks;
+		Uint64 selfBytes;
+	};
+	struct ProfileFrame {
+		ProfileEntry *entry;
+		Uint64 start;
+		Uint64 childTicks;
+		Uint64 startBytes;
+		Uint64 childBytes;
+		bool tail;
+	};
+
+	void ProfileCall(lua_State *l, lua_Debug *ar, bool tail);
+	void ProfileReturn(lua_State *l);
+
+	SmallBlockPool m_pool;
 	lua_State *m_lua;
+	lua_State *m_running;
+
+	double m_gcBudget;
+	double m_gcTime;
+	Uint32 m_gcCycles;
+	// memory in use when the last cycle finished, and whether one is running
+	size_t m_gcCycleEndUsage;
+	bool m_gcCycleActive;
+
+	// running total of bytes handed out by the allocator
+	Uint64 m_bytesAllocated;
+
+	bool m_profiling;
+	Uint64 m_profileStart;
+	Uint64 m_profileStop;
+	std::map<ProfileKey, ProfileEntry> m_profile;
+	// coroutines each have their own call stack
+	std::map<lua_State*, std::vector<ProfileFrame> > m_profileStacks;
 };
 
 #endif
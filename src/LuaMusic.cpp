@@ -251,7 +251,7 @@ void LuaMusic::Register()
 	};
 
 	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
-	LuaObjectBase::CreateObject(l_methods, 0, 0);
+	LuaObjectBase::CreateObject("Music", l_methods, 0, 0);
 	lua_setfield(l, -2, "Music");
 	lua_pop(l, 1);
 
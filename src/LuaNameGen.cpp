@@ -5,6 +5,7 @@
 #include "LuaObject.h"
 #include "galaxy/StarSystem.h"
 #include "Random.h"
+#include <cstring>
 
 static const std::string DEFAULT_FULL_NAME_MALE("Tom Morton");
 static const std::string DEFAULT_FULL_NAME_FEMALE("Thomasina Mortonella");
@@ -31,7 +32,148 @@ static bool GetNameGenFunc(lua_State *l, const char *func)
 	return true;
 }
 
+// true if NameGen[func] is the one from the stock libs/NameGen.lua, which
+// the native versions below follow. loaded from a trusted source, so a mod's
+// replacement for the whole file doesn't count
+static bool IsStockFunc(lua_State *l, const char *func)
+{
+	LUA_DEBUG_START(l);
+
+	if (!GetNameGenFunc(l, func))
+		return false;
+
+	bool stock = false;
+	if (lua_isfunction(l, -1)) {
+		lua_Debug ar;
+		lua_getinfo(l, ">S", &ar);
+		stock = strcmp(ar.source, "[T] @libs/NameGen.lua") == 0;
+	} else
+		lua_pop(l, 1);
+
+	LUA_DEBUG_END(l, 0);
+	return stock;
+}
+
+// copies NameGen.<table>[.<subtable>]. false if it's missing or empty, as
+// the Lua side would fail to pick from it
+static bool GetNameList(lua_State *l, const char *table, const char *subtable, std::vector<std::string> &out)
+{
+	LUA_DEBUG_START(l);
+
+	out.clear();
+	if (!pi_lua_import(l, "NameGen"))
+		return false;
+
+	lua_getfield(l, -1, table);
+	if (subtable && lua_istable(l, -1)) {
+		lua_getfield(l, -1, subtable);
+		lua_remove(l, -2);
+	}
+	if (lua_istable(l, -1)) {
+		const int len = lua_rawlen(l, -1);
+		out.reserve(len);
+		for (int i = 1; i <= len; i++) {
+			lua_rawgeti(l, -1, i);
+			if (lua_type(l, -1) == LUA_TSTRING)
+				out.push_back(lua_tostring(l, -1));
+			lua_pop(l, 1);
+		}
+		if (int(out.size()) != len)
+			out.clear();
+	}
+	lua_pop(l, 2);
+
+	LUA_DEBUG_END(l, 0);
+	return !out.empty();
+}
+
+// same as rand:Integer(1,#t) on the Lua side
+static inline const std::string &Pick(const std::vector<std::string> &list, Random &rng)
+{
+	return list[rng.Int32(1, list.size()) - 1];
+}
+
+// string.interp(format, { name = name })
+static std::string Interp(const std::string &format, const std::string &name)
+{
+	static const std::string key("{name}");
+	std::string out;
+	out.reserve(format.size() + name.size());
+	size_t start = 0, pos;
+	while ((pos = format.find(key, start)) != std::string::npos) {
+		out.append(format, start, pos - start);
+		out.append(name);
+		start = pos + key.size();
+	}
+	out.append(format, start, std::string::npos);
+	return out;
+}
+
+LuaNameGen::LuaNameGen(LuaManager *manager) :
+	m_luaManager(manager)
+{
+	lua_State *l = m_luaManager->GetLuaState();
+
+	m_nativeSurname = IsStockFunc(l, "Surname") &&
+		GetNameList(l, "surnames", 0, m_surnames);
+
+	m_nativeFullName = IsStockFunc(l, "FullName") &&
+		GetNameList(l, "firstNames", "male", m_maleNames) &&
+		GetNameList(l, "firstNames", "female", m_femaleNames);
+
+	m_nativeBodyName = IsStockFunc(l, "BodyName") &&
+		GetNameList(l, "outdoorPlanetFormats", 0, m_outdoorPlanetFormats) &&
+		GetNameList(l, "rockPlanetFormats", 0, m_rockPlanetFormats) &&
+		GetNameList(l, "orbitalStarportFormats", 0, m_orbitalStarportFormats) &&
+		GetNameList(l, "surfaceStarportFormats", 0, m_surfaceStarportFormats);
+
+	if (!m_nativeSurname || !m_nativeFullName || !m_nativeBodyName)
+		Output("LuaNameGen: NameGen has been changed, using Lua for%s%s%s\n",
+			m_nativeFullName ? "" : " FullName", m_nativeSurname ? "" : " Surname", m_nativeBodyName ? "" : " BodyName");
+}
+
 std::string LuaNameGen::FullName(bool isFemale, RefCountedPtr<Random> &rng)
+{
+	if (!m_nativeFullName)
+		return LuaFullName(isFemale, rng);
+
+	const std::string &firstname = Pick(isFemale ? m_femaleNames : m_maleNames, *rng);
+	return firstname + " " + Surname(rng);
+}
+
+std::string LuaNameGen::Surname(RefCountedPtr<Random> &rng)
+{
+	if (!m_nativeSurname)
+		return LuaSurname(rng);
+
+	return Pick(m_surnames, *rng);
+}
+
+std::string LuaNameGen::BodyName(SystemBody *body, RefCountedPtr<Random> &rng)
+{
+	if (!m_nativeBodyName)
+		return LuaBodyName(body, rng);
+
+	const std::vector<std::string> *formats;
+	if (body->GetType() == SystemBody::TYPE_STARPORT_ORBITAL)
+		formats = &m_orbitalStarportFormats;
+	else if (body->GetType() == SystemBody::TYPE_STARPORT_SURFACE)
+		formats = &m_surfaceStarportFormats;
+	else if (body->GetSuperType() == SystemBody::SUPERTYPE_ROCKY_PLANET) {
+		// XXX -15-50C is "outdoor", as in NameGen.lua
+		if (body->GetAverageTemp() >= 258 && body->GetAverageTemp() <= 323)
+			formats = &m_outdoorPlanetFormats;
+		else
+			formats = &m_rockPlanetFormats;
+	} else
+		// let Lua raise the error
+		return LuaBodyName(body, rng);
+
+	const std::string &format = Pick(*formats, *rng);
+	return Interp(format, Surname(rng));
+}
+
+std::string LuaNameGen::LuaFullName(bool isFemale, RefCountedPtr<Random> &rng)
 {
 	lua_State *l = m_luaManager->GetLuaState();
 
@@ -48,7 +190,7 @@ std::string LuaNameGen::FullName(bool isFemale, RefCountedPtr<Random> &rng)
 	return fullname;
 }
 
-std::string LuaNameGen::Surname(RefCountedPtr<Random> &rng)
+std::string LuaNameGen::LuaSurname(RefCountedPtr<Random> &rng)
 {
 	lua_State *l = m_luaManager->GetLuaState();
 
@@ -64,7 +206,7 @@ std::string LuaNameGen::Surname(RefCountedPtr<Random> &rng)
 	return surname;
 }
 
-std::string LuaNameGen::BodyName(SystemBody *body, RefCountedPtr<Random> &rng)
+std::string LuaNameGen::LuaBodyName(SystemBody *body, RefCountedPtr<Random> &rng)
 {
 	lua_State *l = m_luaManager->GetLuaState();
 
@@ -6,21 +6,43 @@
 
 #include "RefCounted.h"
 #include <string>
+#include <vector>
 
 class LuaManager;
 class Random;
 class SystemBody;
 
+// Names come from the NameGen Lua module. As long as its functions are the
+// stock ones from libs/NameGen.lua they're done here instead, from a copy of
+// its tables taken at construction, giving the same names for the same
+// random numbers without a trip into Lua each time. Any function that has
+// been replaced (by a module, or a mod's NameGen.lua) is called as before.
 class LuaNameGen {
 public:
-	LuaNameGen(LuaManager *manager): m_luaManager(manager) {}
+	LuaNameGen(LuaManager *manager);
 
 	std::string FullName(bool isFemale, RefCountedPtr<Random> &rng);
 	std::string Surname(RefCountedPtr<Random> &rng);
 	std::string BodyName(SystemBody *body, RefCountedPtr<Random> &rng);
 
 private:
+	std::string LuaFullName(bool isFemale, RefCountedPtr<Random> &rng);
+	std::string LuaSurname(RefCountedPtr<Random> &rng);
+	std::string LuaBodyName(SystemBody *body, RefCountedPtr<Random> &rng);
+
 	LuaManager *m_luaManager;
+
+	bool m_nativeFullName;
+	bool m_nativeSurname;
+	bool m_nativeBodyName;
+
+	std::vector<std::string> m_maleNames;
+	std::vector<std::string> m_femaleNames;
+	std::vector<std::string> m_surnames;
+	std::vector<std::string> m_outdoorPlanetFormats;
+	std::vector<std::string> m_rockPlanetFormats;
+	std::vector<std::string> m_orbitalStarportFormats;
+	std::vector<std::string> m_surfaceStarportFormats;
 };
 
 #endif
@@ -7,6 +7,8 @@
 #include "PropertiedObject.h"
 #include "PropertyMap.h"
 
+#include <algorithm>
+#include <deque>
 #include <map>
 #include <utility>
 
@@ -125,6 +127,7 @@ int LuaObjectBase::l_hasprop(lua_State *l)
 {
 	luaL_checktype(l, 1, LUA_TUSERDATA);
 	luaL_checktype(l, 2, LUA_TSTRING);
+	PropertyMap::Sync();
 	lua_getuservalue(l, 1);
 
 	if (lua_isnil(l, -1)) { // Doesn't have properties
@@ -157,10 +160,7 @@ int LuaObjectBase::l_unsetprop(lua_State *l)
 	PropertiedObject *po = dynamic_cast<PropertiedObject*>(o);
 	assert(po);
 
-	po->Properties().PushLuaTable();
-	lua_pushvalue(l, 2);
-	lua_pushnil(l);
-	lua_settable(l, -3);
+	po->Properties().Unset(key);
 
 	return 0;
 }
@@ -230,6 +230,24 @@ int LuaObjectBase::l_tostring(lua_State *l)
 	return 1;
 }
 
+// pushes the method table for the class. what's published under the class
+// name is an empty proxy whose __index is the real table
+static void push_method_table(lua_State *l, const std::string &type)
+{
+	LUA_DEBUG_START(l);
+
+	pi_lua_split_table_path(l, type);
+	lua_rawget(l, -2);
+	lua_remove(l, -2);
+	lua_getmetatable(l, -1);
+	lua_pushstring(l, "__index");
+	lua_rawget(l, -2);
+	lua_replace(l, -3);
+	lua_pop(l, 1);
+
+	LUA_DEBUG_END(l, 1);
+}
+
 // takes metatable on top of stack
 // if there's a parent, leaves next metatable, method on stack
 // if there's no parent, leaves nil, method on stack
@@ -243,9 +261,7 @@ static void get_next_method_table(lua_State *l)
 
 	const std::string type(lua_tostring(l, -1));
 	lua_pop(l, 1);                     // object, metatable
-	pi_lua_split_table_path(l, type);  // object, metatable, "global" table, leaf type name
-	lua_rawget(l, -2);                 // object, metatable, "global" table, method table
-	lua_remove(l, -2);                 // object, metatable, method table
+	push_method_table(l, type);        // object, metatable, method table
 
 	// see if the metatable has a parent
 	lua_pushstring(l, "parent");
@@ -285,7 +301,7 @@ static bool get_method_or_attr(lua_State *l)
 	lua_pop(l, 1);
 
 	// didn't find a method, so now we go looking for an attribute handler
-	lua_pushstring(l, (std::string("__attribute_")+lua_tostring(l, -1)).c_str());
+	lua_pushfstring(l, "__attribute_%s", lua_tostring(l, -1));
 	lua_rawget(l, -3);
 
 	// found something, return it
@@ -311,6 +327,161 @@ static bool get_method_or_attr(lua_State *l)
 	return false;
 }
 
+static const char ATTRIBUTE_PREFIX[] = "__attribute_";
+static const size_t ATTRIBUTE_PREFIX_LEN = sizeof(ATTRIBUTE_PREFIX)-1;
+
+// copies every entry of the table at src into the table at dest
+static void copy_table(lua_State *l, int src, int dest)
+{
+	lua_pushnil(l);
+	while (lua_next(l, src)) {
+		lua_pushvalue(l, -2);
+		lua_insert(l, -2);
+		lua_rawset(l, dest);
+	}
+}
+
+// takes metatable on top of stack
+// leaves metatable, method cache, attribute cache on stack
+//
+// the caches flatten the class and all its parents into one table of
+// methods and one of attribute handlers keyed by the bare attribute name,
+// so a lookup is two rawgets no matter how deep the class is. they're
+// built on first use and thrown away whenever a method table is stored to
+static void get_index_cache(lua_State *l)
+{
+	LUA_DEBUG_START(l);
+
+	const int mt = lua_gettop(l);
+
+	lua_pushstring(l, "methodcache");
+	lua_rawget(l, mt);
+	if (!lua_isnil(l, -1)) {
+		lua_pushstring(l, "attrcache");
+		lua_rawget(l, mt);
+		LUA_DEBUG_END(l, 2);
+		return;
+	}
+	lua_pop(l, 1);
+
+	lua_newtable(l);
+	const int methods = lua_gettop(l);
+	lua_newtable(l);
+	const int attrs = lua_gettop(l);
+
+	// start with everything the parent has
+	lua_pushstring(l, "parent");
+	lua_rawget(l, mt);
+	if (!lua_isnil(l, -1)) {
+		lua_rawget(l, LUA_REGISTRYINDEX);  // parent metatable
+		get_index_cache(l);                // parent metatable, method cache, attribute cache
+		copy_table(l, lua_gettop(l)-1, methods);
+		copy_table(l, lua_gettop(l), attrs);
+		lua_pop(l, 3);
+	}
+	else
+		lua_pop(l, 1);
+
+	// then lay our own method table over the top. the chained lookup this
+	// replaces tried a class's methods before its attributes, and a class
+	// before its parent
+	lua_pushstring(l, "type");
+	lua_rawget(l, mt);
+	const std::string type(lua_tostring(l, -1));
+	lua_pop(l, 1);
+	push_method_table(l, type);
+	const int table = lua_gettop(l);
+
+	lua_pushnil(l);
+	while (lua_next(l, table)) {
+		// the raw key stays visible as it was before
+		lua_pushvalue(l, -2);
+		lua_pushvalue(l, -2);
+		lua_rawset(l, methods);
+
+		size_t len;
+		const char *key = lua_type(l, -2) == LUA_TSTRING ? lua_tolstring(l, -2, &len) : 0;
+		if (key && len > ATTRIBUTE_PREFIX_LEN && strncmp(key, ATTRIBUTE_PREFIX, ATTRIBUTE_PREFIX_LEN) == 0) {
+			lua_pushlstring(l, key+ATTRIBUTE_PREFIX_LEN, len-ATTRIBUTE_PREFIX_LEN);
+
+			// a method of the same name in this class wins
+			lua_pushvalue(l, -1);
+			lua_rawget(l, table);
+			const bool shadowed = !lua_isnil(l, -1);
+			lua_pop(l, 1);
+
+			if (!shadowed) {
+				lua_pushvalue(l, -1);
+				lua_pushvalue(l, -3);
+				lua_rawset(l, attrs);
+				lua_pushnil(l);
+				lua_rawset(l, methods);
+			}
+			else
+				lua_pop(l, 1);
+		}
+		else {
+			lua_pushvalue(l, -2);
+			lua_pushnil(l);
+			lua_rawset(l, attrs);
+		}
+
+		lua_pop(l, 1);
+	}
+	lua_pop(l, 1);
+
+	lua_pushstring(l, "methodcache");
+	lua_pushvalue(l, methods);
+	lua_rawset(l, mt);
+	lua_pushstring(l, "attrcache");
+	lua_pushvalue(l, attrs);
+	lua_rawset(l, mt);
+
+	LUA_DEBUG_END(l, 2);
+}
+
+// __newindex for method table proxies, with the method table as upvalue.
+// any store may change what a class or one of its children resolves a name
+// to, so drop every cache
+static int l_method_table_newindex(lua_State *l)
+{
+	lua_rawset(l, lua_upvalueindex(1));
+
+	lua_getfield(l, LUA_REGISTRYINDEX, "LuaObjectClasses");
+	lua_pushnil(l);
+	while (lua_next(l, -2)) {
+		lua_pop(l, 1);                     // classes, metatable
+		lua_pushstring(l, "methodcache");
+		lua_pushnil(l);
+		lua_rawset(l, -3);
+		lua_pushstring(l, "attrcache");
+		lua_pushnil(l);
+		lua_rawset(l, -3);
+	}
+	lua_pop(l, 1);
+
+	return 0;
+}
+
+static int l_method_table_next(lua_State *l)
+{
+	luaL_checktype(l, 1, LUA_TTABLE);
+	lua_settop(l, 2);
+	if (lua_next(l, 1))
+		return 2;
+	lua_pushnil(l);
+	return 1;
+}
+
+// __pairs for method table proxies, so they iterate like the table itself
+static int l_method_table_pairs(lua_State *l)
+{
+	lua_pushcfunction(l, l_method_table_next);
+	lua_pushvalue(l, lua_upvalueindex(1));
+	lua_pushnil(l);
+	return 3;
+}
+
 int LuaObjectBase::l_dispatch_index(lua_State *l)
 {
 	// userdata are typed, tables are not
@@ -328,31 +499,39 @@ int LuaObjectBase::l_dispatch_index(lua_State *l)
 	else {
 
 		// first check properties. we don't need to drill through lua if the
-		// property is already available
+		// property is already available. properties are plain values, so
+		// there's no attribute handler to look for
+		PropertyMap::Sync();
 		lua_getuservalue(l, 1);
 		if (!lua_isnil(l, -1)) {
 			lua_pushvalue(l, 2);
-			if (get_method_or_attr(l))
+			lua_rawget(l, -2);
+			if (!lua_isnil(l, -1))
 				return 1;
 			lua_pop(l, 1);
 		}
 		lua_pop(l, 1);
 
 		lua_getmetatable(l, 1);
-		while (1) {
-			get_next_method_table(l);
-
-			lua_pushvalue(l, 2);
-			if (get_method_or_attr(l))
-				return 1;
+		get_index_cache(l);                // metatable, method cache, attribute cache
 
-			// not found. remove name copy and method table
-			lua_pop(l, 2);
+		lua_pushvalue(l, 2);
+		lua_rawget(l, -3);
+		if (!lua_isnil(l, -1))
+			return 1;
+		lua_pop(l, 1);
 
-			// if there's no parent metatable, get out
-			if (lua_isnil(l, -1))
-				break;
+		lua_pushvalue(l, 2);
+		lua_rawget(l, -2);
+		if (lua_isfunction(l, -1)) {
+			// since its likely a regular attribute lookup and not a method
+			// call we have to do the call ourselves
+			lua_pushvalue(l, 1);
+			pi_lua_protected_call(l, 1, 1);
 		}
+
+		// the handler's result, the odd non-function attribute value, or nil
+		return 1;
 	}
 
 	lua_pushnil(l);
@@ -453,6 +632,7 @@ void LuaObjectBase::GetNames(std::vector<std::string> &names, const std::string
 
 	// properties
 	if (!methodsOnly) {
+		PropertyMap::Sync();
 		lua_getuservalue(l, -1);
 		if (!lua_isnil(l, -1))
 			get_names_from_table(l, names, prefix, false);
@@ -501,7 +681,30 @@ static int secure_trampoline(lua_State *l)
 	return fn(l);
 }
 
-static void register_functions(lua_State *l, const luaL_Reg *methods, bool protect, const char *prefix)
+// call counts for Dev.DumpLuaApiCalls, when enabled before the functions
+// are registered. a deque so the counters don't move, the wrappers point at them
+struct CallCount {
+	std::string name;
+	Uint64 calls;
+	Uint64 ticks;
+};
+static bool s_countCalls = false;
+static std::deque<CallCount> s_callCounts;
+
+static int counted_call(lua_State *l)
+{
+	CallCount *count = static_cast<CallCount*>(lua_touserdata(l, lua_upvalueindex(1)));
+	count->calls++;
+	const int nargs = lua_gettop(l);
+	lua_pushvalue(l, lua_upvalueindex(2));
+	lua_insert(l, 1);
+	const Uint64 start = SDL_GetPerformanceCounter();
+	lua_call(l, nargs, LUA_MULTRET);
+	count->ticks += SDL_GetPerformanceCounter() - start;
+	return lua_gettop(l);
+}
+
+static void register_functions(lua_State *l, const luaL_Reg *methods, bool protect, const char *prefix, const char *type)
 {
 	const size_t prefix_len = prefix ? strlen(prefix) : 0;
 	for (const luaL_Reg *m = methods; m->name; m++) {
@@ -517,11 +720,53 @@ static void register_functions(lua_State *l, const luaL_Reg *methods, bool prote
 		lua_pushcfunction(l, m->func);
 		if (protect)
 			lua_pushcclosure(l, secure_trampoline, 1);
+		if (s_countCalls) {
+			const CallCount count = { std::string(type) + "." + m->name, 0, 0 };
+			s_callCounts.push_back(count);
+			lua_pushlightuserdata(l, &s_callCounts.back());
+			lua_insert(l, -2);
+			lua_pushcclosure(l, counted_call, 2);
+		}
 		lua_rawset(l, -3);
 	}
 }
 
-void LuaObjectBase::CreateObject(const luaL_Reg *methods, const luaL_Reg *attrs, const luaL_Reg *meta, bool protect)
+void LuaObjectBase::EnableCallCounting(bool enabled)
+{
+	s_countCalls = enabled;
+}
+
+std::string LuaObjectBase::DumpCallCounts()
+{
+	if (!s_countCalls)
+		return "Lua API call counting is off, set LuaApiCallCounts=1 in the config to turn it on\n";
+
+	std::vector<const CallCount*> counts;
+	for (const CallCount &c : s_callCounts)
+		if (c.calls)
+			counts.push_back(&c);
+	std::sort(counts.begin(), counts.end(), [](const CallCount *a, const CallCount *b) { return a->ticks > b->ticks; });
+
+	const double freq = double(SDL_GetPerformanceFrequency());
+	std::string out;
+	char buf[256];
+	snprintf(buf, sizeof(buf), "%-48s %10s %10s %10s\n", "function", "calls", "total ms", "us/call");
+	out += buf;
+	for (const CallCount *c : counts) {
+		snprintf(buf, sizeof(buf), "%-48s %10llu %10.2f %10.2f\n", c->name.c_str(), (unsigned long long)c->calls,
+			double(c->ticks) * 1e3 / freq, double(c->ticks) * 1e6 / (freq * double(c->calls)));
+		out += buf;
+	}
+	return out;
+}
+
+void LuaObjectBase::ResetCallCounts()
+{
+	for (CallCount &c : s_callCounts)
+		c.calls = c.ticks = 0;
+}
+
+void LuaObjectBase::CreateObject(const char *name, const luaL_Reg *methods, const luaL_Reg *attrs, const luaL_Reg *meta, bool protect)
 {
 	lua_State *l = Lua::manager->GetLuaState();
 
@@ -531,14 +776,14 @@ void LuaObjectBase::CreateObject(const luaL_Reg *methods, const luaL_Reg *attrs,
 	lua_newtable(l);
 
 	// add methods
-	if (methods) register_functions(l, methods, protect, "");
+	if (methods) register_functions(l, methods, protect, "", name);
 
 	// add attributes
-	if (attrs) register_functions(l, attrs, protect, "__attribute_");
+	if (attrs) register_functions(l, attrs, protect, "__attribute_", name);
 
 	// create metatable for it
 	lua_newtable(l);
-	if (meta) register_functions(l, meta, protect, "");
+	if (meta) register_functions(l, meta, protect, "", name);
 
 	// index function
 	lua_pushstring(l, "__index");
@@ -581,6 +826,11 @@ void LuaObjectBase::CreateClass(const char *type, const char *parent, const luaL
 		lua_setmetatable(l, -2);
 
 		lua_setfield(l, LUA_REGISTRYINDEX, "LuaObjectRegistry");
+
+		// and the list of class metatables, so their lookup caches can be
+		// found and dropped when a method table changes
+		lua_newtable(l);
+		lua_setfield(l, LUA_REGISTRYINDEX, "LuaObjectClasses");
 	}
 	lua_pop(l, 1);
 
@@ -589,16 +839,10 @@ void LuaObjectBase::CreateClass(const char *type, const char *parent, const luaL
 
 	// create table, attach methods to it, leave it on the stack
 	lua_newtable(l);
-    if (methods) luaL_setfuncs(l, methods, 0);
+	if (methods) register_functions(l, methods, false, "", type);
 
 	// add attributes
-	if (attrs) {
-		for (const luaL_Reg *attr = attrs; attr->name; attr++) {
-			lua_pushstring(l, (std::string("__attribute_")+attr->name).c_str());
-			lua_pushcfunction(l, attr->func);
-			lua_rawset(l, -3);
-		}
-	}
+	if (attrs) register_functions(l, attrs, false, "__attribute_", type);
 
 	// add the exists method
 	lua_pushstring(l, "exists");
@@ -621,7 +865,26 @@ void LuaObjectBase::CreateClass(const char *type, const char *parent, const luaL
 	lua_pushcfunction(l, LuaObjectBase::l_hasprop);
 	lua_rawset(l, -3);
 
-	// publish the method table
+	// publish an empty proxy in front of the method table. __newindex only
+	// fires for missing keys, and through the proxy that's every store from
+	// Lua (eg. libs/Ship.lua), so the lookup caches can be rebuilt
+	lua_newtable(l);
+	lua_newtable(l);
+	lua_pushstring(l, "__index");
+	lua_pushvalue(l, -4);
+	lua_rawset(l, -3);
+	lua_pushstring(l, "__newindex");
+	lua_pushvalue(l, -4);
+	lua_pushcclosure(l, l_method_table_newindex, 1);
+	lua_rawset(l, -3);
+	lua_pushstring(l, "__pairs");
+	lua_pushvalue(l, -4);
+	lua_pushcclosure(l, l_method_table_pairs, 1);
+	lua_rawset(l, -3);
+	lua_setmetatable(l, -2);
+	lua_remove(l, -2);
+
+	// publish it
 	lua_rawset(l, -3);
 
 	// remove the "global" table
@@ -637,7 +900,7 @@ void LuaObjectBase::CreateClass(const char *type, const char *parent, const luaL
 	lua_rawset(l, -3);
 
 	// attach supplied metamethods
-	if (meta) luaL_setfuncs(l, meta, 0);
+	if (meta) register_functions(l, meta, false, "", type);
 
 	// add a generic garbage collector
 	lua_pushstring(l, "__gc");
@@ -664,6 +927,13 @@ void LuaObjectBase::CreateClass(const char *type, const char *parent, const luaL
 		lua_rawset(l, -3);
 	}
 
+	// remember it for cache invalidation
+	lua_getfield(l, LUA_REGISTRYINDEX, "LuaObjectClasses");
+	lua_pushvalue(l, -2);
+	lua_pushboolean(l, true);
+	lua_rawset(l, -3);
+	lua_pop(l, 1);
+
 	// pop the metatable
 	lua_pop(l, 1);
 
@@ -97,8 +97,16 @@ class LuaObjectBase {
 public:
 	// creates a single "typeless" object and attaches the listed methods,
 	// attributes and metamethods to it. leaves the created object on the
-	// stack
-	static void CreateObject(const luaL_Reg *methods, const luaL_Reg *attrs, const luaL_Reg *meta, bool protect = false);
+	// stack. the name is only for the call counts
+	static void CreateObject(const char *name, const luaL_Reg *methods, const luaL_Reg *attrs, const luaL_Reg *meta, bool protect = false);
+
+	// count the calls to and time spent in every function registered by
+	// CreateObject and CreateClass after this, for finding the ones scripts
+	// lean on. each call goes through a wrapper, so it's off by default
+	static void EnableCallCounting(bool enabled);
+	// functions called since the last reset, most time first
+	static std::string DumpCallCounts();
+	static void ResetCallCounts();
 
 	// get all valid method/attribute names for the object on the top of the
 	// stack. mainly intended for the console. uses the same logic as the
@@ -255,12 +263,7 @@ template <typename T>
 class LuaCoreObject : public LuaObject<T> {
 public:
 	LuaCoreObject(T *o) : m_object(o) {
-		m_deleteConnection = m_object->DeleteEmitter::onDelete.connect(sigc::mem_fun(this, &LuaCoreObject::OnDelete));
-	}
-
-	~LuaCoreObject() {
-		if (m_deleteConnection.connected())
-			m_deleteConnection.disconnect();
+		m_deleteSlot.Connect(m_object->DeleteEmitter::onDelete, [this]() { OnDelete(); });
 	}
 
 	LuaWrappable *GetObject() const {
@@ -274,7 +277,8 @@ private:
 	}
 
 	T *m_object;
-	sigc::connection m_deleteConnection;
+	// disconnects itself when we go
+	Signal<>::Slot m_deleteSlot;
 };
 
 
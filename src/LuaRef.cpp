@@ -4,6 +4,7 @@
 #include "LuaRef.h"
 #include "Lua.h"
 #include "Pi.h"
+#include "json/JsonUtils.h"
 #include <cassert>
 
 LuaRef::LuaRef(const LuaRef & ref): m_lua(ref.m_lua), m_id(ref.m_id), m_copycount(ref.m_copycount) {
@@ -59,16 +60,23 @@ void LuaRef::CheckCopyCount() {
 
 LuaRef::LuaRef(lua_State * l, int index): m_lua(l), m_id(0) {
 	assert(m_lua && index);
+
+	// hold the main thread rather than l, which may be a coroutine that is
+	// collected long before the ref goes away
+	lua_rawgeti(l, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+	m_lua = lua_tothread(l, -1);
+	lua_pop(l, 1);
+
 	if (index == LUA_NOREF) {
 		m_copycount = new int(0);
 		return;
 	}
 
-	index = lua_absindex(m_lua, index);
+	index = lua_absindex(l, index);
 
-	PushGlobalToStack();
-	lua_pushvalue(m_lua, index);
-	m_id = luaL_ref(m_lua, -2);
+	luaL_getsubtable(l, LUA_REGISTRYINDEX, "LuaRef");
+	lua_pushvalue(l, index);
+	m_id = luaL_ref(l, -2);
 	lua_pop(l, 1); // Pop global.
 
 	m_copycount = new int(1);
@@ -101,7 +109,7 @@ void LuaRef::SaveToJson(Json::Value &jsonObj)
 	PushCopyToStack();
 	serializer->pickle(m_lua, -1, out);
 	lua_pop(m_lua, 1);
-	jsonObj["lua_ref"] = out;
+	BinStrToJsonHex(jsonObj, out, "lua_ref");
 
 	LUA_DEBUG_END(m_lua, 0);
 }
@@ -110,7 +118,7 @@ void LuaRef::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("lua_ref")) throw SavedGameCorruptException();
 
-	std::string pickled = jsonObj["lua_ref"].asString();
+	const std::string pickled = JsonHexToBinStr(jsonObj, "lua_ref");
 
 	LUA_DEBUG_START(m_lua);
 
@@ -123,7 +131,7 @@ void LuaRef::LoadFromJson(const Json::Value &jsonObj)
 		return;
 	}
 
-	serializer->unpickle(m_lua, pickled.c_str()); // loaded
+	serializer->unpickle(m_lua, pickled.data(), pickled.data() + pickled.size()); // loaded
 	lua_getfield(m_lua, LUA_REGISTRYINDEX, "PiLuaRefLoadTable"); // loaded, reftable
 	lua_pushvalue(m_lua, -2); // loaded, reftable, copy
 	lua_gettable(m_lua, -2);  // loaded, reftable, luaref
@@ -41,8 +41,10 @@ private:
 };
 
 inline void pi_lua_generic_push(lua_State *l, const LuaRef &r) {
-	assert(r.GetLua() == l);
 	r.PushCopyToStack();
+	// refs live on the main thread, l may be a coroutine
+	if (l != r.GetLua())
+		lua_xmove(r.GetLua(), l, 1);
 }
 
 inline void pi_lua_generic_pull(lua_State *l, int index, LuaRef &r) {
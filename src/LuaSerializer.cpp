@@ -28,20 +28,27 @@
 // down into tables. it can do userdata assuming the appropriate Lua wrapper
 // class has registered a serializer and deseriaizer
 //
-// pickle format is newline-seperated. each line begins with a type value,
-// followed by data for that type as follows
-//   fNNN.nnn - number (float)
-//   bN       - boolean. N is 0 or 1 for true/false
-//   sNNN     - string. number is length, followed by newline, then string of bytes
-//   t        - table. followed by a float (fNNN.nnn) uniquely identifying the
-//            - table, then more pickled stuff (ie recursive)
-//   n        - end of table
-//   r        - reference to previously-seen table. followed by the table id
-//   uXXXX    - userdata. XXXX is type, followed by newline, followed by data
-//                everything after u is passed down to LuaObject::Serialize to
-//                generate using per-class serializers
-//   oXXXX    - object. XXX is type, followed by newline, followed by one
-//              pickled item (typically t[able])
+// pickle format is binary. each value begins with a type byte, followed by
+// data for that type as follows. counts and ids are varints (7 bits per
+// byte, high bit set on all but the last)
+//   f  - number (float). followed by the 8 byte double
+//   i  - number (integer). followed by a zigzag encoded varint
+//   T  - boolean true
+//   F  - boolean false
+//   s  - string. followed by the length, then string of bytes. the string
+//        is also added to the end of the string table for this pickle
+//   S  - string seen earlier in this pickle. followed by its string table index
+//   t  - table. followed by an id uniquely identifying the table, then
+//        pickled key, value pairs (ie recursive)
+//   n  - end of table
+//   r  - reference to previously-seen table. followed by the table id
+//   u  - userdata. followed by a pickled string, which is passed to
+//        LuaObject::Deserialize. it is generated using per-class serializers
+//   o  - object. followed by the class name as a pickled string, then one
+//        pickled item (typically t[able])
+//
+// table ids are shared across every pickle made between InitTableRefs and
+// UninitTableRefs, so a LuaRef can refer to a table in the module data
 
 
 // on serialize, if an item has a metatable with a "class" attribute, the
@@ -52,9 +59,100 @@
 // "Deserialize" function under that namespace. that data returned will be
 // given back to the module
 
+enum PickleType {
+	PICKLE_FLOAT     = 'f',
+	PICKLE_INTEGER   = 'i',
+	PICKLE_TRUE      = 'T',
+	PICKLE_FALSE     = 'F',
+	PICKLE_STRING    = 's',
+	PICKLE_STRINGREF = 'S',
+	PICKLE_TABLE     = 't',
+	PICKLE_TABLEEND  = 'n',
+	PICKLE_TABLEREF  = 'r',
+	PICKLE_USERDATA  = 'u',
+	PICKLE_OBJECT    = 'o'
+};
+
+// last table id handed out since InitTableRefs
+static Uint32 s_tableRefCount;
+
+struct LuaSerializer::PickleState {
+	PickleState(std::string &o, int s) : out(o), strings(s), numStrings(0) {}
+	std::string &out;
+	int strings; // stack index of string -> index table
+	Uint32 numStrings;
+};
+
+struct LuaSerializer::UnpickleState {
+	UnpickleState(const char *p, const char *e, int s) : pos(p), end(e), strings(s), numStrings(0) {}
+	const char *pos;
+	const char *end;
+	int strings; // stack index of index -> string table
+	Uint32 numStrings;
+};
+
+static void write_varint(std::string &out, Uint64 v)
+{
+	while (v >= 0x80) {
+		out += char((v & 0x7f) | 0x80);
+		v >>= 7;
+	}
+	out += char(v);
+}
+
+static Uint64 read_varint(const char *&pos, const char *end)
+{
+	Uint64 v = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (pos >= end) throw SavedGameCorruptException();
+		const Uint8 b = Uint8(*pos++);
+		v |= Uint64(b & 0x7f) << shift;
+		if (!(b & 0x80))
+			return v;
+	}
+	throw SavedGameCorruptException();
+}
+
+void LuaSerializer::pickle_string(lua_State *l, int idx, PickleState &ps)
+{
+	lua_pushvalue(l, idx);
+	lua_rawget(l, ps.strings);
+	if (!lua_isnil(l, -1)) {
+		ps.out += char(PICKLE_STRINGREF);
+		write_varint(ps.out, Uint64(lua_tointeger(l, -1)));
+		lua_pop(l, 1);
+		return;
+	}
+	lua_pop(l, 1);
+
+	size_t len;
+	const char *str = lua_tolstring(l, idx, &len);
+	ps.out += char(PICKLE_STRING);
+	write_varint(ps.out, len);
+	ps.out.append(str, len);
+
+	lua_pushvalue(l, idx);
+	lua_pushinteger(l, ps.numStrings++);
+	lua_rawset(l, ps.strings);
+}
+
 void LuaSerializer::pickle(lua_State *l, int to_serialize, std::string &out, const char *key)
 {
-	static char buf[256];
+	LUA_DEBUG_START(l);
+
+	to_serialize = lua_absindex(l, to_serialize);
+
+	lua_newtable(l);
+	PickleState ps(out, lua_gettop(l));
+	pickle_value(l, to_serialize, ps, key);
+	lua_pop(l, 1);
+
+	LUA_DEBUG_END(l, 0);
+}
+
+void LuaSerializer::pickle_value(lua_State *l, int to_serialize, PickleState &ps, const char *key)
+{
+	std::string &out = ps.out;
 
 	LUA_DEBUG_START(l);
 
@@ -74,7 +172,7 @@ void LuaSerializer::pickle(lua_State *l, int to_serialize, std::string &out, con
 
 		else {
 			const char *cl = lua_tostring(l, -1);
-			snprintf(buf, sizeof(buf), "o%s\n", cl);
+			const int clidx = lua_gettop(l);
 
 			lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerClasses");
 
@@ -97,7 +195,8 @@ void LuaSerializer::pickle(lua_State *l, int to_serialize, std::string &out, con
 				return;
 			}
 
-			out += buf;
+			out += char(PICKLE_OBJECT);
+			pickle_string(l, clidx, ps);
 		}
 	}
 
@@ -106,80 +205,84 @@ void LuaSerializer::pickle(lua_State *l, int to_serialize, std::string &out, con
 			break;
 
 		case LUA_TNUMBER: {
-			snprintf(buf, sizeof(buf), "f%f\n", lua_tonumber(l, idx));
-			out += buf;
+			const double n = lua_tonumber(l, idx);
+			// most numbers in module data are counts, ids and the like.
+			// anything integral that a double holds exactly goes as a varint
+			static const double MAX_EXACT = 9007199254740992.0; // 2^53
+			const Sint64 i = (n > -MAX_EXACT && n < MAX_EXACT) ? Sint64(n) : 0;
+			if (n > -MAX_EXACT && n < MAX_EXACT && !(double(i) < n) && !(double(i) > n)) {
+				out += char(PICKLE_INTEGER);
+				write_varint(out, (Uint64(i) << 1) ^ Uint64(i >> 63));
+			} else {
+				char buf[sizeof(double)];
+				memcpy(buf, &n, sizeof(double));
+				out += char(PICKLE_FLOAT);
+				out.append(buf, sizeof(double));
+			}
 			break;
 		}
 
 		case LUA_TBOOLEAN: {
-			snprintf(buf, sizeof(buf), "b%d", lua_toboolean(l, idx) ? 1 : 0);
-			out += buf;
+			out += char(lua_toboolean(l, idx) ? PICKLE_TRUE : PICKLE_FALSE);
 			break;
 		}
 
 		case LUA_TSTRING: {
-			lua_pushvalue(l, idx);
-			size_t len;
-			const char *str = lua_tolstring(l, -1, &len);
-			snprintf(buf, sizeof(buf), "s" SIZET_FMT "\n", len);
-			out += buf;
-			out.append(str, len);
-			lua_pop(l, 1);
+			pickle_string(l, idx, ps);
 			break;
 		}
 
 		case LUA_TTABLE: {
-			lua_pushinteger(l, lua_Integer(lua_topointer(l, to_serialize)));         // ptr
-
-			lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs");    // ptr reftable
-			lua_pushvalue(l, -2);                                           // ptr reftable ptr
-			lua_rawget(l, -2);                                              // ptr reftable ???
+			lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs");    // reftable
+			lua_pushvalue(l, to_serialize);                                 // reftable table
+			lua_rawget(l, -2);                                              // reftable ???
 
 			if (!lua_isnil(l, -1)) {
-				out += "r";
-				pickle(l, -3, out, key);
-				lua_pop(l, 3);                                              // [empty]
+				out += char(PICKLE_TABLEREF);
+				write_varint(out, Uint64(lua_tointeger(l, -1)));
+				lua_pop(l, 2);                                              // [empty]
 			}
 
 			else {
-				out += "t";
+				const Uint32 id = ++s_tableRefCount;
+				out += char(PICKLE_TABLE);
+				write_varint(out, id);
 
-				lua_pushvalue(l, -3);                                       // ptr reftable nil ptr
-				lua_pushvalue(l, to_serialize);                                      // ptr reftable nil ptr table
-				lua_rawset(l, -4);                                          // ptr reftable nil
-				pickle(l, -3, out, key);
-				lua_pop(l, 3);                                              // [empty]
+				lua_pop(l, 1);                                              // reftable
+				lua_pushvalue(l, to_serialize);                             // reftable table
+				lua_pushinteger(l, id);                                     // reftable table id
+				lua_rawset(l, -3);                                          // reftable
+				lua_pop(l, 1);                                              // [empty]
 
 				lua_pushvalue(l, idx);
 				lua_pushnil(l);
 				while (lua_next(l, -2)) {
-					const char *k = key;
-					if (!k) {
-						lua_pushvalue(l, -2);
-						k = lua_tostring(l, -1);
-						lua_pop(l, 1);
-					}
 					// Copy the values to pickle, as they might be mutated by the pickling process.
-					pickle(l, -2, out, key);
-					pickle(l, -1, out, key);
+					pickle_value(l, -2, ps, key);
+					pickle_value(l, -1, ps, key);
 					lua_pop(l, 1);
 				}
 				lua_pop(l, 1);
-				out += "n";
+				out += char(PICKLE_TABLEEND);
 			}
 
 			break;
 		}
 
 		case LUA_TUSERDATA: {
-			out += "u";
+			out += char(PICKLE_USERDATA);
 
 			LuaObjectBase *lo = static_cast<LuaObjectBase*>(lua_touserdata(l, idx));
 			void *o = lo->GetObject();
 			if (!o)
 				Error("Lua serializer '%s' tried to serialize an invalid '%s' object", key, lo->GetType());
 
-			out += lo->Serialize();
+			// the same body tends to turn up many times, so this goes
+			// through the string table too
+			const std::string data(lo->Serialize());
+			lua_pushlstring(l, data.c_str(), data.size());
+			pickle_string(l, -1, ps);
+			lua_pop(l, 1);
 			break;
 		}
 
@@ -194,7 +297,21 @@ void LuaSerializer::pickle(lua_State *l, int to_serialize, std::string &out, con
 	LUA_DEBUG_END(l, 0);
 }
 
-const char *LuaSerializer::unpickle(lua_State *l, const char *pos)
+const char *LuaSerializer::unpickle(lua_State *l, const char *pos, const char *end)
+{
+	LUA_DEBUG_START(l);
+
+	lua_newtable(l);
+	UnpickleState us(pos, end, lua_gettop(l));
+	unpickle_value(l, us);
+	lua_remove(l, -2);
+
+	LUA_DEBUG_END(l, 1);
+
+	return us.pos;
+}
+
+void LuaSerializer::unpickle_value(lua_State *l, UnpickleState &us)
 {
 	LUA_DEBUG_START(l);
 
@@ -204,111 +321,130 @@ const char *LuaSerializer::unpickle(lua_State *l, const char *pos)
 	if (!lua_checkstack(l, 20))
 		luaL_error(l, "The Lua stack couldn't be extended (not enough memory?)");
 
-	char type = *pos++;
+	if (us.pos >= us.end) throw SavedGameCorruptException();
+	const char type = *us.pos++;
 
 	switch (type) {
 
-		case 'f': {
-			char *end;
-			double f = strtod(pos, &end);
-			if (pos == end) throw SavedGameCorruptException();
+		case PICKLE_FLOAT: {
+			if (us.end - us.pos < int(sizeof(double))) throw SavedGameCorruptException();
+			double f;
+			memcpy(&f, us.pos, sizeof(double));
 			lua_pushnumber(l, f);
-			pos = end+1; // skip newline
+			us.pos += sizeof(double);
+			break;
+		}
+
+		case PICKLE_INTEGER: {
+			const Uint64 z = read_varint(us.pos, us.end);
+			const Sint64 i = Sint64(z >> 1) ^ -Sint64(z & 1);
+			lua_pushnumber(l, double(i));
 			break;
 		}
 
-		case 'b': {
-			if (*pos != '0' && *pos != '1') throw SavedGameCorruptException();
-			bool b = (*pos == '0') ? false : true;
-			lua_pushboolean(l, b);
-			pos++;
+		case PICKLE_TRUE:
+		case PICKLE_FALSE: {
+			lua_pushboolean(l, type == PICKLE_TRUE);
 			break;
 		}
 
-		case 's': {
-			char *end;
-			int len = strtol(pos, const_cast<char**>(&end), 0);
-			if (pos == end) throw SavedGameCorruptException();
-			end++; // skip newline
-			lua_pushlstring(l, end, len);
-			pos = end + len;
+		case PICKLE_STRING: {
+			const Uint64 len = read_varint(us.pos, us.end);
+			if (Uint64(us.end - us.pos) < len) throw SavedGameCorruptException();
+			lua_pushlstring(l, us.pos, len);
+			us.pos += len;
+
+			lua_pushvalue(l, -1);
+			lua_rawseti(l, us.strings, ++us.numStrings);
 			break;
 		}
 
-		case 't': {
+		case PICKLE_STRINGREF: {
+			const Uint64 index = read_varint(us.pos, us.end);
+			if (index >= us.numStrings) throw SavedGameCorruptException();
+			lua_rawgeti(l, us.strings, int(index) + 1);
+			break;
+		}
+
+		case PICKLE_TABLE: {
+			const Uint64 id = read_varint(us.pos, us.end);
+
 			lua_newtable(l);
 
 			lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs");
-			pos = unpickle(l, pos);
+			lua_pushnumber(l, double(id));
 			lua_pushvalue(l, -3);
 			lua_rawset(l, -3);
 			lua_pop(l, 1);
 
-			while (*pos != 'n') {
-				pos = unpickle(l, pos);
-				pos = unpickle(l, pos);
+			while (true) {
+				if (us.pos >= us.end) throw SavedGameCorruptException();
+				if (*us.pos == PICKLE_TABLEEND) break;
+				unpickle_value(l, us);
+				unpickle_value(l, us);
 				lua_rawset(l, -3);
 			}
-			pos++;
+			us.pos++;
 
 			break;
 		}
 
-		case 'r': {
-			pos = unpickle(l, pos);
+		case PICKLE_TABLEREF: {
+			const Uint64 id = read_varint(us.pos, us.end);
 
 			lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs");
-			lua_pushvalue(l, -2);
+			lua_pushnumber(l, double(id));
 			lua_rawget(l, -2);
 
 			if (lua_isnil(l, -1))
 				throw SavedGameCorruptException();
 
-			lua_insert(l, -3);
-			lua_pop(l, 2);
+			lua_remove(l, -2);
 
 			break;
 		}
 
-		case 'u': {
-			const char *end;
-			if (!LuaObjectBase::Deserialize(pos, &end))
+		case PICKLE_USERDATA: {
+			unpickle_value(l, us);
+			if (lua_type(l, -1) != LUA_TSTRING) throw SavedGameCorruptException();
+
+			const char *next;
+			if (!LuaObjectBase::Deserialize(lua_tostring(l, -1), &next))
 				throw SavedGameCorruptException();
-			pos = end;
+			lua_remove(l, -2);
 			break;
 		}
 
-		case 'o': {
-			const char *end = strchr(pos, '\n');
-			if (!end) throw SavedGameCorruptException();
-			int len = end - pos;
-			end++; // skip newline
-
-			const char *cl = pos;
-
-			// unpickle the object, and insert it beneath the method table value
-			pos = unpickle(l, end);
+		case PICKLE_OBJECT: {
+			unpickle_value(l, us);
+			if (lua_type(l, -1) != LUA_TSTRING) throw SavedGameCorruptException();
+			const int clidx = lua_gettop(l);
 
 			// If it is a reference, don't run the unserializer. It has either
 			// already been run, or the data is still building (cyclic
 			// references will do that to you.)
-			if (*end != 'r') {
+			const bool ref = us.pos < us.end && *us.pos == PICKLE_TABLEREF;
+
+			// unpickle the object, and insert it beneath the method table value
+			unpickle_value(l, us);
+
+			if (!ref) {
 				// get PiSerializerClasses[typename]
 				lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerClasses");
-				lua_pushlstring(l, cl, len);
+				lua_pushvalue(l, clidx);
 				lua_gettable(l, -2);
 				lua_remove(l, -2);
 
 				if (lua_isnil(l, -1)) {
-					lua_pop(l, 2);
+					// no such class any more, so pass the data through as is
+					lua_pop(l, 1);
+					lua_remove(l, clidx);
 					break;
 				}
 
 				lua_getfield(l, -1, "Unserialize");
-				if (lua_isnil(l, -1)) {
-					lua_pushlstring(l, cl, len);
-					luaL_error(l, "No Unserialize method found for class '%s'\n", lua_tostring(l, -1));
-				}
+				if (lua_isnil(l, -1))
+					luaL_error(l, "No Unserialize method found for class '%s'\n", lua_tostring(l, clidx));
 
 				lua_insert(l, -3);
 				lua_pop(l, 1);
@@ -316,6 +452,8 @@ const char *LuaSerializer::unpickle(lua_State *l, const char *pos)
 				pi_lua_protected_call(l, 1, 1);
 			}
 
+			lua_remove(l, clidx);
+
 			break;
 		}
 
@@ -324,8 +462,6 @@ const char *LuaSerializer::unpickle(lua_State *l, const char *pos)
 	}
 
 	LUA_DEBUG_END(l, 1);
-
-	return pos;
 }
 
 void LuaSerializer::InitTableRefs() {
@@ -336,6 +472,7 @@ void LuaSerializer::InitTableRefs() {
 
 	lua_newtable(l);
 	lua_setfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs");
+	s_tableRefCount = 0;
 
 	lua_newtable(l);
 	lua_setfield(l, LUA_REGISTRYINDEX, "PiLuaRefLoadTable");
@@ -385,9 +522,10 @@ void LuaSerializer::ToJson(Json::Value &jsonObj)
 	lua_pop(l, 1);
 
 	std::string pickled;
+	pickled.reserve(64 * 1024);
 	pickle(l, savetable, pickled);
 
-	BinStrToJson(jsonObj, pickled, "lua_modules");
+	BinStrToJsonHex(jsonObj, pickled, "lua_modules");
 
 	lua_pop(l, 1);
 
@@ -402,10 +540,9 @@ void LuaSerializer::FromJson(const Json::Value &jsonObj)
 
 	LUA_DEBUG_START(l);
 
-	std::string pickled = JsonToBinStr(jsonObj, "lua_modules");
-	const char *start = pickled.c_str();
-	const char *end = unpickle(l, start);
-	if (size_t(end - start) != pickled.length()) throw SavedGameCorruptException();
+	const std::string pickled = JsonHexToBinStr(jsonObj, "lua_modules");
+	const char *end = pickled.data() + pickled.size();
+	if (unpickle(l, pickled.data(), end) != end) throw SavedGameCorruptException();
 	if (!lua_istable(l, -1)) throw SavedGameCorruptException();
 	int savetable = lua_gettop(l);
 
@@ -521,7 +658,7 @@ template <> void LuaObject<LuaSerializer>::RegisterClass()
 	};
 
 	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
-	LuaObjectBase::CreateObject(l_methods, 0, 0);
+	LuaObjectBase::CreateObject("Serializer", l_methods, 0, 0);
 	lua_setfield(l, -2, "Serializer");
 	lua_pop(l, 1);
 
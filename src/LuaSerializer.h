@@ -29,8 +29,16 @@ private:
 	static int l_register(lua_State *l);
 	static int l_register_class(lua_State *l);
 
+	struct PickleState;
+	struct UnpickleState;
+
+	// out is appended to. unpickle returns the end of what it read
 	static void pickle(lua_State *l, int idx, std::string &out, const char *key = 0);
-	static const char *unpickle(lua_State *l, const char *pos);
+	static const char *unpickle(lua_State *l, const char *pos, const char *end);
+
+	static void pickle_value(lua_State *l, int idx, PickleState &ps, const char *key);
+	static void pickle_string(lua_State *l, int idx, PickleState &ps);
+	static void unpickle_value(lua_State *l, UnpickleState &us);
 };
 
 #endif
@@ -211,6 +211,6 @@ void LuaServerAgent::Register()
 		{ 0, 0 }
 	};
 
-	LuaObjectBase::CreateObject(l_methods, 0, 0);
+	LuaObjectBase::CreateObject("ServerAgent", l_methods, 0, 0);
 	lua_setglobal(Lua::manager->GetLuaState(), "ServerAgent");
 }
@@ -5,6 +5,8 @@
 #include "LuaSpace.h"
 #include "LuaManager.h"
 #include "LuaUtils.h"
+#include "LuaConstants.h"
+#include "LuaArrayView.h"
 #include "Space.h"
 #include "Ship.h"
 #include "HyperspaceCloud.h"
@@ -295,6 +297,73 @@ static int l_space_spawn_ship_docked(lua_State *l)
 	return 1;
 }
 
+/*
+ * Function: SpawnShipsDocked
+ *
+ * Create a number of ships of one type and place them inside the given
+ * <SpaceStation>, for filling a station with traffic in one go.
+ *
+ * > ships = Space.SpawnShipsDocked(type, station, count)
+ *
+ * Parameters:
+ *
+ *   type - the name of the ship
+ *
+ *   station - the <SpaceStation> to place the ships inside
+ *
+ *   count - how many ships to create
+ *
+ * Return:
+ *
+ *   ships - an array of the new <Ship> objects. It has fewer than count
+ *           ships if the station ran out of space for them
+ *
+ * Availability:
+ *
+ *   October 2015
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_space_spawn_ships_docked(lua_State *l)
+{
+	if (!Pi::game)
+		luaL_error(l, "Game is not started");
+
+	LUA_DEBUG_START(l);
+
+	const char *type = luaL_checkstring(l, 1);
+	if (! ShipType::Get(type))
+		luaL_error(l, "Unknown ship type '%s'", type);
+
+	SpaceStation *station = LuaObject<SpaceStation>::CheckFromLua(2);
+	const int count = luaL_checkinteger(l, 3);
+
+	lua_createtable(l, std::max(count, 0), 0);
+	for (int i = 1; i <= count; i++) {
+		Ship *ship = new Ship(type);
+
+		int port = station->GetFreeDockingPort(ship);
+		if (port < 0) {
+			// they're all the same size, so none of the rest would fit either
+			delete ship;
+			break;
+		}
+
+		ship->SetFrame(station->GetFrame());
+		Pi::game->GetSpace()->AddBody(ship);
+		ship->SetDockedWith(station, port);
+
+		LuaObject<Ship>::PushToLua(ship);
+		lua_rawseti(l, -2, i);
+	}
+
+	LUA_DEBUG_END(l, 1);
+
+	return 1;
+}
+
 /*
  * Function: SpawnShipParked
  *
@@ -614,26 +683,16 @@ static int l_space_get_body(lua_State *l)
  *
  *   stable
  */
-static int l_space_get_bodies(lua_State *l)
+// push a table of the bodies that pass the filter function at filterIdx (or
+// all of them, if filterIdx is 0)
+template <typename Bodies>
+static void push_filtered_bodies(lua_State *l, int filterIdx, const Bodies &bodies)
 {
-	if (!Pi::game) {
-		luaL_error(l, "Game is not started");
-		return 0;
-	}
-
-	LUA_DEBUG_START(l);
-
-	bool filter = false;
-	if (lua_gettop(l) >= 1) {
-		luaL_checktype(l, 1, LUA_TFUNCTION); // any type of function
-		filter = true;
-	}
-
 	lua_newtable(l);
 
-	for (Body* b : Pi::game->GetSpace()->GetBodies()) {
-		if (filter) {
-			lua_pushvalue(l, 1);
+	for (Body* b : bodies) {
+		if (filterIdx) {
+			lua_pushvalue(l, filterIdx);
 			LuaObject<Body>::PushToLua(b);
 			if (int ret = lua_pcall(l, 1, 1, 0)) {
 				const char *errmsg( "Unknown error" );
@@ -655,7 +714,155 @@ static int l_space_get_bodies(lua_State *l)
 		lua_pushinteger(l, lua_rawlen(l, -1)+1);
 		LuaObject<Body>::PushToLua(b);
 		lua_rawset(l, -3);
-    }
+	}
+}
+
+static int l_space_get_bodies(lua_State *l)
+{
+	if (!Pi::game) {
+		luaL_error(l, "Game is not started");
+		return 0;
+	}
+
+	LUA_DEBUG_START(l);
+
+	int filterIdx = 0;
+	if (lua_gettop(l) >= 1) {
+		luaL_checktype(l, 1, LUA_TFUNCTION); // any type of function
+		filterIdx = 1;
+	}
+
+	push_filtered_bodies(l, filterIdx, Pi::game->GetSpace()->GetBodies());
+
+	LUA_DEBUG_END(l, 1);
+
+	return 1;
+}
+
+/*
+ * Function: GetBodyView
+ *
+ * Get a read-only array view of the <Body> objects in space, optionally of
+ * a single type. The type test is done natively and no Lua objects are made
+ * until a body is read from the view, so this is much cheaper than
+ * <GetBodies> when only a few of the results are wanted.
+ *
+ * > view = Space.GetBodyView(type)
+ *
+ * Parameters:
+ *
+ *   type - optional. Only bodies of this <Constants.PhysicsObjectType> (or a
+ *          subtype of it) are included
+ *
+ * Return:
+ *
+ *   view - supports view[i], #view and ipairs(view). The view becomes
+ *          invalid once any body is removed from space, so it must not be
+ *          kept across frames
+ *
+ * Example:
+ *
+ * > for i, ship in ipairs(Space.GetBodyView("SHIP")) do
+ * >     print(ship.label)
+ * > end
+ *
+ * Availability:
+ *
+ *   October 2015
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_space_get_body_view(lua_State *l)
+{
+	PROFILE_SCOPED()
+	if (!Pi::game) {
+		luaL_error(l, "Game is not started");
+		return 0;
+	}
+
+	LUA_DEBUG_START(l);
+
+	const bool filter = !lua_isnoneornil(l, 1);
+	const Object::Type type = filter ?
+		static_cast<Object::Type>(LuaConstants::GetConstantFromArg(l, "PhysicsObjectType", 1)) : Object::OBJECT;
+
+	Space *space = Pi::game->GetSpace();
+	std::vector<Body*> bodies;
+	bodies.reserve(space->GetNumBodies());
+	for (Body *b : space->GetBodies())
+		if (!filter || b->IsType(type))
+			bodies.push_back(b);
+
+	LuaArrayView::PushBodies(l, bodies);
+
+	LUA_DEBUG_END(l, 1);
+
+	return 1;
+}
+
+/*
+ * Function: GetBodiesNear
+ *
+ * Get the <Body> objects within some distance of a body that match the
+ * specified filter. This is much cheaper than filtering <GetBodies> by
+ * distance, as only bodies that are close by are looked at.
+ *
+ * bodies = Space.GetBodiesNear(body, distance, filter)
+ *
+ * Parameters:
+ *
+ *   body - the <Body> to search around. It is included in the results if it
+ *          passes the filter
+ *
+ *   distance - the search radius, in metres. Negative distances find
+ *              nothing, and huge ones are clamped to something bigger
+ *              than any system
+ *
+ *   filter - an optional function, as for <GetBodies>
+ *
+ * Return:
+ *
+ *   bodies - an array containing zero or more <Body> objects that are near
+ *            and matched the filter
+ *
+ * Example:
+ *
+ * > -- get all the ships within 50km of the player
+ * > local ships = Space.GetBodiesNear(Game.player, 50000, function (body)
+ * >     return body:isa("Ship")
+ * > end)
+ *
+ * Availability:
+ *
+ *   October 2015
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_space_get_bodies_near(lua_State *l)
+{
+	if (!Pi::game) {
+		luaL_error(l, "Game is not started");
+		return 0;
+	}
+
+	LUA_DEBUG_START(l);
+
+	Body *b = LuaObject<Body>::CheckFromLua(1);
+	const double dist = luaL_checknumber(l, 2);
+
+	int filterIdx = 0;
+	if (lua_gettop(l) >= 3) {
+		luaL_checktype(l, 3, LUA_TFUNCTION); // any type of function
+		filterIdx = 3;
+	}
+
+	Space::BodyNearList nearby;
+	Pi::game->GetSpace()->GetBodiesMaybeNear(b, dist, nearby);
+	push_filtered_bodies(l, filterIdx, nearby);
 
 	LUA_DEBUG_END(l, 1);
 
@@ -672,17 +879,20 @@ void LuaSpace::Register()
 		{ "SpawnShip",       l_space_spawn_ship        },
 		{ "SpawnShipNear",   l_space_spawn_ship_near   },
 		{ "SpawnShipDocked", l_space_spawn_ship_docked },
+		{ "SpawnShipsDocked", l_space_spawn_ships_docked },
 		{ "SpawnShipParked", l_space_spawn_ship_parked },
 		{ "SpawnShipLanded", l_space_spawn_ship_landed },
 		{ "SpawnShipLandedNear", l_space_spawn_ship_landed_near },
 
 		{ "GetBody",   l_space_get_body   },
 		{ "GetBodies", l_space_get_bodies },
+		{ "GetBodiesNear", l_space_get_bodies_near },
+		{ "GetBodyView",   l_space_get_body_view   },
 		{ 0, 0 }
 	};
 
 	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
-	LuaObjectBase::CreateObject(l_methods, 0, 0);
+	LuaObjectBase::CreateObject("Space", l_methods, 0, 0);
 	lua_setfield(l, -2, "Space");
 	lua_pop(l, 1);
 
@@ -20,6 +20,7 @@
 #include "galaxy/GalaxyCache.h"
 #include "Factions.h"
 #include "FileSystem.h"
+#include "LuaArrayView.h"
 
 /*
  * Class: StarSystem
@@ -77,6 +78,44 @@ static int l_starsystem_get_station_paths(lua_State *l)
 	return 1;
 }
 
+/*
+ * Method: GetStationPathView
+ *
+ * As <GetStationPaths>, but returns a read-only array view rather than a
+ * table. Paths are only pushed to Lua as they are read.
+ *
+ * > paths = system:GetStationPathView()
+ *
+ * Return:
+ *
+ *   paths - supports paths[i], #paths and ipairs(paths)
+ *
+ * Availability:
+ *
+ *   October 2015
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_starsystem_get_station_path_view(lua_State *l)
+{
+	PROFILE_SCOPED()
+	LUA_DEBUG_START(l);
+
+	StarSystem *s = LuaObject<StarSystem>::CheckFromLua(1);
+
+	std::vector<SystemPath> paths;
+	for (const SystemBody *station : s->GetSpaceStations())
+		paths.push_back(station->GetPath());
+
+	LuaArrayView::PushPaths(l, paths);
+
+	LUA_DEBUG_END(l, 1);
+
+	return 1;
+}
+
 /*
  * Method: GetBodyPaths
  *
@@ -293,6 +332,71 @@ static int l_starsystem_get_nearby_systems(lua_State *l)
 	return 1;
 }
 
+/*
+ * Method: GetNearbySystemPathView
+ *
+ * Get the <SystemPaths> of nearby systems as a read-only array view. Unlike
+ * <GetNearbySystems> this only looks at sector data, so none of the systems
+ * have to be generated.
+ *
+ * > paths = system:GetNearbySystemPathView(range)
+ *
+ * Parameters:
+ *
+ *   range - distance from this system to search, in light years
+ *
+ * Return:
+ *
+ *   paths - supports paths[i], #paths and ipairs(paths)
+ *
+ * Availability:
+ *
+ *   October 2015
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_starsystem_get_nearby_system_path_view(lua_State *l)
+{
+	PROFILE_SCOPED()
+	LUA_DEBUG_START(l);
+
+	const StarSystem *s = LuaObject<StarSystem>::CheckFromLua(1);
+	const double dist_ly = luaL_checknumber(l, 2);
+
+	const SystemPath &here = s->GetPath();
+	const Uint32 here_idx = here.systemIndex;
+	RefCountedPtr<const Sector> here_sec = s->m_galaxy->GetSector(here);
+
+	const int diff_sec = int(ceil(dist_ly/Sector::SIZE));
+
+	std::vector<SystemPath> paths;
+	for (int x = here.sectorX-diff_sec; x <= here.sectorX+diff_sec; x++) {
+		for (int y = here.sectorY-diff_sec; y <= here.sectorY+diff_sec; y++) {
+			for (int z = here.sectorZ-diff_sec; z <= here.sectorZ+diff_sec; z++) {
+				RefCountedPtr<const Sector> sec = s->m_galaxy->GetSector(SystemPath(x, y, z));
+
+				for (unsigned int idx = 0; idx < sec->m_systems.size(); idx++) {
+					if (x == here.sectorX && y == here.sectorY && z == here.sectorZ && idx == here_idx)
+						continue;
+
+					if (Sector::DistanceBetween(here_sec, here_idx, sec, idx) > dist_ly)
+						continue;
+
+					paths.push_back(SystemPath(x, y, z, idx));
+				}
+			}
+		}
+	}
+
+	LuaArrayView::PushPaths(l, paths);
+
+	LUA_DEBUG_END(l, 1);
+
+	return 1;
+}
+
 /*
  * Method: DistanceTo
  *
@@ -558,11 +662,13 @@ template <> void LuaObject<StarSystem>::RegisterClass()
 	static const luaL_Reg l_methods[] = {
 		{ "GetStationPaths", l_starsystem_get_station_paths },
 		{ "GetBodyPaths", l_starsystem_get_body_paths },
+		{ "GetStationPathView", l_starsystem_get_station_path_view },
 
 		{ "GetCommodityBasePriceAlterations", l_starsystem_get_commodity_base_price_alterations },
 		{ "IsCommodityLegal",                 l_starsystem_is_commodity_legal                   },
 
 		{ "GetNearbySystems", l_starsystem_get_nearby_systems },
+		{ "GetNearbySystemPathView", l_starsystem_get_nearby_system_path_view },
 
 		{ "DistanceTo", l_starsystem_distance_to },
 
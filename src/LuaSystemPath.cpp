@@ -10,6 +10,8 @@
 #include "galaxy/StarSystem.h"
 #include "galaxy/Sector.h"
 #include "galaxy/GalaxyCache.h"
+#include "galaxy/MarketIndex.h"
+#include "EnumStrings.h"
 
 /*
  * Class: SystemPath
@@ -313,6 +315,139 @@ static int l_sbodypath_distance_to(lua_State *l)
 	return 1;
 }
 
+/*
+ * Method: GetRouteTo
+ *
+ * Plan a multi-jump hyperspace route from this system to another
+ *
+ * > route = path:GetRouteTo(otherpath, range)
+ *
+ * The route found has the shortest total distance of all routes made of
+ * jumps no longer than the given range. Routes are remembered, so asking
+ * for the same one again is cheap.
+ *
+ * Parameters:
+ *
+ *   otherpath - the <SystemPath> to plan a route to
+ *
+ *   range - the longest single jump allowed, in lightyears. ranges over
+ *           50 lightyears are treated as 50
+ *
+ * Return:
+ *
+ *   route - an array of <SystemPath> objects for the systems along the way,
+ *           starting with this one and ending with otherpath, or nil if no
+ *           route could be found or either path names a system that
+ *           doesn't exist
+ *
+ * Availability:
+ *
+ *   October 2015
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_sbodypath_get_route_to(lua_State *l)
+{
+	PROFILE_SCOPED()
+	LUA_DEBUG_START(l);
+
+	const SystemPath *from = LuaObject<SystemPath>::CheckFromLua(1);
+	const SystemPath *to = LuaObject<SystemPath>::CheckFromLua(2);
+	const float range = luaL_checknumber(l, 3);
+
+	if (!from->HasValidSystem())
+		return luaL_error(l, "SystemPath:GetRouteTo() self argument does not refer to a system");
+	if (!to->HasValidSystem())
+		return luaL_error(l, "SystemPath:GetRouteTo() argument #1 does not refer to a system");
+
+	const RoutePlanner::Route &route = Pi::game->GetGalaxy()->GetRoutePlanner()->GetRoute(*from, *to, range);
+	if (route.empty()) {
+		lua_pushnil(l);
+	} else {
+		lua_createtable(l, route.size(), 0);
+		for (unsigned i = 0; i < route.size(); i++) {
+			lua_pushinteger(l, i+1);
+			LuaObject<SystemPath>::PushToLua(route[i]);
+			lua_rawset(l, -3);
+		}
+	}
+
+	LUA_DEBUG_END(l, 1);
+	return 1;
+}
+
+/*
+ * Method: GetBestMarkets
+ *
+ * Find the best places to buy and sell every commodity around this system
+ *
+ * > cheapest, dearest = path:GetBestMarkets(range, jumps)
+ *
+ * Only systems with stations where the commodity is legal are considered.
+ * Systems up to jumps * range lightyears away in a straight line count as
+ * reachable. Answers are remembered, so asking again is cheap.
+ *
+ * Parameters:
+ *
+ *   range - the longest single jump, in lightyears
+ *
+ *   jumps - optional. the number of jumps allowed, defaults to 1
+ *
+ * Return:
+ *
+ *   cheapest - a table keyed by commodity type (see <Constants.CommodityType>)
+ *              whose values are tables with a 'path' <SystemPath> and the
+ *              'alteration' percentage of the cheapest system in reach.
+ *              commodities nobody in reach trades are left out
+ *
+ *   dearest - the same, for the system with the highest price
+ *
+ * Availability:
+ *
+ *   October 2015
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static void push_markets(lua_State *l, const MarketIndex::Market *markets)
+{
+	lua_newtable(l);
+	for (int i = 0; i < GalacticEconomy::COMMODITY_COUNT; i++) {
+		const char *name = EnumStrings::GetString("CommodityType", i);
+		if (!name || !markets[i].system.HasValidSystem())
+			continue;
+		lua_newtable(l);
+		LuaObject<SystemPath>::PushToLua(markets[i].system);
+		lua_setfield(l, -2, "path");
+		lua_pushinteger(l, markets[i].priceMod);
+		lua_setfield(l, -2, "alteration");
+		lua_setfield(l, -2, name);
+	}
+}
+
+static int l_sbodypath_get_best_markets(lua_State *l)
+{
+	PROFILE_SCOPED()
+	LUA_DEBUG_START(l);
+
+	const SystemPath *path = LuaObject<SystemPath>::CheckFromLua(1);
+	const float range = luaL_checknumber(l, 2);
+	const int jumps = luaL_optinteger(l, 3, 1);
+
+	if (!path->HasValidSystem())
+		return luaL_error(l, "SystemPath:GetBestMarkets() self argument does not refer to a system");
+
+	const MarketIndex::BestMarkets &best = Pi::game->GetGalaxy()->GetMarketIndex()->GetBestMarkets(*path, range, jumps);
+	push_markets(l, best.cheapest);
+	push_markets(l, best.dearest);
+
+	LUA_DEBUG_END(l, 2);
+	return 2;
+}
+
 /*
  * Method: GetStarSystem
  *
@@ -575,6 +710,8 @@ template <> void LuaObject<SystemPath>::RegisterClass()
 		{ "SectorOnly", l_sbodypath_sector_only },
 
 		{ "DistanceTo", l_sbodypath_distance_to },
+		{ "GetRouteTo", l_sbodypath_get_route_to },
+		{ "GetBestMarkets", l_sbodypath_get_best_markets },
 
 		{ "GetStarSystem", l_sbodypath_get_star_system },
 		{ "GetSystemBody", l_sbodypath_get_system_body },
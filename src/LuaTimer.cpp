@@ -5,65 +5,91 @@
 #include "LuaUtils.h"
 #include "Game.h"
 #include "Pi.h"
+#include <algorithm>
 
 void LuaTimer::RemoveAll()
 {
-    lua_State *l = Lua::manager->GetLuaState();
+	lua_State *l = Lua::manager->GetLuaState();
+
+	lua_pushnil(l);
+	lua_setfield(l, LUA_REGISTRYINDEX, "PiTimerCallbacks");
+
+	m_queue.clear();
+	m_nextId = 1;
+}
 
-    lua_pushnil(l);
-    lua_setfield(l, LUA_REGISTRYINDEX, "PiTimerCallbacks");
+void LuaTimer::Push(double at, int id)
+{
+	m_queue.push_back(Entry{ at, id });
+	std::push_heap(m_queue.begin(), m_queue.end());
+}
+
+int LuaTimer::Schedule(double at)
+{
+	const int id = m_nextId++;
+	Push(at, id);
+	return id;
 }
 
 void LuaTimer::Tick()
 {
+	PROFILE_SCOPED()
 	assert(Pi::game);
+
+	const double now = Pi::game->GetTime();
+	if (m_queue.empty() || m_queue.front().at > now)
+		return;
+
 	lua_State *l = Lua::manager->GetLuaState();
 
 	LUA_DEBUG_START(l);
 
-	lua_getfield(l, LUA_REGISTRYINDEX, "PiTimerCallbacks");
-	if (lua_isnil(l, -1)) {
-		lua_pop(l, 1);
-		LUA_DEBUG_END(l, 0);
-		return;
-	}
-	assert(lua_istable(l, -1));
+	// new and rescheduled timers are always due after now, so this ends
+	while (!m_queue.empty() && m_queue.front().at <= now) {
+		const int id = m_queue.front().id;
+		std::pop_heap(m_queue.begin(), m_queue.end());
+		m_queue.pop_back();
 
-	double now = Pi::game->GetTime();
+		// look the table up each time; a callback may have removed everything
+		lua_getfield(l, LUA_REGISTRYINDEX, "PiTimerCallbacks");
+		if (lua_isnil(l, -1)) {
+			lua_pop(l, 1);
+			break;
+		}
+		assert(lua_istable(l, -1));
 
-	lua_pushnil(l);
-	while (lua_next(l, -2)) {
+		lua_rawgeti(l, -1, id);
+		if (lua_isnil(l, -1)) {
+			lua_pop(l, 2);
+			continue;
+		}
 		assert(lua_istable(l, -1));
 
-		lua_getfield(l, -1, "at");
-		double at = lua_tonumber(l, -1);
+		lua_getfield(l, -1, "callback");
+		pi_lua_protected_call(l, 0, 1);
+		bool cancel = lua_toboolean(l, -1);
 		lua_pop(l, 1);
 
-		if (at <= now) {
-			lua_getfield(l, -1, "callback");
-			pi_lua_protected_call(l, 0, 1);
-			bool cancel = lua_toboolean(l, -1);
-			lua_pop(l, 1);
+		lua_getfield(l, -1, "every");
+		if (lua_isnil(l, -1) || cancel) {
+			lua_pop(l, 2);
 
-			lua_getfield(l, -1, "every");
-			if (lua_isnil(l, -1) || cancel) {
-				lua_pop(l, 1);
+			lua_pushnil(l);
+			lua_rawseti(l, -2, id);
+		}
+		else {
+			double every = lua_tonumber(l, -1);
+			lua_pop(l, 1);
 
-				lua_pushvalue(l, -2);
-				lua_pushnil(l);
-				lua_settable(l, -5);
-			}
-			else {
-				double every = lua_tonumber(l, -1);
-				lua_pop(l, 1);
+			double at = Pi::game->GetTime() + every;
+			pi_lua_settable(l, "at", at);
+			lua_pop(l, 1);
 
-				pi_lua_settable(l, "at", Pi::game->GetTime() + every);
-			}
+			Push(at, id);
 		}
 
 		lua_pop(l, 1);
 	}
-	lua_pop(l, 1);
 
 	LUA_DEBUG_END(l, 0);
 }
@@ -104,7 +130,7 @@ void LuaTimer::Tick()
  * underlying object exists before trying to use it.
  */
 
-static void _finish_timer_create(lua_State *l)
+static void _finish_timer_create(lua_State *l, double at)
 {
 	lua_pushstring(l, "callback");
 	lua_pushvalue(l, 3);
@@ -119,9 +145,7 @@ static void _finish_timer_create(lua_State *l)
 	}
 
 	lua_insert(l, -2);
-	lua_pushinteger(l, lua_rawlen(l, -2) + 1);
-	lua_insert(l, -2);
-	lua_settable(l, -3);
+	lua_rawseti(l, -2, Pi::luaTimer->Schedule(at));
 
 	lua_pop(l, 1);
 }
@@ -175,7 +199,7 @@ static int l_timer_call_at(lua_State *l)
 	lua_newtable(l);
 	pi_lua_settable(l, "at", at);
 
-	_finish_timer_create(l);
+	_finish_timer_create(l, at);
 
 	LUA_DEBUG_END(l, 0);
 
@@ -238,10 +262,11 @@ static int l_timer_call_every(lua_State *l)
 	LUA_DEBUG_START(l);
 
 	lua_newtable(l);
+	const double at = Pi::game->GetTime() + every;
 	pi_lua_settable(l, "every", every);
-	pi_lua_settable(l, "at", Pi::game->GetTime() + every);
+	pi_lua_settable(l, "at", at);
 
-	_finish_timer_create(l);
+	_finish_timer_create(l, at);
 
 	LUA_DEBUG_END(l, 0);
 
@@ -263,7 +288,7 @@ template <> void LuaObject<LuaTimer>::RegisterClass()
 	};
 
 	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
-	LuaObjectBase::CreateObject(l_methods, 0, 0);
+	LuaObjectBase::CreateObject("Timer", l_methods, 0, 0);
 	lua_setfield(l, -2, "Timer");
 	lua_pop(l, 1);
 
@@ -6,11 +6,38 @@
 
 #include "LuaManager.h"
 #include "DeleteEmitter.h"
+#include <vector>
 
 class LuaTimer : public DeleteEmitter {
 public:
+	LuaTimer() : m_nextId(1) {}
+
 	void Tick();
 	void RemoveAll();
+
+	// queues a callback to fire at the given game time. returns the key to
+	// store the timer under in the PiTimerCallbacks registry table
+	int Schedule(double at);
+
+private:
+	// timers are kept in a min-heap on due time so a tick only has to look
+	// at the ones that are actually due
+	struct Entry {
+		double at;
+		int id;
+		// std::push_heap keeps the largest at the front, so invert. ties go
+		// to the older timer so timers fire in the order they were set
+		bool operator<(const Entry &o) const {
+			if (o.at < at) return true;
+			if (at < o.at) return false;
+			return id > o.id;
+		}
+	};
+
+	void Push(double at, int id);
+
+	std::vector<Entry> m_queue;
+	int m_nextId;
 };
 
 #endif
@@ -4,6 +4,7 @@
 #include "LuaUtils.h"
 #include "libs.h"
 #include "FileSystem.h"
+#include "LuaBytecodeCache.h"
 
 extern "C" {
 #ifdef ENABLE_LDB
@@ -529,7 +530,13 @@ int pi_lua_loadfile(lua_State *l, const FileSystem::FileData &code)
 	bool trusted = code.GetInfo().GetSource().IsTrusted();
 	const std::string chunkName = (trusted ? "[T] @" : "@") + path;
 
-	return luaL_loadbuffer(l, source.begin, source.Size(), chunkName.c_str());
+	if (LuaBytecodeCache::Load(l, chunkName, source))
+		return LUA_OK;
+
+	const int ret = luaL_loadbuffer(l, source.begin, source.Size(), chunkName.c_str());
+	if (ret == LUA_OK)
+		LuaBytecodeCache::Save(l, chunkName, source);
+	return ret;
 }
 
 static void pi_lua_dofile(lua_State *l, const FileSystem::FileData &code, int nret)
@@ -152,12 +152,129 @@ static int l_vector_cross(lua_State *L)
 	return 1;
 }
 
+// the rest change the vector they're called on and return it, rather than
+// making a new one, so loops can do their sums without making garbage.
+// a:add(b, 2) is a = a + b * 2
+
+// v:set(x, y, z) or v:set(other)
+static int l_vector_set(lua_State *L)
+{
+	vector3d *v = const_cast<vector3d*>(LuaVector::CheckFromLua(L, 1));
+	if (lua_isnumber(L, 2))
+		*v = vector3d(luaL_checknumber(L, 2), luaL_checknumber(L, 3), luaL_checknumber(L, 4));
+	else
+		*v = *LuaVector::CheckFromLua(L, 2);
+	lua_settop(L, 1);
+	return 1;
+}
+
+// v:add(other[, scale])
+static int l_vector_add_in_place(lua_State *L)
+{
+	vector3d *v = const_cast<vector3d*>(LuaVector::CheckFromLua(L, 1));
+	const vector3d *b = LuaVector::CheckFromLua(L, 2);
+	*v += *b * luaL_optnumber(L, 3, 1.0);
+	lua_settop(L, 1);
+	return 1;
+}
+
+// v:sub(other)
+static int l_vector_sub_in_place(lua_State *L)
+{
+	vector3d *v = const_cast<vector3d*>(LuaVector::CheckFromLua(L, 1));
+	*v -= *LuaVector::CheckFromLua(L, 2);
+	lua_settop(L, 1);
+	return 1;
+}
+
+// v:scale(s)
+static int l_vector_scale(lua_State *L)
+{
+	vector3d *v = const_cast<vector3d*>(LuaVector::CheckFromLua(L, 1));
+	*v *= luaL_checknumber(L, 2);
+	lua_settop(L, 1);
+	return 1;
+}
+
+// v:normalise()
+static int l_vector_normalise(lua_State *L)
+{
+	vector3d *v = const_cast<vector3d*>(LuaVector::CheckFromLua(L, 1));
+	*v = v->NormalizedSafe();
+	lua_settop(L, 1);
+	return 1;
+}
+
+// x, y, z = v:unpack(), three plain numbers
+static int l_vector_unpack(lua_State *L)
+{
+	const vector3d *v = LuaVector::CheckFromLua(L, 1);
+	lua_pushnumber(L, v->x);
+	lua_pushnumber(L, v->y);
+	lua_pushnumber(L, v->z);
+	return 3;
+}
+
+// vector.distances(p, { a, b, ... }) is { |a-p|, |b-p|, ... }. the numbers
+// go in the table given as the third argument if there is one, so it can be
+// used again
+static int l_vector_distances(lua_State *L)
+{
+	const vector3d *p = LuaVector::CheckFromLua(L, 1);
+	luaL_checktype(L, 2, LUA_TTABLE);
+	const int count = lua_rawlen(L, 2);
+	if (lua_istable(L, 3))
+		lua_settop(L, 3);
+	else {
+		lua_settop(L, 2);
+		lua_createtable(L, count, 0);
+	}
+	for (int i = 1; i <= count; i++) {
+		lua_rawgeti(L, 2, i);
+		const vector3d *v = LuaVector::CheckFromLua(L, -1);
+		const double d = (*v - *p).Length();
+		lua_pop(L, 1);
+		lua_pushnumber(L, d);
+		lua_rawseti(L, 3, i);
+	}
+	return 1;
+}
+
+// index, distance = vector.nearest(p, { a, b, ... }). nil for an empty list
+static int l_vector_nearest(lua_State *L)
+{
+	const vector3d *p = LuaVector::CheckFromLua(L, 1);
+	luaL_checktype(L, 2, LUA_TTABLE);
+	const int count = lua_rawlen(L, 2);
+	int best = 0;
+	double bestDistSqr = 0.0;
+	for (int i = 1; i <= count; i++) {
+		lua_rawgeti(L, 2, i);
+		const vector3d *v = LuaVector::CheckFromLua(L, -1);
+		const double distSqr = (*v - *p).LengthSqr();
+		lua_pop(L, 1);
+		if (!best || distSqr < bestDistSqr) {
+			best = i;
+			bestDistSqr = distSqr;
+		}
+	}
+	if (!best) {
+		lua_pushnil(L);
+		return 1;
+	}
+	lua_pushinteger(L, best);
+	lua_pushnumber(L, sqrt(bestDistSqr));
+	return 2;
+}
+
 static luaL_Reg l_vector_lib[] = {
 	{ "new", &l_vector_new },
 	{ "unit", &l_vector_unit },
 	{ "cross", &l_vector_cross },
 	{ "dot", &l_vector_dot },
 	{ "length", &l_vector_length },
+	{ "distances", &l_vector_distances },
+	{ "nearest", &l_vector_nearest },
 	{ 0, 0 }
 };
 
@@ -175,6 +292,12 @@ static luaL_Reg l_vector_meta[] = {
 	{ "length", &l_vector_length },
 	{ "cross", &l_vector_cross },
 	{ "dot", &l_vector_dot },
+	{ "unpack", &l_vector_unpack },
+	{ "set", &l_vector_set },
+	{ "add", &l_vector_add_in_place },
+	{ "sub", &l_vector_sub_in_place },
+	{ "scale", &l_vector_scale },
+	{ "normalise", &l_vector_normalise },
 	{ 0, 0 }
 };
 
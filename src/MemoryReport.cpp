@@ -0,0 +1,120 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "MemoryReport.h"
+#include "Game.h"
+#include "GeoPatchPool.h"
+#include "Lua.h"
+#include "ModelCache.h"
+#include "OS.h"
+#include "Pi.h"
+#include "Sound.h"
+#include "StringName.h"
+#include "galaxy/Galaxy.h"
+#include "graphics/Renderer.h"
+#include <cstdio>
+#include <map>
+
+namespace MemoryReport {
+
+static Entry MakeEntry(const std::string &name, size_t bytes, Uint32 count)
+{
+	Entry e = { name, bytes, count };
+	return e;
+}
+
+std::vector<Entry> Collect()
+{
+	PROFILE_SCOPED()
+	std::vector<Entry> entries;
+
+	if (Lua::manager)
+		entries.push_back(MakeEntry("lua", Lua::manager->GetMemoryUsage(), 0));
+
+	if (Pi::modelCache)
+		entries.push_back(MakeEntry("models", Pi::modelCache->GetMemoryUsage(), Pi::modelCache->GetNumModels()));
+
+	if (Pi::renderer) {
+		const std::map<std::string,Graphics::Renderer::TextureCacheUsage> textures = Pi::renderer->GetTextureCacheUsage();
+		for (auto it = textures.begin(); it != textures.end(); ++it)
+			entries.push_back(MakeEntry("textures/" + it->first, it->second.bytes, it->second.textures));
+	}
+
+	if (Pi::game) {
+		const RefCountedPtr<Galaxy> galaxy = Pi::game->GetGalaxy();
+		entries.push_back(MakeEntry("galaxy/sectors", galaxy->GetSectorCache().GetBytesResident(),
+			galaxy->GetSectorCache().GetNumResident()));
+		entries.push_back(MakeEntry("galaxy/systems", galaxy->GetStarSystemCache().GetBytesResident(),
+			galaxy->GetStarSystemCache().GetNumResident()));
+	}
+
+	const GeoPatchPool::Stats pool = GeoPatchPool::GetStats();
+	entries.push_back(MakeEntry("geopatch/in use", pool.bytesInUse, pool.slabsInUse));
+	entries.push_back(MakeEntry("geopatch/free", pool.bytesFree, pool.slabsFree));
+
+	size_t soundBytes = 0;
+	Uint32 soundSamples = 0;
+	const Sound::SampleMap &samples = Sound::GetSamples();
+	for (auto it = samples.begin(); it != samples.end(); ++it) {
+		if (it->second.buf) {
+			soundBytes += it->second.buf_len * sizeof(Uint16);
+			soundSamples++;
+		}
+	}
+	entries.push_back(MakeEntry("sound samples", soundBytes, soundSamples));
+
+	size_t names, nameBytes;
+	StringName::GetStats(names, nameBytes);
+	entries.push_back(MakeEntry("interned names", nameBytes, names));
+
+	return entries;
+}
+
+std::string Dump()
+{
+	// what each was at the last dump, to spot anything that keeps growing
+	static std::map<std::string,size_t> s_previous;
+
+	const std::vector<Entry> entries = Collect();
+	std::string out;
+	char buf[256];
+	snprintf(buf, sizeof(buf), "%-24s %10s %10s %10s\n", "", "KB", "change", "objects");
+	out += buf;
+	size_t total = 0;
+	for (const Entry &e : entries) {
+		auto prev = s_previous.find(e.name);
+		const double change = prev != s_previous.end() ? (double(e.bytes) - double(prev->second)) / 1024.0 : 0.0;
+		snprintf(buf, sizeof(buf), "%-24s %10zu %+10.0f %10u\n", e.name.c_str(), e.bytes >> 10, change, e.count);
+		out += buf;
+		s_previous[e.name] = e.bytes;
+		total += e.bytes;
+	}
+	snprintf(buf, sizeof(buf), "%-24s %10zu\n%-24s %10zu\n", "total", total >> 10, "process peak", OS::GetPeakMemoryUsage() >> 10);
+	out += buf;
+	return out;
+}
+
+std::string Summary()
+{
+	const std::vector<Entry> entries = Collect();
+	// folded together by the part of the name before the slash
+	std::vector<std::pair<std::string,size_t>> groups;
+	for (const Entry &e : entries) {
+		const std::string group = e.name.substr(0, e.name.find('/'));
+		if (groups.empty() || groups.back().first != group)
+			groups.push_back(std::make_pair(group, size_t(0)));
+		groups.back().second += e.bytes;
+	}
+
+	std::string out = "Memory MB:";
+	char buf[64];
+	for (size_t i = 0; i < groups.size(); i++) {
+		snprintf(buf, sizeof(buf), "%s %s %.1f", i ? "," : "", groups[i].first.c_str(), double(groups[i].second) / (1024.0 * 1024.0));
+		out += buf;
+	}
+	snprintf(buf, sizeof(buf), ", process peak %.0f\n", double(OS::GetPeakMemoryUsage()) / (1024.0 * 1024.0));
+	out += buf;
+	return out;
+}
+
+}
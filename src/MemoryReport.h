@@ -0,0 +1,34 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _MEMORYREPORT_H
+#define _MEMORYREPORT_H
+
+#include "libs.h"
+#include <string>
+#include <vector>
+
+/*
+ * How much memory each of the big caches is holding, as each of them
+ * reckons it: Lua, the model cache, the renderer's texture cache by type,
+ * the galaxy caches, GeoPatch vertex data and decoded sound samples. These
+ * are the subsystem's own estimates rather than what the allocator sees, so
+ * they won't add up to the process total, but they do show which one is
+ * growing.
+ */
+namespace MemoryReport {
+	struct Entry {
+		std::string name;
+		size_t bytes;
+		Uint32 count; // objects held, where that means something
+	};
+
+	std::vector<Entry> Collect();
+
+	// a table of everything, with the change in each since the last Dump
+	std::string Dump();
+	// a line or two of megabytes for the debug overlay
+	std::string Summary();
+}
+
+#endif
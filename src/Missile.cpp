@@ -22,6 +22,7 @@ Missile::Missile(ShipType::Id shipId, Body *owner, int power): Ship(shipId)
 		m_power = power;
 
 	m_owner = owner;
+	if (m_owner) m_owner->AddWatcher(this);
 	SetLabel(Lang::MISSILE);
 	Disarm();
 }
@@ -38,6 +39,7 @@ void Missile::PostLoadFixup(Space *space)
 {
 	Ship::PostLoadFixup(space);
 	m_owner = space->GetBodyByIndex(m_ownerIndex);
+	if (m_owner) m_owner->AddWatcher(this);
 }
 
 void Missile::SaveToJson(Json::Value &jsonObj, Space *space)
@@ -58,7 +60,7 @@ void Missile::LoadFromJson(const Json::Value &jsonObj, Space *space)
 	Ship::LoadFromJson(jsonObj, space);
 
 	if (!jsonObj.isMember("missile")) throw SavedGameCorruptException();
-	Json::Value missileObj = jsonObj["missile"];
+	const Json::Value &missileObj = jsonObj["missile"];
 
 	if (!missileObj.isMember("index_for_body")) throw SavedGameCorruptException();
 	if (!missileObj.isMember("power")) throw SavedGameCorruptException();
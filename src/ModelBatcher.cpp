@@ -0,0 +1,102 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "ModelBatcher.h"
+#include "ModelBody.h"
+#include "graphics/Renderer.h"
+#include "scenegraph/SceneGraph.h"
+
+ModelBatcher::ModelBatcher(Graphics::Renderer *r)
+: m_renderer(r)
+{
+}
+
+bool ModelBatcher::SameLights(const Batch &b, const std::vector<Graphics::Light> &lights, const Color &ambient)
+{
+	if (!(b.ambient == ambient) || b.lights.size() != lights.size())
+		return false;
+	for (size_t i = 0; i < lights.size(); i++) {
+		const Graphics::Light &l1 = b.lights[i];
+		const Graphics::Light &l2 = lights[i];
+		if (l1.GetType() != l2.GetType() || !(l1.GetPosition() == l2.GetPosition()) ||
+			!(l1.GetDiffuse() == l2.GetDiffuse()) || !(l1.GetSpecular() == l2.GetSpecular()))
+			return false;
+	}
+	return true;
+}
+
+void ModelBatcher::Add(ModelBody *body, const matrix4x4f &trans, const std::vector<Graphics::Light> &lights, const Color &ambient)
+{
+	const Instance inst = { body, trans };
+
+	const SceneGraph::Model *model = body->GetModel();
+	for (Batch &b : m_batches) {
+		if (SameLights(b, lights, ambient) && model->CanShareRenderWith(*b.instances.front().body->GetModel())) {
+			b.instances.push_back(inst);
+			return;
+		}
+	}
+
+	m_batches.push_back(Batch());
+	Batch &b = m_batches.back();
+	b.lights = lights;
+	b.ambient = ambient;
+	b.instances.push_back(inst);
+}
+
+void ModelBatcher::DrawBatch(Batch &batch)
+{
+	m_renderer->SetAmbientColor(batch.ambient);
+	m_renderer->SetLights(batch.lights.size(), &batch.lights[0]);
+
+	Graphics::Renderer::GpuTimerTicket gt(m_renderer, Graphics::Stats::GPU_TIMER_MODELS);
+
+	if (batch.instances.size() == 1) {
+		const Instance &inst = batch.instances.front();
+		inst.body->PrepareBatchedRender();
+		inst.body->GetModel()->Render(inst.transform);
+		return;
+	}
+
+	m_transforms.clear();
+	for (const Instance &inst : batch.instances) {
+		matrix4x4f t = inst.transform;
+		if (inst.body->GetModel()->HasPatternArray())
+			inst.body->GetModel()->PackInstanceSkin(t);
+		m_transforms.push_back(t);
+	}
+
+	// any instance will do, they all look the same
+	const Instance &first = batch.instances.front();
+	first.body->PrepareBatchedRender();
+	first.body->GetModel()->RenderPass(m_transforms, SceneGraph::NODE_SOLID);
+
+	for (const Instance &inst : batch.instances) {
+		inst.body->PrepareBatchedRender();
+		inst.body->GetModel()->RenderPass(inst.transform, SceneGraph::NODE_TRANSPARENT);
+	}
+}
+
+void ModelBatcher::Flush()
+{
+	PROFILE_SCOPED()
+	if (m_batches.empty())
+		return;
+
+	const Color oldAmbient = m_renderer->GetAmbientColor();
+	std::vector<Graphics::Light> oldLights;
+	for (Uint32 i = 0; i < m_renderer->GetNumLights(); i++)
+		oldLights.push_back(m_renderer->GetLight(i));
+
+	{
+		Graphics::Renderer::MatrixTicket mt(m_renderer, Graphics::MatrixMode::MODELVIEW);
+		for (Batch &b : m_batches)
+			DrawBatch(b);
+	}
+
+	if (!oldLights.empty())
+		m_renderer->SetLights(oldLights.size(), &oldLights[0]);
+	m_renderer->SetAmbientColor(oldAmbient);
+
+	m_batches.clear();
+}
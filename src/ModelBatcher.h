@@ -0,0 +1,51 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _MODELBATCHER_H
+#define _MODELBATCHER_H
+
+#include "libs.h"
+#include "graphics/Light.h"
+#include <vector>
+
+class ModelBody;
+namespace Graphics { class Renderer; }
+
+/*
+ * Collects the model bodies a camera draws in a frame and draws bodies
+ * that share a model, skin, animation state and lighting together: their
+ * solid pass goes through the instanced path in one go, after which each
+ * body draws its own transparent pass (thrusters, navlights, labels,
+ * glass) so per-body state there is kept.
+ *
+ * Models whose patterns all fit in one texture array carry each
+ * instance's pattern and colours in its transform, so those only need
+ * matching decals. Otherwise skins are not per instance, and bodies only
+ * batch if their pattern, colours and decals all match.
+ */
+class ModelBatcher {
+public:
+	ModelBatcher(Graphics::Renderer *r);
+
+	void Add(ModelBody *body, const matrix4x4f &trans, const std::vector<Graphics::Light> &lights, const Color &ambient);
+	void Flush();
+
+private:
+	struct Instance {
+		ModelBody *body;
+		matrix4x4f transform;
+	};
+	struct Batch {
+		std::vector<Graphics::Light> lights;
+		Color ambient;
+		std::vector<Instance> instances;
+	};
+	static bool SameLights(const Batch &b, const std::vector<Graphics::Light> &lights, const Color &ambient);
+	void DrawBatch(Batch &batch);
+
+	Graphics::Renderer *m_renderer;
+	std::vector<Batch> m_batches;
+	std::vector<matrix4x4f> m_transforms;
+};
+
+#endif
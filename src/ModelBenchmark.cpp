@@ -0,0 +1,262 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "ModelBenchmark.h"
+#include "CollMesh.h"
+#include "FileSystem.h"
+#include "GameConfig.h"
+#include "Lua.h"
+#include "ModManager.h"
+#include "NavLights.h"
+#include "OS.h"
+#include "Shields.h"
+#include "graphics/Graphics.h"
+#include "graphics/Light.h"
+#include "graphics/opengl/RendererGL.h"
+#include "json/json.h"
+#include "scenegraph/LOD.h"
+#include "scenegraph/NodeVisitor.h"
+#include "scenegraph/SceneGraph.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <set>
+
+// frames drawn and thrown away before each level is timed, while textures
+// and buffers settle
+static const Uint32 WARMUP_FRAMES = 5;
+// frames afterwards with nothing drawn, for the last GPU timer results to come in
+static const Uint32 FLUSH_FRAMES = 3;
+// as the model viewer
+static const float FOV = 85.f;
+
+namespace ModelBenchmark {
+
+// finds the outermost LOD node, whose levels are the model's detail levels
+class FindLOD : public SceneGraph::NodeVisitor {
+public:
+	FindLOD() : m_lod(nullptr) {}
+	virtual void ApplyLOD(SceneGraph::LOD &lod) { if (!m_lod) m_lod = &lod; }
+	SceneGraph::LOD *m_lod;
+};
+
+static double Now()
+{
+	return double(SDL_GetPerformanceCounter()) / double(SDL_GetPerformanceFrequency());
+}
+
+// names of everything under models/, without the extension, as the loader wants them
+static void CollectModels(std::set<std::string> &names)
+{
+	for (FileSystem::FileEnumerator files(FileSystem::gameDataFiles, "models", FileSystem::FileEnumerator::Recurse); !files.Finished(); files.Next()) {
+		const FileSystem::FileInfo &info = files.Current();
+		if (!info.IsFile())
+			continue;
+		const std::string &name = info.GetName();
+		if (ends_with_ci(name, ".model"))
+			names.insert(name.substr(0, name.size() - 6));
+		else if (ends_with_ci(name, ".sgm"))
+			names.insert(name.substr(0, name.size() - 4));
+	}
+}
+
+// distance from the camera at which the LOD picks this level: halfway, in
+// pixels, between its size and the next one up
+static float LevelDistance(const std::vector<unsigned int> &pixelSizes, Uint32 level, float radius)
+{
+	const float pixrad = level == 0 ? pixelSizes[0] * 0.5f : (pixelSizes[level-1] + pixelSizes[level]) * 0.5f;
+	return Graphics::GetScreenHeight() * radius / (pixrad * Graphics::GetFovFactor());
+}
+
+static Json::Value DrawLevel(Graphics::Renderer *r, SceneGraph::Model *model, const matrix4x4f &mv, Uint32 frames)
+{
+	const Graphics::Stats &stats = r->GetStats();
+	double cpuTime = 0.0;
+	Uint64 gpuTime = 0;
+	Uint32 gpuFrames = 0;
+	Uint32 drawCalls = 0, tris = 0;
+	for (Uint32 i = 0; i < WARMUP_FRAMES + frames + FLUSH_FRAMES; i++) {
+		r->BeginFrame();
+		r->ClearScreen();
+		r->SetPerspectiveProjection(FOV, Graphics::GetScreenWidth()/float(Graphics::GetScreenHeight()), 0.1f, 1e6f);
+		r->SetTransform(matrix4x4f::Identity());
+		if (i < WARMUP_FRAMES + frames) {
+			const double start = Now();
+			{
+				Graphics::Renderer::GpuTimerTicket gt(r, Graphics::Stats::GPU_TIMER_MODELS);
+				model->Render(mv);
+			}
+			if (i >= WARMUP_FRAMES)
+				cpuTime += Now() - start;
+		}
+		r->EndFrame();
+		r->SwapBuffers();
+
+		// after the swap the previous frame is the one just drawn. GPU
+		// results arrive a frame or two late, and only from timed frames
+		const Graphics::Stats::TFrameData &prev = stats.FrameStatsPrevious();
+		if (i == WARMUP_FRAMES) {
+			drawCalls = prev.m_stats[Graphics::Stats::STAT_DRAWCALL];
+			tris = prev.m_stats[Graphics::Stats::STAT_DRAWTRIS];
+		}
+		if (i > WARMUP_FRAMES && prev.m_gpuTime[Graphics::Stats::GPU_TIMER_MODELS]) {
+			gpuTime += prev.m_gpuTime[Graphics::Stats::GPU_TIMER_MODELS];
+			gpuFrames++;
+		}
+	}
+
+	Json::Value result(Json::objectValue);
+	result["draw_calls"] = drawCalls;
+	result["triangles"] = tris;
+	result["cpu_ms"] = cpuTime * 1e3 / double(frames);
+	// -1 where the renderer has no GPU timers
+	result["gpu_ms"] = gpuFrames ? double(gpuTime) * 1e-3 / double(gpuFrames) : -1.0;
+	return result;
+}
+
+static Json::Value BenchModel(Graphics::Renderer *r, const std::string &name, Uint32 frames)
+{
+	Json::Value result(Json::objectValue);
+	result["name"] = name;
+
+	// loaded as the game does, so from the .sgm if there is one
+	double start = Now();
+	SceneGraph::Loader::ModelSource src;
+	if (!SceneGraph::Loader::ReadModel(name, "models", true, src)) {
+		result["error"] = "not found";
+		return result;
+	}
+	const double readTime = Now() - start;
+
+	std::unique_ptr<SceneGraph::Model> model;
+	start = Now();
+	try {
+		SceneGraph::Loader loader(r);
+		model.reset(loader.LoadModel(src));
+	} catch (SceneGraph::LoadingError &err) {
+		result["error"] = err.what();
+		return result;
+	}
+	const double buildTime = Now() - start;
+	Shields::ReparentShieldNodes(model.get());
+
+	start = Now();
+	RefCountedPtr<CollMesh> collMesh = model->CreateCollisionMesh();
+	const double collisionTime = Now() - start;
+
+	const SceneGraph::Model::MemoryUsage mem = model->GetMemoryUsage();
+	result["format"] = src.binary ? "sgm" : "model";
+	result["read_ms"] = readTime * 1e3;
+	result["build_ms"] = buildTime * 1e3;
+	result["collision_ms"] = collisionTime * 1e3;
+	result["collision_tris"] = collMesh->GetGeomTree()->GetNumTris();
+	result["geometry_bytes"] = Json::UInt64(mem.geometry);
+	result["texture_bytes"] = Json::UInt64(mem.textures);
+	result["collision_bytes"] = Json::UInt64(mem.collision);
+
+	const float radius = model->GetDrawClipRadius();
+	FindLOD find;
+	model->GetRoot()->Accept(find);
+	const Uint32 numLevels = find.m_lod ? find.m_lod->GetPixelSizes().size() : 1;
+
+	Json::Value levels(Json::arrayValue);
+	for (Uint32 level = 0; level < numLevels; level++) {
+		// a model without levels is drawn from where it fills a good part of the screen
+		const float dist = find.m_lod ? LevelDistance(find.m_lod->GetPixelSizes(), level, radius) : radius * 3.f;
+		matrix4x4f mv = matrix4x4f::Translation(0.f, 0.f, -dist);
+		mv.RotateX(DEG2RAD(20.f));
+		mv.RotateY(DEG2RAD(30.f));
+		if (find.m_lod && find.m_lod->SelectLevel(mv, radius) != int(level))
+			Output("modelbench: %s: level %u not picked at %.1f m\n", name.c_str(), level, dist);
+
+		Json::Value l = DrawLevel(r, model.get(), mv, frames);
+		l["level"] = level;
+		l["distance"] = dist;
+		if (find.m_lod)
+			l["pixel_size"] = find.m_lod->GetPixelSizes()[level];
+		levels.append(l);
+	}
+	result["levels"] = levels;
+
+	Output("  %-24s %-5s %8.2f read %8.2f build %8.2f collision ms, %u levels, level 0: %u tris %u draws %.3f ms gpu\n",
+		name.c_str(), result["format"].asCString(), readTime * 1e3, buildTime * 1e3, collisionTime * 1e3, numLevels,
+		levels[0]["triangles"].asUInt(), levels[0]["draw_calls"].asUInt(), levels[0]["gpu_ms"].asDouble());
+	return result;
+}
+
+bool Run(const std::string &filename, Uint32 frames)
+{
+	std::unique_ptr<GameConfig> config(new GameConfig);
+
+	FileSystem::Init();
+	FileSystem::userFiles.MakeDirectory("");
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+		Error("SDL initialization failed: %s\n", SDL_GetError());
+
+	Lua::Init();
+	ModManager::Init();
+	Graphics::RendererOGL::RegisterRenderer();
+
+	// windowed and without vsync, or the frame times are the refresh rate
+	Graphics::Settings videoSettings = {};
+	videoSettings.rendererType = Graphics::RENDERER_OPENGL;
+	videoSettings.width = config->Int("ScrWidth");
+	videoSettings.height = config->Int("ScrHeight");
+	videoSettings.fullscreen = false;
+	videoSettings.hidden = false;
+	videoSettings.requestedSamples = config->Int("AntiAliasingMode");
+	videoSettings.vsync = false;
+	videoSettings.useTextureCompression = (config->Int("UseTextureCompression") != 0);
+	videoSettings.iconFile = OS::GetIconFilename();
+	videoSettings.title = "Model benchmark";
+	Graphics::Renderer *renderer = Graphics::Init(videoSettings);
+
+	NavLights::Init(renderer);
+	Shields::Init(renderer);
+
+	const Graphics::Light light(Graphics::Light::LIGHT_DIRECTIONAL, vector3f(0.f, 0.5f, 1.f).Normalized(), Color::WHITE, Color::WHITE);
+	renderer->SetLights(1, &light);
+	renderer->SetAmbientColor(Color(50, 50, 50));
+
+	std::set<std::string> names;
+	CollectModels(names);
+	Output("modelbench: %u models, %u frames per level\n", Uint32(names.size()), frames);
+
+	Json::Value results(Json::arrayValue);
+	const double start = Now();
+	for (const std::string &name : names) {
+		results.append(BenchModel(renderer, name, frames));
+		// each model's textures loaded fresh, as they would be in game
+		renderer->RemoveAllCachedTextures();
+	}
+	Output("modelbench: done in %.1f s\n", Now() - start);
+
+	Json::Value root(Json::objectValue);
+	root["frames"] = frames;
+	root["width"] = Graphics::GetScreenWidth();
+	root["height"] = Graphics::GetScreenHeight();
+	root["fov"] = FOV;
+	root["results"] = results;
+
+	Lua::Uninit();
+	delete renderer;
+	Shields::Uninit();
+	NavLights::Uninit();
+	Graphics::Uninit();
+	FileSystem::Uninit();
+	SDL_Quit();
+
+	Json::StyledWriter writer;
+	const std::string out = writer.write(root);
+	FILE *f = filename == "-" ? stdout : fopen(filename.c_str(), "w");
+	if (!f) {
+		Output("modelbench: could not open \"%s\" for writing: %s\n", filename.c_str(), strerror(errno));
+		return false;
+	}
+	const bool ok = fwrite(out.c_str(), 1, out.size(), f) == out.size();
+	if (filename != "-" && fclose(f) != 0)
+		return false;
+	return ok;
+}
+
+}
@@ -0,0 +1,30 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _MODELBENCHMARK_H
+#define _MODELBENCHMARK_H
+
+#include "libs.h"
+#include <string>
+
+/*
+ * Model loading and drawing benchmark, to catch an asset or loader change
+ * that makes a model slow. Brings up the renderer the way the model viewer
+ * does, then for every model under data/models times:
+ *
+ *  - reading its files (the .sgm if there is one, as the game would)
+ *  - building it, through BinaryConverter or the .model loader
+ *  - building its collision mesh on its own
+ *
+ * and draws each detail level for a number of frames, from a distance where
+ * that level is picked, recording draw calls, triangles, CPU submission time
+ * and GPU time.
+ *
+ * The results go to the file (or "-" for stdout) as json, for comparing runs.
+ */
+namespace ModelBenchmark {
+	// false if the output couldn't be written
+	bool Run(const std::string &filename, Uint32 frames);
+}
+
+#endif
@@ -11,6 +11,7 @@
 #include "Space.h"
 #include "WorldView.h"
 #include "Camera.h"
+#include "ModelBatcher.h"
 #include "Planet.h"
 #include "collider/collider.h"
 #include "graphics/Renderer.h"
@@ -66,6 +67,8 @@ ModelBody::ModelBody()
 , m_colliding(true)
 , m_geom(0)
 , m_model(0)
+, m_idleAnimation(0)
+, m_animationsDirty(false)
 {
 }
 
@@ -114,7 +117,7 @@ void ModelBody::LoadFromJson(const Json::Value &jsonObj, Space *space)
 	Body::LoadFromJson(jsonObj, space);
 
 	if (!jsonObj.isMember("model_body")) throw SavedGameCorruptException();
-	Json::Value modelBodyObj = jsonObj["model_body"];
+	const Json::Value &modelBodyObj = jsonObj["model_body"];
 
 	if (!modelBodyObj.isMember("is_static")) throw SavedGameCorruptException();
 	if (!modelBodyObj.isMember("is_colliding")) throw SavedGameCorruptException();
@@ -171,15 +174,18 @@ void ModelBody::RebuildCollisionMesh()
 }
 
 void ModelBody::SetModel(const char *modelName)
+{
+	//create model instance (some modelbodies, like missiles could avoid this)
+	SetModel(modelName, Pi::FindModel(modelName)->MakeInstance());
+}
+
+void ModelBody::SetModel(const char *modelName, SceneGraph::Model *instance)
 {
 	//remove old instance
 	delete m_model;
-	m_model = 0;
+	m_model = instance;
 
 	m_modelName = modelName;
-
-	//create model instance (some modelbodies, like missiles could avoid this)
-	m_model = Pi::FindModel(m_modelName)->MakeInstance();
 	m_idleAnimation = m_model->FindAnimation("idle");
 
 	SetClipRadius(m_model->GetDrawClipRadius());
@@ -386,16 +392,28 @@ void ModelBody::CalcLighting(double &ambient, double &direct, const Camera *came
 // should be reset after rendering with ModelBody::ResetLighting.
 void ModelBody::SetLighting(Graphics::Renderer *r, const Camera *camera, std::vector<Graphics::Light> &oldLights, Color &oldAmbient) {
 	std::vector<Graphics::Light> newLights;
+	Color ambient;
+	GetLights(camera, newLights, ambient);
+
+	const std::vector<Camera::LightSource> &lightSources = camera->GetLightSources();
+	oldLights.reserve(lightSources.size());
+	for(size_t i = 0; i < lightSources.size(); i++)
+		oldLights.push_back(lightSources[i].GetLight());
+
+	oldAmbient = r->GetAmbientColor();
+	r->SetAmbientColor(ambient);
+	r->SetLights(newLights.size(), &newLights[0]);
+}
+
+// the camera's lights, dimmed for this body
+void ModelBody::GetLights(const Camera *camera, std::vector<Graphics::Light> &lights, Color &ambientColor) {
 	double ambient, direct;
 	CalcLighting(ambient, direct, camera);
 	const std::vector<Camera::LightSource> &lightSources = camera->GetLightSources();
-	newLights.reserve(lightSources.size());
-	oldLights.reserve(lightSources.size());
+	lights.reserve(lightSources.size());
 	for(size_t i = 0; i < lightSources.size(); i++) {
 		Graphics::Light light(lightSources[i].GetLight());
 
-		oldLights.push_back(light);
-
 		const float intensity = direct * camera->ShadowedIntensity(i, this);
 
 		Color c = light.GetDiffuse();
@@ -409,12 +427,10 @@ void ModelBody::SetLighting(Graphics::Renderer *r, const Camera *camera, std::ve
 		light.SetDiffuse(c);
 		light.SetSpecular(cs);
 
-		newLights.push_back(light);
+		lights.push_back(light);
 	}
 
-	oldAmbient = r->GetAmbientColor();
-	r->SetAmbientColor(Color(ambient*255));
-	r->SetLights(newLights.size(), &newLights[0]);
+	ambientColor = Color(ambient*255);
 }
 
 void ModelBody::ResetLighting(Graphics::Renderer *r, const std::vector<Graphics::Light> &oldLights, const Color &oldAmbient) {
@@ -426,11 +442,6 @@ void ModelBody::ResetLighting(Graphics::Renderer *r, const std::vector<Graphics:
 
 void ModelBody::RenderModel(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform, const bool setLighting)
 {
-	std::vector<Graphics::Light> oldLights;
-	Color oldAmbient;
-	if (setLighting)
-		SetLighting(r, camera, oldLights, oldAmbient);
-
 	matrix4x4d m2 = GetInterpOrient();
 	m2.SetTranslate(GetInterpPosition());
 	matrix4x4d t = viewTransform * m2;
@@ -443,7 +454,30 @@ void ModelBody::RenderModel(Graphics::Renderer *r, const Camera *camera, const v
 	trans[14] = viewCoords.z;
 	trans[15] = 1.0f;
 
-	m_model->Render(trans);
+	if (m_animationsDirty) {
+		m_model->UpdateAnimations();
+		m_animationsDirty = false;
+	}
+
+	// drawn later along with other bodies of the same model
+	ModelBatcher *batcher = camera ? camera->GetModelBatcher() : nullptr;
+	if (setLighting && batcher && CanBatchRender()) {
+		std::vector<Graphics::Light> lights;
+		Color ambient;
+		GetLights(camera, lights, ambient);
+		batcher->Add(this, trans, lights, ambient);
+		return;
+	}
+
+	std::vector<Graphics::Light> oldLights;
+	Color oldAmbient;
+	if (setLighting)
+		SetLighting(r, camera, oldLights, oldAmbient);
+
+	{
+		Graphics::Renderer::GpuTimerTicket gt(r, Graphics::Stats::GPU_TIMER_MODELS);
+		m_model->Render(trans);
+	}
 
 	if (setLighting)
 		ResetLighting(r, oldLights, oldAmbient);
@@ -455,5 +489,11 @@ void ModelBody::TimeStepUpdate(const float timestep)
 		// step animation by timestep/total length, loop to 0.0 if it goes >= 1.0
 		m_idleAnimation->SetProgress(fmod(m_idleAnimation->GetProgress() + timestep / m_idleAnimation->GetDuration(), 1.0));
 
-	m_model->UpdateAnimations();
+	// only animated collision needs the nodes moved every step. Otherwise
+	// wait until the body is drawn, which bodies that are culled or far
+	// away never are
+	if (m_dynGeoms.empty())
+		m_animationsDirty = true;
+	else
+		m_model->UpdateAnimations();
 }
@@ -34,9 +34,20 @@ public:
 	CollMesh *GetCollMesh() { return m_collMesh.Get(); }
 
 	void SetModel(const char *modelName);
+	// as SetModel, with an instance of it that's already been made
+	void SetModel(const char *modelName, SceneGraph::Model *instance);
 
 	void RenderModel(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform, const bool setLighting=true);
 
+	// bodies that can be drawn by the camera's ModelBatcher, which draws
+	// the solid pass of bodies sharing a model in one instanced draw
+	virtual bool CanBatchRender() const { return m_model != nullptr; }
+	// set up state shared between instances of the model (eg. material
+	// parameters) before the batcher draws this body
+	virtual void PrepareBatchedRender() {}
+
+	void GetLights(const Camera *camera, std::vector<Graphics::Light> &lights, Color &ambient);
+
 	virtual void TimeStepUpdate(const float timeStep);
 
 protected:
@@ -65,6 +76,7 @@ private:
 	SceneGraph::Model *m_model;
 	std::vector<Geom*> m_dynGeoms;
 	SceneGraph::Animation *m_idleAnimation;
+	bool m_animationsDirty; //node transforms are behind the animation progress
 	std::unique_ptr<Shields> m_shields;
 };
 
@@ -5,8 +5,54 @@
 #include "scenegraph/SceneGraph.h"
 #include "Shields.h"
 
-ModelCache::ModelCache(Graphics::Renderer *r)
+class ModelCache::LoadJob : public Job {
+public:
+	LoadJob(ModelCache *cache, const std::string &name)
+		: m_cache(cache), m_name(name), m_found(false) { SetLane(LANE_IO); }
+
+	// file search, read, decompression and .model parsing
+	virtual void OnRun() override {
+		try {
+			m_found = SceneGraph::Loader::ReadModel(m_name, "models", true, m_source);
+		} catch (SceneGraph::LoadingError &) {
+			m_found = false;
+		}
+	}
+
+	virtual void OnFinish() override {
+		m_cache->m_loading.erase(m_name);
+		// FindModel got there first
+		if (m_cache->m_models.count(m_name))
+			return;
+		if (!m_found) {
+			Output("ModelCache: could not find model %s\n", m_name.c_str());
+			return;
+		}
+		try {
+			SceneGraph::Loader loader(m_cache->m_renderer);
+			SceneGraph::Model *m = loader.LoadModel(m_source);
+			if (m) {
+				Shields::ReparentShieldNodes(m);
+				m_cache->AddModel(m_name, m);
+			}
+		} catch (SceneGraph::LoadingError &) {
+			Output("ModelCache: could not load model %s\n", m_name.c_str());
+		}
+	}
+
+	virtual const char *GetName() const override { return "ModelCache::LoadJob"; }
+
+private:
+	ModelCache *m_cache;
+	std::string m_name;
+	bool m_found;
+	SceneGraph::Loader::ModelSource m_source;
+};
+
+ModelCache::ModelCache(Graphics::Renderer *r, JobQueue *jobs)
 : m_renderer(r)
+, m_jobs(jobs)
+, m_bytes(0)
 {
 
 }
@@ -25,7 +71,7 @@ SceneGraph::Model *ModelCache::FindModel(const std::string &name)
 			SceneGraph::Loader loader(m_renderer);
 			SceneGraph::Model *m = loader.LoadModel(name);
 			Shields::ReparentShieldNodes(m);
-			m_models[name] = m;
+			AddModel(name, m);
 			return m;
 		} catch (SceneGraph::LoadingError &) {
 			throw ModelNotFoundException();
@@ -34,10 +80,40 @@ SceneGraph::Model *ModelCache::FindModel(const std::string &name)
 	return it->second;
 }
 
+void ModelCache::RequestModel(const std::string &name)
+{
+	if (name.empty() || m_models.count(name) || m_loading.count(name))
+		return;
+
+	m_loading.insert(name);
+	m_jobs.Order(new LoadJob(this, name));
+}
+
+void ModelCache::Preload(const std::vector<std::string> &names)
+{
+	PROFILE_SCOPED()
+	for (const std::string &name : names)
+		RequestModel(name);
+}
+
+SceneGraph::Model *ModelCache::GetLoadedModel(const std::string &name) const
+{
+	ModelMap::const_iterator it = m_models.find(name);
+	return (it != m_models.end()) ? it->second : nullptr;
+}
+
+void ModelCache::AddModel(const std::string &name, SceneGraph::Model *m)
+{
+	const SceneGraph::Model::MemoryUsage usage = m->GetMemoryUsage();
+	m_bytes += usage.geometry + usage.collision + usage.instanceBytes;
+	m_models[name] = m;
+}
+
 void ModelCache::Flush()
 {
 	for(ModelMap::iterator it = m_models.begin(); it != m_models.end(); ++it) {
 		delete it->second;
 	}
 	m_models.clear();
+	m_bytes = 0;
 }
@@ -6,8 +6,13 @@
 /*
  * This class is a quick thoughtless hack
  * Also it only deals in New Models
+ *
+ * Models can also be requested ahead of time. The files are found, read,
+ * decompressed and parsed on the job runners, and the model (buffers,
+ * textures, materials) is created on the main thread when the job finishes.
  */
 #include "libs.h"
+#include "JobQueue.h"
 #include <stdexcept>
 
 namespace Graphics { class Renderer; }
@@ -18,15 +23,36 @@ public:
 	struct ModelNotFoundException : public std::runtime_error {
 		ModelNotFoundException() : std::runtime_error("Could not find model") { }
 	};
-	ModelCache(Graphics::Renderer*);
+	ModelCache(Graphics::Renderer*, JobQueue *jobs);
 	~ModelCache();
+	// loads the model now if it isn't cached yet, even if it has been requested
 	SceneGraph::Model *FindModel(const std::string&);
+	// starts loading the model in the background. does nothing if it is
+	// already cached or on its way
+	void RequestModel(const std::string&);
+	void Preload(const std::vector<std::string> &names);
+	// the model if it has finished loading, otherwise nullptr. doesn't load anything
+	SceneGraph::Model *GetLoadedModel(const std::string&) const;
+	bool IsLoading(const std::string &name) const { return m_loading.count(name) > 0; }
 	void Flush();
 
+	// geometry, collision meshes and animations of the cached models, worked
+	// out as each is loaded. textures are in the renderer's texture cache
+	size_t GetMemoryUsage() const { return m_bytes; }
+	Uint32 GetNumModels() const { return m_models.size(); }
+
 private:
+	class LoadJob;
+	friend class LoadJob;
+
+	void AddModel(const std::string &name, SceneGraph::Model *m);
+
 	typedef std::map<std::string, SceneGraph::Model*> ModelMap;
 	ModelMap m_models;
 	Graphics::Renderer *m_renderer;
+	std::set<std::string> m_loading;
+	JobSet m_jobs;
+	size_t m_bytes;
 };
 
 #endif
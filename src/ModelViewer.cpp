@@ -807,8 +807,13 @@ void ModelViewer::SaveModelToBinary()
 
 	std::unique_ptr<SceneGraph::Model> model;
 	try {
-		SceneGraph::Loader ld(m_renderer);
+		//from the source meshes, not an older .sgm, so they can be optimised
+		SceneGraph::Loader ld(m_renderer, false, false);
+		ld.SetOptimiseMeshes(true);
 		model.reset(ld.LoadModel(m_modelName));
+		const SceneGraph::MeshOptimiser::Stats &stats = ld.GetMeshStats();
+		AddLog(stringf("Meshes: %0{u} -> %1{u} vertices, ACMR %2{f.3} -> %3{f.3}",
+			stats.verticesIn, stats.verticesOut, stats.GetACMRIn(), stats.GetACMROut()));
 	} catch (...) {
 		//minimal error handling, this is not expected to happen since we got this far.
 		AddLog("Could not load model");
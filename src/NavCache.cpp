@@ -0,0 +1,105 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "NavCache.h"
+#include "Body.h"
+#include "Frame.h"
+#include <algorithm>
+
+const double NavCache::NEAREST_REFRESH = 2.0;
+
+NavCache::NavCache()
+	: m_root(nullptr)
+	, m_time(0.0)
+{
+}
+
+void NavCache::AddBody(Body *b)
+{
+	for (int t = 0; t < NUM_TYPES; t++)
+		if (b->IsType(Object::Type(t)))
+			m_bodiesByType[t].push_back(b);
+}
+
+void NavCache::RemoveBody(Body *b)
+{
+	for (int t = 0; t < NUM_TYPES; t++) {
+		std::vector<Body*> &bodies = m_bodiesByType[t];
+		auto i = std::find(bodies.begin(), bodies.end(), b);
+		if (i != bodies.end()) {
+			*i = bodies.back();
+			bodies.pop_back();
+		}
+	}
+
+	// forget anything asked by it or answered with it
+	for (auto i = m_nearest.begin(); i != m_nearest.end(); ) {
+		if (i->first.first == b || i->second.body == b)
+			i = m_nearest.erase(i);
+		else
+			++i;
+	}
+}
+
+void NavCache::Update(const Frame *root, double time)
+{
+	PROFILE_SCOPED()
+	m_time = time;
+
+	// frames don't change once the space is built
+	if (root != m_root) {
+		m_approach.clear();
+		m_root = root;
+		if (root)
+			AddApproach(root);
+	}
+}
+
+void NavCache::AddApproach(const Frame *frame)
+{
+	if (frame->GetNonRotFrame() == frame) {
+		ApproachChain &chain = m_approach[frame];
+		Body *body = nullptr;
+		for (const Frame *f = frame; f; f = f->GetParent() ? f->GetParent()->GetNonRotFrame() : nullptr) {
+			if (f->GetBody()) body = f->GetBody();
+			ApproachStep step = { f, body };
+			chain.push_back(step);
+		}
+	}
+	for (const Frame *child : frame->GetChildren())
+		AddApproach(child);
+}
+
+const NavCache::ApproachChain *NavCache::GetApproach(const Frame *frame) const
+{
+	auto i = m_approach.find(frame->GetNonRotFrame());
+	return i != m_approach.end() ? &i->second : nullptr;
+}
+
+Body *NavCache::FindNearestTo(const Body *b, Object::Type t) const
+{
+	Body *nearest = nullptr;
+	double dist = FLT_MAX;
+	for (Body *other : m_bodiesByType[t]) {
+		if (other->IsDead()) continue;
+		double d = other->GetPositionRelTo(b).Length();
+		if (d < dist) {
+			dist = d;
+			nearest = other;
+		}
+	}
+	return nearest;
+}
+
+Body *NavCache::FindNearestToCached(const Body *b, Object::Type t)
+{
+	const std::pair<const Body*,int> key(b, int(t));
+	auto i = m_nearest.find(key);
+	if (i != m_nearest.end() && m_time - i->second.time < NEAREST_REFRESH)
+		return i->second.body;
+
+	Nearest &n = m_nearest[key];
+	n.body = FindNearestTo(b, t);
+	n.time = m_time;
+	return n.body;
+}
@@ -0,0 +1,78 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _NAVCACHE_H
+#define _NAVCACHE_H
+
+#include "libs.h"
+#include "Object.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+class Body;
+class Frame;
+
+/*
+ * Navigation queries shared by everything in a space, so the answers are
+ * worked out once rather than by each ship that asks:
+ *
+ *  - the bodies of each object type, for FindNearestTo and the sensors
+ *  - nearest body lookups, remembered for a little while
+ *  - for each non-rotating frame, the chain of frames (and the body that
+ *    would be in the way in each) from it out to the root, which is what
+ *    the autopilot steps down to keep clear of planets on the way
+ *
+ * Update runs on the main thread at the start of the space's timestep.
+ * Between updates GetApproach only reads, so the AI on the job runners can
+ * use it.
+ */
+class NavCache {
+public:
+	NavCache();
+
+	void AddBody(Body *b);
+	void RemoveBody(Body *b);
+
+	void Update(const Frame *root, double time);
+
+	// everything that IsType(t)
+	const std::vector<Body*> &GetBodies(Object::Type t) const { return m_bodiesByType[t]; }
+
+	// exact, over the bodies of that type only
+	Body *FindNearestTo(const Body *b, Object::Type t) const;
+	// as FindNearestTo, but the answer may be up to NEAREST_REFRESH seconds
+	// old. main thread only
+	Body *FindNearestToCached(const Body *b, Object::Type t);
+
+	struct ApproachStep {
+		const Frame *frame;
+		Body *body; // innermost frame body from the start of the chain to here
+	};
+	typedef std::vector<ApproachStep> ApproachChain;
+	// null for frames the cache hasn't seen yet
+	const ApproachChain *GetApproach(const Frame *frame) const;
+
+	static const double NEAREST_REFRESH;
+
+private:
+	NavCache(const NavCache &);
+	NavCache &operator=(const NavCache &);
+
+	void AddApproach(const Frame *frame);
+
+	static const int NUM_TYPES = Object::HYPERSPACECLOUD + 1;
+	std::vector<Body*> m_bodiesByType[NUM_TYPES];
+
+	struct Nearest {
+		Body *body;
+		double time;
+	};
+	std::map<std::pair<const Body*,int>,Nearest> m_nearest;
+
+	std::unordered_map<const Frame*,ApproachChain> m_approach;
+	const Frame *m_root;
+	double m_time;
+};
+
+#endif
@@ -144,7 +144,7 @@ void NavLights::SaveToJson(Json::Value &jsonObj)
 void NavLights::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("nav_lights")) throw SavedGameCorruptException();
-	Json::Value navLightsObj = jsonObj["nav_lights"];
+	const Json::Value &navLightsObj = jsonObj["nav_lights"];
 
 	if (!navLightsObj.isMember("time")) throw SavedGameCorruptException();
 	if (!navLightsObj.isMember("enabled")) throw SavedGameCorruptException();
@@ -153,7 +153,7 @@ void NavLights::LoadFromJson(const Json::Value &jsonObj)
 	m_time = StrToFloat(navLightsObj["time"].asString());
 	m_enabled = navLightsObj["enabled"].asBool();
 
-	Json::Value lightsArray = navLightsObj["lights"];
+	const Json::Value &lightsArray = navLightsObj["lights"];
 	if (!lightsArray.isArray()) throw SavedGameCorruptException();
 	RefCountedPtr<Graphics::Material> mat;
 	assert(m_lights.size() == lightsArray.size());
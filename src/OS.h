@@ -31,6 +31,9 @@ namespace OS {
 	// http://stackoverflow.com/questions/150355/programmatically-find-the-number-of-cores-on-a-machine
 	int GetNumCores();
 
+	// the most memory the process has had resident, in bytes. 0 if unknown
+	size_t GetPeakMemoryUsage();
+
 	// return a string describing the operating system that the game is running on, useful!
 	const std::string GetOSInfoString();
 
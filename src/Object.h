@@ -23,7 +23,6 @@ public:
 		STAR,
 		CARGOBODY,
 		CITYONPLANET,   // <enum skip>
-		PROJECTILE,     // <enum skip>
 		MISSILE,
 		HYPERSPACECLOUD // <enum skip>
 	};
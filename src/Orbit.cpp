@@ -53,22 +53,46 @@ static double calc_velocity_area_per_sec_gravpoint(double semiMajorAxis, double
 	return M_PI * a2 * sqrt((eccentricity < 1.0) ? (1 - e2) : (e2 - 1.0)) / calc_orbital_period_gravpoint(semiMajorAxis, totalMass, bodyMass);
 }
 
-static void calc_position_from_mean_anomaly(const double M, const double e, const double a, double &cos_v, double &sin_v, double *r) {
+// newton steps smaller than this are taken as converged, when starting from
+// an earlier solution
+static const double ANOMALY_TOLERANCE = 1e-12;
+// above this five steps from a cold start don't quite converge, so starting
+// closer would put the body somewhere slightly different to where the rest
+// of the game (orbit lines, system view) has it
+static const double WARM_START_MAX_ECCENTRICITY = 0.75;
+
+static void calc_position_from_mean_anomaly(const double M, const double e, const double a, double &cos_v, double &sin_v, double *r, double *anomaly = 0) {
 	// M is mean anomaly
 	// e is eccentricity
 	// a is semi-major axis
+	// anomaly, if given, is the eccentric anomaly of a nearby solution to
+	// start from, NaN if there isn't one. it's set to this solution
 
 	cos_v = 0.0;
 	sin_v = 0.0;
 	if (r) { *r = 0.0; }
 
+	const bool warm = anomaly && !std::isnan(*anomaly) && e < WARM_START_MAX_ECCENTRICITY;
+
 	if (e < 1.0) { // elliptic orbit
 		// eccentric anomaly
 		// NR method to solve for E: M = E-sin(E)
 		double E = M;
-		for (int iter=5; iter > 0; --iter) {
-			E = E - (E-e*(sin(E))-M) / (1.0 - e*cos(E));
+		if (warm) {
+			// the earlier solution had M' = E'-e*sin(E'), so this is E' moved
+			// along by the change in M
+			E = M + e*sin(*anomaly);
+			for (int iter=5; iter > 0; --iter) {
+				const double step = (E-e*(sin(E))-M) / (1.0 - e*cos(E));
+				E -= step;
+				if (fabs(step) < ANOMALY_TOLERANCE) break;
+			}
+		} else {
+			for (int iter=5; iter > 0; --iter) {
+				E = E - (E-e*(sin(E))-M) / (1.0 - e*cos(E));
+			}
 		}
+		if (anomaly) { *anomaly = E; }
 
 		// true anomaly (angle of orbit position)
 		cos_v = (cos(E) - e) / (1.0 - e*cos(E));
@@ -138,6 +162,13 @@ vector3d Orbit::OrbitalPosAtTime(double t) const
 	return m_orient * vector3d(-cos_v*r, sin_v*r, 0);
 }
 
+vector3d Orbit::OrbitalPosAtTime(double t, double &anomaly) const
+{
+	double cos_v, sin_v, r;
+	calc_position_from_mean_anomaly(MeanAnomalyAtTime(t), m_eccentricity, m_semiMajorAxis, cos_v, sin_v, &r, &anomaly);
+	return m_orient * vector3d(-cos_v*r, sin_v*r, 0);
+}
+
 // used for stepping through the orbit in small fractions
 // mean anomaly <-> true anomaly conversion doesn't have
 // to be taken into account
@@ -32,6 +32,9 @@ public:
 	void SetPhase(double orbitalPhaseAtStart) { m_orbitalPhaseAtStart = orbitalPhaseAtStart; }
 
 	vector3d OrbitalPosAtTime(double t) const;
+	// for following an orbit in steps. anomaly is the solver state from the
+	// last position (NaN for none), and is updated for the next
+	vector3d OrbitalPosAtTime(double t, double &anomaly) const;
 
 	// 0.0 <= t <= 1.0. Not for finding orbital pos
 	vector3d EvenSpacedPosTrajectory(double t) const;
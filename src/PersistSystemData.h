@@ -6,6 +6,7 @@
 
 #include "Serializer.h"
 #include "galaxy/SystemPath.h"
+#include "json/JsonUtils.h"
 #include <map>
 
 template <typename T>
@@ -22,29 +23,37 @@ public:
 	void Set(const SystemPath &path, T val) {
 		m_dict[path.SystemOnly()] = val;
 	}
+	// the dict can get to thousands of entries (every system the player has
+	// explored), so it's packed into one binary blob rather than a JSON object
+	// per entry
 	void ToJson(Json::Value &jsonObj) const {
-		Json::Value dictArray(Json::arrayValue); // Create JSON array to contain dict data.
+		Serializer::Writer wr;
+		wr.Int32(m_dict.size());
 		for (typename std::map<SystemPath, T>::const_iterator i = m_dict.begin(); i != m_dict.end(); ++i)
 		{
-			Json::Value dictArrayEl(Json::objectValue); // Create JSON object to contain dict element.
-			(*i).first.ToJson(dictArrayEl);
-			dictArrayEl["value"] = AutoToStr((*i).second);
-			dictArray.append(dictArrayEl); // Append dict object to array.
+			wr.Int32((*i).first.sectorX);
+			wr.Int32((*i).first.sectorY);
+			wr.Int32((*i).first.sectorZ);
+			wr.Int32((*i).first.systemIndex);
+			wr.Auto((*i).second);
 		}
-		jsonObj["dict"] = dictArray; // Add dict array to supplied object.
+		BinStrToJsonHex(jsonObj, wr.GetData(), "dict");
 	}
 	static void FromJson(const Json::Value &jsonObj, PersistSystemData<T> *pd) {
-		if (!jsonObj.isMember("dict")) throw SavedGameCorruptException();
-		Json::Value dictArray = jsonObj["dict"];
-		if (!dictArray.isArray()) throw SavedGameCorruptException();
-		for (unsigned int arrayIndex = 0; arrayIndex < dictArray.size(); ++arrayIndex)
+		const std::string data = JsonHexToBinStr(jsonObj, "dict");
+		if (data.size() < 4) throw SavedGameCorruptException();
+		Serializer::Reader rd(ByteRange(data.data(), data.data() + data.size()));
+		const Uint32 count = rd.Int32();
+		if (data.size() != 4 + count * (4 * sizeof(Sint32) + sizeof(T))) throw SavedGameCorruptException();
+		for (Uint32 i = 0; i < count; ++i)
 		{
-			Json::Value dictArrayEl = dictArray[arrayIndex];
-			if (!dictArrayEl.isMember("value")) throw SavedGameCorruptException();
-			SystemPath path = SystemPath::FromJson(dictArrayEl);
+			const Sint32 sx = rd.Int32();
+			const Sint32 sy = rd.Int32();
+			const Sint32 sz = rd.Int32();
+			const Sint32 si = rd.Int32();
 			T val;
-			StrToAuto(&val, dictArrayEl["value"].asString());
-			pd->m_dict[path] = val;
+			rd.Auto(&val);
+			pd->m_dict[SystemPath(sx, sy, sz, si)] = val;
 		}
 	}
 private:
@@ -10,12 +10,15 @@
 #include "FaceParts.h"
 #include "Factions.h"
 #include "FileSystem.h"
+#include "FrameTimings.h"
 #include "Frame.h"
 #include "GalacticView.h"
 #include "Game.h"
 #include "BaseSphere.h"
+#include "InputLatency.h"
 #include "Intro.h"
 #include "Lang.h"
+#include "LinearArena.h"
 #include "LuaComms.h"
 #include "LuaConsole.h"
 #include "LuaConstants.h"
@@ -34,7 +37,12 @@
 #include "LuaServerAgent.h"
 #include "LuaShipDef.h"
 #include "LuaSpace.h"
+#include "LuaArrayView.h"
+#include "LuaAsync.h"
+#include "PropertyMap.h"
+#include "LuaBytecodeCache.h"
 #include "LuaTimer.h"
+#include "MemoryReport.h"
 #include "Missile.h"
 #include "ModelCache.h"
 #include "ModManager.h"
@@ -44,10 +52,12 @@
 #include "OS.h"
 #include "Planet.h"
 #include "Player.h"
-#include "Projectile.h"
+#include "ProjectileSystem.h"
+#include "QualityGovernor.h"
 #include "SDLWrappers.h"
 #include "SectorView.h"
 #include "Serializer.h"
+#include "SessionRecording.h"
 #include "Sfx.h"
 #include "ShipCpanel.h"
 #include "ShipType.h"
@@ -67,12 +77,18 @@
 #include "galaxy/CustomSystem.h"
 #include "galaxy/GalaxyGenerator.h"
 #include "galaxy/StarSystem.h"
+#include "gameui/Face.h"
 #include "gameui/Lua.h"
 #include "graphics/opengl/RendererGL.h"
+#include "graphics/dummy/RendererDummy.h"
 #include "graphics/Graphics.h"
 #include "graphics/Light.h"
 #include "graphics/Renderer.h"
+#include "graphics/RenderTargetPool.h"
+#include "graphics/DynamicResolution.h"
 #include "graphics/Stats.h"
+#include "graphics/TextureBuilder.h"
+#include "graphics/TextureStreamer.h"
 #include "gui/Gui.h"
 #include "scenegraph/Model.h"
 #include "scenegraph/Lua.h"
@@ -97,6 +113,7 @@ int Pi::keyModState;
 std::map<SDL_Keycode,bool> Pi::keyState; // XXX SDL2 SDLK_LAST
 char Pi::mouseButton[6];
 int Pi::mouseMotion[2];
+int Pi::flightMouseMotion[2];
 bool Pi::doingMouseGrab = false;
 bool Pi::warpAfterMouseGrab = false;
 int Pi::mouseGrabWarpPos[2];
@@ -142,6 +159,11 @@ bool Pi::bRequestEndGame = false;
 Sound::MusicPlayer Pi::musicPlayer;
 std::unique_ptr<AsyncJobQueue> Pi::asyncJobQueue;
 std::unique_ptr<SyncJobQueue> Pi::syncJobQueue;
+std::unique_ptr<Graphics::TextureStreamer> Pi::textureStreamer;
+std::unique_ptr<FrameTimings> Pi::frameTimings;
+std::unique_ptr<InputLatency> Pi::inputLatency;
+std::unique_ptr<QualityGovernor> Pi::qualityGovernor;
+std::unique_ptr<Graphics::DynamicResolution> Pi::dynamicResolution;
 
 // Leaving define in place in case of future rendering problems.
 #define USE_RTT 0
@@ -150,6 +172,7 @@ std::unique_ptr<SyncJobQueue> Pi::syncJobQueue;
 void Pi::CreateRenderTarget(const Uint16 width, const Uint16 height) {
 	/*	@fluffyfreak here's a rendertarget implementation you can use for oculusing and other things. It's pretty simple:
 		 - fill out a RenderTargetDesc struct and call Renderer::CreateRenderTarget
+		   (or acquire one from Renderer::GetRenderTargetPool if it's only needed for a pass)
 		 - pass target to Renderer::SetRenderTarget to start rendering to texture
 		 - set up viewport, clear etc, then draw as usual
 		 - SetRenderTarget(0) to resume render to screen
@@ -182,7 +205,7 @@ void Pi::CreateRenderTarget(const Uint16 width, const Uint16 height) {
 		Graphics::TEXTURE_NONE,		// don't create a texture
 		Graphics::TEXTURE_DEPTH,
 		false);
-	Pi::renderTarget = Pi::renderer->CreateRenderTarget(rtDesc);
+	Pi::renderTarget = Pi::renderer->GetRenderTargetPool().Acquire(rtDesc);
 
 	Pi::renderTarget->SetColorTexture(Pi::renderTexture.Get());
 #endif
@@ -243,6 +266,39 @@ static void draw_progress(UI::Gauge *gauge, UI::Label *label, float progress)
 	Pi::renderer->SwapBuffers();
 }
 
+// a piece of startup that can be done off the main thread: no GL, and
+// nothing shared with the main Lua state. finish runs on the main thread
+class StartupJob : public Job {
+public:
+	StartupJob(const char *name, const std::function<void()> &run, const std::function<void()> &finish = std::function<void()>())
+		: m_name(name), m_run(run), m_finish(finish) {}
+
+	virtual void OnRun() override { m_run(); }
+	virtual void OnFinish() override { if (m_finish) m_finish(); }
+	virtual const char *GetName() const override { return m_name; }
+
+private:
+	const char *m_name;
+	std::function<void()> m_run;
+	std::function<void()> m_finish;
+};
+
+// deliver finished jobs (startup ones, and the model loads they start)
+// until every job in jobs is done, keeping the loading screen alive if
+// there is one yet
+static void wait_for_startup_jobs(JobSet &jobs, UI::Gauge *gauge = nullptr, UI::Label *label = nullptr, float progress = 0.0f)
+{
+	PROFILE_SCOPED()
+	while (!jobs.IsEmpty()) {
+		if (Pi::GetAsyncJobQueue()->FinishJobs())
+			continue;
+		if (gauge)
+			draw_progress(gauge, label, progress);
+		else
+			SDL_Delay(1);
+	}
+}
+
 static void LuaInit()
 {
 	LuaObject<PropertiedObject>::RegisterClass();
@@ -278,9 +334,12 @@ static void LuaInit()
 	LuaComms::Register();
 	LuaFormat::Register();
 	LuaSpace::Register();
+	LuaArrayView::Register();
 	LuaShipDef::Register();
 	LuaMusic::Register();
 	LuaDev::Register();
+	LuaEvent::Register();
+	LuaAsync::Register();
 	LuaConsole::Register();
 
 	// XXX sigh
@@ -336,8 +395,29 @@ std::string Pi::GetSaveDir()
 	return FileSystem::JoinPath(FileSystem::GetUserDir(), Pi::SAVE_DIR_NAME);
 }
 
-void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
+#ifdef PIONEER_PROFILER
+// next to the HTML the profiler writes, named the same way
+static void DumpLuaProfile()
+{
+	char stamp[32];
+	const time_t now = time(0);
+	strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+
+	const std::string path = FileSystem::JoinPath("profiler", std::string("lua-profile-") + stamp + ".txt");
+	FILE *f = FileSystem::userFiles.OpenWriteStream(path, FileSystem::FileSourceFS::WRITE_TEXT);
+	if (!f) {
+		Output("Could not write Lua profile '%s'\n", path.c_str());
+		return;
+	}
+	fputs(Lua::manager->DumpProfile().c_str(), f);
+	fclose(f);
+}
+#endif
+
+void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui, bool headless)
 {
+	if (headless) no_gui = true;
+
 #ifdef PIONEER_PROFILER
 	Profiler::reset();
 #endif
@@ -380,8 +460,8 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 	Pi::detail.fracmult = config->Int("FractalMultiple");
 	Pi::detail.cities = config->Int("DetailCities");
 
-	// Initialize SDL
-	Uint32 sdlInitFlags = SDL_INIT_VIDEO | SDL_INIT_JOYSTICK;
+	// Initialize SDL. without a window there's no video or input to set up
+	Uint32 sdlInitFlags = headless ? 0 : (SDL_INIT_VIDEO | SDL_INIT_JOYSTICK);
 #if defined(DEBUG) || defined(_DEBUG)
 	sdlInitFlags |= SDL_INIT_NOPARACHUTE;
 #endif
@@ -393,10 +473,11 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 	Output("SDL Version %d.%d.%d\n", ver.major, ver.minor, ver.patch);
 
 	Graphics::RendererOGL::RegisterRenderer();
+	Graphics::RendererDummy::RegisterRenderer();
 
 	// Do rest of SDL video initialization and create Renderer
 	Graphics::Settings videoSettings = {};
-	videoSettings.rendererType = Graphics::RENDERER_OPENGL;
+	videoSettings.rendererType = headless ? Graphics::RENDERER_DUMMY : Graphics::RENDERER_OPENGL;
 	videoSettings.width = config->Int("ScrWidth");
 	videoSettings.height = config->Int("ScrHeight");
 	videoSettings.fullscreen = (config->Int("StartFullscreen") != 0);
@@ -405,6 +486,7 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 	videoSettings.vsync = (config->Int("VSync") != 0);
 	videoSettings.useTextureCompression = (config->Int("UseTextureCompression") != 0);
 	videoSettings.enableDebugMessages = (config->Int("EnableGLDebug") != 0);
+	videoSettings.useShaderCache = (config->Int("ShaderCache") != 0);
 	videoSettings.iconFile = OS::GetIconFilename();
 	videoSettings.title = "Pioneer";
 
@@ -414,7 +496,8 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 	Pi::rng.IncRefCount(); // so nothing tries to free it
 	Pi::rng.seed(time(0));
 
-	InitJoysticks();
+	if (!headless)
+		InitJoysticks();
 	
 	// we can only do bindings once joysticks are initialised.
 	if (!no_gui) // This re-saves the config file. With no GUI we want to allow multiple instances in parallel.
@@ -435,13 +518,88 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 	const int numCores = OS::GetNumCores();
 	assert(numCores > 0);
 	if (numThreads == 0) numThreads = std::max(Uint32(numCores) - 1, 1U);
-	asyncJobQueue.reset(new AsyncJobQueue(numThreads));
-	Output("started %d worker threads\n", numThreads);
+	// runners kept for one kind of work, so eg. a galaxy map full of
+	// sectors can't hold up the terrain under a landing. -1 sizes them
+	// from the number of threads: a third for terrain, one for file loads
+	// once there are enough to go round
+	Uint32 reserved[Job::LANE_COUNT] = { 0 };
+	const int terrainThreads = config->Int("TerrainWorkerThreads");
+	const int galaxyThreads = config->Int("GalaxyWorkerThreads");
+	const int ioThreads = config->Int("IOWorkerThreads");
+	reserved[Job::LANE_TERRAIN] = terrainThreads < 0 ? (numThreads >= 3 ? numThreads / 3 : 0) : Uint32(terrainThreads);
+	reserved[Job::LANE_GALAXY] = galaxyThreads < 0 ? 0 : Uint32(galaxyThreads);
+	reserved[Job::LANE_IO] = ioThreads < 0 ? (numThreads >= 4 ? 1 : 0) : Uint32(ioThreads);
+	asyncJobQueue.reset(new AsyncJobQueue(numThreads, reserved));
+	Output("started %d worker threads (%d terrain, %d galaxy, %d io reserved)\n", numThreads,
+		reserved[Job::LANE_TERRAIN], reserved[Job::LANE_GALAXY], reserved[Job::LANE_IO]);
 	syncJobQueue.reset(new SyncJobQueue);
-	
-	Output("ShipType::Init()\n");
+
+	// main loop phase timings, for the percentiles and hitch log
+	frameTimings.reset(new FrameTimings(std::max(config->Int("FrameTimingFrames"), 1), config->Float("FrameHitchMs") * 0.001));
+	inputLatency.reset(new InputLatency);
+	if (config->Int("QualityGovernor") && config->Float("QualityGovernorFps") > 0.0f)
+		qualityGovernor.reset(new QualityGovernor(1.0 / config->Float("QualityGovernorFps"), config->Int("QualityGovernorMaxSteps")));
+	// the world view's scene gets most of the frame, the ui and the rest
+	// of the frame what's left
+	if (config->Int("DynamicResolution") && config->Float("DynamicResolutionFps") > 0.0f)
+		dynamicResolution.reset(new Graphics::DynamicResolution(Pi::renderer, 0.75 / config->Float("DynamicResolutionFps"), config->Float("DynamicResolutionMinScale")));
+
+	// textures. budgets are per cache type, 0 for no limit
+	if (config->Int("TextureStreaming")) {
+		textureStreamer.reset(new Graphics::TextureStreamer(Pi::renderer, asyncJobQueue.get()));
+		Pi::renderer->SetTextureStreamer(textureStreamer.get());
+	}
+	Graphics::TextureBuilder::SetMaxTextureSize(config->Int("TextureMaxSize"));
+	static const char *textureCacheTypes[][2] = {
+		{ "model", "ModelTextureBudgetMB" },
+		{ "decal", "DecalTextureBudgetMB" },
+		{ "billboard", "BillboardTextureBudgetMB" },
+	};
+	for (auto &t : textureCacheTypes) {
+		const int budgetMB = config->Int(t[1]);
+		if (budgetMB > 0)
+			Pi::renderer->SetTextureCacheBudget(t[0], size_t(budgetMB) << 20);
+	}
+
+	// everything that doesn't need the main thread goes on the job runners
+	// now, and is waited for where it was needed before. the ship and
+	// station definitions, the galaxy (density map, factions and custom
+	// systems) and the face images all come in while the main thread gets
+	// Lua and the ui going
+	LuaBytecodeCache::Init(); // before any Lua is loaded, here or on a job
+
+	Output("Shields::Init\n");
+	Shields::Init(Pi::renderer);
+	Output("new ModelCache\n");
+	modelCache = new ModelCache(Pi::renderer, asyncJobQueue.get());
+
+	JobSet shipTypeJobs(asyncJobQueue.get());
+	ShipType::Init(shipTypeJobs);
+
+	JobSet startupJobs(asyncJobQueue.get());
+	const bool defaultGenerator = !config->HasEntry("GalaxyGenerator");
+	const std::string generatorName = config->String("GalaxyGenerator");
+	const int generatorVersion = config->Int("GalaxyGeneratorVersion", GalaxyGenerator::LAST_VERSION);
+	startupJobs.Order(new StartupJob("GalaxyGenerator::Init", [=] {
+		if (defaultGenerator)
+			GalaxyGenerator::Init();
+		else
+			GalaxyGenerator::Init(generatorName, generatorVersion);
+	}));
+	startupJobs.Order(new StartupJob("FaceParts::Init", [] { FaceParts::Init(); }));
+	Job *stationDefs = SpaceStationType::LoadDefinitions(startupJobs);
+	if (stationDefs) {
+		startupJobs.OrderAfter(new StartupJob("SpaceStationType models", [] {}, [] {
+			// so the models are ready by the time SpaceStation::Init wants them
+			std::vector<std::string> names;
+			SpaceStationType::GetModelNames(names);
+			Pi::modelCache->Preload(names);
+		}), std::vector<Job*>(1, stationDefs));
+	}
+
 	// XXX early, Lua init needs it
-	ShipType::Init();
+	Output("ShipType::Init()\n");
+	wait_for_startup_jobs(shipTypeJobs);
 
 	// XXX UI requires Lua  but Pi::ui must exist before we start loading
 	// templates. so now we have crap everywhere :/
@@ -455,7 +613,7 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 		const std::string endpoint(config->String("ServerEndpoint"));
 		if (endpoint.size() > 0) {
 			Output("Server agent enabled, endpoint: %s\n", endpoint.c_str());
-			Pi::serverAgent = new HTTPServerAgent(endpoint);
+			Pi::serverAgent = new HTTPServerAgent(endpoint, config->Int("ServerAgentMaxRequests"), config->Int("ServerAgentTimeoutMs"));
 		}
 	}
 	if (!Pi::serverAgent) {
@@ -463,6 +621,8 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 		Pi::serverAgent = new NullServerAgent();
 	}
 
+	// has to be decided before the classes are registered
+	LuaObjectBase::EnableCallCounting(config->Int("LuaApiCallCounts") != 0);
 	LuaInit();
 
 	// Gui::Init shouldn't initialise any VBOs, since we haven't tested
@@ -488,25 +648,8 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 
 	draw_progress(gauge, label, 0.0f);
 
-	Output("GalaxyGenerator::Init()\n");
-	if (config->HasEntry("GalaxyGenerator"))
-		GalaxyGenerator::Init(config->String("GalaxyGenerator"),
-			config->Int("GalaxyGeneratorVersion", GalaxyGenerator::LAST_VERSION));
-	else
-		GalaxyGenerator::Init();
-
-	draw_progress(gauge, label, 0.1f);
-
-	Output("FaceParts::Init()\n");
-	FaceParts::Init();
-	draw_progress(gauge, label, 0.2f);
-
-	Output("new ModelCache\n");
-	modelCache = new ModelCache(Pi::renderer);
-	draw_progress(gauge, label, 0.3f);
-
-	Output("Shields::Init\n");
-	Shields::Init(Pi::renderer);
+	Output("GalaxyGenerator::Init(), FaceParts::Init(), SpaceStationType::LoadDefinitions()\n");
+	wait_for_startup_jobs(startupJobs, gauge, label, 0.2f);
 	draw_progress(gauge, label, 0.4f);
 
 //unsigned int control_word;
@@ -676,7 +819,10 @@ bool Pi::IsConsoleActive()
 
 void Pi::Quit()
 {
-	Projectile::FreeModel();
+	// a save that's still being written would be lost
+	Game::WaitForSaves();
+	ProjectileSystem::FreeModel();
+	Ship::ClearPrototypes();
 	delete Pi::intro;
 	delete Pi::luaConsole;
 	NavLights::Uninit();
@@ -685,12 +831,18 @@ void Pi::Quit()
 	Sound::Uninit();
 	CityOnPlanet::Uninit();
 	BaseSphere::Uninit();
+	Planet::Uninit();
+	Star::Uninit();
 	FaceParts::Uninit();
+	GameUI::Face::ClearCache();
 	Graphics::Uninit();
 	Pi::ui.Reset(0);
 	LuaUninit();
 	Gui::Uninit();
 	delete Pi::modelCache;
+	Pi::renderer->SetTextureStreamer(nullptr);
+	textureStreamer.reset();
+	dynamicResolution.reset();
 	delete Pi::renderer;
 	delete Pi::config;
 	GalaxyGenerator::Uninit();
@@ -735,13 +887,19 @@ void Pi::HandleEvents()
 	bool skipTextInput = false;
 
 	Pi::mouseMotion[0] = Pi::mouseMotion[1] = 0;
-	while (SDL_PollEvent(&event)) {
+	while (SessionRecording::PollEvent(&event)) {
 		if (event.type == SDL_QUIT) {
 			if (Pi::game)
 				Pi::EndGame();
 			Pi::Quit();
 		}
 
+		// the flight controls see all of it, even what the ui takes
+		if (event.type == SDL_MOUSEMOTION) {
+			Pi::flightMouseMotion[0] += event.motion.xrel;
+			Pi::flightMouseMotion[1] += event.motion.yrel;
+		}
+
 		if (skipTextInput && event.type == SDL_TEXTINPUT) {
 			skipTextInput = false;
 			continue;
@@ -763,6 +921,8 @@ void Pi::HandleEvents()
 			continue;
 
 		Gui::HandleSDLEvent(&event);
+		if (Pi::game)
+			inputLatency->OnEvent(event);
 
 		switch (event.type) {
 			case SDL_KEYDOWN:
@@ -804,14 +964,37 @@ void Pi::HandleEvents()
 							write_screenshot(sd, buf);
 							break;
 						}
+						case SDLK_r: // record the session, to play back with -replay
+							if (Pi::game)
+								SessionRecording::ToggleRecording();
+							break;
 #if WITH_DEVKEYS
 						case SDLK_i: // Toggle Debug info
 							Pi::showDebugInfo = !Pi::showDebugInfo;
 							break;
 
+						case SDLK_t: // frame timing percentiles, input latency and memory use
+							Output("frame timings:\n%s", frameTimings->DumpPercentiles().c_str());
+							Output("input latency:\n%s", inputLatency->DumpHistograms().c_str());
+							Output("memory:\n%s", MemoryReport::Dump().c_str());
+							break;
+
+						case SDLK_b: // capture the next frame and benchmark drawing it
+							Pi::renderer->CaptureFrame(std::max(config->Int("FrameCaptureReplays"), 1));
+							break;
+
 #ifdef PIONEER_PROFILER
 						case SDLK_p: // alert it that we want to profile
-							if (KeyState(SDLK_LSHIFT) || KeyState(SDLK_RSHIFT))
+							if (KeyState(SDLK_LALT) || KeyState(SDLK_RALT)) {
+								// timeline of everything until pressed again
+								if (Profiler::tracing()) {
+									Profiler::dumptrace(profilerPath.c_str());
+									Output("trace written to %s\n", profilerPath.c_str());
+								} else {
+									Profiler::tracestart();
+									Output("trace recording started\n");
+								}
+							} else if (KeyState(SDLK_LSHIFT) || KeyState(SDLK_RSHIFT))
 								Pi::doProfileOne = true;
 							else {
 								Pi::doProfileSlow = !Pi::doProfileSlow;
@@ -1076,6 +1259,7 @@ void Pi::Start()
 		intro->Draw(_time);
 		Pi::renderer->EndFrame();
 
+		PropertyMap::SendPendingSignals();
 		ui->Update();
 		ui->Draw();
 		Pi::EndRenderTarget();
@@ -1112,17 +1296,32 @@ void Pi::EndGame()
 	// always reset this, otherwise we can never play again
 	Pi::bRequestEndGame = false;
 
+	SessionRecording::Stop();
 	Pi::SetMouseGrab(false);
 
 	Pi::musicPlayer.Stop();
 	Sound::DestroyAllEvents();
 
+	// leave a summary in the log to go with any hitches in it
+	if (frameTimings->GetNumFrames()) {
+		Output("frame timings:\n%s", frameTimings->DumpPercentiles().c_str());
+		frameTimings->Clear();
+		Output("memory:\n%s", MemoryReport::Dump().c_str());
+	}
+	if (inputLatency->GetNumSamples())
+		Output("input latency:\n%s", inputLatency->DumpHistograms().c_str());
+	inputLatency->Clear();
+
 	// final event
 	LuaEvent::Queue("onGameEnd");
 	LuaEvent::Emit();
 
 	luaTimer->RemoveAll();
+	LuaAsync::Clear();
 
+	// back to collecting whenever Lua likes, since nothing outside the game
+	// loop steps it
+	Lua::manager->SetGarbageBudget(0.0);
 	Lua::manager->CollectGarbage();
 
 	if (!config->Int("DisableSound")) AmbientSounds::Uninit();
@@ -1150,20 +1349,36 @@ void Pi::MainLoop()
 	memset(fps_readout, 0, sizeof(fps_readout));
 #endif
 
+	// completed jobs left over for the next frame
+	Uint32 asyncJobsDeferred = 0;
+	Uint32 syncJobsDeferred = 0;
+
 	int MAX_PHYSICS_TICKS = Pi::config->Int("MaxPhysicsCyclesPerRender");
 	if (MAX_PHYSICS_TICKS <= 0)
 		MAX_PHYSICS_TICKS = 4;
 
+	// Lua garbage collection happens in a fixed slice at the end of each
+	// frame instead of in the middle of whatever script allocates
+	Lua::manager->SetGarbageBudget(Pi::config->Float("LuaGCBudgetMs") * 0.001);
+
 	double currentTime = 0.001 * double(SDL_GetTicks());
 	double accumulator = Pi::game->GetTimeStep();
 	Pi::gameTickAlpha = 0;
 
+	FrameTimings *timings = frameTimings.get();
+	// each game starts at full detail
+	if (qualityGovernor)
+		qualityGovernor->Reset();
+
 	while (Pi::game) {
 		PROFILE_SCOPED()
 
 #ifdef PIONEER_PROFILER
 		Profiler::reset();
 #endif
+		PROFILE_FRAME()
+
+		timings->BeginFrame();
 
 		Pi::serverAgent->ProcessResponses();
 
@@ -1172,8 +1387,16 @@ void Pi::MainLoop()
 		Pi::frameTime = newTime - currentTime;
 		if (Pi::frameTime > 0.25) Pi::frameTime = 0.25;
 		currentTime = newTime;
+		// a recording keeps the frame time, a replay hands back the kept one
+		if (SessionRecording::BeginFrame(Pi::frameTime))
+			accumulator = Pi::game->GetTimeStep();
 		accumulator += Pi::frameTime * Pi::game->GetTimeAccelRate();
 
+		timings->Lap(FrameTimings::PHASE_OTHER);
+		// Lua events and timers run from inside the physics step
+		const Space *stepSpace = game->GetSpace();
+		const Space::StepTimes stepTimes = stepSpace->GetStepTimes();
+
 		const float step = Pi::game->GetTimeStep();
 		if (step > 0.0f) {
 			PROFILE_SCOPED_RAW("unpaused")
@@ -1193,6 +1416,7 @@ void Pi::MainLoop()
 			if (pstate == Ship::DOCKED || pstate == Ship::DOCKING) Pi::gameTickAlpha = 1.0;
 			else Pi::gameTickAlpha = accumulator / step;
 
+			timings->SetPhysicsTicks(phys_ticks);
 #if WITH_DEVKEYS
 			phys_stat += phys_ticks;
 #endif
@@ -1203,6 +1427,14 @@ void Pi::MainLoop()
 		}
 		frame_stat++;
 
+		timings->Lap(FrameTimings::PHASE_PHYSICS);
+		// hyperspace swaps the space out, leaving nothing to compare with
+		if (game->GetSpace() == stepSpace) {
+			const Space::StepTimes &t = stepSpace->GetStepTimes();
+			timings->Move(FrameTimings::PHASE_PHYSICS, FrameTimings::PHASE_LUA,
+				(t.luaEvents - stepTimes.luaEvents) + (t.luaTimers - stepTimes.luaTimers));
+		}
+
 		// fuckadoodledoo, did the player die?
 		if (Pi::player->IsDead()) {
 			if (time_player_died > 0.0) {
@@ -1225,15 +1457,24 @@ void Pi::MainLoop()
 		Pi::renderer->BeginFrame();
 		Pi::renderer->SetTransform(matrix4x4f::Identity());
 
-		/* Calculate position for this rendered frame (interpolated between two physics ticks */
-        // XXX should this be here? what is this anyway?
-		for (Body* b : game->GetSpace()->GetBodies()) {
-			b->UpdateInterpTransform(Pi::GetGameTickAlpha());
-		}
-		game->GetSpace()->GetRootFrame()->UpdateInterpTransform(Pi::GetGameTickAlpha());
+		// positions for this rendered frame, between the last two physics ticks
+		game->GetSpace()->UpdateInterpTransforms(Pi::GetGameTickAlpha());
 
 		currentView->Update();
-		currentView->Draw3D();
+		BaseSphere::BeginFrame();
+		// only the world view is scaled, the others are mostly ui anyway
+		const bool scaleScene = dynamicResolution && currentView == game->GetWorldView();
+		if (scaleScene) {
+			dynamicResolution->Update();
+			dynamicResolution->Begin();
+		}
+		{
+			Graphics::Renderer::GpuTimerTicket gt(Pi::renderer, Graphics::Stats::GPU_TIMER_SCENE);
+			currentView->Draw3D();
+		}
+		if (scaleScene)
+			dynamicResolution->End();
+		timings->Lap(FrameTimings::PHASE_RENDER);
 		// XXX HandleEvents at the moment must be after view->Draw3D and before
 		// Gui::Draw so that labels drawn to screen can have mouse events correctly
 		// detected. Gui::Draw wipes memory of label positions.
@@ -1244,10 +1485,12 @@ void Pi::MainLoop()
 		// hide cursor for ship control.
 
 		SetMouseGrab(Pi::MouseButtonState(SDL_BUTTON_RIGHT));
+		timings->Lap(FrameTimings::PHASE_OTHER);
 
 		Pi::renderer->EndFrame();
 
 		Pi::renderer->ClearDepthBuffer();
+		Pi::renderer->BeginGpuTimer(Graphics::Stats::GPU_TIMER_UI);
 		if( DrawGUI ) {
 			Gui::Draw();
 			if (game)
@@ -1272,6 +1515,9 @@ void Pi::MainLoop()
 			}
 		}
 
+		// coalesced property changes, so bound widgets are current
+		PropertyMap::SendPendingSignals();
+
 		// XXX don't draw the UI during death obviously a hack, and still
 		// wrong, because we shouldn't this when the HUD is disabled, but
 		// probably sure draw it if they switch to eg infoview while the HUD is
@@ -1280,6 +1526,7 @@ void Pi::MainLoop()
 			Pi::ui->Update();
 			Pi::ui->Draw();
 		}
+		Pi::renderer->EndGpuTimer();
 
 #if WITH_DEVKEYS
 		if (Pi::showDebugInfo) {
@@ -1292,9 +1539,14 @@ void Pi::MainLoop()
 		}
 #endif
 
+		timings->Lap(FrameTimings::PHASE_UI);
+
 		Pi::EndRenderTarget();
 		Pi::DrawRenderTarget();
 		Pi::renderer->SwapBuffers();
+		timings->Lap(FrameTimings::PHASE_SWAP);
+		inputLatency->OnSwap();
+		FrameArena::EndFrame();
 
 		// game exit will have cleared Pi::game. we can't continue.
 		if (!Pi::game)
@@ -1310,10 +1562,38 @@ void Pi::MainLoop()
 		}
 		Pi::game->GetCpan()->Update();
 		musicPlayer.Update();
+		timings->Lap(FrameTimings::PHASE_OTHER);
 
+		// spread job completions (VBO uploads and the like) over several
+		// frames rather than taking one long hitch
 		syncJobQueue->RunJobs(SYNC_JOBS_PER_LOOP);
-		asyncJobQueue->FinishJobs();
-		syncJobQueue->FinishJobs();
+		asyncJobQueue->FinishJobs(FINISH_JOBS_BUDGET_MS * 0.001, asyncJobsDeferred);
+		syncJobQueue->FinishJobs(FINISH_JOBS_BUDGET_MS * 0.001, syncJobsDeferred);
+		timings->Lap(FrameTimings::PHASE_JOBS);
+		timings->SetDeferredJobs(asyncJobsDeferred, syncJobsDeferred);
+		LuaAsync::Update();
+		timings->Lap(FrameTimings::PHASE_LUA);
+
+		Pi::game->GetGalaxy()->ApplyCacheBudgets();
+		Pi::renderer->TrimTextureCache();
+		timings->Lap(FrameTimings::PHASE_OTHER);
+		Lua::manager->StepGarbage();
+		timings->Lap(FrameTimings::PHASE_LUA);
+
+		const bool hitch = timings->EndFrame();
+		SessionRecording::EndFrame(timings);
+		if (qualityGovernor)
+			qualityGovernor->Update(timings->GetLastTotal(), timings->GetLastPhase(FrameTimings::PHASE_SWAP));
+		if (hitch && game->GetSpace() == stepSpace) {
+			const Space::StepTimes &t = stepSpace->GetStepTimes();
+			Output("  space step ms: collisions %.1f, bodies %.1f, projectiles %.1f, movement %.1f, lua events %.1f, lua timers %.1f, cleanup %.1f\n",
+				(t.collisions - stepTimes.collisions) * 1e3, (t.bodies - stepTimes.bodies) * 1e3,
+				(t.projectiles - stepTimes.projectiles) * 1e3, (t.movement - stepTimes.movement) * 1e3,
+				(t.luaEvents - stepTimes.luaEvents) * 1e3, (t.luaTimers - stepTimes.luaTimers) * 1e3,
+				(t.cleanup - stepTimes.cleanup) * 1e3);
+			Output("  %u bodies, time accel %d, lua gc %.1f ms, %.1f MB lua\n", Uint32(stepSpace->GetNumBodies()),
+				int(game->GetTimeAccel()), Lua::manager->GetGarbageTime() * 1e3, Lua::manager->GetMemoryUsage() / (1024.0 * 1024.0));
+		}
 
 #if WITH_DEVKEYS
 		if (Pi::showDebugInfo && SDL_GetTicks() - last_stats > 1000) {
@@ -1336,19 +1616,36 @@ void Pi::MainLoop()
 			const Uint32 numDrawStars			= stats.m_stats[Graphics::Stats::STAT_STARS];
 			const Uint32 numDrawShips			= stats.m_stats[Graphics::Stats::STAT_SHIPS];
 			const Uint32 numDrawBillBoards = stats.m_stats[Graphics::Stats::STAT_BILLBOARD];
+			const Uint32 numProgramSwitches		= stats.m_stats[Graphics::Stats::STAT_PROGRAM_SWITCHES];
+			const Uint32 numVAOBinds			= stats.m_stats[Graphics::Stats::STAT_VAO_BINDS];
+			const Uint32 numUniformsSet			= stats.m_stats[Graphics::Stats::STAT_UNIFORMS_SET];
+			const Uint32 numUniformsSkipped		= stats.m_stats[Graphics::Stats::STAT_UNIFORMS_SKIPPED];
+			const Uint32 *gpuTime				= stats.m_gpuTime;
 			snprintf(
 				fps_readout, sizeof(fps_readout),
 				"%d fps (%.1f ms/f), %d phys updates, %d triangles, %.3f M tris/sec, %d glyphs/sec, %d patches/frame\n"
-				"Lua mem usage: %d MB + %d KB + %d bytes (stack top: %d)\n\n"
+				"Lua mem usage: %d MB + %d KB + %d bytes (stack top: %d), GC %.2f ms/f, %u cycles\n"
+				"Deferred jobs: %u async, %u sync\n\n"
 				"Draw Calls (%u), of which were:\n Tris (%u)\n Point Sprites (%u)\n Billboards (%u)\n"
 				"Buildings (%u), Cities (%u), GroundStations (%u), SpaceStations (%u), Atmospheres (%u)\n"
-				"Patches (%u), Planets (%u), GasGiants (%u), Stars (%u), Ships (%u)\n",
+				"Patches (%u), Planets (%u), GasGiants (%u), Stars (%u), Ships (%u)\n"
+				"Program switches (%u), VAO binds (%u), Uniforms set (%u), skipped (%u)\n"
+				"GPU ms: frame %.2f, scene %.2f, background %.2f, terrain %.2f, atmospheres %.2f, models %.2f, cockpit %.2f, ui %.2f\n"
+				"%s",
 				frame_stat, (1000.0/frame_stat), phys_stat, Pi::statSceneTris, Pi::statSceneTris*frame_stat*1e-6,
 				Text::TextureFont::GetGlyphCount(), Pi::statNumPatches,
 				lua_memMB, lua_memKB, lua_memB, lua_gettop(Lua::manager->GetLuaState()),
+				Lua::manager->GetGarbageTime() * 1e3, Lua::manager->GetGarbageCycles(),
+				asyncJobsDeferred, syncJobsDeferred,
 				numDrawCalls, numDrawTris, numDrawPointSprites, numDrawBillBoards,
 				numDrawBuildings, numDrawCities, numDrawGroundStations, numDrawSpaceStations, numDrawAtmospheres,
-				numDrawPatches, numDrawPlanets, numDrawGasGiants, numDrawStars, numDrawShips
+				numDrawPatches, numDrawPlanets, numDrawGasGiants, numDrawStars, numDrawShips,
+				numProgramSwitches, numVAOBinds, numUniformsSet, numUniformsSkipped,
+				gpuTime[Graphics::Stats::GPU_TIMER_FRAME] * 0.001, gpuTime[Graphics::Stats::GPU_TIMER_SCENE] * 0.001,
+				gpuTime[Graphics::Stats::GPU_TIMER_BACKGROUND] * 0.001, gpuTime[Graphics::Stats::GPU_TIMER_TERRAIN] * 0.001,
+				gpuTime[Graphics::Stats::GPU_TIMER_ATMOSPHERES] * 0.001, gpuTime[Graphics::Stats::GPU_TIMER_MODELS] * 0.001,
+				gpuTime[Graphics::Stats::GPU_TIMER_COCKPIT] * 0.001, gpuTime[Graphics::Stats::GPU_TIMER_UI] * 0.001,
+				MemoryReport::Summary().c_str()
 			);
 			frame_stat = 0;
 			phys_stat = 0;
@@ -1364,6 +1661,11 @@ void Pi::MainLoop()
 		if (Pi::doProfileOne || (Pi::doProfileSlow && (profTicks-newTicks) > 100)) { // slow: < ~10fps
 			Output("dumping profile data\n");
 			Profiler::dumphtml(profilerPath.c_str());
+			Output("async job queue:\n%s", asyncJobQueue->DumpStats().c_str());
+			Output("sync job queue:\n%s", syncJobQueue->DumpStats().c_str());
+			Output("gpu time per frame:\n%s", Pi::renderer->GetStats().DumpGpuTimes().c_str());
+			if (Lua::manager->IsProfiling())
+				DumpLuaProfile();
 			Pi::doProfileOne = false;
 		}
 #endif
@@ -19,11 +19,14 @@
 #include <string>
 #include <vector>
 
+class FrameTimings;
+class InputLatency;
 class Intro;
 class LuaConsole;
 class LuaNameGen;
 class ModelCache;
 class Player;
+class QualityGovernor;
 class Ship;
 class SpaceStation;
 class StarSystem;
@@ -32,7 +35,7 @@ class UIView;
 class View;
 class SDLGraphics;
 class ServerAgent;
-namespace Graphics { class Renderer; }
+namespace Graphics { class DynamicResolution; class Renderer; class TextureStreamer; }
 namespace SceneGraph { class Model; }
 namespace Sound { class MusicPlayer; }
 namespace UI { class Context; }
@@ -53,7 +56,9 @@ class Game;
 
 class Pi {
 public:
-	static void Init(const std::map<std::string,std::string> &options, bool no_gui = false);
+	// headless runs on the dummy renderer without a window, and implies
+	// no_gui
+	static void Init(const std::map<std::string,std::string> &options, bool no_gui = false, bool headless = false);
 	static void InitGame();
 	static void StarportStart(Uint32 starport);
 	static void StartGame();
@@ -100,6 +105,12 @@ public:
 	static void GetMouseMotion(int motion[2]) {
 		memcpy(motion, mouseMotion, sizeof(int)*2);
 	}
+	// all motion since the last call, for the flight controls, which read it
+	// every physics tick rather than every frame
+	static void TakeFlightMouseMotion(int motion[2]) {
+		memcpy(motion, flightMouseMotion, sizeof(int)*2);
+		flightMouseMotion[0] = flightMouseMotion[1] = 0;
+	}
 	static void SetMouseGrab(bool on);
 	static void FlushCaches();
 	static void BoinkNoise();
@@ -163,6 +174,9 @@ public:
 	static JobQueue *GetAsyncJobQueue() { return asyncJobQueue.get();}
 	static JobQueue *GetSyncJobQueue() { return syncJobQueue.get();}
 
+	static FrameTimings *GetFrameTimings() { return frameTimings.get(); }
+	static InputLatency *GetInputLatency() { return inputLatency.get(); }
+
 	static bool DrawGUI;
 
 private:
@@ -170,8 +184,14 @@ private:
 	static void InitJoysticks();
 
 	static const Uint32 SYNC_JOBS_PER_LOOP = 1;
+	static const Uint32 FINISH_JOBS_BUDGET_MS = 4; // per queue, per frame
 	static std::unique_ptr<AsyncJobQueue> asyncJobQueue;
 	static std::unique_ptr<SyncJobQueue> syncJobQueue;
+	static std::unique_ptr<Graphics::TextureStreamer> textureStreamer;
+	static std::unique_ptr<FrameTimings> frameTimings;
+	static std::unique_ptr<InputLatency> inputLatency;
+	static std::unique_ptr<QualityGovernor> qualityGovernor;
+	static std::unique_ptr<Graphics::DynamicResolution> dynamicResolution;
 
 	static bool menuDone;
 
@@ -187,6 +207,7 @@ private:
 	static int keyModState;
 	static char mouseButton[6];
 	static int mouseMotion[2];
+	static int flightMouseMotion[2];
 	static bool doingMouseGrab;
 	static bool warpAfterMouseGrab;
 	static int mouseGrabWarpPos[2];
@@ -13,6 +13,8 @@
 #include "graphics/Texture.h"
 #include "graphics/VertexArray.h"
 #include "Color.h"
+#include "JobQueue.h"
+#include <map>
 
 #ifdef _MSC_VER
 	#include "win32/WinMath.h"
@@ -29,6 +31,7 @@ Planet::Planet()
 	: TerrainBody()
 	, m_ringVertices(RING_VERTEX_ATTRIBS)
 	, m_ringState(nullptr)
+	, m_ringPending(false)
 {
 }
 
@@ -36,6 +39,7 @@ Planet::Planet(SystemBody *sbody)
 	: TerrainBody(sbody)
 	, m_ringVertices(RING_VERTEX_ATTRIBS)
 	, m_ringState(nullptr)
+	, m_ringPending(false)
 {
 	InitParams(sbody);
 }
@@ -163,6 +167,108 @@ void Planet::GetAtmosphericState(double dist, double *outPressure, double *outDe
 	*outDensity = (*outPressure/(PA_2_ATMOS*GAS_CONSTANT*temp))*gasMolarMass;
 }
 
+// NOTE: texture width must be > 1 to avoid graphical glitches with Intel GMA 900 systems
+//       this is something to do with mipmapping (probably mipmap generation going wrong)
+//       (if the texture is generated without mipmaps then a 1xN texture works)
+static const int RING_TEXTURE_WIDTH = 4;
+static const int RING_TEXTURE_LENGTH = 256;
+// textures kept for bodies that aren't in the current system any more
+static const size_t MAX_CACHED_RING_TEXTURES = 32;
+
+// ring textures by body, so coming back to a system doesn't make them again
+static std::map<SystemPath, RefCountedPtr<Graphics::Texture>> s_ringTextures;
+
+static void CacheRingTexture(const SystemPath &path, Graphics::Texture *texture)
+{
+	if (s_ringTextures.size() >= MAX_CACHED_RING_TEXTURES) {
+		// drop the ones only the cache is holding
+		for (auto it = s_ringTextures.begin(); it != s_ringTextures.end(); ) {
+			if (it->second->GetRefCount() == 1)
+				s_ringTextures.erase(it++);
+			else
+				++it;
+		}
+	}
+	s_ringTextures[path].Reset(texture);
+}
+
+// the ring texture's noise, done on the job queue
+class RingTextureJob : public Job {
+public:
+	RingTextureJob(Graphics::Renderer *r, const SystemBody *sbody) :
+		m_renderer(r),
+		m_path(sbody->GetPath()),
+		m_seed(sbody->GetSeed()),
+		m_baseCol(sbody->GetRings().baseColor),
+		m_ringScale((sbody->GetRings().maxRadius - sbody->GetRings().minRadius).ToFloat() * sbody->GetRadius() / 1.5e7f)
+	{}
+
+	virtual void OnRun() override {
+		PROFILE_SCOPED()
+		m_pixels.resize(RING_TEXTURE_WIDTH * RING_TEXTURE_LENGTH);
+
+		Random rng(m_seed+4609837);
+		double noiseOffset = 2048.0 * rng.Double();
+		for (int i = 0; i < RING_TEXTURE_LENGTH; ++i) {
+			const float alpha = (float(i) / float(RING_TEXTURE_LENGTH)) * m_ringScale;
+			const float n = 0.25 +
+				0.60 * noise( 5.0 * alpha, noiseOffset, 0.0) +
+				0.15 * noise(10.0 * alpha, noiseOffset, 0.0);
+
+			const float LOG_SCALE = 1.0f/sqrtf(sqrtf(log1pf(1.0f)));
+			const float v = LOG_SCALE*sqrtf(sqrtf(log1pf(n)));
+
+			Color color;
+			color.r = v*m_baseCol.r;
+			color.g = v*m_baseCol.g;
+			color.b = v*m_baseCol.b;
+			color.a = ((v*0.25f)+0.75f)*m_baseCol.a;
+
+			Color *row = &m_pixels[i * RING_TEXTURE_WIDTH];
+			for (int j = 0; j < RING_TEXTURE_WIDTH; ++j) {
+				row[j] = color;
+			}
+		}
+
+		// first and last pixel are forced to zero, to give a slightly smoother ring edge
+		{
+			Color *row;
+			row = &m_pixels[0];
+			memset(row, 0, RING_TEXTURE_WIDTH * 4);
+			row = &m_pixels[(RING_TEXTURE_LENGTH - 1) * RING_TEXTURE_WIDTH];
+			memset(row, 0, RING_TEXTURE_WIDTH * 4);
+		}
+	}
+
+	virtual void OnFinish() override {
+		const vector2f texSize(RING_TEXTURE_WIDTH, RING_TEXTURE_LENGTH);
+		const Graphics::TextureDescriptor texDesc(
+				Graphics::TEXTURE_RGBA_8888, texSize, Graphics::LINEAR_REPEAT, true);
+
+		Graphics::Texture *texture = m_renderer->CreateTexture(texDesc);
+		texture->Update(
+				static_cast<void*>(&m_pixels[0]), texSize,
+				Graphics::TEXTURE_RGBA_8888);
+		CacheRingTexture(m_path, texture);
+	}
+
+	virtual const char *GetName() const override { return "RingTexture"; }
+
+private:
+	Graphics::Renderer *m_renderer;
+	const SystemPath m_path;
+	const Uint32 m_seed;
+	const Color m_baseCol;
+	const float m_ringScale;
+	std::vector<Color> m_pixels;
+};
+
+//static
+void Planet::Uninit()
+{
+	s_ringTextures.clear();
+}
+
 void Planet::GenerateRings(Graphics::Renderer *renderer)
 {
 	const SystemBody *sbody = GetSystemBody();
@@ -181,70 +287,37 @@ void Planet::GenerateRings(Graphics::Renderer *renderer)
 		m_ringVertices.Add(vector3f(outer*sa, 0.0f, outer*ca), vector2f(float(i), 1.0f));
 	}
 
-	// generate the ring texture
-	// NOTE: texture width must be > 1 to avoid graphical glitches with Intel GMA 900 systems
-	//       this is something to do with mipmapping (probably mipmap generation going wrong)
-	//       (if the texture is generated without mipmaps then a 1xN texture works)
-	const int RING_TEXTURE_WIDTH = 4;
-	const int RING_TEXTURE_LENGTH = 256;
-	std::unique_ptr<Color, FreeDeleter> buf(
-			static_cast<Color*>(malloc(RING_TEXTURE_WIDTH * RING_TEXTURE_LENGTH * 4)));
-
-	const float ringScale = (outer-inner)*sbody->GetRadius() / 1.5e7f;
-
-	Random rng(GetSystemBody()->GetSeed()+4609837);
-	Color baseCol = sbody->GetRings().baseColor;
-	double noiseOffset = 2048.0 * rng.Double();
-	for (int i = 0; i < RING_TEXTURE_LENGTH; ++i) {
-		const float alpha = (float(i) / float(RING_TEXTURE_LENGTH)) * ringScale;
-		const float n = 0.25 +
-			0.60 * noise( 5.0 * alpha, noiseOffset, 0.0) +
-			0.15 * noise(10.0 * alpha, noiseOffset, 0.0);
-
-		const float LOG_SCALE = 1.0f/sqrtf(sqrtf(log1pf(1.0f)));
-		const float v = LOG_SCALE*sqrtf(sqrtf(log1pf(n)));
-
-		Color color;
-		color.r = v*baseCol.r;
-		color.g = v*baseCol.g;
-		color.b = v*baseCol.b;
-		color.a = ((v*0.25f)+0.75f)*baseCol.a;
-
-		Color *row = buf.get() + i * RING_TEXTURE_WIDTH;
-		for (int j = 0; j < RING_TEXTURE_WIDTH; ++j) {
-			row[j] = color;
-		}
-	}
-
-	// first and last pixel are forced to zero, to give a slightly smoother ring edge
-	{
-		Color *row;
-		row = buf.get();
-		memset(row, 0, RING_TEXTURE_WIDTH * 4);
-		row = buf.get() + (RING_TEXTURE_LENGTH - 1) * RING_TEXTURE_WIDTH;
-		memset(row, 0, RING_TEXTURE_WIDTH * 4);
-	}
-
-	const vector2f texSize(RING_TEXTURE_WIDTH, RING_TEXTURE_LENGTH);
-	const Graphics::TextureDescriptor texDesc(
-			Graphics::TEXTURE_RGBA_8888, texSize, Graphics::LINEAR_REPEAT, true);
-
-	m_ringTexture.Reset(renderer->CreateTexture(texDesc));
-	m_ringTexture->Update(
-			static_cast<void*>(buf.get()), texSize,
-			Graphics::TEXTURE_RGBA_8888);
-
 	Graphics::MaterialDescriptor desc;
 	desc.effect = Graphics::EFFECT_PLANETRING;
 	desc.lighting = true;
 	desc.textures = 1;
 	m_ringMaterial.reset(renderer->CreateMaterial(desc));
-	m_ringMaterial->texture0 = m_ringTexture.Get();
 
 	Graphics::RenderStateDesc rsd;
 	rsd.blendMode = Graphics::BLEND_ALPHA_PREMULT;
 	rsd.cullMode = Graphics::CULL_NONE;
 	m_ringState = renderer->CreateRenderState(rsd);
+
+	// made before, on an earlier visit
+	auto it = s_ringTextures.find(sbody->GetPath());
+	if (it != s_ringTextures.end()) {
+		m_ringTexture = it->second;
+		m_ringMaterial->texture0 = m_ringTexture.Get();
+		return;
+	}
+
+	// until the job is done the rings are flat, at roughly the average of the noise
+	const float v = 0.75f;
+	const Color baseCol = sbody->GetRings().baseColor;
+	const Color flat(v*baseCol.r, v*baseCol.g, v*baseCol.b, ((v*0.25f)+0.75f)*baseCol.a);
+	const Color pixels[RING_TEXTURE_WIDTH * 2] = { flat, flat, flat, flat, flat, flat, flat, flat };
+	const vector2f texSize(RING_TEXTURE_WIDTH, 2);
+	m_ringTexture.Reset(renderer->CreateTexture(Graphics::TextureDescriptor(Graphics::TEXTURE_RGBA_8888, texSize, Graphics::LINEAR_CLAMP, false, false)));
+	m_ringTexture->Update(static_cast<const void*>(pixels), texSize, Graphics::TEXTURE_RGBA_8888);
+	m_ringMaterial->texture0 = m_ringTexture.Get();
+
+	m_ringJob = Pi::GetAsyncJobQueue()->Queue(new RingTextureJob(renderer, sbody));
+	m_ringPending = true;
 }
 
 void Planet::DrawGasGiantRings(Renderer *renderer, const matrix4x4d &modelView)
@@ -254,6 +327,16 @@ void Planet::DrawGasGiantRings(Renderer *renderer, const matrix4x4d &modelView)
 	if (!m_ringTexture)
 		GenerateRings(renderer);
 
+	if (m_ringPending && !m_ringJob.HasJob()) {
+		// the job has finished, or been cancelled and left us the placeholder
+		m_ringPending = false;
+		auto it = s_ringTextures.find(GetSystemBody()->GetPath());
+		if (it != s_ringTextures.end()) {
+			m_ringTexture = it->second;
+			m_ringMaterial->texture0 = m_ringTexture.Get();
+		}
+	}
+
 	renderer->SetTransform(modelView);
 	renderer->DrawTriangles(&m_ringVertices, m_ringState, m_ringMaterial.get(), TRIANGLE_STRIP);
 }
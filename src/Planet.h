@@ -7,6 +7,7 @@
 #include "TerrainBody.h"
 #include "graphics/VertexArray.h"
 #include "SmartPtr.h"
+#include "JobQueue.h"
 
 namespace Graphics {
 	class Renderer;
@@ -26,6 +27,9 @@ public:
 	void GetAtmosphericState(double dist, double *outPressure, double *outDensity) const;
 	double GetAtmosphereRadius() const { return m_atmosphereRadius; }
 
+	// drops the ring textures kept from earlier systems
+	static void Uninit();
+
 #if WITH_OBJECTVIEWER
 	friend class ObjectViewerView;
 #endif
@@ -44,6 +48,8 @@ private:
 	Graphics::VertexArray m_ringVertices;
 	std::unique_ptr<Graphics::Material> m_ringMaterial;
 	Graphics::RenderState *m_ringState;
+	Job::Handle m_ringJob;
+	bool m_ringPending; // showing the flat placeholder until the job is done
 
 	// Legacy renderer visuals
 	std::unique_ptr<Graphics::VertexArray> m_atmosphereVertices;
@@ -10,6 +10,7 @@
 #include "galaxy/Economy.h"
 #include "Factions.h"
 #include "Space.h"
+#include "NavCache.h"
 #include "Ship.h"
 #include "ShipCpanel.h"
 #include "SpaceStation.h"
@@ -118,24 +119,24 @@ void FromJson(const Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy)
 	Init(galaxy);
 
 	if (!jsonObj.isMember("polit")) throw SavedGameCorruptException();
-	Json::Value politObj = jsonObj["polit"];
+	const Json::Value &politObj = jsonObj["polit"];
 
 	if (!politObj.isMember("criminal_record")) throw SavedGameCorruptException();
 	if (!politObj.isMember("outstanding_fine")) throw SavedGameCorruptException();
 	if (!politObj.isMember("crime_record")) throw SavedGameCorruptException();
 
-	Json::Value criminalRecordObj = politObj["criminal_record"];
+	const Json::Value &criminalRecordObj = politObj["criminal_record"];
 	PersistSystemData<Sint64>::FromJson(criminalRecordObj, &s_criminalRecord);
 
-	Json::Value outstandingFineObj = politObj["outstanding_fine"];
+	const Json::Value &outstandingFineObj = politObj["outstanding_fine"];
 	PersistSystemData<Sint64>::FromJson(outstandingFineObj, &s_outstandingFine);
 
-	Json::Value crimeRecordArray = politObj["crime_record"];
+	const Json::Value &crimeRecordArray = politObj["crime_record"];
 	if (!crimeRecordArray.isArray()) throw SavedGameCorruptException();
 	assert(s_playerPerBlocCrimeRecord.size() == crimeRecordArray.size());
 	for (Uint32 i = 0; i < s_playerPerBlocCrimeRecord.size(); i++)
 	{
-		Json::Value crimeRecordArrayEl = crimeRecordArray[i];
+		const Json::Value &crimeRecordArrayEl = crimeRecordArray[i];
 		if (!crimeRecordArrayEl.isMember("record")) throw SavedGameCorruptException();
 		if (!crimeRecordArrayEl.isMember("fine")) throw SavedGameCorruptException();
 		s_playerPerBlocCrimeRecord[i].record = StrToSInt64(crimeRecordArrayEl["record"].asString());
@@ -163,7 +164,7 @@ void NotifyOfCrime(Ship *s, enum Crime crime)
 	// ignore crimes of NPCs for the time being
 	if (!s->IsType(Object::PLAYER)) return;
 	// find nearest starport to this evil criminal
-	SpaceStation *station = static_cast<SpaceStation*>(Pi::game->GetSpace()->FindNearestTo(s, Object::SPACESTATION));
+	SpaceStation *station = static_cast<SpaceStation*>(Pi::game->GetSpace()->GetNavCache()->FindNearestToCached(s, Object::SPACESTATION));
 	if (station) {
 		double dist = station->GetPositionRelTo(s).Length();
 		// too far away for crime to be noticed :)
@@ -0,0 +1,452 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "libs.h"
+#include "Pi.h"
+#include "ProjectileSystem.h"
+#include "Frame.h"
+#include "galaxy/StarSystem.h"
+#include "Space.h"
+#include "Serializer.h"
+#include "collider/collider.h"
+#include "CargoBody.h"
+#include "Planet.h"
+#include "Sfx.h"
+#include "Ship.h"
+#include "Game.h"
+#include "LuaEvent.h"
+#include "LuaUtils.h"
+#include "graphics/Graphics.h"
+#include "graphics/Material.h"
+#include "graphics/Renderer.h"
+#include "graphics/VertexArray.h"
+#include "graphics/TextureBuilder.h"
+#include "json/JsonUtils.h"
+#include <algorithm>
+
+std::unique_ptr<Graphics::VertexArray> ProjectileSystem::s_sideVerts;
+std::unique_ptr<Graphics::VertexArray> ProjectileSystem::s_glowVerts;
+std::unique_ptr<Graphics::Material> ProjectileSystem::s_sideMat;
+std::unique_ptr<Graphics::Material> ProjectileSystem::s_glowMat;
+Graphics::RenderState *ProjectileSystem::s_renderState = nullptr;
+
+void ProjectileSystem::BuildModel()
+{
+	//set up materials
+	Graphics::MaterialDescriptor desc;
+	desc.textures = 1;
+	desc.vertexColors = true;
+	s_sideMat.reset(Pi::renderer->CreateMaterial(desc));
+	s_glowMat.reset(Pi::renderer->CreateMaterial(desc));
+	s_sideMat->texture0 = Graphics::TextureBuilder::Billboard("textures/projectile_l.png").GetOrCreateTexture(Pi::renderer, "billboard");
+	s_glowMat->texture0 = Graphics::TextureBuilder::Billboard("textures/projectile_w.png").GetOrCreateTexture(Pi::renderer, "billboard");
+
+	//zero at projectile position
+	//+x down
+	//+y right
+	//+z forwards (or projectile direction)
+	const float w = 0.5f;
+
+	vector3f one(0.f, -w, 0.f); //top left
+	vector3f two(0.f,  w, 0.f); //top right
+	vector3f three(0.f,  w, -1.f); //bottom right
+	vector3f four(0.f, -w, -1.f); //bottom left
+
+	//uv coords
+	const vector2f topLeft(0.f, 1.f);
+	const vector2f topRight(1.f, 1.f);
+	const vector2f botLeft(0.f, 0.f);
+	const vector2f botRight(1.f, 0.f);
+
+	s_sideVerts.reset(new Graphics::VertexArray(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0));
+	s_glowVerts.reset(new Graphics::VertexArray(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0));
+
+	//add four intersecting planes to create a volumetric effect
+	for (int i=0; i < 4; i++) {
+		s_sideVerts->Add(one, topLeft);
+		s_sideVerts->Add(two, topRight);
+		s_sideVerts->Add(three, botRight);
+
+		s_sideVerts->Add(three, botRight);
+		s_sideVerts->Add(four, botLeft);
+		s_sideVerts->Add(one, topLeft);
+
+		one.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
+		two.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
+		three.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
+		four.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
+	}
+
+	//create quads for viewing on end
+	float gw = 0.5f;
+	float gz = -0.1f;
+
+	for (int i=0; i < 4; i++) {
+		s_glowVerts->Add(vector3f(-gw, -gw, gz), topLeft);
+		s_glowVerts->Add(vector3f(-gw, gw, gz), topRight);
+		s_glowVerts->Add(vector3f(gw, gw, gz), botRight);
+
+		s_glowVerts->Add(vector3f(gw, gw, gz), botRight);
+		s_glowVerts->Add(vector3f(gw, -gw, gz), botLeft);
+		s_glowVerts->Add(vector3f(-gw, -gw, gz), topLeft);
+
+		gw -= 0.1f; // they get smaller
+		gz -= 0.2f; // as they move back
+	}
+
+	Graphics::RenderStateDesc rsd;
+	rsd.blendMode = Graphics::BLEND_ALPHA_ONE;
+	rsd.depthWrite = false;
+	rsd.cullMode = Graphics::CULL_NONE;
+	s_renderState = Pi::renderer->CreateRenderState(rsd);
+}
+
+void ProjectileSystem::FreeModel()
+{
+	s_sideMat.reset();
+	s_glowMat.reset();
+	s_sideVerts.reset();
+	s_glowVerts.reset();
+}
+
+ProjectileSystem::ProjectileSystem()
+	: m_sideBatch(new Graphics::VertexArray(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0))
+	, m_glowBatch(new Graphics::VertexArray(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0))
+{
+}
+
+ProjectileSystem::~ProjectileSystem()
+{
+}
+
+void ProjectileSystem::Add(Body *parent, float lifespan, float dam, float length, float width, bool mining, const Color &color, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel)
+{
+	m_frame.push_back(parent->GetFrame());
+	m_parent.push_back(parent);
+	m_pos.push_back(pos);
+	m_baseVel.push_back(baseVel);
+	m_dirVel.push_back(dirVel);
+	m_age.push_back(0.0f);
+	m_lifespan.push_back(lifespan);
+	m_baseDam.push_back(dam);
+	m_length.push_back(length);
+	m_width.push_back(width);
+	m_mining.push_back(mining);
+	m_color.push_back(color);
+}
+
+void ProjectileSystem::Remove(Uint32 i)
+{
+	const Uint32 last = GetCount() - 1;
+	if (i != last) {
+		m_frame[i] = m_frame[last];
+		m_parent[i] = m_parent[last];
+		m_pos[i] = m_pos[last];
+		m_baseVel[i] = m_baseVel[last];
+		m_dirVel[i] = m_dirVel[last];
+		m_age[i] = m_age[last];
+		m_lifespan[i] = m_lifespan[last];
+		m_baseDam[i] = m_baseDam[last];
+		m_length[i] = m_length[last];
+		m_width[i] = m_width[last];
+		m_mining[i] = m_mining[last];
+		m_color[i] = m_color[last];
+	}
+	m_frame.pop_back();
+	m_parent.pop_back();
+	m_pos.pop_back();
+	m_baseVel.pop_back();
+	m_dirVel.pop_back();
+	m_age.pop_back();
+	m_lifespan.pop_back();
+	m_baseDam.pop_back();
+	m_length.pop_back();
+	m_width.pop_back();
+	m_mining.pop_back();
+	m_color.pop_back();
+}
+
+void ProjectileSystem::NotifyRemoved(const Body *removedBody)
+{
+	for (Body *&parent : m_parent)
+		if (parent == removedBody) parent = nullptr;
+}
+
+void ProjectileSystem::ToJson(Json::Value &jsonObj, Space *space)
+{
+	Json::Value projectileArray(Json::arrayValue); // Create JSON array to contain projectile data.
+
+	for (Uint32 i = 0; i < GetCount(); i++) {
+		Json::Value projectileObj(Json::objectValue);
+
+		projectileObj["index_for_frame"] = space->GetIndexForFrame(m_frame[i]);
+		VectorToJson(projectileObj, m_pos[i], "pos");
+		VectorToJson(projectileObj, m_baseVel[i], "base_vel");
+		VectorToJson(projectileObj, m_dirVel[i], "dir_vel");
+		projectileObj["age"] = FloatToStr(m_age[i]);
+		projectileObj["life_span"] = FloatToStr(m_lifespan[i]);
+		projectileObj["base_dam"] = FloatToStr(m_baseDam[i]);
+		projectileObj["length"] = FloatToStr(m_length[i]);
+		projectileObj["width"] = FloatToStr(m_width[i]);
+		projectileObj["mining"] = bool(m_mining[i]);
+		ColorToJson(projectileObj, m_color[i], "color");
+		projectileObj["index_for_body"] = space->GetIndexForBody(m_parent[i]);
+
+		projectileArray.append(projectileObj);
+	}
+
+	jsonObj["projectiles"] = projectileArray; // Add projectile array to supplied object.
+}
+
+void ProjectileSystem::FromJson(const Json::Value &jsonObj, Space *space)
+{
+	if (!jsonObj.isMember("projectiles")) throw SavedGameCorruptException();
+	const Json::Value &projectileArray = jsonObj["projectiles"];
+	if (!projectileArray.isArray()) throw SavedGameCorruptException();
+
+	for (Uint32 i = 0; i < projectileArray.size(); i++) {
+		const Json::Value &projectileObj = projectileArray[i];
+
+		if (!projectileObj.isMember("index_for_frame")) throw SavedGameCorruptException();
+		if (!projectileObj.isMember("pos")) throw SavedGameCorruptException();
+		if (!projectileObj.isMember("base_vel")) throw SavedGameCorruptException();
+		if (!projectileObj.isMember("dir_vel")) throw SavedGameCorruptException();
+		if (!projectileObj.isMember("age")) throw SavedGameCorruptException();
+		if (!projectileObj.isMember("life_span")) throw SavedGameCorruptException();
+		if (!projectileObj.isMember("base_dam")) throw SavedGameCorruptException();
+		if (!projectileObj.isMember("length")) throw SavedGameCorruptException();
+		if (!projectileObj.isMember("width")) throw SavedGameCorruptException();
+		if (!projectileObj.isMember("mining")) throw SavedGameCorruptException();
+		if (!projectileObj.isMember("color")) throw SavedGameCorruptException();
+		if (!projectileObj.isMember("index_for_body")) throw SavedGameCorruptException();
+
+		vector3d pos, baseVel, dirVel;
+		Color color;
+		JsonToVector(&pos, projectileObj, "pos");
+		JsonToVector(&baseVel, projectileObj, "base_vel");
+		JsonToVector(&dirVel, projectileObj, "dir_vel");
+		JsonToColor(&color, projectileObj, "color");
+
+		m_frame.push_back(space->GetFrameByIndex(projectileObj["index_for_frame"].asUInt()));
+		m_parent.push_back(space->GetBodyByIndex(projectileObj["index_for_body"].asUInt()));
+		m_pos.push_back(pos);
+		m_baseVel.push_back(baseVel);
+		m_dirVel.push_back(dirVel);
+		m_age.push_back(StrToFloat(projectileObj["age"].asString()));
+		m_lifespan.push_back(StrToFloat(projectileObj["life_span"].asString()));
+		m_baseDam.push_back(StrToFloat(projectileObj["base_dam"].asString()));
+		m_length.push_back(StrToFloat(projectileObj["length"].asString()));
+		m_width.push_back(StrToFloat(projectileObj["width"].asString()));
+		m_mining.push_back(projectileObj["mining"].asBool());
+		m_color.push_back(color);
+	}
+}
+
+/* In hull kg */
+float ProjectileSystem::GetDamage(Uint32 i) const
+{
+	return m_baseDam[i] * sqrt((m_lifespan[i] - m_age[i])/m_lifespan[i]);
+}
+
+static void MiningLaserSpawnTastyStuff(Frame *f, const SystemBody *asteroid, const vector3d &pos)
+{
+	lua_State *l = Lua::manager->GetLuaState();
+	pi_lua_import(l, "Equipment");
+	LuaTable cargo_types = LuaTable(l, -1).Sub("cargo");
+	if (20*Pi::rng.Fixed() < asteroid->GetMetallicityAsFixed()) {
+		cargo_types.Sub("precious_metals");
+	} else if (8*Pi::rng.Fixed() < asteroid->GetMetallicityAsFixed()) {
+		cargo_types.Sub("metal_alloys");
+	} else if (Pi::rng.Fixed() < asteroid->GetMetallicityAsFixed()) {
+		cargo_types.Sub("metal_ore");
+	} else if (Pi::rng.Fixed() < fixed(1,2)) {
+		cargo_types.Sub("water");
+	} else {
+		cargo_types.Sub("rubbish");
+	}
+	CargoBody *cargo = new CargoBody(LuaRef(l, -1));
+	lua_pop(l, 3);
+	cargo->SetFrame(f);
+	cargo->SetPosition(pos);
+	const double x = Pi::rng.Double();
+	vector3d dir = pos.Normalized();
+	dir.ArbRotate(vector3d(x, 1-x, 0), Pi::rng.Double()-.5);
+	cargo->SetVelocity(Pi::rng.Double(100.0,200.0) * dir);
+	Pi::game->GetSpace()->AddBody(cargo);
+}
+
+bool ProjectileSystem::HitTerrain(Uint32 i)
+{
+	Body *frameBody = m_frame[i]->GetBody();
+	if (!frameBody || !frameBody->IsType(Object::PLANET))
+		return false;
+
+	Planet *const planet = static_cast<Planet*>(frameBody);
+	const SystemBody *b = planet->GetSystemBody();
+	const vector3d &pos = m_pos[i];
+	double terrainHeight = planet->GetTerrainHeight(pos.Normalized());
+	if (terrainHeight <= pos.Length())
+		return false;
+
+	// hit the fucker
+	if (b->GetType() == SystemBody::TYPE_PLANET_ASTEROID) {
+		vector3d n = pos.Normalized();
+		MiningLaserSpawnTastyStuff(planet->GetFrame(), b, n*terrainHeight + 5.0*n);
+		Sfx::Add(m_frame[i], pos, vector3d(0.0), Sfx::TYPE_EXPLOSION);
+	}
+	return true;
+}
+
+void ProjectileSystem::TimeStep(const float step)
+{
+	PROFILE_SCOPED()
+	const Uint32 count = GetCount();
+	if (!count) return;
+
+	// trace the projectiles a frame at a time, all of a frame's together
+	m_order.resize(count);
+	for (Uint32 i = 0; i < count; i++)
+		m_order[i] = i;
+	std::sort(m_order.begin(), m_order.end(), [this](Uint32 a, Uint32 b) { return m_frame[a] < m_frame[b]; });
+
+	m_rayStart.resize(count);
+	m_rayDir.resize(count);
+	m_rayLen.resize(count);
+	m_contacts.assign(count, CollisionContact());
+	for (Uint32 i = 0; i < count; i++) {
+		const Uint32 p = m_order[i];
+		const vector3d vel = (m_baseVel[p]+m_dirVel[p]) * double(step);
+		m_rayStart[i] = m_pos[p];
+		m_rayLen[i] = vel.Length();
+		m_rayDir[i] = vel.Normalized();
+	}
+	for (Uint32 begin = 0; begin < count; ) {
+		Frame *f = m_frame[m_order[begin]];
+		Uint32 end = begin + 1;
+		while (end < count && m_frame[m_order[end]] == f)
+			end++;
+		f->GetCollisionSpace()->TraceSegments(&m_rayStart[begin], &m_rayDir[begin], &m_rayLen[begin], end - begin, &m_contacts[begin]);
+		begin = end;
+	}
+
+	m_dead.assign(count, 0);
+	for (Uint32 i = 0; i < count; i++) {
+		const Uint32 p = m_order[i];
+		const CollisionContact &c = m_contacts[i];
+		if (!c.userData1) continue;
+
+		Object *o = static_cast<Object*>(c.userData1);
+		if (o->IsType(Object::CITYONPLANET)) {
+			m_dead[p] = 1;
+		}
+		else if (o->IsType(Object::BODY)) {
+			Body *hit = static_cast<Body*>(o);
+			if (hit != m_parent[p]) {
+				hit->OnDamage(m_parent[p], GetDamage(p), c);
+				m_dead[p] = 1;
+				if (hit->IsType(Object::SHIP))
+					LuaEvent::Queue("onShipHit", dynamic_cast<Ship*>(hit), m_parent[p]);
+			}
+		}
+	}
+
+	for (Uint32 i = 0; i < count; i++) {
+		// need to test for terrain hit
+		if (m_mining[i] && !m_dead[i] && HitTerrain(i))
+			m_dead[i] = 1;
+
+		m_age[i] += step;
+		m_pos[i] += (m_baseVel[i]+m_dirVel[i]) * double(step);
+		if (m_age[i] > m_lifespan[i])
+			m_dead[i] = 1;
+	}
+
+	// from the back, so whatever Remove moves down has already been checked
+	for (Uint32 i = count; i > 0; i--)
+		if (m_dead[i-1]) Remove(i-1);
+}
+
+void ProjectileSystem::Render(Graphics::Renderer *renderer, const Frame *camFrame)
+{
+	PROFILE_SCOPED()
+	if (!GetCount()) return;
+	if (!s_sideMat) BuildModel();
+
+	// drawn where they were between the last two steps, as bodies are
+	const double interpBack = (1.0 - Pi::GetGameTickAlpha()) * Pi::game->GetTimeStep();
+
+	m_sideBatch->Clear();
+	m_glowBatch->Clear();
+
+	const Frame *transFrame = nullptr;
+	matrix4x4d viewTransform;
+	for (Uint32 i = 0; i < GetCount(); i++) {
+		if (m_frame[i] != transFrame) {
+			transFrame = m_frame[i];
+			Frame::GetFrameTransform(transFrame, camFrame, viewTransform);
+		}
+
+		const vector3d interpPos = m_pos[i] - (m_baseVel[i]+m_dirVel[i]) * interpBack;
+		const vector3d viewCoords = viewTransform * interpPos;
+		// behind the camera
+		if (viewCoords.z > m_length[i] + m_width[i])
+			continue;
+
+		vector3d _to = viewTransform * (interpPos + m_dirVel[i]);
+		vector3d _dir = _to - viewCoords;
+		vector3f from(&viewCoords.x);
+		vector3f dir = vector3f(_dir).Normalized();
+
+		vector3f v1, v2;
+		matrix4x4f m = matrix4x4f::Identity();
+		v1.x = dir.y; v1.y = dir.z; v1.z = dir.x;
+		v2 = v1.Cross(dir).Normalized();
+		v1 = v2.Cross(dir);
+		m[0] = v1.x; m[4] = v2.x; m[8] = dir.x;
+		m[1] = v1.y; m[5] = v2.y; m[9] = dir.y;
+		m[2] = v1.z; m[6] = v2.z; m[10] = dir.z;
+
+		m[12] = from.x;
+		m[13] = from.y;
+		m[14] = from.z;
+
+		// increase visible size based on distance from camera, z is always negative
+		// allows them to be smaller while maintaining visibility for game play
+		const float dist_scale = float(viewCoords.z / -500);
+		const float length = m_length[i] + dist_scale;
+		const float width = m_width[i] + dist_scale;
+
+		const matrix4x4f trans = m * matrix4x4f::ScaleMatrix(width, width, length);
+
+		Color color = m_color[i];
+		// fade them out as they age so they don't suddenly disappear
+		// this matches the damage fall-off calculation
+		const float base_alpha = sqrt(1.0f - m_age[i]/m_lifespan[i]);
+		// fade out side quads when viewing nearly edge on
+		vector3f view_dir = vector3f(viewCoords).Normalized();
+		color.a = (base_alpha * (1.f - powf(fabs(dir.Dot(view_dir)), length))) * 255;
+
+		if (color.a > 3) {
+			for (Uint32 v = 0; v < s_sideVerts->GetNumVerts(); v++)
+				m_sideBatch->Add(trans * s_sideVerts->position[v], color, s_sideVerts->uv0[v]);
+		}
+
+		// fade out glow quads when viewing nearly edge on
+		// these and the side quads fade at different rates
+		// so that they aren't both at the same alpha as that looks strange
+		color.a = (base_alpha * powf(fabs(dir.Dot(view_dir)), width)) * 255;
+
+		if (color.a > 3) {
+			for (Uint32 v = 0; v < s_glowVerts->GetNumVerts(); v++)
+				m_glowBatch->Add(trans * s_glowVerts->position[v], color, s_glowVerts->uv0[v]);
+		}
+	}
+
+	// everything is in view coordinates already
+	Graphics::Renderer::MatrixTicket mt(renderer, Graphics::MatrixMode::MODELVIEW);
+	renderer->SetTransform(matrix4x4f::Identity());
+	if (m_sideBatch->GetNumVerts())
+		renderer->DrawTriangles(m_sideBatch.get(), s_renderState, s_sideMat.get());
+	if (m_glowBatch->GetNumVerts())
+		renderer->DrawTriangles(m_glowBatch.get(), s_renderState, s_glowMat.get());
+}
@@ -0,0 +1,88 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _PROJECTILESYSTEM_H
+#define _PROJECTILESYSTEM_H
+
+#include "libs.h"
+#include "Serializer.h"
+#include "collider/CollisionContact.h"
+#include "graphics/Material.h"
+#include "graphics/RenderState.h"
+
+class Body;
+class Frame;
+class Space;
+namespace Graphics {
+	class Renderer;
+	class VertexArray;
+}
+
+/*
+ * Every laser bolt in a space. They aren't bodies: each one is a row across
+ * a set of arrays, traced against the collision spaces a frame at a time
+ * and drawn all together at the end of the camera's draw.
+ */
+class ProjectileSystem {
+public:
+	ProjectileSystem();
+	~ProjectileSystem();
+
+	void Add(Body *parent, float lifespan, float dam, float length, float width, bool mining, const Color &color, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel);
+
+	// trace each projectile along its path for the step and deal with
+	// anything it hits, then move them all on and drop the expired ones
+	void TimeStep(float step);
+	void NotifyRemoved(const Body *removedBody);
+	void Render(Graphics::Renderer *r, const Frame *camFrame);
+
+	void ToJson(Json::Value &jsonObj, Space *space);
+	void FromJson(const Json::Value &jsonObj, Space *space);
+
+	static void FreeModel();
+
+private:
+	ProjectileSystem(const ProjectileSystem &);
+	ProjectileSystem &operator=(const ProjectileSystem &);
+
+	Uint32 GetCount() const { return m_frame.size(); }
+	float GetDamage(Uint32 i) const;
+	// moves the last projectile into i. the storage stays allocated for
+	// the next ones fired
+	void Remove(Uint32 i);
+	bool HitTerrain(Uint32 i);
+
+	std::vector<Frame*> m_frame;
+	std::vector<Body*> m_parent;
+	std::vector<vector3d> m_pos;
+	std::vector<vector3d> m_baseVel;
+	std::vector<vector3d> m_dirVel;
+	std::vector<float> m_age;
+	std::vector<float> m_lifespan;
+	std::vector<float> m_baseDam;
+	std::vector<float> m_length;
+	std::vector<float> m_width;
+	std::vector<Uint8> m_mining;
+	std::vector<Color> m_color;
+
+	// scratch for TimeStep, kept to save reallocating every step
+	std::vector<Uint32> m_order;
+	std::vector<vector3d> m_rayStart;
+	std::vector<vector3d> m_rayDir;
+	std::vector<double> m_rayLen;
+	std::vector<CollisionContact> m_contacts;
+	std::vector<Uint8> m_dead;
+
+	std::unique_ptr<Graphics::VertexArray> m_sideBatch;
+	std::unique_ptr<Graphics::VertexArray> m_glowBatch;
+
+	static void BuildModel();
+
+	static std::unique_ptr<Graphics::VertexArray> s_sideVerts;
+	static std::unique_ptr<Graphics::VertexArray> s_glowVerts;
+	static std::unique_ptr<Graphics::Material> s_sideMat;
+	static std::unique_ptr<Graphics::Material> s_glowMat;
+	static Graphics::RenderState *s_renderState;
+};
+
+#endif /* _PROJECTILESYSTEM_H */
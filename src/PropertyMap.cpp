@@ -4,6 +4,30 @@
 #include "PropertyMap.h"
 #include "LuaUtils.h"
 #include "LuaSerializer.h"
+#include <algorithm>
+
+std::vector<PropertyMap*> PropertyMap::s_unwritten;
+std::vector<PropertyMap*> PropertyMap::s_unsignalled;
+
+bool PropertyMap::Property::operator==(const Property &b) const
+{
+	if (type != b.type) return false;
+	switch (type) {
+		case NUMBER: return !(number < b.number) && !(b.number < number);
+		case BOOLEAN: return boolean == b.boolean;
+		case STRING: return string == b.string;
+	}
+	return false;
+}
+
+void PropertyMap::Property::Push(lua_State *l) const
+{
+	switch (type) {
+		case NUMBER: lua_pushnumber(l, number); break;
+		case BOOLEAN: lua_pushboolean(l, boolean); break;
+		case STRING: lua_pushlstring(l, string.c_str(), string.size()); break;
+	}
+}
 
 PropertyMap::PropertyMap(LuaManager *lua)
 {
@@ -15,6 +39,102 @@ PropertyMap::PropertyMap(LuaManager *lua)
 	LUA_DEBUG_END(l, 0);
 }
 
+PropertyMap::~PropertyMap()
+{
+	if (!m_unwritten.empty())
+		s_unwritten.erase(std::find(s_unwritten.begin(), s_unwritten.end(), this));
+	if (!m_unsignalled.empty())
+		s_unsignalled.erase(std::find(s_unsignalled.begin(), s_unsignalled.end(), this));
+}
+
+void PropertyMap::SetProperty(const std::string &k, const Property &p)
+{
+	std::pair<PropertyValues::iterator,bool> ins = m_values.insert(std::make_pair(k, p));
+	if (!ins.second) {
+		if (ins.first->second == p)
+			return;
+		ins.first->second = p;
+	}
+
+	if (m_unwritten.empty())
+		s_unwritten.push_back(this);
+	if (std::find(m_unwritten.begin(), m_unwritten.end(), k) == m_unwritten.end())
+		m_unwritten.push_back(k);
+
+	QueueSignal(k);
+}
+
+void PropertyMap::QueueSignal(const std::string &k)
+{
+	if (m_signals.find(k) == m_signals.end())
+		return;
+	if (m_unsignalled.empty())
+		s_unsignalled.push_back(this);
+	if (std::find(m_unsignalled.begin(), m_unsignalled.end(), k) == m_unsignalled.end())
+		m_unsignalled.push_back(k);
+}
+
+void PropertyMap::Unset(const std::string &k)
+{
+	Materialise();
+	m_values.erase(k);
+
+	lua_State *l = m_table.GetLua();
+	LUA_DEBUG_START(l);
+	m_table.PushCopyToStack();
+	lua_pushlstring(l, k.c_str(), k.size());
+	lua_pushnil(l);
+	lua_rawset(l, -3);
+	lua_pop(l, 1);
+	LUA_DEBUG_END(l, 0);
+}
+
+void PropertyMap::Materialise()
+{
+	if (m_unwritten.empty())
+		return;
+
+	lua_State *l = m_table.GetLua();
+	LUA_DEBUG_START(l);
+	m_table.PushCopyToStack();
+	for (const std::string &k : m_unwritten) {
+		PropertyValues::const_iterator i = m_values.find(k);
+		if (i == m_values.end())
+			continue;
+		lua_pushlstring(l, k.c_str(), k.size());
+		i->second.Push(l);
+		lua_rawset(l, -3);
+	}
+	lua_pop(l, 1);
+	LUA_DEBUG_END(l, 0);
+
+	m_unwritten.clear();
+	s_unwritten.erase(std::find(s_unwritten.begin(), s_unwritten.end(), this));
+}
+
+void PropertyMap::MaterialiseAll()
+{
+	PROFILE_SCOPED()
+	while (!s_unwritten.empty())
+		s_unwritten.back()->Materialise();
+}
+
+void PropertyMap::SendPendingSignals()
+{
+	PROFILE_SCOPED()
+	// maps queued by the handlers wait for the next frame. a map that goes
+	// away under a handler takes itself off the queue
+	std::vector<std::string> keys;
+	for (size_t n = s_unsignalled.size(); n > 0 && !s_unsignalled.empty(); n--) {
+		PropertyMap *map = s_unsignalled.front();
+		s_unsignalled.erase(s_unsignalled.begin());
+		keys.clear();
+		keys.swap(map->m_unsignalled);
+		for (const std::string &k : keys)
+			map->SendSignal(k);
+	}
+}
+
 void PropertyMap::SendSignal(const std::string &k)
 {
 	std::map< std::string,sigc::signal<void,PropertyMap &,const std::string &> >::iterator i = m_signals.find(k);
@@ -26,15 +146,23 @@ void PropertyMap::SendSignal(const std::string &k)
 
 void PropertyMap::PushLuaTable()
 {
+	Materialise();
 	m_table.PushCopyToStack();
 }
 
 void PropertyMap::SaveToJson(Json::Value &jsonObj)
 {
+	Materialise();
 	m_table.SaveToJson(jsonObj);
 }
 
 void PropertyMap::LoadFromJson(const Json::Value &jsonObj)
 {
 	m_table.LoadFromJson(jsonObj);
+	// whatever was set before is replaced wholesale
+	m_values.clear();
+	if (!m_unwritten.empty()) {
+		m_unwritten.clear();
+		s_unwritten.erase(std::find(s_unwritten.begin(), s_unwritten.end(), this));
+	}
 }
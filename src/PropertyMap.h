@@ -12,19 +12,30 @@
 
 struct lua_State;
 
+// plain values (numbers, booleans, strings) are kept natively and only written into the Lua table
+// once something reads from it, so a property that changes several times a
+// frame costs one table write. change signals are held back until
+// SendPendingSignals and each changed property signals once. setting a
+// property to the value it already has does nothing at all
 class PropertyMap {
 public:
 	PropertyMap(LuaManager *lua);
+	~PropertyMap();
 
 	template <class Value> void Set(const std::string &k, const Value &v) {
-		ScopedTable(m_table).Set(k, v);
-		SendSignal(k);
+		SetValue(k, v);
 	}
 
+	void Unset(const std::string &k);
+
 	template <class Value> void Get(const std::string &k, Value &v) {
+		if (GetNative(k, v))
+			return;
+		Materialise();
 		v = ScopedTable(m_table).Get<Value>(k, v);
 	}
 
+	// anything that reads the table on the Lua side must call Sync first
 	void PushLuaTable();
 
 	sigc::connection Connect(const std::string &k, const sigc::slot<void,PropertyMap &,const std::string &> &fn) {
@@ -34,8 +45,73 @@ public:
 	void SaveToJson(Json::Value &jsonObj);
 	void LoadFromJson(const Json::Value &jsonObj);
 
+	// write every map's unwritten values into its Lua table
+	static void Sync() { if (!s_unwritten.empty()) MaterialiseAll(); }
+	// once a frame, before the UI is updated
+	static void SendPendingSignals();
+
 private:
+	PropertyMap(const PropertyMap &);
+	PropertyMap &operator=(const PropertyMap &);
+
+	struct Property {
+		enum Type { NUMBER, BOOLEAN, STRING };
+
+		Property(double v) : type(NUMBER), number(v), boolean(false) {}
+		Property(float v) : type(NUMBER), number(v), boolean(false) {}
+		Property(int v) : type(NUMBER), number(v), boolean(false) {}
+		Property(bool v) : type(BOOLEAN), number(0.0), boolean(v) {}
+		Property(const std::string &v) : type(STRING), number(0.0), boolean(false), string(v) {}
+		Property(const char *v) : type(STRING), number(0.0), boolean(false), string(v) {}
+
+		bool operator==(const Property &b) const;
+		void Push(lua_State *l) const;
+
+		Type type;
+		double number;
+		bool boolean;
+		std::string string;
+	};
+	typedef std::map<std::string,Property> PropertyValues;
+
+	void SetValue(const std::string &k, double v) { SetProperty(k, Property(v)); }
+	void SetValue(const std::string &k, float v) { SetProperty(k, Property(v)); }
+	void SetValue(const std::string &k, int v) { SetProperty(k, Property(v)); }
+	void SetValue(const std::string &k, bool v) { SetProperty(k, Property(v)); }
+	void SetValue(const std::string &k, const std::string &v) { SetProperty(k, Property(v)); }
+	void SetValue(const std::string &k, const char *v) { SetProperty(k, Property(v)); }
+	void SetValue(const std::string &k, char *v) { SetProperty(k, Property(v)); }
+	// anything else (tables, refs) goes straight into Lua as before
+	template <class Value> void SetValue(const std::string &k, const Value &v) {
+		m_values.erase(k);
+		ScopedTable(m_table).Set(k, v);
+		QueueSignal(k);
+	}
+	void SetProperty(const std::string &k, const Property &p);
+	void QueueSignal(const std::string &k);
+	void Materialise();
+	static void MaterialiseAll();
+
+	const Property *Find(const std::string &k, Property::Type type) const {
+		PropertyValues::const_iterator i = m_values.find(k);
+		return (i != m_values.end() && i->second.type == type) ? &i->second : 0;
+	}
+	template <class Value> bool GetNative(const std::string &, Value &) { return false; }
+	bool GetNative(const std::string &k, double &v) { const Property *p = Find(k, Property::NUMBER); if (p) v = p->number; return p; }
+	bool GetNative(const std::string &k, float &v) { const Property *p = Find(k, Property::NUMBER); if (p) v = float(p->number); return p; }
+	bool GetNative(const std::string &k, int &v) { const Property *p = Find(k, Property::NUMBER); if (p) v = int(p->number); return p; }
+	bool GetNative(const std::string &k, bool &v) { const Property *p = Find(k, Property::BOOLEAN); if (p) v = p->boolean; return p; }
+	bool GetNative(const std::string &k, std::string &v) { const Property *p = Find(k, Property::STRING); if (p) v = p->string; return p; }
+
 	LuaRef m_table;
+	PropertyValues m_values;
+
+	// keys waiting to be written to the table, and to be signalled
+	std::vector<std::string> m_unwritten;
+	std::vector<std::string> m_unsignalled;
+
+	static std::vector<PropertyMap*> s_unwritten;
+	static std::vector<PropertyMap*> s_unsignalled;
 
 	void SendSignal(const std::string &k);
 	std::map< std::string,sigc::signal<void,PropertyMap &,const std::string &> > m_signals;
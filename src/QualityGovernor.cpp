@@ -0,0 +1,88 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "QualityGovernor.h"
+#include "CityOnPlanet.h"
+#include "GeoSphere.h"
+#include "scenegraph/LOD.h"
+
+static const double WINDOW_SECONDS = 0.5;
+// over this much of the target for STEP_DOWN_WINDOWS windows in a row steps down
+static const double SLOW_FRACTION = 1.1;
+static const int STEP_DOWN_WINDOWS = 2;
+// making the target, with work taking under this much of it, for
+// STEP_UP_WINDOWS windows in a row steps up
+static const double MAKING_FRACTION = 1.05;
+static const double SPARE_FRACTION = 0.7;
+static const int STEP_UP_WINDOWS = 8;
+// windows ignored after a step, while things settle at the new detail
+static const int HOLD_WINDOWS = 2;
+static const int MAX_STEPS = 6;
+
+QualityGovernor::QualityGovernor(double targetFrameTime, int maxSteps) :
+	m_target(targetFrameTime),
+	m_maxSteps(Clamp(maxSteps, 0, MAX_STEPS)),
+	m_step(0)
+{
+	ClearWindow();
+	m_slowWindows = m_fastWindows = m_holdWindows = 0;
+}
+
+void QualityGovernor::ClearWindow()
+{
+	m_windowTime = m_windowWork = 0.0;
+	m_windowFrames = 0;
+}
+
+void QualityGovernor::Update(double frameTime, double swapTime)
+{
+	m_windowTime += frameTime;
+	m_windowWork += std::max(0.0, frameTime - swapTime);
+	m_windowFrames++;
+	if (m_windowTime < WINDOW_SECONDS)
+		return;
+
+	const double average = m_windowTime / double(m_windowFrames);
+	const double work = m_windowWork / double(m_windowFrames);
+	ClearWindow();
+
+	if (m_holdWindows > 0) {
+		m_holdWindows--;
+		return;
+	}
+
+	if (average > m_target * SLOW_FRACTION) {
+		m_fastWindows = 0;
+		if (++m_slowWindows >= STEP_DOWN_WINDOWS && m_step < m_maxSteps) {
+			Output("quality governor: %.1f ms frames, stepping detail down\n", average * 1e3);
+			SetStep(m_step + 1);
+		}
+	} else if (average <= m_target * MAKING_FRACTION && work < m_target * SPARE_FRACTION) {
+		m_slowWindows = 0;
+		if (++m_fastWindows >= STEP_UP_WINDOWS && m_step > 0) {
+			Output("quality governor: %.1f ms of work a frame, stepping detail up\n", work * 1e3);
+			SetStep(m_step - 1);
+		}
+	} else
+		m_slowWindows = m_fastWindows = 0;
+}
+
+void QualityGovernor::Reset()
+{
+	SetStep(0);
+	ClearWindow();
+	m_holdWindows = 0;
+}
+
+void QualityGovernor::SetStep(int step)
+{
+	m_step = step;
+	m_slowWindows = m_fastWindows = 0;
+	m_holdWindows = HOLD_WINDOWS;
+
+	// cheapest to change, and least noticed, first: the terrain and model
+	// LODs move a little with every step, cities lose a level every other
+	GeoSphere::SetSplitDistanceScale(1.0 - 0.1 * step);
+	SceneGraph::LOD::SetPixelScale(1.0f - 0.12f * step);
+	CityOnPlanet::SetDetailReduction(step / 2);
+}
@@ -0,0 +1,54 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _QUALITYGOVERNOR_H
+#define _QUALITYGOVERNOR_H
+
+#include "libs.h"
+
+/*
+ * Trades detail for frame rate while the game is running. It watches how
+ * long frames take and, when they're over the target for a while, steps
+ * detail down: terrain splits from nearer, models drop to their coarser
+ * LODs sooner and cities show fewer buildings. When frames are comfortably
+ * inside the target again it steps back up, one step at a time.
+ *
+ * The user's detail settings are never changed, the steps are taken off
+ * them, and never more than the configured number of steps.
+ *
+ * It takes a good deal more spare time to step up than it takes overrun to
+ * step down, and after each step it waits to see the effect, so it doesn't
+ * flip back and forth. Time spent presenting the frame doesn't count as
+ * spare, so with vsync it still knows how much room there is.
+ */
+class QualityGovernor {
+public:
+	QualityGovernor(double targetFrameTime, int maxSteps);
+
+	// once a frame, with how long it took and how much of that was spent
+	// presenting it
+	void Update(double frameTime, double swapTime);
+	// back to full detail
+	void Reset();
+
+	int GetStep() const { return m_step; }
+
+private:
+	void SetStep(int step);
+	void ClearWindow();
+
+	const double m_target;
+	const int m_maxSteps;
+	int m_step;
+
+	// frames are judged in windows of about half a second
+	double m_windowTime;
+	double m_windowWork;
+	Uint32 m_windowFrames;
+
+	int m_slowWindows;
+	int m_fastWindows;
+	int m_holdWindows;
+};
+
+#endif
@@ -224,6 +224,61 @@ public:
 		return k;
 	}
 
+	//
+	// Bulk generators.
+	//
+	// These fill an array with exactly the numbers the calls above would
+	// return one at a time, and leave the generator in the same state, so
+	// swapping one for the other doesn't change seeded results. The state
+	// stays in a register for the whole loop instead of going back to
+	// memory after every number
+	//
+
+	// count numbers from Int32()
+	void FillInt32(Uint32 *out, size_t count)
+	{
+		Uint32 s = current;
+		for (size_t i = 0; i < count; i++) {
+			s ^= (s << 17);
+			s ^= (s >> 13);
+			s ^= (s << 5);
+			out[i] = s;
+		}
+		current = s;
+	}
+
+	// count numbers from Double()
+	// interval [0, 1)
+	void FillDouble(double *out, size_t count)
+	{
+		Uint32 s = current;
+		for (size_t i = 0; i < count; i++) {
+			s ^= (s << 17);
+			s ^= (s >> 13);
+			s ^= (s << 5);
+			out[i] = double(s) * (1. / 4294967296.); // divided by 2^32
+		}
+		current = s;
+	}
+
+	// count numbers from Double(min, limit)
+	// interval [min, limit)
+	void FillDouble(double *out, size_t count, double min, double limit)
+	{
+		FillDouble(out, count);
+		const double range = limit-min;
+		for (size_t i = 0; i < count; i++)
+			out[i] = range*out[i]+min;
+	}
+
+	// count numbers from Normal(mean, stddev). rejection sampling means
+	// there's no telling ahead how many integers each one takes
+	void FillNormal(double *out, size_t count, double mean = 0.0, double stddev = 1.0)
+	{
+		for (size_t i = 0; i < count; i++)
+			out[i] = Normal(mean, stddev);
+	}
+
 	// Pick a fixed-point integer half open interval [0,1)
 	fixed Fixed()
 	{
@@ -5,6 +5,7 @@
 #define _REFCOUNTED_H
 
 #include <atomic>
+#include <utility>
 #include "SmartPtr.h"
 #include "LuaWrappable.h"
 
@@ -13,8 +14,10 @@ public:
 	RefCounted() : m_refCount(0) {}
 	virtual ~RefCounted() {}
 
-	inline void IncRefCount() const { ++m_refCount; }
-	inline void DecRefCount() const { assert(m_refCount > 0); if (! --m_refCount) delete this; }
+	// taking a reference needs no ordering, only dropping the last one does,
+	// so everything done through the others is seen before the delete
+	inline void IncRefCount() const { m_refCount.fetch_add(1, std::memory_order_relaxed); }
+	inline void DecRefCount() const { assert(m_refCount > 0); if (m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this; }
 	inline int GetRefCount() const { return m_refCount; }
 
 private:
@@ -46,6 +49,12 @@ public:
 	RefCountedPtr(const RefCountedPtr<U>& b): base_type(b.Get())
 	{ if (this->m_ptr) this->m_ptr->IncRefCount(); }
 
+	// moves take the reference over, leaving b empty, without touching the count
+	RefCountedPtr(this_type&& b): base_type(b.Release()) {}
+
+	template <typename U>
+	RefCountedPtr(RefCountedPtr<U>&& b): base_type(b.Release()) {}
+
 	~RefCountedPtr() {
 		T *p = this->Release();
 		if (p) p->DecRefCount();
@@ -58,7 +67,16 @@ public:
 	template <typename U>
 	this_type &operator=(const RefCountedPtr<U>& b) { this->Reset(b.Get()); return *this; }
 
+	this_type &operator=(this_type&& b) { this_type(std::move(b)).Swap(*this); return *this; }
+
+	template <typename U>
+	this_type &operator=(RefCountedPtr<U>&& b) { this_type(std::move(b)).Swap(*this); return *this; }
+
 	bool Unique() const { assert(this->m_ptr); return (this->m_ptr->GetRefCount() == 1); }
+
+private:
+	// for Release() in the moves from other pointer types
+	template <typename U> friend class RefCountedPtr;
 };
 
 #endif
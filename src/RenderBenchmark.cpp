@@ -0,0 +1,28 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "RenderBenchmark.h"
+#include "SimBenchmark.h"
+#include "Pi.h"
+#include "Game.h"
+#include "graphics/Renderer.h"
+
+namespace RenderBenchmark {
+
+bool Run(const std::string &scenario, Uint32 replays, Uint32 frames)
+{
+	Pi::game = SimBenchmark::StartScenario(scenario);
+	if (!Pi::game)
+		return false;
+
+	Output("renderbench: %s, capturing after %u frames, %u replays\n", scenario.c_str(), frames, replays);
+
+	// the main loop returns once the game has ended
+	Pi::renderer->CaptureFrame(replays, frames, [](const Graphics::Renderer::CaptureResult &) { Pi::RequestEndGame(); });
+	Pi::InitGame();
+	Pi::StartGame();
+	Pi::MainLoop();
+	return true;
+}
+
+}
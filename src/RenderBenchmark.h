@@ -0,0 +1,23 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _RENDERBENCHMARK_H
+#define _RENDERBENCHMARK_H
+
+#include "libs.h"
+#include <string>
+
+/*
+ * Renderer benchmark. Starts the scenario (a save file or a system body
+ * path, as for SimBenchmark), runs the game for a number of frames so things
+ * can load and settle, then captures one frame and draws it again the given
+ * number of times, reporting the CPU submit and GPU time per replay. See
+ * Renderer::CaptureFrame. Needs a real renderer, so Pi is initialised
+ * normally.
+ */
+namespace RenderBenchmark {
+	// returns false if the scenario couldn't be started
+	bool Run(const std::string &scenario, Uint32 replays, Uint32 frames);
+}
+
+#endif
@@ -0,0 +1,453 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "libs.h"
+#include "SaveGameFile.h"
+#include "Serializer.h"
+#include <set>
+
+extern "C" {
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz/miniz.h"
+}
+
+namespace {
+
+const char s_signature[8] = { 'P', 'I', 'O', 'N', 'S', 'A', 'V', '\x1a' };
+// 2 added array slices. a version 1 file has none, so reads the same.
+// 3 added the summary block
+const Uint32 s_formatVersion = 3;
+
+// a summary bigger than this isn't one
+const Uint32 MAX_SUMMARY_SIZE = 64*1024;
+
+// members of these get a chunk each
+const char *s_splitSections[] = { "space" };
+
+// and arrays among those members are cut into chunks of this many
+// elements, so one changed body doesn't mean encoding all the others again
+const Json::ArrayIndex SLICE_SIZE = 64;
+
+// not worth deflating below this
+const size_t MIN_COMPRESS_SIZE = 256;
+
+enum ChunkCompression {
+	CHUNK_RAW,
+	CHUNK_DEFLATE
+};
+
+enum ValueTag {
+	TAG_NULL,
+	TAG_INT,
+	TAG_UINT,
+	TAG_REAL,
+	TAG_STRING,
+	TAG_FALSE,
+	TAG_TRUE,
+	TAG_ARRAY,
+	TAG_OBJECT
+};
+
+void WriteValue(Serializer::Writer &wr, const Json::Value &value)
+{
+	switch (value.type()) {
+		case Json::nullValue:
+			wr.Byte(TAG_NULL);
+			break;
+		case Json::intValue:
+			wr.Byte(TAG_INT);
+			wr.Int64(Uint64(value.asLargestInt()));
+			break;
+		case Json::uintValue:
+			wr.Byte(TAG_UINT);
+			wr.Int64(Uint64(value.asLargestUInt()));
+			break;
+		case Json::realValue:
+			wr.Byte(TAG_REAL);
+			wr.Double(value.asDouble());
+			break;
+		case Json::stringValue:
+			wr.Byte(TAG_STRING);
+			wr.String(value.asCString());
+			break;
+		case Json::booleanValue:
+			wr.Byte(value.asBool() ? TAG_TRUE : TAG_FALSE);
+			break;
+		case Json::arrayValue:
+			wr.Byte(TAG_ARRAY);
+			wr.Int32(value.size());
+			for (Json::ArrayIndex i = 0; i < value.size(); i++)
+				WriteValue(wr, value[i]);
+			break;
+		case Json::objectValue:
+			wr.Byte(TAG_OBJECT);
+			wr.Int32(value.size());
+			for (Json::Value::const_iterator i = value.begin(); i != value.end(); ++i) {
+				wr.String(i.memberName());
+				WriteValue(wr, *i);
+			}
+			break;
+	}
+}
+
+void EncodeChunk(const std::string &raw, bool compress, SaveGameFile::ChunkCache::Chunk &out)
+{
+	out.raw = raw;
+	out.compressed = compress;
+
+	if (compress && raw.size() >= MIN_COMPRESS_SIZE) {
+		size_t outSize = 0;
+		void *deflated = tdefl_compress_mem_to_heap(raw.data(), raw.size(), &outSize, 128);
+		if (deflated && outSize < raw.size()) {
+			out.compression = CHUNK_DEFLATE;
+			out.stored.assign(static_cast<const char*>(deflated), outSize);
+			mz_free(deflated);
+			return;
+		}
+		mz_free(deflated);
+	}
+
+	out.compression = CHUNK_RAW;
+	out.stored = raw;
+}
+
+void WriteChunk(Serializer::Writer &wr, const std::string &name, const Json::Value &value, bool compress, SaveGameFile::ChunkCache *cache, std::set<std::string> &written)
+{
+	Serializer::Writer chunk;
+	WriteValue(chunk, value);
+	const std::string &raw = chunk.GetData();
+
+	SaveGameFile::ChunkCache::Chunk fresh;
+	SaveGameFile::ChunkCache::Chunk *encoded = &fresh;
+	if (cache) {
+		written.insert(name);
+		encoded = &cache->chunks[name];
+		// the same bytes as last time can go out as they went then
+		if (encoded->stored.empty() || encoded->compressed != compress || encoded->raw != raw)
+			EncodeChunk(raw, compress, *encoded);
+	} else
+		EncodeChunk(raw, compress, fresh);
+
+	wr.String(name);
+	wr.Byte(encoded->compression);
+	wr.Int32(raw.size());
+	wr.String(encoded->stored);
+}
+
+// chunks a member of a split section goes in. long arrays get a slice each
+Uint32 CountMemberChunks(const Json::Value &member)
+{
+	if (member.isArray() && member.size() > SLICE_SIZE)
+		return (member.size() + SLICE_SIZE - 1) / SLICE_SIZE;
+	return 1;
+}
+
+void WriteMember(Serializer::Writer &wr, const std::string &name, const Json::Value &member, bool compress, SaveGameFile::ChunkCache *cache, std::set<std::string> &written)
+{
+	if (!member.isArray() || member.size() <= SLICE_SIZE) {
+		WriteChunk(wr, name, member, compress, cache, written);
+		return;
+	}
+
+	for (Json::ArrayIndex start = 0; start < member.size(); start += SLICE_SIZE) {
+		const Json::ArrayIndex end = std::min(start + SLICE_SIZE, member.size());
+		Json::Value slice(Json::arrayValue);
+		slice.resize(end - start);
+		for (Json::ArrayIndex i = start; i < end; i++)
+			slice[i - start] = member[i];
+		WriteChunk(wr, name + "@" + std::to_string(start), slice, compress, cache, written);
+	}
+}
+
+bool IsSplit(const char *name)
+{
+	for (const char *s : s_splitSections)
+		if (!strcmp(s, name))
+			return true;
+	return false;
+}
+
+// like Serializer::Reader, but a truncated or garbled file is an exception
+// rather than an assert
+class ChunkReader {
+public:
+	explicit ChunkReader(const ByteRange &data) : m_at(data.begin), m_end(data.end) {}
+
+	bool AtEnd() const { return m_at == m_end; }
+
+	Uint8 Byte() {
+		Need(1);
+		return Uint8(*m_at++);
+	}
+	Uint32 Int32() {
+		Need(4);
+		const unsigned char *p = reinterpret_cast<const unsigned char*>(m_at);
+		m_at += 4;
+		return Uint32(p[0]) | (Uint32(p[1]) << 8) | (Uint32(p[2]) << 16) | (Uint32(p[3]) << 24);
+	}
+	Uint64 Int64() {
+		const Uint64 lo = Int32();
+		const Uint64 hi = Int32();
+		return lo | (hi << 32);
+	}
+	double Double() {
+		Need(sizeof(double));
+		double d;
+		memcpy(&d, m_at, sizeof(double));
+		m_at += sizeof(double);
+		return d;
+	}
+	// as written by Serializer::Writer::String. the terminator isn't included
+	ByteRange Blob() {
+		const Uint32 size = Int32();
+		if (size == 0)
+			return ByteRange();
+		Need(size);
+		const ByteRange range(m_at, m_at + size - 1);
+		m_at += size;
+		return range;
+	}
+	std::string String() {
+		const ByteRange range = Blob();
+		return std::string(range.begin, range.Size());
+	}
+	void Bytes(char *out, size_t size) {
+		Need(size);
+		memcpy(out, m_at, size);
+		m_at += size;
+	}
+
+private:
+	void Need(size_t size) {
+		if (size_t(m_end - m_at) < size)
+			throw SavedGameCorruptException();
+	}
+
+	const char *m_at;
+	const char *m_end;
+};
+
+void ReadValue(ChunkReader &rd, Json::Value &value, int depth)
+{
+	// real saves are a couple of dozen levels deep at most
+	if (depth > 256)
+		throw SavedGameCorruptException();
+
+	switch (rd.Byte()) {
+		case TAG_NULL:
+			value = Json::Value();
+			break;
+		case TAG_INT:
+			value = Json::Value(Json::LargestInt(rd.Int64()));
+			break;
+		case TAG_UINT:
+			value = Json::Value(Json::LargestUInt(rd.Int64()));
+			break;
+		case TAG_REAL:
+			value = Json::Value(rd.Double());
+			break;
+		case TAG_STRING: {
+			const ByteRange s = rd.Blob();
+			value = Json::Value(s.begin, s.end);
+			break;
+		}
+		case TAG_FALSE:
+			value = Json::Value(false);
+			break;
+		case TAG_TRUE:
+			value = Json::Value(true);
+			break;
+		case TAG_ARRAY: {
+			const Uint32 size = rd.Int32();
+			value = Json::Value(Json::arrayValue);
+			for (Uint32 i = 0; i < size; i++)
+				ReadValue(rd, value[i], depth + 1);
+			break;
+		}
+		case TAG_OBJECT: {
+			const Uint32 size = rd.Int32();
+			value = Json::Value(Json::objectValue);
+			for (Uint32 i = 0; i < size; i++) {
+				const std::string key = rd.String();
+				ReadValue(rd, value[key], depth + 1);
+			}
+			break;
+		}
+		default:
+			throw SavedGameCorruptException();
+	}
+}
+
+}
+
+namespace SaveGameFile {
+
+std::string Write(const Json::Value &root, const Json::Value &summary, bool compress, ChunkCache *cache)
+{
+	PROFILE_SCOPED()
+
+	Serializer::Writer wr;
+	for (size_t i = 0; i < sizeof(s_signature); i++)
+		wr.Byte(s_signature[i]);
+	wr.Int32(s_formatVersion);
+
+	// never deflated, so ReadSummary can get at it with a couple of reads
+	Serializer::Writer summaryWr;
+	WriteValue(summaryWr, summary);
+	wr.String(summaryWr.GetData());
+
+	// top level scalars go together in one chunk
+	Json::Value scalars(Json::objectValue);
+	Uint32 numChunks = 0;
+	for (Json::Value::const_iterator i = root.begin(); i != root.end(); ++i) {
+		if (!(*i).isObject() && !(*i).isArray())
+			scalars[i.memberName()] = *i;
+		else if ((*i).isObject() && IsSplit(i.memberName())) {
+			for (Json::Value::const_iterator j = (*i).begin(); j != (*i).end(); ++j)
+				numChunks += CountMemberChunks(*j);
+			if ((*i).size() == 0)
+				numChunks++;
+		} else
+			numChunks++;
+	}
+	wr.Int32(numChunks + 1);
+
+	std::set<std::string> written;
+	WriteChunk(wr, "", scalars, compress, cache, written);
+	for (Json::Value::const_iterator i = root.begin(); i != root.end(); ++i) {
+		const std::string name(i.memberName());
+		if (!(*i).isObject() && !(*i).isArray())
+			continue;
+		if ((*i).isObject() && IsSplit(name.c_str()) && (*i).size() > 0) {
+			for (Json::Value::const_iterator j = (*i).begin(); j != (*i).end(); ++j)
+				WriteMember(wr, name + "/" + j.memberName(), *j, compress, cache, written);
+		} else
+			WriteChunk(wr, name, *i, compress, cache, written);
+	}
+
+	// forget chunks this save didn't have (slices of a shrunk array, say)
+	if (cache) {
+		for (auto i = cache->chunks.begin(); i != cache->chunks.end(); ) {
+			if (written.count(i->first))
+				++i;
+			else
+				i = cache->chunks.erase(i);
+		}
+	}
+
+	return wr.GetData();
+}
+
+bool IsBinary(const ByteRange &data)
+{
+	return data.Size() >= sizeof(s_signature) && !memcmp(data.begin, s_signature, sizeof(s_signature));
+}
+
+void Read(const ByteRange &data, Json::Value &root)
+{
+	PROFILE_SCOPED()
+
+	ChunkReader rd(data);
+
+	char signature[sizeof(s_signature)];
+	rd.Bytes(signature, sizeof(signature));
+	if (memcmp(signature, s_signature, sizeof(s_signature)))
+		throw SavedGameCorruptException();
+	const Uint32 version = rd.Int32();
+	if (version < 1 || version > s_formatVersion)
+		throw SavedGameWrongVersionException();
+	if (version >= 3)
+		rd.Blob();
+
+	root = Json::Value(Json::objectValue);
+
+	std::vector<char> inflated;
+	const Uint32 numChunks = rd.Int32();
+	for (Uint32 c = 0; c < numChunks; c++) {
+		const std::string name = rd.String();
+		const Uint8 compression = rd.Byte();
+		const Uint32 rawSize = rd.Int32();
+		ByteRange payload = rd.Blob();
+
+		if (compression == CHUNK_DEFLATE) {
+			inflated.resize(rawSize);
+			const size_t outSize = tinfl_decompress_mem_to_mem(inflated.data(), rawSize, payload.begin, payload.Size(), 0);
+			if (outSize != rawSize)
+				throw SavedGameCorruptException();
+			payload = ByteRange(inflated.data(), inflated.data() + rawSize);
+		} else if (compression != CHUNK_RAW || payload.Size() != rawSize)
+			throw SavedGameCorruptException();
+
+		ChunkReader chunk(payload);
+		if (name.empty()) {
+			Json::Value scalars;
+			ReadValue(chunk, scalars, 0);
+			if (!scalars.isObject())
+				throw SavedGameCorruptException();
+			for (Json::Value::iterator i = scalars.begin(); i != scalars.end(); ++i)
+				root[i.memberName()] = *i;
+		} else {
+			const size_t slash = name.find('/');
+			const size_t at = name.find('@');
+			if (slash == std::string::npos)
+				ReadValue(chunk, root[name], 0);
+			else if (at == std::string::npos)
+				ReadValue(chunk, root[name.substr(0, slash)][name.substr(slash + 1)], 0);
+			else {
+				// slices come in order, each continuing the array
+				Json::Value &member = root[name.substr(0, slash)][name.substr(slash + 1, at - slash - 1)];
+				if (member.isNull())
+					member = Json::Value(Json::arrayValue);
+				if (!member.isArray() || name.substr(at + 1) != std::to_string(member.size()))
+					throw SavedGameCorruptException();
+				Json::Value slice;
+				ReadValue(chunk, slice, 0);
+				if (!slice.isArray())
+					throw SavedGameCorruptException();
+				for (Json::ArrayIndex i = 0; i < slice.size(); i++)
+					member.append(slice[i]);
+			}
+		}
+		if (!chunk.AtEnd())
+			throw SavedGameCorruptException();
+	}
+
+	if (!rd.AtEnd())
+		throw SavedGameCorruptException();
+}
+
+bool ReadSummary(FILE *f, Json::Value &summary)
+{
+	// signature, version and the summary's size
+	char header[sizeof(s_signature) + 8];
+	if (fread(header, sizeof(header), 1, f) != 1)
+		return false;
+
+	ChunkReader rd(ByteRange(header, header + sizeof(header)));
+	char signature[sizeof(s_signature)];
+	rd.Bytes(signature, sizeof(signature));
+	if (memcmp(signature, s_signature, sizeof(s_signature)))
+		return false;
+	const Uint32 version = rd.Int32();
+	if (version < 3 || version > s_formatVersion)
+		return false;
+	const Uint32 size = rd.Int32();
+	if (size == 0 || size > MAX_SUMMARY_SIZE)
+		return false;
+
+	// Serializer::Writer::String counts the terminator
+	std::vector<char> buf(size);
+	if (fread(buf.data(), size, 1, f) != 1)
+		return false;
+
+	try {
+		ChunkReader body(ByteRange(buf.data(), buf.data() + size - 1));
+		ReadValue(body, summary, 0);
+	}
+	catch (SavedGameCorruptException) {
+		return false;
+	}
+	return summary.isObject();
+}
+
+}
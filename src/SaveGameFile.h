@@ -0,0 +1,58 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SAVEGAMEFILE_H
+#define _SAVEGAMEFILE_H
+
+#include "ByteRange.h"
+#include "json/json.h"
+#include <cstdio>
+#include <map>
+#include <string>
+
+/*
+ * Binary savegame container. A signature, the format version, a small
+ * summary of the game for the load screen and a list of named chunks, each holding part of the game's json tree in a compact
+ * binary encoding, deflated if that makes it smaller.
+ *
+ * Top level members of the tree each get a chunk ("galaxy_generator",
+ * "lua_modules", "sector_view", ...). The space section is big enough that
+ * its members get one each ("space/frame", "space/bodies", ...), and long
+ * arrays among those a chunk per slice ("space/bodies@0", "space/bodies@64").
+ *
+ * The tree that comes back from Read is the one that went into Write, so
+ * the FromJson code doesn't care which format a save is in.
+ */
+namespace SaveGameFile {
+
+	// the chunks of the last save written with it. the next save reuses the
+	// deflated bytes of any chunk that comes out the same, which is most of
+	// them for saves made close together. for one save at a time
+	struct ChunkCache {
+		struct Chunk {
+			Chunk() : compression(0), compressed(false) {}
+			std::string raw;    // encoded tree
+			std::string stored; // as written
+			int compression;
+			bool compressed;    // what Write was asked for
+		};
+		std::map<std::string,Chunk> chunks;
+	};
+
+	// summary is kept apart from the tree, for ReadSummary
+	std::string Write(const Json::Value &root, const Json::Value &summary, bool compress, ChunkCache *cache = nullptr);
+
+	// true if data starts with the binary signature. anything else is
+	// taken to be a plain json save
+	bool IsBinary(const ByteRange &data);
+
+	// throws SavedGameCorruptException or SavedGameWrongVersionException
+	void Read(const ByteRange &data, Json::Value &root);
+
+	// reads the summary from the start of an open save, and no further.
+	// false if there isn't one (a json save, or an older binary one)
+	bool ReadSummary(FILE *f, Json::Value &summary);
+
+}
+
+#endif
@@ -11,12 +11,14 @@
 #include "Player.h"
 #include "SectorView.h"
 #include "Serializer.h"
+#include "Space.h"
 #include "ShipCpanel.h"
 #include "StringF.h"
 #include "SystemInfoView.h"
 #include "galaxy/Galaxy.h"
 #include "galaxy/Sector.h"
 #include "galaxy/GalaxyCache.h"
+#include "galaxy/SectorGenerator.h"
 #include "galaxy/StarSystem.h"
 #include "graphics/Graphics.h"
 #include "graphics/Material.h"
@@ -35,6 +37,15 @@ static const int DRAW_RAD = 5;
 static const float FAR_THRESHOLD = 7.5f;
 static const float FAR_LIMIT     = 36.f;
 static const float FAR_MAX       = 46.f;
+// sectors are fetched for where the view will be this far ahead, and no
+// more than this many at once
+static const float PREFETCH_SECONDS = 1.0f;
+static const size_t MAX_PREFETCH_SECTORS = 4096;
+
+static inline int DrawRadius(float zoomClamped)
+{
+	return (zoomClamped <= FAR_THRESHOLD) ? DRAW_RAD : ceilf((zoomClamped/FAR_THRESHOLD) * DRAW_RAD);
+}
 
 enum DetailSelection {
 	DETAILBOX_NONE    = 0
@@ -44,6 +55,9 @@ enum DetailSelection {
 
 static const float ZOOM_SPEED = 15;
 static const float WHEEL_SENSITIVITY = .03f;		// Should be a variable in user settings.
+// don't plan routes to targets further than this many jumps as the crow
+// flies; the search would stall the view
+static const float MAX_ROUTE_JUMPS = 30.f;
 
 SectorView::SectorView(Game* game) : UIView(), m_game(game), m_galaxy(game->GetGalaxy())
 {
@@ -81,7 +95,7 @@ SectorView::SectorView(const Json::Value &jsonObj, Game* game) : UIView(), m_gam
 	InitDefaults();
 
 	if (!jsonObj.isMember("sector_view")) throw SavedGameCorruptException();
-	Json::Value sectorViewObj = jsonObj["sector_view"];
+	const Json::Value &sectorViewObj = jsonObj["sector_view"];
 
 	if (!sectorViewObj.isMember("pos_x")) throw SavedGameCorruptException();
 	if (!sectorViewObj.isMember("pos_y")) throw SavedGameCorruptException();
@@ -128,10 +142,16 @@ void SectorView::InitDefaults()
 
 	m_secPosFar = vector3f(INT_MAX, INT_MAX, INT_MAX);
 	m_radiusFar = 0;
+	m_farstarsDirty = true;
+	m_routeRange = 0.0f;
 	m_cacheXMin = 0;
 	m_cacheXMax = 0;
 	m_cacheYMin = 0;
 	m_cacheYMax = 0;
+	m_panVelocity = vector3f(0.0f);
+	m_zoomVelocity = 0.0f;
+	m_prefetchX = m_prefetchY = m_prefetchZ = 0;
+	m_prefetchRadius = -1;
 	m_cacheYMin = 0;
 	m_cacheYMax = 0;
 
@@ -418,65 +438,22 @@ void SectorView::OnSearchBoxKeyPress(const SDL_Keysym *keysym)
 		return;
 	} catch (SystemPath::ParseFailure) {}
 
-	bool gotMatch = false, gotStartMatch = false;
-	SystemPath bestMatch;
-	const std::string *bestMatchName = 0;
-
-	for (auto i = m_sectorCache->Begin(); i != m_sectorCache->End(); ++i)
-
-		for (unsigned int systemIndex = 0; systemIndex < (*i).second->m_systems.size(); systemIndex++) {
-			const Sector::System *ss = &((*i).second->m_systems[systemIndex]);
-
-			// compare with the start of the current system
-			if (strncasecmp(search.c_str(), ss->GetName().c_str(), search.size()) == 0) {
-
-				// matched, see if they're the same size
-				if (search.size() == ss->GetName().size()) {
-
-					// exact match, take it and go
-					SystemPath path = (*i).first;
-					path.systemIndex = systemIndex;
-					m_statusLabel->SetText(stringf(Lang::EXACT_MATCH_X, formatarg("system", ss->GetName())));
-					GotoSystem(path);
-					return;
-				}
-
-				// partial match at start of name
-				if (!gotMatch || !gotStartMatch || bestMatchName->size() > ss->GetName().size()) {
-
-					// don't already have one or its shorter than the previous
-					// one, take it
-					bestMatch = (*i).first;
-					bestMatch.systemIndex = systemIndex;
-					bestMatchName = &(ss->GetName());
-					gotMatch = gotStartMatch = true;
-				}
-
-				continue;
-			}
-
-			// look for the search term somewhere within the current system
-			if (pi_strcasestr(ss->GetName().c_str(), search.c_str())) {
-
-				// found it
-				if (!gotMatch || !gotStartMatch || bestMatchName->size() > ss->GetName().size()) {
-
-					// best we've found so far, take it
-					bestMatch = (*i).first;
-					bestMatch.systemIndex = systemIndex;
-					bestMatchName = &(ss->GetName());
-					gotMatch = true;
-				}
-			}
-		}
-
-	if (gotMatch) {
-		m_statusLabel->SetText(stringf(Lang::NOT_FOUND_BEST_MATCH_X, formatarg("system", *bestMatchName)));
-		GotoSystem(bestMatch);
+	SystemPath match;
+	std::string matchName;
+	switch (m_galaxy->GetSystemNameIndex()->Find(search, match, matchName)) {
+		case SystemNameIndex::EXACT_MATCH:
+			m_statusLabel->SetText(stringf(Lang::EXACT_MATCH_X, formatarg("system", matchName)));
+			GotoSystem(match);
+			break;
+		case SystemNameIndex::START_MATCH:
+		case SystemNameIndex::CONTAINS_MATCH:
+			m_statusLabel->SetText(stringf(Lang::NOT_FOUND_BEST_MATCH_X, formatarg("system", matchName)));
+			GotoSystem(match);
+			break;
+		case SystemNameIndex::NO_MATCH:
+			m_statusLabel->SetText(Lang::NOT_FOUND);
+			break;
 	}
-
-	else
-		m_statusLabel->SetText(Lang::NOT_FOUND);
 }
 
 #define FFRAC(_x)	((_x)-floor(_x))
@@ -541,11 +518,63 @@ void SectorView::Draw3D()
 		m_sectorlines.Draw(m_renderer, m_alphaBlendState);
 	}
 
+	if (m_zoomClamped <= FAR_THRESHOLD && m_route.size() > 2)
+		DrawRoute(modelview);
+
 	UpdateFactionToggles();
 
 	UIView::Draw3D();
 }
 
+void SectorView::DrawRoute(const matrix4x4f &modelview)
+{
+	PROFILE_SCOPED()
+	const Color routeColor(0, 160, 255, 160);
+	const vector3f origin = Sector::SIZE * vector3f(floorf(m_pos.x), floorf(m_pos.y), floorf(m_pos.z));
+
+	std::vector<vector3f> verts;
+	verts.reserve((m_route.size() - 1) * 2);
+	vector3f prev;
+	for (unsigned i = 0; i < m_route.size(); i++) {
+		RefCountedPtr<Sector> sec = GetCached(m_route[i]);
+		const vector3f pos = modelview * (sec->m_systems[m_route[i].systemIndex].GetFullPosition() - origin);
+		if (i > 0) {
+			verts.push_back(prev);
+			verts.push_back(pos);
+		}
+		prev = pos;
+	}
+	m_routeLines.SetData(verts.size(), &verts[0], routeColor);
+	m_routeLines.Draw(m_renderer, m_alphaBlendState);
+}
+
+void SectorView::UpdateRoute()
+{
+	if (!m_inSystem || m_hyperspaceTarget.IsSameSystem(m_current) || m_playerHyperspaceRange <= 0.0f) {
+		m_route.clear();
+		return;
+	}
+	if (m_routeFrom == m_current && m_routeTo == m_hyperspaceTarget && is_equal_exact(m_routeRange, m_playerHyperspaceRange))
+		return;
+
+	m_routeFrom = m_current;
+	m_routeTo = m_hyperspaceTarget;
+	m_routeRange = m_playerHyperspaceRange;
+
+	RefCountedPtr<Sector> fromSec = GetCached(m_current);
+	RefCountedPtr<Sector> toSec = GetCached(m_hyperspaceTarget);
+	if (Sector::DistanceBetween(fromSec, m_current.systemIndex, toSec, m_hyperspaceTarget.systemIndex) > MAX_ROUTE_JUMPS * m_routeRange)
+		m_route.clear();
+	else
+		m_route = m_galaxy->GetRoutePlanner()->GetRoute(m_current, m_hyperspaceTarget, m_routeRange);
+
+	// without a route the target is still where the player's likely to go
+	if (m_route.empty())
+		m_game->GetSpace()->PrefetchRoute(std::vector<SystemPath>(1, m_hyperspaceTarget));
+	else
+		m_game->GetSpace()->PrefetchRoute(m_route);
+}
+
 void SectorView::SetHyperspaceTarget(const SystemPath &path)
 {
 	m_hyperspaceTarget = path;
@@ -1126,28 +1155,98 @@ void SectorView::DrawFarSectors(const matrix4x4f& modelview)
 
 	// build vertex and colour arrays for all the stars we want to see, if we don't already have them
 	if (m_toggledFaction || buildRadius != m_radiusFar || !secOrigin.ExactlyEqual(m_secPosFar)) {
+		// the hidden factions decide what each sector holds, so a toggle throws away everything
+		if (m_toggledFaction) m_farSectors.clear();
+
 		m_farstars       .clear();
 		m_farstarsColor  .clear();
 		m_visibleFactions.clear();
 
+		const vector3f viewCentre = m_pos * Sector::SIZE;
+		const float viewRadius = (m_zoomClamped/FAR_THRESHOLD) * OUTER_RADIUS;
+		const float sectorHalfDiagonal = 0.5f * Sector::SIZE * sqrtf(3.0f);
+		const vector3f origin = Sector::SIZE * secOrigin;
+
+		/* sectors too sparse for random systems, and without custom ones, are
+		   empty, so they aren't generated at all. out at the edges of the galaxy
+		   and away from the plane that's most of them. the densities come a
+		   plane at a time from the galaxy's batched query */
+		const int x0 = int(secOrigin.x)-buildRadius, y0 = int(secOrigin.y)-buildRadius, z0 = int(secOrigin.z)-buildRadius;
+		const int side = 2*buildRadius + 1;
+		std::vector<Uint8> densities(side*side*side);
+		for (int k = 0; k < side; k++)
+			m_galaxy->GetSectorDensities(x0, y0, z0 + k, side, side, 1, &densities[k*side*side]);
+		const CustomSystemsDatabase *customSystems = m_galaxy->GetCustomSystems();
+
+		std::map<SystemPath, FarSectorStars> keep;
+		FarSectorStars clipped;
 		for (int sx = secOrigin.x-buildRadius; sx <= secOrigin.x+buildRadius; sx++) {
 			for (int sy = secOrigin.y-buildRadius; sy <= secOrigin.y+buildRadius; sy++) {
 				for (int sz = secOrigin.z-buildRadius; sz <= secOrigin.z+buildRadius; sz++) {
-					if ((vector3f(sx,sy,sz) - secOrigin).Length() <= buildRadius){
-						BuildFarSector(GetCached(SystemPath(sx, sy, sz)), Sector::SIZE * secOrigin, m_farstars, m_farstarsColor);
+					if ((vector3f(sx,sy,sz) - secOrigin).Length() > buildRadius) continue;
+					if (SectorRandomSystemsGenerator::IsEmptyDensity(densities[((sz-z0)*side + (sy-y0))*side + (sx-x0)]) &&
+						customSystems->GetCustomSystemsForSector(sx, sy, sz).empty()) continue;
+
+					/* sectors wholly inside the view sphere don't depend on where we are
+					   looking from, so those are kept from one rebuild to the next. the ones
+					   on the edge are clipped against the sphere every time, as is everything
+					   while factions are hidden, since then the selection matters too */
+					const SystemPath secPath(sx, sy, sz);
+					const vector3f secCentre = Sector::SIZE * (vector3f(sx, sy, sz) + vector3f(0.5f));
+					const bool inside = (secCentre - viewCentre).Length() + sectorHalfDiagonal <= viewRadius;
+					const FarSectorStars *stars;
+					if (inside && m_hiddenFactions.empty()) {
+						auto it = m_farSectors.find(secPath);
+						if (it != m_farSectors.end()) {
+							stars = &(keep[secPath] = std::move(it->second));
+						} else {
+							FarSectorStars &built = keep[secPath];
+							BuildFarSector(GetCached(secPath), built, false);
+							stars = &built;
+						}
+					} else {
+						clipped.points.clear();
+						clipped.colors.clear();
+						clipped.factions.clear();
+						BuildFarSector(GetCached(secPath), clipped, true);
+						stars = &clipped;
 					}
+
+					// origin must be m_pos's *sector* or we get judder
+					for (const vector3f &p : stars->points)
+						m_farstars.push_back(p - origin);
+					m_farstarsColor.insert(m_farstarsColor.end(), stars->colors.begin(), stars->colors.end());
+					m_visibleFactions.insert(stars->factions.begin(), stars->factions.end());
 				}
 			}
 		}
+		// anything we didn't pass over this time is out of range
+		m_farSectors.swap(keep);
 
 		m_secPosFar      = secOrigin;
 		m_radiusFar      = buildRadius;
 		m_toggledFaction = false;
+		m_farstarsDirty  = true;
+	}
+
+	// the billboards only need rebuilding when the stars change or the view turns, panning just moves them
+	const matrix3x3f orient = modelview.GetOrient();
+	if (!m_farstarsDirty) {
+		for (int i = 0; i < 9; i++) {
+			if (!is_equal_exact(orient[i], m_farstarsOrient[i])) {
+				m_farstarsDirty = true;
+				break;
+			}
+		}
 	}
 
 	// always draw the stars, slightly altering their size for different different resolutions, so they still look okay
 	if (m_farstars.size() > 0) {
-		m_farstarsPoints.SetData(m_renderer, m_farstars.size(), &m_farstars[0], &m_farstarsColor[0], modelview, 1.f * (Graphics::GetScreenHeight() / 720.f));
+		if (m_farstarsDirty) {
+			m_farstarsPoints.SetData(m_renderer, m_farstars.size(), &m_farstars[0], &m_farstarsColor[0], modelview, 1.f * (Graphics::GetScreenHeight() / 720.f));
+			m_farstarsOrient = orient;
+			m_farstarsDirty  = false;
+		}
 		m_farstarsPoints.Draw(m_renderer, m_alphaBlendState);
 	}
 
@@ -1155,26 +1254,25 @@ void SectorView::DrawFarSectors(const matrix4x4f& modelview)
 	PutFactionLabels(Sector::SIZE * secOrigin);
 }
 
-void SectorView::BuildFarSector(RefCountedPtr<Sector> sec, const vector3f &origin, std::vector<vector3f> &points, std::vector<Color> &colors)
+void SectorView::BuildFarSector(RefCountedPtr<Sector> sec, FarSectorStars &stars, bool clip)
 {
 	PROFILE_SCOPED()
 	Color starColor;
 	for (std::vector<Sector::System>::iterator i = sec->m_systems.begin(); i != sec->m_systems.end(); ++i) {
 		// skip the system if it doesn't fall within the sphere we're viewing.
-		if ((m_pos*Sector::SIZE - (*i).GetFullPosition()).Length() > (m_zoomClamped/FAR_THRESHOLD )*OUTER_RADIUS) continue;
+		if (clip && (m_pos*Sector::SIZE - (*i).GetFullPosition()).Length() > (m_zoomClamped/FAR_THRESHOLD )*OUTER_RADIUS) continue;
 
 		// if the system belongs to a faction we've chosen to hide also skip it, if it's not selectd in some way
-		m_visibleFactions.insert(i->GetFaction());
+		stars.factions.insert(i->GetFaction());
 		if (m_hiddenFactions.find(i->GetFaction()) != m_hiddenFactions.end()
 			&& !i->IsSameSystem(m_selected) && !i->IsSameSystem(m_hyperspaceTarget) && !i->IsSameSystem(m_current)) continue;
 
-		// otherwise add the system's position (origin must be m_pos's *sector* or we get judder)
-		// and faction color to the list to draw
+		// otherwise add the system's position and faction color to the list to draw
 		starColor = i->GetFaction()->colour;
 		starColor.a = 191;
 
-		points.push_back((*i).GetFullPosition() - origin);
-		colors.push_back(starColor);
+		stars.points.push_back((*i).GetFullPosition());
+		stars.colors.push_back(starColor);
 	}
 }
 
@@ -1339,6 +1437,8 @@ void SectorView::Update()
 
 	m_rotXMovingTo = Clamp(m_rotXMovingTo, -170.0f, -10.0f);
 
+	const vector3f prevPos = m_pos;
+	const float prevZoom = m_zoom;
 	{
 		vector3f diffPos = m_posMovingTo - m_pos;
 		vector3f travelPos = diffPos * 10.0f*frameTime;
@@ -1355,7 +1455,6 @@ void SectorView::Update()
 		if (fabs(travelZ) > fabs(diffZ)) m_rotZ = m_rotZMovingTo;
 		else m_rotZ = m_rotZ + travelZ;
 
-		float prevZoom = m_zoom;
 		float diffZoom = m_zoomMovingTo - m_zoom;
 		float travelZoom = diffZoom * ZOOM_SPEED*frameTime;
 		if (fabs(travelZoom) > fabs(diffZoom)) m_zoom = m_zoomMovingTo;
@@ -1402,9 +1501,11 @@ void SectorView::Update()
 		}
 	}
 
+	PrefetchSectors(m_pos - prevPos, m_zoom - prevZoom, frameTime);
 	ShrinkCache();
 
 	m_playerHyperspaceRange = LuaObject<Player>::CallMethod<float>(Pi::player, "GetHyperspaceRange");
+	UpdateRoute();
 
 	if(!m_jumpSphere)
 	{
@@ -1442,18 +1543,89 @@ void SectorView::MouseWheel(bool up)
 	}
 }
 
+void SectorView::PrefetchSectors(const vector3f &posDelta, float zoomDelta, float frameTime)
+{
+	PROFILE_SCOPED()
+	// smoothed, so one odd frame doesn't throw the guess about
+	if (frameTime > 0.0f) {
+		m_panVelocity = m_panVelocity * 0.8f + posDelta * (0.2f / frameTime);
+		m_zoomVelocity = m_zoomVelocity * 0.8f + zoomDelta * (0.2f / frameTime);
+	}
+
+	// where the view is easing to, carried on at the speed it's going. only
+	// zooming out brings more sectors in
+	const vector3f ahead = m_posMovingTo + m_panVelocity * PREFETCH_SECONDS;
+	const float zoomAhead = Clamp(m_zoomMovingTo + std::max(0.0f, m_zoomVelocity) * PREFETCH_SECONDS, 1.f, FAR_LIMIT);
+
+	const int x = int(floorf(ahead.x)), y = int(floorf(ahead.y)), z = int(floorf(ahead.z));
+	const int radius = std::max(DrawRadius(zoomAhead), DrawRadius(m_zoomClamped));
+	const int hereX = int(floorf(m_pos.x)), hereY = int(floorf(m_pos.y)), hereZ = int(floorf(m_pos.z));
+	const int hereRadius = DrawRadius(m_zoomClamped);
+
+	if (x == hereX && y == hereY && z == hereZ && radius == hereRadius) {
+		// staying put, what's drawn is all that's needed
+		if (m_prefetchRadius >= 0) {
+			m_sectorCache->CancelPrefetch();
+			m_prefetchRadius = -1;
+		}
+		return;
+	}
+	if (x == m_prefetchX && y == m_prefetchY && z == m_prefetchZ && radius == m_prefetchRadius)
+		return;
+
+	m_prefetchX = x;
+	m_prefetchY = y;
+	m_prefetchZ = z;
+	m_prefetchRadius = radius;
+
+	// the sectors in view there that aren't in view now, nearest first as
+	// they'll be wanted first
+	std::vector<std::pair<int,SystemPath> > wanted;
+	for (int sx = x-radius; sx <= x+radius; sx++) {
+		for (int sy = y-radius; sy <= y+radius; sy++) {
+			for (int sz = z-radius; sz <= z+radius; sz++) {
+				const int dx = sx-hereX, dy = sy-hereY, dz = sz-hereZ;
+				if (abs(dx) <= hereRadius && abs(dy) <= hereRadius && abs(dz) <= hereRadius)
+					continue;
+				wanted.push_back(std::make_pair(dx*dx + dy*dy + dz*dz, SystemPath(sx, sy, sz)));
+			}
+		}
+	}
+	if (wanted.size() > MAX_PREFETCH_SECTORS) {
+		std::nth_element(wanted.begin(), wanted.begin() + MAX_PREFETCH_SECTORS, wanted.end());
+		wanted.resize(MAX_PREFETCH_SECTORS);
+	}
+	std::sort(wanted.begin(), wanted.end());
+
+	SectorCache::PathVector paths;
+	paths.reserve(wanted.size());
+	for (auto it = wanted.begin(); it != wanted.end(); ++it)
+		paths.push_back(it->second);
+	m_sectorCache->Prefetch(paths);
+}
+
 void SectorView::ShrinkCache()
 {
 	PROFILE_SCOPED()
 	// we're going to use these to determine if our sectors are within the range that we'll ever render
-	const int drawRadius = (m_zoomClamped <= FAR_THRESHOLD) ? DRAW_RAD : ceilf((m_zoomClamped/FAR_THRESHOLD) * DRAW_RAD);
-
-	const int xmin = int(floorf(m_pos.x))-drawRadius;
-	const int xmax = int(floorf(m_pos.x))+drawRadius;
-	const int ymin = int(floorf(m_pos.y))-drawRadius;
-	const int ymax = int(floorf(m_pos.y))+drawRadius;
-	const int zmin = int(floorf(m_pos.z))-drawRadius;
-	const int zmax = int(floorf(m_pos.z))+drawRadius;
+	const int drawRadius = DrawRadius(m_zoomClamped);
+
+	int xmin = int(floorf(m_pos.x))-drawRadius;
+	int xmax = int(floorf(m_pos.x))+drawRadius;
+	int ymin = int(floorf(m_pos.y))-drawRadius;
+	int ymax = int(floorf(m_pos.y))+drawRadius;
+	int zmin = int(floorf(m_pos.z))-drawRadius;
+	int zmax = int(floorf(m_pos.z))+drawRadius;
+
+	// and what's been fetched for where the view is going
+	if (m_prefetchRadius >= 0) {
+		xmin = std::min(xmin, m_prefetchX-m_prefetchRadius);
+		xmax = std::max(xmax, m_prefetchX+m_prefetchRadius);
+		ymin = std::min(ymin, m_prefetchY-m_prefetchRadius);
+		ymax = std::max(ymax, m_prefetchY+m_prefetchRadius);
+		zmin = std::min(zmin, m_prefetchZ-m_prefetchRadius);
+		zmax = std::max(zmax, m_prefetchZ+m_prefetchRadius);
+	}
 
 	// XXX don't clear the current/selected/target sectors
 
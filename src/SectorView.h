@@ -41,6 +41,9 @@ public:
 	void GotoCurrentSystem() { GotoSystem(m_current); }
 	void GotoSelectedSystem() { GotoSystem(m_selected); }
 	void GotoHyperspaceTarget() { GotoSystem(m_hyperspaceTarget); }
+	// the planned jumps from the current system to the hyperspace target,
+	// including both. empty if there's no route within the player's range
+	const std::vector<SystemPath>& GetRoute() const { return m_route; }
 	virtual void SaveToJson(Json::Value &jsonObj);
 
 	sigc::signal<void> onHyperspaceTargetChanged;
@@ -72,8 +75,15 @@ private:
 	void DrawNearSector(const int sx, const int sy, const int sz, const vector3f &playerAbsPos, const matrix4x4f &trans);
 	void PutSystemLabels(RefCountedPtr<Sector> sec, const vector3f &origin, int drawRadius);
 
+	// stars of one far sector, in absolute coordinates, kept until the faction filter changes
+	struct FarSectorStars {
+		std::vector<vector3f> points;
+		std::vector<Color> colors;
+		std::set<const Faction*> factions;
+	};
+
 	void DrawFarSectors(const matrix4x4f& modelview);
-	void BuildFarSector(RefCountedPtr<Sector> sec, const vector3f &origin, std::vector<vector3f> &points, std::vector<Color> &colors);
+	void BuildFarSector(RefCountedPtr<Sector> sec, FarSectorStars &stars, bool clip);
 	void PutFactionLabels(const vector3f &secPos);
 	void AddStarBillboard(const matrix4x4f &modelview, const vector3f &pos, const Color &col, float size);
 
@@ -86,8 +96,12 @@ private:
 
 	void UpdateHyperspaceLockLabel();
 
+	void UpdateRoute();
+	void DrawRoute(const matrix4x4f &modelview);
+
 	RefCountedPtr<Sector> GetCached(const SystemPath& loc) { return m_sectorCache->GetCached(loc); }
 	void ShrinkCache();
+	void PrefetchSectors(const vector3f &posDelta, float zoomDelta, float frameTime);
 
 	void MouseWheel(bool up);
 	void OnKeyPressed(SDL_Keysym *keysym);
@@ -177,6 +191,9 @@ private:
 	vector3f m_secPosFar;
 	int      m_radiusFar;
 	bool     m_toggledFaction;
+	std::map<SystemPath, FarSectorStars> m_farSectors;
+	matrix3x3f m_farstarsOrient;
+	bool     m_farstarsDirty;
 
 	int m_cacheXMin;
 	int m_cacheXMax;
@@ -185,6 +202,12 @@ private:
 	int m_cacheZMin;
 	int m_cacheZMax;
 
+	// the sectors being fetched ahead of the view, from how it's moving
+	vector3f m_panVelocity;
+	float m_zoomVelocity;
+	int m_prefetchX, m_prefetchY, m_prefetchZ;
+	int m_prefetchRadius; // -1 when nothing is being fetched
+
 	std::unique_ptr<Graphics::VertexArray> m_lineVerts;
 	std::unique_ptr<Graphics::VertexArray> m_secLineVerts;
 	RefCountedPtr<Graphics::Material> m_fresnelMat;
@@ -194,6 +217,12 @@ private:
 	Graphics::Drawables::Lines m_lines;
 	Graphics::Drawables::Lines m_sectorlines;
 	Graphics::Drawables::Points m_farstarsPoints;
+
+	SystemPath m_routeFrom;
+	SystemPath m_routeTo;
+	float m_routeRange;
+	std::vector<SystemPath> m_route;
+	Graphics::Drawables::Lines m_routeLines;
 };
 
 #endif /* _SECTORVIEW_H */
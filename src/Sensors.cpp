@@ -7,6 +7,7 @@
 #include "Pi.h"
 #include "Ship.h"
 #include "Space.h"
+#include "NavCache.h"
 #include "Player.h"
 #include "HudTrail.h"
 
@@ -52,6 +53,10 @@ bool Sensors::ContactDistanceSort(const RadarContact &a, const RadarContact &b)
 Sensors::Sensors(Ship *owner)
 {
 	m_owner = owner;
+	// spread the sweeps of ships created together over the ticks
+	static int s_nextTick = 0;
+	m_tick = s_nextTick++ % SWEEP_TICKS;
+	m_removalSerial = Space::GetRemovalSerial();
 }
 
 bool Sensors::ChooseTarget(TargetingCriteria crit)
@@ -96,47 +101,61 @@ void Sensors::Update(float time)
 	PROFILE_SCOPED();
 	if (m_owner != Pi::player) return;
 
-	PopulateStaticContacts(); //no need to do all the time
+	// sweep on our tick, or straight away if a body has gone since the last
+	// one, as a contact could be pointing at it
+	const bool sweep = (m_tick == 0) || m_removalSerial != Space::GetRemovalSerial();
+	m_tick = (m_tick + 1) % SWEEP_TICKS;
+	if (sweep)
+		Sweep();
+
+	//update contacts
+	for (auto it = m_radarContacts.begin(); it != m_radarContacts.end(); ++it) {
+		const Ship* ship =dynamic_cast<Ship*>(it->body);
+		if (ship && Ship::FLYING==ship->GetFlightState()) {
+			it->distance = m_owner->GetPositionRelTo(it->body).Length();
+			it->trail->Update(time);
+		} else {
+			it->trail->Reset(nullptr);
+		}
+	}
+}
+
+void Sensors::Sweep()
+{
+	PROFILE_SCOPED();
+	m_removalSerial = Space::GetRemovalSerial();
+
+	PopulateStaticContacts();
 
 	//Find nearby contacts, same range as scanner. Scanner should use these
 	//contacts, worldview labels too.
-	Space::BodyNearList nearby;
+	Space::BodyNearList nearby(FrameArena::Allocator<Body*>());
 	Pi::game->GetSpace()->GetBodiesMaybeNear(m_owner, 100000.0f, nearby);
 	for (Space::BodyNearIterator i = nearby.begin(); i != nearby.end(); ++i) {
 		if ((*i) == m_owner || !(*i)->IsType(Object::SHIP)) continue;
 		if ((*i)->IsDead()) continue;
 
-		auto cit = m_radarContacts.begin();
-		while (cit != m_radarContacts.end()) {
-			if (cit->body == (*i)) break;
-			++cit;
-		}
-
 		//create new contact or refresh old
-		if (cit == m_radarContacts.end()) {
+		auto cit = m_contactIters.find(*i);
+		if (cit == m_contactIters.end()) {
 			m_radarContacts.push_back(RadarContact());
 			RadarContact &rc = m_radarContacts.back();
 			rc.body = (*i);
 			rc.iff = CheckIFF(rc.body);
 			rc.trail = new HudTrail(rc.body, IFFColor(rc.iff));
+			m_contactIters[rc.body] = std::prev(m_radarContacts.end());
 		} else {
-			cit->fresh = true;
+			cit->second->fresh = true;
 		}
 	}
 
-	//update contacts and delete stale ones
+	//delete stale contacts
 	auto it = m_radarContacts.begin();
 	while (it != m_radarContacts.end()) {
 		if (!it->fresh) {
+			m_contactIters.erase(it->body);
 			m_radarContacts.erase(it++);
 		} else {
-			const Ship* ship =dynamic_cast<Ship*>(it->body);
-			if (ship && Ship::FLYING==ship->GetFlightState()) {
-				it->distance = m_owner->GetPositionRelTo(it->body).Length();
-				it->trail->Update(time);
-			} else {
-				it->trail->Reset(nullptr);
-			}
 			it->fresh = false;
 			++it;
 		}
@@ -167,19 +186,14 @@ void Sensors::PopulateStaticContacts()
 	PROFILE_SCOPED();
 	m_staticContacts.clear();
 
-	for (Body* b : Pi::game->GetSpace()->GetBodies()) {
-		switch (b->GetType())
-		{
-			case Object::STAR:
-			case Object::PLANET:
-			case Object::CITYONPLANET:
-			case Object::SPACESTATION:
-				break;
-			default:
-				continue;
+	const NavCache *nav = Pi::game->GetSpace()->GetNavCache();
+	const Object::Type types[] = { Object::STAR, Object::PLANET, Object::SPACESTATION };
+	for (Object::Type t : types) {
+		for (Body* b : nav->GetBodies(t)) {
+			if (b->GetType() != t) continue;
+			m_staticContacts.push_back(RadarContact(b));
+			RadarContact &rc = m_staticContacts.back();
+			rc.fresh = true;
 		}
-		m_staticContacts.push_back(RadarContact(b));
-		RadarContact &rc = m_staticContacts.back();
-		rc.fresh = true;
 	}
 }
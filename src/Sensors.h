@@ -6,13 +6,16 @@
 /*
  * Ship/station subsystem that holds a list of known contacts
  * and handles IFF
+ * The radar sweep runs every SWEEP_TICKS updates, with the sensors of
+ * different ships on different ticks. Contacts' distances and trails are
+ * still updated every time.
  * Some ideas:
  *  - targeting should be lost when going out of range
- *  - don't run radar sweep every frame (more of an optimization than simulation)
  *  - allow "pinned" radar contacts (visible at all ranges, for missions)
  */
 #include "libs.h"
 #include "Body.h"
+#include <unordered_map>
 
 class Body;
 class HudTrail;
@@ -56,11 +59,18 @@ public:
 	void UpdateIFF(Body*);
 	void ResetTrails();
 
+	static const int SWEEP_TICKS = 4;
+
 private:
 	Ship *m_owner;
 	ContactList m_radarContacts;
+	std::unordered_map<const Body*,ContactList::iterator> m_contactIters;
 	ContactList m_staticContacts; //things we know of regardless of range
 
+	int m_tick;
+	Uint32 m_removalSerial; // contacts may have gone if this has changed
+
+	void Sweep();
 	void PopulateStaticContacts();
 };
 
@@ -18,51 +18,29 @@ void Writer::Byte(Uint8 x) {
 void Writer::Bool(bool x) {
 	Byte(Uint8(x));
 }
+// each value goes in with one append, rather than a push_back per byte
 void Writer::Int16(Uint16 x) {
-	m_str.push_back(char(x&0xff));
-	m_str.push_back(char((x>>8)&0xff));
+	const char b[2] = { char(x&0xff), char((x>>8)&0xff) };
+	m_str.append(b, sizeof(b));
 }
 void Writer::Int32(Uint32 x) {
-	m_str.push_back(char(x&0xff));
-	m_str.push_back(char((x>>8)&0xff));
-	m_str.push_back(char((x>>16)&0xff));
-	m_str.push_back(char((x>>24)&0xff));
+	const char b[4] = { char(x&0xff), char((x>>8)&0xff), char((x>>16)&0xff), char((x>>24)&0xff) };
+	m_str.append(b, sizeof(b));
 }
 void Writer::Int64(Uint64 x) {
-	m_str.push_back(char(x&0xff));
-	m_str.push_back(char((x>>8)&0xff));
-	m_str.push_back(char((x>>16)&0xff));
-	m_str.push_back(char((x>>24)&0xff));
-	m_str.push_back(char((x>>32)&0xff));
-	m_str.push_back(char((x>>40)&0xff));
-	m_str.push_back(char((x>>48)&0xff));
-	m_str.push_back(char((x>>56)&0xff));
+	const char b[8] = {
+		char(x&0xff), char((x>>8)&0xff), char((x>>16)&0xff), char((x>>24)&0xff),
+		char((x>>32)&0xff), char((x>>40)&0xff), char((x>>48)&0xff), char((x>>56)&0xff)
+	};
+	m_str.append(b, sizeof(b));
 }
 void Writer::Float(float f) {
 	// not portable across architectures?
-	unsigned int i;
-	union {
-		unsigned char c[sizeof (float)];
-		float f;
-	} p;
-	p.f = f;
-
-	for (i=0; i<sizeof (float); i++) {
-		Byte (p.c[i]);
-	}
+	m_str.append(reinterpret_cast<const char*>(&f), sizeof(f));
 }
 void Writer::Double(double f) {
 	// not portable across architectures
-	unsigned int i;
-	union {
-		unsigned char c[sizeof (double)];
-		double f;
-	} p;
-	p.f = f;
-
-	for (i=0; i<sizeof (double); i++) {
-		Byte (p.c[i]);
-	}
+	m_str.append(reinterpret_cast<const char*>(&f), sizeof(f));
 }
 /* First byte is string length, including null terminator */
 void Writer::String(const char* s)
@@ -73,23 +51,45 @@ void Writer::String(const char* s)
 		return;
 	}
 
-	Int32(strlen(s)+1);
-
-	while (*s) {
-		Byte(*s);
-		s++;
-	}
-	Byte(*s);
+	const size_t len = strlen(s);
+	Int32(len+1);
+	m_str.append(s, len+1);
 }
 
 void Writer::String(const std::string &s)
 {
 	Int32(s.size()+1);
+	m_str.append(s.c_str(), s.size()+1);
+}
 
-	for(size_t i=0; i<s.size(); i++) {
-		Byte(s[i]);
-	}
+size_t Writer::BeginSection(const std::string &section_label)
+{
+	String(section_label);
+	const size_t mark = m_str.size();
+	Int32(0);
+	return mark;
+}
+
+void Writer::EndSection(size_t mark)
+{
+	assert(mark + 4 <= m_str.size());
 	Byte(0);
+	// the same length String() would have written, null included
+	const Uint32 size = Uint32(m_str.size() - mark - 4);
+	m_str[mark]   = char(size&0xff);
+	m_str[mark+1] = char((size>>8)&0xff);
+	m_str[mark+2] = char((size>>16)&0xff);
+	m_str[mark+3] = char((size>>24)&0xff);
+}
+
+void Writer::AlignedBlob(const char *data, size_t size, size_t alignment)
+{
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+	Int32(size);
+	const size_t padding = (alignment - (m_str.size() & (alignment - 1))) & (alignment - 1);
+	m_str.append(padding, '\0');
+	if (size > 0)
+		m_str.append(data, size);
 }
 
 void Writer::Vector3f(vector3f vec)
@@ -142,6 +142,15 @@ Uint8 Reader::Byte()
 	return Uint8(*m_at++);
 }
 
+void Reader::Bytes(void *out, size_t size)
+{
+#ifdef DEBUG
+	assert(size <= size_t(m_data.end - m_at));
+#endif /* DEBUG */
+	memcpy(out, m_at, size);
+	m_at += size;
+}
+
 bool Reader::Bool()
 {
 	return Byte() != 0;
@@ -149,60 +158,38 @@ bool Reader::Bool()
 
 Uint16 Reader::Int16()
 {
-	int t1, t2;
-	t2 = Byte();
-	t1 = Byte();
-	return ((t1 << 8) | t2);
+	Uint8 b[2];
+	Bytes(b, sizeof(b));
+	return Uint16(b[0] | (b[1] << 8));
 }
 Uint32 Reader::Int32(void)
 {
-	int t1, t2, t3, t4;
-	t4 = Byte();
-	t3 = Byte();
-	t2 = Byte();
-	t1 = Byte();
-	return ((t1 << 24) | (t2 << 16) | (t3 << 8) | t4);
+	Uint8 b[4];
+	Bytes(b, sizeof(b));
+	return Uint32(b[0]) | (Uint32(b[1]) << 8) | (Uint32(b[2]) << 16) | (Uint32(b[3]) << 24);
 }
 Uint64 Reader::Int64(void)
 {
-	Uint64 t1, t2, t3, t4, t5, t6, t7, t8;
-	t8 = Byte();
-	t7 = Byte();
-	t6 = Byte();
-	t5 = Byte();
-	t4 = Byte();
-	t3 = Byte();
-	t2 = Byte();
-	t1 = Byte();
-	return ((t1<<56) | (t2<<48) | (t3<<40) | (t4<<32) | (t5 << 24) | (t6 << 16) | (t7 << 8) | t8);
+	Uint8 b[8];
+	Bytes(b, sizeof(b));
+	Uint64 x = 0;
+	for (int i = 7; i >= 0; i--)
+		x = (x << 8) | b[i];
+	return x;
 }
 
 float Reader::Float ()
 {
-	unsigned int i;
-	union {
-		unsigned char c[sizeof (float)];
-		float f;
-	} p;
-
-	for (i=0; i<sizeof (float); i++) {
-		p.c[i] = Byte ();
-	}
-	return p.f;
+	float f;
+	Bytes(&f, sizeof(f));
+	return f;
 }
 
 double Reader::Double ()
 {
-	unsigned int i;
-	union {
-		unsigned char c[sizeof (double)];
-		double f;
-	} p;
-
-	for (i=0; i<sizeof (double); i++) {
-		p.c[i] = Byte ();
-	}
-	return p.f;
+	double f;
+	Bytes(&f, sizeof(f));
+	return f;
 }
 
 ByteRange Reader::Blob()
@@ -224,6 +211,23 @@ ByteRange Reader::Blob()
 	return range;
 }
 
+ByteRange Reader::AlignedBlob(size_t alignment)
+{
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+	size_t size = Int32();
+	const size_t padding = (alignment - (size_t(m_at - m_data.begin) & (alignment - 1))) & (alignment - 1);
+	if (padding + size > size_t(m_data.end - m_at)) {
+		assert(0 && "Serializer:Reader stream is truncated");
+		m_at = m_data.end;
+		return ByteRange();
+	}
+
+	m_at += padding;
+	ByteRange range = ByteRange(m_at, size);
+	m_at += size;
+	return range;
+}
+
 std::string Reader::String()
 {
 	ByteRange range = Blob();
@@ -38,10 +38,20 @@ namespace Serializer {
 		void Vector3d(vector3d vec);
 		void WrQuaternionf(const Quaternionf &q);
 		void Color4UB(const Color&);
+		// size, then padding so the data starts on a multiple of alignment
+		// from the start of the stream. for bulk data that's used in place
+		void AlignedBlob(const char *data, size_t size, size_t alignment);
 		void WrSection(const std::string &section_label, const std::string &section_data) {
 			String(section_label);
 			String(section_data);
 		}
+		// a section written in place, as WrSection would write it, without
+		// building it up in a string of its own first. BeginSection returns
+		// the mark to give EndSection once the section's data is written
+		size_t BeginSection(const std::string &section_label);
+		void EndSection(size_t mark);
+		// room for size more bytes, for writers that know about how much is coming
+		void Reserve(size_t size) { m_str.reserve(m_str.size() + size); }
 		/** Best not to use these except in templates */
 		void Auto(Sint32 x) { Int32(x); }
 		void Auto(Sint64 x) { Int64(x); }
@@ -67,6 +77,8 @@ namespace Serializer {
 		double Double ();
 		std::string String();
 		ByteRange Blob();
+		// points into the stream, nothing is copied
+		ByteRange AlignedBlob(size_t alignment);
 		vector3f Vector3f();
 		vector3d Vector3d();
 		Quaternionf RdQuaternionf();
@@ -88,6 +100,8 @@ namespace Serializer {
 		void SetStreamVersion(int x) { m_streamVersion = x; }
 
 	private:
+		void Bytes(void *out, size_t size);
+
 		ByteRange m_data;
 		const char *m_at;
 		int m_streamVersion;
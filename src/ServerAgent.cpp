@@ -20,26 +20,39 @@ void NullServerAgent::ProcessResponses()
 }
 
 
+// requests sending more than this go in the bulk queue
+static const size_t BULK_REQUEST_SIZE = 16 * 1024;
+// how many of the transfers can be bulk ones, so there's always room for
+// the small calls
+static const int MAX_BULK_IN_FLIGHT = 1;
+// longest the worker sleeps in curl before looking at the queue again
+static const int POLL_INTERVAL_MS = 10;
+
 bool HTTPServerAgent::s_initialised = false;
 
-HTTPServerAgent::HTTPServerAgent(const std::string &endpoint) :
-	m_endpoint(endpoint)
+HTTPServerAgent::HTTPServerAgent(const std::string &endpoint, int maxRequests, int timeoutMs) :
+	m_endpoint(endpoint),
+	m_maxRequests(std::max(1, maxRequests)),
+	m_timeoutMs(std::max(0, timeoutMs)),
+	m_bulkInFlight(0),
+	m_quit(false)
 {
-	if (!s_initialised)
+	if (!s_initialised) {
 		curl_global_init(CURL_GLOBAL_ALL);
+		s_initialised = true;
+	}
 
-	m_curl = curl_easy_init();
-	//curl_easy_setopt(m_curl, CURLOPT_VERBOSE, 1);
-
-	curl_easy_setopt(m_curl, CURLOPT_POST, 1);
-
-	curl_easy_setopt(m_curl, CURLOPT_READFUNCTION, HTTPServerAgent::FillRequestBuffer);
-	curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, HTTPServerAgent::FillResponseBuffer);
+	// the multi handle keeps connections open between calls and lets them
+	// share one where the server supports it
+	m_curlMulti = curl_multi_init();
+#ifdef CURLPIPE_MULTIPLEX
+	curl_multi_setopt(m_curlMulti, CURLMOPT_PIPELINING, long(CURLPIPE_MULTIPLEX));
+#endif
+	curl_multi_setopt(m_curlMulti, CURLMOPT_MAX_HOST_CONNECTIONS, long(m_maxRequests));
 
 	m_curlHeaders = 0;
 	m_curlHeaders = curl_slist_append(m_curlHeaders, ("User-agent: " + UserAgent()).c_str());
 	m_curlHeaders = curl_slist_append(m_curlHeaders, "Content-type: application/json");
-	curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, m_curlHeaders);
 
 	m_requestQueueLock = SDL_CreateMutex();
 	m_requestQueueCond = SDL_CreateCond();
@@ -51,35 +64,40 @@ HTTPServerAgent::HTTPServerAgent(const std::string &endpoint) :
 
 HTTPServerAgent::~HTTPServerAgent()
 {
-	// flush the queue
+	// tell the thread to stop, and wait for it. anything still queued or in
+	// flight is dropped
 	SDL_LockMutex(m_requestQueueLock);
-	while (m_requestQueue.size() > 0)
-		m_requestQueue.pop();
+	m_quit = true;
+	m_requestQueue.clear();
+	m_bulkQueue.clear();
 	SDL_UnlockMutex(m_requestQueueLock);
-
-	// signal the thread. empty queue will cause it to exit
 	SDL_CondBroadcast(m_requestQueueCond);
+	SDL_WaitThread(m_thread, 0);
 
-	// first thing the queue does is check the queue, so we must
-	// not shut down until its done that. it will release the queue
-	// lock before it dies, so try to take it
-	SDL_LockMutex(m_requestQueueLock);
+	for (Transfer &t : m_transfers) {
+		curl_multi_remove_handle(m_curlMulti, t.curl);
+		curl_easy_cleanup(t.curl);
+	}
+	for (CURL *curl : m_idleHandles)
+		curl_easy_cleanup(curl);
+	curl_multi_cleanup(m_curlMulti);
 
-	// we have the lock, so we know the thread won't doing anything
-	// else. we can clean up now
 	SDL_DestroyMutex(m_responseQueueLock);
 	SDL_DestroyMutex(m_requestQueueLock);
 	SDL_DestroyCond(m_requestQueueCond);
 
 	curl_slist_free_all(m_curlHeaders);
-
-	curl_easy_cleanup(m_curl);
 }
 
 void HTTPServerAgent::Call(const std::string &method, const Json::Value &data, SuccessCallback onSuccess, FailCallback onFail, void *userdata)
 {
+	Request req(method, data, onSuccess, onFail, userdata);
+	Json::FastWriter writer;
+	req.buffer = writer.write(req.data);
+	const bool bulk = req.buffer.size() > BULK_REQUEST_SIZE;
+
 	SDL_LockMutex(m_requestQueueLock);
-	m_requestQueue.push(Request(method, data, onSuccess, onFail, userdata));
+	(bulk ? m_bulkQueue : m_requestQueue).push_back(req);
 	SDL_UnlockMutex(m_requestQueueLock);
 
 	SDL_CondBroadcast(m_requestQueueCond);
@@ -89,12 +107,10 @@ void HTTPServerAgent::ProcessResponses()
 {
 	std::queue<Response> responseQueue;
 
-	// make a copy of the response queue so we can process
-	// the response at our leisure
+	// take the whole response queue so we can process
+	// the responses at our leisure
 	SDL_LockMutex(m_responseQueueLock);
-	responseQueue = m_responseQueue;
-	while (m_responseQueue.size() > 0)
-		m_responseQueue.pop();
+	std::swap(responseQueue, m_responseQueue);
 	SDL_UnlockMutex(m_responseQueueLock);
 
 	while (responseQueue.size() > 0) {
@@ -122,72 +138,124 @@ void HTTPServerAgent::ThreadMain()
 		// look for requests
 		SDL_LockMutex(m_requestQueueLock);
 
-		// if there's no requests, wait until the main thread wakes us
-		if (m_requestQueue.size() == 0)
+		// if there's nothing to do, wait until the main thread wakes us
+		if (!m_quit && m_transfers.empty() && m_requestQueue.empty() && m_bulkQueue.empty())
 			SDL_CondWait(m_requestQueueCond, m_requestQueueLock);
 
-		// woken up but nothing on the queue means we're being destroyed
-		if (m_requestQueue.size() == 0) {
-			// main thread is waiting for this lock, and will start
-			// cleanup as soon as it has it
+		if (m_quit) {
 			SDL_UnlockMutex(m_requestQueueLock);
-
-			// might be cleaned up already, so don't do anything else,
-			// just get out of here
 			return;
 		}
 
-		// grab a request
-		Request req = m_requestQueue.front();
-		m_requestQueue.pop();
+		// start as many as there's room for, small ones first
+		while (int(m_transfers.size()) < m_maxRequests) {
+			if (!m_requestQueue.empty()) {
+				StartTransfer(m_requestQueue.front(), false);
+				m_requestQueue.pop_front();
+			} else if (!m_bulkQueue.empty() && m_bulkInFlight < MAX_BULK_IN_FLIGHT) {
+				StartTransfer(m_bulkQueue.front(), true);
+				m_bulkQueue.pop_front();
+			} else
+				break;
+		}
 
 		// done with the queue
 		SDL_UnlockMutex(m_requestQueueLock);
 
-		Json::FastWriter writer;
-		req.buffer = writer.write(req.data);
-
-		Response resp(req.onSuccess, req.onFail, req.userdata);
+		if (m_transfers.empty())
+			continue;
 
-		curl_easy_setopt(m_curl, CURLOPT_URL, std::string(m_endpoint+"/"+req.method).c_str());
-		curl_easy_setopt(m_curl, CURLOPT_POSTFIELDSIZE, req.buffer.size());
-		curl_easy_setopt(m_curl, CURLOPT_READDATA, &req);
-		curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &resp);
+		int running;
+		curl_multi_perform(m_curlMulti, &running);
 
-		CURLcode rc = curl_easy_perform(m_curl);
-		resp.success = rc == CURLE_OK;
-		if (!resp.success)
-			resp.buffer = std::string("call failed: " + std::string(curl_easy_strerror(rc)));
-
-		if (resp.success) {
-			uint32_t code;
-			curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &code);
-			if (code != 200) {
-				resp.success = false;
-				resp.buffer = stringf("call returned HTTP status: %0{d}", code);
-			}
+		CURLMsg *msg;
+		int remaining;
+		while ((msg = curl_multi_info_read(m_curlMulti, &remaining))) {
+			if (msg->msg != CURLMSG_DONE)
+				continue;
+			Transfer *t = 0;
+			curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&t));
+			FinishTransfer(t, msg->data.result);
 		}
 
-		if (resp.success) {
-			Json::Reader reader;
-			resp.success = reader.parse(resp.buffer, resp.data, false);
-			if (!resp.success)
-				resp.buffer = std::string("JSON parse error: " + reader.getFormattedErrorMessages());
-		}
+		// sleep until there's something to read, but not for long so new
+		// calls get started soon after they come in
+		if (!m_transfers.empty())
+			curl_multi_wait(m_curlMulti, 0, 0, POLL_INTERVAL_MS, 0);
+	}
+}
 
-		SDL_LockMutex(m_responseQueueLock);
-		m_responseQueue.push(resp);
-		SDL_UnlockMutex(m_responseQueueLock);
+void HTTPServerAgent::StartTransfer(const Request &req, bool bulk)
+{
+	CURL *curl;
+	if (m_idleHandles.empty()) {
+		curl = curl_easy_init();
+		//curl_easy_setopt(curl, CURLOPT_VERBOSE, 1);
+		curl_easy_setopt(curl, CURLOPT_POST, 1L);
+		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, HTTPServerAgent::FillResponseBuffer);
+		curl_easy_setopt(curl, CURLOPT_HTTPHEADER, m_curlHeaders);
+		curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+		curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, long(m_timeoutMs));
+	} else {
+		curl = m_idleHandles.back();
+		m_idleHandles.pop_back();
 	}
+
+	m_transfers.push_back(Transfer(req, curl, bulk));
+	Transfer &t = m_transfers.back();
+	if (bulk)
+		m_bulkInFlight++;
+
+	// the body is sent straight from the request, which lives as long as the transfer
+	curl_easy_setopt(curl, CURLOPT_URL, std::string(m_endpoint+"/"+t.request.method).c_str());
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, t.request.buffer.data());
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, long(t.request.buffer.size()));
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &t.response);
+	curl_easy_setopt(curl, CURLOPT_PRIVATE, &t);
+
+	curl_multi_add_handle(m_curlMulti, curl);
 }
 
-size_t HTTPServerAgent::FillRequestBuffer(char *ptr, size_t size, size_t nmemb, void *userdata)
+void HTTPServerAgent::FinishTransfer(Transfer *t, CURLcode rc)
 {
-	HTTPServerAgent::Request *req = reinterpret_cast<HTTPServerAgent::Request*>(userdata);
-	size_t amount = std::max(size*nmemb, req->buffer.size());
-	memcpy(ptr, req->buffer.data(), amount);
-	req->buffer.erase(0, amount);
-	return amount;
+	Response &resp = t->response;
+
+	resp.success = rc == CURLE_OK;
+	if (!resp.success)
+		resp.buffer = std::string("call failed: " + std::string(curl_easy_strerror(rc)));
+
+	if (resp.success) {
+		long code;
+		curl_easy_getinfo(t->curl, CURLINFO_RESPONSE_CODE, &code);
+		if (code != 200) {
+			resp.success = false;
+			resp.buffer = stringf("call returned HTTP status: %0{d}", int(code));
+		}
+	}
+
+	if (resp.success) {
+		Json::Reader reader;
+		resp.success = reader.parse(resp.buffer, resp.data, false);
+		if (!resp.success)
+			resp.buffer = std::string("JSON parse error: " + reader.getFormattedErrorMessages());
+	}
+
+	SDL_LockMutex(m_responseQueueLock);
+	m_responseQueue.push(resp);
+	SDL_UnlockMutex(m_responseQueueLock);
+
+	// the handle goes back for reuse, keeping its connection
+	curl_multi_remove_handle(m_curlMulti, t->curl);
+	m_idleHandles.push_back(t->curl);
+	if (t->bulk)
+		m_bulkInFlight--;
+
+	for (auto i = m_transfers.begin(); i != m_transfers.end(); ++i) {
+		if (&*i == t) {
+			m_transfers.erase(i);
+			break;
+		}
+	}
 }
 
 size_t HTTPServerAgent::FillResponseBuffer(char *ptr, size_t size, size_t nmemb, void *userdata)
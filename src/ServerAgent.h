@@ -5,6 +5,8 @@
 #define SERVERAGENT_H
 
 #include "libs.h"
+#include <deque>
+#include <list>
 #include <map>
 #include <queue>
 #include <json/json.h>
@@ -48,9 +50,12 @@ private:
 };
 
 
+// calls run on a worker thread through a curl multi handle. a few can be in
+// flight at once over kept-alive connections, and big uploads queue
+// separately so they can't hold up the small calls
 class HTTPServerAgent : public ServerAgent {
 public:
-	HTTPServerAgent(const std::string &endpoint);
+	HTTPServerAgent(const std::string &endpoint, int maxRequests = 4, int timeoutMs = 30000);
 	virtual ~HTTPServerAgent();
 
 	virtual void Call(const std::string &method, const Json::Value &data, SuccessCallback onSuccess = sigc::ptr_fun(&ServerAgent::IgnoreSuccessCallback), FailCallback onFail = sigc::ptr_fun(&ServerAgent::IgnoreFailCallback), void *userdata = 0);
@@ -63,8 +68,8 @@ private:
 		Request(const std::string &_method, const Json::Value &_data, SuccessCallback _onSuccess, FailCallback _onFail, void *_userdata) :
 			method(_method), data(_data), onSuccess(_onSuccess), onFail(_onFail), userdata(_userdata) {}
 
-		const std::string method;
-		const Json::Value data;
+		std::string method;
+		Json::Value data;
 
 		std::string buffer;
 
@@ -90,24 +95,45 @@ private:
 		void *userdata;
 	};
 
+	// a call on the wire. lives in a list so curl can keep a pointer to it
+	struct Transfer {
+		Transfer(const Request &_request, CURL *_curl, bool _bulk) :
+			request(_request), response(_request.onSuccess, _request.onFail, _request.userdata), curl(_curl), bulk(_bulk) {}
+
+		Request request;
+		Response response;
+		CURL *curl;
+		bool bulk;
+	};
+
 	static int ThreadEntry(void *data);
 	void ThreadMain();
+	void StartTransfer(const Request &req, bool bulk);
+	void FinishTransfer(Transfer *t, CURLcode rc);
 
 	static const std::string &UserAgent();
 
-	static size_t FillRequestBuffer(char *ptr, size_t size, size_t nmemb, void *userdata);
 	static size_t FillResponseBuffer(char *ptr, size_t size, size_t nmemb, void *userdata);
 
 	static bool s_initialised;
 
 	const std::string m_endpoint;
+	const int m_maxRequests;
+	const int m_timeoutMs;
 
 	SDL_Thread *m_thread;
 
-	CURL *m_curl;
+	// only touched by the worker thread
+	CURLM *m_curlMulti;
 	curl_slist *m_curlHeaders;
-
-	std::queue<Request> m_requestQueue;
+	std::vector<CURL*> m_idleHandles;
+	std::list<Transfer> m_transfers;
+	int m_bulkInFlight;
+
+	// requests are small or bulk by the size of what they send
+	std::deque<Request> m_requestQueue;
+	std::deque<Request> m_bulkQueue;
+	bool m_quit;
 	SDL_mutex *m_requestQueueLock;
 	SDL_cond *m_requestQueueCond;
 
@@ -0,0 +1,388 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "SessionRecording.h"
+#include "SimBenchmark.h"
+#include "FrameTimings.h"
+#include "FileSystem.h"
+#include "Game.h"
+#include "Pi.h"
+#include "Serializer.h"
+#include "graphics/Graphics.h"
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+namespace SessionRecording {
+
+static const Uint32 MAGIC = 0x43455250; // "PREC"
+static const Uint32 VERSION = 1;
+static const char RECORDING_DIR[] = "recordings";
+
+struct FileHeader {
+	Uint32 magic;
+	Uint32 version;
+	Uint32 eventSize; // events are stored raw
+	Uint32 seed;
+	Uint32 width, height;
+	Uint32 saveNameLength; // the name follows the header
+};
+
+// followed by the frame's events
+struct FrameHeader {
+	float frameTime;
+	Uint8 timeAccel;
+	Uint8 requestedTimeAccel;
+	Uint16 pad;
+	Uint32 numEvents;
+};
+
+enum State {
+	STATE_IDLE,
+	STATE_START_RECORDING,
+	STATE_RECORDING,
+	STATE_STOP_RECORDING,
+	STATE_REPLAYING
+};
+
+static State s_state = STATE_IDLE;
+static FILE *s_file = nullptr;
+static Uint32 s_seed;
+static Uint32 s_frames;
+// the frame being recorded, or played back
+static FrameHeader s_frame;
+static std::vector<SDL_Event> s_events;
+static size_t s_nextEvent;
+
+// playback
+static bool s_realtime;
+static bool s_replayEnded;
+static bool s_frameReplayed;
+static Uint32 s_corrections;
+static Uint64 s_startCounter;
+static double s_recordedTime;
+static FILE *s_csv = nullptr;
+
+bool IsRecording() { return s_state == STATE_RECORDING || s_state == STATE_STOP_RECORDING; }
+bool IsReplaying() { return s_state == STATE_REPLAYING; }
+
+// ones that can't be stored raw, or that only make sense for the window
+// they came to
+static bool Recordable(const SDL_Event &event)
+{
+	switch (event.type) {
+		case SDL_QUIT:
+		case SDL_WINDOWEVENT:
+		case SDL_SYSWMEVENT:
+		case SDL_DROPFILE:
+			return false;
+		default:
+			return event.type < SDL_USEREVENT;
+	}
+}
+
+static bool StartRecording()
+{
+	char stamp[32];
+	const time_t now = time(0);
+	strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+
+	const std::string saveName = std::string("_recording-") + stamp;
+	try {
+		Game::SaveGame(saveName, Pi::game);
+	}
+	catch (CannotSaveCurrentGameState) {
+		Output("recording: can't save the game here\n");
+		return false;
+	}
+	catch (CouldNotOpenFileException) {
+		Output("recording: couldn't write save '%s'\n", saveName.c_str());
+		return false;
+	}
+
+	FileSystem::userFiles.MakeDirectory(RECORDING_DIR);
+	const std::string path = FileSystem::JoinPath(RECORDING_DIR, std::string("recording-") + stamp + ".rec");
+	s_file = FileSystem::userFiles.OpenWriteStream(path);
+	if (!s_file) {
+		Output("recording: couldn't open '%s' for writing\n", path.c_str());
+		return false;
+	}
+
+	s_seed = Uint32(now);
+	Pi::rng.seed(s_seed);
+	s_frames = 0;
+
+	FileHeader header;
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.eventSize = sizeof(SDL_Event);
+	header.seed = s_seed;
+	header.width = Graphics::GetScreenWidth();
+	header.height = Graphics::GetScreenHeight();
+	header.saveNameLength = saveName.size();
+	fwrite(&header, sizeof(header), 1, s_file);
+	fwrite(saveName.data(), 1, saveName.size(), s_file);
+
+	Output("recording to '%s', from save '%s'\n", path.c_str(), saveName.c_str());
+	return true;
+}
+
+static void StopRecording()
+{
+	fclose(s_file);
+	s_file = nullptr;
+	s_events.clear();
+	s_state = STATE_IDLE;
+	Output("recording stopped after %u frames\n", s_frames);
+}
+
+static void WriteFrame()
+{
+	s_frame.numEvents = s_events.size();
+	bool ok = fwrite(&s_frame, sizeof(s_frame), 1, s_file) == 1;
+	if (ok && !s_events.empty())
+		ok = fwrite(&s_events[0], sizeof(SDL_Event), s_events.size(), s_file) == s_events.size();
+	if (!ok) {
+		Output("recording: write failed\n");
+		StopRecording();
+		return;
+	}
+	s_frames++;
+}
+
+void ToggleRecording()
+{
+	switch (s_state) {
+		case STATE_IDLE:
+			s_state = STATE_START_RECORDING;
+			break;
+		case STATE_START_RECORDING:
+			s_state = STATE_IDLE;
+			break;
+		case STATE_RECORDING:
+			s_state = STATE_STOP_RECORDING;
+			break;
+		default:
+			break;
+	}
+}
+
+void Stop()
+{
+	if (IsRecording())
+		StopRecording();
+	else if (s_state == STATE_START_RECORDING)
+		s_state = STATE_IDLE;
+}
+
+static void EndReplay(const char *why)
+{
+	if (s_replayEnded)
+		return;
+	s_replayEnded = true;
+	s_events.clear();
+	Output("replay: %s after %u frames\n", why, s_frames);
+	Pi::RequestEndGame();
+}
+
+static void BeginReplayFrame(float &frameTime)
+{
+	s_events.clear();
+	s_nextEvent = 0;
+	s_frameReplayed = false;
+	// once it's over the game runs on the clock until it has ended
+	if (s_replayEnded)
+		return;
+
+	if (fread(&s_frame, sizeof(s_frame), 1, s_file) != 1) {
+		EndReplay("end of recording");
+		return;
+	}
+	s_events.resize(s_frame.numEvents);
+	if (!s_events.empty() && fread(&s_events[0], sizeof(SDL_Event), s_events.size(), s_file) != s_events.size()) {
+		EndReplay("recording cut short");
+		return;
+	}
+
+	frameTime = s_frame.frameTime;
+	s_frameReplayed = true;
+
+	const Game::TimeAccel accel = Game::TimeAccel(s_frame.timeAccel);
+	const Game::TimeAccel requested = Game::TimeAccel(s_frame.requestedTimeAccel);
+	if (Pi::game->GetRequestedTimeAccel() != requested)
+		Pi::game->RequestTimeAccel(requested);
+	if (Pi::game->GetTimeAccel() != accel) {
+		// the save doesn't keep it, so the first frame is expected to differ
+		if (s_frames > 0 && s_corrections++ == 0)
+			Output("replay: time acceleration drifted at frame %u\n", s_frames);
+		Pi::game->SetTimeAccel(accel);
+	}
+
+	if (s_frames == 0) {
+		Pi::rng.seed(s_seed);
+		s_startCounter = SDL_GetPerformanceCounter();
+		s_recordedTime = 0.0;
+	} else if (s_realtime) {
+		// each frame starts when it did in the recording, or as soon after
+		// as it can
+		s_recordedTime += s_frame.frameTime;
+		const double elapsed = double(SDL_GetPerformanceCounter() - s_startCounter) / double(SDL_GetPerformanceFrequency());
+		if (s_recordedTime > elapsed)
+			SDL_Delay(Uint32((s_recordedTime - elapsed) * 1e3));
+	}
+	s_frames++;
+}
+
+bool BeginFrame(float &frameTime)
+{
+	bool started = false;
+	if (s_state == STATE_START_RECORDING) {
+		started = StartRecording();
+		s_state = started ? STATE_RECORDING : STATE_IDLE;
+	}
+
+	if (s_state == STATE_RECORDING) {
+		s_frame.frameTime = frameTime;
+		s_frame.timeAccel = Uint8(Pi::game->GetTimeAccel());
+		s_frame.requestedTimeAccel = Uint8(Pi::game->GetRequestedTimeAccel());
+		s_frame.pad = 0;
+		s_events.clear();
+	} else if (s_state == STATE_REPLAYING)
+		BeginReplayFrame(frameTime);
+
+	return started;
+}
+
+bool PollEvent(SDL_Event *event)
+{
+	if (s_state != STATE_REPLAYING) {
+		if (!SDL_PollEvent(event))
+			return false;
+		if (s_state == STATE_RECORDING && Recordable(*event))
+			s_events.push_back(*event);
+		return true;
+	}
+
+	// real input is dropped, except for a request to quit, which ends the
+	// replay early
+	SDL_Event real;
+	while (SDL_PollEvent(&real))
+		if (real.type == SDL_QUIT)
+			EndReplay("stopped");
+
+	if (s_nextEvent >= s_events.size())
+		return false;
+	*event = s_events[s_nextEvent++];
+	return true;
+}
+
+void EndFrame(const FrameTimings *timings)
+{
+	switch (s_state) {
+		case STATE_RECORDING:
+			WriteFrame();
+			break;
+		case STATE_STOP_RECORDING:
+			// the frame it was stopped in isn't kept, so neither is the
+			// keypress that stopped it
+			StopRecording();
+			break;
+		case STATE_REPLAYING:
+			if (s_csv && s_frameReplayed) {
+				fprintf(s_csv, "%u,%.3f,%.3f", s_frames - 1, s_frame.frameTime * 1e3, timings->GetLastTotal() * 1e3);
+				for (int i = 0; i < FrameTimings::PHASE_MAX; i++)
+					fprintf(s_csv, ",%.3f", timings->GetLastPhase(FrameTimings::Phase(i)) * 1e3);
+				fputc('\n', s_csv);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+bool Replay(const std::string &filename, bool realtime)
+{
+	const std::string path = FileSystem::JoinPathBelow(RECORDING_DIR, filename);
+	FILE *f = FileSystem::userFiles.OpenReadStream(path);
+	if (!f) {
+		Output("replay: couldn't open '%s'\n", path.c_str());
+		return false;
+	}
+
+	FileHeader header;
+	if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != MAGIC) {
+		Output("replay: '%s' isn't a recording\n", path.c_str());
+		fclose(f);
+		return false;
+	}
+	if (header.version != VERSION || header.eventSize != sizeof(SDL_Event)) {
+		Output("replay: '%s' was recorded by another version\n", path.c_str());
+		fclose(f);
+		return false;
+	}
+	std::string saveName(header.saveNameLength, '\0');
+	if (!saveName.empty() && fread(&saveName[0], 1, saveName.size(), f) != saveName.size()) {
+		Output("replay: '%s' is corrupt\n", path.c_str());
+		fclose(f);
+		return false;
+	}
+	if (int(header.width) != Graphics::GetScreenWidth() || int(header.height) != Graphics::GetScreenHeight())
+		Output("replay: recorded at %ux%u, mouse input may not land where it did\n", header.width, header.height);
+
+	Pi::game = SimBenchmark::StartScenario(saveName);
+	if (!Pi::game) {
+		fclose(f);
+		return false;
+	}
+
+	s_file = f;
+	s_seed = header.seed;
+	s_frames = 0;
+	s_realtime = realtime;
+	s_replayEnded = false;
+	s_corrections = 0;
+
+	s_csv = FileSystem::userFiles.OpenWriteStream(path + ".csv", FileSystem::FileSourceFS::WRITE_TEXT);
+	if (s_csv) {
+		fputs("frame,recorded,total", s_csv);
+		for (int i = 0; i < FrameTimings::PHASE_MAX; i++)
+			fprintf(s_csv, ",%s", FrameTimings::GetPhaseName(FrameTimings::Phase(i)));
+		fputc('\n', s_csv);
+	} else
+		Output("replay: couldn't open '%s.csv' for writing\n", path.c_str());
+
+	Output("replay: '%s' from save '%s', seed %u, %s\n", path.c_str(), saveName.c_str(), s_seed,
+		realtime ? "in real time" : "as fast as it will go");
+
+	s_state = STATE_REPLAYING;
+#ifdef PIONEER_PROFILER
+	Profiler::tracestart();
+#endif
+	const Uint64 start = SDL_GetPerformanceCounter();
+
+	// the main loop returns once the game has ended
+	Pi::InitGame();
+	Pi::StartGame();
+	Pi::MainLoop();
+
+	const double seconds = double(SDL_GetPerformanceCounter() - start) / double(SDL_GetPerformanceFrequency());
+#ifdef PIONEER_PROFILER
+	if (Profiler::tracing()) {
+		Profiler::dumptrace(Pi::profilerPath.c_str());
+		Output("replay: trace written to %s\n", Pi::profilerPath.c_str());
+	}
+#endif
+	s_state = STATE_IDLE;
+	fclose(s_file);
+	s_file = nullptr;
+	s_events.clear();
+	if (s_csv) {
+		fclose(s_csv);
+		s_csv = nullptr;
+		Output("replay: frame timings written to '%s.csv'\n", path.c_str());
+	}
+	Output("replay: %u frames in %.2fs, time acceleration corrected %u times\n", s_frames, seconds, s_corrections);
+	return true;
+}
+
+}
@@ -0,0 +1,52 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SESSIONRECORDING_H
+#define _SESSIONRECORDING_H
+
+#include "libs.h"
+#include <string>
+
+/*
+ * Records a play session so it can be played back later, to reproduce a
+ * hitch or a slow patch someone ran into. A recording starts from a save
+ * made at the top of a frame, with the rng reseeded and the seed kept, and
+ * holds the length of each frame, its time acceleration and the SDL input
+ * events handled in it.
+ *
+ * Playing one back loads the save and drives Pi::MainLoop from it: the
+ * recorded frame times in place of the clock, the recorded events in place
+ * of SDL's, and the time acceleration put right if it has drifted. Frames
+ * run as fast as they'll go, or at the recorded pace, and their timings go
+ * to a CSV next to the recording.
+ *
+ * Not everything is replayed. Jobs on the async queue (terrain, sectors)
+ * finish when they finish, so what they feed can land a frame or two
+ * apart, and keys already held when recording starts aren't known to it.
+ * Events are stored raw, so recordings are only good for the same build.
+ */
+class FrameTimings;
+
+namespace SessionRecording {
+	// starts recording with the next frame, or stops
+	void ToggleRecording();
+	bool IsRecording();
+	bool IsReplaying();
+
+	// plays a recording (from the recordings directory) through the main
+	// loop. returns false if it couldn't be started
+	bool Replay(const std::string &filename, bool realtime);
+
+	// main loop hooks. BeginFrame swaps in the recorded frame time when
+	// playing back, and returns true when recording starts with this frame
+	// (the main loop should restart its physics accumulator then, as it
+	// does for a new game, since that's what playback will do)
+	bool BeginFrame(float &frameTime);
+	// in place of SDL_PollEvent
+	bool PollEvent(SDL_Event *event);
+	void EndFrame(const FrameTimings *timings);
+	// the game is ending
+	void Stop();
+}
+
+#endif
@@ -13,8 +13,10 @@
 #include "graphics/Graphics.h"
 #include "graphics/Material.h"
 #include "graphics/Renderer.h"
+#include "graphics/SpriteBatch.h"
 #include "graphics/TextureBuilder.h"
 #include "json/JsonUtils.h"
+#include <algorithm>
 
 using namespace Graphics;
 
@@ -50,7 +52,7 @@ void Sfx::SaveToJson(Json::Value &jsonObj)
 void Sfx::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("sfx")) throw SavedGameCorruptException();
-	Json::Value sfxObj = jsonObj["sfx"];
+	const Json::Value &sfxObj = jsonObj["sfx"];
 	if (!sfxObj.isMember("pos")) throw SavedGameCorruptException();
 	if (!sfxObj.isMember("vel")) throw SavedGameCorruptException();
 	if (!sfxObj.isMember("age")) throw SavedGameCorruptException();
@@ -85,7 +87,7 @@ void Sfx::ToJson(Json::Value &jsonObj, const Frame *f)
 void Sfx::FromJson(const Json::Value &jsonObj, Frame *f)
 {
 	if (!jsonObj.isMember("sfx_array")) throw SavedGameCorruptException();
-	Json::Value sfxArray = jsonObj["sfx_array"];
+	const Json::Value &sfxArray = jsonObj["sfx_array"];
 	if (!sfxArray.isArray()) throw SavedGameCorruptException();
 
 	if (sfxArray.size()) f->m_sfx = new Sfx[MAX_SFX_PER_FRAME];
@@ -122,46 +124,51 @@ void Sfx::TimeStepUpdate(const float timeStep)
 	}
 }
 
-void Sfx::Render(Renderer *renderer, const matrix4x4d &ftransform)
+// a camera facing quad of width size, in view space
+static void AddSprite(SpriteBatch &batch, const vector3f &pos, float size, const Color &c, RenderState *rs, Texture *tex)
 {
-	PROFILE_SCOPED()
-	vector3d fpos = ftransform * GetPosition();
-	vector3f pos(&fpos.x);
+	static const vector2f uvs[6] = {
+		vector2f(0.f, 0.f), vector2f(0.f, 1.f), vector2f(1.f, 0.f),
+		vector2f(1.f, 0.f), vector2f(0.f, 1.f), vector2f(1.f, 1.f)
+	};
+	const float sz = 0.5f * size;
+	const vector3f tl = pos + vector3f(-sz,  sz, 0.f);
+	const vector3f bl = pos + vector3f(-sz, -sz, 0.f);
+	const vector3f tr = pos + vector3f( sz,  sz, 0.f);
+	const vector3f br = pos + vector3f( sz, -sz, 0.f);
+	const vector3f verts[6] = { tl, bl, tr, tr, bl, br };
+	batch.Add(matrix4x4f::Identity(), verts, uvs, 6, c, rs, tex);
+}
 
+void Sfx::Render(SpriteBatch &batch)
+{
+	const vector3f &pos = m_viewPos;
 	switch (m_type) 
 	{
 		case TYPE_NONE: break;
 		case TYPE_EXPLOSION: 
 		{
-			renderer->SetTransform(matrix4x4d::Translation(fpos));
 			const int spriteframe = Clamp( Uint32(m_age*20.0f), Uint32(0), NUM_EXPLOSION_TEXTURES-1 );
 			assert(explosionTextures[spriteframe]);
-			explosionParticle->texture0 = explosionTextures[spriteframe];
-			//face camera
-			renderer->SetTransform(matrix4x4f::Identity());
-			renderer->DrawPointSprites(1, &pos, alphaOneState, explosionParticle.get(), m_speed);
+			AddSprite(batch, pos, m_speed, Color::WHITE, alphaOneState, explosionTextures[spriteframe]);
 			break;
 		} 
 		case TYPE_DAMAGE: 
 		{
-			renderer->SetTransform(matrix4x4d::Translation(fpos));
-			damageParticle->diffuse = Color(255, 255, 0, (1.0f-(m_age/2.0f))*255);
-			renderer->DrawPointSprites(1, &pos, additiveAlphaState, damageParticle.get(), 20.f);
+			const Color c(255, 255, 0, (1.0f-(m_age/2.0f))*255);
+			AddSprite(batch, pos, 20.f, c, additiveAlphaState, damageParticle->texture0);
 			break;
 		} 
 		case TYPE_SMOKE: 
 		{
 			float var = Pi::rng.Double()*0.05f; //slightly variation to trail color
+			Color c;
 			if (m_age < 0.5) { //start trail
-				smokeParticle->diffuse = Color((0.75f-var)*255, (0.75f-var)*255, (0.75f-var)*255, (m_age*0.5-(m_age/2.0f))*255);
+				c = Color((0.75f-var)*255, (0.75f-var)*255, (0.75f-var)*255, (m_age*0.5-(m_age/2.0f))*255);
 			} else { //end trail
-				smokeParticle->diffuse = Color((0.75-var)*255, (0.75f-var)*255, (0.75f-var)*255, Clamp(0.5*0.5-(m_age/16.0),0.0,1.0)*255);
+				c = Color((0.75-var)*255, (0.75f-var)*255, (0.75f-var)*255, Clamp(0.5*0.5-(m_age/16.0),0.0,1.0)*255);
 			}
-
-			renderer->SetTransform(matrix4x4d::Translation(fpos));
-
-			damageParticle->diffuse*=0.05;
-			renderer->DrawPointSprites(1, &pos, alphaState, smokeParticle.get(), (m_speed*m_age));
+			AddSprite(batch, pos, m_speed*m_age, c, alphaState, smokeParticle->texture0);
 			break;
 		}
 	}
@@ -183,13 +190,18 @@ Sfx *Sfx::AllocSfxInFrame(Frame *f)
 
 void Sfx::Add(const Body *b, TYPE t)
 {
-	Sfx *sfx = AllocSfxInFrame(b->GetFrame());
+	Add(b->GetFrame(), b->GetPosition(), b->GetVelocity(), t);
+}
+
+void Sfx::Add(Frame *f, const vector3d &pos, const vector3d &vel, TYPE t)
+{
+	Sfx *sfx = AllocSfxInFrame(f);
 	if (!sfx) return;
 
 	sfx->m_type = t;
 	sfx->m_age = 0;
-	sfx->SetPosition(b->GetPosition());
-	sfx->m_vel = b->GetVelocity() + 200.0*vector3d(
+	sfx->SetPosition(pos);
+	sfx->m_vel = vel + 200.0*vector3d(
 			Pi::rng.Double()-0.5,
 			Pi::rng.Double()-0.5,
 			Pi::rng.Double()-0.5);
@@ -240,25 +252,50 @@ void Sfx::TimeStepAll(const float timeStep, Frame *f)
 	}
 }
 
-void Sfx::RenderAll(Renderer *renderer, Frame *f, const Frame *camFrame)
+void Sfx::GatherVisible(Frame *f, const Frame *camFrame, std::vector<std::pair<float, Sfx*>> &visible)
 {
-	PROFILE_SCOPED()
 	if (f->m_sfx) {
 		matrix4x4d ftran;
 		Frame::GetFrameTransform(f, camFrame, ftran);
 
 		for (int i=0; i<MAX_SFX_PER_FRAME; i++) {
-			if (f->m_sfx[i].m_type != TYPE_NONE) {
-				f->m_sfx[i].Render(renderer, ftran);
-			}
+			Sfx &sfx = f->m_sfx[i];
+			if (sfx.m_type == TYPE_NONE)
+				continue;
+			sfx.m_viewPos = vector3f(ftran * sfx.m_pos);
+			visible.push_back(std::make_pair(sfx.m_viewPos.LengthSqr(), &sfx));
 		}
 	}
 
 	for (Frame* kid : f->GetChildren()) {
-		RenderAll(renderer, kid, camFrame);
+		GatherVisible(kid, camFrame, visible);
 	}
 }
 
+void Sfx::RenderAll(Renderer *renderer, Frame *f, const Frame *camFrame)
+{
+	PROFILE_SCOPED()
+	static std::vector<std::pair<float, Sfx*>> visible;
+	visible.clear();
+	GatherVisible(f, camFrame, visible);
+	if (visible.empty())
+		return;
+
+	// smoke is alpha blended, so everything goes far to near. the batch
+	// then draws each texture's sprites together, in that order
+	std::sort(visible.begin(), visible.end(), [](const std::pair<float, Sfx*> &a, const std::pair<float, Sfx*> &b) {
+		return a.first > b.first;
+	});
+
+	Graphics::Renderer::MatrixTicket mt(renderer, Graphics::MatrixMode::MODELVIEW);
+	renderer->SetTransform(matrix4x4f::Identity());
+	SpriteBatch &batch = renderer->GetSpriteBatch();
+	batch.Begin();
+	for (const auto &v : visible)
+		v.second->Render(batch);
+	batch.End();
+}
+
 void Sfx::Init(Graphics::Renderer *r)
 {
 	//shared render states
@@ -12,6 +12,7 @@
 class Frame;
 namespace Graphics {
 	class Renderer;
+	class SpriteBatch;
 	namespace Drawables {
 		class Sphere3D;
 	}
@@ -22,6 +23,7 @@ public:
 	enum TYPE { TYPE_NONE, TYPE_EXPLOSION, TYPE_DAMAGE, TYPE_SMOKE };
 
 	static void Add(const Body *, TYPE);
+	static void Add(Frame *f, const vector3d &pos, const vector3d &vel, TYPE);
 	static void AddExplosion(Body *, TYPE);
 	static void AddThrustSmoke(const Body *b, TYPE, float speed, vector3d adjustpos);
 	static void TimeStepAll(const float timeStep, Frame *f);
@@ -49,13 +51,17 @@ private:
 	static const Uint32 NUM_EXPLOSION_TEXTURES = 32;
 	static Graphics::Texture* explosionTextures[NUM_EXPLOSION_TEXTURES];
 
-	void Render(Graphics::Renderer *r, const matrix4x4d &transform);
+	// every effect in view goes in one sprite batch, so drawing them costs a
+	// draw per texture however many there are
+	static void GatherVisible(Frame *f, const Frame *camFrame, std::vector<std::pair<float, Sfx*>> &visible);
+	void Render(Graphics::SpriteBatch &batch);
 	void TimeStepUpdate(const float timeStep);
 	void SaveToJson(Json::Value &jsonObj);
 	void LoadFromJson(const Json::Value &jsonObj);
 
 	vector3d m_pos;
 	vector3d m_vel;
+	vector3f m_viewPos; // only while rendering
 	float m_age;
 	float m_speed;
 	enum TYPE m_type;
@@ -240,7 +240,7 @@ void Shields::SaveToJson(Json::Value &jsonObj)
 void Shields::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("shields")) throw SavedGameCorruptException();
-	Json::Value shieldsObj = jsonObj["shields"];
+	const Json::Value &shieldsObj = jsonObj["shields"];
 
 	if (!shieldsObj.isMember("enabled")) throw SavedGameCorruptException();
 	if (!shieldsObj.isMember("num_shields")) throw SavedGameCorruptException();
@@ -249,11 +249,11 @@ void Shields::LoadFromJson(const Json::Value &jsonObj)
 	m_enabled = shieldsObj["Enabled"].asBool();
 	assert(shieldsObj["num_shields"].asUInt() == m_shields.size());
 
-	Json::Value shieldArray = shieldsObj["shield_array"];
+	const Json::Value &shieldArray = shieldsObj["shield_array"];
 	if (!shieldArray.isArray()) throw SavedGameCorruptException();
 	for (unsigned int i = 0; i < shieldArray.size(); ++i)
 	{
-		Json::Value shieldArrayEl = shieldArray[i];
+		const Json::Value &shieldArrayEl = shieldArray[i];
 		if (!shieldArrayEl.isMember("mesh_name")) throw SavedGameCorruptException();
 		for (ShieldIterator it = m_shields.begin(); it != m_shields.end(); ++it)
 		{
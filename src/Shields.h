@@ -40,6 +40,7 @@ public:
 	virtual void LoadFromJson(const Json::Value &jsonObj);
 
 	void SetEnabled(const bool on) { m_enabled = on; }
+	bool IsEnabled() const { return m_enabled; }
 	void Update(const float coolDown, const float shieldStrength);
 	void SetColor(const Color3ub&);
 	void AddHit(const vector3d& hitPos);
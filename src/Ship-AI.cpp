@@ -20,7 +20,7 @@
 void Ship::AIModelCoordsMatchAngVel(const vector3d &desiredAngVel, double softness)
 {
 	double angAccel = m_type->angThrust / GetAngularInertia();
-	const double softTimeStep = Pi::game->GetTimeStep() * softness;
+	const double softTimeStep = AIGetTimeStep() * softness;
 
 	vector3d angVel = desiredAngVel - GetAngVelocity() * GetOrient();
 	vector3d thrust;
@@ -49,7 +49,7 @@ void Ship::AIAccelToModelRelativeVelocity(const vector3d &v)
 {
 	vector3d difVel = v - GetVelocity() * GetOrient();		// required change in velocity
 	vector3d maxThrust = GetMaxThrust(difVel);
-	vector3d maxFrameAccel = maxThrust * (Pi::game->GetTimeStep() / GetMass());
+	vector3d maxFrameAccel = maxThrust * (AIGetTimeStep() / GetMass());
 
 	SetThrusterState(0, is_zero_exact(maxFrameAccel.x) ? 0.0 : difVel.x / maxFrameAccel.x);
 	SetThrusterState(1, is_zero_exact(maxFrameAccel.y) ? 0.0 : difVel.y / maxFrameAccel.y);
@@ -60,10 +60,25 @@ void Ship::AIAccelToModelRelativeVelocity(const vector3d &v)
 // returns true if command is complete
 bool Ship::AITimeStep(float timeStep)
 {
+	m_aiTimeStep = timeStep;
+
 	// allow the launch thruster thing to happen
 	if (m_launchLockTimeout > 0.0) return false;
 
+	// already stepped in ParallelUpdate, just deal with the outcome. that
+	// step set m_decelerating, so it's left alone
+	if (m_aiPrestep != AIPRESTEP_NONE) {
+		const bool complete = (m_aiPrestep == AIPRESTEP_COMPLETE);
+		m_aiPrestep = AIPRESTEP_NONE;
+		if (complete && m_curAICmd) {
+			AIClearInstructions();
+			LuaEvent::Queue("onAICompleted", this, EnumStrings::GetString("ShipAIError", AIMessage()));
+		}
+		return complete;
+	}
+
 	m_decelerating = false;
+
 	if (!m_curAICmd) {
 		if (this == Pi::player) return true;
 
@@ -83,6 +98,33 @@ bool Ship::AITimeStep(float timeStep)
 	else return false;
 }
 
+// the step the ship's AI is working to. the same as the game's, unless the
+// simulation LOD is updating the ship less often
+float Ship::AIGetTimeStep() const
+{
+	return m_aiTimeStep > 0.0f ? m_aiTimeStep : Pi::game->GetTimeStep();
+}
+
+// whether the current command can be stepped from ParallelUpdate. anything
+// that might launch the ship, talk to a station or roll the shared rng has to
+// run in the normal serial step
+bool Ship::AICanStepInParallel() const
+{
+	if (!m_curAICmd || IsType(Object::PLAYER)) return false;
+	if (m_launchLockTimeout > 0.0 || m_flightState != FLYING) return false;
+	return m_curAICmd->IsThreadSafe();
+}
+
+void Ship::ParallelUpdate(const float timeStep)
+{
+	m_aiTimeStep = timeStep;
+	m_aiPrestep = AIPRESTEP_NONE;
+	if (IsDead() || !AICanStepInParallel()) return;
+
+	m_decelerating = false;
+	m_aiPrestep = m_curAICmd->TimeStepUpdate() ? AIPRESTEP_COMPLETE : AIPRESTEP_ACTIVE;
+}
+
 void Ship::AIClearInstructions()
 {
 	if (!m_curAICmd) return;
@@ -101,6 +143,7 @@ void Ship::AIGetStatusText(char *str)
 void Ship::AIKamikaze(Body *target)
 {
 	AIClearInstructions();
+	target->AddWatcher(this);
 	m_curAICmd = new AICmdKamikaze(this, target);
 }
 
@@ -109,6 +152,7 @@ void Ship::AIKill(Ship *target)
 	AIClearInstructions();
 	SetFuelReserve((GetFuel() < 0.5) ? GetFuel() / 2 : 0.25);
 
+	target->AddWatcher(this);
 	m_curAICmd = new AICmdKill(this, target);
 }
 
@@ -125,6 +169,7 @@ void Ship::AIFlyTo(Body *target)
 	AIClearInstructions();
 	SetFuelReserve((GetFuel() < 0.5) ? GetFuel() / 2 : 0.25);
 
+	target->AddWatcher(this);
 	if (target->IsType(Object::SHIP)) {		// test code
 		vector3d posoff(-1000.0, 0.0, 1000.0);
 		m_curAICmd = new AICmdFormation(this, static_cast<Ship*>(target), posoff);
@@ -137,6 +182,7 @@ void Ship::AIDock(SpaceStation *target)
 	AIClearInstructions();
 	SetFuelReserve((GetFuel() < 0.5) ? GetFuel() / 2 : 0.25);
 
+	target->AddWatcher(this);
 	m_curAICmd = new AICmdDock(this, target);
 }
 
@@ -164,14 +210,14 @@ void Ship::AIHoldPosition()
 // sometimes endvel is too low to catch moving objects
 // worked around with half-accel hack in dynamicbody & pi.cpp
 
-double calc_ivel(double dist, double vel, double acc)
+double calc_ivel(double dist, double vel, double acc, double timeStep)
 {
 	bool inv = false;
 	if (dist < 0) { dist = -dist; vel = -vel; inv = true; }
 	double ivel = 0.9 * sqrt(vel*vel + 2.0 * acc * dist);		// fudge hardly necessary
 
-	double endvel = ivel - (acc * Pi::game->GetTimeStep());
-	if (endvel <= 0.0) ivel = dist / Pi::game->GetTimeStep();	// last frame discrete correction
+	double endvel = ivel - (acc * timeStep);
+	if (endvel <= 0.0) ivel = dist / timeStep;	// last frame discrete correction
 	else ivel = (ivel + endvel) * 0.5;					// discrete overshoot correction
 //	else ivel = endvel + 0.5*acc/PHYSICS_HZ;			// unknown next timestep discrete overshoot correction
 
@@ -179,12 +225,12 @@ double calc_ivel(double dist, double vel, double acc)
 }
 
 // version for all-positive values
-double calc_ivel_pos(double dist, double vel, double acc)
+double calc_ivel_pos(double dist, double vel, double acc, double timeStep)
 {
 	double ivel = 0.9 * sqrt(vel*vel + 2.0 * acc * dist);		// fudge hardly necessary
 
-	double endvel = ivel - (acc * Pi::game->GetTimeStep());
-	if (endvel <= 0.0) ivel = dist / Pi::game->GetTimeStep();	// last frame discrete correction
+	double endvel = ivel - (acc * timeStep);
+	if (endvel <= 0.0) ivel = dist / timeStep;	// last frame discrete correction
 	else ivel = (ivel + endvel) * 0.5;					// discrete overshoot correction
 
 	return ivel;
@@ -203,11 +249,11 @@ bool Ship::AIMatchVel(const vector3d &vel)
 bool Ship::AIChangeVelBy(const vector3d &diffvel)
 {
 	// counter external forces
-	vector3d extf = GetExternalForce() * (Pi::game->GetTimeStep() / GetMass());
+	vector3d extf = GetExternalForce() * (AIGetTimeStep() / GetMass());
 	vector3d diffvel2 = diffvel - extf * GetOrient();
 
 	vector3d maxThrust = GetMaxThrust(diffvel2);
-	vector3d maxFrameAccel = maxThrust * (Pi::game->GetTimeStep() / GetMass());
+	vector3d maxFrameAccel = maxThrust * (AIGetTimeStep() / GetMass());
 	vector3d thrust(diffvel2.x / maxFrameAccel.x,
 					diffvel2.y / maxFrameAccel.y,
 					diffvel2.z / maxFrameAccel.z);
@@ -222,7 +268,7 @@ vector3d Ship::AIChangeVelDir(const vector3d &reqdiffvel)
 	// get max thrust in desired direction after external force compensation
 	vector3d maxthrust = GetMaxThrust(reqdiffvel);
 	maxthrust += GetExternalForce() * GetOrient();
-	vector3d maxFA = maxthrust * (Pi::game->GetTimeStep() / GetMass());
+	vector3d maxFA = maxthrust * (AIGetTimeStep() / GetMass());
 	maxFA.x = fabs(maxFA.x); maxFA.y = fabs(maxFA.y); maxFA.z = fabs(maxFA.z);
 
 	// crunch diffvel by relative thruster power to get acceleration in right direction
@@ -239,7 +285,7 @@ vector3d Ship::AIChangeVelDir(const vector3d &reqdiffvel)
 void Ship::AIMatchAngVelObjSpace(const vector3d &angvel)
 {
 	double maxAccel = m_type->angThrust / GetAngularInertia();
-	double invFrameAccel = 1.0 / (maxAccel * Pi::game->GetTimeStep());
+	double invFrameAccel = 1.0 / (maxAccel * AIGetTimeStep());
 
 	vector3d diff = angvel - GetAngVelocity() * GetOrient();		// find diff between current & desired angvel
 	SetAngThrusterState(diff * invFrameAccel);
@@ -249,7 +295,7 @@ void Ship::AIMatchAngVelObjSpace(const vector3d &angvel)
 double Ship::AIFaceUpdir(const vector3d &updir, double av)
 {
 	double maxAccel = m_type->angThrust / GetAngularInertia();		// should probably be in stats anyway
-	double frameAccel = maxAccel * Pi::game->GetTimeStep();
+	double frameAccel = maxAccel * AIGetTimeStep();
 
 	vector3d uphead = updir * GetOrient();			// create desired object-space updir
 	if (uphead.z > 0.99999) return 0;				// bail out if facing updir
@@ -259,7 +305,7 @@ double Ship::AIFaceUpdir(const vector3d &updir, double av)
 	if (uphead.y < 0.99999999)
 	{
 		ang = acos(Clamp(uphead.y, -1.0, 1.0));		// scalar angle from head to curhead
-		double iangvel = av + calc_ivel_pos(ang, 0.0, maxAccel);	// ideal angvel at current time
+		double iangvel = av + calc_ivel_pos(ang, 0.0, maxAccel, AIGetTimeStep());	// ideal angvel at current time
 
 		dav = uphead.x > 0 ? -iangvel : iangvel;
 	}
@@ -286,7 +332,7 @@ double Ship::AIFaceDirection(const vector3d &dir, double av)
 	if (head.z > -0.99999999)
 	{
 		ang = acos (Clamp(-head.z, -1.0, 1.0));		// scalar angle from head to curhead
-		double iangvel = av + calc_ivel_pos(ang, 0.0, maxAccel);	// ideal angvel at current time
+		double iangvel = av + calc_ivel_pos(ang, 0.0, maxAccel, AIGetTimeStep());	// ideal angvel at current time
 
 		// Normalize (head.x, head.y) to give desired angvel direction
 		if (head.z > 0.999999) head.x = 1.0;
@@ -295,7 +341,7 @@ double Ship::AIFaceDirection(const vector3d &dir, double av)
 		dav.y = -head.x * head2dnorm * iangvel;
 	}
 	const vector3d cav = GetAngVelocity() * GetOrient();				// current obj-rel angvel
-	const double frameAccel = maxAccel * Pi::game->GetTimeStep();
+	const double frameAccel = maxAccel * AIGetTimeStep();
 	vector3d diff = is_zero_exact(frameAccel) ? vector3d(0.0) : (dav - cav) / frameAccel;	// find diff between current & desired angvel
 
 	// If the player is pressing a roll key, don't override roll.
@@ -9,7 +9,7 @@
 #include "LuaUtils.h"
 #include "Missile.h"
 #include "Player.h"
-#include "Projectile.h"
+#include "ProjectileSystem.h"
 #include "ShipAICmd.h"
 #include "ShipController.h"
 #include "Sound.h"
@@ -32,7 +32,11 @@
 
 static const float TONS_HULL_PER_SHIELD = 10.f;
 static const double KINETIC_ENERGY_MULT	= 0.01;
+// ticks apart a ship in open flight may be updated, if it's far from the
+// player and the simulation LOD is on
+static const Uint32 SIM_LOD_MAX_INTERVAL = 4;
 HeatGradientParameters_t Ship::s_heatGradientParams;
+std::map<ShipType::Id, std::unique_ptr<Ship::Prototype> > Ship::s_prototypes;
 const float Ship::DEFAULT_SHIELD_COOLDOWN_TIME = 1.0f;
 
 void Ship::SaveToJson(Json::Value &jsonObj, Space *space)
@@ -95,7 +99,7 @@ void Ship::LoadFromJson(const Json::Value &jsonObj, Space *space)
 	DynamicBody::LoadFromJson(jsonObj, space);
 
 	if (!jsonObj.isMember("ship")) throw SavedGameCorruptException();
-	Json::Value shipObj = jsonObj["ship"];
+	const Json::Value &shipObj = jsonObj["ship"];
 
 	if (!shipObj.isMember("ang_thrusters")) throw SavedGameCorruptException();
 	if (!shipObj.isMember("thrusters")) throw SavedGameCorruptException();
@@ -137,17 +141,17 @@ void Ship::LoadFromJson(const Json::Value &jsonObj, Space *space)
 	Properties().Set("alertStatus", EnumStrings::GetString("ShipAlertStatus", m_alertState));
 	m_lastFiringAlert = StrToDouble(shipObj["last_firing_alert"].asString());
 
-	Json::Value hyperspaceDestObj = shipObj["hyperspace_destination"];
+	const Json::Value &hyperspaceDestObj = shipObj["hyperspace_destination"];
 	m_hyperspace.dest = SystemPath::FromJson(hyperspaceDestObj);
 	m_hyperspace.countdown = StrToFloat(shipObj["hyperspace_countdown"].asString());
 	m_hyperspace.duration = 0;
 
-	Json::Value gunArray = shipObj["guns"];
+	const Json::Value &gunArray = shipObj["guns"];
 	if (!gunArray.isArray()) throw SavedGameCorruptException();
 	assert(ShipType::GUNMOUNT_MAX == gunArray.size());
 	for (unsigned int i = 0; i < ShipType::GUNMOUNT_MAX; i++)
 	{
-		Json::Value gunArrayEl = gunArray[i];
+		const Json::Value &gunArrayEl = gunArray[i];
 		if (!gunArrayEl.isMember("state")) throw SavedGameCorruptException();
 		if (!gunArrayEl.isMember("recharge")) throw SavedGameCorruptException();
 		if (!gunArrayEl.isMember("temperature")) throw SavedGameCorruptException();
@@ -166,6 +170,8 @@ void Ship::LoadFromJson(const Json::Value &jsonObj, Space *space)
 	m_shieldCooldown = StrToFloat(shipObj["shield_cooldown"].asString());
 	m_curAICmd = 0;
 	m_curAICmd = AICommand::LoadFromJson(shipObj);
+	m_aiPrestep = AIPRESTEP_NONE;
+	m_aiTimeStep = 0.0f;
 	m_aiMessage = AIError(shipObj["ai_message"].asInt());
 	SetFuel(StrToDouble(shipObj["thruster_fuel"].asString()));
 	m_stats.fuel_tank_mass_left = GetShipType()->fuelTankMass * GetFuel();
@@ -219,32 +225,55 @@ void Ship::InitEquipSet() {
 	LUA_DEBUG_END(l, 0);
 }
 
-void Ship::InitGun(const char *tag, int num)
+//static
+const Ship::Prototype &Ship::GetPrototype(const ShipType *type)
 {
-	const SceneGraph::MatrixTransform *mt = GetModel()->FindTagByName(tag);
-	if (mt) {
-		const matrix4x4f &trans = mt->GetTransform();
-		m_gun[num].pos = trans.GetTranslate();
-		m_gun[num].dir = trans.GetOrient().VectorZ();
+	std::unique_ptr<Prototype> &proto = s_prototypes[type->id];
+	if (proto)
+		return *proto;
+
+	PROFILE_SCOPED()
+	proto.reset(new Prototype);
+	proto->model.reset(Pi::FindModel(type->modelName)->MakeInstance());
+	SceneGraph::Model *model = proto->model.get();
+
+	static const char *gunTags[ShipType::GUNMOUNT_MAX] = { "tag_gunmount_0", "tag_gunmount_1" };
+	for (int num = 0; num < ShipType::GUNMOUNT_MAX; num++) {
+		const SceneGraph::MatrixTransform *mt = model->FindTagByName(gunTags[num]);
+		if (mt) {
+			const matrix4x4f &trans = mt->GetTransform();
+			proto->gunPos[num] = trans.GetTranslate();
+			proto->gunDir[num] = trans.GetOrient().VectorZ();
+		} else {
+			// XXX deprecated
+			proto->gunPos[num] = vector3f(0,0,0);
+			proto->gunDir[num] = (num==ShipType::GUN_FRONT) ? vector3f(0,0,-1) : vector3f(0,0,1);
+		}
+	}
+
+	// If we've got the tag_landing set then use it for an offset otherwise grab the AABB
+	const SceneGraph::MatrixTransform *mt = model->FindTagByName("tag_landing");
+	if( mt ) {
+		proto->landingMinOffset = mt->GetTransform().GetTranslate().y;
 	} else {
-		// XXX deprecated
-		m_gun[num].pos = (num==ShipType::GUN_FRONT) ? vector3f(0,0,0) : vector3f(0,0,0);
-		m_gun[num].dir = (num==ShipType::GUN_FRONT) ? vector3f(0,0,-1) : vector3f(0,0,1);
+		proto->landingMinOffset = model->GetCollisionMesh()->GetAabb().min.y;
 	}
-}
 
-void Ship::InitMaterials()
-{
-	SceneGraph::Model *pModel = GetModel();
-	assert(pModel);
-	const Uint32 numMats = pModel->GetNumMaterials();
+	Graphics::Texture *heatGradient = Graphics::TextureBuilder::Decal("textures/heat_gradient.png").GetOrCreateTexture(Pi::renderer, "model");
+	const Uint32 numMats = model->GetNumMaterials();
 	for( Uint32 m=0; m<numMats; m++ ) {
-		RefCountedPtr<Graphics::Material> mat = pModel->GetMaterialByIndex(m);
-		mat->heatGradient = Graphics::TextureBuilder::Decal("textures/heat_gradient.png").GetOrCreateTexture(Pi::renderer, "model");
+		RefCountedPtr<Graphics::Material> mat = model->GetMaterialByIndex(m);
+		mat->heatGradient = heatGradient;
 		mat->specialParameter0 = &s_heatGradientParams;
 	}
-	s_heatGradientParams.heatingAmount = 0.0f;
-	s_heatGradientParams.heatingNormal = vector3f(0.0f, -1.0f, 0.0f);
+
+	return *proto;
+}
+
+//static
+void Ship::ClearPrototypes()
+{
+	s_prototypes.clear();
 }
 
 void Ship::Init()
@@ -274,18 +303,15 @@ void Ship::Init()
 
 	m_landingGearAnimation = GetModel()->FindAnimation("gear_down");
 
-	InitGun("tag_gunmount_0", 0);
-	InitGun("tag_gunmount_1", 1);
-
-	// If we've got the tag_landing set then use it for an offset otherwise grab the AABB
-	const SceneGraph::MatrixTransform *mt = GetModel()->FindTagByName("tag_landing");
-	if( mt ) {
-		m_landingMinOffset = mt->GetTransform().GetTranslate().y;
-	} else {
-		m_landingMinOffset = GetAabb().min.y;
+	const Prototype &proto = GetPrototype(m_type);
+	for (int i = 0; i < ShipType::GUNMOUNT_MAX; i++) {
+		m_gun[i].pos = proto.gunPos[i];
+		m_gun[i].dir = proto.gunDir[i];
 	}
+	m_landingMinOffset = proto.landingMinOffset;
 
-	InitMaterials();
+	s_heatGradientParams.heatingAmount = 0.0f;
+	s_heatGradientParams.heatingNormal = vector3f(0.0f, -1.0f, 0.0f);
 }
 
 void Ship::PostLoadFixup(Space *space)
@@ -336,8 +362,10 @@ Ship::Ship(ShipType::Id shipId): DynamicBody(),
 	m_curAICmd = 0;
 	m_aiMessage = AIERROR_NONE;
 	m_decelerating = false;
+	m_aiPrestep = AIPRESTEP_NONE;
+	m_aiTimeStep = 0.0f;
 
-	SetModel(m_type->modelName.c_str());
+	SetModel(m_type->modelName.c_str(), GetPrototype(m_type).model->MakeInstance());
 	SetLabel("UNLABELED_SHIP");
 	m_skin.SetRandomColors(Pi::rng);
 	m_skin.SetDecal(m_type->manufacturer);
@@ -749,7 +777,7 @@ void Ship::Blastoff()
 
 	vector3d up = GetPosition().Normalized();
 	assert(GetFrame()->GetBody()->IsType(Object::PLANET));
-	const double planetRadius = 2.0 + static_cast<Planet*>(GetFrame()->GetBody())->GetTerrainHeight(up);
+	const double planetRadius = 2.0 + GetTerrainHeightBelow(static_cast<Planet*>(GetFrame()->GetBody()), up);
 	SetVelocity(vector3d(0, 0, 0));
 	SetAngVelocity(vector3d(0, 0, 0));
 	SetFlightState(FLYING);
@@ -768,7 +796,7 @@ void Ship::TestLanded()
 	if (GetFrame()->GetBody()->IsType(Object::PLANET)) {
 		double speed = GetVelocity().Length();
 		vector3d up = GetPosition().Normalized();
-		const double planetRadius = static_cast<Planet*>(GetFrame()->GetBody())->GetTerrainHeight(up);
+		const double planetRadius = GetTerrainHeightBelow(static_cast<Planet*>(GetFrame()->GetBody()), up);
 
 		if (speed < MAX_LANDING_SPEED) {
 			// check player is sortof sensibly oriented for landing
@@ -918,15 +946,16 @@ void Ship::FireWeapon(int num)
 	const float width = prop.Get<float>(prefix+"width");
 	const float length = prop.Get<float>(prefix+"length");
 	const bool mining = prop.Get<int>(prefix+"mining");
+	ProjectileSystem *projectiles = Pi::game->GetSpace()->GetProjectiles();
 	if (prop.Get<int>(prefix+"dual"))
 	{
 		const vector3d orient_norm = m.VectorY();
 		const vector3d sep = 5.0 * dir.Cross(orient_norm).NormalizedSafe();
 
-		Projectile::Add(this, lifespan, damage, length, width, mining, c, pos + sep, baseVel, dirVel);
-		Projectile::Add(this, lifespan, damage, length, width, mining, c, pos - sep, baseVel, dirVel);
+		projectiles->Add(this, lifespan, damage, length, width, mining, c, pos + sep, baseVel, dirVel);
+		projectiles->Add(this, lifespan, damage, length, width, mining, c, pos - sep, baseVel, dirVel);
 	} else {
-		Projectile::Add(this, lifespan, damage, length, width, mining, c, pos, baseVel, dirVel);
+		projectiles->Add(this, lifespan, damage, length, width, mining, c, pos, baseVel, dirVel);
 	}
 
 	Polit::NotifyOfCrime(this, Polit::CRIME_WEAPON_DISCHARGE);
@@ -1081,6 +1110,17 @@ void Ship::UpdateFuel(const float timeStep, const vector3d &thrust)
 		LuaEvent::Queue("onShipFuelChanged", this, EnumStrings::GetString("ShipFuelStatus", currentState));
 }
 
+// the player, missiles and anything docking, landing or down near a
+// planet need every tick
+Uint32 Ship::GetMaxSimulationInterval() const
+{
+	if (IsType(Object::PLAYER) || IsType(Object::MISSILE))
+		return 1;
+	if (m_flightState != FLYING || (GetFrame() && GetFrame()->IsRotFrame()))
+		return 1;
+	return SIM_LOD_MAX_INTERVAL;
+}
+
 void Ship::StaticUpdate(const float timeStep)
 {
 	// do player sounds before dead check, so they also turn off
@@ -1351,6 +1391,22 @@ void Ship::Render(Graphics::Renderer *renderer, const Camera *camera, const vect
 	}
 }
 
+// heat and shields are drawn using material parameters shared by every
+// ship, so only cold ships without shields up can share a draw
+bool Ship::CanBatchRender() const
+{
+	if (!ModelBody::CanBatchRender())
+		return false;
+	if (!is_equal_exact(GetHullTemperature(), 0.0))
+		return false;
+	return !GetShields()->IsEnabled();
+}
+
+void Ship::PrepareBatchedRender()
+{
+	s_heatGradientParams.heatingAmount = 0.0f;
+}
+
 bool Ship::SpawnCargo(CargoBody * c_body) const
 {
 	if (m_flightState != FLYING) return false;
@@ -1424,7 +1480,7 @@ void Ship::SetShipType(const ShipType::Id &shipId)
 	ScopedTable(m_equipSet).CallMethod("Clear", this);
 
 	SetShipId(shipId);
-	SetModel(m_type->modelName.c_str());
+	SetModel(m_type->modelName.c_str(), GetPrototype(m_type).model->MakeInstance());
 	m_skin.SetDecal(m_type->manufacturer);
 	m_skin.Apply(GetModel());
 	Init();
@@ -17,6 +17,7 @@
 #include "scenegraph/SceneGraph.h"
 #include "scenegraph/ModelSkin.h"
 #include "LuaTable.h"
+#include <atomic>
 #include <list>
 #include <unordered_map>
 
@@ -53,6 +54,8 @@ class Ship: public DynamicBody {
 public:
 	OBJDEF(Ship, DynamicBody, SHIP);
 	Ship(ShipType::Id shipId);
+	// drop the per type prototypes, before the models go
+	static void ClearPrototypes();
 	Ship() {} //default constructor used before Load
 	virtual ~Ship();
 
@@ -70,6 +73,8 @@ public:
 	virtual void SetLandedOn(Planet *p, float latitude, float longitude);
 
 	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform);
+	virtual bool CanBatchRender() const override;
+	virtual void PrepareBatchedRender() override;
 
 	void SetThrusterState(int axis, double level) {
 		if (m_thrusterFuel <= 0.f) level = 0.0;
@@ -101,6 +106,8 @@ public:
 	bool Undock();
 	virtual void TimeStepUpdate(const float timeStep);
 	virtual void StaticUpdate(const float timeStep);
+	virtual Uint32 GetMaxSimulationInterval() const;
+	virtual void ParallelUpdate(const float timeStep);
 
 	void TimeAccelAdjust(const float timeStep);
 	void SetDecelerating(bool decel) { m_decelerating = decel; }
@@ -190,6 +197,7 @@ public:
 	void AIClearInstructions();
 	bool AIIsActive() { return m_curAICmd ? true : false; }
 	void AIGetStatusText(char *str);
+	float AIGetTimeStep() const;
 
 	enum AIError { // <enum scope='Ship' name=ShipAIError prefix=AIERROR_ public>
 		AIERROR_NONE=0,
@@ -268,6 +276,7 @@ protected:
 	void RenderLaserfire();
 
 	bool AITimeStep(float timeStep); // Called by controller. Returns true if complete
+	bool AICanStepInParallel() const;
 
 	virtual void SetAlertState(AlertState as);
 
@@ -303,10 +312,20 @@ private:
 	void UpdateFuel(float timeStep, const vector3d &thrust);
 	void SetShipId(const ShipType::Id &shipId);
 	void EnterHyperspace();
-	void InitGun(const char *tag, int num);
-	void InitMaterials();
 	void InitEquipSet();
 
+	// what every ship of a type starts out with, worked out when the first
+	// one is made. the rest clone their model from it, and materials,
+	// being shared between instances, are set up on it once for them all
+	struct Prototype {
+		std::unique_ptr<SceneGraph::Model> model;
+		vector3f gunPos[ShipType::GUNMOUNT_MAX];
+		vector3f gunDir[ShipType::GUNMOUNT_MAX];
+		double landingMinOffset;
+	};
+	static const Prototype &GetPrototype(const ShipType *type);
+	static std::map<ShipType::Id, std::unique_ptr<Prototype> > s_prototypes;
+
 	bool m_invulnerable;
 
 	static const float DEFAULT_SHIELD_COOLDOWN_TIME;
@@ -343,7 +362,12 @@ private:
 
 	AICommand *m_curAICmd;
 	AIError m_aiMessage;
-	bool m_decelerating;
+	// read by other ships' AI, which may be stepping in parallel
+	std::atomic<bool> m_decelerating;
+	// result of the AI step taken in ParallelUpdate, picked up by AITimeStep
+	enum AIPrestep { AIPRESTEP_NONE, AIPRESTEP_ACTIVE, AIPRESTEP_COMPLETE };
+	AIPrestep m_aiPrestep;
+	float m_aiTimeStep; // the last step the AI was given
 
 	double m_thrusterFuel; 	// remaining fuel 0.0-1.0
 	double m_reserveFuel;	// 0-1, fuel not to touch for the current AI program
@@ -11,6 +11,7 @@
 #include "Planet.h"
 #include "SpaceStation.h"
 #include "Space.h"
+#include "NavCache.h"
 
 
 static const double VICINITY_MIN = 15000.0;
@@ -20,9 +21,9 @@ AICommand *AICommand::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (jsonObj.isMember("ai_command"))
 	{
-		Json::Value aiCommandObj = jsonObj["ai_command"];
+		const Json::Value &aiCommandObj = jsonObj["ai_command"];
 		if (!aiCommandObj.isMember("common_ai_command")) throw SavedGameCorruptException();
-		Json::Value commonAiCommandObj = aiCommandObj["common_ai_command"];
+		const Json::Value &commonAiCommandObj = aiCommandObj["common_ai_command"];
 		if (!commonAiCommandObj.isMember("command_name")) throw SavedGameCorruptException();
 		CmdName name = CmdName(commonAiCommandObj["command_name"].asInt());
 		switch (name)
@@ -62,7 +63,7 @@ AICommand::AICommand(const Json::Value &jsonObj, CmdName name)
 	m_cmdName = name;
 
 	if (!jsonObj.isMember("common_ai_command")) throw SavedGameCorruptException();
-	Json::Value commonAiCommandObj = jsonObj["common_ai_command"];
+	const Json::Value &commonAiCommandObj = jsonObj["common_ai_command"];
 
 	if (!commonAiCommandObj.isMember("index_for_body")) throw SavedGameCorruptException();
 	m_shipIndex = commonAiCommandObj["index_for_body"].asInt();
@@ -89,7 +90,7 @@ bool AICommand::ProcessChild()
 // temporary evasion-test version
 bool AICmdKill::TimeStepUpdate()
 {
-	m_timeSinceChange += Pi::game->GetTimeStep();
+	m_timeSinceChange += m_ship->AIGetTimeStep();
 	if (m_timeSinceChange < m_changeTime) {
 		m_ship->AIFaceDirection(m_curDir);
 		return false;
@@ -272,7 +273,7 @@ bool AICmdKill::TimeStepUpdate()
 	vector3d targdir = targpos.NormalizedSafe();
 	vector3d heading = -rot.VectorZ();
 	// Accel will be wrong for a frame on timestep changes, but it doesn't matter
-	vector3d targaccel = (m_target->GetVelocity() - m_lastVel) / Pi::game->GetTimeStep();
+	vector3d targaccel = (m_target->GetVelocity() - m_lastVel) / m_ship->AIGetTimeStep();
 	m_lastVel = m_target->GetVelocity();		// may need next frame
 	vector3d leaddir = m_ship->AIGetLeadDir(m_target, targaccel, 0);
 
@@ -307,7 +308,7 @@ bool AICmdKill::TimeStepUpdate()
 		else m_ship->SetGunState(0,0);
 		if (targpos.LengthSqr() > 4000*4000) m_ship->SetGunState(0,0);		// temp
 	}
-	m_leadOffset += m_leadDrift * Pi::game->GetTimeStep();
+	m_leadOffset += m_leadDrift * m_ship->AIGetTimeStep();
 	double leadAV = (leaddir-targdir).Dot((leaddir-heading).NormalizedSafe());	// leaddir angvel
 	m_ship->AIFaceDirection((leaddir + m_leadOffset).Normalized(), leadAV);
 
@@ -651,21 +652,20 @@ static int CheckCollision(Ship *ship, const vector3d &pathdir, double pathdist,
 // modify targpos directly to aim short of dangerous bodies
 static bool ParentSafetyAdjust(Ship *ship, Frame *targframe, vector3d &targpos, vector3d &targvel)
 {
+	// the frames from the target's out to the root are the same for every
+	// ship heading there, so the space keeps them
+	const NavCache::ApproachChain *chain = Pi::game->GetSpace()->GetNavCache()->GetApproach(targframe);
+	if (!chain) return false;
+
 	Body *body = 0;
-	Frame *frame = targframe->GetNonRotFrame();
-	while (frame)
+	const Frame *shipFrame = ship->GetFrame()->GetNonRotFrame();
+	for (const NavCache::ApproachStep &step : *chain)
 	{
-		if (ship->GetFrame()->GetNonRotFrame() == frame) break;		// ship in frame, stop
-		if (frame->GetBody()) body = frame->GetBody();			// ignore grav points?
-
-		double sdist = ship->GetPositionRelTo(frame).Length();
-		if (sdist < frame->GetRadius()) break;					// ship inside frame, stop
-
-		// we should always be inside the root frame, so if we're not inside 'frame'
-		// then it must not be the root frame (ie, it must have a parent)
-		assert(frame->GetParent());
+		if (shipFrame == step.frame) break;						// ship in frame, stop
+		body = step.body;										// ignore grav points?
 
-		frame = frame->GetParent()->GetNonRotFrame();			// check next frame down
+		double sdist = ship->GetPositionRelTo(step.frame).Length();
+		if (sdist < step.frame->GetRadius()) break;				// ship inside frame, stop
 	}
 	if (!body) return false;
 
@@ -696,7 +696,7 @@ static bool CheckSuicide(Ship *ship, const vector3d &tandir)
 }
 
 
-extern double calc_ivel(double dist, double vel, double acc);
+extern double calc_ivel(double dist, double vel, double acc, double timeStep);
 
 // Fly to vicinity of body
 AICmdFlyTo::AICmdFlyTo(Ship *ship, Body *target) : AICommand(ship, CMD_FLYTO)
@@ -739,7 +739,7 @@ bool AICmdFlyTo::TimeStepUpdate()
 	else { LaunchShip(m_ship); return false; }
 
 	// generate base target pos (with vicinity adjustment) & vel 
-	double timestep = Pi::game->GetTimeStep();
+	double timestep = m_ship->AIGetTimeStep();
 	vector3d targpos, targvel;
 	if (m_target) {
 		targpos = m_target->GetPositionRelTo(m_ship->GetFrame());
@@ -835,7 +835,7 @@ Output("Autopilot dist = %.1f, speed = %.1f, zthrust = %.2f, state = %i\n",
 //	if (perpspeed < tt*0.01*m_ship->GetAccelMin()) perpspeed = 0;
 
 	// calculate target speed
-	double ispeed = (maxdecel < 1e-10) ? 0.0 : calc_ivel(targdist, m_endvel, maxdecel);
+	double ispeed = (maxdecel < 1e-10) ? 0.0 : calc_ivel(targdist, m_endvel, maxdecel, m_ship->AIGetTimeStep());
 
 	// cap target speed according to spare fuel remaining
 	double fuelspeed = m_ship->GetSpeedReachedWithFuel();
@@ -972,7 +972,7 @@ bool AICmdDock::TimeStepUpdate()
 	const vector3d relvel = -m_target->GetVelocityRelTo(m_ship);
 
 	const double maxdecel = m_ship->GetAccelUp() - GetGravityAtPos(m_target->GetFrame(), m_dockpos);
-	const double ispeed = calc_ivel(relpos.Length(), 0.0, maxdecel);
+	const double ispeed = calc_ivel(relpos.Length(), 0.0, maxdecel, m_ship->AIGetTimeStep());
 	const vector3d vdiff = ispeed*reldir - relvel;
 	m_ship->AIChangeVelDir(vdiff * m_ship->GetOrient());
 	if (vdiff.Dot(reldir) < 0) {
@@ -982,7 +982,7 @@ bool AICmdDock::TimeStepUpdate()
 	// get rotation of station for next frame
 	matrix3x3d trot = m_target->GetOrientRelTo(m_ship->GetFrame());
 	double av = m_target->GetAngVelocity().Length();
-	double ang = av * Pi::game->GetTimeStep();
+	double ang = av * m_ship->AIGetTimeStep();
 	if (ang > 1e-16) {
 		vector3d axis = m_target->GetAngVelocity().Normalized();
 		trot = trot * matrix3x3d::Rotate(ang, axis);
@@ -1051,7 +1051,7 @@ double AICmdFlyAround::MaxVel(double targdist, double targalt)
 	double t = sqrt(2.0 * targdist / m_ship->GetAccelFwd());
 	double vmaxprox = m_ship->GetAccelMin()*t;			// limit by target proximity
 	double vmaxstep = std::max(m_alt*0.05, m_alt-targalt);
-	vmaxstep /= Pi::game->GetTimeStep();			// limit by distance covered per timestep
+	vmaxstep /= m_ship->AIGetTimeStep();			// limit by distance covered per timestep
 	return std::min(m_vel, std::min(vmaxprox, vmaxstep));
 }
 
@@ -1064,7 +1064,7 @@ bool AICmdFlyAround::TimeStepUpdate()
 	if (m_ship->GetFlightState() == Ship::FLYING) m_ship->SetWheelState(false);
 	else { LaunchShip(m_ship); return false; }
 
-	double timestep = Pi::game->GetTimeStep();
+	double timestep = m_ship->AIGetTimeStep();
 	vector3d targpos = (!m_targmode) ? m_targpos :
 		m_ship->GetVelocity().NormalizedSafe()*m_ship->GetPosition().LengthSqr();
 	vector3d obspos = m_obstructor->GetPositionRelTo(m_ship);
@@ -1108,7 +1108,7 @@ bool AICmdFlyAround::TimeStepUpdate()
 
 	// calculate target velocity
 	double alt = (tanvel * timestep + obspos).Length();		// unnecessary?
-	double ivel = calc_ivel(alt - m_alt, 0.0, m_ship->GetAccelMin());
+	double ivel = calc_ivel(alt - m_alt, 0.0, m_ship->GetAccelMin(), m_ship->AIGetTimeStep());
 
 	vector3d finalvel = tanvel + ivel * obsdir;
 	m_ship->AIMatchVel(finalvel);
@@ -1158,12 +1158,12 @@ bool AICmdFormation::TimeStepUpdate()
 	// adjust for target acceleration
 	matrix3x3d forient = m_target->GetFrame()->GetOrientRelTo(m_ship->GetFrame());
 	vector3d targaccel = forient * m_target->GetLastForce() / m_target->GetMass();
-	relvel -= targaccel * Pi::game->GetTimeStep();
+	relvel -= targaccel * m_ship->AIGetTimeStep();
 	double maxdecel = m_ship->GetAccelFwd() + targaccel.Dot(reldir);
 	if (maxdecel < 0.0) maxdecel = 0.0;
 
 	// linear thrust
-	double ispeed = calc_ivel(targdist, 0.0, maxdecel);
+	double ispeed = calc_ivel(targdist, 0.0, maxdecel, m_ship->AIGetTimeStep());
 	vector3d vdiff = ispeed*reldir - relvel;
 	m_ship->AIChangeVelDir(vdiff * m_ship->GetOrient());
 	if (m_target->IsDecelerating()) m_ship->SetDecelerating(true);
@@ -24,6 +24,9 @@ public:
 	virtual ~AICommand() { if (m_child) delete m_child; }
 
 	virtual bool TimeStepUpdate() = 0;
+	// true if TimeStepUpdate only changes the ship's own state while it's
+	// flying, so it can be run from Ship::ParallelUpdate
+	virtual bool IsThreadSafe() const { return false; }
 	bool ProcessChild();				// returns false if child is active
 	virtual void GetStatusText(char *str) {
 		if (m_child) m_child->GetStatusText(str);
@@ -82,6 +85,7 @@ public:
 	virtual void PostLoadFixup(Space *space) {
 		AICommand::PostLoadFixup(space);
 		m_target = static_cast<SpaceStation *>(space->GetBodyByIndex(m_targetIndex));
+		if (m_target) m_target->AddWatcher(m_ship);
 	}
 	virtual void OnDeleted(const Body *body) {
 		AICommand::OnDeleted(body);
@@ -119,6 +123,7 @@ private:
 class AICmdFlyTo : public AICommand {
 public:
 	virtual bool TimeStepUpdate();
+	virtual bool IsThreadSafe() const { return !m_child || m_child->IsThreadSafe(); }
 	AICmdFlyTo(Ship *ship, Frame *targframe, const vector3d &posoff, double endvel, bool tangent);
 	AICmdFlyTo(Ship *ship, Body *target);
 
@@ -161,6 +166,7 @@ public:
 	virtual void PostLoadFixup(Space *space) {
 		AICommand::PostLoadFixup(space);
 		m_target = space->GetBodyByIndex(m_targetIndex);
+		if (m_target) m_target->AddWatcher(m_ship);
 		m_targframe = space->GetFrameByIndex(m_targframeIndex);
 		m_lockhead = true;
 	}
@@ -188,6 +194,7 @@ private:
 class AICmdFlyAround : public AICommand {
 public:
 	virtual bool TimeStepUpdate();
+	virtual bool IsThreadSafe() const { return !m_child || m_child->IsThreadSafe(); }
 	AICmdFlyAround(Ship *ship, Body *obstructor, double relalt, int mode=2);
 	AICmdFlyAround(Ship *ship, Body *obstructor, double alt, double vel, int mode=1);
 
@@ -262,6 +269,7 @@ public:
 	virtual void PostLoadFixup(Space *space) {
 		AICommand::PostLoadFixup(space);
 		m_target = static_cast<Ship *>(space->GetBodyByIndex(m_targetIndex));
+		if (m_target) m_target->AddWatcher(m_ship);
 		m_leadTime = m_evadeTime = m_closeTime = 0.0;
 		m_lastVel = m_target->GetVelocity();
 	}
@@ -299,6 +307,7 @@ public:
 	virtual void PostLoadFixup(Space *space) {
 		AICommand::PostLoadFixup(space);
 		m_target = space->GetBodyByIndex(m_targetIndex);
+		if (m_target) m_target->AddWatcher(m_ship);
 	}
 
 	virtual void OnDeleted(const Body *body) {
@@ -314,6 +323,7 @@ private:
 class AICmdHoldPosition : public AICommand {
 public:
 	virtual bool TimeStepUpdate();
+	virtual bool IsThreadSafe() const { return true; }
 	AICmdHoldPosition(Ship *ship) : AICommand(ship, CMD_HOLDPOSITION) { }
 	AICmdHoldPosition(const Json::Value &jsonObj) : AICommand(jsonObj, CMD_HOLDPOSITION) { }
 };
@@ -321,6 +331,7 @@ public:
 class AICmdFormation : public AICommand {
 public:
 	virtual bool TimeStepUpdate();
+	virtual bool IsThreadSafe() const { return !m_child || m_child->IsThreadSafe(); }
 	AICmdFormation(Ship *ship, Ship *target, const vector3d &posoff);
 
 	virtual void GetStatusText(char *str) {
@@ -345,6 +356,7 @@ public:
 	virtual void PostLoadFixup(Space *space) {
 		AICommand::PostLoadFixup(space);
 		m_target = static_cast<Ship*>(space->GetBodyByIndex(m_targetIndex));
+		if (m_target) m_target->AddWatcher(m_ship);
 	}
 	virtual void OnDeleted(const Body *body) {
 		if (static_cast<Body *>(m_target) == body) m_target = 0;
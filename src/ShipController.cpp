@@ -4,6 +4,7 @@
 #include "ShipController.h"
 #include "Frame.h"
 #include "Game.h"
+#include "InputLatency.h"
 #include "KeyBindings.h"
 #include "Pi.h"
 #include "Player.h"
@@ -70,7 +71,7 @@ void PlayerShipController::SaveToJson(Json::Value &jsonObj, Space *space)
 void PlayerShipController::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("player_ship_controller")) throw SavedGameCorruptException();
-	Json::Value playerShipControllerObj = jsonObj["player_ship_controller"];
+	const Json::Value &playerShipControllerObj = jsonObj["player_ship_controller"];
 
 	if (!playerShipControllerObj.isMember("flight_control_state")) throw SavedGameCorruptException();
 	if (!playerShipControllerObj.isMember("set_speed")) throw SavedGameCorruptException();
@@ -94,6 +95,8 @@ void PlayerShipController::PostLoadFixup(Space *space)
 {
 	m_combatTarget = space->GetBodyByIndex(m_combatTargetIndex);
 	m_navTarget = space->GetBodyByIndex(m_navTargetIndex);
+	if (m_combatTarget) m_combatTarget->AddWatcher(m_ship);
+	if (m_navTarget) m_navTarget->AddWatcher(m_ship);
 	m_setSpeedTarget = space->GetBodyByIndex(m_setSpeedTargetIndex);
 }
 
@@ -102,8 +105,10 @@ void PlayerShipController::StaticUpdate(const float timeStep)
 	vector3d v;
 	matrix4x4d m;
 
+	Pi::GetInputLatency()->OnControlsPolled();
+
 	int mouseMotion[2];
-	SDL_GetRelativeMouseState (mouseMotion+0, mouseMotion+1);	// call to flush
+	Pi::TakeFlightMouseMotion(mouseMotion);	// call to flush
 
 	// external camera mouselook
 	if (Pi::MouseButtonState(SDL_BUTTON_MIDDLE)) {
@@ -419,6 +424,7 @@ void PlayerShipController::SetCombatTarget(Body* const target, bool setSpeedTo)
 	else if (m_setSpeedTarget == m_combatTarget)
 		m_setSpeedTarget = 0;
 	m_combatTarget = target;
+	if (target) target->AddWatcher(m_ship);
 }
 
 void PlayerShipController::SetNavTarget(Body* const target, bool setSpeedTo)
@@ -428,4 +434,5 @@ void PlayerShipController::SetNavTarget(Body* const target, bool setSpeedTo)
 	else if (m_setSpeedTarget == m_navTarget)
 		m_setSpeedTarget = 0;
 	m_navTarget = target;
+	if (target) target->AddWatcher(m_ship);
 }
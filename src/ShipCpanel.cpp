@@ -30,7 +30,7 @@ ShipCpanel::ShipCpanel(const Json::Value &jsonObj, Graphics::Renderer *r, Game*
 m_game(game)
 {
 	if (!jsonObj.isMember("ship_c_panel")) throw SavedGameCorruptException();
-	Json::Value shipCPanelObj = jsonObj["ship_c_panel"];
+	const Json::Value &shipCPanelObj = jsonObj["ship_c_panel"];
 
 	m_scanner = new ScannerWidget(r, shipCPanelObj);
 
@@ -43,6 +43,9 @@ m_game(game)
 void ShipCpanel::InitObject()
 {
 	SetTransparency(true);
+	// the panel is mostly static, so it's drawn once into a texture and only
+	// the widgets that change every frame are drawn over it
+	SetCached(true);
 
 	Gui::Image *img = new Gui::Image("icons/cpanel.png");
 	img->SetRenderDimensions(800, 80);
@@ -53,6 +56,8 @@ void ShipCpanel::InitObject()
 
 	m_userSelectedMfuncWidget = MFUNC_SCANNER;
 
+	m_scanner->SetDynamic(true);
+
 	m_scanner->onGrabFocus.connect(sigc::bind(sigc::mem_fun(this, &ShipCpanel::OnMultiFuncGrabFocus), MFUNC_SCANNER));
 	m_useEquipWidget->onGrabFocus.connect(sigc::bind(sigc::mem_fun(this, &ShipCpanel::OnMultiFuncGrabFocus), MFUNC_EQUIPMENT));
 
@@ -149,6 +154,7 @@ void ShipCpanel::InitObject()
 	Add(comms_button, 98, 56);
 
 	m_clock = (new Gui::Label(""))->Color(255,178,0);
+	m_clock->SetDynamic(true);
 	Add(m_clock, 3, 15);
 
 	m_rightButtonGroup = new Gui::RadioGroup();
@@ -213,6 +219,7 @@ void ShipCpanel::InitObject()
 	m_overlay[OVERLAY_TOP_RIGHT]    = (new Gui::Label(""))->Color(s_hudTextColor);
 	m_overlay[OVERLAY_BOTTOM_LEFT]  = (new Gui::Label(""))->Color(s_hudTextColor);
 	m_overlay[OVERLAY_BOTTOM_RIGHT] = (new Gui::Label(""))->Color(s_hudTextColor);
+	for (int i = 0; i < 4; i++) m_overlay[i]->SetDynamic(true);
 	Add(m_overlay[OVERLAY_TOP_LEFT],     170.0f, 2.0f);
 	Add(m_overlay[OVERLAY_TOP_RIGHT],    500.0f, 2.0f);
 	Add(m_overlay[OVERLAY_BOTTOM_LEFT],  150.0f, 62.0f);
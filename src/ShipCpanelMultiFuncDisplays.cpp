@@ -20,6 +20,7 @@
 #include "graphics/Graphics.h"
 #include "graphics/Renderer.h"
 #include "graphics/VertexArray.h"
+#include "graphics/VertexBuffer.h"
 
 using namespace Graphics;
 
@@ -30,6 +31,8 @@ static const float SCANNER_SCALE     = 0.00001f;
 //static const float SCANNER_XSHRINK   = 4.0f;
 static const float A_BIT             = 1.1f;
 static const unsigned int SCANNER_STEPS = 100;
+static const Uint32 SCANNER_MIN_CONTACTS = 64;
+static const float SCANNER_BLOB_SIZE = 3.0f;
 
 // XXX target colours should be unified throughout the game
 static const Color scannerNavTargetColour     = Color( 0,   255, 0   );
@@ -41,6 +44,41 @@ static const Color scannerPlayerMissileColour = Color( 243, 237, 29  );
 static const Color scannerCargoColour         = Color( 166, 166, 166 );
 static const Color scannerCloudColour         = Color( 128, 128, 255 );
 
+struct ScannerVert {
+	vector3f pos;
+	Color4ub col;
+};
+
+static Graphics::VertexBuffer *CreateScannerBuffer(Graphics::Renderer *r, Uint32 numVertices, Graphics::BufferUsage usage)
+{
+	Graphics::VertexBufferDesc vbd;
+	vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+	vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
+	vbd.attrib[1].semantic = Graphics::ATTRIB_DIFFUSE;
+	vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_UBYTE4;
+	vbd.numVertices = numVertices;
+	vbd.usage = usage;
+	return r->CreateVertexBuffer(vbd);
+}
+
+static const Color *ContactColour(Object::Type type, bool isSpecial)
+{
+	switch (type) {
+		case Object::SHIP:
+			return isSpecial ? &scannerCombatTargetColour : &scannerShipColour;
+		case Object::MISSILE:
+			return isSpecial ? &scannerPlayerMissileColour : &scannerMissileColour;
+		case Object::SPACESTATION:
+			return isSpecial ? &scannerNavTargetColour : &scannerStationColour;
+		case Object::CARGOBODY:
+			return isSpecial ? &scannerNavTargetColour : &scannerCargoColour;
+		case Object::HYPERSPACECLOUD:
+			return isSpecial ? &scannerNavTargetColour : &scannerCloudColour;
+		default:
+			return 0;
+	}
+}
+
 ScannerWidget::ScannerWidget(Graphics::Renderer *r) :
 	m_renderer(r)
 {
@@ -54,7 +92,7 @@ ScannerWidget::ScannerWidget(Graphics::Renderer *r, const Json::Value &jsonObj)
 m_renderer(r)
 {
 	if (!jsonObj.isMember("scanner")) throw SavedGameCorruptException();
-	Json::Value scannerObj = jsonObj["scanner"];
+	const Json::Value &scannerObj = jsonObj["scanner"];
 
 	if (!scannerObj.isMember("mode")) throw SavedGameCorruptException();
 	if (!scannerObj.isMember("current_range")) throw SavedGameCorruptException();
@@ -126,31 +164,18 @@ void ScannerWidget::Draw()
 		m_lastRange = m_currentRange;
 	}
 
-	// draw objects below player (and below scanner)
-	if (!m_contacts.empty()) DrawBlobs(true);
-
-	// disc
-	Color green(0, 255, 0, 26);
-
-	// XXX 2d vertices
-	VertexArray va(ATTRIB_POSITION | ATTRIB_DIFFUSE, 128); //reserve some space for positions & colors
-	va.Add(vector3f(SCANNER_XSHRINK * m_x, m_y, 0.f), green);
-	for (float a = 0; a < 2 * float(M_PI); a += float(M_PI) * 0.02f) {
-		va.Add(vector3f(SCANNER_XSHRINK * m_x + m_x * sin(a), m_y + SCANNER_YSHRINK * m_y * cos(a), 0.f), green);
-	}
-	va.Add(vector3f(SCANNER_XSHRINK * m_x, m_y + SCANNER_YSHRINK * m_y, 0.f), green);
-	m_renderer->DrawTriangles(&va, m_renderState, Graphics::vtxColorMaterial, TRIANGLE_FAN);
-
-	// circles and spokes
+	// disc, circles and spokes
 	{
 		Graphics::Renderer::MatrixTicket ticket(m_renderer, Graphics::MatrixMode::MODELVIEW);
 		m_renderer->Translate(SCANNER_XSHRINK * m_x, m_y, 0);
 		m_renderer->Scale(m_x, m_y, 1.0f);
+		m_renderer->DrawBuffer(m_discBuffer.get(), m_renderState, Graphics::vtxColorMaterial, TRIANGLE_FAN);
 		DrawRingsAndSpokes(false);
 	}
 
-	// objects above
-	if (!m_contacts.empty()) DrawBlobs(false);
+	// objects above and below the scanner all go on top. the disc is nearly
+	// transparent, so the stalks still show which side they are on
+	if (!m_contacts.empty()) DrawContacts();
 
 	// glLineWidth(1.f);
 
@@ -192,18 +217,18 @@ void ScannerWidget::Update()
 	float combat_dist = 0, far_ship_dist = 0, nav_dist = 0, far_other_dist = 0;
 
 	// collect the bodies to be displayed, and if AUTO, distances
-	Space::BodyNearList nearby;
+	Space::BodyNearList nearby(FrameArena::Allocator<Body*>());
 	Pi::game->GetSpace()->GetBodiesMaybeNear(Pi::player, SCANNER_RANGE_MAX, nearby);
 	for (Space::BodyNearIterator i = nearby.begin(); i != nearby.end(); ++i) {
 		if ((*i) == Pi::player) continue;
 
-		float dist = float((*i)->GetPositionRelTo(Pi::player).Length());
-
 		Contact c;
 		c.type = (*i)->GetType();
 		c.pos = (*i)->GetPositionRelTo(Pi::player);
 		c.isSpecial = false;
 
+		float dist = float(c.pos.Length());
+
 		switch ((*i)->GetType()) {
 
 			case Object::MISSILE:
@@ -303,67 +328,32 @@ void ScannerWidget::Update()
 		m_targetRange = m_manualRange;
 }
 
-void ScannerWidget::DrawBlobs(bool below)
+void ScannerWidget::DrawContacts()
 {
+	PROFILE_SCOPED()
 	assert( !m_contacts.empty() );
 
-	static const Uint32 MAX_CONTACTS(100);
-	std::vector<vector3f> blobs;
-	std::vector<vector3f> vts;
-	std::vector<Color> blobcolors;
-	std::vector<Color> colors;
-	blobs.reserve(MAX_CONTACTS);
-	vts.reserve(MAX_CONTACTS);
-	blobcolors.reserve(MAX_CONTACTS);
-	colors.reserve(MAX_CONTACTS);
-
-	for (std::list<Contact>::iterator i = m_contacts.begin(); i != m_contacts.end(); ++i) {
-
-		const Color *color = 0;
-
-		switch (i->type) {
-			case Object::SHIP:
-				if (i->isSpecial)
-					color = &scannerCombatTargetColour;
-				else
-					color = &scannerShipColour;
-				break;
-
-			case Object::MISSILE:
-				if (i->isSpecial)
-					color = &scannerPlayerMissileColour;
-				else
-					color = &scannerMissileColour;
-				break;
+	const Uint32 numContacts = m_contacts.size();
+	if (!m_stalkBuffer || m_stalkBuffer->GetDesc().numVertices < numContacts * 2) {
+		Uint32 capacity = SCANNER_MIN_CONTACTS;
+		while (capacity < numContacts) capacity *= 2;
+		m_stalkBuffer.reset(CreateScannerBuffer(m_renderer, capacity * 2, Graphics::BUFFER_USAGE_DYNAMIC));
+		m_blobBuffer.reset(CreateScannerBuffer(m_renderer, capacity * 6, Graphics::BUFFER_USAGE_DYNAMIC));
+	}
 
-			case Object::SPACESTATION:
-				if (i->isSpecial)
-					color = &scannerNavTargetColour;
-				else
-					color = &scannerStationColour;
-				break;
+	assert(m_stalkBuffer->GetDesc().stride == sizeof(ScannerVert));
+	assert(m_blobBuffer->GetDesc().stride == sizeof(ScannerVert));
+	ScannerVert *stalk = m_stalkBuffer->Map<ScannerVert>(Graphics::BUFFER_MAP_WRITE);
+	ScannerVert *blob = m_blobBuffer->Map<ScannerVert>(Graphics::BUFFER_MAP_WRITE);
 
-			case Object::CARGOBODY:
-				if (i->isSpecial)
-					color = &scannerNavTargetColour;
-				else
-					color = &scannerCargoColour;
-				break;
+	const matrix3x3d &orient = Pi::player->GetOrient();
+	const float halfBlob = 0.5f * SCANNER_BLOB_SIZE;
+	Uint32 numDrawn = 0;
+	for (const Contact &c : m_contacts) {
+		const Color *color = ContactColour(c.type, c.isSpecial);
+		if (!color) continue;
 
-			case Object::HYPERSPACECLOUD:
-				if (i->isSpecial)
-					color = &scannerNavTargetColour;
-				else
-					color = &scannerCloudColour;
-				break;
-
-			default:
-				continue;
-		}
-
-		vector3d pos = i->pos * Pi::player->GetOrient();
-		if ((pos.y > 0) && (below)) continue;
-		if ((pos.y < 0) && (!below)) continue;
+		const vector3d pos = c.pos * orient;
 
 		const float x = SCANNER_XSHRINK * m_x + m_x * float(pos.x) * m_scale;
 		// x scanner widget bound check
@@ -373,24 +363,34 @@ void ScannerWidget::DrawBlobs(bool below)
 		const float y_base = m_y + m_y * SCANNER_YSHRINK * float(pos.z) * m_scale;
 		const float y_blob = y_base - m_y * SCANNER_YSHRINK * float(pos.y) * m_scale;
 
-		// store this stalk
-		vts.push_back(vector3f(x, y_base, 0.f));
-		vts.push_back(vector3f(x, y_blob, 0.f));
-		colors.push_back(*color);
-		colors.push_back(*color);
-
-		// blob!
-		blobs.push_back(vector3f(x, y_blob, 0.f));
-		blobcolors.push_back(*color);
+		// stalk
+		stalk[0].pos = vector3f(x, y_base, 0.f);
+		stalk[1].pos = vector3f(x, y_blob, 0.f);
+		stalk[0].col = stalk[1].col = *color;
+		stalk += 2;
+
+		// blob! two triangles, as Drawables::Points lays them out
+		const vector3f tl(x - halfBlob, y_blob + halfBlob, 0.f);
+		const vector3f bl(x - halfBlob, y_blob - halfBlob, 0.f);
+		const vector3f tr(x + halfBlob, y_blob + halfBlob, 0.f);
+		const vector3f br(x + halfBlob, y_blob - halfBlob, 0.f);
+		blob[0].pos = tl; blob[1].pos = bl; blob[2].pos = tr;
+		blob[3].pos = tr; blob[4].pos = bl; blob[5].pos = br;
+		for (int i = 0; i < 6; i++) blob[i].col = *color;
+		blob += 6;
+
+		++numDrawn;
 	}
 
-	if( !vts.empty() ) {
-		m_contactLines.SetData(vts.size(), &vts[0], &colors[0]);
-		m_contactLines.Draw(m_renderer, m_renderState);
+	m_stalkBuffer->Unmap();
+	m_blobBuffer->Unmap();
 
-		m_contactBlobs.SetData(m_renderer, blobs.size(), &blobs[0], &blobcolors[0], matrix4x4f::Identity(), 3.f);
-		m_contactBlobs.Draw(m_renderer, m_renderState);
-	}
+	if (numDrawn == 0) return;
+
+	m_stalkBuffer->SetVertexCount(numDrawn * 2);
+	m_blobBuffer->SetVertexCount(numDrawn * 6);
+	m_renderer->DrawBuffer(m_stalkBuffer.get(), m_renderState, Graphics::vtxColorMaterial, LINE_SINGLE);
+	m_renderer->DrawBuffer(m_blobBuffer.get(), m_renderState, Graphics::vtxColorMaterial, TRIANGLES);
 }
 
 void ScannerWidget::GenerateBaseGeometry()
@@ -414,6 +414,16 @@ void ScannerWidget::GenerateBaseGeometry()
 		m_spokes.push_back(vector3f(0.1f * sin(ang), 0.1f * SCANNER_YSHRINK * cos(ang), 0.0f));
 		m_spokes.push_back(vector3f(sin(ang), SCANNER_YSHRINK * cos(ang), 0.0f));
 	}
+
+	// disc, as a fan from the centre
+	const Color green(0, 255, 0, 26);
+	VertexArray disc(ATTRIB_POSITION | ATTRIB_DIFFUSE, 128);
+	disc.Add(vector3f(0.0f, 0.0f, 0.0f), green);
+	for (float ang = 0; ang < circle; ang += float(M_PI) * 0.02f)
+		disc.Add(vector3f(sin(ang), SCANNER_YSHRINK * cos(ang), 0.0f), green);
+	disc.Add(vector3f(0.0f, SCANNER_YSHRINK, 0.0f), green);
+	m_discBuffer.reset(CreateScannerBuffer(m_renderer, disc.GetNumVerts(), Graphics::BUFFER_USAGE_STATIC));
+	m_discBuffer->Populate(disc);
 }
 
 void ScannerWidget::GenerateRingsAndSpokes()
@@ -43,7 +43,7 @@ public:
 private:
 	void InitObject();
 
-	void DrawBlobs(bool below);
+	void DrawContacts();
 	void GenerateBaseGeometry();
 	void GenerateRingsAndSpokes();
 	void DrawRingsAndSpokes(bool blend);
@@ -55,9 +55,11 @@ private:
 		vector3d pos;
 		bool isSpecial;
 	};
-	std::list<Contact> m_contacts;
-	Graphics::Drawables::Lines m_contactLines;
-	Graphics::Drawables::Points m_contactBlobs;
+	std::vector<Contact> m_contacts;
+	// every contact's stalk, and every contact's blob, rewritten each frame
+	// and drawn with one call each. they only ever grow
+	std::unique_ptr<Graphics::VertexBuffer> m_stalkBuffer;
+	std::unique_ptr<Graphics::VertexBuffer> m_blobBuffer;
 
 	enum ScannerMode { SCANNER_MODE_AUTO, SCANNER_MODE_MANUAL };
 	ScannerMode m_mode;
@@ -82,6 +84,7 @@ private:
 	Graphics::Renderer *m_renderer;
 	Graphics::RenderState *m_renderState;
 	
+	std::unique_ptr<Graphics::VertexBuffer> m_discBuffer;
 	Graphics::Drawables::Lines m_scanLines;
 	Graphics::Drawables::Lines m_edgeLines;
 };
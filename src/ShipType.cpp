@@ -13,8 +13,10 @@
 #include "FileSystem.h"
 #include "utils.h"
 #include "Lang.h"
+#include "JobQueue.h"
 #include "json/json.h"
 #include <algorithm>
+#include <memory>
 
 
 std::map<ShipType::Id, const ShipType> ShipType::types;
@@ -291,32 +293,50 @@ int define_missile(lua_State *L)
 }
 #endif
 
-void ShipType::Init()
-{
-	static bool isInitted = false;
-	if (isInitted) 
-		return;
-	isInitted = true;
+namespace {
 
-	// load all ship definitions
+// the json definitions, in the order they're found. each one can be parsed
+// on its own, into its slot in parsed
+struct ShipTypeLoad {
+	std::vector<std::pair<ShipType::Id,std::string>> files; // id, path
+	std::vector<ShipType> parsed;
+};
+
+bool s_initted = false;
+
+void FindShipDefs(ShipTypeLoad &load)
+{
 	namespace fs = FileSystem;
 	for (fs::FileEnumerator files(fs::gameDataFiles, "ships", fs::FileEnumerator::Recurse); !files.Finished(); files.Next()) {
 		const fs::FileInfo &info = files.Current();
 		if (ends_with_ci(info.GetPath(), ".json")) {
 			const std::string id(info.GetName().substr(0, info.GetName().size()-5));
-			ShipType st = ShipType(id, info.GetPath());
-			types.insert(std::make_pair(st.id, st));
-
-			// assign the names to the various lists
-			switch( st.tag ) {
-			case TAG_SHIP:				player_ships.push_back(id);				break;
-			case TAG_STATIC_SHIP:		static_ships.push_back(id);				break;
-			case TAG_MISSILE:			missile_ships.push_back(id);			break;
-				break;
-			case TAG_NONE:
-			default:
-				break;
-			}
+			load.files.push_back(std::make_pair(id, info.GetPath()));
+		}
+	}
+	load.parsed.resize(load.files.size());
+}
+
+void ParseShipDef(ShipTypeLoad &load, size_t i)
+{
+	load.parsed[i] = ShipType(load.files[i].first, load.files[i].second);
+}
+
+// everything after the json definitions are in, in file order
+void AddShipTypes(const ShipTypeLoad &load)
+{
+	for (const ShipType &st : load.parsed) {
+		ShipType::types.insert(std::make_pair(st.id, st));
+
+		// assign the names to the various lists
+		switch( st.tag ) {
+		case ShipType::TAG_SHIP:			ShipType::player_ships.push_back(st.id);		break;
+		case ShipType::TAG_STATIC_SHIP:		ShipType::static_ships.push_back(st.id);		break;
+		case ShipType::TAG_MISSILE:			ShipType::missile_ships.push_back(st.id);		break;
+			break;
+		case ShipType::TAG_NONE:
+		default:
+			break;
 		}
 	}
 
@@ -379,3 +399,58 @@ void ShipType::Init()
 		Error("No playable ships have been defined! The game cannot run.");
 }
 
+class ShipDefJob : public Job {
+public:
+	ShipDefJob(const std::shared_ptr<ShipTypeLoad> &load, size_t index) : m_load(load), m_index(index) {}
+	virtual void OnRun() override { ParseShipDef(*m_load, m_index); }
+	virtual void OnFinish() override {}
+	virtual const char *GetName() const override { return "ShipDefJob"; }
+private:
+	std::shared_ptr<ShipTypeLoad> m_load;
+	size_t m_index;
+};
+
+class AddShipTypesJob : public Job {
+public:
+	AddShipTypesJob(const std::shared_ptr<ShipTypeLoad> &load) : m_load(load) {}
+	virtual void OnRun() override { AddShipTypes(*m_load); }
+	virtual void OnFinish() override {}
+	virtual const char *GetName() const override { return "AddShipTypesJob"; }
+private:
+	std::shared_ptr<ShipTypeLoad> m_load;
+};
+
+}
+
+void ShipType::Init()
+{
+	if (s_initted)
+		return;
+	s_initted = true;
+
+	ShipTypeLoad load;
+	FindShipDefs(load);
+	for (size_t i = 0; i < load.files.size(); i++)
+		ParseShipDef(load, i);
+	AddShipTypes(load);
+}
+
+void ShipType::Init(JobSet &jobs)
+{
+	if (s_initted)
+		return;
+	s_initted = true;
+
+	std::shared_ptr<ShipTypeLoad> load(new ShipTypeLoad);
+	FindShipDefs(*load);
+
+	std::vector<Job*> parseJobs;
+	parseJobs.reserve(load->files.size());
+	for (size_t i = 0; i < load->files.size(); i++) {
+		Job *job = new ShipDefJob(load, i);
+		jobs.Order(job);
+		parseJobs.push_back(job);
+	}
+	jobs.OrderAfter(new AddShipTypesJob(load), parseJobs);
+}
+
@@ -10,6 +10,8 @@
 #include <map>
 #include <string>
 
+class JobSet;
+
 struct ShipType {
 	enum Thruster { // <enum scope='ShipType' name=ShipTypeThruster prefix=THRUSTER_ public>
 		THRUSTER_REVERSE,
@@ -80,6 +82,10 @@ struct ShipType {
 	static std::vector<Id> missile_ships;
 
 	static void Init();
+	// as Init, but each definition is read on its own job in jobs, and
+	// another puts them all together once they're done. call from the main
+	// thread; the types are there once jobs is empty
+	static void Init(JobSet &jobs);
 	static const ShipType *Get(const char *name) {
 		std::map<Id, const ShipType>::iterator t = types.find(name);
 		if (t == types.end()) return 0;
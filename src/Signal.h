@@ -0,0 +1,155 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SIGNAL_H
+#define _SIGNAL_H
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+ * A signal for hot paths that never allocates, for use instead of
+ * sigc::signal where an emitter is created, connected or fired often.
+ *
+ * The listener owns the connection: a Signal::Slot is a member of the
+ * listening object and holds the callback in a small inline buffer. The
+ * signal keeps an intrusive list of its slots, so connecting and
+ * disconnecting are a few pointer writes. Whichever of the two goes first
+ * unlinks itself from the other, so a slot may outlive its signal and the
+ * other way round, and a slot may be disconnected or destroyed from inside
+ * a callback, including the one being called (which then mustn't touch its
+ * captures, they're gone).
+ *
+ *   class Listener {
+ *       void OnDelete();
+ *       Signal<>::Slot m_deleteSlot;
+ *   };
+ *   m_deleteSlot.Connect(emitter->onDelete, [this]() { OnDelete(); });
+ *
+ * Slots are called in the order they were connected. Signals and slots
+ * can't be copied.
+ */
+template <typename... Args>
+class Signal {
+public:
+	class Slot {
+	public:
+		// callbacks up to this size (a few captured pointers) are stored inline
+		static const size_t BUFFER_SIZE = 4 * sizeof(void*);
+
+		Slot() : m_signal(nullptr), m_prev(nullptr), m_next(nullptr), m_call(nullptr), m_destroy(nullptr) {}
+		~Slot() { Disconnect(); }
+
+		template <typename F>
+		void Connect(Signal &signal, F &&fn) {
+			typedef typename std::decay<F>::type Fn;
+			static_assert(sizeof(Fn) <= BUFFER_SIZE, "callback too big for a Signal slot");
+			static_assert(std::alignment_of<Fn>::value <= std::alignment_of<Buffer>::value, "callback alignment too strict for a Signal slot");
+			Disconnect();
+			new (&m_buffer) Fn(std::forward<F>(fn));
+			m_call = &Call<Fn>;
+			m_destroy = &Destroy<Fn>;
+			signal.Link(this);
+		}
+
+		void Disconnect() {
+			if (m_signal)
+				m_signal->Unlink(this);
+			if (m_destroy) {
+				m_destroy(&m_buffer);
+				m_call = nullptr;
+				m_destroy = nullptr;
+			}
+		}
+
+		bool Connected() const { return m_signal != nullptr; }
+
+	private:
+		Slot(const Slot &);
+		Slot &operator=(const Slot &);
+
+		friend class Signal;
+
+		typedef typename std::aligned_storage<BUFFER_SIZE>::type Buffer;
+
+		template <typename Fn>
+		static void Call(void *buf, Args... args) { (*static_cast<Fn*>(buf))(args...); }
+		template <typename Fn>
+		static void Destroy(void *buf) { static_cast<Fn*>(buf)->~Fn(); }
+
+		Signal *m_signal;
+		Slot *m_prev;
+		Slot *m_next;
+		void (*m_call)(void *, Args...);
+		void (*m_destroy)(void *);
+		Buffer m_buffer;
+	};
+
+	Signal() : m_head(nullptr), m_tail(nullptr), m_emissions(nullptr) {}
+	~Signal() {
+		while (m_head)
+			Unlink(m_head);
+	}
+
+	void emit(Args... args) {
+		// the emission is on the stack and linked into the signal, so a slot
+		// going away mid-emission moves it along rather than leaving it dangling
+		Emission e = { m_head, m_emissions };
+		m_emissions = &e;
+		while (e.next) {
+			Slot *s = e.next;
+			e.next = s->m_next;
+			s->m_call(&s->m_buffer, args...);
+		}
+		m_emissions = e.prev;
+	}
+
+	bool empty() const { return m_head == nullptr; }
+
+private:
+	Signal(const Signal &);
+	Signal &operator=(const Signal &);
+
+	struct Emission {
+		Slot *next;
+		Emission *prev;
+	};
+
+	void Link(Slot *s) {
+		assert(!s->m_signal);
+		s->m_signal = this;
+		s->m_prev = m_tail;
+		s->m_next = nullptr;
+		if (m_tail)
+			m_tail->m_next = s;
+		else
+			m_head = s;
+		m_tail = s;
+	}
+
+	void Unlink(Slot *s) {
+		assert(s->m_signal == this);
+		for (Emission *e = m_emissions; e; e = e->prev)
+			if (e->next == s)
+				e->next = s->m_next;
+		if (s->m_prev)
+			s->m_prev->m_next = s->m_next;
+		else
+			m_head = s->m_next;
+		if (s->m_next)
+			s->m_next->m_prev = s->m_prev;
+		else
+			m_tail = s->m_prev;
+		s->m_signal = nullptr;
+		s->m_prev = s->m_next = nullptr;
+	}
+
+	Slot *m_head;
+	Slot *m_tail;
+	Emission *m_emissions;
+};
+
+#endif
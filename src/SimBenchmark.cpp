@@ -0,0 +1,123 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "SimBenchmark.h"
+#include "Pi.h"
+#include "Game.h"
+#include "Player.h"
+#include "Space.h"
+#include "JobQueue.h"
+#include "Lua.h"
+#include "LuaManager.h"
+#include "Serializer.h"
+#include "galaxy/SystemPath.h"
+#include <cstdio>
+
+// same as the main loop gives completed jobs each frame
+static const double FINISH_JOBS_BUDGET = 0.002;
+
+namespace SimBenchmark {
+
+Game *StartScenario(const std::string &scenario)
+{
+	int x, y, z;
+	unsigned int systemIndex, bodyIndex;
+	char extra;
+	if (sscanf(scenario.c_str(), "%d,%d,%d,%u,%u%c", &x, &y, &z, &systemIndex, &bodyIndex, &extra) == 5) {
+		try {
+			return new Game(SystemPath(x, y, z, systemIndex, bodyIndex));
+		}
+		catch (InvalidGameStartLocation &e) {
+			Output("simbench: invalid starting location: %s\n", e.error.c_str());
+			return nullptr;
+		}
+	}
+
+	try {
+		return Game::LoadGame(scenario);
+	}
+	catch (SavedGameCorruptException) {
+		Output("simbench: save '%s' is corrupt\n", scenario.c_str());
+	}
+	catch (SavedGameWrongVersionException) {
+		Output("simbench: save '%s' is from another version\n", scenario.c_str());
+	}
+	catch (CouldNotOpenFileException) {
+		Output("simbench: couldn't open save '%s'\n", scenario.c_str());
+	}
+	return nullptr;
+}
+
+static void OutputPart(const char *name, double seconds, Uint32 ticks, double total)
+{
+	Output("  %-12s %9.3f ms/tick  %5.1f%%\n", name, seconds * 1e3 / double(ticks), total > 0.0 ? seconds * 100.0 / total : 0.0);
+}
+
+bool Run(const std::string &scenario, Uint32 ticks, Uint32 seed)
+{
+	Pi::rng.seed(seed);
+
+	Pi::game = StartScenario(scenario);
+	if (!Pi::game)
+		return false;
+
+	Pi::InitGame();
+	Pi::StartGame();
+	Pi::game->SetTimeAccel(Game::TIMEACCEL_1X);
+	Pi::game->RequestTimeAccel(Game::TIMEACCEL_1X);
+	Lua::manager->SetGarbageBudget(Pi::config->Float("LuaGCBudgetMs") * 0.001);
+
+	const double counterPeriod = 1.0 / double(SDL_GetPerformanceFrequency());
+	const float step = Pi::game->GetTimeStep();
+	Uint32 asyncDeferred = 0, syncDeferred = 0;
+	double total = 0.0, gcTime = 0.0;
+	Uint32 done = 0;
+
+	Output("simbench: %s, seed %u, %u bodies, %u ticks of %.4fs\n", scenario.c_str(), seed,
+		Pi::game->GetSpace()->GetNumBodies(), ticks, step);
+	Pi::game->GetSpace()->ResetStepTimes();
+
+	while (done < ticks) {
+		const Uint64 start = SDL_GetPerformanceCounter();
+		Pi::game->TimeStep(step);
+		Pi::GetAsyncJobQueue()->FinishJobs(FINISH_JOBS_BUDGET, asyncDeferred);
+		Pi::GetSyncJobQueue()->FinishJobs(FINISH_JOBS_BUDGET, syncDeferred);
+		const Uint64 gcStart = SDL_GetPerformanceCounter();
+		Lua::manager->StepGarbage();
+		const Uint64 end = SDL_GetPerformanceCounter();
+		gcTime += double(end - gcStart) * counterPeriod;
+		total += double(end - start) * counterPeriod;
+		done++;
+
+		// a hyperspace jump would leave the times behind in the old space
+		if (!Pi::game->IsNormalSpace()) {
+			Output("simbench: left normal space after %u ticks, stopping\n", done);
+			break;
+		}
+		if (Pi::player->IsDead()) {
+			Output("simbench: player died after %u ticks, stopping\n", done);
+			break;
+		}
+	}
+
+	if (done) {
+		const Space::StepTimes &t = Pi::game->GetSpace()->GetStepTimes();
+		Output("simbench: %u ticks in %.3fs, %.1f ticks/s, %u bodies at the end\n", done, total, double(done) / total,
+			Pi::game->GetSpace()->GetNumBodies());
+		OutputPart("collisions", t.collisions, done, total);
+		OutputPart("bodies/ai", t.bodies, done, total);
+		OutputPart("projectiles", t.projectiles, done, total);
+		OutputPart("movement", t.movement, done, total);
+		OutputPart("lua events", t.luaEvents, done, total);
+		OutputPart("lua timers", t.luaTimers, done, total);
+		OutputPart("cleanup", t.cleanup, done, total);
+		OutputPart("lua gc", gcTime, done, total);
+		const double space = t.collisions + t.bodies + t.projectiles + t.movement + t.luaEvents + t.luaTimers + t.cleanup;
+		OutputPart("other", total - space - gcTime, done, total);
+	}
+
+	Pi::EndGame();
+	return true;
+}
+
+}
@@ -0,0 +1,31 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SIMBENCHMARK_H
+#define _SIMBENCHMARK_H
+
+#include "libs.h"
+#include <string>
+
+/*
+ * Headless simulation benchmark, for catching performance regressions.
+ * Starts a game, steps it a fixed number of ticks as fast as it will go and
+ * reports the tick rate with a breakdown of where the time went. Nothing is
+ * drawn; Pi should be initialised headless first.
+ *
+ * The scenario is either a save file name, or a system body path
+ * ("x,y,z,system,body") to start a new game at. The seed goes into Pi::rng
+ * before the game starts, so runs with the same scenario and seed simulate
+ * the same thing.
+ */
+class Game;
+
+namespace SimBenchmark {
+	// returns false if the scenario couldn't be started
+	bool Run(const std::string &scenario, Uint32 ticks, Uint32 seed);
+
+	// a new game for the scenario, or null (with the reason logged)
+	Game *StartScenario(const std::string &scenario);
+}
+
+#endif
@@ -17,12 +17,22 @@
 #include "Pi.h"
 #include "Player.h"
 #include "FileSystem.h"
+#include "JobQueue.h"
+#include <atomic>
+#include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOUND_SSE2 1
+#include <emmintrin.h>
+#endif
 
 namespace Sound {
 
 static const unsigned int FREQ = 44100;
 static const unsigned int BUF_SIZE = 4096;
-static const unsigned int MAX_WAVSTREAMS = 10; //first two are for music
+static const unsigned int MAX_WAVSTREAMS = 66; //first two are for music
+// per channel. quieter than this a new sound isn't worth a voice
+static const float MIN_AUDIBLE_VOLUME = 1.0f / 512.0f;
 static const double STREAM_IF_LONGER_THAN = 10.0;
 
 class OggFileDataStream {
@@ -131,7 +141,7 @@ float GetSfxVolume()
 	return m_sfxVol;
 }
 
-eventid BodyMakeNoise(const Body *b, const char *sfx, float vol)
+eventid BodyMakeNoise(const Body *b, const StringName &sfx, float vol)
 {
 	vector3d pos;
 
@@ -156,13 +166,16 @@ eventid BodyMakeNoise(const Body *b, const char *sfx, float vol)
 	v[0] = Clamp(v[0], 0.0f, 1.0f);
 	v[1] = Clamp(v[1], 0.0f, 1.0f);
 
+	// too far off to hear, don't take a voice for it
+	if (v[0] < MIN_AUDIBLE_VOLUME && v[1] < MIN_AUDIBLE_VOLUME)
+		return 0;
+
 	return Sound::PlaySfx(sfx, v[0], v[1], 0);
 }
 
 struct SoundEvent {
 	const Sample *sample;
-	OggVorbis_File *oggv; // if sample->buf = 0 then stream this
-	OggFileDataStream ogg_data_stream;
+	bool streaming; // sample->buf was 0 when it started, so it has a Stream
 	Uint32 buf_pos;
 	float volume[2]; // left and right channels
 	eventid identifier;
@@ -170,16 +183,311 @@ struct SoundEvent {
 
 	float targetVolume[2];
 	float rateOfChange[2]; // per sample
-	bool ascend[2];
 };
 
-static std::map<std::string, Sample> sfx_samples;
+// looked up by interned name, so playing a sound compares pointers rather than strings
+static SampleMap sfx_samples;
 struct SoundEvent wavstream[MAX_WAVSTREAMS];
 
-static Sample *GetSample(const char *filename)
+// samples that aren't decoded are streamed through a ring buffer per voice,
+// filled on a thread of their own. the mixer only ever copies out of the
+// ring, so file reads and vorbis decoding can't hold up the audio callback.
+// if the decoder falls behind the voice just pauses until it catches up
+struct Stream {
+	enum { RING_SIZE = 1 << 17, RING_MASK = RING_SIZE - 1 }; // Sint16s, ~1.5s of stereo
+
+	Stream() : readPos(0), writePos(0), active(false), failed(false), generation(0), opened(false) {}
+
+	// allocated the first time the voice streams anything
+	std::unique_ptr<Sint16[]> ring;
+	// free running. only the mixer moves readPos, only the decoder writePos
+	std::atomic<Uint32> readPos;
+	std::atomic<Uint32> writePos;
+	// cleared by the mixer when the voice ends, the decoder then closes up
+	std::atomic<bool> active;
+	std::atomic<bool> failed;
+
+	// decoder state, under s_streamLock
+	Uint32 generation;
+	std::string path;
+	bool opened;
+	OggVorbis_File oggv;
+	OggFileDataStream data;
+};
+
+// Sint16s decoded per stream per pass, so one stream can't starve the rest
+static const Uint32 STREAM_DECODE_CHUNK = 8192;
+static const Uint32 STREAM_IDLE_WAIT_MS = 10;
+
+static Stream *s_streams = 0;
+static SDL_mutex *s_streamLock = 0;
+static SDL_cond *s_streamCond = 0;
+static SDL_Thread *s_streamThread = 0;
+static bool s_streamQuit = false;
+
+// mixer side. returns the number of Sint16s copied
+static int stream_read(Stream &st, Sint16 *out, int wanted)
+{
+	const Uint32 r = st.readPos.load(std::memory_order_relaxed);
+	const Uint32 w = st.writePos.load(std::memory_order_acquire);
+	const Uint32 n = std::min(Uint32(wanted), w - r);
+	const Uint32 idx = r & Stream::RING_MASK;
+	const Uint32 first = std::min(n, Uint32(Stream::RING_SIZE) - idx);
+	memcpy(out, &st.ring[idx], first * sizeof(Sint16));
+	memcpy(out + first, &st.ring[0], (n - first) * sizeof(Sint16));
+	st.readPos.store(r + n, std::memory_order_release);
+	return int(n);
+}
+
+static void stream_close(Stream &st)
+{
+	if (st.opened) {
+		ov_clear(&st.oggv);
+		st.opened = false;
+	}
+}
+
+// decoder side, with s_streamLock held. returns true if it decoded anything
+static bool stream_fill(Stream &st)
+{
+	Uint32 w = st.writePos.load(std::memory_order_relaxed);
+	const Uint32 space = Stream::RING_SIZE - (w - st.readPos.load(std::memory_order_acquire));
+	if (space < STREAM_DECODE_CHUNK)
+		return false;
+
+	Uint32 todo = STREAM_DECODE_CHUNK;
+	bool rewound = false;
+	while (todo) {
+		const Uint32 idx = w & Stream::RING_MASK;
+		const Uint32 contiguous = std::min(todo, Uint32(Stream::RING_SIZE) - idx);
+		int section;
+		const long amt = ov_read(&st.oggv, reinterpret_cast<char*>(&st.ring[idx]), contiguous * 2, 0, 2, 1, &section);
+		if (amt == OV_HOLE)
+			continue;
+		if (amt < 0 || (amt == 0 && rewound)) {
+			Output("Vorbis stream failed for '%s'\n", st.path.c_str());
+			st.failed = true;
+			break;
+		}
+		if (amt == 0) {
+			// always loop. if the voice doesn't repeat, the mixer stops
+			// at the end of the sample and the rest is never played
+			ov_pcm_seek(&st.oggv, 0);
+			rewound = true;
+			continue;
+		}
+		rewound = false;
+		w += Uint32(amt / 2);
+		todo -= std::min(todo, Uint32(amt / 2));
+		st.writePos.store(w, std::memory_order_release);
+	}
+	return true;
+}
+
+static int stream_thread(void *)
 {
-	if (sfx_samples.find(filename) != sfx_samples.end()) {
-		return &sfx_samples[filename];
+	SDL_LockMutex(s_streamLock);
+	while (!s_streamQuit) {
+		bool busy = false;
+		for (unsigned int i = 0; i < MAX_WAVSTREAMS; i++) {
+			Stream &st = s_streams[i];
+			if (!st.active) {
+				stream_close(st);
+				continue;
+			}
+			if (st.failed)
+				continue;
+
+			if (!st.opened) {
+				// read the file without holding everyone else up
+				const Uint32 generation = st.generation;
+				const std::string path = st.path;
+				SDL_UnlockMutex(s_streamLock);
+				RefCountedPtr<FileSystem::FileData> oggdata = FileSystem::gameDataFiles.ReadFile(path);
+				SDL_LockMutex(s_streamLock);
+				busy = true;
+				if (st.generation != generation || !st.active)
+					continue;
+				if (!oggdata) {
+					Output("Could not open '%s'\n", path.c_str());
+					st.failed = true;
+					continue;
+				}
+				st.data.Reset(oggdata);
+				if (ov_open_callbacks(&st.data, &st.oggv, 0, 0, OggFileDataStream::CALLBACKS) < 0) {
+					Output("Vorbis could not understand '%s'\n", path.c_str());
+					st.data.Reset();
+					st.failed = true;
+					continue;
+				}
+				st.opened = true;
+			}
+
+			busy |= stream_fill(st);
+		}
+
+		if (busy) {
+			// give voices being started a look in between passes
+			SDL_UnlockMutex(s_streamLock);
+			SDL_LockMutex(s_streamLock);
+		} else
+			SDL_CondWaitTimeout(s_streamCond, s_streamLock, STREAM_IDLE_WAIT_MS);
+	}
+	for (unsigned int i = 0; i < MAX_WAVSTREAMS; i++)
+		stream_close(s_streams[i]);
+	SDL_UnlockMutex(s_streamLock);
+	return 0;
+}
+
+// point the stream for a voice at a new file. with s_streamLock and the
+// audio lock held, and the voice's previous event already destroyed
+static void stream_start(unsigned int idx, const std::string &path)
+{
+	Stream &st = s_streams[idx];
+	stream_close(st);
+	if (!st.ring)
+		st.ring.reset(new Sint16[Stream::RING_SIZE]);
+	st.path = path;
+	st.generation++;
+	st.readPos = 0;
+	st.writePos = 0;
+	st.failed = false;
+	st.active = true;
+}
+
+// decoded sample memory. over the budget, the least recently played samples
+// that aren't playing go back to being streamed
+static size_t s_decodedBytes = 0;
+static size_t s_decodedBudget = 0;
+static Uint64 s_useCounter = 0;
+static std::unique_ptr<JobSet> s_decodeJobs;
+
+// decode a whole ogg. returns 0 if it can't be read
+static Uint16 *decode_sample(const std::string &path, Uint32 buf_len)
+{
+	RefCountedPtr<FileSystem::FileData> oggdata = FileSystem::gameDataFiles.ReadFile(path);
+	if (!oggdata)
+		return 0;
+	OggFileDataStream datastream(oggdata);
+	oggdata.Reset();
+	OggVorbis_File oggv;
+	if (ov_open_callbacks(&datastream, &oggv, 0, 0, OggFileDataStream::CALLBACKS) < 0)
+		return 0;
+
+	Uint16 *buf = new Uint16[buf_len];
+	int i=0;
+	for (;;) {
+		int music_section;
+		int amt = ov_read(&oggv, reinterpret_cast<char*>(buf) + i,
+				2*buf_len - i, 0, 2, 1, &music_section);
+		if (amt <= 0) break;
+		i += amt;
+	}
+	// anything short of the length vorbis promised is silence
+	memset(reinterpret_cast<char*>(buf) + i, 0, 2*buf_len - i);
+
+	ov_clear(&oggv);
+	return buf;
+}
+
+static bool is_playing(const Sample *sample)
+{
+	for (unsigned int i = 0; i < MAX_WAVSTREAMS; i++)
+		if (wavstream[i].sample == sample)
+			return true;
+	return false;
+}
+
+static void evict_samples(const Sample *keep)
+{
+	if (!s_decodedBudget)
+		return;
+	SDL_LockAudio();
+	while (s_decodedBytes > s_decodedBudget) {
+		Sample *victim = 0;
+		for (SampleMap::iterator it = sfx_samples.begin(); it != sfx_samples.end(); ++it) {
+			Sample &s = it->second;
+			if (!s.buf || !s.decodable || &s == keep || is_playing(&s))
+				continue;
+			if (!victim || s.lastUsed < victim->lastUsed)
+				victim = &s;
+		}
+		if (!victim)
+			break;
+		delete[] victim->buf;
+		victim->buf = 0;
+		s_decodedBytes -= victim->buf_len * sizeof(Uint16);
+	}
+	SDL_UnlockAudio();
+}
+
+static void install_sample(Sample *sample, Uint16 *buf)
+{
+	sample->decoding = false;
+	if (!buf)
+		return;
+	// the mixer picks it up mid-play, from the same position
+	SDL_LockAudio();
+	sample->buf = buf;
+	SDL_UnlockAudio();
+	s_decodedBytes += sample->buf_len * sizeof(Uint16);
+	evict_samples(sample);
+}
+
+class DecodeJob : public Job {
+public:
+	DecodeJob(const StringName &name, const Sample &sample)
+		: m_name(name), m_path(sample.path), m_bufLen(sample.buf_len), m_buf(0) { SetLane(LANE_IO); }
+	virtual ~DecodeJob() { delete[] m_buf; }
+
+	virtual void OnRun() override { m_buf = decode_sample(m_path, m_bufLen); }
+
+	virtual void OnFinish() override {
+		SampleMap::iterator it = sfx_samples.find(m_name);
+		if (it == sfx_samples.end())
+			return;
+		if (!m_buf)
+			Output("Could not decode '%s'\n", m_path.c_str());
+		install_sample(&it->second, m_buf);
+		m_buf = 0;
+	}
+
+	virtual const char *GetName() const override { return "Sound::DecodeJob"; }
+
+private:
+	StringName m_name;
+	std::string m_path;
+	Uint32 m_bufLen;
+	Uint16 *m_buf;
+};
+
+// mark the sample used, and get it decoded if it isn't
+static void touch_sample(const StringName &name, Sample *sample)
+{
+	sample->lastUsed = ++s_useCounter;
+	if (!sample->decodable || sample->buf || sample->decoding)
+		return;
+
+	sample->decoding = true;
+	if (s_decodeJobs)
+		s_decodeJobs->Order(new DecodeJob(name, *sample));
+	else
+		install_sample(sample, decode_sample(sample->path, sample->buf_len));
+}
+
+void Prefetch(const StringName &fx)
+{
+	SampleMap::iterator it = sfx_samples.find(fx);
+	if (it != sfx_samples.end())
+		touch_sample(it->first, &it->second);
+}
+
+static Sample *GetSample(const StringName &filename)
+{
+	SampleMap::iterator it = sfx_samples.find(filename);
+	if (it != sfx_samples.end()) {
+		touch_sample(it->first, &it->second);
+		return &it->second;
 	} else {
 		//SilentWarning("Unknown sound sample: %s", filename);
 		return 0;
@@ -211,12 +519,10 @@ bool SetOp(eventid id, Op op)
 
 static void DestroyEvent(SoundEvent *ev)
 {
-	if (ev->oggv) {
-		// streaming ogg
-		ov_clear(ev->oggv);
-		delete ev->oggv;
-		ev->oggv = 0;
-		ev->ogg_data_stream.Reset();
+	if (ev->streaming) {
+		// the decoder thread closes the file when it notices
+		s_streams[ev - wavstream].active = false;
+		ev->streaming = false;
 	}
 	ev->sample = 0;
 }
@@ -225,28 +531,54 @@ static void DestroyEvent(SoundEvent *ev)
  * Volume should be 0-65535
  */
 static Uint32 identifier = 1;
-eventid PlaySfx (const char *fx, const float volume_left, const float volume_right, const Op op)
+// how much a voice deserves to keep playing when they're all taken. loops
+// (engines, ambience) win over one-shots, since they can't just be replayed
+// next frame, then the loudest the voice is or is going to be
+static float voice_priority(float volume_left, float volume_right, Uint32 op)
+{
+	return std::max(volume_left, volume_right) + ((op & OP_REPEAT) ? 1.0f : 0.0f);
+}
+
+static float voice_priority(const SoundEvent &ev)
+{
+	return voice_priority(std::max(ev.volume[0], ev.targetVolume[0]),
+		std::max(ev.volume[1], ev.targetVolume[1]), ev.op);
+}
+
+eventid PlaySfx (const StringName &fx, const float volume_left, const float volume_right, const Op op)
 {
+	Sample *sample = GetSample(fx);
+	const bool streamed = sample && !sample->buf;
+	if (streamed) SDL_LockMutex(s_streamLock);
 	SDL_LockAudio();
 	unsigned int idx;
-	Uint32 age;
 	/* find free wavstream (first two reserved for music) */
 	for (idx = 2; idx < MAX_WAVSTREAMS; idx++) {
 		if (!wavstream[idx].sample) break;
 	}
 	if (idx == MAX_WAVSTREAMS) {
-		/* otherwise overwrite oldest one */
-		age = 0; idx = 0;
+		/* otherwise take the one that matters least, the oldest of those
+		 * if there's a tie. if that still matters more, don't play at all */
+		float lowest = 0.0f;
+		Uint32 age = 0;
 		for (unsigned int i = 2; i < MAX_WAVSTREAMS; i++) {
-			if ((i==0) || (wavstream[i].buf_pos > age)) {
+			const float priority = voice_priority(wavstream[i]);
+			if (i == 2 || priority < lowest || (priority <= lowest && wavstream[i].buf_pos > age)) {
 				idx = i;
+				lowest = priority;
 				age = wavstream[i].buf_pos;
 			}
 		}
+		if (lowest > voice_priority(volume_left * GetSfxVolume(), volume_right * GetSfxVolume(), op)) {
+			SDL_UnlockAudio();
+			if (streamed) SDL_UnlockMutex(s_streamLock);
+			return 0;
+		}
 		DestroyEvent(&wavstream[idx]);
 	}
-	wavstream[idx].sample = GetSample(fx);
-	wavstream[idx].oggv = 0;
+	wavstream[idx].sample = sample;
+	wavstream[idx].streaming = streamed;
+	if (streamed) stream_start(idx, sample->path);
 	wavstream[idx].buf_pos = 0;
 	wavstream[idx].volume[0] = volume_left * GetSfxVolume();
 	wavstream[idx].volume[1] = volume_right * GetSfxVolume();
@@ -256,21 +588,29 @@ eventid PlaySfx (const char *fx, const float volume_left, const float volume_rig
 	wavstream[idx].targetVolume[1] = volume_right * GetSfxVolume();
 	wavstream[idx].rateOfChange[0] = wavstream[idx].rateOfChange[1] = 0.0f;
 	SDL_UnlockAudio();
+	if (streamed) {
+		SDL_CondSignal(s_streamCond);
+		SDL_UnlockMutex(s_streamLock);
+	}
 	return identifier++;
 }
 
 //unlike PlaySfx, we want uninterrupted play and do not care about age
 //alternate between two streams for crossfade
 static int nextMusicStream = 0;
-eventid PlayMusic(const char *fx, const float volume_left, const float volume_right, const Op op)
+eventid PlayMusic(const StringName &fx, const float volume_left, const float volume_right, const Op op)
 {
 	const int idx = nextMusicStream;
 	nextMusicStream ^= 1;
+	Sample *sample = GetSample(fx);
+	const bool streamed = sample && !sample->buf;
+	if (streamed) SDL_LockMutex(s_streamLock);
 	SDL_LockAudio();
 	if (wavstream[idx].sample)
 		DestroyEvent(&wavstream[idx]);
-	wavstream[idx].sample = GetSample(fx);
-	wavstream[idx].oggv = 0;
+	wavstream[idx].sample = sample;
+	wavstream[idx].streaming = streamed;
+	if (streamed) stream_start(idx, sample->path);
 	wavstream[idx].buf_pos = 0;
 	wavstream[idx].volume[0] = volume_left;
 	wavstream[idx].volume[1] = volume_right;
@@ -280,156 +620,196 @@ eventid PlayMusic(const char *fx, const float volume_left, const float volume_ri
 	wavstream[idx].targetVolume[1] = volume_right;
 	wavstream[idx].rateOfChange[0] = wavstream[idx].rateOfChange[1] = 0.0f;
 	SDL_UnlockAudio();
+	if (streamed) {
+		SDL_CondSignal(s_streamCond);
+		SDL_UnlockMutex(s_streamLock);
+	}
 	return identifier++;
 }
 
 /*
- * len is the number of floats to put in buffer, NOT full samples (a sample would be 2 floats since stereo)
+ * Writes up to frames stereo frames of a voice, unscaled and at the output
+ * rate, into out. Fewer if the voice ends or its stream has run dry. tmp
+ * needs room for the input of frames*2 Sint16s
  */
 template <int T_channels, int T_upsample>
-static void fill_audio_1stream(float *buffer, int len, int stream_num)
+static int gather_voice(unsigned int stream_num, Sint16 *tmp, float *out, int frames)
 {
-	// inbuf will be smaller for mono and for 22050hz samples
-	Sint16 *inbuf = static_cast<Sint16*>(alloca(len*T_channels / T_upsample));
-	// hm pity to put this here ^^ since not used by ev.sample->buf case
 	SoundEvent &ev = wavstream[stream_num];
-	int inbuf_pos = 0;
-	int pos = 0;
-	while ((pos < len) && ev.sample) {
+	Stream &st = s_streams[stream_num];
+	int done = 0;
+	while ((done < frames) && ev.sample) {
+		const Sint16 *inbuf;
+		int n = std::min((frames - done) / T_upsample, int((ev.sample->buf_len - ev.buf_pos) / T_channels));
 		if (ev.sample->buf) {
-			// already decoded
-			inbuf = reinterpret_cast<Sint16 *>(ev.sample->buf);
-			inbuf_pos = ev.buf_pos;
-		} else {
-			// stream ogg vorbis
-			// ogg vorbis streaming
-			if (!ev.oggv) {
-				// open file to start streaming
-				ev.oggv = new OggVorbis_File;
-				RefCountedPtr<FileSystem::FileData> oggdata = FileSystem::gameDataFiles.ReadFile(ev.sample->path);
-				if (!oggdata) {
-					Output("Could not open '%s'", ev.sample->path.c_str());
-					ev.sample = 0;
-					return;
-				}
-				ev.ogg_data_stream.Reset(oggdata);
-				oggdata.Reset();
-				if (ov_open_callbacks(&ev.ogg_data_stream, ev.oggv, 0, 0, OggFileDataStream::CALLBACKS) < 0) {
-					Output("Vorbis could not understand '%s'", ev.sample->path.c_str());
-					ev.sample = 0;
-					return;
-				}
+			// already decoded. if that happened while it was being
+			// streamed, carry on from the same place
+			if (ev.streaming) {
+				st.active = false;
+				ev.streaming = false;
 			}
-			int i=0;
-			// (len-pos) = num floats the destination buffer wants.
-			// if we are stereo then to fill this we need (len-pos)*2 bytes
-			// if we are mono we want (len-pos) bytes
-			int wanted_bytes = (len-pos)*T_channels / T_upsample;
-			for (;;) {
-				int music_section;
-				if (wanted_bytes == 0) break;
-				int amt = ov_read(ev.oggv, reinterpret_cast<char*>(inbuf) + i,
-						wanted_bytes, 0, 2, 1, &music_section);
-				i += amt;
-				wanted_bytes -= amt;
-				if (amt == 0) break;
+			inbuf = reinterpret_cast<const Sint16 *>(ev.sample->buf) + ev.buf_pos;
+		} else {
+			if (st.failed) {
+				DestroyEvent(&ev);
+				break;
 			}
+			// whatever the decoder thread has ready. if it's behind, play
+			// what there is and pick up from there next time. a stream
+			// carries straight on at the end, the decoder has already gone
+			// round to the start
+			n = stream_read(st, tmp, n*T_channels) / T_channels;
+			inbuf = tmp;
 		}
+		if (n == 0)
+			break;
 
-		while (pos < len) {
-			/* Volume animations */
-			for (int chan=0; chan<2; chan++) {
-				if (ev.ascend[chan]) {
-					ev.volume[chan] = std::min(ev.volume[chan] + ev.rateOfChange[chan], ev.targetVolume[chan]);
-				} else {
-					ev.volume[chan] = std::max(ev.volume[chan] - ev.rateOfChange[chan], ev.targetVolume[chan]);
-				}
+		float *o = out + 2*done;
+		for (int j = 0; j < n; j++) {
+			const float s0 = float(inbuf[j*T_channels]);
+			const float s1 = float(inbuf[j*T_channels + T_channels-1]);
+			o[0] = s0;
+			o[1] = s1;
+			if (T_upsample == 2) {
+				o[2] = s0;
+				o[3] = s1;
 			}
+			o += 2*T_upsample;
+		}
+		done += n*T_upsample;
+		ev.buf_pos += n*T_channels;
+
+		/* Repeat or end? */
+		if (ev.buf_pos >= ev.sample->buf_len) {
+			ev.buf_pos = 0;
+			if (!(ev.op & OP_REPEAT))
+				DestroyEvent(&ev);
+		}
+	}
+	return done;
+}
 
-			float s0, s1;
-
-			if (T_channels == 1) {
-				s0 = float(inbuf[inbuf_pos++]);
-				s1 = ev.volume[1] * s0;
-				s0 = ev.volume[0] * s0;
-				ev.buf_pos += 1;
-			} else /* stereo */ {
-				s0 = ev.volume[0] * float(inbuf[inbuf_pos++]);
-				s1 = ev.volume[1] * float(inbuf[inbuf_pos++]);
-				ev.buf_pos += 2;
-			}
+static int gather_voice(unsigned int stream_num, Sint16 *tmp, float *out, int frames)
+{
+	const Sample *sample = wavstream[stream_num].sample;
+	if (sample->channels == 1) {
+		if (sample->upsample == 1)
+			return gather_voice<1,1>(stream_num, tmp, out, frames);
+		else
+			return gather_voice<1,2>(stream_num, tmp, out, frames);
+	} else {
+		if (sample->upsample == 1)
+			return gather_voice<2,1>(stream_num, tmp, out, frames);
+		else
+			return gather_voice<2,2>(stream_num, tmp, out, frames);
+	}
+}
 
-			if (T_upsample == 1) {
-				buffer[pos] += s0;
-				buffer[pos+1] += s1;
-				pos += 2;
-			} else {
-				buffer[pos] += s0;
-				buffer[pos+1] += s1;
-				buffer[pos+2] += s0;
-				buffer[pos+3] += s1;
-				pos += 4;
-			}
+// a silent decoded voice only has to keep its place
+static void skip_voice(SoundEvent &ev, int frames)
+{
+	ev.buf_pos += Uint32(frames / ev.sample->upsample) * ev.sample->channels;
+	if (ev.buf_pos >= ev.sample->buf_len) {
+		if ((ev.op & OP_REPEAT) && ev.sample->buf_len)
+			ev.buf_pos %= ev.sample->buf_len;
+		else
+			DestroyEvent(&ev);
+	}
+}
 
-			/* Repeat or end? */
-			if (ev.buf_pos >= ev.sample->buf_len) {
-				ev.buf_pos = 0;
-				inbuf_pos = 0;
-				if (!(ev.op & OP_REPEAT)) {
-					DestroyEvent(&ev);
-					break;
-				}
-				if (ev.oggv) {
-					// streaming ogg
-					ov_pcm_seek(ev.oggv, 0);
-					// repeat outer loop to decode some
-					// more vorbis from the start of the stream
-					break;
-				}
+static bool is_ramping(const SoundEvent &ev, int chan)
+{
+	return (ev.rateOfChange[chan] > 0.0f) && (ev.volume[chan] < ev.targetVolume[chan] || ev.volume[chan] > ev.targetVolume[chan]);
+}
+
+// out += volume * in, for interleaved stereo frames
+static void mix_constant(float *out, const float *in, int frames, float v0, float v1)
+{
+	int i = 0;
+#ifdef SOUND_SSE2
+	const __m128 vol = _mm_setr_ps(v0, v1, v0, v1);
+	for (; i + 2 <= frames; i += 2) {
+		const __m128 o = _mm_loadu_ps(out + 2*i);
+		_mm_storeu_ps(out + 2*i, _mm_add_ps(o, _mm_mul_ps(vol, _mm_loadu_ps(in + 2*i))));
+	}
+#endif
+	for (; i < frames; i++) {
+		out[2*i] += v0 * in[2*i];
+		out[2*i+1] += v1 * in[2*i+1];
+	}
+}
+
+/*
+ * Adds frames stereo frames from in to out at the voice's volume. Volume
+ * animations step once per output frame until both channels get there,
+ * anything after that is mixed at a constant volume
+ */
+static void mix_voice(SoundEvent &ev, const float *in, float *out, int frames)
+{
+	int i = 0;
+	for (; (i < frames) && (is_ramping(ev, 0) || is_ramping(ev, 1)); i++) {
+		/* Volume animations */
+		for (int chan=0; chan<2; chan++) {
+			if (ev.targetVolume[chan] > ev.volume[chan]) {
+				ev.volume[chan] = std::min(ev.volume[chan] + ev.rateOfChange[chan], ev.targetVolume[chan]);
+			} else {
+				ev.volume[chan] = std::max(ev.volume[chan] - ev.rateOfChange[chan], ev.targetVolume[chan]);
 			}
 		}
+		out[2*i] += ev.volume[0] * in[2*i];
+		out[2*i+1] += ev.volume[1] * in[2*i+1];
 	}
+	mix_constant(out + 2*i, in + 2*i, frames - i, ev.volume[0], ev.volume[1]);
 }
 
 static void fill_audio(void *udata, Uint8 *dsp_buf, int len)
 {
-	const int len_in_floats = len>>1;
-	float *tmpbuf = static_cast<float*>(alloca(sizeof(float)*len_in_floats)); // len is in chars not samples
+	const int len_in_floats = len>>1; // len is in chars not samples
+	const int frames = len_in_floats>>1;
+	float *tmpbuf = static_cast<float*>(alloca(sizeof(float)*len_in_floats));
 	memset(static_cast<void*>(tmpbuf), 0, sizeof(float)*len_in_floats);
+	// one voice at a time, gathered at the output rate and then mixed in
+	float *voicebuf = static_cast<float*>(alloca(sizeof(float)*len_in_floats));
+	Sint16 *inbuf = static_cast<Sint16*>(alloca(sizeof(Sint16)*len_in_floats));
 
 	for (unsigned int i = 0; i < MAX_WAVSTREAMS; i++) {
-		if (!wavstream[i].sample) continue;
+		SoundEvent &ev = wavstream[i];
+		if (!ev.sample) continue;
 
-		wavstream[i].ascend[0] = (wavstream[i].targetVolume[0] > wavstream[i].volume[0]);
-		wavstream[i].ascend[1] = (wavstream[i].targetVolume[1] > wavstream[i].volume[1]);
-
-		if (wavstream[i].op & OP_STOP_AT_TARGET_VOLUME) {
-			if ((wavstream[i].targetVolume[0] <= wavstream[i].volume[0]) &&
-			    (wavstream[i].targetVolume[1] <= wavstream[i].volume[1])) {
-				DestroyEvent(&wavstream[i]);
+		if (ev.op & OP_STOP_AT_TARGET_VOLUME) {
+			if ((ev.targetVolume[0] <= ev.volume[0]) &&
+			    (ev.targetVolume[1] <= ev.volume[1])) {
+				DestroyEvent(&ev);
 				continue;
 			}
 		}
 
-		if (wavstream[i].sample->channels == 1) {
-			if (wavstream[i].sample->upsample == 1) {
-				fill_audio_1stream<1,1>(tmpbuf, len_in_floats, i);
-			} else {
-				fill_audio_1stream<1,2>(tmpbuf, len_in_floats, i);
-			}
-		} else {
-			if (wavstream[i].sample->upsample == 1) {
-				fill_audio_1stream<2,1>(tmpbuf, len_in_floats, i);
-			} else {
-				fill_audio_1stream<2,2>(tmpbuf, len_in_floats, i);
-			}
+		if (ev.sample->buf && !ev.streaming &&
+				!(ev.volume[0] > 0.0f) && !(ev.volume[1] > 0.0f) &&
+				!(ev.targetVolume[0] > 0.0f) && !(ev.targetVolume[1] > 0.0f)) {
+			skip_voice(ev, frames);
+			continue;
 		}
+
+		const int got = gather_voice(i, inbuf, voicebuf, frames);
+		mix_voice(ev, voicebuf, tmpbuf, got);
 	}
 
 	/* Convert float sample buffer to Sint16 samples the hardware likes */
-	for (int pos=0; pos<len_in_floats; pos++) {
+	Sint16 *out = reinterpret_cast<Sint16*>(dsp_buf);
+	int pos = 0;
+#ifdef SOUND_SSE2
+	// packs saturates, so no need to clamp first
+	const __m128 master = _mm_set1_ps(m_masterVol);
+	for (; pos + 8 <= len_in_floats; pos += 8) {
+		const __m128i lo = _mm_cvttps_epi32(_mm_mul_ps(master, _mm_loadu_ps(tmpbuf + pos)));
+		const __m128i hi = _mm_cvttps_epi32(_mm_mul_ps(master, _mm_loadu_ps(tmpbuf + pos + 4)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + pos), _mm_packs_epi32(lo, hi));
+	}
+#endif
+	for (; pos<len_in_floats; pos++) {
 		const float val = m_masterVol * tmpbuf[pos];
-		(reinterpret_cast<Sint16*>(dsp_buf))[pos] = Sint16(Clamp(val, -32768.0f, 32767.0f));
+		out[pos] = Sint16(Clamp(val, -32768.0f, 32767.0f));
 	}
 }
 
@@ -482,19 +862,10 @@ static void load_sound(const std::string &basename, const std::string &path, boo
 	const float seconds = num_samples/float(info->rate);
 	//Output("%f seconds\n", seconds);
 
-	// immediately decode and store as raw sample if short enough
-	if (seconds < STREAM_IF_LONGER_THAN) {
-		sample.buf = new Uint16[sample.buf_len];
-
-		int i=0;
-		for (;;) {
-			int music_section;
-			int amt = ov_read(&oggv, reinterpret_cast<char*>(sample.buf) + i,
-					2*sample.buf_len - i, 0, 2, 1, &music_section);
-			i += amt;
-			if (amt == 0) break;
-		}
-	}
+	// short enough to keep as raw samples, once something plays it
+	sample.decodable = (seconds < STREAM_IF_LONGER_THAN);
+	sample.decoding = false;
+	sample.lastUsed = 0;
 
 	if (is_music) {
 		sample.isMusic = true;
@@ -534,7 +905,17 @@ bool Init ()
 			return false;
 		}
 
-		// load all the wretched effects
+		s_streams = new Stream[MAX_WAVSTREAMS];
+		s_streamLock = SDL_CreateMutex();
+		s_streamCond = SDL_CreateCond();
+		s_streamQuit = false;
+		s_streamThread = SDL_CreateThread(&stream_thread, "SoundStream", 0);
+
+		s_decodedBudget = size_t(std::max(0, Pi::config->Int("SoundSampleCacheMB"))) * 1024 * 1024;
+		if (Pi::GetAsyncJobQueue())
+			s_decodeJobs.reset(new JobSet(Pi::GetAsyncJobQueue()));
+
+		// find all the wretched effects. they're only decoded when used
 		for (FileSystem::FileEnumerator files(FileSystem::gameDataFiles, "sounds", FileSystem::FileEnumerator::Recurse); !files.Finished(); files.Next()) {
 			const FileSystem::FileInfo &info = files.Current();
 			assert(info.IsFile());
@@ -558,9 +939,23 @@ bool Init ()
 void Uninit ()
 {
 	DestroyAllEvents();
-	std::map<std::string, Sample>::iterator i;
+	s_decodeJobs.reset();
+	SampleMap::iterator i;
 	for (i=sfx_samples.begin(); i!=sfx_samples.end(); ++i) delete[] (*i).second.buf;
 	SDL_CloseAudio ();
+
+	if (s_streamThread) {
+		SDL_LockMutex(s_streamLock);
+		s_streamQuit = true;
+		SDL_CondSignal(s_streamCond);
+		SDL_UnlockMutex(s_streamLock);
+		SDL_WaitThread(s_streamThread, 0);
+		s_streamThread = 0;
+		SDL_DestroyCond(s_streamCond);
+		SDL_DestroyMutex(s_streamLock);
+		delete[] s_streams;
+		s_streams = 0;
+	}
 }
 
 void Pause (int on)
@@ -568,7 +963,7 @@ void Pause (int on)
 	SDL_PauseAudio (on);
 }
 
-void Event::Play(const char *fx, float volume_left, float volume_right, Op op)
+void Event::Play(const StringName &fx, float volume_left, float volume_right, Op op)
 {
 	Stop();
 	eid = PlaySfx(fx, volume_left, volume_right, op);
@@ -640,7 +1035,7 @@ bool Event::SetVolume(const float vol_left, const float vol_right)
 	return status;
 }
 
-const std::map<std::string, Sample> & GetSamples()
+const SampleMap & GetSamples()
 {
 	return sfx_samples;
 }
@@ -5,8 +5,9 @@
 #ifndef __OGGMIX_H
 #define __OGGMIX_H
 
+#include "StringName.h"
 #include <string>
-#include <map>
+#include <unordered_map>
 
 class Body;
 
@@ -26,14 +27,21 @@ struct Sample {
 	/* if buf is null, this will be path to an ogg we must stream */
 	std::string path;
 	bool isMusic;
+
+	/* short samples are decoded into buf on the job runners when first
+	 * wanted, and streamed until that's done. buf may be freed again to
+	 * stay within the decoded sample budget */
+	bool decodable;
+	bool decoding;
+	Uint64 lastUsed;
 };
 
 class Event {
 public:
 	Event(): eid(0) {}
 	Event(Uint32 id): eid(id) {}
-	virtual void Play(const char *fx, const float volume_left, const float volume_right, Op op);
-	void Play(const char *fx) { Play(fx, 1.0f, 1.0f, 0); }
+	virtual void Play(const StringName &fx, const float volume_left, const float volume_right, Op op);
+	void Play(const StringName &fx) { Play(fx, 1.0f, 1.0f, 0); }
 	bool Stop();
 	bool IsPlaying() const;
 	Uint32 EventId() { return eid; }
@@ -59,15 +67,23 @@ void Uninit ();
  */
 void DestroyAllEvents();
 void Pause (int on);
-eventid PlaySfx (const char *fx, const float volume_left, const float volume_right, const Op op);
-eventid PlayMusic (const char *fx, const float volume_left, const float volume_right, const Op op);
-inline static eventid PlaySfx (const char *fx) { return PlaySfx(fx, 1.0f, 1.0f, 0); }
-eventid BodyMakeNoise(const Body *b, const char *fx, float vol);
+/**
+ * Returns 0 if every voice is busy with something that matters more.
+ */
+eventid PlaySfx (const StringName &fx, const float volume_left, const float volume_right, const Op op);
+eventid PlayMusic (const StringName &fx, const float volume_left, const float volume_right, const Op op);
+inline static eventid PlaySfx (const StringName &fx) { return PlaySfx(fx, 1.0f, 1.0f, 0); }
+eventid BodyMakeNoise(const Body *b, const StringName &fx, float vol);
+/**
+ * Start decoding a sample that is likely to be played soon.
+ */
+void Prefetch(const StringName &fx);
 void SetMasterVolume(const float vol);
 float GetMasterVolume();
 void SetSfxVolume(const float vol);
 float GetSfxVolume();
-const std::map<std::string, Sample> & GetSamples();
+typedef std::unordered_map<StringName, Sample> SampleMap;
+const SampleMap & GetSamples();
 
 } /* namespace Sound */
 
@@ -5,6 +5,7 @@
 #include "libs.h" //for clamp
 #include "Pi.h"
 #include "LuaEvent.h"
+#include <algorithm>
 #include <map>
 
 namespace Sound {
@@ -15,7 +16,7 @@ MusicEvent::MusicEvent(Uint32 id) : Event(id) { }
 
 MusicEvent::~MusicEvent() { }
 
-void MusicEvent::Play(const char *fx, const float volume_left, const float volume_right, Op op)
+void MusicEvent::Play(const StringName &fx, const float volume_left, const float volume_right, Op op)
 {
 	Stop();
 	eid = PlayMusic(fx, volume_left, volume_right, op);
@@ -113,12 +114,14 @@ const std::vector<std::string> MusicPlayer::GetSongList() const
 	using std::string;
 	using std::pair;
 	std::vector<string> songs;
-	const std::map<string, Sample> samples = Sound::GetSamples();
-	for (std::map<string, Sample>::const_iterator it = samples.begin();
+	const SampleMap &samples = Sound::GetSamples();
+	for (SampleMap::const_iterator it = samples.begin();
 		it != samples.end(); ++it) {
 			if (it->second.isMusic)
-				songs.push_back(it->first.c_str());
+				songs.push_back(it->first.GetString());
 	}
+	// the samples aren't kept in any order
+	std::sort(songs.begin(), songs.end());
 
 	return songs;
 }
@@ -26,17 +26,121 @@
 #include "Game.h"
 #include "MathUtil.h"
 #include "LuaEvent.h"
+#include "BodyIntegrator.h"
+#include "ProjectileSystem.h"
+#include "NavCache.h"
 
 //#define DEBUG_CACHE
 
+// bodies handed to each job runner at a time in the parallel update
+static const Uint32 PARALLEL_UPDATE_BATCH = 16;
+
+// edge length of a cell in the body finder's grid. most queries (scanner,
+// sensors, alerts) are around 100km, so they only have to look at a handful
+static const double BODY_FINDER_CELL_SIZE = 100000.0;
+// queries are clamped to this radius, and cell coordinates to this many cells
+// from the origin, so huge or infinite values can't overflow the cell keys.
+// both are far bigger than any system
+static const double BODY_FINDER_MAX_DIST = 1.0e16;
+static const double BODY_FINDER_MAX_CELL = 1.0e12;
+
+// simulation LOD. bodies nearer the player than this always get every tick
+static const double SIM_LOD_NEAR_DIST = 100.0e3;
+// and nearer than this every other one
+static const double SIM_LOD_MID_DIST = 1000.0e3;
+// the most time a body may be stepped by at once (s), so the bigger steps
+// stay small enough for the AI and the integration
+static const float SIM_LOD_MAX_STEP = 0.5f;
+
+Uint32 Space::s_removalSerial = 0;
+
+Space::BodyNearFinder::CellKey Space::BodyNearFinder::GetCell(const vector3d &pos)
+{
+	const CellKey cell = {
+		Sint64(Clamp(floor(pos.x / BODY_FINDER_CELL_SIZE), -BODY_FINDER_MAX_CELL, BODY_FINDER_MAX_CELL)),
+		Sint64(Clamp(floor(pos.y / BODY_FINDER_CELL_SIZE), -BODY_FINDER_MAX_CELL, BODY_FINDER_MAX_CELL)),
+		Sint64(Clamp(floor(pos.z / BODY_FINDER_CELL_SIZE), -BODY_FINDER_MAX_CELL, BODY_FINDER_MAX_CELL))
+	};
+	return cell;
+}
+
+void Space::BodyNearFinder::RemoveFromCell(const CellKey &cell, Uint32 index)
+{
+	CellMap::iterator it = m_cells.find(cell);
+	assert(it != m_cells.end() && index < it->second.size());
+	std::vector<BodyPos> &bodies = it->second;
+	if (index + 1 != bodies.size()) {
+		bodies[index] = bodies.back();
+		m_entries[bodies[index].body].index = index;
+	}
+	bodies.pop_back();
+	if (bodies.empty())
+		m_cells.erase(it);
+}
+
 void Space::BodyNearFinder::Prepare()
 {
-	m_bodyDist.clear();
+	PROFILE_SCOPED()
+	++m_stamp;
+
+	for (Body* b : m_space->GetBodies()) {
+		const vector3d pos = b->GetPositionRelTo(m_space->GetRootFrame());
+		const CellKey cell = GetCell(pos);
+
+		auto it = m_entries.find(b);
+		if (it != m_entries.end()) {
+			Entry &entry = it->second;
+			entry.stamp = m_stamp;
+			if (entry.cell == cell) {
+				m_cells[cell][entry.index].pos = pos;
+				continue;
+			}
+			RemoveFromCell(entry.cell, entry.index);
+		}
+
+		std::vector<BodyPos> &bodies = m_cells[cell];
+		const BodyPos bp = { b, pos };
+		bodies.push_back(bp);
+		const Entry entry = { cell, Uint32(bodies.size() - 1), m_stamp };
+		m_entries[b] = entry;
+	}
+
+	// drop anything that's left the space
+	for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+		if (it->second.stamp != m_stamp) {
+			const Entry entry = it->second;
+			it = m_entries.erase(it);
+			RemoveFromCell(entry.cell, entry.index);
+		} else
+			++it;
+	}
+}
 
-	for (Body* b : m_space->GetBodies())
-		m_bodyDist.push_back(BodyDist(b, b->GetPositionRelTo(m_space->GetRootFrame()).Length()));
+template <typename Accept>
+void Space::BodyNearFinder::Query(const vector3d &min, const vector3d &max, Accept accept, BodyNearList &bodies) const
+{
+	const CellKey cmin = GetCell(min);
+	const CellKey cmax = GetCell(max);
+
+	// a big enough query touches more cells than there are full ones, so
+	// just look at all of those instead
+	const double numCells = double(cmax.x - cmin.x + 1) * double(cmax.y - cmin.y + 1) * double(cmax.z - cmin.z + 1);
+	if (numCells >= double(m_cells.size())) {
+		for (const auto &cell : m_cells)
+			for (const BodyPos &bp : cell.second)
+				if (accept(bp.pos)) bodies.push_back(bp.body);
+		return;
+	}
 
-	std::sort(m_bodyDist.begin(), m_bodyDist.end());
+	CellKey key;
+	for (key.x = cmin.x; key.x <= cmax.x; key.x++)
+		for (key.y = cmin.y; key.y <= cmax.y; key.y++)
+			for (key.z = cmin.z; key.z <= cmax.z; key.z++) {
+				CellMap::const_iterator it = m_cells.find(key);
+				if (it == m_cells.end()) continue;
+				for (const BodyPos &bp : it->second)
+					if (accept(bp.pos)) bodies.push_back(bp.body);
+			}
 }
 
 void Space::BodyNearFinder::GetBodiesMaybeNear(const Body *b, double dist, BodyNearList &bodies) const
@@ -46,17 +150,14 @@ void Space::BodyNearFinder::GetBodiesMaybeNear(const Body *b, double dist, BodyN
 
 void Space::BodyNearFinder::GetBodiesMaybeNear(const vector3d &pos, double dist, BodyNearList &bodies) const
 {
-	if (m_bodyDist.empty()) return;
-
-	const double len = pos.Length();
-
-	std::vector<BodyDist>::const_iterator min = std::lower_bound(m_bodyDist.begin(), m_bodyDist.end(), len-dist);
-	std::vector<BodyDist>::const_iterator max = std::upper_bound(min, m_bodyDist.end(), len+dist);
+	PROFILE_SCOPED()
+	// also rejects nan
+	if (m_cells.empty() || !(dist >= 0.0)) return;
 
-	while (min != max) {
-		bodies.push_back((*min).body);
-		++min;
-	}
+	const double d = std::min(dist, BODY_FINDER_MAX_DIST);
+	const double distSqr = d*d;
+	Query(pos - vector3d(d), pos + vector3d(d),
+		[&pos, distSqr](const vector3d &p) { return (p - pos).LengthSqr() <= distSqr; }, bodies);
 }
 
 Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, Space* oldSpace)
@@ -66,6 +167,10 @@ Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, Space* oldSpace)
 	, m_bodyIndexValid(false)
 	, m_sbodyIndexValid(false)
 	, m_bodyNearFinder(this)
+	, m_projectiles(new ProjectileSystem)
+	, m_navCache(new NavCache)
+	, m_integrating(false)
+	, m_simTick(0)
 #ifndef NDEBUG
 	, m_processingFinalizationQueue(false)
 #endif
@@ -85,6 +190,10 @@ Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, const SystemPath &path, S
 	, m_bodyIndexValid(false)
 	, m_sbodyIndexValid(false)
 	, m_bodyNearFinder(this)
+	, m_projectiles(new ProjectileSystem)
+	, m_navCache(new NavCache)
+	, m_integrating(false)
+	, m_simTick(0)
 #ifndef NDEBUG
 	, m_processingFinalizationQueue(false)
 #endif
@@ -109,19 +218,23 @@ Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, const SystemPath &path, S
 	//DebugDumpFrames();
 }
 
-Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, const Json::Value &jsonObj, double at_time)
+Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, Json::Value &jsonObj, double at_time)
 	: m_starSystemCache(galaxy->NewStarSystemSlaveCache())
 	, m_game(game)
 	, m_frameIndexValid(false)
 	, m_bodyIndexValid(false)
 	, m_sbodyIndexValid(false)
 	, m_bodyNearFinder(this)
+	, m_projectiles(new ProjectileSystem)
+	, m_navCache(new NavCache)
+	, m_integrating(false)
+	, m_simTick(0)
 #ifndef NDEBUG
 	, m_processingFinalizationQueue(false)
 #endif
 {
 	if (!jsonObj.isMember("space")) throw SavedGameCorruptException();
-	Json::Value spaceObj = jsonObj["space"];
+	Json::Value &spaceObj = jsonObj["space"];
 
 	m_starSystem = StarSystem::FromJson(galaxy, spaceObj);
 
@@ -136,14 +249,22 @@ Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, const Json::Value &jsonOb
 
 	m_rootFrame.reset(Frame::FromJson(spaceObj, this, 0, at_time));
 	RebuildFrameIndex();
+	spaceObj.removeMember("frame");
 
+	// each body's part of the tree goes as soon as the body is built, so a
+	// big save doesn't hold the whole tree and all the bodies at once
 	if (!spaceObj.isMember("bodies")) throw SavedGameCorruptException();
-	Json::Value bodyArray = spaceObj["bodies"];
+	Json::Value &bodyArray = spaceObj["bodies"];
 	if (!bodyArray.isArray()) throw SavedGameCorruptException();
-	for (Uint32 i = 0; i < bodyArray.size(); i++)
-		m_bodies.push_back(Body::FromJson(bodyArray[i], this));
+	for (Uint32 i = 0; i < bodyArray.size(); i++) {
+		AddBody(Body::FromJson(bodyArray[i], this));
+		bodyArray[i] = Json::Value();
+	}
 	RebuildBodyIndex();
 
+	m_projectiles->FromJson(spaceObj, this);
+	spaceObj.removeMember("projectiles");
+
 	Frame::PostUnserializeFixup(m_rootFrame.get(), this);
 	for (Body* b : m_bodies)
 		b->PostLoadFixup(this);
@@ -180,6 +301,8 @@ void Space::ToJson(Json::Value &jsonObj)
 	}
 	spaceObj["bodies"] = bodyArray; // Add body array to space object.
 
+	m_projectiles->ToJson(spaceObj, this);
+
 	jsonObj["space"] = spaceObj; // Add space object to supplied object.
 }
 
@@ -207,33 +330,34 @@ SystemBody *Space::GetSystemBodyByIndex(Uint32 idx) const
 Uint32 Space::GetIndexForFrame(const Frame *frame) const
 {
 	assert(m_frameIndexValid);
-	for (Uint32 i = 0; i < m_frameIndex.size(); i++)
-		if (m_frameIndex[i] == frame) return i;
-	assert(0);
-	return Uint32(-1);
+	if (!frame) return 0;
+	auto it = m_frameIndexOf.find(frame);
+	assert(it != m_frameIndexOf.end());
+	return it != m_frameIndexOf.end() ? it->second : Uint32(-1);
 }
 
 Uint32 Space::GetIndexForBody(const Body *body) const
 {
 	assert(m_bodyIndexValid);
-	for (Uint32 i = 0; i < m_bodyIndex.size(); i++)
-		if (m_bodyIndex[i] == body) return i;
-	assert(0);
-	return Uint32(-1);
+	if (!body) return 0;
+	auto it = m_bodyIndexOf.find(body);
+	assert(it != m_bodyIndexOf.end());
+	return it != m_bodyIndexOf.end() ? it->second : Uint32(-1);
 }
 
 Uint32 Space::GetIndexForSystemBody(const SystemBody *sbody) const
 {
 	assert(m_sbodyIndexValid);
-	for (Uint32 i = 0; i < m_sbodyIndex.size(); i++)
-		if (m_sbodyIndex[i] == sbody) return i;
-	assert(0);
-	return Uint32(-1);
+	if (!sbody) return 0;
+	auto it = m_sbodyIndexOf.find(sbody);
+	assert(it != m_sbodyIndexOf.end());
+	return it != m_sbodyIndexOf.end() ? it->second : Uint32(-1);
 }
 
 void Space::AddFrameToIndex(Frame *frame)
 {
 	assert(frame);
+	m_frameIndexOf[frame] = Uint32(m_frameIndex.size());
 	m_frameIndex.push_back(frame);
 	for (Frame* kid : frame->GetChildren())
 		AddFrameToIndex(kid);
@@ -242,6 +366,7 @@ void Space::AddFrameToIndex(Frame *frame)
 void Space::AddSystemBodyToIndex(SystemBody *sbody)
 {
 	assert(sbody);
+	m_sbodyIndexOf[sbody] = Uint32(m_sbodyIndex.size());
 	m_sbodyIndex.push_back(sbody);
 	for (Uint32 i = 0; i < sbody->GetNumChildren(); i++)
 		AddSystemBodyToIndex(sbody->GetChildren()[i]);
@@ -250,6 +375,7 @@ void Space::AddSystemBodyToIndex(SystemBody *sbody)
 void Space::RebuildFrameIndex()
 {
 	m_frameIndex.clear();
+	m_frameIndexOf.clear();
 	m_frameIndex.push_back(0);
 
 	if (m_rootFrame)
@@ -261,16 +387,22 @@ void Space::RebuildFrameIndex()
 void Space::RebuildBodyIndex()
 {
 	m_bodyIndex.clear();
+	m_bodyIndexOf.clear();
+	m_bodyIndexOf.reserve(m_bodies.size());
 	m_bodyIndex.push_back(0);
 
 	for (Body* b : m_bodies) {
+		m_bodyIndexOf[b] = Uint32(m_bodyIndex.size());
 		m_bodyIndex.push_back(b);
 		// also index ships inside clouds
 		// XXX we should not have to know about this. move indexing grunt work
 		// down into the bodies?
 		if (b->IsType(Object::HYPERSPACECLOUD)) {
 			Ship *s = static_cast<HyperspaceCloud*>(b)->GetShip();
-			if (s) m_bodyIndex.push_back(s);
+			if (s) {
+				m_bodyIndexOf[s] = Uint32(m_bodyIndex.size());
+				m_bodyIndex.push_back(s);
+			}
 		}
 	}
 
@@ -280,6 +412,7 @@ void Space::RebuildBodyIndex()
 void Space::RebuildSystemBodyIndex()
 {
 	m_sbodyIndex.clear();
+	m_sbodyIndexOf.clear();
 	m_sbodyIndex.push_back(0);
 
 	if (m_starSystem)
@@ -291,6 +424,17 @@ void Space::RebuildSystemBodyIndex()
 void Space::AddBody(Body *b)
 {
 	m_bodies.push_back(b);
+	m_bodyIters[b] = std::prev(m_bodies.end());
+	m_navCache->AddBody(b);
+}
+
+void Space::EraseBody(Body *b)
+{
+	auto i = m_bodyIters.find(b);
+	if (i == m_bodyIters.end()) return;
+	m_bodies.erase(i->second);
+	m_bodyIters.erase(i);
+	m_navCache->RemoveBody(b);
 }
 
 void Space::RemoveBody(Body *b)
@@ -365,19 +509,7 @@ vector3d Space::GetHyperspaceExitPoint(const SystemPath &source, const SystemPat
 
 Body *Space::FindNearestTo(const Body *b, Object::Type t) const
 {
-	Body *nearest = 0;
-	double dist = FLT_MAX;
-	for (std::list<Body*>::const_iterator i = m_bodies.begin(); i != m_bodies.end(); ++i) {
-		if ((*i)->IsDead()) continue;
-		if ((*i)->IsType(t)) {
-			double d = (*i)->GetPositionRelTo(b).Length();
-			if (d < dist) {
-				dist = d;
-				nearest = *i;
-			}
-		}
-	}
-	return nearest;
+	return m_navCache->FindNearestTo(b, t);
 }
 
 Body *Space::FindBodyForPath(const SystemPath *path) const
@@ -667,7 +799,8 @@ void Space::GenSectorCache(RefCountedPtr<Galaxy> galaxy, const SystemPath* here)
 	std::sort(paths.begin(), paths.end(), SDS);
 	m_sectorCache = galaxy->NewSectorSlaveCache();
 	const SystemPath& center(*here);
-	m_sectorCache->FillCache(paths, [this,center]() { UpdateStarSystemCache(&center); });
+	// nothing is waiting on these, they're only here to make the next jump quicker
+	m_sectorCache->FillCache(paths, [this,center]() { UpdateStarSystemCache(&center); }, Job::PRIORITY_LOW);
 }
 
 static bool WithinBox(const SystemPath &here, const int Xmin, const int Xmax, const int Ymin, const int Ymax, const int Zmin, const int Zmax) {
@@ -737,7 +870,47 @@ void Space::UpdateStarSystemCache(const SystemPath* here)
 			}
 		}
 	}
-	m_starSystemCache->FillCache(paths);
+	m_starSystemCache->FillCache(paths, StarSystemCache::CacheFilledCallback(), Job::PRIORITY_LOW);
+}
+
+// systems further along than this are likely to be replanned before they're reached
+static const size_t routePrefetchJumps = 4;
+
+void Space::PrefetchRoute(const std::vector<SystemPath> &route)
+{
+	PROFILE_SCOPED()
+	if (!m_starSystem.Valid())
+		return;
+	const SystemPath &here = m_starSystem->GetPath();
+
+	SectorCache::PathVector systems;
+	for (const SystemPath &path : route) {
+		if (path.IsSameSystem(here))
+			continue;
+		systems.push_back(path.SystemOnly());
+		if (systems.size() >= routePrefetchJumps)
+			break;
+	}
+	if (systems.empty()) {
+		m_sectorCache->CancelPrefetch();
+		m_starSystemCache->CancelPrefetch();
+		return;
+	}
+
+	// the sectors the next Space will want around its system
+	const SystemPath &next = systems.front();
+	SectorCache::PathVector sectors;
+	for (int x = next.sectorX-sectorRadius; x <= next.sectorX+sectorRadius; x++) {
+		for (int y = next.sectorY-sectorRadius; y <= next.sectorY+sectorRadius; y++) {
+			for (int z = next.sectorZ-sectorRadius; z <= next.sectorZ+sectorRadius; z++) {
+				sectors.push_back(SystemPath(x, y, z));
+			}
+		}
+	}
+	SectorDistanceSort SDS(&next);
+	std::sort(sectors.begin(), sectors.end(), SDS);
+	m_sectorCache->Prefetch(sectors);
+	m_starSystemCache->Prefetch(systems);
 }
 
 void Space::GenBody(double at_time, SystemBody *sbody, Frame *f)
@@ -871,31 +1044,54 @@ static void hitCallback(CollisionContact *c)
 }
 
 // temporary one-point version
-static void CollideWithTerrain(Body *body)
+// fills in c and returns true if body has hit the terrain below it. safe to
+// call from any thread
+static bool GetTerrainContact(Body *body, CollisionContact &c)
 {
-	if (!body->IsType(Object::DYNAMICBODY)) return;
+	if (!body->IsType(Object::DYNAMICBODY)) return false;
 	DynamicBody *dynBody = static_cast<DynamicBody*>(body);
-	if (!dynBody->IsMoving()) return;
+	if (!dynBody->IsMoving()) return false;
 
 	Frame *f = body->GetFrame();
-	if (!f || !f->GetBody() || f != f->GetBody()->GetFrame()) return;
-	if (!f->GetBody()->IsType(Object::TERRAINBODY)) return;
+	if (!f || !f->GetBody() || f != f->GetBody()->GetFrame()) return false;
+	if (!f->GetBody()->IsType(Object::TERRAINBODY)) return false;
 	TerrainBody *terrain = static_cast<TerrainBody*>(f->GetBody());
 
 	const Aabb &aabb = dynBody->GetAabb();
 	double altitude = body->GetPosition().Length() + aabb.min.y;
-	if (altitude >= (terrain->GetMaxFeatureRadius()*2.0)) return;
+	if (altitude >= (terrain->GetMaxFeatureRadius()*2.0)) return false;
 
-	double terrHeight = terrain->GetTerrainHeight(body->GetPosition().Normalized());
-	if (altitude >= terrHeight) return;
+	double terrHeight = dynBody->GetTerrainHeightBelow(terrain, body->GetPosition().Normalized());
+	if (altitude >= terrHeight) return false;
 
-	CollisionContact c;
 	c.pos = body->GetPosition();
 	c.normal = c.pos.Normalized();
 	c.depth = terrHeight - altitude;
 	c.userData1 = static_cast<void*>(body);
 	c.userData2 = static_cast<void*>(f->GetBody());
-	hitCallback(&c);
+	return true;
+}
+
+static void CollideWithTerrain(Body *body)
+{
+	CollisionContact c;
+	if (GetTerrainContact(body, c))
+		hitCallback(&c);
+}
+
+// contacts gathered off-thread can be stale by the time they're handled, if
+// an earlier one stopped a body colliding (eg. it started docking).
+// CollisionSpace would have skipped those, so skip them here too
+static bool IsStillColliding(const Object *o)
+{
+	return !o->IsType(Object::MODELBODY) || static_cast<const ModelBody*>(o)->IsColliding();
+}
+
+static void DeferredHitCallback(CollisionContact *c)
+{
+	if (!IsStillColliding(static_cast<Object*>(c->userData1)) || !IsStillColliding(static_cast<Object*>(c->userData2)))
+		return;
+	hitCallback(c);
 }
 
 void Space::CollideFrame(Frame *f)
@@ -905,35 +1101,195 @@ void Space::CollideFrame(Frame *f)
 		CollideFrame(kid);
 }
 
+static void GatherFrames(Frame *f, std::vector<Frame*> &frames)
+{
+	frames.push_back(f);
+	for (Frame* kid : f->GetChildren())
+		GatherFrames(kid, frames);
+}
+
+void Space::CollideParallel()
+{
+	PROFILE_SCOPED()
+	JobQueue *jobs = Pi::GetAsyncJobQueue();
+
+	// frames don't share geoms, so their spaces can be collided at the same
+	// time. they're gathered depth first so the contacts come out in the same
+	// order as CollideFrame's
+	std::vector<Frame*> frames;
+	GatherFrames(m_rootFrame.get(), frames);
+	std::vector<std::vector<CollisionContact> > frameContacts(frames.size());
+	jobs->ParallelFor(frames.size(), 1, [&frames, &frameContacts](Uint32 begin, Uint32 end) {
+		for (Uint32 i = begin; i < end; i++) {
+			std::vector<CollisionContact> &contacts = frameContacts[i];
+			frames[i]->GetCollisionSpace()->Collide([&contacts](CollisionContact *c) { contacts.push_back(*c); });
+		}
+	});
+	for (std::vector<CollisionContact> &contacts : frameContacts)
+		for (CollisionContact &c : contacts)
+			DeferredHitCallback(&c);
+
+	// the terrain checks read the bodies' positions, which the responses above
+	// don't change, so they can be found up front too
+	std::vector<Body*> bodies(m_bodies.begin(), m_bodies.end());
+	std::vector<CollisionContact> terrainContacts(bodies.size());
+	std::vector<char> hitTerrain(bodies.size(), 0);
+	jobs->ParallelFor(bodies.size(), PARALLEL_UPDATE_BATCH, [&bodies, &terrainContacts, &hitTerrain](Uint32 begin, Uint32 end) {
+		for (Uint32 i = begin; i < end; i++)
+			hitTerrain[i] = GetTerrainContact(bodies[i], terrainContacts[i]);
+	});
+	for (Uint32 i = 0; i < bodies.size(); i++)
+		if (hitTerrain[i])
+			DeferredHitCallback(&terrainContacts[i]);
+}
+
+void Space::UpdateInterpTransforms(double alpha)
+{
+	PROFILE_SCOPED()
+	// each body only touches its own interpolated transform
+	if (Pi::config->Int("ParallelBodyUpdate")) {
+		std::vector<Body*, ArenaAllocator<Body*>> bodies(m_bodies.begin(), m_bodies.end(), FrameArena::Allocator<Body*>());
+		Pi::GetAsyncJobQueue()->ParallelFor(bodies.size(), PARALLEL_UPDATE_BATCH, [&bodies, alpha](Uint32 begin, Uint32 end) {
+			for (Uint32 i = begin; i < end; i++)
+				bodies[i]->UpdateInterpTransform(alpha);
+		});
+	} else {
+		for (Body* b : m_bodies)
+			b->UpdateInterpTransform(alpha);
+	}
+	m_rootFrame->UpdateInterpTransform(alpha);
+}
+
 void Space::TimeStep(float step)
 {
 	PROFILE_SCOPED()
-	m_frameIndexValid = m_bodyIndexValid = m_sbodyIndexValid = false;
+	// the system bodies don't change, the frames and bodies might
+	m_frameIndexValid = m_bodyIndexValid = false;
+
+	// cheap enough to always keep
+	static const double counterPeriod = 1.0 / double(SDL_GetPerformanceFrequency());
+	Uint64 lapStart = SDL_GetPerformanceCounter();
+	auto lap = [&lapStart](double &total) {
+		const Uint64 now = SDL_GetPerformanceCounter();
+		total += double(now - lapStart) * counterPeriod;
+		lapStart = now;
+	};
+
+	m_navCache->Update(m_rootFrame.get(), m_game->GetTime());
 
 	// XXX does not need to be done this often
-	CollideFrame(m_rootFrame.get());
-	for (Body* b : m_bodies)
-		CollideWithTerrain(b);
+	if (Pi::config->Int("ParallelCollisions"))
+		CollideParallel();
+	else {
+		CollideFrame(m_rootFrame.get());
+		for (Body* b : m_bodies)
+			CollideWithTerrain(b);
+	}
+	lap(m_stepTimes.collisions);
 
 	// update frames of reference
 	for (Body* b : m_bodies)
 		b->UpdateFrame();
 
+	// with SimulationLOD some bodies sit this tick out, and the rest get
+	// the time since they were last updated
+	const bool lod = Pi::config->Int("SimulationLOD") != 0;
+	if (lod)
+		PickSteppingBodies(step);
+	else if (!m_simPending.empty())
+		m_simPending.clear();
+	auto forStepping = [&](const std::function<void(Body*,float)> &fn) {
+		if (lod) {
+			for (const std::pair<Body*,float> &b : m_steppingBodies)
+				fn(b.first, b.second);
+		} else {
+			for (Body* b : m_bodies)
+				fn(b, step);
+		}
+	};
+
+	// optionally let the bodies do their self-contained work (mostly AI
+	// steering) across the job runners first. StaticUpdate then applies
+	// anything that reaches beyond the body itself
+	if (Pi::config->Int("ParallelBodyUpdate")) {
+		typedef std::pair<Body*,float> StepItem;
+		std::vector<StepItem, ArenaAllocator<StepItem>> bodies(FrameArena::Allocator<StepItem>());
+		forStepping([&bodies](Body *b, float bodyStep) { bodies.push_back(std::make_pair(b, bodyStep)); });
+		Pi::GetAsyncJobQueue()->ParallelFor(bodies.size(), PARALLEL_UPDATE_BATCH, [&bodies](Uint32 begin, Uint32 end) {
+			for (Uint32 i = begin; i < end; i++)
+				bodies[i].first->ParallelUpdate(bodies[i].second);
+		});
+	}
+
 	// AI acts here, then move all bodies and frames
-	for (Body* b : m_bodies)
-		b->StaticUpdate(step);
+	forStepping([](Body *b, float bodyStep) { b->StaticUpdate(bodyStep); });
+	lap(m_stepTimes.bodies);
+	m_projectiles->TimeStep(step);
+	lap(m_stepTimes.projectiles);
 
 	m_rootFrame->UpdateOrbitRails(m_game->GetTime(), m_game->GetTimeStep());
 
-	for (Body* b : m_bodies)
-		b->TimeStepUpdate(step);
+	// with BatchIntegration the dynamic bodies only gather their forces
+	// here, and are integrated all together afterwards
+	const bool batch = Pi::config->Int("BatchIntegration") != 0;
+	if (batch) {
+		if (!m_integrator)
+			m_integrator.reset(new BodyIntegrator);
+		m_integrator->Begin();
+		m_integrating = true;
+	}
+
+	forStepping([](Body *b, float bodyStep) { b->TimeStepUpdate(bodyStep); });
+
+	if (batch) {
+		m_integrating = false;
+		m_integrator->Integrate(Pi::GetAsyncJobQueue());
+		m_integrator->Finish();
+	}
+
+	lap(m_stepTimes.movement);
 
 	LuaEvent::Emit();
+	lap(m_stepTimes.luaEvents);
 	Pi::luaTimer->Tick();
+	lap(m_stepTimes.luaTimers);
 
 	UpdateBodies();
 
 	m_bodyNearFinder.Prepare();
+	lap(m_stepTimes.cleanup);
+	m_stepTimes.steps++;
+}
+
+// the bodies that step this tick, and by how much. a body allowed to run
+// slower is updated every so many ticks depending on how far it is from
+// the player, staggered so they don't all land on the same tick
+void Space::PickSteppingBodies(float step)
+{
+	PROFILE_SCOPED()
+
+	m_steppingBodies.clear();
+	++m_simTick;
+
+	const Body *player = m_game->GetPlayer();
+	for (Body *b : m_bodies) {
+		float &pending = m_simPending[b];
+		pending += step;
+
+		Uint32 interval = step > 0.0f ? std::min(b->GetMaxSimulationInterval(), Uint32(SIM_LOD_MAX_STEP / step)) : 1;
+		if (interval > 1 && player && player->GetFrame() && b->GetFrame()) {
+			const double dist = b->GetPositionRelTo(player).Length();
+			if (dist < SIM_LOD_NEAR_DIST)
+				interval = 1;
+			else if (dist < SIM_LOD_MID_DIST)
+				interval = std::min(interval, 2U);
+		}
+
+		if (interval <= 1 || (m_simTick + (uintptr_t(b) >> 4)) % interval == 0) {
+			m_steppingBodies.push_back(std::make_pair(b, pending));
+			pending = 0.0f;
+		}
+	}
 }
 
 void Space::UpdateBodies()
@@ -942,18 +1298,25 @@ void Space::UpdateBodies()
 	m_processingFinalizationQueue = true;
 #endif
 
+	if (!m_removeBodies.empty() || !m_killBodies.empty())
+		++s_removalSerial;
+
+	// only the bodies that registered a pointer to the removed one (see
+	// Body::AddWatcher) are told about it
 	for (Body* rmb : m_removeBodies) {
+		m_simPending.erase(rmb);
 		rmb->SetFrame(0);
-		for (Body* b : m_bodies)
-			b->NotifyRemoved(rmb);
-		m_bodies.remove(rmb);
+		rmb->NotifyWatchers();
+		m_projectiles->NotifyRemoved(rmb);
+		EraseBody(rmb);
 	}
 	m_removeBodies.clear();
 
 	for (Body* killb : m_killBodies) {
-		for (Body* b : m_bodies)
-			b->NotifyRemoved(killb);
-		m_bodies.remove(killb);
+		m_simPending.erase(killb);
+		killb->NotifyWatchers();
+		m_projectiles->NotifyRemoved(killb);
+		EraseBody(killb);
 		delete killb;
 	}
 	m_killBodies.clear();
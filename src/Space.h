@@ -5,6 +5,8 @@
 #define _SPACE_H
 
 #include <list>
+#include "FlatHashMap.h"
+#include "LinearArena.h"
 #include "Object.h"
 #include "vector3.h"
 #include "Serializer.h"
@@ -19,6 +21,9 @@ class Frame;
 class Ship;
 class HyperspaceCloud;
 class Game;
+class BodyIntegrator;
+class ProjectileSystem;
+class NavCache;
 
 class Space {
 public:
@@ -28,8 +33,8 @@ public:
 	// initalise with system bodies
 	Space(Game *game, RefCountedPtr<Galaxy> galaxy, const SystemPath &path, Space* oldSpace = nullptr);
 
-	// initialise from save file
-	Space(Game *game, RefCountedPtr<Galaxy> galaxy, const Json::Value &jsonObj, double at_time);
+	// initialise from save file. the space section is released as it's read
+	Space(Game *game, RefCountedPtr<Galaxy> galaxy, Json::Value &jsonObj, double at_time);
 
 	virtual ~Space();
 
@@ -47,6 +52,10 @@ public:
 
 	RefCountedPtr<StarSystem> GetStarSystem() const { return m_starSystem; }
 
+	// start generating the sectors and systems a planned route will need,
+	// at low priority. replaces what the last call asked for
+	void PrefetchRoute(const std::vector<SystemPath> &route);
+
 	Frame *GetRootFrame() const { return m_rootFrame.get(); }
 
 	void AddBody(Body *);
@@ -54,6 +63,14 @@ public:
 	void KillBody(Body *);
 
 	void TimeStep(float step);
+	// where the bodies and frames are drawn this frame, alpha of the way
+	// from the previous tick to the last. only reads what the ticks left
+	// behind, so it can be done apart from them
+	void UpdateInterpTransforms(double alpha);
+	ProjectileSystem *GetProjectiles() const { return m_projectiles.get(); }
+	NavCache *GetNavCache() const { return m_navCache.get(); }
+	// only while TimeStep is moving the bodies, and BatchIntegration is on
+	BodyIntegrator *GetIntegrator() const { return m_integrating ? m_integrator.get() : nullptr; }
 
 	vector3d GetHyperspaceExitPoint(const SystemPath &source, const SystemPath &dest) const;
 	vector3d GetHyperspaceExitPoint(const SystemPath &source) const {
@@ -69,8 +86,9 @@ public:
 
 	Background::Container *GetBackground() { return m_background.get(); }
 
-	// body finder delegates
-	typedef std::vector<Body*> BodyNearList;
+	// body finder delegates. lists are on the heap unless made with an
+	// arena, eg BodyNearList nearby(FrameArena::Allocator<Body*>())
+	typedef std::vector<Body*, ArenaAllocator<Body*>> BodyNearList;
 	typedef BodyNearList::iterator BodyNearIterator;
 	void GetBodiesMaybeNear(const Body *b, double dist, BodyNearList &bodies) const {
 		m_bodyNearFinder.GetBodiesMaybeNear(b, dist, bodies);
@@ -79,6 +97,25 @@ public:
 		m_bodyNearFinder.GetBodiesMaybeNear(pos, dist, bodies);
 	}
 
+	// wall clock seconds spent in each part of TimeStep, summed over the
+	// steps since the last reset. for the simulation benchmark
+	struct StepTimes {
+		StepTimes() : collisions(0.0), bodies(0.0), projectiles(0.0), movement(0.0), luaEvents(0.0), luaTimers(0.0), cleanup(0.0), steps(0) {}
+		double collisions;  // collision spaces and terrain
+		double bodies;      // frame changes and the bodies' own updates (AI etc)
+		double projectiles;
+		double movement;    // orbit rails and integration
+		double luaEvents;
+		double luaTimers;
+		double cleanup;     // removing dead bodies, body grid
+		Uint32 steps;
+	};
+	const StepTimes &GetStepTimes() const { return m_stepTimes; }
+	void ResetStepTimes() { m_stepTimes = StepTimes(); }
+
+	// bumped whenever bodies are removed from any space, so anything holding
+	// raw Body pointers across frames can tell they may have gone
+	static Uint32 GetRemovalSerial() { return s_removalSerial; }
 
 private:
 	void GenSectorCache(RefCountedPtr<Galaxy> galaxy, const SystemPath* here);
@@ -88,8 +125,12 @@ private:
 	Frame *GetFrameWithSystemBody(const SystemBody *b) const;
 
 	void UpdateBodies();
+	void EraseBody(Body *b);
 
 	void CollideFrame(Frame *f);
+	// as CollideFrame on the root plus CollideWithTerrain for every body, but
+	// with the contacts found on the job runners and handled afterwards
+	void CollideParallel();
 
 	std::unique_ptr<Frame> m_rootFrame;
 
@@ -100,12 +141,15 @@ private:
 
 	Game *m_game;
 
-	// all the bodies we know about
+	// all the bodies we know about. a list, since bodies get added while
+	// it's being walked, with each body's place kept for removing it
 	std::list<Body*> m_bodies;
+	FlatHashMap<const Body*, std::list<Body*>::iterator> m_bodyIters;
 
 	// bodies that were removed/killed this timestep and need pruning at the end
 	std::list<Body*> m_removeBodies;
 	std::list<Body*> m_killBodies;
+	static Uint32 s_removalSerial;
 
 	void RebuildFrameIndex();
 	void RebuildBodyIndex();
@@ -118,37 +162,73 @@ private:
 	std::vector<Frame*> m_frameIndex;
 	std::vector<Body*>  m_bodyIndex;
 	std::vector<SystemBody*> m_sbodyIndex;
+	// and back the other way, so saving a reference isn't a search
+	FlatHashMap<const Frame*,Uint32> m_frameIndexOf;
+	FlatHashMap<const Body*,Uint32> m_bodyIndexOf;
+	FlatHashMap<const SystemBody*,Uint32> m_sbodyIndexOf;
 
 	//background (elements that are infinitely far away,
 	//e.g. starfield and milky way)
 	std::unique_ptr<Background::Container> m_background;
 
+	// hashed grid of body positions relative to the root frame. Prepare
+	// only moves bodies that have changed cell since the last call
 	class BodyNearFinder {
 	public:
-		BodyNearFinder(const Space *space) : m_space(space) {}
+		BodyNearFinder(const Space *space) : m_space(space), m_stamp(0) {}
 		void Prepare();
 
 		void GetBodiesMaybeNear(const Body *b, double dist, BodyNearList &bodies) const;
 		void GetBodiesMaybeNear(const vector3d &pos, double dist, BodyNearList &bodies) const;
 
 	private:
-		struct BodyDist {
-			BodyDist(Body *_body, double _dist) : body(_body), dist(_dist) {}
-			Body   *body;
-			double dist;
-
-			bool operator<(const BodyDist &a) const { return dist < a.dist; }
-
-			friend bool operator<(const BodyDist &a, double d) { return a.dist < d; }
-			friend bool operator<(double d, const BodyDist &a) { return d < a.dist; }
+		struct CellKey {
+			Sint64 x, y, z;
+			bool operator==(const CellKey &o) const { return x == o.x && y == o.y && z == o.z; }
+			bool operator!=(const CellKey &o) const { return !(*this == o); }
+		};
+		struct CellKeyHash {
+			size_t operator()(const CellKey &k) const {
+				return size_t(k.x * 73856093) ^ size_t(k.y * 19349663) ^ size_t(k.z * 83492791);
+			}
+		};
+		struct BodyPos {
+			Body *body;
+			vector3d pos;
 		};
+		struct Entry {
+			CellKey cell;
+			Uint32 index; // in its cell
+			Uint32 stamp; // last Prepare that saw it
+		};
+		typedef FlatHashMap<CellKey, std::vector<BodyPos>, CellKeyHash> CellMap;
+
+		static CellKey GetCell(const vector3d &pos);
+		void RemoveFromCell(const CellKey &cell, Uint32 index);
+		template <typename Accept>
+		void Query(const vector3d &min, const vector3d &max, Accept accept, BodyNearList &bodies) const;
 
 		const Space *m_space;
-		std::vector<BodyDist> m_bodyDist;
+		CellMap m_cells;
+		FlatHashMap<const Body*, Entry> m_entries;
+		Uint32 m_stamp;
 	};
 
 	BodyNearFinder m_bodyNearFinder;
 
+	std::unique_ptr<ProjectileSystem> m_projectiles;
+	std::unique_ptr<NavCache> m_navCache;
+
+	std::unique_ptr<BodyIntegrator> m_integrator;
+	bool m_integrating;
+
+	void PickSteppingBodies(float step);
+	Uint32 m_simTick;
+	FlatHashMap<const Body*,float> m_simPending; // time since each body's last step
+	std::vector<std::pair<Body*,float>> m_steppingBodies; // body, step
+
+	StepTimes m_stepTimes;
+
 #ifndef NDEBUG
 	//to check RemoveBody and KillBody are not called from within
 	//the NotifyRemoved callback (#735)
@@ -89,7 +89,7 @@ void SpaceStation::LoadFromJson(const Json::Value &jsonObj, Space *space)
 	ModelBody::LoadFromJson(jsonObj, space);
 
 	if (!jsonObj.isMember("space_station")) throw SavedGameCorruptException();
-	Json::Value spaceStationObj = jsonObj["space_station"];
+	const Json::Value &spaceStationObj = jsonObj["space_station"];
 
 	if (!spaceStationObj.isMember("ship_docking")) throw SavedGameCorruptException();
 	if (!spaceStationObj.isMember("ports")) throw SavedGameCorruptException();
@@ -100,7 +100,7 @@ void SpaceStation::LoadFromJson(const Json::Value &jsonObj, Space *space)
 
 	m_oldAngDisplacement = 0.0;
 
-	Json::Value shipDockingArray = spaceStationObj["ship_docking"];
+	const Json::Value &shipDockingArray = spaceStationObj["ship_docking"];
 	if (!shipDockingArray.isArray()) throw SavedGameCorruptException();
 	m_shipDocking.reserve(shipDockingArray.size());
 	for (Uint32 i = 0; i < shipDockingArray.size(); i++)
@@ -108,7 +108,7 @@ void SpaceStation::LoadFromJson(const Json::Value &jsonObj, Space *space)
 		m_shipDocking.push_back(shipDocking_t());
 		shipDocking_t &sd = m_shipDocking.back();
 
-		Json::Value shipDockingArrayEl = shipDockingArray[i];
+		const Json::Value &shipDockingArrayEl = shipDockingArray[i];
 		if (!shipDockingArrayEl.isMember("index_for_body")) throw SavedGameCorruptException();
 		if (!shipDockingArrayEl.isMember("stage")) throw SavedGameCorruptException();
 		if (!shipDockingArrayEl.isMember("stage_pos")) throw SavedGameCorruptException();
@@ -123,7 +123,7 @@ void SpaceStation::LoadFromJson(const Json::Value &jsonObj, Space *space)
 	}
 
 	// retrieve each of the port details and bay IDs
-	Json::Value portArray = spaceStationObj["ports"];
+	const Json::Value &portArray = spaceStationObj["ports"];
 	if (!portArray.isArray()) throw SavedGameCorruptException();
 	m_ports.reserve(portArray.size());
 	for (Uint32 i = 0; i < portArray.size(); i++)
@@ -131,7 +131,7 @@ void SpaceStation::LoadFromJson(const Json::Value &jsonObj, Space *space)
 		m_ports.push_back(SpaceStationType::SPort());
 		SpaceStationType::SPort &port = m_ports.back();
 
-		Json::Value portArrayEl = portArray[i];
+		const Json::Value &portArrayEl = portArray[i];
 		if (!portArrayEl.isMember("min_ship_size")) throw SavedGameCorruptException();
 		if (!portArrayEl.isMember("max_ship_size")) throw SavedGameCorruptException();
 		if (!portArrayEl.isMember("in_use")) throw SavedGameCorruptException();
@@ -141,12 +141,12 @@ void SpaceStation::LoadFromJson(const Json::Value &jsonObj, Space *space)
 		port.maxShipSize = portArrayEl["max_ship_size"].asInt();
 		port.inUse = portArrayEl["in_use"].asBool();
 
-		Json::Value bayArray = portArrayEl["bays"];
+		const Json::Value &bayArray = portArrayEl["bays"];
 		if (!bayArray.isArray()) throw SavedGameCorruptException();
 		port.bayIDs.reserve(bayArray.size());
 		for (Uint32 j = 0; j < bayArray.size(); j++)
 		{
-			Json::Value bayArrayEl = bayArray[j];
+			const Json::Value &bayArrayEl = bayArray[j];
 			if (!bayArrayEl.isMember("bay_id")) throw SavedGameCorruptException();
 			if (!bayArrayEl.isMember("name")) throw SavedGameCorruptException();
 
@@ -170,6 +170,7 @@ void SpaceStation::PostLoadFixup(Space *space)
 	ModelBody::PostLoadFixup(space);
 	for (Uint32 i=0; i<m_shipDocking.size(); i++) {
 		m_shipDocking[i].ship = static_cast<Ship*>(space->GetBodyByIndex(m_shipDocking[i].shipIndex));
+		if (m_shipDocking[i].ship) m_shipDocking[i].ship->AddWatcher(this);
 	}
 }
 
@@ -295,6 +296,7 @@ void SpaceStation::SetDocked(Ship *ship, const int port)
 	assert(m_shipDocking.size() > Uint32(port));
 	m_shipDocking[port].ship = ship;
 	m_shipDocking[port].stage = m_type->NumDockingStages()+1;
+	ship->AddWatcher(this);
 
 	// have to do this crap again in case it was called directly (Ship::SetDockWith())
 	ship->SetFlightState(Ship::DOCKED);
@@ -327,6 +329,7 @@ bool SpaceStation::LaunchShip(Ship *ship, const int port)
 
 	sd.ship = ship;
 	sd.stage = -1;
+	ship->AddWatcher(this);
 	sd.stagePos = 0.0;
 
 	m_doorAnimationStep = 0.3; // open door
@@ -368,6 +371,7 @@ bool SpaceStation::GetDockingClearance(Ship *s, std::string &outMsg)
 			shipDocking_t &sd = m_shipDocking[i];
 			sd.ship = s;
 			sd.stage = 1;
+			s->AddWatcher(this);
 			sd.stagePos = 0;
 			outMsg = stringf(Lang::CLEARANCE_GRANTED_BAY_N, formatarg("bay", i+1));
 			return true;
@@ -410,6 +414,7 @@ bool SpaceStation::OnCollision(Object *b, Uint32 flags, double relVel)
 			shipDocking_t &sd = m_shipDocking[port];
 			sd.ship = s;
 			sd.stage = 2;
+			s->AddWatcher(this);
 			sd.stagePos = 0;
 			sd.fromPos = (s->GetPosition() - GetPosition()) * GetOrient();	// station space
 			sd.fromRot = Quaterniond::FromMatrix3x3(GetOrient().Transpose() * s->GetOrient());
@@ -542,11 +547,21 @@ void SpaceStation::PositionDockedShip(Ship *ship, int port) const
 	}
 }
 
+// cities are laid out on a job, started from a good way off so it's done
+// well before the city can be seen
+static const double SQRPREPARECITYDIST = 1e6 * 1e6;
+
 void SpaceStation::StaticUpdate(const float timeStep)
 {
 	DoLawAndOrder(timeStep);
 	DockingUpdate(timeStep);
 	m_navLights->Update(timeStep);
+
+	if (!m_adjacentCity && IsGroundStation() && Pi::player && GetPositionRelTo(Pi::player).LengthSqr() < SQRPREPARECITYDIST) {
+		Body *b = GetFrame()->GetBody();
+		if (b && b->IsType(Object::PLANET))
+			m_adjacentCity = new CityOnPlanet(static_cast<Planet*>(b), this, m_sbody->GetSeed());
+	}
 }
 
 void SpaceStation::TimeStepUpdate(const float timeStep)
@@ -9,9 +9,11 @@
 #include "StringF.h"
 #include "scenegraph/Model.h"
 #include "OS.h"
+#include "JobQueue.h"
 #include "json/json.h"
 
 #include <algorithm>
+#include <memory>
 
 std::vector<SpaceStationType> SpaceStationType::surfaceTypes;
 std::vector<SpaceStationType> SpaceStationType::orbitalTypes;
@@ -28,6 +30,7 @@ SpaceStationType::SpaceStationType(const std::string &id_, const std::string &pa
 	, shipLaunchStage(3)
 	, parkingDistance(0)
 	, parkingGapSize(0)
+	, parsed(false)
 {
 	Json::Reader reader;
 	Json::Value data;
@@ -62,9 +65,8 @@ SpaceStationType::SpaceStationType(const std::string &id_, const std::string &pa
 	
 	padOffset = data.get("pad_offset", 150.f).asFloat();
 
-	model = Pi::FindModel(modelName);
-	assert(model);
-	OnSetupComplete();
+	// the model is set up by Init, on the main thread
+	parsed = true;
 }
 
 void SpaceStationType::OnSetupComplete()
@@ -277,54 +279,78 @@ void SpaceStationType::OnSetupComplete()
 		}
 
 	}
+
+	BuildBayPaths();
 }
 
-const SpaceStationType::SPort* SpaceStationType::FindPortByBay(const int zeroBaseBayID) const
+static void BuildWaypoints(const SpaceStationType::TMapBayIDMat &stages, SpaceStationType::TWaypoints &out)
 {
-	for (TPorts::const_iterator bayIter = m_ports.begin(), grpEnd=m_ports.end(); bayIter!=grpEnd ; ++bayIter ) {
-		for (auto idIter : (*bayIter).bayIDs ) {
-			if (idIter.first==zeroBaseBayID) {
-				return &(*bayIter);
-			}
-		}
+	out.clear();
+	if (stages.empty())
+		return;
+	out.resize(stages.rbegin()->first + 1);
+	for (const auto &stage : stages) {
+		const matrix4x4f &mt = stage.second;
+		SpaceStationType::Waypoint &wp = out[stage.first];
+		wp.orient.pos   = vector3d(mt.GetTranslate());
+		wp.orient.xaxis = vector3d(mt.GetOrient().VectorX()).Normalized();
+		wp.orient.yaxis = vector3d(mt.GetOrient().VectorY()).Normalized();
+		wp.orient.zaxis = vector3d(mt.GetOrient().VectorZ()).Normalized();
+		wp.valid = true;
 	}
-	// is it safer to return that the bay is locked?
-	return 0;
 }
 
-SpaceStationType::SPort* SpaceStationType::GetPortByBay(const int zeroBaseBayID)
+static inline const SpaceStationType::Waypoint *GetWaypoint(const SpaceStationType::TWaypoints &waypoints, const int stage)
 {
-	for (TPorts::iterator bayIter = m_ports.begin(), grpEnd=m_ports.end(); bayIter!=grpEnd ; ++bayIter ) {
-		for (auto idIter : (*bayIter).bayIDs ) {
-			if (idIter.first==zeroBaseBayID) {
-				return &(*bayIter);
-			}
+	if (stage < 0 || stage >= int(waypoints.size()) || !waypoints[stage].valid)
+		return 0;
+	return &waypoints[stage];
+}
+
+void SpaceStationType::BuildBayPaths()
+{
+	m_bayPaths.clear();
+	m_bayPaths.resize(m_portPaths.size());
+	for (Uint32 i = 0; i < m_ports.size(); i++) {
+		for (const auto &bay : m_ports[i].bayIDs) {
+			if (bay.first < 0 || bay.first >= int(m_bayPaths.size()))
+				continue;
+			BayPaths &paths = m_bayPaths[bay.first];
+			paths.port = i;
+			BuildWaypoints(m_ports[i].m_approach, paths.approach);
 		}
 	}
+	for (const auto &portPath : m_portPaths) {
+		const int bay = int(portPath.first) - 1;
+		if (bay < 0 || bay >= int(m_bayPaths.size()))
+			continue;
+		BuildWaypoints(portPath.second.m_docking, m_bayPaths[bay].docking);
+		BuildWaypoints(portPath.second.m_leaving, m_bayPaths[bay].leaving);
+	}
+}
+
+const SpaceStationType::SPort* SpaceStationType::FindPortByBay(const int zeroBaseBayID) const
+{
 	// is it safer to return that the bay is locked?
-	return 0;
+	if (zeroBaseBayID < 0 || zeroBaseBayID >= int(m_bayPaths.size()) || m_bayPaths[zeroBaseBayID].port < 0)
+		return 0;
+	return &m_ports[m_bayPaths[zeroBaseBayID].port];
 }
 
-bool SpaceStationType::GetShipApproachWaypoints(const unsigned int port, const int stage, positionOrient_t &outPosOrient) const
+SpaceStationType::SPort* SpaceStationType::GetPortByBay(const int zeroBaseBayID)
 {
-	bool gotOrient = false;
+	return const_cast<SPort*>(static_cast<const SpaceStationType*>(this)->FindPortByBay(zeroBaseBayID));
+}
 
-	const SPort* pPort = FindPortByBay(port);
-	if (pPort && stage>0) {
-		TMapBayIDMat::const_iterator stageDataIt = pPort->m_approach.find(stage);
-		if (stageDataIt != pPort->m_approach.end()) {
-			const matrix4x4f &mt = pPort->m_approach.at(stage);
-			outPosOrient.pos	= vector3d(mt.GetTranslate());
-			outPosOrient.xaxis	= vector3d(mt.GetOrient().VectorX());
-			outPosOrient.yaxis	= vector3d(mt.GetOrient().VectorY());
-			outPosOrient.zaxis	= vector3d(mt.GetOrient().VectorZ());
-			outPosOrient.xaxis	= outPosOrient.xaxis.Normalized();
-			outPosOrient.yaxis	= outPosOrient.yaxis.Normalized();
-			outPosOrient.zaxis	= outPosOrient.zaxis.Normalized();
-			gotOrient = true;
-		}
-	}
-	return gotOrient;
+bool SpaceStationType::GetShipApproachWaypoints(const unsigned int port, const int stage, positionOrient_t &outPosOrient) const
+{
+	if (port >= m_bayPaths.size())
+		return false;
+	const Waypoint *wp = GetWaypoint(m_bayPaths[port].approach, stage);
+	if (!wp || stage <= 0)
+		return false;
+	outPosOrient = wp->orient;
+	return true;
 }
 
 double SpaceStationType::GetDockAnimStageDuration(const int stage) const
@@ -337,32 +363,19 @@ double SpaceStationType::GetUndockAnimStageDuration(const int stage) const
 	return ((SURFACE==dockMethod) ? 0.0 : 5.0);
 }
 
-static bool GetPosOrient(const SpaceStationType::TMapBayIDMat &bayMap, const int stage, const double t, const vector3d &from,
+static bool GetPosOrient(const SpaceStationType::TWaypoints &waypoints, const int stage, const double t, const vector3d &from,
 				  SpaceStationType::positionOrient_t &outPosOrient)
 {
-	bool gotOrient = false;
-
-	vector3d toPos;
-
-	const SpaceStationType::TMapBayIDMat::const_iterator stageDataIt = bayMap.find( stage );
-	const bool bHasStageData = (stageDataIt != bayMap.end());
-	assert(bHasStageData);
-	if (bHasStageData) {
-		const matrix4x4f &mt = stageDataIt->second;
-		outPosOrient.xaxis	= vector3d(mt.GetOrient().VectorX()).Normalized();
-		outPosOrient.yaxis	= vector3d(mt.GetOrient().VectorY()).Normalized();
-		outPosOrient.zaxis	= vector3d(mt.GetOrient().VectorZ()).Normalized();
-		toPos				= vector3d(mt.GetTranslate());
-		gotOrient = true;
-	}
-
-	if (gotOrient)
-	{
-		vector3d pos		= MathUtil::mix<vector3d, double>(from, toPos, t);
-		outPosOrient.pos	= pos;
-	}
-
-	return gotOrient;
+	const SpaceStationType::Waypoint *wp = GetWaypoint(waypoints, stage);
+	assert(wp);
+	if (!wp)
+		return false;
+
+	outPosOrient.xaxis	= wp->orient.xaxis;
+	outPosOrient.yaxis	= wp->orient.yaxis;
+	outPosOrient.zaxis	= wp->orient.zaxis;
+	outPosOrient.pos	= MathUtil::mix<vector3d, double>(from, wp->orient.pos, t);
+	return true;
 }
 
 /* when ship is on rails it returns true and fills outPosOrient.
@@ -378,22 +391,129 @@ bool SpaceStationType::GetDockAnimPositionOrient(const unsigned int port, int st
 
 	bool gotOrient = false;
 
-	assert(port<=m_portPaths.size());
-	const PortPath &rPortPath = m_portPaths.at(port+1);
+	assert(port<m_bayPaths.size());
+	const BayPaths &rBayPaths = m_bayPaths.at(port);
 	if (stage<0) {
 		const int leavingStage = (-1*stage);
-		gotOrient = GetPosOrient(rPortPath.m_leaving, leavingStage, t, from, outPosOrient);
-		const vector3d up = outPosOrient.yaxis.Normalized() * ship->GetLandingPosOffset();
+		gotOrient = GetPosOrient(rBayPaths.leaving, leavingStage, t, from, outPosOrient);
+		const vector3d up = outPosOrient.yaxis * ship->GetLandingPosOffset();
 		outPosOrient.pos = outPosOrient.pos - up;
 	} else if (stage>0) {
-		gotOrient = GetPosOrient(rPortPath.m_docking, stage, t, from, outPosOrient);
-		const vector3d up = outPosOrient.yaxis.Normalized() * ship->GetLandingPosOffset();
+		gotOrient = GetPosOrient(rBayPaths.docking, stage, t, from, outPosOrient);
+		const vector3d up = outPosOrient.yaxis * ship->GetLandingPosOffset();
 		outPosOrient.pos = outPosOrient.pos - up;
 	}
 
 	return gotOrient;
 }
 
+namespace {
+
+// the definitions in the order they're found, each parsed into its own slot
+struct StationTypeLoad {
+	std::vector<std::pair<std::string,std::string>> files; // id, path
+	std::vector<std::unique_ptr<SpaceStationType>> parsed;
+};
+
+bool s_loaded = false;
+
+void FindStationDefs(StationTypeLoad &load)
+{
+	namespace fs = FileSystem;
+	for (fs::FileEnumerator files(fs::gameDataFiles, "stations", 0); !files.Finished(); files.Next()) {
+		const fs::FileInfo &info = files.Current();
+		if (ends_with_ci(info.GetPath(), ".json")) {
+			const std::string id(info.GetName().substr(0, info.GetName().size()-5));
+			load.files.push_back(std::make_pair(id, info.GetPath()));
+		}
+	}
+	load.parsed.resize(load.files.size());
+}
+
+void ParseStationDef(StationTypeLoad &load, size_t i)
+{
+	load.parsed[i].reset(new SpaceStationType(load.files[i].first, load.files[i].second));
+}
+
+class StationDefJob : public Job {
+public:
+	StationDefJob(const std::shared_ptr<StationTypeLoad> &load, size_t index) : m_load(load), m_index(index) {}
+	virtual void OnRun() override { ParseStationDef(*m_load, m_index); }
+	virtual void OnFinish() override {}
+	virtual const char *GetName() const override { return "StationDefJob"; }
+private:
+	std::shared_ptr<StationTypeLoad> m_load;
+	size_t m_index;
+};
+
+class AddStationTypesJob : public Job {
+public:
+	AddStationTypesJob(const std::shared_ptr<StationTypeLoad> &load) : m_load(load) {}
+	virtual void OnRun() override { SpaceStationType::AddTypes(m_load->parsed); }
+	virtual void OnFinish() override {}
+	virtual const char *GetName() const override { return "AddStationTypesJob"; }
+private:
+	std::shared_ptr<StationTypeLoad> m_load;
+};
+
+}
+
+/*static*/
+void SpaceStationType::AddTypes(const std::vector<std::unique_ptr<SpaceStationType>> &parsed)
+{
+	for (const std::unique_ptr<SpaceStationType> &st : parsed) {
+		switch (st->dockMethod) {
+			case SURFACE: surfaceTypes.push_back(*st); break;
+			case ORBITAL: orbitalTypes.push_back(*st); break;
+		}
+	}
+}
+
+/*static*/
+void SpaceStationType::LoadDefinitions()
+{
+	if (s_loaded)
+		return;
+	s_loaded = true;
+
+	StationTypeLoad load;
+	FindStationDefs(load);
+	for (size_t i = 0; i < load.files.size(); i++)
+		ParseStationDef(load, i);
+	AddTypes(load.parsed);
+}
+
+/*static*/
+Job *SpaceStationType::LoadDefinitions(JobSet &jobs)
+{
+	if (s_loaded)
+		return nullptr;
+	s_loaded = true;
+
+	std::shared_ptr<StationTypeLoad> load(new StationTypeLoad);
+	FindStationDefs(*load);
+
+	std::vector<Job*> parseJobs;
+	parseJobs.reserve(load->files.size());
+	for (size_t i = 0; i < load->files.size(); i++) {
+		Job *job = new StationDefJob(load, i);
+		jobs.Order(job);
+		parseJobs.push_back(job);
+	}
+	Job *addJob = new AddStationTypesJob(load);
+	jobs.OrderAfter(addJob, parseJobs);
+	return addJob;
+}
+
+/*static*/
+void SpaceStationType::GetModelNames(std::vector<std::string> &names)
+{
+	for (const SpaceStationType &st : surfaceTypes)
+		if (st.parsed) names.push_back(st.modelName);
+	for (const SpaceStationType &st : orbitalTypes)
+		if (st.parsed) names.push_back(st.modelName);
+}
+
 /*static*/
 void SpaceStationType::Init()
 {
@@ -402,17 +522,16 @@ void SpaceStationType::Init()
 		return;
 	isInitted = true;
 
-	// load all station definitions
-	namespace fs = FileSystem;
-	for (fs::FileEnumerator files(fs::gameDataFiles, "stations", 0); !files.Finished(); files.Next()) {
-		const fs::FileInfo &info = files.Current();
-		if (ends_with_ci(info.GetPath(), ".json")) {
-			const std::string id(info.GetName().substr(0, info.GetName().size()-5));
-			SpaceStationType st = SpaceStationType(id, info.GetPath());
-			switch (st.dockMethod) {
-				case SURFACE: surfaceTypes.push_back(st); break;
-				case ORBITAL: orbitalTypes.push_back(st); break;
-			}
+	LoadDefinitions();
+
+	std::vector<SpaceStationType> *lists[] = { &surfaceTypes, &orbitalTypes };
+	for (std::vector<SpaceStationType> *list : lists) {
+		for (SpaceStationType &st : *list) {
+			if (!st.parsed)
+				continue;
+			st.model = Pi::FindModel(st.modelName);
+			assert(st.model);
+			st.OnSetupComplete();
 		}
 	}
 }
@@ -5,10 +5,13 @@
 #define _SPACESTATIONTYPE_H
 
 #include "libs.h"
+#include <memory>
 
 //Space station definition, loaded from data/stations
 
 class Ship;
+class Job;
+class JobSet;
 namespace SceneGraph { class Model; }
 
 class SpaceStationType {
@@ -39,6 +42,24 @@ public:
 		vector3d yaxis;
 		vector3d zaxis;
 	};
+
+	// a waypoint from the maps above, already converted and normalised
+	struct Waypoint {
+		Waypoint() : valid(false) {}
+		positionOrient_t orient;
+		bool valid;
+	};
+	typedef std::vector<Waypoint> TWaypoints; // indexed by stage
+
+	// everything a bay's ships go through, worked out once in
+	// OnSetupComplete so the per-tick lookups are just indexing
+	struct BayPaths {
+		BayPaths() : port(-1) {}
+		int port; // index into m_ports
+		TWaypoints approach;
+		TWaypoints docking;
+		TWaypoints leaving;
+	};
 	
 private:
 	std::string id;
@@ -54,7 +75,9 @@ private:
 	float parkingGapSize;
 	PortPathMap m_portPaths;
 	TPorts m_ports;
+	std::vector<BayPaths> m_bayPaths; // by zero based bay id
 	float padOffset;
+	bool parsed; // the definition was read, so there's a model to set up
 
 	static std::vector<SpaceStationType> surfaceTypes;
 	static std::vector<SpaceStationType> orbitalTypes;
@@ -89,9 +112,24 @@ public:
 	float ParkingGapSize() const { return parkingGapSize; }
 	const TPorts& Ports() const { return m_ports; }
 
+	// reads the definitions but doesn't touch the models, so it can run
+	// on a job. Init does it itself if this hasn't been called
+	static void LoadDefinitions();
+	// as LoadDefinitions, with a job in jobs for each definition. returns
+	// the last of them (null if they're already loaded), for anything that
+	// needs the definitions to go after
+	static Job *LoadDefinitions(JobSet &jobs);
+	// files parsed definitions into the surface and orbital lists. only
+	// for the loaders
+	static void AddTypes(const std::vector<std::unique_ptr<SpaceStationType>> &parsed);
+	// the models the definitions use, so they can be requested early
+	static void GetModelNames(std::vector<std::string> &names);
 	static void Init();
 
 	static const SpaceStationType* RandomStationType(Random &random, const bool bIsGround);
+
+private:
+	void BuildBayPaths();
 };
 
 #endif
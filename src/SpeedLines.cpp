@@ -17,25 +17,29 @@ SpeedLines::SpeedLines(Ship *s)
 , m_dir(0.f)
 {
 	PROFILE_SCOPED();
-	m_points.reserve(DEPTH * DEPTH * DEPTH);
+	m_params.offset = vector3f(0.f);
+	m_params.dir = vector3f(0.f);
+	m_params.bounds = BOUNDS;
+
+	// each point twice, uv0.x saying which end of the line it is
+	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0, DEPTH * DEPTH * DEPTH * 2);
 	for (int x = -DEPTH/2; x < DEPTH/2; x++) {
 		for (int y = -DEPTH/2; y < DEPTH/2; y++) {
 			for (int z = -DEPTH/2; z < DEPTH/2; z++) {
-				m_points.push_back(vector3f(x * SPACING, y * SPACING, z * SPACING));
+				const vector3f pt(x * SPACING, y * SPACING, z * SPACING);
+				va.Add(pt, vector2f(-1.f, 0.f));
+				va.Add(pt, vector2f(1.f, 0.f));
 			}
 		}
 	}
 
-	m_varray.reset(new Graphics::VertexArray(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE, (m_points.size() * 2)));
-	for( Uint32 i = 0; i < (m_points.size() * 2); i++ )
-		m_varray->Add(vector3f(0.0f), Color::BLACK);
-
 	Graphics::RenderStateDesc rsd;
 	rsd.blendMode = Graphics::BLEND_ALPHA_ONE;
 	rsd.depthWrite = false;
 	m_renderState = Pi::renderer->CreateRenderState(rsd);
 
-	CreateVertexBuffer( Pi::renderer, (m_points.size() * 2) );
+	CreateVertexBuffer( Pi::renderer, va.GetNumVerts() );
+	m_vbuffer->Populate( va );
 }
 
 void SpeedLines::Update(float time)
@@ -76,48 +80,30 @@ void SpeedLines::Update(float time)
 	if (d > MAX_VEL)
 		vel = m_dir * MAX_VEL;
 
-	for (Uint16 i = 0; i < m_points.size(); i++) {
-
-		vector3f &pt = m_points[i];
-
-		pt -= vel;
-
-		//wrap around
-		if (pt.x > BOUNDS)
-			pt.x -= BOUNDS * 2.f;
-		if (pt.x < -BOUNDS)
-			pt.x += BOUNDS * 2.f;
-		if (pt.y > BOUNDS)
-			pt.y -= BOUNDS * 2.f;
-		if (pt.y < -BOUNDS)
-			pt.y += BOUNDS * 2.f;
-		if (pt.z > BOUNDS)
-			pt.z -= BOUNDS * 2.f;
-		if (pt.z < -BOUNDS)
-			pt.z += BOUNDS * 2.f;
-	}
+	//the points all move together, so only the offset needs updating. it
+	//wraps the same way they do so it never gets big enough to lose precision
+	vector3f &off = m_params.offset;
+	off += vel;
+	if (off.x > BOUNDS)
+		off.x -= BOUNDS * 2.f;
+	if (off.x < -BOUNDS)
+		off.x += BOUNDS * 2.f;
+	if (off.y > BOUNDS)
+		off.y -= BOUNDS * 2.f;
+	if (off.y < -BOUNDS)
+		off.y += BOUNDS * 2.f;
+	if (off.z > BOUNDS)
+		off.z -= BOUNDS * 2.f;
+	if (off.z < -BOUNDS)
+		off.z += BOUNDS * 2.f;
 }
 
 void SpeedLines::Render(Graphics::Renderer *r)
 {
 	PROFILE_SCOPED();
-	if (!m_visible || m_points.empty()) return;
-
-	const vector3f dir = m_dir * m_lineLength;
-
-	Uint16 vtx = 0;
-	//distance fade
-	Color col(Color::GRAY);
-	for (auto it = m_points.begin(); it != m_points.end(); ++it) {
-		col.a = Clamp((1.f - it->Length() / BOUNDS),0.f,1.f) * 255;	
-
-		m_varray->Set(vtx, *it - dir, col);
-		m_varray->Set(vtx+1,*it + dir, col);
-
-		vtx += 2;
-	}
+	if (!m_visible) return;
 
-	m_vbuffer->Populate( *m_varray );
+	m_params.dir = m_dir * m_lineLength;
 
 	r->SetTransform(m_transform);
 	r->DrawBuffer(m_vbuffer.get(), m_renderState, m_material.Get(), Graphics::LINE_SINGLE);
@@ -127,15 +113,17 @@ void SpeedLines::CreateVertexBuffer(Graphics::Renderer *r, const Uint32 size)
 {
 	PROFILE_SCOPED();
 	Graphics::MaterialDescriptor desc;
-	desc.vertexColors = true;
+	desc.effect = Graphics::EFFECT_SPEEDLINES;
 	m_material.Reset(r->CreateMaterial(desc));
+	m_material->diffuse = Color::GRAY;
+	m_material->specialParameter0 = &m_params;
 
 	Graphics::VertexBufferDesc vbd;
 	vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
 	vbd.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-	vbd.attrib[1].semantic = Graphics::ATTRIB_DIFFUSE;
-	vbd.attrib[1].format = Graphics::ATTRIB_FORMAT_UBYTE4;
-	vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;
+	vbd.attrib[1].semantic = Graphics::ATTRIB_UV0;
+	vbd.attrib[1].format = Graphics::ATTRIB_FORMAT_FLOAT2;
+	vbd.usage = Graphics::BUFFER_USAGE_STATIC;
 	vbd.numVertices = size;
 	m_vbuffer.reset(r->CreateVertexBuffer(vbd));
 }
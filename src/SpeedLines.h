@@ -14,6 +14,13 @@ class Ship;
 class SpeedLines
 {
 public:
+	// what the speed lines material needs to place the lines
+	struct LineParameters {
+		vector3f offset;
+		vector3f dir;
+		float bounds;
+	};
+
 	SpeedLines(Ship*);
 
 	void Update(float time);
@@ -28,11 +35,12 @@ private:
 
 	Ship *m_ship;
 
-	std::vector<vector3f> m_points;
+	// the points never change on the GPU. how far they've moved is in here,
+	// and the shader wraps them around the box and fades them
+	LineParameters m_params;
 	
 	Graphics::RenderState *m_renderState;
 	RefCountedPtr<Graphics::Material> m_material;
-	std::unique_ptr<Graphics::VertexArray> m_varray;
 	std::unique_ptr<Graphics::VertexBuffer> m_vbuffer;
 
 	matrix4x4d m_transform;
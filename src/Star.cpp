@@ -7,10 +7,51 @@
 #include "graphics/VertexArray.h"
 #include "gui/Gui.h"
 #include "Pi.h"
+#include <map>
 #include <SDL_stdinc.h>
 
 using namespace Graphics;
 
+// halos are all the same shape, with a radius of one, and only differ in
+// colour, so there's one per type of star, made the first time it's drawn
+static std::map<SystemBody::BodyType, std::unique_ptr<Graphics::VertexBuffer>> s_haloBuffers;
+
+static Graphics::VertexBuffer *GetHaloBuffer(Graphics::Renderer *renderer, SystemBody::BodyType type)
+{
+	std::unique_ptr<Graphics::VertexBuffer> &vb = s_haloBuffers[type];
+	if (vb)
+		return vb.get();
+
+	Random rand;
+
+	VertexArray va(ATTRIB_POSITION | ATTRIB_DIFFUSE);
+	const Color bright(StarSystem::starRealColors[type]);
+	const Color dark(0);
+
+	va.Add(vector3f(0.f), bright);
+	for (float ang=0; ang<2*M_PI; ang+=0.26183+rand.Double(0,0.4)) {
+		va.Add(vector3f(sin(ang), cos(ang), 0), dark);
+	}
+	va.Add(vector3f(0.f, 1.f, 0.f), dark);
+
+	Graphics::VertexBufferDesc vbd;
+	vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+	vbd.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
+	vbd.attrib[1].semantic = Graphics::ATTRIB_DIFFUSE;
+	vbd.attrib[1].format = Graphics::ATTRIB_FORMAT_UBYTE4;
+	vbd.numVertices = va.GetNumVerts();
+	vbd.usage = Graphics::BUFFER_USAGE_STATIC;
+	vb.reset(renderer->CreateVertexBuffer(vbd));
+	vb->Populate(va);
+	return vb.get();
+}
+
+//static
+void Star::Uninit()
+{
+	s_haloBuffers.clear();
+}
+
 Star::Star() : TerrainBody()
 {
 }
@@ -66,22 +107,10 @@ void Star::Render(Graphics::Renderer *renderer, const Camera *camera, const vect
 	vector3d yaxis = zaxis.Cross(xaxis);
 	matrix4x4d rot = matrix4x4d::MakeRotMatrix(xaxis, yaxis, zaxis).Inverse();
 
-	renderer->SetTransform(trans * rot);
-
-	Random rand;
+	renderer->SetTransform(trans * rot * matrix4x4d::ScaleMatrix(rad));
 
 	//render star halo
-	VertexArray va(ATTRIB_POSITION | ATTRIB_DIFFUSE);
-	const Color bright(StarSystem::starRealColors[GetSystemBody()->GetType()]);
-	const Color dark(0);
-
-	va.Add(vector3f(0.f), bright);
-	for (float ang=0; ang<2*M_PI; ang+=0.26183+rand.Double(0,0.4)) {
-		va.Add(vector3f(rad*sin(ang), rad*cos(ang), 0), dark);
-	}
-	va.Add(vector3f(0.f, rad, 0.f), dark);
-
-	renderer->DrawTriangles(&va, m_haloState, Graphics::vtxColorMaterial, TRIANGLE_FAN);
+	renderer->DrawBuffer(GetHaloBuffer(renderer, GetSystemBody()->GetType()), m_haloState, Graphics::vtxColorMaterial, TRIANGLE_FAN);
 
 	TerrainBody::Render(renderer, camera, viewCoords, viewTransform);
 
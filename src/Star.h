@@ -17,6 +17,9 @@ public:
 	virtual ~Star() {};
 
 	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform);
+
+	// drops the halo meshes shared by all stars
+	static void Uninit();
 protected:
 	void InitStar();
 	virtual void LoadFromJson(const Json::Value &jsonObj, Space *space);
@@ -0,0 +1,111 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "StringName.h"
+#include <SDL_mutex.h>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "jenkins/lookup3.h"
+}
+
+// chained, with the bucket count a power of two and at least the entry count
+struct StringName::Table {
+	Table() : count(0), bytes(0), lock(SDL_CreateMutex()) { buckets.resize(256, nullptr); }
+	// names are trivially destructible, so any still around in other
+	// statics don't mind their entries going first
+	~Table() {
+		for (Entry *b : buckets) {
+			for (Entry *e = b, *next; e; e = next) {
+				next = e->next;
+				delete e;
+			}
+		}
+		SDL_DestroyMutex(lock);
+	}
+
+	std::vector<Entry*> buckets;
+	size_t count;
+	size_t bytes;
+	SDL_mutex *lock;
+};
+
+// a function static rather than a global, so names made during static
+// initialisation in other files don't find it unconstructed
+//static
+StringName::Table &StringName::GetTable()
+{
+	static Table table;
+	return table;
+}
+
+//static
+const StringName::Entry *StringName::Intern(const char *s, size_t len)
+{
+	static Entry empty = { std::string(), lookup3_hashlittle("", 0, 0), nullptr };
+	if (!len)
+		return &empty;
+
+	const Uint32 hash = lookup3_hashlittle(s, len, 0);
+	Table &t = GetTable();
+	SDL_LockMutex(t.lock);
+
+	size_t mask = t.buckets.size() - 1;
+	for (Entry *e = t.buckets[hash & mask]; e; e = e->next) {
+		if (e->hash == hash && e->str.size() == len && !memcmp(e->str.data(), s, len)) {
+			SDL_UnlockMutex(t.lock);
+			return e;
+		}
+	}
+
+	if (t.count >= t.buckets.size()) {
+		std::vector<Entry*> buckets(t.buckets.size() * 2, nullptr);
+		mask = buckets.size() - 1;
+		for (Entry *b : t.buckets) {
+			for (Entry *e = b, *next; e; e = next) {
+				next = e->next;
+				e->next = buckets[e->hash & mask];
+				buckets[e->hash & mask] = e;
+			}
+		}
+		t.buckets.swap(buckets);
+	}
+
+	Entry *e = new Entry;
+	e->str.assign(s, len);
+	e->hash = hash;
+	e->next = t.buckets[hash & mask];
+	t.buckets[hash & mask] = e;
+	t.count++;
+	t.bytes += sizeof(Entry) + e->str.capacity();
+
+	SDL_UnlockMutex(t.lock);
+	return e;
+}
+
+StringName::StringName() : m_entry(Intern("", 0))
+{
+}
+
+StringName::StringName(const char *s) : m_entry(Intern(s, strlen(s)))
+{
+}
+
+StringName::StringName(const char *s, size_t len) : m_entry(Intern(s, len))
+{
+}
+
+StringName::StringName(const std::string &s) : m_entry(Intern(s.data(), s.size()))
+{
+}
+
+//static
+void StringName::GetStats(size_t &count, size_t &bytes)
+{
+	Table &t = GetTable();
+	SDL_LockMutex(t.lock);
+	count = t.count;
+	bytes = t.bytes + t.buckets.size() * sizeof(Entry*);
+	SDL_UnlockMutex(t.lock);
+}
@@ -0,0 +1,67 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _STRINGNAME_H
+#define _STRINGNAME_H
+
+#include <SDL_stdinc.h>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+/*
+ * An interned string, for names that get looked up over and over: sound
+ * samples, model tags, cache keys. Every StringName with the same text
+ * points at the same entry in a global table, which holds the string and
+ * its hash, so comparing two names is a pointer compare and hashing one is
+ * a load. Making one from text costs a hash and a table lookup, so
+ * anything looked up every frame should make its name once and keep it.
+ *
+ * Entries live until the program exits. Names can be made from any
+ * thread, but the first must be made from the main thread (in practice
+ * static initialisation or startup does that).
+ */
+class StringName {
+public:
+	StringName();
+	StringName(const char *s);
+	StringName(const char *s, size_t len);
+	StringName(const std::string &s);
+
+	const std::string &GetString() const { return m_entry->str; }
+	const char *c_str() const { return m_entry->str.c_str(); }
+	size_t size() const { return m_entry->str.size(); }
+	bool empty() const { return m_entry->str.empty(); }
+	Uint32 GetHash() const { return m_entry->hash; }
+
+	bool operator==(const StringName &b) const { return m_entry == b.m_entry; }
+	bool operator!=(const StringName &b) const { return m_entry != b.m_entry; }
+	// alphabetical, for anything that wants a stable order
+	bool operator<(const StringName &b) const { return m_entry != b.m_entry && m_entry->str < b.m_entry->str; }
+
+	// number of distinct names and the bytes they hold, for the memory report
+	static void GetStats(size_t &count, size_t &bytes);
+
+private:
+	struct Entry {
+		std::string str;
+		Uint32 hash;
+		Entry *next;
+	};
+
+	struct Table;
+
+	static Table &GetTable();
+	static const Entry *Intern(const char *s, size_t len);
+
+	const Entry *m_entry;
+};
+
+namespace std {
+	template <>
+	struct hash<StringName> {
+		size_t operator()(const StringName &n) const { return n.GetHash(); }
+	};
+}
+
+#endif
@@ -24,6 +24,8 @@ SystemInfoView::SystemInfoView(Game* game) : UIView(), m_game(game)
 	SetTransparency(true);
 	m_refresh = REFRESH_NONE;
 	m_unexplored = true;
+	m_tabs = 0;
+	m_econTabBuilt = m_demographicsTabBuilt = false;
 	int trade_analyzer = 0;
 	Pi::player->Properties().Get("trade_analyzer_cap", trade_analyzer);
 	m_hasTradeAnalyzer = bool(trade_analyzer);
@@ -161,6 +163,9 @@ void SystemInfoView::UpdateEconomyTab()
 	// we might be here because we changed equipment, update that as well:
 	m_hasTradeAnalyzer = bool (trade_analyzer);
 
+	if (!m_econTabBuilt)
+		return;
+
 	// If current system is defined and not equal to selected we will compare them
 	const bool compareSelectedWithCurrent =
 		(hs && !m_system->GetPath().IsSameSystem(hs->GetPath()) && trade_analyzer > 0);
@@ -328,11 +333,17 @@ void SystemInfoView::PutBodies(SystemBody *body, Gui::Fixed *container, int dir,
 
 void SystemInfoView::OnClickBackground(Gui::MouseButtonEvent *e)
 {
-	if (e->isdown && e->button == SDL_BUTTON_LEFT) {
-		// XXX reinit view unnecessary - we only want to show
-		// the general system info text...
-		m_refresh = REFRESH_ALL;
-	}
+	if (e->isdown && e->button == SDL_BUTTON_LEFT)
+		ShowSystemInfo();
+}
+
+void SystemInfoView::ShowSystemInfo()
+{
+	m_infoBox->DeleteAllChildren();
+	Gui::Label *l = (new Gui::Label(m_systemInfoText))->Color(255,255,0);
+	m_infoBox->PackStart(l);
+	m_infoBox->ShowAll();
+	m_infoBox->ResizeRequest();
 }
 
 void SystemInfoView::SystemChanged(const SystemPath &path)
@@ -340,11 +351,18 @@ void SystemInfoView::SystemChanged(const SystemPath &path)
 	DeleteAllChildren();
 	m_tabs = 0;
 	m_bodyIcons.clear();
+	m_econTabBuilt = m_demographicsTabBuilt = false;
 
 	if (!path.HasValidSystem())
 		return;
 
-	m_system = m_game->GetGalaxy()->GetStarSystem(path);
+	// the system we're in is already there in full, anything else comes
+	// from the galaxy's cache
+	RefCountedPtr<StarSystem> currentSys = m_game->GetSpace()->GetStarSystem();
+	if (currentSys && currentSys->GetPath().IsSameSystem(path))
+		m_system = currentSys;
+	else
+		m_system = m_game->GetGalaxy()->GetStarSystem(path);
 	m_unexplored = m_system->GetUnexplored();
 	m_sbodyInfoTab = new Gui::Fixed(float(Gui::Screen::GetWidth()), float(Gui::Screen::GetHeight()-100));
 
@@ -363,12 +381,13 @@ void SystemInfoView::SystemChanged(const SystemPath &path)
 	}
 
 	m_econInfoTab = new Gui::Fixed(float(Gui::Screen::GetWidth()), float(Gui::Screen::GetHeight()-100));
-	Gui::Fixed *demographicsTab = new Gui::Fixed();
+	m_demographicsTab = new Gui::Fixed();
 
 	m_tabs = new Gui::Tabbed();
 	m_tabs->AddPage(new Gui::Label(Lang::PLANETARY_INFO), m_sbodyInfoTab);
 	m_tabs->AddPage(new Gui::Label(Lang::ECONOMIC_INFO), m_econInfoTab);
-	m_tabs->AddPage(new Gui::Label(Lang::DEMOGRAPHICS), demographicsTab);
+	m_tabs->AddPage(new Gui::Label(Lang::DEMOGRAPHICS), m_demographicsTab);
+	m_tabs->onSelectPage.connect(sigc::mem_fun(this, &SystemInfoView::OnTabSelected));
 	Add(m_tabs, 0, 0);
 
 	m_sbodyInfoTab->onMouseButtonEvent.connect(sigc::mem_fun(this, &SystemInfoView::OnClickBackground));
@@ -378,20 +397,11 @@ void SystemInfoView::SystemChanged(const SystemPath &path)
 		float pos[2] = { 0, 0 };
 		float psize = -1;
 		majorBodies = starports = onSurface = 0;
-		PutBodies(m_system->GetRootBody().Get(), m_econInfoTab, 1, pos, majorBodies, starports, onSurface, psize);
-
-		majorBodies = starports = onSurface = 0;
-		pos[0] = pos[1] = 0;
-		psize = -1;
 		PutBodies(m_system->GetRootBody().Get(), m_sbodyInfoTab, 1, pos, majorBodies, starports, onSurface, psize);
-
-		majorBodies = starports = onSurface = 0;
-		pos[0] = pos[1] = 0;
-		psize = -1;
-		PutBodies(m_system->GetRootBody().Get(), demographicsTab, 1, pos, majorBodies, starports, onSurface, psize);
 	}
 
-	std::string _info = stringf(
+	std::string &_info = m_systemInfoText;
+	_info = stringf(
 		Lang::STABLE_SYSTEM_WITH_N_MAJOR_BODIES_STARPORTS,
 		formatarg("bodycount", majorBodies),
 		formatarg("body(s)", std::string(majorBodies == 1 ? Lang::BODY : Lang::BODIES)),
@@ -421,8 +431,30 @@ void SystemInfoView::SystemChanged(const SystemPath &path)
 		scrollBox->PackStart(portal);
 	}
 
+	UpdateIconSelections();
+
+	ShowAll();
+}
+
+void SystemInfoView::OnTabSelected(int page)
+{
+	if (page == 1 && !m_econTabBuilt)
+		BuildEconomyTab();
+	else if (page == 2 && !m_demographicsTabBuilt)
+		BuildDemographicsTab();
+}
+
+void SystemInfoView::BuildEconomyTab()
+{
+	PROFILE_SCOPED()
+	m_econTabBuilt = true;
+
+	int majorBodies = 0, starports = 0, onSurface = 0;
+	float pos[2] = { 0, 0 };
+	float psize = -1;
+	PutBodies(m_system->GetRootBody().Get(), m_econInfoTab, 1, pos, majorBodies, starports, onSurface, psize);
+
 	{
-		// economy tab
 		Gui::VBox *econbox = new Gui::VBox();
 		econbox->SetSpacing(5);
 
@@ -458,11 +490,26 @@ void SystemInfoView::SystemChanged(const SystemPath &path)
 		UpdateEconomyTab();
 	}
 
+	UpdateIconSelections();
+	m_econInfoTab->ShowAll();
+}
+
+void SystemInfoView::BuildDemographicsTab()
+{
+	PROFILE_SCOPED()
+	m_demographicsTabBuilt = true;
+	const SystemPath &path = m_system->GetPath();
+
+	int majorBodies = 0, starports = 0, onSurface = 0;
+	float pos[2] = { 0, 0 };
+	float psize = -1;
+	PutBodies(m_system->GetRootBody().Get(), m_demographicsTab, 1, pos, majorBodies, starports, onSurface, psize);
+
 	{
 		Gui::Fixed *col1 = new Gui::Fixed();
-		demographicsTab->Add(col1, 200, 300);
+		m_demographicsTab->Add(col1, 200, 300);
 		Gui::Fixed *col2 = new Gui::Fixed();
-		demographicsTab->Add(col2, 400, 300);
+		m_demographicsTab->Add(col2, 400, 300);
 
 		const float YSEP = Gui::Screen::GetFontHeight() * 1.2f;
 
@@ -494,8 +541,7 @@ void SystemInfoView::SystemChanged(const SystemPath &path)
 	}
 
 	UpdateIconSelections();
-
-	ShowAll();
+	m_demographicsTab->ShowAll();
 }
 
 void SystemInfoView::Draw3D()
@@ -526,7 +572,7 @@ SystemInfoView::RefreshType SystemInfoView::NeedsRefresh()
 	int trade_analyzer = 0;
 	Pi::player->Properties().Get("trade_analyzer_cap", trade_analyzer);
 	if (m_hasTradeAnalyzer != (trade_analyzer!=0))
-		return REFRESH_ALL;
+		return REFRESH_SELECTED_BODY; // which updates the economy tab too
 
 	if (m_system->GetUnexplored())
 		return REFRESH_NONE; // Nothing can be selected and we reset in SystemChanged
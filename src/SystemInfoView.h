@@ -48,6 +48,11 @@ private:
 	RefreshType NeedsRefresh();
 	void SystemChanged(const SystemPath &path);
 	void UpdateEconomyTab();
+	// the tabs other than the first are only filled in when they're looked at
+	void OnTabSelected(int page);
+	void BuildEconomyTab();
+	void BuildDemographicsTab();
+	void ShowSystemInfo();
 	void OnBodyViewed(SystemBody *b);
 	void OnBodySelected(SystemBody *b);
 	void OnClickBackground(Gui::MouseButtonEvent *e);
@@ -61,7 +66,9 @@ private:
 	Gui::Fixed *m_econMajImport, *m_econMinImport;
 	Gui::Fixed *m_econMajExport, *m_econMinExport;
 	Gui::Fixed *m_econIllegal;
-	Gui::Fixed *m_sbodyInfoTab, *m_econInfoTab;
+	Gui::Fixed *m_sbodyInfoTab, *m_econInfoTab, *m_demographicsTab;
+	bool m_econTabBuilt, m_demographicsTabBuilt;
+	std::string m_systemInfoText;
 
 	Gui::Label *m_commodityTradeLabel;
 	Gui::Tabbed *m_tabs;
@@ -16,6 +16,8 @@
 #include "graphics/Material.h"
 #include "graphics/Renderer.h"
 #include "graphics/TextureBuilder.h"
+#include "graphics/Graphics.h"
+#include "JobQueue.h"
 
 using namespace Graphics;
 
@@ -27,6 +29,13 @@ static const float ZOOM_OUT_SPEED = 1.f/ZOOM_IN_SPEED;
 static const float WHEEL_SENSITIVITY = .1f;		// Should be a variable in user settings.
 // i don't know how to name it
 static const double ROUGH_SIZE_OF_TURD = 10.0;
+// orbit lines get a point every few pixels, within these limits. the max
+// must be a power of two so the cached lines can be drawn with any
+// power of two stride
+static const Uint32 MIN_ORBIT_SAMPLES = 16;
+static const Uint32 MAX_ORBIT_SAMPLES = 512;
+static const double ORBIT_SEGMENT_PIXELS = 4.0;
+static const Uint32 ORBIT_CACHE_BATCH = 8;
 
 TransferPlanner::TransferPlanner() {
 	m_dvPrograde = 0.0;
@@ -305,27 +314,57 @@ void SystemView::ResetViewpoint()
 	m_time = m_game->GetTime();
 }
 
+Uint32 SystemView::GetOrbitSampleCount(const Orbit *orbit) const
+{
+	// radius in pixels, as seen from the camera at ROUGH_SIZE_OF_TURD with
+	// the 50 degree field of view Draw3D sets up
+	const double halfHeight = ROUGH_SIZE_OF_TURD * tan(DEG2RAD(25.0));
+	const double radius = fabs(orbit->GetSemiMajorAxis()) * m_zoom / halfHeight * 0.5 * Graphics::GetScreenHeight();
+	// eccentric ones turn sharply round the periapsis
+	const double bend = 1.0 + 2.0 * std::min(orbit->GetEccentricity(), 1.0);
+	const double count = 2.0 * M_PI * radius * bend / ORBIT_SEGMENT_PIXELS;
+	return Uint32(Clamp(count, double(MIN_ORBIT_SAMPLES), double(MAX_ORBIT_SAMPLES)));
+}
+
 void SystemView::PutOrbit(const Orbit *orbit, const vector3d &offset, const Color &color, double planetRadius)
 {
-	int num_vertices = 0;
-	vector3f vts[100];
-	for (int i = 0; i < int(COUNTOF(vts)); ++i) {
-		const double t = double(i) / double(COUNTOF(vts));
+	const Uint32 count = GetOrbitSampleCount(orbit);
+	m_orbitPoints.clear();
+	for (Uint32 i = 0; i < count; ++i) {
+		const double t = double(i) / double(count);
 		const vector3d pos = orbit->EvenSpacedPosTrajectory(t);
-		vts[i] = vector3f(offset + pos * double(m_zoom));
-		++num_vertices;
+		m_orbitPoints.push_back(pos);
 		if (pos.Length() < planetRadius)
 			break;
 	}
 
-	if (num_vertices > 1) {
-		m_orbits.SetData(num_vertices, vts, color);
-		// don't close the loop for hyperbolas and parabolas and crashed ellipses
-		if ((orbit->GetEccentricity() > 1.0) || (num_vertices < int(COUNTOF(vts)))) {
-			m_orbits.Draw(m_renderer, m_lineState, LINE_STRIP);
-		} else {
-			m_orbits.Draw(m_renderer, m_lineState, LINE_LOOP);
-		}
+	// don't close the loop for hyperbolas and parabolas and crashed ellipses
+	const bool closed = orbit->GetEccentricity() <= 1.0 && m_orbitPoints.size() == count;
+	DrawOrbit(orbit, m_orbitPoints, 1, closed, offset, color);
+}
+
+void SystemView::PutOrbit(const SystemBody *b, const vector3d &offset, const Color &color)
+{
+	auto i = m_orbitCache.find(b);
+	if (i == m_orbitCache.end()) return;
+
+	const Orbit *orbit = &b->GetOrbit();
+	Uint32 stride = 1;
+	const Uint32 count = GetOrbitSampleCount(orbit);
+	while (MAX_ORBIT_SAMPLES / (stride*2) >= count)
+		stride *= 2;
+	DrawOrbit(orbit, i->second, stride, orbit->GetEccentricity() <= 1.0, offset, color);
+}
+
+void SystemView::DrawOrbit(const Orbit *orbit, const std::vector<vector3d> &points, Uint32 stride, bool closed, const vector3d &offset, const Color &color)
+{
+	m_orbitVerts.clear();
+	for (Uint32 i = 0; i < points.size(); i += stride)
+		m_orbitVerts.push_back(vector3f(offset + points[i] * double(m_zoom)));
+
+	if (m_orbitVerts.size() > 1) {
+		m_orbits.SetData(m_orbitVerts.size(), &m_orbitVerts[0], color);
+		m_orbits.Draw(m_renderer, m_lineState, closed ? LINE_LOOP : LINE_STRIP);
 	}
 
 	Gui::Screen::EnterOrtho();
@@ -337,6 +376,29 @@ void SystemView::PutOrbit(const Orbit *orbit, const vector3d &offset, const Colo
 	Gui::Screen::LeaveOrtho();
 }
 
+void SystemView::BuildOrbitCache()
+{
+	PROFILE_SCOPED()
+	m_orbitCache.clear();
+
+	// make every entry first, so the runners only fill them in
+	std::vector<std::pair<const SystemBody*,std::vector<vector3d>*>> work;
+	for (const RefCountedPtr<SystemBody> &b : m_system->GetBodies()) {
+		if (!b->GetParent() || is_zero_general(b->GetOrbit().GetSemiMajorAxis())) continue;
+		work.push_back(std::make_pair(b.Get(), &m_orbitCache[b.Get()]));
+	}
+
+	Pi::GetAsyncJobQueue()->ParallelFor(work.size(), ORBIT_CACHE_BATCH, [&work](Uint32 begin, Uint32 end) {
+		for (Uint32 i = begin; i < end; i++) {
+			const Orbit &orbit = work[i].first->GetOrbit();
+			std::vector<vector3d> &points = *work[i].second;
+			points.resize(MAX_ORBIT_SAMPLES);
+			for (Uint32 j = 0; j < MAX_ORBIT_SAMPLES; j++)
+				points[j] = orbit.EvenSpacedPosTrajectory(double(j) / double(MAX_ORBIT_SAMPLES));
+		}
+	});
+}
+
 void SystemView::OnClickObject(const SystemBody *b)
 {
 	m_selectedObject = b;
@@ -510,7 +572,7 @@ void SystemView::PutBody(const SystemBody *b, const vector3d &offset, const matr
 		for(const SystemBody* kid : b->GetChildren()) {
 			if (is_zero_general(kid->GetOrbit().GetSemiMajorAxis())) continue;
 			if (kid->GetOrbit().GetSemiMajorAxis() * m_zoom < ROUGH_SIZE_OF_TURD) {
-				PutOrbit(&(kid->GetOrbit()), offset, Color(0, 255, 0, 255));
+				PutOrbit(kid, offset, Color(0, 255, 0, 255));
 			}
 
 			// not using current time yet
@@ -586,6 +648,7 @@ void SystemView::Draw3D()
 	if (m_system) {
 		if (m_system->GetUnexplored() != m_unexplored || !m_system->GetPath().IsSameSystem(path)) {
 			m_system.Reset();
+			m_orbitCache.clear();
 			ResetViewpoint();
 		}
 	}
@@ -602,6 +665,8 @@ void SystemView::Draw3D()
 	if (!m_system) {
 		m_system = m_game->GetGalaxy()->GetStarSystem(path);
 		m_unexplored = m_system->GetUnexplored();
+		if (!m_unexplored)
+			BuildOrbitCache();
 	}
 
 	matrix4x4f trans = matrix4x4f::Identity();
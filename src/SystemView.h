@@ -8,6 +8,7 @@
 #include "gui/Gui.h"
 #include "UIView.h"
 #include "graphics/Drawables.h"
+#include <unordered_map>
 
 class StarSystem;
 class SystemBody;
@@ -54,6 +55,13 @@ public:
 private:
 	static const double PICK_OBJECT_RECT_SIZE;
 	void PutOrbit(const Orbit *orb, const vector3d &offset, const Color &color, double planetRadius = 0.0);
+	void PutOrbit(const SystemBody *b, const vector3d &offset, const Color &color);
+	void DrawOrbit(const Orbit *orb, const std::vector<vector3d> &points, Uint32 stride, bool closed, const vector3d &offset, const Color &color);
+	// how many points the line needs at the current zoom, for its size on
+	// screen and how sharply it bends
+	Uint32 GetOrbitSampleCount(const Orbit *orb) const;
+	// samples every system body's orbit, on the job runners
+	void BuildOrbitCache();
 	void PutBody(const SystemBody *b, const vector3d &offset, const matrix4x4f &trans);
 	void PutLabel(const SystemBody *b, const vector3d &offset);
 	void PutSelectionBox(const SystemBody *b, const vector3d &rootPos, const Color &col);
@@ -107,6 +115,13 @@ private:
 	std::unique_ptr<Gui::TexturedQuad> m_apoapsisIcon;
 	Graphics::RenderState *m_lineState;
 	Graphics::Drawables::Lines m_orbits;
+	// points around the orbit of each body of m_system, relative to its
+	// parent and unscaled. system body orbits never change, so they're only
+	// sampled once per system, MAX_ORBIT_SAMPLES evenly spaced, and drawn
+	// with a stride for the zoom
+	std::unordered_map<const SystemBody*,std::vector<vector3d>> m_orbitCache;
+	std::vector<vector3d> m_orbitPoints; // scratch for orbits that aren't cached
+	std::vector<vector3f> m_orbitVerts;
 	Graphics::Drawables::Lines m_selectBox;
 };
 
@@ -0,0 +1,209 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "TerrainBenchmark.h"
+#include "GeoPatchJobs.h"
+#include "GeoPatchPool.h"
+#include "JobQueue.h"
+#include "OS.h"
+#include "perlin.h"
+#include "Random.h"
+#include "galaxy/Galaxy.h"
+#include "galaxy/GalaxyGenerator.h"
+#include "galaxy/Sector.h"
+#include "galaxy/StarSystem.h"
+#include "json/json.h"
+#include "terrain/Terrain.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <set>
+
+// sectors either side of Sol to look for bodies in
+static const int SEARCH_RADIUS = 1;
+// the GeoSphere detail levels' edge lengths
+static const int PATCH_EDGE_LENGTHS[] = { 7, 15, 25, 35, 55 };
+// patches are this fraction of a cube face across, about what's drawn
+// close to the ground
+static const double PATCH_SIZE = 1.0 / 256.0;
+static const Uint32 SEED = 0x7e77a1;
+
+namespace TerrainBenchmark {
+
+// only here to get at GenerateMesh
+class PatchGenerator : public BasePatchJob {
+public:
+	PatchGenerator(int edgeLen) : m_edgeLen(edgeLen) {
+		const int numVerts = edgeLen*edgeLen;
+		const int numBorderedVerts = (edgeLen+2)*(edgeLen+2);
+		m_heights.reset(GeoPatchPool::Alloc<double>(numVerts));
+		m_normals.reset(GeoPatchPool::Alloc<vector3f>(numVerts));
+		m_colors.reset(GeoPatchPool::Alloc<Color3ub>(numVerts));
+		m_borderHeights.reset(GeoPatchPool::Alloc<double>(numBorderedVerts));
+		m_borderVertexs.reset(GeoPatchPool::Alloc<vector3d>(numBorderedVerts));
+	}
+	void Generate(const vector3d *corners, const Terrain *terrain) {
+		GenerateMesh(m_heights.get(), m_normals.get(), m_colors.get(), m_borderHeights.get(), m_borderVertexs.get(),
+			corners[0], corners[1], corners[2], corners[3], m_edgeLen, 1.0 / double(m_edgeLen-1), terrain);
+	}
+	virtual const char *GetName() const { return "TerrainBenchmark"; }
+private:
+	const int m_edgeLen;
+	std::unique_ptr<double[], GeoPatchPool::Deleter> m_heights;
+	std::unique_ptr<vector3f[], GeoPatchPool::Deleter> m_normals;
+	std::unique_ptr<Color3ub[], GeoPatchPool::Deleter> m_colors;
+	std::unique_ptr<double[], GeoPatchPool::Deleter> m_borderHeights;
+	std::unique_ptr<vector3d[], GeoPatchPool::Deleter> m_borderVertexs;
+};
+
+static double Now()
+{
+	return double(SDL_GetPerformanceCounter()) / double(SDL_GetPerformanceFrequency());
+}
+
+static vector3d RandomDirection(Random &rng)
+{
+	for (;;) {
+		const vector3d v(rng.Double(-1.0, 1.0), rng.Double(-1.0, 1.0), rng.Double(-1.0, 1.0));
+		const double len = v.Length();
+		if (len > 0.01 && len <= 1.0)
+			return v / len;
+	}
+}
+
+// one body for each fractal pair, so each generator is only timed once
+static void FindBodies(RefCountedPtr<Galaxy> galaxy, std::vector<RefCountedPtr<StarSystem>> &systems,
+	std::vector<std::pair<const SystemBody*,RefCountedPtr<Terrain>>> &bodies)
+{
+	std::set<std::pair<std::string,std::string>> seen;
+	for (int z = -SEARCH_RADIUS; z <= SEARCH_RADIUS; z++) {
+		for (int y = -SEARCH_RADIUS; y <= SEARCH_RADIUS; y++) {
+			for (int x = -SEARCH_RADIUS; x <= SEARCH_RADIUS; x++) {
+				RefCountedPtr<const Sector> sector = galaxy->GetSector(SystemPath(x, y, z));
+				for (Uint32 i = 0; i < sector->m_systems.size(); i++) {
+					RefCountedPtr<StarSystem> system = galaxy->GetStarSystem(SystemPath(x, y, z, i));
+					bool used = false;
+					for (const RefCountedPtr<SystemBody> &b : system->GetBodies()) {
+						const SystemBody::BodySuperType st = b->GetSuperType();
+						if (st != SystemBody::SUPERTYPE_STAR && st != SystemBody::SUPERTYPE_ROCKY_PLANET && st != SystemBody::SUPERTYPE_GAS_GIANT)
+							continue;
+						RefCountedPtr<Terrain> terrain(Terrain::InstanceTerrain(b.Get()));
+						if (!seen.insert(std::make_pair(terrain->GetHeightFractalName(), terrain->GetColorFractalName())).second)
+							continue;
+						bodies.push_back(std::make_pair(b.Get(), terrain));
+						used = true;
+					}
+					if (used)
+						systems.push_back(system); // keeps the bodies alive
+				}
+			}
+		}
+	}
+}
+
+bool Run(const std::string &filename, Uint32 points, Uint32 patches)
+{
+	RefCountedPtr<Galaxy> galaxy = GalaxyGenerator::Create();
+	std::vector<RefCountedPtr<StarSystem>> systems;
+	std::vector<std::pair<const SystemBody*,RefCountedPtr<Terrain>>> bodies;
+	FindBodies(galaxy, systems, bodies);
+	Output("terrainbench: %u fractal pairs, %u points, %u patches, %s colour noise\n", Uint32(bodies.size()), points, patches,
+		noiseIsVectorised() ? "vectorised" : "scalar");
+
+	std::vector<Uint32> threadCounts;
+	const Uint32 numCores = std::max(OS::GetNumCores(), 1);
+	for (Uint32 n = 1; n < numCores; n *= 2)
+		threadCounts.push_back(n);
+	threadCounts.push_back(numCores);
+
+	// the same points and patches for every terrain
+	Random rng(SEED);
+	std::vector<vector3d> pts(points);
+	for (vector3d &p : pts)
+		p = RandomDirection(rng);
+	std::vector<vector3d> corners(patches*4);
+	for (Uint32 i = 0; i < patches; i++) {
+		const vector3d centre = RandomDirection(rng);
+		const vector3d side = centre.Cross(fabs(centre.x) < 0.9 ? vector3d(1,0,0) : vector3d(0,1,0)).Normalized() * PATCH_SIZE;
+		const vector3d up = centre.Cross(side);
+		corners[i*4+0] = (centre - side - up).Normalized();
+		corners[i*4+1] = (centre + side - up).Normalized();
+		corners[i*4+2] = (centre + side + up).Normalized();
+		corners[i*4+3] = (centre - side + up).Normalized();
+	}
+
+	std::vector<double> heights(points);
+	std::vector<vector3d> colors(points);
+
+	Json::Value results(Json::arrayValue);
+	for (const std::pair<const SystemBody*,RefCountedPtr<Terrain>> &body : bodies) {
+		const Terrain *terrain = body.second.Get();
+		Json::Value result(Json::objectValue);
+		result["body"] = body.first->GetName();
+		result["height_fractal"] = terrain->GetHeightFractalName();
+		result["color_fractal"] = terrain->GetColorFractalName();
+
+		double start = Now();
+		terrain->GetHeights(&pts[0], &heights[0], int(points));
+		const double heightTime = Now() - start;
+		// the points are unit vectors, so they do for the normals too
+		start = Now();
+		terrain->GetColors(&pts[0], &heights[0], &pts[0], &colors[0], int(points));
+		const double colorTime = Now() - start;
+		result["heights_per_sec"] = double(points) / heightTime;
+		result["colors_per_sec"] = double(points) / colorTime;
+
+		Json::Value patchResults(Json::arrayValue);
+		for (int edgeLen : PATCH_EDGE_LENGTHS) {
+			for (Uint32 threads : threadCounts) {
+				AsyncJobQueue jobs(threads);
+				std::vector<std::unique_ptr<PatchGenerator>> generators(threads);
+				for (std::unique_ptr<PatchGenerator> &g : generators)
+					g.reset(new PatchGenerator(edgeLen));
+
+				// one batch per runner, each with its own buffers
+				const Uint32 batch = (patches + threads - 1) / threads;
+				start = Now();
+				jobs.ParallelFor(patches, batch, [&](Uint32 begin, Uint32 end) {
+					PatchGenerator *g = generators[begin / batch].get();
+					for (Uint32 i = begin; i < end; i++)
+						g->Generate(&corners[i*4], terrain);
+				});
+				const double patchTime = Now() - start;
+
+				Json::Value p(Json::objectValue);
+				p["edge_length"] = edgeLen;
+				p["threads"] = threads;
+				p["patches_per_sec"] = double(patches) / patchTime;
+				p["ms_per_patch"] = patchTime * 1e3 / double(patches);
+				patchResults.append(p);
+			}
+		}
+		result["patches"] = patchResults;
+		results.append(result);
+
+		Output("  %-28s %-28s %10.0f heights/s %10.0f colors/s\n", terrain->GetHeightFractalName(), terrain->GetColorFractalName(),
+			double(points) / heightTime, double(points) / colorTime);
+	}
+
+	Json::Value root(Json::objectValue);
+	root["points"] = points;
+	root["patches"] = patches;
+	root["patch_size"] = PATCH_SIZE;
+	root["cores"] = numCores;
+	root["results"] = results;
+
+	Json::StyledWriter writer;
+	const std::string out = writer.write(root);
+	FILE *f = filename == "-" ? stdout : fopen(filename.c_str(), "w");
+	if (!f) {
+		Output("terrainbench: could not open \"%s\" for writing: %s\n", filename.c_str(), strerror(errno));
+		return false;
+	}
+	const bool ok = fwrite(out.c_str(), 1, out.size(), f) == out.size();
+	if (filename != "-" && fclose(f) != 0)
+		return false;
+	return ok;
+}
+
+}
@@ -0,0 +1,26 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _TERRAINBENCHMARK_H
+#define _TERRAINBENCHMARK_H
+
+#include "libs.h"
+#include <string>
+
+/*
+ * Terrain generation benchmark. Finds one body for each height and colour
+ * fractal pair in the systems around Sol and times, for each:
+ *
+ *  - GetHeights and GetColors over a batch of random surface points
+ *  - GeoPatch mesh generation at a few patch edge lengths, with the patches
+ *    spread over 1, 2, 4... job runners up to the number of cores
+ *
+ * The results go to the file (or "-" for stdout) as json, for comparing
+ * runs. Pi should be initialised headless first.
+ */
+namespace TerrainBenchmark {
+	// false if the output couldn't be written
+	bool Run(const std::string &filename, Uint32 points, Uint32 patches);
+}
+
+#endif
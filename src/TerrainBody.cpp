@@ -28,6 +28,12 @@ TerrainBody::TerrainBody() :
 
 TerrainBody::~TerrainBody()
 {
+	// the body may well be back soon, eg. on the way back from a round trip
+	GeoSphere *gs = dynamic_cast<GeoSphere*>(m_baseSphere.get());
+	if (gs) {
+		m_baseSphere.release();
+		GeoSphere::KeepAlive(gs);
+	}
 	m_baseSphere.reset();
 }
 
@@ -39,7 +45,8 @@ void TerrainBody::InitTerrainBody()
 		if ( SystemBody::SUPERTYPE_GAS_GIANT==m_sbody->GetSuperType() ) {
 			m_baseSphere.reset(new GasGiant(m_sbody));
 		} else {
-			m_baseSphere.reset(new GeoSphere(m_sbody));
+			GeoSphere *gs = GeoSphere::Adopt(m_sbody);
+			m_baseSphere.reset(gs ? gs : new GeoSphere(m_sbody));
 		}
 	}
 	m_maxFeatureHeight = (m_baseSphere->GetMaxFeatureHeight() + 1.0) * m_sbody->GetRadius();
@@ -61,7 +68,7 @@ void TerrainBody::LoadFromJson(const Json::Value &jsonObj, Space *space)
 	Body::LoadFromJson(jsonObj, space);
 
 	if (!jsonObj.isMember("terrain_body")) throw SavedGameCorruptException();
-	Json::Value terrainBodyObj = jsonObj["terrain_body"];
+	const Json::Value &terrainBodyObj = jsonObj["terrain_body"];
 
 	if (!terrainBodyObj.isMember("index_for_system_body")) throw SavedGameCorruptException();
 
@@ -22,6 +22,9 @@ public:
 	virtual bool OnCollision(Object *b, Uint32 flags, double relVel) { return true; }
 	virtual double GetMass() const { return m_mass; }
 	double GetTerrainHeight(const vector3d &pos) const;
+	// for sampling heights away from the main thread. take a reference to
+	// it first, the body may go before the work is done
+	Terrain *GetTerrain() const { return m_baseSphere ? m_baseSphere->GetTerrain() : nullptr; }
 	bool IsSuperType(SystemBody::BodySuperType t) const;
 	virtual const SystemBody *GetSystemBody() const { return m_sbody; }
 
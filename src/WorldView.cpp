@@ -61,7 +61,7 @@ WorldView::WorldView(Game* game): UIView(), m_game(game)
 WorldView::WorldView(const Json::Value &jsonObj, Game* game) : UIView(), m_game(game)
 {
 	if (!jsonObj.isMember("world_view")) throw SavedGameCorruptException();
-	Json::Value worldViewObj = jsonObj["world_view"];
+	const Json::Value &worldViewObj = jsonObj["world_view"];
 
 	if (!worldViewObj.isMember("cam_type")) throw SavedGameCorruptException();
 	m_camType = CamType(worldViewObj["cam_type"].asInt());
@@ -1439,7 +1439,6 @@ void WorldView::UpdateCommsOptions()
 void WorldView::SelectBody(Body *target, bool reselectIsDeselect)
 {
 	if (!target || target == Pi::player) return;		// don't select self
-	if (target->IsType(Object::PROJECTILE)) return;
 
 	if (target->IsType(Object::SHIP)) {
 		if (Pi::player->GetCombatTarget() == target) {
@@ -1458,11 +1457,11 @@ void WorldView::SelectBody(Body *target, bool reselectIsDeselect)
 
 Body* WorldView::PickBody(const double screenX, const double screenY) const
 {
-	for (std::map<Body*,vector3d>::const_iterator
+	for (std::vector< std::pair<Body*,vector3d> >::const_iterator
 		i = m_projectedPos.begin(); i != m_projectedPos.end(); ++i) {
 		Body *b = i->first;
 
-		if (b == Pi::player || b->IsType(Object::PROJECTILE))
+		if (b == Pi::player)
 			continue;
 
 		const double x1 = i->second.x - PICK_OBJECT_RECT_SIZE * 0.5;
@@ -1508,9 +1507,11 @@ void WorldView::UpdateProjectedObjects()
 	// determine projected positions and update labels
 	m_bodyLabels->Clear();
 	m_projectedPos.clear();
+	const Body *navTarget = Pi::player->GetNavTarget();
+	const bool internalCam = GetCamType() == CAM_INTERNAL;
 	for (Body* b : m_game->GetSpace()->GetBodies()) {
 		// don't show the player label on internal camera
-		if (b->IsType(Object::PLAYER) && GetCamType() == CAM_INTERNAL)
+		if (internalCam && b->IsType(Object::PLAYER))
 			continue;
 
 		vector3d pos = b->GetInterpPositionRelTo(cam_frame);
@@ -1522,16 +1523,14 @@ void WorldView::UpdateProjectedObjects()
 			    b->IsType(Object::SPACESTATION) ||
 			    Pi::player->GetPositionRelTo(b).LengthSqr() < 1000000.0*1000000.0)
 			{
-				std::string bodyName = b->GetLabel();
 				// offset the label so it doesn't intersect with the icon drawn around the
 				// navtarget. XXX this probably isn't the most elegant solution
-				if(b == Pi::player->GetNavTarget()) { bodyName = "    " + bodyName; }
-				m_bodyLabels->Add(bodyName,
+				m_bodyLabels->Add(b == navTarget ? "    " + b->GetLabel() : b->GetLabel(),
 						  sigc::bind(sigc::mem_fun(this, &WorldView::SelectBody), b, true),
 						  float(pos.x),
 						  float(pos.y));
 			}
-			m_projectedPos[b] = pos;
+			m_projectedPos.push_back(std::make_pair(b, pos));
 		}
 	}
 
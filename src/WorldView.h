@@ -186,7 +186,7 @@ private:
 	sigc::connection m_onMouseWheelCon;
 
 	Gui::LabelSet *m_bodyLabels;
-	std::map<Body*,vector3d> m_projectedPos;
+	std::vector< std::pair<Body*,vector3d> > m_projectedPos;
 
 	RefCountedPtr<CameraContext> m_cameraContext;
 	std::unique_ptr<Camera> m_camera;
@@ -32,6 +32,55 @@ BVHTree::BVHTree(int numObjs, const objPtr_t *objPtrs, const Aabb *objAabbs)
 	//Output(" - - - BVHTree::BVHTree took: %lf milliseconds\n", timer.millicycles());
 }
 
+// nodes are stored in allocation order, the root first, with their kids
+// and leaf contents as indices rather than pointers
+BVHTree::BVHTree(Serializer::Reader &rd)
+{
+	PROFILE_SCOPED()
+	m_objPtrAllocMax = m_objPtrAllocPos = rd.Int32();
+	m_objPtrAlloc = new objPtr_t[std::max<size_t>(m_objPtrAllocMax, 1)];
+	for (size_t i = 0; i < m_objPtrAllocPos; i++)
+		m_objPtrAlloc[i] = rd.Int32();
+
+	m_nodeAllocMax = m_nodeAllocPos = rd.Int32();
+	if (m_nodeAllocMax == 0) Error("BVHTree with no nodes.");
+	m_bvhNodes = new BVHNode[m_nodeAllocMax];
+	for (size_t i = 0; i < m_nodeAllocPos; i++) {
+		BVHNode &n = m_bvhNodes[i];
+		n.aabb.max = rd.Vector3d();
+		n.aabb.min = rd.Vector3d();
+		n.aabb.radius = rd.Double();
+		n.numTris = rd.Int32();
+		const Sint32 triStart = rd.Int32();
+		n.triIndicesStart = triStart < 0 ? nullptr : &m_objPtrAlloc[triStart];
+		for (int k = 0; k < 2; k++) {
+			const Sint32 kid = rd.Int32();
+			n.kids[k] = kid < 0 ? nullptr : &m_bvhNodes[kid];
+		}
+	}
+	m_root = &m_bvhNodes[0];
+}
+
+void BVHTree::Save(Serializer::Writer &wr) const
+{
+	assert(m_root == &m_bvhNodes[0]);
+	wr.Int32(m_objPtrAllocPos);
+	for (size_t i = 0; i < m_objPtrAllocPos; i++)
+		wr.Int32(m_objPtrAlloc[i]);
+
+	wr.Int32(m_nodeAllocPos);
+	for (size_t i = 0; i < m_nodeAllocPos; i++) {
+		const BVHNode &n = m_bvhNodes[i];
+		wr.Vector3d(n.aabb.max);
+		wr.Vector3d(n.aabb.min);
+		wr.Double(n.aabb.radius);
+		wr.Int32(n.numTris);
+		wr.Int32(n.triIndicesStart ? Sint32(n.triIndicesStart - m_objPtrAlloc) : -1);
+		for (int k = 0; k < 2; k++)
+			wr.Int32(n.kids[k] ? Sint32(n.kids[k] - m_bvhNodes) : -1);
+	}
+}
+
 void BVHTree::MakeLeaf(BVHNode *node, const objPtr_t *objPtrs, std::vector<objPtr_t> &objs)
 {
 	PROFILE_SCOPED()
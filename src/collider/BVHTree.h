@@ -9,6 +9,7 @@
 #include "../vector3.h"
 #include "../Aabb.h"
 #include "../utils.h"
+#include "../Serializer.h"
 
 struct BVHNode {
 	Aabb aabb;
@@ -33,11 +34,17 @@ class BVHTree {
 public:
 	typedef int objPtr_t;
 	BVHTree(const int numObjs, const objPtr_t *objPtrs, const Aabb *objAabbs);
+	// a tree as built and written by Save, without building it again
+	BVHTree(Serializer::Reader &rd);
 	~BVHTree() {
 		delete [] m_objPtrAlloc;
 		delete [] m_bvhNodes;
 	}
 	BVHNode *GetRoot() { return m_root; }
+	size_t GetMemorySize() const {
+		return sizeof(BVHTree) + m_objPtrAllocMax * sizeof(objPtr_t) + m_nodeAllocMax * sizeof(BVHNode);
+	}
+	void Save(Serializer::Writer &wr) const;
 private:
 	void BuildNode(BVHNode *node,
 			const objPtr_t *objPtrs,
@@ -4,6 +4,8 @@
 #ifndef _COLLISION_CONTACT_H
 #define _COLLISION_CONTACT_H
 
+#include <functional>
+
 struct CollisionContact {
 	/* position and normal are in world (or rather, CollisionSpace) coordinates */
 	vector3d pos;
@@ -17,4 +19,8 @@ struct CollisionContact {
 	CollisionContact() : depth(0), dist(0), triIdx(-1), userData1(nullptr), userData2(nullptr), geomFlag(0) { /*empty*/ }
 };
 
+// called for each contact found. the contact is only valid for the duration
+// of the call, so copy it if you want to keep it
+typedef std::function<void(CollisionContact*)> CollisionCallback;
+
 #endif /* _COLLISION_CONTACT_H */
@@ -48,53 +48,108 @@ struct BvhNode {
 
 /*
  * Tree of objects in collision space (one tree for static objects, one for
- * dynamic)
+ * dynamic). the storage is kept between builds, and the dynamic tree is
+ * normally just refitted to the geoms' new positions rather than rebuilt
  */
 class BvhTree {
 public:
-	Geom **m_geoms;
+	std::vector<Geom*> m_geoms;
+	std::vector<BvhNode> m_nodes;
 	BvhNode *m_root;
-	BvhNode *m_nodesAlloc;
-	int m_nodesAllocPos;
-	int m_nodesAllocMax;
 
-	BvhNode *AllocNode() {
-		assert(m_nodesAllocPos < m_nodesAllocMax);
-		return &m_nodesAlloc[m_nodesAllocPos++];
-	}
+	BvhTree() : m_root(0), m_builtCost(0.0) {}
 
-	BvhTree(const std::list<Geom*> &geoms);
-	~BvhTree() {
-		if (m_geoms) delete [] m_geoms;
-		if (m_nodesAlloc) delete [] m_nodesAlloc;
-	}
-	void CollideGeom(Geom *, const Aabb &, int minMailboxValue, void (*callback)(CollisionContact*));
+	void Build(const std::list<Geom*> &geoms);
+	// recompute the node bounds bottom up from the geoms' current positions.
+	// returns false if the tree has got loose enough that it should be rebuilt
+	bool Refit();
+	void CollideGeom(Geom *, const Aabb &, int minMailboxValue, const CollisionCallback &callback);
 
 private:
+	BvhNode *AllocNode() {
+		// a node only splits if both sides get something, so there are never
+		// more than 2n-1 of them and this can't reallocate under BuildNode
+		assert(m_nodes.size() < m_nodes.capacity());
+		m_nodes.push_back(BvhNode());
+		return &m_nodes.back();
+	}
 	void BuildNode(BvhNode *node, const std::list<Geom*> &a_geoms, int &outGeomPos);
+	double GetCost() const;
+
+	// GetCost() when last built
+	double m_builtCost;
 };
 
-BvhTree::BvhTree(const std::list<Geom*> &geoms)
+static void GrowAabb(Aabb &aabb, const Geom *g)
+{
+	const vector3d p = g->GetPosition();
+	const double rad = g->GetGeomTree()->GetRadius();
+	aabb.Update(p + vector3d(rad,rad,rad));
+	aabb.Update(p - vector3d(rad,rad,rad));
+}
+
+static double AabbArea(const Aabb &aabb)
+{
+	const vector3d d = aabb.max - aabb.min;
+	return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+// rebuild once the summed node area is this much worse than when built
+static const double BVH_REBUILD_COST_RATIO = 2.0;
+
+void BvhTree::Build(const std::list<Geom*> &geoms)
 {
 	PROFILE_SCOPED()
-	m_geoms = 0;
-	m_nodesAlloc = 0;
-	int numGeoms = geoms.size();
-	if (numGeoms == 0) {
-		m_root = 0;
+	m_geoms.clear();
+	m_nodes.clear();
+	m_root = 0;
+	m_builtCost = 0.0;
+	const int numGeoms = geoms.size();
+	if (numGeoms == 0)
 		return;
-	}
-	m_geoms = new Geom*[numGeoms];
+	m_geoms.resize(numGeoms);
+	m_nodes.reserve(numGeoms*2);
 	int geomPos = 0;
-	m_nodesAllocPos = 0;
-	m_nodesAllocMax = numGeoms*2;
-	m_nodesAlloc = new BvhNode[m_nodesAllocMax];
 	m_root = AllocNode();
 	BuildNode(m_root, geoms, geomPos);
 	assert(geomPos == numGeoms);
+	m_builtCost = GetCost();
+}
+
+double BvhTree::GetCost() const
+{
+	double cost = 0.0;
+	for (const BvhNode &node : m_nodes)
+		cost += AabbArea(node.aabb);
+	return cost;
+}
+
+bool BvhTree::Refit()
+{
+	PROFILE_SCOPED()
+	if (!m_root) return true;
+
+	// kids are always allocated after their parent, so walking backwards
+	// visits every node after its kids
+	for (auto it = m_nodes.rbegin(); it != m_nodes.rend(); ++it) {
+		BvhNode &node = *it;
+		node.aabb.min = vector3d(FLT_MAX, FLT_MAX, FLT_MAX);
+		node.aabb.max = vector3d(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		if (node.geomStart) {
+			for (int i = 0; i < node.numGeoms; i++)
+				GrowAabb(node.aabb, node.geomStart[i]);
+		} else {
+			for (int k = 0; k < 2; k++) {
+				node.aabb.Update(node.kids[k]->aabb.min);
+				node.aabb.Update(node.kids[k]->aabb.max);
+			}
+		}
+	}
+
+	return GetCost() <= m_builtCost * BVH_REBUILD_COST_RATIO;
 }
 
-void BvhTree::CollideGeom(Geom *g, const Aabb &geomAabb, int minMailboxValue, void (*callback)(CollisionContact*))
+void BvhTree::CollideGeom(Geom *g, const Aabb &geomAabb, int minMailboxValue, const CollisionCallback &callback)
 {
 	PROFILE_SCOPED()
 	if (!m_root) return;
@@ -147,12 +202,8 @@ void BvhTree::BuildNode(BvhNode *node, const std::list<Geom*> &a_geoms, int &out
 	aabb.max = vector3d(-FLT_MAX, -FLT_MAX, -FLT_MAX);
 
 	for (std::list<Geom*>::const_iterator i = a_geoms.begin();
-			i != a_geoms.end(); ++i) {
-		vector3d p = (*i)->GetPosition();
-		double rad = (*i)->GetGeomTree()->GetRadius();
-		aabb.Update(p + vector3d(rad,rad,rad));
-		aabb.Update(p - vector3d(rad,rad,rad));
-	}
+			i != a_geoms.end(); ++i)
+		GrowAabb(aabb, *i);
 
 	// divide by longest axis
 	int axis;
@@ -205,27 +256,30 @@ CollisionSpace::CollisionSpace()
 	PROFILE_SCOPED()
 	sphere.radius = 0;
 	m_needStaticGeomRebuild = true;
-	m_staticObjectTree = 0;
-	m_dynamicObjectTree = 0;
+	m_needDynamicGeomRebuild = true;
+	m_staticObjectTree = new BvhTree();
+	m_dynamicObjectTree = new BvhTree();
 }
 
 CollisionSpace::~CollisionSpace()
 {
 	PROFILE_SCOPED()
-	if (m_staticObjectTree) delete m_staticObjectTree;
-	if (m_dynamicObjectTree) delete m_dynamicObjectTree;
+	delete m_staticObjectTree;
+	delete m_dynamicObjectTree;
 }
 
 void CollisionSpace::AddGeom(Geom *geom)
 {
 	PROFILE_SCOPED()
 	m_geoms.push_back(geom);
+	m_needDynamicGeomRebuild = true;
 }
 
 void CollisionSpace::RemoveGeom(Geom *geom)
 {
 	PROFILE_SCOPED()
 	m_geoms.remove(geom);
+	m_needDynamicGeomRebuild = true;
 }
 
 void CollisionSpace::AddStaticGeom(Geom *geom)
@@ -273,11 +327,39 @@ void CollisionSpace::CollideRaySphere(const vector3d &start, const vector3d &dir
 	}
 }
 
-void CollisionSpace::TraceRay(const vector3d &start, const vector3d &dir, double len, CollisionContact *c, Geom *ignore)
+// trace one ray against one geom, updating the contact if it hits closer
+// than anything so far
+static void TraceGeomRay(Geom *g, const vector3d &start, const vector3d &dir, double len, CollisionContact *c)
+{
+	const matrix4x4d &invTrans = g->GetInvTransform();
+	vector3d ms = invTrans * start;
+	vector3d md = invTrans.ApplyRotationOnly(dir);
+	vector3f modelStart = vector3f(ms.x, ms.y, ms.z);
+	vector3f modelDir = vector3f(md.x, md.y, md.z);
+
+	isect_t isect;
+	isect.dist = float(c->dist);
+	isect.triIdx = -1;
+	g->GetGeomTree()->TraceRay(modelStart, modelDir, &isect);
+	if (isect.triIdx != -1) {
+		c->pos = start + dir*double(isect.dist);
+
+		vector3f n = g->GetGeomTree()->GetTriNormal(isect.triIdx);
+		c->normal = vector3d(n.x, n.y, n.z);
+		c->normal = g->GetTransform().ApplyRotationOnly(c->normal);
+
+		c->depth = len - isect.dist;
+		c->triIdx = isect.triIdx;
+		c->userData1 = g->GetUserData();
+		c->userData2 = 0;
+		c->geomFlag = g->GetGeomTree()->GetTriFlag(isect.triIdx);
+		c->dist = isect.dist;
+	}
+}
+
+void CollisionSpace::TraceStaticRay(const vector3d &start, const vector3d &dir, double len, CollisionContact *c)
 {
-	PROFILE_SCOPED()
 	vector3d invDir(1.0/dir.x, 1.0/dir.y, 1.0/dir.z);
-	c->dist = len;
 
 	BvhNode *vn_stack[16];
 	BvhNode *node = m_staticObjectTree->m_root;
@@ -295,34 +377,8 @@ void CollisionSpace::TraceRay(const vector3d &start, const vector3d &dir, double
 		if (node->geomStart) {
 			// it is a leaf node
 			// collide with all geoms
-			for (int i=0; i<node->numGeoms; i++) {
-				Geom *g = node->geomStart[i];
-
-				const matrix4x4d &invTrans = g->GetInvTransform();
-				vector3d ms = invTrans * start;
-				vector3d md = invTrans.ApplyRotationOnly(dir);
-				vector3f modelStart = vector3f(ms.x, ms.y, ms.z);
-				vector3f modelDir = vector3f(md.x, md.y, md.z);
-
-				isect_t isect;
-				isect.dist = float(c->dist);
-				isect.triIdx = -1;
-				g->GetGeomTree()->TraceRay(modelStart, modelDir, &isect);
-				if (isect.triIdx != -1) {
-					c->pos = start + dir*double(isect.dist);
-
-					vector3f n = g->GetGeomTree()->GetTriNormal(isect.triIdx);
-					c->normal = vector3d(n.x, n.y, n.z);
-					c->normal = g->GetTransform().ApplyRotationOnly(c->normal);
-
-					c->depth = len - isect.dist;
-					c->triIdx = isect.triIdx;
-					c->userData1 = g->GetUserData();
-					c->userData2 = 0;
-					c->geomFlag = g->GetGeomTree()->GetTriFlag(isect.triIdx);
-					c->dist = isect.dist;
-				}
-			}
+			for (int i=0; i<node->numGeoms; i++)
+				TraceGeomRay(node->geomStart[i], start, dir, len, c);
 		} else if (node->kids[0]) {
 			vn_stack[++stackPos] = node->kids[0];
 			node = node->kids[1];
@@ -332,57 +388,74 @@ pop_jizz:
 		if (stackPos < 0) break;
 		node = vn_stack[stackPos--];
 	}
+}
+
+void CollisionSpace::TraceSphereRay(const vector3d &start, const vector3d &dir, double len, CollisionContact *c)
+{
+	isect_t isect;
+	isect.dist = float(c->dist);
+	isect.triIdx = -1;
+	CollideRaySphere(start, dir, &isect);
+	if (isect.triIdx != -1) {
+		c->pos = start + dir*double(isect.dist);
+		c->normal = vector3d(0.0);
+		c->depth = len - isect.dist;
+		c->triIdx = -1;
+		c->userData1 = sphere.userData;
+		c->userData2 = 0;
+		c->geomFlag = 0;
+	}
+}
+
+void CollisionSpace::TraceRay(const vector3d &start, const vector3d &dir, double len, CollisionContact *c, Geom *ignore)
+{
+	PROFILE_SCOPED()
+	c->dist = len;
+
+	TraceStaticRay(start, dir, len, c);
 
 	for (std::list<Geom*>::iterator i = m_geoms.begin(); i != m_geoms.end(); ++i) {
 		if ((*i) == ignore) continue;
-		if ((*i)->IsEnabled()) {
-			const matrix4x4d &invTrans = (*i)->GetInvTransform();
-			vector3d ms = invTrans * start;
-			vector3d md = invTrans.ApplyRotationOnly(dir);
-			vector3f modelStart = vector3f(ms.x, ms.y, ms.z);
-			vector3f modelDir = vector3f(md.x, md.y, md.z);
+		if ((*i)->IsEnabled())
+			TraceGeomRay(*i, start, dir, len, c);
+	}
 
-			isect_t isect;
-			isect.dist = float(c->dist);
-			isect.triIdx = -1;
-			(*i)->GetGeomTree()->TraceRay(modelStart, modelDir, &isect);
-			if (isect.triIdx != -1) {
-				c->pos = start + dir*double(isect.dist);
-
-				vector3f n = (*i)->GetGeomTree()->GetTriNormal(isect.triIdx);
-				c->normal = vector3d(n.x, n.y, n.z);
-				c->normal = (*i)->GetTransform().ApplyRotationOnly(c->normal);
-
-				c->depth = len - isect.dist;
-				c->triIdx = isect.triIdx;
-				c->userData1 = (*i)->GetUserData();
-				c->userData2 = 0;
-				c->geomFlag = (*i)->GetGeomTree()->GetTriFlag(isect.triIdx);
-				c->dist = isect.dist;
-			}
-		}
+	TraceSphereRay(start, dir, len, c);
+}
+
+void CollisionSpace::TraceSegments(const vector3d *starts, const vector3d *dirs, const double *lens, int numRays, CollisionContact *contacts)
+{
+	PROFILE_SCOPED()
+	if (numRays <= 0) return;
+
+	for (int i = 0; i < numRays; i++) {
+		contacts[i].dist = lens[i];
+		TraceStaticRay(starts[i], dirs[i], lens[i], &contacts[i]);
 	}
-	{
-		isect_t isect;
-		isect.dist = float(c->dist);
-		isect.triIdx = -1;
-		CollideRaySphere(start, dir, &isect);
-		if (isect.triIdx != -1) {
-			c->pos = start + dir*double(isect.dist);
-			c->normal = vector3d(0.0);
-			c->depth = len - isect.dist;
-			c->triIdx = -1;
-			c->userData1 = sphere.userData;
-			c->userData2 = 0;
-			c->geomFlag = 0;
+
+	// each moving geom is bounded once for the whole batch, and only traced
+	// by the segments that come within its radius
+	for (Geom *g : m_geoms) {
+		if (!g->IsEnabled()) continue;
+		const vector3d centre = g->GetPosition();
+		const double radius = g->GetGeomTree()->GetRadius();
+		const double radiusSqr = radius*radius;
+		for (int i = 0; i < numRays; i++) {
+			const vector3d v = centre - starts[i];
+			const double t = Clamp(v.Dot(dirs[i]), 0.0, contacts[i].dist);
+			if ((v - dirs[i]*t).LengthSqr() > radiusSqr) continue;
+			TraceGeomRay(g, starts[i], dirs[i], lens[i], &contacts[i]);
 		}
 	}
+
+	for (int i = 0; i < numRays; i++)
+		TraceSphereRay(starts[i], dirs[i], lens[i], &contacts[i]);
 }
 
 /*
  * Do not collide objects with mailbox value < minMailboxValue
  */
-void CollisionSpace::CollideGeoms(Geom *a, int minMailboxValue, void (*callback)(CollisionContact*))
+void CollisionSpace::CollideGeoms(Geom *a, int minMailboxValue, const CollisionCallback &callback)
 {
 	PROFILE_SCOPED()
 	if (!a->IsEnabled()) return;
@@ -393,8 +466,8 @@ void CollisionSpace::CollideGeoms(Geom *a, int minMailboxValue, void (*callback)
 	ourAabb.min = pos - vector3d(radius, radius, radius);
 	ourAabb.max = pos + vector3d(radius, radius, radius);
 
-	if (m_staticObjectTree) m_staticObjectTree->CollideGeom(a, ourAabb, 0, callback);
-	if (m_dynamicObjectTree) m_dynamicObjectTree->CollideGeom(a, ourAabb, minMailboxValue, callback);
+	m_staticObjectTree->CollideGeom(a, ourAabb, 0, callback);
+	m_dynamicObjectTree->CollideGeom(a, ourAabb, minMailboxValue, callback);
 
 	/* test the fucker against the planet sphere thing */
 	if (sphere.radius > 0.0) {
@@ -406,17 +479,19 @@ void CollisionSpace::CollideGeoms(Geom *a, int minMailboxValue, void (*callback)
 void CollisionSpace::RebuildObjectTrees()
 {
 	PROFILE_SCOPED()
-	if (m_needStaticGeomRebuild) {
-		if (m_staticObjectTree) delete m_staticObjectTree;
-		m_staticObjectTree = new BvhTree(m_staticGeoms);
-	}
-	if (m_dynamicObjectTree) delete m_dynamicObjectTree;
-	m_dynamicObjectTree = new BvhTree(m_geoms);
+	if (m_needStaticGeomRebuild)
+		m_staticObjectTree->Build(m_staticGeoms);
+
+	// the dynamic geoms move every step, but their tree only needs
+	// rebuilding when the set changes or the refitted bounds get too loose
+	if (m_needDynamicGeomRebuild || !m_dynamicObjectTree->Refit())
+		m_dynamicObjectTree->Build(m_geoms);
 
 	m_needStaticGeomRebuild = false;
+	m_needDynamicGeomRebuild = false;
 }
 
-void CollisionSpace::Collide(void (*callback)(CollisionContact*))
+void CollisionSpace::Collide(const CollisionCallback &callback)
 {
 	PROFILE_SCOPED()
 	RebuildObjectTrees();
@@ -6,10 +6,10 @@
 
 #include <list>
 #include "../vector3.h"
+#include "CollisionContact.h"
 
 class Geom;
 struct isect_t;
-struct CollisionContact;
 
 struct Sphere {
 	vector3d pos;
@@ -31,11 +31,15 @@ public:
 	void AddStaticGeom(Geom*);
 	void RemoveStaticGeom(Geom*);
 	void TraceRay(const vector3d &start, const vector3d &dir, double len, CollisionContact *c, Geom *ignore = 0);
-	void Collide(void (*callback)(CollisionContact*));
+	// as TraceRay, for numRays unrelated rays (eg. projectiles), each with
+	// its own start and length. moving geoms are only traced by the rays
+	// that pass close to them. contacts has one entry per ray
+	void TraceSegments(const vector3d *starts, const vector3d *dirs, const double *lens, int numRays, CollisionContact *contacts);
+	void Collide(const CollisionCallback &callback);
 	void SetSphere(const vector3d &pos, double radius, void *user_data) {
 		sphere.pos = pos; sphere.radius = radius; sphere.userData = user_data;
 	}
-	void FlagRebuildObjectTrees() { m_needStaticGeomRebuild = true; }
+	void FlagRebuildObjectTrees() { m_needStaticGeomRebuild = m_needDynamicGeomRebuild = true; }
 	void RebuildObjectTrees();
 
 	// Geoms with the same handle will not be collision tested against each other
@@ -44,11 +48,14 @@ public:
 	// zero means ungrouped. assumes that wraparound => no old crap left
 	static int GetGroupHandle() { if(!s_nextHandle) s_nextHandle++; return s_nextHandle++; }
 private:
-	void CollideGeoms(Geom *a, int minMailboxValue, void (*callback)(CollisionContact*));
+	void CollideGeoms(Geom *a, int minMailboxValue, const CollisionCallback &callback);
 	void CollideRaySphere(const vector3d &start, const vector3d &dir, isect_t *isect);
+	void TraceStaticRay(const vector3d &start, const vector3d &dir, double len, CollisionContact *c);
+	void TraceSphereRay(const vector3d &start, const vector3d &dir, double len, CollisionContact *c);
 	std::list<Geom*> m_geoms;
 	std::list<Geom*> m_staticGeoms;
 	bool m_needStaticGeomRebuild;
+	bool m_needDynamicGeomRebuild;
 	BvhTree *m_staticObjectTree;
 	BvhTree *m_dynamicObjectTree;
 	Sphere sphere;
@@ -53,7 +53,7 @@ vector3d Geom::GetPosition() const
 		m_orient[14]);
 }
 
-void Geom::CollideSphere(Sphere &sphere, void (*callback)(CollisionContact*))
+void Geom::CollideSphere(Sphere &sphere, const CollisionCallback &callback)
 {
 	PROFILE_SCOPED()
 	/* if the geom is actually within the sphere, create a contact so
@@ -78,7 +78,7 @@ void Geom::CollideSphere(Sphere &sphere, void (*callback)(CollisionContact*))
  * This geom has moved, causing a possible collision with geom b.
  * Collide meshes to see.
  */
-void Geom::Collide(Geom *b, void (*callback)(CollisionContact*))
+void Geom::Collide(Geom *b, const CollisionCallback &callback)
 {
 	PROFILE_SCOPED()
 	int max_contacts = MAX_CONTACTS;
@@ -102,15 +102,13 @@ void Geom::Collide(Geom *b, void (*callback)(CollisionContact*))
 static bool rotatedAabbIsectsNormalOne(Aabb &a, const matrix4x4d &transA, Aabb &b)
 {
 	Aabb arot;
-	vector3d p[8];
-	p[0] = transA * vector3d(a.min.x, a.min.y, a.min.z);
-	p[1] = transA * vector3d(a.min.x, a.min.y, a.max.z);
-	p[2] = transA * vector3d(a.min.x, a.max.y, a.min.z);
-	p[3] = transA * vector3d(a.min.x, a.max.y, a.max.z);
-	p[4] = transA * vector3d(a.max.x, a.min.y, a.min.z);
-	p[5] = transA * vector3d(a.max.x, a.min.y, a.max.z);
-	p[6] = transA * vector3d(a.max.x, a.max.y, a.min.z);
-	p[7] = transA * vector3d(a.max.x, a.max.y, a.max.z);
+	vector3d p[8] = {
+		vector3d(a.min.x, a.min.y, a.min.z), vector3d(a.min.x, a.min.y, a.max.z),
+		vector3d(a.min.x, a.max.y, a.min.z), vector3d(a.min.x, a.max.y, a.max.z),
+		vector3d(a.max.x, a.min.y, a.min.z), vector3d(a.max.x, a.min.y, a.max.z),
+		vector3d(a.max.x, a.max.y, a.min.z), vector3d(a.max.x, a.max.y, a.max.z)
+	};
+	transA.TransformPoints(p, p, 8);
 	arot.min = arot.max = p[0];
 	for (int i=1; i<8; i++) arot.Update(p[i]);
 	return b.Intersects(arot);
@@ -120,7 +118,7 @@ static bool rotatedAabbIsectsNormalOne(Aabb &a, const matrix4x4d &transA, Aabb &
  * Intersect this Geom's edge BVH tree with geom b's triangle BVH tree.
  * Generate collision contacts.
  */
-void Geom::CollideEdgesWithTrisOf(int &maxContacts, Geom *b, const matrix4x4d &transTo, void (*callback)(CollisionContact*))
+void Geom::CollideEdgesWithTrisOf(int &maxContacts, Geom *b, const matrix4x4d &transTo, const CollisionCallback &callback)
 {
 	PROFILE_SCOPED()
 	struct stackobj {
@@ -182,7 +180,7 @@ void Geom::CollideEdgesWithTrisOf(int &maxContacts, Geom *b, const matrix4x4d &t
  * BVH of another geom (b), starting from btriNode.
  */
 void Geom::CollideEdgesTris(int &maxContacts, const BVHNode *edgeNode, const matrix4x4d &transToB,
-		Geom *b, const BVHNode *btriNode, void (*callback)(CollisionContact*))
+		Geom *b, const BVHNode *btriNode, const CollisionCallback &callback)
 {
 	PROFILE_SCOPED()
 	if (maxContacts <= 0) return;
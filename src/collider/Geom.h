@@ -25,9 +25,9 @@ public:
 	void Enable() { m_active = true; }
 	void Disable() { m_active = false; }
 	bool IsEnabled() { return m_active; }
-	const GeomTree *GetGeomTree() { return m_geomtree; }
-	void Collide(Geom *b, void (*callback)(CollisionContact*));
-	void CollideSphere(Sphere &sphere, void (*callback)(CollisionContact*));
+	const GeomTree *GetGeomTree() const { return m_geomtree; }
+	void Collide(Geom *b, const CollisionCallback &callback);
+	void CollideSphere(Sphere &sphere, const CollisionCallback &callback);
 	void SetUserData(void *d) { m_data = d; }
 	void *GetUserData() { return m_data; }
 	void SetMailboxIndex(int idx) { m_mailboxIndex = idx; }
@@ -38,11 +38,11 @@ public:
 	matrix4x4d m_animTransform;
 
 private:
-	void CollideEdgesWithTrisOf(int &maxContacts, Geom *b, const matrix4x4d &transTo, void (*callback)(CollisionContact*));
+	void CollideEdgesWithTrisOf(int &maxContacts, Geom *b, const matrix4x4d &transTo, const CollisionCallback &callback);
 	void CollideEdgesTris(int &maxContacts, const BVHNode *edgeNode, const matrix4x4d &transToB,
-		Geom *b, const BVHNode *btriNode, void (*callback)(CollisionContact*));
+		Geom *b, const BVHNode *btriNode, const CollisionCallback &callback);
 	int m_mailboxIndex; // used to avoid duplicate collisions
-	void CollideEdges(const matrix4x4d &transToB, Geom *b, void (*callback)(CollisionContact*));
+	void CollideEdges(const matrix4x4d &transToB, Geom *b, const CollisionCallback &callback);
 	// double-buffer position so we can keep previous position
 	matrix4x4d m_orient, m_invOrient;
 	bool m_active;
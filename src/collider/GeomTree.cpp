@@ -8,10 +8,25 @@
 
 static const unsigned int IGNORE_FLAG = 0x8000;
 
+const int GeomTree::RAY_PACKET_SIZE;
+
 GeomTree::~GeomTree()
 {
 }
 
+size_t GeomTree::GetMemorySize() const
+{
+	size_t size = sizeof(GeomTree);
+	size += m_aabbs.capacity() * sizeof(Aabb);
+	size += m_edges.capacity() * sizeof(Edge);
+	size += m_vertices.capacity() * sizeof(vector3f);
+	size += m_indices.capacity() * sizeof(Uint16);
+	size += m_triFlags.capacity() * sizeof(unsigned int);
+	if (m_triTree) size += m_triTree->GetMemorySize();
+	if (m_edgeTree) size += m_edgeTree->GetMemorySize();
+	return size;
+}
+
 GeomTree::GeomTree(const int numVerts, const int numTris, const std::vector<vector3f> &vertices, const Uint16 *indices, const unsigned int *triflags)
 : m_numVertices(numVerts)
 , m_numTris(numTris)
@@ -35,16 +50,6 @@ GeomTree::GeomTree(const int numVerts, const int numTris, const std::vector<vect
 	m_aabb.min = vector3d(FLT_MAX,FLT_MAX,FLT_MAX);
 	m_aabb.max = vector3d(-FLT_MAX,-FLT_MAX,-FLT_MAX);
 
-	// activeTris = tris we are still trying to put into leaves
-	std::vector<int> activeTris;
-	activeTris.reserve(numTris);
-	// So, we ignore tris with flag >= 0x8000
-	for (int i=0; i<numTris; i++) 
-	{
-		if (triflags[i] >= IGNORE_FLAG) continue;
-		activeTris.push_back(i*3);
-	}
-
 	typedef std::map< std::pair<int,int>, int > EdgeType;
 	EdgeType edges;
 #define ADD_EDGE(_i1,_i2,_triflag) \
@@ -101,30 +106,10 @@ GeomTree::GeomTree(const int numVerts, const int numTris, const std::vector<vect
 	}
 	m_radius = sqrt(m_radius);
 
-	{
-		Aabb *aabbs = new Aabb[activeTris.size()];
-		for (unsigned int i = 0; i < activeTris.size(); i++)
-		{
-			const vector3d v1 = vector3d(m_vertices[m_indices[activeTris[i] + 0]]);
-			const vector3d v2 = vector3d(m_vertices[m_indices[activeTris[i] + 1]]);
-			const vector3d v3 = vector3d(m_vertices[m_indices[activeTris[i] + 2]]);
-			aabbs[i].min = aabbs[i].max = v1;
-			aabbs[i].Update(v2);
-			aabbs[i].Update(v3);
-		}
-
-		//int t = SDL_GetTicks();
-		m_triTree.reset(new BVHTree(activeTris.size(), &activeTris[0], aabbs));
-		delete[] aabbs;
-	}
-	//Output("Tri tree of %d tris build in %dms\n", activeTris.size(), SDL_GetTicks() - t);
-
 	m_numEdges = edges.size();
 	m_edges.resize( m_numEdges );
 	// to build Edge bvh tree with.
 	m_aabbs.resize( m_numEdges );
-	int *edgeIdxs = new int[m_numEdges];
-
 	int pos = 0;
 	typedef EdgeType::iterator MapPairIter;
 	for (MapPairIter i = edges.begin(), iEnd = edges.end();	i != iEnd; ++i, pos++) 
@@ -144,15 +129,11 @@ GeomTree::GeomTree(const int numVerts, const int numTris, const std::vector<vect
 		m_edges[pos].len = len;
 		m_edges[pos].dir = dir;
 
-		edgeIdxs[pos] = pos;
 		m_aabbs[pos].min = m_aabbs[pos].max = vector3d(v1);
 		m_aabbs[pos].Update(vector3d(v2));
 	}
 
-	//t = SDL_GetTicks();
-	m_edgeTree.reset(new BVHTree(m_numEdges, edgeIdxs, &m_aabbs[0]));
-	delete [] edgeIdxs;
-	//Output("Edge tree of %d edges build in %dms\n", m_numEdges, SDL_GetTicks() - t);
+	// the trees are left until the first collision query
 
 	timer.Stop();
 	//Output(" - - GeomTree::GeomTree took: %lf milliseconds\n", timer.millicycles());
@@ -198,6 +179,28 @@ GeomTree::GeomTree(Serializer::Reader &rd)
 		m_triFlags[iTri] = rd.Int32();
 	}
 
+	m_triTree.reset(new BVHTree(rd));
+	m_edgeTree.reset(new BVHTree(rd));
+}
+
+BVHTree *GeomTree::GetTriTree() const
+{
+	std::call_once(m_treesBuilt, &GeomTree::BuildTrees, this);
+	return m_triTree.get();
+}
+
+BVHTree *GeomTree::GetEdgeTree() const
+{
+	std::call_once(m_treesBuilt, &GeomTree::BuildTrees, this);
+	return m_edgeTree.get();
+}
+
+void GeomTree::BuildTrees() const
+{
+	PROFILE_SCOPED()
+	if (m_triTree && m_edgeTree)
+		return; //loaded
+
 	// activeTris = tris we are still trying to put into leaves
 	std::vector<int> activeTris;
 	activeTris.reserve(m_numTris);
@@ -207,7 +210,6 @@ GeomTree::GeomTree(Serializer::Reader &rd)
 		if (m_triFlags[i] >= IGNORE_FLAG) continue;
 		activeTris.push_back(i * 3);
 	}
-	// regenerate the aabb data
 	Aabb *aabbs = new Aabb[activeTris.size()];
 	for (unsigned int i = 0; i<activeTris.size(); i++)
 	{
@@ -221,13 +223,12 @@ GeomTree::GeomTree(Serializer::Reader &rd)
 	m_triTree.reset(new BVHTree(activeTris.size(), &activeTris[0], aabbs));
 	delete[] aabbs;
 
-	// 
 	int *edgeIdxs = new int[m_numEdges];
-	memset(edgeIdxs, 0, sizeof(int)*m_numEdges);
 	for (int i = 0; i<m_numEdges; i++) {
 		edgeIdxs[i] = i;
 	}
 	m_edgeTree.reset(new BVHTree(m_numEdges, edgeIdxs, &m_aabbs[0]));
+	delete[] edgeIdxs;
 }
 
 static bool SlabsRayAabbTest(const BVHNode *n, const vector3f &start, const vector3f &invDir, isect_t *isect)
@@ -253,7 +254,7 @@ static bool SlabsRayAabbTest(const BVHNode *n, const vector3f &start, const vect
 
 void GeomTree::TraceRay(const vector3f &start, const vector3f &dir, isect_t *isect) const
 {
-	TraceRay(m_triTree->GetRoot(), start, dir, isect);
+	TraceRay(GetTriTree()->GetRoot(), start, dir, isect);
 }
 
 void GeomTree::TraceRay(const BVHNode *currnode, const vector3f &a_origin, const vector3f &a_dir, isect_t *isect) const
@@ -282,55 +283,92 @@ pop_bstack:
 }
 
 struct bvhstack {
-	BVHNode *node;
-	int activeRay;
+	const BVHNode *node;
+	Uint32 activeRays;
 };
 
+// slab test of every ray in a packet against one node. the rays share an
+// origin, so only the inverse directions differ. written as a flat loop
+// over the packet so the compiler can vectorise it. returns a mask of the
+// rays that hit
+static Uint32 SlabsRayPacketAabbTest(const BVHNode *n, const vector3f &start, int numRays,
+	const float *invDirX, const float *invDirY, const float *invDirZ, const float *dists)
+{
+	const float minx = float(n->aabb.min.x) - start.x, maxx = float(n->aabb.max.x) - start.x;
+	const float miny = float(n->aabb.min.y) - start.y, maxy = float(n->aabb.max.y) - start.y;
+	const float minz = float(n->aabb.min.z) - start.z, maxz = float(n->aabb.max.z) - start.z;
+
+	Uint32 hits = 0;
+	for (int i=0; i<numRays; i++) {
+		float l1 = minx * invDirX[i], l2 = maxx * invDirX[i];
+		float lmin = std::min(l1,l2), lmax = std::max(l1,l2);
+
+		l1 = miny * invDirY[i]; l2 = maxy * invDirY[i];
+		lmin = std::max(std::min(l1,l2), lmin);
+		lmax = std::min(std::max(l1,l2), lmax);
+
+		l1 = minz * invDirZ[i]; l2 = maxz * invDirZ[i];
+		lmin = std::max(std::min(l1,l2), lmin);
+		lmax = std::min(std::max(l1,l2), lmax);
+
+		hits |= Uint32((lmax >= 0.f) & (lmax >= lmin) & (lmin < dists[i])) << i;
+	}
+	return hits;
+}
+
 /*
  * Bundle of rays with common origin
  */
-/*void GeomTree::TraceCoherentRays(int numRays, const vector3f &a_origin, const vector3f *a_dirs, isect_t *isects) const
+void GeomTree::TraceCoherentRays(int numRays, const vector3f &a_origin, const vector3f *a_dirs, isect_t *isects) const
 {
 	PROFILE_SCOPED()
-	TraceCoherentRays(m_triTree->GetRoot(), numRays, a_origin, a_dirs, isects);
+	for (int i=0; i<numRays; i+=RAY_PACKET_SIZE)
+		TraceCoherentRays(GetTriTree()->GetRoot(), std::min(numRays - i, RAY_PACKET_SIZE), a_origin, &a_dirs[i], &isects[i]);
 }
 
 void GeomTree::TraceCoherentRays(const BVHNode *currnode, int numRays, const vector3f &a_origin, const vector3f *a_dirs, isect_t *isects) const
 {
-	PROFILE_SCOPED()
-	bvhstack stack[32];
-	int stackpos = -1;
-	vector3f *invDirs = static_cast<vector3f*>(alloca(sizeof(vector3f)*numRays));
+	assert(numRays > 0 && numRays <= RAY_PACKET_SIZE);
+
+	// split into components so the slab tests can run across the packet
+	float invDirX[RAY_PACKET_SIZE], invDirY[RAY_PACKET_SIZE], invDirZ[RAY_PACKET_SIZE];
+	float dists[RAY_PACKET_SIZE];
 	for (int i=0; i<numRays; i++) {
-		invDirs[i] = vector3f(1.0f/a_dirs[i].x, 1.0f/a_dirs[i].y, 1.0f/a_dirs[i].z);
+		invDirX[i] = 1.0f/a_dirs[i].x;
+		invDirY[i] = 1.0f/a_dirs[i].y;
+		invDirZ[i] = 1.0f/a_dirs[i].z;
 	}
-	int activeRay = numRays - 1;
+
+	bvhstack stack[32];
+	int stackpos = -1;
+	Uint32 activeRays = (1u << numRays) - 1;
 
 	for (;;) {
 		while (!currnode->IsLeaf()) {
-			do {
-				if (SlabsRayAabbTest(currnode, a_origin, invDirs[activeRay], &isects[activeRay])) break;
-			} while (activeRay-- > 0);
-			if (activeRay < 0) goto pop_bstack;
+			// hits can shorten the rays, so the distances can't be cached
+			for (int i=0; i<numRays; i++)
+				dists[i] = isects[i].dist;
+			activeRays &= SlabsRayPacketAabbTest(currnode, a_origin, numRays, invDirX, invDirY, invDirZ, dists);
+			if (!activeRays) goto pop_bstack;
 
 			stackpos++;
 			stack[stackpos].node = currnode->kids[1];
-			stack[stackpos].activeRay = activeRay;
+			stack[stackpos].activeRays = activeRays;
 			currnode = currnode->kids[0];
 		}
 		// triangle intersection jizz
 		for (int i=0; i<currnode->numTris; i++) {
-			RayTriIntersect(activeRay+1, a_origin, a_dirs, currnode->triIndicesStart[i], isects);
+			RayTriIntersect(numRays, a_origin, a_dirs, currnode->triIndicesStart[i], isects, activeRays);
 		}
 pop_bstack:
 		if (stackpos < 0) break;
 		currnode = stack[stackpos].node;
-		activeRay = stack[stackpos].activeRay;
+		activeRays = stack[stackpos].activeRays;
 		stackpos--;
 	}
-}*/
+}
 
-void GeomTree::RayTriIntersect(int numRays, const vector3f &origin, const vector3f *dirs, int triIdx, isect_t *isects) const
+void GeomTree::RayTriIntersect(int numRays, const vector3f &origin, const vector3f *dirs, int triIdx, isect_t *isects, Uint32 activeRays) const
 {
 	const vector3f a(m_vertices[m_indices[triIdx+0]]);
 	const vector3f b(m_vertices[m_indices[triIdx+1]]);
@@ -345,6 +383,7 @@ void GeomTree::RayTriIntersect(int numRays, const vector3f &origin, const vector
 	v2_cross = (a-origin).Cross(c-origin);
 
 	for (int i=0; i<numRays; i++) {
+		if (!(activeRays & (1u << i))) continue;
 		const float v0d = v0_cross.Dot(dirs[i]);
 		const float v1d = v1_cross.Dot(dirs[i]);
 		const float v2d = v2_cross.Dot(dirs[i]);
@@ -371,6 +410,8 @@ vector3f GeomTree::GetTriNormal(int triIdx) const
 
 void GeomTree::Save(Serializer::Writer &wr) const
 {
+	// everything but the BVH trees
+	wr.Reserve(m_numEdges * (7*8 + 7*4) + m_numVertices * 3*4 + m_numTris * (3*2 + 4));
 	wr.Int32(m_numVertices);
 	wr.Int32(m_numEdges);
 	wr.Int32(m_numTris);
@@ -402,4 +443,7 @@ void GeomTree::Save(Serializer::Writer &wr) const
 	for (Sint32 iTri = 0; iTri < m_numTris; ++iTri) {
 		wr.Int32(m_triFlags[iTri]);
 	}
+
+	GetTriTree()->Save(wr);
+	GetEdgeTree()->Save(wr);
 }
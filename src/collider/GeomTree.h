@@ -7,6 +7,7 @@
 #include "libs.h"
 #include "CollisionContact.h"
 #include "Serializer.h"
+#include <mutex>
 
 struct isect_t {
 	// triIdx = -1 if no intersection
@@ -27,11 +28,15 @@ public:
 	// dir should be unit length,
 	// isect.dist should be ray length
 	// isect.triIdx should be -1 unless repeat calls with same isect_t
-	void CollideEdgesWithTrisOf(const GeomTree *other, const matrix4x4d &transTo, void (*callback)(CollisionContact*)) const;
+	void CollideEdgesWithTrisOf(const GeomTree *other, const matrix4x4d &transTo, const CollisionCallback &callback) const;
 	void TraceRay(const vector3f &start, const vector3f &dir, isect_t *isect) const;
 	void TraceRay(const BVHNode *startNode, const vector3f &a_origin, const vector3f &a_dir, isect_t *isect) const;
-	//void TraceCoherentRays(int numRays, const vector3f &a_origin, const vector3f *a_dirs, isect_t *isects) const;
-	//void TraceCoherentRays(const BVHNode *startNode, int numRays, const vector3f &a_origin, const vector3f *a_dirs, isect_t *isects) const;
+	// as TraceRay, for a bundle of rays from a common origin. they're traced
+	// through the tree together in packets of RAY_PACKET_SIZE, so rays that
+	// head roughly the same way share most of the work
+	static const int RAY_PACKET_SIZE = 8;
+	void TraceCoherentRays(int numRays, const vector3f &a_origin, const vector3f *a_dirs, isect_t *isects) const;
+	void TraceCoherentRays(const BVHNode *startNode, int numRays, const vector3f &a_origin, const vector3f *a_dirs, isect_t *isects) const;
 	vector3f GetTriNormal(int triIdx) const;
 	unsigned int GetTriFlag(int triIdx) const { return m_triFlags[triIdx]; }
 	double GetRadius() const { return m_radius; }
@@ -63,19 +68,25 @@ public:
 	const Edge *GetEdges() const { return &m_edges[0]; }
 	int GetNumEdges() const { return m_numEdges; }
 
-	BVHTree* GetTriTree() const { return m_triTree.get(); }
-	BVHTree* GetEdgeTree() const { return m_edgeTree.get(); }
+	// built on first use unless they were loaded. Safe to call from the
+	// collision threads
+	BVHTree* GetTriTree() const;
+	BVHTree* GetEdgeTree() const;
 
 	const std::vector<vector3f>& GetVertices() const { return m_vertices; }
 	const Uint16 *GetIndices() const { return &m_indices[0]; }
 	const unsigned int *GetTriFlags() const { return &m_triFlags[0]; }
 	int GetNumVertices() const { return m_numVertices; }
 	int GetNumTris() const { return m_numTris; }
+	// bytes held by the tree, including both BVHs
+	size_t GetMemorySize() const;
 
 	void Save(Serializer::Writer &wr) const;
 
 private:
-	void RayTriIntersect(int numRays, const vector3f &origin, const vector3f *dirs, int triIdx, isect_t *isects) const;
+	// only the rays with their bit set in activeRays are tested
+	void RayTriIntersect(int numRays, const vector3f &origin, const vector3f *dirs, int triIdx, isect_t *isects, Uint32 activeRays = ~0u) const;
+	void BuildTrees() const;
 
 	int m_numVertices;
 	int m_numEdges;
@@ -85,8 +96,9 @@ private:
 	Aabb m_aabb;
 	std::vector<Aabb> m_aabbs;
 
-	std::unique_ptr<BVHTree> m_triTree;
-	std::unique_ptr<BVHTree> m_edgeTree;
+	mutable std::once_flag m_treesBuilt;
+	mutable std::unique_ptr<BVHTree> m_triTree;
+	mutable std::unique_ptr<BVHTree> m_edgeTree;
 
 	std::vector<Edge> m_edges;
 
@@ -13,11 +13,24 @@
 #include "Polit.h"
 #include "Factions.h"
 #include "FileSystem.h"
+#include "Serializer.h"
+#include "jenkins/lookup3.h"
 #include <map>
 
 const CustomSystemsDatabase::SystemList CustomSystemsDatabase::s_emptySystemList; // see: Null Object pattern
 
-static CustomSystemsDatabase* s_activeCustomSystemsDatabase = nullptr;
+// the database the systems are going to. kept in the registry of each state
+// rather than in a global, as sectors can be loaded on any thread
+static const char s_databaseKey[] = "CustomSystemsDatabase";
+
+static CustomSystemsDatabase *GetDatabase(lua_State *L)
+{
+	lua_getfield(L, LUA_REGISTRYINDEX, s_databaseKey);
+	CustomSystemsDatabase *db = static_cast<CustomSystemsDatabase*>(lua_touserdata(L, -1));
+	lua_pop(L, 1);
+	assert(db);
+	return db;
+}
 
 // ------- CustomSystemBody --------
 
@@ -341,13 +354,18 @@ static int l_csys_faction(lua_State *L)
 	CustomSystem *cs = l_csys_check(L, 1);
 
 	std::string factionName = luaL_checkstring(L, 2);
-	if (!s_activeCustomSystemsDatabase->GetGalaxy()->GetFactions()->IsInitialized()) {
-		s_activeCustomSystemsDatabase->GetGalaxy()->GetFactions()->RegisterCustomSystem(cs, factionName);
+	CustomSystemsDatabase *db = GetDatabase(L);
+	if (db->IsIndexing()) {
+		lua_settop(L, 1);
+		return 1;
+	}
+	if (!db->GetGalaxy()->GetFactions()->IsInitialized()) {
+		db->GetGalaxy()->GetFactions()->RegisterCustomSystem(cs, factionName);
 		lua_settop(L, 1);
 		return 1;
 	}
 
-	cs->faction = s_activeCustomSystemsDatabase->GetGalaxy()->GetFactions()->GetFaction(factionName);
+	cs->faction = db->GetGalaxy()->GetFactions()->GetFaction(factionName);
 	if (cs->faction->idx == Faction::BAD_FACTION_IDX) {
 		luaL_argerror(L, 2, "Faction not found");
 	}
@@ -473,7 +491,7 @@ static int l_csys_add_to_sector(lua_State *L)
 
 	//Output("l_csys_add_to_sector: %s added to %d, %d, %d\n", (*csptr)->name.c_str(), x, y, z);
 
-	s_activeCustomSystemsDatabase->AddCustomSystem(SystemPath(x, y, z), *csptr);
+	GetDatabase(L)->AddCustomSystem(SystemPath(x, y, z), *csptr);
 	*csptr = 0;
 	return 0;
 }
@@ -526,11 +544,49 @@ static void RegisterCustomSystemsAPI(lua_State *L)
 	register_class(L, LuaCustomSystemBody_TypeName, LuaCustomSystemBody_meta);
 }
 
-void CustomSystemsDatabase::Init()
+// ------ CustomSystemsDatabase ------
+
+namespace {
+
+const char INDEX_FILE[] = "customsystems.idx";
+
+// bump this if the index layout changes
+const Uint32 INDEX_VERSION = 1;
+
+struct IndexHeader {
+	char magic[4];
+	Uint32 version;
+	Uint32 payloadSize;
+	Uint32 payloadHash;
+};
+
+// the order pi_lua_dofile_recursive runs them in
+void ListFiles(const std::string &dir, std::vector<std::string> &paths)
+{
+	for (FileSystem::FileEnumerator files(FileSystem::gameDataFiles, dir, FileSystem::FileEnumerator::IncludeDirs); !files.Finished(); files.Next()) {
+		const FileSystem::FileInfo &info = files.Current();
+		if (info.IsDir())
+			ListFiles(info.GetPath(), paths);
+		else if (ends_with_ci(info.GetPath(), ".lua"))
+			paths.push_back(info.GetPath());
+	}
+}
+
+}
+
+CustomSystemsDatabase::CustomSystemsDatabase(Galaxy* galaxy, const std::string& customSysDir) :
+	m_galaxy(galaxy),
+	m_customSysDirectory(customSysDir),
+	m_lazy(false),
+	m_indexing(false),
+	m_currentFile(0),
+	m_lua(nullptr)
+{
+	m_lock = SDL_CreateMutex();
+}
+
+lua_State *CustomSystemsDatabase::NewLuaState()
 {
-	PROFILE_SCOPED()
-	assert(!s_activeCustomSystemsDatabase);
-	s_activeCustomSystemsDatabase = this;
 	lua_State *L = luaL_newstate();
 	LUA_DEBUG_START(L);
 
@@ -558,17 +614,190 @@ void CustomSystemsDatabase::Init()
 
 	RegisterCustomSystemsAPI(L);
 
-	LUA_DEBUG_CHECK(L, 0);
-	pi_lua_dofile_recursive(L, m_customSysDirectory);
+	lua_pushlightuserdata(L, this);
+	lua_setfield(L, LUA_REGISTRYINDEX, s_databaseKey);
 
 	LUA_DEBUG_END(L, 0);
-	lua_close(L);
-	s_activeCustomSystemsDatabase = nullptr;
+	return L;
+}
+
+void CustomSystemsDatabase::Init()
+{
+	PROFILE_SCOPED()
+	m_lazy = Pi::config->Int("LazyCustomSystems") != 0;
+
+	if (!m_lazy) {
+		lua_State *L = NewLuaState();
+		pi_lua_dofile_recursive(L, m_customSysDirectory);
+		lua_close(L);
+		return;
+	}
+
+	std::vector<std::string> paths;
+	ListFiles(m_customSysDirectory, paths);
+
+	std::map<std::string, SourceFile> index;
+	LoadIndex(index);
+
+	// files that are new or have changed since the index was written are
+	// run now, just to see where their systems go
+	Uint32 numScanned = 0;
+	lua_State *L = nullptr;
+	m_files.reserve(paths.size());
+	for (const std::string &path : paths) {
+		RefCountedPtr<FileSystem::FileData> code = FileSystem::gameDataFiles.ReadFile(path);
+		if (!code) continue;
+
+		SourceFile file;
+		file.path = path;
+		file.hash[0] = file.hash[1] = 0;
+		lookup3_hashlittle2(code->GetData(), code->GetSize(), &file.hash[0], &file.hash[1]);
+		file.loaded = false;
+
+		auto it = index.find(path);
+		if (it != index.end() && it->second.hash[0] == file.hash[0] && it->second.hash[1] == file.hash[1]) {
+			file.sectors.swap(it->second.sectors);
+			m_files.push_back(file);
+			continue;
+		}
+
+		m_files.push_back(file);
+		if (!L) L = NewLuaState();
+		m_indexing = true;
+		RunFile(L, m_files.size() - 1);
+		m_indexing = false;
+		numScanned++;
+	}
+	if (L) lua_close(L);
+
+	if (numScanned || index.size() != m_files.size())
+		SaveIndex();
+
+	for (Uint32 i = 0; i < m_files.size(); i++)
+		for (const SystemPath &sec : m_files[i].sectors)
+			m_unloadedSectors[sec].push_back(i);
+
+	Output("CustomSystemsDatabase: %u files, %u sectors (%u files indexed)\n",
+		Uint32(m_files.size()), Uint32(m_unloadedSectors.size()), numScanned);
+}
+
+bool CustomSystemsDatabase::LoadIndex(std::map<std::string, SourceFile> &index) const
+{
+	RefCountedPtr<FileSystem::FileData> fd = FileSystem::userFiles.ReadFile(INDEX_FILE);
+	if (!fd || fd->GetSize() < sizeof(IndexHeader)) return false;
+
+	const char *data = fd->GetData();
+	IndexHeader header;
+	memcpy(&header, data, sizeof(IndexHeader));
+	if (memcmp(header.magic, "PCS1", 4) != 0 || header.version != INDEX_VERSION) return false;
+	// Serializer::Reader doesn't check for overruns, so make sure the
+	// payload is exactly what was written before reading any of it
+	if (fd->GetSize() != sizeof(IndexHeader) + header.payloadSize) return false;
+	if (lookup3_hashlittle(data + sizeof(IndexHeader), header.payloadSize, 0) != header.payloadHash) return false;
+
+	Serializer::Reader rd(ByteRange(data + sizeof(IndexHeader), data + fd->GetSize()));
+	const Uint32 numFiles = rd.Int32();
+	for (Uint32 i = 0; i < numFiles; i++) {
+		SourceFile file;
+		file.path = rd.String();
+		file.hash[0] = rd.Int32();
+		file.hash[1] = rd.Int32();
+		file.loaded = false;
+		const Uint32 numSectors = rd.Int32();
+		file.sectors.reserve(numSectors);
+		for (Uint32 j = 0; j < numSectors; j++) {
+			const Sint32 x = rd.Int32();
+			const Sint32 y = rd.Int32();
+			const Sint32 z = rd.Int32();
+			file.sectors.push_back(SystemPath(x, y, z));
+		}
+		index[file.path] = file;
+	}
+	return true;
+}
+
+void CustomSystemsDatabase::SaveIndex() const
+{
+	Serializer::Writer wr;
+	wr.Int32(m_files.size());
+	for (const SourceFile &file : m_files) {
+		wr.String(file.path);
+		wr.Int32(file.hash[0]);
+		wr.Int32(file.hash[1]);
+		wr.Int32(file.sectors.size());
+		for (const SystemPath &sec : file.sectors) {
+			wr.Int32(sec.sectorX);
+			wr.Int32(sec.sectorY);
+			wr.Int32(sec.sectorZ);
+		}
+	}
+	const std::string &payload = wr.GetData();
+
+	FILE *f = FileSystem::userFiles.OpenWriteStream(INDEX_FILE);
+	if (!f) return;
+	IndexHeader header;
+	memcpy(header.magic, "PCS1", 4);
+	header.version = INDEX_VERSION;
+	header.payloadSize = payload.size();
+	header.payloadHash = lookup3_hashlittle(payload.data(), payload.size(), 0);
+	fwrite(&header, sizeof(IndexHeader), 1, f);
+	fwrite(payload.data(), payload.size(), 1, f);
+	fclose(f);
+}
+
+void CustomSystemsDatabase::RunFile(lua_State *L, Uint32 fileIndex)
+{
+	PROFILE_SCOPED()
+	LUA_DEBUG_START(L);
+	m_currentFile = fileIndex;
+	pi_lua_dofile(L, m_files[fileIndex].path);
+	m_files[fileIndex].loaded = true;
+	LUA_DEBUG_END(L, 0);
+}
+
+void CustomSystemsDatabase::LoadSector(const SystemPath &path)
+{
+	PROFILE_SCOPED()
+	auto it = m_unloadedSectors.find(path);
+	if (it == m_unloadedSectors.end())
+		return;
+
+	// the files may add to other sectors too, and any that have all
+	// their files run by now are done as well
+	const std::vector<Uint32> files = it->second;
+	for (Uint32 idx : files) {
+		if (m_files[idx].loaded) continue;
+		if (!m_lua) m_lua = NewLuaState();
+		RunFile(m_lua, idx);
+		for (const SystemPath &sec : m_files[idx].sectors)
+			CompleteSector(sec);
+	}
+}
+
+void CustomSystemsDatabase::CompleteSector(const SystemPath &path)
+{
+	auto it = m_unloadedSectors.find(path);
+	if (it == m_unloadedSectors.end())
+		return;
+	for (Uint32 idx : it->second)
+		if (!m_files[idx].loaded)
+			return;
+
+	SystemList &systems = m_sectorMap[path];
+	for (Uint32 idx : it->second) {
+		auto pending = m_pending.find(std::make_pair(path, idx));
+		if (pending == m_pending.end()) continue;
+		systems.insert(systems.end(), pending->second.begin(), pending->second.end());
+		m_pending.erase(pending);
+	}
+	m_unloadedSectors.erase(it);
 }
 
 CustomSystemsDatabase::~CustomSystemsDatabase()
 {
 	PROFILE_SCOPED()
+	if (m_lua)
+		lua_close(m_lua);
 	for (SectorMap::iterator secIt = m_sectorMap.begin(); secIt != m_sectorMap.end(); ++secIt) {
 		for (CustomSystemsDatabase::SystemList::iterator
 				sysIt = secIt->second.begin(); sysIt != secIt->second.end(); ++sysIt) {
@@ -576,20 +805,52 @@ CustomSystemsDatabase::~CustomSystemsDatabase()
 		}
 	}
 	m_sectorMap.clear();
+	for (auto &pending : m_pending)
+		for (const CustomSystem *cs : pending.second)
+			delete cs;
+	m_pending.clear();
+	SDL_DestroyMutex(m_lock);
 }
 
 const CustomSystemsDatabase::SystemList &CustomSystemsDatabase::GetCustomSystemsForSector(int x, int y, int z) const
 {
 	PROFILE_SCOPED()
 	SystemPath path(x,y,z);
+	SDL_LockMutex(m_lock);
+	if (m_lazy)
+		const_cast<CustomSystemsDatabase*>(this)->LoadSector(path);
 	SectorMap::const_iterator it = m_sectorMap.find(path);
-	return (it != m_sectorMap.end()) ? it->second : s_emptySystemList;
+	// lists aren't touched once they're in the map, and map entries don't
+	// move, so this stays good after the lock is let go
+	const SystemList &systems = (it != m_sectorMap.end()) ? it->second : s_emptySystemList;
+	SDL_UnlockMutex(m_lock);
+	return systems;
 }
 
 void CustomSystemsDatabase::AddCustomSystem(const SystemPath& path, CustomSystem* csys)
 {
-	m_sectorMap[path].push_back(csys);
+	if (!m_lazy) {
+		m_sectorMap[path].push_back(csys);
+		return;
+	}
 
+	SourceFile &file = m_files[m_currentFile];
+	if (m_indexing) {
+		if (std::find(file.sectors.begin(), file.sectors.end(), path) == file.sectors.end())
+			file.sectors.push_back(path);
+		delete csys;
+		return;
+	}
+
+	// a sector the index didn't have this file in. only if the file
+	// changed since Init, and it's too late to hand out now
+	if (std::find(file.sectors.begin(), file.sectors.end(), path) == file.sectors.end()) {
+		Output("CustomSystemsDatabase: %s added %s to (%d,%d,%d) after indexing, ignoring\n",
+			file.path.c_str(), csys->name.c_str(), path.sectorX, path.sectorY, path.sectorZ);
+		delete csys;
+		return;
+	}
+	m_pending[std::make_pair(path, m_currentFile)].push_back(csys);
 }
 
 CustomSystem::CustomSystem():
@@ -12,6 +12,7 @@
 
 class Faction;
 class Galaxy;
+struct lua_State;
 
 class CustomSystemBody {
 public:
@@ -88,26 +89,65 @@ public:
 	bool IsRandom() const { return !sBody; }
 };
 
+/*
+ * With LazyCustomSystems on, Init only works out which sectors each file in
+ * the custom systems directory adds systems to. That's kept in an index in
+ * the user directory, so after the first run it's only redone for files
+ * that have changed. A file is run when one of its sectors is first asked
+ * for, and the sector's list is handed out once all of its files have run,
+ * in the same order they'd have been run up front.
+ */
 class CustomSystemsDatabase {
 public:
-	CustomSystemsDatabase(Galaxy* galaxy, const std::string& customSysDir) : m_galaxy(galaxy), m_customSysDirectory(customSysDir) { }
+	CustomSystemsDatabase(Galaxy* galaxy, const std::string& customSysDir);
 	~CustomSystemsDatabase();
 
 	void Init();
 
 	typedef std::vector<const CustomSystem*> SystemList;
 	// XXX this is not as const-safe as it should be
+	// safe to call from any thread. may run Lua, the first time for a sector
 	const SystemList &GetCustomSystemsForSector(int sectorX, int sectorY, int sectorZ) const;
 	void AddCustomSystem(const SystemPath& path, CustomSystem* csys);
 	Galaxy* GetGalaxy() const { return m_galaxy; }
+	// true while files are only being run to find their sectors. the
+	// systems are thrown away, so they mustn't be handed to anything else
+	bool IsIndexing() const { return m_indexing; }
 
 private:
 	typedef std::map<SystemPath, CustomSystemsDatabase::SystemList> SectorMap;
 
+	// a file in the custom systems directory, and the sectors it adds to
+	struct SourceFile {
+		std::string path;
+		Uint32 hash[2];
+		std::vector<SystemPath> sectors;
+		bool loaded;
+	};
+
+	lua_State *NewLuaState();
+	bool LoadIndex(std::map<std::string, SourceFile> &index) const;
+	void SaveIndex() const;
+	void RunFile(lua_State *L, Uint32 fileIndex);
+	void LoadSector(const SystemPath &path);
+	void CompleteSector(const SystemPath &path);
+
 	Galaxy* const m_galaxy;
 	const std::string m_customSysDirectory;
 	SectorMap m_sectorMap;
 	static const CustomSystemsDatabase::SystemList s_emptySystemList; // see: Null Object pattern
+
+	bool m_lazy;
+	bool m_indexing;
+	Uint32 m_currentFile;
+	std::vector<SourceFile> m_files;
+	// the files still to finish for each sector that isn't in m_sectorMap yet
+	std::map<SystemPath, std::vector<Uint32> > m_unloadedSectors;
+	// systems from files that have run, by sector and file, waiting for the
+	// rest of their sector
+	std::map<std::pair<SystemPath, Uint32>, SystemList> m_pending;
+	lua_State *m_lua;
+	SDL_mutex *m_lock;
 };
 
 #endif /* _CUSTOMSYSTEM_H */
@@ -8,12 +8,14 @@
 #include "Sector.h"
 #include "Pi.h"
 #include "FileSystem.h"
+#include "JobQueue.h"
+#include "OS.h"
 
 Galaxy::Galaxy(RefCountedPtr<GalaxyGenerator> galaxyGenerator, float radius, float sol_offset_x, float sol_offset_y,
 	const std::string& factionsDir, const std::string& customSysDir)
 	: GALAXY_RADIUS(radius), SOL_OFFSET_X(sol_offset_x), SOL_OFFSET_Y(sol_offset_y),
 	m_initialized(false), m_galaxyGenerator(galaxyGenerator), m_sectorCache(this),
-	m_starSystemCache(this), m_factions(this, factionsDir), m_customSystems(this, customSysDir)
+	m_starSystemCache(this), m_routePlanner(this), m_marketIndex(this), m_nameIndex(this), m_factions(this, factionsDir), m_customSystems(this, customSysDir)
 {
 }
 
@@ -21,7 +23,7 @@ Galaxy::Galaxy(RefCountedPtr<GalaxyGenerator> galaxyGenerator, float radius, flo
 RefCountedPtr<Galaxy> Galaxy::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("galaxy_generator")) throw SavedGameCorruptException();
-	Json::Value galaxyGenObj = jsonObj["galaxy_generator"];
+	const Json::Value &galaxyGenObj = jsonObj["galaxy_generator"];
 
 	RefCountedPtr<Galaxy> galaxy = GalaxyGenerator::CreateFromJson(galaxyGenObj);
 	galaxy->m_galaxyGenerator->FromJson(galaxyGenObj, galaxy);
@@ -40,12 +42,14 @@ void Galaxy::SetGalaxyGenerator(RefCountedPtr<GalaxyGenerator> galaxyGenerator)
 
 Galaxy::~Galaxy()
 {
+	m_nameIndex.Save();
 }
 
 void Galaxy::Init()
 {
 	m_customSystems.Init();
 	m_factions.Init();
+	m_nameIndex.Load();
 	m_initialized = true;
 	m_factions.PostInit(); // So, cached home sectors take persisted state into account
 #if 0
@@ -70,6 +74,8 @@ void Galaxy::Init()
 void Galaxy::FlushCaches()
 {
 	m_factions.ClearCache();
+	m_routePlanner.ClearCache();
+	m_marketIndex.ClearCache();
 	m_starSystemCache.OutputCacheStatistics();
 	m_starSystemCache.ClearCache();
 	m_sectorCache.OutputCacheStatistics();
@@ -77,6 +83,22 @@ void Galaxy::FlushCaches()
 	assert(m_sectorCache.IsEmpty());
 }
 
+void Galaxy::GetSectorDensities(const int sx, const int sy, const int sz, const int countX, const int countY, const int step, Uint8 *out) const
+{
+	PROFILE_SCOPED()
+	// without anything better, sample the sector in the middle of each block
+	const int half = step / 2;
+	for (int j = 0; j < countY; j++)
+		for (int i = 0; i < countX; i++)
+			*out++ = GetSectorDensity(sx + i*step + half, sy + j*step + half, sz);
+}
+
+void Galaxy::ApplyCacheBudgets()
+{
+	m_starSystemCache.ApplyMemoryBudget();
+	m_sectorCache.ApplyMemoryBudget();
+}
+
 void Galaxy::Dump(FILE* file, Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 radius)
 {
 	for (Sint32 sx = centerX - radius; sx <= centerX + radius; ++sx) {
@@ -90,6 +112,84 @@ void Galaxy::Dump(FILE* file, Sint32 centerX, Sint32 centerY, Sint32 centerZ, Si
 	}
 }
 
+template <typename Slave>
+static void FillAndWait(Slave* slave, const std::vector<SystemPath>& paths, bool complete = true)
+{
+	bool done = false;
+	slave->FillCache(paths, [&done]() { done = true; }, Job::PRIORITY_NORMAL, complete);
+	while (!done)
+		if (!Pi::GetAsyncJobQueue()->FinishJobs())
+			SDL_Delay(1);
+}
+
+void Galaxy::Benchmark(Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 size)
+{
+	const double period = 1.0 / double(SDL_GetPerformanceFrequency());
+	const Sint32 lo = -size / 2, hi = lo + size;
+	Output("galaxybench: %dx%dx%d sectors around %d,%d,%d on %u threads\n", size, size, size, centerX, centerY, centerZ,
+		Pi::GetAsyncJobQueue()->GetNumRunners());
+
+	GalaxyGenerator::SetStageTiming(true);
+	m_galaxyGenerator->ResetStageTimes();
+
+	// the sectors all at once, the way the sector view asks for them
+	SectorCache::PathVector sectorPaths;
+	for (Sint32 sx = centerX + lo; sx < centerX + hi; ++sx)
+		for (Sint32 sy = centerY + lo; sy < centerY + hi; ++sy)
+			for (Sint32 sz = centerZ + lo; sz < centerZ + hi; ++sz)
+				sectorPaths.push_back(SystemPath(sx, sy, sz));
+	RefCountedPtr<SectorCache::Slave> sectors = m_sectorCache.NewSlaveCache();
+	Uint64 start = SDL_GetPerformanceCounter();
+	FillAndWait(sectors.Get(), sectorPaths);
+	const double sectorTime = double(SDL_GetPerformanceCounter() - start) * period;
+
+	Uint32 numSystems = 0;
+	start = SDL_GetPerformanceCounter();
+	for (auto it = sectors->Begin(); it != sectors->End(); ++it)
+		for (const Sector::System& sys : it->second->m_systems) {
+			sys.GetFaction();
+			++numSystems;
+		}
+	const double factionTime = double(SDL_GetPerformanceCounter() - start) * period;
+
+	// then the systems a slab at a time, so it doesn't all have to fit in
+	// memory at once. the jobs are asked for only the headers here, so the
+	// bodies can be timed separately
+	double headerTime = 0.0, populateTime = 0.0;
+	for (Sint32 sx = centerX + lo; sx < centerX + hi; ++sx) {
+		StarSystemCache::PathVector systemPaths;
+		for (auto it = sectors->Begin(); it != sectors->End(); ++it) {
+			if (it->first.sectorX != sx)
+				continue;
+			for (Uint32 i = 0; i < it->second->m_systems.size(); ++i)
+				systemPaths.push_back(SystemPath(it->first.sectorX, it->first.sectorY, it->first.sectorZ, i));
+		}
+		RefCountedPtr<StarSystemCache::Slave> systems = m_starSystemCache.NewSlaveCache();
+		start = SDL_GetPerformanceCounter();
+		FillAndWait(systems.Get(), systemPaths, false);
+		const Uint64 headersDone = SDL_GetPerformanceCounter();
+		for (auto it = systems->Begin(); it != systems->End(); ++it)
+			it->second->Materialise(StarSystem::STAGE_POPULATED);
+		const Uint64 populateDone = SDL_GetPerformanceCounter();
+		headerTime += double(headersDone - start) * period;
+		populateTime += double(populateDone - headersDone) * period;
+	}
+
+	GalaxyGenerator::SetStageTiming(false);
+
+	Output("galaxybench: %zu sectors, %u systems\n", sectorPaths.size(), numSystems);
+	Output("  %-32s %10.3f s\n", "sectors (job queue)", sectorTime);
+	Output("  %-32s %10.3f s\n", "factions", factionTime);
+	Output("  %-32s %10.3f s\n", "system headers (job queue)", headerTime);
+	Output("  %-32s %10.3f s\n", "system bodies", populateTime);
+	Output("galaxybench: stage times, summed over threads:\n");
+	for (const GalaxyGenerator::StageTime& t : m_galaxyGenerator->GetStageTimes())
+		Output("  %-32s %10.3f s %10u calls %10.1f us/call\n", t.name, t.seconds, t.calls, t.calls ? t.seconds * 1e6 / t.calls : 0.0);
+	m_sectorCache.OutputCacheStatistics();
+	m_starSystemCache.OutputCacheStatistics();
+	Output("galaxybench: peak memory %zu MB\n", OS::GetPeakMemoryUsage() >> 20);
+}
+
 RefCountedPtr<GalaxyGenerator> Galaxy::GetGenerator() const
 {
 	return m_galaxyGenerator;
@@ -108,7 +208,7 @@ int Galaxy::GetGeneratorVersion() const
 DensityMapGalaxy::DensityMapGalaxy(RefCountedPtr<GalaxyGenerator> galaxyGenerator, const std::string& mapfile,
 	float radius, float sol_offset_x, float sol_offset_y, const std::string& factionsDir, const std::string& customSysDir)
 	: Galaxy(galaxyGenerator, radius, sol_offset_x, sol_offset_y, factionsDir, customSysDir),
-	  m_mapWidth(0), m_mapHeight(0)
+	  m_mapWidth(0), m_mapHeight(0), m_sectorsPerTexel(1.0f)
 {
 	RefCountedPtr<FileSystem::FileData> filedata = FileSystem::gameDataFiles.ReadFile(mapfile);
 	if (!filedata) {
@@ -142,20 +242,56 @@ DensityMapGalaxy::DensityMapGalaxy(RefCountedPtr<GalaxyGenerator> galaxyGenerato
 	SDL_UnlockSurface(galaxyImg);
 	if(galaxyImg)
 		SDL_FreeSurface(galaxyImg);
+
+	BuildMapLevels();
 }
 
-static const float one_over_256(1.0f / 256.0f);
-Uint8 DensityMapGalaxy::GetSectorDensity(const int sx, const int sy, const int sz) const
+void DensityMapGalaxy::BuildMapLevels()
 {
-	// -1.0 to 1.0 then limited to 0.0 to 1.0
-	const float offset_x = (((sx*Sector::SIZE + SOL_OFFSET_X)/GALAXY_RADIUS) + 1.0f)*0.5f;
-	const float offset_y = (((-sy*Sector::SIZE + SOL_OFFSET_Y)/GALAXY_RADIUS) + 1.0f)*0.5f;
+	PROFILE_SCOPED()
+	// how many sectors across one texel of the full size map is
+	m_sectorsPerTexel = (2.0f * GALAXY_RADIUS) / (Sector::SIZE * float(std::max(m_mapWidth - 1, 1)));
 
-	const int x = int(floor(offset_x * (m_mapWidth - 1)));
-	const int y = int(floor(offset_y * (m_mapHeight - 1)));
+	// each level averages 2x2 texels of the one above it, an odd last row or column
+	// just repeats the edge
+	Sint32 prevWidth = m_mapWidth, prevHeight = m_mapHeight;
+	const float *prev = m_galaxyMap.get();
+	while (prevWidth > 1 || prevHeight > 1) {
+		MapLevel level;
+		level.width = std::max(prevWidth / 2, 1);
+		level.height = std::max(prevHeight / 2, 1);
+		level.data.reset(new float[level.width * level.height]);
+		for (Sint32 y = 0; y < level.height; y++) {
+			const Sint32 y0 = std::min(y*2, prevHeight-1), y1 = std::min(y*2+1, prevHeight-1);
+			for (Sint32 x = 0; x < level.width; x++) {
+				const Sint32 x0 = std::min(x*2, prevWidth-1), x1 = std::min(x*2+1, prevWidth-1);
+				level.data[x + y*level.width] = 0.25f * (prev[x0 + y0*prevWidth] + prev[x1 + y0*prevWidth]
+					+ prev[x0 + y1*prevWidth] + prev[x1 + y1*prevWidth]);
+			}
+		}
+		prevWidth = level.width;
+		prevHeight = level.height;
+		m_mapLevels.push_back(std::move(level));
+		prev = m_mapLevels.back().data.get();
+	}
+}
 
-	float val = m_galaxyMap.get()[x + y*m_mapWidth];
+float DensityMapGalaxy::SampleMap(const int level, const float offset_x, const float offset_y) const
+{
+	const int x = Clamp(int(floor(offset_x * (m_mapWidth - 1))), 0, m_mapWidth - 1);
+	const int y = Clamp(int(floor(offset_y * (m_mapHeight - 1))), 0, m_mapHeight - 1);
+	if (level == 0)
+		return m_galaxyMap.get()[x + y*m_mapWidth];
+
+	const MapLevel &map = m_mapLevels[level - 1];
+	const int lx = Clamp(x >> level, 0, map.width - 1);
+	const int ly = Clamp(y >> level, 0, map.height - 1);
+	return map.data[lx + ly*map.width];
+}
 
+static const float one_over_256(1.0f / 256.0f);
+static inline Uint8 ScaleDensity(float val, const int sz)
+{
 	// crappy unrealistic but currently adequate density dropoff with sector z
 	val = val * (256.0f - std::min(float(abs(sz)),256.0f)) * one_over_256;
 
@@ -164,3 +300,35 @@ Uint8 DensityMapGalaxy::GetSectorDensity(const int sx, const int sy, const int s
 
 	return Uint8(val);
 }
+
+Uint8 DensityMapGalaxy::GetSectorDensity(const int sx, const int sy, const int sz) const
+{
+	// -1.0 to 1.0 then limited to 0.0 to 1.0
+	const float offset_x = (((sx*Sector::SIZE + SOL_OFFSET_X)/GALAXY_RADIUS) + 1.0f)*0.5f;
+	const float offset_y = (((-sy*Sector::SIZE + SOL_OFFSET_Y)/GALAXY_RADIUS) + 1.0f)*0.5f;
+
+	return ScaleDensity(SampleMap(0, offset_x, offset_y), sz);
+}
+
+void DensityMapGalaxy::GetSectorDensities(const int sx, const int sy, const int sz, const int countX, const int countY, const int step, Uint8 *out) const
+{
+	PROFILE_SCOPED()
+	/* pick the coarsest level whose texels are no bigger than a block, so a
+	   galaxy wide grid costs one lookup per value however many sectors it spans */
+	int level = 0;
+	while (step > 1 && level < int(m_mapLevels.size()) && m_sectorsPerTexel * float(2 << level) <= float(step))
+		level++;
+
+	// sampled where the base class samples, so with step 1 the values are
+	// exactly GetSectorDensity's
+	const int half = step / 2;
+	for (int j = 0; j < countY; j++) {
+		const float cy = float(sy + j*step + half);
+		const float offset_y = (((-cy*Sector::SIZE + SOL_OFFSET_Y)/GALAXY_RADIUS) + 1.0f)*0.5f;
+		for (int i = 0; i < countX; i++) {
+			const float cx = float(sx + i*step + half);
+			const float offset_x = (((cx*Sector::SIZE + SOL_OFFSET_X)/GALAXY_RADIUS) + 1.0f)*0.5f;
+			*out++ = ScaleDensity(SampleMap(level, offset_x, offset_y), sz);
+		}
+	}
+}
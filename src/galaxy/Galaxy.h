@@ -10,6 +10,9 @@
 #include "Factions.h"
 #include "CustomSystem.h"
 #include "GalaxyCache.h"
+#include "RoutePlanner.h"
+#include "MarketIndex.h"
+#include "SystemNameIndex.h"
 #include "json/json.h"
 
 struct SDL_Surface;
@@ -37,6 +40,11 @@ public:
 	bool IsInitialized() const { return m_initialized; }
 	/* 0 - 255 */
 	virtual Uint8 GetSectorDensity(const int sx, const int sy, const int sz) const = 0;
+	/* densities for a countX by countY grid of sectors in the plane sz, spaced step
+	   sectors apart starting at sx,sy, written row by row. with step > 1 each value
+	   is the average over the step x step block rather than a single sector; with
+	   step 1 they're the same as GetSectorDensity's */
+	virtual void GetSectorDensities(const int sx, const int sy, const int sz, const int countX, const int countY, const int step, Uint8 *out) const;
 	FactionsDatabase* GetFactions() { return &m_factions; } // XXX const correctness
 	CustomSystemsDatabase* GetCustomSystems() { return &m_customSystems; } // XXX const correctness
 
@@ -47,8 +55,20 @@ public:
 	RefCountedPtr<StarSystem> GetStarSystem(const SystemPath& path) { return m_starSystemCache.GetCached(path); }
 	RefCountedPtr<StarSystemCache::Slave> NewStarSystemSlaveCache() { return m_starSystemCache.NewSlaveCache(); }
 
+	const SectorCache &GetSectorCache() const { return m_sectorCache; }
+	const StarSystemCache &GetStarSystemCache() const { return m_starSystemCache; }
+
+	RoutePlanner* GetRoutePlanner() { return &m_routePlanner; }
+	MarketIndex* GetMarketIndex() { return &m_marketIndex; }
+	SystemNameIndex* GetSystemNameIndex() { return &m_nameIndex; }
+
 	void FlushCaches();
+	void ApplyCacheBudgets();
 	void Dump(FILE* file, Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 radius);
+	// generate a size^3 cube of sectors and all their systems on the async
+	// job queue, and report how long each part took, the cache statistics
+	// and the peak memory use
+	void Benchmark(Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 size);
 
 	RefCountedPtr<GalaxyGenerator> GetGenerator() const;
 	const std::string& GetGeneratorName() const;
@@ -59,6 +79,9 @@ private:
 	RefCountedPtr<GalaxyGenerator> m_galaxyGenerator;
 	SectorCache m_sectorCache;
 	StarSystemCache m_starSystemCache;
+	RoutePlanner m_routePlanner;
+	MarketIndex m_marketIndex;
+	SystemNameIndex m_nameIndex;
 	FactionsDatabase m_factions;
 	CustomSystemsDatabase m_customSystems;
 };
@@ -71,10 +94,22 @@ private:
 
 public:
 	virtual Uint8 GetSectorDensity(const int sx, const int sy, const int sz) const;
+	virtual void GetSectorDensities(const int sx, const int sy, const int sz, const int countX, const int countY, const int step, Uint8 *out) const;
 
 private:
+	// averaged copies of the map, each half the size of the one before
+	struct MapLevel {
+		std::unique_ptr<float[]> data;
+		Sint32 width, height;
+	};
+
+	void BuildMapLevels();
+	float SampleMap(const int level, const float offset_x, const float offset_y) const;
+
 	std::unique_ptr<float[]> m_galaxyMap;
 	Sint32 m_mapWidth, m_mapHeight;
+	std::vector<MapLevel> m_mapLevels;
+	float m_sectorsPerTexel;
 };
 
 #endif /* _GALAXY_H */
@@ -1,6 +1,7 @@
 // Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
+#include <algorithm>
 #include <utility>
 #include "libs.h"
 #include "Factions.h"
@@ -16,6 +17,14 @@
 
 //virtual
 
+template <typename T, typename CompareT>
+GalaxyObjectCache<T,CompareT>::GalaxyObjectCache(Galaxy* galaxy)
+	: m_galaxy(galaxy), m_cacheHits(0), m_cacheHitsSlave(0), m_cacheMisses(0), m_evictions(0),
+	m_byteBudget(size_t(std::max(0, Pi::config->Int(CACHE_NAME + "BudgetMB"))) << 20),
+	m_bytesResident(0), m_bytesAfterTrim(0), m_useCounter(0)
+{
+}
+
 template <typename T, typename CompareT>
 GalaxyObjectCache<T,CompareT>::~GalaxyObjectCache()
 {
@@ -28,15 +37,46 @@ template <typename T, typename CompareT>
 void GalaxyObjectCache<T,CompareT>::AddToCache(std::vector<RefCountedPtr<T> >& objects)
 {
 	for (auto it = objects.begin(), itEnd = objects.end(); it != itEnd; ++it) {
-		auto inserted = m_attic.insert( std::make_pair(it->Get()->GetPath(), it->Get()) );
-		if (!inserted.second) {
-			it->Reset(inserted.first->second);
+		const SystemPath path = it->Get()->GetPath();
+		typename AtticMap::iterator i = m_attic.find(path);
+		if (i != m_attic.end()) {
+			it->Reset(i->second.object);
+			i->second.lastUsed = ++m_useCounter;
 		} else {
+			AddToAttic(path, it->Get());
 			(*it)->SetCache(this);
 		}
 	}
 }
 
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T,CompareT>::AddToAttic(const SystemPath& path, T* object)
+{
+	const size_t bytes = EstimateSize(object);
+	m_attic.insert( std::make_pair(path, AtticEntry(object, bytes, ++m_useCounter)) );
+	m_bytesResident += bytes;
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T,CompareT>::UpdateSize(const SystemPath& path)
+{
+	typename AtticMap::iterator i = m_attic.find(path);
+	if (i != m_attic.end()) {
+		const size_t bytes = EstimateSize(i->second.object);
+		m_bytesResident = m_bytesResident - i->second.bytes + bytes;
+		i->second.bytes = bytes;
+	}
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T,CompareT>::Touch(const SystemPath& path)
+{
+	if (!m_byteBudget) return;
+	typename AtticMap::iterator i = m_attic.find(path);
+	if (i != m_attic.end())
+		i->second.lastUsed = ++m_useCounter;
+}
+
 template <typename T, typename CompareT>
 RefCountedPtr<T> GalaxyObjectCache<T,CompareT>::GetIfCached(const SystemPath& path)
 {
@@ -45,7 +85,8 @@ RefCountedPtr<T> GalaxyObjectCache<T,CompareT>::GetIfCached(const SystemPath& pa
 	RefCountedPtr<T> s;
 	typename AtticMap::iterator i = m_attic.find(path);
 	if (i != m_attic.end()) {
-		s.Reset(i->second);
+		s.Reset(i->second.object);
+		i->second.lastUsed = ++m_useCounter;
 	}
 
 	return s;
@@ -60,7 +101,7 @@ RefCountedPtr<T> GalaxyObjectCache<T,CompareT>::GetCached(const SystemPath& path
 	if (!s) {
 		++m_cacheMisses;
 		s = m_galaxy->GetGenerator()->Generate<T,GalaxyObjectCache<T,CompareT>>(RefCountedPtr<Galaxy>(m_galaxy), path, this);
-		m_attic.insert( std::make_pair(path, s.Get()));
+		AddToAttic(path, s.Get());
 	} else {
 		++m_cacheHits;
 	}
@@ -78,7 +119,11 @@ bool GalaxyObjectCache<T,CompareT>::HasCached(const SystemPath& path) const
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T,CompareT>::RemoveFromAttic(const SystemPath& path)
 {
-	m_attic.erase(path);
+	typename AtticMap::iterator i = m_attic.find(path);
+	if (i != m_attic.end()) {
+		m_bytesResident -= i->second.bytes;
+		m_attic.erase(i);
+	}
 }
 
 template <typename T, typename CompareT>
@@ -91,9 +136,42 @@ void GalaxyObjectCache<T,CompareT>::ClearCache()
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T,CompareT>::OutputCacheStatistics(bool reset)
 {
-	Output("%s: misses: %lld, slave hits: %lld, master hits: %lld\n", CACHE_NAME.c_str(), m_cacheMisses, m_cacheHitsSlave, m_cacheHits);
+	Output("%s: misses: %lld, slave hits: %lld, master hits: %lld, resident: %zu objects / %zu KB (budget %zu KB), evictions: %lld\n",
+		CACHE_NAME.c_str(), m_cacheMisses, m_cacheHitsSlave, m_cacheHits,
+		m_attic.size(), m_bytesResident >> 10, m_byteBudget >> 10, m_evictions);
 	if (reset)
-		m_cacheMisses = m_cacheHitsSlave = m_cacheHits = 0;
+		m_cacheMisses = m_cacheHitsSlave = m_cacheHits = m_evictions = 0;
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T,CompareT>::ApplyMemoryBudget()
+{
+	if (!m_byteBudget || m_bytesResident <= m_byteBudget || m_bytesResident <= m_bytesAfterTrim)
+		return;
+
+	PROFILE_SCOPED()
+
+	// trim a little below the budget so we aren't back here next frame
+	const size_t target = m_byteBudget - m_byteBudget / 8;
+
+	std::vector<std::pair<Uint64, SystemPath> > byAge;
+	byAge.reserve(m_attic.size());
+	for (auto it = m_attic.begin(), itEnd = m_attic.end(); it != itEnd; ++it)
+		byAge.push_back(std::make_pair(it->second.lastUsed, it->first));
+	std::sort(byAge.begin(), byAge.end(), [](const std::pair<Uint64, SystemPath>& a, const std::pair<Uint64, SystemPath>& b) {
+		return a.first < b.first;
+	});
+
+	for (auto it = byAge.begin(), itEnd = byAge.end(); it != itEnd && m_bytesResident > target; ++it) {
+		// the object deregisters itself from the attic once the last slave lets go
+		for (Slave* s : m_slaves)
+			s->Erase(it->second);
+		if (!HasCached(it->second))
+			++m_evictions;
+	}
+
+	// whatever is left is referenced from outside the caches
+	m_bytesAfterTrim = m_bytesResident;
 }
 
 template <typename T, typename CompareT>
@@ -103,8 +181,8 @@ RefCountedPtr<typename GalaxyObjectCache<T,CompareT>::Slave> GalaxyObjectCache<T
 }
 
 template <typename T, typename CompareT>
-GalaxyObjectCache<T,CompareT>::Slave::Slave(GalaxyObjectCache<T,CompareT>* master, RefCountedPtr<Galaxy> galaxy, JobQueue* jobQueue)
-	: m_master(master), m_galaxy(galaxy), m_jobs(Pi::GetAsyncJobQueue())
+GalaxyObjectCache<T,CompareT>::Slave::Slave(GalaxyObjectCache<T,CompareT>* master, const RefCountedPtr<Galaxy> &galaxy, JobQueue* jobQueue)
+	: m_master(master), m_galaxy(galaxy), m_jobs(Pi::GetAsyncJobQueue()), m_prefetchJobs(Pi::GetAsyncJobQueue())
 {
 	m_master->m_slaves.insert(this);
 }
@@ -133,8 +211,10 @@ RefCountedPtr<T> GalaxyObjectCache<T,CompareT>::Slave::GetCached(const SystemPat
 
 	typename CacheMap::iterator i = m_cache.find(path);
 	if (i != m_cache.end()) {
-		if (m_master)
+		if (m_master) {
 			++m_master->m_cacheHitsSlave;
+			m_master->Touch(path);
+		}
 		return (*i).second;
 	}
 
@@ -182,19 +262,16 @@ void GalaxyObjectCache<T,CompareT>::Slave::AddToCache(std::vector<RefCountedPtr<
 
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T,CompareT>::Slave::FillCache(const typename GalaxyObjectCache<T,CompareT>::PathVector& paths,
-	typename GalaxyObjectCache<T,CompareT>::CacheFilledCallback callback)
+	typename GalaxyObjectCache<T,CompareT>::CacheFilledCallback callback, Job::Priority priority, bool complete)
 {
-	// allocate some space for what we're about to chunk up
-	std::vector<std::unique_ptr<PathVector> > vec_paths;
-	vec_paths.reserve(paths.size()/CACHE_JOB_SIZE + 1);
-	std::unique_ptr<PathVector> current_paths;
 #	ifdef DEBUG_CACHE
 		size_t alreadyCached = m_cache.size();
 		unsigned masterCached = 0;
 		unsigned toBeCreated = 0;
 #	endif
 
-	// chop the paths into groups of CACHE_JOB_SIZE
+	// pick up what the master already has, the rest needs generating
+	PathVector missing;
 	for (auto it = paths.begin(), itEnd = paths.end(); it != itEnd; ++it) {
 		RefCountedPtr<T> s = m_master->GetIfCached(*it);
 		if (s) {
@@ -203,47 +280,100 @@ void GalaxyObjectCache<T,CompareT>::Slave::FillCache(const typename GalaxyObject
 				++masterCached;
 #			endif
 		} else {
-			if (!current_paths) {
-				current_paths.reset(new PathVector);
-				current_paths->reserve(CACHE_JOB_SIZE);
-			}
-			current_paths->push_back(*it);
-			if( current_paths->size() >= CACHE_JOB_SIZE ) {
-				vec_paths.push_back( std::move(current_paths) );
-			}
+			missing.push_back(*it);
 #			ifdef DEBUG_CACHE
 				++toBeCreated;
 #			endif
 		}
 	}
 
-	// catch the last loop in case it's got some entries (could be less than the spread width)
-	if (current_paths) {
-		vec_paths.push_back( std::move(current_paths) );
-	}
-
 #	ifdef DEBUG_CACHE
-		Output("%s: FillCache: %zu cached, %u in master cache, %u to be created, will use %zu jobs\n", CACHE_NAME.c_str(),
-			alreadyCached, masterCached, toBeCreated, vec_paths.size());
+		Output("%s: FillCache: %zu cached, %u in master cache, %u to be created\n", CACHE_NAME.c_str(),
+			alreadyCached, masterCached, toBeCreated);
 #	endif
 
-	if (vec_paths.empty()) {
+	if (missing.empty()) {
 		if (callback)
 			callback();
-	} else {
-		// now add the batched jobs
-		for (auto it = vec_paths.begin(), itEnd = vec_paths.end(); it != itEnd; ++it)
-			m_jobs.Order(new GalaxyObjectCache<T,CompareT>::CacheJob(std::move(*it), this, m_galaxy, callback));
+	} else
+		QueueJobs(m_jobs, missing, callback, priority, complete);
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T,CompareT>::Slave::Prefetch(const typename GalaxyObjectCache<T,CompareT>::PathVector& paths)
+{
+	PROFILE_SCOPED()
+	CancelPrefetch();
+
+	PathVector missing;
+	for (auto it = paths.begin(), itEnd = paths.end(); it != itEnd; ++it) {
+		if (m_cache.count(*it))
+			continue;
+		RefCountedPtr<T> s = m_master->GetIfCached(*it);
+		if (s)
+			m_cache[*it] = s;
+		else
+			missing.push_back(*it);
+	}
+	if (!missing.empty())
+		QueueJobs(m_prefetchJobs, missing, CacheFilledCallback(), Job::PRIORITY_LOW, true);
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T,CompareT>::Slave::CancelPrefetch()
+{
+	// dropping the handles cancels the jobs
+	m_prefetchJobs = JobSet(m_prefetchJobs.GetQueue());
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T,CompareT>::Slave::QueueJobs(JobSet &jobs, const typename GalaxyObjectCache<T,CompareT>::PathVector& missing,
+	typename GalaxyObjectCache<T,CompareT>::CacheFilledCallback callback, Job::Priority priority, bool complete)
+{
+	// each object is seeded from its own path, so how the paths are split
+	// up doesn't change what gets generated
+	const size_t numJobs = CACHE_JOBS_PER_RUNNER * std::max(1u, jobs.GetQueue()->GetNumRunners());
+	const size_t jobSize = Clamp((missing.size() + numJobs - 1) / numJobs, size_t(MIN_CACHE_JOB_SIZE), size_t(CACHE_JOB_SIZE));
+
+	// allocate some space for what we're about to chunk up
+	std::vector<std::unique_ptr<PathVector> > vec_paths;
+	vec_paths.reserve(missing.size()/jobSize + 1);
+	std::unique_ptr<PathVector> current_paths;
+
+	// chop the paths into groups of jobSize
+	for (auto it = missing.begin(), itEnd = missing.end(); it != itEnd; ++it) {
+		if (!current_paths) {
+			current_paths.reset(new PathVector);
+			current_paths->reserve(jobSize);
+		}
+		current_paths->push_back(*it);
+		if( current_paths->size() >= jobSize ) {
+			vec_paths.push_back( std::move(current_paths) );
+		}
+	}
+
+	// catch the last loop in case it's got some entries (could be less than the spread width)
+	if (current_paths) {
+		vec_paths.push_back( std::move(current_paths) );
+	}
+
+	// now add the batched jobs
+	for (auto it = vec_paths.begin(), itEnd = vec_paths.end(); it != itEnd; ++it) {
+		CacheJob *job = new GalaxyObjectCache<T,CompareT>::CacheJob(std::move(*it), this, m_galaxy, callback, complete);
+		job->SetPriority(priority);
+		jobs.Order(job);
 	}
 }
 
 
 template <typename T, typename CompareT>
 GalaxyObjectCache<T,CompareT>::CacheJob::CacheJob(std::unique_ptr<std::vector<SystemPath> > path,
-	typename GalaxyObjectCache<T,CompareT>::Slave* slaveCache, RefCountedPtr<Galaxy> galaxy,
-	typename GalaxyObjectCache<T,CompareT>::CacheFilledCallback callback)
-	: Job(), m_paths(std::move(path)), m_slaveCache(slaveCache), m_galaxy(galaxy), m_galaxyGenerator(galaxy->GetGenerator()), m_callback(callback)
+	typename GalaxyObjectCache<T,CompareT>::Slave* slaveCache, const RefCountedPtr<Galaxy> &galaxy,
+	typename GalaxyObjectCache<T,CompareT>::CacheFilledCallback callback, bool complete)
+	: Job(), m_paths(std::move(path)), m_slaveCache(slaveCache), m_galaxy(galaxy), m_galaxyGenerator(galaxy->GetGenerator()), m_callback(callback),
+	m_complete(complete)
 {
+	SetLane(LANE_GALAXY);
 	m_objects.reserve(m_paths->size());
 }
 
@@ -251,8 +381,11 @@ GalaxyObjectCache<T,CompareT>::CacheJob::CacheJob(std::unique_ptr<std::vector<Sy
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T,CompareT>::CacheJob::OnRun()    // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 {
-	for (auto it = m_paths->begin(), itEnd = m_paths->end(); it != itEnd; ++it)
+	for (auto it = m_paths->begin(), itEnd = m_paths->end(); it != itEnd; ++it) {
 		m_objects.push_back(m_galaxyGenerator->Generate<T,GalaxyObjectCache<T,CompareT>>(m_galaxy, *it, nullptr));
+		if (m_complete)
+			Complete(m_objects.back().Get());
+	}
 }
 
 //virtual
@@ -268,17 +401,48 @@ void GalaxyObjectCache<T,CompareT>::CacheJob::OnFinish()  // runs in primary thr
 
 template <> const std::string GalaxyObjectCache<Sector,SystemPath::LessSectorOnly>::CACHE_NAME("SectorCache");
 
+template <>
+size_t GalaxyObjectCache<Sector,SystemPath::LessSectorOnly>::EstimateSize(const Sector* sector)
+{
+	size_t bytes = sizeof(Sector) + sector->m_systems.capacity() * sizeof(Sector::System);
+	for (const Sector::System& sys : sector->m_systems)
+		bytes += sys.GetName().capacity();
+	return bytes;
+}
+
+template <>
+void GalaxyObjectCache<Sector,SystemPath::LessSectorOnly>::Complete(Sector* sector)
+{
+}
+
 template class GalaxyObjectCache<Sector,SystemPath::LessSectorOnly>;
 
 /****** StarSystemCache ******/
 
 template <>
-GalaxyObjectCache<StarSystem,SystemPath::LessSystemOnly>::Slave::Slave(GalaxyObjectCache<StarSystem,SystemPath::LessSystemOnly>* master, RefCountedPtr<Galaxy> galaxy, JobQueue* jobQueue)
-	: m_master(master), m_galaxy(galaxy), m_jobs(Pi::GetSyncJobQueue())
+GalaxyObjectCache<StarSystem,SystemPath::LessSystemOnly>::Slave::Slave(GalaxyObjectCache<StarSystem,SystemPath::LessSystemOnly>* master, const RefCountedPtr<Galaxy> &galaxy, JobQueue* jobQueue)
+	: m_master(master), m_galaxy(galaxy), m_jobs(Pi::GetSyncJobQueue()), m_prefetchJobs(Pi::GetSyncJobQueue())
 {
 	m_master->m_slaves.insert(this);
 }
 
 template <> const std::string GalaxyObjectCache<StarSystem,SystemPath::LessSystemOnly>::CACHE_NAME("StarSystemCache");
 
+template <>
+size_t GalaxyObjectCache<StarSystem,SystemPath::LessSystemOnly>::EstimateSize(const StarSystem* system)
+{
+	// each body is also referenced from its parent's children and possibly
+	// the star or station lists. goes to the members directly, the accessors
+	// would generate the rest of the system
+	const size_t perBody = sizeof(SystemBody) + sizeof(RefCountedPtr<SystemBody>) + 2 * sizeof(SystemBody*);
+	return sizeof(StarSystem) + system->m_name.capacity() + system->m_shortDesc.capacity() +
+		system->m_longDesc.capacity() + system->m_bodies.size() * perBody;
+}
+
+template <>
+void GalaxyObjectCache<StarSystem,SystemPath::LessSystemOnly>::Complete(StarSystem* system)
+{
+	system->Materialise(StarSystem::STAGE_POPULATED);
+}
+
 template class GalaxyObjectCache<StarSystem,SystemPath::LessSystemOnly>;
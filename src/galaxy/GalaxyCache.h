@@ -24,7 +24,7 @@ class GalaxyObjectCache {
 public:
 	static const std::string CACHE_NAME;
 
-	GalaxyObjectCache(Galaxy* galaxy) : m_galaxy(galaxy), m_cacheHits(0), m_cacheHitsSlave(0), m_cacheMisses(0) { }
+	GalaxyObjectCache(Galaxy* galaxy);
 	~GalaxyObjectCache();
 
 	RefCountedPtr<T> GetCached(const SystemPath& path);
@@ -35,9 +35,24 @@ public:
 
 	void OutputCacheStatistics(bool reset = true);
 
+	// drop the least recently used objects from the slave caches until the
+	// estimated footprint is back under the configured budget. objects that
+	// are still referenced from elsewhere stay alive. never called from
+	// within the cache itself because the slaves may be iterated over at the
+	// time, so call once a frame from a safe point
+	void ApplyMemoryBudget();
+	size_t GetBytesResident() const { return m_bytesResident; }
+	size_t GetNumResident() const { return m_attic.size(); }
+
 	typedef std::vector<SystemPath> PathVector;
 	typedef std::map<SystemPath,RefCountedPtr<T>,CompareT> CacheMap;
-	typedef std::map<SystemPath,T*,CompareT> AtticMap;
+	struct AtticEntry {
+		AtticEntry(T* o, size_t b, Uint64 used) : object(o), bytes(b), lastUsed(used) { }
+		T* object;
+		size_t bytes;
+		Uint64 lastUsed;
+	};
+	typedef std::map<SystemPath,AtticEntry,CompareT> AtticMap;
 	typedef std::function<void()> CacheFilledCallback;
 
 	class Slave : public RefCounted {
@@ -48,7 +63,16 @@ public:
 		typename CacheMap::const_iterator Begin() const { return m_cache.begin(); }
 		typename CacheMap::const_iterator End() const { return m_cache.end(); }
 
-		void FillCache(const PathVector& paths, CacheFilledCallback callback = CacheFilledCallback());
+		// objects generated in stages (star systems) are taken through all
+		// of them in the job, unless complete is false, when only the first
+		// is done and the rest waits until it's asked for
+		void FillCache(const PathVector& paths, CacheFilledCallback callback = CacheFilledCallback(), Job::Priority priority = Job::PRIORITY_NORMAL,
+			bool complete = true);
+		// generate, at low priority, what's likely to be wanted soon. each
+		// call replaces the last one's prefetch, cancelling what it hasn't
+		// got to yet, so it can follow a guess that keeps changing
+		void Prefetch(const PathVector& paths);
+		void CancelPrefetch();
 		void Erase(const SystemPath& path);
 		void Erase(const typename CacheMap::const_iterator& it);
 		void ClearCache();
@@ -60,20 +84,32 @@ public:
 		RefCountedPtr<Galaxy> m_galaxy;
 		CacheMap m_cache;
 		JobSet m_jobs;
+		JobSet m_prefetchJobs;
 
-		Slave(GalaxyObjectCache* master, RefCountedPtr<Galaxy> galaxy, JobQueue* jobQueue);
+		Slave(GalaxyObjectCache* master, const RefCountedPtr<Galaxy> &galaxy, JobQueue* jobQueue);
 		void MasterDeleted();
 		void AddToCache(std::vector<RefCountedPtr<T> >& objects);
+		void QueueJobs(JobSet &jobs, const PathVector& missing, CacheFilledCallback callback, Job::Priority priority, bool complete);
 	};
 
 	RefCountedPtr<Slave> NewSlaveCache();
 
 private:
+	// FillCache aims for a few jobs per runner so the work spreads evenly
+	// over the workers, within these bounds on the paths per job
 	static const unsigned CACHE_JOB_SIZE = 100;
+	static const unsigned MIN_CACHE_JOB_SIZE = 8;
+	static const unsigned CACHE_JOBS_PER_RUNNER = 4;
 
 	void AddToCache(std::vector<RefCountedPtr<T> >& objects);
 	bool HasCached(const SystemPath& path) const;
 	void RemoveFromAttic(const SystemPath& path);
+	void AddToAttic(const SystemPath& path, T* object);
+	void Touch(const SystemPath& path);
+	void UpdateSize(const SystemPath& path); // the object has grown since it was added
+	static size_t EstimateSize(const T* object);
+	// generates whatever the generator left for later
+	static void Complete(T* object);
 
 	// ********************************************************************************
 	// Overloaded Job class to handle generating a collection of sectors
@@ -81,11 +117,12 @@ private:
 	class CacheJob : public Job
 	{
 	public:
-		CacheJob(std::unique_ptr<std::vector<SystemPath> > path, Slave* slaveCache, RefCountedPtr<Galaxy> galaxy, CacheFilledCallback callback = CacheFilledCallback());
+		CacheJob(std::unique_ptr<std::vector<SystemPath> > path, Slave* slaveCache, const RefCountedPtr<Galaxy> &galaxy, CacheFilledCallback callback, bool complete);
 
 		virtual void OnRun();    // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 		virtual void OnFinish();  // runs in primary thread of the context
 		virtual void OnCancel() {}  // runs in primary thread of the context
+		virtual const char *GetName() const { return CACHE_NAME.c_str(); }
 
 	protected:
 		std::unique_ptr<std::vector<SystemPath> > m_paths;
@@ -94,6 +131,7 @@ private:
 		RefCountedPtr<Galaxy> m_galaxy;
 		RefCountedPtr<GalaxyGenerator> m_galaxyGenerator;
 		CacheFilledCallback m_callback;
+		bool m_complete;
 	};
 
 	Galaxy* m_galaxy;
@@ -105,6 +143,12 @@ private:
 	unsigned long long m_cacheHits;
 	unsigned long long m_cacheHitsSlave;
 	unsigned long long m_cacheMisses;
+	unsigned long long m_evictions;
+
+	size_t m_byteBudget; // 0 for unlimited
+	size_t m_bytesResident;
+	size_t m_bytesAfterTrim; // don't rescan until we've grown past this again
+	Uint64 m_useCounter;
 };
 
 class Sector;
@@ -6,18 +6,21 @@
 #include "GalaxyGenerator.h"
 #include "SectorGenerator.h"
 #include "galaxy/StarSystemGenerator.h"
+#include "galaxy/SectorStore.h"
 
 static const GalaxyGenerator::Version LAST_VERSION_LEGACY = 1;
 
 std::string GalaxyGenerator::s_defaultGenerator = "legacy";
 GalaxyGenerator::Version GalaxyGenerator::s_defaultVersion = LAST_VERSION_LEGACY;
 RefCountedPtr<Galaxy> GalaxyGenerator::s_galaxy;
+bool GalaxyGenerator::s_stageTiming = false;
 
 //static
 void GalaxyGenerator::Init(const std::string& name, Version version)
 {
 	s_defaultGenerator = name;
 	s_defaultVersion = (version == LAST_VERSION) ? GetLastVersion(name) : version;
+	SectorStore::Init();
 	GalaxyGenerator::Create(); // This will set s_galaxy
 }
 
@@ -106,7 +109,7 @@ RefCountedPtr<Galaxy> GalaxyGenerator::CreateFromJson(const Json::Value &jsonObj
 	return galaxy;
 }
 
-void GalaxyGenerator::ToJson(Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy)
+void GalaxyGenerator::ToJson(Json::Value &jsonObj, const RefCountedPtr<Galaxy> &galaxy)
 {
 	Json::Value galaxyGenObj(Json::objectValue); // Create JSON object to contain galaxy data.
 
@@ -137,12 +140,12 @@ void GalaxyGenerator::ToJson(Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy)
 	jsonObj["galaxy_generator"] = galaxyGenObj; // Add galaxy generator object to supplied object.
 }
 
-void GalaxyGenerator::FromJson(const Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy)
+void GalaxyGenerator::FromJson(const Json::Value &jsonObj, const RefCountedPtr<Galaxy> &galaxy)
 {
 	if (!jsonObj.isMember("sector_stage")) throw SavedGameCorruptException();
 	if (!jsonObj.isMember("star_system_stage")) throw SavedGameCorruptException();
-	Json::Value sectorStageArray = jsonObj["sector_stage"];
-	Json::Value starSystemStageArray = jsonObj["star_system_stage"];
+	const Json::Value &sectorStageArray = jsonObj["sector_stage"];
+	const Json::Value &starSystemStageArray = jsonObj["star_system_stage"];
 	if (!sectorStageArray.isArray()) throw SavedGameCorruptException();
 	if (!starSystemStageArray.isArray()) throw SavedGameCorruptException();
 
@@ -176,30 +179,89 @@ GalaxyGenerator* GalaxyGenerator::AddStarSystemStage(StarSystemGeneratorStage* s
 	return this;
 }
 
-RefCountedPtr<Sector> GalaxyGenerator::GenerateSector(RefCountedPtr<Galaxy> galaxy, const SystemPath& path, SectorCache* cache)
+std::vector<GalaxyGenerator::StageTime> GalaxyGenerator::GetStageTimes() const
+{
+	const double period = 1.0 / double(SDL_GetPerformanceFrequency());
+	std::vector<StageTime> times;
+	for (const SectorGeneratorStage* secgen : m_sectorStage)
+		times.push_back({ secgen->GetName(), double(secgen->m_timeTicks) * period, secgen->m_timeCalls });
+	for (const StarSystemGeneratorStage* sysgen : m_starSystemStage)
+		times.push_back({ sysgen->GetName(), double(sysgen->m_timeTicks) * period, sysgen->m_timeCalls });
+	return times;
+}
+
+void GalaxyGenerator::ResetStageTimes()
+{
+	for (SectorGeneratorStage* secgen : m_sectorStage)
+		secgen->m_timeTicks = secgen->m_timeCalls = 0;
+	for (StarSystemGeneratorStage* sysgen : m_starSystemStage)
+		sysgen->m_timeTicks = sysgen->m_timeCalls = 0;
+}
+
+RefCountedPtr<Sector> GalaxyGenerator::GenerateSector(const RefCountedPtr<Galaxy> &galaxy, const SystemPath& path, SectorCache* cache)
 {
 	const Uint32 _init[4] = { Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ), UNIVERSE_SEED };
 	Random rng(_init, 4);
 	SectorConfig config;
 	RefCountedPtr<Sector> sector(new Sector(galaxy, path, cache));
-	for (SectorGeneratorStage* secgen : m_sectorStage)
-		if (!secgen->Apply(rng, galaxy, sector, &config))
+	for (SectorGeneratorStage* secgen : m_sectorStage) {
+		const Uint64 start = s_stageTiming ? SDL_GetPerformanceCounter() : 0;
+		const bool more = secgen->Apply(rng, galaxy, sector, &config);
+		if (s_stageTiming) {
+			secgen->m_timeTicks += SDL_GetPerformanceCounter() - start;
+			++secgen->m_timeCalls;
+		}
+		if (!more)
 			break;
+	}
+	galaxy->GetSystemNameIndex()->AddSector(*sector);
 	return sector;
 }
 
-RefCountedPtr<StarSystem> GalaxyGenerator::GenerateStarSystem(RefCountedPtr<Galaxy> galaxy, const SystemPath& path, StarSystemCache* cache)
+RefCountedPtr<StarSystem> GalaxyGenerator::GenerateStarSystem(const RefCountedPtr<Galaxy> &galaxy, const SystemPath& path, StarSystemCache* cache)
 {
 	RefCountedPtr<const Sector> sec = galaxy->GetSector(path);
 	assert(path.systemIndex >= 0 && path.systemIndex < sec->m_systems.size());
 	Uint32 seed = sec->m_systems[path.systemIndex].GetSeed();
 	std::string name = sec->m_systems[path.systemIndex].GetName();
 	Uint32 _init[6] = { path.systemIndex, Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ), UNIVERSE_SEED, Uint32(seed) };
-	Random rng(_init, 6);
-	StarSystemConfig config;
-	RefCountedPtr<StarSystem::GeneratorAPI> system(new StarSystem::GeneratorAPI(path, galaxy, cache, rng));
-	for (StarSystemGeneratorStage* sysgen : m_starSystemStage)
-		if (!sysgen->Apply(rng, galaxy, system, &config))
-			break;
+	RefCountedPtr<Random> rng(new Random(_init, 6));
+	RefCountedPtr<StarSystem::GeneratorAPI> system(new StarSystem::GeneratorAPI(path, galaxy, cache, *rng));
+	system->m_stage = StarSystem::STAGE_HEADER;
+	system->m_genState.reset(new StarSystem::GenerationState(RefCountedPtr<GalaxyGenerator>(this), rng, m_starSystemStage.begin()));
+	RunStarSystemStages(system.Get(), StarSystem::STAGE_HEADER);
 	return system;
 }
+
+void GalaxyGenerator::RunStarSystemStages(StarSystem::GeneratorAPI* system, StarSystem::GenerationStage stage)
+{
+	PROFILE_SCOPED()
+	StarSystem::GenerationState* state = system->m_genState.get();
+	assert(state && !system->m_generating);
+	RefCountedPtr<StarSystem::GeneratorAPI> sys(system);
+
+	// the stages use the accessors themselves, don't recurse from those
+	system->m_generating = true;
+	auto it = state->nextStage;
+	for (; it != m_starSystemStage.end() && (*it)->GetGenerationStage() <= stage; ++it) {
+		const Uint64 start = s_stageTiming ? SDL_GetPerformanceCounter() : 0;
+		const bool more = (*it)->Apply(*state->rng, system->m_galaxy, sys, &state->config);
+		if (s_stageTiming) {
+			(*it)->m_timeTicks += SDL_GetPerformanceCounter() - start;
+			++(*it)->m_timeCalls;
+		}
+		if (!more) {
+			it = m_starSystemStage.end();
+			break;
+		}
+	}
+	system->m_generating = false;
+
+	if (it == m_starSystemStage.end()) {
+		system->m_stage = StarSystem::STAGE_POPULATED;
+		system->m_genState.reset();
+	} else {
+		system->m_stage = StarSystem::GenerationStage((*it)->GetGenerationStage() - 1);
+		state->nextStage = it;
+	}
+}
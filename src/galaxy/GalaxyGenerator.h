@@ -4,8 +4,10 @@
 #ifndef GALAXYGENERATOR_H
 #define GALAXYGENERATOR_H
 
+#include <atomic>
 #include <list>
 #include <string>
+#include <vector>
 #include "RefCounted.h"
 #include "Serializer.h"
 #include "Sector.h"
@@ -41,20 +43,21 @@ public:
 
 	bool IsDefault() const { return m_name == s_defaultGenerator && m_version == s_defaultVersion; }
 
-	void ToJson(Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy);
-	void FromJson(const Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy);
+	void ToJson(Json::Value &jsonObj, const RefCountedPtr<Galaxy> &galaxy);
+	void FromJson(const Json::Value &jsonObj, const RefCountedPtr<Galaxy> &galaxy);
 
 	// Templated for the template cache class.
 	template <typename T, typename Cache>
-	RefCountedPtr<T> Generate(RefCountedPtr<Galaxy> galaxy, const SystemPath& path, Cache* cache);
+	RefCountedPtr<T> Generate(const RefCountedPtr<Galaxy> &galaxy, const SystemPath& path, Cache* cache);
 
 	GalaxyGenerator* AddSectorStage(SectorGeneratorStage* sectorGenerator);
 	GalaxyGenerator* AddStarSystemStage(StarSystemGeneratorStage* starSystemGenerator);
 
 	struct SectorConfig {
 		bool isCustomOnly;
+		bool isFromStore; // systems were loaded from the SectorStore, don't generate them again
 
-		SectorConfig() : isCustomOnly(false) { }
+		SectorConfig() : isCustomOnly(false), isFromStore(false) { }
 	};
 
 	struct StarSystemConfig {
@@ -63,11 +66,25 @@ public:
 		StarSystemConfig() : isCustomOnly(false) { }
 	};
 
+	// time each stage as it runs, for benchmarking. off normally, the
+	// counters are shared between the job runners
+	static void SetStageTiming(bool enable) { s_stageTiming = enable; }
+	struct StageTime {
+		const char *name;
+		double seconds;
+		Uint32 calls;
+	};
+	std::vector<StageTime> GetStageTimes() const; // sector stages then system stages
+	void ResetStageTimes();
+
 private:
+	friend class StarSystem;
 	GalaxyGenerator(const std::string& name, Version version = LAST_VERSION) : m_name(name), m_version(version) { }
 
-	virtual RefCountedPtr<Sector> GenerateSector(RefCountedPtr<Galaxy> galaxy, const SystemPath& path, SectorCache* cache);
-	virtual RefCountedPtr<StarSystem> GenerateStarSystem(RefCountedPtr<Galaxy> galaxy, const SystemPath& path, StarSystemCache* cache);
+	virtual RefCountedPtr<Sector> GenerateSector(const RefCountedPtr<Galaxy> &galaxy, const SystemPath& path, SectorCache* cache);
+	virtual RefCountedPtr<StarSystem> GenerateStarSystem(const RefCountedPtr<Galaxy> &galaxy, const SystemPath& path, StarSystemCache* cache);
+	// continue generating the system with the stages that belong to stage or earlier
+	void RunStarSystemStages(StarSystem::GeneratorAPI* system, StarSystem::GenerationStage stage);
 
 	const std::string m_name;
 	const Version m_version;
@@ -78,15 +95,16 @@ private:
 	static RefCountedPtr<Galaxy> s_galaxy;
 	static std::string s_defaultGenerator;
 	static Version s_defaultVersion;
+	static bool s_stageTiming;
 };
 
 template <>
-inline RefCountedPtr<Sector> GalaxyGenerator::Generate<Sector,SectorCache>(RefCountedPtr<Galaxy> galaxy, const SystemPath& path, SectorCache* cache) {
+inline RefCountedPtr<Sector> GalaxyGenerator::Generate<Sector,SectorCache>(const RefCountedPtr<Galaxy> &galaxy, const SystemPath& path, SectorCache* cache) {
 	return GenerateSector(galaxy, path, cache);
 }
 
 template <>
-inline RefCountedPtr<StarSystem> GalaxyGenerator::Generate<StarSystem,StarSystemCache>(RefCountedPtr<Galaxy> galaxy, const SystemPath& path, StarSystemCache* cache) {
+inline RefCountedPtr<StarSystem> GalaxyGenerator::Generate<StarSystem,StarSystemCache>(const RefCountedPtr<Galaxy> &galaxy, const SystemPath& path, StarSystemCache* cache) {
 	return GenerateStarSystem(galaxy, path, cache);
 }
 
@@ -94,30 +112,52 @@ class GalaxyGeneratorStage {
 public:
 	virtual ~GalaxyGeneratorStage() { }
 
-	virtual void ToJson(Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy) { }
-	virtual void FromJson(const Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy) { }
+	virtual void ToJson(Json::Value &jsonObj, const RefCountedPtr<Galaxy> &galaxy) { }
+	virtual void FromJson(const Json::Value &jsonObj, const RefCountedPtr<Galaxy> &galaxy) { }
+
+	virtual const char *GetName() const = 0;
 
 protected:
-	GalaxyGeneratorStage() : m_galaxyGenerator(nullptr) { }
+	GalaxyGeneratorStage() : m_galaxyGenerator(nullptr), m_timeTicks(0), m_timeCalls(0) { }
 
 	friend class GalaxyGenerator;
 	void AssignToGalaxyGenerator(GalaxyGenerator* galaxyGenerator) { m_galaxyGenerator = galaxyGenerator; }
 
 	GalaxyGenerator* m_galaxyGenerator;
+
+private:
+	// only counted while stage timing is on
+	std::atomic<Uint64> m_timeTicks;
+	std::atomic<Uint32> m_timeCalls;
 };
 
 class SectorGeneratorStage : public GalaxyGeneratorStage {
 public:
 	virtual ~SectorGeneratorStage() { }
 
-	virtual bool Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig* config) = 0;
+	virtual bool Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<Sector> &sector, GalaxyGenerator::SectorConfig* config) = 0;
 };
 
 class StarSystemGeneratorStage : public GalaxyGeneratorStage {
 public:
 	virtual ~StarSystemGeneratorStage() { }
 
-	virtual bool Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig* config) = 0;
+	virtual bool Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<StarSystem::GeneratorAPI> &system, GalaxyGenerator::StarSystemConfig* config) = 0;
+
+	// the part of the system this stage fills in. stages must be added in
+	// stage order, they only run once something asks for their part
+	virtual StarSystem::GenerationStage GetGenerationStage() const { return StarSystem::STAGE_POPULATED; }
+};
+
+// what's needed to pick up generating a StarSystem where it was left off
+struct StarSystem::GenerationState {
+	GenerationState(RefCountedPtr<GalaxyGenerator> gen, RefCountedPtr<Random> r, std::list<StarSystemGeneratorStage*>::const_iterator next)
+		: generator(gen), rng(r), nextStage(next) { }
+
+	RefCountedPtr<GalaxyGenerator> generator;
+	RefCountedPtr<Random> rng;
+	GalaxyGenerator::StarSystemConfig config;
+	std::list<StarSystemGeneratorStage*>::const_iterator nextStage;
 };
 
 #endif
@@ -0,0 +1,104 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "MarketIndex.h"
+#include "Galaxy.h"
+#include "Sector.h"
+#include "StarSystem.h"
+
+const MarketIndex::BestMarkets& MarketIndex::GetBestMarkets(const SystemPath& from, float range, int jumps)
+{
+	PROFILE_SCOPED()
+	QueryKey key;
+	key.from = from.SystemOnly();
+	key.range = range;
+	key.jumps = jumps;
+
+	auto it = m_queries.find(key);
+	if (it != m_queries.end())
+		return it->second;
+
+	if (m_queries.size() >= MAX_CACHED_QUERIES)
+		m_queries.clear();
+	BestMarkets& best = m_queries[key];
+	FindBestMarkets(key.from, range * float(std::max(jumps, 0)), best);
+	return best;
+}
+
+void MarketIndex::Invalidate(const SystemPath& system)
+{
+	m_systems.erase(system.SystemOnly());
+	// any answer could have included it
+	m_queries.clear();
+}
+
+void MarketIndex::ClearCache()
+{
+	m_systems.clear();
+	m_queries.clear();
+}
+
+const MarketIndex::SystemMarket& MarketIndex::GetSystemMarket(const SystemPath& path)
+{
+	auto it = m_systems.find(path);
+	if (it != m_systems.end())
+		return it->second;
+
+	if (m_systems.size() >= MAX_CACHED_SYSTEMS)
+		m_systems.clear();
+
+	RefCountedPtr<StarSystem> sys = m_galaxy->GetStarSystem(path);
+	SystemMarket& market = m_systems[path];
+	market.hasStations = sys->HasSpaceStations();
+	for (int i = 0; i < GalacticEconomy::COMMODITY_COUNT; i++) {
+		market.priceMod[i] = sys->GetCommodityBasePriceModPercent(GalacticEconomy::Commodity(i));
+		market.legal[i] = sys->IsCommodityLegal(GalacticEconomy::Commodity(i));
+	}
+	return market;
+}
+
+void MarketIndex::FindBestMarkets(const SystemPath& from, float reach, BestMarkets& best)
+{
+	PROFILE_SCOPED()
+	if (!from.HasValidSystem() || reach < 0.0f)
+		return;
+
+	RefCountedPtr<const Sector> fromSec = m_galaxy->GetSector(from);
+	const vector3f fromPos = fromSec->m_systems[from.systemIndex].GetFullPosition();
+	const int secRadius = int(ceilf(reach / Sector::SIZE));
+
+	for (int sx = from.sectorX-secRadius; sx <= from.sectorX+secRadius; sx++) {
+		for (int sy = from.sectorY-secRadius; sy <= from.sectorY+secRadius; sy++) {
+			for (int sz = from.sectorZ-secRadius; sz <= from.sectorZ+secRadius; sz++) {
+				RefCountedPtr<const Sector> sec = m_galaxy->GetSector(SystemPath(sx, sy, sz));
+				for (const Sector::System& secSys : sec->m_systems) {
+					if ((secSys.GetFullPosition() - fromPos).Length() > reach)
+						continue;
+					// systems known to be uninhabited have nowhere to trade, so don't generate them
+					if (secSys.GetPopulation() == fixed(0))
+						continue;
+
+					const SystemPath path(sx, sy, sz, secSys.idx);
+					const SystemMarket& market = GetSystemMarket(path);
+					if (!market.hasStations)
+						continue;
+
+					for (int i = 0; i < GalacticEconomy::COMMODITY_COUNT; i++) {
+						if (!market.legal[i])
+							continue;
+						Market& cheapest = best.cheapest[i];
+						if (!cheapest.system.HasValidSystem() || market.priceMod[i] < cheapest.priceMod) {
+							cheapest.system = path;
+							cheapest.priceMod = market.priceMod[i];
+						}
+						Market& dearest = best.dearest[i];
+						if (!dearest.system.HasValidSystem() || market.priceMod[i] > dearest.priceMod) {
+							dearest.system = path;
+							dearest.priceMod = market.priceMod[i];
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,73 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _MARKETINDEX_H
+#define _MARKETINDEX_H
+
+#include "libs.h"
+#include "galaxy/Economy.h"
+#include "galaxy/SystemPath.h"
+#include <map>
+
+class Galaxy;
+
+// answers "where is the cheapest/dearest place to trade each commodity
+// around here" in one go. the price alterations and legality of every system
+// looked at are kept, as are the answers for each (system, range, jumps), so
+// trade scripts that keep asking about the same neighbourhood stay cheap.
+// nothing in a system's market changes after generation, so entries only go
+// when Invalidate is called for that system or the caches are flushed
+class MarketIndex {
+public:
+	struct Market {
+		Market() : priceMod(0) { }
+		SystemPath system; // invalid if no system in range trades the commodity
+		int priceMod;      // percentage change to the base price
+	};
+
+	struct BestMarkets {
+		Market cheapest[GalacticEconomy::COMMODITY_COUNT];  // best place to buy
+		Market dearest[GalacticEconomy::COMMODITY_COUNT];   // best place to sell
+	};
+
+	MarketIndex(Galaxy* galaxy) : m_galaxy(galaxy) { }
+
+	// best markets among the systems with stations, where the commodity is legal,
+	// no more than jumps hyperspace jumps of range lightyears away. reach is
+	// taken as jumps * range in a straight line, so gaps in the route aren't
+	// accounted for
+	const BestMarkets& GetBestMarkets(const SystemPath& from, float range, int jumps);
+
+	void Invalidate(const SystemPath& system);
+	void ClearCache();
+
+private:
+	static const unsigned MAX_CACHED_SYSTEMS = 16384;
+	static const unsigned MAX_CACHED_QUERIES = 256;
+
+	struct SystemMarket {
+		bool hasStations;
+		int priceMod[GalacticEconomy::COMMODITY_COUNT];
+		bool legal[GalacticEconomy::COMMODITY_COUNT];
+	};
+
+	struct QueryKey {
+		SystemPath from;
+		float range;
+		int jumps;
+		bool operator<(const QueryKey& b) const {
+			if (from != b.from) return from < b.from;
+			if (jumps != b.jumps) return jumps < b.jumps;
+			return range < b.range;
+		}
+	};
+
+	const SystemMarket& GetSystemMarket(const SystemPath& path);
+	void FindBestMarkets(const SystemPath& from, float reach, BestMarkets& best);
+
+	Galaxy* m_galaxy;
+	std::map<SystemPath, SystemMarket> m_systems;
+	std::map<QueryKey, BestMarkets> m_queries;
+};
+
+#endif
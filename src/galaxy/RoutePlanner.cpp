@@ -0,0 +1,140 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "RoutePlanner.h"
+#include "Galaxy.h"
+#include "Sector.h"
+#include <algorithm>
+#include <queue>
+
+const float RoutePlanner::MAX_RANGE = 50.0f;
+
+const RoutePlanner::Route& RoutePlanner::GetRoute(const SystemPath& from, const SystemPath& to, float range)
+{
+	PROFILE_SCOPED()
+	static const Route noRoute;
+	if (!(range > 0.0f))
+		return noRoute; // nan would break the key ordering
+	RouteKey key;
+	key.from = from.SystemOnly();
+	key.to = to.SystemOnly();
+	key.range = std::min(range, MAX_RANGE);
+
+	auto it = m_routes.find(key);
+	if (it != m_routes.end())
+		return it->second;
+
+	if (m_routes.size() >= MAX_CACHED_ROUTES)
+		m_routes.clear();
+	Route& route = m_routes[key];
+	PlanRoute(key.from, key.to, key.range, route);
+	return route;
+}
+
+void RoutePlanner::ClearCache()
+{
+	m_sectors.clear();
+	m_routes.clear();
+}
+
+const std::vector<vector3f>& RoutePlanner::GetSystemPositions(int sx, int sy, int sz)
+{
+	const SystemPath secPath(sx, sy, sz);
+	auto it = m_sectors.find(secPath);
+	if (it != m_sectors.end())
+		return it->second;
+
+	if (m_sectors.size() >= MAX_CACHED_SECTORS)
+		m_sectors.clear();
+
+	RefCountedPtr<const Sector> sec = m_galaxy->GetSector(secPath);
+	std::vector<vector3f>& positions = m_sectors[secPath];
+	positions.reserve(sec->m_systems.size());
+	for (const Sector::System& sys : sec->m_systems)
+		positions.push_back(sys.GetFullPosition());
+	return positions;
+}
+
+bool RoutePlanner::IsExistingSystem(const SystemPath& path)
+{
+	return path.HasValidSystem() && path.systemIndex < GetSystemPositions(path.sectorX, path.sectorY, path.sectorZ).size();
+}
+
+// A* over the systems, with the straight line distance to the destination
+// as the heuristic. edges are found by scanning the sectors within range of
+// each system as it is expanded
+void RoutePlanner::PlanRoute(const SystemPath& from, const SystemPath& to, float range, Route& route)
+{
+	PROFILE_SCOPED()
+	route.clear();
+	if (!(range > 0.0f) || !IsExistingSystem(from) || !IsExistingSystem(to))
+		return;
+	if (from.IsSameSystem(to)) {
+		route.push_back(from);
+		return;
+	}
+
+	struct Node {
+		Node() : cost(0.0f), closed(false) { }
+		float cost;
+		SystemPath parent;
+		bool closed;
+	};
+	typedef std::pair<float, SystemPath> OpenEntry;
+	struct OpenCompare {
+		bool operator()(const OpenEntry& a, const OpenEntry& b) const { return a.first > b.first; }
+	};
+
+	const vector3f goalPos = GetSystemPosition(to);
+	const int secRadius = int(ceilf(range / Sector::SIZE));
+
+	std::map<SystemPath, Node> nodes;
+	std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenCompare> open;
+
+	nodes[from].parent = from;
+	open.push(std::make_pair((goalPos - GetSystemPosition(from)).Length(), from));
+
+	unsigned visited = 0;
+	while (!open.empty() && visited < MAX_SEARCH_NODES) {
+		const SystemPath current = open.top().second;
+		open.pop();
+
+		Node& currentNode = nodes[current];
+		if (currentNode.closed)
+			continue; // stale entry, already reached more cheaply
+		currentNode.closed = true;
+		++visited;
+
+		if (current.IsSameSystem(to)) {
+			for (SystemPath p = to; !p.IsSameSystem(from); p = nodes[p].parent)
+				route.push_back(p);
+			route.push_back(from);
+			std::reverse(route.begin(), route.end());
+			return;
+		}
+
+		const float currentCost = currentNode.cost;
+		const vector3f currentPos = GetSystemPosition(current);
+		for (int x = current.sectorX - secRadius; x <= current.sectorX + secRadius; x++) {
+			for (int y = current.sectorY - secRadius; y <= current.sectorY + secRadius; y++) {
+				for (int z = current.sectorZ - secRadius; z <= current.sectorZ + secRadius; z++) {
+					const std::vector<vector3f>& positions = GetSystemPositions(x, y, z);
+					for (Uint32 idx = 0; idx < positions.size(); idx++) {
+						const float dist = (positions[idx] - currentPos).Length();
+						if (dist > range)
+							continue;
+						const SystemPath next(x, y, z, idx);
+						const float cost = currentCost + dist;
+						auto inserted = nodes.insert(std::make_pair(next, Node()));
+						Node& nextNode = inserted.first->second;
+						if (!inserted.second && (nextNode.closed || nextNode.cost <= cost))
+							continue;
+						nextNode.cost = cost;
+						nextNode.parent = current;
+						open.push(std::make_pair(cost + (goalPos - positions[idx]).Length(), next));
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,65 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _ROUTEPLANNER_H
+#define _ROUTEPLANNER_H
+
+#include "libs.h"
+#include "galaxy/SystemPath.h"
+#include <map>
+#include <vector>
+
+class Galaxy;
+
+// plans multi-jump hyperspace routes. the jump graph is never built as a
+// whole; system positions are pulled out of the sector cache a sector at a
+// time as the search reaches them and kept for later searches. finished
+// routes are memoised by (from, to, range)
+class RoutePlanner {
+public:
+	typedef std::vector<SystemPath> Route;
+
+	// every system expanded scans the (2r+1)^3 sectors around it, so the
+	// range is capped well above what any drive manages
+	static const float MAX_RANGE;
+
+	RoutePlanner(Galaxy* galaxy) : m_galaxy(galaxy) { }
+
+	// the route with the shortest total distance from one system to another
+	// in jumps of at most range lightyears, starting with from and ending with
+	// to. empty if there isn't one, or the search gave up before finding it.
+	// ranges over MAX_RANGE are planned as MAX_RANGE
+	const Route& GetRoute(const SystemPath& from, const SystemPath& to, float range);
+
+	void ClearCache();
+
+private:
+	// the search gives up after visiting this many systems, which is
+	// roughly a 20 jump trip through dense sectors
+	static const unsigned MAX_SEARCH_NODES = 50000;
+	static const unsigned MAX_CACHED_SECTORS = 8192;
+	static const unsigned MAX_CACHED_ROUTES = 256;
+
+	struct RouteKey {
+		SystemPath from, to;
+		float range;
+		bool operator<(const RouteKey& b) const {
+			if (from != b.from) return from < b.from;
+			if (to != b.to) return to < b.to;
+			return range < b.range;
+		}
+	};
+
+	// absolute positions of the systems in a sector, in lightyears
+	const std::vector<vector3f>& GetSystemPositions(int sx, int sy, int sz);
+	// has a system index, and the sector has that many systems
+	bool IsExistingSystem(const SystemPath& path);
+	vector3f GetSystemPosition(const SystemPath& path) { return GetSystemPositions(path.sectorX, path.sectorY, path.sectorZ)[path.systemIndex]; }
+	void PlanRoute(const SystemPath& from, const SystemPath& to, float range, Route& route);
+
+	Galaxy* m_galaxy;
+	std::map<SystemPath, std::vector<vector3f>, SystemPath::LessSectorOnly> m_sectors;
+	std::map<RouteKey, Route> m_routes;
+};
+
+#endif
@@ -15,7 +15,7 @@ const float Sector::SIZE = 8.f;
 
 //////////////////////// Sector
 
-Sector::Sector(RefCountedPtr<Galaxy> galaxy, const SystemPath& path, SectorCache* cache)
+Sector::Sector(const RefCountedPtr<Galaxy> &galaxy, const SystemPath& path, SectorCache* cache)
 	: sx(path.sectorX), sy(path.sectorY), sz(path.sectorZ), m_galaxy(galaxy), m_cache(cache) { }
 
 Sector::~Sector()
@@ -24,7 +24,7 @@ Sector::~Sector()
 		m_cache->RemoveFromAttic(SystemPath(sx, sy, sz));
 }
 
-float Sector::DistanceBetween(RefCountedPtr<const Sector> a, int sysIdxA, RefCountedPtr<const Sector> b, int sysIdxB)
+float Sector::DistanceBetween(const RefCountedPtr<const Sector> &a, int sysIdxA, const RefCountedPtr<const Sector> &b, int sysIdxB)
 {
 	PROFILE_SCOPED()
 	vector3f dv = a->m_systems[sysIdxA].GetPosition() - b->m_systems[sysIdxB].GetPosition();
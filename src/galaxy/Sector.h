@@ -25,7 +25,7 @@ public:
 	static const float SIZE;
 	~Sector();
 
-	static float DistanceBetween(RefCountedPtr<const Sector> a, int sysIdxA, RefCountedPtr<const Sector> b, int sysIdxB);
+	static float DistanceBetween(const RefCountedPtr<const Sector> &a, int sysIdxA, const RefCountedPtr<const Sector> &b, int sysIdxB);
 
 	// Sector is within a bounding rectangle - used for SectorView m_sectorCache pruning.
 	bool WithinBox(const int Xmin, const int Xmax, const int Ymin, const int Ymax, const int Zmin, const int Zmax) const;
@@ -74,6 +74,7 @@ public:
 		friend class SectorCustomSystemsGenerator;
 		friend class SectorRandomSystemsGenerator;
 		friend class SectorPersistenceGenerator;
+		friend class SectorStore;
 
 		void AssignFaction() const;
 
@@ -104,7 +105,7 @@ private:
 	SectorCache* m_cache;
 
 	// Only SectorCache(Job) are allowed to create sectors
-	Sector(RefCountedPtr<Galaxy> galaxy, const SystemPath& path, SectorCache* cache);
+	Sector(const RefCountedPtr<Galaxy> &galaxy, const SystemPath& path, SectorCache* cache);
 	void SetCache(SectorCache* cache) { assert(!m_cache); m_cache = cache; }
 	// sets appropriate factions for all systems in the sector
 };
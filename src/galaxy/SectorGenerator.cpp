@@ -7,6 +7,7 @@
 #include "CustomSystem.h"
 #include "Galaxy.h"
 #include "Factions.h"
+#include "SectorStore.h"
 
 static const unsigned int SYS_NAME_FRAGS = 32;
 static const char *sys_names[SYS_NAME_FRAGS] =
@@ -14,7 +15,7 @@ static const char *sys_names[SYS_NAME_FRAGS] =
   "lia", "an", "ar", "ur", "mi", "in", "ti", "qu", "so", "ed", "ess",
   "ex", "io", "ce", "ze", "fa", "ay", "wa", "da", "ack", "gre" };
 
-bool SectorCustomSystemsGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig* config)
+bool SectorCustomSystemsGenerator::Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<Sector> &sector, GalaxyGenerator::SectorConfig* config)
 {
 	PROFILE_SCOPED()
 
@@ -27,6 +28,11 @@ bool SectorCustomSystemsGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> gala
 		(sz >= -m_customOnlyRadius) && (sz <= m_customOnlyRadius-1))
 		config->isCustomOnly = true;
 
+	if (SectorStore::Load(galaxy, sector)) {
+		config->isFromStore = true;
+		return true;
+	}
+
 	const std::vector<const CustomSystem*> &systems = galaxy->GetCustomSystems()->GetCustomSystemsForSector(sx, sy, sz);
 	if (systems.size() == 0) return true;
 
@@ -64,7 +70,7 @@ bool SectorCustomSystemsGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> gala
 	return true;
 }
 
-const std::string SectorRandomSystemsGenerator::GenName(RefCountedPtr<Galaxy> galaxy, const Sector& sec, Sector::System &sys, int si, Random &rng)
+const std::string SectorRandomSystemsGenerator::GenName(const RefCountedPtr<Galaxy> &galaxy, const Sector& sec, Sector::System &sys, int si, Random &rng)
 {
 	PROFILE_SCOPED()
 	std::string name;
@@ -129,18 +135,23 @@ const std::string SectorRandomSystemsGenerator::GenName(RefCountedPtr<Galaxy> ga
 	}
 }
 
-bool SectorRandomSystemsGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig* config)
+bool SectorRandomSystemsGenerator::Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<Sector> &sector, GalaxyGenerator::SectorConfig* config)
 {
+	if (config->isFromStore)
+		return true;
+
 	/* Always place random systems outside the core custom-only region */
-	if (config->isCustomOnly)
+	if (config->isCustomOnly) {
+		SectorStore::Save(galaxy, sector);
 		return true;
+	}
 
 	const int sx = sector->sx;
 	const int sy = sector->sy;
 	const int sz = sector->sz;
 	const int customCount = sector->m_systems.size();
 
-	int numSystems = (rng.Int32(4,20) * galaxy->GetSectorDensity(sx, sy, sz)) >> 8;
+	int numSystems = (rng.Int32(4,MAX_SYSTEMS) * galaxy->GetSectorDensity(sx, sy, sz)) >> 8;
 
 	for (int i=0; i<numSystems; i++) {
 		Sector::System s(sector.Get(), sx, sy, sz, customCount + i);
@@ -323,6 +334,7 @@ bool SectorRandomSystemsGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> gala
 
 		sector->m_systems.push_back(s);
 	}
+	SectorStore::Save(galaxy, sector);
 	return true;
 }
 
@@ -339,7 +351,7 @@ void SectorPersistenceGenerator::SetExplored(Sector::System* sys, StarSystem::Ex
 	m_exploredSystems.Set(SystemPath(sys->sx, sys->sy, sys->sz, sys->idx), (e == StarSystem::eUNEXPLORED) ? -1 : date);
 }
 
-bool SectorPersistenceGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig* config)
+bool SectorPersistenceGenerator::Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<Sector> &sector, GalaxyGenerator::SectorConfig* config)
 {
 	if (galaxy->IsInitialized()) {
 		for (Sector::System& secsys : sector->m_systems) {
@@ -361,14 +373,14 @@ bool SectorPersistenceGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> galaxy
 	return true;
 }
 
-void SectorPersistenceGenerator::FromJson(const Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy)
+void SectorPersistenceGenerator::FromJson(const Json::Value &jsonObj, const RefCountedPtr<Galaxy> &galaxy)
 {
 	m_exploredSystems.Clear();
 	if (m_version >= 1)
 		m_exploredSystems.FromJson(jsonObj, &m_exploredSystems);
 }
 
-void SectorPersistenceGenerator::ToJson(Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy)
+void SectorPersistenceGenerator::ToJson(Json::Value &jsonObj, const RefCountedPtr<Galaxy> &galaxy)
 {
 	m_exploredSystems.ToJson(jsonObj);
 }
@@ -14,7 +14,8 @@
 class SectorCustomSystemsGenerator : public SectorGeneratorStage {
 public:
 	SectorCustomSystemsGenerator(int customOnlyRadius) : m_customOnlyRadius(customOnlyRadius) { }
-	virtual bool Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig* config);
+	virtual bool Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<Sector> &sector, GalaxyGenerator::SectorConfig* config);
+	virtual const char *GetName() const { return "SectorCustomSystemsGenerator"; }
 
 private:
 	int m_customOnlyRadius;
@@ -22,17 +23,24 @@ private:
 
 class SectorRandomSystemsGenerator : public SectorGeneratorStage {
 public:
-	virtual bool Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig* config);
+	// the most systems a sector gets, at full density
+	static const int MAX_SYSTEMS = 20;
+	// true if a sector this sparse gets no random systems at all
+	static bool IsEmptyDensity(Uint8 density) { return ((MAX_SYSTEMS * int(density)) >> 8) == 0; }
+
+	virtual bool Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<Sector> &sector, GalaxyGenerator::SectorConfig* config);
+	virtual const char *GetName() const { return "SectorRandomSystemsGenerator"; }
 private:
-	const std::string GenName(RefCountedPtr<Galaxy> galaxy, const Sector& sec, Sector::System &sys, int si, Random &rand);
+	const std::string GenName(const RefCountedPtr<Galaxy> &galaxy, const Sector& sec, Sector::System &sys, int si, Random &rand);
 };
 
 class SectorPersistenceGenerator : public SectorGeneratorStage {
 public:
 	SectorPersistenceGenerator(GalaxyGenerator::Version version) : m_version(version) { }
-	virtual bool Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig* config);
-	virtual void FromJson(const Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy);
-	virtual void ToJson(Json::Value &jsonObj, RefCountedPtr<Galaxy> galaxy);
+	virtual bool Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<Sector> &sector, GalaxyGenerator::SectorConfig* config);
+	virtual void FromJson(const Json::Value &jsonObj, const RefCountedPtr<Galaxy> &galaxy);
+	virtual void ToJson(Json::Value &jsonObj, const RefCountedPtr<Galaxy> &galaxy);
+	virtual const char *GetName() const { return "SectorPersistenceGenerator"; }
 
 private:
 	void SetExplored(Sector::System* sys, StarSystem::ExplorationState e, double time);
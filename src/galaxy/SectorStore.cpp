@@ -0,0 +1,199 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "libs.h"
+#include "SectorStore.h"
+#include "Sector.h"
+#include "Galaxy.h"
+#include "CustomSystem.h"
+#include "Factions.h"
+#include "FileSystem.h"
+#include "Pi.h"
+#include "Serializer.h"
+#include "jenkins/lookup3.h"
+
+namespace {
+
+const char STORE_DIR[] = "sectorstore";
+
+// bump this whenever the record layout changes, or the sector generator
+// changes in a way the generator version wouldn't notice
+const Uint32 STORE_VERSION = 1;
+
+struct Header {
+	char magic[4];
+	Uint32 version;
+	Uint32 generatorVersion;
+	Uint32 signatureA;
+	Uint32 signatureB;
+	Uint32 numSystems;
+	Uint32 payloadSize;
+	Uint32 payloadHash;
+};
+
+bool s_enabled = false;
+
+std::string GetStoreFileName(const RefCountedPtr<Galaxy> &galaxy, int sx, int sy, int sz)
+{
+	char buf[128];
+	snprintf(buf, sizeof(buf), "%s_%d_%d_%d_%d.sector",
+		galaxy->GetGeneratorName().c_str(), galaxy->GetGeneratorVersion(), sx, sy, sz);
+	return FileSystem::JoinPath(STORE_DIR, buf);
+}
+
+// hash everything from outside the sector's own seed that the custom and
+// random stages read
+void GetSignature(const RefCountedPtr<Galaxy> &galaxy, int sx, int sy, int sz, Uint32 *sigA, Uint32 *sigB)
+{
+	Serializer::Writer wr;
+	wr.Byte(galaxy->GetSectorDensity(sx, sy, sz));
+
+	const CustomSystemsDatabase::SystemList &custom = galaxy->GetCustomSystems()->GetCustomSystemsForSector(sx, sy, sz);
+	wr.Int32(custom.size());
+	for (const CustomSystem *cs : custom) {
+		wr.String(cs->name);
+		wr.Vector3f(cs->pos);
+		wr.Int32(cs->numStars);
+		for (unsigned i = 0; i < COUNTOF(cs->primaryType); i++)
+			wr.Int32(cs->primaryType[i]);
+		wr.Int32(cs->seed);
+		wr.Bool(cs->explored);
+		wr.Bool(cs->want_rand_explored);
+	}
+
+	const FactionsDatabase *factions = galaxy->GetFactions();
+	for (Uint32 i = 0; i < factions->GetNumFactions(); i++) {
+		const SystemPath &home = factions->GetFaction(i)->homeworld;
+		if (home.IsSameSector(SystemPath(sx, sy, sz)))
+			wr.Int32(home.systemIndex);
+	}
+
+	const std::string &data = wr.GetData();
+	*sigA = *sigB = 0;
+	lookup3_hashlittle2(data.data(), data.size(), sigA, sigB);
+}
+
+Header MakeHeader(Uint32 generatorVersion, Uint32 sigA, Uint32 sigB, Uint32 numSystems, Uint32 payloadSize, Uint32 payloadHash)
+{
+	Header h;
+	memcpy(h.magic, "PSS1", 4);
+	h.version = STORE_VERSION;
+	h.generatorVersion = generatorVersion;
+	h.signatureA = sigA;
+	h.signatureB = sigB;
+	h.numSystems = numSystems;
+	h.payloadSize = payloadSize;
+	h.payloadHash = payloadHash;
+	return h;
+}
+
+}
+
+void SectorStore::Init()
+{
+	s_enabled = Pi::config->Int("SectorStore") != 0;
+	if (s_enabled && !FileSystem::userFiles.MakeDirectory(STORE_DIR)) {
+		Output("SectorStore: couldn't create store directory, disabling\n");
+		s_enabled = false;
+	}
+}
+
+bool SectorStore::IsEnabled()
+{
+	return s_enabled;
+}
+
+bool SectorStore::Load(const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<Sector> &sector)
+{
+	PROFILE_SCOPED()
+	if (!s_enabled) return false;
+	assert(sector->m_systems.empty());
+
+	const int sx = sector->sx;
+	const int sy = sector->sy;
+	const int sz = sector->sz;
+
+	RefCountedPtr<FileSystem::FileData> fd = FileSystem::userFiles.ReadFile(GetStoreFileName(galaxy, sx, sy, sz));
+	if (!fd || fd->GetSize() < sizeof(Header)) return false;
+
+	const char *data = fd->GetData();
+	Header header;
+	memcpy(&header, data, sizeof(Header));
+	// a short file is one that didn't finish being written
+	if (fd->GetSize() != sizeof(Header) + header.payloadSize) return false;
+
+	Uint32 sigA, sigB;
+	GetSignature(galaxy, sx, sy, sz, &sigA, &sigB);
+	const Header expected = MakeHeader(galaxy->GetGeneratorVersion(), sigA, sigB, header.numSystems, header.payloadSize, header.payloadHash);
+	if (memcmp(&header, &expected, sizeof(Header)) != 0) return false;
+	// Serializer::Reader doesn't check for overruns, so make sure the
+	// payload is exactly what was written before reading any of it
+	if (lookup3_hashlittle(data + sizeof(Header), header.payloadSize, 0) != header.payloadHash) return false;
+
+	const CustomSystemsDatabase::SystemList &custom = galaxy->GetCustomSystems()->GetCustomSystemsForSector(sx, sy, sz);
+	Serializer::Reader rd(ByteRange(data + sizeof(Header), data + fd->GetSize()));
+	std::vector<Sector::System> systems;
+	systems.reserve(header.numSystems);
+	for (Uint32 i = 0; i < header.numSystems; i++) {
+		Sector::System s(sector.Get(), sx, sy, sz, i);
+		s.m_name = rd.String();
+		s.m_pos = rd.Vector3f();
+		s.m_numStars = rd.Int32();
+		if (s.m_numStars > COUNTOF(s.m_starType)) return false;
+		for (unsigned j = 0; j < s.m_numStars; j++)
+			s.m_starType[j] = SystemBody::BodyType(rd.Int32());
+		s.m_seed = rd.Int32();
+		const Sint32 customIdx = rd.Int32();
+		if (customIdx >= 0) {
+			if (Uint32(customIdx) >= custom.size()) return false;
+			s.m_customSys = custom[customIdx];
+		}
+		s.m_explored = StarSystem::ExplorationState(rd.Int32());
+		systems.push_back(s);
+	}
+	if (!rd.AtEnd()) return false;
+
+	sector->m_systems.swap(systems);
+	return true;
+}
+
+void SectorStore::Save(const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<const Sector> &sector)
+{
+	PROFILE_SCOPED()
+	if (!s_enabled) return;
+
+	const int sx = sector->sx;
+	const int sy = sector->sy;
+	const int sz = sector->sz;
+
+	const CustomSystemsDatabase::SystemList &custom = galaxy->GetCustomSystems()->GetCustomSystemsForSector(sx, sy, sz);
+	Serializer::Writer wr;
+	for (const Sector::System &s : sector->m_systems) {
+		wr.String(s.m_name);
+		wr.Vector3f(s.m_pos);
+		wr.Int32(s.m_numStars);
+		for (unsigned j = 0; j < s.m_numStars; j++)
+			wr.Int32(s.m_starType[j]);
+		wr.Int32(s.m_seed);
+		Sint32 customIdx = -1;
+		if (s.m_customSys) {
+			auto it = std::find(custom.begin(), custom.end(), s.m_customSys);
+			if (it == custom.end()) return;
+			customIdx = it - custom.begin();
+		}
+		wr.Int32(customIdx);
+		wr.Int32(s.m_explored);
+	}
+	const std::string &payload = wr.GetData();
+
+	Uint32 sigA, sigB;
+	GetSignature(galaxy, sx, sy, sz, &sigA, &sigB);
+	FILE *f = FileSystem::userFiles.OpenWriteStream(GetStoreFileName(galaxy, sx, sy, sz));
+	if (f) {
+		const Header header = MakeHeader(galaxy->GetGeneratorVersion(), sigA, sigB, sector->m_systems.size(),
+			payload.size(), lookup3_hashlittle(payload.data(), payload.size(), 0));
+		fwrite(&header, sizeof(Header), 1, f);
+		fwrite(payload.data(), payload.size(), 1, f);
+		fclose(f);
+	}
+}
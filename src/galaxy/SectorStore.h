@@ -0,0 +1,33 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SECTORSTORE_H
+#define _SECTORSTORE_H
+
+#include "RefCounted.h"
+
+class Galaxy;
+class Sector;
+
+// on-disk store of generated sectors, in the user dir. only the generated
+// part of each system (name, position, stars, seed, starting exploration
+// state) is kept; population, faction and the per-game exploration state are
+// still filled in by the later stages. entries are keyed by generator name
+// and version and carry a signature of the custom systems, factions and
+// density that went into them, so a change to those regenerates the sector.
+// Load and Save are safe to call from the cache jobs
+class SectorStore {
+public:
+	// call from the main thread before any sectors are generated
+	static void Init();
+
+	static bool IsEnabled();
+
+	// fill an empty sector from the store. returns false, leaving it alone,
+	// if the sector isn't there or is stale
+	static bool Load(const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<Sector> &sector);
+
+	static void Save(const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<const Sector> &sector);
+};
+
+#endif
@@ -549,6 +549,7 @@ double SystemBody::CalcSurfaceGravity() const
 SystemBody *StarSystem::GetBodyByPath(const SystemPath &path) const
 {
 	PROFILE_SCOPED()
+	Materialise(STAGE_POPULATED);
 	assert(m_path.IsSameSystem(path));
 	assert(path.IsBodyPath());
 	assert(path.bodyIndex < m_bodies.size());
@@ -561,6 +562,33 @@ SystemPath StarSystem::GetPathOf(const SystemBody *sbody) const
 	return sbody->GetPath();
 }
 
+SystemBodyArena::~SystemBodyArena()
+{
+	for (char *block : m_blocks)
+		delete[] block;
+}
+
+void *SystemBodyArena::Allocate(size_t size)
+{
+	assert(size == sizeof(SystemBody));
+	const size_t slot = sizeof(Header) + sizeof(SystemBody);
+	if (m_used == BLOCK_BODIES) {
+		m_blocks.push_back(new char[slot * BLOCK_BODIES]);
+		m_used = 0;
+	}
+	Header *header = reinterpret_cast<Header*>(m_blocks.back() + slot * m_used++);
+	header->arena = this;
+	IncRefCount();
+	return header + 1;
+}
+
+//static
+void SystemBodyArena::Release(void *p)
+{
+	// the block's given back with the arena, once the last body's gone
+	static_cast<Header*>(p)[-1].arena->DecRefCount();
+}
+
 SystemBody::SystemBody(const SystemPath& path, StarSystem *system) : m_parent(nullptr), m_path(path), m_seed(0), m_aspectRatio(1,1), m_orbMin(0),
 	m_orbMax(0), m_rotationalPhaseAtStart(0), m_semiMajorAxis(0), m_eccentricity(0), m_orbitalOffset(0), m_axialTilt(0),
 	m_inclination(0), m_averageTemp(0), m_type(TYPE_GRAVPOINT), m_isCustomBody(false), m_heightMapFractal(0), m_atmosDensity(0.0), m_system(system)
@@ -646,18 +674,30 @@ SystemBody::AtmosphereParameters SystemBody::CalcAtmosphereParams() const
  *
  * We must be sneaky and avoid floating point in these places.
  */
-StarSystem::StarSystem(const SystemPath &path, RefCountedPtr<Galaxy> galaxy, StarSystemCache* cache, Random& rand)
+StarSystem::StarSystem(const SystemPath &path, const RefCountedPtr<Galaxy> &galaxy, StarSystemCache* cache, Random& rand)
 	: m_galaxy(galaxy), m_path(path.SystemOnly()), m_numStars(0), m_isCustom(false),
 	  m_faction(nullptr), m_explored(eEXPLORED_AT_START), m_exploredTime(0.0), m_econType(GalacticEconomy::ECON_MINING), m_seed(0),
-	  m_commodityLegal(unsigned(GalacticEconomy::Commodity::COMMODITY_COUNT), true), m_cache(cache)
+	  m_commodityLegal(unsigned(GalacticEconomy::Commodity::COMMODITY_COUNT), true), m_cache(cache),
+	  m_stage(STAGE_POPULATED), m_generating(false)
 {
 	PROFILE_SCOPED()
 	memset(m_tradeLevel, 0, sizeof(m_tradeLevel));
 }
 
-StarSystem::GeneratorAPI::GeneratorAPI(const SystemPath &path, RefCountedPtr<Galaxy> galaxy, StarSystemCache* cache, Random& rand)
+StarSystem::GeneratorAPI::GeneratorAPI(const SystemPath &path, const RefCountedPtr<Galaxy> &galaxy, StarSystemCache* cache, Random& rand)
 	: StarSystem(path, galaxy, cache, rand) { }
 
+void StarSystem::RunGeneratorStages(GenerationStage stage)
+{
+	PROFILE_SCOPED()
+	assert(m_genState);
+	// keep the generator alive, finishing generation drops the state
+	RefCountedPtr<GalaxyGenerator> generator = m_genState->generator;
+	generator->RunStarSystemStages(static_cast<GeneratorAPI*>(this), stage);
+	if (m_cache)
+		m_cache->UpdateSize(m_path);
+}
+
 #ifdef DEBUG_DUMP
 struct thing_t {
 	SystemBody* obj;
@@ -760,6 +800,8 @@ void StarSystem::ExploreSystem(double time)
 {
 	if (m_explored != eUNEXPLORED)
 		return;
+	// the short description is made by the populate stage unless it's set already
+	Materialise(STAGE_POPULATED);
 	m_explored = eEXPLORED_BY_PLAYER;
 	m_exploredTime = time;
 	RefCountedPtr<Sector> sec = m_galaxy->GetMutableSector(m_path);
@@ -825,7 +867,8 @@ StarSystem::~StarSystem()
 	PROFILE_SCOPED()
 	// clear parent and children pointers. someone (Lua) might still have a
 	// reference to things that are about to be deleted
-	m_rootBody->ClearParentAndChildPointers();
+	if (m_rootBody)
+		m_rootBody->ClearParentAndChildPointers();
 	if (m_cache)
 		m_cache->RemoveFromAttic(m_path);
 }
@@ -843,11 +886,11 @@ void StarSystem::ToJson(Json::Value &jsonObj, StarSystem *s)
 	}
 }
 
-RefCountedPtr<StarSystem> StarSystem::FromJson(RefCountedPtr<Galaxy> galaxy, const Json::Value &jsonObj)
+RefCountedPtr<StarSystem> StarSystem::FromJson(const RefCountedPtr<Galaxy> &galaxy, const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("star_system")) return RefCountedPtr<StarSystem>(0); // No star system
 
-	Json::Value starSystemObj = jsonObj["star_system"];
+	const Json::Value &starSystemObj = jsonObj["star_system"];
 
 	if (!starSystemObj.isMember("sector_x")) throw SavedGameCorruptException();
 	if (!starSystemObj.isMember("sector_y")) throw SavedGameCorruptException();
@@ -982,6 +1025,7 @@ std::string StarSystem::GetStarTypes(SystemBody *body) {
 }
 
 void StarSystem::ExportToLua(const char *filename) {
+	Materialise(STAGE_POPULATED);
 	FILE *f = fopen(filename,"w");
 	int j;
 
@@ -1017,6 +1061,7 @@ void StarSystem::ExportToLua(const char *filename) {
 
 void StarSystem::Dump(FILE* file, const char* indent, bool suppressSectorData) const
 {
+	Materialise(STAGE_POPULATED);
 	if (suppressSectorData) {
 		fprintf(file, "%sStarSystem {%s\n", indent, m_hasCustomBodies ? " CUSTOM-ONLY" : m_isCustom ? " CUSTOM" : "");
 	} else {
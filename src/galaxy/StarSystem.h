@@ -8,6 +8,7 @@
 #include "galaxy/Economy.h"
 #include "Polit.h"
 #include "Serializer.h"
+#include <memory>
 #include <vector>
 #include <string>
 #include "RefCounted.h"
@@ -29,6 +30,31 @@ class SystemBody;
 class StarSystem;
 class Faction;
 
+// a system's bodies are made here, a block of them at a time, so they sit
+// together in memory rather than wherever the heap put each one. bodies can
+// outlive their system, so each one holds a reference to the arena until
+// it's deleted
+class SystemBodyArena : public RefCounted {
+public:
+	SystemBodyArena() : m_used(BLOCK_BODIES) {}
+	~SystemBodyArena();
+
+	void *Allocate(size_t size);
+	static void Release(void *p);
+
+private:
+	static const unsigned BLOCK_BODIES = 16;
+	// ahead of each body, kept to the alignment of anything in it
+	union Header {
+		SystemBodyArena *arena;
+		double align;
+		Uint64 align64;
+	};
+
+	std::vector<char*> m_blocks;
+	unsigned m_used;
+};
+
 struct RingStyle {
 	// note: radius values are given as proportions of the planet radius
 	// (e.g., 1.6)
@@ -41,6 +67,11 @@ class SystemBody : public RefCounted {
 public:
 	SystemBody(const SystemPath& path, StarSystem *system);
 
+	// only made by StarSystem::NewBody, from the system's arena
+	static void *operator new(size_t size, SystemBodyArena *arena) { return arena->Allocate(size); }
+	static void operator delete(void *p, SystemBodyArena *) { SystemBodyArena::Release(p); }
+	static void operator delete(void *p) { SystemBodyArena::Release(p); }
+
 	enum BodyType { // <enum scope='SystemBody' prefix=TYPE_ public>
 		TYPE_GRAVPOINT = 0,
 		TYPE_BROWN_DWARF = 1, //  L+T Class Brown Dwarfs
@@ -287,7 +318,9 @@ class StarSystem : public RefCounted {
 public:
 	friend class SystemBody;
 	friend class GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>;
+	friend class GalaxyGenerator;
 	class GeneratorAPI; // Complete definition below
+	struct GenerationState; // Defined in GalaxyGenerator.h
 
 	enum ExplorationState {
 		eUNEXPLORED = 0,
@@ -295,41 +328,59 @@ public:
 		eEXPLORED_AT_START = 2
 	};
 
+	// systems are generated in stages. the header (name, seed, faction,
+	// exploration state) comes first; the body tree and population are
+	// generated the first time something that needs them is asked for, if
+	// the cache fill job that made the system didn't already do it
+	enum GenerationStage {
+		STAGE_HEADER = 0,
+		STAGE_BODIES = 1,    // stars and planets, metallicity
+		STAGE_POPULATED = 2  // population, economy, starports; the body tree is final
+	};
+	GenerationStage GetGenerationStage() const { return m_stage; }
+	void Materialise(GenerationStage stage) const {
+		if (m_stage < stage && !m_generating) const_cast<StarSystem*>(this)->RunGeneratorStages(stage);
+	}
+
 	void ExportToLua(const char *filename);
 
 	const std::string &GetName() const { return m_name; }
 	SystemPath GetPathOf(const SystemBody *sbody) const;
 	SystemBody *GetBodyByPath(const SystemPath &path) const;
 	static void ToJson(Json::Value &jsonObj, StarSystem *);
-	static RefCountedPtr<StarSystem> FromJson(RefCountedPtr<Galaxy> galaxy, const Json::Value &jsonObj);
+	static RefCountedPtr<StarSystem> FromJson(const RefCountedPtr<Galaxy> &galaxy, const Json::Value &jsonObj);
 	const SystemPath &GetPath() const { return m_path; }
-	const std::string& GetShortDescription() const { return m_shortDesc; }
-	const std::string& GetLongDescription() const { return m_longDesc; }
-	unsigned GetNumStars() const { return m_numStars; }
-	const SysPolit &GetSysPolit() const { return m_polit; }
+	const std::string& GetShortDescription() const { Materialise(STAGE_POPULATED); return m_shortDesc; }
+	const std::string& GetLongDescription() const { Materialise(STAGE_BODIES); return m_longDesc; }
+	unsigned GetNumStars() const { Materialise(STAGE_BODIES); return m_numStars; }
+	const SysPolit &GetSysPolit() const { Materialise(STAGE_POPULATED); return m_polit; }
 
 	static const Color starColors[];
 	static const Color starRealColors[];
 	static const double starLuminosities[];
 	static const float starScale[];
 
-	RefCountedPtr<const SystemBody> GetRootBody() const { return m_rootBody; }
-	RefCountedPtr<SystemBody> GetRootBody() { return m_rootBody; }
-	bool HasSpaceStations() const { return !m_spaceStations.empty(); }
-	unsigned GetNumSpaceStations() const { return m_spaceStations.size(); }
-	IterationProxy<std::vector<SystemBody*> > GetSpaceStations() { return MakeIterationProxy(m_spaceStations); }
-	const IterationProxy<const std::vector<SystemBody*> > GetSpaceStations() const { return MakeIterationProxy(m_spaceStations); }
-	IterationProxy<std::vector<SystemBody*> > GetStars() { return MakeIterationProxy(m_stars); }
-	const IterationProxy<const std::vector<SystemBody*> > GetStars() const { return MakeIterationProxy(m_stars); }
-	unsigned GetNumBodies() const { return m_bodies.size(); }
-	IterationProxy<std::vector<RefCountedPtr<SystemBody> > > GetBodies() { return MakeIterationProxy(m_bodies); }
-	const IterationProxy<const std::vector<RefCountedPtr<SystemBody> > > GetBodies() const { return MakeIterationProxy(m_bodies); }
+	// bodies handed out from here may be looked at in any way, so anything
+	// that reaches the body tree waits for the populated stage
+	RefCountedPtr<const SystemBody> GetRootBody() const { Materialise(STAGE_POPULATED); return m_rootBody; }
+	RefCountedPtr<SystemBody> GetRootBody() { Materialise(STAGE_POPULATED); return m_rootBody; }
+	bool HasSpaceStations() const { Materialise(STAGE_POPULATED); return !m_spaceStations.empty(); }
+	unsigned GetNumSpaceStations() const { Materialise(STAGE_POPULATED); return m_spaceStations.size(); }
+	IterationProxy<std::vector<SystemBody*> > GetSpaceStations() { Materialise(STAGE_POPULATED); return MakeIterationProxy(m_spaceStations); }
+	const IterationProxy<const std::vector<SystemBody*> > GetSpaceStations() const { Materialise(STAGE_POPULATED); return MakeIterationProxy(m_spaceStations); }
+	IterationProxy<std::vector<SystemBody*> > GetStars() { Materialise(STAGE_POPULATED); return MakeIterationProxy(m_stars); }
+	const IterationProxy<const std::vector<SystemBody*> > GetStars() const { Materialise(STAGE_POPULATED); return MakeIterationProxy(m_stars); }
+	unsigned GetNumBodies() const { Materialise(STAGE_POPULATED); return m_bodies.size(); }
+	IterationProxy<std::vector<RefCountedPtr<SystemBody> > > GetBodies() { Materialise(STAGE_POPULATED); return MakeIterationProxy(m_bodies); }
+	const IterationProxy<const std::vector<RefCountedPtr<SystemBody> > > GetBodies() const { Materialise(STAGE_POPULATED); return MakeIterationProxy(m_bodies); }
 
 	bool IsCommodityLegal(const GalacticEconomy::Commodity t) {
+		Materialise(STAGE_POPULATED);
 		return m_commodityLegal[int(t)];
 	}
 
 	int GetCommodityBasePriceModPercent(GalacticEconomy::Commodity t) {
+		Materialise(STAGE_POPULATED);
 		return m_tradeLevel[int(t)];
 	}
 
@@ -339,25 +390,27 @@ public:
 	double GetExploredTime() const { return m_exploredTime; }
 	void ExploreSystem(double time);
 
-	fixed GetMetallicity() const { return m_metallicity; }
-	fixed GetIndustrial() const { return m_industrial; }
-	fixed GetAgricultural() const { return m_agricultural; }
-	GalacticEconomy::EconType GetEconType() const { return m_econType; }
-	const int* GetTradeLevel() const { return m_tradeLevel; }
+	fixed GetMetallicity() const { Materialise(STAGE_BODIES); return m_metallicity; }
+	fixed GetIndustrial() const { Materialise(STAGE_POPULATED); return m_industrial; }
+	fixed GetAgricultural() const { Materialise(STAGE_POPULATED); return m_agricultural; }
+	GalacticEconomy::EconType GetEconType() const { Materialise(STAGE_POPULATED); return m_econType; }
+	const int* GetTradeLevel() const { Materialise(STAGE_POPULATED); return m_tradeLevel; }
 	int GetSeed() const { return m_seed; }
-	fixed GetHumanProx() const { return m_humanProx; }
-	fixed GetTotalPop() const { return m_totalPop; }
+	fixed GetHumanProx() const { Materialise(STAGE_POPULATED); return m_humanProx; }
+	fixed GetTotalPop() const { Materialise(STAGE_POPULATED); return m_totalPop; }
 
 	void Dump(FILE* file, const char* indent = "", bool suppressSectorData = false) const;
 
 	const RefCountedPtr<Galaxy> m_galaxy;
 
 protected:
-	StarSystem(const SystemPath &path, RefCountedPtr<Galaxy> galaxy, StarSystemCache* cache, Random& rand);
+	StarSystem(const SystemPath &path, const RefCountedPtr<Galaxy> &galaxy, StarSystemCache* cache, Random& rand);
 	virtual ~StarSystem();
 
 	SystemBody *NewBody() {
-		SystemBody *body = new SystemBody(SystemPath(m_path.sectorX, m_path.sectorY, m_path.sectorZ, m_path.systemIndex, m_bodies.size()), this);
+		if (!m_bodyArena)
+			m_bodyArena.Reset(new SystemBodyArena);
+		SystemBody *body = new (m_bodyArena.Get()) SystemBody(SystemPath(m_path.sectorX, m_path.sectorY, m_path.sectorZ, m_path.systemIndex, m_bodies.size()), this);
 		m_bodies.push_back(RefCountedPtr<SystemBody>(body));
 		return body;
 	}
@@ -367,6 +420,7 @@ protected:
 
 private:
 	void SetCache(StarSystemCache* cache) { assert(!m_cache); m_cache = cache; }
+	void RunGeneratorStages(GenerationStage stage);
 
 	std::string ExportBodyToLua(FILE *f, SystemBody *body);
 	std::string GetStarTypes(SystemBody *body);
@@ -395,6 +449,7 @@ private:
 	fixed m_humanProx;
 	fixed m_totalPop;
 
+	RefCountedPtr<SystemBodyArena> m_bodyArena;
 	RefCountedPtr<SystemBody> m_rootBody;
 	// index into this will be the SystemBody ID used by SystemPath
 	std::vector< RefCountedPtr<SystemBody> > m_bodies;
@@ -403,12 +458,16 @@ private:
 	std::vector<bool> m_commodityLegal;
 
 	StarSystemCache* m_cache;
+
+	GenerationStage m_stage;
+	bool m_generating;
+	std::unique_ptr<GenerationState> m_genState; // only until fully generated
 };
 
 class StarSystem::GeneratorAPI : public StarSystem {
 private:
 	friend class GalaxyGenerator;
-	GeneratorAPI(const SystemPath &path, RefCountedPtr<Galaxy> galaxy, StarSystemCache* cache, Random& rand);
+	GeneratorAPI(const SystemPath &path, const RefCountedPtr<Galaxy> &galaxy, StarSystemCache* cache, Random& rand);
 
 public:
 	bool HasCustomBodies() const { return m_hasCustomBodies; }
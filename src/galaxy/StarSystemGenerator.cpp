@@ -279,7 +279,7 @@ const StarSystemLegacyGeneratorBase::StarTypeInfo StarSystemLegacyGeneratorBase:
 };
 
 
-bool StarSystemFromSectorGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig* config)
+bool StarSystemFromSectorGenerator::Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<StarSystem::GeneratorAPI> &system, GalaxyGenerator::StarSystemConfig* config)
 {
 	PROFILE_SCOPED()
 	RefCountedPtr<const Sector> sec = galaxy->GetSector(system->GetPath());
@@ -460,7 +460,7 @@ fixed StarSystemLegacyGeneratorBase::CalcHillRadius(SystemBody* sbody) const
 }
 
 
-void StarSystemCustomGenerator::CustomGetKidsOf(RefCountedPtr<StarSystem::GeneratorAPI> system, SystemBody *parent,
+void StarSystemCustomGenerator::CustomGetKidsOf(const RefCountedPtr<StarSystem::GeneratorAPI> &system, SystemBody *parent,
 	const std::vector<CustomSystemBody*> &children, int *outHumanInfestedness, Random &rand)
 {
 	PROFILE_SCOPED()
@@ -573,7 +573,7 @@ void StarSystemCustomGenerator::CustomGetKidsOf(RefCountedPtr<StarSystem::Genera
 	}
 }
 
-bool StarSystemCustomGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig* config)
+bool StarSystemCustomGenerator::Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<StarSystem::GeneratorAPI> &system, GalaxyGenerator::StarSystemConfig* config)
 {
 	PROFILE_SCOPED()
 	RefCountedPtr<const Sector> sec = galaxy->GetSector(system->GetPath());
@@ -969,7 +969,7 @@ static fixed get_disc_density(SystemBody *primary, fixed discMin, fixed discMax,
 	return primary->GetMassInEarths() * percentOfPrimaryMass / total;
 }
 
-void StarSystemRandomGenerator::MakePlanetsAround(RefCountedPtr<StarSystem::GeneratorAPI> system, SystemBody *primary, Random &rand)
+void StarSystemRandomGenerator::MakePlanetsAround(const RefCountedPtr<StarSystem::GeneratorAPI> &system, SystemBody *primary, Random &rand)
 {
 	PROFILE_SCOPED()
 	fixed discMin = fixed();
@@ -1216,7 +1216,7 @@ void StarSystemRandomGenerator::MakeBinaryPair(SystemBody *a, SystemBody *b, fix
 	b->m_orbMax = orbMax;
 }
 
-bool StarSystemRandomGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig* config)
+bool StarSystemRandomGenerator::Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<StarSystem::GeneratorAPI> &system, GalaxyGenerator::StarSystemConfig* config)
 {
 	PROFILE_SCOPED()
 	RefCountedPtr<const Sector> sec = galaxy->GetSector(system->GetPath());
@@ -1625,7 +1625,7 @@ void PopulateStarSystemGenerator::PopulateAddStations(SystemBody* sbody, StarSys
 	}
 }
 
-void PopulateStarSystemGenerator::SetSysPolit(RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, const fixed &human_infestedness)
+void PopulateStarSystemGenerator::SetSysPolit(const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<StarSystem::GeneratorAPI> &system, const fixed &human_infestedness)
 {
 	SystemPath path = system->GetPath();
 	const Uint32 _init[5] = { Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ), path.systemIndex, POLIT_SEED };
@@ -1662,7 +1662,7 @@ void PopulateStarSystemGenerator::SetSysPolit(RefCountedPtr<Galaxy> galaxy, RefC
 	system->SetSysPolit(sysPolit);
 }
 
-void PopulateStarSystemGenerator::SetCommodityLegality(RefCountedPtr<StarSystem::GeneratorAPI> system)
+void PopulateStarSystemGenerator::SetCommodityLegality(const RefCountedPtr<StarSystem::GeneratorAPI> &system)
 {
 	const SystemPath path = system->GetPath();
 	const Uint32 _init[5] = { Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ), path.systemIndex, POLIT_SALT };
@@ -1685,7 +1685,7 @@ void PopulateStarSystemGenerator::SetCommodityLegality(RefCountedPtr<StarSystem:
 	}
 }
 
-void PopulateStarSystemGenerator::SetEconType(RefCountedPtr<StarSystem::GeneratorAPI> system)
+void PopulateStarSystemGenerator::SetEconType(const RefCountedPtr<StarSystem::GeneratorAPI> &system)
 {
 	if ((system->GetIndustrial() > system->GetMetallicity()) && (system->GetIndustrial() > system->GetAgricultural())) {
 		system->SetEconType(GalacticEconomy::ECON_INDUSTRY);
@@ -1699,7 +1699,7 @@ void PopulateStarSystemGenerator::SetEconType(RefCountedPtr<StarSystem::Generato
 /* percent */
 static const int MAX_COMMODITY_BASE_PRICE_ADJUSTMENT = 25;
 
-bool PopulateStarSystemGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system,
+bool PopulateStarSystemGenerator::Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<StarSystem::GeneratorAPI> &system,
 		GalaxyGenerator::StarSystemConfig* config)
 {
 	PROFILE_SCOPED()
@@ -9,7 +9,9 @@
 
 class StarSystemFromSectorGenerator : public StarSystemGeneratorStage {
 public:
-	virtual bool Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig* config);
+	virtual bool Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<StarSystem::GeneratorAPI> &system, GalaxyGenerator::StarSystemConfig* config);
+	virtual const char *GetName() const { return "StarSystemFromSectorGenerator"; }
+	virtual StarSystem::GenerationStage GetGenerationStage() const { return StarSystem::STAGE_HEADER; }
 };
 
 class StarSystemLegacyGeneratorBase : public StarSystemGeneratorStage {
@@ -30,18 +32,22 @@ protected:
 
 class StarSystemCustomGenerator : public StarSystemLegacyGeneratorBase {
 public:
-	virtual bool Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig* config);
+	virtual bool Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<StarSystem::GeneratorAPI> &system, GalaxyGenerator::StarSystemConfig* config);
+	virtual const char *GetName() const { return "StarSystemCustomGenerator"; }
+	virtual StarSystem::GenerationStage GetGenerationStage() const { return StarSystem::STAGE_BODIES; }
 
 private:
-	void CustomGetKidsOf(RefCountedPtr<StarSystem::GeneratorAPI> system, SystemBody *parent, const std::vector<CustomSystemBody*> &children, int *outHumanInfestedness, Random &rand);
+	void CustomGetKidsOf(const RefCountedPtr<StarSystem::GeneratorAPI> &system, SystemBody *parent, const std::vector<CustomSystemBody*> &children, int *outHumanInfestedness, Random &rand);
 };
 
 class StarSystemRandomGenerator : public StarSystemLegacyGeneratorBase {
 public:
-	virtual bool Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig* config);
+	virtual bool Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<StarSystem::GeneratorAPI> &system, GalaxyGenerator::StarSystemConfig* config);
+	virtual const char *GetName() const { return "StarSystemRandomGenerator"; }
+	virtual StarSystem::GenerationStage GetGenerationStage() const { return StarSystem::STAGE_BODIES; }
 
 private:
-	void MakePlanetsAround(RefCountedPtr<StarSystem::GeneratorAPI> system, SystemBody *primary, Random &rand);
+	void MakePlanetsAround(const RefCountedPtr<StarSystem::GeneratorAPI> &system, SystemBody *primary, Random &rand);
 	void MakeRandomStar(SystemBody *sbody, Random &rand);
 	void MakeStarOfType(SystemBody *sbody, SystemBody::BodyType type, Random &rand);
 	void MakeStarOfTypeLighterThan(SystemBody *sbody, SystemBody::BodyType type, fixed maxMass, Random &rand);
@@ -54,12 +60,13 @@ private:
 
 class PopulateStarSystemGenerator : public StarSystemLegacyGeneratorBase {
 public:
-	virtual bool Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig* config);
+	virtual bool Apply(Random& rng, const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<StarSystem::GeneratorAPI> &system, GalaxyGenerator::StarSystemConfig* config);
+	virtual const char *GetName() const { return "PopulateStarSystemGenerator"; }
 
 private:
-	void SetSysPolit(RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, const fixed &human_infestedness);
-	void SetCommodityLegality(RefCountedPtr<StarSystem::GeneratorAPI> system);
-	void SetEconType(RefCountedPtr<StarSystem::GeneratorAPI> system);
+	void SetSysPolit(const RefCountedPtr<Galaxy> &galaxy, const RefCountedPtr<StarSystem::GeneratorAPI> &system, const fixed &human_infestedness);
+	void SetCommodityLegality(const RefCountedPtr<StarSystem::GeneratorAPI> &system);
+	void SetEconType(const RefCountedPtr<StarSystem::GeneratorAPI> &system);
 
 	void PopulateAddStations(SystemBody* sbody, StarSystem::GeneratorAPI* system);
 	void PositionSettlementOnPlanet(SystemBody* sbody);
@@ -0,0 +1,262 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "SystemNameIndex.h"
+#include "Galaxy.h"
+#include "Sector.h"
+#include "SectorStore.h"
+#include "FileSystem.h"
+#include "Serializer.h"
+#include "jenkins/lookup3.h"
+#include <cctype>
+
+namespace {
+
+const char STORE_DIR[] = "sectorstore";
+
+// bump this if the layout changes
+const Uint32 INDEX_VERSION = 1;
+
+struct Header {
+	char magic[4];
+	Uint32 version;
+	Uint32 generatorVersion;
+	Uint32 numSectors;
+	Uint32 payloadSize;
+	Uint32 payloadHash;
+};
+
+std::string Fold(const std::string &s)
+{
+	std::string out(s);
+	for (char &c : out)
+		c = tolower(static_cast<unsigned char>(c));
+	return out;
+}
+
+inline Uint32 Trigram(const char *s)
+{
+	return Uint32(Uint8(s[0])) | (Uint32(Uint8(s[1])) << 8) | (Uint32(Uint8(s[2])) << 16);
+}
+
+// shortest name wins, then the lowest path, so the answer doesn't depend on
+// the order sectors were generated in
+inline bool IsBetter(const std::string &name, const SystemPath &path, const std::string *bestName, const SystemPath &bestPath)
+{
+	if (!bestName) return true;
+	if (name.size() != bestName->size()) return name.size() < bestName->size();
+	return path < bestPath;
+}
+
+}
+
+SystemNameIndex::SystemNameIndex(Galaxy* galaxy) :
+	m_galaxy(galaxy),
+	m_dirty(false)
+{
+	m_lock = SDL_CreateMutex();
+}
+
+SystemNameIndex::~SystemNameIndex()
+{
+	SDL_DestroyMutex(m_lock);
+}
+
+std::string SystemNameIndex::GetFileName() const
+{
+	char buf[128];
+	snprintf(buf, sizeof(buf), "%s_%d.names", m_galaxy->GetGeneratorName().c_str(), m_galaxy->GetGeneratorVersion());
+	return FileSystem::JoinPath(STORE_DIR, buf);
+}
+
+void SystemNameIndex::Load()
+{
+	PROFILE_SCOPED()
+	if (!SectorStore::IsEnabled()) return;
+
+	RefCountedPtr<FileSystem::FileData> fd = FileSystem::userFiles.ReadFile(GetFileName());
+	if (!fd || fd->GetSize() < sizeof(Header)) return;
+
+	const char *data = fd->GetData();
+	Header header;
+	memcpy(&header, data, sizeof(Header));
+	if (memcmp(header.magic, "PSN1", 4) != 0 || header.version != INDEX_VERSION) return;
+	if (header.generatorVersion != Uint32(m_galaxy->GetGeneratorVersion())) return;
+	// Serializer::Reader doesn't check for overruns, so make sure the
+	// payload is exactly what was written before reading any of it
+	if (fd->GetSize() != sizeof(Header) + header.payloadSize) return;
+	if (lookup3_hashlittle(data + sizeof(Header), header.payloadSize, 0) != header.payloadHash) return;
+
+	Serializer::Reader rd(ByteRange(data + sizeof(Header), data + fd->GetSize()));
+	SDL_LockMutex(m_lock);
+	std::vector<std::string> names;
+	for (Uint32 i = 0; i < header.numSectors; i++) {
+		const Sint32 sx = rd.Int32();
+		const Sint32 sy = rd.Int32();
+		const Sint32 sz = rd.Int32();
+		const Uint32 numSystems = rd.Int32();
+		names.resize(numSystems);
+		for (Uint32 j = 0; j < numSystems; j++)
+			names[j] = rd.String();
+		AddSectorLocked(SystemPath(sx, sy, sz), names);
+	}
+	m_dirty = false;
+	SDL_UnlockMutex(m_lock);
+
+	Output("SystemNameIndex: %u sectors, " SIZET_FMT " systems\n", header.numSectors, m_entries.size());
+}
+
+void SystemNameIndex::Save()
+{
+	PROFILE_SCOPED()
+	if (!SectorStore::IsEnabled()) return;
+
+	SDL_LockMutex(m_lock);
+	if (!m_dirty) {
+		SDL_UnlockMutex(m_lock);
+		return;
+	}
+	Serializer::Writer wr;
+	for (const auto &sector : m_sectors) {
+		wr.Int32(sector.first.sectorX);
+		wr.Int32(sector.first.sectorY);
+		wr.Int32(sector.first.sectorZ);
+		wr.Int32(sector.second.size());
+		for (Uint32 idx : sector.second)
+			wr.String(m_entries[idx].name);
+	}
+	const Uint32 numSectors = m_sectors.size();
+	m_dirty = false;
+	SDL_UnlockMutex(m_lock);
+
+	const std::string &payload = wr.GetData();
+	FILE *f = FileSystem::userFiles.OpenWriteStream(GetFileName());
+	if (!f) return;
+	Header header;
+	memcpy(header.magic, "PSN1", 4);
+	header.version = INDEX_VERSION;
+	header.generatorVersion = m_galaxy->GetGeneratorVersion();
+	header.numSectors = numSectors;
+	header.payloadSize = payload.size();
+	header.payloadHash = lookup3_hashlittle(payload.data(), payload.size(), 0);
+	fwrite(&header, sizeof(Header), 1, f);
+	fwrite(payload.data(), payload.size(), 1, f);
+	fclose(f);
+}
+
+void SystemNameIndex::AddSector(const Sector &sector)
+{
+	std::vector<std::string> names;
+	names.reserve(sector.m_systems.size());
+	for (const Sector::System &s : sector.m_systems)
+		names.push_back(s.GetName());
+
+	SDL_LockMutex(m_lock);
+	AddSectorLocked(SystemPath(sector.sx, sector.sy, sector.sz), names);
+	SDL_UnlockMutex(m_lock);
+}
+
+void SystemNameIndex::AddSectorLocked(const SystemPath &sectorPath, const std::vector<std::string> &names)
+{
+	std::vector<Uint32> &sector = m_sectors[sectorPath];
+
+	// most of the time it's a sector coming back into the cache, as it was
+	if (sector.size() == names.size()) {
+		bool same = true;
+		for (Uint32 i = 0; i < names.size() && same; i++)
+			same = m_entries[sector[i]].name == names[i];
+		if (same) return;
+	}
+
+	// otherwise the old names go. their index entries stay behind, and
+	// are skipped
+	for (Uint32 idx : sector)
+		m_entries[idx].live = false;
+	sector.clear();
+
+	for (Uint32 i = 0; i < names.size(); i++) {
+		const Uint32 idx = m_entries.size();
+		Entry e;
+		e.name = names[i];
+		e.folded = Fold(names[i]);
+		e.path = SystemPath(sectorPath.sectorX, sectorPath.sectorY, sectorPath.sectorZ, i);
+		e.live = true;
+		m_entries.push_back(e);
+		sector.push_back(idx);
+
+		const std::string &folded = m_entries.back().folded;
+		m_byName.insert(std::make_pair(folded, idx));
+		for (size_t j = 0; j + 3 <= folded.size(); j++) {
+			std::vector<Uint32> &list = m_trigrams[Trigram(&folded[j])];
+			// a name with the same run twice only needs listing once
+			if (list.empty() || list.back() != idx)
+				list.push_back(idx);
+		}
+	}
+	m_dirty = true;
+}
+
+SystemNameIndex::MatchType SystemNameIndex::Find(const std::string &search, SystemPath &match, std::string &matchName) const
+{
+	PROFILE_SCOPED()
+	if (search.empty()) return NO_MATCH;
+	const std::string folded = Fold(search);
+
+	SDL_LockMutex(m_lock);
+
+	MatchType type = NO_MATCH;
+	const std::string *bestName = 0;
+	SystemPath bestPath;
+
+	// everything starting with the search is together in the map
+	for (auto it = m_byName.lower_bound(folded); it != m_byName.end() && it->first.compare(0, folded.size(), folded) == 0; ++it) {
+		const Entry &e = m_entries[it->second];
+		if (!e.live) continue;
+		if (e.folded.size() == folded.size()) {
+			type = EXACT_MATCH;
+			bestName = &e.name;
+			bestPath = e.path;
+			break;
+		}
+		if (IsBetter(e.name, e.path, bestName, bestPath)) {
+			type = START_MATCH;
+			bestName = &e.name;
+			bestPath = e.path;
+		}
+	}
+
+	if (type == NO_MATCH) {
+		// anywhere in the name. with three letters or more, only the names
+		// with the search's rarest run of three can match
+		const std::vector<Uint32> *candidates = 0;
+		if (folded.size() >= 3) {
+			for (size_t j = 0; j + 3 <= folded.size(); j++) {
+				auto list = m_trigrams.find(Trigram(&folded[j]));
+				if (list == m_trigrams.end()) {
+					SDL_UnlockMutex(m_lock);
+					return NO_MATCH;
+				}
+				if (!candidates || list->second.size() < candidates->size())
+					candidates = &list->second;
+			}
+		}
+
+		const Uint32 count = candidates ? candidates->size() : m_entries.size();
+		for (Uint32 i = 0; i < count; i++) {
+			const Entry &e = m_entries[candidates ? (*candidates)[i] : i];
+			if (!e.live || e.folded.find(folded) == std::string::npos) continue;
+			if (IsBetter(e.name, e.path, bestName, bestPath)) {
+				type = CONTAINS_MATCH;
+				bestName = &e.name;
+				bestPath = e.path;
+			}
+		}
+	}
+
+	if (bestName) {
+		match = bestPath;
+		matchName = *bestName;
+	}
+	SDL_UnlockMutex(m_lock);
+	return type;
+}
@@ -0,0 +1,66 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SYSTEMNAMEINDEX_H
+#define _SYSTEMNAMEINDEX_H
+
+#include "libs.h"
+#include "galaxy/SystemPath.h"
+#include <map>
+#include <unordered_map>
+
+class Galaxy;
+class Sector;
+
+// the name of every system in every sector that has been generated, for the
+// sector view search. sectors are added as they're generated (from the cache
+// jobs, so that's locked) and, with the sector store on, the index is kept
+// next to it in the user dir so searches cover everything that has ever been
+// generated, not just what's in the cache right now. names are matched
+// case-insensitively: by prefix through a sorted map, and anywhere in the
+// name through an index of three letter runs
+class SystemNameIndex {
+public:
+	enum MatchType {
+		NO_MATCH,
+		CONTAINS_MATCH, // the search is somewhere in the name
+		START_MATCH,    // the name starts with the search
+		EXACT_MATCH
+	};
+
+	SystemNameIndex(Galaxy* galaxy);
+	~SystemNameIndex();
+
+	// read and write the copy in the sector store. Load is for Galaxy::Init,
+	// before any sectors are generated
+	void Load();
+	void Save();
+
+	void AddSector(const Sector &sector);
+
+	// an exact match if there is one, otherwise the shortest name starting
+	// with the search, otherwise the shortest one containing it
+	MatchType Find(const std::string &search, SystemPath &match, std::string &matchName) const;
+
+private:
+	struct Entry {
+		std::string name;
+		std::string folded; // lower case
+		SystemPath path;
+		bool live; // false once its sector has been re-added with other names
+	};
+
+	void AddSectorLocked(const SystemPath &sectorPath, const std::vector<std::string> &names);
+	std::string GetFileName() const;
+
+	Galaxy* m_galaxy;
+	SDL_mutex *m_lock;
+	bool m_dirty;
+
+	std::vector<Entry> m_entries;
+	std::map<SystemPath, std::vector<Uint32> > m_sectors; // entries, by system index
+	std::multimap<std::string, Uint32> m_byName;
+	std::unordered_map<Uint32, std::vector<Uint32> > m_trigrams;
+};
+
+#endif
@@ -3,9 +3,10 @@
 
 #include "Face.h"
 #include "FileSystem.h"
-#include "SDLWrappers.h"
+#include "Pi.h"
 #include "graphics/TextureBuilder.h"
-#include "FaceParts.h"
+#include <array>
+#include <map>
 
 using namespace UI;
 
@@ -13,6 +14,50 @@ namespace GameUI {
 
 RefCountedPtr<Graphics::Material> Face::s_material;
 
+namespace {
+	// a bulletin board shows the same few dozen faces over and over, so the
+	// textures are kept rather than building them again each time
+	typedef std::array<int, 12> FaceKey;
+
+	struct CachedFace {
+		RefCountedPtr<Graphics::Texture> texture;
+		Uint32 lastUsed;
+	};
+
+	static const size_t MAX_CACHED_FACES = 48;
+	static std::map<FaceKey, CachedFace> s_faces;
+
+	static FaceKey MakeKey(const FaceParts::FaceDescriptor &face, bool armoured)
+	{
+		const FaceKey key = {{
+			face.species, face.race, face.gender,
+			face.head, face.eyes, face.nose, face.mouth, face.hairstyle,
+			face.accessories, face.clothes, face.armour, armoured ? 1 : 0
+		}};
+		return key;
+	}
+}
+
+// builds the image off the main thread. the texture is made from it when
+// it's done, as that has to happen on the main thread
+class Face::ImageJob : public Job {
+public:
+	ImageJob(Face *face, const FaceParts::FaceDescriptor &desc, bool armoured) : m_face(face), m_desc(desc), m_armoured(armoured) {}
+
+	virtual void OnRun() override {
+		m_image = SDLSurfacePtr::WrapNew(SDL_CreateRGBSurface(SDL_SWSURFACE, FaceParts::FACE_WIDTH, FaceParts::FACE_HEIGHT, 24, 0xff, 0xff00, 0xff0000, 0));
+		FaceParts::BuildFaceImage(m_image.Get(), m_desc, m_armoured);
+	}
+	virtual void OnFinish() override { m_face->SetImage(m_image); }
+	virtual const char *GetName() const override { return "FaceImage"; }
+
+private:
+	Face *m_face;
+	const FaceParts::FaceDescriptor m_desc;
+	const bool m_armoured;
+	SDLSurfacePtr m_image;
+};
+
 Face::Face(Context *context, Uint32 flags, Uint32 seed) : Single(context), m_preferredSize(INT_MAX)
 {
 	if (!seed) seed = time(0);
@@ -20,20 +65,21 @@ Face::Face(Context *context, Uint32 flags, Uint32 seed) : Single(context), m_pre
 	m_flags = flags;
 	m_seed = seed;
 
-	SDLSurfacePtr faceim = SDLSurfacePtr::WrapNew(SDL_CreateRGBSurface(SDL_SWSURFACE, FaceParts::FACE_WIDTH, FaceParts::FACE_HEIGHT, 24, 0xff, 0xff00, 0xff0000, 0));
-
-	FaceParts::FaceDescriptor face;
 	switch (flags & GENDER_MASK) {
-		case RAND: face.gender = -1; break;
-		case MALE: face.gender = 0; break;
-		case FEMALE: face.gender = 1; break;
+		case RAND: m_face.gender = -1; break;
+		case MALE: m_face.gender = 0; break;
+		case FEMALE: m_face.gender = 1; break;
 		default: assert(0); break;
 	}
 
-	FaceParts::PickFaceParts(face, m_seed);
-	FaceParts::BuildFaceImage(faceim.Get(), face, (flags & ARMOUR));
+	FaceParts::PickFaceParts(m_face, m_seed);
 
-	m_texture.reset(Graphics::TextureBuilder(faceim, Graphics::LINEAR_CLAMP, true, true).CreateTexture(GetContext()->GetRenderer()));
+	auto cached = s_faces.find(MakeKey(m_face, (flags & ARMOUR)));
+	if (cached != s_faces.end()) {
+		cached->second.lastUsed = SDL_GetTicks();
+		m_texture = cached->second.texture;
+	} else
+		m_imageJob = Pi::GetAsyncJobQueue()->Queue(new ImageJob(this, m_face, (flags & ARMOUR)));
 
 	if (!s_material) {
 		Graphics::MaterialDescriptor matDesc;
@@ -45,6 +91,40 @@ Face::Face(Context *context, Uint32 flags, Uint32 seed) : Single(context), m_pre
 	SetSizeControlFlags(UI::Widget::PRESERVE_ASPECT);
 }
 
+void Face::SetImage(SDLSurfacePtr image)
+{
+	PROFILE_SCOPED()
+	const FaceKey key = MakeKey(m_face, (m_flags & ARMOUR));
+
+	// another face may have asked for the same one in the meantime
+	auto cached = s_faces.find(key);
+	if (cached != s_faces.end()) {
+		cached->second.lastUsed = SDL_GetTicks();
+		m_texture = cached->second.texture;
+		return;
+	}
+
+	m_texture.Reset(Graphics::TextureBuilder(image, Graphics::LINEAR_CLAMP, true, true).CreateTexture(GetContext()->GetRenderer()));
+
+	// keep it for next time, dropping the one that's gone longest unused
+	if (s_faces.size() >= MAX_CACHED_FACES) {
+		auto oldest = s_faces.begin();
+		for (auto it = s_faces.begin(); it != s_faces.end(); ++it) {
+			if (Sint32(it->second.lastUsed - oldest->second.lastUsed) < 0)
+				oldest = it;
+		}
+		s_faces.erase(oldest);
+	}
+	CachedFace &entry = s_faces[key];
+	entry.texture = m_texture;
+	entry.lastUsed = SDL_GetTicks();
+}
+
+void Face::ClearCache()
+{
+	s_faces.clear();
+}
+
 UI::Point Face::PreferredSize() {
 	return m_preferredSize;
 }
@@ -59,11 +139,16 @@ void Face::Layout()
 	Widget *innerWidget = GetInnerWidget();
 	if (!innerWidget) return;
 	SetWidgetDimensions(innerWidget, activeOffset, activeArea);
-	innerWidget->Layout();
+	innerWidget->LayoutIfNeeded();
 }
 
 void Face::Draw()
 {
+	if (!m_texture) {
+		Single::Draw();
+		return;
+	}
+
 	const Point &offset = GetActiveOffset();
 	const Point &area = GetActiveArea();
 
@@ -81,7 +166,7 @@ void Face::Draw()
 	va.Add(vector3f(x+sx, y+sy, 0.0f), vector2f(texSize.x, texSize.y));
 
 	Graphics::Renderer *r = GetContext()->GetRenderer();
-	s_material->texture0 = m_texture.get();
+	s_material->texture0 = m_texture.Get();
 	auto state = GetContext()->GetSkin().GetAlphaBlendState();
 	r->DrawTriangles(&va, state, s_material.Get(), Graphics::TRIANGLE_STRIP);
 
@@ -93,7 +178,7 @@ Face *Face::SetHeightLines(Uint32 lines)
 	const Text::TextureFont *font = GetContext()->GetFont(GetFont()).Get();
 	const float height = font->GetHeight() * lines;
 	m_preferredSize = UI::Point(height * float(FaceParts::FACE_WIDTH) / float(FaceParts::FACE_HEIGHT), height);
-	GetContext()->RequestLayout();
+	RequestLayout();
 	return this;
 }
 
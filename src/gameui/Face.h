@@ -6,6 +6,9 @@
 
 #include "ui/Context.h"
 #include "SmartPtr.h"
+#include "FaceParts.h"
+#include "JobQueue.h"
+#include "SDLWrappers.h"
 #include "graphics/Texture.h"
 
 namespace GameUI {
@@ -17,6 +20,7 @@ public:
 	virtual UI::Point PreferredSize();
 	virtual void Layout();
 	virtual void Draw();
+	virtual bool IsDrawBatched() const { return false; }
 
 	Face *SetHeightLines(Uint32 lines);
 
@@ -29,15 +33,25 @@ public:
 		ARMOUR = (1<<2),
 	};
 
+	// drop the cached face textures. faces still showing keep theirs
+	static void ClearCache();
+
 private:
+	class ImageJob;
+
+	void SetImage(SDLSurfacePtr image);
+
 	UI::Point m_preferredSize;
 
 	Uint32 m_flags;
 	Uint32 m_seed;
+	FaceParts::FaceDescriptor m_face;
 
 	static RefCountedPtr<Graphics::Material> s_material;
 
-	std::unique_ptr<Graphics::Texture> m_texture;
+	// nothing is drawn until the image has been built
+	RefCountedPtr<Graphics::Texture> m_texture;
+	Job::Handle m_imageJob;
 };
 
 }
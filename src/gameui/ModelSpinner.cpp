@@ -7,15 +7,29 @@
 #include "Pi.h"
 #include "Game.h"
 #include "scenegraph/Model.h"
+#include "graphics/Graphics.h"
+#include "graphics/VertexArray.h"
 
 using namespace UI;
 
 namespace GameUI {
 
+static const float FOV = 45.f;
+// big spinners are drawn at this size and stretched
+static const int MAX_TARGET_SIZE = 512;
+// the spin on its own is drawn at most this often
+static const float SPIN_REDRAW_INTERVAL = 1.f / 30.f;
+
+RefCountedPtr<Graphics::Material> ModelSpinner::s_material;
+
 ModelSpinner::ModelSpinner(Context *context, SceneGraph::Model *model, const SceneGraph::ModelSkin &skin, unsigned int pattern) : Widget(context),
 	m_skin(skin),
 	m_rotX(DEG2RAD(-15.0)), m_rotY(DEG2RAD(180.0)),
-	m_rightMouseButton(false)
+	m_rightMouseButton(false),
+	m_targetSize(0),
+	m_drawnRotX(0.f), m_drawnRotY(0.f),
+	m_sinceDrawn(0.f),
+	m_dirty(true)
 {
 	m_model.reset(model->MakeInstance());
 	m_skin.Apply(m_model.get());
@@ -41,6 +55,7 @@ void ModelSpinner::Update()
 {
 	if (!(m_rightMouseButton && IsMouseActive()))
 		m_rotY += Pi::GetFrameTime();
+	m_sinceDrawn += Pi::GetFrameTime();
 
 	if (m_model) {
 		m_shields->SetEnabled(false);
@@ -50,28 +65,89 @@ void ModelSpinner::Update()
 
 void ModelSpinner::Draw()
 {
+	const Point &offset = GetActiveOffset();
+	const Point &area = GetActiveArea();
+	const int size = std::min(area.x, MAX_TARGET_SIZE);
+	if (size <= 0)
+		return;
+
 	Graphics::Renderer *r = GetContext()->GetRenderer();
 
-	Graphics::Renderer::StateTicket ticket(r);
+	if (!m_target || size != m_targetSize) {
+		m_target.reset(r->CreateRenderTarget(Graphics::RenderTargetDesc(
+			size, size, Graphics::TEXTURE_NONE, Graphics::TEXTURE_DEPTH, false)));
+		if (!m_target)
+			return;
+		// our own texture rather than the target's, so that uvs are normalised
+		m_texture.Reset(r->CreateTexture(Graphics::TextureDescriptor(
+			Graphics::TEXTURE_RGBA_8888, vector2f(size, size), Graphics::LINEAR_CLAMP, false, false, 0)));
+		m_target->SetColorTexture(m_texture.Get());
+		m_targetSize = size;
+		m_dirty = true;
+	}
 
-	const float fov = 45.f;
-	r->SetPerspectiveProjection(fov, 1.f, 1.f, 10000.f);
-	r->SetTransform(matrix4x4f::Identity());
+	if (!s_material) {
+		Graphics::MaterialDescriptor matDesc;
+		matDesc.textures = 1;
+		s_material.Reset(r->CreateMaterial(matDesc));
+	}
 
-	r->ClearDepthBuffer();
+	// turned by about a pixel at the edge of the model. the spin on its own
+	// also waits for the interval, turning by hand is drawn straight away
+	const float minTurn = 2.f / float(size);
+	const bool turned = fabs(m_rotX - m_drawnRotX) > minTurn || fabs(m_rotY - m_drawnRotY) > minTurn;
+	const bool turnedByHand = m_rightMouseButton && IsMouseActive();
+	if (m_dirty || (turned && (turnedByHand || m_sinceDrawn >= SPIN_REDRAW_INTERVAL)))
+		DrawModel(size);
+
+	const float x = offset.x;
+	const float y = offset.y;
+	const float sx = area.x;
+	const float sy = area.y;
+
+	// render targets are upside down to the ui
+	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
+	va.Add(vector3f(x,    y,    0.0f), vector2f(0.0f, 1.0f));
+	va.Add(vector3f(x,    y+sy, 0.0f), vector2f(0.0f, 0.0f));
+	va.Add(vector3f(x+sx, y,    0.0f), vector2f(1.0f, 1.0f));
+	va.Add(vector3f(x+sx, y+sy, 0.0f), vector2f(1.0f, 0.0f));
+
+	s_material->texture0 = m_texture.Get();
+	r->DrawTriangles(&va, GetContext()->GetSkin().GetAlphaBlendState(), s_material.Get(), Graphics::TRIANGLE_STRIP);
+}
 
-	r->SetLights(1, &m_light);
+void ModelSpinner::DrawModel(int size)
+{
+	PROFILE_SCOPED()
+	Graphics::Renderer *r = GetContext()->GetRenderer();
 
-	Point pos(GetAbsolutePosition() + GetActiveOffset());
-	Point size(GetActiveArea());
+	Graphics::RenderTarget *prevTarget = r->GetRenderTarget();
+	Graphics::Renderer::StateTicket ticket(r);
+	r->SetRenderTarget(m_target.get());
+	r->SetViewport(0, 0, size, size);
+	r->SetClearColor(Color(0, 0, 0, 0));
+	r->ClearScreen();
 
-	r->SetViewport(pos.x, GetContext()->GetSize().y - pos.y - size.y, size.x, size.y);
+	r->SetPerspectiveProjection(FOV, 1.f, 1.f, 10000.f);
+	r->SetTransform(matrix4x4f::Identity());
+	r->SetLights(1, &m_light);
 
 	matrix4x4f rot = matrix4x4f::RotateXMatrix(m_rotX);
 	rot.RotateY(m_rotY);
-	const float dist = m_model->GetDrawClipRadius() / sinf(DEG2RAD(fov*0.5f));
+	const float dist = m_model->GetDrawClipRadius() / sinf(DEG2RAD(FOV*0.5f));
 	rot[14] = -dist;
-	m_model->Render(rot);
+
+	// levels picked by the size the model is drawn at, not the screen's
+	SceneGraph::RenderData rd;
+	rd.lodScale = float(size) * Graphics::GetFovFactor() / (float(Graphics::GetScreenHeight()) * 2.f * tanf(DEG2RAD(FOV*0.5f)));
+	m_model->Render(rot, &rd);
+
+	r->SetRenderTarget(prevTarget);
+
+	m_drawnRotX = m_rotX;
+	m_drawnRotY = m_rotY;
+	m_sinceDrawn = 0.f;
+	m_dirty = false;
 }
 
 void ModelSpinner::HandleMouseDown(const MouseButtonEvent &event)
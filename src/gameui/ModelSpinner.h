@@ -10,6 +10,8 @@
 #include "scenegraph/ModelSkin.h"
 #include "SmartPtr.h"
 #include "Shields.h"
+#include "graphics/RenderTarget.h"
+#include "graphics/Texture.h"
 
 namespace GameUI {
 
@@ -38,6 +40,18 @@ private:
 	Graphics::Light m_light;
 
 	bool m_rightMouseButton;
+
+	// the model is drawn to a texture, and only drawn again when it has
+	// turned far enough to see, so a screen of spinners costs little
+	void DrawModel(int size);
+	std::unique_ptr<Graphics::RenderTarget> m_target;
+	RefCountedPtr<Graphics::Texture> m_texture;
+	int m_targetSize;
+	float m_drawnRotX, m_drawnRotY;
+	float m_sinceDrawn;
+	bool m_dirty;
+
+	static RefCountedPtr<Graphics::Material> s_material;
 };
 
 }
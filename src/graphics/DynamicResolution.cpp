@@ -0,0 +1,143 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "DynamicResolution.h"
+#include "Graphics.h"
+#include "Renderer.h"
+#include "RenderState.h"
+#include "Stats.h"
+#include "VertexArray.h"
+#include "utils.h"
+
+namespace Graphics {
+
+// aim under the target so a frame that's a little slower doesn't step down
+static const double AIM_FRACTION = 0.85;
+// and only step back up once there's this much room
+static const double SPARE_FRACTION = 0.65;
+// weight of each new timing in the running average
+static const double SMOOTHING = 0.1;
+// most the scale moves in a frame, and what it's rounded to
+static const float MAX_STEP = 0.05f;
+static const float QUANTUM = 1.0f / 64.0f;
+
+DynamicResolution::DynamicResolution(Renderer *r, double targetSceneTime, float minScale) :
+	m_renderer(r),
+	m_targetTime(targetSceneTime),
+	m_minScale(Clamp(minScale, 0.25f, 1.0f)),
+	m_scale(1.0f),
+	m_sceneTime(0.0),
+	m_active(false),
+	m_width(0),
+	m_height(0),
+	m_scaledWidth(0),
+	m_scaledHeight(0),
+	m_prevTarget(nullptr)
+{
+	m_viewport[0] = m_viewport[1] = m_viewport[2] = m_viewport[3] = 0;
+
+	MaterialDescriptor matDesc;
+	matDesc.textures = 1;
+	m_material.Reset(r->CreateMaterial(matDesc));
+
+	RenderStateDesc rsd;
+	rsd.depthTest = false;
+	rsd.depthWrite = false;
+	rsd.blendMode = BLEND_SOLID;
+	m_renderState = r->CreateRenderState(rsd);
+}
+
+void DynamicResolution::Update()
+{
+	// microseconds, and none at all without timer queries
+	const Uint32 us = m_renderer->GetStats().FrameStatsPrevious().m_gpuTime[Stats::GPU_TIMER_SCENE];
+	if (!us)
+		return;
+
+	const double t = double(us) * 1e-6;
+	m_sceneTime = m_sceneTime > 0.0 ? m_sceneTime + (t - m_sceneTime) * SMOOTHING : t;
+
+	float wanted = m_scale;
+	if (m_sceneTime > m_targetTime || m_sceneTime < m_targetTime * SPARE_FRACTION) {
+		// what the scene would take at full size, and the scale it fits at
+		const double fullTime = m_sceneTime / double(m_scale * m_scale);
+		wanted = float(sqrt(m_targetTime * AIM_FRACTION / fullTime));
+	}
+	wanted = Clamp(wanted, m_minScale, 1.0f);
+	const float scale = Clamp(wanted, m_scale - MAX_STEP, m_scale + MAX_STEP);
+	m_scale = Clamp(floor(scale / QUANTUM + 0.5f) * QUANTUM, m_minScale, 1.0f);
+}
+
+bool DynamicResolution::CreateTarget(int width, int height)
+{
+	m_target.reset(m_renderer->CreateRenderTarget(RenderTargetDesc(
+		width, height, TEXTURE_NONE, TEXTURE_DEPTH, false)));
+	if (!m_target)
+		return false;
+	// our own texture rather than the target's, so that uvs are normalised
+	m_texture.Reset(m_renderer->CreateTexture(TextureDescriptor(
+		TEXTURE_RGBA_8888, vector2f(width, height), LINEAR_CLAMP, false, false, 0)));
+	m_target->SetColorTexture(m_texture.Get());
+	m_width = width;
+	m_height = height;
+	return true;
+}
+
+void DynamicResolution::Begin()
+{
+	PROFILE_SCOPED()
+	assert(!m_active);
+	if (m_scale >= 1.0f)
+		return;
+
+	// the target is the size of the screen, only the corner of it in use is
+	// scaled
+	const int width = GetScreenWidth(), height = GetScreenHeight();
+	if (!m_target || width != m_width || height != m_height) {
+		if (!CreateTarget(width, height)) {
+			Output("dynamic resolution: couldn't create the render target\n");
+			m_scale = m_minScale = 1.0f;
+			return;
+		}
+	}
+
+	m_scaledWidth = std::max(1, int(float(width) * m_scale + 0.5f));
+	m_scaledHeight = std::max(1, int(float(height) * m_scale + 0.5f));
+
+	m_renderer->GetCurrentViewport(m_viewport);
+	m_prevTarget = m_renderer->GetRenderTarget();
+	m_renderer->SetRenderTarget(m_target.get());
+	m_renderer->SetViewport(0, 0, m_scaledWidth, m_scaledHeight);
+	m_renderer->ClearScreen();
+	m_active = true;
+}
+
+void DynamicResolution::End()
+{
+	PROFILE_SCOPED()
+	if (!m_active)
+		return;
+	m_active = false;
+
+	m_renderer->SetRenderTarget(m_prevTarget);
+	m_renderer->SetViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+
+	Renderer::StateTicket ticket(m_renderer);
+	m_renderer->SetOrthographicProjection(0, m_width, m_height, 0, -1, 1);
+	m_renderer->SetTransform(matrix4x4f::Identity());
+
+	// the part of the target that was drawn, stretched over the whole screen.
+	// render targets are upside down to the ui
+	const float w = float(m_width), h = float(m_height);
+	const float u = float(m_scaledWidth) / w, v = float(m_scaledHeight) / h;
+	VertexArray va(ATTRIB_POSITION | ATTRIB_UV0);
+	va.Add(vector3f(0.0f, 0.0f, 0.0f), vector2f(0.0f, v));
+	va.Add(vector3f(0.0f, h,    0.0f), vector2f(0.0f, 0.0f));
+	va.Add(vector3f(w,    0.0f, 0.0f), vector2f(u,    v));
+	va.Add(vector3f(w,    h,    0.0f), vector2f(u,    0.0f));
+
+	m_material->texture0 = m_texture.Get();
+	m_renderer->DrawTriangles(&va, m_renderState, m_material.Get(), TRIANGLE_STRIP);
+}
+
+}
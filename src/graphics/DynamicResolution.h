@@ -0,0 +1,71 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_DYNAMICRESOLUTION_H
+#define _GRAPHICS_DYNAMICRESOLUTION_H
+
+#include "libs.h"
+#include "graphics/Material.h"
+#include "graphics/RenderTarget.h"
+#include "graphics/Texture.h"
+#include <memory>
+
+namespace Graphics {
+
+class Renderer;
+class RenderState;
+
+/*
+ * Draws the 3D scene at less than the screen's resolution when the GPU
+ * can't get it done in time, and stretches it back over the screen before
+ * the UI goes on top at full resolution.
+ *
+ * The scale follows the GPU time the scene took, as the timer queries report
+ * it a frame or two later. Scene time goes roughly with the number of
+ * pixels, so the scale that should just fit is worked out from that and
+ * moved towards a little at a time. There's a band below the target where
+ * it's left alone so it doesn't hunt.
+ *
+ * At full scale the target isn't used at all and the scene is drawn straight
+ * to the screen as before. Without GPU timers it stays there.
+ */
+class DynamicResolution {
+public:
+	DynamicResolution(Renderer *r, double targetSceneTime, float minScale);
+
+	// once a frame that draws the scene, before Begin
+	void Update();
+
+	// around the scene. between them it's drawn to the scaled target, if
+	// it's scaled at all
+	void Begin();
+	void End();
+
+	float GetScale() const { return m_scale; }
+
+private:
+	bool CreateTarget(int width, int height);
+
+	Renderer *m_renderer;
+	const double m_targetTime;
+	float m_minScale;
+	float m_scale;
+	double m_sceneTime;
+
+	bool m_active;
+	int m_width;
+	int m_height;
+	int m_scaledWidth;
+	int m_scaledHeight;
+	Sint32 m_viewport[4];
+	RenderTarget *m_prevTarget;
+
+	std::unique_ptr<RenderTarget> m_target;
+	RefCountedPtr<Texture> m_texture;
+	RefCountedPtr<Material> m_material;
+	RenderState *m_renderState;
+};
+
+}
+
+#endif
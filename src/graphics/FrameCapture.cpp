@@ -0,0 +1,217 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "FrameCapture.h"
+#include "Renderer.h"
+#include <algorithm>
+
+namespace Graphics {
+
+std::vector<FrameCapture*> FrameCapture::s_captures;
+
+FrameCapture::Command::Command(CommandType t) :
+	type(t), primitive(TRIANGLES), state(nullptr), material(nullptr), vb(nullptr), ib(nullptr), instb(nullptr), target(nullptr),
+	data(0), count(0), enabled(false), size(0.0f)
+{
+	range[0] = range[1] = 0.0;
+	rect[0] = rect[1] = rect[2] = rect[3] = 0;
+}
+
+FrameCapture::FrameCapture(RenderTarget *target, const Sint32 *viewport) :
+	m_numDraws(0),
+	m_paused(0)
+{
+	// start from the state the frame started in
+	Add(CMD_RENDER_TARGET).target = target;
+	SetViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	s_captures.push_back(this);
+}
+
+FrameCapture::~FrameCapture()
+{
+	s_captures.erase(std::find(s_captures.begin(), s_captures.end(), this));
+}
+
+FrameCapture::Command &FrameCapture::Add(CommandType t)
+{
+	m_commands.push_back(Command(t));
+	return m_commands.back();
+}
+
+void FrameCapture::BeginFrame()
+{
+	Add(CMD_BEGIN_FRAME);
+}
+
+void FrameCapture::SetRenderTarget(RenderTarget *rt)
+{
+	Add(CMD_RENDER_TARGET).target = rt;
+}
+
+void FrameCapture::SetDepthRange(double near_, double far_)
+{
+	Command &c = Add(CMD_DEPTH_RANGE);
+	c.range[0] = near_;
+	c.range[1] = far_;
+}
+
+void FrameCapture::ClearScreen()
+{
+	Add(CMD_CLEAR_SCREEN);
+}
+
+void FrameCapture::ClearDepthBuffer()
+{
+	Add(CMD_CLEAR_DEPTH);
+}
+
+void FrameCapture::SetClearColor(const Color &c)
+{
+	Add(CMD_CLEAR_COLOR).color = c;
+}
+
+void FrameCapture::SetViewport(int x, int y, int width, int height)
+{
+	Command &c = Add(CMD_VIEWPORT);
+	c.rect[0] = x;
+	c.rect[1] = y;
+	c.rect[2] = width;
+	c.rect[3] = height;
+}
+
+void FrameCapture::SetWireFrameMode(bool enabled)
+{
+	Add(CMD_WIREFRAME).enabled = enabled;
+}
+
+void FrameCapture::SetLights(Uint32 numlights, const Light *l)
+{
+	Command &c = Add(CMD_LIGHTS);
+	c.data = m_lights.size();
+	c.count = numlights;
+	m_lights.push_back(std::vector<Light>(l, l + numlights));
+}
+
+void FrameCapture::SetAmbientColor(const Color &c)
+{
+	Add(CMD_AMBIENT).color = c;
+}
+
+void FrameCapture::SetScissor(bool enabled, const vector2f &pos, const vector2f &size)
+{
+	Command &c = Add(CMD_SCISSOR);
+	c.enabled = enabled;
+	c.pos = pos;
+	c.extent = size;
+}
+
+void FrameCapture::DrawTriangles(const VertexArray *vertices, RenderState *state, Material *material, PrimitiveType type,
+	const matrix4x4f &modelView, const matrix4x4f &projection)
+{
+	Command &c = Add(CMD_DRAW_TRIANGLES);
+	c.state = state;
+	c.material = material;
+	c.primitive = type;
+	c.modelView = modelView;
+	c.projection = projection;
+	c.data = m_vertexArrays.size();
+	m_vertexArrays.emplace_back(new VertexArray(*vertices));
+	++m_numDraws;
+}
+
+void FrameCapture::DrawPointSprites(int count, const vector3f *positions, RenderState *rs, Material *material, float size,
+	const matrix4x4f &modelView, const matrix4x4f &projection)
+{
+	Command &c = Add(CMD_DRAW_POINT_SPRITES);
+	c.state = rs;
+	c.material = material;
+	c.size = size;
+	c.modelView = modelView;
+	c.projection = projection;
+	c.data = m_sprites.size();
+	c.count = count;
+	m_sprites.push_back(std::vector<vector3f>(positions, positions + count));
+	++m_numDraws;
+}
+
+void FrameCapture::DrawBuffer(VertexBuffer *vb, IndexBuffer *ib, InstanceBuffer *instb, RenderState *state, Material *material, PrimitiveType type,
+	const matrix4x4f &modelView, const matrix4x4f &projection)
+{
+	Command &c = Add(CMD_DRAW_BUFFER);
+	c.vb = vb;
+	c.ib = ib;
+	c.instb = instb;
+	c.state = state;
+	c.material = material;
+	c.primitive = type;
+	c.modelView = modelView;
+	c.projection = projection;
+	++m_numDraws;
+}
+
+void FrameCapture::Replay(Renderer *r) const
+{
+	PROFILE_SCOPED()
+	for (const Command &c : m_commands) {
+		switch (c.type) {
+			case CMD_NONE: break;
+			case CMD_BEGIN_FRAME: r->BeginFrame(); break;
+			case CMD_RENDER_TARGET: r->SetRenderTarget(c.target); break;
+			case CMD_DEPTH_RANGE: r->SetDepthRange(c.range[0], c.range[1]); break;
+			case CMD_CLEAR_SCREEN: r->ClearScreen(); break;
+			case CMD_CLEAR_DEPTH: r->ClearDepthBuffer(); break;
+			case CMD_CLEAR_COLOR: r->SetClearColor(c.color); break;
+			case CMD_VIEWPORT: r->SetViewport(c.rect[0], c.rect[1], c.rect[2], c.rect[3]); break;
+			case CMD_WIREFRAME: r->SetWireFrameMode(c.enabled); break;
+			case CMD_LIGHTS: r->SetLights(c.count, c.count ? &m_lights[c.data][0] : nullptr); break;
+			case CMD_AMBIENT: r->SetAmbientColor(c.color); break;
+			case CMD_SCISSOR: r->SetScissor(c.enabled, c.pos, c.extent); break;
+
+			case CMD_DRAW_TRIANGLES:
+				r->SetProjection(c.projection);
+				r->SetTransform(c.modelView);
+				r->DrawTriangles(m_vertexArrays[c.data].get(), c.state, c.material, c.primitive);
+				break;
+
+			case CMD_DRAW_POINT_SPRITES:
+				r->SetProjection(c.projection);
+				r->SetTransform(c.modelView);
+				r->DrawPointSprites(c.count, c.count ? &m_sprites[c.data][0] : nullptr, c.state, c.material, c.size);
+				break;
+
+			case CMD_DRAW_BUFFER:
+				r->SetProjection(c.projection);
+				r->SetTransform(c.modelView);
+				if (c.instb && c.ib)
+					r->DrawBufferIndexedInstanced(c.vb, c.ib, c.state, c.material, c.instb, c.primitive);
+				else if (c.instb)
+					r->DrawBufferInstanced(c.vb, c.state, c.material, c.instb, c.primitive);
+				else if (c.ib)
+					r->DrawBufferIndexed(c.vb, c.ib, c.state, c.material, c.primitive);
+				else
+					r->DrawBuffer(c.vb, c.state, c.material, c.primitive);
+				break;
+		}
+	}
+}
+
+void FrameCapture::ForgetObject(const void *object)
+{
+	for (Command &c : m_commands) {
+		if (c.material == object || c.vb == object || c.ib == object || c.instb == object)
+			c.type = CMD_NONE;
+		else if (c.type == CMD_RENDER_TARGET && c.target == object) {
+			// draw to the screen instead, the work is much the same
+			c.target = nullptr;
+		}
+	}
+}
+
+//static
+void FrameCapture::Forget(const void *object)
+{
+	for (FrameCapture *c : s_captures)
+		c->ForgetObject(object);
+}
+
+}
@@ -0,0 +1,139 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_FRAMECAPTURE_H
+#define _GRAPHICS_FRAMECAPTURE_H
+
+#include "libs.h"
+#include "graphics/Light.h"
+#include "graphics/Types.h"
+#include "graphics/VertexArray.h"
+#include <memory>
+#include <vector>
+
+namespace Graphics {
+
+class IndexBuffer;
+class InstanceBuffer;
+class Material;
+class RenderState;
+class RenderTarget;
+class Renderer;
+class VertexBuffer;
+
+/*
+ * One frame's renderer calls, recorded so the same frame can be drawn again
+ * and again to time the renderer on a fixed workload (see
+ * Renderer::CaptureFrame).
+ *
+ * Data the renderer is only lent for the call (vertex arrays, sprite
+ * positions, lights) is copied. Buffers, materials and render targets are
+ * referenced, so a replay draws them as they are by then; commands using
+ * anything that has been destroyed in the meantime are dropped.
+ */
+class FrameCapture {
+public:
+	FrameCapture(RenderTarget *target, const Sint32 *viewport);
+	~FrameCapture();
+
+	// the renderer skips recording calls it makes to itself while paused,
+	// eg DrawPointSprites drawing through DrawBufferInstanced
+	bool IsRecording() const { return m_paused == 0; }
+	class Pause {
+	public:
+		Pause(FrameCapture *c) : m_capture(c) { if (m_capture) ++m_capture->m_paused; }
+		~Pause() { if (m_capture) --m_capture->m_paused; }
+	private:
+		FrameCapture *m_capture;
+	};
+
+	void BeginFrame();
+	void SetRenderTarget(RenderTarget *rt);
+	void SetDepthRange(double near_, double far_);
+	void ClearScreen();
+	void ClearDepthBuffer();
+	void SetClearColor(const Color &c);
+	void SetViewport(int x, int y, int width, int height);
+	void SetWireFrameMode(bool enabled);
+	void SetLights(Uint32 numlights, const Light *l);
+	void SetAmbientColor(const Color &c);
+	void SetScissor(bool enabled, const vector2f &pos, const vector2f &size);
+
+	// the transforms are the renderer's current ones
+	void DrawTriangles(const VertexArray *vertices, RenderState *state, Material *material, PrimitiveType type,
+		const matrix4x4f &modelView, const matrix4x4f &projection);
+	void DrawPointSprites(int count, const vector3f *positions, RenderState *rs, Material *material, float size,
+		const matrix4x4f &modelView, const matrix4x4f &projection);
+	void DrawBuffer(VertexBuffer *vb, IndexBuffer *ib, InstanceBuffer *instb, RenderState *state, Material *material, PrimitiveType type,
+		const matrix4x4f &modelView, const matrix4x4f &projection);
+
+	// draw everything again through r
+	void Replay(Renderer *r) const;
+
+	Uint32 GetNumCommands() const { return m_commands.size(); }
+	Uint32 GetNumDraws() const { return m_numDraws; }
+
+	// called as buffers, materials and render targets are destroyed
+	static void Forget(const void *object);
+
+private:
+	FrameCapture(const FrameCapture&);
+	FrameCapture &operator=(const FrameCapture&);
+
+	enum CommandType {
+		CMD_NONE, // dropped
+		CMD_BEGIN_FRAME,
+		CMD_RENDER_TARGET,
+		CMD_DEPTH_RANGE,
+		CMD_CLEAR_SCREEN,
+		CMD_CLEAR_DEPTH,
+		CMD_CLEAR_COLOR,
+		CMD_VIEWPORT,
+		CMD_WIREFRAME,
+		CMD_LIGHTS,
+		CMD_AMBIENT,
+		CMD_SCISSOR,
+		CMD_DRAW_TRIANGLES,
+		CMD_DRAW_POINT_SPRITES,
+		CMD_DRAW_BUFFER
+	};
+
+	struct Command {
+		Command(CommandType t);
+
+		CommandType type;
+		PrimitiveType primitive;
+		RenderState *state;
+		Material *material;
+		VertexBuffer *vb;
+		IndexBuffer *ib;
+		InstanceBuffer *instb;
+		RenderTarget *target;
+		Uint32 data;   // index into the copied vertex arrays, sprites or lights
+		Uint32 count;
+		bool enabled;
+		float size;
+		double range[2];
+		Sint32 rect[4];
+		vector2f pos, extent;
+		Color color;
+		matrix4x4f modelView;
+		matrix4x4f projection;
+	};
+
+	Command &Add(CommandType t);
+	void ForgetObject(const void *object);
+
+	std::vector<Command> m_commands;
+	std::vector<std::unique_ptr<VertexArray>> m_vertexArrays;
+	std::vector<std::vector<vector3f>> m_sprites;
+	std::vector<std::vector<Light>> m_lights;
+	Uint32 m_numDraws;
+	Uint32 m_paused;
+
+	static std::vector<FrameCapture*> s_captures;
+};
+
+}
+
+#endif
@@ -26,6 +26,7 @@ namespace Graphics {
 		bool hidden;
 		bool useTextureCompression;
 		bool enableDebugMessages;
+		bool useShaderCache;
 		int vsync;
 		int requestedSamples;
 		int height;
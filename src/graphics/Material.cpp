@@ -2,6 +2,7 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "Material.h"
+#include "FrameCapture.h"
 
 namespace Graphics {
 
@@ -13,6 +14,8 @@ Material::Material() :
 	texture4(nullptr),
 	texture5(nullptr),
 	heatGradient(nullptr),
+	smoothPatternColors(true),
+	patternArray(nullptr),
 	diffuse(Color::WHITE),
 	specular(Color::BLACK),
 	emissive(Color::BLACK),
@@ -21,6 +24,11 @@ Material::Material() :
 {
 }
 
+Material::~Material()
+{
+	FrameCapture::Forget(this);
+}
+
 MaterialDescriptor::MaterialDescriptor()
 : effect(EFFECT_DEFAULT)
 , alphaTest(false)
@@ -29,6 +37,7 @@ MaterialDescriptor::MaterialDescriptor()
 , lighting(false)
 , specularMap(false)
 , usePatterns(false)
+, patternArray(false)
 , vertexColors(false)
 , instanced(false)
 , textures(0)
@@ -47,6 +56,7 @@ bool operator==(const MaterialDescriptor &a, const MaterialDescriptor &b)
 		a.lighting == b.lighting &&
 		a.specularMap == b.specularMap &&
 		a.usePatterns == b.usePatterns &&
+		a.patternArray == b.patternArray &&
 		a.vertexColors == b.vertexColors &&
 		a.instanced == b.instanced &&
 		a.textures == b.textures &&
@@ -27,6 +27,7 @@ enum EffectType {
 	EFFECT_DEFAULT,
 	EFFECT_VTXCOLOR,
 	EFFECT_UI,
+	EFFECT_UI_DISTANCE_FIELD,
 	EFFECT_STARFIELD,
 	EFFECT_PLANETRING,
 	EFFECT_GEOSPHERE_TERRAIN,
@@ -37,7 +38,9 @@ enum EffectType {
 	EFFECT_FRESNEL_SPHERE,
 	EFFECT_SHIELD,
 	EFFECT_SKYBOX,
-	EFFECT_SPHEREIMPOSTOR
+	EFFECT_SPHEREIMPOSTOR,
+	EFFECT_TRAIL,
+	EFFECT_SPEEDLINES
 };
 
 
@@ -45,7 +48,8 @@ enum EffectType {
 enum MaterialQuality {
 	HAS_ATMOSPHERE		= 1 << 0,
 	HAS_ECLIPSES		= 1 << 1,
-	HAS_HEAT_GRADIENT   = 1 << 2
+	HAS_HEAT_GRADIENT   = 1 << 2,
+	HAS_COMPACT_VERTICES = 1 << 3	// geosphere: 16-bit positions, octahedral normals
 };
 
 // Renderer creates a material that best matches these requirements.
@@ -60,6 +64,7 @@ public:
 	bool lighting;
 	bool specularMap;
 	bool usePatterns; //pattern/color system
+	bool patternArray; //instanced, with texture4 holding all the patterns and each instance picking its own
 	bool vertexColors;
 	bool instanced;
 	Sint32 textures; //texture count
@@ -75,7 +80,7 @@ public:
 class Material : public RefCounted {
 public:
 	Material();
-	virtual ~Material() { }
+	virtual ~Material();
 
 	Texture *texture0;
 	Texture *texture1;
@@ -85,6 +90,14 @@ public:
 	Texture *texture5;
 	Texture *heatGradient;
 
+	// primary, secondary and trim, looked up by the pattern (texture4) in
+	// materials with usePatterns
+	Color patternColors[3];
+	bool smoothPatternColors;
+	// all of the model's patterns as the layers of one texture, if it has
+	// one. instanced variants use it in place of texture4
+	Texture *patternArray;
+
 	Color diffuse;
 	Color specular;
 	Color emissive;
@@ -0,0 +1,114 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "RenderQueue.h"
+#include "Renderer.h"
+#include "RenderState.h"
+#include <algorithm>
+
+namespace Graphics {
+
+RenderQueue::RenderQueue(Renderer *r)
+: m_renderer(r)
+, m_depth(0)
+{
+}
+
+void RenderQueue::Begin()
+{
+	++m_depth;
+}
+
+void RenderQueue::End()
+{
+	assert(m_depth > 0);
+	--m_depth;
+	// flush even when nested: a sub-model may change its shared materials
+	// again before the outer model is finished
+	Flush();
+}
+
+void RenderQueue::Submit(VertexBuffer *vb, IndexBuffer *ib, RenderState *rs, Material *mat, PrimitiveType type)
+{
+	if (!IsActive()) {
+		if (ib)
+			m_renderer->DrawBufferIndexed(vb, ib, rs, mat, type);
+		else
+			m_renderer->DrawBuffer(vb, rs, mat, type);
+		return;
+	}
+
+	Command c;
+	c.pass = (rs->GetDesc().blendMode == BLEND_SOLID) ? PASS_OPAQUE : PASS_TRANSPARENT;
+	c.target = m_renderer->GetRenderTarget();
+	c.material = mat;
+	c.vertexBuffer = vb;
+	c.indexBuffer = ib;
+	c.renderState = rs;
+	c.primitive = type;
+	c.modelView = m_renderer->GetCurrentModelView();
+	c.projection = m_renderer->GetCurrentProjection();
+	// view space looks down -z, so this is the distance in front of the camera
+	c.depth = -c.modelView[14];
+	c.sequence = m_commands.size();
+	m_commands.push_back(c);
+}
+
+bool RenderQueue::CompareCommands(const Command *a, const Command *b)
+{
+	if (a->pass != b->pass) return a->pass < b->pass;
+	if (a->target != b->target) return a->target < b->target;
+	if (a->pass == PASS_OPAQUE) {
+		if (a->material != b->material) return a->material < b->material;
+		if (a->vertexBuffer != b->vertexBuffer) return a->vertexBuffer < b->vertexBuffer;
+		if (a->depth < b->depth) return true;
+		if (b->depth < a->depth) return false;
+	} else {
+		if (b->depth < a->depth) return true;
+		if (a->depth < b->depth) return false;
+	}
+	return a->sequence < b->sequence;
+}
+
+void RenderQueue::Flush()
+{
+	PROFILE_SCOPED()
+	if (m_commands.empty())
+		return;
+
+	m_sorted.clear();
+	m_sorted.reserve(m_commands.size());
+	for (const Command &c : m_commands)
+		m_sorted.push_back(&c);
+	std::sort(m_sorted.begin(), m_sorted.end(), CompareCommands);
+
+	{
+		Renderer::MatrixTicket projTicket(m_renderer, MatrixMode::PROJECTION);
+		Renderer::MatrixTicket mvTicket(m_renderer, MatrixMode::MODELVIEW);
+
+		RenderTarget *const origTarget = m_renderer->GetRenderTarget();
+		RenderTarget *target = origTarget;
+		const matrix4x4f *projection = nullptr;
+		for (const Command *c : m_sorted) {
+			if (c->target != target) {
+				m_renderer->SetRenderTarget(c->target);
+				target = c->target;
+			}
+			if (!projection || memcmp(projection, &c->projection, sizeof(matrix4x4f)) != 0) {
+				m_renderer->SetProjection(c->projection);
+				projection = &c->projection;
+			}
+			m_renderer->SetTransform(c->modelView);
+			if (c->indexBuffer)
+				m_renderer->DrawBufferIndexed(c->vertexBuffer, c->indexBuffer, c->renderState, c->material, c->primitive);
+			else
+				m_renderer->DrawBuffer(c->vertexBuffer, c->renderState, c->material, c->primitive);
+		}
+		if (target != origTarget)
+			m_renderer->SetRenderTarget(origTarget);
+	}
+
+	m_commands.clear();
+}
+
+}
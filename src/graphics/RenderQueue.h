@@ -0,0 +1,76 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_RENDERQUEUE_H
+#define _GRAPHICS_RENDERQUEUE_H
+
+#include "libs.h"
+#include "graphics/Types.h"
+#include <vector>
+
+namespace Graphics {
+
+class Renderer;
+class RenderState;
+class RenderTarget;
+class Material;
+class VertexBuffer;
+class IndexBuffer;
+
+/*
+ * Deferred list of buffer draws. Scene traversal submits draws between
+ * Begin() and End(); End() sorts them and hands them to the renderer in
+ * one go. Outside of Begin()/End() submitted draws are made immediately.
+ *
+ * Opaque draws are grouped by render target, material and vertex buffer
+ * and then ordered front to back. Blended draws are kept in a separate
+ * pass after all opaque ones and ordered back to front, falling back to
+ * submission order for draws at the same depth (eg. decals on a hull).
+ *
+ * Materials are applied when the queue is flushed, not when the draw is
+ * submitted, so callers must not change material parameters while the
+ * queue is open.
+ */
+class RenderQueue {
+public:
+	enum Pass {
+		PASS_OPAQUE,
+		PASS_TRANSPARENT
+	};
+
+	RenderQueue(Renderer *r);
+
+	void Begin();
+	void End();
+	bool IsActive() const { return m_depth > 0; }
+
+	// records the renderer's current modelview and projection with the draw
+	void Submit(VertexBuffer *vb, IndexBuffer *ib, RenderState *rs, Material *mat, PrimitiveType type=TRIANGLES);
+
+	void Flush();
+
+private:
+	struct Command {
+		Pass pass;
+		RenderTarget *target;
+		Material *material;
+		VertexBuffer *vertexBuffer;
+		IndexBuffer *indexBuffer;
+		RenderState *renderState;
+		PrimitiveType primitive;
+		float depth;
+		Uint32 sequence;
+		matrix4x4f modelView;
+		matrix4x4f projection;
+	};
+	static bool CompareCommands(const Command *a, const Command *b);
+
+	Renderer *m_renderer;
+	int m_depth;
+	std::vector<Command> m_commands;
+	std::vector<const Command*> m_sorted;
+};
+
+}
+
+#endif
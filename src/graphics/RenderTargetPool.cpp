@@ -0,0 +1,96 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "RenderTargetPool.h"
+#include "Renderer.h"
+
+namespace Graphics {
+
+// released targets are kept around this many frames for the next user
+static const Uint32 MAX_IDLE_FRAMES = 120;
+
+RenderTargetPool::RenderTargetPool(Renderer *r)
+: m_renderer(r)
+, m_frame(0)
+{
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+	// targets still acquired go too, the renderer is going away
+	for (Entry &e : m_entries)
+		delete e.target;
+}
+
+bool RenderTargetPool::IsCompatible(const RenderTargetDesc &a, const RenderTargetDesc &b)
+{
+	return a.width == b.width && a.height == b.height &&
+		a.colorFormat == b.colorFormat && a.depthFormat == b.depthFormat &&
+		a.allowDepthTexture == b.allowDepthTexture;
+}
+
+RenderTarget *RenderTargetPool::Acquire(const RenderTargetDesc &desc)
+{
+	for (Entry &e : m_entries) {
+		if (!e.inUse && IsCompatible(e.target->GetDesc(), desc)) {
+			e.inUse = true;
+			e.lastUsed = m_frame;
+			return e.target;
+		}
+	}
+
+	RenderTarget *rt = m_renderer->CreateRenderTarget(desc);
+	if (!rt) return nullptr;
+	const Entry e = { rt, true, m_frame };
+	m_entries.push_back(e);
+	return rt;
+}
+
+void RenderTargetPool::Release(RenderTarget *rt)
+{
+	for (Entry &e : m_entries) {
+		if (e.target == rt) {
+			assert(e.inUse);
+			e.inUse = false;
+			e.lastUsed = m_frame;
+			return;
+		}
+	}
+	assert(false && "render target not from this pool");
+}
+
+void RenderTargetPool::EndFrame()
+{
+	++m_frame;
+	for (auto it = m_entries.begin(); it != m_entries.end();) {
+		if (!it->inUse && m_frame - it->lastUsed > MAX_IDLE_FRAMES) {
+			delete it->target;
+			it = m_entries.erase(it);
+		} else
+			++it;
+	}
+}
+
+Uint32 RenderTargetPool::GetNumTargetsInUse() const
+{
+	Uint32 n = 0;
+	for (const Entry &e : m_entries)
+		if (e.inUse) ++n;
+	return n;
+}
+
+size_t RenderTargetPool::GetMemorySize() const
+{
+	size_t bytes = 0;
+	for (const Entry &e : m_entries) {
+		const RenderTargetDesc &d = e.target->GetDesc();
+		if (d.colorFormat != TEXTURE_NONE)
+			bytes += Renderer::GetTextureMemorySize(TextureDescriptor(d.colorFormat, vector2f(d.width, d.height)));
+		// 24-bit depth, padded
+		if (d.depthFormat != TEXTURE_NONE)
+			bytes += size_t(d.width) * size_t(d.height) * 4;
+	}
+	return bytes;
+}
+
+}
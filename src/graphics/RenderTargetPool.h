@@ -0,0 +1,57 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_RENDERTARGETPOOL_H
+#define _GRAPHICS_RENDERTARGETPOOL_H
+
+#include "libs.h"
+#include "RenderTarget.h"
+#include <vector>
+
+namespace Graphics {
+
+class Renderer;
+
+/*
+ * Shared pool of transient render targets. A pass acquires a target for
+ * as long as it needs it and releases it as soon as the result has been
+ * consumed; a later pass asking for the same size and formats then gets
+ * the same target back instead of a new allocation, so passes whose
+ * targets are never alive at the same time share their memory.
+ *
+ * Targets nobody has asked for in a while are freed by EndFrame(), which
+ * the renderer calls once a frame after swapping.
+ *
+ * Acquired targets keep whatever textures were attached last; a pass that
+ * attaches its own must detach them before releasing the target.
+ */
+class RenderTargetPool {
+public:
+	RenderTargetPool(Renderer *r);
+	~RenderTargetPool();
+
+	RenderTarget *Acquire(const RenderTargetDesc &desc);
+	void Release(RenderTarget *rt);
+
+	void EndFrame();
+
+	Uint32 GetNumTargets() const { return m_entries.size(); }
+	Uint32 GetNumTargetsInUse() const;
+	size_t GetMemorySize() const;
+
+private:
+	struct Entry {
+		RenderTarget *target;
+		bool inUse;
+		Uint32 lastUsed; // m_frame
+	};
+	static bool IsCompatible(const RenderTargetDesc &a, const RenderTargetDesc &b);
+
+	Renderer *m_renderer;
+	std::vector<Entry> m_entries;
+	Uint32 m_frame;
+};
+
+}
+
+#endif
@@ -2,13 +2,27 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "Renderer.h"
+#include "FrameCapture.h"
 #include "Texture.h"
+#include "RenderQueue.h"
+#include "RenderTargetPool.h"
+#include "SpriteBatch.h"
+#include <algorithm>
 
 namespace Graphics {
 
+// textures used this recently are kept even when they're over budget
+static const Uint32 TEXTURE_CACHE_MIN_IDLE_TICKS = 300;
+// how often TrimTextureCache actually goes through the cache
+static const Uint32 TEXTURE_CACHE_TRIM_INTERVAL = 60;
+
 Renderer::Renderer(WindowSDL *window, int w, int h) :
-	m_width(w), m_height(h), m_ambient(Color::BLACK), m_window(window)
+	m_width(w), m_height(h), m_ambient(Color::BLACK), m_captureReplays(0), m_captureSkipFrames(0),
+	m_textureCacheTick(0), m_textureStreamer(nullptr), m_window(window)
 {
+	m_renderQueue.reset(new RenderQueue(this));
+	m_renderTargetPool.reset(new RenderTargetPool(this));
+	m_spriteBatch.reset(new SpriteBatch(this));
 }
 
 Renderer::~Renderer()
@@ -16,32 +30,104 @@ Renderer::~Renderer()
 	RemoveAllCachedTextures();
 }
 
+void Renderer::CaptureFrame(Uint32 replays, Uint32 skipFrames, CaptureCallback callback)
+{
+	m_captureReplays = replays;
+	m_captureSkipFrames = skipFrames;
+	m_captureCallback = callback;
+}
+
 Texture *Renderer::GetCachedTexture(const std::string &type, const std::string &name)
 {
 	TextureCacheMap::iterator i = m_textures.find(TextureCacheKey(type,name));
 	if (i == m_textures.end()) return 0;
-	return (*i).second->Get();
+	(*i).second.lastUsed = m_textureCacheTick;
+	return (*i).second.texture->Get();
 }
 
 void Renderer::AddCachedTexture(const std::string &type, const std::string &name, Texture *texture)
 {
 	RemoveCachedTexture(type,name);
-	m_textures.insert(std::make_pair(TextureCacheKey(type,name),new RefCountedPtr<Texture>(texture)));
+	const TextureCacheEntry entry = { new RefCountedPtr<Texture>(texture), m_textureCacheTick };
+	m_textures.insert(std::make_pair(TextureCacheKey(type,name),entry));
 }
 
 void Renderer::RemoveCachedTexture(const std::string &type, const std::string &name)
 {
 	TextureCacheMap::iterator i = m_textures.find(TextureCacheKey(type,name));
 	if (i == m_textures.end()) return;
-	delete (*i).second;
+	delete (*i).second.texture;
 	m_textures.erase(i);
 }
 
 void Renderer::RemoveAllCachedTextures()
 {
 	for (TextureCacheMap::iterator i = m_textures.begin(); i != m_textures.end(); ++i)
-		delete (*i).second;
+		delete (*i).second.texture;
 	m_textures.clear();
 }
 
+size_t Renderer::GetTextureMemorySize(const TextureDescriptor &descriptor)
+{
+	size_t bytes = size_t(descriptor.dataSize.x) * size_t(descriptor.dataSize.y);
+	switch (descriptor.format) {
+		case TEXTURE_RGBA_8888: bytes *= 4; break;
+		case TEXTURE_RGB_888: bytes *= 3; break;
+		case TEXTURE_LUMINANCE_ALPHA_88: bytes *= 2; break;
+		case TEXTURE_R_FLOAT: bytes *= 4; break;
+		case TEXTURE_DXT1: bytes /= 2; break;
+		default: break;
+	}
+	if (descriptor.generateMipmaps || descriptor.numberOfMipMaps > 1)
+		bytes = bytes * 4 / 3;
+	if (descriptor.type == TEXTURE_CUBE_MAP)
+		bytes *= 6;
+	else if (descriptor.type == TEXTURE_2D_ARRAY)
+		bytes *= descriptor.layers;
+	return bytes;
+}
+
+std::map<std::string,Renderer::TextureCacheUsage> Renderer::GetTextureCacheUsage() const
+{
+	std::map<std::string,TextureCacheUsage> usage;
+	for (TextureCacheMap::const_iterator i = m_textures.begin(); i != m_textures.end(); ++i) {
+		TextureCacheUsage &u = usage[(*i).first.first];
+		u.bytes += GetTextureMemorySize((*i).second.texture->Get()->GetDescriptor());
+		u.textures++;
+	}
+	return usage;
+}
+
+void Renderer::TrimTextureCache()
+{
+	PROFILE_SCOPED()
+	if (++m_textureCacheTick % TEXTURE_CACHE_TRIM_INTERVAL || m_textureBudgets.empty())
+		return;
+
+	std::map<std::string,size_t> used;
+	std::vector<std::pair<TextureCacheMap::iterator,size_t> > idle;
+	for (TextureCacheMap::iterator i = m_textures.begin(); i != m_textures.end(); ++i) {
+		const Texture *t = (*i).second.texture->Get();
+		const size_t bytes = GetTextureMemorySize(t->GetDescriptor());
+		used[(*i).first.first] += bytes;
+		// the cache's own reference is the only one left
+		if (t->GetRefCount() == 1 && m_textureCacheTick - (*i).second.lastUsed > TEXTURE_CACHE_MIN_IDLE_TICKS)
+			idle.push_back(std::make_pair(i, bytes));
+	}
+
+	std::sort(idle.begin(), idle.end(), [](const std::pair<TextureCacheMap::iterator,size_t> &a, const std::pair<TextureCacheMap::iterator,size_t> &b) {
+		return (*a.first).second.lastUsed < (*b.first).second.lastUsed;
+	});
+
+	for (auto &it : idle) {
+		const std::string &type = (*it.first).first.first;
+		auto budget = m_textureBudgets.find(type);
+		if (budget == m_textureBudgets.end() || used[type] <= budget->second)
+			continue;
+		used[type] -= it.second;
+		delete (*it.first).second.texture;
+		m_textures.erase(it.first);
+	}
+}
+
 }
@@ -9,6 +9,7 @@
 #include "graphics/Types.h"
 #include "graphics/Light.h"
 #include "Stats.h"
+#include <functional>
 #include <map>
 #include <memory>
 
@@ -19,12 +20,17 @@ namespace Graphics {
  * It is also used to create render states, materials and vertex/index buffers.
  */
 
+class FrameCapture;
 class Material;
 class MaterialDescriptor;
+class RenderQueue;
+class SpriteBatch;
+class RenderTargetPool;
 class RenderState;
 class RenderTarget;
 class Texture;
 class TextureDescriptor;
+class TextureStreamer;
 class VertexArray;
 class VertexBuffer;
 class IndexBuffer;
@@ -66,6 +72,7 @@ public:
 
 	//set 0 to render to screen
 	virtual bool SetRenderTarget(RenderTarget*) = 0;
+	virtual RenderTarget *GetRenderTarget() const { return 0; }
 
 	//clear color and depth buffer
 	virtual bool ClearScreen() = 0;
@@ -118,7 +125,7 @@ public:
 	//returns 0 if unsupported
 	virtual RenderTarget *CreateRenderTarget(const RenderTargetDesc &) { return 0; }
 	virtual VertexBuffer *CreateVertexBuffer(const VertexBufferDesc&) = 0;
-	virtual IndexBuffer *CreateIndexBuffer(Uint32 size, BufferUsage) = 0;
+	virtual IndexBuffer *CreateIndexBuffer(Uint32 size, BufferUsage, IndexFormat = INDEX_FORMAT_UINT16) = 0;
 	virtual InstanceBuffer *CreateInstanceBuffer(Uint32 size, BufferUsage) = 0;
 
 	Texture *GetCachedTexture(const std::string &type, const std::string &name);
@@ -126,6 +133,24 @@ public:
 	void RemoveCachedTexture(const std::string &type, const std::string &name);
 	void RemoveAllCachedTextures();
 
+	// cached textures of a type that nothing else holds on to are thrown
+	// away, least recently used first, once the type goes over budget.
+	// TrimTextureCache does this and should be called once a frame
+	void SetTextureCacheBudget(const std::string &type, size_t bytes) { m_textureBudgets[type] = bytes; }
+	void TrimTextureCache();
+	// bytes and number of cached textures, by type
+	struct TextureCacheUsage {
+		TextureCacheUsage() : bytes(0), textures(0) {}
+		size_t bytes;
+		Uint32 textures;
+	};
+	std::map<std::string,TextureCacheUsage> GetTextureCacheUsage() const;
+	static size_t GetTextureMemorySize(const TextureDescriptor &descriptor);
+
+	// not owned. 0 means TextureBuilder::GetOrCreateTextureAsync loads in place
+	void SetTextureStreamer(TextureStreamer *streamer) { m_textureStreamer = streamer; }
+	TextureStreamer *GetTextureStreamer() const { return m_textureStreamer; }
+
 	virtual bool ReloadShaders() = 0;
 
 	// our own matrix stack
@@ -176,10 +201,57 @@ public:
 		MatrixMode m_matrixMode;
 	};
 
+	// time a pass on the GPU, results end up in Stats a frame or two later.
+	// scopes can nest. does nothing if the renderer can't time things
+	virtual void BeginGpuTimer(Stats::GpuTimerType type) {}
+	virtual void EndGpuTimer() {}
+
+	class GpuTimerTicket {
+	public:
+		GpuTimerTicket(Renderer *r, Stats::GpuTimerType type) : m_renderer(r) { m_renderer->BeginGpuTimer(type); }
+		virtual ~GpuTimerTicket() { m_renderer->EndGpuTimer(); }
+	private:
+		GpuTimerTicket(const GpuTimerTicket&);
+		GpuTimerTicket &operator=(const GpuTimerTicket&);
+		Renderer *m_renderer;
+	};
+
+	// count the samples that pass the depth test between Begin and End.
+	// results are only read once the GPU has them, usually a frame later.
+	// CreateOcclusionQuery returns 0 if the renderer can't do them
+	virtual Uint32 CreateOcclusionQuery() { return 0; }
+	virtual void DeleteOcclusionQuery(Uint32 query) {}
+	virtual void BeginOcclusionQuery(Uint32 query) {}
+	virtual void EndOcclusionQuery() {}
+	// false while the result isn't in yet. never waits for the GPU
+	virtual bool GetOcclusionQueryResult(Uint32 query, Uint32 &samples) { return false; }
+
+	// record a frame's calls, from BeginFrame up to the swap, and just before
+	// the swap draw them again `replays` times, timing the CPU submit and the
+	// GPU. skipFrames frames go by first. a fixed workload for comparing
+	// renderer changes on the same scene. does nothing if the renderer can't
+	struct CaptureResult {
+		Uint32 commands;
+		Uint32 draws;
+		Uint32 replays;
+		double cpuSeconds; // submitting all the replays
+		double gpuSeconds; // < 0 if the GPU couldn't be timed
+	};
+	typedef std::function<void(const CaptureResult&)> CaptureCallback;
+	void CaptureFrame(Uint32 replays, Uint32 skipFrames = 0, CaptureCallback callback = CaptureCallback());
+	bool IsCapturePending() const { return m_captureReplays > 0; }
+
 	virtual bool Screendump(ScreendumpState &sd) { return false; }
 
 	Stats& GetStats() { return m_stats; }
 
+	// deferred, sorted buffer draws. see RenderQueue.h
+	RenderQueue &GetRenderQueue() { return *m_renderQueue; }
+	// transient render targets shared between passes. see RenderTargetPool.h
+	RenderTargetPool &GetRenderTargetPool() { return *m_renderTargetPool; }
+	// thruster and navlight sprites drawn together. see SpriteBatch.h
+	SpriteBatch &GetSpriteBatch() { return *m_spriteBatch; }
+
 protected:
 	int m_width;
 	int m_height;
@@ -190,12 +262,29 @@ protected:
 	virtual void PushState() = 0;
 	virtual void PopState() = 0;
 
+	// the frame being recorded, if any. see CaptureFrame
+	std::unique_ptr<FrameCapture> m_capture;
+	Uint32 m_captureReplays;
+	Uint32 m_captureSkipFrames;
+	CaptureCallback m_captureCallback;
+
 private:
 	typedef std::pair<std::string,std::string> TextureCacheKey;
-	typedef std::map<TextureCacheKey,RefCountedPtr<Texture>*> TextureCacheMap;
+	struct TextureCacheEntry {
+		RefCountedPtr<Texture> *texture;
+		Uint32 lastUsed; // m_textureCacheTick
+	};
+	typedef std::map<TextureCacheKey,TextureCacheEntry> TextureCacheMap;
 	TextureCacheMap m_textures;
+	std::map<std::string,size_t> m_textureBudgets;
+	Uint32 m_textureCacheTick;
+	TextureStreamer *m_textureStreamer;
 
 	std::unique_ptr<WindowSDL> m_window;
+	std::unique_ptr<RenderQueue> m_renderQueue;
+	// after m_window: the targets must go while the GL context is still there
+	std::unique_ptr<RenderTargetPool> m_renderTargetPool;
+	std::unique_ptr<SpriteBatch> m_spriteBatch;
 };
 
 }
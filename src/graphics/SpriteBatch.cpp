@@ -0,0 +1,106 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "SpriteBatch.h"
+#include "Renderer.h"
+#include "Material.h"
+#include "Texture.h"
+
+namespace Graphics {
+
+SpriteBatch::Group::Group(RenderState *r, Texture *t)
+: renderState(r)
+, texture(t)
+, vertices(new VertexArray(ATTRIB_POSITION | ATTRIB_DIFFUSE | ATTRIB_UV0))
+{
+}
+
+SpriteBatch::SpriteBatch(Renderer *r)
+: m_renderer(r)
+, m_depth(0)
+, m_projection(matrix4x4f::Identity())
+{
+}
+
+SpriteBatch::~SpriteBatch()
+{
+}
+
+void SpriteBatch::Begin()
+{
+	++m_depth;
+}
+
+void SpriteBatch::End()
+{
+	assert(m_depth > 0);
+	if (--m_depth == 0)
+		Flush();
+}
+
+SpriteBatch::Group &SpriteBatch::GetGroup(RenderState *rs, Texture *tex)
+{
+	for (Group &g : m_groups)
+		if (g.renderState == rs && g.texture == tex)
+			return g;
+	m_groups.push_back(Group(rs, tex));
+	return m_groups.back();
+}
+
+void SpriteBatch::Add(const matrix4x4f &modelView, const vector3f *positions, const vector2f *uvs, Uint32 count,
+	const Color &c, RenderState *rs, Texture *tex)
+{
+	assert(count % 3 == 0);
+	if (count == 0)
+		return;
+
+	// one projection per flush; a different one (eg. a cockpit, or another
+	// camera) starts the next
+	const matrix4x4f &projection = m_renderer->GetCurrentProjection();
+	if (memcmp(&projection, &m_projection, sizeof(matrix4x4f)) != 0) {
+		Flush();
+		m_projection = projection;
+	}
+
+	VertexArray &va = *GetGroup(rs, tex).vertices;
+	for (Uint32 i = 0; i < count; i++)
+		va.Add(modelView * positions[i], c, uvs[i]);
+
+	if (!IsActive())
+		Flush();
+}
+
+void SpriteBatch::Flush()
+{
+	PROFILE_SCOPED()
+	bool empty = true;
+	for (const Group &g : m_groups)
+		if (g.vertices->GetNumVerts() > 0) empty = false;
+	if (empty)
+		return;
+
+	if (!m_material.Valid()) {
+		MaterialDescriptor desc;
+		desc.textures = 1;
+		desc.vertexColors = true;
+		m_material.Reset(m_renderer->CreateMaterial(desc));
+	}
+
+	{
+		Renderer::MatrixTicket projTicket(m_renderer, MatrixMode::PROJECTION);
+		Renderer::MatrixTicket mvTicket(m_renderer, MatrixMode::MODELVIEW);
+		m_renderer->SetProjection(m_projection);
+		m_renderer->SetTransform(matrix4x4f::Identity());
+		for (Group &g : m_groups) {
+			if (g.vertices->GetNumVerts() == 0)
+				continue;
+			m_material->texture0 = g.texture;
+			m_renderer->DrawTriangles(g.vertices.get(), g.renderState, m_material.Get());
+			g.vertices->Clear();
+		}
+	}
+	// groups are kept for the next frame, but only compare the texture
+	m_material->texture0 = nullptr;
+}
+
+}
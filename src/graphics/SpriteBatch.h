@@ -0,0 +1,63 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_SPRITEBATCH_H
+#define _GRAPHICS_SPRITEBATCH_H
+
+#include "libs.h"
+#include "graphics/VertexArray.h"
+#include <vector>
+
+namespace Graphics {
+
+class Renderer;
+class RenderState;
+class Material;
+class Texture;
+
+/*
+ * Collects small textured, self-lit triangles (thruster flames, navlight
+ * halos) between Begin() and End() and draws them with one draw per
+ * texture and render state. Triangles are moved into view space when
+ * they are added and carry their colour per vertex, so sprites from any
+ * number of models go in the same draw. Outside of Begin()/End() each
+ * Add() is drawn straight away.
+ *
+ * Only meant for blend modes that don't depend on draw order (additive),
+ * since everything ends up drawn after whatever was drawn in between.
+ * Begin()/End() nest; only the outermost End() draws.
+ */
+class SpriteBatch {
+public:
+	SpriteBatch(Renderer *r);
+	~SpriteBatch();
+
+	void Begin();
+	void End();
+	bool IsActive() const { return m_depth > 0; }
+
+	// count/3 triangles, positions relative to modelView, c for all of them
+	void Add(const matrix4x4f &modelView, const vector3f *positions, const vector2f *uvs, Uint32 count,
+		const Color &c, RenderState *rs, Texture *tex);
+
+	void Flush();
+
+private:
+	struct Group {
+		Group(RenderState *r, Texture *t);
+		RenderState *renderState;
+		Texture *texture;
+		std::unique_ptr<VertexArray> vertices;
+	};
+	Group &GetGroup(RenderState *rs, Texture *tex);
+
+	Renderer *m_renderer;
+	int m_depth;
+	std::vector<Group> m_groups;
+	matrix4x4f m_projection;
+	RefCountedPtr<Material> m_material;
+};
+
+}
+
+#endif
@@ -17,6 +17,11 @@ namespace Graphics {
 		m_frameStats[m_currentFrame].m_stats[type] += count;
 	}
 
+	void Stats::AddGpuTime(const GpuTimerType type, const Uint32 microseconds)
+	{
+		m_frameStats[m_currentFrame].m_gpuTime[type] += microseconds;
+	}
+
 	void Stats::NextFrame()
 	{
 		++m_currentFrame;
@@ -30,4 +35,40 @@ namespace Graphics {
 	const Stats::TFrameData& Stats::FrameStatsPrevious() const { 
 		return m_frameStats[Clamp(m_currentFrame-1, 0U, MAX_FRAMES_STORE-1)]; 
 	}
+
+	const char *Stats::GetGpuTimerName(const GpuTimerType type)
+	{
+		static const char *names[MAX_GPU_TIMER] = {
+			"frame",
+			"scene",
+			"background",
+			"terrain",
+			"atmospheres",
+			"models",
+			"cockpit",
+			"ui",
+		};
+		assert(type < MAX_GPU_TIMER);
+		return names[type];
+	}
+
+	std::string Stats::DumpGpuTimes() const
+	{
+		std::string out;
+		char buf[128];
+		for (Uint32 t = 0; t < MAX_GPU_TIMER; t++) {
+			// skip the frame being recorded, it hasn't had any results yet
+			Uint64 total = 0;
+			Uint32 frames = 0;
+			for (Uint32 f = 0; f < MAX_FRAMES_STORE; f++) {
+				if (f == m_currentFrame)
+					continue;
+				total += m_frameStats[f].m_gpuTime[t];
+				frames++;
+			}
+			snprintf(buf, sizeof(buf), "  %-12s %8.3f ms\n", GetGpuTimerName(GpuTimerType(t)), double(total) / (frames * 1000.0));
+			out += buf;
+		}
+		return out;
+	}
 }
@@ -5,6 +5,7 @@
 #define _STATS_H
 
 #include "SDL_stdinc.h"
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -20,6 +21,12 @@ public:
 		STAT_DRAWTRIS,
 		STAT_DRAWPOINTSPRITES,
 
+		// state changes
+		STAT_PROGRAM_SWITCHES,
+		STAT_VAO_BINDS,
+		STAT_UNIFORMS_SET,
+		STAT_UNIFORMS_SKIPPED,
+
 		// objects
 		STAT_BUILDINGS,
 		STAT_CITIES,
@@ -37,17 +44,40 @@ public:
 
 		MAX_STAT
 	};
+
+	// GPU time spent in each pass. scopes can nest, so these overlap (the
+	// frame covers everything)
+	enum GpuTimerType {
+		GPU_TIMER_FRAME = 0,
+		GPU_TIMER_SCENE,
+		GPU_TIMER_BACKGROUND,
+		GPU_TIMER_TERRAIN,
+		GPU_TIMER_ATMOSPHERES,
+		GPU_TIMER_MODELS,
+		GPU_TIMER_COCKPIT,
+		GPU_TIMER_UI,
+
+		MAX_GPU_TIMER
+	};
 	
 	struct TFrameData {
 		Uint32 m_stats[MAX_STAT];
+		// microseconds. results come back from the renderer a frame or two
+		// late, so this is the latest available rather than this frame's
+		Uint32 m_gpuTime[MAX_GPU_TIMER];
 	};
 
 	Stats();
 	~Stats() {}
 
 	void AddToStatCount(const StatType type, const Uint32 count);
+	void AddGpuTime(const GpuTimerType type, const Uint32 microseconds);
 	void NextFrame();
 
+	static const char *GetGpuTimerName(const GpuTimerType type);
+	// average GPU time per pass over the stored frames, one pass per line
+	std::string DumpGpuTimes() const;
+
 	const TFrameData& FrameStats() const { return m_frameStats[m_currentFrame]; }
 	const TFrameData& FrameStatsPrevious() const;
 
@@ -23,6 +23,8 @@ enum TextureFormat {
 	TEXTURE_DXT1, // data is expected to be pre-compressed
 	TEXTURE_DXT5,
 
+	TEXTURE_R_FLOAT, // one 32 bit float channel, for tables the shaders look up
+
 	TEXTURE_DEPTH //precision chosen by renderer
 };
 
@@ -35,7 +37,8 @@ enum TextureSampleMode {
 
 enum TextureType {
 	TEXTURE_2D,
-	TEXTURE_CUBE_MAP
+	TEXTURE_CUBE_MAP,
+	TEXTURE_2D_ARRAY // layers of the same size and format, filled one at a time
 };
 
 struct TextureCubeData {
@@ -50,15 +53,15 @@ struct TextureCubeData {
 class TextureDescriptor {
 public:
 	TextureDescriptor() :
-		format(TEXTURE_RGBA_8888), dataSize(1.0f), texSize(1.0f), sampleMode(LINEAR_CLAMP), generateMipmaps(false), allowCompression(true), numberOfMipMaps(0), type(TEXTURE_2D)
+		format(TEXTURE_RGBA_8888), dataSize(1.0f), texSize(1.0f), sampleMode(LINEAR_CLAMP), generateMipmaps(false), allowCompression(true), numberOfMipMaps(0), type(TEXTURE_2D), layers(1)
 	{}
 
-	TextureDescriptor(TextureFormat _format, const vector2f &_dataSize, TextureSampleMode _sampleMode = LINEAR_CLAMP, bool _generateMipmaps = false, bool _allowCompression = true, unsigned int _numberOfMipMaps = 0, TextureType _textureType = TEXTURE_2D) :
-		format(_format), dataSize(_dataSize), texSize(1.0f), sampleMode(_sampleMode), generateMipmaps(_generateMipmaps), allowCompression(_allowCompression), numberOfMipMaps(_numberOfMipMaps), type(_textureType)
+	TextureDescriptor(TextureFormat _format, const vector2f &_dataSize, TextureSampleMode _sampleMode = LINEAR_CLAMP, bool _generateMipmaps = false, bool _allowCompression = true, unsigned int _numberOfMipMaps = 0, TextureType _textureType = TEXTURE_2D, unsigned int _layers = 1) :
+		format(_format), dataSize(_dataSize), texSize(1.0f), sampleMode(_sampleMode), generateMipmaps(_generateMipmaps), allowCompression(_allowCompression), numberOfMipMaps(_numberOfMipMaps), type(_textureType), layers(_layers)
 	{}
 
-	TextureDescriptor(TextureFormat _format, const vector2f &_dataSize, const vector2f &_texSize, TextureSampleMode _sampleMode = LINEAR_CLAMP, bool _generateMipmaps = false, bool _allowCompression = true, unsigned int _numberOfMipMaps = 0, TextureType _textureType = TEXTURE_2D) :
-		format(_format), dataSize(_dataSize), texSize(_texSize), sampleMode(_sampleMode), generateMipmaps(_generateMipmaps), allowCompression(_allowCompression), numberOfMipMaps(_numberOfMipMaps), type(_textureType)
+	TextureDescriptor(TextureFormat _format, const vector2f &_dataSize, const vector2f &_texSize, TextureSampleMode _sampleMode = LINEAR_CLAMP, bool _generateMipmaps = false, bool _allowCompression = true, unsigned int _numberOfMipMaps = 0, TextureType _textureType = TEXTURE_2D, unsigned int _layers = 1) :
+		format(_format), dataSize(_dataSize), texSize(_texSize), sampleMode(_sampleMode), generateMipmaps(_generateMipmaps), allowCompression(_allowCompression), numberOfMipMaps(_numberOfMipMaps), type(_textureType), layers(_layers)
 	{}
 
 	const TextureFormat format;
@@ -69,6 +72,7 @@ public:
 	const bool allowCompression;
 	const unsigned int numberOfMipMaps;
 	const TextureType type;
+	const unsigned int layers; // TEXTURE_2D_ARRAY only
 
 	void operator=(const TextureDescriptor &o) {
 		const_cast<TextureFormat&>(format) = o.format;
@@ -79,6 +83,7 @@ public:
 		const_cast<bool&>(allowCompression) = o.allowCompression;
 		const_cast<unsigned int&>(numberOfMipMaps) = o.numberOfMipMaps;
 		const_cast<TextureType&>(type) = o.type;
+		const_cast<unsigned int&>(layers) = o.layers;
 	}
 };
 
@@ -91,12 +96,19 @@ public:
         Update(data, vector2f(0,0), dataSize, format, numMips);
     }
 	virtual void Update(const TextureCubeData &data, const vector2f &dataSize, TextureFormat format, const unsigned int numMips = 0) = 0;
+	// one whole layer of a TEXTURE_2D_ARRAY
+	virtual void UpdateLayer(const void *data, unsigned int layer, const vector2f &dataSize, TextureFormat format, const unsigned int numMips = 0) = 0;
+	// throw away the contents and make the texture over with a new size
+	// and format. the object stays the same so anything holding it sees
+	// the new texture once it's been updated
+	virtual void Reallocate(const TextureDescriptor &descriptor) = 0;
 	virtual void SetSampleMode(TextureSampleMode) = 0;
 
 	virtual ~Texture() {}
 
 protected:
 	Texture(const TextureDescriptor &descriptor) : m_descriptor(descriptor) {}
+	void SetDescriptor(const TextureDescriptor &descriptor) { m_descriptor = descriptor; }
 
 private:
 	TextureDescriptor m_descriptor;
@@ -2,6 +2,8 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "TextureBuilder.h"
+#include "TextureStreamer.h"
+#include "TextureCooker.h"
 #include "FileSystem.h"
 #include "utils.h"
 #include <SDL_image.h>
@@ -12,13 +14,15 @@
 
 namespace Graphics {
 
+Uint32 TextureBuilder::s_maxTextureSize = 0;
+
 TextureBuilder::TextureBuilder(const SDLSurfacePtr &surface, TextureSampleMode sampleMode, bool generateMipmaps, bool potExtend, bool forceRGBA, bool compressTextures) :
-    m_surface(surface), m_sampleMode(sampleMode), m_generateMipmaps(generateMipmaps), m_potExtend(potExtend), m_forceRGBA(forceRGBA), m_compressTextures(compressTextures), m_textureType(TEXTURE_2D), m_prepared(false)
+    m_surface(surface), m_ddsOffset(0), m_sampleMode(sampleMode), m_generateMipmaps(generateMipmaps), m_potExtend(potExtend), m_forceRGBA(forceRGBA), m_compressTextures(compressTextures), m_textureType(TEXTURE_2D), m_prepared(false)
 {
 }
 
 TextureBuilder::TextureBuilder(const std::string &filename, TextureSampleMode sampleMode, bool generateMipmaps, bool potExtend, bool forceRGBA, bool compressTextures, TextureType textureType) :
-    m_filename(filename), m_sampleMode(sampleMode), m_generateMipmaps(generateMipmaps), m_potExtend(potExtend), m_forceRGBA(forceRGBA), m_compressTextures(compressTextures), m_textureType(textureType), m_prepared(false)
+    m_ddsOffset(0), m_filename(filename), m_sampleMode(sampleMode), m_generateMipmaps(generateMipmaps), m_potExtend(potExtend), m_forceRGBA(forceRGBA), m_compressTextures(compressTextures), m_textureType(textureType), m_prepared(false)
 {
 }
 
@@ -93,7 +97,7 @@ void TextureBuilder::PrepareSurface()
 		std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
 		if (ends_with_ci(filename, ".dds")) {
 			LoadDDS();
-		} else {
+		} else if (!LoadCooked()) {
 			LoadSurface();
 		}
 	}
@@ -175,6 +179,20 @@ void TextureBuilder::PrepareSurface()
 			// Cube map must be fully defined (6 images) to be used correctly
 			assert(numberOfImages == 6);
 		}
+
+		// drop the biggest levels of oversized textures. the rest of the
+		// chain is already there, so this costs nothing but video memory
+		if (s_maxTextureSize && m_textureType == TEXTURE_2D) {
+			const size_t blockSize = (targetTextureFormat == TEXTURE_DXT1) ? 8 : 16;
+			while ((actualWidth > s_maxTextureSize || actualHeight > s_maxTextureSize) && numberOfMipMaps > 1) {
+				m_ddsOffset += ((actualWidth + 3) / 4) * ((actualHeight + 3) / 4) * blockSize;
+				actualWidth = std::max(1u, actualWidth / 2);
+				actualHeight = std::max(1u, actualHeight / 2);
+				numberOfMipMaps--;
+			}
+			virtualWidth = actualWidth;
+			virtualHeight = actualHeight;
+		}
 	}
 
 	m_descriptor = TextureDescriptor(
@@ -229,6 +247,25 @@ void TextureBuilder::LoadDDS()
 	// XXX if we can't load the fallback texture, then what?
 }
 
+// the compressed copy modelcompiler -textures leaves next to an image, if
+// there is one and it's not older than the image
+bool TextureBuilder::LoadCooked()
+{
+	if (!m_compressTextures || m_textureType != TEXTURE_2D)
+		return false;
+
+	const std::string cooked = TextureCooker::GetCookedFilename(m_filename);
+	const FileSystem::FileInfo cookedInfo = FileSystem::gameDataFiles.Lookup(cooked);
+	if (!cookedInfo.IsFile())
+		return false;
+	const FileSystem::FileInfo info = FileSystem::gameDataFiles.Lookup(m_filename);
+	if (info.IsFile() && info.GetModificationTime() > cookedInfo.GetModificationTime())
+		return false;
+
+	LoadDDSFromFile(cooked, m_dds);
+	return m_dds.headerdone_;
+}
+
 void TextureBuilder::UpdateTexture(Texture *texture)
 {
 	if( m_surface ) {
@@ -253,7 +290,7 @@ void TextureBuilder::UpdateTexture(Texture *texture)
 		assert(m_dds.headerdone_);
 		assert(m_descriptor.format == TEXTURE_DXT1 || m_descriptor.format == TEXTURE_DXT5);
 		if(texture->GetDescriptor().type == TEXTURE_2D && m_textureType == TEXTURE_2D) {
-			texture->Update(m_dds.imgdata_.imgData, vector2f(m_dds.imgdata_.width,m_dds.imgdata_.height), m_descriptor.format, m_dds.imgdata_.numMipMaps);
+			texture->Update(m_dds.imgdata_.imgData + m_ddsOffset, m_descriptor.dataSize, m_descriptor.format, m_descriptor.numberOfMipMaps);
 		} else if(texture->GetDescriptor().type == TEXTURE_CUBE_MAP && m_textureType == TEXTURE_CUBE_MAP) {
 			TextureCubeData tcd;
 			// Size in bytes of each cube map face
@@ -273,6 +310,27 @@ void TextureBuilder::UpdateTexture(Texture *texture)
 	}
 }
 
+void TextureBuilder::UpdateTextureLayer(Texture *texture, unsigned int layer)
+{
+	assert(texture->GetDescriptor().type == TEXTURE_2D_ARRAY && m_textureType == TEXTURE_2D);
+	PrepareSurface();
+	if (m_surface) {
+		texture->UpdateLayer(m_surface->pixels, layer, vector2f(m_surface->w,m_surface->h), m_descriptor.format, 0);
+	} else {
+		assert(m_dds.headerdone_);
+		assert(m_descriptor.format == TEXTURE_DXT1 || m_descriptor.format == TEXTURE_DXT5);
+		texture->UpdateLayer(m_dds.imgdata_.imgData + m_ddsOffset, layer, m_descriptor.dataSize, m_descriptor.format, m_descriptor.numberOfMipMaps);
+	}
+}
+
+Texture *TextureBuilder::GetOrCreateTextureAsync(Renderer *r, const std::string &type, const std::string &name)
+{
+	TextureStreamer *streamer = r->GetTextureStreamer();
+	if (!streamer || m_prepared || m_filename.empty())
+		return GetOrCreateTexture(r, type, name);
+	return streamer->GetOrCreateTexture(*this, type, name);
+}
+
 Texture *TextureBuilder::GetWhiteTexture(Renderer *r)
 {
 	return Model("textures/white.png").GetOrCreateTexture(r, "model");
@@ -39,6 +39,8 @@ public:
 
 	const TextureDescriptor &GetDescriptor() { PrepareSurface(); return m_descriptor; }
 	void UpdateTexture(Texture *texture); // XXX pass src/dest rectangles
+	// into one layer of a TEXTURE_2D_ARRAY made with the same size and format
+	void UpdateTextureLayer(Texture *texture, unsigned int layer);
 
 	Texture *CreateTexture(Renderer *r) {
 		Texture *t = r->CreateTexture(GetDescriptor());
@@ -56,6 +58,17 @@ public:
 		return t;
 	}
 
+	// loads the file on the renderer's TextureStreamer if it has one, and
+	// returns a stand-in that's filled in later. same as GetOrCreateTexture
+	// otherwise. only for file textures that haven't been prepared yet
+	Texture *GetOrCreateTextureAsync(Renderer *r, const std::string &type, const std::string &name = "");
+
+	const std::string &GetFilename() const { return m_filename; }
+
+	// DDS textures with mipmaps bigger than this in either dimension lose
+	// their top levels until they fit. 0 for no limit
+	static void SetMaxTextureSize(Uint32 size) { s_maxTextureSize = size; }
+
 	//commonly used dummy textures
 	static Texture *GetWhiteTexture(Renderer *);
 	static Texture *GetTransparentTexture(Renderer *);
@@ -64,8 +77,11 @@ private:
 	SDLSurfacePtr m_surface;
 	std::vector<SDLSurfacePtr> m_cubemap;
 	PicoDDS::DDSImage m_dds;
+	size_t m_ddsOffset; // to the first mip level kept
 	std::string m_filename;
 
+	static Uint32 s_maxTextureSize;
+
 	TextureSampleMode m_sampleMode;
 	bool m_generateMipmaps;
 
@@ -81,6 +97,7 @@ private:
 
 	void LoadSurface();
 	void LoadDDS();
+	bool LoadCooked();
 };
 
 }
@@ -0,0 +1,273 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "TextureCooker.h"
+#include "utils.h"
+#include "PicoDDS/PicoDDS.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace Graphics {
+namespace TextureCooker {
+
+static inline bool IsPow2(int n) { return n > 0 && (n & (n - 1)) == 0; }
+
+static inline Uint16 Pack565(const float *c)
+{
+	const int r = Clamp(int(c[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+	const int g = Clamp(int(c[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+	const int b = Clamp(int(c[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+	return Uint16((r << 11) | (g << 5) | b);
+}
+
+static inline void Unpack565(Uint16 v, int *c)
+{
+	const int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+	c[0] = (r << 3) | (r >> 2);
+	c[1] = (g << 2) | (g >> 4);
+	c[2] = (b << 3) | (b >> 2);
+}
+
+static void CompressColorBlock(const Uint8 *rgba, Uint8 *out)
+{
+	// principal axis of the colours, by a few rounds of power iteration on
+	// their covariance
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 3; c++)
+			mean[c] += rgba[i*4+c];
+	for (int c = 0; c < 3; c++)
+		mean[c] *= 1.0f / 16.0f;
+
+	float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++) {
+		const float r = rgba[i*4+0] - mean[0], g = rgba[i*4+1] - mean[1], b = rgba[i*4+2] - mean[2];
+		cov[0] += r*r; cov[1] += r*g; cov[2] += r*b;
+		cov[3] += g*g; cov[4] += g*b; cov[5] += b*b;
+	}
+
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iter = 0; iter < 4; iter++) {
+		const float x = axis[0]*cov[0] + axis[1]*cov[1] + axis[2]*cov[2];
+		const float y = axis[0]*cov[1] + axis[1]*cov[3] + axis[2]*cov[4];
+		const float z = axis[0]*cov[2] + axis[1]*cov[4] + axis[2]*cov[5];
+		const float m = std::max(std::max(fabs(x), fabs(y)), fabs(z));
+		if (m < 1e-6f)
+			break;
+		axis[0] = x / m; axis[1] = y / m; axis[2] = z / m;
+	}
+
+	// the colours furthest along it either way are the endpoints
+	float minDot = 1e30f, maxDot = -1e30f;
+	int minIdx = 0, maxIdx = 0;
+	for (int i = 0; i < 16; i++) {
+		const float d = rgba[i*4+0]*axis[0] + rgba[i*4+1]*axis[1] + rgba[i*4+2]*axis[2];
+		if (d < minDot) { minDot = d; minIdx = i; }
+		if (d > maxDot) { maxDot = d; maxIdx = i; }
+	}
+	const float cmax[3] = { float(rgba[maxIdx*4+0]), float(rgba[maxIdx*4+1]), float(rgba[maxIdx*4+2]) };
+	const float cmin[3] = { float(rgba[minIdx*4+0]), float(rgba[minIdx*4+1]), float(rgba[minIdx*4+2]) };
+	Uint16 c0 = Pack565(cmax), c1 = Pack565(cmin);
+
+	// four colour mode needs c0 > c1. if they're equal every index is 0
+	if (c0 < c1)
+		std::swap(c0, c1);
+
+	Uint32 indices = 0;
+	if (c0 != c1) {
+		int palette[4][3];
+		Unpack565(c0, palette[0]);
+		Unpack565(c1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = (2*palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2*palette[1][c]) / 3;
+		}
+		for (int i = 15; i >= 0; i--) {
+			int best = 0, bestDist = INT_MAX;
+			for (int p = 0; p < 4; p++) {
+				const int dr = rgba[i*4+0] - palette[p][0], dg = rgba[i*4+1] - palette[p][1], db = rgba[i*4+2] - palette[p][2];
+				const int dist = dr*dr + dg*dg + db*db;
+				if (dist < bestDist) { bestDist = dist; best = p; }
+			}
+			indices = (indices << 2) | best;
+		}
+	}
+
+	out[0] = c0 & 0xff; out[1] = c0 >> 8;
+	out[2] = c1 & 0xff; out[3] = c1 >> 8;
+	out[4] = indices & 0xff; out[5] = (indices >> 8) & 0xff;
+	out[6] = (indices >> 16) & 0xff; out[7] = indices >> 24;
+}
+
+static void CompressAlphaBlock(const Uint8 *rgba, Uint8 *out)
+{
+	int a0 = 0, a1 = 255;
+	for (int i = 0; i < 16; i++) {
+		a0 = std::max(a0, int(rgba[i*4+3]));
+		a1 = std::min(a1, int(rgba[i*4+3]));
+	}
+
+	// eight value mode, a0 > a1. if they're equal every index is 0
+	Uint64 indices = 0;
+	if (a0 != a1) {
+		int palette[8] = { a0, a1 };
+		for (int p = 1; p < 7; p++)
+			palette[p+1] = ((7-p)*a0 + p*a1) / 7;
+		for (int i = 15; i >= 0; i--) {
+			int best = 0, bestDist = INT_MAX;
+			for (int p = 0; p < 8; p++) {
+				const int dist = abs(int(rgba[i*4+3]) - palette[p]);
+				if (dist < bestDist) { bestDist = dist; best = p; }
+			}
+			indices = (indices << 3) | Uint64(best);
+		}
+	}
+
+	out[0] = Uint8(a0);
+	out[1] = Uint8(a1);
+	for (int i = 0; i < 6; i++)
+		out[2+i] = Uint8(indices >> (8*i));
+}
+
+void CompressBlockDXT1(const Uint8 *rgba, Uint8 *out)
+{
+	CompressColorBlock(rgba, out);
+}
+
+void CompressBlockDXT5(const Uint8 *rgba, Uint8 *out)
+{
+	CompressAlphaBlock(rgba, out);
+	CompressColorBlock(rgba, out + 8);
+}
+
+bool CanCook(const SDL_Surface *surface)
+{
+	return surface && IsPow2(surface->w) && IsPow2(surface->h) && surface->w >= 4 && surface->h >= 4;
+}
+
+// half the size, averaging each 2x2 (or 2x1 once one side is down to 1)
+static void Downsample(const std::vector<Uint8> &src, int w, int h, std::vector<Uint8> &dst)
+{
+	const int dw = std::max(1, w / 2), dh = std::max(1, h / 2);
+	dst.resize(dw * dh * 4);
+	for (int y = 0; y < dh; y++) {
+		const int y0 = std::min(y*2, h-1), y1 = std::min(y*2+1, h-1);
+		for (int x = 0; x < dw; x++) {
+			const int x0 = std::min(x*2, w-1), x1 = std::min(x*2+1, w-1);
+			for (int c = 0; c < 4; c++) {
+				const int sum = src[(y0*w+x0)*4+c] + src[(y0*w+x1)*4+c] + src[(y1*w+x0)*4+c] + src[(y1*w+x1)*4+c];
+				dst[(y*dw+x)*4+c] = Uint8((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+static void CompressLevel(const std::vector<Uint8> &pixels, int w, int h, bool alpha, std::vector<Uint8> &out)
+{
+	Uint8 block[16*4];
+	Uint8 packed[16];
+	for (int by = 0; by < h; by += 4) {
+		for (int bx = 0; bx < w; bx += 4) {
+			// levels under 4 pixels across repeat their edges to fill the block
+			for (int y = 0; y < 4; y++) {
+				const int sy = std::min(by + y, h - 1);
+				for (int x = 0; x < 4; x++) {
+					const int sx = std::min(bx + x, w - 1);
+					memcpy(&block[(y*4+x)*4], &pixels[(sy*w+sx)*4], 4);
+				}
+			}
+			if (alpha) {
+				CompressBlockDXT5(block, packed);
+				out.insert(out.end(), packed, packed + 16);
+			} else {
+				CompressBlockDXT1(block, packed);
+				out.insert(out.end(), packed, packed + 8);
+			}
+		}
+	}
+}
+
+static inline void PutUint32(std::vector<Uint8> &out, Uint32 v)
+{
+	out.push_back(v & 0xff);
+	out.push_back((v >> 8) & 0xff);
+	out.push_back((v >> 16) & 0xff);
+	out.push_back(v >> 24);
+}
+
+bool Cook(const SDLSurfacePtr &surface, std::vector<Uint8> &dds)
+{
+	PROFILE_SCOPED()
+	if (!CanCook(surface.Get()))
+		return false;
+
+	// ABGR8888 is R in the low byte of each 32 bit pixel whatever the
+	// machine's byte order, so reading pixels as Uint32s gives RGBA
+	SDL_Surface *s = SDL_ConvertSurfaceFormat(const_cast<SDL_Surface*>(surface.Get()), SDL_PIXELFORMAT_ABGR8888, 0);
+	if (!s)
+		return false;
+	const int w = s->w, h = s->h;
+	std::vector<Uint8> pixels(w * h * 4);
+	bool alpha = false;
+	SDL_LockSurface(s);
+	for (int y = 0; y < h; y++) {
+		const Uint32 *row = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(s->pixels) + y * s->pitch);
+		for (int x = 0; x < w; x++) {
+			const Uint32 p = row[x];
+			Uint8 *d = &pixels[(y*w+x)*4];
+			d[0] = p & 0xff; d[1] = (p >> 8) & 0xff; d[2] = (p >> 16) & 0xff; d[3] = p >> 24;
+			alpha = alpha || d[3] != 0xff;
+		}
+	}
+	SDL_UnlockSurface(s);
+	SDL_FreeSurface(s);
+
+	int levels = 1;
+	while ((w >> (levels-1)) > 1 || (h >> (levels-1)) > 1)
+		levels++;
+
+	std::vector<Uint8> data;
+	std::vector<Uint8> level(pixels), next;
+	int lw = w, lh = h;
+	for (int i = 0; i < levels; i++) {
+		CompressLevel(level, lw, lh, alpha, data);
+		if (i + 1 < levels) {
+			Downsample(level, lw, lh, next);
+			level.swap(next);
+			lw = std::max(1, lw / 2);
+			lh = std::max(1, lh / 2);
+		}
+	}
+
+	using namespace PicoDDS::DDS;
+	const Uint32 blockBytes = alpha ? 16 : 8;
+	dds.clear();
+	dds.reserve(128 + data.size());
+	PutUint32(dds, FOURCC('D','D','S',' '));
+	PutUint32(dds, 124);
+	PutUint32(dds, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE);
+	PutUint32(dds, h);
+	PutUint32(dds, w);
+	PutUint32(dds, ((w + 3) / 4) * ((h + 3) / 4) * blockBytes);
+	PutUint32(dds, 0); // depth
+	PutUint32(dds, levels);
+	for (int i = 0; i < 11; i++)
+		PutUint32(dds, 0);
+	// pixel format
+	PutUint32(dds, 32);
+	PutUint32(dds, DDPF_FOURCC);
+	PutUint32(dds, alpha ? FOURCC('D','X','T','5') : FOURCC('D','X','T','1'));
+	for (int i = 0; i < 5; i++)
+		PutUint32(dds, 0);
+	// caps
+	PutUint32(dds, DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX);
+	for (int i = 0; i < 4; i++)
+		PutUint32(dds, 0);
+	dds.insert(dds.end(), data.begin(), data.end());
+	return true;
+}
+
+}
+}
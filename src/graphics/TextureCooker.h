@@ -0,0 +1,46 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_TEXTURECOOKER_H
+#define _GRAPHICS_TEXTURECOOKER_H
+
+#include "libs.h"
+#include "SDLWrappers.h"
+#include <vector>
+
+namespace Graphics {
+
+/*
+ * Offline texture compression, for modelcompiler -textures. Turns an image
+ * into a DDS with its full mipmap chain in DXT1 (opaque) or DXT5 (with
+ * alpha), which TextureBuilder picks up in place of the original. Doing it
+ * ahead of time means the driver doesn't have to compress on every load,
+ * and the result doesn't depend on whose driver it is.
+ *
+ * The block encoder fits the endpoints along each block's principal axis.
+ * It's not as good as an exhaustive search, but it's in the same place as
+ * the drivers' and quick enough to run over everything in one go.
+ */
+namespace TextureCooker {
+
+	// true if the image can be cooked: power-of-two dimensions, at least a
+	// block on each side
+	bool CanCook(const SDL_Surface *surface);
+
+	// the whole file, header included. false if the image can't be cooked
+	bool Cook(const SDLSurfacePtr &surface, std::vector<Uint8> &dds);
+
+	// one 4x4 block of RGBA pixels, row by row
+	void CompressBlockDXT1(const Uint8 *rgba, Uint8 *out);
+	void CompressBlockDXT5(const Uint8 *rgba, Uint8 *out);
+
+	// the cooked file TextureBuilder looks for in place of an image
+	inline std::string GetCookedFilename(const std::string &filename) {
+		const size_t dot = filename.rfind('.');
+		return (dot == std::string::npos ? filename : filename.substr(0, dot)) + ".dds";
+	}
+}
+
+}
+
+#endif
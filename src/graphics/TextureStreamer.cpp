@@ -0,0 +1,60 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "TextureStreamer.h"
+#include "TextureBuilder.h"
+#include "Renderer.h"
+
+namespace Graphics {
+
+class TextureStreamer::LoadJob : public Job {
+public:
+	LoadJob(const TextureBuilder &builder, Texture *texture)
+		: m_builder(builder), m_texture(texture) { SetLane(LANE_IO); }
+
+	// file read, decode and any format conversion
+	virtual void OnRun() override { m_builder.GetDescriptor(); }
+
+	virtual void OnFinish() override {
+		m_texture->Reallocate(m_builder.GetDescriptor());
+		m_builder.UpdateTexture(m_texture.Get());
+	}
+
+	// called on the main thread, so let go of the texture while the
+	// renderer is still around
+	virtual void OnCancel() override { m_texture.Reset(); }
+
+	virtual const char *GetName() const override { return "TextureStreamer::LoadJob"; }
+
+private:
+	TextureBuilder m_builder;
+	RefCountedPtr<Texture> m_texture;
+};
+
+TextureStreamer::TextureStreamer(Renderer *r, JobQueue *jobs)
+: m_renderer(r)
+, m_jobs(jobs)
+{
+}
+
+Texture *TextureStreamer::GetOrCreateTexture(const TextureBuilder &builder, const std::string &type, const std::string &name)
+{
+	const std::string &cacheName = name.length() > 0 ? name : builder.GetFilename();
+	assert(cacheName.length() > 0);
+	Texture *t = m_renderer->GetCachedTexture(type, cacheName);
+	if (t) return t;
+
+	// stand-in until the job is done. it goes in the cache now so further
+	// requests for the same texture share it rather than loading it again
+	static const Uint8 transparent[4] = { 0, 0, 0, 0 };
+	t = m_renderer->CreateTexture(TextureDescriptor(TEXTURE_RGBA_8888, vector2f(1.0f), LINEAR_CLAMP, false, false));
+	t->Update(transparent, vector2f(1.0f), TEXTURE_RGBA_8888);
+	m_renderer->AddCachedTexture(type, cacheName, t);
+
+	LoadJob *job = new LoadJob(builder, t);
+	job->SetPriority(Job::PRIORITY_HIGH);
+	m_jobs.Order(job);
+	return t;
+}
+
+}
@@ -0,0 +1,39 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_TEXTURESTREAMER_H
+#define _GRAPHICS_TEXTURESTREAMER_H
+
+#include "JobQueue.h"
+#include <string>
+
+namespace Graphics {
+
+class Renderer;
+class Texture;
+class TextureBuilder;
+
+/*
+ * Loads textures on the job runners instead of at first use. A request
+ * hands back a 1x1 transparent texture straight away. Once the file has
+ * been read and decoded, that same texture is reallocated and filled in
+ * on the main thread, so materials that already hold it pick up the real
+ * image without being told.
+ */
+class TextureStreamer {
+public:
+	TextureStreamer(Renderer *r, JobQueue *jobs);
+
+	// like TextureBuilder::GetOrCreateTexture, but doesn't wait for the file
+	Texture *GetOrCreateTexture(const TextureBuilder &builder, const std::string &type, const std::string &name = "");
+
+private:
+	class LoadJob;
+
+	Renderer *m_renderer;
+	JobSet m_jobs;
+};
+
+}
+
+#endif
@@ -25,7 +25,9 @@ enum VertexAttribFormat {
 	ATTRIB_FORMAT_FLOAT2,
 	ATTRIB_FORMAT_FLOAT3,
 	ATTRIB_FORMAT_FLOAT4,
-	ATTRIB_FORMAT_UBYTE4
+	ATTRIB_FORMAT_UBYTE4,
+	ATTRIB_FORMAT_SHORT2N,	// signed 16-bit, normalised to [-1,1] by the GPU
+	ATTRIB_FORMAT_SHORT4N
 };
 
 enum BufferUsage {
@@ -39,6 +41,12 @@ enum BufferMapMode {
 	BUFFER_MAP_READ
 };
 
+enum IndexFormat {
+	INDEX_FORMAT_UINT8,
+	INDEX_FORMAT_UINT16,
+	INDEX_FORMAT_UINT32
+};
+
 enum PrimitiveType {
 	TRIANGLES = GL_TRIANGLES,
 	TRIANGLE_STRIP = GL_TRIANGLE_STRIP,
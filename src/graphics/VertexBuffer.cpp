@@ -2,6 +2,7 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "graphics/VertexBuffer.h"
+#include "graphics/FrameCapture.h"
 
 namespace Graphics {
 
@@ -15,7 +16,10 @@ Uint32 VertexBufferDesc::GetAttribSize(VertexAttribFormat f)
 	case ATTRIB_FORMAT_FLOAT4:
 		return 16;
 	case ATTRIB_FORMAT_UBYTE4:
+	case ATTRIB_FORMAT_SHORT2N:
 		return 4;
+	case ATTRIB_FORMAT_SHORT4N:
+		return 8;
 	default:
 		return 0;
 	}
@@ -65,6 +69,7 @@ Uint32 VertexBufferDesc::CalculateOffset(const VertexBufferDesc &desc, VertexAtt
 
 VertexBuffer::~VertexBuffer()
 {
+	FrameCapture::Forget(this);
 }
 
 Uint32 VertexBuffer::GetVertexCount() const
@@ -79,15 +84,17 @@ void VertexBuffer::SetVertexCount(Uint32 v)
 }
 
 // ------------------------------------------------------------
-IndexBuffer::IndexBuffer(Uint32 size, BufferUsage usage)
+IndexBuffer::IndexBuffer(Uint32 size, BufferUsage usage, IndexFormat format)
 	: m_size(size)
 	, m_indexCount(size)
 	, m_usage(usage)
+	, m_format(format)
 {
 }
 
 IndexBuffer::~IndexBuffer()
 {
+	FrameCapture::Forget(this);
 }
 
 void IndexBuffer::SetIndexCount(Uint32 ic)
@@ -96,6 +103,79 @@ void IndexBuffer::SetIndexCount(Uint32 ic)
 	m_indexCount = std::min(ic, GetSize());
 }
 
+void IndexBuffer::Populate(const Uint32 *indices, Uint32 count)
+{
+	assert(count <= GetSize());
+	switch (m_format) {
+	case INDEX_FORMAT_UINT8: {
+		Uint8 *p = Map<Uint8>(BUFFER_MAP_WRITE);
+		for (Uint32 i = 0; i < count; i++) {
+			assert(indices[i] <= 0xff);
+			p[i] = indices[i];
+		}
+		break;
+	}
+	case INDEX_FORMAT_UINT16: {
+		Uint16 *p = Map<Uint16>(BUFFER_MAP_WRITE);
+		for (Uint32 i = 0; i < count; i++) {
+			assert(indices[i] <= 0xffff);
+			p[i] = indices[i];
+		}
+		break;
+	}
+	case INDEX_FORMAT_UINT32:
+		memcpy(Map<Uint32>(BUFFER_MAP_WRITE), indices, sizeof(Uint32) * count);
+		break;
+	}
+	Unmap();
+}
+
+void IndexBuffer::PopulateRaw(const void *indices, Uint32 count)
+{
+	assert(count <= GetSize());
+	memcpy(MapInternal(BUFFER_MAP_WRITE), indices, GetIndexSize() * count);
+	Unmap();
+}
+
+void IndexBuffer::Read(std::vector<Uint32> &indices)
+{
+	indices.resize(GetSize());
+	switch (m_format) {
+	case INDEX_FORMAT_UINT8: {
+		const Uint8 *p = Map<Uint8>(BUFFER_MAP_READ);
+		std::copy(p, p + GetSize(), indices.begin());
+		break;
+	}
+	case INDEX_FORMAT_UINT16: {
+		const Uint16 *p = Map<Uint16>(BUFFER_MAP_READ);
+		std::copy(p, p + GetSize(), indices.begin());
+		break;
+	}
+	case INDEX_FORMAT_UINT32: {
+		const Uint32 *p = Map<Uint32>(BUFFER_MAP_READ);
+		std::copy(p, p + GetSize(), indices.begin());
+		break;
+	}
+	}
+	Unmap();
+}
+
+Uint32 IndexBuffer::GetIndexSize(IndexFormat format)
+{
+	switch (format) {
+	case INDEX_FORMAT_UINT8: return sizeof(Uint8);
+	case INDEX_FORMAT_UINT16: return sizeof(Uint16);
+	case INDEX_FORMAT_UINT32: return sizeof(Uint32);
+	}
+	assert(false);
+	return 0;
+}
+
+IndexFormat IndexBuffer::GetFormatForVertexCount(Uint32 numVertices)
+{
+	return (numVertices <= 0x10000) ? INDEX_FORMAT_UINT16 : INDEX_FORMAT_UINT32;
+}
+
 // ------------------------------------------------------------
 InstanceBuffer::InstanceBuffer(Uint32 size, BufferUsage usage)
 	: m_size(size)
@@ -105,6 +185,7 @@ InstanceBuffer::InstanceBuffer(Uint32 size, BufferUsage usage)
 
 InstanceBuffer::~InstanceBuffer()
 {
+	FrameCapture::Forget(this);
 }
 
 void InstanceBuffer::SetInstanceCount(const Uint32 ic)
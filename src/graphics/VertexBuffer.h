@@ -84,6 +84,9 @@ public:
 
 	// copies the contents of the VertexArray into the buffer
 	virtual bool Populate(const VertexArray &) = 0;
+	// copies the VertexArray in from firstVertex on, leaving the rest of the
+	// buffer as it was. for buffers that are added to a few vertices at a time
+	virtual bool PopulateRange(const VertexArray &, Uint32 firstVertex) = 0;
 
 	virtual void Bind() = 0;
 	virtual void Release() = 0;
@@ -94,25 +97,51 @@ protected:
 	Uint32 m_numVertices;
 };
 
-// Index buffer, limited to Uint16 index format for better portability
+// Index buffer. Uint16 is the default index format, Uint32 lifts the 65536
+// vertex limit for big meshes and Uint8 halves the size of tiny ones.
 class IndexBuffer : public RefCounted, public Mappable {
 public:
-	IndexBuffer(Uint32 size, BufferUsage);
+	IndexBuffer(Uint32 size, BufferUsage, IndexFormat = INDEX_FORMAT_UINT16);
 	virtual ~IndexBuffer();
-	virtual Uint16 *Map(BufferMapMode) = 0;
+
+	// Uint16 buffers only
+	Uint16 *Map(BufferMapMode mode) {
+		assert(m_format == INDEX_FORMAT_UINT16);
+		return reinterpret_cast<Uint16*>(MapInternal(mode));
+	}
+	// T must match the index format
+	template <typename T> T *Map(BufferMapMode mode) {
+		assert(sizeof(T) == GetIndexSize());
+		return reinterpret_cast<T*>(MapInternal(mode));
+	}
+
+	// copy indices in or out, converting to/from the buffer's index format
+	void Populate(const Uint32 *indices, Uint32 count);
+	void Read(std::vector<Uint32> &indices);
+	// straight copy of indices that are already in the buffer's format
+	void PopulateRaw(const void *indices, Uint32 count);
 
 	Uint32 GetSize() const { return m_size; }
 	Uint32 GetIndexCount() const { return m_indexCount; }
 	void SetIndexCount(Uint32);
 	BufferUsage GetUsage() const { return m_usage; }
+	IndexFormat GetFormat() const { return m_format; }
+	Uint32 GetIndexSize() const { return GetIndexSize(m_format); }
+
+	static Uint32 GetIndexSize(IndexFormat);
+	// smallest format that can address numVertices. Uint8 is never picked,
+	// as plenty of hardware converts byte indices in the driver
+	static IndexFormat GetFormatForVertexCount(Uint32 numVertices);
 
 	virtual void Bind() = 0;
 	virtual void Release() = 0;
 
 protected:
+	virtual Uint8 *MapInternal(BufferMapMode) = 0;
 	Uint32 m_size;
 	Uint32 m_indexCount;
 	BufferUsage m_usage;
+	IndexFormat m_format;
 };
 
 // Instance buffer
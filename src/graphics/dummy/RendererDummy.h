@@ -68,7 +68,7 @@ public:
 	virtual RenderState *CreateRenderState(const RenderStateDesc &d) override { return new Graphics::Dummy::RenderState(d); }
 	virtual RenderTarget *CreateRenderTarget(const RenderTargetDesc &d) override { return new Graphics::Dummy::RenderTarget(d); }
 	virtual VertexBuffer *CreateVertexBuffer(const VertexBufferDesc &d) override { return new Graphics::Dummy::VertexBuffer(d); }
-	virtual IndexBuffer *CreateIndexBuffer(Uint32 size, BufferUsage bu) override { return new Graphics::Dummy::IndexBuffer(size, bu); }
+	virtual IndexBuffer *CreateIndexBuffer(Uint32 size, BufferUsage bu, IndexFormat format = INDEX_FORMAT_UINT16) override { return new Graphics::Dummy::IndexBuffer(size, bu, format); }
 	virtual InstanceBuffer *CreateInstanceBuffer(Uint32 size, BufferUsage bu) override { return new Graphics::Dummy::InstanceBuffer(size, bu); }
 
 	virtual bool ReloadShaders() { return true; }
@@ -12,6 +12,8 @@ class TextureDummy : public Texture {
 public:
 	virtual void Update(const void *data, const vector2f &pos, const vector2f &dataSize, TextureFormat format, const unsigned int numMips) {}
 	virtual void Update(const TextureCubeData &data, const vector2f &dataSize, TextureFormat format, const unsigned int numMips) {}
+	virtual void UpdateLayer(const void *data, unsigned int layer, const vector2f &dataSize, TextureFormat format, const unsigned int numMips) {}
+	virtual void Reallocate(const TextureDescriptor &descriptor) { SetDescriptor(descriptor); }
 
 	void Bind() {}
 	void Unbind() {}
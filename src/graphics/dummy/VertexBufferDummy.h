@@ -18,6 +18,7 @@ public:
 
 	// copies the contents of the VertexArray into the buffer
 	virtual bool Populate(const VertexArray &) override { return true; }
+	virtual bool PopulateRange(const VertexArray &, Uint32) override { return true; }
 
 	virtual void Bind() {}
 	virtual void Release() {}
@@ -33,19 +34,20 @@ private:
 
 class IndexBuffer : public Graphics::IndexBuffer {
 public:
-	IndexBuffer(Uint32 size, BufferUsage bu) : Graphics::IndexBuffer(size, bu),
-	m_buffer(new Uint16[size])
+	IndexBuffer(Uint32 size, BufferUsage bu, IndexFormat format) : Graphics::IndexBuffer(size, bu, format),
+	m_buffer(new Uint8[size * GetIndexSize()])
 	{};
 
-	virtual Uint16 *Map(BufferMapMode) override { return m_buffer.get(); }
-
 	virtual void Unmap() override {}
 
 	virtual void Bind() {}
 	virtual void Release() {}
 
+protected:
+	virtual Uint8 *MapInternal(BufferMapMode) override { return m_buffer.get(); }
+
 private:
-    std::unique_ptr<Uint16[]> m_buffer;
+    std::unique_ptr<Uint8[]> m_buffer;
 };
 
 // Instance buffer
@@ -31,6 +31,8 @@ void GasGiantProgram::InitUniforms()
 	geosphereCenter.Init("geosphereCenter", m_program);
 	geosphereScale.Init("geosphereScale", m_program);
 	geosphereScaledRadius.Init("geosphereScaledRadius", m_program);
+	atmosOpticalDepth.Init("atmosOpticalDepth", m_program);
+	atmosHasOpticalDepth.Init("atmosHasOpticalDepth", m_program);
 
 	shadows.Init("shadows", m_program);
 	occultedLight.Init("occultedLight", m_program);
@@ -76,7 +78,6 @@ void GasGiantSurfaceMaterial::SetGSUniforms()
 	const SystemBody::AtmosphereParameters ap = params.atmosphere;
 
 	p->emission.Set(this->emissive);
-	p->sceneAmbient.Set(m_renderer->GetAmbientColor());
 	p->atmosColor.Set(ap.atmosCol);
 	p->geosphereAtmosFogDensity.Set(ap.atmosDensity);
 	p->geosphereAtmosInvScaleHeight.Set(ap.atmosInvScaleHeight);
@@ -84,15 +85,9 @@ void GasGiantSurfaceMaterial::SetGSUniforms()
 	p->geosphereCenter.Set(ap.center);
 	p->geosphereScaledRadius.Set(ap.planetRadius / ap.scale);
 	p->geosphereScale.Set(ap.scale);
-
-	//Light uniform parameters
-	for( Uint32 i=0 ; i<m_renderer->GetNumLights() ; i++ ) {
-		const Light& Light = m_renderer->GetLight(i);
-		p->lights[i].diffuse.Set( Light.GetDiffuse() );
-		p->lights[i].specular.Set( Light.GetSpecular() );
-		const vector3f& pos = Light.GetPosition();
-		p->lights[i].position.Set( pos.x, pos.y, pos.z, (Light.GetType() == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f));
-	}
+	// texture0 is the surface
+	p->atmosOpticalDepth.Set(params.opticalDepth, 1);
+	p->atmosHasOpticalDepth.Set(params.opticalDepth ? 1 : 0);
 
 	p->diffuse.Set(this->diffuse);
 	p->texture0.Set(this->texture0, 0);
@@ -24,6 +24,8 @@ namespace Graphics {
 			Uniform geosphereCenter;
 			Uniform geosphereScale;
 			Uniform geosphereScaledRadius; // (planet radius) / scale
+			Uniform atmosOpticalDepth; // table from AtmosphereLUT
+			Uniform atmosHasOpticalDepth;
 
 			Uniform shadows;
 			Uniform occultedLight;
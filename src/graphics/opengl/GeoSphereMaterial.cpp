@@ -30,6 +30,8 @@ void GeoSphereProgram::InitUniforms()
 	geosphereCenter.Init("geosphereCenter", m_program);
 	geosphereScale.Init("geosphereScale", m_program);
 	geosphereScaledRadius.Init("geosphereScaledRadius", m_program);
+	atmosOpticalDepth.Init("atmosOpticalDepth", m_program);
+	atmosHasOpticalDepth.Init("atmosHasOpticalDepth", m_program);
 
 	shadows.Init("shadows", m_program);
 	occultedLight.Init("occultedLight", m_program);
@@ -61,6 +63,8 @@ Program *GeoSphereSurfaceMaterial::CreateProgram(const MaterialDescriptor &desc)
 		ss << "#define TERRAIN_WITH_WATER\n";
 	if (desc.quality & HAS_ECLIPSES)
 		ss << "#define ECLIPSE\n";
+	if (desc.quality & HAS_COMPACT_VERTICES)
+		ss << "#define COMPACT_VERTICES\n";
 	return new Graphics::OGL::GeoSphereProgram("geosphere_terrain", ss.str());
 }
 
@@ -78,7 +82,6 @@ void GeoSphereSurfaceMaterial::SetGSUniforms()
 	const SystemBody::AtmosphereParameters ap = params.atmosphere;
 
 	p->emission.Set(this->emissive);
-	p->sceneAmbient.Set(m_renderer->GetAmbientColor());
 	p->atmosColor.Set(ap.atmosCol);
 	p->geosphereAtmosFogDensity.Set(ap.atmosDensity);
 	p->geosphereAtmosInvScaleHeight.Set(ap.atmosInvScaleHeight);
@@ -86,15 +89,8 @@ void GeoSphereSurfaceMaterial::SetGSUniforms()
 	p->geosphereCenter.Set(ap.center);
 	p->geosphereScaledRadius.Set(ap.planetRadius / ap.scale);
 	p->geosphereScale.Set(ap.scale);
-
-	//Light uniform parameters
-	for( Uint32 i=0 ; i<m_renderer->GetNumLights() ; i++ ) {
-		const Light& Light = m_renderer->GetLight(i);
-		p->lights[i].diffuse.Set( Light.GetDiffuse() );
-		p->lights[i].specular.Set( Light.GetSpecular() );
-		const vector3f& pos = Light.GetPosition();
-		p->lights[i].position.Set( pos.x, pos.y, pos.z, (Light.GetType() == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f));
-	}
+	p->atmosOpticalDepth.Set(params.opticalDepth, 1);
+	p->atmosHasOpticalDepth.Set(params.opticalDepth ? 1 : 0);
 
 	// we handle up to three shadows at a time
 	int occultedLight[3] = {-1,-1,-1};
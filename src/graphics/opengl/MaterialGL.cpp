@@ -10,8 +10,8 @@ namespace OGL {
 
 void Material::Apply()
 {
+	m_renderer->UpdateSceneBlock();
 	m_program->Use();
-	m_program->invLogZfarPlus1.Set(m_renderer->m_invLogZfarPlus1);
 }
 
 void Material::Unapply()
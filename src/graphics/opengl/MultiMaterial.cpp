@@ -39,6 +39,8 @@ MultiProgram::MultiProgram(const MaterialDescriptor &desc, int numLights)
 		ss << "#define MAP_AMBIENT\n";
 	if (desc.usePatterns)
 		ss << "#define MAP_COLOR\n";
+	if (desc.usePatterns && desc.patternArray && desc.instanced)
+		ss << "#define PATTERN_ARRAY\n";
 	if (desc.quality & HAS_HEAT_GRADIENT)
 		ss << "#define HEAT_COLOURING\n";
 	
@@ -89,6 +91,11 @@ void MultiMaterial::Apply()
 	p->texture3.Set(this->texture3, 3);
 	p->texture4.Set(this->texture4, 4);
 	p->texture5.Set(this->texture5, 5);
+	if (m_descriptor.usePatterns) {
+		for (int i = 0; i < 3; i++)
+			p->patternColors[i].Set(this->patternColors[i]);
+		p->smoothPatternColors.Set(this->smoothPatternColors ? 1 : 0);
+	}
 
 	p->heatGradient.Set(this->heatGradient, 6);
 	if(nullptr!=specialParameter0) {
@@ -121,16 +128,6 @@ void LitMultiMaterial::Apply()
 	p->emission.Set(this->emissive);
 	p->specular.Set(this->specular);
 	p->shininess.Set(float(this->shininess));
-	p->sceneAmbient.Set(m_renderer->GetAmbientColor());
-
-	//Light uniform parameters
-	for( Uint32 i=0 ; i<m_renderer->GetNumLights() ; i++ ) {
-		const Light& Light = m_renderer->GetLight(i);
-		p->lights[i].diffuse.Set( Light.GetDiffuse() );
-		p->lights[i].specular.Set( Light.GetSpecular() );
-		const vector3f pos = Light.GetPosition();
-		p->lights[i].position.Set( pos.x, pos.y, pos.z, (Light.GetType() == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f));
-	}
 	RendererOGL::CheckErrors();
 }
 
@@ -7,6 +7,7 @@
 #include "StringF.h"
 #include "OS.h"
 #include "graphics/Graphics.h"
+#include "RendererGL.h"
 
 namespace Graphics {
 
@@ -72,32 +73,47 @@ static bool check_glsl_errors(const char *filename, GLuint obj)
 	return true;
 }
 
+// FNV-1a
+static Uint64 hash_bytes(Uint64 hash, const char *data, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		hash ^= Uint8(data[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
 struct Shader {
-	Shader(GLenum type, const std::string &filename, const std::string &defines) {
-		RefCountedPtr<FileSystem::FileData> code = FileSystem::gameDataFiles.ReadFile(filename);
+	Shader(GLenum type, const std::string &filename, const std::string &defines)
+	: shader(0)
+	, m_type(type)
+	, m_filename(filename)
+	{
+		m_code = FileSystem::gameDataFiles.ReadFile(filename);
 
-		if (!code.Valid())
+		if (!m_code.Valid())
 			Error("Could not load %s", filename.c_str());
 
 		// Load some common code
-		RefCountedPtr<FileSystem::FileData> attributesCode = FileSystem::gameDataFiles.ReadFile("shaders/opengl/attributes.glsl");
-		assert(attributesCode.Valid());
-		RefCountedPtr<FileSystem::FileData> logzCode = FileSystem::gameDataFiles.ReadFile("shaders/opengl/logz.glsl");
-		assert(logzCode.Valid());
-		RefCountedPtr<FileSystem::FileData> libsCode = FileSystem::gameDataFiles.ReadFile("shaders/opengl/lib.glsl");
-		assert(libsCode.Valid());
-
+		m_attributesCode = FileSystem::gameDataFiles.ReadFile("shaders/opengl/attributes.glsl");
+		assert(m_attributesCode.Valid());
+		m_logzCode = FileSystem::gameDataFiles.ReadFile("shaders/opengl/logz.glsl");
+		assert(m_logzCode.Valid());
+		m_libsCode = FileSystem::gameDataFiles.ReadFile("shaders/opengl/lib.glsl");
+		assert(m_libsCode.Valid());
+
+		m_defines = defines;
 		AppendSource(s_glslVersion);
-		AppendSource(defines.c_str());
+		AppendSource(m_defines.c_str());
 		if (type == GL_VERTEX_SHADER) {
 			AppendSource("#define VERTEX_SHADER\n");
 		} else {
 			AppendSource("#define FRAGMENT_SHADER\n");
 		}
-		AppendSource(attributesCode->AsStringRange().StripUTF8BOM());
-		AppendSource(logzCode->AsStringRange().StripUTF8BOM());
-		AppendSource(libsCode->AsStringRange().StripUTF8BOM());
-		AppendSource(code->AsStringRange().StripUTF8BOM());
+		AppendSource(m_attributesCode->AsStringRange().StripUTF8BOM());
+		AppendSource(m_logzCode->AsStringRange().StripUTF8BOM());
+		AppendSource(m_libsCode->AsStringRange().StripUTF8BOM());
+		AppendSource(m_code->AsStringRange().StripUTF8BOM());
 #if 0
 		static bool s_bDumpShaderSource = true;
 		if (s_bDumpShaderSource) {
@@ -122,19 +138,32 @@ struct Shader {
 			}
 		}
 #endif
-		shader = glCreateShader(type);
+	};
+
+	~Shader() {
+		if (shader)
+			glDeleteShader(shader);
+	}
+
+	// the complete source, so any change to it or its includes shows up
+	Uint64 Hash(Uint64 hash) const {
+		for (size_t i = 0; i < blocks.size(); i++)
+			hash = hash_bytes(hash, blocks[i], block_sizes[i]);
+		return hash;
+	}
+
+	void Compile() {
+		shader = glCreateShader(m_type);
 		if(glIsShader(shader)!=GL_TRUE)
 			throw ShaderException();
 
-		Compile(shader);
+		assert(blocks.size() == block_sizes.size());
+		glShaderSource(shader, blocks.size(), &blocks[0], &block_sizes[0]);
+		glCompileShader(shader);
 
 		// CheckGLSL may use OS::Warning instead of Error so the game may still (attempt to) run
-		if (!check_glsl_errors(filename.c_str(), shader))
+		if (!check_glsl_errors(m_filename.c_str(), shader))
 			throw ShaderException();
-	};
-
-	~Shader() {
-		glDeleteShader(shader);
 	}
 
 	GLuint shader;
@@ -152,17 +181,108 @@ private:
 		block_sizes.push_back(str.Size());
 	}
 
-	void Compile(GLuint shader_id)
-	{
-		assert(blocks.size() == block_sizes.size());
-		glShaderSource(shader_id, blocks.size(), &blocks[0], &block_sizes[0]);
-		glCompileShader(shader_id);
-	}
+	GLenum m_type;
+	std::string m_filename;
+	std::string m_defines;
+
+	// the blocks point into these
+	RefCountedPtr<FileSystem::FileData> m_code;
+	RefCountedPtr<FileSystem::FileData> m_attributesCode;
+	RefCountedPtr<FileSystem::FileData> m_logzCode;
+	RefCountedPtr<FileSystem::FileData> m_libsCode;
 
 	std::vector<const char*> blocks;
 	std::vector<GLint> block_sizes;
 };
 
+static const char BINARY_CACHE_DIR[] = "shadercache";
+bool Program::s_binaryCacheEnabled = false;
+
+struct BinaryHeader {
+	char magic[4];
+	Uint32 format;
+	Uint32 size;
+	Uint32 pad;
+};
+
+void Program::EnableBinaryCache()
+{
+	if (ogl_ext_ARB_get_program_binary == ogl_LOAD_FAILED)
+		return;
+	GLint numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	if (numFormats <= 0)
+		return;
+	if (!FileSystem::userFiles.MakeDirectory(BINARY_CACHE_DIR)) {
+		Output("shader cache: couldn't create cache directory, disabling\n");
+		return;
+	}
+	s_binaryCacheEnabled = true;
+}
+
+// binaries are only good for the driver that made them
+static std::string get_binary_cache_name(const Shader &vs, const Shader &fs)
+{
+	Uint64 hash = 14695981039346656037ULL;
+	static const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (GLenum e : driverStrings) {
+		const char *str = reinterpret_cast<const char*>(glGetString(e));
+		if (str)
+			hash = hash_bytes(hash, str, strlen(str));
+	}
+	hash = vs.Hash(hash);
+	hash = fs.Hash(hash);
+
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%08x%08x.bin", Uint32(hash >> 32), Uint32(hash));
+	return FileSystem::JoinPath(BINARY_CACHE_DIR, buf);
+}
+
+bool Program::LoadBinary(const std::string &cacheName)
+{
+	PROFILE_SCOPED()
+	RefCountedPtr<FileSystem::FileData> fd = FileSystem::userFiles.ReadFile(cacheName);
+	if (!fd.Valid() || fd->GetSize() < sizeof(BinaryHeader))
+		return false;
+
+	BinaryHeader h;
+	memcpy(&h, fd->GetData(), sizeof(h));
+	if (memcmp(h.magic, "PSB1", 4) != 0 || fd->GetSize() != sizeof(BinaryHeader) + h.size)
+		return false;
+
+	// the driver is free to turn down a binary even on a name match (eg.
+	// after an update), in which case we compile as normal
+	glProgramBinary(m_program, h.format, fd->GetData() + sizeof(BinaryHeader), h.size);
+	GLint status = GL_FALSE;
+	glGetProgramiv(m_program, GL_LINK_STATUS, &status);
+	return status == GL_TRUE;
+}
+
+void Program::SaveBinary(const std::string &cacheName)
+{
+	PROFILE_SCOPED()
+	GLint size = 0;
+	glGetProgramiv(m_program, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0)
+		return;
+
+	std::vector<char> data(size);
+	GLenum format = 0;
+	glGetProgramBinary(m_program, size, nullptr, &format, &data[0]);
+
+	FILE *f = FileSystem::userFiles.OpenWriteStream(cacheName);
+	if (!f)
+		return;
+	BinaryHeader h;
+	memcpy(h.magic, "PSB1", 4);
+	h.format = format;
+	h.size = size;
+	h.pad = 0;
+	fwrite(&h, sizeof(h), 1, f);
+	fwrite(&data[0], size, 1, f);
+	fclose(f);
+}
+
 Program::Program()
 : m_name("")
 , m_defines("")
@@ -194,8 +314,10 @@ void Program::Reload()
 
 void Program::Use()
 {
-	if (s_curProgram != m_program)
+	if (s_curProgram != m_program) {
 		glUseProgram(m_program);
+		++RendererOGL::s_stateStats.programSwitches;
+	}
 	s_curProgram = m_program;
 }
 
@@ -210,15 +332,30 @@ void Program::LoadShaders(const std::string &name, const std::string &defines)
 {
 	const std::string filename = std::string("shaders/opengl/") + name;
 
-	//load, create and compile shaders
+	//load shaders
 	Shader vs(GL_VERTEX_SHADER, filename + ".vert", defines);
 	Shader fs(GL_FRAGMENT_SHADER, filename + ".frag", defines);
 
-	//create program, attach shaders and link
+	//create program
 	m_program = glCreateProgram();
 	if(glIsProgram(m_program)!=GL_TRUE)
 		throw ProgramException();
 
+	//try for a binary from an earlier run before compiling anything
+	const std::string cacheName = s_binaryCacheEnabled ? get_binary_cache_name(vs, fs) : std::string();
+	if (!cacheName.empty()) {
+		if (LoadBinary(cacheName))
+			return;
+		// start over with a clean program object
+		glDeleteProgram(m_program);
+		m_program = glCreateProgram();
+		glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	//compile shaders, attach them and link
+	vs.Compile();
+	fs.Compile();
+
 	glAttachShader(m_program, vs.shader);
 
 	glAttachShader(m_program, fs.shader);
@@ -234,7 +371,8 @@ void Program::LoadShaders(const std::string &name, const std::string &defines)
 
 	glLinkProgram(m_program);
 
-	check_glsl_errors(name.c_str(), m_program);
+	if (check_glsl_errors(name.c_str(), m_program) && !cacheName.empty())
+		SaveBinary(cacheName);
 
 	//shaders may now be deleted by Shader destructor
 }
@@ -248,17 +386,11 @@ void Program::InitUniforms()
 	uViewProjectionMatrix.Init("uViewProjectionMatrix", m_program);
 	uNormalMatrix.Init("uNormalMatrix", m_program);
 
-	//Light uniform parameters
-	char cLight[64];
-	for( int i=0 ; i<4 ; i++ ) {
-		snprintf(cLight, 64, "uLight[%d]", i);
-		const std::string strLight( cLight );
-		lights[i].diffuse.Init( (strLight + ".diffuse").c_str(), m_program );
-		lights[i].specular.Init( (strLight + ".specular").c_str(), m_program );
-		lights[i].position.Init( (strLight + ".position").c_str(), m_program );
-	}
+	//lights, ambient and log z, if the program uses any of them
+	const GLuint sceneBlock = glGetUniformBlockIndex(m_program, "SceneData");
+	if (sceneBlock != GL_INVALID_INDEX)
+		glUniformBlockBinding(m_program, sceneBlock, SCENE_BLOCK_BINDING);
 
-	invLogZfarPlus1.Init("invLogZfarPlus1", m_program);
 	diffuse.Init("material.diffuse", m_program);
 	emission.Init("material.emission", m_program);
 	specular.Init("material.specular", m_program);
@@ -269,11 +401,14 @@ void Program::InitUniforms()
 	texture3.Init("texture3", m_program);
 	texture4.Init("texture4", m_program);
 	texture5.Init("texture5", m_program);
+	patternColors[0].Init("patternColors[0]", m_program);
+	patternColors[1].Init("patternColors[1]", m_program);
+	patternColors[2].Init("patternColors[2]", m_program);
+	smoothPatternColors.Init("smoothPatternColors", m_program);
 	heatGradient.Init("heatGradient", m_program);
 	heatingMatrix.Init("heatingMatrix", m_program);
 	heatingNormal.Init("heatingNormal", m_program);
 	heatingAmount.Init("heatingAmount", m_program);
-	sceneAmbient.Init("scene.ambient", m_program);
 }
 
 } // OGL
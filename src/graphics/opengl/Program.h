@@ -27,6 +27,15 @@ namespace Graphics {
 			virtual void Use();
 			virtual void Unuse();
 
+			// keep linked programs on disk and load them from there when
+			// the sources and driver haven't changed. needs
+			// ARB_get_program_binary, does nothing without it
+			static void EnableBinaryCache();
+
+			// where the renderer binds the SceneData block, with the lights,
+			// ambient and log z constant
+			static const GLuint SCENE_BLOCK_BINDING = 0;
+
 			// Uniforms.
 			Uniform uProjectionMatrix;
 			Uniform uViewMatrix;
@@ -34,7 +43,6 @@ namespace Graphics {
 			Uniform uViewProjectionMatrix;
 			Uniform uNormalMatrix;
 
-			Uniform invLogZfarPlus1;
 			Uniform diffuse;
 			Uniform emission;
 			Uniform specular;
@@ -45,25 +53,20 @@ namespace Graphics {
 			Uniform texture3;
 			Uniform texture4;
 			Uniform texture5;
+			Uniform patternColors[3];
+			Uniform smoothPatternColors;
 			Uniform heatGradient;
 			Uniform heatingMatrix;
 			Uniform heatingNormal;
 			Uniform heatingAmount;
 
-			Uniform sceneAmbient;
-
-			//Light uniform parameters
-			struct UniformLight {
-				Uniform diffuse;
-				Uniform specular;
-				Uniform position;
-			};
-			UniformLight lights[4];
-
 		protected:
 			static GLuint s_curProgram;
+			static bool s_binaryCacheEnabled;
 
 			void LoadShaders(const std::string&, const std::string &defines);
+			bool LoadBinary(const std::string &cacheName);
+			void SaveBinary(const std::string &cacheName);
 			virtual void InitUniforms();
 			std::string m_name;
 			std::string m_defines;
@@ -3,6 +3,7 @@
 
 #include "RenderTargetGL.h"
 #include "TextureGL.h"
+#include "graphics/FrameCapture.h"
 
 namespace Graphics { namespace OGL {
 
@@ -40,6 +41,7 @@ RenderTarget::RenderTarget(const RenderTargetDesc &d)
 
 RenderTarget::~RenderTarget()
 {
+	FrameCapture::Forget(static_cast<Graphics::RenderTarget*>(this));
 	glDeleteFramebuffers(1, &m_fbo);
 }
 
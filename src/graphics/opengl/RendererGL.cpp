@@ -2,9 +2,11 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "RendererGL.h"
+#include "graphics/FrameCapture.h"
 #include "graphics/Graphics.h"
 #include "graphics/Light.h"
 #include "graphics/Material.h"
+#include "graphics/RenderTargetPool.h"
 #include "OS.h"
 #include "StringF.h"
 #include "graphics/Texture.h"
@@ -25,6 +27,8 @@
 #include "ShieldMaterial.h"
 #include "SkyboxMaterial.h"
 #include "SphereImpostorMaterial.h"
+#include "SpeedLinesMaterial.h"
+#include "TrailMaterial.h"
 #include "UIMaterial.h"
 #include "VtxColorMaterial.h"
 
@@ -45,6 +49,7 @@ void RendererOGL::RegisterRenderer() {
 
 
 bool RendererOGL::initted = false;
+RendererOGL::StateStats RendererOGL::s_stateStats = { 0, 0, 0, 0 };
 
 typedef std::vector<std::pair<MaterialDescriptor, OGL::Program*> >::const_iterator ProgramIterator;
 
@@ -59,9 +64,13 @@ RendererOGL::RendererOGL(WindowSDL *window, const Graphics::Settings &vs)
 , m_maxZFar(10000000.0f)
 , m_useCompressedTextures(false)
 , m_invLogZfarPlus1(0.f)
+, m_sceneBlock(0)
+, m_sceneBlockDirty(true)
 , m_activeRenderTarget(0)
 , m_activeRenderState(nullptr)
 , m_matrixMode(MatrixMode::MODELVIEW)
+, m_gpuTimersEnabled(false)
+, m_gpuTimerFrame(0)
 {
 	if (!initted) {
 		initted = true;
@@ -100,6 +109,19 @@ RendererOGL::RendererOGL(WindowSDL *window, const Graphics::Settings &vs)
 
 	if (vs.enableDebugMessages)
 		GLDebug::Enable();
+
+	if (vs.useShaderCache)
+		OGL::Program::EnableBinaryCache();
+
+	glGenBuffers(1, &m_sceneBlock);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_sceneBlock);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(SceneBlock), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, OGL::Program::SCENE_BLOCK_BINDING, m_sceneBlock);
+
+	// timestamp queries are core from 3.3, we only ask for 3.1
+	m_gpuTimersEnabled = ogl_IsVersionGEQ(3, 3) != 0;
+	BeginGpuTimer(Stats::GPU_TIMER_FRAME);
 }
 
 RendererOGL::~RendererOGL()
@@ -108,6 +130,14 @@ RendererOGL::~RendererOGL()
 	//while (!m_programs.empty()) delete m_programs.back().second, m_programs.pop_back();
 	for (auto state : m_renderStates)
 		delete state.second;
+	m_streamBuffers.clear();
+	m_spriteMaterials.clear();
+	m_spriteInstances.Reset();
+	m_spriteQuad.Reset();
+	for (GpuTimerFrame &f : m_gpuTimerFrames)
+		if (!f.queries.empty())
+			glDeleteQueries(f.queries.size(), &f.queries[0]);
+	glDeleteBuffers(1, &m_sceneBlock);
 }
 
 static const char *gl_error_to_string(GLenum err)
@@ -247,6 +277,17 @@ bool RendererOGL::GetNearFarRange(float &near_, float &far_) const
 bool RendererOGL::BeginFrame()
 {
 	PROFILE_SCOPED()
+	if (m_captureReplays && !m_capture) {
+		if (m_captureSkipFrames)
+			--m_captureSkipFrames;
+		else {
+			Sint32 vp[4];
+			GetCurrentViewport(vp);
+			m_capture.reset(new FrameCapture(m_activeRenderTarget, vp));
+		}
+	}
+	if (m_capture && m_capture->IsRecording())
+		m_capture->BeginFrame();
 	glClearColor(0,0,0,0);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	return true;
@@ -318,11 +359,166 @@ bool RendererOGL::SwapBuffers()
 	}
 #endif
 
+	if (m_capture)
+		ReplayCapture();
+
+	// the frame timer runs from swap to swap
+	while (!m_gpuTimerStack.empty())
+		EndGpuTimer();
+
 	GetWindow()->SwapBuffers();
+	ResolveGpuTimers();
+	GetRenderTargetPool().EndFrame();
+	m_stats.AddToStatCount(Stats::STAT_PROGRAM_SWITCHES, s_stateStats.programSwitches);
+	m_stats.AddToStatCount(Stats::STAT_VAO_BINDS, s_stateStats.vaoBinds);
+	m_stats.AddToStatCount(Stats::STAT_UNIFORMS_SET, s_stateStats.uniformsSet);
+	m_stats.AddToStatCount(Stats::STAT_UNIFORMS_SKIPPED, s_stateStats.uniformsSkipped);
+	s_stateStats = StateStats();
 	m_stats.NextFrame();
+	BeginGpuTimer(Stats::GPU_TIMER_FRAME);
 	return true;
 }
 
+Uint32 RendererOGL::IssueTimestamp()
+{
+	GpuTimerFrame &f = m_gpuTimerFrames[m_gpuTimerFrame];
+	if (f.used == f.queries.size()) {
+		GLuint query;
+		glGenQueries(1, &query);
+		f.queries.push_back(query);
+	}
+	glQueryCounter(f.queries[f.used], GL_TIMESTAMP);
+	return f.used++;
+}
+
+void RendererOGL::BeginGpuTimer(Stats::GpuTimerType type)
+{
+	if (!m_gpuTimersEnabled)
+		return;
+	GpuTimerFrame &f = m_gpuTimerFrames[m_gpuTimerFrame];
+	const GpuTimerScope scope = { type, IssueTimestamp(), 0 };
+	f.scopes.push_back(scope);
+	m_gpuTimerStack.push_back(f.scopes.size() - 1);
+}
+
+void RendererOGL::EndGpuTimer()
+{
+	if (!m_gpuTimersEnabled || m_gpuTimerStack.empty())
+		return;
+	GpuTimerFrame &f = m_gpuTimerFrames[m_gpuTimerFrame];
+	f.scopes[m_gpuTimerStack.back()].end = IssueTimestamp();
+	m_gpuTimerStack.pop_back();
+}
+
+void RendererOGL::ResolveGpuTimers()
+{
+	PROFILE_SCOPED()
+	if (!m_gpuTimersEnabled)
+		return;
+
+	m_gpuTimerFrame = (m_gpuTimerFrame + 1) % GPU_TIMER_FRAMES;
+	GpuTimerFrame &f = m_gpuTimerFrames[m_gpuTimerFrame];
+	if (f.used) {
+		// timestamps complete in order, so if the last one is in they all are
+		GLint available = 0;
+		glGetQueryObjectiv(f.queries[f.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available) {
+			std::vector<GLuint64> times(f.used);
+			for (Uint32 i = 0; i < f.used; i++)
+				glGetQueryObjectui64v(f.queries[i], GL_QUERY_RESULT, &times[i]);
+			for (const GpuTimerScope &s : f.scopes)
+				m_stats.AddGpuTime(s.type, Uint32((times[s.end] - times[s.begin]) / 1000));
+		}
+	}
+	f.used = 0;
+	f.scopes.clear();
+}
+
+Uint32 RendererOGL::CreateOcclusionQuery()
+{
+	GLuint query;
+	glGenQueries(1, &query);
+	return query;
+}
+
+void RendererOGL::DeleteOcclusionQuery(Uint32 query)
+{
+	const GLuint q = query;
+	glDeleteQueries(1, &q);
+}
+
+void RendererOGL::BeginOcclusionQuery(Uint32 query)
+{
+	glBeginQuery(GL_SAMPLES_PASSED, query);
+}
+
+void RendererOGL::EndOcclusionQuery()
+{
+	glEndQuery(GL_SAMPLES_PASSED);
+}
+
+bool RendererOGL::GetOcclusionQueryResult(Uint32 query, Uint32 &samples)
+{
+	GLint available = 0;
+	glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return false;
+	GLuint result;
+	glGetQueryObjectuiv(query, GL_QUERY_RESULT, &result);
+	samples = result;
+	return true;
+}
+
+void RendererOGL::ReplayCapture()
+{
+	PROFILE_SCOPED()
+	std::unique_ptr<FrameCapture> capture(std::move(m_capture));
+	CaptureCallback callback;
+	std::swap(callback, m_captureCallback);
+	CaptureResult result = { capture->GetNumCommands(), capture->GetNumDraws(), m_captureReplays, 0.0, -1.0 };
+	m_captureReplays = 0;
+
+	// put things back as the frame left them for the swap
+	OGL::RenderTarget *target = m_activeRenderTarget;
+	const MatrixMode matrixMode = m_matrixMode;
+	PushState();
+
+	GLuint queries[2];
+	if (m_gpuTimersEnabled) {
+		glGenQueries(2, queries);
+		glQueryCounter(queries[0], GL_TIMESTAMP);
+	}
+	const Uint64 start = SDL_GetPerformanceCounter();
+	for (Uint32 i = 0; i < result.replays; i++)
+		capture->Replay(this);
+	result.cpuSeconds = double(SDL_GetPerformanceCounter() - start) / double(SDL_GetPerformanceFrequency());
+	if (m_gpuTimersEnabled) {
+		glQueryCounter(queries[1], GL_TIMESTAMP);
+		// waits for the GPU to finish, which is fine here
+		GLuint64 times[2];
+		glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &times[0]);
+		glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &times[1]);
+		glDeleteQueries(2, queries);
+		result.gpuSeconds = double(times[1] - times[0]) * 1e-9;
+	}
+
+	SetRenderTarget(target);
+	PopState();
+	SetMatrixMode(matrixMode);
+	CheckRenderErrors();
+
+	const double perReplay = result.replays ? 1e3 / double(result.replays) : 0.0;
+	if (result.gpuSeconds >= 0.0)
+		Output("frame capture: %u commands, %u draws, %u replays: %.3f ms cpu, %.3f ms gpu per replay\n",
+			result.commands, result.draws, result.replays, result.cpuSeconds * perReplay, result.gpuSeconds * perReplay);
+	else
+		Output("frame capture: %u commands, %u draws, %u replays: %.3f ms cpu per replay, gpu not timed\n",
+			result.commands, result.draws, result.replays, result.cpuSeconds * perReplay);
+
+	if (callback)
+		callback(result);
+}
+
 bool RendererOGL::SetRenderState(RenderState *rs)
 {
 	if (m_activeRenderState != rs) {
@@ -336,6 +532,8 @@ bool RendererOGL::SetRenderState(RenderState *rs)
 bool RendererOGL::SetRenderTarget(RenderTarget *rt)
 {
 	PROFILE_SCOPED()
+	if (m_capture && m_capture->IsRecording())
+		m_capture->SetRenderTarget(rt);
 	if (rt)
 		static_cast<OGL::RenderTarget*>(rt)->Bind();
 	else if (m_activeRenderTarget)
@@ -347,14 +545,23 @@ bool RendererOGL::SetRenderTarget(RenderTarget *rt)
 	return true;
 }
 
+RenderTarget *RendererOGL::GetRenderTarget() const
+{
+	return m_activeRenderTarget;
+}
+
 bool RendererOGL::SetDepthRange(double near, double far)
 {
+	if (m_capture && m_capture->IsRecording())
+		m_capture->SetDepthRange(near, far);
 	glDepthRange(near, far);
 	return true;
 }
 
 bool RendererOGL::ClearScreen()
 {
+	if (m_capture && m_capture->IsRecording())
+		m_capture->ClearScreen();
 	m_activeRenderState = nullptr;
 	glDepthMask(GL_TRUE);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -365,6 +572,8 @@ bool RendererOGL::ClearScreen()
 
 bool RendererOGL::ClearDepthBuffer()
 {
+	if (m_capture && m_capture->IsRecording())
+		m_capture->ClearDepthBuffer();
 	m_activeRenderState = nullptr;
 	glDepthMask(GL_TRUE);
 	glClear(GL_DEPTH_BUFFER_BIT);
@@ -375,12 +584,16 @@ bool RendererOGL::ClearDepthBuffer()
 
 bool RendererOGL::SetClearColor(const Color &c)
 {
+	if (m_capture && m_capture->IsRecording())
+		m_capture->SetClearColor(c);
 	glClearColor(c.r, c.g, c.b, c.a);
 	return true;
 }
 
 bool RendererOGL::SetViewport(int x, int y, int width, int height)
 {
+	if (m_capture && m_capture->IsRecording())
+		m_capture->SetViewport(x, y, width, height);
 	assert(!m_viewportStack.empty());
 	Viewport& currentViewport = m_viewportStack.top();
 	currentViewport.x = x;
@@ -413,7 +626,11 @@ bool RendererOGL::SetPerspectiveProjection(float fov, float aspect, float near_,
 	PROFILE_SCOPED()
 
 	// update values for log-z hack
-	m_invLogZfarPlus1 = 1.0f / (log(far_+1.0f)/log(2.0f));
+	const float invLogZfarPlus1 = 1.0f / (log(far_+1.0f)/log(2.0f));
+	if (invLogZfarPlus1 != m_invLogZfarPlus1) {
+		m_invLogZfarPlus1 = invLogZfarPlus1;
+		m_sceneBlockDirty = true;
+	}
 
 	Graphics::SetFov(fov);
 
@@ -446,12 +663,16 @@ bool RendererOGL::SetProjection(const matrix4x4f &m)
 
 bool RendererOGL::SetWireFrameMode(bool enabled)
 {
+	if (m_capture && m_capture->IsRecording())
+		m_capture->SetWireFrameMode(enabled);
 	glPolygonMode(GL_FRONT_AND_BACK, enabled ? GL_LINE : GL_FILL);
 	return true;
 }
 
 bool RendererOGL::SetLights(Uint32 numlights, const Light *lights)
 {
+	if (m_capture && m_capture->IsRecording())
+		m_capture->SetLights(numlights, lights);
 	numlights = std::min(numlights, TOTAL_NUM_LIGHTS);
 	if (numlights < 1) {
 		m_numLights = 0;
@@ -461,6 +682,7 @@ bool RendererOGL::SetLights(Uint32 numlights, const Light *lights)
 
 	m_numLights = numlights;
 	m_numDirLights = 0;
+	m_sceneBlockDirty = true;
 
 	for (Uint32 i = 0; i<numlights; i++) {
 		const Light &l = lights[i];
@@ -479,12 +701,19 @@ bool RendererOGL::SetLights(Uint32 numlights, const Light *lights)
 
 bool RendererOGL::SetAmbientColor(const Color &c)
 {
-	m_ambient = c;
+	if (m_capture && m_capture->IsRecording())
+		m_capture->SetAmbientColor(c);
+	if (!(c == m_ambient)) {
+		m_ambient = c;
+		m_sceneBlockDirty = true;
+	}
 	return true;
 }
 
 bool RendererOGL::SetScissor(bool enabled, const vector2f &pos, const vector2f &size)
 {
+	if (m_capture && m_capture->IsRecording())
+		m_capture->SetScissor(enabled, pos, size);
 	if (enabled) {
 		glScissor(pos.x,pos.y,size.x,size.y);
 		glEnable(GL_SCISSOR_TEST);
@@ -494,6 +723,34 @@ bool RendererOGL::SetScissor(bool enabled, const vector2f &pos, const vector2f &
 	return true;
 }
 
+void RendererOGL::UpdateSceneBlock()
+{
+	if (!m_sceneBlockDirty)
+		return;
+	m_sceneBlockDirty = false;
+
+	// std140: each light is three vec4s, then the ambient vec4, then the float
+	SceneBlock b;
+	memset(&b, 0, sizeof(b));
+	for (Uint32 i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		const Light &l = m_lights[i];
+		const Color4f diffuse = l.GetDiffuse().ToColor4f();
+		const Color4f specular = l.GetSpecular().ToColor4f();
+		const vector3f &pos = l.GetPosition();
+		float *d = b.lights[i][0], *s = b.lights[i][1], *p = b.lights[i][2];
+		d[0] = diffuse.r; d[1] = diffuse.g; d[2] = diffuse.b; d[3] = diffuse.a;
+		s[0] = specular.r; s[1] = specular.g; s[2] = specular.b; s[3] = specular.a;
+		p[0] = pos.x; p[1] = pos.y; p[2] = pos.z; p[3] = (l.GetType() == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f);
+	}
+	const Color4f ambient = m_ambient.ToColor4f();
+	b.ambient[0] = ambient.r; b.ambient[1] = ambient.g; b.ambient[2] = ambient.b; b.ambient[3] = ambient.a;
+	b.invLogZfarPlus1 = m_invLogZfarPlus1;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_sceneBlock);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SceneBlock), &b);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
 void RendererOGL::SetMaterialShaderTransforms(Material *m)
 {
 	m->SetCommonUniforms(m_modelViewStack.top(), m_projectionStack.top());
@@ -504,6 +761,9 @@ bool RendererOGL::DrawTriangles(const VertexArray *v, RenderState *rs, Material
 {
 	PROFILE_SCOPED()
 	if (!v || v->position.size() < 3) return false;
+	if (m_capture && m_capture->IsRecording())
+		m_capture->DrawTriangles(v, rs, m, t, GetCurrentModelView(), GetCurrentProjection());
+	FrameCapture::Pause pause(m_capture.get());
 
 	VertexBufferDesc vbd;
 	Uint32 attribIdx = 0;
@@ -527,26 +787,132 @@ bool RendererOGL::DrawTriangles(const VertexArray *v, RenderState *rs, Material
 		vbd.attrib[attribIdx].format	= ATTRIB_FORMAT_FLOAT2;
 		++attribIdx;
 	}
-	vbd.numVertices = v->position.size();
-	vbd.usage = BUFFER_USAGE_STATIC;
-	
-	// VertexBuffer
-	std::unique_ptr<VertexBuffer> vb;
-	vb.reset(CreateVertexBuffer(vbd));
-	vb->Populate(*v);
 
-	const bool res = DrawBuffer(vb.get(), rs, m, t);
-	CheckRenderErrors();
+	// stream it through the buffer for its vertex format, creating that on first use
+	std::unique_ptr<OGL::StreamVertexBuffer> &stream = m_streamBuffers[v->GetAttributeSet()];
+	if (!stream) {
+		vbd.numVertices = STREAM_BUFFER_VERTICES;
+		vbd.usage = BUFFER_USAGE_DYNAMIC;
+		stream.reset(new OGL::StreamVertexBuffer(vbd));
+	}
+
+	Uint32 first;
+	bool res;
+	if (stream->Append(*v, first)) {
+		SetRenderState(rs);
+		m->Apply();
+		SetMaterialShaderTransforms(m);
+
+		stream->Bind();
+		glDrawArrays(t, first, v->GetNumVerts());
+		stream->Release();
+		CheckRenderErrors();
+
+		m_stats.AddToStatCount(Stats::STAT_DRAWCALL, 1);
+		res = true;
+	} else {
+		// too big to stream, so fall back to a one-off buffer
+		vbd.numVertices = v->position.size();
+		vbd.usage = BUFFER_USAGE_STATIC;
+
+		std::unique_ptr<VertexBuffer> vb;
+		vb.reset(CreateVertexBuffer(vbd));
+		vb->Populate(*v);
+
+		res = DrawBuffer(vb.get(), rs, m, t);
+		CheckRenderErrors();
+	}
 	
 	m_stats.AddToStatCount(Stats::STAT_DRAWTRIS, 1);
 
 	return res;
 }
 
+Material *RendererOGL::GetPointSpriteMaterial(Material *m)
+{
+	// only the multi shader knows how to read instance transforms
+	MaterialDescriptor desc = m->GetDescriptor();
+	if (desc.effect != EFFECT_DEFAULT || desc.lighting || desc.vertexColors)
+		return nullptr;
+	desc.instanced = true;
+
+	Material *sm = nullptr;
+	for (auto &it : m_spriteMaterials) {
+		if (it.first == desc) {
+			sm = it.second.Get();
+			break;
+		}
+	}
+	if (!sm) {
+		sm = CreateMaterial(desc);
+		m_spriteMaterials.push_back(std::make_pair(desc, RefCountedPtr<Material>(sm)));
+	}
+
+	sm->texture0 = m->texture0;
+	sm->texture1 = m->texture1;
+	sm->diffuse = m->diffuse;
+	sm->emissive = m->emissive;
+	sm->specialParameter0 = m->specialParameter0;
+	return sm;
+}
+
 bool RendererOGL::DrawPointSprites(int count, const vector3f *positions, RenderState *rs, Material *material, float size)
 {
 	PROFILE_SCOPED()
 	if (count < 1 || !material || !material->texture0) return false;
+	if (m_capture && m_capture->IsRecording())
+		m_capture->DrawPointSprites(count, positions, rs, material, size, GetCurrentModelView(), GetCurrentProjection());
+	FrameCapture::Pause pause(m_capture.get());
+
+	Material *spriteMat = GetPointSpriteMaterial(material);
+	if (spriteMat) {
+		if (!m_spriteQuad.Valid()) {
+			VertexArray quad(ATTRIB_POSITION | ATTRIB_NORMAL | ATTRIB_UV0, 6);
+			const vector3f n(0.0f, 0.0f, 1.0f);
+			quad.Add(vector3f(-0.5f,  0.5f, 0.0f), n, vector2f(0.f, 0.f)); //top left
+			quad.Add(vector3f(-0.5f, -0.5f, 0.0f), n, vector2f(0.f, 1.f)); //bottom left
+			quad.Add(vector3f( 0.5f,  0.5f, 0.0f), n, vector2f(1.f, 0.f)); //top right
+			quad.Add(vector3f( 0.5f,  0.5f, 0.0f), n, vector2f(1.f, 0.f)); //top right
+			quad.Add(vector3f(-0.5f, -0.5f, 0.0f), n, vector2f(0.f, 1.f)); //bottom left
+			quad.Add(vector3f( 0.5f, -0.5f, 0.0f), n, vector2f(1.f, 1.f)); //bottom right
+
+			VertexBufferDesc vbd;
+			vbd.attrib[0].semantic = ATTRIB_POSITION;
+			vbd.attrib[0].format   = ATTRIB_FORMAT_FLOAT3;
+			vbd.attrib[1].semantic = ATTRIB_NORMAL;
+			vbd.attrib[1].format   = ATTRIB_FORMAT_FLOAT3;
+			vbd.attrib[2].semantic = ATTRIB_UV0;
+			vbd.attrib[2].format   = ATTRIB_FORMAT_FLOAT2;
+			vbd.numVertices = quad.GetNumVerts();
+			vbd.usage = BUFFER_USAGE_STATIC;
+			m_spriteQuad.Reset(CreateVertexBuffer(vbd));
+			m_spriteQuad->Populate(quad);
+		}
+
+		if (!m_spriteInstances.Valid() || m_spriteInstances->GetSize() < Uint32(count)) {
+			Uint32 capacity = 64;
+			while (capacity < Uint32(count)) capacity <<= 1;
+			m_spriteInstances.Reset(CreateInstanceBuffer(capacity, BUFFER_USAGE_DYNAMIC));
+		}
+
+		// every sprite faces the camera the same way, so they share the
+		// rotation and scale and only the translation differs
+		matrix4x4f base(GetCurrentModelView());
+		base.ClearToRotOnly();
+		base = base.Inverse() * matrix4x4f::ScaleMatrix(size);
+
+		matrix4x4f *instances = m_spriteInstances->Map(BUFFER_MAP_WRITE);
+		for (int i=0; i<count; i++) {
+			instances[i] = base;
+			instances[i].SetTranslate(positions[i]);
+		}
+		m_spriteInstances->Unmap();
+		m_spriteInstances->SetInstanceCount(count);
+
+		DrawBufferInstanced(m_spriteQuad.Get(), rs, spriteMat, m_spriteInstances.Get(), TRIANGLES);
+		m_stats.AddToStatCount(Stats::STAT_DRAWPOINTSPRITES, count);
+		return true;
+	}
 
 	VertexArray va(ATTRIB_POSITION | ATTRIB_UV0, count * 6);
 
@@ -586,6 +952,8 @@ bool RendererOGL::DrawPointSprites(int count, const vector3f *positions, RenderS
 bool RendererOGL::DrawBuffer(VertexBuffer* vb, RenderState* state, Material* mat, PrimitiveType pt)
 {
 	PROFILE_SCOPED()
+	if (m_capture && m_capture->IsRecording())
+		m_capture->DrawBuffer(vb, nullptr, nullptr, state, mat, pt, GetCurrentModelView(), GetCurrentProjection());
 	SetRenderState(state);
 	mat->Apply();
 
@@ -604,6 +972,8 @@ bool RendererOGL::DrawBuffer(VertexBuffer* vb, RenderState* state, Material* mat
 bool RendererOGL::DrawBufferIndexed(VertexBuffer *vb, IndexBuffer *ib, RenderState *state, Material *mat, PrimitiveType pt)
 {
 	PROFILE_SCOPED()
+	if (m_capture && m_capture->IsRecording())
+		m_capture->DrawBuffer(vb, ib, nullptr, state, mat, pt, GetCurrentModelView(), GetCurrentProjection());
 	SetRenderState(state);
 	mat->Apply();
 
@@ -611,7 +981,7 @@ bool RendererOGL::DrawBufferIndexed(VertexBuffer *vb, IndexBuffer *ib, RenderSta
 
 	vb->Bind();
 	ib->Bind();
-	glDrawElements(pt, ib->GetIndexCount(), GL_UNSIGNED_SHORT, 0);
+	glDrawElements(pt, ib->GetIndexCount(), static_cast<OGL::IndexBuffer*>(ib)->GetGLType(), 0);
 	ib->Release();
 	vb->Release();
 	CheckRenderErrors();
@@ -624,6 +994,8 @@ bool RendererOGL::DrawBufferIndexed(VertexBuffer *vb, IndexBuffer *ib, RenderSta
 bool RendererOGL::DrawBufferInstanced(VertexBuffer* vb, RenderState* state, Material* mat, InstanceBuffer* instb, PrimitiveType pt)
 {
 	PROFILE_SCOPED()
+	if (m_capture && m_capture->IsRecording())
+		m_capture->DrawBuffer(vb, nullptr, instb, state, mat, pt, GetCurrentModelView(), GetCurrentProjection());
 	SetRenderState(state);
 	mat->Apply();
 
@@ -644,6 +1016,8 @@ bool RendererOGL::DrawBufferInstanced(VertexBuffer* vb, RenderState* state, Mate
 bool RendererOGL::DrawBufferIndexedInstanced(VertexBuffer *vb, IndexBuffer *ib, RenderState *state, Material *mat, InstanceBuffer* instb, PrimitiveType pt)
 {
 	PROFILE_SCOPED()
+	if (m_capture && m_capture->IsRecording())
+		m_capture->DrawBuffer(vb, ib, instb, state, mat, pt, GetCurrentModelView(), GetCurrentProjection());
 	SetRenderState(state);
 	mat->Apply();
 
@@ -652,7 +1026,7 @@ bool RendererOGL::DrawBufferIndexedInstanced(VertexBuffer *vb, IndexBuffer *ib,
 	vb->Bind();
 	ib->Bind();
 	instb->Bind();
-	glDrawElementsInstanced(pt, ib->GetIndexCount(), GL_UNSIGNED_SHORT, 0, instb->GetInstanceCount());
+	glDrawElementsInstanced(pt, ib->GetIndexCount(), static_cast<OGL::IndexBuffer*>(ib)->GetGLType(), 0, instb->GetInstanceCount());
 	instb->Release();
 	ib->Release();
 	vb->Release();
@@ -683,6 +1057,7 @@ Material *RendererOGL::CreateMaterial(const MaterialDescriptor &d)
 		mat = new OGL::VtxColorMaterial();
 		break;
 	case EFFECT_UI:
+	case EFFECT_UI_DISTANCE_FIELD:
 		mat = new OGL::UIMaterial();
 		break;
 	case EFFECT_PLANETRING:
@@ -714,6 +1089,12 @@ Material *RendererOGL::CreateMaterial(const MaterialDescriptor &d)
 	case EFFECT_GASSPHERE_TERRAIN:
 		mat = new OGL::GasGiantSurfaceMaterial();
 		break;
+	case EFFECT_TRAIL:
+		mat = new OGL::TrailMaterial();
+		break;
+	case EFFECT_SPEEDLINES:
+		mat = new OGL::SpeedLinesMaterial();
+		break;
 	default:
 		if (desc.lighting)
 			mat = new OGL::LitMultiMaterial();
@@ -830,9 +1211,9 @@ VertexBuffer *RendererOGL::CreateVertexBuffer(const VertexBufferDesc &desc)
 	return new OGL::VertexBuffer(desc);
 }
 
-IndexBuffer *RendererOGL::CreateIndexBuffer(Uint32 size, BufferUsage usage)
+IndexBuffer *RendererOGL::CreateIndexBuffer(Uint32 size, BufferUsage usage, IndexFormat format)
 {
-	return new OGL::IndexBuffer(size, usage);
+	return new OGL::IndexBuffer(size, usage, format);
 }
 
 InstanceBuffer *RendererOGL::CreateInstanceBuffer(Uint32 size, BufferUsage usage)
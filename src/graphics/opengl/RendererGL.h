@@ -35,6 +35,7 @@ namespace OGL {
 	class RingMaterial;
 	class FresnelColourMaterial;
 	class ShieldMaterial;
+	class StreamVertexBuffer;
 	class UIMaterial;
 }
 
@@ -53,6 +54,16 @@ public:
 	virtual void CheckRenderErrors() const { CheckErrors(); }
 	static void CheckErrors();
 
+	// GL state changes made and skipped since the last SwapBuffers, counted by
+	// the programs, uniforms and buffers themselves and handed to Stats there
+	struct StateStats {
+		Uint32 programSwitches;
+		Uint32 vaoBinds;
+		Uint32 uniformsSet;
+		Uint32 uniformsSkipped;
+	};
+	static StateStats s_stateStats;
+
 	virtual bool GetNearFarRange(float &near_, float &far_) const;
 
 	virtual bool BeginFrame();
@@ -61,6 +72,7 @@ public:
 
 	virtual bool SetRenderState(RenderState*) override;
 	virtual bool SetRenderTarget(RenderTarget*) override;
+	virtual RenderTarget *GetRenderTarget() const override;
 
 	virtual bool SetDepthRange(double near, double far) override;
 
@@ -96,7 +108,7 @@ public:
 	virtual RenderState *CreateRenderState(const RenderStateDesc &) override;
 	virtual RenderTarget *CreateRenderTarget(const RenderTargetDesc &) override;
 	virtual VertexBuffer *CreateVertexBuffer(const VertexBufferDesc&) override;
-	virtual IndexBuffer *CreateIndexBuffer(Uint32 size, BufferUsage) override;
+	virtual IndexBuffer *CreateIndexBuffer(Uint32 size, BufferUsage, IndexFormat = INDEX_FORMAT_UINT16) override;
 	virtual InstanceBuffer *CreateInstanceBuffer(Uint32 size, BufferUsage) override;
 
 	virtual bool ReloadShaders();
@@ -118,6 +130,15 @@ public:
 
 	virtual bool Screendump(ScreendumpState &sd);
 
+	virtual void BeginGpuTimer(Stats::GpuTimerType type) override;
+	virtual void EndGpuTimer() override;
+
+	virtual Uint32 CreateOcclusionQuery() override;
+	virtual void DeleteOcclusionQuery(Uint32 query) override;
+	virtual void BeginOcclusionQuery(Uint32 query) override;
+	virtual void EndOcclusionQuery() override;
+	virtual bool GetOcclusionQueryResult(Uint32 query, Uint32 &samples) override;
+
 protected:
 	virtual void PushState();
 	virtual void PopState();
@@ -131,6 +152,19 @@ protected:
 	
 	void SetMaterialShaderTransforms(Material *);
 
+	// lights, ambient and the log z constant go to every program through
+	// one uniform block, uploaded when one of them has changed since the
+	// last draw rather than set on each program as it's used
+	struct SceneBlock {
+		float lights[TOTAL_NUM_LIGHTS][3][4]; // diffuse, specular, position
+		float ambient[4];
+		float invLogZfarPlus1;
+		float pad[3];
+	};
+	void UpdateSceneBlock();
+	GLuint m_sceneBlock;
+	bool m_sceneBlockDirty;
+
 	matrix4x4f& GetCurrentTransform() { return m_currentTransform; }
 	matrix4x4f m_currentTransform;
 
@@ -146,6 +180,15 @@ protected:
 	friend class OGL::ShieldMaterial;
 	std::vector<std::pair<MaterialDescriptor, OGL::Program*> > m_programs;
 	std::unordered_map<Uint32, OGL::RenderState*> m_renderStates;
+	// DrawTriangles geometry, one stream per vertex format (AttributeSet)
+	static const Uint32 STREAM_BUFFER_VERTICES = 1 << 17;
+	std::unordered_map<Uint32, std::unique_ptr<OGL::StreamVertexBuffer> > m_streamBuffers;
+	// DrawPointSprites: one unit quad drawn once per sprite, with the
+	// sprite transforms in an instance buffer that grows as needed
+	Material *GetPointSpriteMaterial(Material *m);
+	RefCountedPtr<VertexBuffer> m_spriteQuad;
+	RefCountedPtr<InstanceBuffer> m_spriteInstances;
+	std::vector<std::pair<MaterialDescriptor, RefCountedPtr<Material> > > m_spriteMaterials;
 	float m_invLogZfarPlus1;
 	OGL::RenderTarget *m_activeRenderTarget;
 	RenderState *m_activeRenderState;
@@ -160,6 +203,31 @@ protected:
 	};
 	std::stack<Viewport> m_viewportStack;
 
+	// GL_TIMESTAMP queries bracketing each timed scope. a frame's queries
+	// are read back GPU_TIMER_FRAMES-1 frames later, and dropped if the GPU
+	// still hasn't got to them, so reading them never stalls
+	static const Uint32 GPU_TIMER_FRAMES = 2;
+	struct GpuTimerScope {
+		Stats::GpuTimerType type;
+		Uint32 begin;
+		Uint32 end;
+	};
+	struct GpuTimerFrame {
+		GpuTimerFrame() : used(0) {}
+		std::vector<GLuint> queries;
+		Uint32 used;
+		std::vector<GpuTimerScope> scopes;
+	};
+	Uint32 IssueTimestamp();
+	void ResolveGpuTimers();
+	bool m_gpuTimersEnabled;
+	Uint32 m_gpuTimerFrame;
+	GpuTimerFrame m_gpuTimerFrames[GPU_TIMER_FRAMES];
+	std::vector<Uint32> m_gpuTimerStack;
+
+	// draws the captured frame again, see CaptureFrame
+	void ReplayCapture();
+
 private:
 	static bool initted;
 };
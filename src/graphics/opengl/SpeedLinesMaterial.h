@@ -0,0 +1,58 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _OGL_SPEEDLINES_MATERIAL_H
+#define _OGL_SPEEDLINES_MATERIAL_H
+/*
+ * Speed lines material.
+ * The vertices are the points' starting places, each twice over with uv0.x
+ * saying which end of the line it is. How far they've moved, the direction
+ * and length of the lines and the size of the box they wrap around in come
+ * in specialParameter0. The colour is the diffuse
+ */
+#include "libs.h"
+#include "MaterialGL.h"
+#include "Program.h"
+#include "SpeedLines.h"
+
+namespace Graphics {
+	namespace OGL {
+		class SpeedLinesProgram : public Program {
+		public:
+			SpeedLinesProgram() : Program("speedlines", "") {
+				lineOffset.Init("lineOffset", m_program);
+				lineDir.Init("lineDir", m_program);
+				lineBounds.Init("lineBounds", m_program);
+			}
+
+			Uniform lineOffset;
+			Uniform lineDir;
+			Uniform lineBounds;
+		};
+
+		class SpeedLinesMaterial : public Material {
+		public:
+			Program *CreateProgram(const MaterialDescriptor &) {
+				return new SpeedLinesProgram();
+			}
+
+			virtual void Apply() {
+				OGL::Material::Apply();
+				SpeedLinesProgram *p = static_cast<SpeedLinesProgram*>(m_program);
+				p->diffuse.Set(this->diffuse);
+				if (this->specialParameter0) {
+					const SpeedLines::LineParameters *params = static_cast<const SpeedLines::LineParameters*>(this->specialParameter0);
+					p->lineOffset.Set(params->offset);
+					p->lineDir.Set(params->dir);
+					p->lineBounds.Set(params->bounds);
+				} else {
+					p->lineOffset.Set(vector3f(0.f));
+					p->lineDir.Set(vector3f(0.f));
+					p->lineBounds.Set(1.f);
+				}
+			}
+		};
+	}
+}
+
+#endif
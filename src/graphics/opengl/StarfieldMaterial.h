@@ -7,23 +7,41 @@
  * Starfield material.
  * This does nothing very special except toggle POINT_SIZE
  * The Program requires setting intensity using the generic emission parameter
+ * The hyperspace streaks are moved along by the offset in specialParameter0
  */
 #include "libs.h"
 #include "graphics/Material.h"
 #include "Program.h"
+#include "Background.h"
 
 namespace Graphics {
 	namespace OGL {
+		class StarfieldProgram : public Program {
+		public:
+			StarfieldProgram() : Program("starfield", "") {
+				hyperspaceOffset.Init("hyperspaceOffset", m_program);
+			}
+
+			Uniform hyperspaceOffset;
+		};
+
 		class StarfieldMaterial : public Material {
 		public:
 			Program *CreateProgram(const MaterialDescriptor &) {
-				return new Program("starfield", "");
+				return new StarfieldProgram();
 			}
 
 			virtual void Apply() {
 				glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
-				m_program->Use();
-				m_program->emission.Set(this->emissive);
+				StarfieldProgram *p = static_cast<StarfieldProgram*>(m_program);
+				p->Use();
+				p->emission.Set(this->emissive);
+				if (this->specialParameter0) {
+					const Background::StarfieldParameters *params = static_cast<const Background::StarfieldParameters*>(this->specialParameter0);
+					p->hyperspaceOffset.Set(params->hyperspaceOffset);
+				} else {
+					p->hyperspaceOffset.Set(vector3f(0.f));
+				}
 			}
 
 			virtual void Unapply() {
@@ -19,6 +19,7 @@ inline GLint GLInternalFormat(TextureFormat format) {
 		case TEXTURE_INTENSITY_8:  return GL_RED;
 		case TEXTURE_DXT5: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
 		case TEXTURE_DXT1:  return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case TEXTURE_R_FLOAT: return GL_R32F;
 		case TEXTURE_DEPTH: return GL_DEPTH_COMPONENT;
 		default: assert(0); return 0;
 	}
@@ -34,6 +35,7 @@ inline GLint GLCompressedInternalFormat(TextureFormat format) {
 		case TEXTURE_INTENSITY_8:  return GL_RED;
 		case TEXTURE_DXT5: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
 		case TEXTURE_DXT1:  return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case TEXTURE_R_FLOAT: return GL_R32F;
 		default: assert(0); return 0;
 	}
 }
@@ -44,6 +46,7 @@ inline GLint GLImageFormat(TextureFormat format) {
 		case TEXTURE_RGB_888:  return GL_RGB;
 		case TEXTURE_LUMINANCE_ALPHA_88: return GL_RG;
 		case TEXTURE_INTENSITY_8:  return GL_RED;
+		case TEXTURE_R_FLOAT: return GL_RED;
 		case TEXTURE_DXT5: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
 		case TEXTURE_DXT1:  return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
 		case TEXTURE_DEPTH: return GL_DEPTH_COMPONENT;
@@ -55,11 +58,14 @@ inline GLint GLTextureType(TextureType type) {
 	switch (type) {
 		case TEXTURE_2D: return GL_TEXTURE_2D;
 		case TEXTURE_CUBE_MAP: return GL_TEXTURE_CUBE_MAP;
+		case TEXTURE_2D_ARRAY: return GL_TEXTURE_2D_ARRAY;
 		default: assert(0); return 0;
 	}
 }
 
 inline GLint GLImageType(TextureFormat format) {
+	if (format == TEXTURE_R_FLOAT)
+		return GL_FLOAT;
 	return GL_UNSIGNED_BYTE;
 }
 
@@ -76,8 +82,24 @@ inline bool IsCompressed(TextureFormat format) {
 }
 
 TextureGL::TextureGL(const TextureDescriptor &descriptor, const bool useCompressed) :
-	Texture(descriptor)
+	Texture(descriptor),
+	m_useCompressed(useCompressed)
 {
+	Allocate(descriptor);
+}
+
+void TextureGL::Reallocate(const TextureDescriptor &descriptor)
+{
+	// the storage can't change shape, so start again with a new name.
+	// materials look the name up each time they're applied
+	glDeleteTextures(1, &m_texture);
+	SetDescriptor(descriptor);
+	Allocate(descriptor);
+}
+
+void TextureGL::Allocate(const TextureDescriptor &descriptor)
+{
+	const bool useCompressed = m_useCompressed;
 	m_target = GLTextureType(descriptor.type);
 
 	glGenTextures(1, &m_texture);
@@ -194,6 +216,41 @@ TextureGL::TextureGL(const TextureDescriptor &descriptor, const bool useCompress
 			}
 			break;
 
+		case GL_TEXTURE_2D_ARRAY:
+			// as GL_TEXTURE_2D, with every level made for all the layers at once
+			if (!IsCompressed(descriptor.format)) {
+				if (!descriptor.generateMipmaps)
+					glTexParameteri(m_target, GL_TEXTURE_MAX_LEVEL, 0);
+				RendererOGL::CheckErrors();
+
+				glTexImage3D(
+					m_target, 0, compressTexture ? GLCompressedInternalFormat(descriptor.format) : GLInternalFormat(descriptor.format),
+					descriptor.dataSize.x, descriptor.dataSize.y, descriptor.layers, 0,
+					GLImageFormat(descriptor.format),
+					GLImageType(descriptor.format), 0);
+				RendererOGL::CheckErrors();
+			} else {
+				const GLint oglFormatMinSize = GetMinSize(descriptor.format);
+				size_t Width = descriptor.dataSize.x;
+				size_t Height = descriptor.dataSize.y;
+				size_t bufSize = ((Width + 3) / 4) * ((Height + 3) / 4) * oglFormatMinSize;
+
+				GLint maxMip = 0;
+				for( unsigned int i=0; i < descriptor.numberOfMipMaps; ++i ) {
+					maxMip = i;
+					glCompressedTexImage3D(m_target, i, GLInternalFormat(descriptor.format), Width, Height, descriptor.layers, 0, bufSize * descriptor.layers, 0);
+					if( Width<=MIN_COMPRESSED_TEXTURE_DIMENSION || Height<=MIN_COMPRESSED_TEXTURE_DIMENSION ) {
+						break;
+					}
+					bufSize /= 4;
+					Width /= 2;
+					Height /= 2;
+				}
+				glTexParameteri(m_target, GL_TEXTURE_MAX_LEVEL, maxMip);
+				RendererOGL::CheckErrors();
+			}
+			break;
+
 		default:
 			assert(0);
 	}
@@ -337,6 +394,42 @@ void TextureGL::Update(const TextureCubeData &data, const vector2f &dataSize, Te
 	glBindTexture(m_target, 0);
 }
 
+void TextureGL::UpdateLayer(const void *data, unsigned int layer, const vector2f &dataSize, TextureFormat format, const unsigned int numMips)
+{
+	assert(m_target == GL_TEXTURE_2D_ARRAY);
+	assert(layer < GetDescriptor().layers);
+	glBindTexture(m_target, m_texture);
+
+	if (!IsCompressed(format)) {
+		glTexSubImage3D(m_target, 0, 0, 0, layer, dataSize.x, dataSize.y, 1, GLImageFormat(format), GLImageType(format), data);
+		// all the layers' levels are made over again, which is fine while
+		// arrays are only filled as models load
+		if (GetDescriptor().generateMipmaps)
+			glGenerateMipmap(m_target);
+	} else {
+		const GLint oglInternalFormat = GLImageFormat(format);
+		size_t Offset = 0;
+		size_t Width = dataSize.x;
+		size_t Height = dataSize.y;
+		size_t bufSize = ((Width + 3) / 4) * ((Height + 3) / 4) * GetMinSize(format);
+
+		const unsigned char *pData = static_cast<const unsigned char*>(data);
+		for( unsigned int i = 0; i < numMips; ++i ) {
+			glCompressedTexSubImage3D(m_target, i, 0, 0, layer, Width, Height, 1, oglInternalFormat, bufSize, &pData[Offset]);
+			if( Width<=MIN_COMPRESSED_TEXTURE_DIMENSION || Height<=MIN_COMPRESSED_TEXTURE_DIMENSION ) {
+				break;
+			}
+			Offset += bufSize;
+			bufSize /= 4;
+			Width /= 2;
+			Height /= 2;
+		}
+	}
+	RendererOGL::CheckErrors();
+
+	glBindTexture(m_target, 0);
+}
+
 void TextureGL::Bind()
 {
 	glBindTexture(m_target, m_texture);
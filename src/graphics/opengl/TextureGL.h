@@ -13,6 +13,8 @@ class TextureGL : public Texture {
 public:
 	virtual void Update(const void *data, const vector2f &pos, const vector2f &dataSize, TextureFormat format, const unsigned int numMips);
 	virtual void Update(const TextureCubeData &data, const vector2f &dataSize, TextureFormat format, const unsigned int numMips);
+	virtual void UpdateLayer(const void *data, unsigned int layer, const vector2f &dataSize, TextureFormat format, const unsigned int numMips);
+	virtual void Reallocate(const TextureDescriptor &descriptor);
 
 	virtual ~TextureGL();
 
@@ -25,7 +27,9 @@ public:
 private:
 	friend class RendererOGL;
 	TextureGL(const TextureDescriptor &descriptor, const bool useCompressed);
+	void Allocate(const TextureDescriptor &descriptor);
 
+	bool m_useCompressed;
 	GLenum m_target;
 	GLuint m_texture;
 };
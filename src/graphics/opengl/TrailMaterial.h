@@ -0,0 +1,54 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _OGL_TRAIL_MATERIAL_H
+#define _OGL_TRAIL_MATERIAL_H
+/*
+ * Contact trail material.
+ * The trail is a ring of line segments, each vertex tagged with its sample
+ * number in uv0.x. The fade is worked out from how far behind the newest
+ * sample that is, given in specialParameter0, so the points never change
+ * once they're in the buffer. The colour is the diffuse
+ */
+#include "libs.h"
+#include "MaterialGL.h"
+#include "Program.h"
+#include "HudTrail.h"
+
+namespace Graphics {
+	namespace OGL {
+		class TrailProgram : public Program {
+		public:
+			TrailProgram() : Program("trail", "") {
+				trailHead.Init("trailHead", m_program);
+				trailCount.Init("trailCount", m_program);
+			}
+
+			Uniform trailHead;
+			Uniform trailCount;
+		};
+
+		class TrailMaterial : public Material {
+		public:
+			Program *CreateProgram(const MaterialDescriptor &) {
+				return new TrailProgram();
+			}
+
+			virtual void Apply() {
+				OGL::Material::Apply();
+				TrailProgram *p = static_cast<TrailProgram*>(m_program);
+				p->diffuse.Set(this->diffuse);
+				if (this->specialParameter0) {
+					const HudTrail::TrailParameters *params = static_cast<const HudTrail::TrailParameters*>(this->specialParameter0);
+					p->trailHead.Set(params->head);
+					p->trailCount.Set(params->count);
+				} else {
+					p->trailHead.Set(0.f);
+					p->trailCount.Set(1.f);
+				}
+			}
+		};
+	}
+}
+
+#endif
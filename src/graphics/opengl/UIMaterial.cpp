@@ -15,6 +15,8 @@ namespace OGL {
 UIProgram::UIProgram(const MaterialDescriptor &desc)
 {
 	m_name = "ui";
+	if (desc.effect == EFFECT_UI_DISTANCE_FIELD)
+		m_defines = "#define DISTANCE_FIELD\n";
 	RendererOGL::CheckErrors();
 
 	LoadShaders(m_name, m_defines);
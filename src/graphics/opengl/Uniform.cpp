@@ -3,87 +3,111 @@
 
 #include "Uniform.h"
 #include "TextureGL.h"
+#include "RendererGL.h"
 
 namespace Graphics {
 namespace OGL {
 
 Uniform::Uniform()
 : m_location(-1)
+, m_valueSize(0)
 {
 }
 
 void Uniform::Init(const char *name, GLuint program)
 {
 	m_location = glGetUniformLocation(program, name);
+	m_valueSize = 0;
+}
+
+bool Uniform::Changed(const void *value, size_t size)
+{
+	assert(size <= sizeof(m_value));
+	// compared bit for bit, so the odd identical float (-0, NaN) gets set again, which is harmless
+	if (size == m_valueSize && memcmp(m_value, value, size) == 0) {
+		++RendererOGL::s_stateStats.uniformsSkipped;
+		return false;
+	}
+	memcpy(m_value, value, size);
+	m_valueSize = size;
+	++RendererOGL::s_stateStats.uniformsSet;
+	return true;
 }
 
 void Uniform::Set(int i)
 {
-	if (m_location != -1)
+	if (m_location != -1 && Changed(&i, sizeof(i)))
 		glUniform1i(m_location, i);
 }
 
 void Uniform::Set(float f)
 {
-	if (m_location != -1)
+	if (m_location != -1 && Changed(&f, sizeof(f)))
 		glUniform1f(m_location, f);
 }
 
 void Uniform::Set(const vector3f &v)
 {
-	if (m_location != -1)
+	const float f[3] = { v.x, v.y, v.z };
+	if (m_location != -1 && Changed(f, sizeof(f)))
 		glUniform3f(m_location, v.x, v.y, v.z);
 }
 
 void Uniform::Set(const vector3d &v)
 {
-	if (m_location != -1)
-		glUniform3f(m_location, v.x, v.y, v.z); //yes, 3f
+	const float f[3] = { float(v.x), float(v.y), float(v.z) };
+	if (m_location != -1 && Changed(f, sizeof(f)))
+		glUniform3f(m_location, f[0], f[1], f[2]); //yes, 3f
 }
 
 void Uniform::Set(const Color &c)
 {
 	Color4f c4f = c.ToColor4f();
-	if (m_location != -1)
+	const float f[4] = { c4f.r, c4f.g, c4f.b, c4f.a };
+	if (m_location != -1 && Changed(f, sizeof(f)))
 		glUniform4f(m_location, c4f.r, c4f.g, c4f.b, c4f.a);
 }
 
 void Uniform::Set(const int v[3])
 {
-	if (m_location != -1)
+	if (m_location != -1 && Changed(v, sizeof(int) * 3))
 		glUniform3i(m_location, v[0],v[1],v[2]);
 }
 
 void Uniform::Set(const float x, const float y, const float z, const float w)
 {
-	if (m_location != -1)
+	const float f[4] = { x, y, z, w };
+	if (m_location != -1 && Changed(f, sizeof(f)))
 		glUniform4f(m_location, x, y, z, w);
 }
 
 void Uniform::Set(const float m[9])
 {
-	if (m_location != -1)
+	if (m_location != -1 && Changed(m, sizeof(float) * 9))
 		glUniformMatrix3fv(m_location, 1, GL_FALSE, m);
 }
 
 void Uniform::Set(const matrix3x3f &m)
 {
-	if (m_location != -1)
+	if (m_location != -1 && Changed(&m[0], sizeof(float) * 9))
 		glUniformMatrix3fv(m_location, 1, GL_FALSE, &m[0]);
 }
 
 void Uniform::Set(const matrix4x4f &m)
 {
-	if (m_location != -1)
+	if (m_location != -1 && Changed(&m[0], sizeof(float) * 16))
 		glUniformMatrix4fv(m_location, 1, GL_FALSE, &m[0]);
 }
 
+// the texture itself is always bound, as materials unbind theirs after drawing
 void Uniform::Set(Texture *tex, unsigned int unit)
 {
 	if (m_location != -1 && tex) {
 		glActiveTexture(GL_TEXTURE0 + unit);
 		static_cast<TextureGL*>(tex)->Bind();
-		glUniform1i(m_location, unit);
+		const int u = int(unit);
+		if (Changed(&u, sizeof(u)))
+			glUniform1i(m_location, u);
 	}
 }
 
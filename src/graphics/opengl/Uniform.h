@@ -30,6 +30,15 @@ namespace Graphics {
 
 		//private:
 			GLint m_location;
+
+		private:
+			// uniforms keep their values per program, so a Set with the value that's
+			// already there can be skipped. answers whether it needs setting, and
+			// remembers the new value if it does
+			bool Changed(const void *value, size_t size);
+
+			Uint8 m_value[sizeof(float) * 16];
+			size_t m_valueSize;
 		};
 	}
 }
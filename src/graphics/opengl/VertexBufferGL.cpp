@@ -2,6 +2,7 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "graphics/opengl/VertexBufferGL.h"
+#include "graphics/opengl/RendererGL.h"
 #include "graphics/VertexArray.h"
 #include "utils.h"
 
@@ -11,11 +12,13 @@ GLint get_num_components(VertexAttribFormat fmt)
 {
 	switch (fmt) {
 	case ATTRIB_FORMAT_FLOAT2:
+	case ATTRIB_FORMAT_SHORT2N:
 		return 2;
 	case ATTRIB_FORMAT_FLOAT3:
 		return 3;
 	case ATTRIB_FORMAT_FLOAT4:
 	case ATTRIB_FORMAT_UBYTE4:
+	case ATTRIB_FORMAT_SHORT4N:
 		return 4;
 	default:
 		assert(false);
@@ -28,6 +31,9 @@ GLenum get_component_type(VertexAttribFormat fmt)
 	switch (fmt) {
 	case ATTRIB_FORMAT_UBYTE4:
 		return GL_UNSIGNED_BYTE;
+	case ATTRIB_FORMAT_SHORT2N:
+	case ATTRIB_FORMAT_SHORT4N:
+		return GL_SHORT;
 	case ATTRIB_FORMAT_FLOAT2:
 	case ATTRIB_FORMAT_FLOAT3:
 	case ATTRIB_FORMAT_FLOAT4:
@@ -36,49 +42,46 @@ GLenum get_component_type(VertexAttribFormat fmt)
 	}
 }
 
-VertexBuffer::VertexBuffer(const VertexBufferDesc &desc) :
-	Graphics::VertexBuffer(desc)
+GLboolean get_normalised(VertexAttribFormat fmt)
+{
+	switch (fmt) {
+	case ATTRIB_FORMAT_SHORT2N:
+	case ATTRIB_FORMAT_SHORT4N:
+		return GL_TRUE;
+	default:
+		return GL_FALSE;
+	}
+}
+
+// fill in the offsets and the stride of a description, where they are left as zero
+static void FinaliseDesc(VertexBufferDesc &desc)
 {
 	//update offsets in desc
 	for (Uint32 i = 0; i < MAX_ATTRIBS; i++) {
-		if (m_desc.attrib[i].offset == 0)
-			m_desc.attrib[i].offset = VertexBufferDesc::CalculateOffset(m_desc, m_desc.attrib[i].semantic);
+		if (desc.attrib[i].offset == 0)
+			desc.attrib[i].offset = VertexBufferDesc::CalculateOffset(desc, desc.attrib[i].semantic);
 	}
 
 	//update stride in desc (respecting offsets)
-	if (m_desc.stride == 0)
+	if (desc.stride == 0)
 	{
 		Uint32 lastAttrib = 0;
 		while (lastAttrib < MAX_ATTRIBS) {
-			if (m_desc.attrib[lastAttrib].semantic == ATTRIB_NONE)
+			if (desc.attrib[lastAttrib].semantic == ATTRIB_NONE)
 				break;
 			lastAttrib++;
 		}
 
-		m_desc.stride = m_desc.attrib[lastAttrib].offset + VertexBufferDesc::GetAttribSize(m_desc.attrib[lastAttrib].format);
+		desc.stride = desc.attrib[lastAttrib].offset + VertexBufferDesc::GetAttribSize(desc.attrib[lastAttrib].format);
 	}
-	assert(m_desc.stride > 0);
-	assert(m_desc.numVertices > 0);
-
-	SetVertexCount(m_desc.numVertices);
-
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-
-	glGenBuffers(1, &m_buffer);
-
-	//Allocate initial data store
-	//Using zeroed m_data is not mandatory, but otherwise contents are undefined
-	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-	const Uint32 dataSize = m_desc.numVertices * m_desc.stride;
-	m_data = new Uint8[dataSize];
-	memset(m_data, 0, dataSize);
-	const GLenum usage = (m_desc.usage == BUFFER_USAGE_STATIC) ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
-	glBufferData(GL_ARRAY_BUFFER, dataSize, m_data, usage);
+	assert(desc.stride > 0);
+}
 
-	//Setup the VAO pointers
+// point the bound VAO at the bound GL_ARRAY_BUFFER
+static void SetupAttribPointers(const VertexBufferDesc &desc)
+{
 	for (Uint8 i = 0; i < MAX_ATTRIBS; i++) {
-		const auto& attr  = m_desc.attrib[i];
+		const auto& attr  = desc.attrib[i];
 		if (attr.semantic == ATTRIB_NONE)
 			break;
 
@@ -87,28 +90,75 @@ VertexBuffer::VertexBuffer(const VertexBufferDesc &desc) :
 		switch (attr.semantic) {
 		case ATTRIB_POSITION:
 			glEnableVertexAttribArray(0);	// Enable the attribute at that location
-			glVertexAttribPointer(0, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, m_desc.stride, offset);	
+			glVertexAttribPointer(0, get_num_components(attr.format), get_component_type(attr.format), get_normalised(attr.format), desc.stride, offset);	
 			break;
 		case ATTRIB_NORMAL:
 			glEnableVertexAttribArray(1);	// Enable the attribute at that location
-			glVertexAttribPointer(1, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, m_desc.stride, offset);
+			glVertexAttribPointer(1, get_num_components(attr.format), get_component_type(attr.format), get_normalised(attr.format), desc.stride, offset);
 			break;
 		case ATTRIB_DIFFUSE:
 			glEnableVertexAttribArray(2);	// Enable the attribute at that location
-			glVertexAttribPointer(2, get_num_components(attr.format), get_component_type(attr.format), GL_TRUE, m_desc.stride, offset);	// only normalise the colours
+			glVertexAttribPointer(2, get_num_components(attr.format), get_component_type(attr.format), GL_TRUE, desc.stride, offset);	// only normalise the colours
 			break;
 		case ATTRIB_UV0:
 			glEnableVertexAttribArray(3);	// Enable the attribute at that location
-			glVertexAttribPointer(3, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, m_desc.stride, offset);
+			glVertexAttribPointer(3, get_num_components(attr.format), get_component_type(attr.format), get_normalised(attr.format), desc.stride, offset);
 			break;
 		case ATTRIB_NONE:
 		default:
 			break;
 		}
 	}
+}
+
+// the VAO currently bound. every bind goes through BindVertexArray so this stays
+// right, and draws of the same buffer back to back don't rebind it
+static GLuint s_boundVAO = 0;
+
+static void BindVertexArray(GLuint vao)
+{
+	if (s_boundVAO != vao) {
+		glBindVertexArray(vao);
+		s_boundVAO = vao;
+		++RendererOGL::s_stateStats.vaoBinds;
+	}
+}
+
+static void DeleteVertexArray(GLuint vao)
+{
+	// deleting the bound VAO reverts the binding to zero
+	if (s_boundVAO == vao)
+		s_boundVAO = 0;
+	glDeleteVertexArrays(1, &vao);
+}
+
+VertexBuffer::VertexBuffer(const VertexBufferDesc &desc) :
+	Graphics::VertexBuffer(desc)
+{
+	FinaliseDesc(m_desc);
+	assert(m_desc.numVertices > 0);
+
+	SetVertexCount(m_desc.numVertices);
+
+	glGenVertexArrays(1, &m_vao);
+	BindVertexArray(m_vao);
+
+	glGenBuffers(1, &m_buffer);
+
+	//Allocate initial data store
+	//Using zeroed m_data is not mandatory, but otherwise contents are undefined
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	const Uint32 dataSize = m_desc.numVertices * m_desc.stride;
+	m_data = new Uint8[dataSize];
+	memset(m_data, 0, dataSize);
+	const GLenum usage = (m_desc.usage == BUFFER_USAGE_STATIC) ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
+	glBufferData(GL_ARRAY_BUFFER, dataSize, m_data, usage);
+
+	//Setup the VAO pointers
+	SetupAttribPointers(m_desc);
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	BindVertexArray(0);
 
 	//Don't keep client data around for static buffers
 	if (GetDesc().usage == BUFFER_USAGE_STATIC) {
@@ -120,7 +170,7 @@ VertexBuffer::VertexBuffer(const VertexBufferDesc &desc) :
 VertexBuffer::~VertexBuffer()
 {
 	glDeleteBuffers(1, &m_buffer);
-	glDeleteVertexArrays(1, &m_vao);
+	DeleteVertexArray(m_vao);
 	delete[] m_data;
 }
 
@@ -130,7 +180,7 @@ Uint8 *VertexBuffer::MapInternal(BufferMapMode mode)
 	assert(m_mapMode == BUFFER_MAP_NONE); //must not be currently mapped
 	m_mapMode = mode;
 	if (GetDesc().usage == BUFFER_USAGE_STATIC) {
-		glBindVertexArray(m_vao);
+		BindVertexArray(m_vao);
 		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
 		if (mode == BUFFER_MAP_READ)
 			return reinterpret_cast<Uint8*>(glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY));
@@ -156,7 +206,7 @@ void VertexBuffer::Unmap()
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
 	}
-	glBindVertexArray(0);
+	BindVertexArray(0);
 
 	m_mapMode = BUFFER_MAP_NONE;
 }
@@ -189,131 +239,212 @@ struct PosNormUVVert {
 };
 #pragma pack(pop)
 
-void CopyPosUV0(Graphics::VertexBuffer *vb, const Graphics::VertexArray &va)
+template <typename T>
+static T* Dest(Uint8 *dst, Uint32 stride)
 {
-	PosUVVert* vtxPtr = vb->Map<PosUVVert>(Graphics::BUFFER_MAP_WRITE);
-	assert(vb->GetDesc().stride == sizeof(PosUVVert));
-	for(Uint32 i=0 ; i<va.GetNumVerts() ; i++)
-	{
-		vtxPtr[i].pos	= va.position[i];
-		vtxPtr[i].uv	= va.uv0[i];
-	}
-	vb->Unmap();
+	assert(stride == sizeof(T));
+	return reinterpret_cast<T*>(dst);
 }
 
-void CopyPosCol(Graphics::VertexBuffer *vb, const Graphics::VertexArray &va)
+// interleaved size of one vertex of a VertexArray, zero if the attributes aren't supported
+static Uint32 GetVertexSize(const Graphics::AttributeSet as)
 {
-	PosColVert* vtxPtr = vb->Map<PosColVert>(Graphics::BUFFER_MAP_WRITE);
-	assert(vb->GetDesc().stride == sizeof(PosColVert));
-	for(Uint32 i=0 ; i<va.GetNumVerts() ; i++)
-	{
-		vtxPtr[i].pos	= va.position[i];
-		vtxPtr[i].col	= va.diffuse[i];
+	switch( as ) {
+	case Graphics::ATTRIB_POSITION:														return sizeof(PosVert);
+	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE:							return sizeof(PosColVert);
+	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0:								return sizeof(PosUVVert);
+	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0:	return sizeof(PosColUVVert);
+	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL | Graphics::ATTRIB_UV0:	return sizeof(PosNormUVVert);
 	}
-	vb->Unmap();
+	return 0;
 }
 
-void CopyPos(Graphics::VertexBuffer *vb, const Graphics::VertexArray &va)
+// interleave the contents of the VertexArray into dst, which must have room for all of it
+static void CopyVertices(const Graphics::VertexArray &va, Uint8 *dst, const Uint32 stride)
 {
-	PosVert* vtxPtr = vb->Map<PosVert>(Graphics::BUFFER_MAP_WRITE);
-	assert(vb->GetDesc().stride == sizeof(PosVert));
-	for(Uint32 i=0 ; i<va.GetNumVerts() ; i++)
-	{
-		vtxPtr[i].pos	= va.position[i];
+	const Uint32 numVerts = va.GetNumVerts();
+	switch( va.GetAttributeSet() ) {
+	case Graphics::ATTRIB_POSITION: {
+		PosVert* vtxPtr = Dest<PosVert>(dst, stride);
+		for(Uint32 i=0 ; i<numVerts ; i++)
+		{
+			vtxPtr[i].pos	= va.position[i];
+		}
+		break;
 	}
-	vb->Unmap();
-}
-
-void CopyPosColUV0(Graphics::VertexBuffer *vb, const Graphics::VertexArray &va)
-{
-	PosColUVVert* vtxPtr = vb->Map<PosColUVVert>(Graphics::BUFFER_MAP_WRITE);
-	assert(vb->GetDesc().stride == sizeof(PosColUVVert));
-	for(Uint32 i=0 ; i<va.GetNumVerts() ; i++)
-	{
-		vtxPtr[i].pos	= va.position[i];
-		vtxPtr[i].col	= va.diffuse[i];
-		vtxPtr[i].uv	= va.uv0[i];
+	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE: {
+		PosColVert* vtxPtr = Dest<PosColVert>(dst, stride);
+		for(Uint32 i=0 ; i<numVerts ; i++)
+		{
+			vtxPtr[i].pos	= va.position[i];
+			vtxPtr[i].col	= va.diffuse[i];
+		}
+		break;
 	}
-	vb->Unmap();
-}
-
-void CopyPosNormUV0(Graphics::VertexBuffer *vb, const Graphics::VertexArray &va)
-{
-	PosNormUVVert* vtxPtr = vb->Map<PosNormUVVert>(Graphics::BUFFER_MAP_WRITE);
-	assert(vb->GetDesc().stride == sizeof(PosNormUVVert));
-	for(Uint32 i=0 ; i<va.GetNumVerts() ; i++)
-	{
-		vtxPtr[i].pos	= va.position[i];
-		vtxPtr[i].norm	= va.normal[i];
-		vtxPtr[i].uv	= va.uv0[i];
+	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0: {
+		PosUVVert* vtxPtr = Dest<PosUVVert>(dst, stride);
+		for(Uint32 i=0 ; i<numVerts ; i++)
+		{
+			vtxPtr[i].pos	= va.position[i];
+			vtxPtr[i].uv	= va.uv0[i];
+		}
+		break;
+	}
+	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0: {
+		PosColUVVert* vtxPtr = Dest<PosColUVVert>(dst, stride);
+		for(Uint32 i=0 ; i<numVerts ; i++)
+		{
+			vtxPtr[i].pos	= va.position[i];
+			vtxPtr[i].col	= va.diffuse[i];
+			vtxPtr[i].uv	= va.uv0[i];
+		}
+		break;
+	}
+	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL | Graphics::ATTRIB_UV0: {
+		PosNormUVVert* vtxPtr = Dest<PosNormUVVert>(dst, stride);
+		for(Uint32 i=0 ; i<numVerts ; i++)
+		{
+			vtxPtr[i].pos	= va.position[i];
+			vtxPtr[i].norm	= va.normal[i];
+			vtxPtr[i].uv	= va.uv0[i];
+		}
+		break;
+	}
+	default:
+		assert(false);
+		break;
 	}
-	vb->Unmap();
 }
 
 // copies the contents of the VertexArray into the buffer
 bool VertexBuffer::Populate(const VertexArray &va)
 {
 	assert(va.GetNumVerts()>0);
-	bool result = false;
-	const Graphics::AttributeSet as = va.GetAttributeSet();
-	switch( as ) {
-	case Graphics::ATTRIB_POSITION:														CopyPos(this, va);			result = true;	break;
-	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE:							CopyPosCol(this, va);		result = true;	break;
-	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0:								CopyPosUV0(this, va);		result = true;	break;
-	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0:	CopyPosColUV0(this, va);	result = true;	break;
-	case Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL | Graphics::ATTRIB_UV0:	CopyPosNormUV0(this, va);	result = true;	break;
-	}
-	return result;
+	if (GetVertexSize(va.GetAttributeSet()) == 0)
+		return false;
+
+	CopyVertices(va, Map<Uint8>(Graphics::BUFFER_MAP_WRITE), GetDesc().stride);
+	Unmap();
+	return true;
 }
 
-void VertexBuffer::Bind() {
-	glBindVertexArray(m_vao);
+bool VertexBuffer::PopulateRange(const VertexArray &va, Uint32 firstVertex)
+{
+	assert(va.GetNumVerts()>0);
+	assert(firstVertex + va.GetNumVerts() <= m_desc.numVertices);
+	if (GetVertexSize(va.GetAttributeSet()) == 0)
+		return false;
 
-	// Enable the Vertex attributes
-	for (Uint8 i = 0; i < MAX_ATTRIBS; i++) {
-		const auto& attr = m_desc.attrib[i];
-		switch (attr.semantic) {
-		case ATTRIB_POSITION:		glEnableVertexAttribArray(0);		break;
-		case ATTRIB_NORMAL:			glEnableVertexAttribArray(1);		break;
-		case ATTRIB_DIFFUSE:		glEnableVertexAttribArray(2);		break;
-		case ATTRIB_UV0:			glEnableVertexAttribArray(3);		break;
-		case ATTRIB_NONE:
-		default:
-			return;
+	const Uint32 offset = firstVertex * m_desc.stride;
+	const Uint32 size = va.GetNumVerts() * m_desc.stride;
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	if (m_data) {
+		// dynamic buffers keep their copy up to date, then send just the new part
+		CopyVertices(va, m_data + offset, m_desc.stride);
+		glBufferSubData(GL_ARRAY_BUFFER, offset, size, m_data + offset);
+	} else {
+		Uint8 *dst = reinterpret_cast<Uint8*>(glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+		if (!dst) {
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			return false;
 		}
+		CopyVertices(va, dst, m_desc.stride);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
 	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return true;
 }
 
+// the VAO remembers which attributes are enabled, so binding it is all that's needed
+void VertexBuffer::Bind() {
+	BindVertexArray(m_vao);
+}
+
+// left bound, in case the next draw uses this buffer too
 void VertexBuffer::Release() {
-	// Enable the Vertex attributes
-	for (Uint8 i = 0; i < MAX_ATTRIBS; i++) {
-		const auto& attr = m_desc.attrib[i];
-		switch (attr.semantic) {
-		case ATTRIB_POSITION:		glDisableVertexAttribArray(0);			break;
-		case ATTRIB_NORMAL:			glDisableVertexAttribArray(1);			break;
-		case ATTRIB_DIFFUSE:		glDisableVertexAttribArray(2);			break;
-		case ATTRIB_UV0:			glDisableVertexAttribArray(3);			break;
-		case ATTRIB_NONE:
-		default:
-			return;
-		}
+}
+
+// ------------------------------------------------------------
+StreamVertexBuffer::StreamVertexBuffer(const VertexBufferDesc &desc) :
+	m_desc(desc),
+	m_cursor(0)
+{
+	FinaliseDesc(m_desc);
+	assert(m_desc.numVertices > 0);
+
+	glGenVertexArrays(1, &m_vao);
+	BindVertexArray(m_vao);
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	glBufferData(GL_ARRAY_BUFFER, m_desc.numVertices * m_desc.stride, nullptr, GL_STREAM_DRAW);
+
+	SetupAttribPointers(m_desc);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	BindVertexArray(0);
+}
+
+StreamVertexBuffer::~StreamVertexBuffer()
+{
+	glDeleteBuffers(1, &m_buffer);
+	DeleteVertexArray(m_vao);
+}
+
+bool StreamVertexBuffer::Append(const VertexArray &va, Uint32 &first)
+{
+	const Uint32 numVerts = va.GetNumVerts();
+	if (numVerts == 0 || numVerts > m_desc.numVertices)
+		return false;
+	if (GetVertexSize(va.GetAttributeSet()) != m_desc.stride)
+		return false;
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+	// out of room: orphan the storage rather than wait for the GPU to finish with it.
+	// the driver hands us a fresh block and frees the old one once it is no longer used
+	if (m_cursor + numVerts > m_desc.numVertices) {
+		glBufferData(GL_ARRAY_BUFFER, m_desc.numVertices * m_desc.stride, nullptr, GL_STREAM_DRAW);
+		m_cursor = 0;
 	}
 
-	glBindVertexArray(0);
+	// nothing is ever written twice between orphanings, so the map doesn't have to
+	// synchronise with draws still in flight
+	Uint8 *dst = reinterpret_cast<Uint8*>(glMapBufferRange(GL_ARRAY_BUFFER, m_cursor * m_desc.stride, numVerts * m_desc.stride,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	if (!dst) {
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return false;
+	}
+	CopyVertices(va, dst, m_desc.stride);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	first = m_cursor;
+	m_cursor += numVerts;
+	return true;
+}
+
+void StreamVertexBuffer::Bind() {
+	BindVertexArray(m_vao);
+}
+
+void StreamVertexBuffer::Release() {
 }
 
 // ------------------------------------------------------------
-IndexBuffer::IndexBuffer(Uint32 size, BufferUsage hint)
-	: Graphics::IndexBuffer(size, hint)
+IndexBuffer::IndexBuffer(Uint32 size, BufferUsage hint, IndexFormat format)
+	: Graphics::IndexBuffer(size, hint, format)
 {
 	assert(size > 0);
 
 	const GLenum usage = (hint == BUFFER_USAGE_STATIC) ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
+	const Uint32 dataSize = GetIndexSize() * m_size;
 	glGenBuffers(1, &m_buffer);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
-	m_data = new Uint16[size];
-	memset(m_data, 0, sizeof(Uint16) * size);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Uint16) * m_size, m_data, usage);
+	m_data = new Uint8[dataSize];
+	memset(m_data, 0, dataSize);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, dataSize, m_data, usage);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 	//Don't keep client data around for static buffers
@@ -329,7 +460,7 @@ IndexBuffer::~IndexBuffer()
 	delete[] m_data;
 }
 
-Uint16 *IndexBuffer::Map(BufferMapMode mode)
+Uint8 *IndexBuffer::MapInternal(BufferMapMode mode)
 {
 	assert(mode != BUFFER_MAP_NONE); //makes no sense
 	assert(m_mapMode == BUFFER_MAP_NONE); //must not be currently mapped
@@ -337,9 +468,9 @@ Uint16 *IndexBuffer::Map(BufferMapMode mode)
 	if (GetUsage() == BUFFER_USAGE_STATIC) {
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
 		if (mode == BUFFER_MAP_READ)
-			return reinterpret_cast<Uint16*>(glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_READ_ONLY));
+			return reinterpret_cast<Uint8*>(glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_READ_ONLY));
 		else if (mode == BUFFER_MAP_WRITE)
-			return reinterpret_cast<Uint16*>(glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY));
+			return reinterpret_cast<Uint8*>(glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY));
 	}
 
 	return m_data;
@@ -355,7 +486,7 @@ void IndexBuffer::Unmap()
 	} else {
 		if (m_mapMode == BUFFER_MAP_WRITE) {
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
-			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(Uint16) * m_size, m_data);
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, GetIndexSize() * m_size, m_data);
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 		}
 	}
@@ -371,6 +502,15 @@ void IndexBuffer::Release() {
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+GLenum IndexBuffer::GetGLType() const
+{
+	switch (m_format) {
+	case INDEX_FORMAT_UINT8: return GL_UNSIGNED_BYTE;
+	case INDEX_FORMAT_UINT32: return GL_UNSIGNED_INT;
+	default: return GL_UNSIGNED_SHORT;
+	}
+}
+
 // ------------------------------------------------------------
 InstanceBuffer::InstanceBuffer(Uint32 size, BufferUsage hint)
 	: Graphics::InstanceBuffer(size, hint)
@@ -24,6 +24,7 @@ public:
 
 	// copies the contents of the VertexArray into the buffer
 	virtual bool Populate(const VertexArray &) override;
+	virtual bool PopulateRange(const VertexArray &, Uint32 firstVertex) override;
 	
 	virtual void Bind() override;
 	virtual void Release() override;
@@ -36,19 +37,47 @@ private:
 	Uint8 *m_data;
 };
 
+// a vertex buffer that transient geometry is streamed through. each VertexArray
+// is appended after the last, and when the buffer is full its storage is
+// orphaned and filling starts again from the beginning. desc.numVertices is
+// the capacity
+class StreamVertexBuffer : public GLBufferBase {
+public:
+	StreamVertexBuffer(const VertexBufferDesc&);
+	~StreamVertexBuffer();
+
+	const VertexBufferDesc &GetDesc() const { return m_desc; }
+
+	// copies the VertexArray in, answering the first vertex to draw from.
+	// false if it is bigger than the whole buffer or the format isn't supported
+	bool Append(const VertexArray &, Uint32 &first);
+
+	void Bind();
+	void Release();
+
+private:
+	VertexBufferDesc m_desc;
+	GLuint m_vao;
+	Uint32 m_cursor;
+};
+
 class IndexBuffer : public Graphics::IndexBuffer, public GLBufferBase {
 public:
-	IndexBuffer(Uint32 size, BufferUsage);
+	IndexBuffer(Uint32 size, BufferUsage, IndexFormat);
 	~IndexBuffer();
 
-	virtual Uint16 *Map(BufferMapMode) override;
 	virtual void Unmap() override;
 	
 	virtual void Bind() override;
 	virtual void Release() override;
 
+	GLenum GetGLType() const;
+
+protected:
+	virtual Uint8 *MapInternal(BufferMapMode) override;
+
 private:
-	Uint16 *m_data;
+	Uint8 *m_data;
 };
 
 // Instance buffer
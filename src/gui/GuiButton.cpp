@@ -24,6 +24,7 @@ bool Button::OnMouseDown(MouseButtonEvent *e)
 {
 	if (e->button == SDL_BUTTON_LEFT) {
 		m_isPressed = true;
+		Invalidate();
 		onPress.emit();
 		// wait for mouse release, regardless of where on screen
 		_m_release = RawEvents::onMouseUp.connect(sigc::mem_fun(this, &Button::OnRawMouseUp));
@@ -35,6 +36,7 @@ bool Button::OnMouseUp(MouseButtonEvent *e)
 {
 	if ((e->button == SDL_BUTTON_LEFT) && m_isPressed) {
 		m_isPressed = false;
+		Invalidate();
 		_m_release.disconnect();
 		onRelease.emit();
 		onClick.emit();
@@ -46,6 +48,7 @@ void Button::OnActivate()
 {
 	// activated by keyboard shortcut
 	m_isPressed = true;
+	Invalidate();
 	_m_kbrelease = RawEvents::onKeyUp.connect(sigc::mem_fun(this, &Button::OnRawKeyUp));
 	onPress.emit();
 }
@@ -54,6 +57,7 @@ void Button::OnRawKeyUp(SDL_KeyboardEvent *e)
 {
 	if (e->keysym.sym == m_shortcut.sym) {
 		m_isPressed = false;
+		Invalidate();
 		_m_kbrelease.disconnect();
 		onRelease.emit();
 		onClick.emit();
@@ -64,6 +68,7 @@ void Button::OnRawMouseUp(MouseButtonEvent *e)
 {
 	if (e->button == SDL_BUTTON_LEFT) {
 		m_isPressed = false;
+		Invalidate();
 		_m_release.disconnect();
 		onRelease.emit();
 	}
@@ -3,6 +3,8 @@
 
 #include "Gui.h"
 #include "GuiContainer.h"
+#include "graphics/Renderer.h"
+#include "graphics/RenderTarget.h"
 
 #include <SDL_stdinc.h>
 
@@ -11,6 +13,9 @@ namespace Gui {
 Container::Container()
 {
 	m_transparent = true;
+	m_cached = false;
+	m_cacheDirty = true;
+	m_cacheSize[0] = m_cacheSize[1] = 0.0f;
 	SetBgColor(Theme::Colors::bg);
 	onMouseLeave.connect(sigc::mem_fun(this, &Container::_OnMouseLeave));
 	onSetSize.connect(sigc::mem_fun(this, &Container::_OnSetSize));
@@ -109,6 +114,8 @@ void Container::DeleteAllChildren()
 		delete (*i).w;
 	}
 	m_children.clear();
+	InvalidateCache();
+	Invalidate();
 }
 
 void Container::RemoveAllChildren()
@@ -118,6 +125,8 @@ void Container::RemoveAllChildren()
 		i->w->SetParent(0);
 	}
 	m_children.clear();
+	InvalidateCache();
+	Invalidate();
 }
 
 void Container::PrependChild(Widget *child, float x, float y)
@@ -132,6 +141,7 @@ void Container::PrependChild(Widget *child, float x, float y)
 	wp.flags = 0;
 	child->SetParent(this);
 	m_children.push_front(wp);
+	child->Invalidate();
 }
 
 void Container::AppendChild(Widget *child, float x, float y)
@@ -146,15 +156,17 @@ void Container::AppendChild(Widget *child, float x, float y)
 	wp.flags = 0;
 	child->SetParent(this);
 	m_children.push_back(wp);
+	child->Invalidate();
 }
 
 void Container::MoveChild(Widget *child, float x, float y)
 {
 	PROFILE_SCOPED()
 	WidgetList::iterator it = FindChild(child);
-	if (it != m_children.end()) {
+	if (it != m_children.end() && (it->pos[0] != x || it->pos[1] != y)) {
 		it->pos[0] = x;
 		it->pos[1] = y;
+		child->Invalidate();
 	}
 }
 
@@ -163,6 +175,7 @@ void Container::RemoveChild(Widget *child)
 	PROFILE_SCOPED()
 	WidgetList::iterator it = FindChild(child);
 	if (it != m_children.end()) {
+		child->Invalidate();
 		it->w->SetParent(0);
 		m_children.erase(it);
 	}
@@ -188,18 +201,30 @@ void Container::Draw()
 {
 	PROFILE_SCOPED()
 
+	if (m_cached && UpdateCache()) {
+		m_cacheQuad->Draw(Gui::Screen::GetRenderer(), vector2f(0.0f), vector2f(m_cacheSize[0], m_cacheSize[1]),
+			vector2f(0.0f, 1.0f), vector2f(1.0f, -1.0f), Color::WHITE, Gui::Screen::premultBlendState);
+		DrawChildren(DRAW_DYNAMIC);
+	} else
+		DrawChildren(DRAW_ALL);
+}
+
+void Container::DrawChildren(DrawFilter filter)
+{
 	Graphics::Renderer *r = Gui::Screen::GetRenderer();
 	r->SetRenderState(Gui::Screen::alphaBlendState);
 
 	float size[2];
 	GetSize(size);
-	if (!m_transparent) {
+	if (!m_transparent && filter != DRAW_DYNAMIC) {
 		PROFILE_SCOPED_RAW("Container::Draw - !m_transparent")
 		Theme::DrawRect(vector2f(0.f), vector2f(size[0], size[1]), m_bgcol, Screen::alphaBlendState);
 	}
 
 	for (WidgetList::iterator i = m_children.begin(), itEnd = m_children.end(); i != itEnd; ++i) {
 		if (!(*i).w->IsVisible()) continue;
+		if (filter == DRAW_STATIC && (*i).w->IsDynamic()) continue;
+		if (filter == DRAW_DYNAMIC && !(*i).w->IsDynamic()) continue;
 
 		PROFILE_SCOPED_RAW("Container::Draw - Child Loop")
 
@@ -209,6 +234,69 @@ void Container::Draw()
 	}
 }
 
+bool Container::UpdateCache()
+{
+	PROFILE_SCOPED()
+
+	Graphics::Renderer *r = Gui::Screen::GetRenderer();
+
+	float size[2];
+	GetSize(size);
+	const float *scale = Gui::Screen::GetCoords2Pixels();
+	const int width = int(ceilf(size[0] / scale[0]));
+	const int height = int(ceilf(size[1] / scale[1]));
+	if (width <= 0 || height <= 0) return false;
+
+	if (!m_cacheTarget || size[0] != m_cacheSize[0] || size[1] != m_cacheSize[1]) {
+		PROFILE_SCOPED_RAW("Container::UpdateCache - create target")
+		m_cacheQuad.reset();
+		m_cacheTarget.reset(r->CreateRenderTarget(Graphics::RenderTargetDesc(
+			width, height, Graphics::TEXTURE_NONE, Graphics::TEXTURE_NONE, false)));
+		if (!m_cacheTarget) {
+			// renderer can't draw to textures, so just draw directly
+			m_cached = false;
+			return false;
+		}
+		// our own texture rather than the target's, so that uvs are normalised
+		Graphics::Texture *texture = r->CreateTexture(Graphics::TextureDescriptor(
+			Graphics::TEXTURE_RGBA_8888, vector2f(width, height), Graphics::LINEAR_CLAMP, false, false, 0));
+		m_cacheTarget->SetColorTexture(texture);
+		m_cacheQuad.reset(new TexturedQuad(texture));
+		m_cacheSize[0] = size[0];
+		m_cacheSize[1] = size[1];
+		m_cacheDirty = true;
+	}
+
+	if (m_cacheDirty) {
+		PROFILE_SCOPED_RAW("Container::UpdateCache - redraw")
+		// children invalidated while we draw them are drawn anyway
+		m_cacheDirty = false;
+
+		Graphics::RenderTarget *prevTarget = r->GetRenderTarget();
+		Graphics::Renderer::StateTicket ticket(r);
+		r->SetRenderTarget(m_cacheTarget.get());
+		r->SetViewport(0, 0, width, height);
+		r->SetClearColor(Color(0, 0, 0, 0));
+		r->ClearScreen();
+		r->SetOrthographicProjection(0, size[0], size[1], 0, -1, 1);
+		r->SetTransform(matrix4x4f::Identity());
+		DrawChildren(DRAW_STATIC);
+		r->SetRenderTarget(prevTarget);
+	}
+
+	return true;
+}
+
+void Container::SetCached(bool cached)
+{
+	m_cached = cached;
+	m_cacheDirty = true;
+	if (!cached) {
+		m_cacheQuad.reset();
+		m_cacheTarget.reset();
+	}
+}
+
 bool Container::OnMouseDown(MouseButtonEvent *e)
 {
 	return HandleMouseEvent(e);
@@ -271,6 +359,15 @@ void Container::HideAll()
 void Container::SetBgColor(const Color &col)
 {
 	m_bgcol = col;
+	InvalidateCache();
+	Invalidate();
+}
+
+void Container::SetTransparency(bool a)
+{
+	m_transparent = a;
+	InvalidateCache();
+	Invalidate();
 }
 
 }
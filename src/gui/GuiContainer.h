@@ -8,9 +8,12 @@
  */
 
 #include "GuiWidget.h"
+#include "GuiTexturedQuad.h"
 #include <list>
 #include <SDL_stdinc.h>
 
+namespace Graphics { class RenderTarget; }
+
 namespace Gui {
 	class Container: public Widget {
 	public:
@@ -31,17 +34,33 @@ namespace Gui {
 		virtual void HideAll();
 		virtual void OnChildResizeRequest(Widget *) = 0;
 		void SetBgColor(const Color &col);
-		void SetTransparency(bool a) { m_transparent = a; }
+		void SetTransparency(bool a);
 		virtual void UpdateAllChildSizes() = 0;
 		void RemoveChild(Widget *w);
+		/** a cached container draws its background and non-dynamic children
+		 *  into a texture, and redraws that only after one of them has been
+		 *  invalidated. dynamic children are drawn on top of it every frame,
+		 *  so they should not overlap static ones drawn after them.
+		 *  children must not use scissoring, which is in screen coordinates */
+		void SetCached(bool cached);
+		bool IsCached() const { return m_cached; }
+		void InvalidateCache() { m_cacheDirty = true; }
 		// only fired if child widgets do not eat event
 		sigc::signal<void, MouseButtonEvent*> onMouseButtonEvent;
 	private:
 		void _OnMouseLeave();
 		void _OnSetSize();
 		bool HandleMouseEvent(MouseButtonEvent *e);
+		enum DrawFilter { DRAW_ALL, DRAW_STATIC, DRAW_DYNAMIC };
+		void DrawChildren(DrawFilter filter);
+		bool UpdateCache();
 		Color m_bgcol;
 		bool m_transparent;
+		bool m_cached;
+		bool m_cacheDirty;
+		float m_cacheSize[2];
+		std::unique_ptr<Graphics::RenderTarget> m_cacheTarget;
+		std::unique_ptr<TexturedQuad> m_cacheQuad;
 	protected:
 		struct widget_pos {
 			Widget *w;
@@ -43,6 +43,7 @@ void Image::GetSizeRequested(float size[2])
 
 void Image::SetRenderDimensions(const float wide, const float high)
 {
+	if (wide != m_width || high != m_height) Invalidate();
 	m_width = wide;
 	m_height = high;
 }
@@ -15,7 +15,7 @@ namespace Gui {
 		Image(const char *filename, float renderWidth, float renderHeight);
 		virtual void Draw();
 		virtual void GetSizeRequested(float size[2]);
-		void SetModulateColor(const Color &color) { m_color = color; }
+		void SetModulateColor(const Color &color) { if (!(color == m_color)) Invalidate(); m_color = color; }
 		void SetRenderDimensions(const float wide, const float high);
 	private:
 		void InitTexture(const char* filename);
@@ -43,12 +43,12 @@ void Label::RecalcSize()
 
 Label *Label::Color(Uint8 r, Uint8 g, Uint8 b)
 {
-	m_color = ::Color(r, g, b);
-	return this;
+	return Color(::Color(r, g, b));
 }
 
 Label *Label::Color(const ::Color &c)
 {
+	if (!(c == m_color)) Invalidate();
 	m_color = c;
 	return this;
 }
@@ -60,8 +60,11 @@ void Label::SetText(const char *text)
 
 void Label::SetText(const std::string &text)
 {
-	m_text = text;
-	UpdateLayout();
+	if (!m_layout || text != m_text) {
+		m_text = text;
+		UpdateLayout();
+		Invalidate();
+	}
 	RecalcSize();
 }
 
@@ -5,7 +5,12 @@
 
 namespace Gui {
 
-LabelSet::LabelSet() : Widget()
+// labels closer than this on both axes are dropped, so the grid cells are
+// this big and only the neighbouring ones need checking
+static const float LABEL_SPACING = 5.0f;
+
+LabelSet::LabelSet() : Widget(),
+	m_va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0)
 {
 	m_eventMask = EVENT_MOUSEDOWN;
 	m_labelsVisible = true;
@@ -30,23 +35,38 @@ bool LabelSet::OnMouseDown(Gui::MouseButtonEvent *e)
 
 bool LabelSet::CanPutItem(float x, float y)
 {
-	for (std::vector<LabelSetItem>::iterator i = m_items.begin(); i != m_items.end(); ++i) {
-		if ((fabs(x-(*i).screenx) < 5.0f) &&
-		    (fabs(y-(*i).screeny) < 5.0f)) return false;
+	const int cx = int(floor(x / LABEL_SPACING)), cy = int(floor(y / LABEL_SPACING));
+	for (int gy = cy-1; gy <= cy+1; gy++) {
+		for (int gx = cx-1; gx <= cx+1; gx++) {
+			const auto range = m_grid.equal_range(GridKey(gx, gy));
+			for (auto i = range.first; i != range.second; ++i) {
+				const LabelSetItem &item = m_items[i->second];
+				if ((fabs(x-item.screenx) < LABEL_SPACING) &&
+				    (fabs(y-item.screeny) < LABEL_SPACING)) return false;
+			}
+		}
 	}
 	return true;
 }
 
-void LabelSet::Add(std::string text, sigc::slot<void> onClick, float screenx, float screeny)
+void LabelSet::AddToGrid(float x, float y, Uint32 index)
+{
+	const int cx = int(floor(x / LABEL_SPACING)), cy = int(floor(y / LABEL_SPACING));
+	m_grid.insert(std::make_pair(GridKey(cx, cy), index));
+}
+
+void LabelSet::Add(const std::string &text, sigc::slot<void> onClick, float screenx, float screeny)
 {
 	if (CanPutItem(screenx, screeny)) {
+		AddToGrid(screenx, screeny, m_items.size());
 		m_items.push_back(LabelSetItem(text, onClick, screenx, screeny));
 	}
 }
 
-void LabelSet::Add(std::string text, sigc::slot<void> onClick, float screenx, float screeny, const Color &col)
+void LabelSet::Add(const std::string &text, sigc::slot<void> onClick, float screenx, float screeny, const Color &col)
 {
 	if (CanPutItem(screenx, screeny)) {
+		AddToGrid(screenx, screeny, m_items.size());
 		m_items.push_back(LabelSetItem(text, onClick, screenx, screeny, col));
 	}
 }
@@ -54,15 +74,42 @@ void LabelSet::Add(std::string text, sigc::slot<void> onClick, float screenx, fl
 void LabelSet::Clear()
 {
 	m_items.clear();
+	m_grid.clear();
 }
 
 void LabelSet::Draw()
 {
 	PROFILE_SCOPED()
-	if (!m_labelsVisible) return;
-	for (std::vector<LabelSetItem>::iterator i = m_items.begin(); i != m_items.end(); ++i) {
-		Gui::Screen::RenderStringBuffer((*i).m_vb, (*i).text, (*i).screenx, (*i).screeny - Gui::Screen::GetFontHeight()*0.5f, (*i).hasOwnColor ? (*i).color : m_labelColor, m_font.Get());
+	if (!m_labelsVisible || m_items.empty()) return;
+
+	Graphics::Renderer *r = Gui::Screen::GetRenderer();
+	const float *fontScale = Gui::Screen::GetCoords2Pixels();
+	const matrix4x4f &modelMatrix_ = r->GetCurrentModelView();
+	const float xoff = modelMatrix_[12];
+	const float yoff = modelMatrix_[13] - Gui::Screen::GetFontHeight()*0.5f;
+
+	// same pixel snapping as Screen::RenderStringBuffer, but with every label
+	// in the one array
+	m_va.Clear();
+	for (const LabelSetItem &item : m_items) {
+		const float x = floor((xoff + item.screenx) / fontScale[0]);
+		const float y = floor((yoff + item.screeny) / fontScale[1]);
+		m_font->PopulateString(m_va, item.text, x, y, item.hasOwnColor ? item.color : m_labelColor);
 	}
+	if (m_va.GetNumVerts() == 0) return;
+
+	// grow the buffer when needed, and keep it for the frames after
+	if (!m_vb || m_vb->GetDesc().numVertices < m_va.GetNumVerts()) {
+		m_vb.reset(m_font->CreateVertexBuffer(m_va));
+	} else {
+		m_vb->SetVertexCount(m_va.GetNumVerts());
+		m_vb->Populate(m_va);
+	}
+
+	Graphics::Renderer::MatrixTicket ticket(r, Graphics::MatrixMode::MODELVIEW);
+	r->LoadIdentity();
+	r->Scale(fontScale[0], fontScale[1], 1);
+	m_font->RenderBuffer(m_vb.get(), m_labelColor);
 }
 
 void LabelSet::GetSizeRequested(float size[2])
@@ -5,7 +5,11 @@
 #define GUILABELSET_H
 
 #include "GuiWidget.h"
+#include "graphics/VertexArray.h"
+#include "graphics/VertexBuffer.h"
 #include <vector>
+#include <unordered_map>
+#include <memory>
 
 /*
  * Collection of clickable labels. Used by the WorldView for clickable
@@ -16,14 +20,14 @@ class LabelSet: public Widget {
 public:
 	class LabelSetItem {
 	public:
-		LabelSetItem(std::string text_, sigc::slot<void> onClick_, float screenx_, float screeny_) {
+		LabelSetItem(const std::string &text_, sigc::slot<void> onClick_, float screenx_, float screeny_) {
 			this->text = text_;
 			this->onClick = onClick_;
 			this->screenx = screenx_;
 			this->screeny = screeny_;
 			this->hasOwnColor = false;
 		}
-		LabelSetItem(std::string text_, sigc::slot<void> onClick_, float screenx_, float screeny_, const Color &c) {
+		LabelSetItem(const std::string &text_, sigc::slot<void> onClick_, float screenx_, float screeny_, const Color &c) {
 			this->text = text_;
 			this->onClick = onClick_;
 			this->screenx = screenx_;
@@ -36,7 +40,6 @@ public:
 		bool hasOwnColor;
 		sigc::slot<void> onClick;
 		float screenx, screeny;
-		RefCountedPtr<Graphics::VertexBuffer> m_vb;
 	};
 
 	LabelSet();
@@ -44,16 +47,23 @@ public:
 	virtual void Draw();
 	virtual void GetSizeRequested(float size[2]);
 	void Clear();
-	void Add(std::string text, sigc::slot<void> onClick, float screenx, float screeny);
+	void Add(const std::string &text, sigc::slot<void> onClick, float screenx, float screeny);
 	/** Overrides color set by SetLabelColor */
-	void Add(std::string text, sigc::slot<void> onClick, float screenx, float screeny, const Color &col);
+	void Add(const std::string &text, sigc::slot<void> onClick, float screenx, float screeny, const Color &col);
 	void SetLabelsClickable(bool v) { m_labelsClickable = v; }
 	void SetLabelsVisible(bool v) { m_labelsVisible = v; }
 	void SetLabelColor(const Color &c) { m_labelColor = c; }
 private:
 	bool CanPutItem(float x, float y);
+	void AddToGrid(float x, float y, Uint32 index);
+	static Uint32 GridKey(int cx, int cy) { return (Uint32(cx) << 16) ^ Uint32(cy & 0xffff); }
 
 	std::vector<LabelSetItem> m_items;
+	// items by the cell they're in, so placement doesn't check every item
+	std::unordered_multimap<Uint32,Uint32> m_grid;
+	// every label goes in the one buffer, drawn in one go
+	Graphics::VertexArray m_va;
+	std::unique_ptr<Graphics::VertexBuffer> m_vb;
 	bool m_labelsVisible;
 	bool m_labelsClickable;
 	Color m_labelColor;
@@ -18,6 +18,13 @@ MeterBar::MeterBar(float width, const char *label, const ::Color &graphCol)
 	m_label->Show();
 }
 
+void MeterBar::SetValue(float v)
+{
+	v = Clamp(v, 0.0f, 1.0f);
+	if (v != m_barValue) Invalidate();
+	m_barValue = v;
+}
+
 void MeterBar::Draw()
 {
 	PROFILE_SCOPED()
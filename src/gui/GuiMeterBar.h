@@ -17,8 +17,8 @@ namespace Gui {
 		virtual ~MeterBar() {}
 		virtual void Draw();
 		virtual void GetSizeRequested(float size[2]);
-		void SetValue(float v) { m_barValue = Clamp(v,0.0f,1.0f); }
-		void SetColor(const ::Color &c) { m_barColor = c; }
+		void SetValue(float v);
+		void SetColor(const ::Color &c) { if (!(c == m_barColor)) Invalidate(); m_barColor = c; }
 	private:
 		float m_requestedWidth;
 		Gui::Label *m_label;
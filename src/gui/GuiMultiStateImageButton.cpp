@@ -24,6 +24,7 @@ void MultiStateImageButton::StateNext()
 {
 	m_curState++;
 	if (m_curState >= signed(m_states.size())) m_curState = 0;
+	Invalidate();
 	UpdateOverriddenTooltip();
 }
 
@@ -31,6 +32,7 @@ void MultiStateImageButton::StatePrev()
 {
 	m_curState--;
 	if (m_curState < 0) m_curState = signed(m_states.size())-1;
+	Invalidate();
 	UpdateOverriddenTooltip();
 }
 
@@ -40,6 +42,7 @@ void MultiStateImageButton::OnActivate()
 	if (m_isSelected) StateNext();
 	else {
 		m_isSelected = true;
+		Invalidate();
 		onSelect.emit();
 	}
 	onClick.emit(this);
@@ -49,6 +52,7 @@ void MultiStateImageButton::SetActiveState(int state)
 {
 	for (unsigned int i=0; i<m_states.size(); i++) {
 		if (m_states[i].state == state) {
+			if (m_curState != signed(i)) Invalidate();
 			m_curState = i;
 			break;
 		}
@@ -57,6 +61,7 @@ void MultiStateImageButton::SetActiveState(int state)
 
 void MultiStateImageButton::SetSelected(bool state)
 {
+	if (state != m_isSelected) Invalidate();
 	m_isSelected = state;
 }
 
@@ -31,6 +31,7 @@ void RadioButton::OnActivate()
 //	if (!m_pressed) onSelect.emit();
 	onSelect.emit();			// needs to emit even when pressed for time accel buttons
 	m_pressed = true;			// does this break anything?
+	Invalidate();
 }
 void RadioButton::GetSizeRequested(float size[2])
 {
@@ -19,7 +19,7 @@ namespace Gui {
 		virtual void GetSizeRequested(float size[2]);
 		virtual bool OnMouseDown(MouseButtonEvent *e);
 		virtual void OnActivate();
-		virtual void SetSelected(bool state) { m_pressed = state; }
+		virtual void SetSelected(bool state) { if (state != m_pressed) Invalidate(); m_pressed = state; }
 		bool GetSelected() { return m_pressed; }
 	protected:
 		bool m_pressed;
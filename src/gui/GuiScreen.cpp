@@ -28,6 +28,7 @@ RefCountedPtr<Text::TextureFont>Screen::s_defaultFont;
 
 Graphics::Renderer *Screen::s_renderer;
 Graphics::RenderState *Screen::alphaBlendState = nullptr;
+Graphics::RenderState *Screen::premultBlendState = nullptr;
 Graphics::Material *Screen::flatColorMaterial = nullptr;
 
 void Screen::Init(Graphics::Renderer *renderer, int real_width, int real_height, int ui_width, int ui_height)
@@ -56,6 +57,8 @@ void Screen::Init(Graphics::Renderer *renderer, int real_width, int real_height,
 	rsd.blendMode = Graphics::BLEND_ALPHA;
 	rsd.depthWrite = false;
 	alphaBlendState = renderer->CreateRenderState(rsd);
+	rsd.blendMode = Graphics::BLEND_ALPHA_PREMULT;
+	premultBlendState = renderer->CreateRenderState(rsd);
 
 	Graphics::MaterialDescriptor mdesc;
 	flatColorMaterial = renderer->CreateMaterial(mdesc);
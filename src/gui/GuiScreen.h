@@ -64,6 +64,8 @@ namespace Gui {
 		static Graphics::Renderer *GetRenderer() { return s_renderer; }
 
 		static Graphics::RenderState *alphaBlendState;
+		// for drawing textures that were themselves drawn with alphaBlendState
+		static Graphics::RenderState *premultBlendState;
 		static Graphics::Material* flatColorMaterial;
 
 	private:
@@ -46,6 +46,7 @@ void Tabbed::SelectPage(int page)
 {
 	m_page = page;
 	Show();
+	onSelectPage.emit(page);
 }
 
 void Tabbed::OnActivate()
@@ -65,7 +66,6 @@ bool Tabbed::OnMouseDown(MouseButtonEvent *e)
 			csize[0] += 2*LABEL_PADDING;
 			if (e->x - xpos < csize[0]) {
 				SelectPage(index);
-				onSelectPage.emit(index);
 				break;
 			}
 			xpos += csize[0];
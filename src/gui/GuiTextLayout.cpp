@@ -21,6 +21,8 @@ TextLayout::TextLayout(const char *_str, RefCountedPtr<Text::TextureFont> font,
 	strcpy(str, _str);
 
 	m_justify = false;
+	m_prevWidth = -1.0f;
+	m_prevAtlasGeneration = 0;
 	float wordWidth = 0;
 	char *wordstart = str;
 
@@ -101,6 +103,14 @@ void TextLayout::Update(const float width, const Color &color)
 	float fontScale[2];
 	Gui::Screen::GetCoords2Pixels(fontScale);
 
+	const Uint32 atlasGeneration = m_font->GetAtlasGeneration();
+	if (m_vbuffer.Valid() && is_equal_exact(m_prevWidth, width / fontScale[0]) &&
+			m_prevColor == color && m_prevAtlasGeneration == atlasGeneration)
+		return;
+	m_prevWidth = width / fontScale[0];
+	m_prevColor = color;
+	m_prevAtlasGeneration = atlasGeneration;
+
 	Graphics::Renderer *r = Gui::Screen::GetRenderer();
 	Graphics::Renderer::MatrixTicket ticket(r, Graphics::MatrixMode::MODELVIEW);
 	
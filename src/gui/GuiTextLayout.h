@@ -38,6 +38,11 @@ private:
 
 	RefCountedPtr<Text::TextureFont> m_font;
 	RefCountedPtr<Graphics::VertexBuffer> m_vbuffer;
+
+	// what m_vbuffer was built for. the text itself never changes
+	float m_prevWidth;
+	Color m_prevColor;
+	Uint32 m_prevAtlasGeneration;
 };
 }
 
@@ -11,7 +11,7 @@ using namespace Graphics;
 
 namespace Gui {
 
-void TexturedQuad::Draw(Graphics::Renderer *renderer, const vector2f &pos, const vector2f &size, const vector2f &texPos, const vector2f &texSize, const Color &tint)
+void TexturedQuad::Draw(Graphics::Renderer *renderer, const vector2f &pos, const vector2f &size, const vector2f &texPos, const vector2f &texSize, const Color &tint, Graphics::RenderState *state)
 {
 	PROFILE_SCOPED()
 
@@ -57,7 +57,7 @@ void TexturedQuad::Draw(Graphics::Renderer *renderer, const vector2f &pos, const
 		renderer->SetTransform(mv * trans);
 
 		m_material->diffuse = tint;
-		renderer->DrawBuffer(m_vb.Get(), Gui::Screen::alphaBlendState, m_material.get(), TRIANGLE_STRIP);
+		renderer->DrawBuffer(m_vb.Get(), state ? state : Gui::Screen::alphaBlendState, m_material.get(), TRIANGLE_STRIP);
 	}
 }
 
@@ -12,6 +12,7 @@
 namespace Graphics {
 	class Renderer;
 	class Material;
+	class RenderState;
 	class VertexBuffer;
 }
 
@@ -27,7 +28,8 @@ public:
 	virtual void Draw(Graphics::Renderer *r) { Draw(r, vector2f(0.0f), vector2f(1.0f)); }
 	void Draw(Graphics::Renderer *r, const Color &tint) { Draw(r, vector2f(0.0f), vector2f(1.0f), tint); }
 	void Draw(Graphics::Renderer *r, const vector2f &pos, const vector2f &size, const Color &tint = Color::WHITE) { Draw(r, pos, size, vector2f(0.0f), m_texture->GetDescriptor().texSize, tint); }
-	void Draw(Graphics::Renderer *r, const vector2f &pos, const vector2f &size, const vector2f &texPos, const vector2f &texSize, const Color &tint = Color::WHITE);
+	// the uvs are fixed by the first call. state defaults to Screen::alphaBlendState
+	void Draw(Graphics::Renderer *r, const vector2f &pos, const vector2f &size, const vector2f &texPos, const vector2f &texSize, const Color &tint = Color::WHITE, Graphics::RenderState *state = nullptr);
 
 	const Graphics::Texture* GetTexture() const { return m_texture.Get(); }
 private:
@@ -17,6 +17,7 @@ bool ToggleButton::OnMouseDown(MouseButtonEvent *e)
 	if (e->button == SDL_BUTTON_LEFT) {
 		onPress.emit();
 		m_pressed = !m_pressed;
+		Invalidate();
 		if (m_pressed) {
 			onChange.emit(this, true);
 		} else {
@@ -29,6 +30,7 @@ bool ToggleButton::OnMouseDown(MouseButtonEvent *e)
 void ToggleButton::OnActivate()
 {
 	m_pressed = !m_pressed;
+	Invalidate();
 	if (m_pressed) {
 		onChange.emit(this, true);
 	} else {
@@ -16,7 +16,7 @@ namespace Gui {
 		virtual void GetSizeRequested(float size[2]);
 		virtual bool OnMouseDown(MouseButtonEvent *e);
 		virtual void OnActivate();
-		void SetPressed(bool s) { m_pressed = s; }
+		void SetPressed(bool s) { if (s != m_pressed) Invalidate(); m_pressed = s; }
 		bool GetPressed() { return m_pressed != 0; }
 
 		sigc::signal<void, ToggleButton *, bool> onChange;
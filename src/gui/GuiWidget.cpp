@@ -11,6 +11,7 @@ Widget::Widget()
 	m_parent = 0;
 	m_size.w = m_size.h = 0.0f;
 	m_enabled = true;
+	m_dynamic = false;
 	m_visible = false;
 	m_mouseOver = false;
 	m_eventMask = EVENT_MOUSEMOTION;
@@ -36,6 +37,32 @@ bool Widget::IsVisible() const
 		return false;
 }
 
+void Widget::SetSize(float w, float h)
+{
+	if (w != m_size.w || h != m_size.h) Invalidate();
+	m_size.w = w;
+	m_size.h = h;
+	onSetSize.emit();
+}
+
+void Widget::SetEnabled(bool v)
+{
+	if (v != m_enabled) Invalidate();
+	m_enabled = v;
+}
+
+void Widget::Invalidate()
+{
+	// every cached container this widget is drawn into has to redraw. a
+	// dynamic widget is not drawn into the cache of its own parent, but is
+	// part of whatever the parent itself is drawn into
+	const Widget *child = this;
+	for (Container *parent = m_parent; parent; parent = parent->m_parent) {
+		if (!child->m_dynamic) parent->InvalidateCache();
+		child = parent;
+	}
+}
+
 void Widget::SetScissor(bool enabled)
 {
 	if (enabled) {
@@ -143,8 +170,15 @@ void Widget::OnToolTip()
 	}
 }
 
+void Widget::Show()
+{
+	if (!m_visible) Invalidate();
+	m_visible = true;
+}
+
 void Widget::Hide()
 {
+	if (m_visible) Invalidate();
 	m_visible = false;
 	HideTooltip();
 	assert(!m_tooltipWidget);
@@ -22,16 +22,16 @@ namespace Gui {
 		virtual void GetMinimumSize(float size[2]) { GetSizeRequested(size); }
 		void GetAbsolutePosition(float pos[2]) const;
 		void GetSize(float size[2]) { size[0] = m_size.w; size[1] = m_size.h; }
-		void SetSize(float w, float h) { m_size.w = w; m_size.h = h; onSetSize.emit(); }
+		void SetSize(float w, float h);
 		void ResizeRequest();
 		void SetShortcut(SDL_Keycode key, SDL_Keymod mod);
 		void SetScissor(bool enabled);
 		bool GetEnabled() { return m_enabled; }
-		void SetEnabled(bool v) { m_enabled = v; }
+		void SetEnabled(bool v);
 		virtual void GrabFocus();
 		bool IsFocused();
-		virtual void ShowAll() { m_visible = true; }
-		virtual void Show() { m_visible = true; }
+		virtual void ShowAll() { Widget::Show(); }
+		virtual void Show();
 		virtual void Hide();
 		void HideTooltip();
 		bool IsVisible() const;
@@ -39,6 +39,12 @@ namespace Gui {
 		void SetParent(Container *p) { m_parent = p; }
 		void SetToolTip(std::string s) { m_tooltip = s; }
 		const std::string &GetToolTip() const { return m_tooltip; }
+		/** dynamic widgets change every frame, so a cached container draws
+		 *  them over its cache instead of into it (see Container::SetCached) */
+		void SetDynamic(bool dynamic) { m_dynamic = dynamic; }
+		bool IsDynamic() const { return m_dynamic; }
+		// call when the widget looks different, so that cached containers redraw it
+		void Invalidate();
 
 		// event handlers should return false to stop propagating event
 		virtual bool OnMouseDown(MouseButtonEvent *e) { return true; }
@@ -83,6 +89,7 @@ namespace Gui {
 		bool m_visible;
 		bool m_mouseOver;
 		bool m_enabled;
+		bool m_dynamic;
 		Container *m_parent;
 		std::string m_tooltip;
 		sigc::connection m_tooltipTimerConnection;
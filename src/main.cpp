@@ -3,7 +3,12 @@
 
 #include "libs.h"
 #include "Pi.h"
+#include "ModelBenchmark.h"
 #include "ModelViewer.h"
+#include "RenderBenchmark.h"
+#include "SessionRecording.h"
+#include "SimBenchmark.h"
+#include "TerrainBenchmark.h"
 #include "Game.h"
 #include "galaxy/GalaxyGenerator.h"
 #include "galaxy/Galaxy.h"
@@ -14,7 +19,13 @@
 enum RunMode {
 	MODE_GAME,
 	MODE_MODELVIEWER,
+	MODE_MODELBENCH,
 	MODE_GALAXYDUMP,
+	MODE_GALAXYBENCH,
+	MODE_SIMBENCH,
+	MODE_TERRAINBENCH,
+	MODE_RENDERBENCH,
+	MODE_REPLAY,
 	MODE_VERSION,
 	MODE_USAGE,
 	MODE_USAGE_ERROR
@@ -47,11 +58,41 @@ int main(int argc, char** argv)
 			goto start;
 		}
 
+		if (modeopt == "modelbench" || modeopt == "mb") {
+			mode = MODE_MODELBENCH;
+			goto start;
+		}
+
 		if (modeopt == "galaxydump" || modeopt == "gd") {
 			mode = MODE_GALAXYDUMP;
 			goto start;
 		}
 
+		if (modeopt == "galaxybench" || modeopt == "gb") {
+			mode = MODE_GALAXYBENCH;
+			goto start;
+		}
+
+		if (modeopt == "simbench" || modeopt == "sb") {
+			mode = MODE_SIMBENCH;
+			goto start;
+		}
+
+		if (modeopt == "terrainbench" || modeopt == "tb") {
+			mode = MODE_TERRAINBENCH;
+			goto start;
+		}
+
+		if (modeopt == "renderbench" || modeopt == "rb") {
+			mode = MODE_RENDERBENCH;
+			goto start;
+		}
+
+		if (modeopt == "replay" || modeopt == "rp") {
+			mode = MODE_REPLAY;
+			goto start;
+		}
+
 		if (modeopt == "version" || modeopt == "v") {
 			mode = MODE_VERSION;
 			goto start;
@@ -71,6 +112,11 @@ start:
 	long int radius = 4;
 	long int sx = 0, sy = 0, sz = 0;
 	std::string filename;
+	long int ticks = 1000, seed = 0;
+	long int points = 100000, patches = 256;
+	long int size = 8, threads = 0;
+	long int replays = 100, frames = 100;
+	bool realtime = false;
 	switch (mode) {
 		case MODE_GALAXYDUMP: {
 			if (argc < 3) {
@@ -109,6 +155,150 @@ start:
 			}
 			// fallthrough
 		}
+		case MODE_GALAXYBENCH: {
+			if (mode == MODE_GALAXYBENCH) {
+				if (argc > pos) { // edge of the sector cube (optional)
+					char* end = nullptr;
+					size = std::strtol(argv[pos], &end, 0);
+					if (end == nullptr || *end != 0 || size <= 0 || size > 1000) {
+						Output("pioneer: invalid size: %s\n", argv[pos]);
+						break;
+					}
+					++pos;
+				}
+				if (argc > pos) { // center of the cube (three comma separated coordinates, optional)
+					char* end = nullptr;
+					sx = std::strtol(argv[pos], &end, 0);
+					if (end == nullptr || *end != ',' || sx < -10000 || sx > 10000) {
+						Output("pioneer: invalid center: %s\n", argv[pos]);
+						break;
+					}
+					sy = std::strtol(end + 1, &end, 0);
+					if (end == nullptr || *end != ',' || sy < -10000 || sy > 10000) {
+						Output("pioneer: invalid center: %s\n", argv[pos]);
+						break;
+					}
+					sz = std::strtol(end + 1, &end, 0);
+					if (end == nullptr || *end != 0 || sz < -10000 || sz > 10000) {
+						Output("pioneer: invalid center: %s\n", argv[pos]);
+						break;
+					}
+					++pos;
+				}
+				if (argc > pos) { // worker threads (optional, 0 for the configured number)
+					char* end = nullptr;
+					threads = std::strtol(argv[pos], &end, 0);
+					if (end == nullptr || *end != 0 || threads < 0 || threads > 256) {
+						Output("pioneer: invalid thread count: %s\n", argv[pos]);
+						break;
+					}
+					++pos;
+				}
+			}
+			// fallthrough
+		}
+		case MODE_SIMBENCH: {
+			if (mode == MODE_SIMBENCH) {
+				if (argc < 3) {
+					Output("pioneer: simulation benchmark requires a save file or system body path\n");
+					break;
+				}
+				filename = argv[pos];
+				++pos;
+				if (argc > pos) { // number of ticks (optional)
+					char* end = nullptr;
+					ticks = std::strtol(argv[pos], &end, 0);
+					if (end == nullptr || *end != 0 || ticks <= 0) {
+						Output("pioneer: invalid tick count: %s\n", argv[pos]);
+						break;
+					}
+					++pos;
+				}
+				if (argc > pos) { // rng seed (optional)
+					char* end = nullptr;
+					seed = std::strtol(argv[pos], &end, 0);
+					if (end == nullptr || *end != 0 || seed < 0) {
+						Output("pioneer: invalid seed: %s\n", argv[pos]);
+						break;
+					}
+					++pos;
+				}
+			}
+			// fallthrough
+		}
+		case MODE_TERRAINBENCH: {
+			if (mode == MODE_TERRAINBENCH) {
+				if (argc < 3) {
+					Output("pioneer: terrain benchmark requires a filename\n");
+					break;
+				}
+				filename = argv[pos];
+				++pos;
+				if (argc > pos) { // number of height/colour points (optional)
+					char* end = nullptr;
+					points = std::strtol(argv[pos], &end, 0);
+					if (end == nullptr || *end != 0 || points <= 0) {
+						Output("pioneer: invalid point count: %s\n", argv[pos]);
+						break;
+					}
+					++pos;
+				}
+				if (argc > pos) { // number of patches (optional)
+					char* end = nullptr;
+					patches = std::strtol(argv[pos], &end, 0);
+					if (end == nullptr || *end != 0 || patches <= 0) {
+						Output("pioneer: invalid patch count: %s\n", argv[pos]);
+						break;
+					}
+					++pos;
+				}
+			}
+			// fallthrough
+		}
+		case MODE_RENDERBENCH: {
+			if (mode == MODE_RENDERBENCH) {
+				if (argc < 3) {
+					Output("pioneer: renderer benchmark requires a save file or system body path\n");
+					break;
+				}
+				filename = argv[pos];
+				++pos;
+				if (argc > pos) { // number of replays (optional)
+					char* end = nullptr;
+					replays = std::strtol(argv[pos], &end, 0);
+					if (end == nullptr || *end != 0 || replays <= 0) {
+						Output("pioneer: invalid replay count: %s\n", argv[pos]);
+						break;
+					}
+					++pos;
+				}
+				if (argc > pos) { // frames to run before the capture (optional)
+					char* end = nullptr;
+					frames = std::strtol(argv[pos], &end, 0);
+					if (end == nullptr || *end != 0 || frames < 0) {
+						Output("pioneer: invalid frame count: %s\n", argv[pos]);
+						break;
+					}
+					++pos;
+				}
+			}
+			// fallthrough
+		}
+		case MODE_REPLAY: {
+			if (mode == MODE_REPLAY) {
+				if (argc < 3) {
+					Output("pioneer: replay requires a recording\n");
+					break;
+				}
+				filename = argv[pos];
+				++pos;
+				if (argc > pos && std::string(argv[pos]) == "realtime") { // at the recorded pace (optional)
+					realtime = true;
+					++pos;
+				}
+			}
+			// fallthrough
+		}
 		case MODE_GAME: {
 			std::map<std::string,std::string> options;
 			if (argc > pos) {
@@ -125,9 +315,36 @@ start:
 					options[key] = val;
 				}
 			}
-			Pi::Init(options, mode == MODE_GALAXYDUMP);
+			if (threads > 0)
+				options["WorkerThreads"] = std::to_string(threads);
+			Pi::Init(options, mode == MODE_GALAXYDUMP, mode == MODE_SIMBENCH || mode == MODE_TERRAINBENCH || mode == MODE_GALAXYBENCH);
 			if (mode == MODE_GAME)
 				for (;;) Pi::Start();
+			else if (mode == MODE_SIMBENCH) {
+				if (!SimBenchmark::Run(filename, Uint32(ticks), Uint32(seed)))
+					Output("pioneer: couldn't start \"%s\"\n", filename.c_str());
+				Pi::Quit();
+			}
+			else if (mode == MODE_RENDERBENCH) {
+				if (!RenderBenchmark::Run(filename, Uint32(replays), Uint32(frames)))
+					Output("pioneer: couldn't start \"%s\"\n", filename.c_str());
+				Pi::Quit();
+			}
+			else if (mode == MODE_REPLAY) {
+				if (!SessionRecording::Replay(filename, realtime))
+					Output("pioneer: couldn't replay \"%s\"\n", filename.c_str());
+				Pi::Quit();
+			}
+			else if (mode == MODE_TERRAINBENCH) {
+				if (!TerrainBenchmark::Run(filename, Uint32(points), Uint32(patches)))
+					Output("pioneer: writing to \"%s\" failed: %s\n", filename.c_str(), strerror(errno));
+				Pi::Quit();
+			}
+			else if (mode == MODE_GALAXYBENCH) {
+				RefCountedPtr<Galaxy> galaxy = GalaxyGenerator::Create();
+				galaxy->Benchmark(sx, sy, sz, size);
+				Pi::Quit();
+			}
 			else if (mode == MODE_GALAXYDUMP) {
 				FILE* file = filename == "-" ? stdout : fopen(filename.c_str(), "w");
 				if (file == nullptr) {
@@ -152,6 +369,26 @@ start:
 			break;
 		}
 
+		case MODE_MODELBENCH: {
+			if (argc < 3) {
+				Output("pioneer: model benchmark requires a filename\n");
+				break;
+			}
+			filename = argv[pos];
+			++pos;
+			if (argc > pos) { // frames drawn at each detail level (optional)
+				char* end = nullptr;
+				frames = std::strtol(argv[pos], &end, 0);
+				if (end == nullptr || *end != 0 || frames <= 0) {
+					Output("pioneer: invalid frame count: %s\n", argv[pos]);
+					break;
+				}
+			}
+			if (!ModelBenchmark::Run(filename, Uint32(frames)))
+				Output("pioneer: writing to \"%s\" failed: %s\n", filename.c_str(), strerror(errno));
+			break;
+		}
+
 		case MODE_VERSION: {
 			std::string version(PIONEER_VERSION);
 			if (strlen(PIONEER_EXTRAVERSION)) version += " (" PIONEER_EXTRAVERSION ")";
@@ -169,7 +406,19 @@ start:
 				"available modes:\n"
 				"    -game        [-g]     game (default)\n"
 				"    -modelviewer [-mv]    model viewer\n"
+				"    -modelbench  [-mb]    model loading and drawing benchmark:\n"
+				"                          <output|-> [frames]\n"
 				"    -galaxydump  [-gd]    galaxy dumper\n"
+				"    -galaxybench [-gb]    galaxy generation benchmark:\n"
+				"                          [size] [x,y,z] [threads]\n"
+				"    -simbench    [-sb]    headless simulation benchmark:\n"
+				"                          <save|x,y,z,system,body> [ticks] [seed]\n"
+				"    -terrainbench [-tb]   terrain generation benchmark:\n"
+				"                          <output|-> [points] [patches]\n"
+				"    -renderbench [-rb]    renderer frame replay benchmark:\n"
+				"                          <save|x,y,z,system,body> [replays] [frames]\n"
+				"    -replay      [-rp]    play back a recorded session (ctrl+r in game):\n"
+				"                          <recording> [realtime]\n"
 				"    -version     [-v]     show version\n"
 				"    -help        [-h,-?]  this help\n"
 			);
@@ -9,6 +9,11 @@
 #include "vector3.h"
 #include "matrix3x3.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATRIX4X4_SSE2 1
+#include <emmintrin.h>
+#endif
+
 template <typename T>
 class matrix4x4 {
 	private:
@@ -282,25 +287,7 @@ class matrix4x4 {
 	}
 	friend matrix4x4 operator* (const matrix4x4 &a, const matrix4x4 &b) {
 		matrix4x4 m;
-		m.cell[0] = a.cell[0]*b.cell[0] + a.cell[4]*b.cell[1] + a.cell[8]*b.cell[2] + a.cell[12]*b.cell[3];
-		m.cell[1] = a.cell[1]*b.cell[0] + a.cell[5]*b.cell[1] + a.cell[9]*b.cell[2] + a.cell[13]*b.cell[3];
-		m.cell[2] = a.cell[2]*b.cell[0] + a.cell[6]*b.cell[1] + a.cell[10]*b.cell[2] + a.cell[14]*b.cell[3];
-		m.cell[3] = a.cell[3]*b.cell[0] + a.cell[7]*b.cell[1] + a.cell[11]*b.cell[2] + a.cell[15]*b.cell[3];
-
-		m.cell[4] = a.cell[0]*b.cell[4] + a.cell[4]*b.cell[5] + a.cell[8]*b.cell[6] + a.cell[12]*b.cell[7];
-		m.cell[5] = a.cell[1]*b.cell[4] + a.cell[5]*b.cell[5] + a.cell[9]*b.cell[6] + a.cell[13]*b.cell[7];
-		m.cell[6] = a.cell[2]*b.cell[4] + a.cell[6]*b.cell[5] + a.cell[10]*b.cell[6] + a.cell[14]*b.cell[7];
-		m.cell[7] = a.cell[3]*b.cell[4] + a.cell[7]*b.cell[5] + a.cell[11]*b.cell[6] + a.cell[15]*b.cell[7];
-
-		m.cell[8] = a.cell[0]*b.cell[8] + a.cell[4]*b.cell[9] + a.cell[8]*b.cell[10] + a.cell[12]*b.cell[11];
-		m.cell[9] = a.cell[1]*b.cell[8] + a.cell[5]*b.cell[9] + a.cell[9]*b.cell[10] + a.cell[13]*b.cell[11];
-		m.cell[10] = a.cell[2]*b.cell[8] + a.cell[6]*b.cell[9] + a.cell[10]*b.cell[10] + a.cell[14]*b.cell[11];
-		m.cell[11] = a.cell[3]*b.cell[8] + a.cell[7]*b.cell[9] + a.cell[11]*b.cell[10] + a.cell[15]*b.cell[11];
-
-		m.cell[12] = a.cell[0]*b.cell[12] + a.cell[4]*b.cell[13] + a.cell[8]*b.cell[14] + a.cell[12]*b.cell[15];
-		m.cell[13] = a.cell[1]*b.cell[12] + a.cell[5]*b.cell[13] + a.cell[9]*b.cell[14] + a.cell[13]*b.cell[15];
-		m.cell[14] = a.cell[2]*b.cell[12] + a.cell[6]*b.cell[13] + a.cell[10]*b.cell[14] + a.cell[14]*b.cell[15];
-		m.cell[15] = a.cell[3]*b.cell[12] + a.cell[7]*b.cell[13] + a.cell[11]*b.cell[14] + a.cell[15]*b.cell[15];
+		Multiply(m.cell, a.cell, b.cell);
 		return m;
 	}
 	friend vector3<T> operator * (const matrix4x4 &a, const vector3<T> &v) {
@@ -333,6 +320,10 @@ class matrix4x4 {
 		out.z = cell[2]*v.x + cell[6]*v.y + cell[10]*v.z;
 		return out;
 	}
+	// in and out may be the same array
+	void TransformPoints(const vector3<T> *in, vector3<T> *out, size_t count) const {
+		Transform(out, in, count, cell);
+	}
 	//gltranslate equivalent
 	void Translate(const vector3<T> &t) {
 		Translate(t.x, t.y, t.z);
@@ -396,6 +387,65 @@ class matrix4x4 {
 	vector3<T> Back() const {
 		return vector3<T>(cell[2], cell[6], cell[10]);
 	}
+
+	private:
+	// m = a * b, m is neither a nor b
+	template <typename U>
+	static void Multiply(U *m, const U *a, const U *b) {
+		for (int j = 0; j < 16; j += 4) {
+			m[j+0] = a[0]*b[j+0] + a[4]*b[j+1] + a[8]*b[j+2] + a[12]*b[j+3];
+			m[j+1] = a[1]*b[j+0] + a[5]*b[j+1] + a[9]*b[j+2] + a[13]*b[j+3];
+			m[j+2] = a[2]*b[j+0] + a[6]*b[j+1] + a[10]*b[j+2] + a[14]*b[j+3];
+			m[j+3] = a[3]*b[j+0] + a[7]*b[j+1] + a[11]*b[j+2] + a[15]*b[j+3];
+		}
+	}
+	template <typename U>
+	static void Transform(vector3<U> *out, const vector3<U> *in, size_t count, const U *c) {
+		for (size_t i = 0; i < count; i++) {
+			const U x = in[i].x, y = in[i].y, z = in[i].z;
+			out[i].x = c[0]*x + c[4]*y + c[8]*z + c[12];
+			out[i].y = c[1]*x + c[5]*y + c[9]*z + c[13];
+			out[i].z = c[2]*x + c[6]*y + c[10]*z + c[14];
+		}
+	}
+#ifdef MATRIX4X4_SSE2
+	// each column of the result is the columns of a weighted by a column of b.
+	// the cells aren't aligned, so everything goes through unaligned loads
+	static void Multiply(float *m, const float *a, const float *b) {
+		const __m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a+4), a2 = _mm_loadu_ps(a+8), a3 = _mm_loadu_ps(a+12);
+		for (int j = 0; j < 16; j += 4) {
+			__m128 r = _mm_mul_ps(a0, _mm_set1_ps(b[j+0]));
+			r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b[j+1])));
+			r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b[j+2])));
+			r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b[j+3])));
+			_mm_storeu_ps(m+j, r);
+		}
+	}
+	// the same with each column in two halves
+	static void Multiply(double *m, const double *a, const double *b) {
+		for (int h = 0; h < 4; h += 2) {
+			const __m128d a0 = _mm_loadu_pd(a+h), a1 = _mm_loadu_pd(a+4+h), a2 = _mm_loadu_pd(a+8+h), a3 = _mm_loadu_pd(a+12+h);
+			for (int j = 0; j < 16; j += 4) {
+				__m128d r = _mm_mul_pd(a0, _mm_set1_pd(b[j+0]));
+				r = _mm_add_pd(r, _mm_mul_pd(a1, _mm_set1_pd(b[j+1])));
+				r = _mm_add_pd(r, _mm_mul_pd(a2, _mm_set1_pd(b[j+2])));
+				r = _mm_add_pd(r, _mm_mul_pd(a3, _mm_set1_pd(b[j+3])));
+				_mm_storeu_pd(m+j+h, r);
+			}
+		}
+	}
+	static void Transform(vector3<float> *out, const vector3<float> *in, size_t count, const float *c) {
+		const __m128 c0 = _mm_loadu_ps(c), c1 = _mm_loadu_ps(c+4), c2 = _mm_loadu_ps(c+8), c3 = _mm_loadu_ps(c+12);
+		for (size_t i = 0; i < count; i++) {
+			__m128 r = _mm_add_ps(c3, _mm_mul_ps(c0, _mm_set1_ps(in[i].x)));
+			r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(in[i].y)));
+			r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(in[i].z)));
+			float res[4];
+			_mm_storeu_ps(res, r);
+			out[i] = vector3<float>(res[0], res[1], res[2]);
+		}
+	}
+#endif
 };
 
 typedef matrix4x4<float> matrix4x4f;
@@ -16,6 +16,7 @@
 #include "graphics/Renderer.h"
 #include "graphics/Texture.h"
 #include "graphics/TextureBuilder.h"
+#include "graphics/TextureCooker.h"
 #include "graphics/Drawables.h"
 #include "graphics/VertexArray.h"
 #include "scenegraph/DumpVisitor.h"
@@ -24,6 +25,9 @@
 #include "OS.h"
 #include "StringF.h"
 #include "ModManager.h"
+#include "SDL_thread.h"
+#include <atomic>
+#include <functional>
 #include <sstream>
 
 std::unique_ptr<GameConfig> s_config;
@@ -61,7 +65,33 @@ void SetupRenderer()
 	s_renderer.reset(Graphics::Init(videoSettings));
 }
 
-void RunCompiler(const std::string &modelName, const std::string &filepath, const bool bInPlace)
+// comma separated fractions of the triangles to keep, eg. "0.3,0.1"
+static std::vector<float> ParseLodRatios(const std::string &list)
+{
+	std::vector<float> ratios;
+	std::istringstream ss(list);
+	std::string item;
+	while (std::getline(ss, item, ','))
+		if (!item.empty()) ratios.push_back(float(atof(item.c_str())));
+	return ratios;
+}
+
+struct CompilerOptions {
+	std::vector<float> lodRatios;
+	bool compressed;
+	bool inPlace;
+};
+
+static CompilerOptions GetCompilerOptions(const bool bInPlace)
+{
+	CompilerOptions opts;
+	opts.lodRatios = ParseLodRatios(s_config->String("AutoLodRatios"));
+	opts.compressed = s_config->Int("CompressSGM") != 0;
+	opts.inPlace = bInPlace;
+	return opts;
+}
+
+bool RunCompiler(Graphics::Renderer *renderer, const std::string &modelName, const std::string &filepath, const CompilerOptions &opts)
 {
 	Profiler::Timer timer;
 	timer.Start();
@@ -71,29 +101,224 @@ void RunCompiler(const std::string &modelName, const std::string &filepath, cons
 	//and then save it into binary
 	std::unique_ptr<SceneGraph::Model> model;
 	try {
-		SceneGraph::Loader ld(s_renderer.get(), false, false);
+		SceneGraph::Loader ld(renderer, false, false);
+		ld.SetOptimiseMeshes(true);
+		ld.SetGeneratedLods(opts.lodRatios);
 		model.reset(ld.LoadModel(modelName));
+		const SceneGraph::MeshOptimiser::Stats &stats = ld.GetMeshStats();
+		Output("%s: meshes: %u -> %u vertices, %u -> %u triangles in %u clusters, ACMR %.3f -> %.3f\n", modelName.c_str(),
+			stats.verticesIn, stats.verticesOut, stats.trianglesIn, stats.trianglesOut, stats.clusters,
+			stats.GetACMRIn(), stats.GetACMROut());
 	} catch (...) {
 		//minimal error handling, this is not expected to happen since we got this far.
-		return;
+		return false;
 	}
 
 	try {
 		const std::string DataPath = FileSystem::NormalisePath(filepath.substr(0, filepath.size()-6));
-		SceneGraph::BinaryConverter bc(s_renderer.get());
-		bc.Save(modelName, DataPath, model.get(), bInPlace);
+		SceneGraph::BinaryConverter bc(renderer);
+		bc.SetCompressed(opts.compressed);
+		bc.Save(modelName, DataPath, model.get(), opts.inPlace);
 	} catch (const CouldNotOpenFileException&) {
+		return false;
 	} catch (const CouldNotWriteToFileException&) {
+		return false;
 	}
 
 	timer.Stop();
 	Output("Compiling \"%s\" took: %lf\n", modelName.c_str(), timer.millicycles());
+	return true;
 }
 
+// the newest file next to the .model, which is where its meshes and most of
+// its textures live. textures shared from elsewhere aren't seen, use force
+// after changing those
+static Time::DateTime GetSourceTime(const std::string &filepath)
+{
+	Time::DateTime newest;
+	const std::string dir = filepath.substr(0, filepath.rfind('/'));
+	for (FileSystem::FileEnumerator files(FileSystem::gameDataFiles, dir); !files.Finished(); files.Next()) {
+		const Time::DateTime t = files.Current().GetModificationTime();
+		if (t > newest)
+			newest = t;
+	}
+	return newest;
+}
+
+// true if the .sgm is there and newer than everything it was made from.
+// the paths are the ones BinaryConverter::Save writes to
+static bool IsUpToDate(const std::string &filepath, const bool bInPlace)
+{
+	const std::string sgmPath = FileSystem::NormalisePath(filepath.substr(0, filepath.size()-6)) + ".sgm";
+	const FileSystem::FileInfo out = bInPlace ?
+		FileSystem::FileSourceFS(FileSystem::GetDataDir()).Lookup(sgmPath) :
+		FileSystem::userFiles.Lookup(FileSystem::JoinPathBelow("binarymodels", sgmPath));
+	return out.IsFile() && out.GetModificationTime() > GetSourceTime(filepath);
+}
+
+struct BatchModel {
+	std::string name;
+	std::string path;
+	bool failed;
+	double ms;
+};
+
+struct ParallelState {
+	const std::function<void(size_t, Graphics::Renderer*)> *fn;
+	size_t count;
+	std::atomic<size_t> next;
+};
+
+// each worker gets its own renderer, the texture cache lives there and
+// isn't safe to share. everything else the loader, converter and cooker
+// touch is per item or read only
+static int ParallelWorker(void *data)
+{
+	ParallelState *state = static_cast<ParallelState*>(data);
+	Graphics::RendererDummy renderer;
+	for (;;) {
+		const size_t i = state->next++;
+		if (i >= state->count)
+			break;
+		(*state->fn)(i, &renderer);
+	}
+	return 0;
+}
+
+static int GetNumWorkers(size_t count)
+{
+	int numThreads = s_config->Int("WorkerThreads");
+	if (numThreads <= 0)
+		numThreads = OS::GetNumCores();
+	return Clamp(numThreads, 1, std::max(int(count), 1));
+}
+
+// fn(i, renderer) for every i below count, over GetNumWorkers threads
+static void ParallelForEach(size_t count, const std::function<void(size_t, Graphics::Renderer*)> &fn)
+{
+	ParallelState state;
+	state.fn = &fn;
+	state.count = count;
+	state.next = 0;
+
+	std::vector<SDL_Thread*> threads;
+	for (int i = 1; i < GetNumWorkers(count); i++)
+		threads.push_back(SDL_CreateThread(ParallelWorker, "ModelCompiler", &state));
+	ParallelWorker(&state);
+	for (SDL_Thread *t : threads)
+		SDL_WaitThread(t, nullptr);
+}
+
+static void RunBatch(std::vector<BatchModel> &models, const CompilerOptions &opts, const bool force)
+{
+	const Uint32 batchStart = SDL_GetTicks();
+
+	std::vector<BatchModel> todo;
+	size_t upToDate = 0;
+	for (const BatchModel &m : models) {
+		if (!force && IsUpToDate(m.path, opts.inPlace))
+			upToDate++;
+		else
+			todo.push_back(m);
+	}
+
+	Output("modelcompiler: %u models, %u up to date, compiling %u on %d threads\n",
+		unsigned(models.size()), unsigned(upToDate), unsigned(todo.size()), GetNumWorkers(todo.size()));
+
+	ParallelForEach(todo.size(), [&todo, &opts](size_t i, Graphics::Renderer *renderer) {
+		BatchModel &m = todo[i];
+		const Uint32 start = SDL_GetTicks();
+		m.failed = !RunCompiler(renderer, m.name, m.path, opts);
+		m.ms = double(SDL_GetTicks() - start);
+	});
+
+	// summary, slowest first
+	std::sort(todo.begin(), todo.end(), [](const BatchModel &a, const BatchModel &b) { return a.ms > b.ms; });
+	size_t failed = 0;
+	for (const BatchModel &m : todo)
+		if (m.failed) failed++;
+	Output("\n---\nmodelcompiler: compiled %u, %u up to date, %u failed, in %.1fs\n",
+		unsigned(todo.size() - failed), unsigned(upToDate), unsigned(failed), (SDL_GetTicks() - batchStart) * 0.001);
+	for (size_t i = 0; i < todo.size() && i < 5; i++)
+		if (!todo[i].failed)
+			Output("  %-32s %8.0fms\n", todo[i].name.c_str(), todo[i].ms);
+	for (const BatchModel &m : todo)
+		if (m.failed)
+			Output("  failed: %s (%s)\n", m.name.c_str(), m.path.c_str());
+}
+
+// writes a compressed .dds next to every power-of-two .png the models and
+// effects use, which TextureBuilder then loads instead. without inplace
+// they go in the user's data directory, which overrides the game's
+static void RunTextureCooker(const bool bInPlace, const bool force)
+{
+	const Uint32 start = SDL_GetTicks();
+
+	std::vector<std::string> todo;
+	size_t upToDate = 0;
+	static const char *dirs[] = { "models", "textures" };
+	for (const char *dir : dirs) {
+		for (FileSystem::FileEnumerator files(FileSystem::gameDataFiles, dir, FileSystem::FileEnumerator::Recurse); !files.Finished(); files.Next()) {
+			const FileSystem::FileInfo &info = files.Current();
+			if (!info.IsFile() || !ends_with_ci(info.GetPath(), ".png"))
+				continue;
+			const FileSystem::FileInfo cooked = FileSystem::gameDataFiles.Lookup(Graphics::TextureCooker::GetCookedFilename(info.GetPath()));
+			if (!force && cooked.IsFile() && cooked.GetModificationTime() >= info.GetModificationTime())
+				upToDate++;
+			else
+				todo.push_back(info.GetPath());
+		}
+	}
+
+	Output("modelcompiler: %u textures up to date, cooking %u on %d threads\n",
+		unsigned(upToDate), unsigned(todo.size()), GetNumWorkers(todo.size()));
+
+	std::atomic<int> cooked(0), skipped(0), failed(0);
+	std::atomic<size_t> bytesIn(0), bytesOut(0);
+	ParallelForEach(todo.size(), [&](size_t i, Graphics::Renderer *) {
+		const std::string &path = todo[i];
+		SDLSurfacePtr surface = LoadSurfaceFromFile(path);
+		if (!Graphics::TextureCooker::CanCook(surface.Get())) {
+			skipped++;
+			return;
+		}
+		std::vector<Uint8> dds;
+		if (!Graphics::TextureCooker::Cook(surface, dds)) {
+			failed++;
+			Output("  failed: %s\n", path.c_str());
+			return;
+		}
+
+		const std::string outPath = Graphics::TextureCooker::GetCookedFilename(path);
+		FILE *f = nullptr;
+		if (bInPlace) {
+			f = FileSystem::FileSourceFS(FileSystem::GetDataDir()).OpenWriteStream(outPath);
+		} else {
+			const std::string userPath = FileSystem::JoinPathBelow("data", outPath);
+			FileSystem::userFiles.MakeDirectory(userPath.substr(0, userPath.rfind('/')));
+			f = FileSystem::userFiles.OpenWriteStream(userPath);
+		}
+		if (!f || fwrite(&dds[0], dds.size(), 1, f) != 1) {
+			failed++;
+			Output("  failed: %s (couldn't write %s)\n", path.c_str(), outPath.c_str());
+		} else {
+			cooked++;
+			bytesIn += size_t(surface->w) * surface->h * 4;
+			bytesOut += dds.size();
+		}
+		if (f)
+			fclose(f);
+	});
+
+	Output("\n---\nmodelcompiler: cooked %d textures (%.1fMB of RGBA to %.1fMB with mipmaps), %u up to date, %d skipped (not power of two), %d failed, in %.1fs\n",
+		int(cooked), bytesIn / (1024.0 * 1024.0), bytesOut / (1024.0 * 1024.0), unsigned(upToDate), int(skipped), int(failed),
+		(SDL_GetTicks() - start) * 0.001);
+}
 
 enum RunMode {
 	MODE_MODELCOMPILER=0,
 	MODE_MODELBATCHEXPORT,
+	MODE_TEXTURES,
 	MODE_VERSION,
 	MODE_USAGE,
 	MODE_USAGE_ERROR
@@ -126,6 +351,11 @@ int main(int argc, char** argv)
 			goto start;
 		}
 
+		if (modeopt == "textures" || modeopt == "t") {
+			mode = MODE_TEXTURES;
+			goto start;
+		}
+
 		if (modeopt == "version" || modeopt == "v") {
 			mode = MODE_VERSION;
 			goto start;
@@ -177,21 +407,26 @@ start:
 					}
 				}
 				SetupRenderer();
-				RunCompiler(modelName, filePath, isInPlace);
+				RunCompiler(s_renderer.get(), modelName, filePath, GetCompilerOptions(isInPlace));
 			}
 			break;
 		}
 
 		case MODE_MODELBATCHEXPORT: {
-			// determine if we're meant to be writing these in the source directory
+			// determine if we're meant to be writing these in the source
+			// directory, and whether to rebuild models that look up to date
 			bool isInPlace = false;
-			if (argc > 2) {
-				std::string arg2 = argv[2];
-				isInPlace = (arg2 == "inplace" || arg2 == "true");
+			bool force = false;
+			for (int i = 2; i < argc; i++) {
+				const std::string arg = argv[i];
+				if (arg == "inplace" || arg == "true")
+					isInPlace = true;
+				else if (arg == "force")
+					force = true;
 			}
 
 			// find all of the models
-			std::vector<std::pair<std::string, std::string>> list_model;
+			std::vector<BatchModel> list_model;
 			FileSystem::FileSource &fileSource = FileSystem::gameDataFiles;
 			for (FileSystem::FileEnumerator files(fileSource, "models", FileSystem::FileEnumerator::Recurse); !files.Finished(); files.Next())
 			{
@@ -201,15 +436,30 @@ start:
 				//check it's the expected type
 				if (info.IsFile()) {
 					if (ends_with_ci(fpath, ".model")) {	// store the path for ".model" files
-						list_model.push_back( std::make_pair(info.GetName().substr(0, info.GetName().size()-6), fpath) );
+						BatchModel m = { info.GetName().substr(0, info.GetName().size()-6), fpath, false, 0.0 };
+						list_model.push_back(m);
 					}
 				}
 			}
 
 			SetupRenderer();
-			for (auto &modelName : list_model) {
-				RunCompiler(modelName.first, modelName.second, isInPlace);
+			RunBatch(list_model, GetCompilerOptions(isInPlace), force);
+			break;
+		}
+
+		case MODE_TEXTURES: {
+			bool isInPlace = false;
+			bool force = false;
+			for (int i = 2; i < argc; i++) {
+				const std::string arg = argv[i];
+				if (arg == "inplace" || arg == "true")
+					isInPlace = true;
+				else if (arg == "force")
+					force = true;
 			}
+
+			SetupRenderer();
+			RunTextureCooker(isInPlace, force);
 			break;
 		}
 
@@ -232,6 +482,10 @@ start:
 				"    -compile inplace  [-c ... inplace]  model compiler\n"
 				"    -batch            [-b]              batch mode output into users home/Pioneer directory\n"
 				"    -batch inplace    [-b inplace]      batch mode output into the source folder\n"
+				"    -batch ... force  [-b ... force]    batch mode, also rebuild models that are up to date\n"
+				"    -textures         [-t]              compress textures to DDS into users home/Pioneer/data directory\n"
+				"    -textures inplace [-t inplace]      compress textures to DDS into the source folder\n"
+				"    -textures ... force [-t ... force]  compress textures, including ones that are up to date\n"
 				"    -version          [-v]              show version\n"
 				"    -help             [-h,-?]           this help\n"
 			);
@@ -2,6 +2,13 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include <math.h>
+#include <algorithm>
+#include "perlin.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PERLIN_SSE2 1
+#include <emmintrin.h>
+#endif
 
 /* Simplex.cpp
  *
@@ -217,3 +224,143 @@ int main()
 }
 
 #endif /* UNIT_TEST */
+
+#ifdef PERLIN_SSE2
+
+static const float grad3f[12][3] = {
+	{1,1,0}, {-1,1,0}, {1,-1,0}, {-1,-1,0},
+	{1,0,1}, {-1,0,1}, {1,0,-1}, {-1,0,-1},
+	{0,1,1}, {0,-1,1}, {0,1,-1}, {0,-1,-1}
+};
+
+static inline __m128 floor4(const __m128 x)
+{
+	const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+	return _mm_sub_ps(t, _mm_and_ps(_mm_cmplt_ps(x, t), _mm_set1_ps(1.0f)));
+}
+
+static inline __m128 select4(const __m128 mask, const __m128 a, const __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// contribution of one simplex corner, gi is the gradient index for each lane
+static inline __m128 corner4(const __m128 x, const __m128 y, const __m128 z, const int *gi)
+{
+	const __m128 gx = _mm_setr_ps(grad3f[gi[0]][0], grad3f[gi[1]][0], grad3f[gi[2]][0], grad3f[gi[3]][0]);
+	const __m128 gy = _mm_setr_ps(grad3f[gi[0]][1], grad3f[gi[1]][1], grad3f[gi[2]][1], grad3f[gi[3]][1]);
+	const __m128 gz = _mm_setr_ps(grad3f[gi[0]][2], grad3f[gi[1]][2], grad3f[gi[2]][2], grad3f[gi[3]][2]);
+	__m128 t = _mm_sub_ps(_mm_set1_ps(0.6f),
+		_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+	t = _mm_max_ps(t, _mm_setzero_ps());
+	t = _mm_mul_ps(t, t);
+	t = _mm_mul_ps(t, t);
+	const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(gx, x), _mm_mul_ps(gy, y)), _mm_mul_ps(gz, z));
+	return _mm_mul_ps(t, d);
+}
+
+// the same simplex noise as above with the corner ordering done without
+// branches. only the permutation lookups are scalar
+static __m128 noise4(const __m128 x, const __m128 y, const __m128 z)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 G3 = _mm_set1_ps(1.0f/6.0f);
+
+	const __m128 s = _mm_mul_ps(_mm_add_ps(_mm_add_ps(x, y), z), _mm_set1_ps(1.0f/3.0f));
+	const __m128 i = floor4(_mm_add_ps(x, s));
+	const __m128 j = floor4(_mm_add_ps(y, s));
+	const __m128 k = floor4(_mm_add_ps(z, s));
+
+	const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(i, j), k), G3);
+	const __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(i, t));
+	const __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(j, t));
+	const __m128 z0 = _mm_sub_ps(z, _mm_sub_ps(k, t));
+
+	const __m128 xGEy = _mm_cmpge_ps(x0, y0);
+	const __m128 xGEz = _mm_cmpge_ps(x0, z0);
+	const __m128 yGEz = _mm_cmpge_ps(y0, z0);
+	const __m128 i1 = _mm_and_ps(one, _mm_and_ps(xGEy, xGEz));
+	const __m128 j1 = _mm_and_ps(one, _mm_andnot_ps(xGEy, yGEz));
+	const __m128 k1 = _mm_and_ps(one, _mm_andnot_ps(xGEz, _mm_andnot_ps(yGEz, _mm_castsi128_ps(_mm_set1_epi32(-1)))));
+	const __m128 i2 = _mm_and_ps(one, _mm_or_ps(xGEy, xGEz));
+	const __m128 j2 = _mm_and_ps(one, _mm_or_ps(_mm_andnot_ps(xGEy, _mm_castsi128_ps(_mm_set1_epi32(-1))), yGEz));
+	const __m128 k2 = select4(_mm_and_ps(xGEz, yGEz), _mm_setzero_ps(), one);
+
+	const __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, i1), G3);
+	const __m128 y1 = _mm_add_ps(_mm_sub_ps(y0, j1), G3);
+	const __m128 z1 = _mm_add_ps(_mm_sub_ps(z0, k1), G3);
+	const __m128 G3x2 = _mm_set1_ps(2.0f/6.0f);
+	const __m128 x2 = _mm_add_ps(_mm_sub_ps(x0, i2), G3x2);
+	const __m128 y2 = _mm_add_ps(_mm_sub_ps(y0, j2), G3x2);
+	const __m128 z2 = _mm_add_ps(_mm_sub_ps(z0, k2), G3x2);
+	const __m128 G3x3m1 = _mm_set1_ps(3.0f/6.0f - 1.0f);
+	const __m128 x3 = _mm_add_ps(x0, G3x3m1);
+	const __m128 y3 = _mm_add_ps(y0, G3x3m1);
+	const __m128 z3 = _mm_add_ps(z0, G3x3m1);
+
+	// hash the corners
+	int ii[4], jj[4], kk[4], o1[4][3], o2[4][3];
+	{
+		const __m128i mask = _mm_set1_epi32(255);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(ii), _mm_and_si128(_mm_cvttps_epi32(i), mask));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(jj), _mm_and_si128(_mm_cvttps_epi32(j), mask));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(kk), _mm_and_si128(_mm_cvttps_epi32(k), mask));
+		float f[6][4];
+		_mm_storeu_ps(f[0], i1); _mm_storeu_ps(f[1], j1); _mm_storeu_ps(f[2], k1);
+		_mm_storeu_ps(f[3], i2); _mm_storeu_ps(f[4], j2); _mm_storeu_ps(f[5], k2);
+		for (int l = 0; l < 4; l++) {
+			o1[l][0] = int(f[0][l]); o1[l][1] = int(f[1][l]); o1[l][2] = int(f[2][l]);
+			o2[l][0] = int(f[3][l]); o2[l][1] = int(f[4][l]); o2[l][2] = int(f[5][l]);
+		}
+	}
+	int gi0[4], gi1[4], gi2[4], gi3[4];
+	for (int l = 0; l < 4; l++) {
+		gi0[l] = mod12[perm[ii[l]+perm[jj[l]+perm[kk[l]]]]];
+		gi1[l] = mod12[perm[ii[l]+o1[l][0]+perm[jj[l]+o1[l][1]+perm[kk[l]+o1[l][2]]]]];
+		gi2[l] = mod12[perm[ii[l]+o2[l][0]+perm[jj[l]+o2[l][1]+perm[kk[l]+o2[l][2]]]]];
+		gi3[l] = mod12[perm[ii[l]+1+perm[jj[l]+1+perm[kk[l]+1]]]];
+	}
+
+	const __m128 n = _mm_add_ps(
+		_mm_add_ps(corner4(x0, y0, z0, gi0), corner4(x1, y1, z1, gi1)),
+		_mm_add_ps(corner4(x2, y2, z2, gi2), corner4(x3, y3, z3, gi3)));
+	return _mm_mul_ps(n, _mm_set1_ps(32.0f));
+}
+
+void noise(const vector3f *p, float *out, const int count)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 x = _mm_setr_ps(p[i].x, p[i+1].x, p[i+2].x, p[i+3].x);
+		const __m128 y = _mm_setr_ps(p[i].y, p[i+1].y, p[i+2].y, p[i+3].y);
+		const __m128 z = _mm_setr_ps(p[i].z, p[i+1].z, p[i+2].z, p[i+3].z);
+		_mm_storeu_ps(out + i, noise4(x, y, z));
+	}
+	if (i < count) {
+		// pad the tail out to a full vector
+		vector3f tail[4];
+		float res[4];
+		for (int l = 0; l < 4; l++)
+			tail[l] = p[std::min(i + l, count - 1)];
+		_mm_storeu_ps(res, noise4(
+			_mm_setr_ps(tail[0].x, tail[1].x, tail[2].x, tail[3].x),
+			_mm_setr_ps(tail[0].y, tail[1].y, tail[2].y, tail[3].y),
+			_mm_setr_ps(tail[0].z, tail[1].z, tail[2].z, tail[3].z)));
+		for (int l = 0; i + l < count; l++)
+			out[i + l] = res[l];
+	}
+}
+
+bool noiseIsVectorised() { return true; }
+
+#else
+
+void noise(const vector3f *p, float *out, const int count)
+{
+	for (int i = 0; i < count; i++)
+		out[i] = float(noise(p[i].x, p[i].y, p[i].z));
+}
+
+bool noiseIsVectorised() { return false; }
+
+#endif
@@ -11,4 +11,13 @@ static inline double noise(const vector3d &p) {
 	return noise(p.x, p.y, p.z);
 }
 
+// batched version, out[i] = noise(p[i]), in single precision. for colours
+// and other things that don't need to match the double version exactly
+// (heights do). it works on 4 points at a time with SSE2 where the
+// compiler targets it
+void noise(const vector3f *p, float *out, const int count);
+
+// true if the float version has a SIMD path in this build
+bool noiseIsVectorised();
+
 #endif /* _PERLIN_H */
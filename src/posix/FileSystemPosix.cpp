@@ -9,6 +9,7 @@
 #include <cerrno>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <dirent.h>
 #include <unistd.h>
 
@@ -95,10 +96,24 @@ namespace FileSystem {
 		return data_path;
 	}
 
+	class FileDataMapped : public FileData {
+	public:
+		FileDataMapped(const FileInfo &info, size_t size, char *data):
+			FileData(info, size, data) {}
+		virtual ~FileDataMapped() { munmap(m_data, m_size); }
+	};
+
 	FileSourceFS::FileSourceFS(const std::string &root, bool trusted):
-		FileSource(absolute_path(root), trusted) {}
+		FileSource(absolute_path(root), trusted),
+		m_mapFiles(false),
+		m_dirIndexChanged(false),
+		m_dirIndexLock(0) {}
 
-	FileSourceFS::~FileSourceFS() {}
+	FileSourceFS::~FileSourceFS()
+	{
+		if (m_dirIndexLock)
+			SDL_DestroyMutex(m_dirIndexLock);
+	}
 
 	static FileInfo::FileType interpret_stat(const struct stat &info, Time::DateTime &mtime) {
 		FileInfo::FileType ty;
@@ -160,6 +175,17 @@ namespace FileSystem {
 			fseek(fl, 0, SEEK_END);
 			long sz = ftell(fl);
 			fseek(fl, 0, SEEK_SET);
+
+			if (m_mapFiles && size_t(sz) >= MAP_MIN_SIZE) {
+				void *mapped = mmap(0, sz, PROT_READ, MAP_PRIVATE, fileno(fl), 0);
+				if (mapped != MAP_FAILED) {
+					// the mapping keeps its own reference to the file
+					fclose(fl);
+					return RefCountedPtr<FileData>(new FileDataMapped(MakeFileInfo(path, ty, mtime), sz, static_cast<char*>(mapped)));
+				}
+				// otherwise read it the usual way
+			}
+
 			char *data = static_cast<char*>(std::malloc(sz));
 			if (!data) {
 				// XXX handling memory allocation failure gracefully is too hard right now
@@ -181,6 +207,21 @@ namespace FileSystem {
 	bool FileSourceFS::ReadDirectory(const std::string &dirpath, std::vector<FileInfo> &output)
 	{
 		const std::string fulldirpath = JoinPathBelow(GetRoot(), dirpath);
+
+		Time::DateTime dirTime;
+		bool indexable = false;
+		if (m_dirIndexLock) {
+			struct stat info;
+			if (stat(fulldirpath.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+				return false;
+			interpret_stat(info, dirTime);
+			if (FindIndexedDir(dirpath, dirTime, output))
+				return true;
+			// mtimes are in whole seconds, so a change made in the same
+			// second as this read wouldn't show up
+			indexable = info.st_mtime < time(0) - 1;
+		}
+
 		DIR *dir = opendir(fulldirpath.c_str());
 		if (!dir) { return false; }
 		struct dirent *entry;
@@ -207,6 +248,8 @@ namespace FileSystem {
 		closedir(dir);
 
 		std::sort(output.begin() + output_head_size, output.end());
+		if (indexable)
+			IndexDir(dirpath, dirTime, output.begin() + output_head_size, output.end());
 		return true;
 	}
 
@@ -258,4 +301,11 @@ namespace FileSystem {
 		const std::string fullpath = JoinPathBelow(GetRoot(), path);
 		return fopen(fullpath.c_str(), (flags & WRITE_TEXT) ? "w" : "wb");
 	}
+
+	bool FileSourceFS::RenameFile(const std::string &from, const std::string &to)
+	{
+		const std::string fullfrom = JoinPathBelow(GetRoot(), from);
+		const std::string fullto = JoinPathBelow(GetRoot(), to);
+		return rename(fullfrom.c_str(), fullto.c_str()) == 0;
+	}
 }
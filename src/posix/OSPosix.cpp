@@ -13,6 +13,7 @@
 #include <unistd.h>
 #endif
 #include <sys/utsname.h>
+#include <sys/resource.h>
 
 namespace OS {
 
@@ -100,6 +101,18 @@ int GetNumCores()
 #endif
 }
 
+size_t GetPeakMemoryUsage()
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#if defined(__APPLE__)
+	return size_t(usage.ru_maxrss); // bytes
+#else
+	return size_t(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+}
+
 const std::string GetOSInfoString()
 {
 	int z;
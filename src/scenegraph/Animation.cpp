@@ -3,6 +3,7 @@
 
 #include "Animation.h"
 #include "scenegraph/Model.h"
+#include <algorithm>
 #include <iostream>
 
 namespace SceneGraph {
@@ -10,6 +11,21 @@ namespace SceneGraph {
 typedef std::vector<AnimationChannel> ChannelList;
 typedef ChannelList::iterator ChannelIterator;
 
+// the last key at or before time (or the first key), searching from the
+// previous result: animations mostly move a little at a time, so this is
+// usually no more than a step or two
+template <typename Key>
+static unsigned int FindFrame(const std::vector<Key> &keys, double time, Uint32 &cursor)
+{
+	unsigned int frame = std::min<unsigned int>(cursor, keys.size() - 1);
+	while (frame > 0 && time < keys[frame].time)
+		frame--;
+	while (frame + 1 < keys.size() && time >= keys[frame + 1].time)
+		frame++;
+	cursor = frame;
+	return frame;
+}
+
 Animation::Animation(const std::string &name, double duration)
 : m_duration(duration)
 , m_time(0.0)
@@ -56,13 +72,7 @@ void Animation::Interpolate()
 		matrix4x4f trans = chan->node->GetTransform();
 
 		if (!chan->rotationKeys.empty()) {
-			//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-			unsigned int frame = 0;
-			while (frame + 1 < chan->rotationKeys.size()) {
-				if (mtime < chan->rotationKeys[frame+1].time)
-					break;
-				frame++;
-			}
+			const unsigned int frame = FindFrame(chan->rotationKeys, mtime, chan->rotationCursor);
 
 			const RotationKey &a = chan->rotationKeys[frame];
 			vector3f saved_position = trans.GetTranslate();
@@ -82,13 +92,7 @@ void Animation::Interpolate()
 		//continously scale the transform (would have to add originalTransform or
 		//something to MT)
 		if (!chan->scaleKeys.empty() && !chan->rotationKeys.empty()) {
-			//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-			unsigned int frame = 0;
-			while (frame + 1 < chan->scaleKeys.size()) {
-				if (mtime < chan->scaleKeys[frame+1].time)
-					break;
-				frame++;
-			}
+			const unsigned int frame = FindFrame(chan->scaleKeys, mtime, chan->scaleCursor);
 
 			const ScaleKey &a = chan->scaleKeys[frame];
 			vector3f out;
@@ -105,13 +109,7 @@ void Animation::Interpolate()
 		}
 
 		if (!chan->positionKeys.empty()) {
-			//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-			unsigned int frame = 0;
-			while (frame + 1 < chan->positionKeys.size()) {
-				if (mtime < chan->positionKeys[frame+1].time)
-					break;
-				frame++;
-			}
+			const unsigned int frame = FindFrame(chan->positionKeys, mtime, chan->positionCursor);
 
 			const PositionKey &a = chan->positionKeys[frame];
 			vector3f out;
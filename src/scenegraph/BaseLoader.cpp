@@ -51,15 +51,15 @@ void BaseLoader::ConvertMaterialDefinition(const MaterialDefinition &mdef)
 		mat->diffuse.a = (float(mdef.opacity) / 100.f) * 255;
 
 	if (!diffTex.empty())
-		mat->texture0 = Graphics::TextureBuilder::Model(diffTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture0 = Graphics::TextureBuilder::Model(diffTex).GetOrCreateTextureAsync(m_renderer, "model");
 	else
 		mat->texture0 = Graphics::TextureBuilder::GetWhiteTexture(m_renderer);
 	if (!specTex.empty())
-		mat->texture1 = Graphics::TextureBuilder::Model(specTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture1 = Graphics::TextureBuilder::Model(specTex).GetOrCreateTextureAsync(m_renderer, "model");
 	if (!glowTex.empty())
-		mat->texture2 = Graphics::TextureBuilder::Model(glowTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture2 = Graphics::TextureBuilder::Model(glowTex).GetOrCreateTextureAsync(m_renderer, "model");
 	if (!ambiTex.empty())
-		mat->texture3 = Graphics::TextureBuilder::Model(ambiTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture3 = Graphics::TextureBuilder::Model(ambiTex).GetOrCreateTextureAsync(m_renderer, "model");
 	
 	//texture4 is reserved for pattern
 	//texture5 is reserved for color gradient
@@ -100,6 +100,7 @@ void BaseLoader::FindPatterns(PatternContainer &output)
 void BaseLoader::SetUpPatterns()
 {
 	FindPatterns(m_model->m_patterns);
+	m_model->m_patternArray.Reset(CreatePatternArray(m_model->m_patterns, m_curPath, m_renderer));
 
 	if (m_model->m_patterns.empty()) {
 		m_model->m_patterns.push_back(Pattern());
@@ -5,10 +5,9 @@
 #include "NodeVisitor.h"
 #include "graphics/Graphics.h"
 #include "graphics/Renderer.h"
-#include "graphics/VertexArray.h"
-#include "graphics/VertexBuffer.h"
 #include "graphics/Material.h"
 #include "graphics/RenderState.h"
+#include "graphics/SpriteBatch.h"
 #include "graphics/Stats.h"
 
 namespace SceneGraph {
@@ -49,8 +48,6 @@ void Billboard::Render(const matrix4x4f &trans, const RenderData *rd)
 	PROFILE_SCOPED()
 	Graphics::Renderer *r = GetRenderer();
 
-	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0, 6);
-
 	const matrix3x3f rot = trans.GetOrient().Transpose();
 
 	//some hand-tweaked scaling, to make the lights seem larger from distance
@@ -59,30 +56,22 @@ void Billboard::Render(const matrix4x4f &trans, const RenderData *rd)
 	const vector3f rotv1 = rot * vector3f(size*0.5f, -size*0.5f, 0.0f);
 	const vector3f rotv2 = rot * vector3f(size*0.5f, size*0.5f, 0.0f);
 
-	va.Add(m_offset-rotv1, vector2f(0.f, 0.f)); //top left
-	va.Add(m_offset-rotv2, vector2f(0.f, 1.f)); //bottom left
-	va.Add(m_offset+rotv2, vector2f(1.f, 0.f)); //top right
-
-	va.Add(m_offset+rotv2, vector2f(1.f, 0.f)); //top right
-	va.Add(m_offset-rotv2, vector2f(0.f, 1.f)); //bottom left
-	va.Add(m_offset+rotv1, vector2f(1.f, 1.f)); //bottom right
-
-	if( !m_vbuffer.Valid() )
-	{
-		//create buffer and upload data
-		Graphics::VertexBufferDesc vbd;
-		vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-		vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-		vbd.attrib[1].semantic = Graphics::ATTRIB_UV0;
-		vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT2;
-		vbd.numVertices = va.GetNumVerts();
-		vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;	// we could be updating this per-frame
-		m_vbuffer.Reset( r->CreateVertexBuffer(vbd) );
-	}
-	m_vbuffer->Populate( va );
-
-	r->SetTransform(trans);
-	r->DrawBuffer(m_vbuffer.Get(), m_renderState, m_material.Get());
+	const vector3f positions[6] = {
+		m_offset-rotv1, //top left
+		m_offset-rotv2, //bottom left
+		m_offset+rotv2, //top right
+
+		m_offset+rotv2, //top right
+		m_offset-rotv2, //bottom left
+		m_offset+rotv1, //bottom right
+	};
+	static const vector2f uvs[6] = {
+		vector2f(0.f, 0.f), vector2f(0.f, 1.f), vector2f(1.f, 0.f),
+		vector2f(1.f, 0.f), vector2f(0.f, 1.f), vector2f(1.f, 1.f),
+	};
+
+	// drawn along with all other navlights and thrusters in view
+	r->GetSpriteBatch().Add(trans, positions, uvs, 6, m_material->diffuse, m_renderState, m_material->texture0);
 
 	r->GetStats().AddToStatCount(Graphics::Stats::STAT_BILLBOARD, 1);
 }
@@ -10,7 +10,6 @@
 
 namespace Graphics {
 	class Material;
-	class VertexBuffer;
 	class RenderState;
 }
 
@@ -29,7 +28,6 @@ public:
 private:
 	float m_size;
 	RefCountedPtr<Graphics::Material> m_material;
-	RefCountedPtr<Graphics::VertexBuffer> m_vbuffer;
 	Graphics::RenderState *m_renderState;
 	vector3f m_offset;
 };
@@ -17,7 +17,12 @@ using namespace SceneGraph;
 // 2: converted StaticMesh to VertexBuffer
 // 3: store processed collision mesh
 // 4: compressed SGM files and instancing support
-const Uint32 SGM_VERSION = 4;
+// 5: 32-bit indices for large meshes
+// 6: vertex and index data stored in buffer layout, optionally uncompressed
+// 7: collision BVHs stored instead of rebuilt on load
+const Uint32 SGM_VERSION = 7;
+const Uint32 SGM_SIGNATURE = 0x344D4753; //'SGM4'
+
 const std::string SGM_EXTENSION = ".sgm";
 const std::string SAVE_TARGET_DIR = "binarymodels";
 
@@ -49,6 +54,7 @@ public:
 BinaryConverter::BinaryConverter(Graphics::Renderer *r)
 	: BaseLoader(r)
 	, m_patternsUsed(false)
+	, m_compress(true)
 {
 	//register core loaders
 	RegisterLoader("Group", &Group::Load);
@@ -129,10 +135,14 @@ void BinaryConverter::Save(const std::string& filename, const std::string& savep
 	size_t outSize = 0;
 	size_t nwritten = 0;
 	const std::string& data = wr.GetData();
-	void *pCompressedData = tdefl_compress_mem_to_heap(data.data(), data.length(), &outSize, 128);
-	if (pCompressedData) {
-		nwritten = fwrite(pCompressedData, outSize, 1, f);
-		mz_free(pCompressedData);
+	if (m_compress) {
+		void *pCompressedData = tdefl_compress_mem_to_heap(data.data(), data.length(), &outSize, 128);
+		if (pCompressedData) {
+			nwritten = fwrite(pCompressedData, outSize, 1, f);
+			mz_free(pCompressedData);
+		}
+	} else {
+		nwritten = fwrite(data.data(), data.length(), 1, f);
 	}
 	fclose(f);
 
@@ -146,6 +156,26 @@ Model *BinaryConverter::Load(const std::string &filename)
 }
 
 Model *BinaryConverter::Load(const std::string &shortname, const std::string &basepath)
+{
+	RefCountedPtr<FileSystem::FileData> data;
+	std::string curPath;
+	if (!ReadFile(shortname, basepath, data, curPath))
+		throw (LoadingError("File not found"));
+	return Load(data.Get(), curPath);
+}
+
+// uncompressed files start with the signature and current version, compressed
+// ones can't (in any way that matters) look like that
+static bool IsUncompressed(const ByteRange &bin)
+{
+	if (bin.Size() < 8) return false;
+	Serializer::Reader rd(bin);
+	const Uint32 sig = rd.Int32();
+	const Uint32 version = rd.Int32();
+	return sig == SGM_SIGNATURE && version == SGM_VERSION;
+}
+
+bool BinaryConverter::ReadFile(const std::string &shortname, const std::string &basepath, RefCountedPtr<FileSystem::FileData> &data, std::string &curPath)
 {
 	FileSystem::FileSource &fileSource = FileSystem::gameDataFiles;
 	for (FileSystem::FileEnumerator files(fileSource, basepath, FileSystem::FileEnumerator::Recurse); !files.Finished(); files.Next()) {
@@ -161,38 +191,49 @@ Model *BinaryConverter::Load(const std::string &shortname, const std::string &ba
 				//curPath is used to find textures, patterns,
 				//possibly other data files for this model.
 				//Strip trailing slash
-				m_curPath = info.GetDir();
-				if (m_curPath[m_curPath.length()-1] == '/')
-					m_curPath = m_curPath.substr(0, m_curPath.length()-1);
+				curPath = info.GetDir();
+				if (curPath[curPath.length()-1] == '/')
+					curPath = curPath.substr(0, curPath.length()-1);
 
+				data.Reset();
 				RefCountedPtr<FileSystem::FileData> binfile = info.Read();
 				if (binfile.Valid()) {
-					Model* model(nullptr);
-					size_t outSize(0);
-					// decompress the loaded ByteRange in memory
 					const ByteRange bin = binfile->AsByteRange();
-					void *pDecompressedData = tinfl_decompress_mem_to_heap(&bin[0], bin.Size(), &outSize, 0);
-					if (pDecompressedData) {
-						// now parse in-memory representation as new ByteRange.
-						Serializer::Reader rd(ByteRange(static_cast<char*>(pDecompressedData), outSize));
-						model = CreateModel(rd);
-						mz_free(pDecompressedData);
+					if (IsUncompressed(bin)) {
+						// use the file contents as they are
+						data = binfile;
+					} else {
+						// decompress the loaded ByteRange in memory. miniz
+						// allocates with malloc, so the FileData can own the result
+						size_t outSize(0);
+						void *pDecompressedData = tinfl_decompress_mem_to_heap(&bin[0], bin.Size(), &outSize, 0);
+						if (pDecompressedData)
+							data.Reset(new FileSystem::FileDataMalloc(info, outSize, static_cast<char*>(pDecompressedData)));
 					}
-					return model;
 				}
+				return true;
 			}
 		}
 	}
+	return false;
+}
 
-	throw (LoadingError("File not found"));
-	return nullptr;
+Model *BinaryConverter::Load(const FileSystem::FileData *data, const std::string &curPath)
+{
+	if (!data)
+		return nullptr;
+
+	m_curPath = curPath;
+	// now parse in-memory representation as new ByteRange.
+	Serializer::Reader rd(data->AsByteRange());
+	return CreateModel(rd);
 }
 
 Model *BinaryConverter::CreateModel(Serializer::Reader &rd)
 {
 	//verify signature
 	const Uint32 sig = rd.Int32();
-	if (sig != 0x344D4753) //'SGM4'
+	if (sig != SGM_SIGNATURE)
 		throw LoadingError("Not a binary model file");
 
 	const Uint32 version = rd.Int32();
@@ -17,6 +17,8 @@
 #include "CollisionGeometry.h"
 #include "Thruster.h"
 #include "Billboard.h"
+#include "FileSystem.h"
+#include "FlatHashMap.h"
 #include <functional>
 
 namespace SceneGraph
@@ -29,6 +31,16 @@ public:
 	void Save(const std::string& filename, const std::string& savepath, Model* m, const bool bInPlace);
 	Model *Load(const std::string &filename);
 	Model *Load(const std::string &filename, const std::string &path);
+	//create a model from data read by ReadFile
+	Model *Load(const FileSystem::FileData *data, const std::string &curPath);
+
+	//find and decompress a .sgm file. only does file access, so it can be
+	//called from a job thread. data is left null if decompression failed.
+	//uncompressed files are used as read, without another copy
+	static bool ReadFile(const std::string &shortname, const std::string &basepath, RefCountedPtr<FileSystem::FileData> &data, std::string &curPath);
+
+	//write plain files, which load faster but are several times larger
+	void SetCompressed(bool compress) { m_compress = compress; }
 
 	//if you implement any new node types, you must also register a loader function
 	//before calling Load.
@@ -48,7 +60,8 @@ private:
 	static Label3D *LoadLabel3D(NodeDatabase&);
 
 	bool m_patternsUsed;
-	std::map<std::string, std::function<Node*(NodeDatabase&)> > m_loaders;
+	bool m_compress;
+	FlatHashMap<std::string, std::function<Node*(NodeDatabase&)> > m_loaders;
 };
 }
 
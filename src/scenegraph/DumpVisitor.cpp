@@ -4,6 +4,7 @@
 #include "DumpVisitor.h"
 #include "Group.h"
 #include "LOD.h"
+#include "MeshOptimiser.h"
 #include "Node.h"
 #include "StaticGeometry.h"
 #include "Model.h"
@@ -18,6 +19,10 @@ DumpVisitor::DumpVisitor(const Model *m)
 	//model statistics that cannot be visited)
 	m_modelStats.collTriCount = m->GetCollisionMesh() ? m->GetCollisionMesh()->GetNumTriangles() : 0;
 	m_modelStats.materialCount = m->GetNumMaterials();
+	//measure a throwaway instance, so the node counts show what each
+	//extra instance copies and what it shares with the original
+	std::unique_ptr<Model> instance(m->MakeInstance());
+	m_memory = instance->GetMemoryUsage();
 }
 
 std::string DumpVisitor::GetModelStatistics()
@@ -35,6 +40,8 @@ std::string DumpVisitor::GetModelStatistics()
 		ss << "Nodes: " << it->nodeCount << '\n';
 		ss << "Geoms: " << it->opaqueGeomCount << " opaque, " << it->transGeomCount << " transparent\n";
 		ss << "Triangles: " << it->triangles  << '\n';
+		if (it->triangles > 0)
+			ss << "Vertex cache ACMR: " << float(it->cacheMisses) / it->triangles << '\n';
 		++it;
 		idx++;
 	};
@@ -43,6 +50,16 @@ std::string DumpVisitor::GetModelStatistics()
 	ss << "Materials: " << m_modelStats.materialCount << '\n';
 	ss << "Collision triangles: " << m_modelStats.collTriCount << '\n';
 
+	const double kb = 1.0 / 1024.0;
+	ss << '\n';
+	ss << "Memory, shared by all instances\n";
+	ss << "Geometry: " << int(m_memory.geometry * kb) << " KB\n";
+	ss << "Textures: " << int(m_memory.textures * kb) << " KB\n";
+	ss << "Collision: " << int(m_memory.collision * kb) << " KB\n";
+	ss << "Memory, per instance\n";
+	ss << "Nodes: " << m_memory.instanceNodes << " copied, " << m_memory.sharedNodes << " shared\n";
+	ss << "Instance data: " << int(m_memory.instanceBytes * kb) << " KB\n";
+
 	return ss.str();
 }
 
@@ -86,8 +103,13 @@ void DumpVisitor::ApplyStaticGeometry(StaticGeometry &g)
 	else
 		m_stats.opaqueGeomCount++;
 
-	for (unsigned int i = 0; i < g.GetNumMeshes(); i++)
-		m_stats.triangles += g.GetMeshAt(i).indexBuffer->GetSize() / 3;
+	std::vector<Uint32> indices;
+	for (unsigned int i = 0; i < g.GetNumMeshes(); i++) {
+		Graphics::IndexBuffer *ib = g.GetMeshAt(i).indexBuffer.Get();
+		m_stats.triangles += ib->GetSize() / 3;
+		ib->Read(indices);
+		m_stats.cacheMisses += MeshOptimiser::CountCacheMisses(indices);
+	}
 
 	ApplyNode(static_cast<Node&>(g));
 }
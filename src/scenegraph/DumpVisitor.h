@@ -2,14 +2,13 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "NodeVisitor.h"
+#include "Model.h"
 /*
  * Print the graph structure to console
  * Collect statistics
  */
 namespace SceneGraph {
 
-class Model;
-
 class DumpVisitor : public NodeVisitor {
 public:
 	struct LodStatistics {
@@ -18,6 +17,7 @@ public:
 		unsigned int transGeomCount;
 
 		unsigned int triangles;
+		unsigned int cacheMisses; //simulated, see MeshOptimiser
 	};
 
 	struct ModelStatistics {
@@ -40,6 +40,7 @@ private:
 
 	unsigned int m_level;
 	ModelStatistics m_modelStats;
+	Model::MemoryUsage m_memory;
 	LodStatistics m_stats;
 	std::vector<LodStatistics> m_lodStats;
 };
@@ -50,8 +50,11 @@ Group *Group::Load(NodeDatabase &db)
 	//children are loaded by Loader
 }
 
+Uint32 Group::s_structureVersion = 0;
+
 void Group::AddChild(Node *child)
 {
+	++s_structureVersion;
 	child->IncRefCount();
 	m_children.push_back(child);
 }
@@ -64,6 +67,7 @@ bool Group::RemoveChild(Node *node)
 		++itr)
 	{
 		if((*itr) == node) {
+			++s_structureVersion;
 			itr = m_children.erase(itr);
 			node->DecRefCount();
 			return true;
@@ -75,6 +79,7 @@ bool Group::RemoveChild(Node *node)
 bool Group::RemoveChildAt(unsigned int idx)
 {
 	if (m_children.empty() || idx > m_children.size() - 1) return false;
+	++s_structureVersion;
 	Node *node = m_children.at(idx);
 	node->DecRefCount();
 	m_children.erase(m_children.begin() + idx);
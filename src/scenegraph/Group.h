@@ -30,11 +30,18 @@ public:
 	virtual void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd);
 	virtual Node* FindNode(const std::string &);
 
+	// bumped whenever a child is added to or removed from any group, so
+	// anything caching the shape of a node tree knows to look again
+	static Uint32 GetStructureVersion() { return s_structureVersion; }
+
 protected:
 	virtual ~Group();
 	virtual void RenderChildren(const matrix4x4f &trans, const RenderData *rd);
 	virtual void RenderChildren(const std::vector<matrix4x4f> &trans, const RenderData *rd);
 	std::vector<Node *> m_children;
+
+private:
+	static Uint32 s_structureVersion;
 };
 
 }
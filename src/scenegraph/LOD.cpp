@@ -10,6 +10,8 @@
 
 namespace SceneGraph {
 
+float LOD::s_pixelScale = 1.0f;
+
 LOD::LOD(Graphics::Renderer *r) : Group(r)
 {
 }
@@ -39,20 +41,27 @@ void LOD::AddLevel(float pixelSize, Node *nod)
 	AddChild(nod);
 }
 
-void LOD::Render(const matrix4x4f &trans, const RenderData *rd)
+int LOD::SelectLevel(const matrix4x4f &trans, float boundingRadius) const
 {
-	PROFILE_SCOPED()
+	if (m_pixelSizes.empty()) return -1;
 	//figure out approximate pixel size of object's bounding radius
 	//on screen and pick a child to render
 	const vector3f cameraPos(-trans[12], -trans[13], -trans[14]);
 	//fov is vertical, so using screen height
-	const float pixrad = Graphics::GetScreenHeight() * rd->boundingRadius / (cameraPos.Length() * Graphics::GetFovFactor());
-	if (m_pixelSizes.empty()) return;
+	const float pixrad = s_pixelScale * Graphics::GetScreenHeight() * boundingRadius / (cameraPos.Length() * Graphics::GetFovFactor());
 	unsigned int lod = m_children.size() - 1;
 	for (unsigned int i=m_pixelSizes.size(); i > 0; i--) {
 		if (pixrad < m_pixelSizes[i-1]) lod = i-1;
 	}
-	m_children[lod]->Render(trans, rd);
+	return lod;
+}
+
+void LOD::Render(const matrix4x4f &trans, const RenderData *rd)
+{
+	PROFILE_SCOPED()
+	const int lod = SelectLevel(trans, rd->boundingRadius);
+	if (lod >= 0)
+		m_children[lod]->Render(trans, rd);
 }
 
 void LOD::Render(const std::vector<matrix4x4f> &trans, const RenderData *rd)
@@ -82,7 +91,7 @@ void LOD::Render(const std::vector<matrix4x4f> &trans, const RenderData *rd)
 			//on screen and pick a child to render
 			const vector3f cameraPos(-mt[12], -mt[13], -mt[14]);
 			//fov is vertical, so using screen height
-			const float pixrad = Graphics::GetScreenHeight() * rd->boundingRadius / (cameraPos.Length() * Graphics::GetFovFactor());
+			const float pixrad = s_pixelScale * Graphics::GetScreenHeight() * rd->boundingRadius / (cameraPos.Length() * Graphics::GetFovFactor());
 			unsigned int lod = m_children.size() - 1;
 			for (unsigned int i = m_pixelSizes.size(); i > 0; i--) {
 				if (pixrad < m_pixelSizes[i - 1]) {
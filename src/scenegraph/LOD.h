@@ -20,12 +20,23 @@ public:
 	virtual void Render(const matrix4x4f &trans, const RenderData *rd);
 	virtual void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd);
 	void AddLevel(float pixelRadius, Node *child);
+	// child to draw at this view space position, -1 if there is none
+	int SelectLevel(const matrix4x4f &trans, float boundingRadius) const;
+	// on-screen bounding radius in pixels below which each level is drawn
+	const std::vector<unsigned int> &GetPixelSizes() const { return m_pixelSizes; }
 	virtual void Save(NodeDatabase&) override;
 	static LOD* Load(NodeDatabase&);
 
+	// on-screen sizes are scaled by this before picking a level, so below 1
+	// the coarser levels are used from nearer
+	static void SetPixelScale(float scale) { s_pixelScale = scale; }
+
 protected:
 	virtual ~LOD() { }
 	std::vector<unsigned int> m_pixelSizes; // same number as children
+
+private:
+	static float s_pixelScale;
 };
 
 }
@@ -5,6 +5,7 @@
 #include "CollisionGeometry.h"
 #include "FileSystem.h"
 #include "LOD.h"
+#include "MeshSimplifier.h"
 #include "Parser.h"
 #include "SceneGraph.h"
 #include "BinaryConverter.h"
@@ -119,6 +120,8 @@ Loader::Loader(Graphics::Renderer *r, bool logWarnings, bool loadSGMfiles)
 , m_doLog(logWarnings)
 , m_loadSGMs(loadSGMfiles)
 , m_mostDetailedLod(false)
+, m_optimiseMeshes(false)
+, m_meshDetail(1.f)
 {
 }
 
@@ -129,9 +132,29 @@ Model *Loader::LoadModel(const std::string &filename)
 }
 
 Model *Loader::LoadModel(const std::string &shortname, const std::string &basepath)
+{
+	ModelSource src;
+	if (!ReadModel(shortname, basepath, m_loadSGMs, src))
+		throw (LoadingError("File not found"));
+	return LoadModel(src);
+}
+
+Model *Loader::LoadModel(ModelSource &src)
 {
 	m_logMessages.clear();
 
+	if (src.binary) {
+		SceneGraph::BinaryConverter bc(m_renderer);
+		m_model = bc.Load(src.binaryData.Get(), src.curPath);
+		return m_model;
+	}
+
+	m_curPath = src.curPath;
+	return CreateModel(src.definition);
+}
+
+bool Loader::ReadModel(const std::string &shortname, const std::string &basepath, bool loadSGMfiles, ModelSource &src)
+{
 	std::vector<std::string> list_model;
 	std::vector<std::string> list_sgm;
 	FileSystem::FileSource &fileSource = FileSystem::gameDataFiles;
@@ -144,19 +167,18 @@ Model *Loader::LoadModel(const std::string &shortname, const std::string &basepa
 		if (info.IsFile()) {
 			if (ends_with_ci(fpath, ".model")) {	// store the path for ".model" files
 				list_model.push_back(fpath);
-			} else if (m_loadSGMs & ends_with_ci(fpath, ".sgm")) {// store only the shortname for ".sgm" files.
+			} else if (loadSGMfiles & ends_with_ci(fpath, ".sgm")) {// store only the shortname for ".sgm" files.
 				list_sgm.push_back(info.GetName().substr(0, info.GetName().size()-4));
 			}
 		}
 	}
 
-	if (m_loadSGMs) {
+	if (loadSGMfiles) {
 		for (auto &sgmname : list_sgm) {
 			if (sgmname == shortname) {
 				//binary loader expects extension-less name. Might want to change this.
-				SceneGraph::BinaryConverter bc(m_renderer);
-				m_model = bc.Load(shortname);
-				return m_model;
+				src.binary = true;
+				return SceneGraph::BinaryConverter::ReadFile(shortname, basepath, src.binaryData, src.curPath);
 			}
 		}
 	}
@@ -165,34 +187,34 @@ Model *Loader::LoadModel(const std::string &shortname, const std::string &basepa
 		RefCountedPtr<FileSystem::FileData> filedata = FileSystem::gameDataFiles.ReadFile(fpath);
 		if (!filedata) {
 			Output("LoadModel: %s: could not read file\n", fpath.c_str());
-			return nullptr;
+			throw LoadingError("Could not read file");
 		}
 
 		//check it's the wanted name & load it
 		const FileSystem::FileInfo& info = filedata->GetInfo();
 		const std::string name = info.GetName();
 		if (name.substr(0, name.length()-6) == shortname) {
-			ModelDefinition modelDefinition;
 			try {
 				//curPath is used to find textures, patterns,
 				//possibly other data files for this model.
 				//Strip trailing slash
-				m_curPath = info.GetDir();
-				assert(!m_curPath.empty());
-				if (m_curPath[m_curPath.length()-1] == '/')
-					m_curPath = m_curPath.substr(0, m_curPath.length()-1);
+				src.curPath = info.GetDir();
+				assert(!src.curPath.empty());
+				if (src.curPath[src.curPath.length()-1] == '/')
+					src.curPath = src.curPath.substr(0, src.curPath.length()-1);
 
-				Parser p(fileSource, fpath, m_curPath);
-				p.Parse(&modelDefinition);
+				Parser p(fileSource, fpath, src.curPath);
+				p.Parse(&src.definition);
 			} catch (ParseError &err) {
 				Output("%s\n", err.what());
 				throw LoadingError(err.what());
 			}
-			modelDefinition.name = shortname;
-			return CreateModel(modelDefinition);
+			src.binary = false;
+			src.definition.name = shortname;
+			return true;
 		}
 	}
-	throw (LoadingError("File not found"));
+	return false;
 }
 
 Model *Loader::CreateModel(ModelDefinition &def)
@@ -217,10 +239,13 @@ Model *Loader::CreateModel(ModelDefinition &def)
 	}
 	//Output("Loaded %d materials\n", int(model->m_materials.size()));
 
+	if (def.lodDefs.size() == 1 && !m_generatedLods.empty())
+		AddGeneratedLods(def);
+
 	//load meshes
 	//"mesh" here refers to a "mesh xxx.yyy"
 	//defined in the .model
-	std::map<std::string, RefCountedPtr<Node> > meshCache;
+	std::map<std::pair<std::string, float>, RefCountedPtr<Node> > meshCache;
 	LOD *lodNode = 0;
 	if (def.lodDefs.size() > 1) { //don't bother with a lod node if only one level
 		lodNode = new LOD(m_renderer);
@@ -243,17 +268,18 @@ Model *Loader::CreateModel(ModelDefinition &def)
 			try {
 				//multiple lods might use the same mesh
 				RefCountedPtr<Node> mesh;
-				std::map<std::string, RefCountedPtr<Node> >::iterator cacheIt = meshCache.find((*it));
+				const std::pair<std::string, float> cacheKey(*it, (*lod).detail);
+				std::map<std::pair<std::string, float>, RefCountedPtr<Node> >::iterator cacheIt = meshCache.find(cacheKey);
 				if (cacheIt != meshCache.end())
 					mesh = (*cacheIt).second;
 				else {
 					try {
-						mesh = LoadMesh(*it, def.animDefs);
+						mesh = LoadMesh(*it, def.animDefs, (*lod).detail);
 					} catch (LoadingError &err) {
 						//append filename - easiest to do here
 						throw (LoadingError(stringf("%0:\n%1", *it, err.what())));
 					}
-					meshCache[*(it)] = mesh;
+					meshCache[cacheKey] = mesh;
 				}
 				assert(mesh.Valid());
 
@@ -310,18 +336,41 @@ Model *Loader::CreateModel(ModelDefinition &def)
 	return model;
 }
 
-RefCountedPtr<Node> Loader::LoadMesh(const std::string &filename, const AnimList &animDefs)
+void Loader::AddGeneratedLods(ModelDefinition &def) const
+{
+	assert(def.lodDefs.size() == 1);
+	const LodDefinition source = def.lodDefs.front();
+
+	//lowest detail first, like the parser sorts them. A level at a fraction
+	//of the triangles takes over below the same fraction of the pixel size
+	std::vector<float> ratios;
+	for (float r : m_generatedLods)
+		if (r > 0.f && r < 1.f) ratios.push_back(r);
+	std::sort(ratios.begin(), ratios.end());
+	ratios.erase(std::unique(ratios.begin(), ratios.end()), ratios.end());
+
+	def.lodDefs.clear();
+	for (float r : ratios) {
+		def.lodDefs.push_back(LodDefinition(source.pixelSize * r, r));
+		def.lodDefs.back().meshNames = source.meshNames;
+	}
+	def.lodDefs.push_back(source);
+}
+
+RefCountedPtr<Node> Loader::LoadMesh(const std::string &filename, const AnimList &animDefs, float detail)
 {
 	//remove path from filename for nicer logging
 	size_t slashpos = filename.rfind("/");
 	m_curMeshDef = filename.substr(slashpos+1, filename.length()-slashpos);
+	m_meshDetail = detail;
 
 	Assimp::Importer importer;
 	importer.SetIOHandler(new AssimpFileSystem(FileSystem::gameDataFiles));
 
 	//Removing components is suggested to optimize loading. We do not care about vtx colors now.
 	importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, aiComponent_COLORS);
-	importer.SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT, 65536);
+	//big meshes get 32-bit indices, so only split them at the importer's own limit
+	importer.SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT, AI_SLM_DEFAULT_MAX_VERTICES);
 
 	//There are several optimizations assimp can do, intentionally skipping them now
 	const aiScene *scene = importer.ReadFile(
@@ -432,7 +481,6 @@ void Loader::ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> > &geoms,
 	for (unsigned int i=0; i<scene->mNumMeshes; i++) {
 		const aiMesh *mesh = scene->mMeshes[i];
 		assert(mesh->HasNormals());
-		assert(mesh->mNumVertices <= 65536);
 
 		RefCountedPtr<StaticGeometry> geom(new StaticGeometry(m_renderer));
 		geom->SetName(stringf("sgMesh%0{u}", i));
@@ -479,13 +527,9 @@ void Loader::ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> > &geoms,
 		vbd.attrib[2].format   = Graphics::ATTRIB_FORMAT_FLOAT2;
 		vbd.attrib[2].offset   = offsetof(ModelVtx, uv0);
 		vbd.stride = sizeof(ModelVtx);
-		vbd.numVertices = mesh->mNumVertices;
 		vbd.usage = Graphics::BUFFER_USAGE_STATIC;
 
-		RefCountedPtr<Graphics::VertexBuffer> vb(m_renderer->CreateVertexBuffer(vbd));
-
-		// huge meshes are split by the importer so this should not exceed 65K indices
-		std::vector<Uint16> indices;
+		std::vector<Uint32> indices;
 		if (mesh->mNumFaces > 0)
 		{
 			indices.reserve(mesh->mNumFaces * 3);
@@ -505,16 +549,10 @@ void Loader::ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> > &geoms,
 
 		assert(indices.size() > 0);
 
-		//create buffer & copy
-		RefCountedPtr<Graphics::IndexBuffer> ib(m_renderer->CreateIndexBuffer(indices.size(), Graphics::BUFFER_USAGE_STATIC));
-		Uint16* idxPtr = ib->Map(Graphics::BUFFER_MAP_WRITE);
-		for (Uint32 j = 0; j < indices.size(); j++)
-			idxPtr[j] = indices[j];
-		ib->Unmap();
-
 		//copy vertices, always assume normals
 		//replace nonexistent UVs with zeros
-		ModelVtx *vtxPtr = vb->Map<ModelVtx>(Graphics::BUFFER_MAP_WRITE);
+		std::vector<Uint8> vertices(mesh->mNumVertices * sizeof(ModelVtx));
+		ModelVtx *vtxPtr = reinterpret_cast<ModelVtx*>(&vertices[0]);
 		for (unsigned int v = 0; v < mesh->mNumVertices; v++) {
 			const aiVector3D &vtx = mesh->mVertices[v];
 			const aiVector3D &norm = mesh->mNormals[v];
@@ -527,8 +565,36 @@ void Loader::ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> > &geoms,
 			//untransformed points, collision visitor will transform
 			geom->m_boundingBox.Update(vtx.x, vtx.y, vtx.z);
 		}
+
+		if (m_meshDetail < 1.f && mesh->mNumFaces > 0) {
+			const Uint32 target = std::max(1u, Uint32(indices.size() / 3 * m_meshDetail));
+			MeshSimplifier::Simplify(vertices, sizeof(ModelVtx), offsetof(ModelVtx, pos), indices, target);
+		}
+
+		if (m_optimiseMeshes && mesh->mNumFaces > 0) {
+			//kept as is if nothing but degenerate triangles would be left,
+			//the nodes refer to meshes by index
+			std::vector<Uint8> optVertices(vertices);
+			std::vector<Uint32> optIndices(indices);
+			const MeshOptimiser::Stats stats = MeshOptimiser::Optimise(optVertices, sizeof(ModelVtx), offsetof(ModelVtx, pos), optIndices);
+			if (!optIndices.empty()) {
+				m_meshStats.Add(stats);
+				vertices.swap(optVertices);
+				indices.swap(optIndices);
+			} else
+				AddLog(stringf("%0: mesh %1{u} has only degenerate triangles", m_curMeshDef, i));
+		}
+
+		//create buffers & copy
+		vbd.numVertices = vertices.size() / sizeof(ModelVtx);
+		RefCountedPtr<Graphics::VertexBuffer> vb(m_renderer->CreateVertexBuffer(vbd));
+		memcpy(vb->Map<Uint8>(Graphics::BUFFER_MAP_WRITE), &vertices[0], vertices.size());
 		vb->Unmap();
 
+		const Graphics::IndexFormat idxFormat = Graphics::IndexBuffer::GetFormatForVertexCount(vbd.numVertices);
+		RefCountedPtr<Graphics::IndexBuffer> ib(m_renderer->CreateIndexBuffer(indices.size(), Graphics::BUFFER_USAGE_STATIC, idxFormat));
+		ib->Populate(&indices[0], indices.size());
+
 		geom->AddMesh(vb, ib, mat);
 
 		geoms.push_back(geom);
@@ -754,7 +820,10 @@ RefCountedPtr<CollisionGeometry> Loader::CreateCollisionGeometry(RefCountedPtr<S
 	const Uint32 posOffs = mesh.vertexBuffer->GetDesc().GetOffset(Graphics::ATTRIB_POSITION);
 	const Uint32 stride  = mesh.vertexBuffer->GetDesc().stride;
 	const Uint32 numVtx  = mesh.vertexBuffer->GetDesc().numVertices;
-	const Uint32 numIdx  = mesh.indexBuffer->GetSize();
+
+	//collision trees still use 16-bit indices
+	if (numVtx > 65536)
+		throw LoadingError(stringf("%0: collision mesh has more than 65536 vertices", m_curMeshDef));
 
 	//copy vertex positions from buffer
 	std::vector<vector3f> pos;
@@ -766,13 +835,9 @@ RefCountedPtr<CollisionGeometry> Loader::CreateCollisionGeometry(RefCountedPtr<S
 	mesh.vertexBuffer->Unmap();
 
 	//copy indices from buffer
-	std::vector<unsigned short> idx;
-	idx.reserve(numIdx);
-
-	Uint16 *idxPtr = mesh.indexBuffer->Map(Graphics::BUFFER_MAP_READ);
-	for (Uint32 i = 0; i < numIdx; i++)
-		idx.push_back(idxPtr[i]);
-	mesh.indexBuffer->Unmap();
+	std::vector<Uint32> bufIdx;
+	mesh.indexBuffer->Read(bufIdx);
+	std::vector<unsigned short> idx(bufIdx.begin(), bufIdx.end());
 	RefCountedPtr<CollisionGeometry> cgeom(new CollisionGeometry(m_renderer, pos, idx, collFlag));
 	return cgeom;
 }
@@ -812,6 +877,9 @@ void Loader::ConvertNodes(aiNode *node, Group *_parent, std::vector<RefCountedPt
 
 	//nodes named collision_* are not added as renderable geometry
 	if (node->mNumMeshes == 1 && starts_with(nodename, "collision_")) {
+		//the level it was generated from already has it
+		if (m_meshDetail < 1.f)
+			return;
 		const unsigned int collflag = GetGeomFlagForNodeName(nodename);
 		RefCountedPtr<CollisionGeometry> cgeom = CreateCollisionGeometry(geoms.at(node->mMeshes[0]), collflag);
 		cgeom->SetName(nodename + "_cgeom");
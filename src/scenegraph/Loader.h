@@ -8,6 +8,8 @@
  */
 #include "BaseLoader.h"
 #include "CollisionGeometry.h"
+#include "FileSystem.h"
+#include "MeshOptimiser.h"
 #include "graphics/Material.h"
 #include <assimp/types.h>
 
@@ -20,18 +22,46 @@ namespace SceneGraph {
 
 class Loader : public BaseLoader {
 public:
+	//the files a model is built from, read but not yet turned into renderer resources
+	struct ModelSource {
+		ModelSource() : binary(false) {}
+		bool binary;
+		std::string curPath;
+		RefCountedPtr<FileSystem::FileData> binaryData; //decompressed .sgm
+		ModelDefinition definition; //parsed .model
+	};
+
 	Loader(Graphics::Renderer *r, bool logWarnings = false, bool loadSGMfiles = true);
 
 	//find & attempt to load a model, based on filename (without path or .model suffix)
 	Model *LoadModel(const std::string &name);
 	Model *LoadModel(const std::string &name, const std::string &basepath);
+	Model *LoadModel(ModelSource &src);
+
+	//find the model and read its files. does not use the renderer, so it can be
+	//called from a job thread. returns false if there is no such model
+	static bool ReadModel(const std::string &name, const std::string &basepath, bool loadSGMfiles, ModelSource &src);
 
 	const std::vector<std::string> &GetLogMessages() const { return m_logMessages; }
 
+	//weld and reorder mesh vertices and triangles for the GPU caches. Worth
+	//it where the result is saved (modelcompiler), too slow for every load
+	void SetOptimiseMeshes(bool enabled) { m_optimiseMeshes = enabled; }
+	//totals over all meshes converted by this loader
+	const MeshOptimiser::Stats &GetMeshStats() const { return m_meshStats; }
+
+	//models with a single detail level get lower ones simplified from it,
+	//keeping each of these fractions of the triangles. Also compile-time only
+	void SetGeneratedLods(const std::vector<float> &detailRatios) { m_generatedLods = detailRatios; }
+
 protected:
 	bool m_doLog;
 	bool m_loadSGMs;
 	bool m_mostDetailedLod;
+	bool m_optimiseMeshes;
+	MeshOptimiser::Stats m_meshStats;
+	std::vector<float> m_generatedLods;
+	float m_meshDetail; //of the level being loaded
 	std::vector<std::string> m_logMessages;
 	std::string m_curMeshDef; //for logging
 
@@ -41,7 +71,8 @@ protected:
 	bool CheckKeysInRange(const aiNodeAnim *, double start, double end);
 	matrix4x4f ConvertMatrix(const aiMatrix4x4&) const;
 	Model *CreateModel(ModelDefinition &def);
-	RefCountedPtr<Node> LoadMesh(const std::string &filename, const AnimList &animDefs); //load one mesh file so it can be added to the model scenegraph. Materials should be created before this!
+	void AddGeneratedLods(ModelDefinition &def) const;
+	RefCountedPtr<Node> LoadMesh(const std::string &filename, const AnimList &animDefs, float detail = 1.f); //load one mesh file so it can be added to the model scenegraph. Materials should be created before this!
 	void AddLog(const std::string&);
 	void CheckAnimationConflicts(const Animation*, const std::vector<Animation*>&); //detect animation overlap
 	void ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> >&, const aiScene*); //model is only for material lookup
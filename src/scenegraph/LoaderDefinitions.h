@@ -43,9 +43,10 @@ struct MaterialDefinition {
 };
 
 struct LodDefinition {
-	LodDefinition(float size) : pixelSize(size)
+	LodDefinition(float size, float detail_ = 1.f) : pixelSize(size), detail(detail_)
 	{ }
 	float pixelSize;
+	float detail; //fraction of the mesh triangles to keep, less than 1 for generated levels
 	std::vector<std::string> meshNames;
 };
 
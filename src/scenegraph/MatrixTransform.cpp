@@ -50,7 +50,17 @@ void MatrixTransform::Render(const std::vector<matrix4x4f> &trans, const RenderD
 		std::vector<matrix4x4f> t; 
 		t.resize(transSize);
 		for (size_t tIdx = 0; tIdx < transSize; tIdx++) {
-			t[tIdx] = trans[tIdx] * m_transform;
+			// the bottom row may carry the instance's skin (see
+			// Model::PackInstanceSkin), so keep it out of the product
+			matrix4x4f m = trans[tIdx];
+			const float skin[4] = { m[3], m[7], m[11], m[15] };
+			m[3] = m[7] = m[11] = 0.0f;
+			m[15] = 1.0f;
+			t[tIdx] = m * m_transform;
+			t[tIdx][3] = skin[0];
+			t[tIdx][7] = skin[1];
+			t[tIdx][11] = skin[2];
+			t[tIdx][15] = skin[3];
 		}
 		RenderChildren(t, rd);
 	}
@@ -0,0 +1,223 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "MeshOptimiser.h"
+#include "vcacheopt/vcacheopt.h"
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+namespace SceneGraph {
+
+// a cluster may end once it is no worse than this much over the average
+// cache misses of the whole mesh
+static const float CLUSTER_ACMR_THRESHOLD = 1.05f;
+
+void MeshOptimiser::Stats::Add(const Stats &other)
+{
+	verticesIn += other.verticesIn;
+	verticesOut += other.verticesOut;
+	trianglesIn += other.trianglesIn;
+	trianglesOut += other.trianglesOut;
+	clusters += other.clusters;
+	missesIn += other.missesIn;
+	missesOut += other.missesOut;
+}
+
+MeshOptimiser::Stats MeshOptimiser::Optimise(std::vector<Uint8> &vertices, Uint32 stride, Uint32 posOffset, std::vector<Uint32> &indices)
+{
+	PROFILE_SCOPED()
+	assert(stride > 0 && vertices.size() % stride == 0);
+	assert(indices.size() % 3 == 0);
+
+	Stats stats;
+	stats.verticesIn = vertices.size() / stride;
+	stats.trianglesIn = indices.size() / 3;
+	stats.missesIn = CountCacheMisses(indices);
+
+	WeldVertices(vertices, stride, indices);
+	OptimiseVertexCache(indices);
+	stats.clusters = ReorderForOverdraw(vertices, stride, posOffset, indices);
+	OptimiseVertexFetch(vertices, stride, indices);
+
+	stats.verticesOut = vertices.size() / stride;
+	stats.trianglesOut = indices.size() / 3;
+	stats.missesOut = CountCacheMisses(indices);
+	return stats;
+}
+
+Uint32 MeshOptimiser::CountCacheMisses(const std::vector<Uint32> &indices, Uint32 cacheSize)
+{
+	if (indices.empty())
+		return 0;
+
+	// time each vertex went in the cache, 0 for never. it's pushed out
+	// once cacheSize other vertices have gone in after it
+	const Uint32 numVertices = *std::max_element(indices.begin(), indices.end()) + 1;
+	std::vector<Uint32> stamp(numVertices, 0);
+	Uint32 time = 0;
+	for (Uint32 v : indices) {
+		if (stamp[v] == 0 || time - stamp[v] >= cacheSize)
+			stamp[v] = ++time;
+	}
+	return time;
+}
+
+// also drops triangles that use the same vertex twice, which welding can
+// create and which draw nothing anyway
+void MeshOptimiser::WeldVertices(std::vector<Uint8> &vertices, Uint32 stride, std::vector<Uint32> &indices)
+{
+	const Uint32 numVertices = vertices.size() / stride;
+
+	std::unordered_map<std::string, Uint32> unique;
+	unique.reserve(numVertices);
+	std::vector<Uint32> remap(numVertices);
+	std::vector<Uint8> welded;
+	welded.reserve(vertices.size());
+	for (Uint32 v = 0; v < numVertices; v++) {
+		const Uint8 *vtx = &vertices[v * stride];
+		const std::string key(reinterpret_cast<const char*>(vtx), stride);
+		auto it = unique.insert(std::make_pair(key, Uint32(welded.size() / stride)));
+		if (it.second)
+			welded.insert(welded.end(), vtx, vtx + stride);
+		remap[v] = it.first->second;
+	}
+	vertices.swap(welded);
+
+	std::vector<Uint32> tris;
+	tris.reserve(indices.size());
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		const Uint32 a = remap[indices[i]];
+		const Uint32 b = remap[indices[i+1]];
+		const Uint32 c = remap[indices[i+2]];
+		if (a == b || b == c || a == c)
+			continue;
+		tris.push_back(a);
+		tris.push_back(b);
+		tris.push_back(c);
+	}
+	indices.swap(tris);
+}
+
+void MeshOptimiser::OptimiseVertexCache(std::vector<Uint32> &indices)
+{
+	if (indices.empty())
+		return;
+
+	std::vector<int> inds(indices.begin(), indices.end());
+	VertexCacheOptimizerInt vco;
+	if (VertexCacheOptimizerInt::Failed(vco.Optimize(&inds[0], inds.size() / 3)))
+		return;
+	std::copy(inds.begin(), inds.end(), indices.begin());
+}
+
+// "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+// (Sander, Nehab, Barczak 2007), on top of the cache order rather than
+// their own. Returns the number of clusters
+Uint32 MeshOptimiser::ReorderForOverdraw(const std::vector<Uint8> &vertices, Uint32 stride, Uint32 posOffset, std::vector<Uint32> &indices)
+{
+	const Uint32 numTris = indices.size() / 3;
+	if (numTris < 2)
+		return numTris;
+
+	// cut where a triangle misses the cache on all three vertices: the cache
+	// starts over there anyway, so moving what follows costs nothing extra
+	const float threshold = float(CountCacheMisses(indices)) / numTris * CLUSTER_ACMR_THRESHOLD;
+	std::vector<Uint32> clusterStarts(1, 0);
+	{
+		std::vector<Uint32> stamp(vertices.size() / stride, 0);
+		Uint32 time = 0;
+		Uint32 clusterMisses = 0;
+		for (Uint32 t = 0; t < numTris; t++) {
+			Uint32 misses = 0;
+			for (Uint32 k = 0; k < 3; k++) {
+				const Uint32 v = indices[t*3 + k];
+				if (stamp[v] == 0 || time - stamp[v] >= CACHE_SIZE) {
+					stamp[v] = ++time;
+					misses++;
+				}
+			}
+			const Uint32 clusterTris = t - clusterStarts.back();
+			if (misses == 3 && clusterTris > 0 && float(clusterMisses) / clusterTris <= threshold) {
+				clusterStarts.push_back(t);
+				clusterMisses = 0;
+			}
+			clusterMisses += misses;
+		}
+	}
+	const Uint32 numClusters = clusterStarts.size();
+	clusterStarts.push_back(numTris);
+	if (numClusters < 2)
+		return numClusters;
+
+	auto position = [&](Uint32 v) {
+		float p[3];
+		memcpy(p, &vertices[v * stride + posOffset], sizeof(p));
+		return vector3f(p[0], p[1], p[2]);
+	};
+
+	// area weighted centres and normals, of the whole mesh and per cluster
+	std::vector<vector3f> centres(numClusters, vector3f(0.f));
+	std::vector<vector3f> normals(numClusters, vector3f(0.f));
+	std::vector<float> areas(numClusters, 0.f);
+	vector3f meshCentre(0.f);
+	float meshArea = 0.f;
+	for (Uint32 c = 0; c < numClusters; c++) {
+		for (Uint32 t = clusterStarts[c]; t < clusterStarts[c+1]; t++) {
+			const vector3f a = position(indices[t*3]);
+			const vector3f b = position(indices[t*3 + 1]);
+			const vector3f d = position(indices[t*3 + 2]);
+			const vector3f n = (b - a).Cross(d - a);
+			const float area = n.Length() * 0.5f;
+			const vector3f centre = (a + b + d) * (1.f / 3.f);
+			centres[c] += centre * area;
+			normals[c] += n;
+			areas[c] += area;
+		}
+		meshCentre += centres[c];
+		meshArea += areas[c];
+	}
+	if (meshArea > 0.f)
+		meshCentre = meshCentre * (1.f / meshArea);
+
+	// clusters facing out from the middle of the mesh are the likeliest to
+	// cover the rest, so they go first
+	std::vector<float> scores(numClusters, 0.f);
+	for (Uint32 c = 0; c < numClusters; c++) {
+		if (areas[c] <= 0.f) continue;
+		const vector3f centre = centres[c] * (1.f / areas[c]);
+		scores[c] = (centre - meshCentre).Dot(normals[c].NormalizedSafe());
+	}
+	std::vector<Uint32> order(numClusters);
+	for (Uint32 c = 0; c < numClusters; c++)
+		order[c] = c;
+	std::stable_sort(order.begin(), order.end(), [&scores](Uint32 a, Uint32 b) { return scores[a] > scores[b]; });
+
+	std::vector<Uint32> sorted;
+	sorted.reserve(indices.size());
+	for (Uint32 c : order)
+		sorted.insert(sorted.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c+1] * 3);
+	indices.swap(sorted);
+
+	return numClusters;
+}
+
+// unused vertices go as well
+void MeshOptimiser::OptimiseVertexFetch(std::vector<Uint8> &vertices, Uint32 stride, std::vector<Uint32> &indices)
+{
+	const Uint32 unused = ~0u;
+	std::vector<Uint32> remap(vertices.size() / stride, unused);
+	std::vector<Uint8> ordered;
+	ordered.reserve(vertices.size());
+	Uint32 next = 0;
+	for (Uint32 &i : indices) {
+		if (remap[i] == unused) {
+			remap[i] = next++;
+			ordered.insert(ordered.end(), vertices.begin() + i * stride, vertices.begin() + (i + 1) * stride);
+		}
+		i = remap[i];
+	}
+	vertices.swap(ordered);
+}
+
+}
@@ -0,0 +1,56 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SCENEGRAPH_MESHOPTIMISER_H
+#define _SCENEGRAPH_MESHOPTIMISER_H
+/*
+ * Offline optimisation of indexed triangle meshes, used when compiling models.
+ * Runs in this order:
+ *  - weld vertices that are identical byte for byte
+ *  - order triangles for the post-transform vertex cache (vcacheopt)
+ *  - split that order into clusters at cheap points and sort the clusters
+ *    outward facing first, so the mesh tends to occlude itself front to back
+ *  - renumber vertices in order of first use, so vertex fetch runs forwards
+ */
+#include "libs.h"
+#include <vector>
+
+namespace SceneGraph {
+
+class MeshOptimiser {
+public:
+	struct Stats {
+		Stats() : verticesIn(0), verticesOut(0), trianglesIn(0), trianglesOut(0), clusters(0), missesIn(0), missesOut(0) {}
+		Uint32 verticesIn;
+		Uint32 verticesOut;
+		Uint32 trianglesIn;
+		Uint32 trianglesOut; //less any degenerate ones
+		Uint32 clusters;
+		Uint32 missesIn; //simulated vertex cache misses
+		Uint32 missesOut;
+
+		//average cache misses per triangle
+		float GetACMRIn() const { return trianglesIn ? float(missesIn) / trianglesIn : 0.f; }
+		float GetACMROut() const { return trianglesOut ? float(missesOut) / trianglesOut : 0.f; }
+		void Add(const Stats &other);
+	};
+
+	// vertices holds vertexCount * stride bytes with a vector3f position
+	// at posOffset. both arrays are rewritten, and vertices may shrink
+	static Stats Optimise(std::vector<Uint8> &vertices, Uint32 stride, Uint32 posOffset, std::vector<Uint32> &indices);
+
+	// vertex shader runs for a triangle list through a FIFO cache
+	static Uint32 CountCacheMisses(const std::vector<Uint32> &indices, Uint32 cacheSize = CACHE_SIZE);
+
+	static const Uint32 CACHE_SIZE = 32;
+
+private:
+	static void WeldVertices(std::vector<Uint8> &vertices, Uint32 stride, std::vector<Uint32> &indices);
+	static void OptimiseVertexCache(std::vector<Uint32> &indices);
+	static Uint32 ReorderForOverdraw(const std::vector<Uint8> &vertices, Uint32 stride, Uint32 posOffset, std::vector<Uint32> &indices);
+	static void OptimiseVertexFetch(std::vector<Uint8> &vertices, Uint32 stride, std::vector<Uint32> &indices);
+};
+
+}
+
+#endif
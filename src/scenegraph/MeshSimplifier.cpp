@@ -0,0 +1,209 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+
+namespace SceneGraph {
+
+// how much more a border plane counts than a surface plane of the same size
+static const double BORDER_WEIGHT = 100.0;
+// a collapse is refused if it turns a triangle further than about 80 degrees
+static const double MIN_NORMAL_DOT = 0.2;
+
+namespace {
+
+// symmetric 4x4 error matrix of the planes around a vertex
+struct Quadric {
+	Quadric() { std::fill(m, m + 10, 0.0); }
+	Quadric(const vector3d &n, double d, double weight) {
+		m[0] = n.x*n.x; m[1] = n.x*n.y; m[2] = n.x*n.z; m[3] = n.x*d;
+		m[4] = n.y*n.y; m[5] = n.y*n.z; m[6] = n.y*d;
+		m[7] = n.z*n.z; m[8] = n.z*d;
+		m[9] = d*d;
+		for (double &v : m) v *= weight;
+	}
+
+	Quadric &operator+=(const Quadric &o) {
+		for (int i = 0; i < 10; i++) m[i] += o.m[i];
+		return *this;
+	}
+
+	double Error(const vector3d &p) const {
+		return m[0]*p.x*p.x + 2*m[1]*p.x*p.y + 2*m[2]*p.x*p.z + 2*m[3]*p.x
+			+ m[4]*p.y*p.y + 2*m[5]*p.y*p.z + 2*m[6]*p.y
+			+ m[7]*p.z*p.z + 2*m[8]*p.z
+			+ m[9];
+	}
+
+	double m[10];
+};
+
+struct Collapse {
+	double cost;
+	Uint32 from;
+	Uint32 to;
+	Uint32 fromVersion;
+	Uint32 toVersion;
+
+	bool operator<(const Collapse &o) const { return cost > o.cost; } //cheapest first
+};
+
+inline Uint64 EdgeKey(Uint32 a, Uint32 b) { return a < b ? (Uint64(a) << 32) | b : (Uint64(b) << 32) | a; }
+
+}
+
+Uint32 MeshSimplifier::Simplify(std::vector<Uint8> &vertices, Uint32 stride, Uint32 posOffset, std::vector<Uint32> &indices, Uint32 targetTriangles)
+{
+	PROFILE_SCOPED()
+	assert(indices.size() % 3 == 0);
+	const Uint32 numVertices = vertices.size() / stride;
+	const Uint32 numTris = indices.size() / 3;
+	if (numTris <= targetTriangles)
+		return numTris;
+
+	std::vector<vector3d> pos(numVertices);
+	for (Uint32 v = 0; v < numVertices; v++) {
+		float p[3];
+		memcpy(p, &vertices[v * stride + posOffset], sizeof(p));
+		pos[v] = vector3d(p[0], p[1], p[2]);
+	}
+
+	std::vector<Quadric> quadrics(numVertices);
+	std::vector<std::vector<Uint32> > vertexTris(numVertices);
+	std::unordered_map<Uint64, Uint32> edgeUse;
+	for (Uint32 t = 0; t < numTris; t++) {
+		const Uint32 *tri = &indices[t*3];
+		const vector3d n = (pos[tri[1]] - pos[tri[0]]).Cross(pos[tri[2]] - pos[tri[0]]);
+		const double area = n.Length() * 0.5;
+		const vector3d nn = n.NormalizedSafe();
+		const Quadric q(nn, -nn.Dot(pos[tri[0]]), area);
+		for (int k = 0; k < 3; k++) {
+			quadrics[tri[k]] += q;
+			vertexTris[tri[k]].push_back(t);
+			edgeUse[EdgeKey(tri[k], tri[(k+1)%3])]++;
+		}
+	}
+
+	// planes through the border edges, at right angles to their triangle
+	for (Uint32 t = 0; t < numTris; t++) {
+		const Uint32 *tri = &indices[t*3];
+		const vector3d n = (pos[tri[1]] - pos[tri[0]]).Cross(pos[tri[2]] - pos[tri[0]]).NormalizedSafe();
+		for (int k = 0; k < 3; k++) {
+			const Uint32 a = tri[k], b = tri[(k+1)%3];
+			if (edgeUse[EdgeKey(a, b)] != 1) continue;
+			const vector3d edge = pos[b] - pos[a];
+			const vector3d bn = edge.Cross(n).NormalizedSafe();
+			const Quadric q(bn, -bn.Dot(pos[a]), BORDER_WEIGHT * edge.LengthSqr());
+			quadrics[a] += q;
+			quadrics[b] += q;
+		}
+	}
+
+	std::vector<Uint32> version(numVertices, 0);
+	std::vector<bool> removed(numVertices, false);
+	std::vector<bool> deadTri(numTris, false);
+	std::priority_queue<Collapse> heap;
+
+	auto pushEdge = [&](Uint32 a, Uint32 b) {
+		Quadric q = quadrics[a];
+		q += quadrics[b];
+		const double ea = q.Error(pos[a]);
+		const double eb = q.Error(pos[b]);
+		Collapse c;
+		c.cost = std::min(ea, eb);
+		c.from = ea < eb ? b : a;
+		c.to = ea < eb ? a : b;
+		c.fromVersion = version[c.from];
+		c.toVersion = version[c.to];
+		heap.push(c);
+	};
+	for (const auto &e : edgeUse)
+		pushEdge(Uint32(e.first >> 32), Uint32(e.first & 0xffffffff));
+
+	// would moving 'from' onto 'to' fold or collapse any triangle it keeps?
+	auto flips = [&](Uint32 from, Uint32 to) {
+		for (Uint32 t : vertexTris[from]) {
+			if (deadTri[t]) continue;
+			const Uint32 *tri = &indices[t*3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+			vector3d p[3], q[3];
+			for (int k = 0; k < 3; k++) {
+				p[k] = pos[tri[k]];
+				q[k] = tri[k] == from ? pos[to] : p[k];
+			}
+			const vector3d before = (p[1] - p[0]).Cross(p[2] - p[0]);
+			const vector3d after = (q[1] - q[0]).Cross(q[2] - q[0]);
+			const double len = before.Length() * after.Length();
+			if (len <= 0.0 || before.Dot(after) < MIN_NORMAL_DOT * len)
+				return true;
+		}
+		return false;
+	};
+
+	Uint32 liveTris = numTris;
+	std::vector<Uint32> neighbours;
+	while (liveTris > targetTriangles && !heap.empty()) {
+		const Collapse c = heap.top();
+		heap.pop();
+		if (removed[c.from] || removed[c.to]) continue;
+		if (c.fromVersion != version[c.from] || c.toVersion != version[c.to]) continue;
+		if (flips(c.from, c.to)) continue;
+
+		for (Uint32 t : vertexTris[c.from]) {
+			if (deadTri[t]) continue;
+			Uint32 *tri = &indices[t*3];
+			if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+				deadTri[t] = true;
+				liveTris--;
+				continue;
+			}
+			for (int k = 0; k < 3; k++)
+				if (tri[k] == c.from) tri[k] = c.to;
+			vertexTris[c.to].push_back(t);
+		}
+		vertexTris[c.from].clear();
+		removed[c.from] = true;
+		quadrics[c.to] += quadrics[c.from];
+		version[c.to]++;
+
+		// the edges around 'to' cost something else now
+		neighbours.clear();
+		std::vector<Uint32> &toTris = vertexTris[c.to];
+		toTris.erase(std::remove_if(toTris.begin(), toTris.end(), [&deadTri](Uint32 t) { return deadTri[t]; }), toTris.end());
+		for (Uint32 t : toTris)
+			for (int k = 0; k < 3; k++)
+				if (indices[t*3 + k] != c.to) neighbours.push_back(indices[t*3 + k]);
+		std::sort(neighbours.begin(), neighbours.end());
+		neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		for (Uint32 n : neighbours)
+			pushEdge(c.to, n);
+	}
+
+	// keep the surviving triangles in their old order and the vertices in
+	// order of first use
+	const Uint32 unused = ~0u;
+	std::vector<Uint32> remap(numVertices, unused);
+	std::vector<Uint8> outVertices;
+	std::vector<Uint32> outIndices;
+	outIndices.reserve(liveTris * 3);
+	for (Uint32 t = 0; t < numTris; t++) {
+		if (deadTri[t]) continue;
+		for (int k = 0; k < 3; k++) {
+			const Uint32 v = indices[t*3 + k];
+			if (remap[v] == unused) {
+				remap[v] = outVertices.size() / stride;
+				outVertices.insert(outVertices.end(), vertices.begin() + v * stride, vertices.begin() + (v + 1) * stride);
+			}
+			outIndices.push_back(remap[v]);
+		}
+	}
+	vertices.swap(outVertices);
+	indices.swap(outIndices);
+
+	return liveTris;
+}
+
+}
@@ -0,0 +1,31 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SCENEGRAPH_MESHSIMPLIFIER_H
+#define _SCENEGRAPH_MESHSIMPLIFIER_H
+/*
+ * Quadric error edge collapse (Garland & Heckbert) for generating lower
+ * detail levels of indexed triangle meshes offline.
+ *
+ * An edge always collapses onto one of its two vertices, so normals and
+ * UVs are kept as they are and never interpolated. Edges with only one
+ * triangle get extra planes that hold them in place: with an unwelded
+ * mesh that covers both the open borders and the UV and normal seams.
+ */
+#include "libs.h"
+#include <vector>
+
+namespace SceneGraph {
+
+class MeshSimplifier {
+public:
+	// vertices holds vertexCount * stride bytes with a vector3f position
+	// at posOffset. Collapses edges until at most targetTriangles are left
+	// or nothing can go without folding the surface over, then drops the
+	// vertices that are no longer used. Returns the number of triangles left
+	static Uint32 Simplify(std::vector<Uint8> &vertices, Uint32 stride, Uint32 posOffset, std::vector<Uint32> &indices, Uint32 targetTriangles);
+};
+
+}
+
+#endif
@@ -2,9 +2,18 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "Model.h"
+#include "Billboard.h"
+#include "CollisionGeometry.h"
 #include "CollisionVisitor.h"
+#include "LOD.h"
+#include "ModelNode.h"
 #include "NodeCopyCache.h"
+#include "StaticGeometry.h"
+#include "Thruster.h"
+#include "collider/GeomTree.h"
 #include "graphics/Renderer.h"
+#include "graphics/RenderQueue.h"
+#include "graphics/SpriteBatch.h"
 #include "graphics/TextureBuilder.h"
 #include "graphics/VertexArray.h"
 #include "StringF.h"
@@ -21,12 +30,89 @@ public:
 	std::string label;
 };
 
+//a node can be shared by all instances if nothing in its subtree is moved,
+//attached to or otherwise changed per instance. Builds on the leaves that
+//already share themselves in Clone
+static bool CollectSharedNodes(Node *node, const std::set<const Node*> &perInstance, std::set<const Node*> &shared)
+{
+	if (perInstance.count(node))
+		return false;
+
+	Group *group = dynamic_cast<Group*>(node);
+	if (!group) {
+		if (CollisionGeometry *cg = dynamic_cast<CollisionGeometry*>(node))
+			return !cg->IsDynamic();
+		return dynamic_cast<StaticGeometry*>(node) || dynamic_cast<Thruster*>(node) || dynamic_cast<ModelNode*>(node);
+	}
+
+	//empty groups are attachment points (navlights and such)
+	bool sharable = group->GetNumChildren() > 0;
+	for (unsigned int i = 0; i < group->GetNumChildren(); i++)
+		sharable = CollectSharedNodes(group->GetChildAt(i), perInstance, shared) && sharable;
+	if (sharable)
+		shared.insert(group);
+	return sharable;
+}
+
+class MemoryUsageVisitor : public NodeVisitor {
+public:
+	MemoryUsageVisitor(Model::MemoryUsage &usage) : m_usage(usage), m_sharedDepth(0) {}
+
+	virtual void ApplyNode(Node &n) override { Count(n, sizeof(Node)); }
+	virtual void ApplyLabel(Label3D &l) override { Count(l, sizeof(Label3D)); }
+	virtual void ApplyBillboard(Billboard &b) override { Count(b, sizeof(Billboard)); }
+	virtual void ApplyThruster(Thruster &t) override { Count(t, sizeof(Thruster)); }
+	virtual void ApplyCollisionGeometry(CollisionGeometry &g) override { Count(g, sizeof(CollisionGeometry)); }
+	virtual void ApplyGroup(Group &g) override { CountGroup(g, sizeof(Group)); }
+	virtual void ApplyMatrixTransform(MatrixTransform &m) override { CountGroup(m, sizeof(MatrixTransform)); }
+	virtual void ApplyLOD(LOD &l) override { CountGroup(l, sizeof(LOD)); }
+
+	virtual void ApplyStaticGeometry(StaticGeometry &g) override {
+		Count(g, sizeof(StaticGeometry));
+		if (!m_geoms.insert(&g).second)
+			return;
+		for (unsigned int i = 0; i < g.GetNumMeshes(); i++) {
+			const StaticGeometry::Mesh &mesh = g.GetMeshAt(i);
+			const Graphics::VertexBufferDesc &desc = mesh.vertexBuffer->GetDesc();
+			m_usage.geometry += desc.numVertices * desc.stride;
+			m_usage.geometry += mesh.indexBuffer->GetSize() * mesh.indexBuffer->GetIndexSize();
+		}
+	}
+
+private:
+	//nodes below a shared group are only referenced by it, so go by the
+	//group rather than their own reference count
+	bool IsShared(const Node &n) const { return m_sharedDepth > 0 || n.GetRefCount() > 1; }
+
+	void Count(Node &n, size_t size) {
+		if (IsShared(n)) {
+			m_usage.sharedNodes++;
+		} else {
+			m_usage.instanceNodes++;
+			m_usage.instanceBytes += size;
+		}
+	}
+
+	void CountGroup(Group &g, size_t size) {
+		const bool shared = g.GetRefCount() > 1;
+		Count(g, size);
+		if (shared) m_sharedDepth++;
+		g.Traverse(*this);
+		if (shared) m_sharedDepth--;
+	}
+
+	Model::MemoryUsage &m_usage;
+	int m_sharedDepth;
+	std::set<const StaticGeometry*> m_geoms;
+};
+
 Model::Model(Graphics::Renderer *r, const std::string &name)
 : m_boundingRadius(10.f)
 , m_renderer(r)
 , m_name(name)
 , m_curPatternIndex(0)
 , m_curPattern(0)
+, m_smoothColors(true)
 , m_debugFlags(0)
 {
 	m_root.Reset(new Group(m_renderer));
@@ -38,15 +124,30 @@ Model::Model(const Model &model)
 : m_boundingRadius(model.m_boundingRadius)
 , m_materials(model.m_materials)
 , m_patterns(model.m_patterns)
+, m_patternArray(model.m_patternArray)
 , m_collMesh(model.m_collMesh) //might have to make this per-instance at some point
 , m_renderer(model.m_renderer)
 , m_name(model.m_name)
 , m_curPatternIndex(model.m_curPatternIndex)
 , m_curPattern(model.m_curPattern)
+, m_smoothColors(model.m_smoothColors)
 , m_debugFlags(0)
 {
-	//selective copying of node structure
+	//selective copying of node structure: animated nodes, tags and
+	//everything above them are copied, the rest is shared. The root is
+	//always copied, it is where debug and shield nodes get attached
+	std::set<const Node*> perInstance;
+	for (const Animation *anim : model.m_animations)
+		for (const AnimationChannel &chan : anim->GetChannels())
+			perInstance.insert(chan.node);
+	for (const MatrixTransform *tag : model.m_tags)
+		perInstance.insert(tag);
+	std::set<const Node*> shared;
+	for (unsigned int i = 0; i < model.m_root->GetNumChildren(); i++)
+		CollectSharedNodes(model.m_root->GetChildAt(i), perInstance, shared);
+
 	NodeCopyCache cache;
+	cache.SetSharedNodes(&shared);
 	m_root.Reset(dynamic_cast<Group*>(model.m_root->Clone(&cache)));
 
 	//materials are shared by meshes
@@ -54,8 +155,7 @@ Model::Model(const Model &model)
 		m_decalMaterials[i] = model.m_decalMaterials[i];
 	ClearDecals();
 
-	//create unique color texture, if used
-	//patterns are shared
+	//colors are per instance, patterns are shared
 	if (SupportsPatterns()) {
 		std::vector<Color> colors;
 		colors.push_back(Color::RED);
@@ -91,15 +191,62 @@ Model *Model::MakeInstance() const
 	return m;
 }
 
-void Model::Render(const matrix4x4f &trans, const RenderData *rd)
+Model::MemoryUsage Model::GetMemoryUsage() const
+{
+	MemoryUsage usage;
+
+	MemoryUsageVisitor v(usage);
+	m_root->Accept(v);
+
+	std::set<const Graphics::Texture*> textures;
+	auto addTexture = [&textures, &usage](const Graphics::Texture *t) {
+		if (t && textures.insert(t).second)
+			usage.textures += Graphics::Renderer::GetTextureMemorySize(t->GetDescriptor());
+	};
+	for (const auto &it : m_materials) {
+		const Graphics::Material *mat = it.second.Get();
+		addTexture(mat->texture0);
+		addTexture(mat->texture1);
+		addTexture(mat->texture2);
+		addTexture(mat->texture3);
+	}
+	for (const Pattern &pat : m_patterns)
+		addTexture(pat.texture.Get());
+	addTexture(m_patternArray.Get());
+
+	if (m_collMesh) {
+		if (m_collMesh->GetGeomTree())
+			usage.collision += m_collMesh->GetGeomTree()->GetMemorySize();
+		for (const GeomTree *t : m_collMesh->GetDynGeomTrees())
+			usage.collision += t->GetMemorySize();
+	}
+
+	for (const Animation *anim : m_animations) {
+		usage.instanceBytes += sizeof(Animation);
+		for (const AnimationChannel &chan : anim->GetChannels()) {
+			usage.instanceBytes += sizeof(AnimationChannel);
+			usage.instanceBytes += chan.positionKeys.capacity() * sizeof(PositionKey);
+			usage.instanceBytes += chan.rotationKeys.capacity() * sizeof(RotationKey);
+			usage.instanceBytes += chan.scaleKeys.capacity() * sizeof(ScaleKey);
+		}
+	}
+	usage.instanceBytes += m_renderList.GetMemorySize();
+
+	return usage;
+}
+
+void Model::UpdateMaterials()
 {
-	PROFILE_SCOPED()
 	//update color parameters (materials are shared by model instances)
 	if (m_curPattern) {
 		for (MaterialContainer::const_iterator it = m_materials.begin(); it != m_materials.end(); ++it) {
-			if ((*it).second->GetDescriptor().usePatterns) {
-				(*it).second->texture5 = m_colorMap.GetTexture();
-				(*it).second->texture4 = m_curPattern;
+			Graphics::Material *mat = (*it).second.Get();
+			if (mat->GetDescriptor().usePatterns) {
+				mat->texture4 = m_curPattern;
+				mat->patternArray = m_patternArray.Get();
+				for (int i = 0; i < 3; i++)
+					mat->patternColors[i] = m_curColors[i];
+				mat->smoothPatternColors = m_smoothColors;
 			}
 		}
 	}
@@ -108,6 +255,12 @@ void Model::Render(const matrix4x4f &trans, const RenderData *rd)
 	for (unsigned int i=0; i < MAX_DECAL_MATERIALS; i++)
 		if (m_decalMaterials[i])
 			m_decalMaterials[i]->texture0 = m_curDecals[i];
+}
+
+void Model::Render(const matrix4x4f &trans, const RenderData *rd)
+{
+	PROFILE_SCOPED()
+	UpdateMaterials();
 
 	//Override renderdata if this model is called from ModelNode
 	RenderData params = (rd != 0) ? (*rd) : m_renderData;
@@ -125,10 +278,23 @@ void Model::Render(const matrix4x4f &trans, const RenderData *rd)
 	if (params.nodemask & MASK_IGNORE) {
 		m_root->Render(trans, &params);
 	} else {
+		ModelRenderList &list = GetRenderList();
+		list.Update(trans, params.boundingRadius * params.lodScale);
+		// the opaque pass is sorted by material before it is drawn. this is
+		// flushed before the transparent pass and before the next model can
+		// change the shared material parameters above
+		Graphics::RenderQueue &queue = m_renderer->GetRenderQueue();
+		queue.Begin();
 		params.nodemask = NODE_SOLID;
-		m_root->Render(trans, &params);
+		list.Render(&params);
+		queue.End();
+		// thrusters and navlights go in one draw, or with the rest of the
+		// frame's if the caller opened the batch
+		Graphics::SpriteBatch &sprites = m_renderer->GetSpriteBatch();
+		sprites.Begin();
 		params.nodemask = NODE_TRANSPARENT;
-		m_root->Render(trans, &params);
+		list.Render(&params);
+		sprites.End();
 	}
 
 	if (!m_debugFlags)
@@ -161,21 +327,7 @@ void Model::Render(const matrix4x4f &trans, const RenderData *rd)
 void Model::Render(const std::vector<matrix4x4f> &trans, const RenderData *rd)
 {
 	PROFILE_SCOPED();
-
-	//update color parameters (materials are shared by model instances)
-	if (m_curPattern) {
-		for (MaterialContainer::const_iterator it = m_materials.begin(); it != m_materials.end(); ++it) {
-			if ((*it).second->GetDescriptor().usePatterns) {
-				(*it).second->texture5 = m_colorMap.GetTexture();
-				(*it).second->texture4 = m_curPattern;
-			}
-		}
-	}
-
-	//update decals (materials and geometries are shared)
-	for (unsigned int i = 0; i < MAX_DECAL_MATERIALS; i++)
-		if (m_decalMaterials[i])
-			m_decalMaterials[i]->texture0 = m_curDecals[i];
+	UpdateMaterials();
 
 	//Override renderdata if this model is called from ModelNode
 	RenderData params = (rd != 0) ? (*rd) : m_renderData;
@@ -195,11 +347,95 @@ void Model::Render(const std::vector<matrix4x4f> &trans, const RenderData *rd)
 	} else {
 		params.nodemask = NODE_SOLID;
 		m_root->Render(trans, &params);
+		Graphics::SpriteBatch &sprites = m_renderer->GetSpriteBatch();
+		sprites.Begin();
 		params.nodemask = NODE_TRANSPARENT;
 		m_root->Render(trans, &params);
+		sprites.End();
 	}
 }
 
+void Model::RenderPass(const matrix4x4f &trans, Uint32 nodemask)
+{
+	PROFILE_SCOPED()
+	UpdateMaterials();
+
+	RenderData params = m_renderData;
+	params.boundingRadius = GetDrawClipRadius();
+	params.nodemask = nodemask;
+
+	m_renderer->SetTransform(trans);
+	ModelRenderList &list = GetRenderList();
+	list.Update(trans, params.boundingRadius * params.lodScale);
+	if (nodemask & NODE_SOLID) {
+		Graphics::RenderQueue &queue = m_renderer->GetRenderQueue();
+		queue.Begin();
+		list.Render(&params);
+		queue.End();
+	} else {
+		Graphics::SpriteBatch &sprites = m_renderer->GetSpriteBatch();
+		sprites.Begin();
+		list.Render(&params);
+		sprites.End();
+	}
+}
+
+ModelRenderList &Model::GetRenderList()
+{
+	if (!m_renderList.IsValid(m_root.Get()))
+		m_renderList.Build(m_root.Get());
+	return m_renderList;
+}
+
+void Model::RenderPass(const std::vector<matrix4x4f> &trans, Uint32 nodemask)
+{
+	PROFILE_SCOPED()
+	UpdateMaterials();
+
+	RenderData params = m_renderData;
+	params.boundingRadius = GetDrawClipRadius();
+	params.nodemask = nodemask;
+
+	m_root->Render(trans, &params);
+}
+
+bool Model::CanShareRenderWith(const Model &other) const
+{
+	// instances share their materials with the model they were made from
+	if (m_name != other.m_name || m_materials.size() != other.m_materials.size())
+		return false;
+	for (unsigned int i = 0; i < m_materials.size(); i++)
+		if (m_materials[i].second.Get() != other.m_materials[i].second.Get())
+			return false;
+	if (m_debugFlags || other.m_debugFlags)
+		return false;
+
+	if (m_patternArray) {
+		// each instance's skin goes with its transform
+		if (m_patternArray.Get() != other.m_patternArray.Get())
+			return false;
+	} else if (m_curPattern != other.m_curPattern)
+		return false;
+	else if (m_curPattern) {
+		if (m_smoothColors != other.m_smoothColors)
+			return false;
+		for (int i = 0; i < 3; i++)
+			if (!(m_curColors[i] == other.m_curColors[i]))
+				return false;
+	}
+	for (unsigned int i = 0; i < MAX_DECAL_MATERIALS; i++)
+		if (m_curDecals[i] != other.m_curDecals[i])
+			return false;
+
+	// same source, so the animations are in the same order
+	assert(m_animations.size() == other.m_animations.size());
+	for (unsigned int i = 0; i < m_animations.size(); i++)
+		if (!is_equal_exact(m_animations[i]->GetProgress(), other.m_animations[i]->GetProgress()))
+			return false;
+
+	return true;
+}
+
 void Model::CreateAabbVB()
 {
 	PROFILE_SCOPED()
@@ -387,15 +623,27 @@ void Model::SetPattern(unsigned int index)
 {
 	if (m_patterns.empty() || index > m_patterns.size() - 1) return;
 	const Pattern &pat = m_patterns.at(index);
-	m_colorMap.SetSmooth(pat.smoothColor);
+	m_smoothColors = pat.smoothColor;
 	m_curPatternIndex = index;
 	m_curPattern = pat.texture.Get();
 }
 
+void Model::PackInstanceSkin(matrix4x4f &trans) const
+{
+	// colours as 24 bit integers, which floats hold exactly. the last cell
+	// is 2 or more so the shader can tell it from the 1 of a plain transform
+	for (int i = 0; i < 3; i++) {
+		const Color &c = m_curColors[i];
+		trans[i*4 + 3] = float((Uint32(c.r) << 16) | (Uint32(c.g) << 8) | Uint32(c.b));
+	}
+	trans[15] = float(2 + m_curPatternIndex * 2 + (m_smoothColors ? 1 : 0));
+}
+
 void Model::SetColors(const std::vector<Color> &colors)
 {
 	assert(colors.size() == 3); //primary, seconday, trim
-	m_colorMap.Generate(GetRenderer(), colors.at(0), colors.at(1), colors.at(2));
+	for (int i = 0; i < 3; i++)
+		m_curColors[i] = colors.at(i);
 }
 
 void Model::SetDecalTexture(Graphics::Texture *t, unsigned int index)
@@ -528,17 +776,17 @@ private:
 void Model::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("model")) throw SavedGameCorruptException();
-	Json::Value modelObj = jsonObj["model"];
+	const Json::Value &modelObj = jsonObj["model"];
 	if (!modelObj.isMember("visitor")) throw SavedGameCorruptException();
 	if (!modelObj.isMember("animations")) throw SavedGameCorruptException();
 	if (!modelObj.isMember("cur_pattern_index")) throw SavedGameCorruptException();
 
-	Json::Value visitorArray = modelObj["visitor"];
+	const Json::Value &visitorArray = modelObj["visitor"];
 	if (!visitorArray.isArray()) throw SavedGameCorruptException();
 	LoadVisitorJson lv(visitorArray);
 	m_root->Accept(lv);
 
-	Json::Value animationArray = modelObj["animations"];
+	const Json::Value &animationArray = modelObj["animations"];
 	if (!animationArray.isArray()) throw SavedGameCorruptException();
 	assert(m_animations.size() == animationArray.size());
 	unsigned int arrayIndex = 0;
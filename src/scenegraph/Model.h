@@ -61,9 +61,9 @@
  */
 #include "libs.h"
 #include "Animation.h"
-#include "ColorMap.h"
 #include "Group.h"
 #include "Label3D.h"
+#include "ModelRenderList.h"
 #include "Pattern.h"
 #include "CollMesh.h"
 #include "graphics/Material.h"
@@ -102,8 +102,23 @@ public:
 	Model(Graphics::Renderer *r, const std::string &name);
 	~Model();
 
+	//instances share geometry, collision, materials and every part of the
+	//node tree that isn't animated, tagged or attached to
 	Model *MakeInstance() const;
 
+	//approximate memory use. shared figures are for things every instance of
+	//the model points to, so they only cost once however many ships there are
+	struct MemoryUsage {
+		MemoryUsage() : geometry(0), textures(0), collision(0), sharedNodes(0), instanceNodes(0), instanceBytes(0) {}
+		size_t geometry; //vertex and index buffers (shared)
+		size_t textures; //material and pattern textures (shared)
+		size_t collision; //collision mesh trees (shared)
+		Uint32 sharedNodes;
+		Uint32 instanceNodes;
+		size_t instanceBytes; //copied nodes, animations, colour map and render list
+	};
+	MemoryUsage GetMemoryUsage() const;
+
 	const std::string& GetName() const { return m_name; }
 
 	float GetDrawClipRadius() const { return m_boundingRadius; }
@@ -112,6 +127,20 @@ public:
 	void Render(const matrix4x4f &trans, const RenderData *rd = 0); //ModelNode can override RD
 	void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd = 0); //ModelNode can override RD
 
+	// draw a single pass (NODE_SOLID or NODE_TRANSPARENT) with the model's own render data.
+	// used by ModelBatcher to draw the solid pass of several instances at once
+	void RenderPass(const matrix4x4f &trans, Uint32 nodemask);
+	void RenderPass(const std::vector<matrix4x4f> &trans, Uint32 nodemask);
+	// true if both are instances of the same model that would currently
+	// draw their solid pass identically: same skin, decals and animation state.
+	// models with a pattern array only need the same decals and animations,
+	// as long as each instance's transform has its skin packed in
+	bool CanShareRenderWith(const Model &other) const;
+	// puts this instance's pattern and colours in the bottom row of its
+	// transform, where instanced draws with a pattern array pick them up
+	void PackInstanceSkin(matrix4x4f &trans) const;
+	bool HasPatternArray() const { return m_patternArray.Valid(); }
+
 	RefCountedPtr<CollMesh> CreateCollisionMesh();
 	RefCountedPtr<CollMesh> GetCollisionMesh() const { return m_collMesh; }
 	void SetCollisionMesh(RefCountedPtr<CollMesh> collMesh) { m_collMesh.Reset(collMesh.Get()); }
@@ -173,10 +202,10 @@ private:
 	Model(const Model&);
 
 	static const unsigned int MAX_DECAL_MATERIALS = 4;
-	ColorMap m_colorMap;
 	float m_boundingRadius;
 	MaterialContainer m_materials; //materials are shared throughout the model graph
 	PatternContainer m_patterns;
+	RefCountedPtr<Graphics::Texture> m_patternArray; // see CreatePatternArray
 	RefCountedPtr<CollMesh> m_collMesh;
 	RefCountedPtr<Graphics::Material> m_decalMaterials[MAX_DECAL_MATERIALS]; //spaceship insignia, advertising billboards
 	RefCountedPtr<Group> m_root;
@@ -189,8 +218,15 @@ private:
 	//per-instance flavour data
 	unsigned int m_curPatternIndex;
 	Graphics::Texture *m_curPattern;
+	Color m_curColors[3];
+	bool m_smoothColors;
 	Graphics::Texture *m_curDecals[MAX_DECAL_MATERIALS];
 
+	void UpdateMaterials();
+	// flattened m_root, for drawing single instances
+	ModelRenderList &GetRenderList();
+	ModelRenderList m_renderList;
+
 	// debug support
 	void CreateAabbVB();
 	void DrawAabb();
@@ -0,0 +1,173 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "ModelRenderList.h"
+#include "Group.h"
+#include "LOD.h"
+#include "MatrixTransform.h"
+#include "NodeVisitor.h"
+
+namespace SceneGraph {
+
+class ModelRenderList::Builder : public NodeVisitor {
+public:
+	Builder(ModelRenderList &list)
+	: m_list(list)
+	, m_transform(0)
+	, m_lod(-1)
+	, m_level(0)
+	, m_mask(~0u)
+	, m_checkMask(true)
+	{}
+
+	virtual void ApplyNode(Node &n) override {
+		DrawItem item;
+		item.node = &n;
+		item.transform = m_transform;
+		item.lod = m_lod;
+		item.level = m_level;
+		item.groupMask = m_mask;
+		item.checkMask = m_checkMask;
+		m_list.m_items.push_back(item);
+	}
+
+	virtual void ApplyGroup(Group &g) override {
+		const Uint32 oldMask = m_mask;
+		const bool oldCheck = m_checkMask;
+		if (m_checkMask) m_mask &= g.GetNodeMask();
+		m_checkMask = true;
+		g.Traverse(*this);
+		m_mask = oldMask;
+		m_checkMask = oldCheck;
+	}
+
+	virtual void ApplyMatrixTransform(MatrixTransform &mt) override {
+		const Transform t = { &mt, m_transform };
+		m_list.m_transforms.push_back(t);
+
+		const Uint32 oldTransform = m_transform;
+		m_transform = m_list.m_transforms.size() - 1;
+		ApplyGroup(mt);
+		m_transform = oldTransform;
+	}
+
+	virtual void ApplyLOD(LOD &lod) override {
+		const LodSwitch sw = { &lod, m_transform, m_lod, m_level };
+		m_list.m_lods.push_back(sw);
+
+		const Uint32 oldMask = m_mask;
+		const bool oldCheck = m_checkMask;
+		const Sint32 oldLod = m_lod;
+		const Sint32 oldLevel = m_level;
+		if (m_checkMask) m_mask &= lod.GetNodeMask();
+		m_lod = m_list.m_lods.size() - 1;
+		for (unsigned int i = 0; i < lod.GetNumChildren(); i++) {
+			m_level = i;
+			m_checkMask = false;
+			lod.GetChildAt(i)->Accept(*this);
+		}
+		m_mask = oldMask;
+		m_checkMask = oldCheck;
+		m_lod = oldLod;
+		m_level = oldLevel;
+	}
+
+	// nothing to draw
+	virtual void ApplyCollisionGeometry(CollisionGeometry&) override {}
+
+private:
+	ModelRenderList &m_list;
+	Uint32 m_transform;
+	Sint32 m_lod;
+	Sint32 m_level;
+	Uint32 m_mask;
+	bool m_checkMask;
+};
+
+ModelRenderList::ModelRenderList()
+: m_root(nullptr)
+, m_version(0)
+{
+}
+
+bool ModelRenderList::IsValid(const Group *root) const
+{
+	return m_root == root && m_version == Group::GetStructureVersion();
+}
+
+void ModelRenderList::Build(Group *root)
+{
+	PROFILE_SCOPED()
+	m_root = root;
+	m_version = Group::GetStructureVersion();
+	m_transforms.clear();
+	m_lods.clear();
+	m_items.clear();
+
+	const Transform model = { nullptr, 0 };
+	m_transforms.push_back(model);
+
+	// the root itself is drawn regardless of its mask, like Model::Render
+	Builder b(*this);
+	root->Traverse(b);
+
+	m_world.resize(m_transforms.size());
+	m_lodLevels.resize(m_lods.size());
+}
+
+void ModelRenderList::Update(const matrix4x4f &trans, float boundingRadius)
+{
+	PROFILE_SCOPED()
+	static const matrix4x4f s_ident(matrix4x4f::Identity());
+
+	m_world[0] = trans;
+	for (Uint32 i = 1; i < m_transforms.size(); i++) {
+		const Transform &t = m_transforms[i];
+		const matrix4x4f &local = t.node->GetTransform();
+		if (memcmp(&local, &s_ident, sizeof(matrix4x4f)) == 0)
+			m_world[i] = m_world[t.parent];
+		else
+			m_world[i] = m_world[t.parent] * local;
+	}
+
+	for (Uint32 i = 0; i < m_lods.size(); i++)
+		m_lodLevels[i] = m_lods[i].node->SelectLevel(m_world[m_lods[i].transform], boundingRadius);
+}
+
+bool ModelRenderList::IsLevelVisible(Sint32 lod, Sint32 level) const
+{
+	// parents come before their children, walk up until outside any LOD
+	while (lod >= 0) {
+		if (m_lodLevels[lod] != level)
+			return false;
+		level = m_lods[lod].parentLevel;
+		lod = m_lods[lod].parentLod;
+	}
+	return true;
+}
+
+void ModelRenderList::Render(const RenderData *rd)
+{
+	PROFILE_SCOPED()
+	const Uint32 mask = rd->nodemask;
+	for (const DrawItem &item : m_items) {
+		if (!(item.groupMask & mask))
+			continue;
+		if (item.checkMask && !(item.node->GetNodeMask() & mask))
+			continue;
+		if (!IsLevelVisible(item.lod, item.level))
+			continue;
+		item.node->Render(m_world[item.transform], rd);
+	}
+}
+
+size_t ModelRenderList::GetMemorySize() const
+{
+	return m_transforms.capacity() * sizeof(Transform)
+		+ m_lods.capacity() * sizeof(LodSwitch)
+		+ m_items.capacity() * sizeof(DrawItem)
+		+ m_world.capacity() * sizeof(matrix4x4f)
+		+ m_lodLevels.capacity() * sizeof(Sint32);
+}
+
+}
@@ -0,0 +1,83 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SCENEGRAPH_MODELRENDERLIST_H
+#define _SCENEGRAPH_MODELRENDERLIST_H
+/*
+ * Flattened form of a model's node tree for drawing. The tree is walked
+ * once to collect its transforms, LOD switches and drawable nodes into
+ * arrays; drawing the model is then two linear passes over those arrays
+ * instead of a recursive walk per pass.
+ *
+ * Transforms are read from their MatrixTransform nodes on every Update(),
+ * so animations and moved tags don't need a rebuild. Adding or removing
+ * nodes anywhere does (see Group::GetStructureVersion), as does changing
+ * the node mask of a group; masks of drawable nodes are checked as they
+ * are drawn.
+ */
+#include "libs.h"
+#include <vector>
+
+namespace SceneGraph {
+
+class Group;
+class LOD;
+class MatrixTransform;
+class Node;
+struct RenderData;
+
+class ModelRenderList {
+public:
+	ModelRenderList();
+
+	// built from this root, and no nodes added or removed since
+	bool IsValid(const Group *root) const;
+	void Build(Group *root);
+
+	// world transforms and LOD choices for the model drawn at trans
+	void Update(const matrix4x4f &trans, float boundingRadius);
+	// draws the nodes in rd->nodemask, which must be a single pass
+	// (NODE_SOLID or NODE_TRANSPARENT), using the last Update()
+	void Render(const RenderData *rd);
+
+	size_t GetMemorySize() const;
+
+private:
+	class Builder;
+
+	struct Transform {
+		const MatrixTransform *node;
+		Uint32 parent; // index into m_transforms, earlier than this one
+	};
+	struct LodSwitch {
+		const LOD *node;
+		Uint32 transform;
+		Sint32 parentLod; // -1 if not inside another LOD
+		Sint32 parentLevel;
+	};
+	struct DrawItem {
+		Node *node;
+		Uint32 transform;
+		Sint32 lod; // -1 if not inside a LOD
+		Sint32 level;
+		Uint32 groupMask; // masks of the groups above, and'ed together
+		bool checkMask; // false for direct LOD children, LOD ignores them
+	};
+
+	bool IsLevelVisible(Sint32 lod, Sint32 level) const;
+
+	const Group *m_root;
+	Uint32 m_version;
+	// transform 0 is the model itself
+	std::vector<Transform> m_transforms;
+	std::vector<LodSwitch> m_lods;
+	std::vector<DrawItem> m_items;
+
+	// filled by Update
+	std::vector<matrix4x4f> m_world;
+	std::vector<Sint32> m_lodLevels;
+};
+
+}
+
+#endif
@@ -22,7 +22,7 @@ void ModelSkin::Apply(Model *model) const
 		if (m_decals[i].empty())
 			model->ClearDecal(i);
 		else
-			model->SetDecalTexture(Graphics::TextureBuilder::Decal(stringf("textures/decals/%0.png", m_decals[i])).GetOrCreateTexture(model->GetRenderer(), "decal"), i);
+			model->SetDecalTexture(Graphics::TextureBuilder::Decal(stringf("textures/decals/%0.png", m_decals[i])).GetOrCreateTextureAsync(model->GetRenderer(), "decal"), i);
 	}
 	model->SetLabel(m_label);
 }
@@ -102,28 +102,28 @@ void ModelSkin::Load(Serializer::Reader &rd)
 void ModelSkin::LoadFromJson(const Json::Value &jsonObj)
 {
 	if (!jsonObj.isMember("model_skin")) throw SavedGameCorruptException();
-	Json::Value modelSkinObj = jsonObj["model_skin"];
+	const Json::Value &modelSkinObj = jsonObj["model_skin"];
 
 	if (!modelSkinObj.isMember("colors")) throw SavedGameCorruptException();
 	if (!modelSkinObj.isMember("decals")) throw SavedGameCorruptException();
 	if (!modelSkinObj.isMember("label")) throw SavedGameCorruptException();
 
-	Json::Value colorsArray = modelSkinObj["colors"];
+	const Json::Value &colorsArray = modelSkinObj["colors"];
 	if (!colorsArray.isArray()) throw SavedGameCorruptException();
 	if (colorsArray.size() != 3) throw SavedGameCorruptException();
 	for (unsigned int i = 0; i < 3; i++)
 	{
-		Json::Value colorsArrayEl = colorsArray[i];
+		const Json::Value &colorsArrayEl = colorsArray[i];
 		if (!colorsArrayEl.isMember("color")) throw SavedGameCorruptException();
 		JsonToColor(&(m_colors[i]), colorsArrayEl, "color");
 	}
 
-	Json::Value decalsArray = modelSkinObj["decals"];
+	const Json::Value &decalsArray = modelSkinObj["decals"];
 	if (!decalsArray.isArray()) throw SavedGameCorruptException();
 	if (decalsArray.size() != MAX_DECAL_MATERIALS) throw SavedGameCorruptException();
 	for (unsigned int i = 0; i < MAX_DECAL_MATERIALS; i++)
 	{
-		Json::Value decalsArrayEl = decalsArray[i];
+		const Json::Value &decalsArrayEl = decalsArray[i];
 		if (!decalsArrayEl.isMember("decal")) throw SavedGameCorruptException();
 		m_decals[i] = decalsArrayEl["decal"].asString();
 	}
@@ -44,12 +44,14 @@ struct RenderData
 
 	float boundingRadius;	//updated by model and passed to submodels
 	unsigned int nodemask;
+	float lodScale;			//for views not the size of the screen, scales the pixel size LOD levels are picked by
 
 	RenderData()
 	: linthrust()
 	, angthrust()
 	, boundingRadius(0.f)
 	, nodemask(NODE_SOLID) //draw solids
+	, lodScale(1.f)
 	{
 	}
 };
@@ -6,6 +6,7 @@
 
 #include "RefCounted.h"
 #include <map>
+#include <set>
 
 namespace SceneGraph {
 
@@ -13,7 +14,14 @@ class Node;
 
 class NodeCopyCache {
 public:
+	NodeCopyCache() : m_shared(nullptr) {}
+
+	//nodes in this set are handed back as they are instead of being copied
+	void SetSharedNodes(const std::set<const Node*> *shared) { m_shared = shared; }
+
 	template <typename T> T *Copy(const T *origNode) {
+		if (m_shared && m_shared->count(origNode))
+			return const_cast<T*>(origNode);
 		const bool doCache = origNode->GetRefCount() > 1;
 		if (doCache) {
 			std::map<const Node*,Node*>::const_iterator i = m_cache.find(origNode);
@@ -28,6 +36,7 @@ public:
 
 private:
 	std::map<const Node*,Node*> m_cache;
+	const std::set<const Node*> *m_shared;
 };
 
 }
@@ -5,6 +5,7 @@
 #include "FileSystem.h"
 #include "graphics/Texture.h"
 #include "graphics/TextureBuilder.h"
+#include <memory>
 
 namespace SceneGraph {
 
@@ -35,4 +36,35 @@ Pattern::Pattern(const std::string &name_, const std::string& path, Graphics::Re
 	texture.Reset(Graphics::TextureBuilder(patternPath, sampleMode, true, true, false).CreateTexture(r));
 }
 
+Graphics::Texture *CreatePatternArray(const PatternContainer &patterns, const std::string &path, Graphics::Renderer *r)
+{
+	PROFILE_SCOPED()
+	if (patterns.empty())
+		return nullptr;
+
+	// loaded again rather than read back from the textures. it's only the
+	// once per model, and the files are small
+	std::vector<std::unique_ptr<Graphics::TextureBuilder> > builders;
+	for (const Pattern &pat : patterns) {
+		const Graphics::TextureSampleMode sampleMode = pat.smoothPattern ? Graphics::LINEAR_CLAMP : Graphics::NEAREST_CLAMP;
+		builders.emplace_back(new Graphics::TextureBuilder(FileSystem::JoinPathBelow(path, pat.name), sampleMode, true, true, false));
+		if (pat.smoothPattern != patterns.front().smoothPattern)
+			return nullptr;
+	}
+
+	const Graphics::TextureDescriptor &first = builders.front()->GetDescriptor();
+	for (auto &b : builders) {
+		const Graphics::TextureDescriptor &desc = b->GetDescriptor();
+		if (desc.format != first.format || !(desc.dataSize == first.dataSize) || desc.numberOfMipMaps != first.numberOfMipMaps)
+			return nullptr;
+	}
+
+	Graphics::Texture *t = r->CreateTexture(Graphics::TextureDescriptor(
+		first.format, first.dataSize, first.texSize, first.sampleMode, first.generateMipmaps, first.allowCompression,
+		first.numberOfMipMaps, Graphics::TEXTURE_2D_ARRAY, patterns.size()));
+	for (unsigned int i = 0; i < builders.size(); i++)
+		builders[i]->UpdateTextureLayer(t, i);
+	return t;
+}
+
 }
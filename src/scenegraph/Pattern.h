@@ -31,5 +31,10 @@ struct Pattern {
 
 typedef std::vector<Pattern> PatternContainer;
 
+// all the patterns in one texture array, a layer each in the same order, so
+// that instances of a model can be drawn together whatever their pattern.
+// null if they aren't all the same size, format and sampling
+Graphics::Texture *CreatePatternArray(const PatternContainer &patterns, const std::string &path, Graphics::Renderer *r);
+
 }
 #endif
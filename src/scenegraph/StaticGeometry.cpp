@@ -7,10 +7,15 @@
 #include "BaseLoader.h"
 #include "graphics/Graphics.h"
 #include "graphics/Renderer.h"
+#include "graphics/RenderQueue.h"
 #include "graphics/Material.h"
 
 namespace SceneGraph {
 
+// vertex and index data are aligned in the .sgm so they can be copied
+// straight from the file into buffers
+static const size_t SGM_BLOB_ALIGNMENT = 16;
+
 StaticGeometry::StaticGeometry(Graphics::Renderer *r)
 : Node(r, NODE_SOLID)
 , m_blendMode(Graphics::BLEND_SOLID)
@@ -47,8 +52,10 @@ void StaticGeometry::Render(const matrix4x4f &trans, const RenderData *rd)
 	SDL_assert(m_renderState);
 	Graphics::Renderer *r = GetRenderer();
 	r->SetTransform(trans);
+	// goes straight to the renderer unless the model opened the queue
+	Graphics::RenderQueue &queue = r->GetRenderQueue();
 	for (auto& it : m_meshes)
-		r->DrawBufferIndexed(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, it.material.Get());
+		queue.Submit(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, it.material.Get());
 
 	//DrawBoundingBox(m_boundingBox);
 }
@@ -67,11 +74,11 @@ void StaticGeometry::Render(const std::vector<matrix4x4f> &trans, const RenderDa
 	}
 
 	// Update the InstanceBuffer data
-	for(Uint32 i=0; i<numTrans; i++) {
+	{
 		Graphics::InstanceBuffer* ib = m_instBuffer.Get();
 		matrix4x4f *pBuffer = ib->Map(Graphics::BUFFER_MAP_WRITE);
 		// Copy the transforms into the buffer
-		for(auto mt : trans) {
+		for(auto &mt : trans) {
 			(*pBuffer) = mt;
 			++pBuffer;
 		}
@@ -85,17 +92,26 @@ void StaticGeometry::Render(const std::vector<matrix4x4f> &trans, const RenderDa
 	// process each mesh
 	for (auto& it : m_meshes) {
 		// Due to the shader needing to change we have to get the material and force it to the instanced variant
-		Graphics::MaterialDescriptor mdesc = it.material->GetDescriptor();
-		mdesc.instanced = true;
-		// create the "new" material with the instanced description
-		RefCountedPtr<Graphics::Material> mat(r->CreateMaterial(mdesc));
-		// copy over all of the other details
+		if (!it.instancedMaterial.Valid()) {
+			Graphics::MaterialDescriptor mdesc = it.material->GetDescriptor();
+			mdesc.instanced = true;
+			mdesc.patternArray = it.material->patternArray != nullptr;
+			it.instancedMaterial.Reset(r->CreateMaterial(mdesc));
+		}
+		Graphics::Material *mat = it.instancedMaterial.Get();
+		// copy over all of the other details, the shared material's
+		// parameters are changed by each model instance
 		mat->texture0 = it.material->texture0;
 		mat->texture1 = it.material->texture1;
 		mat->texture2 = it.material->texture2;
 		mat->texture3 = it.material->texture3;
-		mat->texture4 = it.material->texture4;
+		// with a pattern array each instance picks its own layer
+		mat->texture4 = it.material->patternArray ? it.material->patternArray : it.material->texture4;
+		mat->patternArray = it.material->patternArray;
 		mat->texture5 = it.material->texture5;
+		for (int i = 0; i < 3; i++)
+			mat->patternColors[i] = it.material->patternColors[i];
+		mat->smoothPatternColors = it.material->smoothPatternColors;
 		mat->heatGradient = it.material->heatGradient;
 		mat->diffuse = it.material->diffuse;
 		mat->specular = it.material->specular;
@@ -103,7 +119,7 @@ void StaticGeometry::Render(const std::vector<matrix4x4f> &trans, const RenderDa
 		mat->shininess = it.material->shininess;
 		mat->specialParameter0 = it.material->specialParameter0;
 		// finally render using the instance material
-		r->DrawBufferIndexedInstanced(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, mat.Get(), m_instBuffer.Get());
+		r->DrawBufferIndexedInstanced(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, mat, m_instBuffer.Get());
 	}
 }
 
@@ -129,28 +145,28 @@ void StaticGeometry::Save(NodeDatabase &db)
 			attribCombo |= vbDesc.attrib[i].semantic;
 		db.wr->Int32(attribCombo);
 
-		//save positions, normals and uvs interleaved (only known format now)
-		const Uint32 posOffset = vbDesc.GetOffset(Graphics::ATTRIB_POSITION);
-		const Uint32 nrmOffset = vbDesc.GetOffset(Graphics::ATTRIB_NORMAL);
-		const Uint32 uv0Offset = vbDesc.GetOffset(Graphics::ATTRIB_UV0);
-		const Uint32 stride    = vbDesc.stride;
+		//positions, normals and uvs interleaved (only known format now),
+		//written exactly as the vertex buffer holds them
 		db.wr->Int32(vbDesc.numVertices);
-		Uint8 *vtxPtr = mesh.vertexBuffer->Map<Uint8>(Graphics::BUFFER_MAP_READ);
-		for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-            db.wr->Vector3f(*reinterpret_cast<vector3f*>(vtxPtr + i * stride + posOffset));
-            db.wr->Vector3f(*reinterpret_cast<vector3f*>(vtxPtr + i * stride + nrmOffset));
-            db.wr->Float(reinterpret_cast<vector2f*>(vtxPtr + i * stride + uv0Offset)->x);
-            db.wr->Float(reinterpret_cast<vector2f*>(vtxPtr + i * stride + uv0Offset)->y);
-		}
+		const Uint8 *vtxPtr = mesh.vertexBuffer->Map<Uint8>(Graphics::BUFFER_MAP_READ);
+		db.wr->AlignedBlob(reinterpret_cast<const char*>(vtxPtr), vbDesc.numVertices * vbDesc.stride, SGM_BLOB_ALIGNMENT);
 		mesh.vertexBuffer->Unmap();
 
-		//indices
-		const Uint16 *indexPtr = mesh.indexBuffer->Map(Graphics::BUFFER_MAP_READ);
-		const Uint32 numIndices = mesh.indexBuffer->GetSize();
-		db.wr->Int32(numIndices);
-		for (Uint32 i = 0; i < numIndices; i++)
-			db.wr->Int16(indexPtr[i]);
-		mesh.indexBuffer->Unmap();
+		//indices in the buffer's own format, 32-bit only when the mesh needs them
+		Graphics::IndexBuffer *ib = mesh.indexBuffer.Get();
+		std::vector<Uint32> indices;
+		ib->Read(indices);
+		std::vector<char> packed(indices.size() * ib->GetIndexSize());
+		for (size_t i = 0; i < indices.size(); i++) {
+			switch (ib->GetFormat()) {
+			case Graphics::INDEX_FORMAT_UINT8: reinterpret_cast<Uint8*>(&packed[0])[i] = indices[i]; break;
+			case Graphics::INDEX_FORMAT_UINT16: reinterpret_cast<Uint16*>(&packed[0])[i] = indices[i]; break;
+			case Graphics::INDEX_FORMAT_UINT32: reinterpret_cast<Uint32*>(&packed[0])[i] = indices[i]; break;
+			}
+		}
+		db.wr->Byte(ib->GetFormat());
+		db.wr->Int32(indices.size());
+		db.wr->AlignedBlob(packed.empty() ? nullptr : &packed[0], packed.size(), SGM_BLOB_ALIGNMENT);
     }
 }
 
@@ -197,28 +213,24 @@ StaticGeometry *StaticGeometry::Load(NodeDatabase &db)
 		vbDesc.usage = Graphics::BUFFER_USAGE_STATIC;
 		vbDesc.numVertices = db.rd->Int32();
 
+		//the stored vertices are already in buffer layout, copy them straight in
 		RefCountedPtr<Graphics::VertexBuffer> vtxBuffer(db.loader->GetRenderer()->CreateVertexBuffer(vbDesc));
-		const Uint32 posOffset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_POSITION);
-		const Uint32 nrmOffset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_NORMAL);
-		const Uint32 uv0Offset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_UV0);
-		const Uint32 stride = vtxBuffer->GetDesc().stride;
-		Uint8 *vtxPtr = vtxBuffer->Map<Uint8>(BUFFER_MAP_WRITE);
-		for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-			*reinterpret_cast<vector3f*>(vtxPtr + i * stride + posOffset) = db.rd->Vector3f();
-			*reinterpret_cast<vector3f*>(vtxPtr + i * stride + nrmOffset) = db.rd->Vector3f();
-			const float uvx = db.rd->Float();
-			const float uvy = db.rd->Float();
-			*reinterpret_cast<vector2f*>(vtxPtr + i * stride + uv0Offset) = vector2f(uvx, uvy);
-		}
+		const ByteRange vtxData = db.rd->AlignedBlob(SGM_BLOB_ALIGNMENT);
+		if (vtxData.Size() != vbDesc.numVertices * vtxBuffer->GetDesc().stride)
+			throw LoadingError("Vertex data size mismatch");
+		memcpy(vtxBuffer->Map<Uint8>(BUFFER_MAP_WRITE), vtxData.begin, vtxData.Size());
 		vtxBuffer->Unmap();
 
-		//index buffer
+		//index buffer, same again
+		const IndexFormat idxFormat = static_cast<IndexFormat>(db.rd->Byte());
+		if (idxFormat > INDEX_FORMAT_UINT32)
+			throw LoadingError("Unsupported index format");
 		const Uint32 numIndices = db.rd->Int32();
-		RefCountedPtr<Graphics::IndexBuffer> idxBuffer(db.loader->GetRenderer()->CreateIndexBuffer(numIndices, Graphics::BUFFER_USAGE_STATIC));
-		Uint16 *idxPtr = idxBuffer->Map(BUFFER_MAP_WRITE);
-		for (Uint32 i = 0; i < numIndices; i++)
-			idxPtr[i] = db.rd->Int16();
-		idxBuffer->Unmap();
+		const ByteRange idxData = db.rd->AlignedBlob(SGM_BLOB_ALIGNMENT);
+		if (idxData.Size() != numIndices * IndexBuffer::GetIndexSize(idxFormat))
+			throw LoadingError("Index data size mismatch");
+		RefCountedPtr<Graphics::IndexBuffer> idxBuffer(db.loader->GetRenderer()->CreateIndexBuffer(numIndices, Graphics::BUFFER_USAGE_STATIC, idxFormat));
+		idxBuffer->PopulateRaw(idxData.begin, numIndices);
 
 		sg->AddMesh(vtxBuffer, idxBuffer, material);
 	}
@@ -23,6 +23,8 @@ public:
 		RefCountedPtr<Graphics::VertexBuffer> vertexBuffer;
 		RefCountedPtr<Graphics::IndexBuffer> indexBuffer;
 		RefCountedPtr<Graphics::Material> material;
+		// instanced variant of material, made on the first instanced draw
+		RefCountedPtr<Graphics::Material> instancedMaterial;
 	};
 	StaticGeometry(Graphics::Renderer *r);
 	StaticGeometry(const StaticGeometry&, NodeCopyCache *cache = 0);
@@ -10,6 +10,7 @@
 #include "graphics/Material.h"
 #include "graphics/TextureBuilder.h"
 #include "graphics/RenderState.h"
+#include "graphics/SpriteBatch.h"
 
 namespace SceneGraph {
 
@@ -87,24 +88,22 @@ void Thruster::Render(const matrix4x4f &trans, const RenderData *rd)
 	}
 	if (power < 0.001f) return;
 
-	m_tMat->diffuse = m_glowMat->diffuse = baseColor * power;
+	Color tColor = baseColor * power;
+	Color glowColor = tColor;
 
 	//directional fade
 	vector3f cdir = vector3f(trans * -dir).Normalized();
 	vector3f vdir = vector3f(trans[2], trans[6], -trans[10]).Normalized();
 	// XXX check this for transition to new colors.
-	m_glowMat->diffuse.a = Easing::Circ::EaseIn(Clamp(vdir.Dot(cdir), 0.f, 1.f), 0.f, 1.f, 1.f) * 255;
-	m_tMat->diffuse.a = 255 - m_glowMat->diffuse.a;
-
-	Graphics::Renderer *r = GetRenderer();
-	if( !m_tBuffer.Valid() ) {
-		m_tBuffer.Reset(CreateThrusterGeometry(r, m_tMat.Get()));
-		m_glowBuffer.Reset(CreateGlowGeometry(r, m_glowMat.Get()));
-	}
-
-	r->SetTransform(trans);
-	r->DrawBuffer(m_tBuffer.Get(), m_renderState, m_tMat.Get());
-	r->DrawBuffer(m_glowBuffer.Get(), m_renderState, m_glowMat.Get());
+	glowColor.a = Easing::Circ::EaseIn(Clamp(vdir.Dot(cdir), 0.f, 1.f), 0.f, 1.f, 1.f) * 255;
+	tColor.a = 255 - glowColor.a;
+
+	// drawn along with all other thrusters and navlights in view
+	const Graphics::VertexArray &flame = GetThrusterGeometry();
+	const Graphics::VertexArray &glow = GetGlowGeometry();
+	Graphics::SpriteBatch &batch = GetRenderer()->GetSpriteBatch();
+	batch.Add(trans, &flame.position[0], &flame.uv0[0], flame.GetNumVerts(), tColor, m_renderState, m_tMat->texture0);
+	batch.Add(trans, &glow.position[0], &glow.uv0[0], glow.GetNumVerts(), glowColor, m_renderState, m_glowMat->texture0);
 }
 
 void Thruster::Save(NodeDatabase &db)
@@ -124,9 +123,11 @@ Thruster *Thruster::Load(NodeDatabase &db)
 	return t;
 }
 
-Graphics::VertexBuffer *Thruster::CreateThrusterGeometry(Graphics::Renderer *r, Graphics::Material *mat)
+const Graphics::VertexArray &Thruster::GetThrusterGeometry()
 {
-	Graphics::VertexArray verts(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
+	static Graphics::VertexArray verts(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
+	if (verts.GetNumVerts() > 0)
+		return verts;
 
 	//zero at thruster center
 	//+x down
@@ -161,23 +162,14 @@ Graphics::VertexBuffer *Thruster::CreateThrusterGeometry(Graphics::Renderer *r,
 		four.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
 	}
 
-	//create buffer and upload data
-	Graphics::VertexBufferDesc vbd;
-	vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-	vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-	vbd.attrib[1].semantic = Graphics::ATTRIB_UV0;
-	vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT2;
-	vbd.numVertices = verts.GetNumVerts();
-	vbd.usage = Graphics::BUFFER_USAGE_STATIC;
-	Graphics::VertexBuffer *vb = r->CreateVertexBuffer(vbd);
-	vb->Populate(verts);
-
-	return vb;
+	return verts;
 }
 
-Graphics::VertexBuffer *Thruster::CreateGlowGeometry(Graphics::Renderer *r, Graphics::Material *mat)
+const Graphics::VertexArray &Thruster::GetGlowGeometry()
 {
-	Graphics::VertexArray verts(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
+	static Graphics::VertexArray verts(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
+	if (verts.GetNumVerts() > 0)
+		return verts;
 
 	//create glow billboard for linear thrusters
 	const float w = 0.2;
@@ -206,18 +198,7 @@ Graphics::VertexBuffer *Thruster::CreateGlowGeometry(Graphics::Renderer *r, Grap
 		two.z = three.z = four.z = one.z;
 	}
 
-	//create buffer and upload data
-	Graphics::VertexBufferDesc vbd;
-	vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-	vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-	vbd.attrib[1].semantic = Graphics::ATTRIB_UV0;
-	vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT2;
-	vbd.numVertices = verts.GetNumVerts();
-	vbd.usage = Graphics::BUFFER_USAGE_STATIC;
-	Graphics::VertexBuffer *vb = r->CreateVertexBuffer(vbd);
-	vb->Populate(verts);
-
-	return vb;
+	return verts;
 }
 
 }
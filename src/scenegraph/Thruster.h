@@ -11,7 +11,7 @@
 
 namespace Graphics {
 	class Renderer;
-	class VertexBuffer;
+	class VertexArray;
 	class Material;
 	class RenderState;
 }
@@ -30,12 +30,11 @@ public:
 	static Thruster *Load(NodeDatabase&);
 
 private:
-	static Graphics::VertexBuffer* CreateThrusterGeometry(Graphics::Renderer*, Graphics::Material*);
-	static Graphics::VertexBuffer* CreateGlowGeometry(Graphics::Renderer*, Graphics::Material*);
+	// built once, shared by all thrusters
+	static const Graphics::VertexArray &GetThrusterGeometry();
+	static const Graphics::VertexArray &GetGlowGeometry();
 	RefCountedPtr<Graphics::Material> m_tMat;
 	RefCountedPtr<Graphics::Material> m_glowMat;
-	RefCountedPtr<Graphics::VertexBuffer> m_tBuffer;
-	RefCountedPtr<Graphics::VertexBuffer> m_glowBuffer;
 	Graphics::RenderState *m_renderState;
 	bool linearOnly;
 	vector3f dir;
@@ -360,18 +360,15 @@ static size_t bufread_or_die(void *ptr, size_t size, size_t nmemb, ByteRange &bu
 	return read_count;
 }
 
-// XXX this sucks, but there isn't a reliable cross-platform way to get them
-#ifndef INT16_MIN
-# define INT16_MIN   (-32767-1)
-#endif
-#ifndef INT16_MAX
-# define INT16_MAX   (32767)
-#endif
-#ifndef UINT16_MAX
-# define UINT16_MAX  (65535)
-#endif
-
-Terrain::Terrain(const SystemBody *body) : m_seed(body->GetSeed()), m_rand(body->GetSeed()), m_heightScaling(0), m_minh(0), m_minBody(body) {
+static void check_remaining_or_die(size_t size, size_t nmemb, const ByteRange &buf)
+{
+	if (buf.Size() < size * nmemb) {
+		Output("Error: failed to read file (truncated)\n");
+		abort();
+	}
+}
+
+Terrain::Terrain(const SystemBody *body) : m_seed(body->GetSeed()), m_rand(body->GetSeed()), m_heightMap(nullptr), m_heightMapScaled(nullptr), m_heightScaling(0), m_minh(0), m_minBody(body) {
 
 	// load the heightmap
 	if (!body->GetHeightMapFilename().empty()) {
@@ -380,12 +377,10 @@ Terrain::Terrain(const SystemBody *body) : m_seed(body->GetSeed()), m_rand(body-
 			Output("Error: could not open file '%s'\n", body->GetHeightMapFilename().c_str());
 			abort();
 		}
+		m_heightMapData = fdata;
 
 		ByteRange databuf = fdata->AsByteRange();
 
-		Sint16 minHMap = INT16_MAX, maxHMap = INT16_MIN;
-		Uint16 minHMapScld = UINT16_MAX, maxHMapScld = 0;
-
 		// XXX unify heightmap types
 		switch (body->GetHeightMapFractal()) {
 			case 0: {
@@ -394,20 +389,8 @@ Terrain::Terrain(const SystemBody *body) : m_seed(body->GetSeed()), m_rand(body-
 				bufread_or_die(&v, 2, 1, databuf); m_heightMapSizeY = v;
 				const Uint32 heightmapPixelArea = (m_heightMapSizeX * m_heightMapSizeY);
 
-				std::unique_ptr<Sint16[]> heightMap(new Sint16[heightmapPixelArea]);
-				bufread_or_die(heightMap.get(), sizeof(Sint16), heightmapPixelArea, databuf);
-				m_heightMap.reset(new double[heightmapPixelArea]);
-				double *pHeightMap = m_heightMap.get();
-				for(Uint32 i=0; i<heightmapPixelArea; i++) {
-					const Sint16 val = heightMap.get()[i];
-					minHMap = std::min(minHMap, val);
-					maxHMap = std::max(maxHMap, val);
-					// store then increment pointer
-					(*pHeightMap) = val;
-					++pHeightMap;
-				}
-				assert(pHeightMap == &m_heightMap[heightmapPixelArea]);
-				//Output("minHMap = (%hd), maxHMap = (%hd)\n", minHMap, maxHMap);
+				check_remaining_or_die(sizeof(Sint16), heightmapPixelArea, databuf);
+				m_heightMap = reinterpret_cast<const Sint16*>(databuf.begin);
 				break;
 			}
 
@@ -425,20 +408,8 @@ Terrain::Terrain(const SystemBody *body) : m_seed(body->GetSeed()), m_rand(body-
 				bufread_or_die(&te, 8, 1, databuf);
 				m_minh = te;
 
-				std::unique_ptr<Uint16[]> heightMapScaled(new Uint16[heightmapPixelArea]);
-				bufread_or_die(heightMapScaled.get(), sizeof(Uint16), heightmapPixelArea, databuf);
-				m_heightMap.reset(new double[heightmapPixelArea]);
-				double *pHeightMap = m_heightMap.get();
-				for(Uint32 i=0; i<heightmapPixelArea; i++) {
-					const Uint16 val = heightMapScaled[i];
-					minHMapScld = std::min(minHMapScld, val);
-					maxHMapScld = std::max(maxHMapScld, val);
-					// store then increment pointer
-					(*pHeightMap) = val;
-					++pHeightMap;
-				}
-				assert(pHeightMap == &m_heightMap[heightmapPixelArea]);
-				//Output("minHMapScld = (%hu), maxHMapScld = (%hu)\n", minHMapScld, maxHMapScld);
+				check_remaining_or_die(sizeof(Uint16), heightmapPixelArea, databuf);
+				m_heightMapScaled = reinterpret_cast<const Uint16*>(databuf.begin);
 				break;
 			}
 
@@ -631,6 +602,73 @@ void Terrain::SetFracDef(const unsigned int index, const double featureHeightMet
 	//Output("%d octaves\n", m_fracdef[index].octaves); //print
 }
 
+// FNV-1a
+static void HashBytes(Uint64 &hash, const void *data, size_t len)
+{
+	const Uint8 *bytes = static_cast<const Uint8*>(data);
+	for (size_t i = 0; i < len; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+}
+
+template <typename T>
+static void HashValue(Uint64 &hash, const T &value) { HashBytes(hash, &value, sizeof(value)); }
+
+Uint64 Terrain::GetSignature() const
+{
+	Uint64 hash = 14695981039346656037ULL;
+	const char *heightName = GetHeightFractalName();
+	const char *colorName = GetColorFractalName();
+	HashBytes(hash, heightName, strlen(heightName)+1);
+	HashBytes(hash, colorName, strlen(colorName)+1);
+	HashValue(hash, m_seed);
+	HashValue(hash, textures);
+	HashValue(hash, m_fracnum);
+	HashValue(hash, m_fracmult);
+	HashValue(hash, m_sealevel);
+	HashValue(hash, m_icyness);
+	HashValue(hash, m_volcanic);
+	HashValue(hash, m_maxHeight);
+	HashValue(hash, m_planetRadius);
+	HashValue(hash, m_minBody.m_aspectRatio);
+	HashValue(hash, m_heightMapSizeX);
+	HashValue(hash, m_heightMapSizeY);
+	HashValue(hash, m_heightScaling);
+	HashValue(hash, m_minh);
+	HashValue(hash, m_entropy);
+	HashValue(hash, m_rockColor);
+	HashValue(hash, m_darkrockColor);
+	HashValue(hash, m_greyrockColor);
+	HashValue(hash, m_plantColor);
+	HashValue(hash, m_darkplantColor);
+	HashValue(hash, m_sandColor);
+	HashValue(hash, m_darksandColor);
+	HashValue(hash, m_dirtColor);
+	HashValue(hash, m_darkdirtColor);
+	HashValue(hash, m_gglightColor);
+	HashValue(hash, m_ggdarkColor);
+	for (Uint32 i = 0; i < MAX_FRACDEFS; i++) {
+		HashValue(hash, m_fracdef[i].amplitude);
+		HashValue(hash, m_fracdef[i].frequency);
+		HashValue(hash, m_fracdef[i].lacunarity);
+		HashValue(hash, m_fracdef[i].octaves);
+	}
+	return hash;
+}
+
+void Terrain::GetHeights(const vector3d *p, double *heights, const int count) const
+{
+	for (int i = 0; i < count; i++)
+		heights[i] = GetHeight(p[i]);
+}
+
+void Terrain::GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, const int count) const
+{
+	for (int i = 0; i < count; i++)
+		colors[i] = GetColor(p[i], heights[i], norms[i]);
+}
+
 void Terrain::DebugDump() const
 {
 	Output("Terrain state dump:\n");
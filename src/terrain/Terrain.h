@@ -7,6 +7,8 @@
 #include "libs.h"
 #include "galaxy/StarSystem.h"
 
+namespace FileSystem { class FileData; }
+
 #ifdef _MSC_VER
 #pragma warning(disable : 4250)			// workaround for MSVC 2008 multiple inheritance bug
 #endif
@@ -43,11 +45,21 @@ public:
 	virtual double GetHeight(const vector3d &p) const = 0;
 	virtual vector3d GetColor(const vector3d &p, double height, const vector3d &norm) const = 0;
 
+	// batch versions of the above, for filling whole patches at once. the
+	// fractal templates override these so the per point calls aren't virtual
+	virtual void GetHeights(const vector3d *p, double *heights, const int count) const;
+	virtual void GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, const int count) const;
+
 	virtual const char *GetHeightFractalName() const = 0;
 	virtual const char *GetColorFractalName() const = 0;
 
 	double GetMaxHeight() const { return m_maxHeight; }
 
+	// hash of everything that goes into the generated heights and colours
+	// (fractal choice, seed, detail settings and fractal parameters). two
+	// terrains with the same signature produce the same surface
+	Uint64 GetSignature() const;
+
 	Uint32 GetSurfaceEffects() const { return m_surfaceEffects; }
 
 	void DebugDump() const;
@@ -77,7 +89,11 @@ protected:
 
 	// heightmap stuff
 	// XXX unify heightmap types
-	std::unique_ptr<double[]> m_heightMap;
+	// the samples are read straight out of the file, which the file system
+	// maps, so only the pages the patches actually sample are ever loaded
+	RefCountedPtr<FileSystem::FileData> m_heightMapData;
+	const Sint16 *m_heightMap;         // fractal 0
+	const Uint16 *m_heightMapScaled;   // fractal 1
 	double m_heightScaling, m_minh;
 
 	int m_heightMapSizeX;
@@ -129,6 +145,10 @@ template <typename HeightFractal>
 class TerrainHeightFractal : virtual public Terrain {
 public:
 	virtual double GetHeight(const vector3d &p) const;
+	virtual void GetHeights(const vector3d *p, double *heights, const int count) const {
+		for (int i = 0; i < count; i++)
+			heights[i] = TerrainHeightFractal<HeightFractal>::GetHeight(p[i]);
+	}
 	virtual const char *GetHeightFractalName() const;
 protected:
 	TerrainHeightFractal(const SystemBody *body);
@@ -140,6 +160,10 @@ template <typename ColorFractal>
 class TerrainColorFractal : virtual public Terrain {
 public:
 	virtual vector3d GetColor(const vector3d &p, double height, const vector3d &norm) const;
+	virtual void GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, const int count) const {
+		for (int i = 0; i < count; i++)
+			colors[i] = TerrainColorFractal<ColorFractal>::GetColor(p[i], heights[i], norms[i]);
+	}
 	virtual const char *GetColorFractalName() const;
 protected:
 	TerrainColorFractal(const SystemBody *body);
@@ -254,6 +278,11 @@ class TerrainColorTFGood;
 class TerrainColorTFPoor;
 class TerrainColorVolcanic;
 
+// colour fractals that put their noise through the batched octave functions
+template <> void TerrainColorFractal<TerrainColorGGNeptune>::GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, const int count) const;
+template <> void TerrainColorFractal<TerrainColorGGSaturn>::GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, const int count) const;
+template <> void TerrainColorFractal<TerrainColorGGUranus>::GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, const int count) const;
+
 #ifdef _MSC_VER
 #pragma warning(default : 4250)
 #endif
@@ -38,3 +38,31 @@ vector3d TerrainColorFractal<TerrainColorGGNeptune>::GetColor(const vector3d &p,
 	return interpolate_color(n, vector3d(.04, .05, .15), vector3d(.80,.94,.96));
 }
 
+template <>
+void TerrainColorFractal<TerrainColorGGNeptune>::GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, const int count) const
+{
+	// the bands only depend on latitude and go through the batched noise,
+	// the spot is done a point at a time
+	vector3d band[OCTAVE_BATCH];
+	double n[OCTAVE_BATCH], t[OCTAVE_BATCH];
+	for (int start = 0; start < count; start += OCTAVE_BATCH) {
+		const int num = std::min(count - start, OCTAVE_BATCH);
+		for (int i = 0; i < num; i++)
+			band[i] = vector3d(3.142*p[start+i].y*p[start+i].y);
+		octavenoise(GetFracDef(2), 0.6, band, n, num);
+		ridged_octavenoise(GetFracDef(3), 0.55, band, t, num);
+		for (int i = 0; i < num; i++)
+			n[i] = 0.8*n[i] + 0.25*t[i];
+		octavenoise(GetFracDef(3), 0.5, band, t, num);
+		for (int i = 0; i < num; i++) {
+			const vector3d &q = p[start+i];
+			double c = n[i] + 0.2*t[i];
+			c += 0.8*billow_octavenoise(GetFracDef(1), 0.8, vector3d(noise(q*3.142)*q))*
+				 megavolcano_function(GetFracDef(0), q);
+			c /= 2.0;
+			c *= c*c;
+			colors[start+i] = interpolate_color(c, vector3d(.04, .05, .15), vector3d(.80,.94,.96));
+		}
+	}
+}
+
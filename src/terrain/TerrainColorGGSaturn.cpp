@@ -38,3 +38,41 @@ vector3d TerrainColorFractal<TerrainColorGGSaturn>::GetColor(const vector3d &p,
 	return interpolate_color(n, vector3d(.69, .53, .43), vector3d(.99, .76, .62));
 }
 
+template <>
+void TerrainColorFractal<TerrainColorGGSaturn>::GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, const int count) const
+{
+	// the bands go through the batched noise, the spot is done a point at
+	// a time
+	vector3d band[OCTAVE_BATCH], warped[OCTAVE_BATCH];
+	double n[OCTAVE_BATCH], t[OCTAVE_BATCH];
+	for (int start = 0; start < count; start += OCTAVE_BATCH) {
+		const int num = std::min(count - start, OCTAVE_BATCH);
+		for (int i = 0; i < num; i++) {
+			const vector3d &q = p[start+i];
+			band[i] = vector3d(3.142*q.y*q.y);
+			warped[i] = q*q.y*q.y;
+		}
+		ridged_octavenoise(GetFracDef(0), 0.7, band, n, num);
+		for (int i = 0; i < num; i++)
+			n[i] *= 0.4;
+		octavenoise(GetFracDef(1), 0.6, band, t, num);
+		for (int i = 0; i < num; i++)
+			n[i] += 0.4*t[i];
+		octavenoise(GetFracDef(2), 0.5, band, t, num);
+		for (int i = 0; i < num; i++)
+			n[i] += 0.3*t[i];
+		octavenoise(GetFracDef(0), 0.7, warped, t, num);
+		for (int i = 0; i < num; i++)
+			n[i] += 0.8*t[i];
+		ridged_octavenoise(GetFracDef(1), 0.7, warped, t, num);
+		for (int i = 0; i < num; i++) {
+			const vector3d &q = p[start+i];
+			double c = (n[i] + 0.5*t[i]) / 2.0;
+			c *= c*c;
+			c += billow_octavenoise(GetFracDef(0), 0.8, vector3d(noise(q*3.142)*q))*
+				 megavolcano_function(GetFracDef(3), q);
+			colors[start+i] = interpolate_color(c, vector3d(.69, .53, .43), vector3d(.99, .76, .62));
+		}
+	}
+}
+
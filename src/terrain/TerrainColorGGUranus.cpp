@@ -29,3 +29,25 @@ vector3d TerrainColorFractal<TerrainColorGGUranus>::GetColor(const vector3d &p,
 	return interpolate_color(n, vector3d(.4, .5, .55), vector3d(.85,.95,.96));
 }
 
+template <>
+void TerrainColorFractal<TerrainColorGGUranus>::GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, const int count) const
+{
+	vector3d band[OCTAVE_BATCH];
+	double n[OCTAVE_BATCH], t[OCTAVE_BATCH];
+	for (int start = 0; start < count; start += OCTAVE_BATCH) {
+		const int num = std::min(count - start, OCTAVE_BATCH);
+		for (int i = 0; i < num; i++)
+			band[i] = vector3d(3.142*p[start+i].y*p[start+i].y);
+		ridged_octavenoise(GetFracDef(0), 0.7, band, n, num);
+		octavenoise(GetFracDef(1), 0.6, band, t, num);
+		for (int i = 0; i < num; i++)
+			n[i] = 0.5*n[i] + 0.5*t[i];
+		octavenoise(GetFracDef(2), 0.5, band, t, num);
+		for (int i = 0; i < num; i++) {
+			double c = (n[i] + 0.2*t[i]) / 2.0;
+			c *= c*c;
+			colors[start+i] = interpolate_color(c, vector3d(.4, .5, .55), vector3d(.85,.95,.96));
+		}
+	}
+}
+
@@ -158,6 +158,45 @@ namespace TerrainNoise {
 		return sqrt(10.0 * fabs(n));
 	}
 
+	// batched, single precision versions for colour fractals, on up to
+	// OCTAVE_BATCH points at a time. each octave goes through the batched
+	// float noise, four points at a time where that's vectorised. heights
+	// must stay with the double versions above
+	static const int OCTAVE_BATCH = 64;
+
+	inline void octave_sum(const fracdef_t &def, const double persistence, const vector3d *p, double *n, const int count) {
+		assert(count <= OCTAVE_BATCH);
+		vector3f scaled[OCTAVE_BATCH];
+		float octave[OCTAVE_BATCH];
+		for (int i=0; i<count; i++)
+			n[i] = 0.0;
+		double amplitude = persistence;
+		double frequency = def.frequency;
+		for (int o=0; o<def.octaves; o++) {
+			for (int i=0; i<count; i++)
+				scaled[i] = vector3f(frequency*p[i]);
+			noise(scaled, octave, count);
+			for (int i=0; i<count; i++)
+				n[i] += amplitude * octave[i];
+			amplitude *= persistence;
+			frequency *= def.lacunarity;
+		}
+	}
+
+	inline void octavenoise(const fracdef_t &def, const double persistence, const vector3d *p, double *out, const int count) {
+		octave_sum(def, persistence, p, out, count);
+		for (int i=0; i<count; i++)
+			out[i] = (out[i]+1.0)*0.5;
+	}
+
+	inline void ridged_octavenoise(const fracdef_t &def, const double persistence, const vector3d *p, double *out, const int count) {
+		octave_sum(def, persistence, p, out, count);
+		for (int i=0; i<count; i++) {
+			const double n = 1.0 - fabs(out[i]);
+			out[i] = n*n;
+		}
+	}
+
 	// not really a noise function but no better place for it
 	inline vector3d interpolate_color(const double n, const vector3d &start, const vector3d &end) {
 		const double nClamped = Clamp(n, 0.0, 1.0);
@@ -43,6 +43,30 @@ void test_random() {
 	cout << "64-bit seeds, Double out: " << endl;
 	for (int i=0; i<5; ++i) cout << i+1 << ": " << (fabs(rnd.Double() - in64outDbl[i]) < 0.000001 ? "pass" : "fail") << endl; // close enough
 
+	// the bulk generators must give the same stream as the single calls
+	Random one(in32, 5), bulk(in32, 5);
+	Uint32 bulk32[64];
+	double bulkDbl[64];
+
+	cout << "Bulk Uint32 out: " << endl;
+	bulk.FillInt32(bulk32, 64);
+	bool same = true;
+	for (int i=0; i<64; ++i) same = same && one.Int32() == bulk32[i];
+	cout << (same ? "pass" : "fail") << endl;
+
+	cout << "Bulk Double out: " << endl;
+	bulk.FillDouble(bulkDbl, 64, -3.0, 5.0);
+	same = true;
+	for (int i=0; i<64; ++i) same = same && one.Double(-3.0, 5.0) == bulkDbl[i];
+	cout << (same ? "pass" : "fail") << endl;
+
+	cout << "Bulk Normal out: " << endl;
+	bulk.FillNormal(bulkDbl, 63, 1.0, 2.0);
+	same = true;
+	for (int i=0; i<63; ++i) same = same && one.Normal(1.0, 2.0) == bulkDbl[i];
+	same = same && one.Int32() == bulk.Int32();
+	cout << (same ? "pass" : "fail") << endl;
+
 	cout << "--------------------" << endl;
 	cout << "End of random tests." << endl;
 	cout << "--------------------" << endl;
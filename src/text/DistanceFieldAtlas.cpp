@@ -0,0 +1,195 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "DistanceFieldAtlas.h"
+#include "FileSystem.h"
+#include "graphics/Renderer.h"
+#include "utils.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#undef FT_FILE // defined by FreeType, conflicts with a symbol name from FileSystem
+
+#include <algorithm>
+
+static const int ATLAS_SIZE = 2048;
+static const int ATLAS_PAGES = 8;
+
+namespace Text {
+
+DistanceFieldAtlas *DistanceFieldAtlas::s_instance = nullptr;
+
+RefCountedPtr<DistanceFieldAtlas> DistanceFieldAtlas::Get(Graphics::Renderer *renderer)
+{
+	if (!s_instance)
+		s_instance = new DistanceFieldAtlas(renderer);
+	return RefCountedPtr<DistanceFieldAtlas>(s_instance);
+}
+
+DistanceFieldAtlas::DistanceFieldAtlas(Graphics::Renderer *renderer)
+	: m_ftLib(nullptr)
+{
+	FT_Error err = FT_Init_FreeType(&m_ftLib);
+	if (err != 0) {
+		Output("Couldn't create FreeType library context (%d)\n", err);
+		abort();
+	}
+
+	// linear sampling is what makes the field interpolate between texels
+	m_atlas.Reset(new GlyphAtlas(renderer, ATLAS_SIZE, ATLAS_PAGES, Graphics::TEXTURE_INTENSITY_8, Graphics::LINEAR_CLAMP));
+
+	Graphics::RenderStateDesc rsd;
+	rsd.blendMode = Graphics::BLEND_ALPHA_PREMULT;
+	rsd.depthWrite = false;
+	m_renderState = renderer->CreateRenderState(rsd);
+
+	Graphics::MaterialDescriptor desc;
+	desc.effect = Graphics::EFFECT_UI_DISTANCE_FIELD;
+	desc.vertexColors = true;
+	desc.textures = 1;
+	m_mat.reset(renderer->CreateMaterial(desc));
+	m_mat->texture0 = m_atlas->GetTexture();
+}
+
+DistanceFieldAtlas::~DistanceFieldAtlas()
+{
+	for (auto i = m_faces.begin(); i != m_faces.end(); ++i)
+		FT_Done_Face((*i).second.first);
+	FT_Done_FreeType(m_ftLib);
+	s_instance = nullptr;
+}
+
+FT_Face DistanceFieldAtlas::GetFTFace(const std::string &fontFile)
+{
+	{
+	auto i = m_faces.find(fontFile);
+	if (i != m_faces.end())
+		return (*i).second.first;
+	}
+
+	RefCountedPtr<FileSystem::FileData> fd = FileSystem::gameDataFiles.ReadFile("fonts/" + fontFile);
+	if (!fd) {
+		Output("Terrible error! Couldn't load '%s'.\n", fontFile.c_str());
+		abort();
+	}
+
+	FT_Face ftFace;
+	FT_Error err;
+
+	if (0 != (err = FT_New_Memory_Face(m_ftLib,
+			reinterpret_cast<const FT_Byte*>(fd->GetData()),
+			fd->GetSize(), 0, &ftFace))) {
+		Output("Terrible error! Couldn't understand '%s'; error %d.\n", fontFile.c_str(), err);
+		abort();
+	}
+
+	FT_Set_Pixel_Sizes(ftFace, BASE_SIZE, BASE_SIZE);
+
+	m_faces.insert(std::make_pair(fontFile, std::make_pair(ftFace, fd)));
+
+	return ftFace;
+}
+
+const DistanceFieldAtlas::Glyph *DistanceFieldAtlas::GetGlyph(const std::string &fontFile, Uint32 chr, bool &noRoom)
+{
+	noRoom = false;
+	const std::pair<std::string,Uint32> key(fontFile, chr);
+	auto i = m_glyphs.find(key);
+	if (i != m_glyphs.end()) {
+		Entry &entry = (*i).second;
+		if (entry.empty)
+			return nullptr;
+		if (m_atlas->IsValid(entry.glyph.slot.page, entry.glyph.slot.epoch)) {
+			m_atlas->Touch(entry.glyph.slot.page);
+			return &entry.glyph;
+		}
+	}
+
+	Glyph glyph;
+	if (!BakeGlyph(GetFTFace(fontFile), chr, glyph)) {
+		// no room right now. try again next time rather than remembering it
+		if (i != m_glyphs.end())
+			m_glyphs.erase(i);
+		noRoom = true;
+		return nullptr;
+	}
+
+	Entry &entry = m_glyphs[key];
+	entry.glyph = glyph;
+	entry.empty = glyph.width == 0;
+	return entry.empty ? nullptr : &entry.glyph;
+}
+
+bool DistanceFieldAtlas::BakeGlyph(FT_Face face, Uint32 chr, Glyph &glyph)
+{
+	glyph.width = glyph.height = 0;
+	glyph.left = glyph.top = 0;
+
+	// hinting is for one pixel grid, and this gets drawn at all of them
+	FT_Error err = FT_Load_Char(face, chr, FT_LOAD_RENDER | FT_LOAD_NO_HINTING);
+	if (err) {
+		Output("Error %d loading glyph\n", err);
+		return true;
+	}
+
+	const FT_Bitmap &bm = face->glyph->bitmap;
+	const int bmWidth = bm.width;
+	const int bmRows = bm.rows;
+	if (!bmWidth || !bmRows)
+		return true;
+
+	const int width = bmWidth + SPREAD*2;
+	const int height = bmRows + SPREAD*2;
+
+	if (!m_atlas->Allocate(width, height, glyph.slot)) {
+		Output("distance field glyph doesn't fit in atlas (U+%04X; height = %d)\n", chr, height);
+		return false;
+	}
+
+	// brute force nearest texel of the other kind within the spread. it's
+	// only done once per glyph, and the glyphs are small
+	auto inside = [&bm, bmWidth, bmRows](int x, int y) {
+		if (x < 0 || y < 0 || x >= bmWidth || y >= bmRows)
+			return false;
+		return bm.buffer[bm.pitch*y+x] >= 128;
+	};
+
+	const int stride = ALIGN(width,4);
+	m_buf.resize(stride*height);
+	std::fill(m_buf.begin(), m_buf.end(), 0);
+
+	const int maxDist2 = SPREAD*SPREAD;
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			const int bx = x - SPREAD, by = y - SPREAD;
+			const bool in = inside(bx, by);
+
+			int best = maxDist2;
+			for (int dy = -SPREAD; dy <= SPREAD; dy++) {
+				if (dy*dy >= best) continue;
+				for (int dx = -SPREAD; dx <= SPREAD; dx++) {
+					const int d2 = dx*dx + dy*dy;
+					if (d2 < best && inside(bx+dx, by+dy) != in)
+						best = d2;
+				}
+			}
+
+			// the edge lies halfway between the two texels
+			float dist = std::min(sqrtf(float(best)) - 0.5f, float(SPREAD));
+			if (!in) dist = -dist;
+			const float v = 0.5f + 0.5f * dist / float(SPREAD);
+			m_buf[stride*y+x] = Uint8(Clamp(v * 255.0f + 0.5f, 0.0f, 255.0f));
+		}
+	}
+
+	m_atlas->Update(&m_buf[0], glyph.slot, width, height);
+
+	glyph.width = width;
+	glyph.height = height;
+	glyph.left = face->glyph->bitmap_left - SPREAD;
+	glyph.top = face->glyph->bitmap_top + SPREAD;
+	return true;
+}
+
+}
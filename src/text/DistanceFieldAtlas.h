@@ -0,0 +1,81 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _TEXT_DISTANCEFIELDATLAS_H
+#define _TEXT_DISTANCEFIELDATLAS_H
+
+#include "libs.h"
+#include "RefCounted.h"
+#include "GlyphAtlas.h"
+#include "graphics/Material.h"
+#include "graphics/RenderState.h"
+#include <map>
+
+namespace FileSystem { class FileData; }
+
+struct FT_FaceRec_;
+struct FT_LibraryRec_;
+typedef struct FT_FaceRec_ *FT_Face;
+typedef struct FT_LibraryRec_ *FT_Library;
+
+namespace Text {
+
+/*
+ * Signed distance field glyphs, baked once at BASE_SIZE from the font files
+ * and shared by every TextureFont that asks for them, whatever its size.
+ * The fonts scale the quads; the ui shader finds the edge at 0.5.
+ */
+class DistanceFieldAtlas : public RefCounted {
+public:
+	static RefCountedPtr<DistanceFieldAtlas> Get(Graphics::Renderer *renderer);
+	~DistanceFieldAtlas();
+
+	// pixel size glyphs are baked at, and how far the field reaches past
+	// the edge of the glyph (in pixels at that size)
+	static const int BASE_SIZE = 48;
+	static const int SPREAD = 6;
+
+	struct Glyph {
+		int width, height; // texels, including the spread
+		int left, top;     // bitmap origin from the pen position, at BASE_SIZE
+		GlyphAtlas::Slot slot;
+	};
+	// null if the glyph has no bitmap (eg space) or couldn't be placed, in
+	// which case noRoom is set. only good until the next call that may bake
+	// a glyph
+	const Glyph *GetGlyph(const std::string &fontFile, Uint32 chr, bool &noRoom);
+
+	GlyphAtlas *GetAtlas() const { return m_atlas.Get(); }
+	Graphics::Material *GetMaterial() const { return m_mat.get(); }
+	Graphics::RenderState *GetRenderState() const { return m_renderState; }
+
+private:
+	DistanceFieldAtlas(Graphics::Renderer *renderer);
+	DistanceFieldAtlas(const DistanceFieldAtlas &);
+	DistanceFieldAtlas &operator=(const DistanceFieldAtlas &);
+
+	static DistanceFieldAtlas *s_instance;
+
+	FT_Face GetFTFace(const std::string &fontFile);
+	bool BakeGlyph(FT_Face face, Uint32 chr, Glyph &glyph);
+
+	FT_Library m_ftLib;
+	std::map<std::string,std::pair<FT_Face,RefCountedPtr<FileSystem::FileData>>> m_faces;
+
+	struct Entry {
+		Entry() : empty(false) {}
+		Glyph glyph;
+		bool empty; // no bitmap, nothing to bake
+	};
+	std::map<std::pair<std::string,Uint32>,Entry> m_glyphs;
+
+	RefCountedPtr<GlyphAtlas> m_atlas;
+	std::unique_ptr<Graphics::Material> m_mat;
+	Graphics::RenderState *m_renderState;
+
+	std::vector<unsigned char> m_buf;
+};
+
+}
+
+#endif
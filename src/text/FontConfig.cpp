@@ -30,6 +30,7 @@ FontConfig::FontConfig(const std::string &name, float scaleX, float scaleY)
 
 	m_name = data.get("name", Json::Value("unknown")).asString();
 	m_outline = data.get("outline", Json::Value(false)).asBool();
+	m_distanceField = !m_outline && data.get("distanceField", Json::Value(false)).asBool();
 
 	Json::Value faces = data.get("faces", Json::arrayValue);
 	for (Json::Value::iterator i = faces.begin(); i != faces.end(); ++i) {
@@ -43,12 +43,15 @@ public:
 
 	const std::string &GetName() const { return m_name; }
 	bool IsOutline() const { return m_outline; }
+	// glyphs come from the shared distance field atlas (not for outline fonts)
+	bool IsDistanceField() const { return m_distanceField; }
 
 	const Face &GetFaceForCodePoint(Uint32 cp);
 
 private:
 	std::string m_name;
 	bool m_outline;
+	bool m_distanceField;
 	std::vector<Face> m_faces;
 
 };
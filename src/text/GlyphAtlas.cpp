@@ -0,0 +1,80 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "GlyphAtlas.h"
+#include "graphics/Renderer.h"
+
+#include <algorithm>
+
+namespace Text {
+
+GlyphAtlas::GlyphAtlas(Graphics::Renderer *renderer, unsigned int size, unsigned int numPages, Graphics::TextureFormat format, Graphics::TextureSampleMode sampleMode)
+	: m_pages(numPages)
+	, m_size(size)
+	, m_pageHeight(size / numPages)
+	, m_useCounter(0)
+	, m_generation(0)
+	, m_format(format)
+{
+	Graphics::TextureDescriptor textureDescriptor(format, vector2f(size), sampleMode, false, false);
+	m_texture.Reset(renderer->CreateTexture(textureDescriptor));
+}
+
+bool GlyphAtlas::Page::Allocate(unsigned int w, unsigned int h, unsigned int size, unsigned int pageHeight, unsigned int &outU, unsigned int &outV)
+{
+	//don't run off atlas borders
+	if (u + w > size) {
+		u = 0;
+		v += vIncrement;
+		vIncrement = 0;
+	}
+	if (v + h > pageHeight)
+		return false;
+
+	vIncrement = std::max(vIncrement, h);
+	outU = u;
+	outV = v;
+	u += w;
+	return true;
+}
+
+bool GlyphAtlas::Allocate(unsigned int w, unsigned int h, Slot &slot)
+{
+	if (w > m_size || h > m_pageHeight)
+		return false;
+
+	Uint32 p;
+	for (p = 0; p < m_pages.size(); p++)
+		if (m_pages[p].Allocate(w, h, m_size, m_pageHeight, slot.u, slot.v))
+			break;
+
+	if (p == m_pages.size()) {
+		p = 0;
+		for (Uint32 i = 1; i < m_pages.size(); i++)
+			if (m_pages[i].lastUsed < m_pages[p].lastUsed)
+				p = i;
+		// everything is in use by whoever is asking
+		if (m_pages[p].lastUsed == m_useCounter)
+			return false;
+
+		const Uint32 epoch = m_pages[p].epoch + 1;
+		m_pages[p] = Page();
+		m_pages[p].epoch = epoch;
+		++m_generation;
+
+		m_pages[p].Allocate(w, h, m_size, m_pageHeight, slot.u, slot.v);
+	}
+
+	slot.page = p;
+	slot.epoch = m_pages[p].epoch;
+	slot.v += p * m_pageHeight;
+	Touch(p);
+	return true;
+}
+
+void GlyphAtlas::Update(const void *data, const Slot &slot, unsigned int w, unsigned int h)
+{
+	m_texture->Update(data, vector2f(slot.u, slot.v), vector2f(w, h), m_format);
+}
+
+}
@@ -0,0 +1,71 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _TEXT_GLYPHATLAS_H
+#define _TEXT_GLYPHATLAS_H
+
+#include "libs.h"
+#include "RefCounted.h"
+#include "graphics/Texture.h"
+#include <vector>
+
+namespace Graphics { class Renderer; }
+
+namespace Text {
+
+/*
+ * Square texture that glyph bitmaps are packed into, in rows. It's split
+ * into horizontal bands; once they're all full, the one that has gone
+ * unused longest is emptied for new glyphs.
+ *
+ * Users call BeginUse() at the start of each call that may add glyphs and
+ * Touch() the bands of the glyphs they look at. Bands touched since the
+ * last BeginUse() hold glyphs that are still referenced, and stay put.
+ * Emptying a band bumps its epoch and the atlas generation, so a glyph
+ * remembers the epoch it was added under and checks it with IsValid().
+ */
+class GlyphAtlas : public RefCounted {
+public:
+	GlyphAtlas(Graphics::Renderer *renderer, unsigned int size, unsigned int numPages, Graphics::TextureFormat format, Graphics::TextureSampleMode sampleMode);
+
+	struct Slot {
+		Uint32 page;
+		Uint32 epoch;
+		unsigned int u, v;
+	};
+	bool Allocate(unsigned int w, unsigned int h, Slot &slot);
+	void Update(const void *data, const Slot &slot, unsigned int w, unsigned int h);
+
+	bool IsValid(Uint32 page, Uint32 epoch) const { return m_pages[page].epoch == epoch; }
+	void Touch(Uint32 page) { m_pages[page].lastUsed = m_useCounter; }
+	void BeginUse() { ++m_useCounter; }
+	// a failed Allocate may succeed once this has moved on
+	Uint32 GetUseCount() const { return m_useCounter; }
+
+	Uint32 GetGeneration() const { return m_generation; }
+	unsigned int GetSize() const { return m_size; }
+	Graphics::Texture *GetTexture() const { return m_texture.Get(); }
+
+private:
+	struct Page {
+		Page() : u(0), v(0), vIncrement(0), lastUsed(0), epoch(0) {}
+		bool Allocate(unsigned int w, unsigned int h, unsigned int size, unsigned int pageHeight, unsigned int &outU, unsigned int &outV);
+		unsigned int u, v;
+		unsigned int vIncrement;
+		Uint32 lastUsed;
+		Uint32 epoch;
+	};
+	std::vector<Page> m_pages;
+	unsigned int m_size;
+	unsigned int m_pageHeight;
+
+	Uint32 m_useCounter;
+	Uint32 m_generation;
+
+	RefCountedPtr<Graphics::Texture> m_texture;
+	Graphics::TextureFormat m_format;
+};
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "TextureFont.h"
+#include "DistanceFieldAtlas.h"
 #include "FileSystem.h"
 #include "libs.h"
 #include "graphics/Renderer.h"
@@ -20,6 +21,8 @@
 #include <algorithm>
 
 static const int ATLAS_SIZE = 1024;
+static const int ATLAS_PAGES = 4;
+static const size_t MAX_CACHED_RUNS = 256;
 
 namespace Text {
 
@@ -27,8 +30,8 @@ int TextureFont::s_glyphCount = 0;
 
 void TextureFont::AddGlyphGeometry(Graphics::VertexArray &va, const Glyph &glyph, const float x, const float y, const Color &c)
 {
-	const float offX = x + float(glyph.offX);
-	const float offY = y + GetHeight() - float(glyph.offY);
+	const float offX = x + glyph.offX;
+	const float offY = y + GetHeight() - glyph.offY;
 	const float offU = glyph.offU;
 	const float offV = glyph.offV;
 
@@ -55,6 +58,7 @@ void TextureFont::AddGlyphGeometry(Graphics::VertexArray &va, const Glyph &glyph
 
 void TextureFont::MeasureString(const std::string &str, float &w, float &h)
 {
+	BeginUse();
 	w = h = 0.0f;
 
 	float line_width = 0.0f;
@@ -92,6 +96,7 @@ void TextureFont::MeasureString(const std::string &str, float &w, float &h)
 void TextureFont::MeasureCharacterPos(const std::string &str, int charIndex, float &charX, float &charY)
 {
 	assert(charIndex >= 0);
+	BeginUse();
 
 	float x = 0.0f, y = GetHeight();
 	int i = 0;
@@ -126,6 +131,7 @@ void TextureFont::MeasureCharacterPos(const std::string &str, int charIndex, flo
 int TextureFont::PickCharacter(const std::string &str, float mouseX, float mouseY)
 {
 	assert(mouseX >= 0.0f && mouseY >= 0.0f);
+	BeginUse();
 
 	// at the point of the mouse in-box test, the vars have the following values:
 	// i1: the index of the character being tested
@@ -178,59 +184,16 @@ void TextureFont::RenderBuffer(Graphics::VertexBuffer *vb, const Color &color)
 {
 	if( vb && vb->GetVertexCount() > 0 )
 	{
-		m_mat->diffuse = color;
-		m_renderer->DrawBuffer(vb, m_renderState, m_mat.get());
+		Graphics::Material *mat = GetMaterial();
+		mat->diffuse = color;
+		m_renderer->DrawBuffer(vb, m_renderState, mat);
 	}
 }
 
-void TextureFont::PopulateString(Graphics::VertexArray &va, const std::string &str, const float x, const float y, const Color &color)
-{
-	PROFILE_SCOPED()
-
-	if(str.empty()) return;
-
-	float alpha_f = color.a / 255.0f;
-	const Color premult_color = Color(color.r * alpha_f, color.g * alpha_f, color.b * alpha_f, color.a);
-
-	float px = x;
-	float py = y;
-
-	int i = 0;
-	while (str[i]) {
-		if (str[i] == '\n') {
-			px = x;
-			py += GetHeight();
-			i++;
-		} else {
-			Uint32 chr;
-			int n = utf8_decode_char(&chr, &str[i]);
-			assert(n);
-			i += n;
-
-			const Glyph &glyph = GetGlyph(chr);
-			AddGlyphGeometry(va, glyph, roundf(px), py, premult_color);
-
-			if (str[i]) {
-				Uint32 chr2;
-				n = utf8_decode_char(&chr2, &str[i]);
-				assert(n);
-
-				px += GetKern(glyph, GetGlyph(chr2));
-			}
-
-			px += glyph.advX;
-		}
-	}
-}
-
-Color TextureFont::PopulateMarkup(Graphics::VertexArray &va, const std::string &str, const float x, const float y, const Color &color)
+void TextureFont::ShapeRun(Run &run, const std::string &str, const Color &color, bool markup)
 {
-	PROFILE_SCOPED()
-
-	if(str.empty()) return Color::BLACK;
-
-	float px = x;
-	float py = y;
+	float px = 0.0f;
+	float py = 0.0f;
 
 	Color c = color;
 	float alpha_f = c.a / 255.0f;
@@ -238,7 +201,7 @@ Color TextureFont::PopulateMarkup(Graphics::VertexArray &va, const std::string &
 
 	int i = 0;
 	while (str[i]) {
-		if (str[i] == '#') {
+		if (markup && str[i] == '#') {
 			Uint32 hexcol;
 			if (sscanf(&str[i], "#%3x", &hexcol)==1) {
 				c.r = float((hexcol&0xf00)>>4);
@@ -254,7 +217,7 @@ Color TextureFont::PopulateMarkup(Graphics::VertexArray &va, const std::string &
 		}
 
 		if (str[i] == '\n') {
-			px = x;
+			px = 0.0f;
 			py += GetHeight();
 			i++;
 		} else {
@@ -264,7 +227,8 @@ Color TextureFont::PopulateMarkup(Graphics::VertexArray &va, const std::string &
 			i += n;
 
 			const Glyph &glyph = GetGlyph(chr);
-			AddGlyphGeometry(va, glyph, roundf(px), py, premult_c);
+			const RunGlyph rg = { &glyph, px, py, premult_c };
+			run.glyphs.push_back(rg);
 
 			// XXX kerning doesn't skip markup
 			if (str[i]) {
@@ -279,7 +243,56 @@ Color TextureFont::PopulateMarkup(Graphics::VertexArray &va, const std::string &
 		}
 	}
 
-	return c;
+	run.endColor = c;
+}
+
+const TextureFont::Run &TextureFont::GetRun(const std::string &str, const Color &color, bool markup)
+{
+	BeginUse();
+
+	const RunKey key(str, (Uint32(color.r) << 24) | (Uint32(color.g) << 16) | (Uint32(color.b) << 8) | Uint32(color.a), markup);
+	auto i = m_runIndex.find(key);
+	if (i != m_runIndex.end()) {
+		m_runs.splice(m_runs.begin(), m_runs, i->second);
+		const Run &run = i->second->second;
+		for (const RunGlyph &rg : run.glyphs)
+			TouchPage(rg.glyph->page);
+		return run;
+	}
+
+	Run run;
+	ShapeRun(run, str, color, markup);
+	m_runs.push_front(std::make_pair(key, std::move(run)));
+	m_runIndex[key] = m_runs.begin();
+	if (m_runs.size() > MAX_CACHED_RUNS) {
+		m_runIndex.erase(m_runs.back().first);
+		m_runs.pop_back();
+	}
+	return m_runs.front().second;
+}
+
+void TextureFont::PopulateString(Graphics::VertexArray &va, const std::string &str, const float x, const float y, const Color &color)
+{
+	PROFILE_SCOPED()
+
+	if(str.empty()) return;
+
+	const Run &run = GetRun(str, color, false);
+	for (const RunGlyph &rg : run.glyphs)
+		AddGlyphGeometry(va, *rg.glyph, roundf(x + rg.x), y + rg.y, rg.color);
+}
+
+Color TextureFont::PopulateMarkup(Graphics::VertexArray &va, const std::string &str, const float x, const float y, const Color &color)
+{
+	PROFILE_SCOPED()
+
+	if(str.empty()) return Color::BLACK;
+
+	const Run &run = GetRun(str, color, true);
+	for (const RunGlyph &rg : run.glyphs)
+		AddGlyphGeometry(va, *rg.glyph, roundf(x + rg.x), y + rg.y, rg.color);
+
+	return run.endColor;
 }
 
 Graphics::VertexBuffer* TextureFont::CreateVertexBuffer(const Graphics::VertexArray &va) const 
@@ -307,11 +320,41 @@ Graphics::VertexBuffer* TextureFont::CreateVertexBuffer(const Graphics::VertexAr
 const TextureFont::Glyph &TextureFont::GetGlyph(Uint32 chr)
 {
 	auto i = m_glyphs.find(chr);
-	if (i != m_glyphs.end())
-		return (*i).second;
+	if (i != m_glyphs.end()) {
+		Glyph &glyph = (*i).second;
+		// a glyph the atlas had no room for gets another go once the pages in
+		// use may have changed
+		const bool stale = glyph.noRoom ? glyph.epoch != m_atlas->GetUseCount() :
+			glyph.page != Glyph::NO_PAGE && !m_atlas->IsValid(glyph.page, glyph.epoch);
+		if (!stale) {
+			TouchPage(glyph.page);
+			return glyph;
+		}
+		// its page was emptied for something else, or there wasn't one
+		glyph = m_distanceField ? BakeDistanceFieldGlyph(chr) : BakeGlyph(chr);
+		return glyph;
+	}
 
-	m_glyphs[chr] = BakeGlyph(chr);
-	return m_glyphs[chr];
+	Glyph &glyph = m_glyphs[chr];
+	glyph = m_distanceField ? BakeDistanceFieldGlyph(chr) : BakeGlyph(chr);
+	return glyph;
+}
+
+void TextureFont::BeginUse()
+{
+	m_atlas->BeginUse();
+
+	// runs point at glyphs, and knowing which ones are left isn't worth it
+	if (m_runGeneration != m_atlas->GetGeneration()) {
+		m_runs.clear();
+		m_runIndex.clear();
+		m_runGeneration = m_atlas->GetGeneration();
+	}
+}
+
+Graphics::Material *TextureFont::GetMaterial() const
+{
+	return m_distanceField ? m_distanceField->GetMaterial() : m_mat.get();
 }
 
 
@@ -386,19 +429,12 @@ TextureFont::Glyph TextureFont::BakeGlyph(Uint32 chr)
 
 		const FT_BitmapGlyph bmStrokeGlyph = FT_BitmapGlyph(strokeGlyph);
 
-		//don't run off atlas borders
-		m_atlasVIncrement = std::max(m_atlasVIncrement, static_cast<unsigned int>(bmStrokeGlyph->bitmap.rows));
-		if (m_atlasU + static_cast<unsigned int>(bmStrokeGlyph->bitmap.width) > ATLAS_SIZE) {
-			m_atlasU = 0;
-			m_atlasV += m_atlasVIncrement;
-			m_atlasVIncrement = 0;
-		}
-
-		if (m_atlasV + bmStrokeGlyph->bitmap.rows > ATLAS_SIZE) {
+		GlyphAtlas::Slot slot;
+		if (!m_atlas->Allocate(bmStrokeGlyph->bitmap.width, bmStrokeGlyph->bitmap.rows, slot)) {
 			char utf8buf[8];
 			int len = utf8_encode_char(chr, utf8buf);
 			utf8buf[len] = '\0';
-			Output("glyph doesn't fit in atlas (U+%04X; height = %d; char: %s; atlasV = %d)\n", chr, bmStrokeGlyph->bitmap.rows, utf8buf, m_atlasV);
+			Output("glyph doesn't fit in atlas (U+%04X; height = %d; char: %s)\n", chr, bmStrokeGlyph->bitmap.rows, utf8buf);
 			FT_Done_Glyph(strokeGlyph);
 			return Glyph();
 		}
@@ -437,32 +473,25 @@ TextureFont::Glyph TextureFont::BakeGlyph(Uint32 chr)
 		glyph.height = bmStrokeGlyph->bitmap.rows;
 		glyph.offX = bmStrokeGlyph->left;
 		glyph.offY = bmStrokeGlyph->top;
-		glyph.offU = float(m_atlasU) / float(ATLAS_SIZE);
-		glyph.offV = float(m_atlasV) / float(ATLAS_SIZE);
+		glyph.offU = float(slot.u) / float(ATLAS_SIZE);
+		glyph.offV = float(slot.v) / float(ATLAS_SIZE);
 		glyph.texWidth = float(glyph.width) / float(ATLAS_SIZE);
 		glyph.texHeight = float(glyph.height) / float(ATLAS_SIZE);
+		glyph.page = slot.page;
+		glyph.epoch = slot.epoch;
 
-		m_texture->Update(&m_buf[0], vector2f(m_atlasU, m_atlasV), vector2f(glyph.width, glyph.height), m_texFormat);
-
-		m_atlasU += bmStrokeGlyph->bitmap.width;
+		m_atlas->Update(&m_buf[0], slot, glyph.width, glyph.height);
 
 		FT_Done_Glyph(strokeGlyph);
 	}
 	else 
 	{
-		//don't run off atlas borders
-		m_atlasVIncrement = std::max(m_atlasVIncrement, static_cast<unsigned int>(bmGlyph->bitmap.rows));
-		if (m_atlasU + static_cast<unsigned int>(bmGlyph->bitmap.width) >= ATLAS_SIZE) {
-			m_atlasU = 0;
-			m_atlasV += m_atlasVIncrement;
-			m_atlasVIncrement = 0;
-		}
-
-		if (m_atlasV + bmGlyph->bitmap.rows > ATLAS_SIZE) {
+		GlyphAtlas::Slot slot;
+		if (!m_atlas->Allocate(bmGlyph->bitmap.width, bmGlyph->bitmap.rows, slot)) {
 			char utf8buf[8];
 			int len = utf8_encode_char(chr, utf8buf);
 			utf8buf[len] = '\0';
-			Output("glyph doesn't fit in atlas (U+%04X; height = %d; char: %s; atlasV = %d)\n", chr, bmGlyph->bitmap.rows, utf8buf, m_atlasV);
+			Output("glyph doesn't fit in atlas (U+%04X; height = %d; char: %s)\n", chr, bmGlyph->bitmap.rows, utf8buf);
 			return Glyph();
 		}
 
@@ -478,14 +507,14 @@ TextureFont::Glyph TextureFont::BakeGlyph(Uint32 chr)
 		glyph.height = bmGlyph->bitmap.rows;
 		glyph.offX = bmGlyph->left;
 		glyph.offY = bmGlyph->top;
-		glyph.offU = float(m_atlasU) / float(ATLAS_SIZE);
-		glyph.offV = float(m_atlasV) / float(ATLAS_SIZE);
+		glyph.offU = float(slot.u) / float(ATLAS_SIZE);
+		glyph.offV = float(slot.v) / float(ATLAS_SIZE);
 		glyph.texWidth = float(glyph.width) / float(ATLAS_SIZE);
 		glyph.texHeight = float(glyph.height) / float(ATLAS_SIZE);
+		glyph.page = slot.page;
+		glyph.epoch = slot.epoch;
 
-		m_texture->Update(&m_buf[0], vector2f(m_atlasU, m_atlasV), vector2f(glyph.width, glyph.height), m_texFormat);
-
-		m_atlasU += glyph.width;
+		m_atlas->Update(&m_buf[0], slot, glyph.width, glyph.height);
 	}
 
 	FT_Done_Glyph(ftGlyph);
@@ -493,15 +522,60 @@ TextureFont::Glyph TextureFont::BakeGlyph(Uint32 chr)
 	return glyph;
 }
 
+TextureFont::Glyph TextureFont::BakeDistanceFieldGlyph(Uint32 chr)
+{
+	Glyph glyph;
+
+	const FontConfig::Face &face = m_config.GetFaceForCodePoint(chr);
+	glyph.ftFace = GetFTFace(face);
+	glyph.ftIndex = FT_Get_Char_Index(glyph.ftFace, chr);
+
+	// advance and kerning come from the face at this size, the bitmap from
+	// the shared atlas scaled down to it
+	const int err = FT_Load_Char(glyph.ftFace, chr, FT_LOAD_FORCE_AUTOHINT);
+	if (err) {
+		Output("Error %d loading glyph\n", err);
+		return Glyph();
+	}
+
+	glyph.advX = float(glyph.ftFace->glyph->advance.x) / 64.f + face.advanceXAdjustment;
+	glyph.advY = float(glyph.ftFace->glyph->advance.y) / 64.f;
+
+	bool noRoom;
+	const DistanceFieldAtlas::Glyph *dfGlyph = m_distanceField->GetGlyph(face.fontFile, chr, noRoom);
+	if (!dfGlyph) {
+		if (noRoom) {
+			glyph.noRoom = true;
+			glyph.epoch = m_atlas->GetUseCount();
+		}
+		return glyph;
+	}
+
+	const float scaleX = float(glyph.ftFace->size->metrics.x_ppem) / float(DistanceFieldAtlas::BASE_SIZE);
+	const float scaleY = float(glyph.ftFace->size->metrics.y_ppem) / float(DistanceFieldAtlas::BASE_SIZE);
+	const float atlasSize = float(m_atlas->GetSize());
+
+	glyph.width = dfGlyph->width * scaleX;
+	glyph.height = dfGlyph->height * scaleY;
+	glyph.offX = dfGlyph->left * scaleX;
+	glyph.offY = dfGlyph->top * scaleY;
+	glyph.offU = float(dfGlyph->slot.u) / atlasSize;
+	glyph.offV = float(dfGlyph->slot.v) / atlasSize;
+	glyph.texWidth = float(dfGlyph->width) / atlasSize;
+	glyph.texHeight = float(dfGlyph->height) / atlasSize;
+	glyph.page = dfGlyph->slot.page;
+	glyph.epoch = dfGlyph->slot.epoch;
+
+	return glyph;
+}
+
 TextureFont::TextureFont(const FontConfig &config, Graphics::Renderer *renderer, float scale)
 	: m_config(config)
 	, m_renderer(renderer)
 	, m_scale(scale)
 	, m_ftLib(nullptr)
 	, m_stroker(nullptr)
-	, m_atlasU(0)
-	, m_atlasV(0)
-	, m_atlasVIncrement(0)
+	, m_runGeneration(0)
 {
 	renderer->CheckRenderErrors();
 
@@ -530,19 +604,26 @@ TextureFont::TextureFont(const FontConfig &config, Graphics::Renderer *renderer,
 
 	renderer->CheckRenderErrors();
 
-	Graphics::RenderStateDesc rsd;
-	rsd.blendMode = Graphics::BLEND_ALPHA_PREMULT;
-	rsd.depthWrite = false;
-	m_renderState = m_renderer->CreateRenderState(rsd);
-
-	Graphics::MaterialDescriptor desc;
-	desc.effect = Graphics::EFFECT_UI;
-	desc.vertexColors = true; //to allow per-character colors
-	desc.textures = 1;
-	m_mat.reset(m_renderer->CreateMaterial(desc));
-	Graphics::TextureDescriptor textureDescriptor(m_texFormat, vector2f(ATLAS_SIZE), Graphics::NEAREST_CLAMP, false, false);
-	m_texture.Reset(m_renderer->CreateTexture(textureDescriptor));
-	m_mat->texture0 = m_texture.Get();
+	if (m_config.IsDistanceField()) {
+		m_distanceField = DistanceFieldAtlas::Get(m_renderer);
+		m_atlas.Reset(m_distanceField->GetAtlas());
+		m_renderState = m_distanceField->GetRenderState();
+	} else {
+		m_atlas.Reset(new GlyphAtlas(m_renderer, ATLAS_SIZE, ATLAS_PAGES, m_texFormat, Graphics::NEAREST_CLAMP));
+
+		Graphics::RenderStateDesc rsd;
+		rsd.blendMode = Graphics::BLEND_ALPHA_PREMULT;
+		rsd.depthWrite = false;
+		m_renderState = m_renderer->CreateRenderState(rsd);
+
+		Graphics::MaterialDescriptor desc;
+		desc.effect = Graphics::EFFECT_UI;
+		desc.vertexColors = true; //to allow per-character colors
+		desc.textures = 1;
+		m_mat.reset(m_renderer->CreateMaterial(desc));
+		m_mat->texture0 = m_atlas->GetTexture();
+	}
+	m_runGeneration = m_atlas->GetGeneration();
 
 	// font-wide metrics. we assume that these match for all faces
 	// XXX loop all the faces and take the min/max as appropriate
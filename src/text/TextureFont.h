@@ -6,11 +6,14 @@
 
 #include "libs.h"
 #include "FontConfig.h"
+#include "GlyphAtlas.h"
 #include "RefCounted.h"
 #include "graphics/Texture.h"
 #include "graphics/Material.h"
 #include "graphics/VertexBuffer.h"
 #include "graphics/RenderState.h"
+#include <list>
+#include <tuple>
 
 namespace FileSystem { class FileData; }
 
@@ -24,6 +27,8 @@ typedef struct FT_StrokerRec_ *FT_Stroker;
 
 namespace Text {
 
+class DistanceFieldAtlas;
+
 class TextureFont : public RefCounted {
 
 public:
@@ -45,22 +50,33 @@ public:
 	float GetDescender() const { return m_descender; }
 
 	struct Glyph {
-		Glyph() : advX(0), advY(0), width(0), height(0), texWidth(0), texHeight(0), offX(0), offY(0), offU(0), offV(0), ftIndex(0) {}
+		static const Uint32 NO_PAGE = ~0u;
+		Glyph() : advX(0), advY(0), width(0), height(0), texWidth(0), texHeight(0), offX(0), offY(0), offU(0), offV(0), ftIndex(0), page(NO_PAGE), epoch(0), noRoom(false) {}
 		float advX, advY;
 		float width, height;
 		float texWidth, texHeight;
-		int offX, offY;
+		float offX, offY;
 		float offU, offV; //atlas UV offset
 		FT_Face ftFace;
 		Uint32 ftIndex;
+		Uint32 page; // atlas page, NO_PAGE if there's no bitmap
+		Uint32 epoch; // page epoch the bitmap was added under, or the atlas use count when noRoom
+		bool noRoom; // the atlas was full, so it's blank until baked again
 	};
+	// only good until the next call that may bake a glyph
 	const Glyph &GetGlyph(Uint32 ch);
 
+	// bumped when a full atlas drops glyphs to make room. geometry that was
+	// populated before it changed may point at the wrong glyphs
+	Uint32 GetAtlasGeneration() const { return m_atlas->GetGeneration(); }
+
 	static int GetGlyphCount() { return s_glyphCount; }
 	static void ClearGlyphCount() { s_glyphCount = 0; }
 
-	RefCountedPtr<Graphics::Texture> GetTexture() const  { return m_texture; }
-	Graphics::Material* GetMaterial() const { return m_mat.get(); }
+	RefCountedPtr<Graphics::Texture> GetTexture() const  { return RefCountedPtr<Graphics::Texture>(m_atlas->GetTexture()); }
+	// distance field fonts all share one, so their text batches together
+	Graphics::Material* GetMaterial() const;
+	Graphics::RenderState* GetRenderState() const { return m_renderState; }
 
 private:
 	TextureFont(const TextureFont &);
@@ -77,9 +93,29 @@ private:
 	std::map<FontConfig::Face,std::pair<FT_Face,RefCountedPtr<FileSystem::FileData>>> m_faces;
 
 	Glyph BakeGlyph(Uint32 chr);
+	Glyph BakeDistanceFieldGlyph(Uint32 chr);
 
 	float GetKern(const Glyph &a, const Glyph &b);
 
+	// a string laid out from the origin, so repeat populates skip the utf8
+	// decoding, glyph lookups and kerning
+	struct RunGlyph {
+		const Glyph *glyph;
+		float x, y;
+		Color color;
+	};
+	struct Run {
+		std::vector<RunGlyph> glyphs;
+		Color endColor; // what PopulateMarkup returns
+	};
+	typedef std::tuple<std::string,Uint32,bool> RunKey; // string, colour, markup
+	const Run &GetRun(const std::string &str, const Color &color, bool markup);
+	void ShapeRun(Run &run, const std::string &str, const Color &color, bool markup);
+
+	// most recently used first
+	std::list<std::pair<RunKey,Run>> m_runs;
+	std::map<RunKey,std::list<std::pair<RunKey,Run>>::iterator> m_runIndex;
+
 	void AddGlyphGeometry(Graphics::VertexArray &va, const Glyph &glyph, const float x, const float y, const Color &color);
 	float m_height;
 	float m_descender;
@@ -91,12 +127,16 @@ private:
 
 	std::map<Uint32,Glyph> m_glyphs;
 
-	// UV offsets for glyphs
-	unsigned int m_atlasU;
-	unsigned int m_atlasV;
-	unsigned int m_atlasVIncrement;
+	// bitmap fonts have an atlas of their own, distance field fonts use
+	// the shared one. glyphs whose page was emptied are baked again
+	RefCountedPtr<GlyphAtlas> m_atlas;
+	RefCountedPtr<DistanceFieldAtlas> m_distanceField;
+	void TouchPage(Uint32 page) { if (page != Glyph::NO_PAGE) m_atlas->Touch(page); }
+	void BeginUse();
+
+	// atlas generation the cached runs were shaped under
+	Uint32 m_runGeneration;
 
-	RefCountedPtr<Graphics::Texture> m_texture;
 	Graphics::TextureFormat m_texFormat;
 
 	std::vector<unsigned char> m_buf;
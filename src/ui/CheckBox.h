@@ -13,6 +13,7 @@ public:
 	virtual Point PreferredSize();
 	virtual void Layout();
 	virtual void Draw();
+	virtual bool IsDrawBatched() const { return true; }
 
 	void Toggle();
 	bool IsChecked() const;
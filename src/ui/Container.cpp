@@ -35,7 +35,7 @@ void Container::Draw()
 void Container::LayoutChildren()
 {
 	for (std::vector< RefCountedPtr<Widget> >::iterator i = m_widgets.begin(); i != m_widgets.end(); ++i)
-		(*i)->Layout();
+		(*i)->LayoutIfNeeded();
 }
 
 void Container::AddWidget(Widget *widget)
@@ -51,7 +51,7 @@ void Container::AddWidget(Widget *widget)
 	widget->Attach(this);
 	m_widgets.push_back(RefCountedPtr<Widget>(widget));
 
-	GetContext()->RequestLayout();
+	RequestLayout();
 }
 
 void Container::RemoveWidget(Widget *widget)
@@ -67,7 +67,7 @@ void Container::RemoveWidget(Widget *widget)
 	widget->Detach();
 	m_widgets.erase(i);
 
-	GetContext()->RequestLayout();
+	RequestLayout();
 }
 
 void Container::RemoveAllWidgets()
@@ -78,7 +78,7 @@ void Container::RemoveAllWidgets()
 		i = m_widgets.erase(i);
 	}
 
-	GetContext()->RequestLayout();
+	RequestLayout();
 }
 
 void Container::Disable()
@@ -93,6 +93,13 @@ void Container::Enable()
 	Widget::Enable();
 }
 
+void Container::InvalidateLayout()
+{
+	for (std::vector< RefCountedPtr<Widget> >::iterator i = m_widgets.begin(); i != m_widgets.end(); ++i)
+		(*i)->InvalidateLayout();
+	Widget::InvalidateLayout();
+}
+
 void Container::NotifyVisible(bool visible)
 {
 	const bool wasVisible = IsVisible();
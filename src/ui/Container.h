@@ -13,7 +13,9 @@
 // will typically call PreferredSize() on its children to request their
 // desired sizings then call SetSize() on its children to set their sizes
 // appropriately. Containers should then call LayoutChildren() to make its
-// children do their layout.
+// children do their layout. Children that haven't requested layout and kept
+// their size are skipped, so a container with its own children outside
+// m_widgets should call LayoutIfNeeded() on them rather than Layout().
 //
 // Containers don't have provide Update() or Draw(). If they do they should
 // make sure that they call the baseclass methods so that child widgets will
@@ -25,7 +27,7 @@ class Container: public Widget {
 
 protected:
 	// can't instantiate a base container directly
-	Container(Context *context) : Widget(context), m_needsLayout(false) {}
+	Container(Context *context) : Widget(context) {}
 
 public:
 	virtual ~Container();
@@ -33,6 +35,7 @@ public:
 	virtual void Layout() = 0;
 	virtual void Update();
 	virtual void Draw();
+	virtual bool IsDrawBatched() const { return true; }
 
 	virtual bool IsContainer() const { return true; }
 
@@ -42,6 +45,8 @@ public:
 	virtual void Disable();
 	virtual void Enable();
 
+	virtual void InvalidateLayout();
+
 	unsigned GetNumWidgets() const { return m_widgets.size(); }
 	IterationProxy<std::vector<RefCountedPtr<Widget> > > GetWidgets() { return MakeIterationProxy(m_widgets); }
 	const IterationProxy<const std::vector<RefCountedPtr<Widget> > > GetWidgets() const { return MakeIterationProxy(m_widgets); }
@@ -67,7 +72,6 @@ private:
 	void EnableChildren();
 	void DisableChildren();
 
-	bool m_needsLayout;
 	std::vector< RefCountedPtr<Widget> > m_widgets;
 };
 
@@ -39,11 +39,11 @@ Context::Context(LuaManager *lua, Graphics::Renderer *renderer, int width, int h
 	m_width(width),
 	m_height(height),
 	m_scale(std::min(float(m_height)/SCALE_CUTOFF_HEIGHT, 1.0f)),
-	m_needsLayout(false),
 	m_mousePointer(nullptr),
 	m_mousePointerEnabled(true),
 	m_eventDispatcher(this),
-	m_skin("ui/Skin.ini", renderer, GetScale()),
+	m_drawList(renderer),
+	m_skin("ui/Skin.ini", renderer, &m_drawList, GetScale()),
 	m_lua(lua)
 {
 	lua_State *l = m_lua->GetLuaState();
@@ -85,7 +85,6 @@ Layer *Context::NewLayer()
 	AddWidget(layer);
 	SetWidgetDimensions(layer, Point(0), Point(m_width, m_height));
 	m_layers.push_back(layer);
-	m_needsLayout = true;
 	return layer;
 }
 
@@ -95,7 +94,6 @@ void Context::DropLayer()
 	assert(m_layers.size() > 1);
 	RemoveWidget(m_layers.back());
 	m_layers.pop_back();
-	m_needsLayout = true;
 }
 
 void Context::DropAllLayers()
@@ -104,7 +102,6 @@ void Context::DropAllLayers()
 		RemoveWidget(*i);
 	m_layers.clear();
 	NewLayer();
-	m_needsLayout = true;
 }
 
 Widget *Context::GetWidgetAt(const Point &pos)
@@ -114,16 +111,21 @@ Widget *Context::GetWidgetAt(const Point &pos)
 
 void Context::Layout()
 {
+	PROFILE_SCOPED()
+
+	// only the widgets that requested layout, their containers and anything
+	// those containers resize get laid out. everything else keeps its
+	// layout and its cached preferred size.
+	//
 	// some widgets (eg MultiLineText) can require two layout passes because we
 	// don't know their preferred size until after their first layout run. so
 	// then we have to do layout again to make sure everyone else gets it right
-	m_needsLayout = false;
-
-	LayoutChildren();
-	if (m_needsLayout)
+	for (int pass = 0; pass < 2 && IsLayoutNeeded(); pass++) {
+		SetLayoutNeeded(false);
 		LayoutChildren();
+	}
 
-	m_needsLayout = false;
+	SetLayoutNeeded(false);
 
 	m_eventDispatcher.LayoutUpdated();
 }
@@ -132,11 +134,11 @@ void Context::Update()
 {
 	m_animationController.Update();
 
-	if (m_needsLayout)
+	if (IsLayoutNeeded())
 		Layout();
 
 	if (m_mousePointer && m_mousePointerEnabled)
-		SetWidgetDimensions(m_mousePointer, m_eventDispatcher.GetMousePos()-m_mousePointer->GetHotspot(), m_mousePointer->PreferredSize());
+		SetWidgetDimensions(m_mousePointer, m_eventDispatcher.GetMousePos()-m_mousePointer->GetHotspot(), m_mousePointer->GetPreferredSize());
 
 	Container::Update();
 }
@@ -156,7 +158,9 @@ void Context::Draw()
 		r->SetTransform(matrix4x4f::Identity());
 		r->SetClearColor(Color::BLACK);
 
+		m_drawList.Begin();
 		DrawWidget(*i);
+		m_drawList.End();
 
 		r->SetScissor(false);
 	}
@@ -165,7 +169,9 @@ void Context::Draw()
 		r->SetOrthographicProjection(0, m_width, m_height, 0, -1, 1);
 		r->SetTransform(matrix4x4f::Identity());
 		r->SetClearColor(Color::BLACK);
+		m_drawList.Begin();
 		DrawWidget(m_mousePointer);
+		m_drawList.End();
 		r->SetScissor(false);
 	}
 }
@@ -182,6 +188,11 @@ Widget *Context::CallTemplate(const char *name)
 
 void Context::DrawWidget(Widget *w)
 {
+	// anything batched so far goes before a widget that draws for itself
+	const bool batched = w->IsDrawBatched();
+	if (!batched)
+		m_drawList.Pause();
+
 	const Point &pos = w->GetPosition();
 	const Point &drawOffset = w->GetDrawOffset();
 	const Point &size = w->GetSize();
@@ -230,6 +241,9 @@ void Context::DrawWidget(Widget *w)
 
 	m_renderer->SetTransform(matrix4x4f::Translation(m_drawWidgetPosition.x, m_drawWidgetPosition.y, 0));
 
+	m_drawList.SetOrigin(m_drawWidgetPosition);
+	m_drawList.SetClip(newScissorPos, newScissorSize);
+
 	float oldOpacity = m_opacityStack.empty() ? 1.0f : m_opacityStack.top();
 	float opacity = oldOpacity * w->GetAnimatedOpacity();
 	m_opacityStack.push(opacity);
@@ -241,6 +255,15 @@ void Context::DrawWidget(Widget *w)
 	m_scissorStack.pop();
 
 	m_drawWidgetPosition -= finalPos + drawOffset;
+
+	// back to the parent, in case it draws more after its children
+	m_drawList.SetOrigin(m_drawWidgetPosition);
+	m_drawList.SetClip(m_scissorStack.top().first, m_scissorStack.top().second);
+	if (!m_opacityStack.empty())
+		m_skin.SetOpacity(m_opacityStack.top());
+
+	if (!batched)
+		m_drawList.Resume();
 }
 
 void Context::SetMousePointer(const std::string &filename, const Point &hotspot)
@@ -255,7 +278,7 @@ void Context::SetMousePointer(const std::string &filename, const Point &hotspot)
 	m_mousePointer = new MousePointer(this, filename, hotspot);
 
 	AddWidget(m_mousePointer);
-	SetWidgetDimensions(m_mousePointer, pos - m_mousePointer->GetHotspot(), m_mousePointer->PreferredSize());
+	SetWidgetDimensions(m_mousePointer, pos - m_mousePointer->GetHotspot(), m_mousePointer->GetPreferredSize());
 }
 
 }
@@ -10,6 +10,7 @@
 #include "EventDispatcher.h"
 #include "Animation.h"
 #include "Skin.h"
+#include "DrawList.h"
 
 #include "Widget.h"
 #include "Layer.h"
@@ -130,7 +131,8 @@ public:
 	bool Dispatch(const Event &event) { return m_eventDispatcher.Dispatch(event); }
 	bool DispatchSDLEvent(const SDL_Event &event) { return m_eventDispatcher.DispatchSDLEvent(event); }
 
-	void RequestLayout() { m_needsLayout = true; }
+	// lay out the whole tree again, not just the widgets that asked for it
+	void RequestLayout() { InvalidateLayout(); }
 
 	void SelectWidget(Widget *target) { m_eventDispatcher.SelectWidget(target); }
 	void DeselectWidget(Widget *target) { m_eventDispatcher.DeselectWidget(target); }
@@ -150,6 +152,7 @@ public:
 
 	Graphics::Renderer *GetRenderer() const { return m_renderer; }
 	const Skin &GetSkin() const { return m_skin; }
+	DrawList &GetDrawList() { return m_drawList; }
 
 	const float &GetScale() const { return m_scale; }
 
@@ -168,8 +171,6 @@ private:
 
 	float m_scale;
 
-	bool m_needsLayout;
-
 	std::vector<Layer*> m_layers;
 
 	MousePointer *m_mousePointer;
@@ -177,6 +178,7 @@ private:
 
 	EventDispatcher m_eventDispatcher;
 	AnimationController m_animationController;
+	DrawList m_drawList;
 	Skin m_skin;
 
 	LuaManager *m_lua;
@@ -0,0 +1,212 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "DrawList.h"
+#include "graphics/Renderer.h"
+#include "graphics/VertexArray.h"
+#include "matrix4x4.h"
+
+namespace UI {
+
+// how many batches back a quad may go looking for one it can join
+static const size_t MAX_BATCH_LOOKBACK = 16;
+
+DrawList::DrawList(Graphics::Renderer *renderer) :
+	m_renderer(renderer),
+	m_depth(0),
+	m_paused(0),
+	m_numBatches(0)
+{
+}
+
+DrawList::~DrawList()
+{
+}
+
+void DrawList::Begin()
+{
+	++m_depth;
+}
+
+void DrawList::End()
+{
+	assert(m_depth > 0);
+	if (--m_depth == 0)
+		Flush();
+}
+
+void DrawList::Pause()
+{
+	Flush();
+	++m_paused;
+}
+
+void DrawList::Resume()
+{
+	assert(m_paused > 0);
+	--m_paused;
+}
+
+void DrawList::SetClip(const Point &pos, const Point &size)
+{
+	m_clipMin = vector2f(pos.x, pos.y);
+	m_clipMax = vector2f(pos.x + size.x, pos.y + size.y);
+}
+
+static inline Color LerpColor(const Color &a, const Color &b, float t)
+{
+	return Color(
+		Uint8(a.r + (b.r - a.r) * t),
+		Uint8(a.g + (b.g - a.g) * t),
+		Uint8(a.b + (b.b - a.b) * t),
+		Uint8(a.a + (b.a - a.a) * t));
+}
+
+static inline void AddVertices(Graphics::VertexArray &va, bool textured, const vector2f &p0, const vector2f &p1, const vector2f &t0, const vector2f &t1, const Color c[4])
+{
+	const vector3f v[4] = {
+		vector3f(p0.x, p0.y, 0.0f), vector3f(p0.x, p1.y, 0.0f),
+		vector3f(p1.x, p0.y, 0.0f), vector3f(p1.x, p1.y, 0.0f)
+	};
+	static const int order[6] = { 0, 1, 2, 2, 1, 3 };
+	if (textured) {
+		const vector2f t[4] = { t0, vector2f(t0.x, t1.y), vector2f(t1.x, t0.y), t1 };
+		for (int i = 0; i < 6; i++)
+			va.Add(v[order[i]], c[order[i]], t[order[i]]);
+	} else {
+		for (int i = 0; i < 6; i++)
+			va.Add(v[order[i]], c[order[i]]);
+	}
+}
+
+void DrawList::AddQuad(Graphics::Material *material, Graphics::RenderState *state, const vector2f &p0, const vector2f &p1, const vector2f &t0, const vector2f &t1, const Color c[4])
+{
+	Emit(material, state, true, p0, p1, t0, t1, c);
+}
+
+void DrawList::AddQuad(Graphics::Material *material, Graphics::RenderState *state, const vector2f &p0, const vector2f &p1, const vector2f &t0, const vector2f &t1, const Color &c)
+{
+	const Color cs[4] = { c, c, c, c };
+	Emit(material, state, true, p0, p1, t0, t1, cs);
+}
+
+void DrawList::AddQuad(Graphics::Material *material, Graphics::RenderState *state, const vector2f &p0, const vector2f &p1, const Color c[4])
+{
+	Emit(material, state, false, p0, p1, vector2f(0.0f), vector2f(0.0f), c);
+}
+
+void DrawList::AddQuad(Graphics::Material *material, Graphics::RenderState *state, const vector2f &p0, const vector2f &p1, const Color &c)
+{
+	const Color cs[4] = { c, c, c, c };
+	Emit(material, state, false, p0, p1, vector2f(0.0f), vector2f(0.0f), cs);
+}
+
+void DrawList::AddText(Graphics::Material *material, Graphics::RenderState *state, const Graphics::VertexArray &va)
+{
+	if (!IsActive()) {
+		if (va.GetNumVerts() > 0)
+			m_renderer->DrawTriangles(&va, state, material);
+		return;
+	}
+
+	for (unsigned int i = 0; i + 6 <= va.GetNumVerts(); i += 6) {
+		const Color c = va.diffuse[i];
+		const Color cs[4] = { c, c, c, c };
+		Emit(material, state, true,
+			vector2f(va.position[i].x, va.position[i].y), vector2f(va.position[i+5].x, va.position[i+5].y),
+			va.uv0[i], va.uv0[i+5], cs);
+	}
+}
+
+void DrawList::Emit(Graphics::Material *material, Graphics::RenderState *state, bool textured, vector2f p0, vector2f p1, vector2f t0, vector2f t1, const Color c[4])
+{
+	if (!IsActive()) {
+		Graphics::VertexArray va(textured ?
+			(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0) :
+			(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE), 6);
+		AddVertices(va, textured, p0, p1, t0, t1, c);
+		m_renderer->DrawTriangles(&va, state, material);
+		return;
+	}
+
+	p0 += m_origin;
+	p1 += m_origin;
+
+	// clip, carrying texture coordinates and colours along
+	const vector2f q0(std::max(p0.x, m_clipMin.x), std::max(p0.y, m_clipMin.y));
+	const vector2f q1(std::min(p1.x, m_clipMax.x), std::min(p1.y, m_clipMax.y));
+	if (q0.x >= q1.x || q0.y >= q1.y)
+		return;
+
+	Color cs[4] = { c[0], c[1], c[2], c[3] };
+	if (q0.x > p0.x || q0.y > p0.y || q1.x < p1.x || q1.y < p1.y) {
+		const vector2f size(p1 - p0);
+		const float fx0 = (q0.x - p0.x) / size.x, fx1 = (q1.x - p0.x) / size.x;
+		const float fy0 = (q0.y - p0.y) / size.y, fy1 = (q1.y - p0.y) / size.y;
+
+		const vector2f tsize(t1 - t0);
+		t1 = vector2f(t0.x + tsize.x * fx1, t0.y + tsize.y * fy1);
+		t0 = vector2f(t0.x + tsize.x * fx0, t0.y + tsize.y * fy0);
+
+		const Color left0 = LerpColor(c[0], c[1], fy0), left1 = LerpColor(c[0], c[1], fy1);
+		const Color right0 = LerpColor(c[2], c[3], fy0), right1 = LerpColor(c[2], c[3], fy1);
+		cs[0] = LerpColor(left0, right0, fx0);
+		cs[1] = LerpColor(left1, right1, fx0);
+		cs[2] = LerpColor(left0, right0, fx1);
+		cs[3] = LerpColor(left1, right1, fx1);
+	}
+
+	Batch &b = FindBatch(material, state, textured, q0, q1);
+	AddVertices(*b.vertices, textured, q0, q1, t0, t1, cs);
+}
+
+DrawList::Batch &DrawList::FindBatch(Graphics::Material *material, Graphics::RenderState *state, bool textured, const vector2f &p0, const vector2f &p1)
+{
+	const size_t stop = m_numBatches > MAX_BATCH_LOOKBACK ? m_numBatches - MAX_BATCH_LOOKBACK : 0;
+	for (size_t i = m_numBatches; i > stop; i--) {
+		Batch &b = m_batches[i-1];
+		if (b.material == material && b.renderState == state && b.textured == textured) {
+			b.min = vector2f(std::min(b.min.x, p0.x), std::min(b.min.y, p0.y));
+			b.max = vector2f(std::max(b.max.x, p1.x), std::max(b.max.y, p1.y));
+			return b;
+		}
+		// drawn after this one, so it can't go any further back
+		if (p0.x < b.max.x && p1.x > b.min.x && p0.y < b.max.y && p1.y > b.min.y)
+			break;
+	}
+
+	if (m_numBatches == m_batches.size())
+		m_batches.push_back(Batch());
+	Batch &b = m_batches[m_numBatches++];
+	if (!b.vertices || b.textured != textured)
+		b.vertices.reset(new Graphics::VertexArray(textured ?
+			(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0) :
+			(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE)));
+	else
+		b.vertices->Clear();
+	b.material = material;
+	b.renderState = state;
+	b.textured = textured;
+	b.min = p0;
+	b.max = p1;
+	return b;
+}
+
+void DrawList::Flush()
+{
+	if (!m_numBatches)
+		return;
+
+	PROFILE_SCOPED()
+
+	m_renderer->SetScissor(false);
+	m_renderer->SetTransform(matrix4x4f::Identity());
+	for (size_t i = 0; i < m_numBatches; i++) {
+		const Batch &b = m_batches[i];
+		if (b.vertices->GetNumVerts() > 0)
+			m_renderer->DrawTriangles(b.vertices.get(), b.renderState, b.material);
+	}
+	m_numBatches = 0;
+}
+
+}
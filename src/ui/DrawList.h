@@ -0,0 +1,97 @@
+// Copyright © 2008-2015 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef UI_DRAWLIST_H
+#define UI_DRAWLIST_H
+
+#include "Point.h"
+#include "Color.h"
+#include "vector2.h"
+#include <vector>
+#include <memory>
+
+namespace Graphics {
+	class Renderer;
+	class Material;
+	class RenderState;
+	class VertexArray;
+}
+
+namespace UI {
+
+// DrawList collects the quads that widgets draw (skin elements, text, icons
+// and images) into one vertex array per material and render state, so a
+// screen full of buttons and labels costs a handful of draws rather than a
+// few per widget.
+//
+// Quads are moved to screen space and clipped to the widget's scissor region
+// as they're added, which lets a batch span many widgets. A quad only joins
+// an earlier batch if it doesn't overlap anything added after that batch, so
+// the result looks the same as drawing everything in order.
+//
+// Widgets that draw with the renderer themselves pause the list. Everything
+// collected so far is drawn first, and while paused quads are drawn straight
+// away with the renderer's current transform and scissor, the same as
+// outside of Begin()/End().
+
+class DrawList {
+public:
+	DrawList(Graphics::Renderer *renderer);
+	~DrawList();
+
+	void Begin();
+	void End();
+
+	void Pause();
+	void Resume();
+
+	bool IsActive() const { return m_depth > 0 && m_paused == 0; }
+
+	// the current widget's top-left corner and scissor region, in screen space
+	void SetOrigin(const Point &origin) { m_origin = vector2f(origin.x, origin.y); }
+	void SetClip(const Point &pos, const Point &size);
+
+	// p0 is the top-left corner and p1 the bottom-right. colours are given
+	// top left, bottom left, top right, bottom right
+	void AddQuad(Graphics::Material *material, Graphics::RenderState *state, const vector2f &p0, const vector2f &p1, const vector2f &t0, const vector2f &t1, const Color c[4]);
+	void AddQuad(Graphics::Material *material, Graphics::RenderState *state, const vector2f &p0, const vector2f &p1, const vector2f &t0, const vector2f &t1, const Color &c);
+	void AddQuad(Graphics::Material *material, Graphics::RenderState *state, const vector2f &p0, const vector2f &p1, const Color c[4]);
+	void AddQuad(Graphics::Material *material, Graphics::RenderState *state, const vector2f &p0, const vector2f &p1, const Color &c);
+
+	// quads as Text::TextureFont lays them out: two triangles of three
+	// vertices, the first vertex and the last at opposite corners
+	void AddText(Graphics::Material *material, Graphics::RenderState *state, const Graphics::VertexArray &va);
+
+	// leaves the transform at identity and the scissor off
+	void Flush();
+
+private:
+	DrawList(const DrawList &);
+	DrawList &operator=(const DrawList &);
+
+	struct Batch {
+		Graphics::Material *material;
+		Graphics::RenderState *renderState;
+		bool textured;
+		vector2f min, max; // screen space bounds
+		std::unique_ptr<Graphics::VertexArray> vertices;
+	};
+
+	void Emit(Graphics::Material *material, Graphics::RenderState *state, bool textured, vector2f p0, vector2f p1, vector2f t0, vector2f t1, const Color c[4]);
+	Batch &FindBatch(Graphics::Material *material, Graphics::RenderState *state, bool textured, const vector2f &p0, const vector2f &p1);
+
+	Graphics::Renderer *m_renderer;
+	int m_depth;
+	int m_paused;
+
+	vector2f m_origin;
+	vector2f m_clipMin, m_clipMax;
+
+	// kept between frames so their vertex storage is reused
+	std::vector<Batch> m_batches;
+	size_t m_numBatches;
+};
+
+}
+
+#endif
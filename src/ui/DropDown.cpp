@@ -36,13 +36,13 @@ DropDown::DropDown(Context *context) : Container(context), m_popupWantToggle(fal
 
 Point DropDown::PreferredSize()
 {
-	return m_container->PreferredSize();
+	return m_container->GetPreferredSize();
 }
 
 void DropDown::Layout()
 {
 	SetWidgetDimensions(m_container, Point(), GetSize());
-	m_container->Layout();
+	m_container->LayoutIfNeeded();
 }
 
 void DropDown::Update()
@@ -61,7 +61,7 @@ void DropDown::Update()
 		else {
 			const Point pos(GetAbsolutePosition() + Point(0, GetSize().y));
 			m_popup->SetFont(GetFont());
-			c->NewLayer()->SetInnerWidget(m_popup.Get(), pos, m_popup->PreferredSize());
+			c->NewLayer()->SetInnerWidget(m_popup.Get(), pos, m_popup->GetPreferredSize());
 			m_popupActive = true;
 			m_icon->SetColor(activeColor);
 			m_contextClickCon = c->onClick.connect(sigc::mem_fun(this, &DropDown::HandlePopupClick));
@@ -4,7 +4,6 @@
 #include "Gradient.h"
 #include "Context.h"
 #include "graphics/Renderer.h"
-#include "graphics/VertexArray.h"
 #include "graphics/Material.h"
 
 namespace UI {
@@ -27,16 +26,18 @@ void Gradient::Draw()
 	const float sx = area.x;
 	const float sy = area.y;
 
-	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE);
-	va.Add(vector3f(x,    y,    0.0f), m_beginColor);
-	va.Add(vector3f(x,    y+sy, 0.0f), m_direction == HORIZONTAL ? m_beginColor : m_endColor);
-	va.Add(vector3f(x+sx, y,    0.0f), m_direction == HORIZONTAL ? m_endColor : m_beginColor);
-	va.Add(vector3f(x+sx, y+sy, 0.0f), m_endColor);
+	const float opacity = GetContext()->GetOpacity();
+	const Color begin(m_beginColor.r, m_beginColor.g, m_beginColor.b, opacity*m_beginColor.a);
+	const Color end(m_endColor.r, m_endColor.g, m_endColor.b, opacity*m_endColor.a);
+	const Color c[4] = {
+		begin,
+		m_direction == HORIZONTAL ? begin : end,
+		m_direction == HORIZONTAL ? end : begin,
+		end
+	};
 
-	Graphics::Renderer *r = GetContext()->GetRenderer();
 	auto renderState = GetContext()->GetSkin().GetAlphaBlendState();
-	m_material->diffuse = Color(Color::WHITE.r, Color::WHITE.g, Color::WHITE.b, GetContext()->GetOpacity()*Color::WHITE.a);
-	r->DrawTriangles(&va, renderState, m_material.get(), Graphics::TRIANGLE_STRIP);
+	GetContext()->GetDrawList().AddQuad(m_material.get(), renderState, vector2f(x, y), vector2f(x+sx, y+sy), c);
 
 	Container::Draw();
 }
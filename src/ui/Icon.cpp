@@ -52,6 +52,7 @@ Icon::Icon(Context *context, const std::string &iconName): Widget(context),
 
 		Graphics::MaterialDescriptor matDesc;
 		matDesc.textures = 1;
+		matDesc.vertexColors = true;
 		s_material.Reset(GetContext()->GetRenderer()->CreateMaterial(matDesc));
 		s_material->texture0 = s_texture.Get();
 	}
@@ -82,17 +83,10 @@ void Icon::Draw()
 	const float sx = area.x;
 	const float sy = area.y;
 
-	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
-	va.Add(vector3f(x,    y,    0.0f), vector2f(s_texScale.x*(m_texPos.x),    s_texScale.y*(m_texPos.y)));
-	va.Add(vector3f(x,    y+sy, 0.0f), vector2f(s_texScale.x*(m_texPos.x),    s_texScale.y*(m_texPos.y+48)));
-	va.Add(vector3f(x+sx, y,    0.0f), vector2f(s_texScale.x*(m_texPos.x+48), s_texScale.y*(m_texPos.y)));
-	va.Add(vector3f(x+sx, y+sy, 0.0f), vector2f(s_texScale.x*(m_texPos.x+48), s_texScale.y*(m_texPos.y+48)));
-
-	Graphics::Renderer *r = GetContext()->GetRenderer();
-	s_material->diffuse = m_color;
-	s_material->diffuse = Color(m_color.r, m_color.g, m_color.b, GetContext()->GetOpacity()*m_color.a);
+	const Color c(m_color.r, m_color.g, m_color.b, GetContext()->GetOpacity()*m_color.a);
 	auto renderState = GetContext()->GetSkin().GetAlphaBlendState();
-	r->DrawTriangles(&va, renderState, s_material.Get(), Graphics::TRIANGLE_STRIP);
+	GetContext()->GetDrawList().AddQuad(s_material.Get(), renderState, vector2f(x, y), vector2f(x+sx, y+sy),
+		vector2f(s_texScale.x*(m_texPos.x), s_texScale.y*(m_texPos.y)), vector2f(s_texScale.x*(m_texPos.x+48), s_texScale.y*(m_texPos.y+48)), c);
 }
 
 }
@@ -17,6 +17,7 @@ class Icon: public Widget {
 public:
 	virtual Point PreferredSize();
 	virtual void Draw();
+	virtual bool IsDrawBatched() const { return true; }
 
 	Icon *SetColor(const Color &c) { m_color = c; return this; }
 
@@ -17,6 +17,7 @@ Image::Image(Context *context, const std::string &filename, Uint32 sizeControlFl
 
 	Graphics::MaterialDescriptor material_desc;
 	material_desc.textures = 1;
+	material_desc.vertexColors = true;
 	m_material.Reset(GetContext()->GetRenderer()->CreateMaterial(material_desc));
 	m_material->texture0 = m_texture.Get();
 
@@ -33,7 +34,7 @@ Image *Image::SetHeightLines(Uint32 lines)
 	const Text::TextureFont *font = GetContext()->GetFont(GetFont()).Get();
 	const float height = font->GetHeight() * lines;
 	m_initialSize = UI::Point(height * float(m_initialSize.x) / float(m_initialSize.y), height);
-	GetContext()->RequestLayout();
+	RequestLayout();
 	return this;
 }
 
@@ -49,16 +50,10 @@ void Image::Draw()
 
 	const vector2f texSize = m_texture->GetDescriptor().texSize;
 
-	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
-	va.Add(vector3f(x,    y,    0.0f), vector2f(0.0f,      0.0f));
-	va.Add(vector3f(x,    y+sy, 0.0f), vector2f(0.0f,      texSize.y));
-	va.Add(vector3f(x+sx, y,    0.0f), vector2f(texSize.x, 0.0f));
-	va.Add(vector3f(x+sx, y+sy, 0.0f), vector2f(texSize.x, texSize.y));
-
-	Graphics::Renderer *r = GetContext()->GetRenderer();
 	auto renderState = GetContext()->GetSkin().GetAlphaBlendState();
-	m_material->diffuse = Color(Color::WHITE.r, Color::WHITE.g, Color::WHITE.b, GetContext()->GetOpacity()*Color::WHITE.a);
-	r->DrawTriangles(&va, renderState, m_material.Get(), Graphics::TRIANGLE_STRIP);
+	const Color c(Color::WHITE.r, Color::WHITE.g, Color::WHITE.b, GetContext()->GetOpacity()*Color::WHITE.a);
+	GetContext()->GetDrawList().AddQuad(m_material.Get(), renderState, vector2f(x, y), vector2f(x+sx, y+sy),
+		vector2f(0.0f), texSize, c);
 }
 
 }
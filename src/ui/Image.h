@@ -15,6 +15,7 @@ class Image: public Widget {
 public:
 	virtual Point PreferredSize();
 	virtual void Draw();
+	virtual bool IsDrawBatched() const { return true; }
 
 	Image *SetHeightLines(Uint32 lines);
 
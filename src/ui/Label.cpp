@@ -5,7 +5,6 @@
 #include "Context.h"
 #include "text/TextureFont.h"
 #include "graphics/VertexArray.h"
-#include "graphics/VertexBuffer.h"
 
 namespace UI {
 
@@ -15,9 +14,11 @@ Label::Label(Context *context, const std::string &text) : Widget(context)
 , m_bNeedsUpdating(true)
 , m_bPrevDisabled(false)
 , m_prevOpacity(-1.0f)
+, m_prevAtlasGeneration(0)
 , m_text(text)
 , m_color(Color::WHITE)
 , m_font(GetContext()->GetFont(GetFont()))
+, m_vertices(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0)
 {
 	RegisterBindPoint("text", sigc::mem_fun(this, &Label::BindText));
 }
@@ -26,10 +27,15 @@ Point Label::PreferredSize()
 {
 	if( m_font != GetContext()->GetFont(GetFont()) ) {
 		m_font = GetContext()->GetFont(GetFont());
+		m_preferredSize = Point();
+		m_bNeedsUpdating = true;
+	}
+	// only measured again when the text or font changes
+	if (m_preferredSize == Point()) {
+		vector2f textSize;
+		m_font->MeasureString(m_text, textSize.x, textSize.y);
+		m_preferredSize = Point(ceilf(textSize.x), ceilf(textSize.y));
 	}
-	vector2f textSize;
-	m_font->MeasureString(m_text, textSize.x, textSize.y);
-	m_preferredSize = Point(ceilf(textSize.x), ceilf(textSize.y));
 	return m_preferredSize;
 }
 
@@ -38,10 +44,10 @@ void Label::Layout()
 	if (m_preferredSize == Point())
 		PreferredSize();
 
+	// the glyphs are placed from the origin, so a new size doesn't need them
+	// done again
 	const Point &size = GetSize();
 	SetActiveArea(Point(std::min(m_preferredSize.x,size.x), std::min(m_preferredSize.y,size.y)));
-
-	m_bNeedsUpdating = true;
 }
 
 void Label::Draw()
@@ -53,24 +59,28 @@ void Label::Draw()
 	const float opacity = GetContext()->GetOpacity();
 	const Color finalColor(color.r, color.g, color.b, color.a*opacity);
 
-	if (m_bNeedsUpdating || m_font != GetContext()->GetFont(GetFont()) || !is_equal_exact(m_prevOpacity, opacity) || m_bPrevDisabled != IsDisabled())
+	if (m_bNeedsUpdating || m_font != GetContext()->GetFont(GetFont()) || !is_equal_exact(m_prevOpacity, opacity) || m_bPrevDisabled != IsDisabled() || m_prevAtlasGeneration != m_font->GetAtlasGeneration())
 	{
 		m_font = GetContext()->GetFont(GetFont());
-		Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0);
-		m_font->PopulateString(va, m_text, 0.0f, 0.0f, finalColor);
-		m_vbuffer.Reset( m_font->CreateVertexBuffer(va) );
+		m_vertices.Clear();
+		m_font->PopulateString(m_vertices, m_text, 0.0f, 0.0f, finalColor);
 		m_bNeedsUpdating = false;
 		m_bPrevDisabled = IsDisabled();
 		m_prevOpacity = opacity;
+		m_prevAtlasGeneration = m_font->GetAtlasGeneration();
 	}
 
-	m_font->RenderBuffer( m_vbuffer.Get() );
+	GetContext()->GetDrawList().AddText(m_font->GetMaterial(), m_font->GetRenderState(), m_vertices);
 }
 
 Label *Label::SetText(const std::string &text)
 {
+	// lots of callers set the same text every frame, don't relayout for that
+	if (text == m_text)
+		return this;
 	m_text = text;
-	GetContext()->RequestLayout();
+	m_preferredSize = Point();
+	RequestLayout();
 	m_bNeedsUpdating = true;
 	return this;
 }
@@ -7,7 +7,7 @@
 #include "Widget.h"
 #include "SmartPtr.h"
 #include "text/TextureFont.h"
-#include "graphics/VertexBuffer.h"
+#include "graphics/VertexArray.h"
 
 // single line of text
 
@@ -18,6 +18,7 @@ public:
 	virtual Point PreferredSize();
 	virtual void Layout();
 	virtual void Draw();
+	virtual bool IsDrawBatched() const { return true; }
 
 	Label *SetText(const std::string &text);
 	const std::string &GetText() const { return m_text; }
@@ -34,11 +35,12 @@ private:
 	bool m_bNeedsUpdating;
 	bool m_bPrevDisabled;
 	float m_prevOpacity;
+	Uint32 m_prevAtlasGeneration;
 	std::string m_text;
 	Color m_color;
 	Point m_preferredSize;
 	RefCountedPtr<Text::TextureFont> m_font;
-	RefCountedPtr<Graphics::VertexBuffer> m_vbuffer;
+	Graphics::VertexArray m_vertices;
 };
 
 }
@@ -5,6 +5,7 @@
 #include "Lua.h"
 #include "LuaConstants.h"
 #include "LuaSignal.h"
+#include "LuaRef.h"
 
 namespace UI {
 
@@ -37,13 +38,9 @@ public:
 		return 1;
 	}
 
-	static void _add_row(Table *t, lua_State *l, int idx) {
+	static void _get_row(UI::Context *c, lua_State *l, int idx, std::vector<UI::Widget*> &widgets) {
 		idx = lua_absindex(l, idx);
 
-		UI::Context *c = t->GetContext();
-
-		std::vector<UI::Widget*> widgets;
-
 		if (lua_istable(l, idx)) {
 			UI::Widget *w = UI::Lua::GetWidget(c, l, idx);
 			if (w)
@@ -57,7 +54,11 @@ public:
 		}
 		else
 			widgets.push_back(UI::Lua::CheckWidget(c, l, idx));
+	}
 
+	static void _add_row(Table *t, lua_State *l, int idx) {
+		std::vector<UI::Widget*> widgets;
+		_get_row(t->GetContext(), l, idx, widgets);
 		t->AddRow(WidgetSet(widgets));
 	}
 
@@ -83,6 +84,42 @@ public:
 		return 1;
 	}
 
+	// the builder is called as builder(index, row), where index counts from
+	// zero like onRowClicked and row is a table of widgets to reuse or nil
+	static WidgetSet _build_virtual_row(unsigned int index, const WidgetSet &recycled, UI::Context *c, LuaRef builder) {
+		lua_State *l = builder.GetLua();
+		LUA_DEBUG_START(l);
+
+		builder.PushCopyToStack();
+		lua_pushinteger(l, index);
+		if (recycled.widgets.empty())
+			lua_pushnil(l);
+		else {
+			lua_createtable(l, recycled.widgets.size(), 0);
+			for (size_t i = 0; i < recycled.widgets.size(); i++) {
+				LuaObject<UI::Widget>::PushToLua(recycled.widgets[i]);
+				lua_rawseti(l, -2, i+1);
+			}
+		}
+		pi_lua_protected_call(l, 2, 1);
+
+		std::vector<UI::Widget*> widgets;
+		_get_row(c, l, -1, widgets);
+		lua_pop(l, 1);
+
+		LUA_DEBUG_END(l, 0);
+		return WidgetSet(widgets);
+	}
+
+	static int l_set_virtual_rows(lua_State *l) {
+		UI::Table *t = LuaObject<UI::Table>::CheckFromLua(1);
+		const int numRows = luaL_checkinteger(l, 2);
+		luaL_checktype(l, 3, LUA_TFUNCTION);
+		t->SetVirtualRows(std::max(numRows, 0), sigc::bind(sigc::ptr_fun(&_build_virtual_row), t->GetContext(), LuaRef(l, 3)));
+		lua_pushvalue(l, 1);
+		return 1;
+	}
+
 	static int l_clear_rows(lua_State *l) {
 		UI::Table *t = LuaObject<UI::Table>::CheckFromLua(1);
 		t->ClearRows();
@@ -171,6 +208,7 @@ template <> void LuaObject<UI::Table>::RegisterClass()
 		{ "SetHeadingRow",      UI::LuaTable::l_set_heading_row      },
 		{ "AddRow",             UI::LuaTable::l_add_row              },
 		{ "AddRows",            UI::LuaTable::l_add_rows             },
+		{ "SetVirtualRows",     UI::LuaTable::l_set_virtual_rows     },
 		{ "ClearRows",          UI::LuaTable::l_clear_rows           },
 		{ "SetRowSpacing",      UI::LuaTable::l_set_row_spacing      },
 		{ "SetColumnSpacing",   UI::LuaTable::l_set_column_spacing   },
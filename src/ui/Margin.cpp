@@ -76,7 +76,7 @@ void Margin::Layout()
 
 	SetWidgetDimensions(GetInnerWidget(), innerPos, GetInnerWidget()->CalcSize(innerSize));
 
-	GetInnerWidget()->Layout();
+	GetInnerWidget()->LayoutIfNeeded();
 }
 
 }
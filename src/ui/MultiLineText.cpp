@@ -29,14 +29,14 @@ Point MultiLineText::PreferredSize()
 void MultiLineText::Layout()
 {
 	const Point newSize(m_layout->ComputeSize(GetSize()));
-	if (m_preferredSize != newSize) GetContext()->RequestLayout();
+	if (m_preferredSize != newSize) RequestLayout();
 	m_preferredSize = newSize;
 	SetActiveArea(m_preferredSize);
 }
 
 void MultiLineText::Draw()
 {
-	m_layout->Draw(GetSize(), GetDrawOffset(), GetContext()->GetScissor(), Color(Color::WHITE.r, Color::WHITE.g, Color::WHITE.b, Color::WHITE.a*GetContext()->GetOpacity()));
+	m_layout->Draw(GetContext()->GetDrawList(), GetSize(), GetDrawOffset(), GetContext()->GetScissor(), Color(Color::WHITE.r, Color::WHITE.g, Color::WHITE.b, Color::WHITE.a*GetContext()->GetOpacity()));
 }
 
 Widget *MultiLineText::SetFont(Font font) {
@@ -51,13 +51,18 @@ MultiLineText *MultiLineText::SetText(const std::string &text)
 	m_text = text;
 	m_layout.reset(new TextLayout(GetContext()->GetFont(GetFont()), m_text));
 	m_preferredSize = Point();
-	GetContext()->RequestLayout();
+	RequestLayout();
 	return this;
 }
 
 MultiLineText *MultiLineText::AppendText(const std::string &text)
 {
-	return SetText(m_text + text);
+	// the layout only has to wrap the new words
+	m_text += text;
+	m_layout->AppendText(text);
+	m_preferredSize = Point();
+	RequestLayout();
+	return this;
 }
 
 }
@@ -16,6 +16,7 @@ public:
 	virtual Point PreferredSize();
 	virtual void Layout();
 	virtual void Draw();
+	virtual bool IsDrawBatched() const { return true; }
 
 	virtual Widget *SetFont(Font font);
 
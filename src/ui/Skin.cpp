@@ -4,15 +4,15 @@
 #include "Skin.h"
 #include "IniConfig.h"
 #include "graphics/TextureBuilder.h"
-#include "graphics/VertexArray.h"
 #include "FileSystem.h"
 
 namespace UI {
 
 static const float SKIN_SIZE = 512.0f;
 
-Skin::Skin(const std::string &filename, Graphics::Renderer *renderer, float scale) :
+Skin::Skin(const std::string &filename, Graphics::Renderer *renderer, DrawList *drawList, float scale) :
 	m_renderer(renderer),
+	m_drawList(drawList),
 	m_scale(scale),
 	m_opacity(1.0f)
 {
@@ -27,8 +27,10 @@ Skin::Skin(const std::string &filename, Graphics::Renderer *renderer, float scal
 
 	m_texture.Reset(Graphics::TextureBuilder::UI(cfg.String("TextureFile")).GetOrCreateTexture(m_renderer, "ui"));
 
+	// colours come per vertex, so skin elements can be batched across widgets
 	Graphics::MaterialDescriptor desc;
 	desc.textures = 1;
+	desc.vertexColors = true;
 	m_textureMaterial.Reset(m_renderer->CreateMaterial(desc));
 	m_textureMaterial->texture0 = m_texture.Get();
 	m_textureMaterial->diffuse = Color::WHITE;
@@ -107,17 +109,16 @@ static inline vector2f scaled(const vector2f &v)
 	return v * (1.0f / SKIN_SIZE);
 }
 
-void Skin::DrawRectElement(const RectElement &element, const Point &pos, const Point &size, Graphics::BlendMode blendMode) const
+void Skin::AddQuad(const vector2f &p0, const vector2f &p1, const vector2f &t0, const vector2f &t1, Graphics::BlendMode blendMode) const
 {
-	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
-
-	va.Add(vector3f(pos.x,        pos.y,        0.0f), scaled(vector2f(element.pos.x,                element.pos.y)));
-	va.Add(vector3f(pos.x,        pos.y+size.y, 0.0f), scaled(vector2f(element.pos.x,                element.pos.y+element.size.y)));
-	va.Add(vector3f(pos.x+size.x, pos.y,        0.0f), scaled(vector2f(element.pos.x+element.size.x, element.pos.y)));
-	va.Add(vector3f(pos.x+size.x, pos.y+size.y, 0.0f), scaled(vector2f(element.pos.x+element.size.x, element.pos.y+element.size.y)));
+	const Color c(Color::WHITE.r, Color::WHITE.g, Color::WHITE.b, m_opacity*Color::WHITE.a);
+	m_drawList->AddQuad(m_textureMaterial.Get(), GetRenderState(blendMode), p0, p1, scaled(t0), scaled(t1), c);
+}
 
-	m_textureMaterial->diffuse = Color(Color::WHITE.r, Color::WHITE.g, Color::WHITE.b, m_opacity*Color::WHITE.a);
-	m_renderer->DrawTriangles(&va, GetRenderState(blendMode), m_textureMaterial.Get(), Graphics::TRIANGLE_STRIP);
+void Skin::DrawRectElement(const RectElement &element, const Point &pos, const Point &size, Graphics::BlendMode blendMode) const
+{
+	AddQuad(vector2f(pos.x, pos.y), vector2f(pos.x+size.x, pos.y+size.y),
+		vector2f(element.pos.x, element.pos.y), vector2f(element.pos.x+element.size.x, element.pos.y+element.size.y), blendMode);
 }
 
 void Skin::DrawBorderedRectElement(const BorderedRectElement &element, const Point &pos, const Point &size, Graphics::BlendMode blendMode) const
@@ -125,96 +126,45 @@ void Skin::DrawBorderedRectElement(const BorderedRectElement &element, const Poi
 	const float width = element.borderWidth;
 	const float height = element.borderHeight;
 
-	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
-
-	va.Add(vector3f(pos.x,              pos.y,        0.0f), scaled(vector2f(element.pos.x,                             element.pos.y)));
-	va.Add(vector3f(pos.x,              pos.y+height, 0.0f), scaled(vector2f(element.pos.x,                             element.pos.y+height)));
-	va.Add(vector3f(pos.x+width,        pos.y,        0.0f), scaled(vector2f(element.pos.x+width,                       element.pos.y)));
-	va.Add(vector3f(pos.x+width,        pos.y+height, 0.0f), scaled(vector2f(element.pos.x+width,                       element.pos.y+height)));
-	va.Add(vector3f(pos.x+size.x-width, pos.y,        0.0f), scaled(vector2f(element.pos.x+element.size.x-width,        element.pos.y)));
-	va.Add(vector3f(pos.x+size.x-width, pos.y+height, 0.0f), scaled(vector2f(element.pos.x+element.size.x-width,        element.pos.y+height)));
-	va.Add(vector3f(pos.x+size.x,       pos.y,        0.0f), scaled(vector2f(element.pos.x+element.size.x,              element.pos.y)));
-	va.Add(vector3f(pos.x+size.x,       pos.y+height, 0.0f), scaled(vector2f(element.pos.x+element.size.x,              element.pos.y+height)));
-
-	// degenerate triangles to join rows
-	va.Add(vector3f(pos.x+size.x,       pos.y+height, 0.0f), scaled(vector2f(element.pos.x+element.size.x,              element.pos.y+height)));
-	va.Add(vector3f(pos.x,              pos.y+height, 0.0f), scaled(vector2f(element.pos.x,                             element.pos.y+height)));
-
-	va.Add(vector3f(pos.x,              pos.y+height,        0.0f), scaled(vector2f(element.pos.x,                      element.pos.y+height)));
-	va.Add(vector3f(pos.x,              pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x,                      element.pos.y+element.size.y-height)));
-	va.Add(vector3f(pos.x+width,        pos.y+height,        0.0f), scaled(vector2f(element.pos.x+width,                element.pos.y+height)));
-	va.Add(vector3f(pos.x+width,        pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x+width,                element.pos.y+element.size.y-height)));
-	va.Add(vector3f(pos.x+size.x-width, pos.y+height,        0.0f), scaled(vector2f(element.pos.x+element.size.x-width, element.pos.y+height)));
-	va.Add(vector3f(pos.x+size.x-width, pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x+element.size.x-width, element.pos.y+element.size.y-height)));
-	va.Add(vector3f(pos.x+size.x,       pos.y+height,        0.0f), scaled(vector2f(element.pos.x+element.size.x,       element.pos.y+height)));
-	va.Add(vector3f(pos.x+size.x,       pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x+element.size.x,       element.pos.y+element.size.y-height)));
-
-	// degenerate triangles to join rows
-	va.Add(vector3f(pos.x+size.x,       pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x+element.size.x,       element.pos.y+element.size.y-height)));
-	va.Add(vector3f(pos.x,              pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x,                      element.pos.y+element.size.y-height)));
-
-	va.Add(vector3f(pos.x,              pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x,                      element.pos.y+element.size.y-height)));
-	va.Add(vector3f(pos.x,              pos.y+size.y,        0.0f), scaled(vector2f(element.pos.x,                      element.pos.y+element.size.y)));
-	va.Add(vector3f(pos.x+width,        pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x+width,                element.pos.y+element.size.y-height)));
-	va.Add(vector3f(pos.x+width,        pos.y+size.y,        0.0f), scaled(vector2f(element.pos.x+width,                element.pos.y+element.size.y)));
-	va.Add(vector3f(pos.x+size.x-width, pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x+element.size.x-width, element.pos.y+element.size.y-height)));
-	va.Add(vector3f(pos.x+size.x-width, pos.y+size.y,        0.0f), scaled(vector2f(element.pos.x+element.size.x-width, element.pos.y+element.size.y)));
-	va.Add(vector3f(pos.x+size.x,       pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x+element.size.x,       element.pos.y+element.size.y-height)));
-	va.Add(vector3f(pos.x+size.x,       pos.y+size.y,        0.0f), scaled(vector2f(element.pos.x+element.size.x,       element.pos.y+element.size.y)));
-
-	m_textureMaterial->diffuse = Color(Color::WHITE.r, Color::WHITE.g, Color::WHITE.b, m_opacity*Color::WHITE.a);
-	m_renderer->DrawTriangles(&va, GetRenderState(blendMode), m_textureMaterial.Get(), Graphics::TRIANGLE_STRIP);
+	// three rows and three columns, the corners keep their size
+	const float x[4] = { float(pos.x), pos.x+width, pos.x+size.x-width, float(pos.x+size.x) };
+	const float y[4] = { float(pos.y), pos.y+height, pos.y+size.y-height, float(pos.y+size.y) };
+	const float u[4] = { float(element.pos.x), element.pos.x+width, element.pos.x+element.size.x-width, float(element.pos.x+element.size.x) };
+	const float v[4] = { float(element.pos.y), element.pos.y+height, element.pos.y+element.size.y-height, float(element.pos.y+element.size.y) };
+
+	for (int row = 0; row < 3; row++)
+		for (int col = 0; col < 3; col++)
+			AddQuad(vector2f(x[col], y[row]), vector2f(x[col+1], y[row+1]), vector2f(u[col], v[row]), vector2f(u[col+1], v[row+1]), blendMode);
 }
 
 void Skin::DrawVerticalEdgedRectElement(const EdgedRectElement &element, const Point &pos, const Point &size, Graphics::BlendMode blendMode) const
 {
 	const float height = element.edgeWidth;
 
-	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
-
-	va.Add(vector3f(pos.x+size.x, pos.y,               0.0f), scaled(vector2f(element.pos.x+element.size.x, element.pos.y)));
-	va.Add(vector3f(pos.x,        pos.y,               0.0f), scaled(vector2f(element.pos.x,                element.pos.y)));
-	va.Add(vector3f(pos.x+size.x, pos.y+height,        0.0f), scaled(vector2f(element.pos.x+element.size.x, element.pos.y+height)));
-	va.Add(vector3f(pos.x,        pos.y+height,        0.0f), scaled(vector2f(element.pos.x,                element.pos.y+height)));
-	va.Add(vector3f(pos.x+size.x, pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x+element.size.x, element.pos.y+element.size.y-height)));
-	va.Add(vector3f(pos.x,        pos.y+size.y-height, 0.0f), scaled(vector2f(element.pos.x,                element.pos.y+element.size.y-height)));
-	va.Add(vector3f(pos.x+size.x, pos.y+size.y,        0.0f), scaled(vector2f(element.pos.x+element.size.x, element.pos.y+element.size.y)));
-	va.Add(vector3f(pos.x,        pos.y+size.y,        0.0f), scaled(vector2f(element.pos.x,                element.pos.y+element.size.y)));
+	const float y[4] = { float(pos.y), pos.y+height, pos.y+size.y-height, float(pos.y+size.y) };
+	const float v[4] = { float(element.pos.y), element.pos.y+height, element.pos.y+element.size.y-height, float(element.pos.y+element.size.y) };
 
-	m_textureMaterial->diffuse = Color(Color::WHITE.r, Color::WHITE.g, Color::WHITE.b, m_opacity*Color::WHITE.a);
-	m_renderer->DrawTriangles(&va, GetRenderState(blendMode), m_textureMaterial.Get(), Graphics::TRIANGLE_STRIP);
+	for (int row = 0; row < 3; row++)
+		AddQuad(vector2f(pos.x, y[row]), vector2f(pos.x+size.x, y[row+1]),
+			vector2f(element.pos.x, v[row]), vector2f(element.pos.x+element.size.x, v[row+1]), blendMode);
 }
 
 void Skin::DrawHorizontalEdgedRectElement(const EdgedRectElement &element, const Point &pos, const Point &size, Graphics::BlendMode blendMode) const
 {
 	const float width = element.edgeWidth;
 
-	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
-
-	va.Add(vector3f(pos.x,              pos.y,        0.0f), scaled(vector2f(element.pos.x,                      element.pos.y)));
-	va.Add(vector3f(pos.x,              pos.y+size.y, 0.0f), scaled(vector2f(element.pos.x,                      element.pos.y+element.size.y)));
-	va.Add(vector3f(pos.x+width,        pos.y,        0.0f), scaled(vector2f(element.pos.x+width,                element.pos.y)));
-	va.Add(vector3f(pos.x+width,        pos.y+size.y, 0.0f), scaled(vector2f(element.pos.x+width,                element.pos.y+element.size.y)));
-	va.Add(vector3f(pos.x+size.x-width, pos.y,        0.0f), scaled(vector2f(element.pos.x+element.size.x-width, element.pos.y)));
-	va.Add(vector3f(pos.x+size.x-width, pos.y+size.y, 0.0f), scaled(vector2f(element.pos.x+element.size.x-width, element.pos.y+element.size.y)));
-	va.Add(vector3f(pos.x+size.x,       pos.y,        0.0f), scaled(vector2f(element.pos.x+element.size.x,       element.pos.y)));
-	va.Add(vector3f(pos.x+size.x,       pos.y+size.y, 0.0f), scaled(vector2f(element.pos.x+element.size.x,       element.pos.y+element.size.y)));
+	const float x[4] = { float(pos.x), pos.x+width, pos.x+size.x-width, float(pos.x+size.x) };
+	const float u[4] = { float(element.pos.x), element.pos.x+width, element.pos.x+element.size.x-width, float(element.pos.x+element.size.x) };
 
-	m_textureMaterial->diffuse = Color(Color::WHITE.r, Color::WHITE.g, Color::WHITE.b, m_opacity*Color::WHITE.a);
-	m_renderer->DrawTriangles(&va, GetRenderState(blendMode), m_textureMaterial.Get(), Graphics::TRIANGLE_STRIP);
+	for (int col = 0; col < 3; col++)
+		AddQuad(vector2f(x[col], pos.y), vector2f(x[col+1], pos.y+size.y),
+			vector2f(u[col], element.pos.y), vector2f(u[col+1], element.pos.y+element.size.y), blendMode);
 }
 
 void Skin::DrawRectColor(const Color &col, const Point &pos, const Point &size) const
 {
-	Graphics::VertexArray va(Graphics::ATTRIB_POSITION);
-
-	va.Add(vector3f(pos.x,        pos.y,        0.0f));
-	va.Add(vector3f(pos.x,        pos.y+size.y, 0.0f));
-	va.Add(vector3f(pos.x+size.x, pos.y,        0.0f));
-	va.Add(vector3f(pos.x+size.x, pos.y+size.y, 0.0f));
-
-	m_colorMaterial->diffuse = Color(col.r, col.g, col.b, m_opacity*col.a);
-	m_renderer->DrawTriangles(&va, GetAlphaBlendState(), m_colorMaterial.Get(), Graphics::TRIANGLE_STRIP);
+	m_drawList->AddQuad(m_colorMaterial.Get(), GetAlphaBlendState(),
+		vector2f(pos.x, pos.y), vector2f(pos.x+size.x, pos.y+size.y), Color(col.r, col.g, col.b, m_opacity*col.a));
 }
 
 static size_t SplitSpec(const std::string &spec, std::vector<int> &output)
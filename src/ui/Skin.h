@@ -10,6 +10,7 @@
 #include "graphics/Material.h"
 #include "graphics/RenderState.h"
 #include "Point.h"
+#include "DrawList.h"
 
 #include <SDL_stdinc.h>
 
@@ -17,7 +18,7 @@ namespace UI {
 
 class Skin {
 public:
-	Skin(const std::string &filename, Graphics::Renderer *renderer, float scale);
+	Skin(const std::string &filename, Graphics::Renderer *renderer, DrawList *drawList, float scale);
 
 	void SetOpacity(float o) { m_opacity = o; }
 
@@ -213,6 +214,7 @@ public:
 
 private:
 	Graphics::Renderer *m_renderer;
+	DrawList *m_drawList;
 
 	float m_scale;
 
@@ -230,6 +232,8 @@ private:
 	void DrawBorderedRectElement(const BorderedRectElement &element, const Point &pos, const Point &size, Graphics::BlendMode blendMode = Graphics::BLEND_ALPHA) const;
 	void DrawVerticalEdgedRectElement(const EdgedRectElement &element, const Point &pos, const Point &size, Graphics::BlendMode blendMode = Graphics::BLEND_ALPHA) const;
 	void DrawHorizontalEdgedRectElement(const EdgedRectElement &element, const Point &pos, const Point &size, Graphics::BlendMode blendMode = Graphics::BLEND_ALPHA) const;
+	// one quad of an element, p0/p1 in widget space and t0/t1 in skin texels
+	void AddQuad(const vector2f &p0, const vector2f &p1, const vector2f &t0, const vector2f &t1, Graphics::BlendMode blendMode) const;
 
 	RectElement LoadRectElement(const std::string &spec);
 	BorderedRectElement LoadBorderedRectElement(const std::string &spec);
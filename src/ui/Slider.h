@@ -13,6 +13,7 @@ public:
 	virtual Point PreferredSize();
 	virtual void Layout();
 	virtual void Draw();
+	virtual bool IsDrawBatched() const { return true; }
 
 	float GetValue() const { return m_value; }
 	void SetValue(float v);
@@ -5,6 +5,7 @@
 #include "Context.h"
 #include "Slider.h"
 
+#include <algorithm>
 #include <typeinfo>
 
 namespace UI {
@@ -34,7 +35,10 @@ void Table::LayoutAccumulator::AddRow(const std::vector<Widget*> &widgets)
 
 void Table::LayoutAccumulator::Clear()
 {
-	m_columnWidth.clear();
+	if (m_keepColumnWidths)
+		m_columnWidth = m_keptColumnWidth;
+	else
+		m_columnWidth.clear();
 	m_columnLeft.clear();
 	m_preferredWidth = 0;
 }
@@ -43,6 +47,10 @@ void Table::LayoutAccumulator::ComputeForWidth(int availWidth) {
 	if (m_columnWidth.empty())
 		return;
 
+	// before the expanded columns get their share of the width
+	if (m_keepColumnWidths)
+		m_keptColumnWidth = m_columnWidth;
+
 	if (m_preferredWidth == SIZE_EXPAND) {
 		int fixedSize = m_columnSpacing * (m_columnWidth.size()-1);
 		int numExpand = 0;
@@ -102,7 +110,11 @@ Table::Inner::Inner(Context *context, LayoutAccumulator &layout) : Container(con
 	m_rowSpacing(0),
 	m_rowAlignment(ROW_TOP),
 	m_dirty(false),
-	m_mouseEnabled(false)
+	m_mouseEnabled(false),
+	m_virtual(false),
+	m_numVirtualRows(0),
+	m_firstVirtualRow(0),
+	m_virtualRowHeight(0)
 {
 }
 
@@ -133,7 +145,15 @@ Point Table::Inner::PreferredSize()
 		m_preferredSize.y += m_rowHeight[i];
 	}
 
-	if (!m_rows.empty() && m_rowSpacing)
+	if (m_virtual) {
+		// rows that aren't built are assumed to be as tall as the ones that are
+		if (!m_rowHeight.empty())
+			m_virtualRowHeight = std::max(m_virtualRowHeight, *std::max_element(m_rowHeight.begin(), m_rowHeight.end()));
+		m_preferredSize.y = m_numVirtualRows*m_virtualRowHeight;
+		if (m_numVirtualRows && m_rowSpacing)
+			m_preferredSize.y += (m_numVirtualRows-1)*m_rowSpacing;
+	}
+	else if (!m_rows.empty() && m_rowSpacing)
 		m_preferredSize.y += (m_rows.size()-1)*m_rowSpacing;
 
 	m_dirty = false;
@@ -145,28 +165,29 @@ void Table::Inner::Layout()
 	if (m_dirty)
 		PreferredSize();
 
-	int rowTop = 0;
+	int rowTop = m_virtual ? m_firstVirtualRow*(m_virtualRowHeight+m_rowSpacing) : 0;
 
 	const std::vector<int> &colWidth = m_layout.ColumnWidth();
 	const std::vector<int> &colLeft = m_layout.ColumnLeft();
 
 	for (std::size_t i = 0; i < m_rows.size(); i++) {
 		const std::vector<Widget*> &row = m_rows[i];
+		const int rowHeight = m_virtual ? m_virtualRowHeight : m_rowHeight[i];
 		for (std::size_t j = 0; j < row.size(); j++) {
 			Widget *w = row[j];
 			if (!w) continue;
 
-			const Point preferredSize(w->PreferredSize());
-			int height = std::min(preferredSize.y, m_rowHeight[i]);
+			const Point preferredSize(w->GetPreferredSize());
+			int height = std::min(preferredSize.y, rowHeight);
 
 			int off = 0;
-			if (height != m_rowHeight[i]) {
+			if (height != rowHeight) {
 				switch (m_rowAlignment) {
 					case ROW_CENTER:
-						off = (m_rowHeight[i] - height) / 2;
+						off = (rowHeight - height) / 2;
 						break;
 					case ROW_BOTTOM:
-						off = m_rowHeight[i] - height;
+						off = rowHeight - height;
 						break;
 					default:
 						off = 0;
@@ -177,7 +198,7 @@ void Table::Inner::Layout()
 			SetWidgetDimensions(w, Point(colLeft[j], rowTop+off), Point(colWidth[j], height));
 		}
 
-		rowTop += m_rowHeight[i] + m_rowSpacing;
+		rowTop += rowHeight + m_rowSpacing;
 	}
 
 	LayoutChildren();
@@ -195,6 +216,7 @@ void Table::Inner::Draw()
 
 void Table::Inner::AddRow(const std::vector<Widget*> &widgets)
 {
+	assert(!m_virtual);
 	m_rows.push_back(widgets);
 
 	Point rowSize;
@@ -219,6 +241,13 @@ void Table::Inner::Clear()
 	m_preferredSize = Point();
 
 	m_dirty = false;
+
+	m_virtual = false;
+	m_numVirtualRows = 0;
+	m_firstVirtualRow = 0;
+	m_virtualRowHeight = 0;
+	m_rowBuilder = RowBuilder();
+	m_rowPool.clear();
 }
 
 void Table::Inner::AccumulateLayout()
@@ -227,6 +256,109 @@ void Table::Inner::AccumulateLayout()
 		m_layout.AddRow(*i);
 
 	m_dirty = true;
+
+	// the columns are shared with the other half of the table, so a change
+	// over there can move our cells even if nothing in here changed
+	SetLayoutNeeded(true);
+}
+
+void Table::Inner::SetVirtualRows(unsigned int numRows, const RowBuilder &builder)
+{
+	Clear();
+
+	m_virtual = true;
+	m_numVirtualRows = numRows;
+	m_rowBuilder = builder;
+	m_dirty = true;
+
+	RequestLayout();
+}
+
+void Table::Inner::ShowVirtualRows(int top, int height)
+{
+	if (!m_virtual)
+		return;
+
+	// can't tell how many rows fit until one has been built
+	if (m_rows.empty() && !m_virtualRowHeight && m_numVirtualRows) {
+		m_rows.push_back(BuildVirtualRow(0));
+		m_firstVirtualRow = 0;
+		m_dirty = true;
+	}
+	MeasureVirtualRows();
+
+	const int step = std::max(m_virtualRowHeight + m_rowSpacing, 1);
+	const unsigned int first = std::min(unsigned(std::max(top, 0) / step), m_numVirtualRows);
+	const unsigned int end = std::max(first, std::min(unsigned((std::max(top, 0) + std::max(height, 0) + step - 1) / step), m_numVirtualRows));
+
+	const unsigned int oldFirst = m_firstVirtualRow;
+	const unsigned int oldEnd = oldFirst + m_rows.size();
+	if (first == oldFirst && end == oldEnd)
+		return;
+
+	// release before building so the builder gets the released rows back
+	for (unsigned int i = oldFirst; i < oldEnd; i++)
+		if (i < first || i >= end)
+			ReleaseVirtualRow(m_rows[i-oldFirst]);
+
+	std::vector< std::vector<Widget*> > rows;
+	rows.reserve(end-first);
+	for (unsigned int i = first; i < end; i++) {
+		if (i >= oldFirst && i < oldEnd)
+			rows.push_back(m_rows[i-oldFirst]);
+		else
+			rows.push_back(BuildVirtualRow(i));
+	}
+
+	m_rows.swap(rows);
+	m_firstVirtualRow = first;
+	m_dirty = true;
+
+	// enough spares to refill the whole view, no more
+	if (m_rowPool.size() > m_rows.size())
+		m_rowPool.resize(m_rows.size());
+}
+
+std::vector<Widget*> Table::Inner::BuildVirtualRow(unsigned int index)
+{
+	std::vector< RefCountedPtr<Widget> > pooled;
+	std::vector<Widget*> recycled;
+	if (!m_rowPool.empty()) {
+		pooled.swap(m_rowPool.back());
+		m_rowPool.pop_back();
+		for (std::size_t i = 0; i < pooled.size(); i++)
+			recycled.push_back(pooled[i].Get());
+	}
+
+	const WidgetSet set(m_rowBuilder(index, WidgetSet(recycled)));
+	for (std::size_t i = 0; i < set.widgets.size(); i++) {
+		if (!set.widgets[i]) continue;
+		AddWidget(set.widgets[i]);
+	}
+
+	// any recycled widgets the builder didn't use go away with pooled
+	return set.widgets;
+}
+
+void Table::Inner::ReleaseVirtualRow(const std::vector<Widget*> &row)
+{
+	std::vector< RefCountedPtr<Widget> > pooled;
+	for (std::size_t i = 0; i < row.size(); i++) {
+		if (!row[i]) continue;
+		pooled.push_back(RefCountedPtr<Widget>(row[i]));
+		RemoveWidget(row[i]);
+	}
+	m_rowPool.push_back(pooled);
+}
+
+void Table::Inner::MeasureVirtualRows()
+{
+	for (std::size_t i = 0; i < m_rows.size(); i++)
+		for (std::size_t j = 0; j < m_rows[i].size(); j++) {
+			Widget *w = m_rows[i][j];
+			if (!w) continue;
+			m_virtualRowHeight = std::max(m_virtualRowHeight, w->CalcLayoutContribution().y);
+		}
 }
 
 void Table::Inner::SetRowSpacing(int spacing)
@@ -254,6 +386,22 @@ void Table::Inner::HandleClick()
 
 int Table::Inner::RowUnderPoint(const Point &pt, int *out_row_top, int *out_row_bottom) const
 {
+	if (m_virtual) {
+		const int step = m_virtualRowHeight + m_rowSpacing;
+		if (step > 0 && pt.y >= 0) {
+			const int row = pt.y / step;
+			const int rowTop = row * step;
+			if (unsigned(row) < m_numVirtualRows && pt.y < rowTop + m_virtualRowHeight) {
+				if (out_row_top) { *out_row_top = rowTop; }
+				if (out_row_bottom) { *out_row_bottom = rowTop + m_virtualRowHeight; }
+				return row;
+			}
+		}
+		if (out_row_top) { *out_row_top = 0; }
+		if (out_row_bottom) { *out_row_bottom = 0; }
+		return -1;
+	}
+
 	int start = 0, end = m_rows.size()-1, mid = 0;
 	while (start <= end) {
 		mid = start+((end-start)/2);
@@ -279,8 +427,7 @@ int Table::Inner::RowUnderPoint(const Point &pt, int *out_row_top, int *out_row_
 }
 
 
-Table::Table(Context *context) : Container(context),
-	m_dirty(false)
+Table::Table(Context *context) : Container(context)
 {
 	m_header.Reset(new Table::Inner(GetContext(), m_layout));
 	AddWidget(m_header.Get());
@@ -296,16 +443,15 @@ Table::Table(Context *context) : Container(context),
 
 Point Table::PreferredSize()
 {
-	if (m_dirty) {
-		m_layout.Clear();
-
-		m_header->AccumulateLayout();
-		m_body->AccumulateLayout();
+	// only called when something within the table has requested layout (the
+	// result is cached otherwise) or from Layout(), which needs the column
+	// widths fresh because ComputeForWidth() fills in the expanded ones
+	m_layout.Clear();
 
-		m_dirty = false;
-	}
+	m_header->AccumulateLayout();
+	m_body->AccumulateLayout();
 
-	const Point sliderSize = m_slider->PreferredSize();
+	const Point sliderSize = m_slider->GetPreferredSize();
 
 	const Point headerPreferredSize = m_header->PreferredSize();
 	const Point bodyPreferredSize = m_body->PreferredSize();
@@ -315,8 +461,8 @@ Point Table::PreferredSize()
 
 void Table::Layout()
 {
-	// always dirty because some widget within the table may have requested layout
-	m_dirty = true;
+	// before measuring, so that rows coming into view are counted
+	UpdateVirtualRows();
 
 	PreferredSize();
 
@@ -343,10 +489,10 @@ void Table::Layout()
 		if (!m_onMouseWheelConn.connected())
 			m_onMouseWheelConn = onMouseWheel.connect(sigc::mem_fun(this, &Table::OnMouseWheel));
 
-		const Point sliderSize(m_slider->PreferredSize().x, size.y);
+		const Point sliderSize(m_slider->GetPreferredSize().x, size.y);
 		const Point sliderPos(size.x-sliderSize.x, top);
 		SetWidgetDimensions(m_slider.Get(), sliderPos, sliderSize);
-		m_slider->Layout();
+		m_slider->LayoutIfNeeded();
 
 		size.x = sliderPos.x;
 
@@ -370,63 +516,64 @@ Table *Table::SetHeadingRow(const WidgetSet &set)
 {
 	m_header->Clear();
 	m_header->AddRow(set.widgets);
-	m_dirty = true;
-	GetContext()->RequestLayout();
+	RequestLayout();
 	return this;
 }
 
 Table *Table::AddRow(const WidgetSet &set)
 {
 	m_body->AddRow(set.widgets);
-	m_dirty = true;
-	GetContext()->RequestLayout();
+	RequestLayout();
+	return this;
+}
+
+Table *Table::SetVirtualRows(unsigned int numRows, const RowBuilder &builder)
+{
+	m_body->SetVirtualRows(numRows, builder);
+	m_layout.SetKeepColumnWidths(true);
+	RequestLayout();
 	return this;
 }
 
 void Table::ClearRows()
 {
 	m_body->Clear();
-	m_dirty = true;
-	GetContext()->RequestLayout();
+	m_layout.SetKeepColumnWidths(false);
+	RequestLayout();
 }
 
 Table *Table::SetRowSpacing(int spacing)
 {
 	m_body->SetRowSpacing(spacing);
-	m_dirty = true;
-	GetContext()->RequestLayout();
+	RequestLayout();
 	return this;
 }
 
 Table *Table::SetColumnSpacing(int spacing)
 {
 	m_layout.SetColumnSpacing(spacing);
-	m_dirty = true;
-	GetContext()->RequestLayout();
+	RequestLayout();
 	return this;
 }
 
 Table *Table::SetRowAlignment(RowAlignDirection dir)
 {
 	m_body->SetRowAlignment(dir);
-	m_dirty = true;
-	GetContext()->RequestLayout();
+	RequestLayout();
 	return this;
 }
 
 Table *Table::SetColumnAlignment(ColumnAlignDirection mode)
 {
 	m_layout.SetColumnAlignment(mode);
-	m_dirty = true;
-	GetContext()->RequestLayout();
+	RequestLayout();
 	return this;
 }
 
 Table *Table::SetHeadingFont(Font font)
 {
 	m_header->SetFont(font);
-	m_dirty = true;
-	GetContext()->RequestLayout();
+	RequestLayout();
 	return this;
 }
 
@@ -443,6 +590,13 @@ void Table::OnScroll(float value)
 		m_body->SetDrawOffset(Point(0, -float(m_body->PreferredSize().y-(GetSize().y-m_header->PreferredSize().y))*value));
 	else
 		m_body->SetDrawOffset(Point());
+
+	UpdateVirtualRows();
+}
+
+void Table::UpdateVirtualRows()
+{
+	m_body->ShowVirtualRows(-m_body->GetDrawOffset().y, GetSize().y - m_header->GetSize().y);
 }
 
 bool Table::OnMouseWheel(const MouseWheelEvent &event)
@@ -7,6 +7,7 @@
 #include "Container.h"
 #include "Slider.h"
 #include "Event.h"
+#include "WidgetSet.h"
 
 namespace UI {
 
@@ -23,6 +24,18 @@ public:
 	Table *AddRow(const WidgetSet &set);
 	void ClearRows();
 
+	// virtual rows. instead of adding every row up front, give the number of
+	// rows and a function to build one. only rows that are scrolled into
+	// view get built, and rows that scroll out are passed back to the
+	// builder to be refilled for another index, so the number of widgets
+	// depends on the height of the table rather than the number of rows.
+	// the builder gets the row index and a row to reuse (empty if there
+	// isn't one) and returns the widgets for the row, which must not be
+	// part of any other row. every virtual row gets the height of the
+	// tallest one built so far
+	typedef sigc::slot<WidgetSet,unsigned int,const WidgetSet &> RowBuilder;
+	Table *SetVirtualRows(unsigned int numRows, const RowBuilder &builder);
+
 	Table *SetRowSpacing(int spacing);
 	Table *SetColumnSpacing(int spacing);
 
@@ -57,7 +70,7 @@ private:
 
 	class LayoutAccumulator {
 	public:
-		LayoutAccumulator() : m_columnSpacing(0), m_preferredWidth(0), m_columnAlignment(COLUMN_LEFT) {}
+		LayoutAccumulator() : m_columnSpacing(0), m_preferredWidth(0), m_columnAlignment(COLUMN_LEFT), m_keepColumnWidths(false) {}
 
 		void AddRow(const std::vector<Widget*> &widgets);
 		void Clear();
@@ -67,6 +80,10 @@ private:
 		void SetColumnSpacing(int spacing) { m_columnSpacing = spacing; }
 		void SetColumnAlignment(ColumnAlignDirection dir) { m_columnAlignment = dir; }
 
+		// start each pass from the widest columns seen so far rather than
+		// from nothing, for rows that come and go as the table scrolls
+		void SetKeepColumnWidths(bool keep) { m_keepColumnWidths = keep; m_keptColumnWidth.clear(); }
+
 		void ComputeForWidth(int availWidth);
 
 		int GetPreferredWidth() const { return m_preferredWidth; }
@@ -80,6 +97,8 @@ private:
 		int m_columnSpacing;
 		int m_preferredWidth;
 		ColumnAlignDirection m_columnAlignment;
+		bool m_keepColumnWidths;
+		std::vector<int> m_keptColumnWidth;
 	};
 
 
@@ -96,6 +115,11 @@ private:
 
 		void AccumulateLayout();
 
+		void SetVirtualRows(unsigned int numRows, const RowBuilder &builder);
+		// build the virtual rows that fall in the given vertical range, and
+		// release the ones that don't
+		void ShowVirtualRows(int top, int height);
+
 		void SetRowSpacing(int spacing);
 		void SetColumnSpacing(int spacing);
 
@@ -111,6 +135,10 @@ private:
 	private:
 		int RowUnderPoint(const Point &pt, int *out_row_top = 0, int *out_row_bottom = 0) const;
 
+		std::vector<Widget*> BuildVirtualRow(unsigned int index);
+		void ReleaseVirtualRow(const std::vector<Widget*> &row);
+		void MeasureVirtualRows();
+
 		LayoutAccumulator &m_layout;
 		std::vector< std::vector<Widget*> > m_rows;
 		std::vector<int> m_rowHeight;
@@ -120,10 +148,17 @@ private:
 		bool m_dirty;
 
 		bool m_mouseEnabled;
+
+		// m_rows holds the built rows, starting at m_firstVirtualRow
+		bool m_virtual;
+		unsigned int m_numVirtualRows;
+		unsigned int m_firstVirtualRow;
+		int m_virtualRowHeight;
+		RowBuilder m_rowBuilder;
+		std::vector< std::vector< RefCountedPtr<Widget> > > m_rowPool;
 	};
 
 	LayoutAccumulator m_layout;
-	bool m_dirty;
 
 	RefCountedPtr<Inner> m_header;
 	RefCountedPtr<Inner> m_body;
@@ -132,6 +167,8 @@ private:
 
 	sigc::connection m_onMouseWheelConn;
 
+	void UpdateVirtualRows();
+
 	void OnScroll(float value);
 	bool OnMouseWheel(const MouseWheelEvent &event);
 };
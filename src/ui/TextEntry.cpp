@@ -19,7 +19,7 @@ Point TextEntry::PreferredSize()
 {
 	const Skin::BorderedRectElement &elem(GetContext()->GetSkin().BackgroundNormal());
 	const Point borderSize(elem.borderWidth*2, elem.borderHeight*2);
-	Point preferredSize = SizeAdd(m_label->PreferredSize(), Point(elem.paddingX*2, elem.paddingY*2));
+	Point preferredSize = SizeAdd(m_label->GetPreferredSize(), Point(elem.paddingX*2, elem.paddingY*2));
 	preferredSize.x = std::max(preferredSize.x, borderSize.x);
 	preferredSize.y = std::max(preferredSize.y, borderSize.y);
 	return preferredSize;
@@ -44,7 +44,7 @@ void TextEntry::Layout()
 	m_cursorVertices[0] = vector3f(0.0f, cursorTop,    0.0f);
 	m_cursorVertices[1] = vector3f(0.0f, cursorBottom, 0.0f);
 
-	m_label->Layout();
+	m_label->LayoutIfNeeded();
 }
 
 void TextEntry::Update()
@@ -88,7 +88,7 @@ TextEntry *TextEntry::SetText(const std::string &text)
 	bool atEnd = m_label->GetText().size() == m_cursor;
 	m_label->SetText(text);
 	m_cursor = atEnd ? Uint32(text.size()) : Clamp(m_cursor, Uint32(0), Uint32(text.size()));
-	GetContext()->RequestLayout();
+	RequestLayout();
 	return this;
 }
 
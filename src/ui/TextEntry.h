@@ -16,6 +16,8 @@ public:
 	virtual void Layout();
 	virtual void Update();
 	virtual void Draw();
+	// the cursor is drawn with the renderer
+	virtual bool IsDrawBatched() const { return false; }
 
 	TextEntry *SetText(const std::string &text);
 	const std::string &GetText() const { return m_label->GetText(); }
@@ -6,13 +6,18 @@
 #include "RefCounted.h"
 #include "text/TextureFont.h"
 #include "Color.h"
+#include "DrawList.h"
 #include "graphics/VertexArray.h"
-#include "graphics/VertexBuffer.h"
 
 namespace UI {
 
 TextLayout::TextLayout(const RefCountedPtr<Text::TextureFont> &font, const std::string &text)
-	: m_font(font), m_prevColor(Color::WHITE)
+	: m_openWord(false), m_wrapped(0), m_font(font), m_vertices(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0), m_built(false), m_prevColor(Color::WHITE), m_prevAtlasGeneration(0)
+{
+	AddWords(text);
+}
+
+void TextLayout::AddWords(const std::string &text)
 {
 	if (!text.size())
 		return;
@@ -21,6 +26,20 @@ TextLayout::TextLayout(const RefCountedPtr<Text::TextureFont> &font, const std::
 	const std::string delim(" \n");
 
 	size_t start = 0, end = 0;
+
+	// the first piece of the new text finishes off an unfinished last word.
+	// it has to be measured again, and may change the bounds, so wrapping
+	// starts over
+	if (m_openWord && delim.find_first_of(text[0]) == std::string::npos) {
+		end = text.find_first_of(delim);
+		Word &last = m_words.back();
+		last.text += text.substr(0, end);
+		last.measured = false;
+		m_wrapped = 0;
+		m_wrapPos = Point();
+		m_lastSize = Point();
+	}
+
 	while (end != std::string::npos) {
 
 		// start where we left off last time
@@ -48,22 +67,38 @@ TextLayout::TextLayout(const RefCountedPtr<Text::TextureFont> &font, const std::
 		std::string word = text.substr(start, (end == std::string::npos) ? std::string::npos : end - start);
 		m_words.push_back(Word(word));
 	}
+
+	m_openWord = delim.find_first_of(text[text.size()-1]) == std::string::npos;
+}
+
+void TextLayout::AppendText(const std::string &text)
+{
+	AddWords(text);
+	m_built = false;
 }
 
 Point TextLayout::ComputeSize(const Point &layoutSize)
 {
 	if (layoutSize == Point()) return Point();
 
-	if (layoutSize == m_lastRequested)
+	// a new width starts the wrapping again, otherwise it carries on from
+	// wherever it got to (which is the end unless text has been appended)
+	if (layoutSize.x != m_lastRequested.x) {
+		m_wrapped = 0;
+		m_wrapPos = Point();
+		m_lastSize = Point();
+	}
+	m_lastRequested = layoutSize;
+	if (m_wrapped == m_words.size())
 		return m_lastSize;
 
 	int spaceWidth = ceilf(m_font->GetGlyph(' ').advX);
 	int lineHeight = ceilf(m_font->GetHeight());
 
-	Point pos;
-	Point bounds;
+	Point pos = m_wrapPos;
+	Point bounds = m_lastSize;
 
-	for (std::vector<Word>::iterator i = m_words.begin(); i != m_words.end(); ++i) {
+	for (std::vector<Word>::iterator i = m_words.begin() + m_wrapped; i != m_words.end(); ++i) {
 
 		// newline. move to start of next line
 		if (!(*i).text.size()) {
@@ -71,9 +106,13 @@ Point TextLayout::ComputeSize(const Point &layoutSize)
 			continue;
 		}
 
-		vector2f _wordSize;
-		m_font->MeasureString((*i).text.c_str(), _wordSize.x, _wordSize.y);
-		Point wordSize(_wordSize.x, _wordSize.y);
+		if (!(*i).measured) {
+			vector2f _wordSize;
+			m_font->MeasureString((*i).text.c_str(), _wordSize.x, _wordSize.y);
+			(*i).size = Point(_wordSize.x, _wordSize.y);
+			(*i).measured = true;
+		}
+		const Point &wordSize = (*i).size;
 
 		// we add the word to this line if:
 		// - we're at the start of the line; OR
@@ -101,13 +140,14 @@ Point TextLayout::ComputeSize(const Point &layoutSize)
 		pos.x += spaceWidth;
 	}
 
-	m_lastRequested = layoutSize;
+	m_wrapped = m_words.size();
+	m_wrapPos = pos;
 	m_lastSize = bounds;
 
 	return bounds;
 }
 
-void TextLayout::Draw(const Point &layoutSize, const Point &drawPos, const Point &drawSize, const Color &color)
+void TextLayout::Draw(DrawList &drawList, const Point &layoutSize, const Point &drawPos, const Point &drawSize, const Color &color)
 {
 	// cache this before Computing the size
 	const bool bNewSize = (layoutSize != m_lastRequested);
@@ -116,19 +156,20 @@ void TextLayout::Draw(const Point &layoutSize, const Point &drawPos, const Point
 	const int top = -drawPos.y - m_font->GetHeight();
 	const int bottom = -drawPos.y + drawSize.y;
 
-	Graphics::VertexArray va(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0);
-
-	for (std::vector<Word>::iterator i = m_words.begin(); i != m_words.end(); ++i) {
-		if ((*i).pos.y >= top && (*i).pos.y < bottom) {
-			m_font->PopulateString(va, (*i).text, (*i).pos.x, (*i).pos.y, color);
+	if (bNewSize || !m_built || m_prevColor != color || m_prevAtlasGeneration != m_font->GetAtlasGeneration()) {
+		// before populating, in case the words themselves push glyphs out
+		m_prevAtlasGeneration = m_font->GetAtlasGeneration();
+		m_vertices.Clear();
+		for (std::vector<Word>::iterator i = m_words.begin(); i != m_words.end(); ++i) {
+			if ((*i).pos.y >= top && (*i).pos.y < bottom) {
+				m_font->PopulateString(m_vertices, (*i).text, (*i).pos.x, (*i).pos.y, color);
+			}
 		}
-	}
 
-	if (bNewSize || !m_vbuffer.Valid() || m_prevColor != color) {
-		m_vbuffer.Reset( m_font->CreateVertexBuffer(va) );
+		m_built = true;
 	}
 
-	m_font->RenderBuffer( m_vbuffer.Get() );
+	drawList.AddText(m_font->GetMaterial(), m_font->GetRenderState(), m_vertices);
 	m_prevColor = color;
 }
 
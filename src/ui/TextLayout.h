@@ -7,37 +7,59 @@
 #include "Point.h"
 #include "RefCounted.h"
 #include "Color.h"
+#include "graphics/VertexArray.h"
 #include <string>
 #include <vector>
 
 namespace Text { class TextureFont; }
-namespace Graphics { class Renderer; class VertexBuffer; }
+namespace Graphics { class Renderer; }
 
 namespace UI {
 
+class DrawList;
+
 class TextLayout {
 public:
 	TextLayout(const RefCountedPtr<Text::TextureFont> &font, const std::string &text);
 
+	// adds to the end of the text. when the width hasn't changed only the
+	// new words are wrapped
+	void AppendText(const std::string &text);
+
+	// only the width of layoutSize affects the wrapping, and words are only
+	// measured the first time, so resizing is cheap
 	Point ComputeSize(const Point &layoutSize);
 
-	void Draw(const Point &layoutSize, const Point &drawPos, const Point &drawSize, const Color &color = Color::WHITE);
+	void Draw(DrawList &drawList, const Point &layoutSize, const Point &drawPos, const Point &drawSize, const Color &color = Color::WHITE);
 
 private:
 	struct Word {
-		Word(const std::string &_text) : text(_text) {}
+		Word(const std::string &_text) : text(_text), measured(false) {}
 		std::string text;
 		Point    pos;
+		Point    size;
+		bool     measured;
 	};
 	std::vector<Word> m_words;
+	// the text so far ended part way through a word, the next append
+	// continues it
+	bool m_openWord;
+
+	void AddWords(const std::string &text);
 
 	Point m_lastRequested;   // the layout area we were asked to compute size for
 	Point m_lastSize;        // and the resulting size
+	// how far the wrapping at m_lastRequested's width has got: the words
+	// placed so far, and where the next one goes
+	size_t m_wrapped;
+	Point m_wrapPos;
 
 	RefCountedPtr<Text::TextureFont> m_font;
-	RefCountedPtr<Graphics::VertexBuffer> m_vbuffer;
+	Graphics::VertexArray m_vertices;
+	bool m_built;
 
 	Color m_prevColor;
+	Uint32 m_prevAtlasGeneration;
 };
 
 }
@@ -20,6 +20,8 @@ Widget::Widget(Context *context) :
 	m_disabled(false),
 	m_mouseOver(false),
 	m_visible(false),
+	m_needsLayout(true),
+	m_preferredSizeValid(false),
 	m_animatedOpacity(1.0f),
 	m_animatedPositionX(1.0f),
 	m_animatedPositionY(1.0f)
@@ -54,6 +56,7 @@ void Widget::Attach(Container *container)
 	assert(container);
 	assert(m_context == container->GetContext());
 	m_container = container;
+	m_needsLayout = true;
 
 	// we should never be visible while we're detached, and we should
 	// always be detached before being attached to something else
@@ -71,6 +74,8 @@ void Widget::Detach()
 
 void Widget::SetDimensions(const Point &position, const Point &size)
 {
+	if (size != m_size)
+		m_needsLayout = true;
 	m_position = position;
 	SetSize(size);
 	SetActiveArea(size);
@@ -94,13 +99,51 @@ void Widget::SetActiveArea(const Point &activeArea, const Point &activeOffset)
 Widget *Widget::SetFont(Font font)
 {
 	m_font = font;
-	GetContext()->RequestLayout();
+	// anything inside that inherits the font has to be measured again
+	InvalidateLayout();
+	RequestLayout();
 	return this;
 }
 
+Point Widget::GetPreferredSize()
+{
+	if (!m_preferredSizeValid) {
+		m_preferredSizeCache = PreferredSize();
+		m_preferredSizeValid = true;
+	}
+	return m_preferredSizeCache;
+}
+
+void Widget::RequestLayout()
+{
+	// all the way up, even through containers that are already dirty. a
+	// container may have left a child dirty without laying it out (eg. an
+	// unattached slider), so a dirty widget doesn't mean a dirty chain
+	for (Widget *w = this; w; w = w->m_container) {
+		w->m_needsLayout = true;
+		w->m_preferredSizeValid = false;
+	}
+}
+
+void Widget::InvalidateLayout()
+{
+	m_needsLayout = true;
+	m_preferredSizeValid = false;
+}
+
+void Widget::LayoutIfNeeded()
+{
+	if (!m_needsLayout)
+		return;
+	// cleared first, so a widget that finds out during Layout() that its
+	// preferred size changed can request another pass
+	m_needsLayout = false;
+	Layout();
+}
+
 Point Widget::CalcLayoutContribution()
 {
-	Point preferredSize = PreferredSize();
+	Point preferredSize = GetPreferredSize();
 	const Uint32 flags = GetSizeControlFlags();
 
 	if (flags & NO_WIDTH)
@@ -121,7 +164,7 @@ Point Widget::CalcSize(const Point &avail)
 	if (!(GetSizeControlFlags() & PRESERVE_ASPECT))
 		return avail;
 
-	const Point preferredSize = PreferredSize();
+	const Point preferredSize = GetPreferredSize();
 
 	float wantRatio = float(preferredSize.x) / float(preferredSize.y);
 
@@ -22,7 +22,9 @@
 // - Draw() actually draws the widget, using regular renderer calls. The
 //   renderer state will be set such that the widget's top-left corner is at
 //   [0,0] with a scissor region to prevent drawing outside of the widget's
-//   allocated space.
+//   allocated space. Widgets that only draw through the Skin, the context's
+//   DrawList and their children can say so with IsDrawBatched(), and get
+//   batched with everything around them.
 //
 // Widgets can implement PreferredSize(), Layout() and Draw() to do more
 // advanced things.
@@ -40,7 +42,9 @@
 //   and then ask them to lay out their children. As such, when Layout is called
 //   a widget can assume that its size and position have been set. It is only
 //   called occassionally when the layout becomes invalid, typically after a
-//   widget is added or removed. See Container.h for more information about
+//   widget is added or removed, and only for the widgets that asked for it
+//   with RequestLayout() (and their containers) or that were given a new
+//   size by their container. See Container.h for more information about
 //   implementing a container. Widgets that aren't containers but don't intend
 //   to use their entire allocation should implement Layout() and call
 //   SetActiveArea() from it.
@@ -68,8 +72,9 @@
 //
 // Event handlers from user input are called before Layout(), which gives a
 // widget an opportunity to modify the layout based on input. If a widget
-// wants to change its size it must call GetContext()->RequestLayout() to
-// force a layout change to occur.
+// wants to change its size it must call RequestLayout() to force a layout
+// change to occur. The result of PreferredSize() is cached until then, so
+// anything that changes it must request layout.
 //
 // Event handlers are called against the "leaf" widgets first. Handlers return
 // a bool to indicate if the event was "handled" or not. If a widget has no
@@ -143,6 +148,22 @@ public:
 		return (point.x >= min_corner.x && point.y >= min_corner.y && point.x < max_corner.x && point.y < max_corner.y);
 	}
 
+	// PreferredSize(), cached until the widget or something inside it
+	// requests layout. containers should use this to size their children
+	Point GetPreferredSize();
+
+	// mark this widget and its containers as needing layout, and drop their
+	// cached preferred sizes
+	void RequestLayout();
+
+	// mark this widget and everything inside it as needing layout, eg. after
+	// something they inherit from this widget changes
+	virtual void InvalidateLayout();
+
+	// call Layout() if the widget requested layout or was resized since it
+	// was last laid out. containers call this on their children
+	void LayoutIfNeeded();
+
 	// calculate layout contribution based on preferred size and flags
 	Point CalcLayoutContribution();
 	// calculate size based on available space, preferred size and flags
@@ -154,6 +175,9 @@ public:
 	// selectable widgets may receive keyboard focus
 	virtual bool IsSelectable() const { return false; }
 
+	// batched widgets make no renderer calls of their own in Draw()
+	virtual bool IsDrawBatched() const { return false; }
+
 	// disabled widgets do not receive input
 	virtual void Disable();
 	virtual void Enable();
@@ -286,6 +310,11 @@ protected:
 
 	void SetDisabled(bool disabled) { m_disabled = disabled; }
 
+	// layout needed for this widget alone. RequestLayout() is usually what
+	// you want
+	bool IsLayoutNeeded() const { return m_needsLayout; }
+	void SetLayoutNeeded(bool needsLayout) { m_needsLayout = needsLayout; }
+
 	// internal event handlers. override to handle events. unlike the external
 	// on* signals, every widget in the stack is guaranteed to receive a call
 	// - there's no facility for stopping propogation up the stack
@@ -426,6 +455,10 @@ private:
 	bool m_mouseOver;
 	bool m_visible;
 
+	bool m_needsLayout;
+	bool m_preferredSizeValid;
+	Point m_preferredSizeCache;
+
 	std::set<KeySym> m_shortcuts;
 
 	std::map< std::string,sigc::slot<void,PropertyMap &,const std::string &> > m_bindPoints;
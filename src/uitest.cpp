@@ -129,6 +129,7 @@ int main(int argc, char **argv)
 	videoSettings.vsync = false;
 	videoSettings.useTextureCompression = false;
 	videoSettings.enableDebugMessages = false;
+	videoSettings.useShaderCache = false;
 	videoSettings.iconFile = OS::GetIconFilename();
 	videoSettings.title = "uitest";
 
@@ -75,10 +75,24 @@ namespace FileSystem {
 		return data_path;
 	}
 
+	class FileDataMapped : public FileData {
+	public:
+		FileDataMapped(const FileInfo &info, size_t size, char *data):
+			FileData(info, size, data) {}
+		virtual ~FileDataMapped() { UnmapViewOfFile(m_data); }
+	};
+
 	FileSourceFS::FileSourceFS(const std::string &root, bool trusted):
-		FileSource((root == "/") ? "" : absolute_path(root), trusted) {}
+		FileSource((root == "/") ? "" : absolute_path(root), trusted),
+		m_mapFiles(false),
+		m_dirIndexChanged(false),
+		m_dirIndexLock(0) {}
 
-	FileSourceFS::~FileSourceFS() {}
+	FileSourceFS::~FileSourceFS()
+	{
+		if (m_dirIndexLock)
+			SDL_DestroyMutex(m_dirIndexLock);
+	}
 
 	static FileInfo::FileType file_type_for_attributes(DWORD attrs)
 	{
@@ -157,6 +171,20 @@ namespace FileSystem {
 			}
 			size_t size = size_t(large_size.QuadPart);
 
+			if (m_mapFiles && size >= MAP_MIN_SIZE) {
+				HANDLE mapping = CreateFileMappingW(filehandle, 0, PAGE_READONLY, 0, 0, 0);
+				if (mapping) {
+					void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+					// the view keeps the mapping and the file open
+					CloseHandle(mapping);
+					if (view) {
+						CloseHandle(filehandle);
+						return RefCountedPtr<FileData>(new FileDataMapped(MakeFileInfo(path, FileInfo::FT_FILE, modtime), size, static_cast<char*>(view)));
+					}
+				}
+				// otherwise read it the usual way
+			}
+
 			char *data = static_cast<char*>(std::malloc(size));
 			if (!data) {
 				// XXX handling memory allocation failure gracefully is too hard right now
@@ -192,7 +220,27 @@ namespace FileSystem {
 	bool FileSourceFS::ReadDirectory(const std::string &dirpath, std::vector<FileInfo> &output)
 	{
 		size_t output_head_size = output.size();
-		const std::wstring wsearchglob = transcode_utf8_to_utf16(JoinPathBelow(GetRoot(), dirpath)) + L"/*";
+		const std::wstring wdirpath = transcode_utf8_to_utf16(JoinPathBelow(GetRoot(), dirpath));
+
+		Time::DateTime dirTime;
+		bool indexable = false;
+		if (m_dirIndexLock) {
+			WIN32_FILE_ATTRIBUTE_DATA attrs;
+			if (!GetFileAttributesExW(wdirpath.c_str(), GetFileExInfoStandard, &attrs) || !(attrs.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				return false;
+			dirTime = datetime_for_filetime(attrs.ftLastWriteTime);
+			if (FindIndexedDir(dirpath, dirTime, output))
+				return true;
+			// leave it for next time if it changed in the last couple of
+			// seconds, in case it's still changing
+			FILETIME now;
+			GetSystemTimeAsFileTime(&now);
+			const ULONGLONG written = (ULONGLONG(attrs.ftLastWriteTime.dwHighDateTime) << 32) | attrs.ftLastWriteTime.dwLowDateTime;
+			const ULONGLONG current = (ULONGLONG(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+			indexable = written + 2 * 10000000ull < current; // 100ns units
+		}
+
+		const std::wstring wsearchglob = wdirpath + L"/*";
 		WIN32_FIND_DATAW findinfo;
 		HANDLE dirhandle = FindFirstFileW(wsearchglob.c_str(), &findinfo);
 		DWORD err;
@@ -224,6 +272,8 @@ namespace FileSystem {
 		}
 
 		std::sort(output.begin() + output_head_size, output.end());
+		if (indexable)
+			IndexDir(dirpath, dirTime, output.begin() + output_head_size, output.end());
 		return true;
 	}
 
@@ -275,4 +325,11 @@ namespace FileSystem {
 		const std::string fullpath = JoinPathBelow(GetRoot(), path);
 		return open_file_raw(fullpath, (flags & WRITE_TEXT) ? L"w" : L"wb");
 	}
+
+	bool FileSourceFS::RenameFile(const std::string &from, const std::string &to)
+	{
+		const std::wstring wfrom = transcode_utf8_to_utf16(JoinPathBelow(GetRoot(), from));
+		const std::wstring wto = transcode_utf8_to_utf16(JoinPathBelow(GetRoot(), to));
+		return MoveFileExW(wfrom.c_str(), wto.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+	}
 }
@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <wchar.h>
 #include <windows.h>
+#include <psapi.h>
 
 #ifdef WITH_BREAKPAD
 using namespace google_breakpad;
@@ -103,6 +104,14 @@ int GetNumCores()
 	return sysinfo.dwNumberOfProcessors;
 }
 
+size_t GetPeakMemoryUsage()
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize;
+}
+
 // get hardware information
 const std::string GetHardwareInfo()
 {